@@ -416,6 +416,75 @@ dump-oat-Calculator: $(TARGET_OUT_APPS)/Calculator.odex $(DEFAULT_DEX_PREOPT_BUI
 	@echo Output in $(ART_DUMP_OAT_PATH)/Calculator.oatdump.txt
 endif
 
+########################################################################
+# dex2oat compile-speed benchmark targets
+#
+# "m compile-benchmark" compiles a fixed corpus with each backend and writes the timings of each
+# compilation, as JSON from dex2oat --dump-timing-json, to $(ART_COMPILE_BENCHMARK_PATH). The
+# corpus is the core libraries compiled as the host image, and services.jar compiled against the
+# target boot image, the size of a framework jar. The thread count is fixed so runs compare.
+
+ART_COMPILE_BENCHMARK_PATH ?= $(OUT_DIR)/compile-benchmark
+ART_COMPILE_BENCHMARK_BACKENDS ?= Quick Optimizing
+ART_COMPILE_BENCHMARK_THREADS ?= 4
+ART_COMPILE_BENCHMARK_FLAGS := --dump-passes -j$(ART_COMPILE_BENCHMARK_THREADS) \
+	--runtime-arg -Xms64m --runtime-arg -Xmx64m
+
+# $(1): backend
+define declare-compile-benchmark-host
+.PHONY: compile-benchmark-host-$(1)
+compile-benchmark-host-$(1): $(HOST_CORE_DEX_FILES) $(DEX2OAT_DEPENDENCY)
+	@mkdir -p $(ART_COMPILE_BENCHMARK_PATH)/host-$(1)
+	$(DEX2OAT) $(ART_COMPILE_BENCHMARK_FLAGS) --compiler-backend=$(1) \
+		--image-classes=$(PRELOADED_CLASSES) $(addprefix --dex-file=,$(HOST_CORE_DEX_FILES)) \
+		$(addprefix --dex-location=,$(HOST_CORE_DEX_LOCATIONS)) \
+		--oat-file=$(ART_COMPILE_BENCHMARK_PATH)/host-$(1)/core.oat \
+		--oat-location=$(ART_COMPILE_BENCHMARK_PATH)/host-$(1)/core.oat \
+		--image=$(ART_COMPILE_BENCHMARK_PATH)/host-$(1)/core.art \
+		--base=$(LIBART_IMG_HOST_BASE_ADDRESS) --instruction-set=$(ART_HOST_ARCH) --host \
+		--android-root=$(HOST_OUT) \
+		--dump-timing-json=$(ART_COMPILE_BENCHMARK_PATH)/core.host.$(1).json
+	@echo Output in $(ART_COMPILE_BENCHMARK_PATH)/core.host.$(1).json
+
+COMPILE_BENCHMARK_HOST_TARGETS += compile-benchmark-host-$(1)
+endef
+
+# $(1): backend
+define declare-compile-benchmark-target
+.PHONY: compile-benchmark-target-$(1)
+compile-benchmark-target-$(1): $(TARGET_OUT_JAVA_LIBRARIES)/services.jar \
+		$(DEFAULT_DEX_PREOPT_BUILT_IMAGE) $(DEX2OAT_DEPENDENCY)
+	@mkdir -p $(ART_COMPILE_BENCHMARK_PATH)/target-$(1)
+	$(DEX2OAT) $(ART_COMPILE_BENCHMARK_FLAGS) --compiler-backend=$(1) \
+		--boot-image=$(DEFAULT_DEX_PREOPT_BUILT_IMAGE) \
+		--dex-file=$(TARGET_OUT_JAVA_LIBRARIES)/services.jar \
+		--dex-location=/system/framework/services.jar \
+		--oat-file=$(ART_COMPILE_BENCHMARK_PATH)/target-$(1)/services.odex \
+		--instruction-set=$(DEX2OAT_TARGET_ARCH) \
+		--instruction-set-features=$(DEX2OAT_TARGET_INSTRUCTION_SET_FEATURES) \
+		--android-root=$(PRODUCT_OUT)/system \
+		--dump-timing-json=$(ART_COMPILE_BENCHMARK_PATH)/services.target.$(1).json
+	@echo Output in $(ART_COMPILE_BENCHMARK_PATH)/services.target.$(1).json
+
+COMPILE_BENCHMARK_TARGET_TARGETS += compile-benchmark-target-$(1)
+endef
+
+COMPILE_BENCHMARK_HOST_TARGETS :=
+COMPILE_BENCHMARK_TARGET_TARGETS :=
+ifeq ($(ART_BUILD_HOST),true)
+$(foreach backend,$(ART_COMPILE_BENCHMARK_BACKENDS), \
+  $(eval $(call declare-compile-benchmark-host,$(backend))))
+endif
+ifeq ($(ART_BUILD_TARGET_NDEBUG),true)
+$(foreach backend,$(ART_COMPILE_BENCHMARK_BACKENDS), \
+  $(eval $(call declare-compile-benchmark-target,$(backend))))
+endif
+
+.PHONY: compile-benchmark compile-benchmark-host compile-benchmark-target
+compile-benchmark: compile-benchmark-host compile-benchmark-target
+compile-benchmark-host: $(COMPILE_BENCHMARK_HOST_TARGETS)
+compile-benchmark-target: $(COMPILE_BENCHMARK_TARGET_TARGETS)
+
 ########################################################################
 # cpplint targets to style check art source files
 
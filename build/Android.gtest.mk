@@ -32,12 +32,16 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
 	runtime/base/unix_file/random_access_file_utils_test.cc \
 	runtime/base/unix_file/string_file_test.cc \
 	runtime/class_linker_test.cc \
+	runtime/class_table_test.cc \
 	runtime/dex_file_test.cc \
 	runtime/dex_instruction_visitor_test.cc \
 	runtime/dex_method_iterator_test.cc \
 	runtime/entrypoints/math_entrypoints_test.cc \
 	runtime/exception_test.cc \
+	runtime/gc/accounting/card_table_test.cc \
+	runtime/gc/accounting/segmented_stack_test.cc \
 	runtime/gc/accounting/space_bitmap_test.cc \
+	runtime/gc/allocation_site_table_test.cc \
 	runtime/gc/heap_test.cc \
 	runtime/gc/space/dlmalloc_space_base_test.cc \
 	runtime/gc/space/dlmalloc_space_static_test.cc \
@@ -46,22 +50,31 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
 	runtime/gc/space/rosalloc_space_static_test.cc \
 	runtime/gc/space/rosalloc_space_random_test.cc \
 	runtime/gc/space/large_object_space_test.cc \
+	runtime/gc/space/region_space_test.cc \
 	runtime/gtest_test.cc \
 	runtime/indenter_test.cc \
 	runtime/indirect_reference_table_test.cc \
 	runtime/instruction_set_test.cc \
 	runtime/intern_table_test.cc \
+	runtime/interpreter/inline_cache_test.cc \
+	runtime/jit/jit_code_cache_test.cc \
 	runtime/leb128_test.cc \
+	runtime/lock_profiler_test.cc \
 	runtime/mem_map_test.cc \
+	runtime/metrics_page_test.cc \
 	runtime/mirror/dex_cache_test.cc \
 	runtime/mirror/object_test.cc \
 	runtime/parsed_options_test.cc \
+	runtime/profiler_test.cc \
 	runtime/reference_table_test.cc \
+	runtime/safepoint_stats_test.cc \
+	runtime/signal_sampler_test.cc \
 	runtime/thread_pool_test.cc \
 	runtime/transaction_test.cc \
 	runtime/utils_test.cc \
 	runtime/verifier/method_verifier_test.cc \
 	runtime/verifier/reg_type_test.cc \
+	runtime/verifier/verifier_deps_test.cc \
 	runtime/zip_archive_test.cc \
 	runtime/stack_indirect_reference_table_test.cc
 
@@ -75,15 +88,25 @@ COMPILER_GTEST_COMMON_SRC_FILES := \
 	compiler/elf_writer_test.cc \
 	compiler/image_test.cc \
 	compiler/jni/jni_compiler_test.cc \
+	compiler/mapping_table_builder_test.cc \
 	compiler/oat_test.cc \
+	compiler/optimizing/bounds_check_elimination_test.cc \
 	compiler/optimizing/codegen_test.cc \
+	compiler/optimizing/constant_folding_test.cc \
 	compiler/optimizing/dominator_test.cc \
+	compiler/optimizing/gvn_test.cc \
+	compiler/optimizing/licm_test.cc \
 	compiler/optimizing/liveness_test.cc \
+	compiler/optimizing/parallel_move_test.cc \
 	compiler/optimizing/pretty_printer_test.cc \
+	compiler/optimizing/register_allocator_test.cc \
+	compiler/optimizing/scalar_replacement_test.cc \
 	compiler/optimizing/ssa_test.cc \
+	compiler/optimizing/vectorizer_test.cc \
 	compiler/output_stream_test.cc \
 	compiler/utils/arena_allocator_test.cc \
 	compiler/utils/dedupe_set_test.cc \
+	compiler/utils/swap_space_test.cc \
 	compiler/utils/arm/managed_register_arm_test.cc \
 	compiler/utils/arm64/managed_register_arm64_test.cc \
 	compiler/utils/x86/managed_register_x86_test.cc \
@@ -100,13 +123,16 @@ RUNTIME_GTEST_TARGET_SRC_FILES := \
 	$(RUNTIME_GTEST_COMMON_SRC_FILES)
 
 RUNTIME_GTEST_HOST_SRC_FILES := \
-	$(RUNTIME_GTEST_COMMON_SRC_FILES)
+	$(RUNTIME_GTEST_COMMON_SRC_FILES) \
+	runtime/gc/gc_benchmark_test.cc \
+	runtime/thread_list_benchmark_test.cc
 
 COMPILER_GTEST_TARGET_SRC_FILES := \
 	$(COMPILER_GTEST_COMMON_SRC_FILES)
 
 COMPILER_GTEST_HOST_SRC_FILES := \
 	$(COMPILER_GTEST_COMMON_SRC_FILES) \
+	runtime/jni_benchmark_test.cc \
 	compiler/utils/x86/assembler_x86_test.cc \
 	compiler/utils/x86_64/assembler_x86_64_test.cc
 
@@ -175,7 +201,8 @@ define build-art-test
   # Mac OS linker doesn't understand --export-dynamic.
   ifneq ($(HOST_OS)-$$(art_target_or_host),darwin-host)
     # Allow jni_compiler_test to find Java_MyClassNatives_bar within itself using dlopen(NULL, ...).
-    LOCAL_LDFLAGS := -Wl,--export-dynamic -Wl,-u,Java_MyClassNatives_bar -Wl,-u,Java_MyClassNatives_sbar
+    LOCAL_LDFLAGS := -Wl,--export-dynamic -Wl,-u,Java_MyClassNatives_bar -Wl,-u,Java_MyClassNatives_sbar \
+        -Wl,-u,Java_MyClassNatives_criticalAdd
   endif
 
   LOCAL_CFLAGS := $(ART_TEST_CFLAGS)
@@ -248,3 +275,20 @@ ifeq ($(WITH_HOST_DALVIK),true)
     $(foreach file,$(COMPILER_GTEST_HOST_SRC_FILES), $(eval $(call build-art-test,host,$(file),art/compiler,libartd-compiler)))
   endif
 endif
+
+# The benchmarks are disabled gtests, so that test-art-host-gtest only checks that they build.
+# "make test-art-host-<name>-benchmark" runs them.
+# $(1): benchmark name, $(2): gtest executable
+define define-art-host-benchmark
+.PHONY: test-art-host-$(1)-benchmark
+test-art-host-$(1)-benchmark: $(HOST_OUT_EXECUTABLES)/$(2) test-art-host-dependencies
+	$$< --gtest_also_run_disabled_tests --gtest_filter='*DISABLED_*'
+endef
+
+ifeq ($(WITH_HOST_DALVIK),true)
+  ifeq ($(ART_BUILD_HOST),true)
+    $(eval $(call define-art-host-benchmark,gc,gc_benchmark_test))
+    $(eval $(call define-art-host-benchmark,jni,jni_benchmark_test))
+    $(eval $(call define-art-host-benchmark,thread,thread_list_benchmark_test))
+  endif
+endif
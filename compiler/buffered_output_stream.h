@@ -36,7 +36,8 @@ class BufferedOutputStream : public OutputStream {
   virtual off_t Seek(off_t offset, Whence whence);
 
  private:
-  static const size_t kBufferSize = 8 * KB;
+  // Large enough for the writes of the compiled code and tables to be few and large.
+  static const size_t kBufferSize = 64 * KB;
 
   bool Flush();
 
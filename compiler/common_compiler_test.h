@@ -122,6 +122,24 @@ static inline InstructionSetFeatures ParseFeatureList(std::string str) {
     } else if (feature == "nodiv") {
       // Turn off support for divide instruction.
       result.SetHasDivideInstruction(false);
+    } else if (feature == "neon") {
+      // Supports the Advanced SIMD instructions.
+      result.SetHasNeon(true);
+    } else if (feature == "noneon") {
+      // Turn off support for the Advanced SIMD instructions.
+      result.SetHasNeon(false);
+    } else if (feature == "sse4.1") {
+      // Supports the SSE4.1 instructions.
+      result.SetHasSse4_1(true);
+    } else if (feature == "nosse4.1") {
+      // Turn off support for the SSE4.1 instructions.
+      result.SetHasSse4_1(false);
+    } else if (feature == "popcnt") {
+      // Supports the popcnt instruction.
+      result.SetHasPopcnt(true);
+    } else if (feature == "nopopcnt") {
+      // Turn off support for the popcnt instruction.
+      result.SetHasPopcnt(false);
     } else {
       LOG(FATAL) << "Unknown instruction set feature: '" << feature << "'";
     }
@@ -172,15 +190,15 @@ class CommonCompilerTest : public CommonRuntimeTest {
                                                               method->GetDexMethodIndex()));
     }
     if (compiled_method != nullptr) {
-      const std::vector<uint8_t>* code = compiled_method->GetQuickCode();
+      const SwapVector* code = compiled_method->GetQuickCode();
       const void* code_ptr;
       if (code != nullptr) {
         uint32_t code_size = code->size();
         CHECK_NE(0u, code_size);
-        const std::vector<uint8_t>& vmap_table = compiled_method->GetVmapTable();
+        const SwapVector& vmap_table = compiled_method->GetVmapTable();
         uint32_t vmap_table_offset = vmap_table.empty() ? 0u
             : sizeof(OatMethodHeader) + vmap_table.size();
-        const std::vector<uint8_t>& mapping_table = compiled_method->GetMappingTable();
+        const SwapVector& mapping_table = compiled_method->GetMappingTable();
         uint32_t mapping_table_offset = mapping_table.empty() ? 0u
             : sizeof(OatMethodHeader) + vmap_table.size() + mapping_table.size();
         OatMethodHeader method_header(vmap_table_offset, mapping_table_offset, code_size);
@@ -341,7 +359,7 @@ class CommonCompilerTest : public CommonRuntimeTest {
                                                 compiler_kind, instruction_set,
                                                 instruction_set_features,
                                                 true, new CompilerDriver::DescriptorSet,
-                                                2, true, true, timer_.get()));
+                                                2, true, true, false, timer_.get()));
     }
     // We typically don't generate an image in unit tests, disable this optimization by default.
     compiler_driver_->SetSupportBootImageFixup(false);
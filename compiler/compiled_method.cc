@@ -147,13 +147,15 @@ CompiledMethod::CompiledMethod(CompilerDriver* driver,
                                const std::vector<uint8_t>& mapping_table,
                                const std::vector<uint8_t>& vmap_table,
                                const std::vector<uint8_t>& native_gc_map,
-                               const std::vector<uint8_t>* cfi_info)
+                               const std::vector<uint8_t>* cfi_info,
+                               const std::vector<uint32_t>& osr_entries)
     : CompiledCode(driver, instruction_set, quick_code), frame_size_in_bytes_(frame_size_in_bytes),
       core_spill_mask_(core_spill_mask), fp_spill_mask_(fp_spill_mask),
   mapping_table_(driver->DeduplicateMappingTable(mapping_table)),
   vmap_table_(driver->DeduplicateVMapTable(vmap_table)),
   gc_map_(driver->DeduplicateGCMap(native_gc_map)),
-  cfi_info_(driver->DeduplicateCFIInfo(cfi_info)) {
+  cfi_info_(driver->DeduplicateCFIInfo(cfi_info)),
+  osr_entries_(osr_entries) {
 }
 
 CompiledMethod::CompiledMethod(CompilerDriver* driver,
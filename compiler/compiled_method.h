@@ -22,6 +22,7 @@
 
 #include "instruction_set.h"
 #include "utils.h"
+#include "utils/swap_space.h"
 #include "UniquePtr.h"
 
 namespace llvm {
@@ -46,11 +47,11 @@ class CompiledCode {
     return instruction_set_;
   }
 
-  const std::vector<uint8_t>* GetPortableCode() const {
+  const SwapVector* GetPortableCode() const {
     return portable_code_;
   }
 
-  const std::vector<uint8_t>* GetQuickCode() const {
+  const SwapVector* GetQuickCode() const {
     return quick_code_;
   }
 
@@ -84,10 +85,10 @@ class CompiledCode {
   const InstructionSet instruction_set_;
 
   // The ELF image for portable.
-  std::vector<uint8_t>* portable_code_;
+  SwapVector* portable_code_;
 
   // Used to store the PIC code for Quick.
-  std::vector<uint8_t>* quick_code_;
+  SwapVector* quick_code_;
 
   // Used for the Portable ELF symbol name.
   const std::string symbol_;
@@ -111,7 +112,8 @@ class CompiledMethod : public CompiledCode {
                  const std::vector<uint8_t>& mapping_table,
                  const std::vector<uint8_t>& vmap_table,
                  const std::vector<uint8_t>& native_gc_map,
-                 const std::vector<uint8_t>* cfi_info);
+                 const std::vector<uint8_t>* cfi_info,
+                 const std::vector<uint32_t>& osr_entries = std::vector<uint32_t>());
 
   // Constructs a CompiledMethod for the QuickJniCompiler.
   CompiledMethod(CompilerDriver* driver,
@@ -143,25 +145,30 @@ class CompiledMethod : public CompiledCode {
     return fp_spill_mask_;
   }
 
-  const std::vector<uint8_t>& GetMappingTable() const {
+  const SwapVector& GetMappingTable() const {
     DCHECK(mapping_table_ != nullptr);
     return *mapping_table_;
   }
 
-  const std::vector<uint8_t>& GetVmapTable() const {
+  const SwapVector& GetVmapTable() const {
     DCHECK(vmap_table_ != nullptr);
     return *vmap_table_;
   }
 
-  const std::vector<uint8_t>& GetGcMap() const {
+  const SwapVector& GetGcMap() const {
     DCHECK(gc_map_ != nullptr);
     return *gc_map_;
   }
 
-  const std::vector<uint8_t>* GetCFIInfo() const {
+  const SwapVector* GetCFIInfo() const {
     return cfi_info_;
   }
 
+  // Pairs of a loop header dex PC and the native PC offset of its on-stack replacement entry.
+  const std::vector<uint32_t>& GetOsrEntries() const {
+    return osr_entries_;
+  }
+
  private:
   // For quick code, the size of the activation used by the code.
   const size_t frame_size_in_bytes_;
@@ -171,14 +178,18 @@ class CompiledMethod : public CompiledCode {
   const uint32_t fp_spill_mask_;
   // For quick code, a uleb128 encoded map from native PC offset to dex PC aswell as dex PC to
   // native PC offset. Size prefixed.
-  std::vector<uint8_t>* mapping_table_;
+  SwapVector* mapping_table_;
   // For quick code, a uleb128 encoded map from GPR/FPR register to dex register. Size prefixed.
-  std::vector<uint8_t>* vmap_table_;
+  SwapVector* vmap_table_;
   // For quick code, a map keyed by native PC indices to bitmaps describing what dalvik registers
   // are live. For portable code, the key is a dalvik PC.
-  std::vector<uint8_t>* gc_map_;
+  SwapVector* gc_map_;
   // For quick code, a FDE entry for the debug_frame section.
-  std::vector<uint8_t>* cfi_info_;
+  SwapVector* cfi_info_;
+  // For quick code compiled for the JIT, the entries reached from the interpreter at loop headers.
+  // Called with the Method* in the first argument register and the interpreter's copy of the
+  // Dalvik registers in the second. Not deduplicated as the JIT compiles one method at a time.
+  std::vector<uint32_t> osr_entries_;
 };
 
 }  // namespace art
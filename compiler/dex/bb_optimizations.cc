@@ -43,6 +43,7 @@ void SSATransformation::End(CompilationUnit* cUnit) const {
   if (cUnit->enable_debug & (1 << kDebugVerifyDataflow)) {
     cUnit->mir_graph->VerifyDataflow();
   }
+  cUnit->mir_graph->FinishSSATransformation();
 }
 
 /*
@@ -136,6 +136,43 @@ class ConstantPropagation : public Pass {
   }
 };
 
+/**
+ * @class LoopCheckElimination
+ * @brief Hoist invariant null checks out of loops, remove range checks of counted loops and
+ * suspend checks of short inner loops.
+ */
+class LoopCheckElimination : public Pass {
+ public:
+  LoopCheckElimination() : Pass("LoopCheckElimination", kNoNodes) {
+  }
+
+  bool Gate(const CompilationUnit* cUnit) const {
+    return cUnit->mir_graph->EliminateLoopChecksGate();
+  }
+
+  void Start(CompilationUnit* cUnit) const {
+    cUnit->mir_graph->EliminateLoopChecks();
+  }
+};
+
+/**
+ * @class ArrayInitialization
+ * @brief Combine the constant stores initializing new arrays into fill-array-data.
+ */
+class ArrayInitialization : public Pass {
+ public:
+  ArrayInitialization() : Pass("ArrayInitialization", kNoNodes) {
+  }
+
+  bool Gate(const CompilationUnit* cUnit) const {
+    return cUnit->mir_graph->CombineArrayInitializationGate();
+  }
+
+  void Start(CompilationUnit* cUnit) const {
+    cUnit->mir_graph->CombineArrayInitialization();
+  }
+};
+
 /**
  * @class InitRegLocations
  * @brief Initialize Register Locations.
@@ -205,6 +242,25 @@ class ClassInitCheckElimination : public Pass {
   }
 };
 
+/**
+ * @class GlobalValueNumbering
+ * @brief Value numbering over the dominator tree, removing null and range checks made
+ * redundant by checks in dominating blocks.
+ */
+class GlobalValueNumbering : public Pass {
+ public:
+  GlobalValueNumbering() : Pass("GVN", kNoNodes) {
+  }
+
+  bool Gate(const CompilationUnit* cUnit) const {
+    return cUnit->mir_graph->ApplyGlobalValueNumberingGate();
+  }
+
+  void Start(CompilationUnit* cUnit) const {
+    cUnit->mir_graph->ApplyGlobalValueNumbering();
+  }
+};
+
 /**
  * @class NullCheckEliminationAndTypeInference
  * @brief Null check elimination and type inference.
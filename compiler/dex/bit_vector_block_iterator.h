@@ -20,7 +20,7 @@
 #include "base/bit_vector.h"
 #include "compiler_enums.h"
 #include "utils/arena_bit_vector.h"
-#include "utils/arena_allocator.h"
+#include "base/arena_allocator.h"
 #include "compiler_ir.h"
 
 namespace art {
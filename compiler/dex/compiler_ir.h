@@ -25,9 +25,9 @@
 #include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
 #include "safe_map.h"
-#include "utils/scoped_arena_allocator.h"
+#include "base/scoped_arena_allocator.h"
 #include "base/timing_logger.h"
-#include "utils/arena_allocator.h"
+#include "base/arena_allocator.h"
 
 namespace art {
 
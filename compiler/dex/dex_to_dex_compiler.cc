@@ -83,6 +83,26 @@ class DexCompiler {
   void CompileInvokeVirtual(Instruction* inst, uint32_t dex_pc,
                             Instruction::Code new_opcode, bool is_range);
 
+  // Compiles a super method invocation into a quick super method invocation.
+  // The method index is replaced by the index in the vtable of the super class
+  // of the compiling method's class, so neither resolution nor the check of
+  // the super class vtable length remain at runtime.
+  void CompileInvokeSuper(Instruction* inst, uint32_t dex_pc,
+                          Instruction::Code new_opcode, bool is_range);
+
+  // Compiles a static field access into a quick static field access.
+  // The field index is kept but the access is only quickened when the field's
+  // class is known to be initialized whenever the instruction runs, which is
+  // the case for fields of the compiling method's class and for initialized
+  // image classes. The class initialization and access checks are skipped at
+  // runtime.
+  void CompileStaticFieldAccess(Instruction* inst, uint32_t dex_pc,
+                                Instruction::Code new_opcode, bool is_put);
+
+  // Compiles a CONST-STRING into a CONST-STRING-QUICK, which goes straight to
+  // the dex cache without checking that java.lang.String is initialized.
+  void CompileConstString(Instruction* inst, uint32_t dex_pc);
+
   CompilerDriver& driver_;
   const DexCompilationUnit& unit_;
   const DexToDexCompilationLevel dex_to_dex_compilation_level_;
@@ -108,6 +128,10 @@ void DexCompiler::Compile() {
         inst = CompileCheckCast(inst, dex_pc);
         break;
 
+      case Instruction::CONST_STRING:
+        CompileConstString(inst, dex_pc);
+        break;
+
       case Instruction::IGET:
         CompileInstanceFieldAccess(inst, dex_pc, Instruction::IGET_QUICK, false);
         break;
@@ -138,6 +162,30 @@ void DexCompiler::Compile() {
         CompileInstanceFieldAccess(inst, dex_pc, Instruction::IPUT_OBJECT_QUICK, true);
         break;
 
+      case Instruction::SGET:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SGET_QUICK, false);
+        break;
+
+      case Instruction::SGET_WIDE:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SGET_WIDE_QUICK, false);
+        break;
+
+      case Instruction::SGET_OBJECT:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SGET_OBJECT_QUICK, false);
+        break;
+
+      case Instruction::SPUT:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SPUT_QUICK, true);
+        break;
+
+      case Instruction::SPUT_WIDE:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SPUT_WIDE_QUICK, true);
+        break;
+
+      case Instruction::SPUT_OBJECT:
+        CompileStaticFieldAccess(inst, dex_pc, Instruction::SPUT_OBJECT_QUICK, true);
+        break;
+
       case Instruction::INVOKE_VIRTUAL:
         CompileInvokeVirtual(inst, dex_pc, Instruction::INVOKE_VIRTUAL_QUICK, false);
         break;
@@ -146,6 +194,14 @@ void DexCompiler::Compile() {
         CompileInvokeVirtual(inst, dex_pc, Instruction::INVOKE_VIRTUAL_RANGE_QUICK, true);
         break;
 
+      case Instruction::INVOKE_SUPER:
+        CompileInvokeSuper(inst, dex_pc, Instruction::INVOKE_SUPER_QUICK, false);
+        break;
+
+      case Instruction::INVOKE_SUPER_RANGE:
+        CompileInvokeSuper(inst, dex_pc, Instruction::INVOKE_SUPER_RANGE_QUICK, true);
+        break;
+
       default:
         // Nothing to do.
         break;
@@ -268,6 +324,73 @@ void DexCompiler::CompileInvokeVirtual(Instruction* inst,
   }
 }
 
+void DexCompiler::CompileInvokeSuper(Instruction* inst,
+                                     uint32_t dex_pc,
+                                     Instruction::Code new_opcode,
+                                     bool is_range) {
+  if (!kEnableQuickening || !PerformOptimizations()) {
+    return;
+  }
+  uint32_t method_idx = is_range ? inst->VRegB_3rc() : inst->VRegB_35c();
+  int vtable_idx;
+  if (driver_.ComputeInvokeSuperInfo(&unit_, method_idx, &vtable_idx) &&
+      IsUint(16, vtable_idx)) {
+    VLOG(compiler) << "Quickening " << Instruction::Name(inst->Opcode())
+                   << "(" << PrettyMethod(method_idx, GetDexFile(), true) << ")"
+                   << " to " << Instruction::Name(new_opcode)
+                   << " by replacing method index " << method_idx
+                   << " by vtable index " << vtable_idx
+                   << " at dex pc " << StringPrintf("0x%x", dex_pc) << " in method "
+                   << PrettyMethod(unit_.GetDexMethodIndex(), GetDexFile(), true);
+    // We are modifying 4 consecutive bytes.
+    inst->SetOpcode(new_opcode);
+    // Replace method index by vtable index.
+    if (is_range) {
+      inst->SetVRegB_3rc(static_cast<uint16_t>(vtable_idx));
+    } else {
+      inst->SetVRegB_35c(static_cast<uint16_t>(vtable_idx));
+    }
+  }
+}
+
+void DexCompiler::CompileStaticFieldAccess(Instruction* inst,
+                                           uint32_t dex_pc,
+                                           Instruction::Code new_opcode,
+                                           bool is_put) {
+  if (!kEnableQuickening || !PerformOptimizations()) {
+    return;
+  }
+  uint32_t field_idx = inst->VRegB_21c();
+  MemberOffset field_offset(0u);
+  uint32_t storage_index;
+  bool is_referrers_class;
+  bool is_volatile;
+  bool is_initialized;
+  bool fast_path = driver_.ComputeStaticFieldInfo(field_idx, &unit_, is_put, &field_offset,
+                                                  &storage_index, &is_referrers_class,
+                                                  &is_volatile, &is_initialized);
+  if (fast_path && (is_referrers_class || is_initialized)) {
+    VLOG(compiler) << "Quickening " << Instruction::Name(inst->Opcode())
+                   << " to " << Instruction::Name(new_opcode)
+                   << " for field " << PrettyField(field_idx, GetDexFile(), true)
+                   << " at dex pc " << StringPrintf("0x%x", dex_pc) << " in method "
+                   << PrettyMethod(unit_.GetDexMethodIndex(), GetDexFile(), true);
+    // We are modifying 2 consecutive bytes, the field index stays.
+    inst->SetOpcode(new_opcode);
+  }
+}
+
+void DexCompiler::CompileConstString(Instruction* inst, uint32_t dex_pc) {
+  if (!kEnableQuickening || !PerformOptimizations()) {
+    return;
+  }
+  VLOG(compiler) << "Quickening " << Instruction::Name(inst->Opcode())
+                 << " to " << Instruction::Name(Instruction::CONST_STRING_QUICK)
+                 << " at dex pc " << StringPrintf("0x%x", dex_pc) << " in method "
+                 << PrettyMethod(unit_.GetDexMethodIndex(), GetDexFile(), true);
+  inst->SetOpcode(Instruction::CONST_STRING_QUICK);
+}
+
 }  // namespace optimizer
 }  // namespace art
 
@@ -53,6 +53,11 @@ static uint32_t kCompilerOptimizerDisableFlags = 0 |  // Disable specific optimi
   // (1 << kPromoteCompilerTemps) |
   // (1 << kSuppressExceptionEdges) |
   // (1 << kSuppressMethodInlining) |
+  // (1 << kGlobalValueNumbering) |
+  // (1 << kLoopCheckElimination) |
+  // (1 << kListScheduling) |
+  // (1 << kSuppressSwitchLowering) |
+  // (1 << kArrayInitialization) |
   0;
 
 static uint32_t kCompilerDebugFlags = 0 |     // Enable debug/testing modes
@@ -545,6 +550,10 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
     cu.verbose = VLOG_IS_ON(compiler) ||
         (cu.enable_debug & (1 << kDebugVerbose));
   }
+  if (driver.GetArenaPool()->CountsAllocations()) {
+    // Report the arena usage of the large methods (dex2oat --dump-arena-stats).
+    cu.enable_debug |= (1 << kDebugShowMemoryUsage);
+  }
 
   if (gVerboseMethods.size() != 0) {
     cu.verbose = false;
@@ -576,7 +585,10 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
         (1 << kSafeOptimizations) |
         (1 << kBBOpt) |
         (1 << kMatch) |
-        (1 << kPromoteCompilerTemps));
+        (1 << kPromoteCompilerTemps) |
+        (1 << kGlobalValueNumbering) |
+        (1 << kLoopCheckElimination) |
+        (1 << kListScheduling));
   }
 
   if (cu.instruction_set == kArm64) {
@@ -599,14 +611,6 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
     cu.mir_graph->EnableOpcodeCounting();
   }
 
-  // Check early if we should skip this compilation if using the profiled filter.
-  if (cu.compiler_driver->ProfilePresent()) {
-    std::string methodname = PrettyMethod(method_idx, dex_file);
-    if (cu.mir_graph->SkipCompilation(methodname)) {
-      return NULL;
-    }
-  }
-
   /* Build the raw MIR graph */
   cu.mir_graph->InlineMethod(code_item, access_flags, invoke_type, class_def_idx, method_idx,
                               class_loader, dex_file);
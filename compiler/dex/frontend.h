@@ -54,6 +54,11 @@ enum opt_control_vector {
   kBranchFusing,
   kSuppressExceptionEdges,
   kSuppressMethodInlining,
+  kGlobalValueNumbering,
+  kLoopCheckElimination,
+  kListScheduling,
+  kSuppressSwitchLowering,
+  kArrayInitialization,
 };
 
 // Force code generation paths for testing.
@@ -21,6 +21,35 @@
 
 namespace art {
 
+template <typename Map>
+static void CopyMap(const Map& src, Map* dest) {
+  for (typename Map::const_iterator it = src.begin(), end = src.end(); it != end; ++it) {
+    dest->Put(it->first, it->second);
+  }
+}
+
+void LocalValueNumbering::CopyState(const LocalValueNumbering& other) {
+  // Copy element by element so that the copies live in this LVN's arena.
+  CopyMap(other.sreg_value_map_, &sreg_value_map_);
+  CopyMap(other.sreg_wide_value_map_, &sreg_wide_value_map_);
+  CopyMap(other.value_map_, &value_map_);
+  next_memory_version_ = other.next_memory_version_;
+  global_memory_version_ = other.global_memory_version_;
+  std::copy_n(other.unresolved_sfield_version_, kFieldTypeCount, unresolved_sfield_version_);
+  std::copy_n(other.unresolved_ifield_version_, kFieldTypeCount, unresolved_ifield_version_);
+  CopyMap(other.memory_version_map_, &memory_version_map_);
+  CopyMap(other.field_index_map_, &field_index_map_);
+  non_aliasing_refs_.insert(other.non_aliasing_refs_.begin(), other.non_aliasing_refs_.end());
+  null_checked_.insert(other.null_checked_.begin(), other.null_checked_.end());
+}
+
+void LocalValueNumbering::KillMemory() {
+  // A reference that was unique may have escaped and been written through on the way, so no
+  // reference is unique anymore and all memory gets a new version.
+  non_aliasing_refs_.clear();
+  AdvanceGlobalMemory();
+}
+
 uint16_t LocalValueNumbering::GetFieldId(const DexFile* dex_file, uint16_t field_idx) {
   FieldReference key = { dex_file, field_idx };
   auto it = field_index_map_.find(key);
@@ -141,14 +170,11 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::RETURN:
     case Instruction::RETURN_OBJECT:
     case Instruction::RETURN_WIDE:
-    case Instruction::MONITOR_ENTER:
-    case Instruction::MONITOR_EXIT:
     case Instruction::GOTO:
     case Instruction::GOTO_16:
     case Instruction::GOTO_32:
     case Instruction::CHECK_CAST:
     case Instruction::THROW:
-    case Instruction::FILL_ARRAY_DATA:
     case Instruction::PACKED_SWITCH:
     case Instruction::SPARSE_SWITCH:
     case Instruction::IF_EQ:
@@ -171,6 +197,27 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
       // Nothing defined - take no action.
       break;
 
+    case kMirOpNullCheck: {
+        uint16_t reg = GetOperandValue(mir->ssa_rep->uses[0]);
+        HandleNullCheck(mir, reg);
+      }
+      break;
+
+    case Instruction::MONITOR_ENTER:
+    case Instruction::MONITOR_EXIT:
+      // Memory barrier: other threads may have written to anything that isn't unique.
+      AdvanceGlobalMemory();
+      break;
+
+    case Instruction::FILL_ARRAY_DATA: {
+        // Writes all elements of the array; their type isn't known here.
+        uint16_t array = GetOperandValue(mir->ssa_rep->uses[0]);
+        for (uint16_t type = 0u; type != kFieldTypeCount; ++type) {
+          AdvanceMemoryVersion(array, NO_VALUE, type);
+        }
+      }
+      break;
+
     case Instruction::FILLED_NEW_ARRAY:
     case Instruction::FILLED_NEW_ARRAY_RANGE:
       // Nothing defined but the result will be unique and non-null.
@@ -226,8 +273,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
 
     case kMirOpPhi:
       /*
-       * Because we'll only see phi nodes at the beginning of an extended basic block,
-       * we can ignore them.  Revisit if we shift to global value numbering.
+       * Phi nodes are only seen at the beginning of a block, where we can ignore them. Their
+       * results get a unique value name on first use, also in global value numbering.
        */
       break;
 
@@ -549,6 +596,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
           field_id = 0u;
           memory_version = next_memory_version_;
           ++next_memory_version_;
+          // The volatile load is also a barrier for loads of other memory locations.
+          AdvanceGlobalMemory();
         } else {
           DCHECK(field_info.IsResolved());
           field_id = GetFieldId(field_info.DeclaringDexFile(), field_info.DeclaringFieldIndex());
@@ -610,6 +659,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
           field_id = 0u;
           memory_version = next_memory_version_;
           ++next_memory_version_;
+          // The volatile load is also a barrier for loads of other memory locations.
+          AdvanceGlobalMemory();
         } else {
           DCHECK(field_info.IsResolved());
           field_id = GetFieldId(field_info.DeclaringDexFile(), field_info.DeclaringFieldIndex());
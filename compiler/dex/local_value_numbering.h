@@ -19,7 +19,7 @@
 
 #include "compiler_internals.h"
 #include "UniquePtr.h"
-#include "utils/scoped_arena_allocator.h"
+#include "base/scoped_arena_allocator.h"
 
 #define NO_VALUE 0xffff
 #define ARRAY_REF 0xfffe
@@ -97,6 +97,13 @@ class LocalValueNumbering {
     return new(addr) LocalValueNumbering(cu, allocator.release());
   }
 
+  // Create a LocalValueNumbering starting from the state of a dominating block at its end.
+  static LocalValueNumbering* Create(CompilationUnit* cu, const LocalValueNumbering& dominator) {
+    LocalValueNumbering* lvn = Create(cu);
+    lvn->CopyState(dominator);
+    return lvn;
+  }
+
   static uint64_t BuildKey(uint16_t op, uint16_t operand1, uint16_t operand2, uint16_t modifier) {
     return (static_cast<uint64_t>(op) << 48 | static_cast<uint64_t>(operand1) << 32 |
             static_cast<uint64_t>(operand2) << 16 | static_cast<uint64_t>(modifier));
@@ -167,6 +174,9 @@ class LocalValueNumbering {
 
   uint16_t GetValueNumber(MIR* mir);
 
+  // Forget the memory versions, for a block reached over paths that may write to memory.
+  void KillMemory();
+
   // Allow delete-expression to destroy a LocalValueNumbering object without deallocation.
   static void operator delete(void* ptr) { UNUSED(ptr); }
 
@@ -187,6 +197,7 @@ class LocalValueNumbering {
     std::fill_n(unresolved_ifield_version_, kFieldTypeCount, 0u);
   }
 
+  void CopyState(const LocalValueNumbering& other);
   uint16_t GetFieldId(const DexFile* dex_file, uint16_t field_idx);
   void AdvanceGlobalMemory();
   uint16_t GetMemoryVersion(uint16_t base, uint16_t field, uint16_t type);
@@ -1013,10 +1013,19 @@ bool MIRGraph::SkipCompilation() {
     return true;
   }
 
-  if (!compiler_options.IsCompilationEnabled() || compiler_filter == CompilerOptions::kProfiled) {
+  if (!compiler_options.IsCompilationEnabled()) {
     return true;
   }
 
+  if (compiler_filter == CompilerOptions::kProfiled) {
+    // Without a profile nothing is known to be hot. With one, the driver only lets the hot
+    // methods through, compile them like the speed filter does.
+    if (!cu_->compiler_driver->ProfilePresent()) {
+      return true;
+    }
+    compiler_filter = CompilerOptions::kSpeed;
+  }
+
   // Set up compilation cutoffs based on current filter mode.
   size_t small_cutoff = 0;
   size_t default_cutoff = 0;
@@ -1284,8 +1293,5 @@ void MIRGraph::DoCacheMethodLoweringInfo() {
                                  method_lowering_infos_.GetRawStorage(), count);
 }
 
-bool MIRGraph::SkipCompilation(const std::string& methodname) {
-  return cu_->compiler_driver->SkipCompilation(methodname);
-}
 
 }  // namespace art
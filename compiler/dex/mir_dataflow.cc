@@ -145,7 +145,7 @@ const uint64_t MIRGraph::oat_data_flow_attributes_[kMirOpLast] = {
   DF_FORMAT_3RC | DF_NON_NULL_RET | DF_UMS,
 
   // 26 FILL_ARRAY_DATA vAA, +BBBBBBBB
-  DF_UA | DF_REF_A | DF_UMS,
+  DF_UA | DF_NULL_CHK_0 | DF_REF_A | DF_UMS,
 
   // 27 THROW vAA
   DF_UA | DF_REF_A | DF_UMS,
@@ -824,7 +824,7 @@ const uint64_t MIRGraph::oat_data_flow_attributes_[kMirOpLast] = {
   DF_NOP,
 
   // 108 MIR_NULL_CHECK
-  0,
+  DF_UA | DF_REF_A | DF_NULL_CHK_0,
 
   // 109 MIR_RANGE_CHECK
   0,
@@ -871,12 +871,17 @@ bool MIRGraph::FindLocalLiveIn(BasicBlock* bb) {
 
   if (bb->data_flow_info == NULL) return false;
 
+  ScopedArenaAllocator* allocator = temp_scoped_alloc_.get();
   use_v = bb->data_flow_info->use_v =
-      new (arena_) ArenaBitVector(arena_, cu_->num_dalvik_registers, false, kBitMapUse);
+      new (allocator) ArenaBitVector(allocator, cu_->num_dalvik_registers, false, kBitMapUse);
   def_v = bb->data_flow_info->def_v =
-      new (arena_) ArenaBitVector(arena_, cu_->num_dalvik_registers, false, kBitMapDef);
+      new (allocator) ArenaBitVector(allocator, cu_->num_dalvik_registers, false, kBitMapDef);
   live_in_v = bb->data_flow_info->live_in_v =
-      new (arena_) ArenaBitVector(arena_, cu_->num_dalvik_registers, false, kBitMapLiveIn);
+      new (allocator) ArenaBitVector(allocator, cu_->num_dalvik_registers, false, kBitMapLiveIn);
+  // The scoped allocator does not clear the memory it hands out.
+  use_v->ClearAllBits();
+  def_v->ClearAllBits();
+  live_in_v->ClearAllBits();
 
   for (mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
     uint64_t df_attributes = GetDataFlowAttributes(mir);
@@ -1115,8 +1120,8 @@ bool MIRGraph::DoSSAConversion(BasicBlock* bb) {
    * predecessor blocks.
    */
   bb->data_flow_info->vreg_to_ssa_map =
-      static_cast<int*>(arena_->Alloc(sizeof(int) * cu_->num_dalvik_registers,
-                                      kArenaAllocDFInfo));
+      static_cast<int*>(temp_scoped_alloc_->Alloc(sizeof(int) * cu_->num_dalvik_registers,
+                                                  kArenaAllocDFInfo));
 
   memcpy(bb->data_flow_info->vreg_to_ssa_map, vreg_to_ssa_map_,
          sizeof(int) * cu_->num_dalvik_registers);
@@ -112,12 +112,15 @@ void MirSFieldLoweringInfo::Resolve(CompilerDriver* compiler_driver,
     std::pair<bool, bool> fast_path = compiler_driver->IsFastStaticField(
         dex_cache.get(), referrer_class.get(), resolved_field, field_idx, &it->field_offset_,
         &it->storage_index_, &is_referrers_class, &is_initialized);
+    bool is_constant = fast_path.first &&
+        compiler_driver->IsStaticFieldConstant(resolved_field, &it->constant_value_);
     it->flags_ = kFlagIsStatic |
         (is_volatile ? kFlagIsVolatile : 0u) |
         (fast_path.first ? kFlagFastGet : 0u) |
         (fast_path.second ? kFlagFastPut : 0u) |
         (is_referrers_class ? kFlagIsReferrersClass : 0u) |
-        (is_initialized ? kFlagIsInitialized : 0u);
+        (is_initialized ? kFlagIsInitialized : 0u) |
+        (is_constant ? kFlagIsConstant : 0u);
   }
 }
 
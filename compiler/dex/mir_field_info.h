@@ -137,7 +137,9 @@ class MirIFieldLoweringInfo : public MirFieldInfo {
   // The member offset of the field, 0u if unresolved.
   MemberOffset field_offset_;
 
+  friend class GlobalValueNumberingTest;
   friend class LocalValueNumberingTest;
+  friend class LoopCheckEliminationTest;
 };
 
 class MirSFieldLoweringInfo : public MirFieldInfo {
@@ -156,7 +158,8 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
   explicit MirSFieldLoweringInfo(uint16_t field_idx)
       : MirFieldInfo(field_idx, kFlagIsVolatile | kFlagIsStatic),
         field_offset_(0u),
-        storage_index_(DexFile::kDexNoIndex) {
+        storage_index_(DexFile::kDexNoIndex),
+        constant_value_(0u) {
   }
 
   bool FastGet() const {
@@ -175,6 +178,12 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
     return (flags_ & kFlagIsInitialized) != 0u;
   }
 
+  // Is the field a final field of a class initialized in the boot image? A get can then use
+  // ConstantValue() instead of loading the field, see CompilerDriver::IsStaticFieldConstant.
+  bool IsConstant() const {
+    return (flags_ & kFlagIsConstant) != 0u;
+  }
+
   MemberOffset FieldOffset() const {
     return field_offset_;
   }
@@ -183,12 +192,17 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
     return storage_index_;
   }
 
+  uint64_t ConstantValue() const {
+    return constant_value_;
+  }
+
  private:
   enum {
     kBitFastGet = kFieldInfoBitEnd,
     kBitFastPut,
     kBitIsReferrersClass,
     kBitIsInitialized,
+    kBitIsConstant,
     kSFieldLoweringInfoBitEnd
   };
   COMPILE_ASSERT(kSFieldLoweringInfoBitEnd <= 16, too_many_flags);
@@ -196,12 +210,15 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
   static constexpr uint16_t kFlagFastPut = 1u << kBitFastPut;
   static constexpr uint16_t kFlagIsReferrersClass = 1u << kBitIsReferrersClass;
   static constexpr uint16_t kFlagIsInitialized = 1u << kBitIsInitialized;
+  static constexpr uint16_t kFlagIsConstant = 1u << kBitIsConstant;
 
   // The member offset of the field, 0u if unresolved.
   MemberOffset field_offset_;
   // The type index of the declaring class in the compiling method's dex file,
   // -1 if the field is unresolved or there's no appropriate TypeId in that dex file.
   uint32_t storage_index_;
+  // The value of a constant field, a reference as its address, 0u otherwise.
+  uint64_t constant_value_;
 
   friend class ClassInitCheckEliminationTest;
   friend class LocalValueNumberingTest;
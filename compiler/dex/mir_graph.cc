@@ -69,6 +69,8 @@ MIRGraph::MIRGraph(CompilationUnit* cu, ArenaAllocator* arena)
       temp_insn_data_(nullptr),
       temp_bit_vector_size_(0u),
       temp_bit_vector_(nullptr),
+      inlined_calls_(0u),
+      inlined_code_units_(0u),
       block_list_(arena, 100, kGrowableArrayBlockList),
       try_block_addr_(NULL),
       entry_block_(NULL),
@@ -1243,6 +1245,10 @@ void MIRGraph::InitializeSSATransformation() {
   /* Compute the dominator info */
   ComputeDominators();
 
+  /* The liveness data below is only needed until the Phi operands are filled */
+  DCHECK(temp_scoped_alloc_.get() == nullptr);
+  temp_scoped_alloc_.reset(ScopedArenaAllocator::Create(&cu_->arena_stack));
+
   /* Allocate data structures in preparation for SSA conversion */
   CompilerInitializeSSAConversion();
 
@@ -1257,6 +1263,21 @@ void MIRGraph::InitializeSSATransformation() {
   DoDFSPreOrderSSARename(GetEntryBlock());
 }
 
+void MIRGraph::FinishSSATransformation() {
+  GrowableArray<BasicBlock*>::Iterator iter(&block_list_);
+  for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
+    if (bb->data_flow_info != NULL) {
+      bb->data_flow_info->use_v = NULL;
+      bb->data_flow_info->def_v = NULL;
+      bb->data_flow_info->live_in_v = NULL;
+      bb->data_flow_info->vreg_to_ssa_map = NULL;
+    }
+  }
+  def_block_matrix_ = NULL;
+  temp_dalvik_register_v_ = NULL;
+  temp_scoped_alloc_.reset();
+}
+
 ChildBlockIterator::ChildBlockIterator(BasicBlock* bb, MIRGraph* mir_graph)
     : basic_block_(bb), mir_graph_(mir_graph), visited_fallthrough_(false),
       visited_taken_(false), have_successors_(false) {
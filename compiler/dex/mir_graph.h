@@ -284,6 +284,9 @@ struct MIR {
     uint32_t sfield_lowering_info;
     // INVOKE data index, points to MIRGraph::method_lowering_infos_.
     uint32_t method_lowering_info;
+    // FILL_ARRAY_DATA payload built by CombineArrayInitialization(), nullptr for the payloads of
+    // the dex code.
+    const uint16_t* fill_array_data;
   } meta;
 };
 
@@ -434,11 +437,6 @@ class MIRGraph {
    */
   bool SkipCompilation();
 
-  /*
-   * Should we skip the compilation of this method based on its name?
-   */
-  bool SkipCompilation(const std::string& methodname);
-
   /*
    * Parse dex method and add MIR at current insert point.  Returns id (which is
    * actually the index of the method in the m_units_ array).
@@ -565,6 +563,14 @@ class MIRGraph {
 
   void ComputeInlineIFieldLoweringInfo(uint16_t field_idx, MIR* invoke, MIR* iget_or_iput);
 
+  /**
+   * @brief Charge the code units of a method body inlined by InlineCalls() to the budget.
+   * @return false, without charging anything, if the budget of the method is exhausted.
+   */
+  bool ChargeInliningBudget(uint32_t code_units);
+
+  int ParseInsn(const uint16_t* code_ptr, MIR::DecodedInstruction* decoded_instruction);
+
   void InitRegLocations();
 
   void RemapRegLocations();
@@ -799,6 +805,19 @@ class MIRGraph {
   bool EliminateClassInitChecksGate();
   bool EliminateClassInitChecks(BasicBlock* bb);
   void EliminateClassInitChecksEnd();
+  bool ApplyGlobalValueNumberingGate();
+  void ApplyGlobalValueNumbering();
+  bool CheckPathsFromIDom(BasicBlock* bb, ArenaBitVector* visited, BasicBlockId* work_list,
+                          bool* may_write_memory);
+  bool EliminateLoopChecksGate();
+  void EliminateLoopChecks();
+  void HoistLoopNullChecks(BasicBlock* header, BasicBlock* pre_header,
+                           const ArenaBitVector* loop_defs);
+  void OptimizeCountedLoop(BasicBlock* header, BasicBlock* pre_header, BasicBlock* tail,
+                           const ArenaBitVector* loop_blocks, MIR** sreg_defs);
+  bool CombineArrayInitializationGate();
+  void CombineArrayInitialization();
+  void CombineArrayStores(MIR* new_array, uint32_t* use_counts);
   /*
    * Type inference handling helpers.  Because Dalvik's bytecode is not fully typed,
    * we have to do some work to figure out the sreg type.  For some operations it is
@@ -857,9 +876,16 @@ class MIRGraph {
 
   /**
    * @brief Perform the initial preparation for the SSA Transformation.
+   * @details The liveness and def-block data only needed to place and fill
+   * the Phi nodes are allocated from temp_scoped_alloc_.
    */
   void InitializeSSATransformation();
 
+  /**
+   * @brief Release the temporary data of the SSA Transformation.
+   */
+  void FinishSSATransformation();
+
   /**
    * @brief Insert a the operands for the Phi nodes.
    * @param bb the considered BasicBlock.
@@ -912,7 +938,6 @@ class MIRGraph {
   void CompilerInitializeSSAConversion();
   bool DoSSAConversion(BasicBlock* bb);
   bool InvokeUsesMethodStar(MIR* mir);
-  int ParseInsn(const uint16_t* code_ptr, MIR::DecodedInstruction* decoded_instruction);
   bool ContentIsInsn(const uint16_t* code_ptr);
   BasicBlock* SplitBlock(DexOffset code_offset, BasicBlock* orig_block,
                          BasicBlock** immed_pred_block_p);
@@ -983,6 +1008,10 @@ class MIRGraph {
   uint16_t* temp_insn_data_;
   uint32_t temp_bit_vector_size_;
   ArenaBitVector* temp_bit_vector_;
+  // Maximum number of code units of method bodies inlined into a single method.
+  static constexpr uint32_t kMaxInlinedCodeUnits = 64u;
+  uint32_t inlined_calls_;
+  uint32_t inlined_code_units_;
   static const int kInvalidEntry = -1;
   GrowableArray<BasicBlock*> block_list_;
   ArenaBitVector* try_block_addr_;
@@ -1017,8 +1046,11 @@ class MIRGraph {
   GrowableArray<MirMethodLoweringInfo> method_lowering_infos_;
   static const uint64_t oat_data_flow_attributes_[kMirOpLast];
 
+  friend class ArrayInitializationTest;
   friend class ClassInitCheckEliminationTest;
+  friend class GlobalValueNumberingTest;
   friend class LocalValueNumberingTest;
+  friend class LoopCheckEliminationTest;
 };
 
 }  // namespace art
@@ -1114,6 +1114,665 @@ void MIRGraph::EliminateClassInitChecksEnd() {
   temp_scoped_alloc_.reset();
 }
 
+bool MIRGraph::ApplyGlobalValueNumberingGate() {
+  return (cu_->disable_opt & (1 << kGlobalValueNumbering)) == 0;
+}
+
+// Returns whether the MIR may change what later loads see, as a write or a memory barrier.
+static bool MayWriteMemory(MIRGraph* mir_graph, MIR* mir) {
+  int opcode = mir->dalvikInsn.opcode;
+  if (opcode >= kMirOpFirst) {
+    // Extended MIRs don't access memory.
+    return false;
+  }
+  if ((Instruction::FlagsOf(mir->dalvikInsn.opcode) & Instruction::kInvoke) != 0) {
+    return (mir->optimization_flags & MIR_INLINED) == 0;
+  }
+  if ((opcode >= Instruction::APUT && opcode <= Instruction::APUT_SHORT) ||
+      (opcode >= Instruction::IPUT && opcode <= Instruction::IPUT_SHORT) ||
+      (opcode >= Instruction::SPUT && opcode <= Instruction::SPUT_SHORT)) {
+    return true;
+  }
+  // Volatile loads are barriers. Unresolved fields may be volatile.
+  if (opcode >= Instruction::IGET && opcode <= Instruction::IGET_SHORT) {
+    const MirIFieldLoweringInfo& field_info = mir_graph->GetIFieldLoweringInfo(mir);
+    return !field_info.IsResolved() || field_info.IsVolatile();
+  }
+  if (opcode >= Instruction::SGET && opcode <= Instruction::SGET_SHORT) {
+    const MirSFieldLoweringInfo& field_info = mir_graph->GetSFieldLoweringInfo(mir);
+    return !field_info.IsResolved() || field_info.IsVolatile();
+  }
+  switch (opcode) {
+    case Instruction::MONITOR_ENTER:
+    case Instruction::MONITOR_EXIT:
+    case Instruction::FILL_ARRAY_DATA:
+    case Instruction::FILLED_NEW_ARRAY:  // Unique references escape into the new array.
+    case Instruction::FILLED_NEW_ARRAY_RANGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * Checks the blocks on the paths from the immediate dominator of bb to bb, including bb itself
+ * if it's in a loop. Returns false if any of them is a catch handler, since the dominator may
+ * then have been left before its end. Otherwise sets *may_write_memory if any of them may
+ * write to memory. The visited bits are clear on entry and on return.
+ */
+bool MIRGraph::CheckPathsFromIDom(BasicBlock* bb, ArenaBitVector* visited,
+                                  BasicBlockId* work_list, bool* may_write_memory) {
+  *may_write_memory = false;
+  bool result = !bb->catch_entry;
+  size_t work_list_size = 0u;
+  GrowableArray<BasicBlockId>::Iterator iter(bb->predecessors);
+  for (BasicBlockId pred_id = iter.Next(); pred_id != NullBasicBlockId; pred_id = iter.Next()) {
+    if (pred_id != bb->i_dom && !visited->IsBitSet(pred_id)) {
+      visited->SetBit(pred_id);
+      work_list[work_list_size++] = pred_id;
+    }
+  }
+  for (size_t i = 0u; result && i != work_list_size; ++i) {
+    BasicBlock* block = GetBasicBlock(work_list[i]);
+    if (block->catch_entry) {
+      result = false;
+      break;
+    }
+    for (MIR* mir = block->first_mir_insn; !*may_write_memory && mir != nullptr; mir = mir->next) {
+      *may_write_memory = MayWriteMemory(this, mir);
+    }
+    GrowableArray<BasicBlockId>::Iterator pred_iter(block->predecessors);
+    for (BasicBlockId pred_id = pred_iter.Next(); pred_id != NullBasicBlockId;
+         pred_id = pred_iter.Next()) {
+      if (pred_id != bb->i_dom && !visited->IsBitSet(pred_id)) {
+        visited->SetBit(pred_id);
+        work_list[work_list_size++] = pred_id;
+      }
+    }
+  }
+  for (size_t i = 0u; i != work_list_size; ++i) {
+    visited->ClearBit(work_list[i]);
+  }
+  return result;
+}
+
+void MIRGraph::ApplyGlobalValueNumbering() {
+  ScopedArenaAllocator allocator(&cu_->arena_stack);
+  ArenaBitVector* visited =
+      new (&allocator) ArenaBitVector(&allocator, GetNumBlocks(), false, kBitMapMisc);
+  visited->ClearAllBits();
+  BasicBlockId* work_list = static_cast<BasicBlockId*>(
+      allocator.Alloc(GetNumBlocks() * sizeof(*work_list), kArenaAllocMisc));
+
+  // Walk the dominator tree depth first. Each block starts with the value numbering state at
+  // the end of its immediate dominator, which is still alive below it on the stack. That keeps
+  // the LVNs' scoped allocations in stack order.
+  struct WorkItem {
+    BasicBlock* bb;
+    ArenaBitVector::Iterator* i_dominated_iter;
+    LocalValueNumbering* lvn;
+  };
+  std::vector<WorkItem> work_stack;
+  BasicBlock* entry = GetEntryBlock();
+  WorkItem root = { entry, entry->i_dominated->GetIterator(), LocalValueNumbering::Create(cu_) };
+  work_stack.push_back(root);
+  while (!work_stack.empty()) {
+    const WorkItem& curr = work_stack.back();
+    int bb_id = curr.i_dominated_iter->Next();
+    if (bb_id == -1) {
+      delete curr.lvn;
+      work_stack.pop_back();
+      continue;
+    }
+    BasicBlock* bb = GetBasicBlock(bb_id);
+    bool may_write_memory;
+    LocalValueNumbering* lvn;
+    if (CheckPathsFromIDom(bb, visited, work_list, &may_write_memory)) {
+      lvn = LocalValueNumbering::Create(cu_, *curr.lvn);
+      if (may_write_memory) {
+        lvn->KillMemory();
+      }
+    } else {
+      lvn = LocalValueNumbering::Create(cu_);
+    }
+    if (bb->block_type == kDalvikByteCode) {
+      for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+        lvn->GetValueNumber(mir);
+      }
+    }
+    WorkItem item = { bb, bb->i_dominated->GetIterator(), lvn };
+    work_stack.push_back(item);
+  }
+}
+
+// Short loops may run this many MIRs without a suspend check, see OptimizeCountedLoop().
+static constexpr int64_t kMaxMIRsWithoutSuspendCheck = 1024;
+
+bool MIRGraph::EliminateLoopChecksGate() {
+  // Every loop has a backward branch. The hoisted null checks are only supported by Quick.
+  return (cu_->disable_opt & (1 << kLoopCheckElimination)) == 0 && backward_branches_ != 0 &&
+      !cu_->compiler->IsPortable();
+}
+
+/*
+ * Looks for natural loops with a single back edge, entered from a single pre-header, and
+ * optimizes their checks.
+ */
+void MIRGraph::EliminateLoopChecks() {
+  ScopedArenaAllocator allocator(&cu_->arena_stack);
+  ArenaBitVector* loop_blocks =
+      new (&allocator) ArenaBitVector(&allocator, GetNumBlocks(), false, kBitMapMisc);
+  ArenaBitVector* loop_defs =
+      new (&allocator) ArenaBitVector(&allocator, GetNumSSARegs(), false, kBitMapMisc);
+  BasicBlockId* work_list = static_cast<BasicBlockId*>(
+      allocator.Alloc(GetNumBlocks() * sizeof(*work_list), kArenaAllocMisc));
+
+  // Record the defining MIR of each SSA reg, nullptr for the method's ins.
+  MIR** sreg_defs = static_cast<MIR**>(
+      allocator.Alloc(GetNumSSARegs() * sizeof(*sreg_defs), kArenaAllocMisc));
+  std::fill_n(sreg_defs, GetNumSSARegs(), nullptr);
+  AllNodesIterator iter(this);
+  for (BasicBlock* bb = iter.Next(); bb != nullptr; bb = iter.Next()) {
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      if (mir->ssa_rep != nullptr) {
+        for (int i = 0; i != mir->ssa_rep->num_defs; ++i) {
+          sreg_defs[mir->ssa_rep->defs[i]] = mir;
+        }
+      }
+    }
+  }
+
+  AllNodesIterator header_iter(this);
+  for (BasicBlock* header = header_iter.Next(); header != nullptr; header = header_iter.Next()) {
+    if (header->block_type != kDalvikByteCode || header->catch_entry ||
+        header->dominators == nullptr) {
+      continue;
+    }
+    // A predecessor dominated by the header is the tail of a back edge.
+    BasicBlock* pre_header = nullptr;
+    BasicBlock* tail = nullptr;
+    bool simple_loop = true;
+    GrowableArray<BasicBlockId>::Iterator pred_iter(header->predecessors);
+    for (BasicBlockId pred_id = pred_iter.Next(); pred_id != NullBasicBlockId;
+         pred_id = pred_iter.Next()) {
+      BasicBlock* pred = GetBasicBlock(pred_id);
+      if (pred->dominators != nullptr && pred->dominators->IsBitSet(header->id)) {
+        simple_loop = simple_loop && (tail == nullptr);
+        tail = pred;
+      } else {
+        simple_loop = simple_loop && (pre_header == nullptr);
+        pre_header = pred;
+      }
+    }
+    if (!simple_loop || tail == nullptr || pre_header == nullptr) {
+      continue;
+    }
+
+    // The loop is made of the blocks reaching the tail without going through the header.
+    loop_blocks->ClearAllBits();
+    loop_blocks->SetBit(header->id);
+    size_t work_list_size = 0u;
+    if (tail != header) {
+      loop_blocks->SetBit(tail->id);
+      work_list[work_list_size++] = tail->id;
+    }
+    for (size_t i = 0u; i != work_list_size; ++i) {
+      GrowableArray<BasicBlockId>::Iterator iter(GetBasicBlock(work_list[i])->predecessors);
+      for (BasicBlockId pred_id = iter.Next(); pred_id != NullBasicBlockId;
+           pred_id = iter.Next()) {
+        BasicBlock* pred = GetBasicBlock(pred_id);
+        if (!loop_blocks->IsBitSet(pred_id) && pred->dominators != nullptr &&
+            pred->dominators->IsBitSet(header->id)) {
+          loop_blocks->SetBit(pred_id);
+          work_list[work_list_size++] = pred_id;
+        }
+      }
+    }
+    loop_defs->ClearAllBits();
+    ArenaBitVector::Iterator* loop_iter = loop_blocks->GetIterator();
+    for (int bb_id = loop_iter->Next(); bb_id != -1; bb_id = loop_iter->Next()) {
+      for (MIR* mir = GetBasicBlock(bb_id)->first_mir_insn; mir != nullptr; mir = mir->next) {
+        if (mir->ssa_rep != nullptr) {
+          for (int i = 0; i != mir->ssa_rep->num_defs; ++i) {
+            loop_defs->SetBit(mir->ssa_rep->defs[i]);
+          }
+        }
+      }
+    }
+
+    HoistLoopNullChecks(header, pre_header, loop_defs);
+    if (tail != header) {
+      OptimizeCountedLoop(header, pre_header, tail, loop_blocks, sreg_defs);
+    }
+  }
+}
+
+/*
+ * Moves the null checks of loop invariant references at the start of the loop header to the
+ * pre-header, where they're done once. The checks left in the loop are then removed by null
+ * check elimination.
+ */
+void MIRGraph::HoistLoopNullChecks(BasicBlock* header, BasicBlock* pre_header,
+                                   const ArenaBitVector* loop_defs) {
+  if ((cu_->disable_opt & (1 << kNullCheckElimination)) != 0 ||
+      pre_header->block_type != kDalvikByteCode ||
+      pre_header->successor_block_list_type != kNotUsed ||
+      !((pre_header->fall_through == header->id && pre_header->taken == NullBasicBlockId) ||
+        (pre_header->taken == header->id && pre_header->fall_through == NullBasicBlockId))) {
+    return;
+  }
+  // The checks go before the pre-header's GOTO, if any.
+  MIR* insert_after = pre_header->last_mir_insn;
+  if (insert_after != nullptr &&
+      (Instruction::FlagsOf(insert_after->dalvikInsn.opcode) & Instruction::kBranch) != 0) {
+    MIR* branch = insert_after;
+    insert_after = nullptr;
+    for (MIR* mir = pre_header->first_mir_insn; mir != branch; mir = mir->next) {
+      insert_after = mir;
+    }
+  }
+
+  for (MIR* mir = header->first_mir_insn; mir != nullptr; mir = mir->next) {
+    int opcode = mir->dalvikInsn.opcode;
+    if (opcode == kMirOpPhi) {
+      continue;
+    }
+    if (opcode >= kMirOpFirst) {
+      break;
+    }
+    uint64_t df_attributes = GetDataFlowAttributes(mir);
+    if ((Instruction::FlagsOf(mir->dalvikInsn.opcode) & Instruction::kThrow) == 0) {
+      // The GC map used at a hoisted check is the one of the checking instruction, so no
+      // reference may be defined before it.
+      if ((df_attributes & DF_DA) != 0 && (df_attributes & (DF_CORE_A | DF_FP_A)) == 0) {
+        break;
+      }
+      continue;
+    }
+    // Only field and array accesses are known to check for null before anything else.
+    bool is_iget = (opcode >= Instruction::IGET && opcode <= Instruction::IGET_SHORT);
+    bool is_field_access = (opcode >= Instruction::IGET && opcode <= Instruction::IPUT_SHORT);
+    bool is_array_access = (opcode >= Instruction::AGET && opcode <= Instruction::APUT_SHORT) ||
+        opcode == Instruction::ARRAY_LENGTH;
+    if ((!is_field_access && !is_array_access) ||
+        (is_field_access && !GetIFieldLoweringInfo(mir).IsResolved()) ||
+        try_block_addr_->IsBitSet(mir->offset)) {
+      break;
+    }
+    int src_idx = ((df_attributes & DF_NULL_CHK_1) != 0) ? 1 :
+        ((df_attributes & DF_NULL_CHK_2) != 0) ? 2 : 0;
+    int32_t obj_sreg = mir->ssa_rep->uses[src_idx];
+    if (loop_defs->IsBitSet(obj_sreg)) {
+      break;
+    }
+
+    MIR* check = static_cast<MIR*>(arena_->Alloc(sizeof(MIR), kArenaAllocMIR));
+    *check = *mir;  // Throw with the dex pc of the original check.
+    check->dalvikInsn.opcode = static_cast<Instruction::Code>(kMirOpNullCheck);
+    check->dalvikInsn.vA = SRegToVReg(obj_sreg);
+    check->optimization_flags = 0u;
+    check->ssa_rep = static_cast<SSARepresentation*>(
+        arena_->Alloc(sizeof(SSARepresentation), kArenaAllocDFInfo));
+    check->ssa_rep->num_uses = 1;
+    check->ssa_rep->uses = static_cast<int32_t*>(arena_->Alloc(sizeof(int32_t),
+                                                               kArenaAllocDFInfo));
+    check->ssa_rep->uses[0] = obj_sreg;
+    check->ssa_rep->fp_use = static_cast<bool*>(arena_->Alloc(sizeof(bool), kArenaAllocDFInfo));
+    check->ssa_rep->num_defs = 0;
+    if (insert_after == nullptr) {
+      pre_header->PrependMIR(check);
+    } else {
+      pre_header->InsertMIRAfter(insert_after, check);
+    }
+    insert_after = check;
+    if (cu_->verbose) {
+      LOG(INFO) << "Hoisted null check at 0x" << std::hex << mir->offset;
+    }
+
+    // Go on only past instructions that can't throw anything else and define no reference.
+    if (opcode != Instruction::ARRAY_LENGTH &&
+        (!is_iget || opcode == Instruction::IGET_OBJECT ||
+         GetIFieldLoweringInfo(mir).IsVolatile())) {
+      break;
+    }
+  }
+}
+
+/*
+ * Optimizes a loop testing an induction variable against a bound in its header:
+ *   i = phi(c, i + 1); if (i >= bound) exit; ...
+ * With c >= 0 and the bound the length of an array, the accesses to that array at index i
+ * can't be out of bounds. With a constant bound the loop is short enough, unless it contains
+ * other loops, to not need a suspend check: one in an enclosing loop is enough.
+ */
+void MIRGraph::OptimizeCountedLoop(BasicBlock* header, BasicBlock* pre_header, BasicBlock* tail,
+                                   const ArenaBitVector* loop_blocks, MIR** sreg_defs) {
+  MIR* test = header->last_mir_insn;
+  if (test == nullptr || test->ssa_rep == nullptr) {
+    return;
+  }
+  int32_t index_sreg;
+  int32_t bound_sreg;
+  BasicBlockId body_id;
+  switch (test->dalvikInsn.opcode) {
+    case Instruction::IF_GE:  // if (i >= bound) exit
+    case Instruction::IF_LT:  // if (i < bound) body
+      index_sreg = test->ssa_rep->uses[0];
+      bound_sreg = test->ssa_rep->uses[1];
+      body_id = (test->dalvikInsn.opcode == Instruction::IF_GE) ? header->fall_through
+                                                                : header->taken;
+      break;
+    case Instruction::IF_LE:  // if (bound <= i) exit
+    case Instruction::IF_GT:  // if (bound > i) body
+      bound_sreg = test->ssa_rep->uses[0];
+      index_sreg = test->ssa_rep->uses[1];
+      body_id = (test->dalvikInsn.opcode == Instruction::IF_LE) ? header->fall_through
+                                                                : header->taken;
+      break;
+    default:
+      return;
+  }
+  BasicBlockId exit_id = (body_id == header->taken) ? header->fall_through : header->taken;
+  BasicBlock* body = GetBasicBlock(body_id);
+  if (!loop_blocks->IsBitSet(body_id) || loop_blocks->IsBitSet(exit_id) ||
+      body->predecessors->Size() != 1u) {
+    return;
+  }
+
+  // The index must be a phi of the header, starting from a constant and incremented by one.
+  MIR* phi = sreg_defs[index_sreg];
+  if (phi == nullptr || static_cast<int>(phi->dalvikInsn.opcode) != kMirOpPhi) {
+    return;
+  }
+  int32_t init_sreg = INVALID_SREG;
+  int32_t next_sreg = INVALID_SREG;
+  for (int i = 0; i != phi->ssa_rep->num_uses; ++i) {
+    if (phi->meta.phi_incoming[i] == pre_header->id) {
+      init_sreg = phi->ssa_rep->uses[i];
+    } else if (phi->meta.phi_incoming[i] == tail->id) {
+      next_sreg = phi->ssa_rep->uses[i];
+    } else {
+      return;  // Not a phi of the header.
+    }
+  }
+  if (init_sreg == INVALID_SREG || next_sreg == INVALID_SREG || !IsConst(init_sreg)) {
+    return;
+  }
+  MIR* increment = sreg_defs[next_sreg];
+  if (increment == nullptr) {
+    return;
+  }
+  switch (increment->dalvikInsn.opcode) {
+    case Instruction::ADD_INT_LIT8:
+    case Instruction::ADD_INT_LIT16:
+      if (increment->ssa_rep->uses[0] != index_sreg || increment->dalvikInsn.vC != 1u) {
+        return;
+      }
+      break;
+    case Instruction::ADD_INT:
+    case Instruction::ADD_INT_2ADDR: {
+      int32_t other_sreg = (increment->ssa_rep->uses[0] == index_sreg)
+          ? increment->ssa_rep->uses[1] : increment->ssa_rep->uses[0];
+      if ((increment->ssa_rep->uses[0] != index_sreg &&
+           increment->ssa_rep->uses[1] != index_sreg) ||
+          !IsConst(other_sreg) || ConstantValue(other_sreg) != 1) {
+        return;
+      }
+      break;
+    }
+    default:
+      return;
+  }
+
+  // In the blocks dominated by the body, 0 <= init <= i < bound; i + 1 can't overflow.
+  MIR* length = sreg_defs[bound_sreg];
+  if (ConstantValue(init_sreg) >= 0 && length != nullptr &&
+      length->dalvikInsn.opcode == Instruction::ARRAY_LENGTH) {
+    int32_t array_sreg = length->ssa_rep->uses[0];
+    ArenaBitVector::Iterator* iter = loop_blocks->GetIterator();
+    for (int bb_id = iter->Next(); bb_id != -1; bb_id = iter->Next()) {
+      BasicBlock* bb = GetBasicBlock(bb_id);
+      if (!bb->dominators->IsBitSet(body_id)) {
+        continue;
+      }
+      for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+        int opcode = mir->dalvikInsn.opcode;
+        int array_idx;
+        if (opcode >= Instruction::AGET && opcode <= Instruction::AGET_SHORT) {
+          array_idx = 0;
+        } else if (opcode >= Instruction::APUT && opcode <= Instruction::APUT_SHORT) {
+          array_idx = (opcode == Instruction::APUT_WIDE) ? 2 : 1;
+        } else {
+          continue;
+        }
+        if (mir->ssa_rep->uses[array_idx] == array_sreg &&
+            mir->ssa_rep->uses[array_idx + 1] == index_sreg) {
+          mir->optimization_flags |= MIR_IGNORE_RANGE_CHECK;
+          if (cu_->verbose) {
+            LOG(INFO) << "Removed range check in counted loop at 0x" << std::hex << mir->offset;
+          }
+        }
+      }
+    }
+  }
+
+  // A constant bound limits the number of iterations.
+  MIR* branch = tail->last_mir_insn;
+  if (!IsConst(bound_sreg) || branch == nullptr ||
+      (Instruction::FlagsOf(branch->dalvikInsn.opcode) & Instruction::kBranch) == 0) {
+    return;
+  }
+  int64_t iterations =
+      static_cast<int64_t>(ConstantValue(bound_sreg)) - ConstantValue(init_sreg);
+  int64_t loop_size = 0;
+  ArenaBitVector::Iterator* iter = loop_blocks->GetIterator();
+  for (int bb_id = iter->Next(); bb_id != -1; bb_id = iter->Next()) {
+    BasicBlock* bb = GetBasicBlock(bb_id);
+    // A back edge other than the tail's belongs to an inner loop.
+    if ((bb->fall_through != header->id && bb->fall_through != NullBasicBlockId &&
+         bb->dominators->IsBitSet(bb->fall_through)) ||
+        (bb->taken != header->id && bb->taken != NullBasicBlockId &&
+         bb->dominators->IsBitSet(bb->taken))) {
+      return;
+    }
+    if (bb->successor_block_list_type != kNotUsed) {
+      GrowableArray<SuccessorBlockInfo*>::Iterator succ_iter(bb->successor_blocks);
+      for (SuccessorBlockInfo* info = succ_iter.Next(); info != nullptr;
+           info = succ_iter.Next()) {
+        if (info->block != header->id && bb->dominators->IsBitSet(info->block)) {
+          return;
+        }
+      }
+    }
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      ++loop_size;
+    }
+  }
+  if (iterations * loop_size <= kMaxMIRsWithoutSuspendCheck) {
+    branch->optimization_flags |= MIR_IGNORE_SUSPEND_CHECK;
+    if (cu_->verbose) {
+      LOG(INFO) << "Suppressed suspend check of short loop at 0x" << std::hex << branch->offset;
+    }
+  }
+}
+
+// A run of constant stores to a new array is combined into a fill-array-data when it has at least
+// this many stores, filling at least half of a payload of at most kMaxArrayInitializationBytes.
+static constexpr size_t kMinArrayInitializationStores = 4u;
+static constexpr uint64_t kMaxArrayInitializationBytes = 64 * KB;
+
+// Returns the element width of a primitive aput, 0 for the other opcodes.
+static uint16_t PrimitiveArrayPutWidth(int opcode) {
+  switch (opcode) {
+    case Instruction::APUT:
+      return 4u;
+    case Instruction::APUT_WIDE:
+      return 8u;
+    case Instruction::APUT_BOOLEAN:
+    case Instruction::APUT_BYTE:
+      return 1u;
+    case Instruction::APUT_CHAR:
+    case Instruction::APUT_SHORT:
+      return 2u;
+    default:
+      return 0u;
+  }
+}
+
+bool MIRGraph::CombineArrayInitializationGate() {
+  // The payloads built by the pass are only lowered by Quick.
+  return (cu_->disable_opt & (1 << kArrayInitialization)) == 0 && !cu_->compiler->IsPortable();
+}
+
+/*
+ * Looks for new arrays of constant length initialized by constant stores, a new-array followed
+ * by const and aput instructions, as the lookup tables of generated code are. Each run of such
+ * stores becomes a single fill-array-data, copying a payload built here, and the constants only
+ * used by the stores are removed.
+ */
+void MIRGraph::CombineArrayInitialization() {
+  ScopedArenaAllocator allocator(&cu_->arena_stack);
+  uint32_t* use_counts = nullptr;  // Counted for the first new-array of constant length.
+  AllNodesIterator iter(this);
+  for (BasicBlock* bb = iter.Next(); bb != nullptr; bb = iter.Next()) {
+    if (bb->block_type != kDalvikByteCode) {
+      continue;
+    }
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      if (mir->dalvikInsn.opcode != Instruction::NEW_ARRAY || !IsConst(mir->ssa_rep->uses[0])) {
+        continue;
+      }
+      if (use_counts == nullptr) {
+        use_counts = static_cast<uint32_t*>(
+            allocator.Alloc(GetNumSSARegs() * sizeof(*use_counts), kArenaAllocMisc));
+        std::fill_n(use_counts, GetNumSSARegs(), 0u);
+        AllNodesIterator count_iter(this);
+        for (BasicBlock* count_bb = count_iter.Next(); count_bb != nullptr;
+             count_bb = count_iter.Next()) {
+          for (MIR* use = count_bb->first_mir_insn; use != nullptr; use = use->next) {
+            if (use->ssa_rep != nullptr) {
+              for (int i = 0; i != use->ssa_rep->num_uses; ++i) {
+                ++use_counts[use->ssa_rep->uses[i]];
+              }
+            }
+          }
+        }
+      }
+      CombineArrayStores(mir, use_counts);
+    }
+  }
+}
+
+void MIRGraph::CombineArrayStores(MIR* new_array, uint32_t* use_counts) {
+  int32_t array_sreg = new_array->ssa_rep->defs[0];
+  int32_t length = ConstantValue(new_array->ssa_rep->uses[0]);
+
+  // The run ends at the first instruction which is neither a constant nor a store of a constant
+  // to a constant index of the array. Nothing in the run can throw or read the array, so the
+  // stores can all be done by the first one.
+  uint16_t width = 0u;
+  size_t num_stores = 0u;
+  int32_t max_index = -1;
+  MIR* end = new_array->next;
+  for (; end != nullptr; end = end->next) {
+    if ((GetDataFlowAttributes(end) & DF_SETS_CONST) != 0) {
+      continue;
+    }
+    int opcode = end->dalvikInsn.opcode;
+    uint16_t store_width = PrimitiveArrayPutWidth(opcode);
+    if (store_width == 0u || (width != 0u && store_width != width)) {
+      break;
+    }
+    const int32_t* uses = end->ssa_rep->uses;
+    int array_idx = (opcode == Instruction::APUT_WIDE) ? 2 : 1;
+    if (uses[array_idx] != array_sreg || !IsConst(uses[array_idx + 1]) || !IsConst(uses[0]) ||
+        (opcode == Instruction::APUT_WIDE && !IsConst(uses[1]))) {
+      break;
+    }
+    int32_t index = ConstantValue(uses[array_idx + 1]);
+    if (index < 0 || index >= length) {
+      break;
+    }
+    width = store_width;
+    ++num_stores;
+    max_index = std::max(max_index, index);
+  }
+  uint32_t size = static_cast<uint32_t>(max_index + 1);
+  uint64_t size_in_bytes = static_cast<uint64_t>(size) * width;
+  if (num_stores < kMinArrayInitializationStores || size > 2u * num_stores ||
+      size_in_bytes > kMaxArrayInitializationBytes) {
+    return;
+  }
+
+  // The payload has the format of the dex code. The elements which aren't stored stay zero, as
+  // they are in the new array.
+  uint16_t* table = static_cast<uint16_t*>(
+      arena_->Alloc((4u + (size_in_bytes + 1u) / 2u) * sizeof(uint16_t), kArenaAllocData));
+  table[0] = static_cast<uint16_t>(Instruction::kArrayDataSignature);
+  table[1] = width;
+  table[2] = static_cast<uint16_t>(size & 0xffff);
+  table[3] = static_cast<uint16_t>(size >> 16);
+  uint8_t* data = reinterpret_cast<uint8_t*>(&table[4]);
+  MIR* fill = nullptr;
+  for (MIR* mir = new_array->next; mir != end; mir = mir->next) {
+    int opcode = mir->dalvikInsn.opcode;
+    if (PrimitiveArrayPutWidth(opcode) == 0u) {
+      continue;
+    }
+    SSARepresentation* ssa_rep = mir->ssa_rep;
+    int array_idx = (opcode == Instruction::APUT_WIDE) ? 2 : 1;
+    int32_t index = ConstantValue(ssa_rep->uses[array_idx + 1]);
+    uint64_t value = static_cast<uint32_t>(ConstantValue(ssa_rep->uses[0]));
+    if (opcode == Instruction::APUT_WIDE) {
+      value |= static_cast<uint64_t>(static_cast<uint32_t>(ConstantValue(ssa_rep->uses[1]))) << 32;
+    }
+    // The payload is little-endian.
+    for (uint16_t i = 0u; i != width; ++i) {
+      data[static_cast<size_t>(index) * width + i] = static_cast<uint8_t>(value >> (8u * i));
+    }
+    for (int i = 0; i != ssa_rep->num_uses; ++i) {
+      if (i != array_idx) {
+        --use_counts[ssa_rep->uses[i]];
+      }
+    }
+    if (fill == nullptr) {
+      // The array is known to be non-null and long enough.
+      fill = mir;
+      fill->dalvikInsn.opcode = Instruction::FILL_ARRAY_DATA;
+      fill->dalvikInsn.vA = fill->dalvikInsn.vB;
+      fill->dalvikInsn.vB = 0u;
+      fill->meta.fill_array_data = table;
+      fill->optimization_flags |= MIR_IGNORE_NULL_CHECK | MIR_IGNORE_RANGE_CHECK;
+      ssa_rep->uses += array_idx;
+      if (ssa_rep->fp_use != nullptr) {
+        ssa_rep->fp_use += array_idx;
+      }
+      ssa_rep->num_uses = 1;
+    } else {
+      mir->dalvikInsn.opcode = static_cast<Instruction::Code>(kMirOpNop);
+      ssa_rep->num_uses = 0;
+    }
+  }
+
+  // Remove the constants which were only used by the stores.
+  for (MIR* mir = new_array->next; mir != end; mir = mir->next) {
+    if ((GetDataFlowAttributes(mir) & DF_SETS_CONST) == 0) {
+      continue;
+    }
+    bool used = false;
+    for (int i = 0; i != mir->ssa_rep->num_defs; ++i) {
+      used |= (use_counts[mir->ssa_rep->defs[i]] != 0u);
+    }
+    if (!used) {
+      mir->dalvikInsn.opcode = static_cast<Instruction::Code>(kMirOpNop);
+      mir->ssa_rep->num_defs = 0;
+    }
+  }
+  if (cu_->verbose) {
+    LOG(INFO) << "Combined " << num_stores << " array stores at 0x" << std::hex << fill->offset;
+  }
+}
+
 void MIRGraph::ComputeInlineIFieldLoweringInfo(uint16_t field_idx, MIR* invoke, MIR* iget_or_iput) {
   uint32_t method_index = invoke->meta.method_lowering_info;
   if (temp_bit_vector_->IsBitSet(method_index)) {
@@ -1163,6 +1822,16 @@ void MIRGraph::InlineCallsStart() {
   temp_bit_vector_->ClearAllBits();
   temp_insn_data_ = static_cast<uint16_t*>(temp_scoped_alloc_->Alloc(
       temp_bit_vector_size_ * sizeof(*temp_insn_data_), kArenaAllocGrowableArray));
+  inlined_calls_ = 0u;
+  inlined_code_units_ = 0u;
+}
+
+bool MIRGraph::ChargeInliningBudget(uint32_t code_units) {
+  if (inlined_code_units_ + code_units > kMaxInlinedCodeUnits) {
+    return false;
+  }
+  inlined_code_units_ += code_units;
+  return true;
 }
 
 void MIRGraph::InlineCalls(BasicBlock* bb) {
@@ -1186,6 +1855,7 @@ void MIRGraph::InlineCalls(BasicBlock* bb) {
     MethodReference target = method_info.GetTargetMethod();
     if (cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(target.dex_file)
             ->GenInline(this, bb, mir, target.dex_method_index)) {
+      ++inlined_calls_;
       if (cu_->verbose) {
         LOG(INFO) << "In \"" << PrettyMethod(cu_->method_idx, *cu_->dex_file)
             << "\" @0x" << std::hex << mir->offset
@@ -1197,6 +1867,12 @@ void MIRGraph::InlineCalls(BasicBlock* bb) {
 }
 
 void MIRGraph::InlineCallsEnd() {
+  if (cu_->compiler_driver->GetDumpPasses() && (cu_->enable_debug & (1 << kDebugTimings)) != 0) {
+    // Reported with the pass timings, to relate the inlining budget to the compile time.
+    LOG(INFO) << "INLINING " << PrettyMethod(cu_->method_idx, *cu_->dex_file) << ": "
+        << inlined_calls_ << " calls, " << inlined_code_units_ << "/" << kMaxInlinedCodeUnits
+        << " code units";
+  }
   DCHECK(temp_insn_data_ != nullptr);
   temp_insn_data_ = nullptr;
   DCHECK(temp_bit_vector_ != nullptr);
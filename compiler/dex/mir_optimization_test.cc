@@ -403,4 +403,823 @@ TEST_F(ClassInitCheckEliminationTest, Catch) {
   }
 }
 
+class GlobalValueNumberingTest : public testing::Test {
+ protected:
+  struct IFieldDef {
+    uint16_t field_idx;
+    uintptr_t declaring_dex_file;
+    uint16_t declaring_field_idx;
+    bool is_volatile;
+  };
+
+  struct BBDef {
+    static constexpr size_t kMaxSuccessors = 2;
+    static constexpr size_t kMaxPredecessors = 4;
+
+    BBType type;
+    size_t num_successors;
+    BasicBlockId successors[kMaxSuccessors];
+    size_t num_predecessors;
+    BasicBlockId predecessors[kMaxPredecessors];
+  };
+
+  struct MIRDef {
+    static constexpr size_t kMaxSsaDefs = 1;
+    static constexpr size_t kMaxSsaUses = 2;
+
+    Instruction::Code opcode;
+    BasicBlockId bbid;
+    uint32_t field_info;
+    size_t num_uses;
+    int32_t uses[kMaxSsaUses];
+    size_t num_defs;
+    int32_t defs[kMaxSsaDefs];
+  };
+
+#define DEF_BB_IGET(opcode, bb, reg, obj, field_info) \
+    { opcode, bb, field_info, 1, { obj }, 1, { reg } }
+#define DEF_BB_IPUT(opcode, bb, reg, obj, field_info) \
+    { opcode, bb, field_info, 2, { reg, obj }, 0, { } }
+
+  void DoPrepareIFields(const IFieldDef* defs, size_t count) {
+    cu_.mir_graph->ifield_lowering_infos_.Reset();
+    cu_.mir_graph->ifield_lowering_infos_.Resize(count);
+    for (size_t i = 0u; i != count; ++i) {
+      const IFieldDef* def = &defs[i];
+      MirIFieldLoweringInfo field_info(def->field_idx);
+      if (def->declaring_dex_file != 0u) {
+        field_info.declaring_dex_file_ = reinterpret_cast<const DexFile*>(def->declaring_dex_file);
+        field_info.declaring_field_idx_ = def->declaring_field_idx;
+        field_info.flags_ = 0u |  // Without kFlagIsStatic.
+            (def->is_volatile ? MirIFieldLoweringInfo::kFlagIsVolatile : 0u);
+      }
+      cu_.mir_graph->ifield_lowering_infos_.Insert(field_info);
+    }
+  }
+
+  template <size_t count>
+  void PrepareIFields(const IFieldDef (&defs)[count]) {
+    DoPrepareIFields(defs, count);
+  }
+
+  void DoPrepareBasicBlocks(const BBDef* defs, size_t count) {
+    cu_.mir_graph->block_id_map_.clear();
+    cu_.mir_graph->block_list_.Reset();
+    ASSERT_LT(3u, count);  // null, entry, exit and at least one bytecode block.
+    ASSERT_EQ(kNullBlock, defs[0].type);
+    ASSERT_EQ(kEntryBlock, defs[1].type);
+    ASSERT_EQ(kExitBlock, defs[2].type);
+    for (size_t i = 0u; i != count; ++i) {
+      const BBDef* def = &defs[i];
+      BasicBlock* bb = cu_.mir_graph->NewMemBB(def->type, i);
+      cu_.mir_graph->block_list_.Insert(bb);
+      bb->successor_block_list_type = kNotUsed;
+      bb->successor_blocks = nullptr;
+      bb->fall_through = (def->num_successors >= 1) ? def->successors[0] : 0u;
+      bb->taken = (def->num_successors >= 2) ? def->successors[1] : 0u;
+      bb->predecessors = new (&cu_.arena) GrowableArray<BasicBlockId>(
+          &cu_.arena, def->num_predecessors, kGrowableArrayPredecessors);
+      for (size_t j = 0u; j != def->num_predecessors; ++j) {
+        ASSERT_NE(0u, def->predecessors[j]);
+        bb->predecessors->Insert(def->predecessors[j]);
+      }
+      if (def->type == kDalvikByteCode || def->type == kEntryBlock || def->type == kExitBlock) {
+        bb->data_flow_info = static_cast<BasicBlockDataFlow*>(
+            cu_.arena.Alloc(sizeof(BasicBlockDataFlow), kArenaAllocDFInfo));
+      }
+    }
+    cu_.mir_graph->num_blocks_ = count;
+    ASSERT_EQ(count, cu_.mir_graph->block_list_.Size());
+    cu_.mir_graph->entry_block_ = cu_.mir_graph->block_list_.Get(1);
+    ASSERT_EQ(kEntryBlock, cu_.mir_graph->entry_block_->block_type);
+    cu_.mir_graph->exit_block_ = cu_.mir_graph->block_list_.Get(2);
+    ASSERT_EQ(kExitBlock, cu_.mir_graph->exit_block_->block_type);
+  }
+
+  template <size_t count>
+  void PrepareBasicBlocks(const BBDef (&defs)[count]) {
+    DoPrepareBasicBlocks(defs, count);
+  }
+
+  void DoPrepareMIRs(const MIRDef* defs, size_t count) {
+    mir_count_ = count;
+    mirs_ = reinterpret_cast<MIR*>(cu_.arena.Alloc(sizeof(MIR) * count, kArenaAllocMIR));
+    ssa_reps_.resize(count);
+    for (size_t i = 0u; i != count; ++i) {
+      const MIRDef* def = &defs[i];
+      MIR* mir = &mirs_[i];
+      mir->dalvikInsn.opcode = def->opcode;
+      ASSERT_LT(def->bbid, cu_.mir_graph->block_list_.Size());
+      BasicBlock* bb = cu_.mir_graph->block_list_.Get(def->bbid);
+      bb->AppendMIR(mir);
+      ASSERT_TRUE(def->opcode >= Instruction::IGET && def->opcode <= Instruction::IPUT_SHORT);
+      ASSERT_LT(def->field_info, cu_.mir_graph->ifield_lowering_infos_.Size());
+      mir->meta.ifield_lowering_info = def->field_info;
+      mir->ssa_rep = &ssa_reps_[i];
+      mir->ssa_rep->num_uses = def->num_uses;
+      mir->ssa_rep->uses = const_cast<int32_t*>(def->uses);  // Not modified by GVN.
+      mir->ssa_rep->fp_use = nullptr;  // Not used by GVN.
+      mir->ssa_rep->num_defs = def->num_defs;
+      mir->ssa_rep->defs = const_cast<int32_t*>(def->defs);  // Not modified by GVN.
+      mir->ssa_rep->fp_def = nullptr;  // Not used by GVN.
+      mir->offset = 2 * i;  // All insns need to be at least 2 code units long.
+      mir->width = 2u;
+      mir->optimization_flags = 0u;
+    }
+  }
+
+  template <size_t count>
+  void PrepareMIRs(const MIRDef (&defs)[count]) {
+    DoPrepareMIRs(defs, count);
+  }
+
+  void PerformGVN() {
+    cu_.mir_graph->ComputeDFSOrders();
+    cu_.mir_graph->ComputeDominators();
+    bool gate_result = cu_.mir_graph->ApplyGlobalValueNumberingGate();
+    ASSERT_TRUE(gate_result);
+    cu_.mir_graph->ApplyGlobalValueNumbering();
+  }
+
+  template <size_t count>
+  void CheckIgnoreNullCheck(const bool (&expected)[count]) {
+    ASSERT_EQ(count, mir_count_);
+    for (size_t i = 0u; i != count; ++i) {
+      EXPECT_EQ(expected[i], (mirs_[i].optimization_flags & MIR_IGNORE_NULL_CHECK) != 0) << i;
+    }
+  }
+
+  GlobalValueNumberingTest()
+      : pool_(),
+        cu_(&pool_),
+        mir_count_(0u),
+        mirs_(nullptr) {
+    cu_.mir_graph.reset(new MIRGraph(&cu_, &cu_.arena));
+  }
+
+  ArenaPool pool_;
+  CompilationUnit cu_;
+  size_t mir_count_;
+  MIR* mirs_;
+  std::vector<SSARepresentation> ssa_reps_;
+};
+
+TEST_F(GlobalValueNumberingTest, Diamond) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },  // Object field.
+      { 1u, 1u, 1u, false },  // Int field.
+  };
+  static const GlobalValueNumberingTest::BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(6)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(4, 5), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(6), DEF_PRED1(3)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(6), DEF_PRED1(3)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED2(4, 5)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 3u, 0u, 100u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 3u, 1u, 0u, 1u),
+      DEF_BB_IGET(Instruction::IGET, 4u, 2u, 100u, 1u),         // Eliminated.
+      DEF_BB_IGET(Instruction::IGET, 5u, 3u, 101u, 1u),
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 6u, 4u, 100u, 0u),  // Eliminated.
+      DEF_BB_IGET(Instruction::IGET, 6u, 5u, 4u, 1u),           // Eliminated, same as v0.
+      DEF_BB_IGET(Instruction::IGET, 6u, 6u, 101u, 1u),         // Checked only in block #5.
+  };
+  static const bool expected_ignore_null_check[] = {
+      false, false, true, false, true, true, false
+  };
+
+  PrepareIFields(ifields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  PerformGVN();
+  CheckIgnoreNullCheck(expected_ignore_null_check);
+}
+
+TEST_F(GlobalValueNumberingTest, DiamondWithStore) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },  // Object field.
+      { 1u, 1u, 1u, false },  // Int field.
+  };
+  static const GlobalValueNumberingTest::BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(6)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(4, 5), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(6), DEF_PRED1(3)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(6), DEF_PRED1(3)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED2(4, 5)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 3u, 0u, 100u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 3u, 1u, 0u, 1u),
+      DEF_BB_IPUT(Instruction::IPUT, 5u, 1u, 101u, 1u),
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 6u, 2u, 100u, 0u),  // Eliminated.
+      DEF_BB_IGET(Instruction::IGET, 6u, 3u, 2u, 1u),           // Not the same as v0 anymore.
+  };
+  static const bool expected_ignore_null_check[] = {
+      false, false, false, true, false
+  };
+
+  PrepareIFields(ifields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  PerformGVN();
+  CheckIgnoreNullCheck(expected_ignore_null_check);
+}
+
+TEST_F(GlobalValueNumberingTest, Loop) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },  // Object field.
+      { 1u, 1u, 1u, false },  // Int field.
+  };
+  static const GlobalValueNumberingTest::BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(5)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(4), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(5, 4), DEF_PRED2(3, 4)),  // "taken" loops to self.
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED1(4)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 3u, 0u, 100u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 3u, 1u, 0u, 1u),
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 4u, 2u, 100u, 0u),  // Eliminated.
+      DEF_BB_IGET(Instruction::IGET, 4u, 3u, 2u, 1u),           // Eliminated, same as v0.
+      DEF_BB_IGET(Instruction::IGET, 5u, 4u, 0u, 1u),           // Eliminated.
+  };
+  static const bool expected_ignore_null_check[] = {
+      false, false, true, true, true
+  };
+
+  PrepareIFields(ifields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  PerformGVN();
+  CheckIgnoreNullCheck(expected_ignore_null_check);
+}
+
+TEST_F(GlobalValueNumberingTest, LoopWithStore) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },  // Object field.
+      { 1u, 1u, 1u, false },  // Int field.
+  };
+  static const GlobalValueNumberingTest::BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(5)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(4), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(5, 4), DEF_PRED2(3, 4)),  // "taken" loops to self.
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED1(4)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 3u, 0u, 100u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 3u, 1u, 0u, 1u),
+      DEF_BB_IGET(Instruction::IGET_OBJECT, 4u, 2u, 100u, 0u),  // Eliminated.
+      DEF_BB_IGET(Instruction::IGET, 4u, 3u, 2u, 1u),           // Stored to on the back edge.
+      DEF_BB_IPUT(Instruction::IPUT_OBJECT, 4u, 101u, 100u, 0u),
+  };
+  static const bool expected_ignore_null_check[] = {
+      false, false, true, false, true
+  };
+
+  PrepareIFields(ifields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  PerformGVN();
+  CheckIgnoreNullCheck(expected_ignore_null_check);
+}
+
+TEST_F(GlobalValueNumberingTest, Catch) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },
+  };
+  static const GlobalValueNumberingTest::BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(5)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(5, 4), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(5), DEF_PRED1(3)),  // Catch handler.
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED2(3, 4)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_BB_IGET(Instruction::IGET, 3u, 0u, 100u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 3u, 1u, 101u, 0u),
+      DEF_BB_IGET(Instruction::IGET, 4u, 2u, 100u, 0u),  // Not eliminated.
+      DEF_BB_IGET(Instruction::IGET, 5u, 3u, 101u, 0u),  // Not eliminated.
+  };
+  static const bool expected_ignore_null_check[] = {
+      false, false, false, false
+  };
+
+  PrepareIFields(ifields);
+  PrepareBasicBlocks(bbs);
+  BasicBlock* catch_handler = cu_.mir_graph->GetBasicBlock(4u);
+  catch_handler->catch_entry = true;
+  PrepareMIRs(mirs);
+  PerformGVN();
+  CheckIgnoreNullCheck(expected_ignore_null_check);
+}
+
+class LoopCheckEliminationTest : public testing::Test {
+ protected:
+  static constexpr size_t kNumSRegs = 16u;
+
+  struct IFieldDef {
+    uint16_t field_idx;
+    uintptr_t declaring_dex_file;
+    uint16_t declaring_field_idx;
+    bool is_volatile;
+  };
+
+  struct BBDef {
+    static constexpr size_t kMaxSuccessors = 2;
+    static constexpr size_t kMaxPredecessors = 4;
+
+    BBType type;
+    size_t num_successors;
+    BasicBlockId successors[kMaxSuccessors];
+    size_t num_predecessors;
+    BasicBlockId predecessors[kMaxPredecessors];
+  };
+
+  struct MIRDef {
+    static constexpr size_t kMaxSsaDefs = 1;
+    static constexpr size_t kMaxSsaUses = 3;
+
+    Instruction::Code opcode;
+    BasicBlockId bbid;
+    int32_t value;
+    uint32_t field_info;
+    size_t num_uses;
+    int32_t uses[kMaxSsaUses];
+    size_t num_defs;
+    int32_t defs[kMaxSsaDefs];
+  };
+
+#define DEF_LOOP_CONST(bb, reg, value) \
+    { Instruction::CONST, bb, value, 0u, 0, { }, 1, { reg } }
+#define DEF_LOOP_PHI2(bb, reg, src1, src2) \
+    { static_cast<Instruction::Code>(kMirOpPhi), bb, 0, 0u, 2, { src1, src2 }, 1, { reg } }
+#define DEF_LOOP_ADD_LIT(bb, reg, src, value) \
+    { Instruction::ADD_INT_LIT8, bb, value, 0u, 1, { src }, 1, { reg } }
+#define DEF_LOOP_IF(bb, opcode, src1, src2) \
+    { opcode, bb, 0, 0u, 2, { src1, src2 }, 0, { } }
+#define DEF_LOOP_GOTO(bb) \
+    { Instruction::GOTO, bb, 0, 0u, 0, { }, 0, { } }
+#define DEF_LOOP_ARRAY_LENGTH(bb, reg, array) \
+    { Instruction::ARRAY_LENGTH, bb, 0, 0u, 1, { array }, 1, { reg } }
+#define DEF_LOOP_AGET(bb, reg, array, index) \
+    { Instruction::AGET, bb, 0, 0u, 2, { array, index }, 1, { reg } }
+#define DEF_LOOP_APUT(bb, reg, array, index) \
+    { Instruction::APUT, bb, 0, 0u, 3, { reg, array, index }, 0, { } }
+#define DEF_LOOP_IGET(bb, opcode, reg, obj, field_info) \
+    { opcode, bb, 0, field_info, 1, { obj }, 1, { reg } }
+
+  void DoPrepareIFields(const IFieldDef* defs, size_t count) {
+    cu_.mir_graph->ifield_lowering_infos_.Reset();
+    cu_.mir_graph->ifield_lowering_infos_.Resize(count);
+    for (size_t i = 0u; i != count; ++i) {
+      const IFieldDef* def = &defs[i];
+      MirIFieldLoweringInfo field_info(def->field_idx);
+      if (def->declaring_dex_file != 0u) {
+        field_info.declaring_dex_file_ = reinterpret_cast<const DexFile*>(def->declaring_dex_file);
+        field_info.declaring_field_idx_ = def->declaring_field_idx;
+        field_info.flags_ = 0u |  // Without kFlagIsStatic.
+            (def->is_volatile ? MirIFieldLoweringInfo::kFlagIsVolatile : 0u);
+      }
+      cu_.mir_graph->ifield_lowering_infos_.Insert(field_info);
+    }
+  }
+
+  template <size_t count>
+  void PrepareIFields(const IFieldDef (&defs)[count]) {
+    DoPrepareIFields(defs, count);
+  }
+
+  void DoPrepareBasicBlocks(const BBDef* defs, size_t count) {
+    cu_.mir_graph->block_id_map_.clear();
+    cu_.mir_graph->block_list_.Reset();
+    ASSERT_LT(3u, count);  // null, entry, exit and at least one bytecode block.
+    ASSERT_EQ(kNullBlock, defs[0].type);
+    ASSERT_EQ(kEntryBlock, defs[1].type);
+    ASSERT_EQ(kExitBlock, defs[2].type);
+    for (size_t i = 0u; i != count; ++i) {
+      const BBDef* def = &defs[i];
+      BasicBlock* bb = cu_.mir_graph->NewMemBB(def->type, i);
+      cu_.mir_graph->block_list_.Insert(bb);
+      bb->successor_block_list_type = kNotUsed;
+      bb->successor_blocks = nullptr;
+      bb->fall_through = (def->num_successors >= 1) ? def->successors[0] : 0u;
+      bb->taken = (def->num_successors >= 2) ? def->successors[1] : 0u;
+      bb->predecessors = new (&cu_.arena) GrowableArray<BasicBlockId>(
+          &cu_.arena, def->num_predecessors, kGrowableArrayPredecessors);
+      for (size_t j = 0u; j != def->num_predecessors; ++j) {
+        ASSERT_NE(0u, def->predecessors[j]);
+        bb->predecessors->Insert(def->predecessors[j]);
+      }
+      if (def->type == kDalvikByteCode || def->type == kEntryBlock || def->type == kExitBlock) {
+        bb->data_flow_info = static_cast<BasicBlockDataFlow*>(
+            cu_.arena.Alloc(sizeof(BasicBlockDataFlow), kArenaAllocDFInfo));
+      }
+    }
+    cu_.mir_graph->num_blocks_ = count;
+    ASSERT_EQ(count, cu_.mir_graph->block_list_.Size());
+    cu_.mir_graph->entry_block_ = cu_.mir_graph->block_list_.Get(1);
+    ASSERT_EQ(kEntryBlock, cu_.mir_graph->entry_block_->block_type);
+    cu_.mir_graph->exit_block_ = cu_.mir_graph->block_list_.Get(2);
+    ASSERT_EQ(kExitBlock, cu_.mir_graph->exit_block_->block_type);
+  }
+
+  template <size_t count>
+  void PrepareBasicBlocks(const BBDef (&defs)[count]) {
+    DoPrepareBasicBlocks(defs, count);
+  }
+
+  void DoPrepareMIRs(const MIRDef* defs, size_t count) {
+    mir_count_ = count;
+    mirs_ = reinterpret_cast<MIR*>(cu_.arena.Alloc(sizeof(MIR) * count, kArenaAllocMIR));
+    ssa_reps_.resize(count);
+    for (size_t i = 0u; i != count; ++i) {
+      const MIRDef* def = &defs[i];
+      MIR* mir = &mirs_[i];
+      mir->dalvikInsn.opcode = def->opcode;
+      mir->dalvikInsn.vB = def->value;
+      mir->dalvikInsn.vC = def->value;
+      ASSERT_LT(def->bbid, cu_.mir_graph->block_list_.Size());
+      BasicBlock* bb = cu_.mir_graph->block_list_.Get(def->bbid);
+      bb->AppendMIR(mir);
+      if (def->opcode >= Instruction::IGET && def->opcode <= Instruction::IPUT_SHORT) {
+        ASSERT_LT(def->field_info, cu_.mir_graph->ifield_lowering_infos_.Size());
+        mir->meta.ifield_lowering_info = def->field_info;
+      } else if (static_cast<int>(def->opcode) == kMirOpPhi) {
+        // The inputs of the phi match the predecessors of the block.
+        ASSERT_EQ(bb->predecessors->Size(), def->num_uses);
+        mir->meta.phi_incoming = static_cast<BasicBlockId*>(
+            cu_.arena.Alloc(sizeof(BasicBlockId) * def->num_uses, kArenaAllocDFInfo));
+        for (size_t j = 0u; j != def->num_uses; ++j) {
+          mir->meta.phi_incoming[j] = bb->predecessors->Get(j);
+        }
+      }
+      mir->ssa_rep = &ssa_reps_[i];
+      mir->ssa_rep->num_uses = def->num_uses;
+      mir->ssa_rep->uses = const_cast<int32_t*>(def->uses);  // Not modified by the pass.
+      mir->ssa_rep->fp_use = nullptr;  // Not used by the pass.
+      mir->ssa_rep->num_defs = def->num_defs;
+      mir->ssa_rep->defs = const_cast<int32_t*>(def->defs);  // Not modified by the pass.
+      mir->ssa_rep->fp_def = nullptr;  // Not used by the pass.
+      mir->offset = 2 * i;  // All insns need to be at least 2 code units long.
+      mir->width = 2u;
+      mir->optimization_flags = 0u;
+    }
+  }
+
+  template <size_t count>
+  void PrepareMIRs(const MIRDef (&defs)[count]) {
+    DoPrepareMIRs(defs, count);
+  }
+
+  // for (s2 = s0; s2 < s1; s2 = s3) { ... s3 = s2 + 1; }, with the pre-header #3 and the body #5.
+  void PrepareCountedLoop() {
+    static const BBDef bbs[] = {
+        DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+        DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+        DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(6)),
+        DEF_BB(kDalvikByteCode, DEF_SUCC1(4), DEF_PRED1(1)),
+        DEF_BB(kDalvikByteCode, DEF_SUCC2(5, 6), DEF_PRED2(3, 5)),  // Loop header.
+        DEF_BB(kDalvikByteCode, DEF_SUCC1(4), DEF_PRED1(4)),
+        DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED1(4)),
+    };
+    PrepareBasicBlocks(bbs);
+  }
+
+  void PerformLoopCheckElimination() {
+    cu_.mir_graph->SetNumSSARegs(kNumSRegs);
+    cu_.mir_graph->ssa_base_vregs_ =
+        new (&cu_.arena) GrowableArray<int>(&cu_.arena, kNumSRegs, kGrowableArraySSAtoDalvikMap);
+    for (size_t i = 0u; i != kNumSRegs; ++i) {
+      cu_.mir_graph->ssa_base_vregs_->Insert(i);  // Each SSA reg has its own vreg.
+    }
+    cu_.mir_graph->ComputeDFSOrders();
+    cu_.mir_graph->ComputeDominators();
+    cu_.mir_graph->InitializeConstantPropagation();
+    for (size_t i = 0u; i != cu_.mir_graph->block_list_.Size(); ++i) {
+      cu_.mir_graph->DoConstantPropagation(cu_.mir_graph->block_list_.Get(i));
+    }
+    cu_.mir_graph->EliminateLoopChecks();
+  }
+
+  LoopCheckEliminationTest()
+      : pool_(),
+        cu_(&pool_),
+        mir_count_(0u),
+        mirs_(nullptr) {
+    cu_.mir_graph.reset(new MIRGraph(&cu_, &cu_.arena));
+  }
+
+  ArenaPool pool_;
+  CompilationUnit cu_;
+  size_t mir_count_;
+  MIR* mirs_;
+  std::vector<SSARepresentation> ssa_reps_;
+};
+
+TEST_F(LoopCheckEliminationTest, RangeChecks) {
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, 0),
+      DEF_LOOP_ARRAY_LENGTH(3u, 1u, 10u),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_AGET(5u, 4u, 10u, 2u),   // Eliminated.
+      DEF_LOOP_AGET(5u, 5u, 11u, 2u),   // Other array.
+      DEF_LOOP_APUT(5u, 4u, 10u, 2u),   // Eliminated.
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_AGET(5u, 6u, 10u, 3u),   // Index may be out of bounds.
+      DEF_LOOP_GOTO(5u),
+  };
+  static const bool expected_ignore_range_check[] = {
+      false, false, false, false, true, false, true, false, false, false
+  };
+
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  ASSERT_EQ(arraysize(expected_ignore_range_check), mir_count_);
+  for (size_t i = 0u; i != arraysize(mirs); ++i) {
+    EXPECT_EQ(expected_ignore_range_check[i],
+              (mirs_[i].optimization_flags & MIR_IGNORE_RANGE_CHECK) != 0) << i;
+  }
+  // The bound isn't constant, the loop keeps its suspend check.
+  EXPECT_EQ(0, mirs_[9].optimization_flags & MIR_IGNORE_SUSPEND_CHECK);
+}
+
+TEST_F(LoopCheckEliminationTest, RangeChecksNegativeStart) {
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, -1),
+      DEF_LOOP_ARRAY_LENGTH(3u, 1u, 10u),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_AGET(5u, 4u, 10u, 2u),   // Not eliminated.
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_GOTO(5u),
+  };
+
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  EXPECT_EQ(0, mirs_[4].optimization_flags & MIR_IGNORE_RANGE_CHECK);
+}
+
+TEST_F(LoopCheckEliminationTest, HoistNullChecks) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },
+  };
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, 0),
+      DEF_LOOP_GOTO(3u),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IGET(4u, Instruction::IGET, 4u, 11u, 0u),  // Check hoisted.
+      DEF_LOOP_ARRAY_LENGTH(4u, 1u, 10u),                 // Check hoisted.
+      DEF_LOOP_IGET(4u, Instruction::IGET, 5u, 12u, 0u),  // Check hoisted.
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_AGET(5u, 6u, 10u, 2u),   // Range check eliminated.
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_GOTO(5u),
+  };
+
+  PrepareIFields(ifields);
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  // The checks are in the pre-header, in order, before its GOTO.
+  static const int32_t expected_checked_sregs[] = { 11, 10, 12 };
+  BasicBlock* pre_header = cu_.mir_graph->GetBasicBlock(3u);
+  MIR* mir = pre_header->first_mir_insn;
+  ASSERT_EQ(&mirs_[0], mir);
+  for (size_t i = 0u; i != arraysize(expected_checked_sregs); ++i) {
+    mir = mir->next;
+    ASSERT_TRUE(mir != nullptr);
+    ASSERT_EQ(kMirOpNullCheck, static_cast<int>(mir->dalvikInsn.opcode));
+    ASSERT_EQ(1, mir->ssa_rep->num_uses);
+    EXPECT_EQ(expected_checked_sregs[i], mir->ssa_rep->uses[0]);
+  }
+  EXPECT_EQ(&mirs_[1], mir->next);
+  EXPECT_EQ(&mirs_[1], pre_header->last_mir_insn);
+  EXPECT_NE(0, mirs_[7].optimization_flags & MIR_IGNORE_RANGE_CHECK);
+}
+
+TEST_F(LoopCheckEliminationTest, DontHoistNullChecks) {
+  static const IFieldDef ifields[] = {
+      { 0u, 1u, 0u, false },
+      { 1u, 0u, 0u, false },  // Unresolved.
+  };
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, 0),
+      DEF_LOOP_ARRAY_LENGTH(3u, 1u, 10u),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IGET(4u, Instruction::IGET, 4u, 11u, 1u),  // Unresolved, stops hoisting.
+      DEF_LOOP_IGET(4u, Instruction::IGET, 5u, 12u, 0u),
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_GOTO(5u),
+  };
+
+  PrepareIFields(ifields);
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  EXPECT_EQ(&mirs_[1], cu_.mir_graph->GetBasicBlock(3u)->last_mir_insn);
+}
+
+TEST_F(LoopCheckEliminationTest, ShortLoopSuspendCheck) {
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, 0),
+      DEF_LOOP_CONST(3u, 1u, 16),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_GOTO(5u),  // No suspend check.
+  };
+
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  EXPECT_NE(0, mirs_[5].optimization_flags & MIR_IGNORE_SUSPEND_CHECK);
+}
+
+TEST_F(LoopCheckEliminationTest, LongLoopSuspendCheck) {
+  static const MIRDef mirs[] = {
+      DEF_LOOP_CONST(3u, 0u, 0),
+      DEF_LOOP_CONST(3u, 1u, 100000),
+      DEF_LOOP_PHI2(4u, 2u, 0u, 3u),
+      DEF_LOOP_IF(4u, Instruction::IF_GE, 2u, 1u),
+      DEF_LOOP_ADD_LIT(5u, 3u, 2u, 1),
+      DEF_LOOP_GOTO(5u),  // Keeps its suspend check.
+  };
+
+  PrepareCountedLoop();
+  PrepareMIRs(mirs);
+  PerformLoopCheckElimination();
+  EXPECT_EQ(0, mirs_[5].optimization_flags & MIR_IGNORE_SUSPEND_CHECK);
+}
+
+class ArrayInitializationTest : public testing::Test {
+ protected:
+  static constexpr size_t kNumSRegs = 16u;
+
+  struct MIRDef {
+    static constexpr size_t kMaxSsaDefs = 2;
+    static constexpr size_t kMaxSsaUses = 4;
+
+    Instruction::Code opcode;
+    int32_t value;
+    size_t num_uses;
+    int32_t uses[kMaxSsaUses];
+    size_t num_defs;
+    int32_t defs[kMaxSsaDefs];
+  };
+
+#define DEF_INIT_CONST(reg, value) \
+    { Instruction::CONST, value, 0, { }, 1, { reg } }
+#define DEF_INIT_NEW_ARRAY(reg, length) \
+    { Instruction::NEW_ARRAY, 0, 1, { length }, 1, { reg } }
+#define DEF_INIT_APUT(reg, array, index) \
+    { Instruction::APUT, 0, 3, { reg, array, index }, 0, { } }
+#define DEF_INIT_AGET(reg, array, index) \
+    { Instruction::AGET, 0, 2, { array, index }, 1, { reg } }
+#define DEF_INIT_ADD_LIT(reg, src, value) \
+    { Instruction::ADD_INT_LIT8, value, 1, { src }, 1, { reg } }
+
+  // The MIRs are all in the single bytecode block #3.
+  void DoPrepareMIRs(const MIRDef* defs, size_t count) {
+    cu_.mir_graph->block_id_map_.clear();
+    cu_.mir_graph->block_list_.Reset();
+    static const BBType kBlockTypes[] = { kNullBlock, kEntryBlock, kExitBlock, kDalvikByteCode };
+    for (size_t i = 0u; i != arraysize(kBlockTypes); ++i) {
+      BasicBlock* bb = cu_.mir_graph->NewMemBB(kBlockTypes[i], i);
+      cu_.mir_graph->block_list_.Insert(bb);
+      bb->successor_block_list_type = kNotUsed;
+    }
+    cu_.mir_graph->num_blocks_ = arraysize(kBlockTypes);
+    BasicBlock* bb = cu_.mir_graph->block_list_.Get(3u);
+
+    mir_count_ = count;
+    mirs_ = reinterpret_cast<MIR*>(cu_.arena.Alloc(sizeof(MIR) * count, kArenaAllocMIR));
+    ssa_reps_.resize(count);
+    for (size_t i = 0u; i != count; ++i) {
+      const MIRDef* def = &defs[i];
+      MIR* mir = &mirs_[i];
+      mir->dalvikInsn.opcode = def->opcode;
+      mir->dalvikInsn.vB = def->value;
+      mir->dalvikInsn.vC = def->value;
+      bb->AppendMIR(mir);
+      mir->ssa_rep = &ssa_reps_[i];
+      mir->ssa_rep->num_uses = def->num_uses;
+      mir->ssa_rep->uses = const_cast<int32_t*>(def->uses);  // Not modified by the pass.
+      mir->ssa_rep->fp_use = nullptr;  // Not used by the pass.
+      mir->ssa_rep->num_defs = def->num_defs;
+      mir->ssa_rep->defs = const_cast<int32_t*>(def->defs);  // Not modified by the pass.
+      mir->ssa_rep->fp_def = nullptr;  // Not used by the pass.
+      mir->offset = 2 * i;  // All insns need to be at least 2 code units long.
+      mir->width = 2u;
+      mir->optimization_flags = 0u;
+    }
+  }
+
+  template <size_t count>
+  void PrepareMIRs(const MIRDef (&defs)[count]) {
+    DoPrepareMIRs(defs, count);
+  }
+
+  void PerformArrayInitialization() {
+    cu_.mir_graph->SetNumSSARegs(kNumSRegs);
+    cu_.mir_graph->InitializeConstantPropagation();
+    cu_.mir_graph->DoConstantPropagation(cu_.mir_graph->block_list_.Get(3u));
+    cu_.mir_graph->CombineArrayInitialization();
+  }
+
+  bool IsNop(size_t i) const {
+    return static_cast<int>(mirs_[i].dalvikInsn.opcode) == kMirOpNop;
+  }
+
+  ArrayInitializationTest()
+      : pool_(),
+        cu_(&pool_),
+        mir_count_(0u),
+        mirs_(nullptr) {
+    cu_.mir_graph.reset(new MIRGraph(&cu_, &cu_.arena));
+  }
+
+  ArenaPool pool_;
+  CompilationUnit cu_;
+  size_t mir_count_;
+  MIR* mirs_;
+  std::vector<SSARepresentation> ssa_reps_;
+};
+
+TEST_F(ArrayInitializationTest, CombinedStores) {
+  static const MIRDef mirs[] = {
+      DEF_INIT_CONST(0u, 6),
+      DEF_INIT_NEW_ARRAY(1u, 0u),
+      DEF_INIT_CONST(2u, 0),
+      DEF_INIT_CONST(3u, 0x11223344),
+      DEF_INIT_APUT(3u, 1u, 2u),        // Becomes the fill-array-data.
+      DEF_INIT_CONST(4u, 1),
+      DEF_INIT_CONST(5u, -1),
+      DEF_INIT_APUT(5u, 1u, 4u),
+      DEF_INIT_CONST(6u, 3),            // Used after the stores.
+      DEF_INIT_APUT(3u, 1u, 6u),
+      DEF_INIT_CONST(7u, 2),
+      DEF_INIT_APUT(4u, 1u, 7u),
+      DEF_INIT_APUT(4u, 1u, 4u),        // Overwrites element 1.
+      DEF_INIT_ADD_LIT(8u, 6u, 1),      // Ends the stores.
+  };
+  static const bool expected_nop[] = {
+      false, false, true, true, false, true, true, true, false, true, true, true, true, false
+  };
+
+  PrepareMIRs(mirs);
+  PerformArrayInitialization();
+  ASSERT_EQ(arraysize(expected_nop), mir_count_);
+  for (size_t i = 0u; i != arraysize(mirs); ++i) {
+    EXPECT_EQ(expected_nop[i], IsNop(i)) << i;
+  }
+  MIR* fill = &mirs_[4];
+  ASSERT_EQ(Instruction::FILL_ARRAY_DATA, fill->dalvikInsn.opcode);
+  ASSERT_EQ(1, fill->ssa_rep->num_uses);
+  EXPECT_EQ(1, fill->ssa_rep->uses[0]);
+  EXPECT_NE(0, fill->optimization_flags & MIR_IGNORE_NULL_CHECK);
+  EXPECT_NE(0, fill->optimization_flags & MIR_IGNORE_RANGE_CHECK);
+  const uint16_t* table = fill->meta.fill_array_data;
+  ASSERT_TRUE(table != nullptr);
+  EXPECT_EQ(static_cast<uint16_t>(Instruction::kArrayDataSignature), table[0]);
+  EXPECT_EQ(4u, table[1]);
+  EXPECT_EQ(4u, table[2] | (static_cast<uint32_t>(table[3]) << 16));
+  static const int32_t expected_data[] = { 0x11223344, 1, 1, 0x11223344 };
+  EXPECT_EQ(0, memcmp(expected_data, &table[4], sizeof(expected_data)));
+}
+
+TEST_F(ArrayInitializationTest, StopsAtLoad) {
+  static const MIRDef mirs[] = {
+      DEF_INIT_CONST(0u, 10),
+      DEF_INIT_NEW_ARRAY(1u, 0u),
+      DEF_INIT_CONST(2u, 0),
+      DEF_INIT_CONST(3u, 1),
+      DEF_INIT_CONST(4u, 2),
+      DEF_INIT_APUT(3u, 1u, 2u),
+      DEF_INIT_APUT(3u, 1u, 3u),
+      DEF_INIT_APUT(3u, 1u, 4u),
+      DEF_INIT_AGET(5u, 1u, 2u),        // Reads the array, only three stores before.
+      DEF_INIT_APUT(3u, 1u, 2u),
+  };
+
+  PrepareMIRs(mirs);
+  PerformArrayInitialization();
+  for (size_t i = 0u; i != arraysize(mirs); ++i) {
+    EXPECT_EQ(mirs[i].opcode, mirs_[i].dalvikInsn.opcode) << i;
+  }
+}
+
 }  // namespace art
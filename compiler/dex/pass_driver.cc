@@ -15,15 +15,22 @@
  */
 
 #include <dlfcn.h>
+#include <inttypes.h>
 
+#include <algorithm>
+
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/stringprintf.h"
 #include "bb_optimizations.h"
 #include "compiler_internals.h"
 #include "dataflow_iterator.h"
 #include "dataflow_iterator-inl.h"
+#include "driver/compiler_options.h"
 #include "pass.h"
 #include "pass_driver.h"
+#include "utils.h"
 
 namespace art {
 
@@ -96,17 +103,69 @@ static const Pass* const gPasses[] = {
   GetPassInstance<CodeLayout>(),
   GetPassInstance<SSATransformation>(),
   GetPassInstance<ConstantPropagation>(),
+  GetPassInstance<LoopCheckElimination>(),
+  GetPassInstance<ArrayInitialization>(),
   GetPassInstance<InitRegLocations>(),
   GetPassInstance<MethodUseCount>(),
   GetPassInstance<NullCheckEliminationAndTypeInference>(),
   GetPassInstance<ClassInitCheckElimination>(),
+  GetPassInstance<GlobalValueNumbering>(),
   GetPassInstance<BBCombine>(),
   GetPassInstance<BBOptimizations>(),
 };
 
+/*
+ * The passes left out of the lean pipeline used for the kSpace compiler filter: they spend
+ * compile time to speed up the code, without making it smaller.
+ */
+static const Pass* const gSpeedOnlyPasses[] = {
+  GetPassInstance<LoopCheckElimination>(),
+  GetPassInstance<GlobalValueNumbering>(),
+};
+
+static bool IsSpeedOnlyPass(const Pass* pass) {
+  return std::find(gSpeedOnlyPasses, gSpeedOnlyPasses + arraysize(gSpeedOnlyPasses), pass) !=
+      gSpeedOnlyPasses + arraysize(gSpeedOnlyPasses);
+}
+
 // The default pass list is used by CreatePasses to initialize pass_list_.
 static std::vector<const Pass*> gDefaultPassList(gPasses, gPasses + arraysize(gPasses));
 
+static std::vector<const Pass*> GetLeanPassList(const std::vector<const Pass*>& passes) {
+  std::vector<const Pass*> lean_passes;
+  for (const Pass* pass : passes) {
+    if (!IsSpeedOnlyPass(pass)) {
+      lean_passes.push_back(pass);
+    }
+  }
+  return lean_passes;
+}
+
+// The lean pass list is used instead of the default one for the kSpace compiler filter.
+static std::vector<const Pass*> gLeanPassList(GetLeanPassList(gDefaultPassList));
+
+/*
+ * The statistics of each pass of gPasses, aggregated over all the compiled methods.
+ * They are only collected with --dump-passes, and updated concurrently by the compiler threads.
+ */
+struct PassStats {
+  Atomic<uint64_t> runs;
+  Atomic<uint64_t> time_ns;
+  Atomic<uint64_t> arena_bytes;
+};
+
+static PassStats gPassStats[arraysize(gPasses)];
+
+static PassStats* GetPassStats(const Pass* pass) {
+  for (size_t i = 0; i != arraysize(gPasses); ++i) {
+    if (gPasses[i] == pass) {
+      return &gPassStats[i];
+    }
+  }
+  // The pass was inserted by hand, not from gPasses.
+  return nullptr;
+}
+
 void PassDriver::CreateDefaultPassList(const std::string& disable_passes) {
   // Insert each pass from gPasses into gDefaultPassList.
   gDefaultPassList.clear();
@@ -119,12 +178,18 @@ void PassDriver::CreateDefaultPassList(const std::string& disable_passes) {
       gDefaultPassList.push_back(pass);
     }
   }
+  gLeanPassList = GetLeanPassList(gDefaultPassList);
 }
 
 void PassDriver::CreatePasses() {
+  const std::vector<const Pass*>* pass_list = &gDefaultPassList;
+  if (cu_->compiler_driver->GetCompilerOptions().GetCompilerFilter() == CompilerOptions::kSpace) {
+    pass_list = &gLeanPassList;
+  }
+
   // Insert each pass into the list via the InsertPass method.
-  pass_list_.reserve(gDefaultPassList.size());
-  for (const Pass* pass : gDefaultPassList) {
+  pass_list_.reserve(pass_list->size());
+  for (const Pass* pass : *pass_list) {
     InsertPass(pass);
   }
 }
@@ -191,9 +256,24 @@ bool PassDriver::RunPass(CompilationUnit* c_unit, const Pass* pass, bool time_sp
   bool should_apply_pass = pass->Gate(c_unit);
 
   if (should_apply_pass) {
+    // Account the time and the memory of the pass only when dumping the passes.
+    PassStats* stats = c_unit->compiler_driver->GetDumpPasses() ? GetPassStats(pass) : nullptr;
+    uint64_t start_ns = 0u;
+    size_t start_bytes = 0u;
+    if (stats != nullptr) {
+      start_ns = NanoTime();
+      start_bytes = c_unit->arena.BytesUsed();
+    }
+
     // Applying the pass: first start, doWork, and end calls.
     ApplyPass(c_unit, pass);
 
+    if (stats != nullptr) {
+      stats->runs.FetchAndAdd(1u);
+      stats->time_ns.FetchAndAdd(NanoTime() - start_ns);
+      stats->arena_bytes.FetchAndAdd(c_unit->arena.BytesUsed() - start_bytes);
+    }
+
     // Clean up if need be.
     HandlePassFlag(c_unit, pass);
 
@@ -247,6 +327,28 @@ void PassDriver::PrintPassNames() {
   }
 }
 
+void PassDriver::DumpPassStats(std::ostream& os) {
+  os << "Pass statistics (runs, time, arena bytes):\n";
+  for (size_t i = 0; i != arraysize(gPasses); ++i) {
+    const PassStats& stats = gPassStats[i];
+    os << StringPrintf("  %-40s %10" PRIu64 " %12s %12" PRIu64 "\n", gPasses[i]->GetName(),
+                       stats.runs.Load(), PrettyDuration(stats.time_ns.Load()).c_str(),
+                       stats.arena_bytes.Load());
+  }
+}
+
+void PassDriver::DumpPassStatsJson(std::ostream& os) {
+  os << "[";
+  for (size_t i = 0; i != arraysize(gPasses); ++i) {
+    const PassStats& stats = gPassStats[i];
+    os << StringPrintf("%s\n    {\"name\": \"%s\", \"runs\": %" PRIu64 ", \"time_ns\": %" PRIu64
+                       ", \"arena_bytes\": %" PRIu64 "}", (i != 0u) ? "," : "",
+                       gPasses[i]->GetName(), stats.runs.Load(), stats.time_ns.Load(),
+                       stats.arena_bytes.Load());
+  }
+  os << "\n  ]";
+}
+
 const Pass* PassDriver::GetPass(const char* name) const {
   for (const Pass* cur_pass : pass_list_) {
     if (strcmp(name, cur_pass->GetName()) == 0) {
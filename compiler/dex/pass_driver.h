@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_DEX_PASS_DRIVER_H_
 #define ART_COMPILER_DEX_PASS_DRIVER_H_
 
+#include <ostream>
 #include <vector>
 #include "pass.h"
 #include "safe_map.h"
@@ -76,6 +77,17 @@ class PassDriver {
   static void PrintPassNames();
   static void CreateDefaultPassList(const std::string& disable_passes);
 
+  /**
+   * @brief Dump the number of runs, the wall time and the arena memory of each pass,
+   * aggregated over all the methods compiled with --dump-passes.
+   */
+  static void DumpPassStats(std::ostream& os);
+
+  /**
+   * @brief Dump the same statistics as a JSON array of objects, one per pass.
+   */
+  static void DumpPassStatsJson(std::ostream& os);
+
   const Pass* GetPass(const char* name) const;
 
   const char* GetDumpCFGFolder() const {
@@ -83,6 +95,10 @@ class PassDriver {
   }
 
  protected:
+  /**
+   * @brief Create the pipeline of the compiler filter: the lean pipeline for kSpace
+   * leaves out the passes that only trade compile time for speed.
+   */
   void CreatePasses();
 
   /** @brief List of passes: provides the order to execute the passes. */
@@ -537,9 +537,24 @@ enum ArmOpcode {
   kThumb2LdrdPcRel8,  // ldrd rt, rt2, pc +-/1024.
   kThumb2LdrdI8,     // ldrd rt, rt2, [rn +-/1024].
   kThumb2StrdI8,     // strd rt, rt2, [rn +-/1024].
+  kThumb2ClzRR,      // clz [111110101011] rm[19..16] [1111] rd[11..8] [1000] rm[3..0].
+  kThumb2RbitRR,     // rbit [111110101001] rm[19..16] [1111] rd[11..8] [1010] rm[3..0].
   kArmLast,
 };
 
+// Result latencies in cycles of the Cortex-A7 and Cortex-A53 in-order pipelines, used by
+// the list scheduler.
+enum ArmLatency {
+  kArmAluLatency = 1,
+  kArmLoadLatency = 3,
+  kArmMulLatency = 3,
+  kArmLongMulLatency = 4,
+  kArmDivLatency = 12,
+  kArmFpAluLatency = 4,
+  kArmFpMulLatency = 5,
+  kArmFpDivLatency = 18,
+};
+
 enum ArmOpDmbOptions {
   kSY = 0xf,
   kST = 0xe,
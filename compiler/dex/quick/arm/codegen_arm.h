@@ -87,6 +87,7 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     std::string BuildInsnString(const char* fmt, LIR* lir, unsigned char* base_addr);
     uint64_t GetPCUseDefEncoding();
     uint64_t GetTargetInstFlags(int opcode);
+    int GetInstructionLatency(LIR* lir);
     int GetInsnSize(LIR* lir);
     bool IsUnconditionalBranch(LIR* lir);
 
@@ -106,6 +107,8 @@ class ArmMir2Lir FINAL : public Mir2Lir {
                            RegLocation rl_src1, RegLocation rl_shift);
     void GenMulLong(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src1,
                     RegLocation rl_src2);
+    void GenDivRemLong(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src1,
+                       RegLocation rl_src2, bool is_div) OVERRIDE;
     void GenAddLong(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src1,
                     RegLocation rl_src2);
     void GenAndLong(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src1,
@@ -119,6 +122,9 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     void GenConversion(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src);
     bool GenInlinedCas(CallInfo* info, bool is_long, bool is_object);
     bool GenInlinedMinMaxInt(CallInfo* info, bool is_min);
+    bool GenInlinedMinMaxLong(CallInfo* info, bool is_min);
+    bool GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long);
+    bool GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long);
     bool GenInlinedSqrt(CallInfo* info);
     bool GenInlinedPeek(CallInfo* info, OpSize size);
     bool GenInlinedPoke(CallInfo* info, OpSize size);
@@ -134,9 +140,12 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     void GenCmpLong(RegLocation rl_dest, RegLocation rl_src1, RegLocation rl_src2);
     void GenDivZeroCheckWide(RegStorage reg);
     void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method);
+    bool CanGenOsrEntries() {
+      return true;
+    }
     void GenExitSequence();
     void GenSpecialExitSequence();
-    void GenFillArrayData(DexOffset table_offset, RegLocation rl_src);
+    void GenFillArrayData(const uint16_t* table, RegLocation rl_src);
     void GenFusedFPCmpBranch(BasicBlock* bb, MIR* mir, bool gt_bias, bool is_double);
     void GenFusedLongCmpBranch(BasicBlock* bb, MIR* mir);
     void GenSelect(BasicBlock* bb, MIR* mir);
@@ -148,7 +157,7 @@ class ArmMir2Lir FINAL : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
     void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
 
     // Required for target - single operation generators.
@@ -205,6 +214,10 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     RegLocation GenDivRem(RegLocation rl_dest, RegLocation rl_src1, RegLocation rl_src2,
                           bool is_div, bool check_zero);
     RegLocation GenDivRemLit(RegLocation rl_dest, RegLocation rl_src1, int lit, bool is_div);
+    void GenDivRemLongPowerOfTwo(RegLocation rl_dest, RegLocation rl_src1, int64_t lit,
+                                 bool is_div);
+    void GenDivRemLongSdiv(RegLocation rl_dest, RegLocation rl_src1, RegLocation rl_src2,
+                           bool is_div);
     typedef struct {
       OpKind op;
       uint32_t shift;
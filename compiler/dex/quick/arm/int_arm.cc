@@ -673,6 +673,90 @@ bool ArmMir2Lir::GenInlinedMinMaxInt(CallInfo* info, bool is_min) {
   return true;
 }
 
+bool ArmMir2Lir::GenInlinedMinMaxLong(CallInfo* info, bool is_min) {
+  DCHECK_EQ(cu_->instruction_set, kThumb2);
+  RegLocation rl_src1 = LoadValueWide(info->args[0], kCoreReg);
+  RegLocation rl_src2 = LoadValueWide(info->args[2], kCoreReg);
+  RegLocation rl_dest = InlineTargetWide(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  // Compare with subs/sbcs into a scratch register, then move one of the operands under IT.
+  RegStorage t_reg = AllocTemp();
+  NewLIR4(kThumb2SubRRR, t_reg.GetReg(), rl_src1.reg.GetLowReg(), rl_src2.reg.GetLowReg(), 0);
+  NewLIR4(kThumb2SbcRRR, t_reg.GetReg(), rl_src1.reg.GetHighReg(), rl_src2.reg.GetHighReg(), 0);
+  FreeTemp(t_reg);
+  RegStorage sources[2] = { rl_src1.reg, rl_src2.reg };
+  LIR* it = OpIT((is_min) ? kCondLt : kCondGe, "TEE");
+  for (RegStorage r_src : sources) {
+    // Only one of the pairs is moved, but the result may overlap its halves.
+    if (rl_result.reg.GetLowReg() == r_src.GetHighReg()) {
+      DCHECK_NE(rl_result.reg.GetHighReg(), r_src.GetLowReg());
+      OpRegReg(kOpMov, rl_result.reg.GetHigh(), r_src.GetHigh());
+      OpRegReg(kOpMov, rl_result.reg.GetLow(), r_src.GetLow());
+    } else {
+      OpRegReg(kOpMov, rl_result.reg.GetLow(), r_src.GetLow());
+      OpRegReg(kOpMov, rl_result.reg.GetHigh(), r_src.GetHigh());
+    }
+  }
+  OpEndIT(it);
+  StoreValueWide(rl_dest, rl_result);
+  return true;
+}
+
+bool ArmMir2Lir::GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long) {
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result;
+  if (!is_long) {
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    NewLIR3(kThumb2ClzRR, rl_result.reg.GetReg(), rl_src.reg.GetReg(), rl_src.reg.GetReg());
+  } else {
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    // clz(high) is 32 only if the high word is 0, the count continues into the low word then.
+    RegStorage t_reg = AllocTemp();
+    NewLIR3(kThumb2ClzRR, t_reg.GetReg(), rl_src.reg.GetLowReg(), rl_src.reg.GetLowReg());
+    NewLIR3(kThumb2ClzRR, rl_result.reg.GetReg(), rl_src.reg.GetHighReg(),
+            rl_src.reg.GetHighReg());
+    OpRegImm(kOpCmp, rl_result.reg, 32);
+    LIR* it = OpIT(kCondEq, "");
+    OpRegRegReg(kOpAdd, rl_result.reg, rl_result.reg, t_reg);
+    OpEndIT(it);
+    FreeTemp(t_reg);
+  }
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
+bool ArmMir2Lir::GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long) {
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result;
+  // The trailing zeros are the leading zeros of the bit reversed value.
+  if (!is_long) {
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    NewLIR3(kThumb2RbitRR, rl_result.reg.GetReg(), rl_src.reg.GetReg(), rl_src.reg.GetReg());
+    NewLIR3(kThumb2ClzRR, rl_result.reg.GetReg(), rl_result.reg.GetReg(),
+            rl_result.reg.GetReg());
+  } else {
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    RegStorage t_reg = AllocTemp();
+    NewLIR3(kThumb2RbitRR, t_reg.GetReg(), rl_src.reg.GetHighReg(), rl_src.reg.GetHighReg());
+    NewLIR3(kThumb2ClzRR, t_reg.GetReg(), t_reg.GetReg(), t_reg.GetReg());
+    NewLIR3(kThumb2RbitRR, rl_result.reg.GetReg(), rl_src.reg.GetLowReg(),
+            rl_src.reg.GetLowReg());
+    NewLIR3(kThumb2ClzRR, rl_result.reg.GetReg(), rl_result.reg.GetReg(),
+            rl_result.reg.GetReg());
+    OpRegImm(kOpCmp, rl_result.reg, 32);
+    LIR* it = OpIT(kCondEq, "");
+    OpRegRegReg(kOpAdd, rl_result.reg, rl_result.reg, t_reg);
+    OpEndIT(it);
+    FreeTemp(t_reg);
+  }
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
 bool ArmMir2Lir::GenInlinedPeek(CallInfo* info, OpSize size) {
   RegLocation rl_src_address = info->args[0];  // long address
   rl_src_address = NarrowRegLoc(rl_src_address);  // ignore high half in info->args[1]
@@ -1086,6 +1170,195 @@ void ArmMir2Lir::GenMulLong(Instruction::Code opcode, RegLocation rl_dest,
     StoreValueWide(rl_dest, rl_result);
 }
 
+void ArmMir2Lir::GenDivRemLong(Instruction::Code opcode, RegLocation rl_dest,
+                               RegLocation rl_src1, RegLocation rl_src2, bool is_div) {
+  bool use_sdiv = cu_->GetInstructionSetFeatures().HasDivideInstruction();
+  if (rl_src2.is_const) {
+    int64_t lit = mir_graph_->ConstantValueWide(rl_src2);
+    // Long.MIN_VALUE has no positive counterpart, it goes to the runtime like zero.
+    uint64_t abs_lit = (lit < 0) ? -static_cast<uint64_t>(lit) : lit;
+    if (lit != 0 && static_cast<int64_t>(abs_lit) > 0 && IsPowerOfTwo(abs_lit)) {
+      GenDivRemLongPowerOfTwo(rl_dest, rl_src1, lit, is_div);
+      return;
+    }
+    // The quotient of a 32-bit dividend by a wider divisor isn't worth a fast path.
+    use_sdiv &= (lit != 0) && (static_cast<int32_t>(lit) == lit);
+  }
+  if (use_sdiv) {
+    GenDivRemLongSdiv(rl_dest, rl_src1, rl_src2, is_div);
+  } else {
+    Mir2Lir::GenDivRemLong(opcode, rl_dest, rl_src1, rl_src2, is_div);
+  }
+}
+
+void ArmMir2Lir::GenDivRemLongPowerOfTwo(RegLocation rl_dest, RegLocation rl_src1, int64_t lit,
+                                         bool is_div) {
+  /*
+   * Round towards zero by adding 2^k - 1 to negative dividends before shifting:
+   *
+   *   bias = (src >> 63) >>> (64 - k)
+   *   tmp  = src + bias
+   *   div  = tmp >> k                    // negated for a negative divisor
+   *   rem  = src - (tmp & -(1 << k))
+   */
+  int k = LowestSetBit(static_cast<uint64_t>((lit < 0) ? -lit : lit));
+  if (k == 0 && (!is_div || lit > 0)) {
+    // Division by 1, or the remainder of a division by 1 or -1 which is always zero.
+    if (!is_div) {
+      RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+      LoadConstantWide(rl_result.reg, 0);
+      StoreValueWide(rl_dest, rl_result);
+    } else {
+      StoreValueWide(rl_dest, LoadValueWide(rl_src1, kCoreReg));
+    }
+    return;
+  }
+  rl_src1 = LoadValueWide(rl_src1, kCoreReg);
+  RegStorage src_lo = rl_src1.reg.GetLow();
+  RegStorage src_hi = rl_src1.reg.GetHigh();
+  RegStorage t_lo = AllocTemp();
+  RegStorage t_hi = AllocTemp();
+  if (k == 0) {
+    // Division by -1. Negate into the temps, the destination may partially overlap the source.
+    RegStorage z_reg = AllocTemp();
+    LoadConstantNoClobber(z_reg, 0);
+    OpRegRegReg(kOpSub, t_lo, z_reg, src_lo);
+    OpRegRegReg(kOpSbc, t_hi, z_reg, src_hi);
+    FreeTemp(z_reg);
+    RegLocation rl_result = GetReturnWide(false);  // Just using as a template.
+    rl_result.reg = RegStorage::MakeRegPair(t_lo, t_hi);
+    StoreValueWide(rl_dest, rl_result);
+    return;
+  }
+  if (k <= 32) {
+    OpRegRegImm(kOpAsr, t_hi, src_hi, 31);
+    if (k < 32) {
+      OpRegRegImm(kOpLsr, t_lo, t_hi, 32 - k);
+      OpRegRegReg(kOpAdd, t_lo, src_lo, t_lo);
+    } else {
+      OpRegRegReg(kOpAdd, t_lo, src_lo, t_hi);
+    }
+    OpRegRegImm(kOpAdc, t_hi, src_hi, 0);
+  } else {
+    OpRegRegImm(kOpAsr, t_lo, src_hi, 31);
+    OpRegRegImm(kOpLsr, t_hi, t_lo, 64 - k);
+    OpRegRegReg(kOpAdd, t_lo, src_lo, t_lo);
+    OpRegRegReg(kOpAdc, t_hi, src_hi, t_hi);
+  }
+  // Compute the result in the temps, which may not overlap the source or need one more pair.
+  if (is_div) {
+    if (k < 32) {
+      OpRegRegImm(kOpLsr, t_lo, t_lo, k);
+      OpRegRegRegShift(kOpOr, t_lo, t_lo, t_hi, EncodeShift(kArmLsl, 32 - k));
+      OpRegRegImm(kOpAsr, t_hi, t_hi, k);
+    } else {
+      if (k == 32) {
+        OpRegCopy(t_lo, t_hi);
+      } else {
+        OpRegRegImm(kOpAsr, t_lo, t_hi, k - 32);
+      }
+      OpRegRegImm(kOpAsr, t_hi, t_hi, 31);
+    }
+    if (lit < 0) {
+      RegStorage z_reg = AllocTemp();
+      LoadConstantNoClobber(z_reg, 0);
+      OpRegRegReg(kOpSub, t_lo, z_reg, t_lo);
+      OpRegRegReg(kOpSbc, t_hi, z_reg, t_hi);
+      FreeTemp(z_reg);
+    }
+  } else {
+    if (k < 32) {
+      OpRegRegImm(kOpLsr, t_lo, t_lo, k);
+      OpRegRegImm(kOpLsl, t_lo, t_lo, k);
+      OpRegRegReg(kOpSub, t_lo, src_lo, t_lo);
+      OpRegRegReg(kOpSbc, t_hi, src_hi, t_hi);
+    } else {
+      if (k > 32) {
+        OpRegRegImm(kOpLsr, t_hi, t_hi, k - 32);
+        OpRegRegImm(kOpLsl, t_hi, t_hi, k - 32);
+      }
+      OpRegCopy(t_lo, src_lo);
+      OpRegRegReg(kOpSub, t_hi, src_hi, t_hi);
+    }
+  }
+  RegLocation rl_result = GetReturnWide(false);  // Just using as a template.
+  rl_result.reg = RegStorage::MakeRegPair(t_lo, t_hi);
+  StoreValueWide(rl_dest, rl_result);
+}
+
+void ArmMir2Lir::GenDivRemLongSdiv(RegLocation rl_dest, RegLocation rl_src1,
+                                   RegLocation rl_src2, bool is_div) {
+  /*
+   * When both operands fit in 32 bits so does the result, but for Integer.MIN_VALUE / -1, and
+   * sdiv computes it. Other operands go to the runtime:
+   *
+   *   cmp   r1, r0, asr #31
+   *   bne   slow
+   *   cmp   r3, r2, asr #31          // Unless the divisor is a constant.
+   *   bne   slow
+   *   cmp   r2, #-1                  // Likewise, for a division.
+   *   beq   slow
+   *   sdiv  ...
+   *   b     done
+   * slow:
+   *   blx   pLdiv / pLmod
+   * done:
+   */
+  FlushAllRegs();   /* Send everything to home location */
+  RegStorage r_src1 = RegStorage::MakeRegPair(rs_r0, rs_r1);
+  RegStorage r_src2 = RegStorage::MakeRegPair(rs_r2, rs_r3);
+  LoadValueDirectWideFixed(rl_src2, r_src2);
+  if (!rl_src2.is_const) {
+    GenDivZeroCheckWide(r_src2);
+  }
+  LoadValueDirectWideFixed(rl_src1, r_src1);
+  LockCallTemps();  // Prepare for explicit register usage
+  OpRegRegShift(kOpCmp, rs_r1, rs_r0, EncodeShift(kArmAsr, 31));
+  LIR* src1_wide_branch = OpCondBranch(kCondNe, NULL);
+  LIR* src2_wide_branch = NULL;
+  LIR* overflow_branch = NULL;
+  if (!rl_src2.is_const) {
+    OpRegRegShift(kOpCmp, rs_r3, rs_r2, EncodeShift(kArmAsr, 31));
+    src2_wide_branch = OpCondBranch(kCondNe, NULL);
+    if (is_div) {
+      overflow_branch = OpCmpImmBranch(kCondEq, rs_r2, -1, NULL);
+    }
+  }
+  if (is_div) {
+    OpRegRegReg(kOpDiv, rs_r0, rs_r0, rs_r2);
+    OpRegRegImm(kOpAsr, rs_r1, rs_r0, 31);
+  } else {
+    // The remainder is returned in r2/r3 by the runtime too.
+    RegStorage temp = AllocTemp();
+    OpRegRegReg(kOpDiv, temp, rs_r0, rs_r2);
+    OpRegReg(kOpMul, temp, rs_r2);
+    OpRegRegReg(kOpSub, rs_r2, rs_r0, temp);
+    OpRegRegImm(kOpAsr, rs_r3, rs_r2, 31);
+    FreeTemp(temp);
+  }
+  LIR* done_branch = OpUnconditionalBranch(NULL);
+
+  LIR* slow_path_target = NewLIR0(kPseudoTargetLabel);
+  src1_wide_branch->target = slow_path_target;
+  if (src2_wide_branch != NULL) {
+    src2_wide_branch->target = slow_path_target;
+  }
+  if (overflow_branch != NULL) {
+    overflow_branch->target = slow_path_target;
+  }
+  ThreadOffset<4> func_offset = is_div ? QUICK_ENTRYPOINT_OFFSET(4, pLdiv) :
+      QUICK_ENTRYPOINT_OFFSET(4, pLmod);
+  LoadWordDisp(rs_rARM_SELF, func_offset.Int32Value(), rs_rARM_LR);
+  ClobberCallerSave();
+  // NOTE: callout here is not a safepoint
+  OpReg(kOpBlx, rs_rARM_LR);
+
+  LIR* done_target = NewLIR0(kPseudoTargetLabel);
+  done_branch->target = done_target;
+  RegLocation rl_result = is_div ? GetReturnWide(false) : GetReturnWideAlt();
+  StoreValueWide(rl_dest, rl_result);
+}
+
 void ArmMir2Lir::GenAddLong(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src1,
                             RegLocation rl_src2) {
   LOG(FATAL) << "Unexpected use of GenAddLong for Arm";
@@ -1175,6 +1448,9 @@ void ArmMir2Lir::GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
     if (!constant_index) {
       FreeTemp(reg_ptr);
     }
+    if (size == kReference) {
+      GenReadBarrier(rl_result.reg);
+    }
     if (rl_dest.wide) {
       StoreValueWide(rl_dest, rl_result);
     } else {
@@ -1194,6 +1470,9 @@ void ArmMir2Lir::GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
     LoadBaseIndexed(reg_ptr, rl_index.reg, rl_result.reg, scale, size);
     MarkPossibleNullPointerException(opt_flags);
     FreeTemp(reg_ptr);
+    if (size == kReference) {
+      GenReadBarrier(rl_result.reg);
+    }
     StoreValue(rl_dest, rl_result);
   }
 }
@@ -750,6 +750,44 @@ uint64_t ArmMir2Lir::GetTargetInstFlags(int opcode) {
   return ArmMir2Lir::EncodingMap[opcode].flags;
 }
 
+int ArmMir2Lir::GetInstructionLatency(LIR* lir) {
+  switch (lir->opcode) {
+    case kThumbMul:
+    case kThumb2MulRRR:
+    case kThumb2Mla:
+      return kArmMulLatency;
+    case kThumb2Umull:
+    case kThumb2Smull:
+      return kArmLongMulLatency;
+    case kThumb2SdivRRR:
+    case kThumb2UdivRRR:
+      return kArmDivLatency;
+    case kThumb2Vadds:
+    case kThumb2Vaddd:
+    case kThumb2Vsubs:
+    case kThumb2Vsubd:
+    case kThumb2VcvtIF:
+    case kThumb2VcvtFI:
+    case kThumb2VcvtDI:
+    case kThumb2VcvtFd:
+    case kThumb2VcvtDF:
+    case kThumb2VcvtF64S32:
+    case kThumb2VcvtF64U32:
+      return kArmFpAluLatency;
+    case kThumb2Vmuls:
+    case kThumb2Vmuld:
+    case kThumb2VmlaF64:
+      return kArmFpMulLatency;
+    case kThumb2Vdivs:
+    case kThumb2Vdivd:
+    case kThumb2Vsqrts:
+    case kThumb2Vsqrtd:
+      return kArmFpDivLatency;
+    default:
+      return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? kArmLoadLatency : kArmAluLatency;
+  }
+}
+
 const char* ArmMir2Lir::GetTargetInstName(int opcode) {
   DCHECK(!IsPseudoLirOp(opcode));
   return ArmMir2Lir::EncodingMap[opcode].name;
@@ -87,6 +87,7 @@ class Arm64Mir2Lir : public Mir2Lir {
     std::string BuildInsnString(const char* fmt, LIR* lir, unsigned char* base_addr);
     uint64_t GetPCUseDefEncoding();
     uint64_t GetTargetInstFlags(int opcode);
+    int GetInstructionLatency(LIR* lir);
     int GetInsnSize(LIR* lir);
     bool IsUnconditionalBranch(LIR* lir);
 
@@ -120,7 +121,15 @@ class Arm64Mir2Lir : public Mir2Lir {
     void GenConversion(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src);
     bool GenInlinedCas(CallInfo* info, bool is_long, bool is_object);
     bool GenInlinedMinMaxInt(CallInfo* info, bool is_min);
+    bool GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double);
     bool GenInlinedSqrt(CallInfo* info);
+    bool GenInlinedCeil(CallInfo* info);
+    bool GenInlinedFloor(CallInfo* info);
+    bool GenInlinedRint(CallInfo* info);
+    bool GenInlinedRound(CallInfo* info, bool is_double);
+    bool GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long);
+    bool GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long);
+    bool GenInlinedBitCount(CallInfo* info, bool is_long);
     bool GenInlinedPeek(CallInfo* info, OpSize size);
     bool GenInlinedPoke(CallInfo* info, OpSize size);
     void GenNegLong(RegLocation rl_dest, RegLocation rl_src);
@@ -137,7 +146,7 @@ class Arm64Mir2Lir : public Mir2Lir {
     void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method);
     void GenExitSequence();
     void GenSpecialExitSequence();
-    void GenFillArrayData(DexOffset table_offset, RegLocation rl_src);
+    void GenFillArrayData(const uint16_t* table, RegLocation rl_src);
     void GenFusedFPCmpBranch(BasicBlock* bb, MIR* mir, bool gt_bias, bool is_double);
     void GenFusedLongCmpBranch(BasicBlock* bb, MIR* mir);
     void GenSelect(BasicBlock* bb, MIR* mir);
@@ -149,7 +158,7 @@ class Arm64Mir2Lir : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
     void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
     bool GenSpecialCase(BasicBlock* bb, MIR* mir, const InlineMethod& special);
 
@@ -225,6 +234,9 @@ class Arm64Mir2Lir : public Mir2Lir {
     RegLocation GenDivRem(RegLocation rl_dest, RegLocation rl_src1, RegLocation rl_src2,
                           bool is_div, bool check_zero);
     RegLocation GenDivRemLit(RegLocation rl_dest, RegLocation rl_src1, int lit, bool is_div);
+    // Rounds the double argument of the invoke to an integral value with one of the frint
+    // instructions.
+    bool GenInlinedFrint(CallInfo* info, ArmOpcode opcode);
 };
 
 }  // namespace art
@@ -296,27 +296,82 @@ void Arm64Mir2Lir::GenNegDouble(RegLocation rl_dest, RegLocation rl_src) {
 }
 
 bool Arm64Mir2Lir::GenInlinedSqrt(CallInfo* info) {
-  // TODO(Arm64): implement this.
-  UNIMPLEMENTED(FATAL) << "GenInlinedSqrt not implemented for Arm64";
-
   DCHECK_EQ(cu_->instruction_set, kArm64);
-  LIR *branch;
   RegLocation rl_src = info->args[0];
   RegLocation rl_dest = InlineTargetWide(info);  // double place for result
   rl_src = LoadValueWide(rl_src, kFPReg);
   RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+  // Unlike the VFP version used on Thumb2, fsqrt gives the IEEE result for every input, so
+  // there is no need for the fallback call to pSqrt on NaN.
   NewLIR2(FWIDE(kA64Fsqrt2ff), rl_result.reg.GetReg(), rl_src.reg.GetReg());
-  NewLIR2(FWIDE(kA64Fcmp2ff), rl_result.reg.GetReg(), rl_result.reg.GetReg());
-  branch = NewLIR2(kA64B2ct, kArmCondEq, 0);
-  ClobberCallerSave();
-  LockCallTemps();  // Using fixed registers
-  RegStorage r_tgt = LoadHelper(A64_QUICK_ENTRYPOINT_OFFSET(pSqrt));
-  // NewLIR3(kThumb2Fmrrd, r0, r1, rl_src.reg.GetReg());
-  NewLIR1(kA64Blr1x, r_tgt.GetReg());
-  // NewLIR3(kThumb2Fmdrr, rl_result.reg.GetReg(), r0, r1);
-  branch->target = NewLIR0(kPseudoTargetLabel);
   StoreValueWide(rl_dest, rl_result);
   return true;
 }
 
+bool Arm64Mir2Lir::GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double) {
+  DCHECK_EQ(cu_->instruction_set, kArm64);
+  // fmin and fmax return NaN if either operand is NaN and order -0.0 below +0.0, as Java does.
+  ArmOpcode opcode = (is_min) ? kA64Fmin3fff : kA64Fmax3fff;
+  if (is_double) {
+    RegLocation rl_src1 = LoadValueWide(info->args[0], kFPReg);
+    RegLocation rl_src2 = LoadValueWide(info->args[2], kFPReg);
+    RegLocation rl_dest = InlineTargetWide(info);
+    RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+    NewLIR3(FWIDE(opcode), rl_result.reg.GetReg(), rl_src1.reg.GetReg(), rl_src2.reg.GetReg());
+    StoreValueWide(rl_dest, rl_result);
+  } else {
+    RegLocation rl_src1 = LoadValue(info->args[0], kFPReg);
+    RegLocation rl_src2 = LoadValue(info->args[1], kFPReg);
+    RegLocation rl_dest = InlineTarget(info);
+    RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+    NewLIR3(opcode, rl_result.reg.GetReg(), rl_src1.reg.GetReg(), rl_src2.reg.GetReg());
+    StoreValue(rl_dest, rl_result);
+  }
+  return true;
+}
+
+bool Arm64Mir2Lir::GenInlinedFrint(CallInfo* info, ArmOpcode opcode) {
+  DCHECK_EQ(cu_->instruction_set, kArm64);
+  RegLocation rl_src = LoadValueWide(info->args[0], kFPReg);
+  RegLocation rl_dest = InlineTargetWide(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+  NewLIR2(FWIDE(opcode), rl_result.reg.GetReg(), rl_src.reg.GetReg());
+  StoreValueWide(rl_dest, rl_result);
+  return true;
+}
+
+bool Arm64Mir2Lir::GenInlinedCeil(CallInfo* info) {
+  return GenInlinedFrint(info, kA64Frintp2ff);
+}
+
+bool Arm64Mir2Lir::GenInlinedFloor(CallInfo* info) {
+  return GenInlinedFrint(info, kA64Frintm2ff);
+}
+
+bool Arm64Mir2Lir::GenInlinedRint(CallInfo* info) {
+  // frintn rounds to nearest with ties to even, as rint does.
+  return GenInlinedFrint(info, kA64Frintn2ff);
+}
+
+bool Arm64Mir2Lir::GenInlinedRound(CallInfo* info, bool is_double) {
+  DCHECK_EQ(cu_->instruction_set, kArm64);
+  if (is_double) {
+    // TODO(Arm64): the long result is still a register pair.
+    return false;
+  }
+  // round(f) is (int) floor(f + 0.5f). fcvtzs saturates and converts NaN to 0, as the Java
+  // conversion does.
+  RegLocation rl_src = LoadValue(info->args[0], kFPReg);
+  RegLocation rl_dest = InlineTarget(info);
+  RegStorage r_tmp = AllocTempSingle();
+  LoadConstantNoClobber(r_tmp, 0x3f000000);  // 0.5f
+  NewLIR3(kA64Fadd3fff, r_tmp.GetReg(), rl_src.reg.GetReg(), r_tmp.GetReg());
+  NewLIR2(kA64Frintm2ff, r_tmp.GetReg(), r_tmp.GetReg());
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  NewLIR2(kA64Fcvtzs2wf, rl_result.reg.GetReg(), r_tmp.GetReg());
+  FreeTemp(r_tmp);
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
 }  // namespace art
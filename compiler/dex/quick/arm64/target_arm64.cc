@@ -750,6 +750,31 @@ uint64_t Arm64Mir2Lir::GetTargetInstFlags(int opcode) {
   return Arm64Mir2Lir::EncodingMap[UNWIDE(opcode)].flags;
 }
 
+int Arm64Mir2Lir::GetInstructionLatency(LIR* lir) {
+  switch (UNWIDE(lir->opcode)) {
+    case kA64Mul3rrr:
+      return kA64MulLatency;
+    case kA64Sdiv3rrr:
+      return kA64DivLatency;
+    case kA64Fadd3fff:
+    case kA64Fsub3fff:
+    case kA64Fcvtzs2wf:
+    case kA64Fcvtzs2xf:
+    case kA64Fcvt2Ss:
+    case kA64Fcvt2sS:
+    case kA64Scvtf2fw:
+    case kA64Scvtf2fx:
+      return kA64FpAluLatency;
+    case kA64Fmul3fff:
+      return kA64FpMulLatency;
+    case kA64Fdiv3fff:
+    case kA64Fsqrt2ff:
+      return kA64FpDivLatency;
+    default:
+      return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? kA64LoadLatency : kA64AluLatency;
+  }
+}
+
 const char* Arm64Mir2Lir::GetTargetInstName(int opcode) {
   DCHECK(!IsPseudoLirOp(opcode));
   return Arm64Mir2Lir::EncodingMap[UNWIDE(opcode)].name;
@@ -19,6 +19,7 @@
 #include "gc_map.h"
 #include "gc_map_builder.h"
 #include "mapping_table.h"
+#include "mapping_table_builder.h"
 #include "mir_to_lir-inl.h"
 #include "dex/quick/dex_file_method_inliner.h"
 #include "dex/quick/dex_file_to_method_inliner_map.h"
@@ -603,94 +604,19 @@ bool Mir2Lir::VerifyCatchEntries() {
 
 
 void Mir2Lir::CreateMappingTables() {
-  uint32_t pc2dex_data_size = 0u;
-  uint32_t pc2dex_entries = 0u;
-  uint32_t pc2dex_offset = 0u;
-  uint32_t pc2dex_dalvik_offset = 0u;
-  uint32_t dex2pc_data_size = 0u;
-  uint32_t dex2pc_entries = 0u;
-  uint32_t dex2pc_offset = 0u;
-  uint32_t dex2pc_dalvik_offset = 0u;
+  MappingTableBuilder builder;
   for (LIR* tgt_lir = first_lir_insn_; tgt_lir != NULL; tgt_lir = NEXT_LIR(tgt_lir)) {
     if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoSafepointPC)) {
-      pc2dex_entries += 1;
-      DCHECK(pc2dex_offset <= tgt_lir->offset);
-      pc2dex_data_size += UnsignedLeb128Size(tgt_lir->offset - pc2dex_offset);
-      pc2dex_data_size += SignedLeb128Size(static_cast<int32_t>(tgt_lir->dalvik_offset) -
-                                           static_cast<int32_t>(pc2dex_dalvik_offset));
-      pc2dex_offset = tgt_lir->offset;
-      pc2dex_dalvik_offset = tgt_lir->dalvik_offset;
+      builder.AddPcToDexEntry(tgt_lir->offset, tgt_lir->dalvik_offset);
     }
     if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoExportedPC)) {
-      dex2pc_entries += 1;
-      DCHECK(dex2pc_offset <= tgt_lir->offset);
-      dex2pc_data_size += UnsignedLeb128Size(tgt_lir->offset - dex2pc_offset);
-      dex2pc_data_size += SignedLeb128Size(static_cast<int32_t>(tgt_lir->dalvik_offset) -
-                                           static_cast<int32_t>(dex2pc_dalvik_offset));
-      dex2pc_offset = tgt_lir->offset;
-      dex2pc_dalvik_offset = tgt_lir->dalvik_offset;
+      builder.AddDexToPcEntry(tgt_lir->offset, tgt_lir->dalvik_offset);
     }
   }
-
-  uint32_t total_entries = pc2dex_entries + dex2pc_entries;
-  uint32_t hdr_data_size = UnsignedLeb128Size(total_entries) + UnsignedLeb128Size(pc2dex_entries);
-  uint32_t data_size = hdr_data_size + pc2dex_data_size + dex2pc_data_size;
-  encoded_mapping_table_.resize(data_size);
-  uint8_t* write_pos = &encoded_mapping_table_[0];
-  write_pos = EncodeUnsignedLeb128(write_pos, total_entries);
-  write_pos = EncodeUnsignedLeb128(write_pos, pc2dex_entries);
-  DCHECK_EQ(static_cast<size_t>(write_pos - &encoded_mapping_table_[0]), hdr_data_size);
-  uint8_t* write_pos2 = write_pos + pc2dex_data_size;
-
-  pc2dex_offset = 0u;
-  pc2dex_dalvik_offset = 0u;
-  dex2pc_offset = 0u;
-  dex2pc_dalvik_offset = 0u;
-  for (LIR* tgt_lir = first_lir_insn_; tgt_lir != NULL; tgt_lir = NEXT_LIR(tgt_lir)) {
-    if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoSafepointPC)) {
-      DCHECK(pc2dex_offset <= tgt_lir->offset);
-      write_pos = EncodeUnsignedLeb128(write_pos, tgt_lir->offset - pc2dex_offset);
-      write_pos = EncodeSignedLeb128(write_pos, static_cast<int32_t>(tgt_lir->dalvik_offset) -
-                                     static_cast<int32_t>(pc2dex_dalvik_offset));
-      pc2dex_offset = tgt_lir->offset;
-      pc2dex_dalvik_offset = tgt_lir->dalvik_offset;
-    }
-    if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoExportedPC)) {
-      DCHECK(dex2pc_offset <= tgt_lir->offset);
-      write_pos2 = EncodeUnsignedLeb128(write_pos2, tgt_lir->offset - dex2pc_offset);
-      write_pos2 = EncodeSignedLeb128(write_pos2, static_cast<int32_t>(tgt_lir->dalvik_offset) -
-                                      static_cast<int32_t>(dex2pc_dalvik_offset));
-      dex2pc_offset = tgt_lir->offset;
-      dex2pc_dalvik_offset = tgt_lir->dalvik_offset;
-    }
-  }
-  DCHECK_EQ(static_cast<size_t>(write_pos - &encoded_mapping_table_[0]),
-            hdr_data_size + pc2dex_data_size);
-  DCHECK_EQ(static_cast<size_t>(write_pos2 - &encoded_mapping_table_[0]), data_size);
+  builder.Build(&encoded_mapping_table_);
 
   if (kIsDebugBuild) {
     CHECK(VerifyCatchEntries());
-
-    // Verify the encoded table holds the expected data.
-    MappingTable table(&encoded_mapping_table_[0]);
-    CHECK_EQ(table.TotalSize(), total_entries);
-    CHECK_EQ(table.PcToDexSize(), pc2dex_entries);
-    auto it = table.PcToDexBegin();
-    auto it2 = table.DexToPcBegin();
-    for (LIR* tgt_lir = first_lir_insn_; tgt_lir != NULL; tgt_lir = NEXT_LIR(tgt_lir)) {
-      if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoSafepointPC)) {
-        CHECK_EQ(tgt_lir->offset, it.NativePcOffset());
-        CHECK_EQ(tgt_lir->dalvik_offset, it.DexPc());
-        ++it;
-      }
-      if (!tgt_lir->flags.is_nop && (tgt_lir->opcode == kPseudoExportedPC)) {
-        CHECK_EQ(tgt_lir->offset, it2.NativePcOffset());
-        CHECK_EQ(tgt_lir->dalvik_offset, it2.DexPc());
-        ++it2;
-      }
-    }
-    CHECK(it == table.PcToDexEnd());
-    CHECK(it2 == table.DexToPcEnd());
   }
 }
 
@@ -960,7 +886,9 @@ Mir2Lir::Mir2Lir(CompilationUnit* cu, MIRGraph* mir_graph, ArenaAllocator* arena
       fp_spill_mask_(0),
       first_lir_insn_(NULL),
       last_lir_insn_(NULL),
-      slow_paths_(arena, 32, kGrowableArraySlowPaths) {
+      slow_paths_(arena, 32, kGrowableArraySlowPaths),
+      osr_entries_(arena, 4, kGrowableArrayMisc),
+      in_osr_entry_(false) {
   // Reserve pointer id 0 for NULL.
   size_t null_idx = WrapPointer(NULL);
   DCHECK_EQ(null_idx, 0U);
@@ -1026,11 +954,18 @@ CompiledMethod* Mir2Lir::GetCompiledMethod() {
     vmap_encoder.PushBackUnsigned(0u);  // Size is 0.
   }
 
+  std::vector<uint32_t> osr_entries;
+  GrowableArray<LIR*>::Iterator osr_iter(&osr_entries_);
+  for (LIR* entry = osr_iter.Next(); entry != NULL; entry = osr_iter.Next()) {
+    osr_entries.push_back(entry->operands[0]);
+    osr_entries.push_back(entry->offset);
+  }
+
   UniquePtr<std::vector<uint8_t> > cfi_info(ReturnCallFrameInformation());
   CompiledMethod* result =
       new CompiledMethod(cu_->compiler_driver, cu_->instruction_set, code_buffer_, frame_size_,
                          core_spill_mask_, fp_spill_mask_, encoded_mapping_table_,
-                         vmap_encoder.GetData(), native_gc_map_, cfi_info.get());
+                         vmap_encoder.GetData(), native_gc_map_, cfi_info.get(), osr_entries);
   return result;
 }
 
@@ -27,6 +27,7 @@
 #include "dex/mir_graph.h"
 #include "dex_instruction.h"
 #include "dex_instruction-inl.h"
+#include "mirror/string.h"
 #include "verifier/method_verifier.h"
 #include "verifier/method_verifier-inl.h"
 
@@ -86,8 +87,10 @@ const char* const DexFileMethodInliner::kClassCacheNames[] = {
     "Ljava/lang/Math;",        // kClassCacheJavaLangMath
     "Ljava/lang/StrictMath;",  // kClassCacheJavaLangStrictMath
     "Ljava/lang/Thread;",      // kClassCacheJavaLangThread
+    "Ljava/lang/System;",      // kClassCacheJavaLangSystem
     "Llibcore/io/Memory;",     // kClassCacheLibcoreIoMemory
     "Lsun/misc/Unsafe;",       // kClassCacheSunMiscUnsafe
+    "[C",                      // kClassCacheJavaLangCharArray
 };
 
 const char* const DexFileMethodInliner::kNameCacheNames[] = {
@@ -100,12 +103,23 @@ const char* const DexFileMethodInliner::kNameCacheNames[] = {
     "max",                   // kNameCacheMax
     "min",                   // kNameCacheMin
     "sqrt",                  // kNameCacheSqrt
+    "ceil",                  // kNameCacheCeil
+    "floor",                 // kNameCacheFloor
+    "rint",                  // kNameCacheRint
+    "round",                 // kNameCacheRound
+    "numberOfLeadingZeros",  // kNameCacheNumberOfLeadingZeros
+    "numberOfTrailingZeros",  // kNameCacheNumberOfTrailingZeros
+    "bitCount",              // kNameCacheBitCount
+    "rotateRight",           // kNameCacheRotateRight
+    "rotateLeft",            // kNameCacheRotateLeft
     "charAt",                // kNameCacheCharAt
     "compareTo",             // kNameCacheCompareTo
+    "equals",                // kNameCacheEquals
     "isEmpty",               // kNameCacheIsEmpty
     "indexOf",               // kNameCacheIndexOf
     "length",                // kNameCacheLength
     "currentThread",         // kNameCacheCurrentThread
+    "arraycopy",             // kNameCacheArrayCopy
     "peekByte",              // kNameCachePeekByte
     "peekIntNative",         // kNameCachePeekIntNative
     "peekLongNative",        // kNameCachePeekLongNative
@@ -155,10 +169,20 @@ const DexFileMethodInliner::ProtoDef DexFileMethodInliner::kProtoCacheDefs[] = {
     { kClassCacheFloat, 1, { kClassCacheInt } },
     // kProtoCacheII_I
     { kClassCacheInt, 2, { kClassCacheInt, kClassCacheInt } },
+    // kProtoCacheJJ_J
+    { kClassCacheLong, 2, { kClassCacheLong, kClassCacheLong } },
+    // kProtoCacheFF_F
+    { kClassCacheFloat, 2, { kClassCacheFloat, kClassCacheFloat } },
+    // kProtoCacheDD_D
+    { kClassCacheDouble, 2, { kClassCacheDouble, kClassCacheDouble } },
+    // kProtoCacheJI_J
+    { kClassCacheLong, 2, { kClassCacheLong, kClassCacheInt } },
     // kProtoCacheI_C
     { kClassCacheChar, 1, { kClassCacheInt } },
     // kProtoCacheString_I
     { kClassCacheInt, 1, { kClassCacheJavaLangString } },
+    // kProtoCacheObject_Z
+    { kClassCacheBoolean, 1, { kClassCacheJavaLangObject } },
     // kProtoCache_Z
     { kClassCacheBoolean, 0, { } },
     // kProtoCache_I
@@ -201,6 +225,9 @@ const DexFileMethodInliner::ProtoDef DexFileMethodInliner::kProtoCacheDefs[] = {
     // kProtoCacheObjectJObject_V
     { kClassCacheVoid, 3, { kClassCacheJavaLangObject, kClassCacheLong,
         kClassCacheJavaLangObject } },
+    // kProtoCacheCharArrayICharArrayII_V
+    { kClassCacheVoid, 5, { kClassCacheJavaLangCharArray, kClassCacheInt,
+        kClassCacheJavaLangCharArray, kClassCacheInt, kClassCacheInt } },
 };
 
 const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods[] = {
@@ -228,11 +255,49 @@ const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods
     INTRINSIC(JavaLangStrictMath, Min, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMin),
     INTRINSIC(JavaLangMath,       Max, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMax),
     INTRINSIC(JavaLangStrictMath, Max, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMax),
     INTRINSIC(JavaLangMath,       Sqrt, D_D, kIntrinsicSqrt, 0),
     INTRINSIC(JavaLangStrictMath, Sqrt, D_D, kIntrinsicSqrt, 0),
+    INTRINSIC(JavaLangMath,       Ceil, D_D, kIntrinsicCeil, 0),
+    INTRINSIC(JavaLangStrictMath, Ceil, D_D, kIntrinsicCeil, 0),
+    INTRINSIC(JavaLangMath,       Floor, D_D, kIntrinsicFloor, 0),
+    INTRINSIC(JavaLangStrictMath, Floor, D_D, kIntrinsicFloor, 0),
+    INTRINSIC(JavaLangMath,       Rint, D_D, kIntrinsicRint, 0),
+    INTRINSIC(JavaLangStrictMath, Rint, D_D, kIntrinsicRint, 0),
+    INTRINSIC(JavaLangMath,       Round, F_I, kIntrinsicRoundFloat, 0),
+    INTRINSIC(JavaLangStrictMath, Round, F_I, kIntrinsicRoundFloat, 0),
+    INTRINSIC(JavaLangMath,       Round, D_J, kIntrinsicRoundDouble, 0),
+    INTRINSIC(JavaLangStrictMath, Round, D_J, kIntrinsicRoundDouble, 0),
+
+    INTRINSIC(JavaLangInteger, NumberOfLeadingZeros, I_I, kIntrinsicNumberOfLeadingZeros,
+              kIntrinsicFlagNone),
+    INTRINSIC(JavaLangLong, NumberOfLeadingZeros, J_I, kIntrinsicNumberOfLeadingZeros,
+              kIntrinsicFlagIsLong),
+    INTRINSIC(JavaLangInteger, NumberOfTrailingZeros, I_I, kIntrinsicNumberOfTrailingZeros,
+              kIntrinsicFlagNone),
+    INTRINSIC(JavaLangLong, NumberOfTrailingZeros, J_I, kIntrinsicNumberOfTrailingZeros,
+              kIntrinsicFlagIsLong),
+    INTRINSIC(JavaLangInteger, BitCount, I_I, kIntrinsicBitCount, kIntrinsicFlagNone),
+    INTRINSIC(JavaLangLong, BitCount, J_I, kIntrinsicBitCount, kIntrinsicFlagIsLong),
+    INTRINSIC(JavaLangInteger, RotateRight, II_I, kIntrinsicRotateRight, kIntrinsicFlagNone),
+    INTRINSIC(JavaLangLong, RotateRight, JI_J, kIntrinsicRotateRight, kIntrinsicFlagIsLong),
+    INTRINSIC(JavaLangInteger, RotateLeft, II_I, kIntrinsicRotateLeft, kIntrinsicFlagNone),
+    INTRINSIC(JavaLangLong, RotateLeft, JI_J, kIntrinsicRotateLeft, kIntrinsicFlagIsLong),
 
     INTRINSIC(JavaLangString, CharAt, I_C, kIntrinsicCharAt, 0),
     INTRINSIC(JavaLangString, CompareTo, String_I, kIntrinsicCompareTo, 0),
+    INTRINSIC(JavaLangString, Equals, Object_Z, kIntrinsicEquals, 0),
     INTRINSIC(JavaLangString, IsEmpty, _Z, kIntrinsicIsEmptyOrLength, kIntrinsicFlagIsEmpty),
     INTRINSIC(JavaLangString, IndexOf, II_I, kIntrinsicIndexOf, kIntrinsicFlagNone),
     INTRINSIC(JavaLangString, IndexOf, I_I, kIntrinsicIndexOf, kIntrinsicFlagBase0),
@@ -240,6 +305,9 @@ const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods
 
     INTRINSIC(JavaLangThread, CurrentThread, _Thread, kIntrinsicCurrentThread, 0),
 
+    INTRINSIC(JavaLangSystem, ArrayCopy, CharArrayICharArrayII_V,
+              kIntrinsicSystemArrayCopyCharArray, 0),
+
     INTRINSIC(LibcoreIoMemory, PeekByte, J_B, kIntrinsicPeek, kSignedByte),
     INTRINSIC(LibcoreIoMemory, PeekIntNative, J_I, kIntrinsicPeek, k32),
     INTRINSIC(LibcoreIoMemory, PeekLongNative, J_J, kIntrinsicPeek, k64),
@@ -329,19 +397,53 @@ bool DexFileMethodInliner::GenIntrinsic(Mir2Lir* backend, CallInfo* info) {
       return backend->GenInlinedAbsDouble(info);
     case kIntrinsicMinMaxInt:
       return backend->GenInlinedMinMaxInt(info, intrinsic.d.data & kIntrinsicFlagMin);
+    case kIntrinsicMinMaxLong:
+      return backend->GenInlinedMinMaxLong(info, intrinsic.d.data & kIntrinsicFlagMin);
+    case kIntrinsicMinMaxFloat:
+      return backend->GenInlinedMinMaxFP(info, intrinsic.d.data & kIntrinsicFlagMin, false);
+    case kIntrinsicMinMaxDouble:
+      return backend->GenInlinedMinMaxFP(info, intrinsic.d.data & kIntrinsicFlagMin, true);
     case kIntrinsicSqrt:
       return backend->GenInlinedSqrt(info);
+    case kIntrinsicCeil:
+      return backend->GenInlinedCeil(info);
+    case kIntrinsicFloor:
+      return backend->GenInlinedFloor(info);
+    case kIntrinsicRint:
+      return backend->GenInlinedRint(info);
+    case kIntrinsicRoundFloat:
+      return backend->GenInlinedRound(info, false);
+    case kIntrinsicRoundDouble:
+      return backend->GenInlinedRound(info, true);
+    case kIntrinsicNumberOfLeadingZeros:
+      return backend->GenInlinedNumberOfLeadingZeros(info,
+                                                     intrinsic.d.data & kIntrinsicFlagIsLong);
+    case kIntrinsicNumberOfTrailingZeros:
+      return backend->GenInlinedNumberOfTrailingZeros(info,
+                                                      intrinsic.d.data & kIntrinsicFlagIsLong);
+    case kIntrinsicBitCount:
+      return backend->GenInlinedBitCount(info, intrinsic.d.data & kIntrinsicFlagIsLong);
+    case kIntrinsicRotateRight:
+      return backend->GenInlinedRotate(info, intrinsic.d.data & kIntrinsicFlagIsLong, false);
+    case kIntrinsicRotateLeft:
+      return backend->GenInlinedRotate(info, intrinsic.d.data & kIntrinsicFlagIsLong, true);
     case kIntrinsicCharAt:
-      return backend->GenInlinedCharAt(info);
+      // The inlined String code reads UTF-16 characters, compressed strings go to the Java code.
+      return !mirror::String::kUseStringCompression && backend->GenInlinedCharAt(info);
     case kIntrinsicCompareTo:
-      return backend->GenInlinedStringCompareTo(info);
+      return !mirror::String::kUseStringCompression && backend->GenInlinedStringCompareTo(info);
+    case kIntrinsicEquals:
+      return !mirror::String::kUseStringCompression && backend->GenInlinedStringEquals(info);
     case kIntrinsicIsEmptyOrLength:
       return backend->GenInlinedStringIsEmptyOrLength(
           info, intrinsic.d.data & kIntrinsicFlagIsEmpty);
     case kIntrinsicIndexOf:
-      return backend->GenInlinedIndexOf(info, intrinsic.d.data & kIntrinsicFlagBase0);
+      return !mirror::String::kUseStringCompression &&
+          backend->GenInlinedIndexOf(info, intrinsic.d.data & kIntrinsicFlagBase0);
     case kIntrinsicCurrentThread:
       return backend->GenInlinedCurrentThread(info);
+    case kIntrinsicSystemArrayCopyCharArray:
+      return backend->GenInlinedArrayCopyCharArray(info);
     case kIntrinsicPeek:
       return backend->GenInlinedPeek(info, static_cast<OpSize>(intrinsic.d.data));
     case kIntrinsicPoke:
@@ -415,6 +517,10 @@ bool DexFileMethodInliner::GenInline(MIRGraph* mir_graph, BasicBlock* bb, MIR* i
       move_result = mir_graph->FindMoveResult(bb, invoke);
       result = GenInlineIPut(mir_graph, bb, invoke, move_result, method, method_idx);
       break;
+    case kInlineOpExpression:
+      move_result = mir_graph->FindMoveResult(bb, invoke);
+      result = GenInlineExpression(mir_graph, bb, invoke, move_result, method, dex_file_);
+      break;
     default:
       LOG(FATAL) << "Unexpected inline op: " << method.opcode;
   }
@@ -755,4 +861,64 @@ bool DexFileMethodInliner::GenInlineIPut(MIRGraph* mir_graph, BasicBlock* bb, MI
   return true;
 }
 
+bool DexFileMethodInliner::GenInlineExpression(MIRGraph* mir_graph, BasicBlock* bb, MIR* invoke,
+                                               MIR* move_result, const InlineMethod& method,
+                                               const DexFile* dex_file) {
+  if (move_result == nullptr) {
+    // Result is unused and the expression has no side effects.
+    return true;
+  }
+  DCHECK(move_result->dalvikInsn.opcode == Instruction::MOVE_RESULT);
+
+  // The callee's accumulator becomes the result register and its ins become the invoke's
+  // argument registers. Check that writing the result register doesn't clobber an argument
+  // that's still needed.
+  const InlineExpressionData& data = method.d.expression_data;
+  const DexFile::CodeItem* code_item = dex_file->GetCodeItem(data.code_item_offset);
+  uint32_t arg_start = code_item->registers_size_ - code_item->ins_size_;
+  uint32_t result_reg = move_result->dalvikInsn.vA;
+  bool result_written = false;
+  for (uint32_t dex_pc = 0u; dex_pc != data.insns_size; ) {
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+    uint64_t df_attributes = MIRGraph::GetDataFlowAttributes(inst->Opcode());
+    if (result_written) {
+      if (((df_attributes & DF_UB) != 0 && static_cast<uint32_t>(inst->VRegB()) >= arg_start &&
+              GetInvokeReg(invoke, inst->VRegB() - arg_start) == result_reg) ||
+          ((df_attributes & DF_UC) != 0 && static_cast<uint32_t>(inst->VRegC()) >= arg_start &&
+              GetInvokeReg(invoke, inst->VRegC() - arg_start) == result_reg)) {
+        return false;
+      }
+    }
+    result_written = true;  // Every instruction writes the accumulator.
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  if (!mir_graph->ChargeInliningBudget(data.insns_size)) {
+    return false;
+  }
+
+  // Insert the callee's instructions with their registers renamed.
+  MIR* insert_after = move_result;
+  for (uint32_t dex_pc = 0u; dex_pc != data.insns_size; ) {
+    MIR* insn = AllocReplacementMIR(mir_graph, invoke, move_result);
+    dex_pc += mir_graph->ParseInsn(code_item->insns_ + dex_pc, &insn->dalvikInsn);
+    uint64_t df_attributes = MIRGraph::GetDataFlowAttributes(insn->dalvikInsn.opcode);
+    DCHECK_NE(df_attributes & DF_DA, 0u);
+    DCHECK_EQ(insn->dalvikInsn.vA, data.accumulator);
+    insn->dalvikInsn.vA = result_reg;
+    if ((df_attributes & DF_UB) != 0) {
+      uint32_t reg = insn->dalvikInsn.vB;
+      insn->dalvikInsn.vB =
+          (reg == data.accumulator) ? result_reg : GetInvokeReg(invoke, reg - arg_start);
+    }
+    if ((df_attributes & DF_UC) != 0) {
+      uint32_t reg = insn->dalvikInsn.vC;
+      insn->dalvikInsn.vC =
+          (reg == data.accumulator) ? result_reg : GetInvokeReg(invoke, reg - arg_start);
+    }
+    bb->InsertMIRAfter(insert_after, insn);
+    insert_after = insn;
+  }
+  return true;
+}
+
 }  // namespace art
@@ -116,8 +116,10 @@ class DexFileMethodInliner {
       kClassCacheJavaLangMath,
       kClassCacheJavaLangStrictMath,
       kClassCacheJavaLangThread,
+      kClassCacheJavaLangSystem,
       kClassCacheLibcoreIoMemory,
       kClassCacheSunMiscUnsafe,
+      kClassCacheJavaLangCharArray,
       kClassCacheLast
     };
 
@@ -137,12 +139,23 @@ class DexFileMethodInliner {
       kNameCacheMax,
       kNameCacheMin,
       kNameCacheSqrt,
+      kNameCacheCeil,
+      kNameCacheFloor,
+      kNameCacheRint,
+      kNameCacheRound,
+      kNameCacheNumberOfLeadingZeros,
+      kNameCacheNumberOfTrailingZeros,
+      kNameCacheBitCount,
+      kNameCacheRotateRight,
+      kNameCacheRotateLeft,
       kNameCacheCharAt,
       kNameCacheCompareTo,
+      kNameCacheEquals,
       kNameCacheIsEmpty,
       kNameCacheIndexOf,
       kNameCacheLength,
       kNameCacheCurrentThread,
+      kNameCacheArrayCopy,
       kNameCachePeekByte,
       kNameCachePeekIntNative,
       kNameCachePeekLongNative,
@@ -189,8 +202,13 @@ class DexFileMethodInliner {
       kProtoCacheF_I,
       kProtoCacheI_F,
       kProtoCacheII_I,
+      kProtoCacheJJ_J,
+      kProtoCacheFF_F,
+      kProtoCacheDD_D,
+      kProtoCacheJI_J,
       kProtoCacheI_C,
       kProtoCacheString_I,
+      kProtoCacheObject_Z,
       kProtoCache_Z,
       kProtoCache_I,
       kProtoCache_Thread,
@@ -210,6 +228,7 @@ class DexFileMethodInliner {
       kProtoCacheObjectJJ_V,
       kProtoCacheObjectJ_Object,
       kProtoCacheObjectJObject_V,
+      kProtoCacheCharArrayICharArrayII_V,
       kProtoCacheLast
     };
 
@@ -303,6 +322,9 @@ class DexFileMethodInliner {
                               MIR* move_result, const InlineMethod& method, uint32_t method_idx);
     static bool GenInlineIPut(MIRGraph* mir_graph, BasicBlock* bb, MIR* invoke,
                               MIR* move_result, const InlineMethod& method, uint32_t method_idx);
+    static bool GenInlineExpression(MIRGraph* mir_graph, BasicBlock* bb, MIR* invoke,
+                                    MIR* move_result, const InlineMethod& method,
+                                    const DexFile* dex_file);
 
     ReaderWriterMutex lock_;
     /*
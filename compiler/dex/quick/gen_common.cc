@@ -281,6 +281,96 @@ void Mir2Lir::GenCompareZeroAndBranch(Instruction::Code opcode, RegLocation rl_s
   OpCmpImmBranch(cond, rl_src.reg, 0, taken);
 }
 
+// Sparse-switch key sets of at most this size are tested with a chain of compares.
+static constexpr int kSparseSwitchChainMaxKeys = 4;
+// A sparse-switch becomes a packed-switch jump table when its key range has at most this many
+// entries per key, and at most kSparseSwitchMaxTableEntries entries. dx already emits a
+// packed-switch for the key sets filling half of their range, so this takes the sparser ones
+// whose table is still no bigger than the compare tree.
+static constexpr int64_t kSparseSwitchMaxEntriesPerKey = 4;
+static constexpr int64_t kSparseSwitchMaxTableEntries = 1024;
+
+bool Mir2Lir::GenLoweredSparseSwitch(MIR* mir, BasicBlock* bb, RegLocation rl_src) {
+  if (((cu_->disable_opt & (1 << kSuppressSwitchLowering)) != 0) ||
+      (bb->successor_block_list_type != kSparseSwitch) ||
+      (bb->fall_through == NullBasicBlockId)) {
+    return false;
+  }
+  // The successors are in the order of the table, that is sorted by key.
+  int size = bb->successor_blocks->Size();
+  int32_t* keys = static_cast<int32_t*>(arena_->Alloc(size * sizeof(int32_t), kArenaAllocData));
+  BasicBlockId* blocks =
+      static_cast<BasicBlockId*>(arena_->Alloc(size * sizeof(BasicBlockId), kArenaAllocData));
+  GrowableArray<SuccessorBlockInfo*>::Iterator iterator(bb->successor_blocks);
+  for (int i = 0; i < size; ++i) {
+    SuccessorBlockInfo* successor_block_info = iterator.Next();
+    keys[i] = successor_block_info->key;
+    blocks[i] = successor_block_info->block;
+    DCHECK(i == 0 || keys[i - 1] < keys[i]);
+  }
+
+  int64_t range = static_cast<int64_t>(keys[size - 1]) - keys[0] + 1;
+  if ((size > kSparseSwitchChainMaxKeys) && (range <= kSparseSwitchMaxEntriesPerKey * size) &&
+      (range <= kSparseSwitchMaxTableEntries)) {
+    // Dense keys: rewrite the table as a packed-switch one, the missing keys going to the
+    // fall-through, and let the target emit its jump table.
+    uint16_t* table = static_cast<uint16_t*>(
+        arena_->Alloc((4 + range * 2) * sizeof(uint16_t), kArenaAllocData));
+    table[0] = static_cast<uint16_t>(Instruction::kPackedSwitchSignature);
+    table[1] = static_cast<uint16_t>(range);
+    table[2] = static_cast<uint16_t>(keys[0] & 0xffff);
+    table[3] = static_cast<uint16_t>((keys[0] >> 16) & 0xffff);
+    int32_t* targets = reinterpret_cast<int32_t*>(&table[4]);
+    int32_t not_found =
+        mir_graph_->GetBasicBlock(bb->fall_through)->start_offset - current_dalvik_offset_;
+    for (int64_t i = 0; i < range; ++i) {
+      targets[i] = not_found;
+    }
+    for (int i = 0; i < size; ++i) {
+      targets[static_cast<int64_t>(keys[i]) - keys[0]] =
+          mir_graph_->GetBasicBlock(blocks[i])->start_offset - current_dalvik_offset_;
+    }
+    GenPackedSwitch(mir, table, rl_src);
+    return true;
+  }
+
+  // Sparse keys: binary search with compares, which needs no table and takes log2(size)
+  // compares rather than the linear scan of the table.
+  rl_src = LoadValue(rl_src, kCoreReg);
+  LIR** targets = static_cast<LIR**>(arena_->Alloc(size * sizeof(LIR*), kArenaAllocData));
+  for (int i = 0; i < size; ++i) {
+    targets[i] = &block_label_list_[blocks[i]];
+  }
+  GenSparseSwitchTree(rl_src.reg, keys, targets, 0, size - 1,
+                      &block_label_list_[bb->fall_through]);
+  return true;
+}
+
+void Mir2Lir::GenSparseSwitchTree(RegStorage reg, const int32_t* keys, LIR** targets, int low,
+                                  int high, LIR* not_found) {
+  if (high - low < kSparseSwitchChainMaxKeys) {
+    for (int i = low; i <= high; ++i) {
+      OpCmpImmBranch(kCondEq, reg, keys[i], targets[i]);
+    }
+    OpUnconditionalBranch(not_found);
+    return;
+  }
+  int middle = low + (high - low) / 2;
+  LIR* branch_high;
+  if (cu_->instruction_set == kMips) {
+    // No condition codes, compare twice.
+    OpCmpImmBranch(kCondEq, reg, keys[middle], targets[middle]);
+    branch_high = OpCmpImmBranch(kCondGt, reg, keys[middle], nullptr);
+  } else {
+    OpRegImm(kOpCmp, reg, keys[middle]);
+    OpCondBranch(kCondEq, targets[middle]);
+    branch_high = OpCondBranch(kCondGt, nullptr);
+  }
+  GenSparseSwitchTree(reg, keys, targets, low, middle - 1, not_found);
+  branch_high->target = NewLIR0(kPseudoTargetLabel);
+  GenSparseSwitchTree(reg, keys, targets, middle + 1, high, not_found);
+}
+
 void Mir2Lir::GenIntToLong(RegLocation rl_dest, RegLocation rl_src) {
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
   if (rl_src.location == kLocPhysReg) {
@@ -468,6 +558,103 @@ void Mir2Lir::GenFilledNewArray(CallInfo* info) {
   }
 }
 
+// Fill-array-data payloads of at most this many bytes are stored inline, rather than copied by
+// the pHandleFillArrayData entrypoint. That's 16 word stores, each with its immediate load.
+static constexpr uint64_t kFillArrayDataInlineMaxBytes = 64;
+
+bool Mir2Lir::GenInlineFillArrayData(const uint16_t* table, RegLocation rl_src, int opt_flags) {
+  DCHECK_EQ(table[0], static_cast<uint16_t>(Instruction::kArrayDataSignature));
+  uint16_t width = table[1];
+  uint32_t size = table[2] | (static_cast<uint32_t>(table[3]) << 16);
+  uint64_t size_in_bytes = static_cast<uint64_t>(size) * width;
+  if ((size == 0) || (size_in_bytes > kFillArrayDataInlineMaxBytes)) {
+    return false;
+  }
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(&table[4]);
+  rl_src = LoadValue(rl_src, kCoreReg);
+  GenNullCheck(rl_src.reg, opt_flags);
+  bool null_check_marked = false;
+  if ((opt_flags & MIR_IGNORE_RANGE_CHECK) == 0) {
+    // The runtime throws for the last element of the payload, as the bounds check does.
+    RegStorage r_length = AllocTemp();
+    Load32Disp(rl_src.reg, mirror::Array::LengthOffset().Int32Value(), r_length);
+    MarkPossibleNullPointerException(opt_flags);
+    null_check_marked = true;
+    GenArrayBoundsCheck(static_cast<int>(size - 1), r_length);
+    FreeTemp(r_length);
+  }
+  // The data offset is word aligned for all the widths. The payload is stored a word at a time,
+  // so that a word packs several narrow elements, and the tail with a half word and a byte store.
+  int data_offset = mirror::Array::DataOffset(width).Int32Value();
+  RegStorage r_value = AllocTemp();
+  bool value_loaded = false;
+  uint32_t last_value = 0u;
+  for (uint64_t offset = 0u; offset != size_in_bytes; ) {
+    uint64_t remaining = size_in_bytes - offset;
+    uint32_t store_bytes = (remaining >= 4u) ? 4u : ((remaining >= 2u) ? 2u : 1u);
+    OpSize store_size = (store_bytes == 4u) ? k32 : ((store_bytes == 2u) ? kUnsignedHalf :
+                                                     kUnsignedByte);
+    // The payload is little-endian, as the targets.
+    uint32_t value = 0u;
+    for (uint32_t i = 0u; i != store_bytes; ++i) {
+      value |= static_cast<uint32_t>(data[offset + i]) << (8u * i);
+    }
+    // Runs of equal words, the zeroes in particular, reuse the immediate.
+    if (!value_loaded || value != last_value) {
+      LoadConstant(r_value, static_cast<int>(value));
+      value_loaded = true;
+      last_value = value;
+    }
+    StoreBaseDisp(rl_src.reg, data_offset + static_cast<int>(offset), r_value, store_size);
+    if (!null_check_marked) {
+      MarkPossibleNullPointerException(opt_flags);
+      null_check_marked = true;
+    }
+    offset += store_bytes;
+  }
+  FreeTemp(r_value);
+  return true;
+}
+
+void Mir2Lir::GenReadBarrier(RegStorage reg) {
+  if (!kUseBakerReadBarrier) {
+    return;
+  }
+  class ReadBarrierSlowPath : public Mir2Lir::LIRSlowPath {
+   public:
+    ReadBarrierSlowPath(Mir2Lir* m2l, LIR* branch, LIR* cont, RegStorage reg)
+        : LIRSlowPath(m2l, m2l->GetCurrentDexPc(), branch, cont), reg_(reg) {
+    }
+
+    void Compile() OVERRIDE {
+      GenerateTargetLabel();
+      // The runtime doesn't suspend while marking, no safepoint is needed.
+      m2l_->CallRuntimeHelperReg(QUICK_ENTRYPOINT_OFFSET(4, pReadBarrierMark), reg_, false);
+      m2l_->OpRegCopy(reg_, m2l_->TargetReg(kRet0));
+      m2l_->OpUnconditionalBranch(cont_);
+    }
+
+   private:
+    const RegStorage reg_;
+  };
+
+  FlushAllRegs();
+  // The mark entrypoint is only set while the collector is marking.
+  ThreadOffset<4> mark_offset = QUICK_ENTRYPOINT_OFFSET(4, pReadBarrierMark);
+  LIR* branch;
+  if (cu_->instruction_set == kX86 || cu_->instruction_set == kX86_64) {
+    OpTlsCmp(mark_offset, 0);
+    branch = OpCondBranch(kCondNe, nullptr);
+  } else {
+    RegStorage r_tmp = AllocTemp();
+    LoadWordDisp(TargetReg(kSelf), mark_offset.Int32Value(), r_tmp);
+    branch = OpCmpImmBranch(kCondNe, r_tmp, 0, nullptr);
+    FreeTemp(r_tmp);
+  }
+  LIR* cont = NewLIR0(kPseudoTargetLabel);
+  AddSlowPath(new (arena_) ReadBarrierSlowPath(this, branch, cont, reg));
+}
+
 //
 // Slow path to ensure a class is initialized for sget/sput.
 //
@@ -513,6 +700,7 @@ void Mir2Lir::GenSput(MIR* mir, RegLocation rl_src, bool is_long_or_double,
       if (IsTemp(rl_method.reg)) {
         FreeTemp(rl_method.reg);
       }
+      GenReadBarrier(r_base);
     } else {
       // Medium path, static storage base in a different class which requires checks that the other
       // class is initialized.
@@ -529,6 +717,7 @@ void Mir2Lir::GenSput(MIR* mir, RegLocation rl_src, bool is_long_or_double,
       LoadRefDisp(r_method, mirror::ArtMethod::DexCacheResolvedTypesOffset().Int32Value(), r_base);
       int32_t offset_of_field = ObjArray::OffsetOfElement(field_info.StorageIndex()).Int32Value();
       LoadRefDisp(r_base, offset_of_field, r_base);
+      GenReadBarrier(r_base);
       // r_base now points at static storage (Class*) or NULL if the type is not yet resolved.
       if (!field_info.IsInitialized() &&
           (mir->optimization_flags & MIR_IGNORE_CLINIT_CHECK) == 0) {
@@ -586,7 +775,17 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
   const MirSFieldLoweringInfo& field_info = mir_graph_->GetSFieldLoweringInfo(mir);
   cu_->compiler_driver->ProcessedStaticField(field_info.FastGet(), field_info.IsReferrersClass());
   OpSize load_size = LoadStoreOpSize(is_long_or_double, is_object);
-  if (!SLOW_FIELD_PATH && field_info.FastGet() &&
+  if (!SLOW_FIELD_PATH && field_info.IsConstant()) {
+    // The class was initialized in the boot image, neither a clinit check nor a load is needed.
+    RegLocation rl_result = EvalLoc(rl_dest, is_object ? kCoreReg : kAnyReg, true);
+    if (is_long_or_double) {
+      LoadConstantWide(rl_result.reg, static_cast<int64_t>(field_info.ConstantValue()));
+      StoreValueWide(rl_dest, rl_result);
+    } else {
+      LoadConstantNoClobber(rl_result.reg, static_cast<int32_t>(field_info.ConstantValue()));
+      StoreValue(rl_dest, rl_result);
+    }
+  } else if (!SLOW_FIELD_PATH && field_info.FastGet() &&
       (!field_info.IsVolatile() || SupportsVolatileLoadStore(load_size))) {
     DCHECK_GE(field_info.FieldOffset().Int32Value(), 0);
     RegStorage r_base;
@@ -595,6 +794,7 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
       RegLocation rl_method  = LoadCurrMethod();
       r_base = AllocTemp();
       LoadRefDisp(rl_method.reg, mirror::ArtMethod::DeclaringClassOffset().Int32Value(), r_base);
+      GenReadBarrier(r_base);
     } else {
       // Medium path, static storage base in a different class which requires checks that the other
       // class is initialized
@@ -610,6 +810,7 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
       LoadRefDisp(r_method, mirror::ArtMethod::DexCacheResolvedTypesOffset().Int32Value(), r_base);
       int32_t offset_of_field = ObjArray::OffsetOfElement(field_info.StorageIndex()).Int32Value();
       LoadRefDisp(r_base, offset_of_field, r_base);
+      GenReadBarrier(r_base);
       // r_base now points at static storage (Class*) or NULL if the type is not yet resolved.
       if (!field_info.IsInitialized() &&
           (mir->optimization_flags & MIR_IGNORE_CLINIT_CHECK) == 0) {
@@ -647,6 +848,9 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
       LoadBaseDisp(r_base, field_offset, rl_result.reg, load_size);
     }
     FreeTemp(r_base);
+    if (is_object) {
+      GenReadBarrier(rl_result.reg);
+    }
 
     if (is_long_or_double) {
       StoreValueWide(rl_dest, rl_result);
@@ -705,6 +909,9 @@ void Mir2Lir::GenIGet(MIR* mir, int opt_flags, OpSize size,
       LoadBaseDisp(rl_obj.reg, field_offset, rl_result.reg, load_size);
       MarkPossibleNullPointerException(opt_flags);
     }
+    if (is_object) {
+      GenReadBarrier(rl_result.reg);
+    }
     if (is_long_or_double) {
       StoreValueWide(rl_dest, rl_result);
     } else {
@@ -835,9 +1042,11 @@ void Mir2Lir::GenConstClass(uint32_t type_idx, RegLocation rl_dest) {
       // Add to list for future.
       AddSlowPath(new (arena_) SlowPath(this, branch, cont, type_idx, rl_method, rl_result));
 
+      GenReadBarrier(rl_result.reg);
       StoreValue(rl_dest, rl_result);
      } else {
       // Fast path, we're done - just store result
+      GenReadBarrier(rl_result.reg);
       StoreValue(rl_dest, rl_result);
     }
   }
@@ -847,7 +1056,14 @@ void Mir2Lir::GenConstString(uint32_t string_idx, RegLocation rl_dest) {
   /* NOTE: Most strings should be available at compile time */
   int32_t offset_of_string = mirror::ObjectArray<mirror::String>::OffsetOfElement(string_idx).
                                                                                       Int32Value();
-  if (!cu_->compiler_driver->CanAssumeStringIsPresentInDexCache(
+  uintptr_t direct_string_ptr;
+  if (!SLOW_STRING_PATH && cu_->compiler_driver->CanEmbedStringInCode(
+      *cu_->dex_file, string_idx, &direct_string_ptr)) {
+    // Interned in the boot image, load its address like the classes of the image.
+    RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    LoadConstantNoClobber(rl_result.reg, static_cast<int32_t>(direct_string_ptr));
+    StoreValue(rl_dest, rl_result);
+  } else if (!cu_->compiler_driver->CanAssumeStringIsPresentInDexCache(
       *cu_->dex_file, string_idx) || SLOW_STRING_PATH) {
     // slow path, resolve string if not in dex cache
     FlushAllRegs();
@@ -897,6 +1113,7 @@ void Mir2Lir::GenConstString(uint32_t string_idx, RegLocation rl_dest) {
     }
 
     GenBarrier();
+    GenReadBarrier(TargetReg(kRet0));
     StoreValue(rl_dest, GetReturn(false));
   } else {
     RegLocation rl_method = LoadCurrMethod();
@@ -904,6 +1121,7 @@ void Mir2Lir::GenConstString(uint32_t string_idx, RegLocation rl_dest) {
     RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
     LoadRefDisp(rl_method.reg, mirror::ArtMethod::DexCacheStringsOffset().Int32Value(), res_reg);
     Load32Disp(res_reg, offset_of_string, rl_result.reg);
+    GenReadBarrier(rl_result.reg);
     StoreValue(rl_dest, rl_result);
   }
 }
@@ -1769,9 +1987,7 @@ void Mir2Lir::GenArithOpLong(Instruction::Code opcode, RegLocation rl_dest,
   OpKind first_op = kOpBkpt;
   OpKind second_op = kOpBkpt;
   bool call_out = false;
-  bool check_zero = false;
   ThreadOffset<4> func_offset(-1);
-  int ret_reg = TargetReg(kRet0).GetReg();
 
   switch (opcode) {
     case Instruction::NOT_LONG:
@@ -1815,25 +2031,17 @@ void Mir2Lir::GenArithOpLong(Instruction::Code opcode, RegLocation rl_dest,
         return;
       } else {
         call_out = true;
-        ret_reg = TargetReg(kRet0).GetReg();
         func_offset = QUICK_ENTRYPOINT_OFFSET(4, pLmul);
       }
       break;
     case Instruction::DIV_LONG:
     case Instruction::DIV_LONG_2ADDR:
-      call_out = true;
-      check_zero = true;
-      ret_reg = TargetReg(kRet0).GetReg();
-      func_offset = QUICK_ENTRYPOINT_OFFSET(4, pLdiv);
-      break;
+      GenDivRemLong(opcode, rl_dest, rl_src1, rl_src2, true);
+      return;
     case Instruction::REM_LONG:
     case Instruction::REM_LONG_2ADDR:
-      call_out = true;
-      check_zero = true;
-      func_offset = QUICK_ENTRYPOINT_OFFSET(4, pLmod);
-      /* NOTE - for Arm, result is in kArg2/kArg3 instead of kRet0/kRet1 */
-      ret_reg = (cu_->instruction_set == kThumb2) ? TargetReg(kArg2).GetReg() : TargetReg(kRet0).GetReg();
-      break;
+      GenDivRemLong(opcode, rl_dest, rl_src1, rl_src2, false);
+      return;
     case Instruction::AND_LONG_2ADDR:
     case Instruction::AND_LONG:
       if (cu_->instruction_set == kX86 || cu_->instruction_set == kX86_64) {
@@ -1871,27 +2079,31 @@ void Mir2Lir::GenArithOpLong(Instruction::Code opcode, RegLocation rl_dest,
     GenLong3Addr(first_op, second_op, rl_dest, rl_src1, rl_src2);
   } else {
     FlushAllRegs();   /* Send everything to home location */
-    if (check_zero) {
-      RegStorage r_tmp1 = RegStorage::MakeRegPair(TargetReg(kArg0), TargetReg(kArg1));
-      RegStorage r_tmp2 = RegStorage::MakeRegPair(TargetReg(kArg2), TargetReg(kArg3));
-      LoadValueDirectWideFixed(rl_src2, r_tmp2);
-      RegStorage r_tgt = CallHelperSetup(func_offset);
-      GenDivZeroCheckWide(RegStorage::MakeRegPair(TargetReg(kArg2), TargetReg(kArg3)));
-      LoadValueDirectWideFixed(rl_src1, r_tmp1);
-      // NOTE: callout here is not a safepoint
-      CallHelper(r_tgt, func_offset, false /* not safepoint */);
-    } else {
-      CallRuntimeHelperRegLocationRegLocation(func_offset, rl_src1, rl_src2, false);
-    }
-    // Adjust return regs in to handle case of rem returning kArg2/kArg3
-    if (ret_reg == TargetReg(kRet0).GetReg())
-      rl_result = GetReturnWide(false);
-    else
-      rl_result = GetReturnWideAlt();
+    CallRuntimeHelperRegLocationRegLocation(func_offset, rl_src1, rl_src2, false);
+    rl_result = GetReturnWide(false);
     StoreValueWide(rl_dest, rl_result);
   }
 }
 
+void Mir2Lir::GenDivRemLong(Instruction::Code opcode, RegLocation rl_dest,
+                            RegLocation rl_src1, RegLocation rl_src2, bool is_div) {
+  ThreadOffset<4> func_offset = is_div ? QUICK_ENTRYPOINT_OFFSET(4, pLdiv) :
+      QUICK_ENTRYPOINT_OFFSET(4, pLmod);
+  FlushAllRegs();   /* Send everything to home location */
+  RegStorage r_tmp1 = RegStorage::MakeRegPair(TargetReg(kArg0), TargetReg(kArg1));
+  RegStorage r_tmp2 = RegStorage::MakeRegPair(TargetReg(kArg2), TargetReg(kArg3));
+  LoadValueDirectWideFixed(rl_src2, r_tmp2);
+  RegStorage r_tgt = CallHelperSetup(func_offset);
+  GenDivZeroCheckWide(r_tmp2);
+  LoadValueDirectWideFixed(rl_src1, r_tmp1);
+  // NOTE: callout here is not a safepoint
+  CallHelper(r_tgt, func_offset, false /* not safepoint */);
+  // NOTE - for Arm, the remainder is in kArg2/kArg3 instead of kRet0/kRet1
+  RegLocation rl_result = (!is_div && cu_->instruction_set == kThumb2) ? GetReturnWideAlt() :
+      GetReturnWide(false);
+  StoreValueWide(rl_dest, rl_result);
+}
+
 void Mir2Lir::GenConversionCall(ThreadOffset<4> func_offset,
                                 RegLocation rl_dest, RegLocation rl_src) {
   /*
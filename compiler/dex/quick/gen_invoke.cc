@@ -373,6 +373,11 @@ void Mir2Lir::FlushIns(RegLocation* ArgLocs, RegLocation rl_method) {
     StoreWordDisp(TargetReg(kSp), 0, TargetReg(kArg0));
   }
 
+  if (in_osr_entry_) {
+    LoadOsrVRegs();
+    return;
+  }
+
   if (cu_->num_ins == 0) {
     return;
   }
@@ -446,6 +451,29 @@ void Mir2Lir::FlushIns(RegLocation* ArgLocs, RegLocation rl_method) {
   }
 }
 
+/*
+ * Load all Dalvik registers of an on-stack replacement entry from the interpreter's copy,
+ * passed in kArg1, to their home locations. Each is stored to the frame as well as to the
+ * registers it is promoted to: a value of a vreg promoted to both a core and an fp register
+ * lives in either depending on its type, and a half promoted wide value is used from the frame.
+ */
+void Mir2Lir::LoadOsrVRegs() {
+  RegStorage r_vregs = TargetReg(kArg1);
+  RegStorage r_tmp = TargetReg(kArg2);
+  for (int v_reg = 0; v_reg < cu_->num_dalvik_registers; v_reg++) {
+    PromotionMap* v_map = &promotion_map_[v_reg];
+    int offset = v_reg * sizeof(uint32_t);
+    Load32Disp(r_vregs, offset, r_tmp);
+    Store32Disp(TargetReg(kSp), VRegOffset(v_reg), r_tmp);
+    if (v_map->core_location == kLocPhysReg) {
+      OpRegCopy(RegStorage::Solo32(v_map->core_reg), r_tmp);
+    }
+    if (v_map->fp_location == kLocPhysReg) {
+      Load32Disp(r_vregs, offset, RegStorage::Solo32(v_map->FpReg));
+    }
+  }
+}
+
 /*
  * Bit of a hack here - in the absence of a real scheduling pass,
  * emit the next instruction in static & direct invoke sequences.
@@ -602,18 +630,13 @@ static int NextInterfaceCallInsn(CompilationUnit* cu, CallInfo* info, int state,
                       cg->TargetReg(kInvokeTgt));
       cg->MarkPossibleNullPointerException(info->opt_flags);
       break;
-    case 3:  // Get this->klass_->imtable [use kInvokeTgt, set kInvokeTgt]
-      // NOTE: native pointer.
-      cg->LoadRefDisp(cg->TargetReg(kInvokeTgt), mirror::Class::ImTableOffset().Int32Value(),
-                      cg->TargetReg(kInvokeTgt));
-      break;
-    case 4:  // Get target method [use kInvokeTgt, set kArg0]
-      // NOTE: native pointer.
+    case 3:  // Get target method from the embedded imt [use kInvokeTgt, set kArg0]
       cg->LoadRefDisp(cg->TargetReg(kInvokeTgt),
-                       ObjArray::OffsetOfElement(method_idx % ClassLinker::kImtSize).Int32Value(),
-                       cg->TargetReg(kArg0));
+                      mirror::Class::EmbeddedImTableEntryOffset(
+                          method_idx % ClassLinker::kImtSize).Int32Value(),
+                      cg->TargetReg(kArg0));
       break;
-    case 5:  // Get the compiled code address [use kArg0, set kInvokeTgt]
+    case 4:  // Get the compiled code address [use kArg0, set kInvokeTgt]
       if (cu->instruction_set != kX86 && cu->instruction_set != kX86_64) {
         cg->LoadWordDisp(cg->TargetReg(kArg0),
                          mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value(),
@@ -1160,6 +1183,10 @@ bool Mir2Lir::GenInlinedStringIsEmptyOrLength(CallInfo* info, bool is_empty) {
   GenNullCheck(rl_obj.reg, info->opt_flags);
   Load32Disp(rl_obj.reg, mirror::String::CountOffset().Int32Value(), rl_result.reg);
   MarkPossibleNullPointerException(info->opt_flags);
+  if (mirror::String::kUseStringCompression) {
+    // Strip the compressed flag from the count.
+    OpRegImm(kOpAnd, rl_result.reg, ~mirror::String::kCompressedFlag);
+  }
   if (is_empty) {
     // dst = (dst == 0);
     if (cu_->instruction_set == kThumb2) {
@@ -1311,6 +1338,78 @@ bool Mir2Lir::GenInlinedDoubleCvt(CallInfo* info) {
   return true;
 }
 
+bool Mir2Lir::GenInlinedMinMaxLong(CallInfo* info, bool is_min) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedCeil(CallInfo* info) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedFloor(CallInfo* info) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedRint(CallInfo* info) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedRound(CallInfo* info, bool is_double) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedBitCount(CallInfo* info, bool is_long) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedRotate(CallInfo* info, bool is_long, bool is_left) {
+  if (is_long || (cu_->instruction_set != kThumb2 && cu_->instruction_set != kArm64)) {
+    // TODO - x86 rotates by register need the count in ECX, longs are register pairs.
+    return false;
+  }
+  RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+  RegLocation rl_shift = info->args[1];
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  // Java only uses the low 5 bits of the distance, as the ror instructions do. A rotation to the
+  // left is a rotation to the right by the negated distance.
+  if (rl_shift.is_const) {
+    int distance = mir_graph_->ConstantValue(rl_shift) & 31;
+    if (is_left) {
+      distance = (32 - distance) & 31;
+    }
+    if (distance == 0) {
+      OpRegCopy(rl_result.reg, rl_src.reg);
+    } else {
+      OpRegRegImm(kOpRor, rl_result.reg, rl_src.reg, distance);
+    }
+  } else {
+    rl_shift = LoadValue(rl_shift, kCoreReg);
+    if (is_left) {
+      RegStorage t_reg = AllocTemp();
+      OpRegReg(kOpNeg, t_reg, rl_shift.reg);
+      OpRegRegReg(kOpRor, rl_result.reg, rl_src.reg, t_reg);
+      FreeTemp(t_reg);
+    } else {
+      OpRegRegReg(kOpRor, rl_result.reg, rl_src.reg, rl_shift.reg);
+    }
+  }
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
 /*
  * Fast String.indexOf(I) & (II).  Tests for simple case of char <= 0xFFFF,
  * otherwise bails to standard library code.
@@ -1397,6 +1496,37 @@ bool Mir2Lir::GenInlinedStringCompareTo(CallInfo* info) {
   return true;
 }
 
+/* Fast String.equals(Ljava/lang/Object;)Z. */
+bool Mir2Lir::GenInlinedStringEquals(CallInfo* info) {
+  if (cu_->instruction_set == kMips) {
+    // TODO - add Mips implementation
+    return false;
+  }
+  ClobberCallerSave();
+  LockCallTemps();  // Using fixed registers
+  RegStorage reg_this = TargetReg(kArg0);
+  RegStorage reg_cmp = TargetReg(kArg1);
+
+  RegLocation rl_this = info->args[0];
+  RegLocation rl_cmp = info->args[1];
+  LoadValueDirectFixed(rl_this, reg_this);
+  LoadValueDirectFixed(rl_cmp, reg_cmp);
+  RegStorage r_tgt = (cu_->instruction_set != kX86 && cu_->instruction_set != kX86_64) ?
+      LoadHelper(QUICK_ENTRYPOINT_OFFSET(4, pStringEquals)) : RegStorage::InvalidReg();
+  GenExplicitNullCheck(reg_this, info->opt_flags);
+  // The helper checks the argument for null and for being a string.
+  // NOTE: not a safepoint
+  if (cu_->instruction_set != kX86 && cu_->instruction_set != kX86_64) {
+    OpReg(kOpBlx, r_tgt);
+  } else {
+    OpThreadMem(kOpBlx, QUICK_ENTRYPOINT_OFFSET(4, pStringEquals));
+  }
+  RegLocation rl_return = GetReturn(false);
+  RegLocation rl_dest = InlineTarget(info);
+  StoreValue(rl_dest, rl_return);
+  return true;
+}
+
 bool Mir2Lir::GenInlinedCurrentThread(CallInfo* info) {
   RegLocation rl_dest = InlineTarget(info);
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
@@ -1411,6 +1541,83 @@ bool Mir2Lir::GenInlinedCurrentThread(CallInfo* info) {
   return true;
 }
 
+// The longest System.arraycopy([CI[CII)V copy that is unrolled inline.
+static constexpr int32_t kArrayCopyCharArrayInlineLimit = 8;
+
+/*
+ * Fast System.arraycopy([CI[CII)V for short constant lengths, as used by StringBuilder and the
+ * String constructors. The characters are copied with unrolled loads and stores, any copy that
+ * might throw or overlap goes to the real System.arraycopy().
+ */
+bool Mir2Lir::GenInlinedArrayCopyCharArray(CallInfo* info) {
+  if (cu_->instruction_set != kThumb2) {
+    // TODO - add implementations for other targets
+    return false;
+  }
+  RegLocation rl_length = info->args[4];
+  if (!rl_length.is_const) {
+    return false;
+  }
+  int32_t length = mir_graph_->ConstantValue(rl_length);
+  if (length < 0 || length > kArrayCopyCharArrayInlineLimit) {
+    return false;
+  }
+  int len_offset = mirror::Array::LengthOffset().Int32Value();
+  int data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Int32Value();
+
+  RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+  RegLocation rl_src_pos = LoadValue(info->args[1], kCoreReg);
+  RegLocation rl_dst = LoadValue(info->args[2], kCoreReg);
+  RegLocation rl_dst_pos = LoadValue(info->args[3], kCoreReg);
+  RegStorage reg_tmp = AllocTemp();
+
+  // Any failed check branches to a common launch pad for the slow path.
+  LIR* branches[8];
+  size_t num_branches = 0;
+  branches[num_branches++] = OpCmpImmBranch(kCondEq, rl_src.reg, 0, nullptr);
+  branches[num_branches++] = OpCmpImmBranch(kCondEq, rl_dst.reg, 0, nullptr);
+  // Overlapping copies within the same array need memmove semantics.
+  branches[num_branches++] = OpCmpBranch(kCondEq, rl_src.reg, rl_dst.reg, nullptr);
+  branches[num_branches++] = OpCmpImmBranch(kCondLt, rl_src_pos.reg, 0, nullptr);
+  branches[num_branches++] = OpCmpImmBranch(kCondLt, rl_dst_pos.reg, 0, nullptr);
+  // The positions are not negative, so pos > array.length - length rejects copies past the end
+  // without overflow, including arrays shorter than length.
+  Load32Disp(rl_src.reg, len_offset, reg_tmp);
+  OpRegImm(kOpSub, reg_tmp, length);
+  branches[num_branches++] = OpCmpBranch(kCondGt, rl_src_pos.reg, reg_tmp, nullptr);
+  Load32Disp(rl_dst.reg, len_offset, reg_tmp);
+  OpRegImm(kOpSub, reg_tmp, length);
+  branches[num_branches++] = OpCmpBranch(kCondGt, rl_dst_pos.reg, reg_tmp, nullptr);
+  DCHECK_LE(num_branches, arraysize(branches));
+
+  RegStorage reg_src_ptr = AllocTemp();
+  RegStorage reg_dst_ptr = AllocTemp();
+  OpRegRegReg(kOpAdd, reg_src_ptr, rl_src_pos.reg, rl_src_pos.reg);
+  OpRegReg(kOpAdd, reg_src_ptr, rl_src.reg);
+  OpRegRegReg(kOpAdd, reg_dst_ptr, rl_dst_pos.reg, rl_dst_pos.reg);
+  OpRegReg(kOpAdd, reg_dst_ptr, rl_dst.reg);
+  for (int32_t i = 0; i < length; ++i) {
+    int disp = data_offset + i * sizeof(uint16_t);
+    LoadBaseDisp(reg_src_ptr, disp, reg_tmp, kUnsignedHalf);
+    StoreBaseDisp(reg_dst_ptr, disp, reg_tmp, kUnsignedHalf);
+  }
+  // Char arrays hold no references, so there is no card to mark.
+  FreeTemp(reg_src_ptr);
+  FreeTemp(reg_dst_ptr);
+  FreeTemp(reg_tmp);
+
+  LIR* done = OpUnconditionalBranch(nullptr);
+  LIR* launch_pad = NewLIR0(kPseudoTargetLabel);
+  for (size_t i = 0; i < num_branches; ++i) {
+    branches[i]->target = launch_pad;
+  }
+  LIR* slow_path_branch = OpUnconditionalBranch(nullptr);
+  LIR* resume_tgt = NewLIR0(kPseudoTargetLabel);
+  done->target = resume_tgt;
+  AddIntrinsicSlowPath(info, slow_path_branch, resume_tgt);
+  return true;
+}
+
 bool Mir2Lir::GenInlinedUnsafeGet(CallInfo* info,
                                   bool is_long, bool is_volatile) {
   if (cu_->instruction_set == kMips) {
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "dex/compiler_internals.h"
+#include "driver/compiler_options.h"
 
 namespace art {
 
@@ -28,6 +31,7 @@ namespace art {
 #define MAX_HOIST_DISTANCE 20
 #define LDLD_DISTANCE 4
 #define LD_LATENCY 2
+#define MAX_SCHEDULE_REGION 64
 
 static bool IsDalvikRegisterClobbered(LIR* lir1, LIR* lir2) {
   int reg1Lo = DECODE_ALIAS_INFO_REG(lir1->flags.alias_info);
@@ -38,6 +42,26 @@ static bool IsDalvikRegisterClobbered(LIR* lir1, LIR* lir2) {
   return (reg1Lo == reg2Lo) || (reg1Lo == reg2Hi) || (reg1Hi == reg2Lo);
 }
 
+/*
+ * Whether lir1 and lir2 may access the same memory with at least one of them writing it. Dalvik
+ * register accesses are disambiguated, everything else may alias.
+ */
+static bool IsMemoryDependent(LIR* lir1, LIR* lir2) {
+  uint64_t use1 = lir1->u.m.use_mask & ENCODE_MEM;
+  uint64_t def1 = lir1->u.m.def_mask & ENCODE_MEM;
+  uint64_t use2 = lir2->u.m.use_mask & ENCODE_MEM;
+  uint64_t def2 = lir2->u.m.def_mask & ENCODE_MEM;
+  uint64_t conflict = (def1 & (use2 | def2)) | (def2 & use1);
+  if (conflict == 0) {
+    return false;
+  }
+  if ((use1 | def1 | use2 | def2) == ENCODE_DALVIK_REG) {
+    return (lir1->flags.alias_info == lir2->flags.alias_info) ||
+        IsDalvikRegisterClobbered(lir1, lir2) || IsDalvikRegisterClobbered(lir2, lir1);
+  }
+  return true;
+}
+
 /* Convert a more expensive instruction (ie load) into a move */
 void Mir2Lir::ConvertMemOpIntoMove(LIR* orig_lir, RegStorage dest, RegStorage src) {
   /* Insert a move to replace the load */
@@ -465,6 +489,182 @@ void Mir2Lir::ApplyLoadHoisting(LIR* head_lir, LIR* tail_lir) {
   }
 }
 
+/*
+ * Default result latency, for targets without a machine model: loads take LD_LATENCY cycles,
+ * everything else a single one.
+ */
+int Mir2Lir::GetInstructionLatency(LIR* lir) {
+  return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? LD_LATENCY : 1;
+}
+
+/*
+ * Whether lir has to stay where it is: pseudo LIRs, branches, IT blocks and instructions that
+ * use or define all resources, such as calls and memory barriers. The instruction in front of
+ * a pseudo LIR stays too, as safepoints and exported PCs record the address after it.
+ */
+bool Mir2Lir::IsSchedulingBarrier(LIR* lir) {
+  if (IsPseudoLirOp(lir->opcode)) {
+    return true;
+  }
+  if (lir->flags.is_nop) {
+    return false;
+  }
+  if (lir->flags.use_def_invalid || (lir->u.m.use_mask == ENCODE_ALL) ||
+      (lir->u.m.def_mask == ENCODE_ALL) ||
+      (GetTargetInstFlags(lir->opcode) & (IS_BRANCH | IS_IT))) {
+    return true;
+  }
+  LIR* next_lir = NEXT_LIR(lir);
+  while (next_lir != NULL && next_lir->flags.is_nop && !IsPseudoLirOp(next_lir->opcode)) {
+    next_lir = NEXT_LIR(next_lir);
+  }
+  return (next_lir == NULL) || IsPseudoLirOp(next_lir->opcode);
+}
+
+/*
+ * List-schedule the size contiguous LIRs of region, none of them a barrier, for a single
+ * issue in-order pipeline. Each cycle issues the ready instruction with the longest latency
+ * path to the end of the region, and the original order breaks ties so that a region without
+ * stalls to hide stays as it is.
+ */
+void Mir2Lir::ScheduleRegion(LIR** region, int size) {
+  LIR* insns[MAX_SCHEDULE_REGION];
+  int num_insns = 0;
+  int num_nops = 0;
+  LIR* nops[MAX_SCHEDULE_REGION];
+  for (int i = 0; i < size; i++) {
+    if (region[i]->flags.is_nop) {
+      nops[num_nops++] = region[i];
+    } else {
+      insns[num_insns++] = region[i];
+    }
+  }
+  if (num_insns < 3) {
+    return;
+  }
+
+  // latency[i][j] is the number of cycles insns[j] has to issue after insns[i], or -1.
+  int8_t latency[MAX_SCHEDULE_REGION][MAX_SCHEDULE_REGION];
+  int num_preds[MAX_SCHEDULE_REGION];
+  int height[MAX_SCHEDULE_REGION];
+  int ready_cycle[MAX_SCHEDULE_REGION];
+  bool scheduled[MAX_SCHEDULE_REGION];
+  for (int j = 0; j < num_insns; j++) {
+    num_preds[j] = 0;
+    ready_cycle[j] = 0;
+    scheduled[j] = false;
+    uint64_t use_j = insns[j]->u.m.use_mask & ~ENCODE_MEM;
+    uint64_t def_j = insns[j]->u.m.def_mask & ~ENCODE_MEM;
+    for (int i = 0; i < j; i++) {
+      uint64_t use_i = insns[i]->u.m.use_mask & ~ENCODE_MEM;
+      uint64_t def_i = insns[i]->u.m.def_mask & ~ENCODE_MEM;
+      int lat = -1;
+      if ((def_i & use_j) != 0) {
+        lat = GetInstructionLatency(insns[i]);
+      } else if (((use_i & def_j) | (def_i & def_j)) != 0) {
+        lat = 0;
+      }
+      if (IsMemoryDependent(insns[i], insns[j])) {
+        lat = std::max(lat, 1);
+      }
+      latency[i][j] = lat;
+      if (lat >= 0) {
+        num_preds[j]++;
+      }
+    }
+  }
+  for (int i = num_insns - 1; i >= 0; i--) {
+    height[i] = GetInstructionLatency(insns[i]);
+    for (int j = i + 1; j < num_insns; j++) {
+      if (latency[i][j] >= 0) {
+        height[i] = std::max(height[i], latency[i][j] + height[j]);
+      }
+    }
+  }
+
+  LIR* order[MAX_SCHEDULE_REGION];
+  bool reordered = false;
+  int cycle = 0;
+  for (int n = 0; n < num_insns; n++) {
+    int best = -1;
+    for (int i = 0; i < num_insns; i++) {
+      if (scheduled[i] || num_preds[i] != 0) {
+        continue;
+      }
+      // Prefer instructions that can issue now, then the ones with the most work behind them.
+      if (best == -1) {
+        best = i;
+      } else {
+        bool ready = ready_cycle[i] <= cycle;
+        bool best_ready = ready_cycle[best] <= cycle;
+        if ((ready && !best_ready) ||
+            (ready == best_ready && (ready ? height[i] > height[best]
+                                           : ready_cycle[i] < ready_cycle[best]))) {
+          best = i;
+        }
+      }
+    }
+    DCHECK_NE(best, -1);
+    cycle = std::max(cycle, ready_cycle[best]);
+    scheduled[best] = true;
+    order[n] = insns[best];
+    reordered |= (best != n);
+    for (int j = best + 1; j < num_insns; j++) {
+      if (latency[best][j] >= 0) {
+        num_preds[j]--;
+        ready_cycle[j] = std::max(ready_cycle[j], cycle + latency[best][j]);
+      }
+    }
+    cycle++;
+  }
+  if (!reordered) {
+    return;
+  }
+
+  // Relink the region, with the dead instructions first.
+  LIR* prev_lir = PREV_LIR(region[0]);
+  LIR* next_lir = NEXT_LIR(region[size - 1]);
+  for (int i = 0; i < size; i++) {
+    LIR* lir = (i < num_nops) ? nops[i] : order[i - num_nops];
+    prev_lir->next = lir;
+    lir->prev = prev_lir;
+    prev_lir = lir;
+  }
+  prev_lir->next = next_lir;
+  next_lir->prev = prev_lir;
+}
+
+/*
+ * Reorder the instructions between scheduling barriers so that the results of loads,
+ * multiplies and floating point operations are not needed right after they issue, which
+ * stalls in-order cores.
+ */
+void Mir2Lir::ApplyListScheduling(LIR* head_lir, LIR* tail_lir) {
+  LIR* region[MAX_SCHEDULE_REGION];
+  int size = 0;
+  bool in_it_block = false;
+  LIR* next_lir;
+  for (LIR* this_lir = NEXT_LIR(head_lir); this_lir != tail_lir; this_lir = next_lir) {
+    next_lir = NEXT_LIR(this_lir);
+    // The instructions of an IT block stay with it, up to the barrier that closes it.
+    bool barrier = in_it_block || IsSchedulingBarrier(this_lir);
+    if (IsPseudoLirOp(this_lir->opcode)) {
+      in_it_block = false;
+    } else if (!this_lir->flags.is_nop && (GetTargetInstFlags(this_lir->opcode) & IS_IT)) {
+      in_it_block = true;
+    }
+    if (!barrier) {
+      region[size++] = this_lir;
+    }
+    if (barrier || size == MAX_SCHEDULE_REGION || next_lir == tail_lir) {
+      if (size != 0) {
+        ScheduleRegion(region, size);
+      }
+      size = 0;
+    }
+  }
+}
+
 void Mir2Lir::ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir) {
   if (!(cu_->disable_opt & (1 << kLoadStoreElimination))) {
     ApplyLoadStoreElimination(head_lir, tail_lir);
@@ -472,6 +672,10 @@ void Mir2Lir::ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir) {
   if (!(cu_->disable_opt & (1 << kLoadHoisting))) {
     ApplyLoadHoisting(head_lir, tail_lir);
   }
+  if (!(cu_->disable_opt & (1 << kListScheduling)) &&
+      cu_->compiler_driver->GetCompilerOptions().GetCompilerFilter() >= CompilerOptions::kSpeed) {
+    ApplyListScheduling(head_lir, tail_lir);
+  }
 }
 
 }  // namespace art
@@ -525,6 +525,9 @@ void MipsMir2Lir::GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
     LoadBaseIndexed(reg_ptr, rl_index.reg, rl_result.reg, scale, size);
 
     FreeTemp(reg_ptr);
+    if (size == kReference) {
+      GenReadBarrier(rl_result.reg);
+    }
     StoreValue(rl_dest, rl_result);
   }
 }
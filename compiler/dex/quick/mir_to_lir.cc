@@ -17,6 +17,7 @@
 #include "dex/compiler_internals.h"
 #include "dex/dataflow_iterator-inl.h"
 #include "dex/quick/dex_file_method_inliner.h"
+#include "driver/compiler_options.h"
 #include "mir_to_lir-inl.h"
 #include "object_utils.h"
 #include "thread-inl.h"
@@ -131,6 +132,10 @@ bool Mir2Lir::GenSpecialIGet(MIR* mir, const InlineMethod& special) {
   if (data.is_volatile && !SupportsVolatileLoadStore(size)) {
     return false;
   }
+  if (ref && kUseBakerReadBarrier) {
+    // The frameless getter can't call the read barrier slow path.
+    return false;
+  }
 
   // The inliner doesn't distinguish kDouble or kFloat, use shorty.
   bool double_or_float = cu_->shorty[0] == 'F' || cu_->shorty[0] == 'D';
@@ -468,9 +473,15 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       GenConstClass(vB, rl_dest);
       break;
 
-    case Instruction::FILL_ARRAY_DATA:
-      GenFillArrayData(vB, rl_src[0]);
+    case Instruction::FILL_ARRAY_DATA: {
+      // The payloads built by MIRGraph::CombineArrayInitialization() aren't in the dex code.
+      const uint16_t* table = (mir->meta.fill_array_data != nullptr)
+          ? mir->meta.fill_array_data : cu_->insns + current_dalvik_offset_ + vB;
+      if (!GenInlineFillArrayData(table, rl_src[0], opt_flags)) {
+        GenFillArrayData(table, rl_src[0]);
+      }
       break;
+    }
 
     case Instruction::FILLED_NEW_ARRAY:
       GenFilledNewArray(mir_graph_->NewMemCallInfo(bb, mir, kStatic,
@@ -497,11 +508,13 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       break;
 
     case Instruction::PACKED_SWITCH:
-      GenPackedSwitch(mir, vB, rl_src[0]);
+      GenPackedSwitch(mir, cu_->insns + current_dalvik_offset_ + vB, rl_src[0]);
       break;
 
     case Instruction::SPARSE_SWITCH:
-      GenSparseSwitch(mir, vB, rl_src[0]);
+      if (!GenLoweredSparseSwitch(mir, bb, rl_src[0])) {
+        GenSparseSwitch(mir, vB, rl_src[0]);
+      }
       break;
 
     case Instruction::CMPL_FLOAT:
@@ -944,6 +957,12 @@ void Mir2Lir::HandleExtendedMethodMIR(BasicBlock* bb, MIR* mir) {
     case kMirOpSelect:
       GenSelect(bb, mir);
       break;
+    case kMirOpNullCheck: {
+      // Hoisted out of a loop. There's no memory access to fault, so the check is explicit.
+      RegLocation rl_obj = LoadValue(mir_graph_->GetSrc(mir, 0), kCoreReg);
+      GenExplicitNullCheck(rl_obj.reg, mir->optimization_flags);
+      break;
+    }
     default:
       break;
   }
@@ -957,8 +976,8 @@ void Mir2Lir::GenPrintLabel(MIR* mir) {
   }
 }
 
-// Handle the content in each basic block.
-bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
+// Handle the content in each basic block. prev_bb is the block compiled just before, if any.
+bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb, BasicBlock* prev_bb) {
   if (bb->block_type == kDead) return false;
   current_dalvik_offset_ = bb->start_offset;
   MIR* mir;
@@ -978,8 +997,13 @@ bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
     head_lir = NewLIR0(kPseudoExportedPC);
   }
 
-  // Free temp registers and reset redundant store tracking.
-  ClobberAllRegs();
+  // Free temp registers and reset redundant store tracking. The stores of prev_bb must stay
+  // even when the temps keep their values, as its other successors may need them.
+  if (CanKeepLiveTemps(bb, prev_bb)) {
+    ResetDefTracking();
+  } else {
+    ClobberAllRegs();
+  }
 
   if (bb->block_type == kEntryBlock) {
     ResetRegPool();
@@ -1049,6 +1073,26 @@ bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
   return false;
 }
 
+/*
+ * Whether the temps may keep the values they hold at the end of prev_bb on entry to bb. That
+ * holds when prev_bb is the only way into bb, so that values such as the loop bounds loaded by
+ * a loop header stay in registers in the loop body. Only done when tracking live temps, and
+ * not for kSpace compiles.
+ */
+bool Mir2Lir::CanKeepLiveTemps(BasicBlock* bb, BasicBlock* prev_bb) {
+  if ((cu_->disable_opt & (1 << kTrackLiveTemps)) != 0 ||
+      cu_->compiler_driver->GetCompilerOptions().GetCompilerFilter() == CompilerOptions::kSpace) {
+    return false;
+  }
+  if (prev_bb == NULL || prev_bb->block_type != kDalvikByteCode ||
+      bb->block_type != kDalvikByteCode || bb->catch_entry ||
+      bb->predecessors->Size() != 1 || bb->predecessors->Get(0) != prev_bb->id) {
+    return false;
+  }
+  // On-stack replacement entries branch to their target with nothing live in the temps.
+  return !(cu_->compiler_driver->GetSupportOsr() && IsOsrTarget(bb));
+}
+
 bool Mir2Lir::SpecialMIR2LIR(const InlineMethod& special) {
   cu_->NewTimingSplit("SpecialMIR2LIR");
   // Find the first DalvikByteCode block.
@@ -1088,23 +1132,79 @@ void Mir2Lir::MethodMIR2LIR() {
                                       kArenaAllocLIR));
 
   PreOrderDfsIterator iter(mir_graph_);
+  BasicBlock* prev_bb = NULL;
   BasicBlock* curr_bb = iter.Next();
   BasicBlock* next_bb = iter.Next();
   while (curr_bb != NULL) {
-    MethodBlockCodeGen(curr_bb);
+    MethodBlockCodeGen(curr_bb, prev_bb);
     // If the fall_through block is no longer laid out consecutively, drop in a branch.
     BasicBlock* curr_bb_fall_through = mir_graph_->GetBasicBlock(curr_bb->fall_through);
     if ((curr_bb_fall_through != NULL) && (curr_bb_fall_through != next_bb)) {
       OpUnconditionalBranch(&block_label_list_[curr_bb->fall_through]);
     }
+    prev_bb = curr_bb;
     curr_bb = next_bb;
     do {
       next_bb = iter.Next();
     } while ((next_bb != NULL) && (next_bb->block_type == kDead));
   }
+  if (cu_->compiler_driver->GetSupportOsr() && CanGenOsrEntries()) {
+    GenOsrEntries();
+  }
   HandleSlowPaths();
 }
 
+// Whether the interpreter may branch back to the start of bb, where it can move to the code.
+bool Mir2Lir::IsOsrTarget(BasicBlock* bb) {
+  if (bb->block_type != kDalvikByteCode || bb->catch_entry ||
+      mir_graph_->FindBlock(bb->start_offset) != bb) {
+    return false;
+  }
+  GrowableArray<BasicBlockId>::Iterator iter(bb->predecessors);
+  while (true) {
+    BasicBlock* pred_bb = mir_graph_->GetBasicBlock(iter.Next());
+    if (pred_bb == NULL) {
+      return false;
+    }
+    if (pred_bb->block_type == kDalvikByteCode && pred_bb->start_offset >= bb->start_offset) {
+      return true;
+    }
+  }
+}
+
+/*
+ * An on-stack replacement entry builds the frame as the method entry does, loads the Dalvik
+ * registers the interpreter had at the loop header and branches to it. The state at the
+ * header is one reached through an actual path from the method entry, so whatever the
+ * optimizations assumed there holds.
+ */
+void Mir2Lir::GenOsrEntry(BasicBlock* bb) {
+  current_dalvik_offset_ = bb->start_offset;
+  LIR* entry = NewLIR0(kPseudoTargetLabel);
+  entry->operands[0] = bb->start_offset;
+  osr_entries_.Insert(entry);
+  ResetRegPool();
+  ResetDefTracking();
+  ClobberAllRegs();
+  in_osr_entry_ = true;
+  int start_vreg = cu_->num_dalvik_registers - cu_->num_ins;
+  GenEntrySequence(&mir_graph_->reg_location_[start_vreg],
+                   mir_graph_->reg_location_[mir_graph_->GetMethodSReg()]);
+  in_osr_entry_ = false;
+  OpUnconditionalBranch(&block_label_list_[bb->id]);
+}
+
+void Mir2Lir::GenOsrEntries() {
+  cu_->NewTimingSplit("OsrEntries");
+  // Only the blocks laid out by MethodMIR2LIR have a label.
+  PreOrderDfsIterator iter(mir_graph_);
+  for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
+    if (IsOsrTarget(bb)) {
+      GenOsrEntry(bb);
+    }
+  }
+}
+
 //
 // LIR Slow Path
 //
@@ -26,7 +26,7 @@
 #include "driver/compiler_driver.h"
 #include "leb128.h"
 #include "safe_map.h"
-#include "utils/arena_allocator.h"
+#include "base/arena_allocator.h"
 #include "utils/growable_array.h"
 
 namespace art {
@@ -584,6 +584,9 @@ class Mir2Lir : public Backend {
     void ConvertMemOpIntoMove(LIR* orig_lir, RegStorage dest, RegStorage src);
     void ApplyLoadStoreElimination(LIR* head_lir, LIR* tail_lir);
     void ApplyLoadHoisting(LIR* head_lir, LIR* tail_lir);
+    bool IsSchedulingBarrier(LIR* lir);
+    void ScheduleRegion(LIR** region, int size);
+    void ApplyListScheduling(LIR* head_lir, LIR* tail_lir);
     void ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir);
 
     // Shared by all targets - implemented in ralloc_util.cc
@@ -693,6 +696,10 @@ class Mir2Lir : public Backend {
     void MarkPossibleNullPointerException(int opt_flags);
     void MarkPossibleStackOverflowException();
     void ForceImplicitNullCheck(RegStorage reg, int opt_flags);
+    // With the Baker read barrier, replaces the reference just loaded into reg by its to-space
+    // reference while the concurrent copying collector is marking. Flushes all registers since
+    // the slow path calls into the runtime, which clobbers the caller save registers but reg.
+    void GenReadBarrier(RegStorage reg);
     LIR* GenImmedCheck(ConditionCode c_code, RegStorage reg, int imm_val, ThrowKind kind);
     LIR* GenNullCheck(RegStorage m_reg, int opt_flags);
     LIR* GenExplicitNullCheck(RegStorage m_reg, int opt_flags);
@@ -700,12 +707,26 @@ class Mir2Lir : public Backend {
                              RegLocation rl_src2, LIR* taken, LIR* fall_through);
     void GenCompareZeroAndBranch(Instruction::Code opcode, RegLocation rl_src,
                                  LIR* taken, LIR* fall_through);
+    /*
+     * @brief Lowers a sparse-switch from the statistics of its keys: a packed-switch jump table
+     * if the keys are dense, otherwise a balanced compare tree on the keys.
+     * @returns false if the switch is left to the target's GenSparseSwitch().
+     */
+    bool GenLoweredSparseSwitch(MIR* mir, BasicBlock* bb, RegLocation rl_src);
+    void GenSparseSwitchTree(RegStorage reg, const int32_t* keys, LIR** targets, int low,
+                             int high, LIR* not_found);
     void GenIntToLong(RegLocation rl_dest, RegLocation rl_src);
     void GenIntNarrowing(Instruction::Code opcode, RegLocation rl_dest,
                          RegLocation rl_src);
     void GenNewArray(uint32_t type_idx, RegLocation rl_dest,
                      RegLocation rl_src);
     void GenFilledNewArray(CallInfo* info);
+    /*
+     * @brief Stores a small fill-array-data payload with word stores of immediates, checking
+     * the array inline.
+     * @returns false if the payload is left to the target's GenFillArrayData().
+     */
+    bool GenInlineFillArrayData(const uint16_t* table, RegLocation rl_src, int opt_flags);
     void GenSput(MIR* mir, RegLocation rl_src,
                  bool is_long_or_double, bool is_object);
     void GenSget(MIR* mir, RegLocation rl_dest,
@@ -731,6 +752,9 @@ class Mir2Lir : public Backend {
                           RegLocation rl_src, int lit);
     void GenArithOpLong(Instruction::Code opcode, RegLocation rl_dest,
                         RegLocation rl_src1, RegLocation rl_src2);
+    // Long division and remainder call the runtime, backends may expand some of them inline.
+    virtual void GenDivRemLong(Instruction::Code opcode, RegLocation rl_dest,
+                               RegLocation rl_src1, RegLocation rl_src2, bool is_div);
     void GenConversionCall(ThreadOffset<4> func_offset, RegLocation rl_dest,
                            RegLocation rl_src);
     void GenSuspendTest(int opt_flags);
@@ -787,6 +811,7 @@ class Mir2Lir : public Backend {
     void GenInvoke(CallInfo* info);
     void GenInvokeNoInline(CallInfo* info);
     virtual void FlushIns(RegLocation* ArgLocs, RegLocation rl_method);
+    void LoadOsrVRegs();
     int GenDalvikArgsNoRange(CallInfo* info, int call_state, LIR** pcrLabel,
                              NextCallInsn next_call_insn,
                              const MethodReference& target_method,
@@ -828,8 +853,23 @@ class Mir2Lir : public Backend {
     bool GenInlinedFloatCvt(CallInfo* info);
     bool GenInlinedDoubleCvt(CallInfo* info);
     virtual bool GenInlinedIndexOf(CallInfo* info, bool zero_based);
+    // Math.min/max of longs, floats and doubles, Math.ceil, floor, rint and round, and the bit
+    // counting and rotations of Integer and Long. The backends override the ones their ISA has
+    // instructions for, the defaults return false so that the call goes to the library code.
+    virtual bool GenInlinedMinMaxLong(CallInfo* info, bool is_min);
+    virtual bool GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double);
+    virtual bool GenInlinedCeil(CallInfo* info);
+    virtual bool GenInlinedFloor(CallInfo* info);
+    virtual bool GenInlinedRint(CallInfo* info);
+    virtual bool GenInlinedRound(CallInfo* info, bool is_double);
+    virtual bool GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long);
+    virtual bool GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long);
+    virtual bool GenInlinedBitCount(CallInfo* info, bool is_long);
+    virtual bool GenInlinedRotate(CallInfo* info, bool is_long, bool is_left);
     bool GenInlinedStringCompareTo(CallInfo* info);
+    bool GenInlinedStringEquals(CallInfo* info);
     bool GenInlinedCurrentThread(CallInfo* info);
+    bool GenInlinedArrayCopyCharArray(CallInfo* info);
     bool GenInlinedUnsafeGet(CallInfo* info, bool is_long, bool is_volatile);
     bool GenInlinedUnsafePut(CallInfo* info, bool is_long, bool is_object,
                              bool is_volatile, bool is_ordered);
@@ -924,9 +964,13 @@ class Mir2Lir : public Backend {
     // Shared by all targets - implemented in mir_to_lir.cc.
     void CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list);
     void HandleExtendedMethodMIR(BasicBlock* bb, MIR* mir);
-    bool MethodBlockCodeGen(BasicBlock* bb);
+    bool MethodBlockCodeGen(BasicBlock* bb, BasicBlock* prev_bb);
+    bool CanKeepLiveTemps(BasicBlock* bb, BasicBlock* prev_bb);
     bool SpecialMIR2LIR(const InlineMethod& special);
     void MethodMIR2LIR();
+    bool IsOsrTarget(BasicBlock* bb);
+    void GenOsrEntry(BasicBlock* bb);
+    void GenOsrEntries();
     // Update LIR for verbose listings.
     void UpdateLIROffsets();
 
@@ -1028,6 +1072,8 @@ class Mir2Lir : public Backend {
     virtual std::string BuildInsnString(const char* fmt, LIR* lir, unsigned char* base_addr) = 0;
     virtual uint64_t GetPCUseDefEncoding() = 0;
     virtual uint64_t GetTargetInstFlags(int opcode) = 0;
+    // Cycles before a dependent instruction can use the result of lir, for list scheduling.
+    virtual int GetInstructionLatency(LIR* lir);
     virtual int GetInsnSize(LIR* lir) = 0;
     virtual bool IsUnconditionalBranch(LIR* lir) = 0;
 
@@ -1114,8 +1160,12 @@ class Mir2Lir : public Backend {
     virtual void GenDivZeroCheckWide(RegStorage reg) = 0;
 
     virtual void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) = 0;
+    // Whether GenEntrySequence can also build the frame of the on-stack replacement entries.
+    virtual bool CanGenOsrEntries() {
+      return false;
+    }
     virtual void GenExitSequence() = 0;
-    virtual void GenFillArrayData(DexOffset table_offset, RegLocation rl_src) = 0;
+    virtual void GenFillArrayData(const uint16_t* table, RegLocation rl_src) = 0;
     virtual void GenFusedFPCmpBranch(BasicBlock* bb, MIR* mir, bool gt_bias, bool is_double) = 0;
     virtual void GenFusedLongCmpBranch(BasicBlock* bb, MIR* mir) = 0;
 
@@ -1141,7 +1191,7 @@ class Mir2Lir : public Backend {
                                                int first_bit, int second_bit) = 0;
     virtual void GenNegDouble(RegLocation rl_dest, RegLocation rl_src) = 0;
     virtual void GenNegFloat(RegLocation rl_dest, RegLocation rl_src) = 0;
-    virtual void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src) = 0;
+    virtual void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src) = 0;
     virtual void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src) = 0;
     virtual void GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
                              RegLocation rl_index, RegLocation rl_dest, int scale) = 0;
@@ -1429,6 +1479,13 @@ class Mir2Lir : public Backend {
     LIR* last_lir_insn_;
 
     GrowableArray<LIRSlowPath*> slow_paths_;
+
+    // The labels of the on-stack replacement entries, with the dex PC of their loop header in
+    // operands[0].
+    GrowableArray<LIR*> osr_entries_;
+    // Set while GenEntrySequence builds an on-stack replacement entry, whose Dalvik registers come
+    // from the interpreter instead of the ins.
+    bool in_osr_entry_;
 };  // Class Mir2Lir
 
 }  // namespace art
@@ -596,11 +596,11 @@ void Mir2Lir::ResetDefTracking() {
   for (RegisterInfo* info = core_it.Next(); info != nullptr; info = core_it.Next()) {
     info->ResetDefBody();
   }
-  GrowableArray<RegisterInfo*>::Iterator sp_it(&reg_pool_->core_regs_);
+  GrowableArray<RegisterInfo*>::Iterator sp_it(&reg_pool_->sp_regs_);
   for (RegisterInfo* info = sp_it.Next(); info != nullptr; info = sp_it.Next()) {
     info->ResetDefBody();
   }
-  GrowableArray<RegisterInfo*>::Iterator dp_it(&reg_pool_->core_regs_);
+  GrowableArray<RegisterInfo*>::Iterator dp_it(&reg_pool_->dp_regs_);
   for (RegisterInfo* info = dp_it.Next(); info != nullptr; info = dp_it.Next()) {
     info->ResetDefBody();
   }
@@ -1026,12 +1026,15 @@ void Mir2Lir::DoPromotion() {
    * TUNING: replace with linear scan once we have the ability
    * to describe register live ranges for GC.
    */
+  ScopedArenaAllocator allocator(&cu_->arena_stack);
   RefCounts *core_regs =
-      static_cast<RefCounts*>(arena_->Alloc(sizeof(RefCounts) * num_regs,
-                                            kArenaAllocRegAlloc));
+      static_cast<RefCounts*>(allocator.Alloc(sizeof(RefCounts) * num_regs,
+                                              kArenaAllocRegAlloc));
   RefCounts *FpRegs =
-      static_cast<RefCounts *>(arena_->Alloc(sizeof(RefCounts) * num_regs * 2,
-                                             kArenaAllocRegAlloc));
+      static_cast<RefCounts *>(allocator.Alloc(sizeof(RefCounts) * num_regs * 2,
+                                               kArenaAllocRegAlloc));
+  memset(core_regs, 0, sizeof(RefCounts) * num_regs);
+  memset(FpRegs, 0, sizeof(RefCounts) * num_regs * 2);
   // Set ssa names for original Dalvik registers
   for (int i = 0; i < dalvik_regs; i++) {
     core_regs[i].s_reg = FpRegs[i].s_reg = i;
@@ -60,9 +60,8 @@ void X86Mir2Lir::GenSparseSwitch(MIR* mir, DexOffset table_offset,
  * jmp  r_start_of_method
  * done:
  */
-void X86Mir2Lir::GenPackedSwitch(MIR* mir, DexOffset table_offset,
+void X86Mir2Lir::GenPackedSwitch(MIR* mir, const uint16_t* table,
                                  RegLocation rl_src) {
-  const uint16_t* table = cu_->insns + current_dalvik_offset_ + table_offset;
   if (cu_->verbose) {
     DumpPackedSwitchTable(table);
   }
@@ -129,8 +128,7 @@ void X86Mir2Lir::GenPackedSwitch(MIR* mir, DexOffset table_offset,
  *
  * Total size is 4+(width * size + 1)/2 16-bit code units.
  */
-void X86Mir2Lir::GenFillArrayData(DexOffset table_offset, RegLocation rl_src) {
-  const uint16_t* table = cu_->insns + current_dalvik_offset_ + table_offset;
+void X86Mir2Lir::GenFillArrayData(const uint16_t* table, RegLocation rl_src) {
   // Add the table to the list - we'll process it later
   FillArrayData* tab_rec =
       static_cast<FillArrayData*>(arena_->Alloc(sizeof(FillArrayData), kArenaAllocData));
@@ -195,22 +193,37 @@ void X86Mir2Lir::GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) {
   LockTemp(rs_rX86_ARG1);
   LockTemp(rs_rX86_ARG2);
 
-  /* Build frame, return address already on stack */
-  // TODO: 64 bit.
-  stack_decrement_ = OpRegImm(kOpSub, rs_rX86_SP, frame_size_ - 4);
-
   /*
    * We can safely skip the stack overflow check if we're
    * a leaf *and* our frame size < fudge factor.
    */
   const bool skip_overflow_check = (mir_graph_->MethodIsLeaf() &&
       (static_cast<size_t>(frame_size_) < Thread::kStackOverflowReservedBytes));
+  const bool explicit_overflow_check = Runtime::Current()->ExplicitStackOverflowChecks();
+  if (!skip_overflow_check && !explicit_overflow_check) {
+    // Implicit stack overflow check: test eax, [esp - overflowsize]. This faults if it
+    // reaches into the protected region at the bottom of the stack. It is done before
+    // the frame is built so that the signal handler finds the return address at [esp]
+    // and the method in eax, and it leaves every register unchanged.
+    NewLIR3(kX86Test32RM, rs_rAX.GetReg(), rs_rX86_SP.GetReg(),
+            -static_cast<int>(Thread::kStackOverflowReservedBytes));
+    MarkPossibleStackOverflowException();
+  }
+
+  /* Build frame, return address already on stack */
+  // TODO: 64 bit.
+  LIR* stack_decrement = OpRegImm(kOpSub, rs_rX86_SP, frame_size_ - 4);
+  if (!in_osr_entry_) {
+    // The call frame information describes the method entry only.
+    stack_decrement_ = stack_decrement;
+  }
+
   NewLIR0(kPseudoMethodEntry);
   /* Spill core callee saves */
   SpillCoreRegs();
   /* NOTE: promotion of FP regs currently unsupported, thus no FP spill */
   DCHECK_EQ(num_fp_spills_, 0);
-  if (!skip_overflow_check) {
+  if (!skip_overflow_check && explicit_overflow_check) {
     class StackOverflowSlowPath : public LIRSlowPath {
      public:
       StackOverflowSlowPath(Mir2Lir* m2l, LIR* branch, size_t sp_displace)
@@ -85,6 +85,7 @@ class X86Mir2Lir FINAL : public Mir2Lir {
     std::string BuildInsnString(const char* fmt, LIR* lir, unsigned char* base_addr);
     uint64_t GetPCUseDefEncoding();
     uint64_t GetTargetInstFlags(int opcode);
+    int GetInstructionLatency(LIR* lir);
     int GetInsnSize(LIR* lir);
     bool IsUnconditionalBranch(LIR* lir);
 
@@ -118,6 +119,12 @@ class X86Mir2Lir FINAL : public Mir2Lir {
     bool GenInlinedCas(CallInfo* info, bool is_long, bool is_object);
     bool GenInlinedMinMaxInt(CallInfo* info, bool is_min);
     bool GenInlinedSqrt(CallInfo* info);
+    bool GenInlinedCeil(CallInfo* info);
+    bool GenInlinedFloor(CallInfo* info);
+    bool GenInlinedRint(CallInfo* info);
+    bool GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long);
+    bool GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long);
+    bool GenInlinedBitCount(CallInfo* info, bool is_long);
     bool GenInlinedPeek(CallInfo* info, OpSize size);
     bool GenInlinedPoke(CallInfo* info, OpSize size);
     void GenNegLong(RegLocation rl_dest, RegLocation rl_src);
@@ -135,9 +142,14 @@ class X86Mir2Lir FINAL : public Mir2Lir {
     void GenArrayBoundsCheck(RegStorage index, RegStorage array_base, int32_t len_offset);
     void GenArrayBoundsCheck(int32_t index, RegStorage array_base, int32_t len_offset);
     void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method);
+    // The base of code temp is set up once, by the method entry. The runtime only enters the
+    // 32-bit code.
+    bool CanGenOsrEntries() {
+      return cu_->instruction_set == kX86 && base_of_code_ == nullptr;
+    }
     void GenExitSequence();
     void GenSpecialExitSequence();
-    void GenFillArrayData(DexOffset table_offset, RegLocation rl_src);
+    void GenFillArrayData(const uint16_t* table, RegLocation rl_src);
     void GenFusedFPCmpBranch(BasicBlock* bb, MIR* mir, bool gt_bias, bool is_double);
     void GenFusedLongCmpBranch(BasicBlock* bb, MIR* mir);
     void GenSelect(BasicBlock* bb, MIR* mir);
@@ -147,7 +159,7 @@ class X86Mir2Lir FINAL : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
     void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
 
     /*
@@ -321,6 +333,9 @@ class X86Mir2Lir FINAL : public Mir2Lir {
     std::vector<uint8_t>* ReturnCallFrameInformation();
 
   private:
+    // Rounds the double argument of the invoke to an integral value with roundsd, if the CPU
+    // has SSE4.1.
+    bool GenInlinedRoundsd(CallInfo* info, int rounding_mode);
     void EmitPrefix(const X86EncodingMap* entry);
     void EmitOpcode(const X86EncodingMap* entry);
     void EmitPrefixAndOpcode(const X86EncodingMap* entry);
@@ -431,6 +431,30 @@ bool X86Mir2Lir::GenInlinedSqrt(CallInfo* info) {
   return true;
 }
 
+bool X86Mir2Lir::GenInlinedRoundsd(CallInfo* info, int rounding_mode) {
+  if (!cu_->GetInstructionSetFeatures().HasSse4_1()) {
+    return false;
+  }
+  RegLocation rl_src = info->args[0];
+  RegLocation rl_dest = InlineTargetWide(info);
+  rl_src = LoadValueWide(rl_src, kFPReg);
+  RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+  NewLIR3(kX86RoundsdRRI, rl_result.reg.GetReg(), rl_src.reg.GetReg(), rounding_mode);
+  StoreValueWide(rl_dest, rl_result);
+  return true;
+}
+
+bool X86Mir2Lir::GenInlinedCeil(CallInfo* info) {
+  return GenInlinedRoundsd(info, kRoundUp);
+}
+
+bool X86Mir2Lir::GenInlinedFloor(CallInfo* info) {
+  return GenInlinedRoundsd(info, kRoundDown);
+}
+
+bool X86Mir2Lir::GenInlinedRint(CallInfo* info) {
+  return GenInlinedRoundsd(info, kRoundToNearest);
+}
 
 
 }  // namespace art
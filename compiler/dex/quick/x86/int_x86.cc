@@ -684,7 +684,107 @@ bool X86Mir2Lir::GenInlinedMinMaxInt(CallInfo* info, bool is_min) {
   return true;
 }
 
+bool X86Mir2Lir::GenInlinedNumberOfLeadingZeros(CallInfo* info, bool is_long) {
+  // bsr gives the index of the highest set bit and sets ZF when there is none, the count is
+  // 31 minus the index. A missing bit is given index -1.
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result;
+  RegStorage t_reg = AllocTemp();
+  if (!is_long) {
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    LoadConstant(t_reg, -1);
+    NewLIR2(kX86Bsr32RR, rl_result.reg.GetReg(), rl_src.reg.GetReg());
+    OpCondRegReg(kOpCmov, kCondEq, rl_result.reg, t_reg);
+    OpRegReg(kOpNeg, rl_result.reg, rl_result.reg);
+    OpRegImm(kOpAdd, rl_result.reg, 31);
+  } else {
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    // The low word is read first, the result must not overwrite the high word before its bsr.
+    RegStorage r_index = (rl_result.reg.GetReg() == rl_src.reg.GetHighReg()) ? AllocTemp()
+                                                                             : rl_result.reg;
+    LoadConstant(t_reg, -1);
+    NewLIR2(kX86Bsr32RR, r_index.GetReg(), rl_src.reg.GetLowReg());
+    OpCondRegReg(kOpCmov, kCondEq, r_index, t_reg);
+    OpRegImm(kOpSub, r_index, 32);
+    NewLIR2(kX86Bsr32RR, t_reg.GetReg(), rl_src.reg.GetHighReg());
+    OpCondRegReg(kOpCmov, kCondNe, r_index, t_reg);
+    OpRegReg(kOpNeg, r_index, r_index);
+    OpRegImm(kOpAdd, r_index, 31);
+    if (r_index != rl_result.reg) {
+      OpRegCopy(rl_result.reg, r_index);
+      FreeTemp(r_index);
+    }
+  }
+  FreeTemp(t_reg);
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
+bool X86Mir2Lir::GenInlinedNumberOfTrailingZeros(CallInfo* info, bool is_long) {
+  // bsf gives the index of the lowest set bit, which is the count, and sets ZF when there is none.
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result;
+  RegStorage t_reg = AllocTemp();
+  if (!is_long) {
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    LoadConstant(t_reg, 32);
+    NewLIR2(kX86Bsf32RR, rl_result.reg.GetReg(), rl_src.reg.GetReg());
+    OpCondRegReg(kOpCmov, kCondEq, rl_result.reg, t_reg);
+  } else {
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    // The high word is read first, the result must not overwrite the low word before its bsf.
+    RegStorage r_count = (rl_result.reg.GetReg() == rl_src.reg.GetLowReg()) ? AllocTemp()
+                                                                            : rl_result.reg;
+    LoadConstant(t_reg, 32);
+    NewLIR2(kX86Bsf32RR, r_count.GetReg(), rl_src.reg.GetHighReg());
+    OpCondRegReg(kOpCmov, kCondEq, r_count, t_reg);
+    OpRegImm(kOpAdd, r_count, 32);
+    NewLIR2(kX86Bsf32RR, t_reg.GetReg(), rl_src.reg.GetLowReg());
+    OpCondRegReg(kOpCmov, kCondNe, r_count, t_reg);
+    if (r_count != rl_result.reg) {
+      OpRegCopy(rl_result.reg, r_count);
+      FreeTemp(r_count);
+    }
+  }
+  FreeTemp(t_reg);
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
+bool X86Mir2Lir::GenInlinedBitCount(CallInfo* info, bool is_long) {
+  if (!cu_->GetInstructionSetFeatures().HasPopcnt()) {
+    return false;
+  }
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result;
+  if (!is_long) {
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    NewLIR2(kX86Popcnt32RR, rl_result.reg.GetReg(), rl_src.reg.GetReg());
+  } else {
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    // The high word is counted first, the result may be the low word.
+    RegStorage t_reg = AllocTemp();
+    NewLIR2(kX86Popcnt32RR, t_reg.GetReg(), rl_src.reg.GetHighReg());
+    NewLIR2(kX86Popcnt32RR, rl_result.reg.GetReg(), rl_src.reg.GetLowReg());
+    OpRegReg(kOpAdd, rl_result.reg, t_reg);
+    FreeTemp(t_reg);
+  }
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
 bool X86Mir2Lir::GenInlinedPeek(CallInfo* info, OpSize size) {
+  if (cu_->target64) {
+    // The address is a 64-bit native pointer, which the backend still splits into a register
+    // pair. TODO: inline once wide values live in single 64-bit registers.
+    return false;
+  }
   RegLocation rl_src_address = info->args[0];  // long address
   rl_src_address = NarrowRegLoc(rl_src_address);  // ignore high half in info->args[1]
   RegLocation rl_dest = size == k64 ? InlineTargetWide(info) : InlineTarget(info);
@@ -702,6 +802,10 @@ bool X86Mir2Lir::GenInlinedPeek(CallInfo* info, OpSize size) {
 }
 
 bool X86Mir2Lir::GenInlinedPoke(CallInfo* info, OpSize size) {
+  if (cu_->target64) {
+    // TODO: inline once wide values live in single 64-bit registers, see GenInlinedPeek.
+    return false;
+  }
   RegLocation rl_src_address = info->args[0];  // long address
   rl_src_address = NarrowRegLoc(rl_src_address);  // ignore high half in info->args[1]
   RegLocation rl_src_value = info->args[2];  // [size] value
@@ -757,14 +861,17 @@ bool X86Mir2Lir::GenInlinedCas(CallInfo* info, bool is_long, bool is_object) {
     NewLIR1(kX86Push32R, rs_rSI.GetReg());
     MarkTemp(rs_rSI);
     LockTemp(rs_rSI);
-    const int push_offset = 4 /* push edi */ + 4 /* push esi */;
+    // A push stores a whole register, 8 bytes on x86-64.
+    const int push_size = cu_->target64 ? 8 : 4;
+    const int push_offset = push_size /* push edi */ + push_size /* push esi */;
     int srcObjSp = IsInReg(this, rl_src_obj, rs_rSI) ? 0
-                : (IsInReg(this, rl_src_obj, rs_rDI) ? 4
+                : (IsInReg(this, rl_src_obj, rs_rDI) ? push_size
                 : (SRegOffset(rl_src_obj.s_reg_low) + push_offset));
-    // FIXME: needs 64-bit update.
+    // The reference and the offset are zero-extended by the 32-bit loads, the heap is in the
+    // low 4GiB on x86-64.
     LoadWordDisp(TargetReg(kSp), srcObjSp, rs_rDI);
     int srcOffsetSp = IsInReg(this, rl_src_offset, rs_rSI) ? 0
-                   : (IsInReg(this, rl_src_offset, rs_rDI) ? 4
+                   : (IsInReg(this, rl_src_offset, rs_rDI) ? push_size
                    : (SRegOffset(rl_src_offset.s_reg_low) + push_offset));
     LoadWordDisp(TargetReg(kSp), srcOffsetSp, rs_rSI);
     NewLIR4(kX86LockCmpxchg8bA, rs_rDI.GetReg(), rs_rSI.GetReg(), 0, 0);
@@ -1417,6 +1524,9 @@ void X86Mir2Lir::GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
   }
   rl_result = EvalLoc(rl_dest, reg_class, true);
   LoadBaseIndexedDisp(rl_array.reg, rl_index.reg, scale, data_offset, rl_result.reg, size);
+  if (size == kReference) {
+    GenReadBarrier(rl_result.reg);
+  }
   if ((size == k64) || (size == kDouble)) {
     StoreValueWide(rl_dest, rl_result);
   } else {
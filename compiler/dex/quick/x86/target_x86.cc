@@ -590,8 +590,10 @@ RegStorage X86Mir2Lir::LoadHelper(ThreadOffset<4> offset) {
 }
 
 LIR* X86Mir2Lir::CheckSuspendUsingLoad() {
-  LOG(FATAL) << "Unexpected use of CheckSuspendUsingLoad in x86";
-  return nullptr;
+  // mov eax, fs:[suspend_trigger_]; mov eax, [eax]. The trigger is cleared to request a
+  // suspension, the second load then faults and the signal handler calls the suspend stub.
+  OpRegThreadMem(kOpMov, rs_rAX, Thread::ThreadSuspendTriggerOffset<4>());
+  return Load32Disp(rs_rAX, 0, rs_rAX);
 }
 
 uint64_t X86Mir2Lir::GetTargetInstFlags(int opcode) {
@@ -599,6 +601,47 @@ uint64_t X86Mir2Lir::GetTargetInstFlags(int opcode) {
   return X86Mir2Lir::EncodingMap[opcode].flags;
 }
 
+int X86Mir2Lir::GetInstructionLatency(LIR* lir) {
+  int latency;
+  switch (lir->opcode) {
+    case kX86Imul16RRI: case kX86Imul16RMI: case kX86Imul16RAI:
+    case kX86Imul32RRI: case kX86Imul32RMI: case kX86Imul32RAI:
+    case kX86Imul32RRI8: case kX86Imul32RMI8: case kX86Imul32RAI8:
+    case kX86Imul32RR: case kX86Imul32RM: case kX86Imul32RA:
+    case kX86Mul32DaR: case kX86Mul32DaM: case kX86Mul32DaA:
+    case kX86Imul32DaR: case kX86Imul32DaM: case kX86Imul32DaA:
+      latency = kX86MulLatency;
+      break;
+    case kX86Divmod32DaR: case kX86Divmod32DaM: case kX86Divmod32DaA:
+    case kX86Idivmod32DaR: case kX86Idivmod32DaM: case kX86Idivmod32DaA:
+      latency = kX86DivLatency;
+      break;
+    case kX86AddsdRR: case kX86AddsdRM: case kX86AddsdRA:
+    case kX86AddssRR: case kX86AddssRM: case kX86AddssRA:
+    case kX86SubsdRR: case kX86SubsdRM: case kX86SubsdRA:
+    case kX86SubssRR: case kX86SubssRM: case kX86SubssRA:
+    case kX86Cvtsi2sdRR: case kX86Cvtsi2sdRM: case kX86Cvtsi2sdRA:
+    case kX86Cvtsi2ssRR: case kX86Cvtsi2ssRM: case kX86Cvtsi2ssRA:
+    case kX86Cvtsd2ssRR: case kX86Cvtsd2ssRM: case kX86Cvtsd2ssRA:
+    case kX86Cvtss2sdRR: case kX86Cvtss2sdRM: case kX86Cvtss2sdRA:
+      latency = kX86FpAluLatency;
+      break;
+    case kX86MulsdRR: case kX86MulsdRM: case kX86MulsdRA:
+    case kX86MulssRR: case kX86MulssRM: case kX86MulssRA:
+      latency = kX86FpMulLatency;
+      break;
+    case kX86DivsdRR: case kX86DivsdRM: case kX86DivsdRA:
+    case kX86DivssRR: case kX86DivssRM: case kX86DivssRA:
+    case kX86SqrtsdRR:
+      latency = kX86FpDivLatency;
+      break;
+    default:
+      return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? kX86LoadLatency : kX86AluLatency;
+  }
+  // The memory operand is read first.
+  return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? latency + kX86LoadLatency : latency;
+}
+
 const char* X86Mir2Lir::GetTargetInstName(int opcode) {
   DCHECK(!IsPseudoLirOp(opcode));
   return X86Mir2Lir::EncodingMap[opcode].name;
@@ -379,6 +379,7 @@ enum X86OpCode {
   opcode ## 32 ## reg, opcode ## 32 ## mem, opcode ## 32 ## array
   UnaryOpcode(kX86Test, RI, MI, AI),
   kX86Test32RR,
+  kX86Test32RM,
   UnaryOpcode(kX86Not, R, M, A),
   UnaryOpcode(kX86Neg, R, M, A),
   UnaryOpcode(kX86Mul,  DaR, DaM, DaA),
@@ -423,6 +424,7 @@ enum X86OpCode {
   kX86PsrlqRI,                  // right shift of floating point registers
   kX86PsllqRI,                  // left shift of floating point registers
   kX86SqrtsdRR,                 // sqrt of floating point register
+  kX86RoundsdRRI,               // round double to integral with the SSE4.1 rounding mode given
   kX86Fild32M,                  // push 32-bit integer on x87 stack
   kX86Fild64M,                  // push 64-bit integer on x87 stack
   kX86Fstp32M,                  // pop top x87 fp stack and do 32-bit store
@@ -449,6 +451,9 @@ enum X86OpCode {
   Binary0fOpCode(kX86Movzx16),  // zero-extend 16-bit value
   Binary0fOpCode(kX86Movsx8),   // sign-extend 8-bit value
   Binary0fOpCode(kX86Movsx16),  // sign-extend 16-bit value
+  kX86Bsf32RR,                  // index of the lowest set bit
+  kX86Bsr32RR,                  // index of the highest set bit
+  kX86Popcnt32RR,               // number of set bits
 #undef Binary0fOpCode
   kX86Jcc8, kX86Jcc32,  // jCC rel8/32; lir operands - 0: rel, 1: CC, target assigned
   kX86Jmp8, kX86Jmp32,  // jmp rel8/32; lir operands - 0: rel, target assigned
@@ -500,6 +505,28 @@ enum X86EncodingKind {
   kUnimplemented                           // Encoding used when an instruction isn't yet implemented.
 };
 
+/*
+ * Result latencies in cycles used by the list scheduler. The cores are out of order, so these
+ * only need to be in proportion. An operation that reads memory adds kX86LoadLatency.
+ */
+enum X86Latency {
+  kX86AluLatency = 1,
+  kX86LoadLatency = 4,
+  kX86MulLatency = 3,
+  kX86DivLatency = 24,
+  kX86FpAluLatency = 3,
+  kX86FpMulLatency = 5,
+  kX86FpDivLatency = 20,
+};
+
+// Rounding modes of the immediate of roundsd and roundss.
+enum X86RoundingMode {
+  kRoundToNearest = 0,  // Ties to even.
+  kRoundDown = 1,
+  kRoundUp = 2,
+  kRoundToZero = 3,
+};
+
 /* Struct used to define the EncodingMap positions for each X86 opcode */
 struct X86EncodingMap {
   X86OpCode opcode;      // e.g. kOpAddRI
@@ -142,15 +142,17 @@ bool MIRGraph::FillDefBlockMatrix(BasicBlock* bb) {
 void MIRGraph::ComputeDefBlockMatrix() {
   int num_registers = cu_->num_dalvik_registers;
   /* Allocate num_dalvik_registers bit vector pointers */
+  ScopedArenaAllocator* allocator = temp_scoped_alloc_.get();
   def_block_matrix_ = static_cast<ArenaBitVector**>
-      (arena_->Alloc(sizeof(ArenaBitVector *) * num_registers,
-                     kArenaAllocDFInfo));
+      (allocator->Alloc(sizeof(ArenaBitVector *) * num_registers,
+                        kArenaAllocDFInfo));
   int i;
 
   /* Initialize num_register vectors with num_blocks bits each */
   for (i = 0; i < num_registers; i++) {
     def_block_matrix_[i] =
-        new (arena_) ArenaBitVector(arena_, GetNumBlocks(), false, kBitMapBMatrix);
+        new (allocator) ArenaBitVector(allocator, GetNumBlocks(), false, kBitMapBMatrix);
+    def_block_matrix_[i]->ClearAllBits();
   }
   AllNodesIterator iter(this);
   for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
@@ -487,15 +489,17 @@ bool MIRGraph::ComputeBlockLiveIns(BasicBlock* bb) {
 /* Insert phi nodes to for each variable to the dominance frontiers */
 void MIRGraph::InsertPhiNodes() {
   int dalvik_reg;
+  ScopedArenaAllocator* allocator = temp_scoped_alloc_.get();
   ArenaBitVector* phi_blocks =
-      new (arena_) ArenaBitVector(arena_, GetNumBlocks(), false, kBitMapPhi);
+      new (allocator) ArenaBitVector(allocator, GetNumBlocks(), false, kBitMapPhi);
   ArenaBitVector* tmp_blocks =
-      new (arena_) ArenaBitVector(arena_, GetNumBlocks(), false, kBitMapTmpBlocks);
+      new (allocator) ArenaBitVector(allocator, GetNumBlocks(), false, kBitMapTmpBlocks);
   ArenaBitVector* input_blocks =
-      new (arena_) ArenaBitVector(arena_, GetNumBlocks(), false, kBitMapInputBlocks);
+      new (allocator) ArenaBitVector(allocator, GetNumBlocks(), false, kBitMapInputBlocks);
 
   temp_dalvik_register_v_ =
-      new (arena_) ArenaBitVector(arena_, cu_->num_dalvik_registers, false, kBitMapRegisterV);
+      new (allocator) ArenaBitVector(allocator, cu_->num_dalvik_registers, false,
+                                     kBitMapRegisterV);
 
   RepeatingPostOrderDfsIterator iter(this);
   bool change = false;
@@ -26,12 +26,15 @@
 #include "verified_method.h"
 #include "verifier/method_verifier.h"
 #include "verifier/method_verifier-inl.h"
+#include "verifier/verifier_deps.h"
 
 namespace art {
 
 VerificationResults::VerificationResults(const CompilerOptions* compiler_options)
     : verified_methods_lock_("compiler verified methods lock"),
       verified_methods_(),
+      verifier_deps_lock_("compiler verifier dependencies lock"),
+      verifier_deps_(),
       rejected_classes_lock_("compiler rejected classes lock"),
       rejected_classes_() {
   UNUSED(compiler_options);
@@ -43,11 +46,32 @@ VerificationResults::~VerificationResults() {
     WriterMutexLock mu(self, verified_methods_lock_);
     STLDeleteValues(&verified_methods_);
   }
+  {
+    MutexLock mu(self, verifier_deps_lock_);
+    STLDeleteValues(&verifier_deps_);
+  }
 }
 
 bool VerificationResults::ProcessVerifiedMethod(verifier::MethodVerifier* method_verifier) {
   DCHECK(method_verifier != NULL);
   MethodReference ref = method_verifier->GetMethodReference();
+  {
+    // Methods of a class are verified by the same thread, only the map is shared.
+    ClassReference class_ref(ref.dex_file,
+                             ref.dex_file->GetIndexForClassDef(*method_verifier->GetClassDef()));
+    verifier::VerifierDeps* deps;
+    {
+      MutexLock mu(Thread::Current(), verifier_deps_lock_);
+      auto it = verifier_deps_.find(class_ref);
+      if (it != verifier_deps_.end()) {
+        deps = it->second;
+      } else {
+        deps = new verifier::VerifierDeps;
+        verifier_deps_.Put(class_ref, deps);
+      }
+    }
+    deps->AddMethod(method_verifier);
+  }
   bool compile = IsCandidateForCompilation(ref, method_verifier->GetAccessFlags());
   // TODO: Check also for virtual/interface invokes when DEX-to-DEX supports devirtualization.
   if (!compile && !method_verifier->HasCheckCasts()) {
@@ -83,6 +107,12 @@ const VerifiedMethod* VerificationResults::GetVerifiedMethod(MethodReference ref
   return (it != verified_methods_.end()) ? it->second : nullptr;
 }
 
+const verifier::VerifierDeps* VerificationResults::GetVerifierDeps(ClassReference ref) {
+  MutexLock mu(Thread::Current(), verifier_deps_lock_);
+  auto it = verifier_deps_.find(ref);
+  return (it != verifier_deps_.end()) ? it->second : nullptr;
+}
+
 void VerificationResults::AddRejectedClass(ClassReference ref) {
   {
     WriterMutexLock mu(Thread::Current(), rejected_classes_lock_);
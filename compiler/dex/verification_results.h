@@ -31,6 +31,7 @@ namespace art {
 
 namespace verifier {
 class MethodVerifier;
+class VerifierDeps;
 }  // namespace verifier
 
 class CompilerOptions;
@@ -49,6 +50,11 @@ class VerificationResults {
     const VerifiedMethod* GetVerifiedMethod(MethodReference ref)
         LOCKS_EXCLUDED(verified_methods_lock_);
 
+    // The classes the verification of the class depended on, nullptr if none of its methods
+    // was verified.
+    const verifier::VerifierDeps* GetVerifierDeps(ClassReference ref)
+        LOCKS_EXCLUDED(verifier_deps_lock_);
+
     void AddRejectedClass(ClassReference ref) LOCKS_EXCLUDED(rejected_classes_lock_);
     bool IsClassRejected(ClassReference ref) LOCKS_EXCLUDED(rejected_classes_lock_);
 
@@ -62,6 +68,11 @@ class VerificationResults {
     ReaderWriterMutex verified_methods_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
     VerifiedMethodMap verified_methods_ GUARDED_BY(verified_methods_lock_);
 
+    // Dependencies of the verification of the classes.
+    typedef SafeMap<ClassReference, verifier::VerifierDeps*> VerifierDepsMap;
+    Mutex verifier_deps_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+    VerifierDepsMap verifier_deps_ GUARDED_BY(verifier_deps_lock_);
+
     // Rejected classes.
     ReaderWriterMutex rejected_classes_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
     std::set<ClassReference> rejected_classes_ GUARDED_BY(rejected_classes_lock_);
@@ -18,7 +18,12 @@
 #define ART_COMPILER_DRIVER_COMPILER_DRIVER_INL_H_
 
 #include "compiler_driver.h"
+
+#include <string.h>
+
 #include "dex/compiler_ir.h"
+#include "gc/heap.h"
+#include "gc/space/space.h"
 #include "mirror/art_field.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method.h"
@@ -27,6 +32,7 @@
 #include "mirror/dex_cache.h"
 #include "mirror/dex_cache-inl.h"
 #include "mirror/art_field-inl.h"
+#include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "sirt_ref-inl.h"
 
@@ -106,6 +112,23 @@ inline std::pair<bool, bool> CompilerDriver::IsFastInstanceField(
   return std::make_pair(fast_get, fast_put);
 }
 
+inline bool CompilerDriver::IsSuperClassInReferrersDexCache(mirror::Class* referrer_class,
+                                                             mirror::Class* klass) {
+  // Linking a class resolves its superclass in the dex cache of the class, and a class is only
+  // initialized after its superclass. Follow the superclasses defined in the referrer's dex file.
+  mirror::DexCache* dex_cache = referrer_class->GetDexCache();
+  for (mirror::Class* c = referrer_class; c->GetDexCache() == dex_cache; ) {
+    c = c->GetSuperClass();
+    if (c == nullptr) {
+      break;
+    }
+    if (c == klass) {
+      return true;
+    }
+  }
+  return false;
+}
+
 inline std::pair<bool, bool> CompilerDriver::IsFastStaticField(
     mirror::DexCache* dex_cache, mirror::Class* referrer_class,
     mirror::ArtField* resolved_field, uint16_t field_idx, MemberOffset* field_offset,
@@ -135,23 +158,20 @@ inline std::pair<bool, bool> CompilerDriver::IsFastStaticField(
       } else {
         // Search dex file for localized ssb index, may fail if field's class is a parent
         // of the class mentioned in the dex file and there is no dex cache entry.
-        const DexFile::StringId* string_id =
-            dex_file->FindStringId(FieldHelper(resolved_field).GetDeclaringClassDescriptor());
-        if (string_id != nullptr) {
-          const DexFile::TypeId* type_id =
-             dex_file->FindTypeId(dex_file->GetIndexForStringId(*string_id));
-          if (type_id != nullptr) {
-            // medium path, needs check of static storage base being initialized
-            storage_idx = dex_file->GetIndexForTypeId(*type_id);
-          }
+        const DexFile::TypeId* type_id =
+            dex_file->FindTypeId(FieldHelper(resolved_field).GetDeclaringClassDescriptor());
+        if (type_id != nullptr) {
+          // medium path, needs check of static storage base being initialized
+          storage_idx = dex_file->GetIndexForTypeId(*type_id);
         }
       }
       if (storage_idx != DexFile::kDexNoIndex) {
         *field_offset = resolved_field->GetOffset();
         *storage_index = storage_idx;
         *is_referrers_class = false;
-        *is_initialized = fields_class->IsInitialized() &&
-            CanAssumeTypeIsPresentInDexCache(*dex_file, storage_idx);
+        *is_initialized = IsSuperClassInReferrersDexCache(referrer_class, fields_class) ||
+            (fields_class->IsInitialized() &&
+             CanAssumeTypeIsPresentInDexCache(*dex_file, storage_idx));
         return std::make_pair(true, !resolved_field->IsFinal());
       }
     }
@@ -164,6 +184,44 @@ inline std::pair<bool, bool> CompilerDriver::IsFastStaticField(
   return std::make_pair(false, false);
 }
 
+inline bool CompilerDriver::IsStaticFieldConstant(mirror::ArtField* resolved_field,
+                                                  uint64_t* value) {
+  DCHECK(resolved_field->IsStatic());
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (heap->IsCompilingBoot() || !resolved_field->IsFinal() || resolved_field->IsVolatile()) {
+    return false;
+  }
+  mirror::Class* fields_class = resolved_field->GetDeclaringClass();
+  if (!fields_class->IsInitialized() ||
+      !heap->FindSpaceFromObject(fields_class, false)->IsImageSpace()) {
+    return false;
+  }
+  FieldHelper fh(resolved_field);
+  switch (fh.GetTypeAsPrimitiveType()) {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      *value = resolved_field->Get64(fields_class);
+      return true;
+    case Primitive::kPrimNot: {
+      if (strcmp(fh.GetTypeDescriptor(), "Ljava/lang/String;") != 0) {
+        // Other objects may be mutable or replaced natively, like System.out.
+        return false;
+      }
+      mirror::Object* string = resolved_field->GetObj(fields_class);
+      if (string != nullptr && !heap->FindSpaceFromObject(string, false)->IsImageSpace()) {
+        return false;
+      }
+      *value = reinterpret_cast<uintptr_t>(string);
+      return true;
+    }
+    case Primitive::kPrimVoid:
+      return false;
+    default:
+      *value = resolved_field->Get32(fields_class);
+      return true;
+  }
+}
+
 inline mirror::ArtMethod* CompilerDriver::ResolveMethod(
     ScopedObjectAccess& soa, const SirtRef<mirror::DexCache>& dex_cache,
     const SirtRef<mirror::ClassLoader>& class_loader, const DexCompilationUnit* mUnit,
@@ -226,6 +284,10 @@ inline int CompilerDriver::IsFastInvoke(
   // overridden (ie is final).
   bool can_sharpen_virtual_based_on_type =
       (*invoke_type == kVirtual) && (resolved_method->IsFinal() || methods_class->IsFinal());
+  // Or when the class hierarchy analysis proves that no class overrides it.
+  bool can_sharpen_virtual_based_on_hierarchy =
+      (*invoke_type == kVirtual) && !can_sharpen_virtual_based_on_type &&
+      IsNeverOverridden(resolved_method);
   // For invoke-super, ensure the vtable index will be correct to dispatch in the vtable of
   // the super class.
   bool can_sharpen_super_based_on_type = (*invoke_type == kSuper) &&
@@ -233,7 +295,8 @@ inline int CompilerDriver::IsFastInvoke(
       resolved_method->GetMethodIndex() < methods_class->GetVTable()->GetLength() &&
       (methods_class->GetVTable()->Get(resolved_method->GetMethodIndex()) == resolved_method);
 
-  if (can_sharpen_virtual_based_on_type || can_sharpen_super_based_on_type) {
+  if (can_sharpen_virtual_based_on_type || can_sharpen_virtual_based_on_hierarchy ||
+      can_sharpen_super_based_on_type) {
     // Sharpen a virtual call into a direct call. The method_idx is into referrer's
     // dex cache, check that this resolved method is where we expect it.
     CHECK(target_method->dex_file == mUnit->GetDexFile());
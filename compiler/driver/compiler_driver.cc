@@ -19,13 +19,17 @@
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <sstream>
 #include <vector>
 #include <unistd.h>
 
 #include "base/stl_util.h"
+#include "base/stringprintf.h"
 #include "base/timing_logger.h"
 #include "class_linker.h"
 #include "compiler.h"
+#include "compiler_callbacks.h"
 #include "compiler_driver-inl.h"
 #include "dex_compilation_unit.h"
 #include "dex_file-inl.h"
@@ -33,6 +37,7 @@
 #include "dex/verified_method.h"
 #include "dex/quick/dex_file_method_inliner.h"
 #include "driver/compiler_options.h"
+#include "driver/previous_oat_file.h"
 #include "jni_internal.h"
 #include "object_utils.h"
 #include "runtime.h"
@@ -324,6 +329,14 @@ extern "C" art::CompiledMethod* ArtCompileDEX(art::CompilerDriver& compiler,
                                               jobject class_loader,
                                               const art::DexFile& dex_file);
 
+// The swap file starts with room for the code of a small app.
+static constexpr size_t kSwapInitialSize = 16 * MB;
+
+// Twice as many dedupe set shards as compiler threads, so that they seldom wait on each other.
+static size_t DedupeShardCount(size_t thread_count) {
+  return std::max<size_t>(4u, 2u * thread_count);
+}
+
 CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
                                VerificationResults* verification_results,
                                DexFileToMethodInlinerMap* method_inliner_map,
@@ -331,8 +344,9 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
                                InstructionSet instruction_set,
                                InstructionSetFeatures instruction_set_features,
                                bool image, DescriptorSet* image_classes, size_t thread_count,
-                               bool dump_stats, bool dump_passes, CumulativeLogger* timer,
-                               std::string profile_file)
+                               bool dump_stats, bool dump_passes, bool dump_arena_stats,
+                               CumulativeLogger* timer,
+                               std::string profile_file, int swap_fd)
     : profile_ok_(false), compiler_options_(compiler_options),
       verification_results_(verification_results),
       method_inliner_map_(method_inliner_map),
@@ -342,25 +356,39 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
       freezing_constructor_lock_("freezing constructor lock"),
       compiled_classes_lock_("compiled classes lock"),
       compiled_methods_lock_("compiled method lock"),
+      hierarchy_analysis_lock_("hierarchy analysis lock"),
+      jni_stubs_lock_("JNI stubs lock"),
+      shared_jni_stubs_(0),
+      class_init_failures_lock_("class init failures lock"),
       image_(image),
       image_classes_(image_classes),
       thread_count_(thread_count),
       start_ns_(0),
+      parallel_wall_ns_(0),
       stats_(new AOTCompilationStats),
       dump_stats_(dump_stats),
       dump_passes_(dump_passes),
       timings_logger_(timer),
       compiler_library_(NULL),
       compiler_context_(NULL),
+      arena_pool_(dump_arena_stats),
       compiler_enable_auto_elf_loading_(NULL),
       compiler_get_method_code_addr_(NULL),
       support_boot_image_fixup_(instruction_set != kMips),
+      support_osr_(false),
       cfi_info_(nullptr),
-      dedupe_code_("dedupe code"),
-      dedupe_mapping_table_("dedupe mapping table"),
-      dedupe_vmap_table_("dedupe vmap table"),
-      dedupe_gc_map_("dedupe gc map"),
-      dedupe_cfi_info_("dedupe cfi info") {
+      previous_oat_file_(nullptr),
+      swap_space_((swap_fd == -1) ? nullptr : new SwapSpace(swap_fd, kSwapInitialSize)),
+      dedupe_code_("dedupe code", DedupeShardCount(thread_count),
+                   SwapAllocator<uint8_t>(swap_space_.get())),
+      dedupe_mapping_table_("dedupe mapping table", DedupeShardCount(thread_count),
+                            SwapAllocator<uint8_t>(swap_space_.get())),
+      dedupe_vmap_table_("dedupe vmap table", DedupeShardCount(thread_count),
+                         SwapAllocator<uint8_t>(swap_space_.get())),
+      dedupe_gc_map_("dedupe gc map", DedupeShardCount(thread_count),
+                     SwapAllocator<uint8_t>(swap_space_.get())),
+      dedupe_cfi_info_("dedupe cfi info", DedupeShardCount(thread_count),
+                       SwapAllocator<uint8_t>(swap_space_.get())) {
   DCHECK(compiler_options_ != nullptr);
   DCHECK(verification_results_ != nullptr);
   DCHECK(method_inliner_map_ != nullptr);
@@ -387,23 +415,23 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
   }
 }
 
-std::vector<uint8_t>* CompilerDriver::DeduplicateCode(const std::vector<uint8_t>& code) {
+SwapVector* CompilerDriver::DeduplicateCode(const std::vector<uint8_t>& code) {
   return dedupe_code_.Add(Thread::Current(), code);
 }
 
-std::vector<uint8_t>* CompilerDriver::DeduplicateMappingTable(const std::vector<uint8_t>& code) {
+SwapVector* CompilerDriver::DeduplicateMappingTable(const std::vector<uint8_t>& code) {
   return dedupe_mapping_table_.Add(Thread::Current(), code);
 }
 
-std::vector<uint8_t>* CompilerDriver::DeduplicateVMapTable(const std::vector<uint8_t>& code) {
+SwapVector* CompilerDriver::DeduplicateVMapTable(const std::vector<uint8_t>& code) {
   return dedupe_vmap_table_.Add(Thread::Current(), code);
 }
 
-std::vector<uint8_t>* CompilerDriver::DeduplicateGCMap(const std::vector<uint8_t>& code) {
+SwapVector* CompilerDriver::DeduplicateGCMap(const std::vector<uint8_t>& code) {
   return dedupe_gc_map_.Add(Thread::Current(), code);
 }
 
-std::vector<uint8_t>* CompilerDriver::DeduplicateCFIInfo(const std::vector<uint8_t>* cfi_info) {
+SwapVector* CompilerDriver::DeduplicateCFIInfo(const std::vector<uint8_t>* cfi_info) {
   if (cfi_info == nullptr) {
     return nullptr;
   }
@@ -420,6 +448,10 @@ CompilerDriver::~CompilerDriver() {
     MutexLock mu(self, compiled_methods_lock_);
     STLDeleteValues(&compiled_methods_);
   }
+  {
+    MutexLock mu(self, jni_stubs_lock_);
+    STLDeleteValues(&jni_stubs_);
+  }
   {
     MutexLock mu(self, compiled_methods_lock_);
     STLDeleteElements(&code_to_patch_);
@@ -436,6 +468,10 @@ CompilerDriver::~CompilerDriver() {
   compiler_->UnInit();
 }
 
+void CompilerDriver::SetPreviousOatFile(PreviousOatFile* previous_oat_file) {
+  previous_oat_file_.reset(previous_oat_file);
+}
+
 CompilerTls* CompilerDriver::GetTls() {
   // Lazily create thread-local storage
   CompilerTls* res = static_cast<CompilerTls*>(pthread_getspecific(tls_key_));
@@ -505,6 +541,25 @@ void CompilerDriver::CompileAll(jobject class_loader,
   Compile(class_loader, dex_files, thread_pool.get(), timings);
   if (dump_stats_) {
     stats_->Dump();
+    std::ostringstream worker_times;
+    thread_pool->DumpWorkerTimes(worker_times);
+    LOG(INFO) << "Compiler driver thread pool workers:\n" << worker_times.str();
+    std::ostringstream utilization;
+    DumpThreadUtilization(utilization);
+    LOG(INFO) << utilization.str();
+    std::ostringstream dedupe_stats;
+    DumpDedupeStats(dedupe_stats);
+    LOG(INFO) << dedupe_stats.str();
+    {
+      MutexLock mu(Thread::Current(), jni_stubs_lock_);
+      LOG(INFO) << jni_stubs_.size() << " JNI stubs generated, reused by " << shared_jni_stubs_
+                << " other native methods";
+    }
+    if (image_) {
+      std::ostringstream class_init_failures;
+      DumpClassInitFailures(class_init_failures);
+      LOG(INFO) << class_init_failures.str();
+    }
   }
 }
 
@@ -541,7 +596,6 @@ static DexToDexCompilationLevel GetDexToDexCompilationlevel(
 }
 
 void CompilerDriver::CompileOne(mirror::ArtMethod* method, TimingLogger* timings) {
-  DCHECK(!Runtime::Current()->IsStarted());
   Thread* self = Thread::Current();
   jobject jclass_loader;
   const DexFile* dex_file;
@@ -563,15 +617,18 @@ void CompilerDriver::CompileOne(mirror::ArtMethod* method, TimingLogger* timings
   const DexFile::CodeItem* code_item = dex_file->GetCodeItem(method->GetCodeItemOffset());
   self->TransitionFromRunnableToSuspended(kNative);
 
-  std::vector<const DexFile*> dex_files;
-  dex_files.push_back(dex_file);
-
-  UniquePtr<ThreadPool> thread_pool(new ThreadPool("Compiler driver thread pool", 0U));
-  PreCompile(jclass_loader, dex_files, thread_pool.get(), timings);
-
   // Can we run DEX-to-DEX compiler on this class ?
   DexToDexCompilationLevel dex_to_dex_compilation_level = kDontDexToDexCompile;
-  {
+  // Once started, the method is compiled by the JIT: the class linker resolved, verified and
+  // initialized the class, and the caller verified the method. The DEX-to-DEX compiler is left out
+  // as it would rewrite the mapped dex file in place.
+  if (!Runtime::Current()->IsStarted()) {
+    std::vector<const DexFile*> dex_files;
+    dex_files.push_back(dex_file);
+
+    UniquePtr<ThreadPool> thread_pool(new ThreadPool("Compiler driver thread pool", 0U));
+    PreCompile(jclass_loader, dex_files, thread_pool.get(), timings);
+
     ScopedObjectAccess soa(Thread::Current());
     const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_idx);
     SirtRef<mirror::ClassLoader> class_loader(soa.Self(),
@@ -828,6 +885,30 @@ bool CompilerDriver::CanAssumeStringIsPresentInDexCache(const DexFile& dex_file,
   return result;
 }
 
+bool CompilerDriver::CanEmbedStringInCode(const DexFile& dex_file, uint32_t string_idx,
+                                          uintptr_t* direct_string_ptr) {
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (heap->IsCompilingBoot()) {
+    // The strings of the image being compiled have no address yet, see
+    // CanAssumeStringIsPresentInDexCache.
+    return false;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  SirtRef<mirror::DexCache> dex_cache(soa.Self(), class_linker->FindDexCache(dex_file));
+  // Strings are resolved by interning them, the image intern table is searched first.
+  mirror::String* resolved_string = class_linker->ResolveString(dex_file, string_idx, dex_cache);
+  if (resolved_string == nullptr) {
+    soa.Self()->ClearException();
+    return false;
+  }
+  if (!heap->FindSpaceFromObject(resolved_string, false)->IsImageSpace()) {
+    return false;
+  }
+  *direct_string_ptr = reinterpret_cast<uintptr_t>(resolved_string);
+  return true;
+}
+
 bool CompilerDriver::CanAccessTypeWithoutChecks(uint32_t referrer_idx, const DexFile& dex_file,
                                                 uint32_t type_idx,
                                                 bool* type_known_final, bool* type_known_abstract,
@@ -1081,18 +1162,16 @@ void CompilerDriver::GetCodeAndMethodForDirectCall(InvokeType* type, InvokeType
     if (!method_code_in_boot) {
       use_dex_cache = true;
     } else {
-      bool has_clinit_trampoline =
-          method->IsStatic() && !method->GetDeclaringClass()->IsInitialized();
-      if (has_clinit_trampoline && (method->GetDeclaringClass() != referrer_class)) {
+      mirror::Class* methods_class = method->GetDeclaringClass();
+      bool has_clinit_trampoline = method->IsStatic() && !methods_class->IsInitialized();
+      if (has_clinit_trampoline && methods_class != referrer_class &&
+          !referrer_class->IsSubClass(methods_class)) {
         // Ensure we run the clinit trampoline unless we are invoking a static method in the same
-        // class.
+        // class or in a superclass, which is initialized before the referrer's class.
         use_dex_cache = true;
       }
     }
   }
-  if (method_code_in_boot) {
-    *stats_flags |= kFlagDirectCallToBoot | kFlagDirectMethodToBoot;
-  }
   if (!use_dex_cache && compiling_boot) {
     MethodHelper mh(method);
     if (!IsImageClass(mh.GetDeclaringClassDescriptor())) {
@@ -1155,6 +1234,63 @@ void CompilerDriver::GetCodeAndMethodForDirectCall(InvokeType* type, InvokeType
       }
     }
   }
+  // Only count the calls into the boot image that do not go through the dex cache.
+  if (method_code_in_boot && *direct_code != 0) {
+    *stats_flags |= kFlagDirectCallToBoot;
+  }
+  if (method_code_in_boot && *direct_method != 0) {
+    *stats_flags |= kFlagDirectMethodToBoot;
+  }
+}
+
+bool CompilerDriver::IsNeverOverridden(mirror::ArtMethod* method) {
+  mirror::Class* methods_class = method->GetDeclaringClass();
+  // A package-private method can only be overridden from its runtime package, that is by
+  // classes of the same package and class loader. Only the boot class path is known not to
+  // get new classes once compiled.
+  if ((method->GetAccessFlags() & (kAccPublic | kAccProtected)) != 0 || method->IsAbstract() ||
+      methods_class->GetClassLoader() != nullptr || methods_class->IsInterface()) {
+    return false;
+  }
+  MethodReference ref(methods_class->GetDexCache()->GetDexFile(), method->GetDexMethodIndex());
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, hierarchy_analysis_lock_);
+    HierarchyTable::const_iterator it = never_overridden_methods_.find(ref);
+    if (it != never_overridden_methods_.end()) {
+      return it->second;
+    }
+  }
+
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  const char* methods_class_descriptor = ClassHelper(methods_class).GetDescriptor();
+  uint16_t vtable_index = method->GetMethodIndex();
+  bool never_overridden = true;
+  const std::vector<const DexFile*>& boot_class_path = class_linker->GetBootClassPath();
+  for (size_t i = 0; never_overridden && i != boot_class_path.size(); ++i) {
+    const DexFile* dex_file = boot_class_path[i];
+    for (size_t j = 0; j != dex_file->NumClassDefs(); ++j) {
+      const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(j));
+      if (!mirror::Class::IsInSamePackage(descriptor, methods_class_descriptor)) {
+        continue;
+      }
+      mirror::Class* klass = class_linker->LookupClass(descriptor, nullptr);
+      if (klass == nullptr || !klass->IsResolved()) {
+        // The class may still be loaded, and override the method, at runtime.
+        never_overridden = false;
+        break;
+      }
+      if (klass->IsSubClass(methods_class) &&
+          klass->GetVTable()->Get(vtable_index) != method) {
+        never_overridden = false;
+        break;
+      }
+    }
+  }
+
+  MutexLock mu(self, hierarchy_analysis_lock_);
+  never_overridden_methods_.Overwrite(ref, never_overridden);
+  return never_overridden;
 }
 
 bool CompilerDriver::ComputeInvokeInfo(const DexCompilationUnit* mUnit, const uint32_t dex_pc,
@@ -1221,6 +1357,34 @@ bool CompilerDriver::ComputeInvokeInfo(const DexCompilationUnit* mUnit, const ui
   return result;
 }
 
+bool CompilerDriver::ComputeInvokeSuperInfo(const DexCompilationUnit* mUnit, uint32_t method_idx,
+                                            int* vtable_idx) {
+  ScopedObjectAccess soa(Thread::Current());
+  SirtRef<mirror::DexCache> dex_cache(soa.Self(),
+      mUnit->GetClassLinker()->FindDexCache(*mUnit->GetDexFile()));
+  SirtRef<mirror::ClassLoader> class_loader(soa.Self(),
+      soa.Decode<mirror::ClassLoader*>(mUnit->GetClassLoader()));
+  SirtRef<mirror::ArtMethod> resolved_method(soa.Self(),
+      ResolveMethod(soa, dex_cache, class_loader, mUnit, method_idx, kSuper));
+  mirror::Class* referrer_class = (resolved_method.get() != nullptr)
+      ? ResolveCompilingMethodsClass(soa, dex_cache, class_loader, mUnit) : nullptr;
+  if (referrer_class == nullptr ||
+      !referrer_class->CanAccessResolvedMethod(resolved_method->GetDeclaringClass(),
+                                               resolved_method.get(), dex_cache.get(),
+                                               method_idx)) {
+    return false;
+  }
+  // Same lookup as the runtime, which throws NoSuchMethodError when the super class vtable is
+  // too short.
+  mirror::Class* super_class = referrer_class->GetSuperClass();
+  uint16_t method_index = resolved_method->GetMethodIndex();
+  if (super_class == nullptr || method_index >= super_class->GetVTable()->GetLength()) {
+    return false;
+  }
+  *vtable_idx = method_index;
+  return true;
+}
+
 const VerifiedMethod* CompilerDriver::GetVerifiedMethod(const DexFile* dex_file,
                                                         uint32_t method_idx) const {
   MethodReference ref(dex_file, method_idx);
@@ -1317,6 +1481,7 @@ class ParallelCompilationManager {
                              const DexFile* dex_file,
                              ThreadPool* thread_pool)
     : index_(0),
+      order_(nullptr),
       class_linker_(class_linker),
       class_loader_(class_loader),
       compiler_(compiler),
@@ -1348,9 +1513,14 @@ class ParallelCompilationManager {
     CHECK_GT(work_units, 0U);
 
     index_ = begin;
+    const uint64_t start_ns = NanoTime();
+    std::vector<uint64_t> busy_ns(work_units, 0u);
+    std::vector<Task*> tasks;
+    tasks.reserve(work_units);
     for (size_t i = 0; i < work_units; ++i) {
-      thread_pool_->AddTask(self, new ForAllClosure(this, end, callback));
+      tasks.push_back(new ForAllClosure(this, end, callback, &busy_ns[i]));
     }
+    thread_pool_->AddTasks(self, tasks);
     thread_pool_->StartWorkers(self);
 
     // Ensure we're suspended while we're blocked waiting for the other threads to finish (worker
@@ -1359,6 +1529,16 @@ class ParallelCompilationManager {
 
     // Wait for all the worker threads to finish.
     thread_pool_->Wait(self, true, false);
+    GetCompiler()->RecordParallelPhase(NanoTime() - start_ns, busy_ns);
+  }
+
+  // Like ForAll, but calls back with the indexes in the given order. The indexes are handed out
+  // to the threads one at a time, so the threads done with the first, most expensive, indexes
+  // share the remaining ones.
+  void ForAllInOrder(const std::vector<size_t>& order, Callback callback, size_t work_units) {
+    order_ = &order;
+    ForAll(0, order.size(), callback, work_units);
+    order_ = nullptr;
   }
 
   size_t NextIndex() {
@@ -1368,20 +1548,25 @@ class ParallelCompilationManager {
  private:
   class ForAllClosure : public Task {
    public:
-    ForAllClosure(ParallelCompilationManager* manager, size_t end, Callback* callback)
+    ForAllClosure(ParallelCompilationManager* manager, size_t end, Callback* callback,
+                  uint64_t* busy_ns)
         : manager_(manager),
           end_(end),
-          callback_(callback) {}
+          callback_(callback),
+          busy_ns_(busy_ns) {}
 
     virtual void Run(Thread* self) {
+      const uint64_t start_ns = NanoTime();
+      const std::vector<size_t>* order = manager_->order_;
       while (true) {
         const size_t index = manager_->NextIndex();
         if (UNLIKELY(index >= end_)) {
           break;
         }
-        callback_(manager_, index);
+        callback_(manager_, (order != nullptr) ? (*order)[index] : index);
         self->AssertNoPendingException();
       }
+      *busy_ns_ = NanoTime() - start_ns;
     }
 
     virtual void Finalize() {
@@ -1392,9 +1577,11 @@ class ParallelCompilationManager {
     ParallelCompilationManager* const manager_;
     const size_t end_;
     Callback* const callback_;
+    uint64_t* const busy_ns_;
   };
 
   AtomicInteger index_;
+  const std::vector<size_t>* order_;
   ClassLinker* const class_linker_;
   const jobject class_loader_;
   CompilerDriver* const compiler_;
@@ -1653,7 +1840,16 @@ void CompilerDriver::VerifyDexFile(jobject class_loader, const DexFile& dex_file
   timings->NewSplit("Verify Dex File");
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   ParallelCompilationManager context(class_linker, class_loader, this, &dex_file, thread_pool);
+  // Let the workers help with the methods of the huge classes once they run out of classes.
+  CompilerCallbacks* callbacks = Runtime::Current()->GetCompilerCallbacks();
+  bool parallel_methods = callbacks != nullptr && thread_pool->GetThreadCount() > 0;
+  if (parallel_methods) {
+    callbacks->SetVerificationThreadPool(thread_pool);
+  }
   context.ForAll(0, dex_file.NumClassDefs(), VerifyClass, thread_count_);
+  if (parallel_methods) {
+    callbacks->SetVerificationThreadPool(nullptr);
+  }
 }
 
 static void InitializeClass(const ParallelCompilationManager* manager, size_t class_def_index)
@@ -1723,6 +1919,12 @@ static void InitializeClass(const ParallelCompilationManager* manager, size_t cl
               mirror::Throwable* exception = soa.Self()->GetException(&throw_location);
               VLOG(compiler) << "Initialization of " << descriptor << " aborted because of "
                   << exception->Dump();
+              std::string reason(PrettyTypeOf(exception));
+              mirror::String* message = exception->GetDetailMessage();
+              if (message != nullptr) {
+                reason += ": " + message->ToModifiedUtf8();
+              }
+              manager->GetCompiler()->RecordClassInitFailure(descriptor, reason);
               soa.Self()->ClearException();
               transaction.Abort();
               CHECK_EQ(old_status, klass->GetStatus()) << "Previous class status not restored";
@@ -1852,12 +2054,158 @@ void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, siz
   DCHECK(!it.HasNext());
 }
 
+// The estimated compilation cost of a class: the size of the code of its methods, with a
+// small cost for the stubs of the native and abstract methods.
+static size_t EstimateClassCompilationCost(const DexFile& dex_file,
+                                           const DexFile::ClassDef& class_def) {
+  const byte* class_data = dex_file.GetClassData(class_def);
+  if (class_data == NULL) {
+    return 0u;
+  }
+  static constexpr size_t kStubCost = 16u;
+  size_t cost = 0u;
+  ClassDataItemIterator it(dex_file, class_data);
+  while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+    it.Next();
+  }
+  while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+    const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+    cost += (code_item != NULL) ? code_item->insns_size_in_code_units_ : kStubCost;
+    it.Next();
+  }
+  return cost;
+}
+
+struct ClassCompilationCost {
+  size_t class_def_index;
+  size_t cost;
+};
+
+struct ClassCompilationCostGreater {
+  bool operator()(const ClassCompilationCost& lhs, const ClassCompilationCost& rhs) const {
+    return lhs.cost > rhs.cost;
+  }
+};
+
+// Returns the class def indexes of the dex file, the most expensive classes to compile first.
+// Starting with the largest classes keeps a huge method from being compiled alone at the end,
+// while the other threads are idle.
+static std::vector<size_t> GetClassDefsByDecreasingCost(const DexFile& dex_file) {
+  std::vector<ClassCompilationCost> costs(dex_file.NumClassDefs());
+  for (size_t i = 0; i != costs.size(); ++i) {
+    costs[i].class_def_index = i;
+    costs[i].cost = EstimateClassCompilationCost(dex_file, dex_file.GetClassDef(i));
+  }
+  std::stable_sort(costs.begin(), costs.end(), ClassCompilationCostGreater());
+  std::vector<size_t> order;
+  order.reserve(costs.size());
+  for (const ClassCompilationCost& class_cost : costs) {
+    order.push_back(class_cost.class_def_index);
+  }
+  return order;
+}
+
 void CompilerDriver::CompileDexFile(jobject class_loader, const DexFile& dex_file,
                                     ThreadPool* thread_pool, TimingLogger* timings) {
   timings->NewSplit("Compile Dex File");
   ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
                                      &dex_file, thread_pool);
-  context.ForAll(0, dex_file.NumClassDefs(), CompilerDriver::CompileClass, thread_count_);
+  if (thread_count_ == 1) {
+    // Keep the class def order, there is no load to balance.
+    context.ForAll(0, dex_file.NumClassDefs(), CompilerDriver::CompileClass, thread_count_);
+  } else {
+    std::vector<size_t> order = GetClassDefsByDecreasingCost(dex_file);
+    context.ForAllInOrder(order, CompilerDriver::CompileClass, thread_count_);
+  }
+}
+
+void CompilerDriver::RecordParallelPhase(uint64_t wall_ns, const std::vector<uint64_t>& busy_ns) {
+  parallel_wall_ns_ += wall_ns;
+  if (parallel_busy_ns_.size() < busy_ns.size()) {
+    parallel_busy_ns_.resize(busy_ns.size(), 0u);
+  }
+  for (size_t i = 0; i != busy_ns.size(); ++i) {
+    parallel_busy_ns_[i] += busy_ns[i];
+  }
+}
+
+void CompilerDriver::DumpDedupeStats(std::ostream& os) const {
+  dedupe_code_.DumpStats(os);
+  dedupe_mapping_table_.DumpStats(os);
+  dedupe_vmap_table_.DumpStats(os);
+  dedupe_gc_map_.DumpStats(os);
+  dedupe_cfi_info_.DumpStats(os);
+}
+
+void CompilerDriver::RecordClassInitFailure(const char* descriptor, const std::string& reason) {
+  MutexLock mu(Thread::Current(), class_init_failures_lock_);
+  class_init_failures_.Overwrite(descriptor, reason);
+}
+
+void CompilerDriver::DumpClassInitFailures(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), class_init_failures_lock_);
+  // Count the classes by reason first, the natives the initializers need show up there.
+  SafeMap<std::string, size_t> reason_counts;
+  for (const auto& entry : class_init_failures_) {
+    auto it = reason_counts.find(entry.second);
+    if (it == reason_counts.end()) {
+      reason_counts.Put(entry.second, 1u);
+    } else {
+      ++it->second;
+    }
+  }
+  os << class_init_failures_.size() << " image classes not initialized at compile time:\n";
+  for (const auto& entry : reason_counts) {
+    os << "  " << entry.second << " x " << entry.first << "\n";
+  }
+  for (const auto& entry : class_init_failures_) {
+    os << "  " << PrettyDescriptor(entry.first) << ": " << entry.second << "\n";
+  }
+}
+
+void CompilerDriver::DumpThreadUtilization(std::ostream& os) const {
+  os << "Compiler threads utilization over " << PrettyDuration(parallel_wall_ns_)
+     << " of parallel phases:\n";
+  for (size_t i = 0; i != parallel_busy_ns_.size(); ++i) {
+    uint64_t percent = (parallel_wall_ns_ != 0u) ? parallel_busy_ns_[i] * 100 / parallel_wall_ns_
+                                                 : 0u;
+    os << "  thread " << i << ": busy " << PrettyDuration(parallel_busy_ns_[i])
+       << " (" << percent << "%)\n";
+  }
+}
+
+size_t CompilerDriver::GetCompiledMethodCount() const {
+  MutexLock mu(Thread::Current(), compiled_methods_lock_);
+  return compiled_methods_.size();
+}
+
+CompiledMethod* CompilerDriver::CompileJniStub(uint32_t access_flags, uint32_t method_idx,
+                                               const DexFile& dex_file) {
+  if (compiler_->IsPortable()) {
+    // Portable stubs are ELF objects with a symbol named after their method.
+    return compiler_->JniCompile(access_flags, method_idx, dex_file);
+  }
+  // Besides the instruction set, a Quick stub only depends on the shorty and these flags.
+  const uint32_t kStubAccessFlags =
+      kAccStatic | kAccSynchronized | kAccFastNative | kAccCriticalNative;
+  std::string key(dex_file.GetMethodShorty(dex_file.GetMethodId(method_idx)));
+  key += StringPrintf(":%x", access_flags & kStubAccessFlags);
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, jni_stubs_lock_);
+    SafeMap<std::string, CompiledMethod*>::const_iterator it = jni_stubs_.find(key);
+    if (it != jni_stubs_.end()) {
+      ++shared_jni_stubs_;
+      return new CompiledMethod(*it->second);
+    }
+  }
+  // Another thread may generate the same stub meanwhile, the first one stays.
+  CompiledMethod* compiled_method = compiler_->JniCompile(access_flags, method_idx, dex_file);
+  MutexLock mu(self, jni_stubs_lock_);
+  if (jni_stubs_.find(key) == jni_stubs_.end()) {
+    jni_stubs_.Put(key, new CompiledMethod(*compiled_method));
+  }
+  return compiled_method;
 }
 
 void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t access_flags,
@@ -1874,13 +2222,27 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
         (instruction_set_ == kX86_64 || instruction_set_ == kArm64)) {
       // Leaving this empty will trigger the generic JNI version
     } else {
-      compiled_method = compiler_->JniCompile(access_flags, method_idx, dex_file);
+      // Annotated methods get the reduced stubs, the class linker sets the same flags.
+      access_flags |= dex_file.GetNativeMethodOptimizationFlags(
+          dex_file.GetClassDef(class_def_idx), method_idx, access_flags);
+      compiled_method = CompileJniStub(access_flags, method_idx, dex_file);
       CHECK(compiled_method != NULL);
     }
   } else if ((access_flags & kAccAbstract) != 0) {
   } else {
     MethodReference method_ref(&dex_file, method_idx);
     bool compile = verification_results_->IsCandidateForCompilation(method_ref, access_flags);
+    // With a profile only the hot methods are compiled, the others are left to the interpreter.
+    if (compile && profile_ok_) {
+      compile = !SkipCompilation(PrettyMethod(method_idx, dex_file));
+    }
+    // The call frame information of the previous compilation is not kept in its oat file.
+    if (compile && previous_oat_file_.get() != nullptr && cfi_info_.get() == nullptr) {
+      compiled_method = previous_oat_file_->FindCompiledMethod(this, dex_file, class_def_idx,
+                                                               method_idx, code_item,
+                                                               access_flags);
+      compile = (compiled_method == nullptr);
+    }
     if (compile) {
       // NOTE: if compiler declines to compile this method, it will return NULL.
       compiled_method = compiler_->Compile(code_item, access_flags, invoke_type, class_def_idx,
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "base/arena_allocator.h"
 #include "base/mutex.h"
 #include "base/timing_logger.h"
 #include "class_reference.h"
@@ -36,8 +37,8 @@
 #include "runtime.h"
 #include "safe_map.h"
 #include "thread_pool.h"
-#include "utils/arena_allocator.h"
 #include "utils/dedupe_set.h"
+#include "utils/swap_space.h"
 
 namespace art {
 
@@ -51,6 +52,7 @@ class DexFileToMethodInlinerMap;
 struct InlineIGetIPutData;
 class OatWriter;
 class ParallelCompilationManager;
+class PreviousOatFile;
 class ScopedObjectAccess;
 template<class T> class SirtRef;
 class TimingLogger;
@@ -77,15 +79,20 @@ enum DexToDexCompilationLevel {
 // Thread-local storage compiler worker threads
 class CompilerTls {
   public:
-    CompilerTls() : llvm_info_(NULL) {}
+    CompilerTls() : llvm_info_(NULL), llvm_compilation_unit_(NULL) {}
     ~CompilerTls() {}
 
     void* GetLLVMInfo() { return llvm_info_; }
 
     void SetLLVMInfo(void* llvm_info) { llvm_info_ = llvm_info; }
 
+    void* GetLlvmCompilationUnit() { return llvm_compilation_unit_; }
+
+    void SetLlvmCompilationUnit(void* cunit) { llvm_compilation_unit_ = cunit; }
+
   private:
     void* llvm_info_;
+    void* llvm_compilation_unit_;
 };
 
 class CompilerDriver {
@@ -105,8 +112,8 @@ class CompilerDriver {
                           InstructionSetFeatures instruction_set_features,
                           bool image, DescriptorSet* image_classes,
                           size_t thread_count, bool dump_stats, bool dump_passes,
-                          CumulativeLogger* timer,
-                          std::string profile_file = "");
+                          bool dump_arena_stats, CumulativeLogger* timer,
+                          std::string profile_file = "", int swap_fd = -1);
 
   ~CompilerDriver();
 
@@ -146,6 +153,13 @@ class CompilerDriver {
     return profile_ok_;
   }
 
+  // Returns the profile of the method: its hot dex pcs and the receiver classes of its call
+  // sites. Returns nullptr if there is no profile or the method isn't in it.
+  const ProfileData* GetProfileData(const std::string& method_name) const {
+    auto it = profile_map_.find(method_name);
+    return it != profile_map_.end() ? &it->second : nullptr;
+  }
+
   // Are we compiling and creating an image file?
   bool IsImage() const {
     return image_;
@@ -212,6 +226,12 @@ class CompilerDriver {
                           bool* is_type_initialized, bool* use_direct_type_ptr,
                           uintptr_t* direct_type_ptr, bool* out_is_finalizable);
 
+  // Can the code load the string directly from its address? True when compiling against the boot
+  // image and the string is interned in the image, which the runtime resolves the string to.
+  bool CanEmbedStringInCode(const DexFile& dex_file, uint32_t string_idx,
+                            uintptr_t* direct_string_ptr)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   // Get the DexCache for the
   mirror::DexCache* GetDexCache(const DexCompilationUnit* mUnit)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -256,6 +276,18 @@ class CompilerDriver {
       uint32_t* storage_index, bool* is_referrers_class, bool* is_initialized)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Can the code use the value of the static field instead of loading it? True for the final
+  // fields of the classes initialized in the boot image when compiling against the image, their
+  // clinit has run and won't run again. Only primitives and the Strings of the image qualify, a
+  // String is returned as its address.
+  bool IsStaticFieldConstant(mirror::ArtField* resolved_field, uint64_t* value)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Is klass a superclass of referrer_class which is resolved in the referrer's dex cache? The
+  // referrer's code can then assume klass is initialized and find it without a null check.
+  bool IsSuperClassInReferrersDexCache(mirror::Class* referrer_class, mirror::Class* klass)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Resolve a method. Returns nullptr on failure, including incompatible class change.
   mirror::ArtMethod* ResolveMethod(
       ScopedObjectAccess& soa, const SirtRef<mirror::DexCache>& dex_cache,
@@ -312,6 +344,12 @@ class CompilerDriver {
                          uintptr_t* direct_code, uintptr_t* direct_method)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
+  // Can an invoke-super of method_idx dispatch through the vtable of the super class of the
+  // compiling method's class? Computes the vtable index.
+  bool ComputeInvokeSuperInfo(const DexCompilationUnit* mUnit, uint32_t method_idx,
+                              int* vtable_idx)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   const VerifiedMethod* GetVerifiedMethod(const DexFile* dex_file, uint32_t method_idx) const;
   bool IsSafeCast(const DexCompilationUnit* mUnit, uint32_t dex_pc);
 
@@ -359,9 +397,30 @@ class CompilerDriver {
     support_boot_image_fixup_ = support_boot_image_fixup;
   }
 
+  // Whether the code has entries at the loop headers for on-stack replacement from the
+  // interpreter, as the JIT needs.
+  bool GetSupportOsr() const {
+    return support_osr_;
+  }
+
+  void SetSupportOsr(bool support_osr) {
+    support_osr_ = support_osr;
+  }
+
   ArenaPool* GetArenaPool() {
     return &arena_pool_;
   }
+  const ArenaPool* GetArenaPool() const {
+    return &arena_pool_;
+  }
+
+  // Reuses the code of the methods that did not change since the compilation of
+  // previous_oat_file, instead of compiling them again. Takes ownership of previous_oat_file.
+  void SetPreviousOatFile(PreviousOatFile* previous_oat_file);
+
+  const PreviousOatFile* GetPreviousOatFile() const {
+    return previous_oat_file_.get();
+  }
 
   bool WriteElf(const std::string& android_root,
                 bool is_host,
@@ -387,6 +446,36 @@ class CompilerDriver {
     return thread_count_;
   }
 
+  // Accounts a phase run by the compiler threads: its wall time, and the time each thread spent
+  // working. Called by the thread starting the phase, once the phase is done.
+  void RecordParallelPhase(uint64_t wall_ns, const std::vector<uint64_t>& busy_ns);
+
+  // Dumps how much of the parallel phases each compiler thread spent working.
+  void DumpThreadUtilization(std::ostream& os) const;
+
+  // The total wall time of the parallel phases, and the time each thread spent working in them.
+  uint64_t GetParallelWallNs() const {
+    return parallel_wall_ns_;
+  }
+  const std::vector<uint64_t>& GetParallelBusyNs() const {
+    return parallel_busy_ns_;
+  }
+
+  // The number of methods and JNI stubs compiled or reused.
+  size_t GetCompiledMethodCount() const LOCKS_EXCLUDED(compiled_methods_lock_);
+
+  // Dumps how many of the compiled code and tables were duplicates.
+  void DumpDedupeStats(std::ostream& os) const;
+
+  // Records why the static initializer of an image class could not run at compile time, so that
+  // the class is left to initialize in every process.
+  void RecordClassInitFailure(const char* descriptor, const std::string& reason)
+      LOCKS_EXCLUDED(class_init_failures_lock_);
+
+  // Dumps the image classes that could not be initialized at compile time, and why.
+  void DumpClassInitFailures(std::ostream& os) const
+      LOCKS_EXCLUDED(class_init_failures_lock_);
+
   class CallPatchInformation;
   class TypePatchInformation;
 
@@ -581,11 +670,11 @@ class CompilerDriver {
   void RecordClassStatus(ClassReference ref, mirror::Class::Status status)
       LOCKS_EXCLUDED(compiled_classes_lock_);
 
-  std::vector<uint8_t>* DeduplicateCode(const std::vector<uint8_t>& code);
-  std::vector<uint8_t>* DeduplicateMappingTable(const std::vector<uint8_t>& code);
-  std::vector<uint8_t>* DeduplicateVMapTable(const std::vector<uint8_t>& code);
-  std::vector<uint8_t>* DeduplicateGCMap(const std::vector<uint8_t>& code);
-  std::vector<uint8_t>* DeduplicateCFIInfo(const std::vector<uint8_t>* cfi_info);
+  SwapVector* DeduplicateCode(const std::vector<uint8_t>& code);
+  SwapVector* DeduplicateMappingTable(const std::vector<uint8_t>& code);
+  SwapVector* DeduplicateVMapTable(const std::vector<uint8_t>& code);
+  SwapVector* DeduplicateGCMap(const std::vector<uint8_t>& code);
+  SwapVector* DeduplicateCFIInfo(const std::vector<uint8_t>* cfi_info);
 
   /*
    * @brief return the pointer to the Call Frame Information.
@@ -639,6 +728,13 @@ class CompilerDriver {
 
   void LoadImageClasses(TimingLogger* timings);
 
+  // Class hierarchy analysis: returns whether no class can override `method`, which is the
+  // case of package-private methods of the boot class path that no class of their package
+  // overrides, since the boot class path does not change after compilation.
+  bool IsNeverOverridden(mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(hierarchy_analysis_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Attempt to resolve all type, methods, fields, and strings
   // referenced from code in the dex file following PathClassLoader
   // ordering semantics.
@@ -676,6 +772,9 @@ class CompilerDriver {
                      jobject class_loader, const DexFile& dex_file,
                      DexToDexCompilationLevel dex_to_dex_compilation_level)
       LOCKS_EXCLUDED(compiled_methods_lock_);
+  CompiledMethod* CompileJniStub(uint32_t access_flags, uint32_t method_idx,
+                                 const DexFile& dex_file)
+      LOCKS_EXCLUDED(jni_stubs_lock_);
 
   static void CompileClass(const ParallelCompilationManager* context, size_t class_def_index)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
@@ -707,6 +806,21 @@ class CompilerDriver {
   mutable Mutex compiled_methods_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   MethodTable compiled_methods_ GUARDED_BY(compiled_methods_lock_);
 
+  typedef SafeMap<const MethodReference, bool, MethodReferenceComparator> HierarchyTable;
+  // Results of IsNeverOverridden(), as the analysis walks the classes of a whole package.
+  Mutex hierarchy_analysis_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  HierarchyTable never_overridden_methods_ GUARDED_BY(hierarchy_analysis_lock_);
+
+  // The Quick JNI stubs generated so far, by shorty and the access flags they depend on. The
+  // stubs of the other native methods with the same key are copies sharing the code.
+  Mutex jni_stubs_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  SafeMap<std::string, CompiledMethod*> jni_stubs_ GUARDED_BY(jni_stubs_lock_);
+  size_t shared_jni_stubs_ GUARDED_BY(jni_stubs_lock_);
+
+  // The reasons the image classes failed to initialize at compile time, by descriptor.
+  mutable Mutex class_init_failures_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  SafeMap<std::string, std::string> class_init_failures_ GUARDED_BY(class_init_failures_lock_);
+
   const bool image_;
 
   // If image_ is true, specifies the classes that will be included in
@@ -717,6 +831,11 @@ class CompilerDriver {
   size_t thread_count_;
   uint64_t start_ns_;
 
+  // The wall time of the phases run by the compiler threads, and the time each thread spent
+  // working during those phases.
+  uint64_t parallel_wall_ns_;
+  std::vector<uint64_t> parallel_busy_ns_;
+
   class AOTCompilationStats;
   UniquePtr<AOTCompilationStats> stats_;
 
@@ -742,7 +861,8 @@ class CompilerDriver {
 
   pthread_key_t tls_key_;
 
-  // Arena pool used by the compiler.
+  // Arena pool used by the compiler. With --dump-arena-stats, it counts the
+  // allocations so that the memory used by large methods can be reported.
   ArenaPool arena_pool_;
 
   typedef void (*CompilerEnableAutoElfLoadingFn)(CompilerDriver& driver);
@@ -753,10 +873,17 @@ class CompilerDriver {
   CompilerGetMethodCodeAddrFn compiler_get_method_code_addr_;
 
   bool support_boot_image_fixup_;
+  bool support_osr_;
 
   // Call Frame Information, which might be generated to help stack tracebacks.
   UniquePtr<std::vector<uint8_t> > cfi_info_;
 
+  UniquePtr<PreviousOatFile> previous_oat_file_;
+
+  // The storage of the deduplicated code and tables when compiling with a swap file. Declared
+  // before the dedupe sets, which free their arrays in it.
+  UniquePtr<SwapSpace> swap_space_;
+
   // DeDuplication data structures, these own the corresponding byte arrays.
   class DedupeHashFunc {
    public:
@@ -791,11 +918,11 @@ class CompilerDriver {
       return hash;
     }
   };
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_code_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_mapping_table_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_vmap_table_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_gc_map_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_cfi_info_;
+  DedupeSet<std::vector<uint8_t>, SwapVector, size_t, DedupeHashFunc> dedupe_code_;
+  DedupeSet<std::vector<uint8_t>, SwapVector, size_t, DedupeHashFunc> dedupe_mapping_table_;
+  DedupeSet<std::vector<uint8_t>, SwapVector, size_t, DedupeHashFunc> dedupe_vmap_table_;
+  DedupeSet<std::vector<uint8_t>, SwapVector, size_t, DedupeHashFunc> dedupe_gc_map_;
+  DedupeSet<std::vector<uint8_t>, SwapVector, size_t, DedupeHashFunc> dedupe_cfi_info_;
 
   DISALLOW_COPY_AND_ASSIGN(CompilerDriver);
 };
@@ -0,0 +1,511 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "previous_oat_file.h"
+
+#include "base/stl_util.h"
+#include "base/stringprintf.h"
+#include "compiled_method.h"
+#include "dex_instruction-inl.h"
+#include "gc_map.h"
+#include "mapping_table.h"
+#include "mirror/art_method.h"
+#include "oat.h"
+#include "oat_file-inl.h"
+#include "vmap_table.h"
+
+namespace art {
+
+// Returns whether the code items have the same registers, instructions and catch handlers. The
+// indexes they hold are compared, not what they stand for.
+static bool HasSameCode(const DexFile::CodeItem* lhs, const DexFile::CodeItem* rhs) {
+  if (lhs == nullptr || rhs == nullptr) {
+    return lhs == rhs;
+  }
+  if (lhs->registers_size_ != rhs->registers_size_ || lhs->ins_size_ != rhs->ins_size_ ||
+      lhs->outs_size_ != rhs->outs_size_ || lhs->tries_size_ != rhs->tries_size_ ||
+      lhs->insns_size_in_code_units_ != rhs->insns_size_in_code_units_) {
+    return false;
+  }
+  if (memcmp(lhs->insns_, rhs->insns_, lhs->insns_size_in_code_units_ * sizeof(uint16_t)) != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i != lhs->tries_size_; ++i) {
+    const DexFile::TryItem* lhs_try = DexFile::GetTryItems(*lhs, i);
+    const DexFile::TryItem* rhs_try = DexFile::GetTryItems(*rhs, i);
+    if (lhs_try->start_addr_ != rhs_try->start_addr_ ||
+        lhs_try->insn_count_ != rhs_try->insn_count_) {
+      return false;
+    }
+    CatchHandlerIterator lhs_handlers(*lhs, *lhs_try);
+    CatchHandlerIterator rhs_handlers(*rhs, *rhs_try);
+    for (; lhs_handlers.HasNext() && rhs_handlers.HasNext();
+         lhs_handlers.Next(), rhs_handlers.Next()) {
+      if (lhs_handlers.GetHandlerAddress() != rhs_handlers.GetHandlerAddress() ||
+          lhs_handlers.GetHandlerTypeIndex() != rhs_handlers.GetHandlerTypeIndex()) {
+        return false;
+      }
+    }
+    if (lhs_handlers.HasNext() || rhs_handlers.HasNext()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool HasSameTypeDescriptor(const DexFile& lhs_dex_file, uint32_t lhs_idx,
+                                  const DexFile& rhs_dex_file, uint32_t rhs_idx) {
+  return strcmp(lhs_dex_file.StringByTypeIdx(lhs_idx), rhs_dex_file.StringByTypeIdx(rhs_idx)) == 0;
+}
+
+static bool HasSameMethodNameAndSignature(const DexFile& lhs_dex_file,
+                                          const DexFile::MethodId& lhs,
+                                          const DexFile& rhs_dex_file,
+                                          const DexFile::MethodId& rhs) {
+  return strcmp(lhs_dex_file.GetMethodName(lhs), rhs_dex_file.GetMethodName(rhs)) == 0 &&
+      lhs_dex_file.GetMethodSignature(lhs) == rhs_dex_file.GetMethodSignature(rhs);
+}
+
+PreviousOatFile* PreviousOatFile::Open(const std::string& oat_filename,
+                                       const std::vector<std::string>& old_dex_filenames,
+                                       const std::vector<const DexFile*>& dex_files,
+                                       InstructionSet instruction_set,
+                                       const InstructionSetFeatures& instruction_set_features,
+                                       uint32_t image_oat_checksum,
+                                       uintptr_t image_oat_data_begin,
+                                       std::string* error_msg) {
+  if (kUsePortableCompiler) {
+    *error_msg = "Only the code of the Quick compiler can be reused";
+    return nullptr;
+  }
+  OatFile* oat_file = OatFile::Open(oat_filename, oat_filename, nullptr, false, error_msg);
+  if (oat_file == nullptr) {
+    return nullptr;
+  }
+  UniquePtr<PreviousOatFile> previous(new PreviousOatFile(oat_file, instruction_set));
+  const OatHeader& oat_header = oat_file->GetOatHeader();
+  if (oat_header.GetInstructionSet() != instruction_set ||
+      oat_header.GetInstructionSetFeatures() != instruction_set_features) {
+    *error_msg = StringPrintf("%s was compiled for another instruction set",
+                              oat_filename.c_str());
+    return nullptr;
+  }
+  if (oat_header.GetImageFileLocationOatChecksum() != image_oat_checksum ||
+      oat_header.GetImageFileLocationOatDataBegin() != image_oat_data_begin) {
+    *error_msg = StringPrintf("%s was compiled against another boot image",
+                              oat_filename.c_str());
+    return nullptr;
+  }
+
+  for (const std::string& old_dex_filename : old_dex_filenames) {
+    const DexFile* old_dex_file = DexFile::Open(old_dex_filename.c_str(),
+                                                old_dex_filename.c_str(), error_msg);
+    if (old_dex_file == nullptr) {
+      return nullptr;
+    }
+    previous->old_dex_files_.push_back(old_dex_file);
+  }
+
+  // Pair the dex files with the previous oat dex files of the same location, and the dex files
+  // these were compiled from. The dex files without a previous version are compiled entirely.
+  for (const DexFile* dex_file : dex_files) {
+    const OatFile::OatDexFile* oat_dex_file =
+        oat_file->GetOatDexFile(dex_file->GetLocation().c_str(), nullptr, false);
+    if (oat_dex_file == nullptr) {
+      continue;
+    }
+    for (const DexFile* old_dex_file : previous->old_dex_files_) {
+      if (old_dex_file->GetLocationChecksum() == oat_dex_file->GetDexFileLocationChecksum()) {
+        previous->old_dex_file_of_.Put(dex_file, old_dex_file);
+        previous->old_oat_dex_file_of_.Put(dex_file, oat_dex_file);
+        break;
+      }
+    }
+  }
+  previous->FindClassChanges(dex_files);
+  return previous.release();
+}
+
+PreviousOatFile::PreviousOatFile(OatFile* oat_file, InstructionSet instruction_set)
+    : oat_file_(oat_file), instruction_set_(instruction_set), reused_methods_(0u) {
+}
+
+PreviousOatFile::~PreviousOatFile() {
+  STLDeleteElements(&old_dex_files_);
+}
+
+void PreviousOatFile::FindClassChanges(const std::vector<const DexFile*>& dex_files) {
+  for (const DexFile* dex_file : dex_files) {
+    for (size_t i = 0; i != dex_file->NumClassDefs(); ++i) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
+      std::string descriptor(dex_file->GetClassDescriptor(class_def));
+      // Like for the class linker, the first definition of a class hides the others.
+      if (new_classes_.find(descriptor) == new_classes_.end()) {
+        NewClass new_class = { dex_file, &class_def };
+        new_classes_.Put(descriptor, new_class);
+      }
+    }
+  }
+  // Computed once here, as the compiler threads only read class_changes_.
+  for (SafeMap<std::string, NewClass>::const_iterator it = new_classes_.begin();
+       it != new_classes_.end(); ++it) {
+    std::set<std::string> visiting;
+    ComputeClassChanges(it->first, &visiting);
+  }
+}
+
+uint32_t PreviousOatFile::ComputeClassChanges(const std::string& descriptor,
+                                              std::set<std::string>* visiting) {
+  SafeMap<std::string, uint32_t>::const_iterator changes_it = class_changes_.find(descriptor);
+  if (changes_it != class_changes_.end()) {
+    return changes_it->second;
+  }
+  SafeMap<std::string, NewClass>::const_iterator new_it = new_classes_.find(descriptor);
+  if (new_it == new_classes_.end()) {
+    return GetClassChanges(descriptor.c_str());
+  }
+  if (!visiting->insert(descriptor).second) {
+    // A circular class hierarchy, the class will not link.
+    return kAllChanged;
+  }
+  const DexFile& dex_file = *new_it->second.dex_file;
+  const DexFile::ClassDef& class_def = *new_it->second.class_def;
+  uint32_t changes = CompareClass(dex_file, class_def);
+  if (class_def.superclass_idx_ != DexFile::kDexNoIndex16) {
+    changes |= ComputeClassChanges(dex_file.StringByTypeIdx(class_def.superclass_idx_), visiting);
+  }
+  const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+  if (interfaces != nullptr) {
+    for (uint32_t i = 0; i != interfaces->Size(); ++i) {
+      changes |= ComputeClassChanges(
+          dex_file.StringByTypeIdx(interfaces->GetTypeItem(i).type_idx_), visiting);
+    }
+  }
+  visiting->erase(descriptor);
+  class_changes_.Put(descriptor, changes);
+  return changes;
+}
+
+uint32_t PreviousOatFile::GetClassChanges(const char* descriptor) const {
+  // The changes of an array class are those of its element class.
+  while (*descriptor == '[') {
+    ++descriptor;
+  }
+  if (*descriptor != 'L') {
+    return 0u;
+  }
+  SafeMap<std::string, uint32_t>::const_iterator it = class_changes_.find(descriptor);
+  if (it != class_changes_.end()) {
+    return it->second;
+  }
+  // A class not defined by the compiled dex files comes from the boot class path, which did not
+  // change, unless it was removed from the compiled dex files.
+  const DexFile* old_dex_file;
+  if (FindOldClassDef(descriptor, &old_dex_file) == nullptr) {
+    return 0u;
+  }
+  return kAllChanged;
+}
+
+const DexFile::ClassDef* PreviousOatFile::FindOldClassDef(const char* descriptor,
+                                                          const DexFile** old_dex_file) const {
+  for (const DexFile* dex_file : old_dex_files_) {
+    const DexFile::ClassDef* class_def = dex_file->FindClassDef(descriptor);
+    if (class_def != nullptr) {
+      *old_dex_file = dex_file;
+      return class_def;
+    }
+  }
+  return nullptr;
+}
+
+uint32_t PreviousOatFile::CompareClass(const DexFile& dex_file,
+                                       const DexFile::ClassDef& class_def) const {
+  const DexFile* old_dex_file;
+  const DexFile::ClassDef* old_class_def =
+      FindOldClassDef(dex_file.GetClassDescriptor(class_def), &old_dex_file);
+  if (old_class_def == nullptr || class_def.access_flags_ != old_class_def->access_flags_) {
+    return kAllChanged;
+  }
+  if ((class_def.superclass_idx_ == DexFile::kDexNoIndex16) !=
+      (old_class_def->superclass_idx_ == DexFile::kDexNoIndex16)) {
+    return kAllChanged;
+  }
+  if (class_def.superclass_idx_ != DexFile::kDexNoIndex16 &&
+      !HasSameTypeDescriptor(dex_file, class_def.superclass_idx_,
+                             *old_dex_file, old_class_def->superclass_idx_)) {
+    return kAllChanged;
+  }
+  const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+  const DexFile::TypeList* old_interfaces = old_dex_file->GetInterfacesList(*old_class_def);
+  uint32_t num_interfaces = (interfaces != nullptr) ? interfaces->Size() : 0u;
+  uint32_t old_num_interfaces = (old_interfaces != nullptr) ? old_interfaces->Size() : 0u;
+  if (num_interfaces != old_num_interfaces) {
+    return kAllChanged;
+  }
+  for (uint32_t i = 0; i != num_interfaces; ++i) {
+    if (!HasSameTypeDescriptor(dex_file, interfaces->GetTypeItem(i).type_idx_,
+                               *old_dex_file, old_interfaces->GetTypeItem(i).type_idx_)) {
+      return kAllChanged;
+    }
+  }
+
+  const byte* class_data = dex_file.GetClassData(class_def);
+  const byte* old_class_data = old_dex_file->GetClassData(*old_class_def);
+  if (class_data == nullptr || old_class_data == nullptr) {
+    return (class_data == old_class_data) ? 0u : static_cast<uint32_t>(kAllChanged);
+  }
+  ClassDataItemIterator it(dex_file, class_data);
+  ClassDataItemIterator old_it(*old_dex_file, old_class_data);
+  if (it.NumStaticFields() != old_it.NumStaticFields() ||
+      it.NumInstanceFields() != old_it.NumInstanceFields() ||
+      it.NumDirectMethods() != old_it.NumDirectMethods() ||
+      it.NumVirtualMethods() != old_it.NumVirtualMethods()) {
+    return kAllChanged;
+  }
+  for (; it.HasNextStaticField() || it.HasNextInstanceField(); it.Next(), old_it.Next()) {
+    const DexFile::FieldId& field_id = dex_file.GetFieldId(it.GetMemberIndex());
+    const DexFile::FieldId& old_field_id = old_dex_file->GetFieldId(old_it.GetMemberIndex());
+    if (it.GetMemberAccessFlags() != old_it.GetMemberAccessFlags() ||
+        strcmp(dex_file.GetFieldName(field_id), old_dex_file->GetFieldName(old_field_id)) != 0 ||
+        !HasSameTypeDescriptor(dex_file, field_id.type_idx_,
+                               *old_dex_file, old_field_id.type_idx_)) {
+      return kAllChanged;
+    }
+  }
+  uint32_t changes = 0u;
+  for (; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); it.Next(), old_it.Next()) {
+    const DexFile::MethodId& method_id = dex_file.GetMethodId(it.GetMemberIndex());
+    const DexFile::MethodId& old_method_id = old_dex_file->GetMethodId(old_it.GetMemberIndex());
+    if (it.GetMemberAccessFlags() != old_it.GetMemberAccessFlags() ||
+        !HasSameMethodNameAndSignature(dex_file, method_id, *old_dex_file, old_method_id)) {
+      return kAllChanged;
+    }
+    if (!HasSameCode(it.GetMethodCodeItem(), old_it.GetMethodCodeItem())) {
+      changes |= kCodeChanged;
+    }
+  }
+  return changes;
+}
+
+bool PreviousOatFile::HasSameReferences(const DexFile& dex_file, const DexFile& old_dex_file,
+                                        const DexFile::CodeItem& code_item,
+                                        uint32_t method_idx) const {
+  // The code may rely on the types of the parameters of the method, as well as the layout of
+  // the classes of the fields it accesses. It may inline or devirtualize the methods it calls.
+  const DexFile::ProtoId& proto_id =
+      dex_file.GetMethodPrototype(dex_file.GetMethodId(method_idx));
+  if ((GetClassChanges(dex_file.StringByTypeIdx(proto_id.return_type_idx_)) &
+       kShapeChanged) != 0) {
+    return false;
+  }
+  const DexFile::TypeList* parameters = dex_file.GetProtoParameters(proto_id);
+  for (uint32_t i = 0; parameters != nullptr && i != parameters->Size(); ++i) {
+    if ((GetClassChanges(dex_file.StringByTypeIdx(parameters->GetTypeItem(i).type_idx_)) &
+         kShapeChanged) != 0) {
+      return false;
+    }
+  }
+
+  for (uint32_t i = 0; i != code_item.tries_size_; ++i) {
+    for (CatchHandlerIterator it(code_item, *DexFile::GetTryItems(code_item, i)); it.HasNext();
+         it.Next()) {
+      uint16_t type_idx = it.GetHandlerTypeIndex();
+      if (type_idx == DexFile::kDexNoIndex16) {
+        continue;
+      }
+      if (type_idx >= old_dex_file.NumTypeIds() ||
+          !HasSameTypeDescriptor(dex_file, type_idx, old_dex_file, type_idx) ||
+          GetClassChanges(dex_file.StringByTypeIdx(type_idx)) != 0u) {
+        return false;
+      }
+    }
+  }
+
+  // The instructions are the same, so are the indexes they reference.
+  const uint16_t* insns = code_item.insns_;
+  for (const Instruction* inst = Instruction::At(insns);
+       inst->GetDexPc(insns) < code_item.insns_size_in_code_units_; inst = inst->Next()) {
+    uint32_t type_idx = DexFile::kDexNoIndex;
+    switch (inst->GetVerifyTypeArgumentB()) {
+      case Instruction::kVerifyRegBString: {
+        uint32_t string_idx = inst->VRegB();
+        if (string_idx >= old_dex_file.NumStringIds() ||
+            strcmp(dex_file.StringDataByIdx(string_idx),
+                   old_dex_file.StringDataByIdx(string_idx)) != 0) {
+          return false;
+        }
+        break;
+      }
+      case Instruction::kVerifyRegBType:
+      case Instruction::kVerifyRegBNewInstance:
+        type_idx = inst->VRegB();
+        break;
+      case Instruction::kVerifyRegBField: {
+        uint32_t field_idx = inst->VRegB();
+        if (field_idx >= old_dex_file.NumFieldIds()) {
+          return false;
+        }
+        const DexFile::FieldId& field_id = dex_file.GetFieldId(field_idx);
+        const DexFile::FieldId& old_field_id = old_dex_file.GetFieldId(field_idx);
+        if (strcmp(dex_file.GetFieldName(field_id), old_dex_file.GetFieldName(old_field_id)) != 0 ||
+            !HasSameTypeDescriptor(dex_file, field_id.class_idx_,
+                                   old_dex_file, old_field_id.class_idx_) ||
+            !HasSameTypeDescriptor(dex_file, field_id.type_idx_,
+                                   old_dex_file, old_field_id.type_idx_) ||
+            (GetClassChanges(dex_file.StringByTypeIdx(field_id.class_idx_)) &
+             kShapeChanged) != 0 ||
+            (GetClassChanges(dex_file.StringByTypeIdx(field_id.type_idx_)) &
+             kShapeChanged) != 0) {
+          return false;
+        }
+        break;
+      }
+      case Instruction::kVerifyRegBMethod: {
+        uint32_t callee_idx = inst->VRegB();
+        if (callee_idx >= old_dex_file.NumMethodIds()) {
+          return false;
+        }
+        const DexFile::MethodId& callee_id = dex_file.GetMethodId(callee_idx);
+        const DexFile::MethodId& old_callee_id = old_dex_file.GetMethodId(callee_idx);
+        if (!HasSameTypeDescriptor(dex_file, callee_id.class_idx_,
+                                   old_dex_file, old_callee_id.class_idx_) ||
+            !HasSameMethodNameAndSignature(dex_file, callee_id, old_dex_file, old_callee_id) ||
+            GetClassChanges(dex_file.StringByTypeIdx(callee_id.class_idx_)) != 0u) {
+          return false;
+        }
+        const DexFile::ProtoId& callee_proto = dex_file.GetMethodPrototype(callee_id);
+        if ((GetClassChanges(dex_file.StringByTypeIdx(callee_proto.return_type_idx_)) &
+             kShapeChanged) != 0) {
+          return false;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    switch (inst->GetVerifyTypeArgumentC()) {
+      case Instruction::kVerifyRegCType:
+      case Instruction::kVerifyRegCNewArray:
+        type_idx = inst->VRegC();
+        break;
+      case Instruction::kVerifyRegCField: {
+        uint32_t field_idx = inst->VRegC();
+        if (field_idx >= old_dex_file.NumFieldIds()) {
+          return false;
+        }
+        const DexFile::FieldId& field_id = dex_file.GetFieldId(field_idx);
+        const DexFile::FieldId& old_field_id = old_dex_file.GetFieldId(field_idx);
+        if (strcmp(dex_file.GetFieldName(field_id), old_dex_file.GetFieldName(old_field_id)) != 0 ||
+            !HasSameTypeDescriptor(dex_file, field_id.class_idx_,
+                                   old_dex_file, old_field_id.class_idx_) ||
+            !HasSameTypeDescriptor(dex_file, field_id.type_idx_,
+                                   old_dex_file, old_field_id.type_idx_) ||
+            (GetClassChanges(dex_file.StringByTypeIdx(field_id.class_idx_)) &
+             kShapeChanged) != 0 ||
+            (GetClassChanges(dex_file.StringByTypeIdx(field_id.type_idx_)) &
+             kShapeChanged) != 0) {
+          return false;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    // The precise types of new instances may devirtualize and inline calls to their methods.
+    if (type_idx != DexFile::kDexNoIndex &&
+        (type_idx >= old_dex_file.NumTypeIds() ||
+         !HasSameTypeDescriptor(dex_file, type_idx, old_dex_file, type_idx) ||
+         GetClassChanges(dex_file.StringByTypeIdx(type_idx)) != 0u)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+CompiledMethod* PreviousOatFile::FindCompiledMethod(CompilerDriver* driver,
+                                                    const DexFile& dex_file,
+                                                    uint16_t class_def_idx,
+                                                    uint32_t method_idx,
+                                                    const DexFile::CodeItem* code_item,
+                                                    uint32_t access_flags) {
+  SafeMap<const DexFile*, const DexFile*>::const_iterator old_it = old_dex_file_of_.find(&dex_file);
+  if (code_item == nullptr || old_it == old_dex_file_of_.end()) {
+    return nullptr;
+  }
+  const DexFile& old_dex_file = *old_it->second;
+  const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_idx);
+  const char* descriptor = dex_file.GetClassDescriptor(class_def);
+  const DexFile::ClassDef* old_class_def = old_dex_file.FindClassDef(descriptor);
+  if (old_class_def == nullptr || (GetClassChanges(descriptor) & kShapeChanged) != 0) {
+    return nullptr;
+  }
+
+  // The class has the same methods in the same order: find the previous version of the method
+  // and its index in the oat class.
+  const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+  ClassDataItemIterator it(old_dex_file, old_dex_file.GetClassData(*old_class_def));
+  while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+    it.Next();
+  }
+  uint32_t oat_method_index = 0u;
+  for (; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); it.Next(), ++oat_method_index) {
+    const DexFile::MethodId& old_method_id = old_dex_file.GetMethodId(it.GetMemberIndex());
+    if (HasSameMethodNameAndSignature(dex_file, method_id, old_dex_file, old_method_id)) {
+      break;
+    }
+  }
+  if (!it.HasNextDirectMethod() && !it.HasNextVirtualMethod()) {
+    return nullptr;
+  }
+  if (it.GetMemberAccessFlags() != access_flags ||
+      !HasSameCode(code_item, it.GetMethodCodeItem()) ||
+      !HasSameReferences(dex_file, old_dex_file, *code_item, method_idx)) {
+    return nullptr;
+  }
+
+  const OatFile::OatDexFile* old_oat_dex_file = old_oat_dex_file_of_.Get(&dex_file);
+  const OatFile::OatClass old_oat_class =
+      old_oat_dex_file->GetOatClass(old_dex_file.GetIndexForClassDef(*old_class_def));
+  const OatFile::OatMethod old_oat_method = old_oat_class.GetOatMethod(oat_method_index);
+  const uint8_t* code = reinterpret_cast<const uint8_t*>(
+      mirror::ArtMethod::EntryPointToCodePointer(old_oat_method.GetQuickCode()));
+  if (code == nullptr) {
+    // The method was left to the interpreter.
+    return nullptr;
+  }
+
+  std::vector<uint8_t> quick_code(code, code + old_oat_method.GetQuickCodeSize());
+  const uint8_t* mapping_table = old_oat_method.GetMappingTable();
+  size_t mapping_table_size = MappingTable(mapping_table).EncodedSize();
+  const uint8_t* vmap_table = old_oat_method.GetVmapTable();
+  size_t vmap_table_size = (vmap_table != nullptr) ? VmapTable(vmap_table).EncodedSize() : 0u;
+  const uint8_t* gc_map = old_oat_method.GetNativeGcMap();
+  size_t gc_map_size =
+      (gc_map != nullptr) ? NativePcOffsetToReferenceMap(gc_map).EncodedSize() : 0u;
+  reused_methods_++;
+  return new CompiledMethod(driver, instruction_set_, quick_code,
+                            old_oat_method.GetFrameSizeInBytes(),
+                            old_oat_method.GetCoreSpillMask(),
+                            old_oat_method.GetFpSpillMask(),
+                            std::vector<uint8_t>(mapping_table,
+                                                 mapping_table + mapping_table_size),
+                            std::vector<uint8_t>(vmap_table, vmap_table + vmap_table_size),
+                            std::vector<uint8_t>(gc_map, gc_map + gc_map_size),
+                            nullptr);
+}
+
+}  // namespace art
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_PREVIOUS_OAT_FILE_H_
+#define ART_COMPILER_DRIVER_PREVIOUS_OAT_FILE_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "dex_file.h"
+#include "instruction_set.h"
+#include "oat_file.h"
+#include "safe_map.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+class CompiledMethod;
+class CompilerDriver;
+
+// The oat file of a previous compilation of the dex files, and the dex files it was compiled
+// from, whose compiled methods are reused for the methods that did not change since.
+//
+// A method is reused when its code item is the same, the strings, types, fields and methods it
+// references have the same names, and the classes it depends on did not change. A class changes
+// shape when its super class, interfaces, fields or methods change, and changes code when the
+// code of one of its methods does. The changes of the super classes and interfaces from the
+// compiled dex files are inherited. The boot image and the compiler options must be the same as
+// for the previous compilation.
+class PreviousOatFile {
+ public:
+  // Returns nullptr with an error message if the oat file cannot be used for dex_files.
+  static PreviousOatFile* Open(const std::string& oat_filename,
+                               const std::vector<std::string>& old_dex_filenames,
+                               const std::vector<const DexFile*>& dex_files,
+                               InstructionSet instruction_set,
+                               const InstructionSetFeatures& instruction_set_features,
+                               uint32_t image_oat_checksum,
+                               uintptr_t image_oat_data_begin,
+                               std::string* error_msg);
+
+  ~PreviousOatFile();
+
+  // Returns a copy of the previously compiled code of the method, or nullptr if the method has
+  // to be compiled again. Called concurrently by the compiler threads.
+  CompiledMethod* FindCompiledMethod(CompilerDriver* driver,
+                                     const DexFile& dex_file,
+                                     uint16_t class_def_idx,
+                                     uint32_t method_idx,
+                                     const DexFile::CodeItem* code_item,
+                                     uint32_t access_flags);
+
+  size_t GetReusedMethodCount() const {
+    return reused_methods_.Load();
+  }
+
+ private:
+  enum ClassChange {
+    kShapeChanged = 1u,
+    kCodeChanged = 2u,
+    kAllChanged = kShapeChanged | kCodeChanged,
+  };
+
+  // A class defined by the dex files being compiled.
+  struct NewClass {
+    const DexFile* dex_file;
+    const DexFile::ClassDef* class_def;
+  };
+
+  PreviousOatFile(OatFile* oat_file, InstructionSet instruction_set);
+
+  void FindClassChanges(const std::vector<const DexFile*>& dex_files);
+  uint32_t ComputeClassChanges(const std::string& descriptor, std::set<std::string>* visiting);
+  uint32_t CompareClass(const DexFile& dex_file, const DexFile::ClassDef& class_def) const;
+  uint32_t GetClassChanges(const char* descriptor) const;
+
+  const DexFile::ClassDef* FindOldClassDef(const char* descriptor,
+                                           const DexFile** old_dex_file) const;
+  bool HasSameReferences(const DexFile& dex_file, const DexFile& old_dex_file,
+                         const DexFile::CodeItem& code_item, uint32_t method_idx) const;
+
+  UniquePtr<OatFile> oat_file_;
+  const InstructionSet instruction_set_;
+
+  // The dex files of the previous compilation, and their oat dex files by compiled dex file.
+  std::vector<const DexFile*> old_dex_files_;
+  SafeMap<const DexFile*, const DexFile*> old_dex_file_of_;
+  SafeMap<const DexFile*, const OatFile::OatDexFile*> old_oat_dex_file_of_;
+
+  SafeMap<std::string, NewClass> new_classes_;
+  // The ClassChange flags of the classes of new_classes_.
+  SafeMap<std::string, uint32_t> class_changes_;
+
+  Atomic<size_t> reused_methods_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreviousOatFile);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_PREVIOUS_OAT_FILE_H_
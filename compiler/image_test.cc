@@ -80,7 +80,7 @@ TEST_F(ImageTest, WriteRead) {
   ScratchFile tmp_image(tmp, "art");
   const uintptr_t requested_image_base = ART_BASE_ADDRESS;
   {
-    ImageWriter writer(*compiler_driver_.get());
+    ImageWriter writer(*compiler_driver_.get(), false, nullptr, false);
     bool success_image = writer.Write(tmp_image.GetFilename(), requested_image_base,
                                       tmp_oat->GetPath(), tmp_oat->GetPath());
     ASSERT_TRUE(success_image);
@@ -96,6 +96,7 @@ TEST_F(ImageTest, WriteRead) {
     ASSERT_TRUE(image_header.IsValid());
     ASSERT_GE(image_header.GetImageBitmapOffset(), sizeof(image_header));
     ASSERT_NE(0U, image_header.GetImageBitmapSize());
+    ASSERT_NE(0U, image_header.GetRelocationsSize());
 
     gc::Heap* heap = Runtime::Current()->GetHeap();
     ASSERT_TRUE(!heap->GetContinuousSpaces().empty());
@@ -183,6 +184,11 @@ TEST_F(ImageTest, ImageHeaderIsValid) {
                              image_size_,
                              image_bitmap_offset,
                              image_bitmap_size,
+                             0U,  // No class table.
+                             0U,
+                             0U,  // No intern table.
+                             0U,
+                             0U,  // No relocations.
                              image_roots,
                              oat_checksum,
                              oat_file_begin,
@@ -17,10 +17,13 @@
 #include "image_writer.h"
 
 #include <sys/stat.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "base/logging.h"
+#include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "compiled_method.h"
@@ -36,6 +39,7 @@
 #include "globals.h"
 #include "image.h"
 #include "intern_table.h"
+#include "leb128.h"
 #include "lock_word.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
@@ -113,6 +117,12 @@ bool ImageWriter::Write(const std::string& image_filename,
       oat_file_->GetOatHeader().GetQuickResolutionTrampolineOffset();
   quick_to_interpreter_bridge_offset_ =
       oat_file_->GetOatHeader().GetQuickToInterpreterBridgeOffset();
+
+  // The workers attach to the runtime, create them while this thread is suspended.
+  size_t thread_count = compiler_driver_.GetThreadCount();
+  if (thread_count > 1) {
+    thread_pool_.reset(new ThreadPool("Image writer thread pool", thread_count - 1));
+  }
   {
     Thread::Current()->TransitionFromSuspendedToRunnable();
     PruneNonImageClasses();  // Remove junk
@@ -140,9 +150,13 @@ bool ImageWriter::Write(const std::string& image_filename,
   CopyAndFixupObjects();
   PatchOatCodeAndMethods();
   Thread::Current()->TransitionFromRunnableToSuspended(kNative);
+  thread_pool_.reset();
 
   UniquePtr<File> image_file(OS::CreateEmptyFile(image_filename.c_str()));
   ImageHeader* image_header = reinterpret_cast<ImageHeader*>(image_->Begin());
+  std::vector<uint8_t> relocations;
+  EncodeRelocations(&relocations);
+  image_header->SetRelocationsSize(relocations.size());
   if (image_file.get() == NULL) {
     LOG(ERROR) << "Failed to open image file " << image_filename;
     return false;
@@ -152,23 +166,97 @@ bool ImageWriter::Write(const std::string& image_filename,
     return EXIT_FAILURE;
   }
 
-  // Write out the image.
+  // The image, then the image bitmap at the page aligned start of the image end, then the class
+  // table, the intern table and the relocation section.
   CHECK_EQ(image_end_, image_header->GetImageSize());
-  if (!image_file->WriteFully(image_->Begin(), image_end_)) {
+  CHECK_ALIGNED(image_header->GetImageBitmapOffset(), kPageSize);
+  CHECK_ALIGNED(image_header->GetClassTableOffset(), kPageSize);
+  CHECK_EQ(class_table_slots_.size() * sizeof(ClassTable::ImageSlot),
+           image_header->GetClassTableSize());
+  CHECK_ALIGNED(image_header->GetInternTableOffset(), kPageSize);
+  CHECK_EQ(intern_table_slots_.size() * sizeof(InternTable::ImageSlot),
+           image_header->GetInternTableSize());
+  CHECK_ALIGNED(image_header->GetRelocationsOffset(), kPageSize);
+  CHECK_NE(image_header->GetRelocationsSize(), 0U);
+  const FileSection sections[] = {
+    { 0, image_->Begin(), image_end_ },
+    { image_header->GetImageBitmapOffset(),
+      reinterpret_cast<const byte*>(image_bitmap_->Begin()), image_header->GetImageBitmapSize() },
+    { image_header->GetClassTableOffset(),
+      reinterpret_cast<const byte*>(class_table_slots_.data()), image_header->GetClassTableSize() },
+    { image_header->GetInternTableOffset(),
+      reinterpret_cast<const byte*>(intern_table_slots_.data()),
+      image_header->GetInternTableSize() },
+    { image_header->GetRelocationsOffset(), &relocations[0], image_header->GetRelocationsSize() },
+  };
+  if (!WriteSections(image_file.get(), sections, arraysize(sections))) {
     PLOG(ERROR) << "Failed to write image file " << image_filename;
     return false;
   }
+  return true;
+}
 
-  // Write out the image bitmap at the page aligned start of the image end.
-  CHECK_ALIGNED(image_header->GetImageBitmapOffset(), kPageSize);
-  if (!image_file->Write(reinterpret_cast<char*>(image_bitmap_->Begin()),
-                         image_header->GetImageBitmapSize(),
-                         image_header->GetImageBitmapOffset())) {
-    PLOG(ERROR) << "Failed to write image file " << image_filename;
+bool ImageWriter::WriteSections(File* image_file, const FileSection* sections,
+                                size_t num_sections) {
+  if (compress_image_) {
+    return WriteCompressedSections(image_file, sections, num_sections);
+  }
+  for (size_t i = 0; i < num_sections; ++i) {
+    if (!image_file->Write(reinterpret_cast<const char*>(sections[i].data), sections[i].size,
+                           sections[i].offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ImageWriter::WriteCompressedSections(File* image_file, const FileSection* sections,
+                                          size_t num_sections) {
+  // The first page of the image is stored as is, the rest of the sections in blocks.
+  std::vector<ImageHeader::CompressedBlock> blocks;
+  std::vector<const byte*> block_data;
+  const size_t block_size = ImageHeader::kCompressedBlockSize;
+  CHECK_GE(sections[0].size, static_cast<size_t>(kPageSize));
+  for (size_t i = 0; i < num_sections; ++i) {
+    for (size_t offset = (i == 0) ? kPageSize : 0; offset < sections[i].size;
+         offset += block_size) {
+      ImageHeader::CompressedBlock block;
+      block.offset = sections[i].offset + offset;
+      block.size = std::min(block_size, sections[i].size - offset);
+      blocks.push_back(block);
+      block_data.push_back(sections[i].data + offset);
+    }
+  }
+  ImageHeader* image_header = reinterpret_cast<ImageHeader*>(image_->Begin());
+  image_header->SetCompressedBlocks(blocks.size());
+  if (!image_file->WriteFully(image_->Begin(), kPageSize)) {
     return false;
   }
 
-  return true;
+  size_t compressed_offset = kPageSize + blocks.size() * sizeof(ImageHeader::CompressedBlock);
+  std::vector<Bytef> compressed;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    uLongf compressed_size = compressBound(blocks[i].size);
+    compressed.resize(compressed_size);
+    int result = compress2(&compressed[0], &compressed_size, block_data[i], blocks[i].size,
+                           Z_BEST_COMPRESSION);
+    if (result != Z_OK) {
+      LOG(ERROR) << "Failed to compress image block at " << blocks[i].offset << ": "
+                 << zError(result);
+      return false;
+    }
+    blocks[i].compressed_offset = compressed_offset;
+    blocks[i].compressed_size = compressed_size;
+    if (!image_file->Write(reinterpret_cast<const char*>(&compressed[0]), compressed_size,
+                           compressed_offset)) {
+      return false;
+    }
+    compressed_offset += compressed_size;
+  }
+  VLOG(compiler) << "Compressed image to " << PrettySize(compressed_offset) << " in "
+                 << blocks.size() << " blocks";
+  return image_file->Write(reinterpret_cast<const char*>(&blocks[0]),
+                           blocks.size() * sizeof(ImageHeader::CompressedBlock), kPageSize);
 }
 
 void ImageWriter::SetImageOffset(mirror::Object* object, size_t offset) {
@@ -178,39 +266,154 @@ void ImageWriter::SetImageOffset(mirror::Object* object, size_t offset) {
   mirror::Object* obj = reinterpret_cast<mirror::Object*>(image_->Begin() + offset);
   DCHECK_ALIGNED(obj, kObjectAlignment);
   image_bitmap_->Set(obj);
+  SaveHashCode(object, obj);
+  object->SetLockWord(LockWord::FromForwardingAddress(offset), false);
+  DCHECK(IsImageOffsetAssigned(object));
+}
+
+void ImageWriter::SaveHashCode(mirror::Object* object, mirror::Object* key) {
   // Before we stomp over the lock word, save the hash code for later.
-  Monitor::Deflate(Thread::Current(), object);;
+  Monitor::Deflate(Thread::Current(), object);
   LockWord lw(object->GetLockWord(false));
   switch (lw.GetState()) {
     case LockWord::kFatLocked: {
-      LOG(FATAL) << "Fat locked object " << obj << " found during object copy";
+      LOG(FATAL) << "Fat locked object " << object << " found during object copy";
       break;
     }
     case LockWord::kThinLocked: {
-      LOG(FATAL) << "Thin locked object " << obj << " found during object copy";
+      LOG(FATAL) << "Thin locked object " << object << " found during object copy";
       break;
     }
     case LockWord::kUnlocked:
       // No hash, don't need to save it.
       break;
     case LockWord::kHashCode:
-      saved_hashes_.push_back(std::make_pair(obj, lw.GetHashCode()));
+      saved_hashes_.push_back(std::make_pair(key, lw.GetHashCode()));
       break;
     default:
       LOG(FATAL) << "Unreachable.";
       break;
   }
-  object->SetLockWord(LockWord::FromForwardingAddress(offset), false);
-  DCHECK(IsImageOffsetAssigned(object));
 }
 
 void ImageWriter::AssignImageOffset(mirror::Object* object) {
   DCHECK(object != nullptr);
+  if (startup_layout_) {
+    AssignImageBin(object, GetBin(object));
+    return;
+  }
   SetImageOffset(object, image_end_);
   image_end_ += RoundUp(object->SizeOf(), 8);  // 64-bit alignment
   DCHECK_LT(image_end_, image_->Size());
 }
 
+ImageWriter::Bin ImageWriter::GetBin(mirror::Object* object) {
+  if (object->GetClass()->IsStringClass()) {
+    return kBinString;
+  }
+  if (dex_cache_objects_.find(object) != dex_cache_objects_.end()) {
+    return kBinMutable;
+  }
+  if (object->IsClass()) {
+    mirror::Class* klass = object->AsClass();
+    if (IsMutableClass(klass)) {
+      return kBinMutable;
+    }
+    return IsStartupClass(klass) ? kBinStartup : kBinClean;
+  }
+  if (object->IsArtMethod()) {
+    // Natives are registered, and the entry points of static methods are fixed up once their
+    // class is initialized.
+    mirror::ArtMethod* method = object->AsArtMethod();
+    mirror::Class* klass = method->GetDeclaringClass();
+    if (method->IsNative() || (method->IsStatic() && !klass->IsInitialized())) {
+      return kBinMutable;
+    }
+    return IsStartupClass(klass) ? kBinStartup : kBinClean;
+  }
+  if (object->IsArtField()) {
+    return IsStartupClass(object->AsArtField()->GetDeclaringClass()) ? kBinStartup : kBinClean;
+  }
+  return kBinClean;
+}
+
+bool ImageWriter::IsStartupClass(mirror::Class* klass) {
+  return startup_classes_ != nullptr &&
+      startup_classes_->find(ClassHelper(klass).GetDescriptor()) != startup_classes_->end();
+}
+
+bool ImageWriter::IsMutableClass(mirror::Class* klass) {
+  // The status and the static fields of a class are written when it is initialized.
+  if (!klass->IsInitialized()) {
+    return true;
+  }
+  for (size_t i = 0, e = klass->NumStaticFields(); i < e; ++i) {
+    if (!klass->GetStaticField(i)->IsFinal()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ImageWriter::AssignImageBin(mirror::Object* object, Bin bin) {
+  DCHECK(object != nullptr);
+  DCHECK(!IsImageOffsetAssigned(object));
+  // The hash codes are keyed by the object until the bins are laid out.
+  SaveHashCode(object, object);
+  object->SetLockWord(LockWord::FromForwardingAddress(bin_sizes_[bin]), false);
+  bin_objects_[bin].push_back(object);
+  bin_sizes_[bin] += RoundUp(object->SizeOf(), 8);  // 64-bit alignment
+}
+
+void ImageWriter::AssignStartupMembers(mirror::Class* klass) {
+  // The member arrays are otherwise only reached through the class, which doesn't say whether
+  // they are used during startup.
+  mirror::Object* members[] = {
+    klass->GetDirectMethods(), klass->GetVirtualMethods(), klass->GetIFields(),
+    klass->GetSFields(), klass->GetVTable(), klass->GetIfTable()
+  };
+  for (mirror::Object* member : members) {
+    if (member == nullptr || IsImageOffsetAssigned(member)) {
+      continue;
+    }
+    AssignImageBin(member, kBinStartup);
+    mirror::ObjectArray<mirror::Object>* array = member->AsObjectArray<mirror::Object>();
+    for (int32_t i = 0, e = array->GetLength(); i < e; ++i) {
+      mirror::Object* value = array->Get(i);
+      if (value != nullptr) {
+        WalkFieldsInOrder(value);
+      }
+    }
+  }
+}
+
+void ImageWriter::AssignBinOffsets() {
+  size_t bin_begin[kNumBins];
+  size_t end = image_end_;
+  for (size_t bin = 0; bin < kNumBins; ++bin) {
+    bin_begin[bin] = end;
+    end += bin_sizes_[bin];
+  }
+  for (size_t bin = 0; bin < kNumBins; ++bin) {
+    for (mirror::Object* object : bin_objects_[bin]) {
+      size_t offset = bin_begin[bin] + object->GetLockWord(false).ForwardingAddress();
+      object->SetLockWord(LockWord::FromForwardingAddress(offset), false);
+      image_bitmap_->Set(reinterpret_cast<mirror::Object*>(image_->Begin() + offset));
+    }
+    bin_objects_[bin].clear();
+  }
+  image_end_ = end;
+  DCHECK_LT(image_end_, image_->Size());
+  for (const std::pair<mirror::Object*, mirror::Object*>& alias : string_aliases_) {
+    alias.first->SetLockWord(alias.second->GetLockWord(false), false);
+  }
+  string_aliases_.clear();
+  for (std::pair<mirror::Object*, uint32_t>& hash_pair : saved_hashes_) {
+    hash_pair.first = reinterpret_cast<mirror::Object*>(image_->Begin() +
+                                                        GetImageOffset(hash_pair.first));
+  }
+}
+
 bool ImageWriter::IsImageOffsetAssigned(mirror::Object* object) const {
   DCHECK(object != nullptr);
   return object->GetLockWord(false).GetState() == LockWord::kForwardingAddress;
@@ -255,33 +458,80 @@ bool ImageWriter::ComputeLazyFieldsForClassesVisitor(Class* c, void* /*arg*/) {
   return true;
 }
 
-void ImageWriter::ComputeEagerResolvedStringsCallback(Object* obj, void* arg) {
-  if (!obj->GetClass()->IsStringClass()) {
+void ImageWriter::CollectObjectsCallback(Object* obj, void* arg) {
+  reinterpret_cast<std::vector<Object*>*>(arg)->push_back(obj);
+}
+
+void ImageWriter::RunTasks(const std::vector<Task*>& tasks) {
+  Thread* self = Thread::Current();
+  if (thread_pool_.get() == nullptr) {
+    for (Task* task : tasks) {
+      task->Run(self);
+    }
     return;
   }
-  mirror::String* string = obj->AsString();
-  const uint16_t* utf16_string = string->GetCharArray()->GetData() + string->GetOffset();
-  for (auto dex_cache : Runtime::Current()->GetClassLinker()->GetDexCaches()) {
-    const DexFile& dex_file = *dex_cache.second->GetDexFile();
-    const DexFile::StringId* string_id;
-    if (UNLIKELY(string->GetLength() == 0)) {
-      string_id = dex_file.FindStringId("");
-    } else {
-      string_id = dex_file.FindStringId(utf16_string);
-    }
-    if (string_id != nullptr) {
-      // This string occurs in this dex file, assign the dex cache entry.
-      uint32_t string_idx = dex_file.GetIndexForStringId(*string_id);
-      if (dex_cache.second->GetResolvedString(string_idx) == NULL) {
-        dex_cache.second->SetResolvedString(string_idx, string);
+  thread_pool_->AddTasks(self, tasks);
+  thread_pool_->StartWorkers(self);
+  thread_pool_->Wait(self, true, true);
+}
+
+// Resolves the strings of a dex cache to the image strings with their value. Each dex cache is
+// written by a single task, which goes through the strings in walk order, so the string wired
+// is the same whatever the number of threads.
+class ImageWriter::EagerResolvedStringsTask : public Task {
+ public:
+  // The strings are paired with their modified UTF-8 value if they are compressed.
+  EagerResolvedStringsTask(DexCache* dex_cache,
+                           const std::vector<std::pair<String*, std::string>>* strings)
+    : dex_cache_(dex_cache), strings_(strings) {
+  }
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    const DexFile& dex_file = *dex_cache_->GetDexFile();
+    for (const std::pair<String*, std::string>& entry : *strings_) {
+      String* string = entry.first;
+      const DexFile::StringId* string_id;
+      if (UNLIKELY(string->GetLength() == 0)) {
+        string_id = dex_file.FindStringId("");
+      } else if (string->IsCompressed()) {
+        string_id = dex_file.FindStringId(entry.second.c_str());
+      } else {
+        string_id = dex_file.FindStringId(string->GetValue());
+      }
+      if (string_id != nullptr) {
+        // This string occurs in this dex file, assign the dex cache entry.
+        uint32_t string_idx = dex_file.GetIndexForStringId(*string_id);
+        if (dex_cache_->GetResolvedString(string_idx) == NULL) {
+          dex_cache_->SetResolvedString(string_idx, string);
+        }
       }
     }
   }
-}
+
+ private:
+  DexCache* const dex_cache_;
+  const std::vector<std::pair<String*, std::string>>* const strings_;
+};
 
 void ImageWriter::ComputeEagerResolvedStrings() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   ReaderMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
-  Runtime::Current()->GetHeap()->VisitObjects(ComputeEagerResolvedStringsCallback, this);
+  std::vector<Object*> objects;
+  Runtime::Current()->GetHeap()->VisitObjects(CollectObjectsCallback, &objects);
+  std::vector<std::pair<String*, std::string>> strings;
+  for (Object* obj : objects) {
+    if (obj->GetClass()->IsStringClass()) {
+      String* string = obj->AsString();
+      strings.push_back(std::make_pair(
+          string, string->IsCompressed() ? string->ToModifiedUtf8() : std::string()));
+    }
+  }
+  std::vector<EagerResolvedStringsTask*> tasks;
+  for (const auto& dex_cache : Runtime::Current()->GetClassLinker()->GetDexCaches()) {
+    tasks.push_back(new EagerResolvedStringsTask(dex_cache.second, &strings));
+  }
+  RunTasks(std::vector<Task*>(tasks.begin(), tasks.end()));
+  STLDeleteElements(&tasks);
 }
 
 bool ImageWriter::IsImageClass(Class* klass) {
@@ -391,7 +641,13 @@ void ImageWriter::CalculateObjectOffsets(Object* obj) {
         AssignImageOffset(interned);
       }
       // point those looking for this object to the interned version.
-      SetImageOffset(sirt_obj.get(), GetImageOffset(interned));
+      if (startup_layout_) {
+        SaveHashCode(sirt_obj.get(), sirt_obj.get());
+        sirt_obj->SetLockWord(interned->GetLockWord(false), false);
+        string_aliases_.push_back(std::make_pair(sirt_obj.get(), interned));
+      } else {
+        SetImageOffset(sirt_obj.get(), GetImageOffset(interned));
+      }
       return;
     }
     // else (obj == interned), nothing to do but fall through to the normal case
@@ -420,7 +676,6 @@ ObjectArray<Object>* ImageWriter::CreateImageRoots() const {
       self, ObjectArray<Object>::Alloc(self, object_array_class.get(), ImageHeader::kImageRootsMax));
   image_roots->Set<false>(ImageHeader::kResolutionMethod, runtime->GetResolutionMethod());
   image_roots->Set<false>(ImageHeader::kImtConflictMethod, runtime->GetImtConflictMethod());
-  image_roots->Set<false>(ImageHeader::kDefaultImt, runtime->GetDefaultImt());
   image_roots->Set<false>(ImageHeader::kCalleeSaveMethod,
                           runtime->GetCalleeSaveMethod(Runtime::kSaveAll));
   image_roots->Set<false>(ImageHeader::kRefsOnlySaveMethod,
@@ -465,6 +720,9 @@ void ImageWriter::WalkFieldsInOrder(mirror::Object* obj) {
     SirtRef<mirror::Class> klass(self, obj->GetClass());
     // visit the object itself.
     CalculateObjectOffsets(sirt_obj.get());
+    if (startup_layout_ && sirt_obj->IsClass() && IsStartupClass(sirt_obj->AsClass())) {
+      AssignStartupMembers(sirt_obj->AsClass());
+    }
     WalkInstanceFields(sirt_obj.get(), klass.get());
     // Walk static fields of a Class.
     if (sirt_obj->IsClass()) {
@@ -505,6 +763,20 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
   gc::Heap* heap = Runtime::Current()->GetHeap();
   DCHECK_EQ(0U, image_end_);
 
+  if (startup_layout_) {
+    for (const auto& dex_cache : Runtime::Current()->GetClassLinker()->GetDexCaches()) {
+      mirror::Object* objects[] = {
+        dex_cache.second, dex_cache.second->GetStrings(), dex_cache.second->GetResolvedTypes(),
+        dex_cache.second->GetResolvedMethods(), dex_cache.second->GetResolvedFields()
+      };
+      for (mirror::Object* object : objects) {
+        if (object != nullptr) {
+          dex_cache_objects_.insert(object);
+        }
+      }
+    }
+  }
+
   // Leave space for the header, but do not write it yet, we need to
   // know where image_roots is going to end up
   image_end_ += RoundUp(sizeof(ImageHeader), 8);  // 64-bit-alignment
@@ -516,8 +788,14 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
     DCHECK_LT(image_end_, image_->Size());
     // Clear any pre-existing monitors which may have been in the monitor words.
     heap->VisitObjects(WalkFieldsCallback, this);
+    if (startup_layout_) {
+      AssignBinOffsets();
+      dex_cache_objects_.clear();
+    }
     self->EndAssertNoThreadSuspension(old);
   }
+  CreateImageClassTable();
+  CreateImageInternTable();
 
   const byte* oat_file_begin = image_begin_ + RoundUp(image_end_, kPageSize);
   const byte* oat_file_end = oat_file_begin + oat_loaded_size;
@@ -529,10 +807,21 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
   const size_t heap_bytes_per_bitmap_byte = kBitsPerByte * kObjectAlignment;
   const size_t bitmap_bytes = RoundUp(image_end_, heap_bytes_per_bitmap_byte) /
       heap_bytes_per_bitmap_byte;
+  const size_t bitmap_offset = RoundUp(image_end_, kPageSize);
+  const size_t bitmap_size = RoundUp(bitmap_bytes, kPageSize);
+  const size_t class_table_size = class_table_slots_.size() * sizeof(ClassTable::ImageSlot);
+  const size_t intern_table_offset = RoundUp(bitmap_offset + bitmap_size + class_table_size,
+                                             kPageSize);
+  const size_t intern_table_size = intern_table_slots_.size() * sizeof(InternTable::ImageSlot);
   ImageHeader image_header(PointerToLowMemUInt32(image_begin_),
                            static_cast<uint32_t>(image_end_),
-                           RoundUp(image_end_, kPageSize),
-                           RoundUp(bitmap_bytes, kPageSize),
+                           bitmap_offset,
+                           bitmap_size,
+                           bitmap_offset + bitmap_size,
+                           class_table_size,
+                           intern_table_offset,
+                           intern_table_size,
+                           RoundUp(intern_table_offset + intern_table_size, kPageSize),
                            PointerToLowMemUInt32(GetImageAddress(image_roots.get())),
                            oat_file_->GetOatHeader().GetChecksum(),
                            PointerToLowMemUInt32(oat_file_begin),
@@ -544,6 +833,82 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
   // Note that image_end_ is left at end of used space
 }
 
+struct ImageClassTable {
+  ImageWriter* image_writer;
+  std::vector<std::pair<size_t, uint32_t>>* classes;
+};
+
+void ImageWriter::CreateImageClassTable() {
+  std::vector<std::pair<size_t, uint32_t>> classes;
+  ImageClassTable context;
+  context.image_writer = this;
+  context.classes = &classes;
+  Runtime::Current()->GetClassLinker()->VisitClasses(ImageClassTableVisitor, &context);
+  ClassTable::BuildImageSlots(classes, &class_table_slots_);
+}
+
+bool ImageWriter::ImageClassTableVisitor(Class* klass, void* arg) {
+  ImageClassTable* context = reinterpret_cast<ImageClassTable*>(arg);
+  // The image only has boot classes, which are all laid out by now.
+  CHECK(klass->GetClassLoader() == nullptr) << PrettyClass(klass);
+  CHECK(context->image_writer->IsImageOffsetAssigned(klass)) << PrettyClass(klass);
+  context->classes->push_back(
+      std::make_pair(ClassTable::HashDescriptor(ClassHelper(klass).GetDescriptor()),
+                     PointerToLowMemUInt32(context->image_writer->GetImageAddress(klass))));
+  return true;
+}
+
+struct ImageInternTable {
+  ImageWriter* image_writer;
+  std::vector<std::pair<int32_t, uint32_t> >* strings;
+};
+
+void ImageWriter::CreateImageInternTable() {
+  std::vector<std::pair<int32_t, uint32_t> > strings;
+  ImageInternTable context;
+  context.image_writer = this;
+  context.strings = &strings;
+  Runtime::Current()->GetInternTable()->VisitInterns(ImageInternTableVisitor, &context);
+  InternTable::BuildImageSlots(strings, &intern_table_slots_);
+}
+
+void ImageWriter::ImageInternTableVisitor(mirror::String* s, void* arg) {
+  ImageInternTable* context = reinterpret_cast<ImageInternTable*>(arg);
+  CHECK(context->image_writer->IsImageOffsetAssigned(s)) << s->ToModifiedUtf8();
+  context->strings->push_back(
+      std::make_pair(s->GetHashCode(),
+                     PointerToLowMemUInt32(context->image_writer->GetImageAddress(s))));
+}
+
+// Copies and fixes up a range of the objects. The copies are disjoint once the offsets are
+// assigned, only the relocations are collected by task.
+class ImageWriter::CopyAndFixupObjectsTask : public Task {
+ public:
+  CopyAndFixupObjectsTask(ImageWriter* image_writer, Object* const* begin, Object* const* end)
+    : image_writer_(image_writer), begin_(begin), end_(end) {
+  }
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    for (Object* const* it = begin_; it != end_; ++it) {
+      image_writer_->CopyAndFixupObject(*it, &relocations_);
+    }
+  }
+
+  const std::vector<uint32_t>& GetRelocations() const {
+    return relocations_;
+  }
+
+ private:
+  ImageWriter* const image_writer_;
+  Object* const* const begin_;
+  Object* const* const end_;
+  std::vector<uint32_t> relocations_;
+};
+
+// More ranges than threads, as the objects differ in size.
+static constexpr size_t kCopyTasksPerThread = 4;
+
 void ImageWriter::CopyAndFixupObjects()
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   Thread* self = Thread::Current();
@@ -553,7 +918,23 @@ void ImageWriter::CopyAndFixupObjects()
   heap->DisableObjectValidation();
   // TODO: Image spaces only?
   WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  heap->VisitObjects(CopyAndFixupObjectsCallback, this);
+  std::vector<Object*> objects;
+  heap->VisitObjects(CollectObjectsCallback, &objects);
+  size_t num_threads = (thread_pool_.get() != nullptr) ? thread_pool_->GetThreadCount() + 1 : 1u;
+  size_t num_tasks = std::min(objects.size(), num_threads * kCopyTasksPerThread);
+  std::vector<CopyAndFixupObjectsTask*> tasks;
+  for (size_t i = 0; i != num_tasks; ++i) {
+    Object* const* begin = &objects[0] + objects.size() * i / num_tasks;
+    Object* const* end = &objects[0] + objects.size() * (i + 1) / num_tasks;
+    tasks.push_back(new CopyAndFixupObjectsTask(this, begin, end));
+  }
+  RunTasks(std::vector<Task*>(tasks.begin(), tasks.end()));
+  // The relocations are sorted when encoded.
+  for (CopyAndFixupObjectsTask* task : tasks) {
+    image_relocations_.insert(image_relocations_.end(), task->GetRelocations().begin(),
+                              task->GetRelocations().end());
+  }
+  STLDeleteElements(&tasks);
   // Fix up the object previously had hash codes.
   for (const std::pair<mirror::Object*, uint32_t>& hash_pair : saved_hashes_) {
     hash_pair.first->SetLockWord(LockWord::FromHashCode(hash_pair.second), false);
@@ -562,27 +943,26 @@ void ImageWriter::CopyAndFixupObjects()
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
-void ImageWriter::CopyAndFixupObjectsCallback(Object* obj, void* arg) {
+void ImageWriter::CopyAndFixupObject(Object* obj, std::vector<uint32_t>* relocations) {
   DCHECK(obj != nullptr);
-  DCHECK(arg != nullptr);
-  ImageWriter* image_writer = reinterpret_cast<ImageWriter*>(arg);
   // see GetLocalAddress for similar computation
-  size_t offset = image_writer->GetImageOffset(obj);
-  byte* dst = image_writer->image_->Begin() + offset;
+  size_t offset = GetImageOffset(obj);
+  byte* dst = image_->Begin() + offset;
   const byte* src = reinterpret_cast<const byte*>(obj);
   size_t n = obj->SizeOf();
-  DCHECK_LT(offset + n, image_writer->image_->Size());
+  DCHECK_LT(offset + n, image_->Size());
   memcpy(dst, src, n);
   Object* copy = reinterpret_cast<Object*>(dst);
   // Write in a hash code of objects which have inflated monitors or a hash code in their monitor
   // word.
   copy->SetLockWord(LockWord(), false);
-  image_writer->FixupObject(obj, copy);
+  FixupObject(obj, copy, relocations);
 }
 
 class FixupVisitor {
  public:
-  FixupVisitor(ImageWriter* image_writer, Object* copy) : image_writer_(image_writer), copy_(copy) {
+  FixupVisitor(ImageWriter* image_writer, Object* copy, std::vector<uint32_t>* relocations)
+      : image_writer_(image_writer), copy_(copy), relocations_(relocations) {
   }
 
   void operator()(Object* obj, MemberOffset offset, bool /*is_static*/) const
@@ -592,22 +972,33 @@ class FixupVisitor {
     // image.
     copy_->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
         offset, image_writer_->GetImageAddress(ref));
+    if (ref != nullptr) {
+      image_writer_->AddImageRelocation(reinterpret_cast<byte*>(copy_) + offset.Int32Value(),
+                                        relocations_);
+    }
   }
 
   // java.lang.ref.Reference visitor.
   void operator()(mirror::Class* /*klass*/, mirror::Reference* ref) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
+    mirror::Object* referent = ref->GetReferent();
     copy_->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
-        mirror::Reference::ReferentOffset(), image_writer_->GetImageAddress(ref->GetReferent()));
+        mirror::Reference::ReferentOffset(), image_writer_->GetImageAddress(referent));
+    if (referent != nullptr) {
+      image_writer_->AddImageRelocation(reinterpret_cast<byte*>(copy_) +
+                                        mirror::Reference::ReferentOffset().Int32Value(),
+                                        relocations_);
+    }
   }
 
  private:
   ImageWriter* const image_writer_;
   mirror::Object* const copy_;
+  std::vector<uint32_t>* const relocations_;
 };
 
-void ImageWriter::FixupObject(Object* orig, Object* copy) {
+void ImageWriter::FixupObject(Object* orig, Object* copy, std::vector<uint32_t>* relocations) {
   DCHECK(orig != nullptr);
   DCHECK(copy != nullptr);
   if (kUseBakerOrBrooksReadBarrier) {
@@ -616,15 +1007,52 @@ void ImageWriter::FixupObject(Object* orig, Object* copy) {
       // Note the address 'copy' isn't the same as the image address of 'orig'.
       copy->SetReadBarrierPointer(GetImageAddress(orig));
       DCHECK_EQ(copy->GetReadBarrierPointer(), GetImageAddress(orig));
+#ifdef USE_BROOKS_READ_BARRIER
+      AddImageRelocation(&copy->x_rb_ptr_, relocations);
+#endif
     }
   }
-  FixupVisitor visitor(this, copy);
+  FixupVisitor visitor(this, copy, relocations);
   orig->VisitReferences<true /*visit class*/>(visitor, visitor);
+  if (orig->IsClass<kVerifyNone>()) {
+    // The member index is native memory of the compiler, the runtime builds its own.
+    copy->SetField64<false, false, kVerifyNone>(Class::MemberIndexOffset(), 0);
+  }
   if (orig->IsArtMethod<kVerifyNone>()) {
     FixupMethod(orig->AsArtMethod<kVerifyNone>(), down_cast<ArtMethod*>(copy));
+    AddPointerRelocation(copy, ArtMethod::EntryPointFromInterpreterOffset(), relocations);
+    AddPointerRelocation(copy, ArtMethod::NativeMethodOffset(), relocations);
+    AddPointerRelocation(copy, ArtMethod::EntryPointFromPortableCompiledCodeOffset(), relocations);
+    AddPointerRelocation(copy, ArtMethod::EntryPointFromQuickCompiledCodeOffset(), relocations);
+    AddPointerRelocation(copy, ArtMethod::NativeGcMapOffset(), relocations);
   }
 }
 
+void ImageWriter::AddPointerRelocation(Object* copy, MemberOffset offset,
+                                       std::vector<uint32_t>* relocations) const {
+  // The resolution and IMT conflict methods keep the entry points of the compiling runtime, they
+  // aren't relocated.
+  const byte* value = copy->GetFieldPtr<const byte*, kVerifyNone>(offset);
+  const ImageHeader* image_header = reinterpret_cast<const ImageHeader*>(image_->Begin());
+  if (value >= image_begin_ && value < image_header->GetOatFileEnd()) {
+    AddImageRelocation(reinterpret_cast<byte*>(copy) + offset.Int32Value(), relocations);
+  }
+}
+
+void ImageWriter::EncodeRelocations(std::vector<uint8_t>* relocations) {
+  Leb128EncodingVector encoder;
+  for (std::vector<uint32_t>* offsets : { &image_relocations_, &oat_relocations_ }) {
+    std::sort(offsets->begin(), offsets->end());
+    encoder.PushBackUnsigned(offsets->size());
+    uint32_t previous_offset = 0;
+    for (uint32_t offset : *offsets) {
+      encoder.PushBackUnsigned(offset - previous_offset);
+      previous_offset = offset;
+    }
+  }
+  *relocations = encoder.GetData();
+}
+
 void ImageWriter::FixupMethod(ArtMethod* orig, ArtMethod* copy) {
   // OatWriter replaces the code_ with an offset value. Here we re-adjust to a pointer relative to
   // oat_begin_
@@ -633,7 +1061,7 @@ void ImageWriter::FixupMethod(ArtMethod* orig, ArtMethod* copy) {
   if (UNLIKELY(orig == Runtime::Current()->GetResolutionMethod())) {
     copy->SetEntryPointFromPortableCompiledCode<kVerifyNone>(GetOatAddress(portable_resolution_trampoline_offset_));
     copy->SetEntryPointFromQuickCompiledCode<kVerifyNone>(GetOatAddress(quick_resolution_trampoline_offset_));
-  } else if (UNLIKELY(orig == Runtime::Current()->GetImtConflictMethod())) {
+  } else if (UNLIKELY(orig->IsImtConflictMethod())) {
     copy->SetEntryPointFromPortableCompiledCode<kVerifyNone>(GetOatAddress(portable_imt_conflict_trampoline_offset_));
     copy->SetEntryPointFromQuickCompiledCode<kVerifyNone>(GetOatAddress(quick_imt_conflict_trampoline_offset_));
   } else {
@@ -820,6 +1248,11 @@ void ImageWriter::SetPatchLocation(const CompilerDriver::PatchInformation* patch
   }
   *patch_location = value;
   oat_header.UpdateChecksum(patch_location, sizeof(value));
+  // Relative calls move with their target, absolute addresses move with the image.
+  if (!patch->IsCall() || !patch->AsCall()->IsRelative()) {
+    oat_relocations_.push_back(reinterpret_cast<uintptr_t>(patch_location) -
+                               reinterpret_cast<uintptr_t>(&oat_header));
+  }
 }
 
 }  // namespace art
@@ -19,17 +19,23 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "class_table.h"
 #include "driver/compiler_driver.h"
+#include "intern_table.h"
 #include "mem_map.h"
 #include "oat_file.h"
 #include "mirror/dex_cache.h"
 #include "os.h"
 #include "safe_map.h"
 #include "gc/space/space.h"
+#include "thread_pool.h"
 #include "UniquePtr.h"
 
 namespace art {
@@ -37,12 +43,21 @@ namespace art {
 // Write a Space built during compilation for use during execution.
 class ImageWriter {
  public:
-  explicit ImageWriter(const CompilerDriver& compiler_driver)
-      : compiler_driver_(compiler_driver), oat_file_(NULL), image_end_(0), image_begin_(NULL),
+  // With startup_layout, the objects are laid out by mutability and by use during startup, see
+  // Bin, rather than in the order they are reached. startup_classes lists the descriptors of
+  // the classes used during startup, it may be null. With compress_image, the image file is
+  // written in compressed blocks, see ImageHeader::GetCompressedBlocks.
+  ImageWriter(const CompilerDriver& compiler_driver, bool startup_layout,
+              const CompilerDriver::DescriptorSet* startup_classes, bool compress_image)
+      : compiler_driver_(compiler_driver), startup_layout_(startup_layout),
+        startup_classes_(startup_classes), compress_image_(compress_image), oat_file_(NULL),
+        image_end_(0), image_begin_(NULL),
         oat_data_begin_(NULL), interpreter_to_interpreter_bridge_offset_(0),
         interpreter_to_compiled_code_bridge_offset_(0), portable_imt_conflict_trampoline_offset_(0),
         portable_resolution_trampoline_offset_(0), quick_generic_jni_trampoline_offset_(0),
-        quick_imt_conflict_trampoline_offset_(0), quick_resolution_trampoline_offset_(0) {}
+        quick_imt_conflict_trampoline_offset_(0), quick_resolution_trampoline_offset_(0) {
+    std::fill(bin_sizes_, bin_sizes_ + kNumBins, 0);
+  }
 
   ~ImageWriter() {}
 
@@ -57,6 +72,21 @@ class ImageWriter {
   }
 
  private:
+  // The startup layout orders the image by bin, in walk order within a bin, so that the pages
+  // the zygote and its children write are together, and so are the pages read during startup.
+  enum Bin {
+    // Dex caches and their arrays, classes initialized at runtime or with non-final statics,
+    // native methods and the static methods of the classes initialized at runtime, which are
+    // written as the runtime resolves, initializes and registers natives.
+    kBinMutable,
+    // The other classes used during startup, with their methods, fields and method tables.
+    kBinStartup,
+    kBinClean,
+    // Strings, which are never written.
+    kBinString,
+    kNumBins,
+  };
+
   bool AllocMemory();
 
   // Mark the objects defined in this space in the given live bitmap.
@@ -68,6 +98,19 @@ class ImageWriter {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool IsImageOffsetAssigned(mirror::Object* object) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Deflates the monitor of the object and saves its hash code, keyed by key, before the lock
+  // word is replaced with the image offset.
+  void SaveHashCode(mirror::Object* object, mirror::Object* key)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // With the startup layout, objects are appended to their bin while the image is walked and
+  // temporarily hold their offset in the bin. AssignBinOffsets then lays the bins out.
+  Bin GetBin(mirror::Object* object) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  bool IsStartupClass(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  bool IsMutableClass(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AssignImageBin(mirror::Object* object, Bin bin) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AssignStartupMembers(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AssignBinOffsets() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   size_t GetImageOffset(mirror::Object* object) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   mirror::Object* GetImageAddress(mirror::Object* object) const
@@ -111,9 +154,8 @@ class ImageWriter {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Wire dex cache resolved strings to strings in the image to avoid runtime resolution.
+  class EagerResolvedStringsTask;
   void ComputeEagerResolvedStrings() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  static void ComputeEagerResolvedStringsCallback(mirror::Object* obj, void* arg)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Remove unwanted classes from various roots.
   void PruneNonImageClasses() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -130,6 +172,14 @@ class ImageWriter {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::ObjectArray<mirror::Object>* CreateImageRoots() const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Lays out the class table of the image classes, after their offsets are assigned.
+  void CreateImageClassTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool ImageClassTableVisitor(mirror::Class* klass, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Same for the intern table of the interned image strings.
+  void CreateImageInternTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void ImageInternTableVisitor(mirror::String* s, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void CalculateObjectOffsets(mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -141,13 +191,45 @@ class ImageWriter {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Creates the contiguous image in memory and adjusts pointers.
+  class CopyAndFixupObjectsTask;
   void CopyAndFixupObjects();
-  static void CopyAndFixupObjectsCallback(mirror::Object* obj, void* arg)
+  void CopyAndFixupObject(mirror::Object* obj, std::vector<uint32_t>* relocations)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void FixupMethod(mirror::ArtMethod* orig, mirror::ArtMethod* copy)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void FixupObject(mirror::Object* orig, mirror::Object* copy)
+  void FixupObject(mirror::Object* orig, mirror::Object* copy,
+                   std::vector<uint32_t>* relocations)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Appends the objects of the heap, in walk order, to the vector arg.
+  static void CollectObjectsCallback(mirror::Object* obj, void* arg);
+
+  // Runs the tasks on thread_pool_ and the calling thread, or on the calling thread alone without
+  // a thread pool. The caller keeps ownership of the tasks.
+  void RunTasks(const std::vector<Task*>& tasks);
+
+  // Records in relocations that the word at address, in the image being written, holds an
+  // address of the image or of the oat file, for relocating the image at load time.
+  void AddImageRelocation(const void* address, std::vector<uint32_t>* relocations) const {
+    relocations->push_back(reinterpret_cast<const byte*>(address) - image_->Begin());
+  }
+  // Same for a native pointer field of a copied object, if it points into the image or oat file.
+  void AddPointerRelocation(mirror::Object* copy, MemberOffset offset,
+                            std::vector<uint32_t>* relocations) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Lays out the relocation section, see ImageHeader::GetRelocationsOffset.
+  void EncodeRelocations(std::vector<uint8_t>* relocations);
+
+  // A section of the image file, the first one is the image itself.
+  struct FileSection {
+    size_t offset;
+    const byte* data;
+    size_t size;
+  };
+  // Writes the sections to the image file, as they are or in compressed blocks.
+  bool WriteSections(File* image_file, const FileSection* sections, size_t num_sections);
+  bool WriteCompressedSections(File* image_file, const FileSection* sections,
+                               size_t num_sections);
 
   // Patches references in OatFile to expect runtime addresses.
   void PatchOatCodeAndMethods()
@@ -157,6 +239,24 @@ class ImageWriter {
 
   const CompilerDriver& compiler_driver_;
 
+  const bool startup_layout_;
+  const CompilerDriver::DescriptorSet* const startup_classes_;
+  const bool compress_image_;
+
+  // The dex caches and their arrays, for the startup layout.
+  std::set<mirror::Object*> dex_cache_objects_;
+
+  // The objects of each bin in walk order and the size of the bin, for the startup layout.
+  std::vector<mirror::Object*> bin_objects_[kNumBins];
+  size_t bin_sizes_[kNumBins];
+
+  // The strings standing for their interned version and that version, for the startup layout.
+  std::vector<std::pair<mirror::Object*, mirror::Object*> > string_aliases_;
+
+  // The compiler threads but the calling one, for copying the objects and resolving the strings
+  // while the image is written. Null with a single compiler thread.
+  UniquePtr<ThreadPool> thread_pool_;
+
   // oat file with code for this image
   OatFile* oat_file_;
 
@@ -178,6 +278,17 @@ class ImageWriter {
   // Image bitmap which lets us know where the objects inside of the image reside.
   UniquePtr<gc::accounting::ContinuousSpaceBitmap> image_bitmap_;
 
+  // Class table of the image classes, written after the image bitmap.
+  std::vector<ClassTable::ImageSlot> class_table_slots_;
+
+  // Intern table of the interned image strings, written after the class table.
+  std::vector<InternTable::ImageSlot> intern_table_slots_;
+
+  // Offsets of the words of the image and of the oat data the image is relocated with, written
+  // after the intern table.
+  std::vector<uint32_t> image_relocations_;
+  std::vector<uint32_t> oat_relocations_;
+
   // Offset from oat_data_begin_ to the stubs.
   uint32_t interpreter_to_interpreter_bridge_offset_;
   uint32_t interpreter_to_compiled_code_bridge_offset_;
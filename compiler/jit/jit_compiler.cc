@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_compiler.h"
+
+#include <algorithm>
+
+#include "atomic.h"
+#include "base/logging.h"
+#include "dex_instruction-inl.h"
+#include "entrypoints/entrypoint_utils.h"
+#include "instrumentation.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "method_reference.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "oat.h"
+#include "object_utils.h"
+#include "runtime.h"
+#include "sirt_ref.h"
+#include "thread.h"
+#include "utils.h"
+#include "verifier/method_verifier.h"
+
+namespace art {
+namespace jit {
+
+JitCompiler* JitCompiler::Create() {
+  return new JitCompiler();
+}
+
+JitCompiler::JitCompiler() {
+  compiler_options_.reset(new CompilerOptions);
+  verification_results_.reset(new VerificationResults(compiler_options_.get()));
+  method_inliner_map_.reset(new DexFileToMethodInlinerMap);
+  callbacks_.reset(new CompilerCallbacksImpl(verification_results_.get(),
+                                             method_inliner_map_.get()));
+  cumulative_logger_.reset(new CumulativeLogger("jit times"));
+  // The quick compiler emits Thumb2 for arm.
+  InstructionSet instruction_set = (kRuntimeISA == kArm) ? kThumb2 : kRuntimeISA;
+  // The code runs on the CPU compiling it, so it can use whatever that CPU supports.
+  InstructionSetFeatures instruction_set_features =
+      InstructionSetFeatures::GuessInstructionSetFeatures();
+  // Not compiling an image: the code calls through the dex cache, so there is nothing to patch.
+  compiler_driver_.reset(new CompilerDriver(compiler_options_.get(), verification_results_.get(),
+                                            method_inliner_map_.get(), Compiler::kQuick,
+                                            instruction_set, instruction_set_features,
+                                            false, nullptr, 1, false, false, false,
+                                            cumulative_logger_.get()));
+  compiler_driver_->SetSupportBootImageFixup(false);
+  compiler_driver_->SetSupportOsr(true);
+}
+
+JitCompiler::~JitCompiler() {
+}
+
+bool JitCompiler::VerifyMethod(Thread* self, mirror::ArtMethod* method) {
+  MethodHelper mh(method);
+  const DexFile& dex_file = mh.GetDexFile();
+  SirtRef<mirror::DexCache> dex_cache(self, mh.GetDexCache());
+  SirtRef<mirror::ClassLoader> class_loader(self, mh.GetClassLoader());
+  // Classes aren't loaded: that could run the code of a class loader on the compiler thread. The
+  // verifier treats them as unresolved.
+  verifier::MethodVerifier verifier(&dex_file, &dex_cache, &class_loader, &mh.GetClassDef(),
+                                    mh.GetCodeItem(), method->GetDexMethodIndex(), method,
+                                    method->GetAccessFlags(), false, true);
+  if (!verifier.Verify()) {
+    return false;
+  }
+  return callbacks_->MethodVerified(&verifier);
+}
+
+// Whether DEX-to-DEX quickened instructions of the method. The quick backend only knows the
+// instructions of the dex format, those methods stay in the interpreter.
+static bool HasQuickenedInstructions(const DexFile::CodeItem* code_item) {
+  const uint16_t* insns = code_item->insns_;
+  const Instruction* end = Instruction::At(insns + code_item->insns_size_in_code_units_);
+  for (const Instruction* inst = Instruction::At(insns); inst < end; inst = inst->Next()) {
+    Instruction::Code opcode = inst->Opcode();
+    if (opcode == Instruction::RETURN_VOID_BARRIER ||
+        (opcode >= Instruction::IGET_QUICK && opcode <= Instruction::CONST_STRING_QUICK)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool JitCompiler::CompileMethod(Thread* self, mirror::ArtMethod* method) {
+  if (HasQuickenedInstructions(MethodHelper(method).GetCodeItem())) {
+    return false;
+  }
+  if (!VerifyMethod(self, method)) {
+    return false;
+  }
+  TimingLogger timings("JitCompiler::CompileMethod", false, false);
+  timings.StartSplit("CompileOne");
+  compiler_driver_->CompileOne(method, &timings);
+  timings.EndSplit();
+  MethodHelper mh(method);
+  MethodReference method_ref(&mh.GetDexFile(), method->GetDexMethodIndex());
+  const CompiledMethod* compiled_method = compiler_driver_->GetCompiledMethod(method_ref);
+  if (compiled_method == nullptr || compiled_method->GetQuickCode() == nullptr) {
+    return false;
+  }
+  return AddToCodeCache(self, method, compiled_method);
+}
+
+bool JitCompiler::AddToCodeCache(Thread* self, mirror::ArtMethod* method,
+                                 const CompiledMethod* compiled_method) {
+  const SwapVector& gc_map = compiled_method->GetGcMap();
+  const SwapVector& mapping_table = compiled_method->GetMappingTable();
+  const SwapVector& vmap_table = compiled_method->GetVmapTable();
+  const SwapVector& code = *compiled_method->GetQuickCode();
+  DCHECK_LE(GetInstructionSetAlignment(compiled_method->GetInstructionSet()),
+            JitCodeCache::kAlignment);
+
+  // The tables, the header and the code, with the padding needed to align the code first.
+  size_t tables_size = gc_map.size() + mapping_table.size() + vmap_table.size();
+  size_t code_offset = RoundUp(tables_size + sizeof(OatMethodHeader), JitCodeCache::kAlignment);
+  // May suspend all threads to collect the code cache.
+  uint8_t* base = Runtime::Current()->GetJit()->ReserveCode(self, method,
+                                                            code_offset + code.size());
+  if (base == nullptr) {
+    LOG(WARNING) << "Jit code cache full, not compiling " << PrettyMethod(method);
+    return false;
+  }
+  uint8_t* code_ptr = base + code_offset;
+  OatMethodHeader* method_header = reinterpret_cast<OatMethodHeader*>(code_ptr) - 1;
+  uint8_t* gc_map_ptr = reinterpret_cast<uint8_t*>(method_header) - tables_size;
+  uint8_t* mapping_table_ptr = gc_map_ptr + gc_map.size();
+  uint8_t* vmap_table_ptr = mapping_table_ptr + mapping_table.size();
+  std::copy(gc_map.begin(), gc_map.end(), gc_map_ptr);
+  std::copy(mapping_table.begin(), mapping_table.end(), mapping_table_ptr);
+  std::copy(vmap_table.begin(), vmap_table.end(), vmap_table_ptr);
+  // As in oat files, the offsets are from the start of the table to the code, 0 without a table.
+  method_header->mapping_table_offset_ =
+      mapping_table.empty() ? 0u : static_cast<uint32_t>(code_ptr - mapping_table_ptr);
+  method_header->vmap_table_offset_ =
+      vmap_table.empty() ? 0u : static_cast<uint32_t>(code_ptr - vmap_table_ptr);
+  method_header->code_size_ = code.size();
+  std::copy(code.begin(), code.end(), code_ptr);
+  JitCodeCache::FlushInstructionCache(code_ptr, code_ptr + code.size());
+
+  method->SetFrameSizeInBytes(compiled_method->GetFrameSizeInBytes());
+  method->SetCoreSpillMask(compiled_method->GetCoreSpillMask());
+  method->SetFpSpillMask(compiled_method->GetFpSpillMask());
+  method->SetNativeGcMap(gc_map.empty() ? nullptr : gc_map_ptr);
+  // The code and the frame layout must be visible before the entry point is, other threads call
+  // the method without synchronizing with the compiler thread.
+  QuasiAtomic::MembarStoreStore();
+  // Registered before the entry point is installed, as the interpreter looks them up once the
+  // method has code in the cache.
+  JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+  const std::vector<uint32_t>& osr_entries = compiled_method->GetOsrEntries();
+  for (size_t i = 0; i < osr_entries.size(); i += 2) {
+    code_cache->AddOsrEntry(self, method, osr_entries[i],
+                            code_ptr + osr_entries[i + 1] + compiled_method->CodeDelta());
+  }
+  const void* entry_point = code_ptr + compiled_method->CodeDelta();
+  Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, entry_point,
+                                                              GetPortableToQuickBridge(), false);
+  return true;
+}
+
+}  // namespace jit
+}  // namespace art
+
+extern "C" void* jit_load() {
+  return art::jit::JitCompiler::Create();
+}
+
+extern "C" void jit_unload(void* handle) {
+  delete reinterpret_cast<art::jit::JitCompiler*>(handle);
+}
+
+extern "C" bool jit_compile_method(void* handle, art::mirror::ArtMethod* method,
+                                   art::Thread* self)
+    SHARED_LOCKS_REQUIRED(art::Locks::mutator_lock_);
+
+extern "C" bool jit_compile_method(void* handle, art::mirror::ArtMethod* method,
+                                   art::Thread* self) {
+  return reinterpret_cast<art::jit::JitCompiler*>(handle)->CompileMethod(self, method);
+}
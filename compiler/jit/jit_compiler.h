@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_JIT_JIT_COMPILER_H_
+#define ART_COMPILER_JIT_JIT_COMPILER_H_
+
+#include "base/mutex.h"
+#include "base/timing_logger.h"
+#include "compiled_method.h"
+#include "dex/quick/dex_file_to_method_inliner_map.h"
+#include "dex/verification_results.h"
+#include "driver/compiler_callbacks_impl.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class Thread;
+
+namespace jit {
+
+// The compiler behind the runtime's Jit, loaded with libart-compiler.so. It runs the quick
+// compiler on one method at a time through CompilerDriver::CompileOne and copies the result into
+// the code cache of the runtime.
+class JitCompiler {
+ public:
+  // Called before the runtime is started, CompilerDriver checks it.
+  static JitCompiler* Create();
+
+  ~JitCompiler();
+
+  // Compiles method and installs its code, returns false if it wasn't compiled.
+  bool CompileMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  JitCompiler();
+
+  // Records the verification of method the quick compiler relies on, which is otherwise only kept
+  // while compiling ahead of time.
+  bool VerifyMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copies the code and tables of compiled_method into the code cache and makes it the code of
+  // method. Returns false if the code doesn't fit in the code cache, even after collecting it.
+  bool AddToCodeCache(Thread* self, mirror::ArtMethod* method,
+                      const CompiledMethod* compiled_method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  UniquePtr<CompilerOptions> compiler_options_;
+  UniquePtr<VerificationResults> verification_results_;
+  UniquePtr<DexFileToMethodInlinerMap> method_inliner_map_;
+  UniquePtr<CompilerCallbacksImpl> callbacks_;
+  UniquePtr<CumulativeLogger> cumulative_logger_;
+  UniquePtr<CompilerDriver> compiler_driver_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompiler);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_COMPILER_JIT_JIT_COMPILER_H_
@@ -41,6 +41,10 @@ extern "C" JNIEXPORT jint JNICALL Java_MyClassNatives_sbar(JNIEnv*, jclass, jint
   return count + 1;
 }
 
+extern "C" JNIEXPORT jint JNICALL Java_MyClassNatives_criticalAdd(jint x, jint y) {
+  return x + y;
+}
+
 namespace art {
 
 class JniCompilerTest : public CommonCompilerTest {
@@ -663,7 +667,6 @@ TEST_F(JniCompilerTest, LocalReferenceTableClearingTest) {
 }
 
 void my_arraycopy(JNIEnv* env, jclass klass, jobject src, jint src_pos, jobject dst, jint dst_pos, jint length) {
-  EXPECT_TRUE(env->IsSameObject(JniCompilerTest::jklass_, klass));
   EXPECT_TRUE(env->IsSameObject(JniCompilerTest::jklass_, dst));
   EXPECT_TRUE(env->IsSameObject(JniCompilerTest::jobj_, src));
   EXPECT_EQ(1234, src_pos);
@@ -1491,4 +1494,69 @@ TEST_F(JniCompilerTest, StackArgsMixed) {
                              f7, i8, f8, i9, f9, i10, f10);
 }
 
+jint Java_MyClassNatives_fastSbar(JNIEnv* env, jclass, jint count) {
+  // A fast native keeps the thread runnable.
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  EXPECT_EQ(Thread::Current()->GetJniEnv(), env);
+  return count + 1;
+}
+
+TEST_F(JniCompilerTest, FastNativeAnnotation) {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "fastSbar", "(I)I",
+               reinterpret_cast<void*>(&Java_MyClassNatives_fastSbar));
+
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(jmethod_);
+    EXPECT_TRUE(method->IsFastNative());
+    EXPECT_FALSE(method->IsCriticalNative());
+  }
+  EXPECT_EQ(43, env_->CallStaticIntMethod(jklass_, jmethod_, 42));
+  EXPECT_FALSE(env_->ExceptionCheck());
+}
+
+TEST_F(JniCompilerTest, CriticalNativeAnnotation) {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "criticalAdd", "(II)I",
+               reinterpret_cast<void*>(&Java_MyClassNatives_criticalAdd));
+
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(jmethod_);
+    EXPECT_TRUE(method->IsFastNative());
+    EXPECT_TRUE(method->IsCriticalNative());
+  }
+  EXPECT_EQ(3, env_->CallStaticIntMethod(jklass_, jmethod_, 1, 2));
+  EXPECT_EQ(-7, env_->CallStaticIntMethod(jklass_, jmethod_, 3, -10));
+}
+
+TEST_F(JniCompilerTest, CriticalNativeDlsymLookup) {
+  TEST_DISABLED_FOR_PORTABLE();
+  // Java_MyClassNatives_criticalAdd is found with dlsym while the thread stays runnable.
+  SetUpForTest(true, "criticalAdd", "(II)I", nullptr);
+
+  EXPECT_EQ(5, env_->CallStaticIntMethod(jklass_, jmethod_, 2, 3));
+  EXPECT_FALSE(env_->ExceptionCheck());
+}
+
+jdouble Java_MyClassNatives_criticalMixed(jint i, jlong l, jfloat f, jdouble d) {
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  EXPECT_EQ(1, i);
+  EXPECT_EQ(INT64_C(0x100000002), l);
+  EXPECT_EQ(3.0f, f);
+  EXPECT_EQ(4.5, d);
+  return i + l + f + d;
+}
+
+TEST_F(JniCompilerTest, CriticalNativeMixedArgs) {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "criticalMixed", "(IJFD)D",
+               reinterpret_cast<void*>(&Java_MyClassNatives_criticalMixed));
+
+  jdouble result = env_->CallStaticDoubleMethod(jklass_, jmethod_, 1, INT64_C(0x100000002), 3.0f,
+                                                4.5);
+  EXPECT_EQ(1 + static_cast<jdouble>(INT64_C(0x100000002)) + 3.0 + 4.5, result);
+}
+
 }  // namespace art
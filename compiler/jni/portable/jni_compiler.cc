@@ -58,6 +58,9 @@ JniCompiler::JniCompiler(LlvmCompilationUnit* cunit,
       func_(NULL), elf_func_idx_(0) {
   // Check: Ensure that JNI compiler will only get "native" method
   CHECK(dex_compilation_unit->IsNative());
+  // The native code of a critical native takes no JNIEnv, which the stub below always passes.
+  CHECK_EQ(dex_compilation_unit->GetAccessFlags() & kAccCriticalNative, 0U)
+      << "@CriticalNative is only supported by the quick JNI compiler";
 }
 
 CompiledMethod* JniCompiler::Compile() {
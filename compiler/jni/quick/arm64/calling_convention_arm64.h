@@ -48,7 +48,8 @@ class Arm64ManagedRuntimeCallingConvention FINAL : public ManagedRuntimeCallingC
 
 class Arm64JniCallingConvention FINAL : public JniCallingConvention {
  public:
-  explicit Arm64JniCallingConvention(bool is_static, bool is_synchronized, const char* shorty);
+  explicit Arm64JniCallingConvention(bool is_static, bool is_synchronized, bool is_critical_native,
+                                     const char* shorty);
   ~Arm64JniCallingConvention() OVERRIDE {}
   // Calling convention
   ManagedRegister ReturnRegister() OVERRIDE;
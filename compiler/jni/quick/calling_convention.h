@@ -269,7 +269,9 @@ class ManagedRuntimeCallingConvention : public CallingConvention {
 // callee saves for frames above this one.
 class JniCallingConvention : public CallingConvention {
  public:
-  static JniCallingConvention* Create(bool is_static, bool is_synchronized, const char* shorty,
+  // A critical native takes neither the JNIEnv* nor the jclass, only the primitive arguments.
+  static JniCallingConvention* Create(bool is_static, bool is_synchronized,
+                                      bool is_critical_native, const char* shorty,
                                       InstructionSet instruction_set);
 
   // Size of frame excluding space for outgoing args (its assumed Method* is
@@ -346,16 +348,24 @@ class JniCallingConvention : public CallingConvention {
     kObjectOrClass = 1
   };
 
-  explicit JniCallingConvention(bool is_static, bool is_synchronized, const char* shorty,
-                                size_t frame_pointer_size)
-      : CallingConvention(is_static, is_synchronized, shorty, frame_pointer_size) {}
+  explicit JniCallingConvention(bool is_static, bool is_synchronized, bool is_critical_native,
+                                const char* shorty, size_t frame_pointer_size)
+      : CallingConvention(is_static, is_synchronized, shorty, frame_pointer_size),
+        is_critical_native_(is_critical_native) {}
 
   // Number of stack slots for outgoing arguments, above which the SIRT is
   // located
   virtual size_t NumberOfOutgoingStackArgs() = 0;
 
  protected:
-  size_t NumberOfExtraArgumentsForJni();
+  bool IsCriticalNative() const {
+    return is_critical_native_;
+  }
+  // The JNIEnv* and the jclass, zero for critical natives.
+  size_t NumberOfExtraArgumentsForJni() const;
+
+ private:
+  const bool is_critical_native_;
 };
 
 }  // namespace art
@@ -26,6 +26,7 @@
 #include "driver/compiler_driver.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "jni_internal.h"
+#include "utils.h"
 #include "utils/assembler.h"
 #include "utils/managed_register.h"
 #include "utils/arm/managed_register_arm.h"
@@ -46,6 +47,9 @@ static void CopyParameter(Assembler* jni_asm,
 static void SetNativeParameter(Assembler* jni_asm,
                                JniCallingConvention* jni_conv,
                                ManagedRegister in_reg);
+static CompiledMethod* ArtJniCompileCriticalNativeMethod(CompilerDriver* driver,
+                                                         const char* shorty,
+                                                         InstructionSet instruction_set);
 
 // Generate the JNI bridge for the given method, general contract:
 // - Arguments are in the managed runtime format, either on stack or in
@@ -64,10 +68,16 @@ CompiledMethod* ArtJniCompileMethodInternal(CompilerDriver* driver,
   if (instruction_set == kThumb2) {
     instruction_set = kArm;
   }
+  if ((access_flags & kAccCriticalNative) != 0) {
+    CHECK(is_static && !is_synchronized) << PrettyMethod(method_idx, dex_file);
+    return ArtJniCompileCriticalNativeMethod(driver, shorty, instruction_set);
+  }
+  // Fast natives take the same stub, JniMethodStart and JniMethodEnd don't change the thread
+  // state for them.
   const bool is_64_bit_target = Is64BitInstructionSet(instruction_set);
   // Calling conventions used to iterate over parameters to method
   UniquePtr<JniCallingConvention> main_jni_conv(
-      JniCallingConvention::Create(is_static, is_synchronized, shorty, instruction_set));
+      JniCallingConvention::Create(is_static, is_synchronized, false, shorty, instruction_set));
   bool reference_return = main_jni_conv->IsReturnAReference();
 
   UniquePtr<ManagedRuntimeCallingConvention> mr_conv(
@@ -87,7 +97,8 @@ CompiledMethod* ArtJniCompileMethodInternal(CompilerDriver* driver,
   }
 
   UniquePtr<JniCallingConvention> end_jni_conv(
-      JniCallingConvention::Create(is_static, is_synchronized, jni_end_shorty, instruction_set));
+      JniCallingConvention::Create(is_static, is_synchronized, false, jni_end_shorty,
+                                   instruction_set));
 
   // Assembler that holds generated instructions
   UniquePtr<Assembler> jni_asm(Assembler::Create(instruction_set));
@@ -431,6 +442,111 @@ CompiledMethod* ArtJniCompileMethodInternal(CompilerDriver* driver,
                             main_jni_conv->FpSpillMask());
 }
 
+// Generate the bridge to a critical native, a static method taking and returning primitives only
+// whose native code takes neither the JNIEnv* nor the jclass. The native code can't reach the
+// heap nor block for long, so the thread stays Runnable and no SIRT, local reference state or
+// suspend check is needed: the bridge shuffles the arguments and makes the call. Only the top of
+// the managed stack is recorded, for the dlsym lookup stub to find the method on the first call.
+static CompiledMethod* ArtJniCompileCriticalNativeMethod(CompilerDriver* driver,
+                                                         const char* shorty,
+                                                         InstructionSet instruction_set) {
+  const bool is_64_bit_target = Is64BitInstructionSet(instruction_set);
+  UniquePtr<JniCallingConvention> jni_conv(
+      JniCallingConvention::Create(true, false, true, shorty, instruction_set));
+  UniquePtr<ManagedRuntimeCallingConvention> mr_conv(
+      ManagedRuntimeCallingConvention::Create(true, false, shorty, instruction_set));
+  UniquePtr<Assembler> jni_asm(Assembler::Create(instruction_set));
+
+  // 1. Build the frame saving all callee saves, the exception delivery of a failed lookup
+  //    restores them.
+  const size_t frame_size(jni_conv->FrameSize());
+  const std::vector<ManagedRegister>& callee_save_regs = jni_conv->CalleeSaveRegisters();
+  __ BuildFrame(frame_size, mr_conv->MethodRegister(), callee_save_regs, mr_conv->EntrySpills());
+
+  // 2. Write out the end of the quick frames.
+  if (is_64_bit_target) {
+    __ StoreStackPointerToThread64(Thread::TopOfManagedStackOffset<8>());
+    __ StoreImmediateToThread64(Thread::TopOfManagedStackPcOffset<8>(), 0,
+                                mr_conv->InterproceduralScratchRegister());
+  } else {
+    __ StoreStackPointerToThread32(Thread::TopOfManagedStackOffset<4>());
+    __ StoreImmediateToThread32(Thread::TopOfManagedStackPcOffset<4>(), 0,
+                                mr_conv->InterproceduralScratchRegister());
+  }
+
+  // 3. Move frame down to allow space for out going args.
+  const size_t out_arg_size = jni_conv->OutArgSize();
+  __ IncreaseFrameSize(out_arg_size);
+
+  // 4. Place the arguments in the native convention. They all come from the stack, in any order.
+  mr_conv->ResetIterator(FrameOffset(frame_size + out_arg_size));
+  jni_conv->ResetIterator(FrameOffset(out_arg_size));
+  while (mr_conv->HasNext()) {
+    CHECK(jni_conv->HasNext());
+    CopyParameter(jni_asm.get(), mr_conv.get(), jni_conv.get(), frame_size, out_arg_size);
+    mr_conv->Next();
+    jni_conv->Next();
+  }
+
+  // 5. Plant call to native code associated with method.
+  jni_conv->ResetIterator(FrameOffset(out_arg_size));
+  __ Call(jni_conv->MethodStackOffset(), mirror::ArtMethod::NativeMethodOffset(),
+          mr_conv->InterproceduralScratchRegister());
+
+  // 6. Fix differences in result widths.
+  if (jni_conv->RequiresSmallResultTypeExtension()) {
+    if (jni_conv->GetReturnType() == Primitive::kPrimByte ||
+        jni_conv->GetReturnType() == Primitive::kPrimShort) {
+      __ SignExtend(jni_conv->ReturnRegister(),
+                    Primitive::ComponentSize(jni_conv->GetReturnType()));
+    } else if (jni_conv->GetReturnType() == Primitive::kPrimBoolean ||
+               jni_conv->GetReturnType() == Primitive::kPrimChar) {
+      __ ZeroExtend(jni_conv->ReturnRegister(),
+                    Primitive::ComponentSize(jni_conv->GetReturnType()));
+    }
+  }
+
+  // 7. Move the result to the managed return register, through the frame as the conventions
+  //    may not use the same one.
+  if (jni_conv->SizeOfReturnValue() != 0) {
+    FrameOffset return_save_location = jni_conv->ReturnValueSaveLocation();
+    if (instruction_set == kMips && jni_conv->GetReturnType() == Primitive::kPrimDouble &&
+        return_save_location.Uint32Value() % 8 != 0) {
+      // Ensure doubles are 8-byte aligned for MIPS
+      return_save_location = FrameOffset(return_save_location.Uint32Value() + kMipsPointerSize);
+    }
+    CHECK_LT(return_save_location.Uint32Value(), frame_size + out_arg_size);
+    __ Store(return_save_location, jni_conv->ReturnRegister(), jni_conv->SizeOfReturnValue());
+    __ Load(mr_conv->ReturnRegister(), return_save_location, mr_conv->SizeOfReturnValue());
+  }
+
+  // 8. Move frame up now we're done with the out arg space.
+  __ DecreaseFrameSize(out_arg_size);
+
+  // 9. Deliver the UnsatisfiedLinkError of a failed lookup, the native code itself can't throw.
+  __ ExceptionPoll(jni_conv->InterproceduralScratchRegister(), 0);
+
+  // 10. Remove activation.
+  __ RemoveFrame(frame_size, callee_save_regs);
+
+  // 11. Finalize code generation
+  __ EmitSlowPaths();
+  size_t cs = __ CodeSize();
+  if (instruction_set == kArm64) {
+    // Test that we do not exceed the buffer size.
+    CHECK(cs < arm64::kBufferSizeArm64);
+  }
+  std::vector<uint8_t> managed_code(cs);
+  MemoryRegion code(&managed_code[0], managed_code.size());
+  __ FinalizeInstructions(code);
+  return new CompiledMethod(driver,
+                            instruction_set,
+                            managed_code,
+                            frame_size,
+                            jni_conv->CoreSpillMask(),
+                            jni_conv->FpSpillMask());
+}
+
 // Copy a single parameter from the managed to the JNI calling convention
 static void CopyParameter(Assembler* jni_asm,
                           ManagedRuntimeCallingConvention* mr_conv,
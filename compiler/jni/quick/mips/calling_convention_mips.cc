@@ -105,12 +105,15 @@ const ManagedRegisterEntrySpills& MipsManagedRuntimeCallingConvention::EntrySpil
 // JNI calling convention
 
 MipsJniCallingConvention::MipsJniCallingConvention(bool is_static, bool is_synchronized,
-                                                   const char* shorty)
-    : JniCallingConvention(is_static, is_synchronized, shorty, kFramePointerSize) {
+                                                   bool is_critical_native, const char* shorty)
+    : JniCallingConvention(is_static, is_synchronized, is_critical_native, shorty,
+                           kFramePointerSize) {
   // Compute padding to ensure longs and doubles are not split in AAPCS. Ignore the 'this' jobject
-  // or jclass for static methods and the JNIEnv. We start at the aligned register A2.
+  // or jclass for static methods and the JNIEnv. We start at the aligned register A2, or at the
+  // first one for critical natives which take neither.
   size_t padding = 0;
-  for (size_t cur_arg = IsStatic() ? 0 : 1, cur_reg = 2; cur_arg < NumArgs(); cur_arg++) {
+  for (size_t cur_arg = IsStatic() ? 0 : 1, cur_reg = NumberOfExtraArgumentsForJni() == 0 ? 0 : 2;
+       cur_arg < NumArgs(); cur_arg++) {
     if (IsParamALongOrDouble(cur_arg)) {
       if ((cur_reg & 1) != 0) {
         padding += 4;
@@ -163,7 +166,7 @@ size_t MipsJniCallingConvention::OutArgSize() {
 void MipsJniCallingConvention::Next() {
   JniCallingConvention::Next();
   size_t arg_pos = itr_args_ - NumberOfExtraArgumentsForJni();
-  if ((itr_args_ >= 2) &&
+  if ((itr_args_ >= NumberOfExtraArgumentsForJni()) &&
       (arg_pos < NumArgs()) &&
       IsParamALongOrDouble(arg_pos)) {
     // itr_slots_ needs to be an even number, according to AAPCS.
@@ -187,9 +190,10 @@ static const Register kJniArgumentRegisters[] = {
 ManagedRegister MipsJniCallingConvention::CurrentParamRegister() {
   CHECK_LT(itr_slots_, 4u);
   int arg_pos = itr_args_ - NumberOfExtraArgumentsForJni();
-  if ((itr_args_ >= 2) && IsParamALongOrDouble(arg_pos)) {
-    CHECK_EQ(itr_slots_, 2u);
-    return MipsManagedRegister::FromRegisterPair(A2_A3);
+  if ((itr_args_ >= NumberOfExtraArgumentsForJni()) && IsParamALongOrDouble(arg_pos)) {
+    // Only a critical native, which has no JNIEnv*, can pass a long in the first pair.
+    CHECK(itr_slots_ == 2u || (itr_slots_ == 0u && IsCriticalNative())) << itr_slots_;
+    return MipsManagedRegister::FromRegisterPair(itr_slots_ == 0u ? A0_A1 : A2_A3);
   } else {
     return
       MipsManagedRegister::FromCoreRegister(kJniArgumentRegisters[itr_slots_]);
@@ -204,11 +208,10 @@ FrameOffset MipsJniCallingConvention::CurrentParamStackOffset() {
 }
 
 size_t MipsJniCallingConvention::NumberOfOutgoingStackArgs() {
-  size_t static_args = IsStatic() ? 1 : 0;  // count jclass
   // regular argument parameters and this
   size_t param_args = NumArgs() + NumLongOrDoubleArgs();
-  // count JNIEnv*
-  return static_args + param_args + 1;
+  // count JNIEnv* and jclass
+  return NumberOfExtraArgumentsForJni() + param_args;
 }
 }  // namespace mips
 }  // namespace art
@@ -111,8 +111,9 @@ const ManagedRegisterEntrySpills& X86ManagedRuntimeCallingConvention::EntrySpill
 // JNI calling convention
 
 X86JniCallingConvention::X86JniCallingConvention(bool is_static, bool is_synchronized,
-                                                 const char* shorty)
-    : JniCallingConvention(is_static, is_synchronized, shorty, kFramePointerSize) {
+                                                 bool is_critical_native, const char* shorty)
+    : JniCallingConvention(is_static, is_synchronized, is_critical_native, shorty,
+                           kFramePointerSize) {
   callee_save_regs_.push_back(X86ManagedRegister::FromCpuRegister(EBP));
   callee_save_regs_.push_back(X86ManagedRegister::FromCpuRegister(ESI));
   callee_save_regs_.push_back(X86ManagedRegister::FromCpuRegister(EDI));
@@ -153,11 +154,10 @@ FrameOffset X86JniCallingConvention::CurrentParamStackOffset() {
 }
 
 size_t X86JniCallingConvention::NumberOfOutgoingStackArgs() {
-  size_t static_args = IsStatic() ? 1 : 0;  // count jclass
   // regular argument parameters and this
   size_t param_args = NumArgs() + NumLongOrDoubleArgs();
-  // count JNIEnv* and return pc (pushed after Method*)
-  size_t total_args = static_args + param_args + 2;
+  // count JNIEnv* and jclass, and return pc (pushed after Method*)
+  size_t total_args = NumberOfExtraArgumentsForJni() + param_args + 1;
   return total_args;
 }
 
@@ -32,6 +32,8 @@
 #include "utils_llvm.h"
 #include "verifier/method_verifier.h"
 
+#include <algorithm>
+
 #include <llvm/LinkAllPasses.h>
 #include <llvm/Support/ManagedStatic.h>
 #include <llvm/Support/TargetSelect.h>
@@ -119,12 +121,13 @@ CompilerLLVM::CompilerLLVM(CompilerDriver* driver, InstructionSet insn_set)
 
 
 CompilerLLVM::~CompilerLLVM() {
+  STLDeleteElements(&thread_cunits_);
 }
 
 
-LlvmCompilationUnit* CompilerLLVM::AllocateCompilationUnit() {
+LlvmCompilationUnit* CompilerLLVM::AllocateCompilationUnit(bool reusable) {
   MutexLock GUARD(Thread::Current(), next_cunit_id_lock_);
-  LlvmCompilationUnit* cunit = new LlvmCompilationUnit(this, next_cunit_id_++);
+  LlvmCompilationUnit* cunit = new LlvmCompilationUnit(this, next_cunit_id_++, reusable);
   if (!bitcode_filename_.empty()) {
     cunit->SetBitcodeFileName(StringPrintf("%s-%u",
                                            bitcode_filename_.c_str(),
@@ -134,9 +137,44 @@ LlvmCompilationUnit* CompilerLLVM::AllocateCompilationUnit() {
 }
 
 
+// The constants and types of a context are never freed, a thread starts over with a new unit
+// after that many methods to bound them.
+static constexpr size_t kMaxMethodsPerThreadUnit = 1000;
+
+LlvmCompilationUnit* CompilerLLVM::GetThreadCompilationUnit() {
+  if (!bitcode_filename_.empty()) {
+    // Each unit writes the bitcode of its method to its own file.
+    return nullptr;
+  }
+  CompilerTls* tls = compiler_driver_->GetTls();
+  LlvmCompilationUnit* cunit = static_cast<LlvmCompilationUnit*>(tls->GetLlvmCompilationUnit());
+  if (cunit != nullptr && cunit->GetNumMaterialized() < kMaxMethodsPerThreadUnit) {
+    return cunit;
+  }
+  LlvmCompilationUnit* new_cunit = AllocateCompilationUnit(true);
+  {
+    MutexLock mu(Thread::Current(), next_cunit_id_lock_);
+    if (cunit != nullptr) {
+      thread_cunits_.erase(std::find(thread_cunits_.begin(), thread_cunits_.end(), cunit));
+      delete cunit;
+    }
+    thread_cunits_.push_back(new_cunit);
+  }
+  tls->SetLlvmCompilationUnit(new_cunit);
+  return new_cunit;
+}
+
+
 CompiledMethod* CompilerLLVM::
 CompileDexMethod(DexCompilationUnit* dex_compilation_unit, InvokeType invoke_type) {
-  UniquePtr<LlvmCompilationUnit> cunit(AllocateCompilationUnit());
+  // The LLVM context, the runtime support module and the target machine are set up once per
+  // compiler thread, rather than per method.
+  UniquePtr<LlvmCompilationUnit> owned_cunit;
+  LlvmCompilationUnit* cunit = GetThreadCompilationUnit();
+  if (cunit == nullptr) {
+    owned_cunit.reset(AllocateCompilationUnit(false));
+    cunit = owned_cunit.get();
+  }
 
   cunit->SetDexCompilationUnit(dex_compilation_unit);
   cunit->SetCompilerDriver(compiler_driver_);
@@ -150,25 +188,39 @@ CompileDexMethod(DexCompilationUnit* dex_compilation_unit, InvokeType invoke_typ
                    dex_compilation_unit->GetDexMethodIndex(),
                    dex_compilation_unit->GetClassLoader(),
                    *dex_compilation_unit->GetDexFile(),
-                   cunit.get());
+                   cunit);
 
   cunit->Materialize();
 
-  return new CompiledMethod(*compiler_driver_, compiler_driver_->GetInstructionSet(),
-                            cunit->GetElfObject(),
-                            dex_compilation_unit->GetVerifiedMethod()->GetDexGcMap(),
-                            cunit->GetDexCompilationUnit()->GetSymbol());
+  CompiledMethod* compiled_method =
+      new CompiledMethod(*compiler_driver_, compiler_driver_->GetInstructionSet(),
+                         cunit->GetElfObject(),
+                         dex_compilation_unit->GetVerifiedMethod()->GetDexGcMap(),
+                         cunit->GetDexCompilationUnit()->GetSymbol());
+  if (owned_cunit.get() == nullptr) {
+    cunit->Reset();
+  }
+  return compiled_method;
 }
 
 
 CompiledMethod* CompilerLLVM::
 CompileNativeMethod(DexCompilationUnit* dex_compilation_unit) {
-  UniquePtr<LlvmCompilationUnit> cunit(AllocateCompilationUnit());
+  UniquePtr<LlvmCompilationUnit> owned_cunit;
+  LlvmCompilationUnit* cunit = GetThreadCompilationUnit();
+  if (cunit == nullptr) {
+    owned_cunit.reset(AllocateCompilationUnit(false));
+    cunit = owned_cunit.get();
+  }
 
   UniquePtr<JniCompiler> jni_compiler(
-      new JniCompiler(cunit.get(), compiler_driver_, dex_compilation_unit));
+      new JniCompiler(cunit, compiler_driver_, dex_compilation_unit));
 
-  return jni_compiler->Compile();
+  CompiledMethod* compiled_method = jni_compiler->Compile();
+  if (owned_cunit.get() == nullptr) {
+    cunit->Reset();
+  }
+  return compiled_method;
 }
 
 
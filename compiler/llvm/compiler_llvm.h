@@ -82,7 +82,11 @@ class CompilerLLVM {
   CompiledMethod* CompileNativeMethod(DexCompilationUnit* dex_compilation_unit);
 
  private:
-  LlvmCompilationUnit* AllocateCompilationUnit();
+  LlvmCompilationUnit* AllocateCompilationUnit(bool reusable);
+
+  // Returns the compilation unit of the calling compiler thread, which compiles its methods one
+  // after the other, or nullptr if each method needs its own unit.
+  LlvmCompilationUnit* GetThreadCompilationUnit();
 
   CompilerDriver* const compiler_driver_;
 
@@ -91,6 +95,9 @@ class CompilerLLVM {
   Mutex next_cunit_id_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   size_t next_cunit_id_ GUARDED_BY(next_cunit_id_lock_);
 
+  // The compilation units of the compiler threads, owned here as the threads may outlive them.
+  std::vector<LlvmCompilationUnit*> thread_cunits_ GUARDED_BY(next_cunit_id_lock_);
+
   std::string bitcode_filename_;
 
   DISALLOW_COPY_AND_ASSIGN(CompilerLLVM);
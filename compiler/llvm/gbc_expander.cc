@@ -945,6 +945,10 @@ bool GBCExpanderPass::EmitIntrinsicStringLengthOrIsEmpty(llvm::CallInst& call_in
                                 art::mirror::String::CountOffset().Int32Value(),
                                 irb_.getJIntTy(),
                                 kTBAAConstJObject);
+  if (art::mirror::String::kUseStringCompression) {
+    string_count = irb_.CreateAnd(string_count,
+                                  irb_.getJInt(~art::mirror::String::kCompressedFlag));
+  }
   if (is_empty) {
     llvm::Value* count_equals_zero = irb_.CreateICmpEQ(string_count,
                                                        irb_.getJInt(0));
@@ -95,8 +95,10 @@ CreateGBCExpanderPass(const IntrinsicHelper& intrinsic_helper, IRBuilder& irb,
 ::llvm::Module* makeLLVMModuleContents(::llvm::Module* module);
 
 
-LlvmCompilationUnit::LlvmCompilationUnit(const CompilerLLVM* compiler_llvm, size_t cunit_id)
-    : compiler_llvm_(compiler_llvm), cunit_id_(cunit_id) {
+LlvmCompilationUnit::LlvmCompilationUnit(const CompilerLLVM* compiler_llvm, size_t cunit_id,
+                                         bool reusable)
+    : compiler_llvm_(compiler_llvm), cunit_id_(cunit_id), reusable_(reusable),
+      num_materialized_(0) {
   driver_ = NULL;
   dex_compilation_unit_ = NULL;
   llvm_info_.reset(new LLVMInfo());
@@ -127,6 +129,16 @@ LlvmCompilationUnit::LlvmCompilationUnit(const CompilerLLVM* compiler_llvm, size
   }
 
   irb_->SetRuntimeSupport(runtime_support_.get());
+
+  if (reusable_) {
+    for (::llvm::Module::iterator it = module_->begin(), end = module_->end(); it != end; ++it) {
+      base_functions_.insert(it);
+    }
+    for (::llvm::Module::global_iterator it = module_->global_begin(), end = module_->global_end();
+         it != end; ++it) {
+      base_globals_.insert(it);
+    }
+  }
 }
 
 
@@ -136,6 +148,39 @@ LlvmCompilationUnit::~LlvmCompilationUnit() {
 }
 
 
+void LlvmCompilationUnit::Reset() {
+  CHECK(reusable_);
+  // Drop the references between the added functions first, as they are erased one by one.
+  std::vector< ::llvm::Function*> functions;
+  for (::llvm::Module::iterator it = module_->begin(), end = module_->end(); it != end; ++it) {
+    if (base_functions_.find(it) == base_functions_.end()) {
+      functions.push_back(it);
+    }
+  }
+  for (::llvm::Function* function : functions) {
+    function->dropAllReferences();
+  }
+  for (::llvm::Function* function : functions) {
+    function->eraseFromParent();
+  }
+  std::vector< ::llvm::GlobalVariable*> globals;
+  for (::llvm::Module::global_iterator it = module_->global_begin(), end = module_->global_end();
+       it != end; ++it) {
+    if (base_globals_.find(it) == base_globals_.end()) {
+      globals.push_back(it);
+    }
+  }
+  for (::llvm::GlobalVariable* global : globals) {
+    global->dropAllReferences();
+  }
+  for (::llvm::GlobalVariable* global : globals) {
+    global->eraseFromParent();
+  }
+  elf_object_.clear();
+  dex_compilation_unit_ = NULL;
+}
+
+
 InstructionSet LlvmCompilationUnit::GetInstructionSet() const {
   return compiler_llvm_->GetInstructionSet();
 }
@@ -170,6 +215,7 @@ bool LlvmCompilationUnit::Materialize() {
   }
 
   // Compile and prelink ::llvm::Module
+  ++num_materialized_;
   if (!MaterializeToString(elf_object_)) {
     LOG(ERROR) << "Failed to materialize compilation unit " << cunit_id_;
     return false;
@@ -202,26 +248,29 @@ bool LlvmCompilationUnit::MaterializeToRawOStream(::llvm::raw_ostream& out_strea
   CompilerDriver::InstructionSetToLLVMTarget(GetInstructionSet(), &target_triple, &target_cpu,
                                              &target_attr);
 
-  std::string errmsg;
-  const ::llvm::Target* target =
-    ::llvm::TargetRegistry::lookupTarget(target_triple, errmsg);
+  if (target_machine_.get() == NULL) {
+    std::string errmsg;
+    const ::llvm::Target* target =
+      ::llvm::TargetRegistry::lookupTarget(target_triple, errmsg);
 
-  CHECK(target != NULL) << errmsg;
+    CHECK(target != NULL) << errmsg;
 
-  // Target options
-  ::llvm::TargetOptions target_options;
-  target_options.FloatABIType = ::llvm::FloatABI::Soft;
-  target_options.NoFramePointerElim = true;
-  target_options.UseSoftFloat = false;
-  target_options.EnableFastISel = false;
+    // Target options
+    ::llvm::TargetOptions target_options;
+    target_options.FloatABIType = ::llvm::FloatABI::Soft;
+    target_options.NoFramePointerElim = true;
+    target_options.UseSoftFloat = false;
+    target_options.EnableFastISel = false;
 
-  // Create the ::llvm::TargetMachine
-  ::llvm::OwningPtr< ::llvm::TargetMachine> target_machine(
-    target->createTargetMachine(target_triple, target_cpu, target_attr, target_options,
-                                ::llvm::Reloc::Static, ::llvm::CodeModel::Small,
-                                ::llvm::CodeGenOpt::Aggressive));
+    // Create the ::llvm::TargetMachine
+    target_machine_.reset(
+      target->createTargetMachine(target_triple, target_cpu, target_attr, target_options,
+                                  ::llvm::Reloc::Static, ::llvm::CodeModel::Small,
+                                  ::llvm::CodeGenOpt::Aggressive));
 
-  CHECK(target_machine.get() != NULL) << "Failed to create target machine";
+    CHECK(target_machine_.get() != NULL) << "Failed to create target machine";
+  }
+  ::llvm::TargetMachine* target_machine = target_machine_.get();
 
   // Add target data
   const ::llvm::DataLayout* data_layout = target_machine->getDataLayout();
@@ -278,7 +327,10 @@ bool LlvmCompilationUnit::MaterializeToRawOStream(::llvm::raw_ostream& out_strea
   pm_builder.DisableUnitAtATime = 1;
   pm_builder.populateFunctionPassManager(fpm);
   pm_builder.populateModulePassManager(pm);
-  pm.add(::llvm::createStripDeadPrototypesPass());
+  if (!reusable_) {
+    // The runtime support builder keeps the declarations of a reusable unit.
+    pm.add(::llvm::createStripDeadPrototypesPass());
+  }
 
   // Add passes to emit ELF image
   {
@@ -29,6 +29,7 @@
 #include "safe_map.h"
 
 #include <UniquePtr.h>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -38,8 +39,10 @@ namespace art {
 
 namespace llvm {
   class Function;
+  class GlobalVariable;
   class LLVMContext;
   class Module;
+  class TargetMachine;
   class raw_ostream;
 }
 
@@ -99,12 +102,26 @@ class LlvmCompilationUnit {
     return elf_object_;
   }
 
+  // Removes the functions and globals added to the module since the unit was created, and the
+  // ELF object, so that the unit compiles the next method with its context, runtime support and
+  // target machine already set up. Only for units created to be reused, see CompilerLLVM.
+  void Reset();
+
+  size_t GetNumMaterialized() const {
+    return num_materialized_;
+  }
+
  private:
   LlvmCompilationUnit(const CompilerLLVM* compiler_llvm,
-                      size_t cunit_id);
+                      size_t cunit_id,
+                      bool reusable);
 
   const CompilerLLVM* compiler_llvm_;
   const size_t cunit_id_;
+  // A reusable unit keeps the runtime support declarations that no method uses, as Reset() only
+  // removes what the methods added.
+  const bool reusable_;
+  size_t num_materialized_;
 
   UniquePtr< ::llvm::LLVMContext> context_;
   UniquePtr<IRBuilder> irb_;
@@ -119,6 +136,14 @@ class LlvmCompilationUnit {
 
   std::string elf_object_;
 
+  // Created on the first materialization, as the lookup of the target and the creation of the
+  // machine are costly.
+  UniquePtr< ::llvm::TargetMachine> target_machine_;
+
+  // The functions and globals of the module once the unit is set up, which Reset() keeps.
+  std::set<const ::llvm::Function*> base_functions_;
+  std::set<const ::llvm::GlobalVariable*> base_globals_;
+
   SafeMap<const ::llvm::Function*, CompiledMethod*> compiled_methods_map_;
 
   void CheckCodeAlign(uint32_t offset) const;
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_MAPPING_TABLE_BUILDER_H_
+#define ART_COMPILER_MAPPING_TABLE_BUILDER_H_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "leb128.h"
+#include "mapping_table.h"
+#include "utils.h"
+
+namespace art {
+
+// Encodes the pc to dex and dex to pc entries of a method in the format read by MappingTable.
+// The entries of each kind must be added in increasing native pc offset order.
+class MappingTableBuilder {
+ public:
+  MappingTableBuilder() {}
+
+  void AddPcToDexEntry(uint32_t native_pc_offset, uint32_t dex_pc) {
+    DCHECK(pc_to_dex_.empty() || pc_to_dex_.back().first <= native_pc_offset);
+    pc_to_dex_.push_back(std::make_pair(native_pc_offset, dex_pc));
+  }
+
+  void AddDexToPcEntry(uint32_t native_pc_offset, uint32_t dex_pc) {
+    DCHECK(dex_to_pc_.empty() || dex_to_pc_.back().first <= native_pc_offset);
+    dex_to_pc_.push_back(std::make_pair(native_pc_offset, dex_pc));
+  }
+
+  void Build(std::vector<uint8_t>* table) const {
+    uint32_t max_native_pc_offset = 0u;
+    uint32_t max_dex_pc = 0u;
+    for (const std::pair<uint32_t, uint32_t>& entry : pc_to_dex_) {
+      max_native_pc_offset = std::max(max_native_pc_offset, entry.first);
+      max_dex_pc = std::max(max_dex_pc, entry.second);
+    }
+    for (const std::pair<uint32_t, uint32_t>& entry : dex_to_pc_) {
+      max_native_pc_offset = std::max(max_native_pc_offset, entry.first);
+      max_dex_pc = std::max(max_dex_pc, entry.second);
+    }
+    size_t native_pc_bits = BitsNeeded(max_native_pc_offset);
+    size_t dex_pc_bits = BitsNeeded(max_dex_pc);
+    size_t entry_bits = native_pc_bits + dex_pc_bits;
+
+    uint32_t total_entries = pc_to_dex_.size() + dex_to_pc_.size();
+    uint32_t pc_to_dex_entries = pc_to_dex_.size();
+    size_t header_size = UnsignedLeb128Size(total_entries) +
+        UnsignedLeb128Size(pc_to_dex_entries) + 2u;
+    table->clear();
+    table->resize(header_size + RoundUp(total_entries * entry_bits, 8u) / 8u, 0u);
+    uint8_t* write_pos = &(*table)[0];
+    write_pos = EncodeUnsignedLeb128(write_pos, total_entries);
+    write_pos = EncodeUnsignedLeb128(write_pos, pc_to_dex_entries);
+    *write_pos++ = native_pc_bits;
+    *write_pos++ = dex_pc_bits;
+    DCHECK_EQ(static_cast<size_t>(write_pos - &(*table)[0]), header_size);
+
+    size_t bit_offset = 0u;
+    for (const std::pair<uint32_t, uint32_t>& entry : pc_to_dex_) {
+      WriteBits(write_pos, bit_offset, entry.first, native_pc_bits);
+      WriteBits(write_pos, bit_offset + native_pc_bits, entry.second, dex_pc_bits);
+      bit_offset += entry_bits;
+    }
+    for (const std::pair<uint32_t, uint32_t>& entry : dex_to_pc_) {
+      WriteBits(write_pos, bit_offset, entry.first, native_pc_bits);
+      WriteBits(write_pos, bit_offset + native_pc_bits, entry.second, dex_pc_bits);
+      bit_offset += entry_bits;
+    }
+
+    if (kIsDebugBuild) {
+      // Verify the encoded table holds the expected data.
+      MappingTable mapping_table(&(*table)[0]);
+      CHECK_EQ(mapping_table.TotalSize(), total_entries);
+      CHECK_EQ(mapping_table.PcToDexSize(), pc_to_dex_entries);
+      auto it = mapping_table.PcToDexBegin();
+      for (const std::pair<uint32_t, uint32_t>& entry : pc_to_dex_) {
+        CHECK_EQ(entry.first, it.NativePcOffset());
+        CHECK_EQ(entry.second, it.DexPc());
+        ++it;
+      }
+      CHECK(it == mapping_table.PcToDexEnd());
+      auto it2 = mapping_table.DexToPcBegin();
+      for (const std::pair<uint32_t, uint32_t>& entry : dex_to_pc_) {
+        CHECK_EQ(entry.first, it2.NativePcOffset());
+        CHECK_EQ(entry.second, it2.DexPc());
+        ++it2;
+      }
+      CHECK(it2 == mapping_table.DexToPcEnd());
+    }
+  }
+
+ private:
+  static size_t BitsNeeded(uint32_t value) {
+    return (value != 0u) ? 32u - CLZ(value) : 0u;
+  }
+
+  static void WriteBits(uint8_t* data, size_t bit_offset, uint32_t value, size_t num_bits) {
+    for (size_t i = 0u; i != num_bits; ++i, ++bit_offset) {
+      if ((value & (1u << i)) != 0u) {
+        data[bit_offset / 8u] |= 1u << (bit_offset % 8u);
+      }
+    }
+  }
+
+  // The (native pc offset, dex pc) pairs of each kind.
+  std::vector<std::pair<uint32_t, uint32_t>> pc_to_dex_;
+  std::vector<std::pair<uint32_t, uint32_t>> dex_to_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappingTableBuilder);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_MAPPING_TABLE_BUILDER_H_
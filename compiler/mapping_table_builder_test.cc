@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mapping_table_builder.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+TEST(MappingTableBuilderTest, Empty) {
+  MappingTableBuilder builder;
+  std::vector<uint8_t> data;
+  builder.Build(&data);
+  MappingTable table(&data[0]);
+  EXPECT_EQ(0u, table.TotalSize());
+  EXPECT_EQ(data.size(), table.EncodedSize());
+  EXPECT_TRUE(table.PcToDexBegin() == table.PcToDexEnd());
+  EXPECT_TRUE(table.DexToPcBegin() == table.DexToPcEnd());
+  uint32_t dex_pc;
+  EXPECT_FALSE(table.FindPcToDex(0u, &dex_pc));
+  EXPECT_FALSE(table.FindDexToPc(0u, &dex_pc));
+}
+
+TEST(MappingTableBuilderTest, FindByNativePcOffset) {
+  MappingTableBuilder builder;
+  for (uint32_t i = 0; i != 100u; ++i) {
+    builder.AddPcToDexEntry(i * 37u + 2u, (i * 13u) % 257u);
+  }
+  builder.AddDexToPcEntry(40u, 3u);
+  builder.AddDexToPcEntry(5000u, 1u);
+  std::vector<uint8_t> data;
+  builder.Build(&data);
+
+  MappingTable table(&data[0]);
+  EXPECT_EQ(102u, table.TotalSize());
+  EXPECT_EQ(100u, table.PcToDexSize());
+  EXPECT_EQ(2u, table.DexToPcSize());
+  EXPECT_EQ(data.size(), table.EncodedSize());
+  uint32_t dex_pc;
+  for (uint32_t i = 0; i != 100u; ++i) {
+    ASSERT_TRUE(table.FindPcToDex(i * 37u + 2u, &dex_pc));
+    EXPECT_EQ((i * 13u) % 257u, dex_pc);
+    EXPECT_FALSE(table.FindPcToDex(i * 37u + 3u, &dex_pc));
+  }
+  EXPECT_FALSE(table.FindPcToDex(0u, &dex_pc));
+  EXPECT_FALSE(table.FindPcToDex(5000u, &dex_pc));
+  ASSERT_TRUE(table.FindDexToPc(5000u, &dex_pc));
+  EXPECT_EQ(1u, dex_pc);
+  ASSERT_TRUE(table.FindDexToPc(40u, &dex_pc));
+  EXPECT_EQ(3u, dex_pc);
+  EXPECT_FALSE(table.FindDexToPc(39u, &dex_pc));
+}
+
+}  // namespace art
@@ -34,10 +34,14 @@
 #include "safe_map.h"
 #include "scoped_thread_state_change.h"
 #include "sirt_ref-inl.h"
+#include "thread_pool.h"
 #include "verifier/method_verifier.h"
+#include "verifier/verifier_deps.h"
 
 namespace art {
 
+constexpr size_t OatWriter::kNumCodeTiers;
+
 #define DCHECK_OFFSET() \
   DCHECK_EQ(static_cast<off_t>(file_offset + relative_offset), out->Seek(0, kSeekCurrent)) \
     << "file_offset=" << file_offset << " relative_offset=" << relative_offset
@@ -87,6 +91,8 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     size_oat_dex_file_methods_offsets_(0),
     size_oat_class_type_(0),
     size_oat_class_status_(0),
+    size_oat_class_verifier_deps_(0),
+    size_oat_class_hot_fields_(0),
     size_oat_class_method_bitmaps_(0),
     size_oat_class_method_offsets_(0) {
   size_t offset;
@@ -131,7 +137,7 @@ OatWriter::~OatWriter() {
 }
 
 struct OatWriter::GcMapDataAccess {
-  static const std::vector<uint8_t>* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
+  static const SwapVector* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
     return &compiled_method->GetGcMap();
   }
 
@@ -150,7 +156,7 @@ struct OatWriter::GcMapDataAccess {
 };
 
 struct OatWriter::MappingTableDataAccess {
-  static const std::vector<uint8_t>* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
+  static const SwapVector* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
     return &compiled_method->GetMappingTable();
   }
 
@@ -172,7 +178,7 @@ struct OatWriter::MappingTableDataAccess {
 };
 
 struct OatWriter::VmapTableDataAccess {
-  static const std::vector<uint8_t>* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
+  static const SwapVector* GetData(const CompiledMethod* compiled_method) ALWAYS_INLINE {
     return &compiled_method->GetVmapTable();
   }
 
@@ -242,7 +248,14 @@ class OatWriter::OatDexMethodVisitor : public DexMethodVisitor {
   OatDexMethodVisitor(OatWriter* writer, size_t offset)
     : DexMethodVisitor(writer, offset),
       oat_class_index_(0u),
-      method_offsets_index_(0u) {
+      method_offsets_index_(0u),
+      code_tier_(kCodeTierHot) {
+  }
+
+  // Starts another visit of the dex files, for the methods whose code is in code_tier.
+  void StartCodeTier(CodeTier code_tier) {
+    oat_class_index_ = 0u;
+    code_tier_ = code_tier;
   }
 
   bool StartClass(const DexFile* dex_file, size_t class_def_index) {
@@ -258,14 +271,21 @@ class OatWriter::OatDexMethodVisitor : public DexMethodVisitor {
   }
 
  protected:
+  bool IsInCodeTier(const OatClass* oat_class) const {
+    return oat_class->GetCodeTier(method_offsets_index_) == code_tier_;
+  }
+
   size_t oat_class_index_;
   size_t method_offsets_index_;
+  CodeTier code_tier_;
 };
 
 class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
  public:
-  InitOatClassesMethodVisitor(OatWriter* writer, size_t offset)
+  InitOatClassesMethodVisitor(OatWriter* writer, size_t offset,
+                              std::vector<OatClass*>* oat_classes)
     : DexMethodVisitor(writer, offset),
+      oat_classes_(oat_classes),
       compiled_methods_(),
       num_non_null_compiled_methods_(0u) {
     compiled_methods_.reserve(256u);
@@ -275,6 +295,7 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
     DexMethodVisitor::StartClass(dex_file, class_def_index);
     compiled_methods_.clear();
     num_non_null_compiled_methods_ = 0u;
+    code_tiers_.clear();
     return true;
   }
 
@@ -289,6 +310,9 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
     compiled_methods_.push_back(compiled_method);
     if (compiled_method != nullptr) {
         ++num_non_null_compiled_methods_;
+        if (writer_->compiler_driver_->ProfilePresent()) {
+          code_tiers_.push_back(writer_->GetCodeTier(*dex_file_, method_idx));
+        }
     }
     return true;
   }
@@ -305,16 +329,33 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
       status = mirror::Class::kStatusNotReady;
     }
 
+    std::vector<uint32_t> verifier_deps;
+    if (status == mirror::Class::kStatusRetryVerificationAtRuntime) {
+      const verifier::VerifierDeps* deps =
+          writer_->compiler_driver_->GetVerificationResults()->GetVerifierDeps(class_ref);
+      if (deps != nullptr && deps->IsValid()) {
+        deps->Encode(&verifier_deps);
+      }
+    }
+
+    std::vector<uint32_t> hot_fields;
+    Runtime::Current()->GetClassLinker()->GetHotFieldIndices(*dex_file_, class_def_index_,
+                                                             &hot_fields);
+
     OatClass* oat_class = new OatClass(offset_, compiled_methods_,
-                                       num_non_null_compiled_methods_, status);
-    writer_->oat_classes_.push_back(oat_class);
+                                       num_non_null_compiled_methods_, status, verifier_deps,
+                                       hot_fields);
+    oat_class->code_tiers_.swap(code_tiers_);
+    oat_classes_->push_back(oat_class);
     offset_ += oat_class->SizeOf();
     return DexMethodVisitor::EndClass();
   }
 
  private:
+  std::vector<OatClass*>* const oat_classes_;
   std::vector<CompiledMethod*> compiled_methods_;
   size_t num_non_null_compiled_methods_;
+  std::vector<uint8_t> code_tiers_;
 };
 
 class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
@@ -328,15 +369,17 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
     CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
-    if (compiled_method != nullptr) {
+    if (compiled_method != nullptr && !IsInCodeTier(oat_class)) {
+      ++method_offsets_index_;
+    } else if (compiled_method != nullptr) {
       // Derived from CompiledMethod.
       uint32_t quick_code_offset = 0;
       uint32_t frame_size_in_bytes = kStackAlignment;
       uint32_t core_spill_mask = 0;
       uint32_t fp_spill_mask = 0;
 
-      const std::vector<uint8_t>* portable_code = compiled_method->GetPortableCode();
-      const std::vector<uint8_t>* quick_code = compiled_method->GetQuickCode();
+      const SwapVector* portable_code = compiled_method->GetPortableCode();
+      const SwapVector* quick_code = compiled_method->GetQuickCode();
       if (portable_code != nullptr) {
         CHECK(quick_code == nullptr);
         size_t oat_method_offsets_offset =
@@ -356,7 +399,7 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
         std::vector<uint8_t>* cfi_info = writer_->compiler_driver_->GetCallFrameInformation();
         if (cfi_info != nullptr) {
           // Copy in the FDE, if present
-          const std::vector<uint8_t>* fde = compiled_method->GetCFIInfo();
+          const SwapVector* fde = compiled_method->GetCFIInfo();
           if (fde != nullptr) {
             // Copy the information into cfi_info and then fix the address in the new copy.
             int cur_offset = cfi_info->size();
@@ -409,7 +452,7 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
         } else {
           status = mirror::Class::kStatusNotReady;
         }
-        const std::vector<uint8_t>& gc_map = compiled_method->GetGcMap();
+        const SwapVector& gc_map = compiled_method->GetGcMap();
         size_t gc_map_size = gc_map.size() * sizeof(gc_map[0]);
         bool is_native = (it.GetMemberAccessFlags() & kAccNative) != 0;
         CHECK(gc_map_size != 0 || is_native || status < mirror::Class::kStatusVerified)
@@ -465,7 +508,7 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
       DCHECK_LT(method_offsets_index_, oat_class->method_offsets_.size());
       DCHECK_EQ(DataAccess::GetOffset(oat_class, method_offsets_index_), 0u);
 
-      const std::vector<uint8_t>* map = DataAccess::GetData(compiled_method);
+      const SwapVector* map = DataAccess::GetData(compiled_method);
       uint32_t map_size = map->size() * sizeof((*map)[0]);
       if (map_size != 0u) {
         auto it = dedupe_map_.find(map);
@@ -487,7 +530,7 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
  private:
   // Deduplication is already done on a pointer basis by the compiler driver,
   // so we can simply compare the pointers to find out if things are duplicated.
-  SafeMap<const std::vector<uint8_t>*, uint32_t> dedupe_map_;
+  SafeMap<const SwapVector*, uint32_t> dedupe_map_;
 };
 
 class OatWriter::InitImageMethodVisitor : public OatDexMethodVisitor {
@@ -571,11 +614,13 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
     const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
-    if (compiled_method != NULL) {  // ie. not an abstract method
+    if (compiled_method != NULL && !IsInCodeTier(oat_class)) {
+      ++method_offsets_index_;
+    } else if (compiled_method != NULL) {  // ie. not an abstract method
       size_t file_offset = file_offset_;
       OutputStream* out = out_;
 
-      const std::vector<uint8_t>* quick_code = compiled_method->GetQuickCode();
+      const SwapVector* quick_code = compiled_method->GetQuickCode();
       if (quick_code != nullptr) {
         CHECK(compiled_method->GetPortableCode() == nullptr);
         uint32_t aligned_offset = compiled_method->AlignCode(offset_);
@@ -659,7 +704,7 @@ class OatWriter::WriteMapMethodVisitor : public OatDexMethodVisitor {
       ++method_offsets_index_;
 
       // Write deduplicated map.
-      const std::vector<uint8_t>* map = DataAccess::GetData(compiled_method);
+      const SwapVector* map = DataAccess::GetData(compiled_method);
       size_t map_size = map->size() * sizeof((*map)[0]);
       DCHECK((map_size == 0u && map_offset == 0u) ||
             (map_size != 0u && map_offset != 0u && map_offset <= offset_))
@@ -688,43 +733,62 @@ class OatWriter::WriteMapMethodVisitor : public OatDexMethodVisitor {
 };
 
 // Visit all methods from all classes in all dex files with the specified visitor.
+OatWriter::CodeTier OatWriter::GetCodeTier(const DexFile& dex_file, uint32_t method_idx) const {
+  const ProfileData* data = compiler_driver_->GetProfileData(PrettyMethod(method_idx, dex_file));
+  if (data == nullptr) {
+    return kCodeTierCold;
+  }
+  // Like for the compilation with a profile, the start of the top K percentage bucket of the
+  // method is compared, in case the threshold falls inside the bucket.
+  static constexpr double kHotTopKPercentage = 90.0;
+  return (data->GetTopKUsedPercentage() - data->GetUsedPercent() <= kHotTopKPercentage)
+      ? kCodeTierHot : kCodeTierWarm;
+}
+
 bool OatWriter::VisitDexMethods(DexMethodVisitor* visitor) {
   for (const DexFile* dex_file : *dex_files_) {
-    const size_t class_def_count = dex_file->NumClassDefs();
-    for (size_t class_def_index = 0; class_def_index != class_def_count; ++class_def_index) {
-      if (UNLIKELY(!visitor->StartClass(dex_file, class_def_index))) {
-        return false;
+    if (UNLIKELY(!VisitDexFileMethods(dex_file, visitor))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OatWriter::VisitDexFileMethods(const DexFile* dex_file, DexMethodVisitor* visitor) {
+  const size_t class_def_count = dex_file->NumClassDefs();
+  for (size_t class_def_index = 0; class_def_index != class_def_count; ++class_def_index) {
+    if (UNLIKELY(!visitor->StartClass(dex_file, class_def_index))) {
+      return false;
+    }
+    const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+    const byte* class_data = dex_file->GetClassData(class_def);
+    if (class_data != NULL) {  // ie not an empty class, such as a marker interface
+      ClassDataItemIterator it(*dex_file, class_data);
+      while (it.HasNextStaticField()) {
+        it.Next();
       }
-      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
-      const byte* class_data = dex_file->GetClassData(class_def);
-      if (class_data != NULL) {  // ie not an empty class, such as a marker interface
-        ClassDataItemIterator it(*dex_file, class_data);
-        while (it.HasNextStaticField()) {
-          it.Next();
-        }
-        while (it.HasNextInstanceField()) {
-          it.Next();
-        }
-        size_t class_def_method_index = 0u;
-        while (it.HasNextDirectMethod()) {
-          if (!visitor->VisitMethod(class_def_method_index, it)) {
-            return false;
-          }
-          ++class_def_method_index;
-          it.Next();
-        }
-        while (it.HasNextVirtualMethod()) {
-          if (UNLIKELY(!visitor->VisitMethod(class_def_method_index, it))) {
-            return false;
-          }
-          ++class_def_method_index;
-          it.Next();
+      while (it.HasNextInstanceField()) {
+        it.Next();
+      }
+      size_t class_def_method_index = 0u;
+      while (it.HasNextDirectMethod()) {
+        if (!visitor->VisitMethod(class_def_method_index, it)) {
+          return false;
         }
+        ++class_def_method_index;
+        it.Next();
       }
-      if (UNLIKELY(!visitor->EndClass())) {
-        return false;
+      while (it.HasNextVirtualMethod()) {
+        if (UNLIKELY(!visitor->VisitMethod(class_def_method_index, it))) {
+          return false;
+        }
+        ++class_def_method_index;
+        it.Next();
       }
     }
+    if (UNLIKELY(!visitor->EndClass())) {
+      return false;
+    }
   }
   return true;
 }
@@ -773,10 +837,15 @@ size_t OatWriter::InitDexFiles(size_t offset) {
 
 size_t OatWriter::InitOatClasses(size_t offset) {
   // calculate the offsets within OatDexFiles to OatClasses
-  InitOatClassesMethodVisitor visitor(this, offset);
-  bool success = VisitDexMethods(&visitor);
-  CHECK(success);
-  offset = visitor.GetOffset();
+  size_t thread_count = std::min(compiler_driver_->GetThreadCount(), dex_files_->size());
+  if (thread_count > 1u) {
+    offset = InitOatClassesInParallel(offset, thread_count);
+  } else {
+    InitOatClassesMethodVisitor visitor(this, offset, &oat_classes_);
+    bool success = VisitDexMethods(&visitor);
+    CHECK(success);
+    offset = visitor.GetOffset();
+  }
 
   // Update oat_dex_files_.
   auto oat_class_it = oat_classes_.begin();
@@ -793,6 +862,58 @@ size_t OatWriter::InitOatClasses(size_t offset) {
   return offset;
 }
 
+// Creates the OatClasses of a dex file from offset 0.
+class OatWriter::InitOatClassesTask : public Task {
+ public:
+  InitOatClassesTask(OatWriter* writer, const DexFile* dex_file)
+    : writer_(writer), dex_file_(dex_file), size_(0u) {
+  }
+
+  void Run(Thread* self) {
+    InitOatClassesMethodVisitor visitor(writer_, 0u, &oat_classes_);
+    bool success = VisitDexFileMethods(dex_file_, &visitor);
+    CHECK(success);
+    size_ = visitor.GetOffset();
+  }
+
+  const std::vector<OatClass*>& GetOatClasses() const {
+    return oat_classes_;
+  }
+
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  OatWriter* const writer_;
+  const DexFile* const dex_file_;
+  std::vector<OatClass*> oat_classes_;
+  size_t size_;
+};
+
+size_t OatWriter::InitOatClassesInParallel(size_t offset, size_t thread_count) {
+  // Looking up the compiled methods and classes of the dex files is independent, the OatClasses
+  // then only need to be moved after the ones of the previous dex files.
+  Thread* self = Thread::Current();
+  std::vector<InitOatClassesTask*> tasks;
+  ThreadPool thread_pool("Oat writer thread pool", thread_count - 1);
+  for (const DexFile* dex_file : *dex_files_) {
+    tasks.push_back(new InitOatClassesTask(this, dex_file));
+  }
+  thread_pool.AddTasks(self, std::vector<Task*>(tasks.begin(), tasks.end()));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  for (InitOatClassesTask* task : tasks) {
+    for (OatClass* oat_class : task->GetOatClasses()) {
+      oat_class->offset_ += offset;
+      oat_classes_.push_back(oat_class);
+    }
+    offset += task->GetSize();
+  }
+  STLDeleteElements(&tasks);
+  return offset;
+}
+
 size_t OatWriter::InitOatMaps(size_t offset) {
   #define VISIT(VisitorType)                          \
     do {                                              \
@@ -863,7 +984,16 @@ size_t OatWriter::InitOatCodeDexFiles(size_t offset) {
       offset = visitor.GetOffset();                   \
     } while (false)
 
-  VISIT(InitCodeMethodVisitor);
+  {
+    InitCodeMethodVisitor visitor(this, offset);
+    size_t num_code_tiers = compiler_driver_->ProfilePresent() ? kNumCodeTiers : 1u;
+    for (size_t code_tier = 0; code_tier != num_code_tiers; ++code_tier) {
+      visitor.StartCodeTier(static_cast<CodeTier>(code_tier));
+      bool success = VisitDexMethods(&visitor);
+      DCHECK(success);
+    }
+    offset = visitor.GetOffset();
+  }
   if (compiler_driver_->IsImage()) {
     VISIT(InitImageMethodVisitor);
   }
@@ -947,6 +1077,8 @@ bool OatWriter::Write(OutputStream* out) {
     DO_STAT(size_oat_dex_file_methods_offsets_);
     DO_STAT(size_oat_class_type_);
     DO_STAT(size_oat_class_status_);
+    DO_STAT(size_oat_class_verifier_deps_);
+    DO_STAT(size_oat_class_hot_fields_);
     DO_STAT(size_oat_class_method_bitmaps_);
     DO_STAT(size_oat_class_method_offsets_);
     #undef DO_STAT
@@ -1069,20 +1201,16 @@ size_t OatWriter::WriteCode(OutputStream* out, const size_t file_offset, size_t
 size_t OatWriter::WriteCodeDexFiles(OutputStream* out,
                                     const size_t file_offset,
                                     size_t relative_offset) {
-  #define VISIT(VisitorType)                                              \
-    do {                                                                  \
-      VisitorType visitor(this, out, file_offset, relative_offset);       \
-      if (UNLIKELY(!VisitDexMethods(&visitor))) {                         \
-        return 0;                                                         \
-      }                                                                   \
-      relative_offset = visitor.GetOffset();                              \
-    } while (false)
-
-  VISIT(WriteCodeMethodVisitor);
-
-  #undef VISIT
-
-  return relative_offset;
+  // The code is written in the order InitOatCodeDexFiles() laid it out.
+  WriteCodeMethodVisitor visitor(this, out, file_offset, relative_offset);
+  size_t num_code_tiers = compiler_driver_->ProfilePresent() ? kNumCodeTiers : 1u;
+  for (size_t code_tier = 0; code_tier != num_code_tiers; ++code_tier) {
+    visitor.StartCodeTier(static_cast<CodeTier>(code_tier));
+    if (UNLIKELY(!VisitDexMethods(&visitor))) {
+      return 0;
+    }
+  }
+  return visitor.GetOffset();
 }
 
 OatWriter::OatDexFile::OatDexFile(size_t offset, const DexFile& dex_file) {
@@ -1149,8 +1277,10 @@ bool OatWriter::OatDexFile::Write(OatWriter* oat_writer,
 OatWriter::OatClass::OatClass(size_t offset,
                               const std::vector<CompiledMethod*>& compiled_methods,
                               uint32_t num_non_null_compiled_methods,
-                              mirror::Class::Status status)
-    : compiled_methods_(compiled_methods) {
+                              mirror::Class::Status status,
+                              const std::vector<uint32_t>& verifier_deps,
+                              const std::vector<uint32_t>& hot_fields)
+    : compiled_methods_(compiled_methods), hot_fields_(hot_fields) {
   uint32_t num_methods = compiled_methods.size();
   CHECK_LE(num_non_null_compiled_methods, num_methods);
 
@@ -1176,6 +1306,18 @@ OatWriter::OatClass::OatClass(size_t offset,
   method_headers_.resize(num_non_null_compiled_methods);
 
   uint32_t oat_method_offsets_offset_from_oat_class = sizeof(type_) + sizeof(status_);
+  if (status_ == mirror::Class::kStatusRetryVerificationAtRuntime) {
+    verifier_deps_ = verifier_deps;
+    verifier_deps_size_ = verifier_deps_.size();
+    oat_method_offsets_offset_from_oat_class += sizeof(verifier_deps_size_);
+    oat_method_offsets_offset_from_oat_class += sizeof(verifier_deps_[0]) * verifier_deps_.size();
+  } else {
+    DCHECK(verifier_deps.empty());
+    verifier_deps_size_ = 0;
+  }
+  hot_fields_size_ = hot_fields_.size();
+  oat_method_offsets_offset_from_oat_class += sizeof(hot_fields_size_);
+  oat_method_offsets_offset_from_oat_class += sizeof(hot_fields_[0]) * hot_fields_.size();
   if (type_ == kOatClassSomeCompiled) {
     method_bitmap_ = new BitVector(num_methods, false, Allocator::GetMallocAllocator());
     method_bitmap_size_ = method_bitmap_->GetSizeOf();
@@ -1221,6 +1363,11 @@ size_t OatWriter::OatClass::GetOatMethodOffsetsOffsetFromOatClass(
 size_t OatWriter::OatClass::SizeOf() const {
   return sizeof(status_)
           + sizeof(type_)
+          + ((status_ != mirror::Class::kStatusRetryVerificationAtRuntime) ? 0
+                 : sizeof(verifier_deps_size_))
+          + (sizeof(uint32_t) * verifier_deps_.size())
+          + sizeof(hot_fields_size_)
+          + (sizeof(uint32_t) * hot_fields_.size())
           + ((method_bitmap_size_ == 0) ? 0 : sizeof(method_bitmap_size_))
           + method_bitmap_size_
           + (sizeof(method_offsets_[0]) * method_offsets_.size());
@@ -1229,6 +1376,17 @@ size_t OatWriter::OatClass::SizeOf() const {
 void OatWriter::OatClass::UpdateChecksum(OatHeader* oat_header) const {
   oat_header->UpdateChecksum(&status_, sizeof(status_));
   oat_header->UpdateChecksum(&type_, sizeof(type_));
+  if (status_ == mirror::Class::kStatusRetryVerificationAtRuntime) {
+    oat_header->UpdateChecksum(&verifier_deps_size_, sizeof(verifier_deps_size_));
+    if (verifier_deps_size_ != 0) {
+      oat_header->UpdateChecksum(&verifier_deps_[0],
+                                 sizeof(verifier_deps_[0]) * verifier_deps_.size());
+    }
+  }
+  oat_header->UpdateChecksum(&hot_fields_size_, sizeof(hot_fields_size_));
+  if (hot_fields_size_ != 0) {
+    oat_header->UpdateChecksum(&hot_fields_[0], sizeof(hot_fields_[0]) * hot_fields_.size());
+  }
   if (method_bitmap_size_ != 0) {
     CHECK_EQ(kOatClassSomeCompiled, type_);
     oat_header->UpdateChecksum(&method_bitmap_size_, sizeof(method_bitmap_size_));
@@ -1252,6 +1410,34 @@ bool OatWriter::OatClass::Write(OatWriter* oat_writer,
     return false;
   }
   oat_writer->size_oat_class_type_ += sizeof(type_);
+  if (status_ == mirror::Class::kStatusRetryVerificationAtRuntime) {
+    if (!out->WriteFully(&verifier_deps_size_, sizeof(verifier_deps_size_))) {
+      PLOG(ERROR) << "Failed to write verifier dependencies size to " << out->GetLocation();
+      return false;
+    }
+    oat_writer->size_oat_class_verifier_deps_ += sizeof(verifier_deps_size_);
+    if (verifier_deps_size_ != 0) {
+      if (!out->WriteFully(&verifier_deps_[0],
+                           sizeof(verifier_deps_[0]) * verifier_deps_.size())) {
+        PLOG(ERROR) << "Failed to write verifier dependencies to " << out->GetLocation();
+        return false;
+      }
+      oat_writer->size_oat_class_verifier_deps_ +=
+          sizeof(verifier_deps_[0]) * verifier_deps_.size();
+    }
+  }
+  if (!out->WriteFully(&hot_fields_size_, sizeof(hot_fields_size_))) {
+    PLOG(ERROR) << "Failed to write hot fields size to " << out->GetLocation();
+    return false;
+  }
+  oat_writer->size_oat_class_hot_fields_ += sizeof(hot_fields_size_);
+  if (hot_fields_size_ != 0) {
+    if (!out->WriteFully(&hot_fields_[0], sizeof(hot_fields_[0]) * hot_fields_.size())) {
+      PLOG(ERROR) << "Failed to write hot fields to " << out->GetLocation();
+      return false;
+    }
+    oat_writer->size_oat_class_hot_fields_ += sizeof(hot_fields_[0]) * hot_fields_.size();
+  }
   if (method_bitmap_size_ != 0) {
     CHECK_EQ(kOatClassSomeCompiled, type_);
     if (!out->WriteFully(&method_bitmap_size_, sizeof(method_bitmap_size_))) {
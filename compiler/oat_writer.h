@@ -117,6 +117,17 @@ class OatWriter {
   struct MappingTableDataAccess;
   struct VmapTableDataAccess;
 
+  // With a profile, the code is laid out in tiers of hotness so that the code run the most shares
+  // few pages, and each tier in the order of the dex files.
+  enum CodeTier {
+    kCodeTierHot,   // The methods making up the leading samples of the profile.
+    kCodeTierWarm,  // The other methods of the profile.
+    kCodeTierCold,  // The methods not in the profile.
+  };
+  static constexpr size_t kNumCodeTiers = kCodeTierCold + 1;
+
+  CodeTier GetCodeTier(const DexFile& dex_file, uint32_t method_idx) const;
+
   // The function VisitDexMethods() below iterates through all the methods in all
   // the compiled dex files in order of their definitions. The method visitor
   // classes provide individual bits of processing for each of the passes we need to
@@ -125,6 +136,7 @@ class OatWriter {
   class DexMethodVisitor;
   class OatDexMethodVisitor;
   class InitOatClassesMethodVisitor;
+  class InitOatClassesTask;
   class InitCodeMethodVisitor;
   template <typename DataAccess>
   class InitMapMethodVisitor;
@@ -136,11 +148,14 @@ class OatWriter {
   // Visit all the methods in all the compiled dex files in their definition order
   // with a given DexMethodVisitor.
   bool VisitDexMethods(DexMethodVisitor* visitor);
+  // Visit the methods of one of the compiled dex files.
+  static bool VisitDexFileMethods(const DexFile* dex_file, DexMethodVisitor* visitor);
 
   size_t InitOatHeader();
   size_t InitOatDexFiles(size_t offset);
   size_t InitDexFiles(size_t offset);
   size_t InitOatClasses(size_t offset);
+  size_t InitOatClassesInParallel(size_t offset, size_t thread_count);
   size_t InitOatMaps(size_t offset);
   size_t InitOatCode(size_t offset)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -179,7 +194,9 @@ class OatWriter {
     explicit OatClass(size_t offset,
                       const std::vector<CompiledMethod*>& compiled_methods,
                       uint32_t num_non_null_compiled_methods,
-                      mirror::Class::Status status);
+                      mirror::Class::Status status,
+                      const std::vector<uint32_t>& verifier_deps,
+                      const std::vector<uint32_t>& hot_fields);
     ~OatClass();
     size_t GetOatMethodOffsetsOffsetFromOatHeader(size_t class_def_method_index_) const;
     size_t GetOatMethodOffsetsOffsetFromOatClass(size_t class_def_method_index_) const;
@@ -216,6 +233,17 @@ class OatWriter {
     COMPILE_ASSERT(OatClassType::kOatClassMax < (2 ^ 16), oat_class_type_wont_fit_in_16bits);
     uint16_t type_;
 
+    // The encoded verifier::VerifierDeps of a class to verify again at runtime. Only written for
+    // classes with status kStatusRetryVerificationAtRuntime, a size of 0 meaning that there are
+    // no usable dependencies.
+    uint32_t verifier_deps_size_;
+    std::vector<uint32_t> verifier_deps_;
+
+    // The field indices of the instance fields ClassLinker::LinkFields laid out together when
+    // compiling, hottest first, so that the runtime lays them out the same way.
+    uint32_t hot_fields_size_;
+    std::vector<uint32_t> hot_fields_;
+
     uint32_t method_bitmap_size_;
 
     // bit vector indexed by ClassDef method index. When
@@ -233,6 +261,14 @@ class OatWriter {
     std::vector<OatMethodOffsets> method_offsets_;
     std::vector<OatMethodHeader> method_headers_;
 
+    // The CodeTier of each CompiledMethod present in the OatClass, empty without a profile.
+    std::vector<uint8_t> code_tiers_;
+
+    CodeTier GetCodeTier(size_t method_offsets_index) const {
+      return code_tiers_.empty() ? kCodeTierHot
+                                 : static_cast<CodeTier>(code_tiers_[method_offsets_index]);
+    }
+
    private:
     DISALLOW_COPY_AND_ASSIGN(OatClass);
   };
@@ -297,6 +333,8 @@ class OatWriter {
   uint32_t size_oat_dex_file_methods_offsets_;
   uint32_t size_oat_class_type_;
   uint32_t size_oat_class_status_;
+  uint32_t size_oat_class_verifier_deps_;
+  uint32_t size_oat_class_hot_fields_;
   uint32_t size_oat_class_method_bitmaps_;
   uint32_t size_oat_class_method_offsets_;
 
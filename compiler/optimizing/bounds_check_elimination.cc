@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounds_check_elimination.h"
+
+namespace art {
+
+static bool IsNonNegativeIntConstant(HInstruction* instruction) {
+  HIntConstant* constant = instruction->AsIntConstant();
+  return constant != nullptr && constant->GetValue() >= 0;
+}
+
+static bool IsIntConstant(HInstruction* instruction, int32_t value) {
+  HIntConstant* constant = instruction->AsIntConstant();
+  return constant != nullptr && constant->GetValue() == value;
+}
+
+HAdd* BoundsCheckElimination::FindUnitStrideIncrement(HPhi* phi) {
+  HBasicBlock* header = phi->GetBlock();
+  if (phi->GetType() != Primitive::kPrimInt
+      || !header->IsLoopHeader()
+      || header->NumberOfBackEdges() != 1) {
+    return nullptr;
+  }
+  HLoopInformation* loop_info = header->GetLoopInformation();
+  HBasicBlock* back_edge = loop_info->GetBackEdges()->Get(0);
+  HInstruction* initial = phi->InputAt(header->GetPredecessorIndexOf(loop_info->GetPreHeader()));
+  HInstruction* next = phi->InputAt(header->GetPredecessorIndexOf(back_edge));
+  HAdd* add = next->AsAdd();
+  if (!IsNonNegativeIntConstant(initial) || add == nullptr) {
+    return nullptr;
+  }
+  if ((add->GetLeft() == phi && IsIntConstant(add->GetRight(), 1))
+      || (add->GetRight() == phi && IsIntConstant(add->GetLeft(), 1))) {
+    return add;
+  }
+  return nullptr;
+}
+
+HBasicBlock* BoundsCheckElimination::GetInBoundsSuccessor(HCondition* condition,
+                                                         HInstruction* index,
+                                                         HInstruction* length) {
+  HIf* branch = nullptr;
+  for (HUseIterator<HInstruction> it(condition->GetUses()); !it.Done(); it.Advance()) {
+    HInstruction* user = it.Current()->GetUser();
+    if (user->AsIf() != nullptr && user->GetBlock() == condition->GetBlock()) {
+      branch = user->AsIf();
+    }
+  }
+  if (branch == nullptr) {
+    return nullptr;
+  }
+
+  HBasicBlock* successor = nullptr;
+  if (condition->GetLeft() == index && condition->GetRight() == length) {
+    if (condition->GetCondition() == kCondLT) {
+      successor = branch->IfTrueSuccessor();
+    } else if (condition->GetCondition() == kCondGE) {
+      successor = branch->IfFalseSuccessor();
+    }
+  } else if (condition->GetLeft() == length && condition->GetRight() == index) {
+    if (condition->GetCondition() == kCondGT) {
+      successor = branch->IfTrueSuccessor();
+    } else if (condition->GetCondition() == kCondLE) {
+      successor = branch->IfFalseSuccessor();
+    }
+  }
+
+  // The successor must not be reachable from elsewhere.
+  if (successor == nullptr || successor->GetPredecessors()->Size() != 1) {
+    return nullptr;
+  }
+  return successor;
+}
+
+// Returns whether `bounds_check` always succeeds. This is the case when its
+// index is an induction variable that starts at a non-negative constant and
+// is incremented by one, and when the check and the increment are guarded by
+// a comparison of the index with the length. The guard also ensures the
+// increment does not overflow, so the index is never negative.
+static bool IsInBounds(HBoundsCheck* bounds_check) {
+  HPhi* index = bounds_check->InputAt(0)->AsPhi();
+  HInstruction* length = bounds_check->InputAt(1);
+  if (index == nullptr) {
+    return false;
+  }
+  HAdd* increment = BoundsCheckElimination::FindUnitStrideIncrement(index);
+  if (increment == nullptr) {
+    return false;
+  }
+
+  for (HUseIterator<HInstruction> it(index->GetUses()); !it.Done(); it.Advance()) {
+    HCondition* condition = it.Current()->GetUser()->AsCondition();
+    if (condition == nullptr) {
+      continue;
+    }
+    HBasicBlock* guarded =
+        BoundsCheckElimination::GetInBoundsSuccessor(condition, index, length);
+    if (guarded != nullptr
+        && guarded->Dominates(bounds_check->GetBlock())
+        && guarded->Dominates(increment->GetBlock())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BoundsCheckElimination::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(*block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HBoundsCheck* bounds_check = inst_it.Current()->AsBoundsCheck();
+      if (bounds_check != nullptr && IsInBounds(bounds_check)) {
+        bounds_check->ReplaceWith(bounds_check->InputAt(0));
+        block->RemoveInstruction(bounds_check);
+      }
+    }
+  }
+}
+
+}  // namespace art
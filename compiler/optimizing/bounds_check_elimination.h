@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Optimization pass removing the bounds checks of array accesses indexed by
+ * the induction variable of a loop, when the loop condition already compares
+ * that variable against the length of the array.
+ */
+class BoundsCheckElimination : public HOptimization {
+ public:
+  explicit BoundsCheckElimination(HGraph* graph)
+      : HOptimization(graph, kBoundsCheckEliminationPassName) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kBoundsCheckEliminationPassName = "BCE";
+
+  // Returns the instruction incrementing `phi` by one on the back edge of its
+  // loop, if `phi` is a basic induction variable starting at a non-negative
+  // constant and incremented by one on each iteration. Returns null otherwise.
+  static HAdd* FindUnitStrideIncrement(HPhi* phi);
+
+  // Returns the successor of `condition`'s block that is only entered when
+  // `index` is less than `length`, or null if `condition` does not guard a
+  // block that way.
+  static HBasicBlock* GetInBoundsSuccessor(HCondition* condition,
+                                           HInstruction* index,
+                                           HInstruction* length);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "bounds_check_elimination.h"
+#include "nodes.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Builds the graph of the following loop, as the builder creates it for the
+ * code generated by dx, and returns the bounds check in its body:
+ *
+ *   for (int i = initial; i < array.length; i += increment) {
+ *     array[i];
+ *   }
+ *
+ * If `guard_in_bounds` is false, the loop condition is `i <= array.length`.
+ */
+static HBoundsCheck* BuildArrayLoop(ArenaAllocator* allocator,
+                                    int32_t initial,
+                                    int32_t increment,
+                                    bool guard_in_bounds) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  HInstruction* array = new (allocator) HParameterValue(0, Primitive::kPrimNot);
+  HInstruction* initial_value = new (allocator) HIntConstant(initial);
+  HInstruction* increment_value = new (allocator) HIntConstant(increment);
+  entry->AddInstruction(array);
+  entry->AddInstruction(initial_value);
+  entry->AddInstruction(increment_value);
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* header = new (allocator) HBasicBlock(graph);
+  HBasicBlock* body = new (allocator) HBasicBlock(graph);
+  HBasicBlock* return_block = new (allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(header);
+  graph->AddBlock(body);
+  graph->AddBlock(return_block);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  entry->AddSuccessor(header);
+  header->AddSuccessor(return_block);
+  header->AddSuccessor(body);
+  body->AddSuccessor(header);
+  return_block->AddSuccessor(exit);
+  body->AddInstruction(new (allocator) HGoto());
+  return_block->AddInstruction(new (allocator) HReturnVoid());
+  exit->AddInstruction(new (allocator) HExit());
+
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+
+  // The loop is built in SSA form directly.
+  HInstruction* null_check = new (allocator) HNullCheck(array, 0);
+  HInstruction* length = new (allocator) HArrayLength(null_check);
+  header->AddInstruction(null_check);
+  header->AddInstruction(length);
+
+  HPhi* phi = new (allocator) HPhi(allocator, 0, 0, Primitive::kPrimInt);
+  header->AddPhi(phi);
+  HBoundsCheck* bounds_check = new (allocator) HBoundsCheck(phi, length, 0);
+  HInstruction* add = new (allocator) HAdd(Primitive::kPrimInt, phi, increment_value);
+  body->InsertInstructionBefore(bounds_check, body->GetLastInstruction());
+  body->InsertInstructionBefore(
+      new (allocator) HArrayGet(null_check, bounds_check, Primitive::kPrimInt),
+      body->GetLastInstruction());
+  body->InsertInstructionBefore(add, body->GetLastInstruction());
+  phi->AddInput(initial_value);
+  phi->AddInput(add);
+
+  // The loop is exited when the condition is true.
+  HInstruction* condition = guard_in_bounds
+      ? static_cast<HInstruction*>(new (allocator) HGreaterThanOrEqual(phi, length))
+      : static_cast<HInstruction*>(new (allocator) HGreaterThan(phi, length));
+  header->AddInstruction(condition);
+  header->AddInstruction(new (allocator) HIf(condition));
+  return bounds_check;
+}
+
+TEST(BoundsCheckEliminationTest, LoopOverArray) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBoundsCheck* bounds_check = BuildArrayLoop(&allocator, 0, 1, true);
+  HInstruction* index = bounds_check->InputAt(0);
+  HBasicBlock* body = bounds_check->GetBlock();
+  BoundsCheckElimination(body->GetGraph()).Run();
+
+  ASSERT_TRUE(bounds_check->GetBlock() == nullptr);
+  ASSERT_EQ(body->GetFirstInstruction()->AsArrayGet()->InputAt(1), index);
+}
+
+TEST(BoundsCheckEliminationTest, NegativeInitialValue) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBoundsCheck* bounds_check = BuildArrayLoop(&allocator, -1, 1, true);
+  HBasicBlock* body = bounds_check->GetBlock();
+  BoundsCheckElimination(body->GetGraph()).Run();
+
+  ASSERT_EQ(bounds_check->GetBlock(), body);
+}
+
+TEST(BoundsCheckEliminationTest, StrideOfTwo) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  // `i + 2` may overflow and make the index negative.
+  HBoundsCheck* bounds_check = BuildArrayLoop(&allocator, 0, 2, true);
+  HBasicBlock* body = bounds_check->GetBlock();
+  BoundsCheckElimination(body->GetGraph()).Run();
+
+  ASSERT_EQ(bounds_check->GetBlock(), body);
+}
+
+TEST(BoundsCheckEliminationTest, LessThanOrEqualGuard) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBoundsCheck* bounds_check = BuildArrayLoop(&allocator, 0, 1, false);
+  HBasicBlock* body = bounds_check->GetBlock();
+  BoundsCheckElimination(body->GetGraph()).Run();
+
+  ASSERT_EQ(bounds_check->GetBlock(), body);
+}
+
+}  // namespace art
@@ -20,11 +20,49 @@
 #include "dex_instruction.h"
 #include "dex_instruction-inl.h"
 #include "builder.h"
+#include "class_linker.h"
+#include "driver/compiler_driver.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
 #include "nodes.h"
 #include "primitive.h"
+#include "scoped_thread_state_change.h"
+#include "thread.h"
 
 namespace art {
 
+/**
+ * Helper class to add HTemporary instructions. This class is used when
+ * converting a DEX instruction to multiple HInstruction, and where those
+ * instructions do not die at the following instruction, but instead spans
+ * multiple instructions.
+ */
+class Temporaries : public ValueObject {
+ public:
+  Temporaries(HGraph* graph, size_t count) : graph_(graph), count_(count), index_(0) {
+    graph_->UpdateNumberOfTemporaries(count_);
+  }
+
+  void Add(HInstruction* instruction) {
+    // We currently only support vreg size temps.
+    DCHECK(instruction->GetType() != Primitive::kPrimLong
+           && instruction->GetType() != Primitive::kPrimDouble);
+    DCHECK_LT(index_, count_);
+    HInstruction* temp = new (graph_->GetArena()) HTemporary(index_++);
+    instruction->GetBlock()->AddInstruction(temp);
+    DCHECK(temp->GetPrevious() == instruction);
+  }
+
+ private:
+  HGraph* const graph_;
+
+  // The total number of temporaries that will be used.
+  const size_t count_;
+
+  // Current index in the temporary stack, updated by `Add`.
+  size_t index_;
+};
+
 void HGraphBuilder::InitializeLocals(uint16_t count) {
   graph_->SetNumberOfVRegs(count);
   locals_.SetSize(count);
@@ -93,13 +131,24 @@ static bool CanHandleCodeItem(const DexFile::CodeItem& code_item) {
 }
 
 template<typename T>
-void HGraphBuilder::If_22t(const Instruction& instruction, int32_t dex_offset, bool is_not) {
+void HGraphBuilder::If_22t(const Instruction& instruction, int32_t dex_offset) {
   HInstruction* first = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
   HInstruction* second = LoadLocal(instruction.VRegB(), Primitive::kPrimInt);
   current_block_->AddInstruction(new (arena_) T(first, second));
-  if (is_not) {
-    current_block_->AddInstruction(new (arena_) HNot(current_block_->GetLastInstruction()));
-  }
+  current_block_->AddInstruction(new (arena_) HIf(current_block_->GetLastInstruction()));
+  HBasicBlock* target = FindBlockStartingAt(instruction.GetTargetOffset() + dex_offset);
+  DCHECK(target != nullptr);
+  current_block_->AddSuccessor(target);
+  target = FindBlockStartingAt(dex_offset + instruction.SizeInCodeUnits());
+  DCHECK(target != nullptr);
+  current_block_->AddSuccessor(target);
+  current_block_ = nullptr;
+}
+
+template<typename T>
+void HGraphBuilder::If_21t(const Instruction& instruction, int32_t dex_offset) {
+  HInstruction* value = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
+  current_block_->AddInstruction(new (arena_) T(value, GetIntConstant0()));
   current_block_->AddInstruction(new (arena_) HIf(current_block_->GetLastInstruction()));
   HBasicBlock* target = FindBlockStartingAt(instruction.GetTargetOffset() + dex_offset);
   DCHECK(target != nullptr);
@@ -259,6 +308,40 @@ void HGraphBuilder::BuildReturn(const Instruction& instruction, Primitive::Type
   current_block_ = nullptr;
 }
 
+bool HGraphBuilder::CanRemoveAllocation(uint16_t type_index) const {
+  // compiler_driver_ is null only when unit testing.
+  if (compiler_driver_ == nullptr) {
+    return false;
+  }
+  bool is_type_initialized;
+  bool use_direct_type_ptr;
+  uintptr_t direct_type_ptr;
+  bool is_finalizable;
+  if (!compiler_driver_->CanEmbedTypeInCode(*dex_file_, type_index, &is_type_initialized,
+                                            &use_direct_type_ptr, &direct_type_ptr,
+                                            &is_finalizable)) {
+    // The class may still be the class of the method, checked below.
+    is_type_initialized = false;
+  }
+
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::DexCache* dex_cache = dex_compilation_unit_->GetClassLinker()->FindDexCache(*dex_file_);
+  mirror::Class* klass = dex_cache->GetResolvedType(type_index);
+  uint16_t referrer_index =
+      dex_file_->GetMethodId(dex_compilation_unit_->GetDexMethodIndex()).class_idx_;
+  mirror::Class* referrer_class = dex_cache->GetResolvedType(referrer_index);
+  if (klass == nullptr
+      || referrer_class == nullptr
+      || klass->IsFinalizable()
+      || !klass->IsInstantiable()
+      || !referrer_class->CanAccess(klass)) {
+    return false;
+  }
+  // Allocating an object initializes its class. The class of the method, and
+  // its super classes, are initialized once the method runs.
+  return is_type_initialized || referrer_class->IsSubClass(klass);
+}
+
 bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
                                 uint32_t dex_offset,
                                 uint32_t method_idx,
@@ -275,14 +358,37 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
       && instruction.Opcode() != Instruction::INVOKE_STATIC_RANGE;
   const size_t number_of_arguments = strlen(descriptor) - (is_instance_call ? 0 : 1);
 
-  // Treat invoke-direct like static calls for now.
-  HInvoke* invoke = new (arena_) HInvokeStatic(
-      arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  HInvoke* invoke = nullptr;
+  if (instruction.Opcode() == Instruction::INVOKE_VIRTUAL
+      || instruction.Opcode() == Instruction::INVOKE_VIRTUAL_RANGE) {
+    InvokeType invoke_type = kVirtual;
+    MethodReference target_method(dex_file_, method_idx);
+    int vtable_index;
+    uintptr_t direct_code;
+    uintptr_t direct_method;
+    // TODO: Add devirtualization support.
+    if (!compiler_driver_->ComputeInvokeInfo(dex_compilation_unit_, dex_offset, true, false,
+                                             &invoke_type, &target_method, &vtable_index,
+                                             &direct_code, &direct_method)
+        || invoke_type != kVirtual) {
+      return false;
+    }
+    invoke = new (arena_) HInvokeVirtual(
+        arena_, number_of_arguments, return_type, dex_offset, vtable_index);
+  } else {
+    // Treat invoke-direct like static calls for now.
+    invoke = new (arena_) HInvokeStatic(
+        arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  }
 
   size_t start_index = 0;
+  Temporaries temps(graph_, is_instance_call ? 1 : 0);
   if (is_instance_call) {
     HInstruction* arg = LoadLocal(is_range ? register_index : args[0], Primitive::kPrimNot);
-    invoke->SetArgumentAt(0, arg);
+    HNullCheck* null_check = new (arena_) HNullCheck(arg, dex_offset);
+    current_block_->AddInstruction(null_check);
+    temps.Add(null_check);
+    invoke->SetArgumentAt(0, null_check);
     start_index = 1;
   }
 
@@ -316,6 +422,81 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
   return true;
 }
 
+bool HGraphBuilder::BuildFieldAccess(const Instruction& instruction,
+                                     uint32_t dex_offset,
+                                     bool is_put) {
+  uint32_t source_or_dest_reg = instruction.VRegA_22c();
+  uint32_t obj_reg = instruction.VRegB_22c();
+  uint16_t field_index = instruction.VRegC_22c();
+
+  MemberOffset field_offset(0u);
+  bool is_volatile;
+  if (!compiler_driver_->ComputeInstanceFieldInfo(
+          field_index, dex_compilation_unit_, is_put, &field_offset, &is_volatile)) {
+    return false;
+  }
+
+  // TODO: Support volatile fields, they need memory barriers.
+  if (is_volatile) {
+    return false;
+  }
+
+  const DexFile::FieldId& field_id = dex_file_->GetFieldId(field_index);
+  Primitive::Type field_type = Primitive::GetType(dex_file_->GetFieldTypeDescriptor(field_id)[0]);
+  if (field_type == Primitive::kPrimFloat || field_type == Primitive::kPrimDouble) {
+    return false;
+  }
+
+  HInstruction* object = LoadLocal(obj_reg, Primitive::kPrimNot);
+  current_block_->AddInstruction(new (arena_) HNullCheck(object, dex_offset));
+  if (is_put) {
+    // We need one temporary for the null check.
+    Temporaries temps(graph_, 1);
+    HInstruction* null_check = current_block_->GetLastInstruction();
+    temps.Add(null_check);
+    HInstruction* value = LoadLocal(source_or_dest_reg, field_type);
+    current_block_->AddInstruction(
+        new (arena_) HInstanceFieldSet(null_check, value, field_type, field_offset));
+  } else {
+    current_block_->AddInstruction(new (arena_) HInstanceFieldGet(
+        current_block_->GetLastInstruction(), field_type, field_offset));
+    UpdateLocal(source_or_dest_reg, current_block_->GetLastInstruction());
+  }
+  return true;
+}
+
+void HGraphBuilder::BuildArrayAccess(const Instruction& instruction,
+                                     uint32_t dex_offset,
+                                     bool is_put,
+                                     Primitive::Type anticipated_type) {
+  uint8_t source_or_dest_reg = instruction.VRegA_23x();
+  uint8_t array_reg = instruction.VRegB_23x();
+  uint8_t index_reg = instruction.VRegC_23x();
+
+  // We need one temporary for the null check, one for the index, and one for the length.
+  Temporaries temps(graph_, 3);
+
+  HInstruction* object = LoadLocal(array_reg, Primitive::kPrimNot);
+  object = new (arena_) HNullCheck(object, dex_offset);
+  current_block_->AddInstruction(object);
+  temps.Add(object);
+
+  HInstruction* length = new (arena_) HArrayLength(object);
+  current_block_->AddInstruction(length);
+  temps.Add(length);
+  HInstruction* index = LoadLocal(index_reg, Primitive::kPrimInt);
+  index = new (arena_) HBoundsCheck(index, length, dex_offset);
+  current_block_->AddInstruction(index);
+  temps.Add(index);
+  if (is_put) {
+    HInstruction* value = LoadLocal(source_or_dest_reg, anticipated_type);
+    current_block_->AddInstruction(new (arena_) HArraySet(object, index, value, anticipated_type));
+  } else {
+    current_block_->AddInstruction(new (arena_) HArrayGet(object, index, anticipated_type));
+    UpdateLocal(source_or_dest_reg, current_block_->GetLastInstruction());
+  }
+}
+
 bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_t dex_offset) {
   if (current_block_ == nullptr) {
     return true;  // Dead code
@@ -357,24 +538,106 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
-    case Instruction::MOVE: {
+    case Instruction::CONST: {
+      int32_t register_index = instruction.VRegA();
+      HIntConstant* constant = GetIntConstant(instruction.VRegB_31i());
+      UpdateLocal(register_index, constant);
+      break;
+    }
+
+    case Instruction::CONST_HIGH16: {
+      int32_t register_index = instruction.VRegA();
+      HIntConstant* constant = GetIntConstant(instruction.VRegB_21h() << 16);
+      UpdateLocal(register_index, constant);
+      break;
+    }
+
+    case Instruction::MOVE:
+    case Instruction::MOVE_FROM16:
+    case Instruction::MOVE_16: {
       HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimInt);
       UpdateLocal(instruction.VRegA(), value);
       break;
     }
 
+    case Instruction::MOVE_WIDE:
+    case Instruction::MOVE_WIDE_FROM16:
+    case Instruction::MOVE_WIDE_16: {
+      HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimLong);
+      UpdateLocal(instruction.VRegA(), value);
+      break;
+    }
+
+    case Instruction::MOVE_OBJECT:
+    case Instruction::MOVE_OBJECT_FROM16:
+    case Instruction::MOVE_OBJECT_16: {
+      HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimNot);
+      UpdateLocal(instruction.VRegA(), value);
+      break;
+    }
+
     case Instruction::RETURN_VOID: {
       BuildReturn(instruction, Primitive::kPrimVoid);
       break;
     }
 
     case Instruction::IF_EQ: {
-      If_22t<HEqual>(instruction, dex_offset, false);
+      If_22t<HEqual>(instruction, dex_offset);
       break;
     }
 
     case Instruction::IF_NE: {
-      If_22t<HEqual>(instruction, dex_offset, true);
+      If_22t<HNotEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LT: {
+      If_22t<HLessThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LE: {
+      If_22t<HLessThanOrEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GT: {
+      If_22t<HGreaterThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GE: {
+      If_22t<HGreaterThanOrEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_EQZ: {
+      If_21t<HEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_NEZ: {
+      If_21t<HNotEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LTZ: {
+      If_21t<HLessThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LEZ: {
+      If_21t<HLessThanOrEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GTZ: {
+      If_21t<HGreaterThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GEZ: {
+      If_21t<HGreaterThanOrEqual>(instruction, dex_offset);
       break;
     }
 
@@ -405,7 +668,8 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::INVOKE_STATIC:
-    case Instruction::INVOKE_DIRECT: {
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_VIRTUAL: {
       uint32_t method_idx = instruction.VRegB_35c();
       uint32_t number_of_vreg_arguments = instruction.VRegA_35c();
       uint32_t args[5];
@@ -417,7 +681,8 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::INVOKE_STATIC_RANGE:
-    case Instruction::INVOKE_DIRECT_RANGE: {
+    case Instruction::INVOKE_DIRECT_RANGE:
+    case Instruction::INVOKE_VIRTUAL_RANGE: {
       uint32_t method_idx = instruction.VRegB_3rc();
       uint32_t number_of_vreg_arguments = instruction.VRegA_3rc();
       uint32_t register_index = instruction.VRegC();
@@ -489,17 +754,88 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::NEW_INSTANCE: {
+      uint16_t type_index = instruction.VRegB_21c();
       current_block_->AddInstruction(
-          new (arena_) HNewInstance(dex_offset, instruction.VRegB_21c()));
+          new (arena_) HNewInstance(dex_offset, type_index, CanRemoveAllocation(type_index)));
       UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
       break;
     }
 
-    case Instruction::MOVE_RESULT_WIDE: {
+    case Instruction::MOVE_RESULT:
+    case Instruction::MOVE_RESULT_WIDE:
+    case Instruction::MOVE_RESULT_OBJECT: {
       UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
       break;
     }
 
+    case Instruction::CMP_LONG: {
+      HInstruction* first = LoadLocal(instruction.VRegB(), Primitive::kPrimLong);
+      HInstruction* second = LoadLocal(instruction.VRegC(), Primitive::kPrimLong);
+      current_block_->AddInstruction(new (arena_) HCompare(Primitive::kPrimLong, first, second));
+      UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
+      break;
+    }
+
+    case Instruction::IGET:
+    case Instruction::IGET_WIDE:
+    case Instruction::IGET_OBJECT:
+    case Instruction::IGET_BOOLEAN:
+    case Instruction::IGET_BYTE:
+    case Instruction::IGET_CHAR:
+    case Instruction::IGET_SHORT: {
+      if (!BuildFieldAccess(instruction, dex_offset, false)) {
+        return false;
+      }
+      break;
+    }
+
+    case Instruction::IPUT:
+    case Instruction::IPUT_WIDE:
+    case Instruction::IPUT_OBJECT:
+    case Instruction::IPUT_BOOLEAN:
+    case Instruction::IPUT_BYTE:
+    case Instruction::IPUT_CHAR:
+    case Instruction::IPUT_SHORT: {
+      if (!BuildFieldAccess(instruction, dex_offset, true)) {
+        return false;
+      }
+      break;
+    }
+
+#define ARRAY_XX(kind, anticipated_type)                                          \
+    case Instruction::AGET##kind: {                                               \
+      BuildArrayAccess(instruction, dex_offset, false, anticipated_type);         \
+      break;                                                                      \
+    }                                                                             \
+    case Instruction::APUT##kind: {                                               \
+      BuildArrayAccess(instruction, dex_offset, true, anticipated_type);          \
+      break;                                                                      \
+    }
+
+    ARRAY_XX(, Primitive::kPrimInt);
+    ARRAY_XX(_WIDE, Primitive::kPrimLong);
+    ARRAY_XX(_BOOLEAN, Primitive::kPrimBoolean);
+    ARRAY_XX(_BYTE, Primitive::kPrimByte);
+    ARRAY_XX(_CHAR, Primitive::kPrimChar);
+    ARRAY_XX(_SHORT, Primitive::kPrimShort);
+
+#undef ARRAY_XX
+
+    // TODO: Support aput-object, it needs an assignability check of the value.
+    case Instruction::AGET_OBJECT: {
+      BuildArrayAccess(instruction, dex_offset, false, Primitive::kPrimNot);
+      break;
+    }
+
+    case Instruction::ARRAY_LENGTH: {
+      HInstruction* object = LoadLocal(instruction.VRegB_12x(), Primitive::kPrimNot);
+      current_block_->AddInstruction(new (arena_) HNullCheck(object, dex_offset));
+      current_block_->AddInstruction(new (arena_) HArrayLength(
+          current_block_->GetLastInstruction()));
+      UpdateLocal(instruction.VRegA_12x(), current_block_->GetLastInstruction());
+      break;
+    }
+
     case Instruction::NOP:
       break;
 
@@ -26,6 +26,7 @@
 namespace art {
 
 class ArenaAllocator;
+class CompilerDriver;
 class Instruction;
 class HBasicBlock;
 class HGraph;
@@ -38,7 +39,8 @@ class HGraphBuilder : public ValueObject {
  public:
   HGraphBuilder(ArenaAllocator* arena,
                 DexCompilationUnit* dex_compilation_unit = nullptr,
-                const DexFile* dex_file = nullptr)
+                const DexFile* dex_file = nullptr,
+                CompilerDriver* driver = nullptr)
       : arena_(arena),
         branch_targets_(arena, 0),
         locals_(arena, 0),
@@ -49,7 +51,8 @@ class HGraphBuilder : public ValueObject {
         constant0_(nullptr),
         constant1_(nullptr),
         dex_file_(dex_file),
-        dex_compilation_unit_(dex_compilation_unit) { }
+        dex_compilation_unit_(dex_compilation_unit),
+        compiler_driver_(driver) { }
 
   HGraph* BuildGraph(const DexFile::CodeItem& code);
 
@@ -90,10 +93,24 @@ class HGraphBuilder : public ValueObject {
   template<typename T>
   void Binop_22s(const Instruction& instruction, bool reverse);
 
-  template<typename T> void If_22t(const Instruction& instruction, int32_t dex_offset, bool is_not);
+  template<typename T> void If_21t(const Instruction& instruction, int32_t dex_offset);
+  template<typename T> void If_22t(const Instruction& instruction, int32_t dex_offset);
 
   void BuildReturn(const Instruction& instruction, Primitive::Type type);
 
+  // Builds an instance field access node and returns whether the instruction is supported.
+  bool BuildFieldAccess(const Instruction& instruction, uint32_t dex_offset, bool is_put);
+
+  // Builds the null and bounds checks and the access node of an array instruction.
+  void BuildArrayAccess(const Instruction& instruction,
+                        uint32_t dex_offset,
+                        bool is_put,
+                        Primitive::Type anticipated_type);
+
+  // Returns whether allocating an instance of the class `type_index` has no
+  // side effect, see HNewInstance::CanBeRemoved.
+  bool CanRemoveAllocation(uint16_t type_index) const;
+
   // Builds an invocation node and returns whether the instruction is supported.
   bool BuildInvoke(const Instruction& instruction,
                    uint32_t dex_offset,
@@ -122,6 +139,7 @@ class HGraphBuilder : public ValueObject {
 
   const DexFile* const dex_file_;
   DexCompilationUnit* const dex_compilation_unit_;
+  CompilerDriver* const compiler_driver_;
 
   DISALLOW_COPY_AND_ASSIGN(HGraphBuilder);
 };
@@ -18,24 +18,52 @@
 
 #include "code_generator_arm.h"
 #include "code_generator_x86.h"
+#include "code_generator_x86_64.h"
 #include "dex/verified_method.h"
 #include "driver/dex_compilation_unit.h"
 #include "gc_map_builder.h"
 #include "leb128.h"
-#include "mapping_table.h"
+#include "mapping_table_builder.h"
 #include "utils/assembler.h"
 #include "verifier/dex_gc_map.h"
 #include "vmap_table.h"
 
 namespace art {
 
-void CodeGenerator::Compile(CodeAllocator* allocator) {
+void CodeGenerator::CompileBaseline(CodeAllocator* allocator) {
   const GrowableArray<HBasicBlock*>& blocks = GetGraph()->GetBlocks();
   DCHECK(blocks.Get(0) == GetGraph()->GetEntryBlock());
-  DCHECK(GoesToNextBlock(GetGraph()->GetEntryBlock(), blocks.Get(1)));
+  DCHECK(blocks.Get(1) == GetGraph()->GetEntryBlock()->GetSuccessors()->Get(0));
+  is_baseline_ = true;
+  block_order_ = &blocks;
+  ComputeFrameSize(GetGraph()->GetNumberOfVRegs() + GetGraph()->GetNumberOfTemporaries());
+  CompileInternal(allocator);
+}
+
+void CodeGenerator::CompileOptimized(CodeAllocator* allocator,
+                                     const GrowableArray<HBasicBlock*>& block_order) {
+  DCHECK(block_order.Get(0) == GetGraph()->GetEntryBlock());
+  // The frame size has been computed by the register allocator.
+  DCHECK_NE(GetFrameSize(), 0u);
+  is_baseline_ = false;
+  block_order_ = &block_order;
+  CompileInternal(allocator);
+}
+
+void CodeGenerator::CompileInternal(CodeAllocator* allocator) {
+  // Most instructions assemble to a few machine instructions, size the buffer for them upfront.
+  static constexpr size_t kEstimatedCodeBytesPerInstruction = 8;
+  GetAssembler()->ReserveCodeSize(
+      GetGraph()->GetCurrentInstructionId() * kEstimatedCodeBytesPerInstruction);
+  block_labels_.SetSize(GetGraph()->GetBlocks().Size());
   GenerateFrameEntry();
-  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
-    CompileBlock(blocks.Get(i));
+  for (current_block_index_ = 0;
+       current_block_index_ < block_order_->Size();
+       ++current_block_index_) {
+    CompileBlock(block_order_->Get(current_block_index_));
+  }
+  for (size_t i = 0, e = slow_paths_.Size(); i < e; ++i) {
+    slow_paths_.Get(i)->EmitNativeCode(this);
   }
   size_t code_size = GetAssembler()->CodeSize();
   uint8_t* buffer = allocator->Allocate(code_size);
@@ -49,12 +77,44 @@ void CodeGenerator::CompileBlock(HBasicBlock* block) {
   HGraphVisitor* instruction_visitor = GetInstructionVisitor();
   for (HInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
     HInstruction* current = it.Current();
-    current->Accept(location_builder);
-    InitLocations(current);
+    if (is_baseline_) {
+      current->Accept(location_builder);
+      InitLocations(current);
+    }
     current->Accept(instruction_visitor);
   }
 }
 
+void CodeGenerator::ComputeFrameSize(size_t number_of_spill_slots) {
+  SetFrameSize(RoundUp(
+      number_of_spill_slots * kVRegSize
+      + kVRegSize  // filler
+      + FrameEntrySpillSize()
+      + GetGraph()->GetMaximumNumberOfOutVRegs() * kVRegSize
+      + GetWordSize(),  // Art method
+      kStackAlignment));
+}
+
+int32_t CodeGenerator::GetSpillSlotOffset(size_t slot) const {
+  // The first slots are the ones of the dex registers that are not parameters,
+  // so that the GC map can describe the references they hold. The other slots
+  // are right below them.
+  size_t number_of_locals = GetGraph()->GetNumberOfVRegs() - GetGraph()->GetNumberOfInVRegs();
+  int32_t locals_start = GetFrameSize()
+      - FrameEntrySpillSize()
+      - kVRegSize  // filler
+      - number_of_locals * kVRegSize;
+  if (slot < number_of_locals) {
+    return locals_start + slot * kVRegSize;
+  }
+  return locals_start - (slot - number_of_locals + 1) * kVRegSize;
+}
+
+int32_t CodeGenerator::GetStackSlotOfParameter(HParameterValue* parameter) const {
+  // Parameters are stored in the caller's frame, above the method pointer.
+  return GetFrameSize() + GetWordSize() + parameter->GetIndex() * kVRegSize;
+}
+
 size_t CodeGenerator::AllocateFreeRegisterInternal(
     bool* blocked_registers, size_t number_of_registers) const {
   for (size_t regno = 0; regno < number_of_registers; regno++) {
@@ -156,6 +216,14 @@ void CodeGenerator::AllocateRegistersLocally(HInstruction* instruction) const {
 
 void CodeGenerator::InitLocations(HInstruction* instruction) {
   if (instruction->GetLocations() == nullptr) {
+    if (instruction->AsTemporary() != nullptr) {
+      // Spill the output of the previous instruction, so that it survives until its
+      // last use. Its users will load it from the temporary location.
+      HInstruction* previous = instruction->GetPrevious();
+      Location temp_location = GetTemporaryLocation(instruction->AsTemporary());
+      Move(previous, temp_location, instruction);
+      previous->GetLocations()->SetOut(temp_location);
+    }
     return;
   }
   AllocateRegistersLocally(instruction);
@@ -169,8 +237,9 @@ void CodeGenerator::InitLocations(HInstruction* instruction) {
 }
 
 bool CodeGenerator::GoesToNextBlock(HBasicBlock* current, HBasicBlock* next) const {
-  // We currently iterate over the block in insertion order.
-  return current->GetBlockId() + 1 == next->GetBlockId();
+  DCHECK_EQ(block_order_->Get(current_block_index_), current);
+  return (current_block_index_ + 1 < block_order_->Size())
+      && (block_order_->Get(current_block_index_ + 1) == next);
 }
 
 Label* CodeGenerator::GetLabelOf(HBasicBlock* block) const {
@@ -191,7 +260,7 @@ CodeGenerator* CodeGenerator::Create(ArenaAllocator* allocator,
       return new (allocator) x86::CodeGeneratorX86(graph);
     }
     case kX86_64: {
-      return new (allocator) x86::CodeGeneratorX86(graph);
+      return new (allocator) x86_64::CodeGeneratorX86_64(graph);
     }
     default:
       return nullptr;
@@ -212,75 +281,47 @@ void CodeGenerator::BuildNativeGCMap(
     }
   }
 
-  GcMapBuilder builder(data, pc_infos_.Size(), max_native_offset, dex_gc_map.RegWidth());
+  if (is_baseline_) {
+    // Dex registers live in their stack slot: use the map of the verifier.
+    GcMapBuilder builder(data, pc_infos_.Size(), max_native_offset, dex_gc_map.RegWidth());
+    for (size_t i = 0; i < pc_infos_.Size(); i++) {
+      struct PcInfo pc_info = pc_infos_.Get(i);
+      uint32_t native_offset = pc_info.native_pc;
+      uint32_t dex_pc = pc_info.dex_pc;
+      const uint8_t* references = dex_gc_map.FindBitMap(dex_pc, false);
+      CHECK(references != NULL) << "Missing ref for dex pc 0x" << std::hex << dex_pc;
+      builder.AddEntry(native_offset, references);
+    }
+    return;
+  }
+
+  // The register allocator recorded which dex register slots hold a reference
+  // at each call. Other pcs have no live reference in the stack.
+  size_t reg_width = RoundUp(GetGraph()->GetNumberOfVRegs(), kBitsPerByte) / kBitsPerByte;
+  std::vector<uint8_t> references(reg_width);
+  GcMapBuilder builder(data, pc_infos_.Size(), max_native_offset, reg_width);
   for (size_t i = 0; i < pc_infos_.Size(); i++) {
     struct PcInfo pc_info = pc_infos_.Get(i);
-    uint32_t native_offset = pc_info.native_pc;
-    uint32_t dex_pc = pc_info.dex_pc;
-    const uint8_t* references = dex_gc_map.FindBitMap(dex_pc, false);
-    CHECK(references != NULL) << "Missing ref for dex pc 0x" << std::hex << dex_pc;
-    builder.AddEntry(native_offset, references);
+    references.assign(reg_width, 0);
+    if (pc_info.stack_mask != nullptr) {
+      BitVector::Iterator it(pc_info.stack_mask);
+      for (int32_t index = it.Next(); index != -1; index = it.Next()) {
+        DCHECK_LT(static_cast<size_t>(index), GetGraph()->GetNumberOfVRegs());
+        references[index / kBitsPerByte] |= (1 << (index % kBitsPerByte));
+      }
+    }
+    builder.AddEntry(pc_info.native_pc, references.data());
   }
 }
 
 void CodeGenerator::BuildMappingTable(std::vector<uint8_t>* data) const {
-  uint32_t pc2dex_data_size = 0u;
-  uint32_t pc2dex_entries = pc_infos_.Size();
-  uint32_t pc2dex_offset = 0u;
-  int32_t pc2dex_dalvik_offset = 0;
-  uint32_t dex2pc_data_size = 0u;
-  uint32_t dex2pc_entries = 0u;
-
+  MappingTableBuilder builder;
   // We currently only have pc2dex entries.
-  for (size_t i = 0; i < pc2dex_entries; i++) {
-    struct PcInfo pc_info = pc_infos_.Get(i);
-    pc2dex_data_size += UnsignedLeb128Size(pc_info.native_pc - pc2dex_offset);
-    pc2dex_data_size += SignedLeb128Size(pc_info.dex_pc - pc2dex_dalvik_offset);
-    pc2dex_offset = pc_info.native_pc;
-    pc2dex_dalvik_offset = pc_info.dex_pc;
-  }
-
-  uint32_t total_entries = pc2dex_entries + dex2pc_entries;
-  uint32_t hdr_data_size = UnsignedLeb128Size(total_entries) + UnsignedLeb128Size(pc2dex_entries);
-  uint32_t data_size = hdr_data_size + pc2dex_data_size + dex2pc_data_size;
-  data->resize(data_size);
-
-  uint8_t* data_ptr = &(*data)[0];
-  uint8_t* write_pos = data_ptr;
-  write_pos = EncodeUnsignedLeb128(write_pos, total_entries);
-  write_pos = EncodeUnsignedLeb128(write_pos, pc2dex_entries);
-  DCHECK_EQ(static_cast<size_t>(write_pos - data_ptr), hdr_data_size);
-  uint8_t* write_pos2 = write_pos + pc2dex_data_size;
-
-  pc2dex_offset = 0u;
-  pc2dex_dalvik_offset = 0u;
-  for (size_t i = 0; i < pc2dex_entries; i++) {
+  for (size_t i = 0; i < pc_infos_.Size(); i++) {
     struct PcInfo pc_info = pc_infos_.Get(i);
-    DCHECK(pc2dex_offset <= pc_info.native_pc);
-    write_pos = EncodeUnsignedLeb128(write_pos, pc_info.native_pc - pc2dex_offset);
-    write_pos = EncodeSignedLeb128(write_pos, pc_info.dex_pc - pc2dex_dalvik_offset);
-    pc2dex_offset = pc_info.native_pc;
-    pc2dex_dalvik_offset = pc_info.dex_pc;
-  }
-  DCHECK_EQ(static_cast<size_t>(write_pos - data_ptr), hdr_data_size + pc2dex_data_size);
-  DCHECK_EQ(static_cast<size_t>(write_pos2 - data_ptr), data_size);
-
-  if (kIsDebugBuild) {
-    // Verify the encoded table holds the expected data.
-    MappingTable table(data_ptr);
-    CHECK_EQ(table.TotalSize(), total_entries);
-    CHECK_EQ(table.PcToDexSize(), pc2dex_entries);
-    auto it = table.PcToDexBegin();
-    auto it2 = table.DexToPcBegin();
-    for (size_t i = 0; i < pc2dex_entries; i++) {
-      struct PcInfo pc_info = pc_infos_.Get(i);
-      CHECK_EQ(pc_info.native_pc, it.NativePcOffset());
-      CHECK_EQ(pc_info.dex_pc, it.DexPc());
-      ++it;
-    }
-    CHECK(it == table.PcToDexEnd());
-    CHECK(it2 == table.DexToPcEnd());
+    builder.AddPcToDexEntry(static_cast<uint32_t>(pc_info.native_pc), pc_info.dex_pc);
   }
+  builder.Build(data);
 }
 
 void CodeGenerator::BuildVMapTable(std::vector<uint8_t>* data) const {
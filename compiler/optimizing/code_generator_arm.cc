@@ -20,8 +20,10 @@
 #include "utils/arm/managed_register_arm.h"
 
 #include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 
 #define __ reinterpret_cast<ArmAssembler*>(GetAssembler())->
@@ -37,10 +39,86 @@ namespace arm {
 static constexpr int kNumberOfPushedRegistersAtEntry = 1;
 static constexpr int kCurrentMethodStackOffset = 0;
 
+#undef __
+#define __ reinterpret_cast<ArmAssembler*>(codegen->GetAssembler())->
+
+class NullCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit NullCheckSlowPathARM(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowNullPointer).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathARM);
+};
+
+class BoundsCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit BoundsCheckSlowPathARM(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    // The index and the length are already in the registers of the runtime calling convention.
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowArrayBounds).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathARM);
+};
+
+#undef __
+#define __ reinterpret_cast<ArmAssembler*>(GetAssembler())->
+
+inline Condition ARMCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return EQ;
+    case kCondNE: return NE;
+    case kCondLT: return LT;
+    case kCondLE: return LE;
+    case kCondGT: return GT;
+    case kCondGE: return GE;
+    default:
+      LOG(FATAL) << "Unknown if condition";
+  }
+  return EQ;        // Unreachable.
+}
+
+inline Condition ARMOppositeCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return NE;
+    case kCondNE: return EQ;
+    case kCondLT: return GE;
+    case kCondLE: return GT;
+    case kCondGT: return LE;
+    case kCondGE: return LT;
+    default:
+      LOG(FATAL) << "Unknown if condition";
+  }
+  return EQ;        // Unreachable.
+}
+
 CodeGeneratorARM::CodeGeneratorARM(HGraph* graph)
     : CodeGenerator(graph, kNumberOfRegIds),
       location_builder_(graph, this),
-      instruction_visitor_(graph, this) {}
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this) {}
+
+size_t CodeGeneratorARM::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kArmWordSize;
+}
 
 static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
   return blocked_registers + kNumberOfAllocIds;
@@ -50,6 +128,7 @@ ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
     case Primitive::kPrimLong: {
+      UpdateBlockedPairRegisters(blocked_registers);
       size_t reg = AllocateFreeRegisterInternal(
           GetBlockedRegisterPairs(blocked_registers), kNumberOfRegisterPairs);
       ArmManagedRegister pair =
@@ -98,6 +177,9 @@ void CodeGeneratorARM::SetupBlockedRegisters(bool* blocked_registers) const {
   // Reserve thread register.
   blocked_registers[TR] = true;
 
+  // Reserve temp register.
+  blocked_registers[IP] = true;
+
   // TODO: We currently don't use Quick's callee saved registers.
   blocked_registers[R5] = true;
   blocked_registers[R6] = true;
@@ -108,6 +190,18 @@ void CodeGeneratorARM::SetupBlockedRegisters(bool* blocked_registers) const {
   blocked_register_pairs[R6_R7] = true;
 }
 
+void CodeGeneratorARM::UpdateBlockedPairRegisters(bool* blocked_registers) const {
+  bool* blocked_register_pairs = GetBlockedRegisterPairs(blocked_registers);
+  for (int i = 0; i < kNumberOfRegisterPairs; i++) {
+    ArmManagedRegister current =
+        ArmManagedRegister::FromRegisterPair(static_cast<RegisterPair>(i));
+    if (blocked_registers[current.AsRegisterPairLow()]
+        || blocked_registers[current.AsRegisterPairHigh()]) {
+      blocked_register_pairs[i] = true;
+    }
+  }
+}
+
 size_t CodeGeneratorARM::GetNumberOfRegisters() const {
   return kNumberOfRegIds;
 }
@@ -125,12 +219,6 @@ void CodeGeneratorARM::GenerateFrameEntry() {
   core_spill_mask_ |= (1 << LR);
   __ PushList((1 << LR));
 
-  SetFrameSize(RoundUp(
-      (GetGraph()->GetMaximumNumberOfOutVRegs() + GetGraph()->GetNumberOfVRegs()) * kVRegSize
-      + kVRegSize  // filler
-      + kArmWordSize  // Art method
-      + kNumberOfPushedRegistersAtEntry * kArmWordSize,
-      kStackAlignment));
   // The return PC has already been pushed on the stack.
   __ AddConstant(SP, -(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kArmWordSize));
   __ str(R0, Address(SP, 0));
@@ -162,6 +250,16 @@ int32_t CodeGeneratorARM::GetStackSlot(HLocal* local) const {
   }
 }
 
+Location CodeGeneratorARM::GetTemporaryLocation(HTemporary* temp) const {
+  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
+  // Use the temporary region (right below the dex registers).
+  int32_t slot = GetFrameSize() - (kNumberOfPushedRegistersAtEntry * kArmWordSize)
+                                - kVRegSize  // filler
+                                - (number_of_vregs * kVRegSize)
+                                - ((1 + temp->GetIndex()) * kVRegSize);
+  return Location::StackSlot(slot);
+}
+
 Location CodeGeneratorARM::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
@@ -244,8 +342,8 @@ void CodeGeneratorARM::Move32(Location destination, Location source) {
     if (source.IsRegister()) {
       __ str(source.AsArm().AsCoreRegister(), Address(SP, destination.GetStackIndex()));
     } else {
-      __ ldr(R0, Address(SP, source.GetStackIndex()));
-      __ str(R0, Address(SP, destination.GetStackIndex()));
+      __ ldr(IP, Address(SP, source.GetStackIndex()));
+      __ str(IP, Address(SP, destination.GetStackIndex()));
     }
   }
 }
@@ -285,8 +383,8 @@ void CodeGeneratorARM::Move64(Location destination, Location source) {
     } else {
       DCHECK(source.IsDoubleStackSlot());
       __ ldr(calling_convention.GetRegisterAt(argument_index), Address(SP, source.GetStackIndex()));
-      __ ldr(R0, Address(SP, source.GetHighStackIndex(kArmWordSize)));
-      __ str(R0, Address(SP, calling_convention.GetStackOffsetOf(argument_index + 1, kArmWordSize)));
+      __ ldr(IP, Address(SP, source.GetHighStackIndex(kArmWordSize)));
+      __ str(IP, Address(SP, calling_convention.GetStackOffsetOf(argument_index + 1, kArmWordSize)));
     }
   } else {
     DCHECK(destination.IsDoubleStackSlot());
@@ -303,15 +401,15 @@ void CodeGeneratorARM::Move64(Location destination, Location source) {
       uint32_t argument_index = source.GetQuickParameterIndex();
       __ str(calling_convention.GetRegisterAt(argument_index),
              Address(SP, destination.GetStackIndex()));
-      __ ldr(R0,
+      __ ldr(IP,
              Address(SP, calling_convention.GetStackOffsetOf(argument_index + 1, kArmWordSize) + GetFrameSize()));
-      __ str(R0, Address(SP, destination.GetHighStackIndex(kArmWordSize)));
+      __ str(IP, Address(SP, destination.GetHighStackIndex(kArmWordSize)));
     } else {
       DCHECK(source.IsDoubleStackSlot());
-      __ ldr(R0, Address(SP, source.GetStackIndex()));
-      __ str(R0, Address(SP, destination.GetStackIndex()));
-      __ ldr(R0, Address(SP, source.GetHighStackIndex(kArmWordSize)));
-      __ str(R0, Address(SP, destination.GetHighStackIndex(kArmWordSize)));
+      __ ldr(IP, Address(SP, source.GetStackIndex()));
+      __ str(IP, Address(SP, destination.GetStackIndex()));
+      __ ldr(IP, Address(SP, source.GetHighStackIndex(kArmWordSize)));
+      __ str(IP, Address(SP, destination.GetHighStackIndex(kArmWordSize)));
     }
   }
 }
@@ -322,8 +420,8 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
     if (location.IsRegister()) {
       __ LoadImmediate(location.AsArm().AsCoreRegister(), value);
     } else {
-      __ LoadImmediate(R0, value);
-      __ str(R0, Address(SP, location.GetStackIndex()));
+      __ LoadImmediate(IP, value);
+      __ str(IP, Address(SP, location.GetStackIndex()));
     }
   } else if (instruction->AsLongConstant() != nullptr) {
     int64_t value = instruction->AsLongConstant()->GetValue();
@@ -331,10 +429,10 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
       __ LoadImmediate(location.AsArm().AsRegisterPairLow(), Low32Bits(value));
       __ LoadImmediate(location.AsArm().AsRegisterPairHigh(), High32Bits(value));
     } else {
-      __ LoadImmediate(R0, Low32Bits(value));
-      __ str(R0, Address(SP, location.GetStackIndex()));
-      __ LoadImmediate(R0, High32Bits(value));
-      __ str(R0, Address(SP, location.GetHighStackIndex(kArmWordSize)));
+      __ LoadImmediate(IP, Low32Bits(value));
+      __ str(IP, Address(SP, location.GetStackIndex()));
+      __ LoadImmediate(IP, High32Bits(value));
+      __ str(IP, Address(SP, location.GetHighStackIndex(kArmWordSize)));
     }
   } else if (instruction->AsLoadLocal() != nullptr) {
     uint32_t stack_slot = GetStackSlot(instruction->AsLoadLocal()->GetLocal());
@@ -357,8 +455,10 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
     }
   } else {
     // This can currently only happen when the instruction that requests the move
-    // is the next to be compiled.
-    DCHECK_EQ(instruction->GetNext(), move_for);
+    // is the next to be compiled, or when the instruction has been spilled to a
+    // temporary, see CodeGenerator::InitLocations.
+    DCHECK((instruction->GetNext() == move_for)
+           || (instruction->GetNext()->AsTemporary() != nullptr));
     switch (instruction->GetType()) {
       case Primitive::kPrimBoolean:
       case Primitive::kPrimByte:
@@ -418,20 +518,70 @@ void InstructionCodeGeneratorARM::VisitIf(HIf* if_instr) {
   }
 }
 
-void LocationsBuilderARM::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(equal);
+void LocationsBuilderARM::VisitCondition(HCondition* comp) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(comp);
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::RequiresRegister());
   locations->SetOut(Location::RequiresRegister());
-  equal->SetLocations(locations);
+  comp->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorARM::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = equal->GetLocations();
-  __ teq(locations->InAt(0).AsArm().AsCoreRegister(),
+void InstructionCodeGeneratorARM::VisitCondition(HCondition* comp) {
+  LocationSummary* locations = comp->GetLocations();
+  __ cmp(locations->InAt(0).AsArm().AsCoreRegister(),
          ShifterOperand(locations->InAt(1).AsArm().AsCoreRegister()));
-  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(1), EQ);
-  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(0), NE);
+  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(1),
+         ARMCondition(comp->GetCondition()));
+  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(0),
+         ARMOppositeCondition(comp->GetCondition()));
+}
+
+void LocationsBuilderARM::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderARM::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
 }
 
 void LocationsBuilderARM::VisitLocal(HLocal* local) {
@@ -480,7 +630,12 @@ void LocationsBuilderARM::VisitIntConstant(HIntConstant* constant) {
 }
 
 void InstructionCodeGeneratorARM::VisitIntConstant(HIntConstant* constant) {
-  // Will be generated at use site.
+  LocationSummary* locations = constant->GetLocations();
+  if (locations != nullptr) {
+    // The register allocator gave the constant a location.
+    codegen_->Move(constant, locations->Out(), nullptr);
+  }
+  // Otherwise, the constant is generated at its use sites.
 }
 
 void LocationsBuilderARM::VisitLongConstant(HLongConstant* constant) {
@@ -547,8 +702,18 @@ void InstructionCodeGeneratorARM::VisitReturn(HReturn* ret) {
 }
 
 void LocationsBuilderARM::VisitInvokeStatic(HInvokeStatic* invoke) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
-  locations->AddTemp(Location::RequiresRegister());
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::HandleInvoke(HInvoke* invoke) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(invoke, LocationSummary::kCall);
+  // The callee expects its ArtMethod* in R0.
+  locations->AddTemp(ArmCoreLocation(R0));
 
   InvokeDexCallingConventionVisitor calling_convention_visitor;
   for (size_t i = 0; i < invoke->InputCount(); i++) {
@@ -610,7 +775,31 @@ void InstructionCodeGeneratorARM::VisitInvokeStatic(HInvokeStatic* invoke) {
   // LR()
   __ blx(LR);
 
-  codegen_->RecordPcInfo(invoke->GetDexPc());
+  codegen_->RecordPcInfo(invoke->GetDexPc(), invoke->GetLocations());
+}
+
+void InstructionCodeGeneratorARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  Register temp = invoke->GetLocations()->GetTemp(0).AsArm().AsCoreRegister();
+  size_t method_offset = mirror::Array::DataOffset(sizeof(mirror::Object*)).Int32Value() +
+      invoke->GetVTableIndex() * kArmWordSize;
+  // The receiver has been null checked and is passed in the first argument register.
+  Location receiver = invoke->GetLocations()->InAt(0);
+  DCHECK(receiver.IsRegister());
+
+  // temp = receiver->klass_;
+  __ LoadFromOffset(kLoadWord, temp, receiver.AsArm().AsCoreRegister(),
+                    mirror::Object::ClassOffset().Int32Value());
+  // temp = temp->vtable_;
+  __ LoadFromOffset(kLoadWord, temp, temp, mirror::Class::VTableOffset().Int32Value());
+  // temp = temp[vtable_index]
+  __ LoadFromOffset(kLoadWord, temp, temp, method_offset);
+  // LR = temp[offset_of_quick_compiled_code]
+  __ ldr(LR, Address(temp,
+                     mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
+  // LR()
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(invoke->GetDexPc(), invoke->GetLocations());
 }
 
 void LocationsBuilderARM::VisitAdd(HAdd* add) {
@@ -736,7 +925,8 @@ class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
 };
 
 void LocationsBuilderARM::VisitNewInstance(HNewInstance* instruction) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
   InvokeRuntimeCallingConvention calling_convention;
   locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(0)));
   locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(1)));
@@ -753,7 +943,7 @@ void InstructionCodeGeneratorARM::VisitNewInstance(HNewInstance* instruction) {
   __ ldr(LR, Address(TR, offset));
   __ blx(LR);
 
-  codegen_->RecordPcInfo(instruction->GetDexPc());
+  codegen_->RecordPcInfo(instruction->GetDexPc(), instruction->GetLocations());
 }
 
 void LocationsBuilderARM::VisitParameterValue(HParameterValue* instruction) {
@@ -786,11 +976,685 @@ void InstructionCodeGeneratorARM::VisitNot(HNot* instruction) {
 }
 
 void LocationsBuilderARM::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorARM::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  // Nothing to do, the register allocator inserted moves at the end of the
+  // predecessors.
+}
+
+void LocationsBuilderARM::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = compare->GetLocations();
+  switch (compare->InputAt(0)->GetType()) {
+    case Primitive::kPrimLong: {
+      Register output = locations->Out().AsArm().AsCoreRegister();
+      ArmManagedRegister left = locations->InAt(0).AsArm();
+      ArmManagedRegister right = locations->InAt(1).AsArm();
+      Label less, greater, done;
+      __ cmp(left.AsRegisterPairHigh(), ShifterOperand(right.AsRegisterPairHigh()));
+      __ b(&less, LT);  // Signed compare.
+      __ b(&greater, GT);  // Signed compare.
+      __ cmp(left.AsRegisterPairLow(), ShifterOperand(right.AsRegisterPairLow()));
+      // The output may alias an input, only write it once the flags are set. A move
+      // of an immediate does not change them.
+      __ LoadImmediate(output, 0);
+      __ b(&done, EQ);
+      __ b(&less, CC);  // Unsigned compare.
+
+      __ Bind(&greater);
+      __ LoadImmediate(output, 1);
+      __ b(&done);
+
+      __ Bind(&less);
+      __ LoadImmediate(output, -1);
+
+      __ Bind(&done);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << compare->InputAt(0)->GetType();
+  }
+}
+
+void LocationsBuilderARM::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  // Temporary registers for the write barrier.
+  if (instruction->GetFieldType() == Primitive::kPrimNot) {
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+  Primitive::Type field_type = instruction->GetFieldType();
+
+  switch (field_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      Register value = locations->InAt(1).AsArm().AsCoreRegister();
+      __ StoreToOffset(kStoreByte, value, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      Register value = locations->InAt(1).AsArm().AsCoreRegister();
+      __ StoreToOffset(kStoreHalfword, value, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      Register value = locations->InAt(1).AsArm().AsCoreRegister();
+      __ StoreToOffset(kStoreWord, value, obj, offset);
+
+      if (field_type == Primitive::kPrimNot) {
+        Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+        Register card = locations->GetTemp(1).AsArm().AsCoreRegister();
+        codegen_->MarkGCCard(temp, card, obj, value);
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      ArmManagedRegister value = locations->InAt(1).AsArm();
+      __ StoreToOffset(kStoreWordPair, value.AsRegisterPairLow(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << field_type;
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << field_type;
+  }
+}
+
+void CodeGeneratorARM::MarkGCCard(Register temp, Register card, Register object, Register value) {
+  Label is_null;
+  __ cmp(value, ShifterOperand(0));
+  __ b(&is_null, EQ);
+  __ LoadFromOffset(kLoadWord, card, TR, Thread::CardTableOffset<kArmWordSize>().Int32Value());
+  __ Lsr(temp, object, gc::accounting::CardTable::kCardShift);
+  __ add(temp, card, ShifterOperand(temp));
+  // The low byte of the biased card table base is the dirty card value.
+  __ strb(card, Address(temp, 0));
+  __ Bind(&is_null);
+}
+
+void LocationsBuilderARM::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadUnsignedByte, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadSignedByte, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadSignedHalfword, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadUnsignedHalfword, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadWord, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      ArmManagedRegister out = locations->Out().AsArm();
+      __ LoadFromOffset(kLoadWordPair, out.AsRegisterPairLow(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathARM(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  DCHECK_EQ(obj, locations->Out().AsArm().AsCoreRegister());
+
+  __ cmp(obj, ShifterOperand(0));
+  __ b(slow_path->GetEntryLabel(), EQ);
+}
+
+void LocationsBuilderARM::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register index = locations->InAt(1).AsArm().AsCoreRegister();
+
+  // The output may alias the array or the index, the address of the element is computed
+  // in a single instruction before being loaded from.
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(out, obj, ShifterOperand(index));
+      __ LoadFromOffset(kLoadUnsignedByte, out, out, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(out, obj, ShifterOperand(index));
+      __ LoadFromOffset(kLoadSignedByte, out, out, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int16_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(out, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ LoadFromOffset(kLoadSignedHalfword, out, out, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(out, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ LoadFromOffset(kLoadUnsignedHalfword, out, out, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(out, obj, ShifterOperand(index, LSL, TIMES_4));
+      __ LoadFromOffset(kLoadWord, out, out, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      ArmManagedRegister out = locations->Out().AsArm();
+      __ add(out.AsRegisterPairLow(), obj, ShifterOperand(index, LSL, TIMES_8));
+      __ LoadFromOffset(kLoadWordPair, out.AsRegisterPairLow(), out.AsRegisterPairLow(),
+                        data_offset);
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RequiresRegister());
+  // Temporary register for the address of the element.
+  locations->AddTemp(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register index = locations->InAt(1).AsArm().AsCoreRegister();
+  Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+  Primitive::Type value_type = instruction->GetComponentType();
+
+  switch (value_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      Register value = locations->InAt(2).AsArm().AsCoreRegister();
+      __ add(temp, obj, ShifterOperand(index));
+      __ StoreToOffset(kStoreByte, value, temp, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register value = locations->InAt(2).AsArm().AsCoreRegister();
+      __ add(temp, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ StoreToOffset(kStoreHalfword, value, temp, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimInt: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register value = locations->InAt(2).AsArm().AsCoreRegister();
+      __ add(temp, obj, ShifterOperand(index, LSL, TIMES_4));
+      __ StoreToOffset(kStoreWord, value, temp, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      ArmManagedRegister value = locations->InAt(2).AsArm();
+      __ add(temp, obj, ShifterOperand(index, LSL, TIMES_8));
+      __ StoreToOffset(kStoreWordPair, value.AsRegisterPairLow(), temp, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimNot:
+      // The builder does not support aput-object yet.
+      LOG(FATAL) << "Unimplemented register type " << value_type;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << value_type;
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << value_type;
+  }
+}
+
+void LocationsBuilderARM::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register out = locations->Out().AsArm().AsCoreRegister();
+  __ LoadFromOffset(kLoadWord, out, obj, offset);
+}
+
+void LocationsBuilderARM::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The slow path passes the index and the length to the runtime.
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) BoundsCheckSlowPathARM(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  Register index = locations->InAt(0).AsArm().AsCoreRegister();
+  Register length = locations->InAt(1).AsArm().AsCoreRegister();
+
+  // An unsigned compare also catches negative indices.
+  __ cmp(index, ShifterOperand(length));
+  __ b(slow_path->GetEntryLabel(), CS);
+}
+
+// Number of int elements in a quad NEON register.
+static constexpr int32_t kVecIntElements = 4;
+static constexpr int32_t kVecRegisterSize = 16;
+
+void LocationsBuilderARM::HandleVecArrayOperation(HInstruction* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // Only four registers are available for the arrays and the index.
+  locations->SetInAt(0, Location::Any());
+  for (size_t i = 1; i < instruction->InputCount(); ++i) {
+    locations->SetInAt(i, Location::RequiresRegister());
+  }
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::CompareWithTo(Register index, Location to) {
+  if (to.IsRegister()) {
+    __ cmp(index, ShifterOperand(to.AsArm().AsCoreRegister()));
+  } else {
+    __ LoadFromOffset(kLoadWord, IP, SP, to.GetStackIndex());
+    __ cmp(index, ShifterOperand(IP));
+  }
+}
+
+void InstructionCodeGeneratorARM::GenerateVecArrayOperation(HInstruction* instruction,
+                                                            int32_t from) {
+  LocationSummary* locations = instruction->GetLocations();
+  Location to = locations->InAt(0);
+  Register index = locations->Out().AsArm().AsCoreRegister();
+  uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  Label vector_loop, vector_done, scalar_loop, fail, done;
+
+  // An empty range is left to the loop. This also keeps the index below the
+  // length of the arrays, so that stepping it by four cannot overflow.
+  __ LoadImmediate(index, from);
+  CompareWithTo(index, to);
+  __ b(&fail, GE);
+  for (size_t i = 1; i < instruction->InputCount(); ++i) {
+    if (instruction->InputAt(i)->GetType() != Primitive::kPrimNot) {
+      // The value of a fill.
+      continue;
+    }
+    Register array = locations->InAt(i).AsArm().AsCoreRegister();
+    __ cmp(array, ShifterOperand(0));
+    __ b(&fail, EQ);
+    __ LoadFromOffset(kLoadWord, index, array, length_offset);
+    CompareWithTo(index, to);
+    __ b(&fail, LT);
+  }
+
+  __ LoadImmediate(index, from);
+  __ Bind(&vector_loop);
+  __ AddConstant(index, kVecIntElements);
+  CompareWithTo(index, to);
+  __ b(&vector_done, GT);
+  GenerateVecElements(instruction, index, true);
+  __ b(&vector_loop);
+  __ Bind(&vector_done);
+  __ AddConstant(index, -kVecIntElements);
+
+  __ Bind(&scalar_loop);
+  CompareWithTo(index, to);
+  __ b(&done, GE);
+  GenerateVecElements(instruction, index, false);
+  __ AddConstant(index, 1);
+  __ b(&scalar_loop);
+
+  __ Bind(&fail);
+  __ LoadImmediate(index, from);
+  __ Bind(&done);
+}
+
+void InstructionCodeGeneratorARM::GenerateVecElements(HInstruction* instruction,
+                                                      Register index,
+                                                      bool packed) {
+  LocationSummary* locations = instruction->GetLocations();
+  int32_t offset = mirror::Array::DataOffset(sizeof(int32_t)).Int32Value();
+  if (packed) {
+    // `index` is past the four elements.
+    offset -= kVecRegisterSize;
+  }
+  Register destination = locations->InAt(1).AsArm().AsCoreRegister();
+  if (instruction->AsVecFill() != nullptr) {
+    // VisitVecFill broadcasts the value in Q1.
+    __ add(IP, destination, ShifterOperand(index, LSL, TIMES_4));
+    if (packed) {
+      __ AddConstant(IP, offset);
+      __ vst1q32(Q1, IP);
+    } else {
+      Register value = locations->InAt(2).AsArm().AsCoreRegister();
+      __ StoreToOffset(kStoreWord, value, IP, offset);
+    }
+    return;
+  }
+
+  // Single elements go through the first lane of Q0 and Q1, that is S0 and S4.
+  Register left = locations->InAt(2).AsArm().AsCoreRegister();
+  __ add(IP, left, ShifterOperand(index, LSL, TIMES_4));
+  if (packed) {
+    __ AddConstant(IP, offset);
+    __ vld1q32(Q0, IP);
+  } else {
+    __ LoadSFromOffset(S0, IP, offset);
+  }
+
+  if (instruction->AsVecCopy() == nullptr) {
+    Register right = locations->InAt(3).AsArm().AsCoreRegister();
+    __ add(IP, right, ShifterOperand(index, LSL, TIMES_4));
+    if (packed) {
+      __ AddConstant(IP, offset);
+      __ vld1q32(Q1, IP);
+    } else {
+      __ LoadSFromOffset(S4, IP, offset);
+    }
+    if (instruction->AsVecAdd() != nullptr) {
+      __ vaddqi32(Q0, Q0, Q1);
+    } else {
+      DCHECK(instruction->AsVecSub() != nullptr);
+      __ vsubqi32(Q0, Q0, Q1);
+    }
+  }
+
+  __ add(IP, destination, ShifterOperand(index, LSL, TIMES_4));
+  if (packed) {
+    __ AddConstant(IP, offset);
+    __ vst1q32(Q0, IP);
+  } else {
+    __ StoreSToOffset(S0, IP, offset);
+  }
+}
+
+void LocationsBuilderARM::VisitVecFill(HVecFill* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorARM::VisitVecFill(HVecFill* instruction) {
+  __ vdupq32(Q1, instruction->GetLocations()->InAt(2).AsArm().AsCoreRegister());
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderARM::VisitVecCopy(HVecCopy* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorARM::VisitVecCopy(HVecCopy* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderARM::VisitVecAdd(HVecAdd* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorARM::VisitVecAdd(HVecAdd* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderARM::VisitVecSub(HVecSub* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorARM::VisitVecSub(HVecSub* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderARM::VisitVecSum(HVecSum* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitVecSum(HVecSum* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register array = locations->InAt(0).AsArm().AsCoreRegister();
+  Register index = locations->GetTemp(0).AsArm().AsCoreRegister();
+  Register out = locations->Out().AsArm().AsCoreRegister();
+  int32_t length_offset = mirror::Array::LengthOffset().Int32Value();
+  int32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Int32Value();
+  Label vector_loop, vector_done, scalar_loop, done;
+
+  // Sum four lanes in Q0.
+  __ veorq(Q0, Q0, Q0);
+  __ LoadImmediate(index, 0);
+  __ Bind(&vector_loop);
+  __ AddConstant(index, kVecIntElements);
+  __ LoadFromOffset(kLoadWord, IP, array, length_offset);
+  __ cmp(index, ShifterOperand(IP));
+  __ b(&vector_done, GT);
+  __ add(IP, array, ShifterOperand(index, LSL, TIMES_4));
+  __ AddConstant(IP, data_offset - kVecRegisterSize);
+  __ vld1q32(Q1, IP);
+  __ vaddqi32(Q0, Q0, Q1);
+  __ b(&vector_loop);
+  __ Bind(&vector_done);
+  __ AddConstant(index, -kVecIntElements);
+
+  // Add the lanes together: Q0 is D0 and D1.
+  __ vaddi32(D0, D0, D1);
+  __ vpaddi32(D0, D0, D0);
+  __ vmovrs(out, S0);
+
+  __ Bind(&scalar_loop);
+  __ LoadFromOffset(kLoadWord, IP, array, length_offset);
+  __ cmp(index, ShifterOperand(IP));
+  __ b(&done, GE);
+  __ add(IP, array, ShifterOperand(index, LSL, TIMES_4));
+  __ LoadFromOffset(kLoadWord, IP, IP, data_offset);
+  __ add(out, out, ShifterOperand(IP));
+  __ AddConstant(index, 1);
+  __ b(&scalar_loop);
+  __ Bind(&done);
+}
+
+void LocationsBuilderARM::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderARM::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void InstructionCodeGeneratorARM::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+ArmAssembler* ParallelMoveResolverARM::GetAssembler() const {
+  return codegen_->GetAssembler();
+}
+
+void ParallelMoveResolverARM::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister()) {
+    if (destination.IsRegister()) {
+      __ Mov(destination.AsArm().AsCoreRegister(), source.AsArm().AsCoreRegister());
+    } else {
+      DCHECK(destination.IsStackSlot());
+      __ str(source.AsArm().AsCoreRegister(), Address(SP, destination.GetStackIndex()));
+    }
+  } else if (source.IsStackSlot()) {
+    if (destination.IsRegister()) {
+      __ ldr(destination.AsArm().AsCoreRegister(), Address(SP, source.GetStackIndex()));
+    } else {
+      DCHECK(destination.IsStackSlot());
+      __ ldr(IP, Address(SP, source.GetStackIndex()));
+      __ str(IP, Address(SP, destination.GetStackIndex()));
+    }
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
+}
+
+void ParallelMoveResolverARM::Exchange(Register reg, int mem) {
+  __ Mov(IP, reg);
+  __ ldr(reg, Address(SP, mem));
+  __ str(IP, Address(SP, mem));
+}
+
+void ParallelMoveResolverARM::Exchange(int mem1, int mem2) {
+  // LR has been saved at the method entry, and is not live outside of calls:
+  // use it as a second scratch register.
+  __ ldr(IP, Address(SP, mem1));
+  __ ldr(LR, Address(SP, mem2));
+  __ str(IP, Address(SP, mem2));
+  __ str(LR, Address(SP, mem1));
+}
+
+void ParallelMoveResolverARM::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    DCHECK_NE(source.AsArm().AsCoreRegister(), IP);
+    DCHECK_NE(destination.AsArm().AsCoreRegister(), IP);
+    __ Mov(IP, source.AsArm().AsCoreRegister());
+    __ Mov(source.AsArm().AsCoreRegister(), destination.AsArm().AsCoreRegister());
+    __ Mov(destination.AsArm().AsCoreRegister(), IP);
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(source.AsArm().AsCoreRegister(), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(destination.AsArm().AsCoreRegister(), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(source.GetStackIndex(), destination.GetStackIndex());
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
 }
 
 }  // namespace arm
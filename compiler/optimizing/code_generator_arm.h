@@ -71,6 +71,10 @@ class LocationsBuilderARM : public HGraphVisitor {
 
 #undef DECLARE_VISIT_INSTRUCTION
 
+  void VisitCondition(HCondition* comp);
+  void HandleInvoke(HInvoke* invoke);
+  void HandleVecArrayOperation(HInstruction* instruction);
+
  private:
   CodeGeneratorARM* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
@@ -90,8 +94,20 @@ class InstructionCodeGeneratorARM : public HGraphVisitor {
 #undef DECLARE_VISIT_INSTRUCTION
 
   ArmAssembler* GetAssembler() const { return assembler_; }
+  void VisitCondition(HCondition* comp);
   void LoadCurrentMethod(Register reg);
 
+  // Emits the loops of a vector array operation, leaving the index of the
+  // first element not processed in the output register.
+  void GenerateVecArrayOperation(HInstruction* instruction, int32_t from);
+
+  // Emits the operation of `instruction` on the four elements before `index`
+  // if `packed`, or on the element at `index` otherwise.
+  void GenerateVecElements(HInstruction* instruction, Register index, bool packed);
+
+  // Compares `index` with the `to` input of a vector array operation.
+  void CompareWithTo(Register index, Location to);
+
  private:
   ArmAssembler* const assembler_;
   CodeGeneratorARM* const codegen_;
@@ -99,6 +115,26 @@ class InstructionCodeGeneratorARM : public HGraphVisitor {
   DISALLOW_COPY_AND_ASSIGN(InstructionCodeGeneratorARM);
 };
 
+class ParallelMoveResolverARM : public ParallelMoveResolver {
+ public:
+  ParallelMoveResolverARM(ArenaAllocator* allocator, CodeGeneratorARM* codegen)
+      : ParallelMoveResolver(allocator), codegen_(codegen) {}
+
+  ArmAssembler* GetAssembler() const;
+
+ protected:
+  virtual void EmitMove(size_t index) OVERRIDE;
+  virtual void EmitSwap(size_t index) OVERRIDE;
+
+ private:
+  void Exchange(Register reg, int mem);
+  void Exchange(int mem1, int mem2);
+
+  CodeGeneratorARM* const codegen_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMoveResolverARM);
+};
+
 class CodeGeneratorARM : public CodeGenerator {
  public:
   explicit CodeGeneratorARM(HGraph* graph);
@@ -113,6 +149,8 @@ class CodeGeneratorARM : public CodeGenerator {
     return kArmWordSize;
   }
 
+  virtual size_t FrameEntrySpillSize() const OVERRIDE;
+
   virtual HGraphVisitor* GetLocationBuilder() OVERRIDE {
     return &location_builder_;
   }
@@ -130,10 +168,25 @@ class CodeGeneratorARM : public CodeGenerator {
       Primitive::Type type, bool* blocked_registers) const OVERRIDE;
   virtual size_t GetNumberOfRegisters() const OVERRIDE;
 
+  virtual size_t GetNumberOfCoreRegisters() const OVERRIDE {
+    return kNumberOfCoreRegisters;
+  }
+
   int32_t GetStackSlot(HLocal* local) const;
   virtual Location GetStackLocation(HLoadLocal* load) const OVERRIDE;
+  virtual Location GetTemporaryLocation(HTemporary* temp) const OVERRIDE;
+
+  virtual ParallelMoveResolverARM* GetMoveResolver() OVERRIDE {
+    return &move_resolver_;
+  }
+
+  // Emit a write barrier.
+  void MarkGCCard(Register temp, Register card, Register object, Register value);
 
  private:
+  // Blocks the register pairs of which a register is already blocked.
+  void UpdateBlockedPairRegisters(bool* blocked_registers) const;
+
   // Helper method to move a 32bits value between two locations.
   void Move32(Location destination, Location source);
   // Helper method to move a 64bits value between two locations.
@@ -141,6 +194,7 @@ class CodeGeneratorARM : public CodeGenerator {
 
   LocationsBuilderARM location_builder_;
   InstructionCodeGeneratorARM instruction_visitor_;
+  ParallelMoveResolverARM move_resolver_;
   ArmAssembler assembler_;
 
   DISALLOW_COPY_AND_ASSIGN(CodeGeneratorARM);
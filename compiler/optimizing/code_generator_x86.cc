@@ -20,8 +20,10 @@
 #include "utils/x86/managed_register_x86.h"
 
 #include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 
 #define __ reinterpret_cast<X86Assembler*>(GetAssembler())->
@@ -37,10 +39,68 @@ namespace x86 {
 static constexpr int kNumberOfPushedRegistersAtEntry = 1;
 static constexpr int kCurrentMethodStackOffset = 0;
 
+#undef __
+#define __ reinterpret_cast<X86Assembler*>(codegen->GetAssembler())->
+
+class NullCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit NullCheckSlowPathX86(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowNullPointer)));
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathX86);
+};
+
+class BoundsCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit BoundsCheckSlowPathX86(uint32_t dex_pc) : dex_pc_(dex_pc) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    // The index and the length are already in the registers of the runtime calling convention.
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowArrayBounds)));
+    codegen->RecordPcInfo(dex_pc_);
+  }
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathX86);
+};
+
+#undef __
+#define __ reinterpret_cast<X86Assembler*>(GetAssembler())->
+
+inline Condition X86Condition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return kEqual;
+    case kCondNE: return kNotEqual;
+    case kCondLT: return kLess;
+    case kCondLE: return kLessEqual;
+    case kCondGT: return kGreater;
+    case kCondGE: return kGreaterEqual;
+    default:
+      LOG(FATAL) << "Unknown if condition";
+  }
+  return kEqual;
+}
+
 CodeGeneratorX86::CodeGeneratorX86(HGraph* graph)
     : CodeGenerator(graph, kNumberOfRegIds),
       location_builder_(graph, this),
-      instruction_visitor_(graph, this) {}
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this) {}
+
+size_t CodeGeneratorX86::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kX86WordSize;
+}
 
 static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
   return blocked_registers + kNumberOfAllocIds;
@@ -50,6 +110,7 @@ ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
     case Primitive::kPrimLong: {
+      UpdateBlockedPairRegisters(blocked_registers);
       size_t reg = AllocateFreeRegisterInternal(
           GetBlockedRegisterPairs(blocked_registers), kNumberOfRegisterPairs);
       X86ManagedRegister pair =
@@ -99,6 +160,18 @@ void CodeGeneratorX86::SetupBlockedRegisters(bool* blocked_registers) const {
   blocked_register_pairs[EBX_EDI] = true;
 }
 
+void CodeGeneratorX86::UpdateBlockedPairRegisters(bool* blocked_registers) const {
+  bool* blocked_register_pairs = GetBlockedRegisterPairs(blocked_registers);
+  for (int i = 0; i < kNumberOfRegisterPairs; i++) {
+    X86ManagedRegister current =
+        X86ManagedRegister::FromRegisterPair(static_cast<RegisterPair>(i));
+    if (blocked_registers[current.AsRegisterPairLow()]
+        || blocked_registers[current.AsRegisterPairHigh()]) {
+      blocked_register_pairs[i] = true;
+    }
+  }
+}
+
 size_t CodeGeneratorX86::GetNumberOfRegisters() const {
   return kNumberOfRegIds;
 }
@@ -117,13 +190,6 @@ void CodeGeneratorX86::GenerateFrameEntry() {
   static const int kFakeReturnRegister = 8;
   core_spill_mask_ |= (1 << kFakeReturnRegister);
 
-  SetFrameSize(RoundUp(
-      (GetGraph()->GetMaximumNumberOfOutVRegs() + GetGraph()->GetNumberOfVRegs()) * kVRegSize
-      + kVRegSize  // filler
-      + kX86WordSize  // Art method
-      + kNumberOfPushedRegistersAtEntry * kX86WordSize,
-      kStackAlignment));
-
   // The return PC has already been pushed on the stack.
   __ subl(ESP, Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86WordSize));
   __ movl(Address(ESP, kCurrentMethodStackOffset), EAX);
@@ -158,6 +224,15 @@ int32_t CodeGeneratorX86::GetStackSlot(HLocal* local) const {
   }
 }
 
+Location CodeGeneratorX86::GetTemporaryLocation(HTemporary* temp) const {
+  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
+  // Use the temporary region (right below the dex registers).
+  int32_t slot = GetFrameSize() - (kNumberOfPushedRegistersAtEntry * kX86WordSize)
+                                - kVRegSize  // filler
+                                - (number_of_vregs * kVRegSize)
+                                - ((1 + temp->GetIndex()) * kVRegSize);
+  return Location::StackSlot(slot);
+}
 
 Location CodeGeneratorX86::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
@@ -358,8 +433,10 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
     }
   } else {
     // This can currently only happen when the instruction that requests the move
-    // is the next to be compiled.
-    DCHECK_EQ(instruction->GetNext(), move_for);
+    // is the next to be compiled, or when the instruction has been spilled to a
+    // temporary, see CodeGenerator::InitLocations.
+    DCHECK((instruction->GetNext() == move_for)
+           || (instruction->GetNext()->AsTemporary() != nullptr));
     switch (instruction->GetType()) {
       case Primitive::kPrimBoolean:
       case Primitive::kPrimByte:
@@ -465,16 +542,17 @@ void LocationsBuilderX86::VisitStoreLocal(HStoreLocal* store) {
 void InstructionCodeGeneratorX86::VisitStoreLocal(HStoreLocal* store) {
 }
 
-void LocationsBuilderX86::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(equal);
+void LocationsBuilderX86::VisitCondition(HCondition* comp) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(comp);
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::Any());
   locations->SetOut(Location::SameAsFirstInput());
-  equal->SetLocations(locations);
+  comp->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorX86::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = equal->GetLocations();
+void InstructionCodeGeneratorX86::VisitCondition(HCondition* comp) {
+  LocationSummary* locations = comp->GetLocations();
+  Register reg = locations->Out().AsX86().AsCpuRegister();
   if (locations->InAt(1).IsRegister()) {
     __ cmpl(locations->InAt(0).AsX86().AsCpuRegister(),
             locations->InAt(1).AsX86().AsCpuRegister());
@@ -482,7 +560,57 @@ void InstructionCodeGeneratorX86::VisitEqual(HEqual* equal) {
     __ cmpl(locations->InAt(0).AsX86().AsCpuRegister(),
             Address(ESP, locations->InAt(1).GetStackIndex()));
   }
-  __ setb(kEqual, locations->Out().AsX86().AsCpuRegister());
+  __ setb(X86Condition(comp->GetCondition()), reg);
+  // setb only writes the low byte of the register.
+  __ movzxb(reg, locations->Out().AsX86().AsByteRegister());
+}
+
+void LocationsBuilderX86::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitEqual(HEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderX86::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitNotEqual(HNotEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderX86::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitLessThan(HLessThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderX86::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderX86::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitGreaterThan(HGreaterThan* comp) {
+  VisitCondition(comp);
+}
+
+void LocationsBuilderX86::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  VisitCondition(comp);
 }
 
 void LocationsBuilderX86::VisitIntConstant(HIntConstant* constant) {
@@ -490,7 +618,12 @@ void LocationsBuilderX86::VisitIntConstant(HIntConstant* constant) {
 }
 
 void InstructionCodeGeneratorX86::VisitIntConstant(HIntConstant* constant) {
-  // Will be generated at use site.
+  LocationSummary* locations = constant->GetLocations();
+  if (locations != nullptr) {
+    // The register allocator gave the constant a location.
+    codegen_->Move(constant, locations->Out(), nullptr);
+  }
+  // Otherwise, the constant is generated at its use sites.
 }
 
 void LocationsBuilderX86::VisitLongConstant(HLongConstant* constant) {
@@ -558,8 +691,18 @@ void InstructionCodeGeneratorX86::VisitReturn(HReturn* ret) {
 }
 
 void LocationsBuilderX86::VisitInvokeStatic(HInvokeStatic* invoke) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
-  locations->AddTemp(Location::RequiresRegister());
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::HandleInvoke(HInvoke* invoke) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(invoke, LocationSummary::kCall);
+  // The callee expects its ArtMethod* in EAX.
+  locations->AddTemp(X86CpuLocation(EAX));
 
   InvokeDexCallingConventionVisitor calling_convention_visitor;
   for (size_t i = 0; i < invoke->InputCount(); i++) {
@@ -614,7 +757,28 @@ void InstructionCodeGeneratorX86::VisitInvokeStatic(HInvokeStatic* invoke) {
   // (temp + offset_of_quick_compiled_code)()
   __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
 
-  codegen_->RecordPcInfo(invoke->GetDexPc());
+  codegen_->RecordPcInfo(invoke->GetDexPc(), invoke->GetLocations());
+}
+
+void InstructionCodeGeneratorX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  Register temp = invoke->GetLocations()->GetTemp(0).AsX86().AsCpuRegister();
+  size_t method_offset = mirror::Array::DataOffset(sizeof(mirror::Object*)).Int32Value() +
+      invoke->GetVTableIndex() * kX86WordSize;
+  // The receiver has been null checked and is passed in the first argument register.
+  Location receiver = invoke->GetLocations()->InAt(0);
+  DCHECK(receiver.IsRegister());
+
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver.AsX86().AsCpuRegister(),
+                        mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->vtable_;
+  __ movl(temp, Address(temp, mirror::Class::VTableOffset().Int32Value()));
+  // temp = temp[vtable_index]
+  __ movl(temp, Address(temp, method_offset));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
+
+  codegen_->RecordPcInfo(invoke->GetDexPc(), invoke->GetLocations());
 }
 
 void LocationsBuilderX86::VisitAdd(HAdd* add) {
@@ -756,7 +920,8 @@ void InstructionCodeGeneratorX86::VisitSub(HSub* sub) {
 }
 
 void LocationsBuilderX86::VisitNewInstance(HNewInstance* instruction) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
   locations->SetOut(X86CpuLocation(EAX));
   InvokeRuntimeCallingConvention calling_convention;
   locations->AddTemp(X86CpuLocation(calling_convention.GetRegisterAt(0)));
@@ -772,7 +937,7 @@ void InstructionCodeGeneratorX86::VisitNewInstance(HNewInstance* instruction) {
   __ fs()->call(
       Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pAllocObjectWithAccessCheck)));
 
-  codegen_->RecordPcInfo(instruction->GetDexPc());
+  codegen_->RecordPcInfo(instruction->GetDexPc(), instruction->GetLocations());
 }
 
 void LocationsBuilderX86::VisitParameterValue(HParameterValue* instruction) {
@@ -806,11 +971,699 @@ void InstructionCodeGeneratorX86::VisitNot(HNot* instruction) {
 }
 
 void LocationsBuilderX86::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorX86::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  // Nothing to do, the register allocator inserted moves at the end of the
+  // predecessors.
+}
+
+void LocationsBuilderX86::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::Any());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = compare->GetLocations();
+  switch (compare->InputAt(0)->GetType()) {
+    case Primitive::kPrimLong: {
+      Label less, greater, done;
+      Register output = locations->Out().AsX86().AsCpuRegister();
+      X86ManagedRegister left = locations->InAt(0).AsX86();
+      Location right = locations->InAt(1);
+      if (right.IsRegister()) {
+        __ cmpl(left.AsRegisterPairHigh(), right.AsX86().AsRegisterPairHigh());
+      } else {
+        DCHECK(right.IsDoubleStackSlot());
+        __ cmpl(left.AsRegisterPairHigh(),
+                Address(ESP, right.GetHighStackIndex(kX86WordSize)));
+      }
+      __ j(kLess, &less);  // Signed compare.
+      __ j(kGreater, &greater);  // Signed compare.
+      if (right.IsRegister()) {
+        __ cmpl(left.AsRegisterPairLow(), right.AsX86().AsRegisterPairLow());
+      } else {
+        DCHECK(right.IsDoubleStackSlot());
+        __ cmpl(left.AsRegisterPairLow(), Address(ESP, right.GetStackIndex()));
+      }
+      // The output may alias an input, only write it once the flags are set. A move
+      // does not change them.
+      __ movl(output, Immediate(0));
+      __ j(kEqual, &done);
+      __ j(kBelow, &less);  // Unsigned compare.
+
+      __ Bind(&greater);
+      __ movl(output, Immediate(1));
+      __ jmp(&done);
+
+      __ Bind(&less);
+      __ movl(output, Immediate(-1));
+
+      __ Bind(&done);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << compare->InputAt(0)->GetType();
+  }
+}
+
+void LocationsBuilderX86::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  Primitive::Type field_type = instruction->GetFieldType();
+  if (field_type == Primitive::kPrimBoolean || field_type == Primitive::kPrimByte) {
+    // Ensure the value is in a byte register.
+    locations->SetInAt(1, X86CpuLocation(EAX));
+  } else {
+    locations->SetInAt(1, Location::RequiresRegister());
+  }
+  // Temporary registers for the write barrier.
+  if (field_type == Primitive::kPrimNot) {
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+  Primitive::Type field_type = instruction->GetFieldType();
+
+  switch (field_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      ByteRegister value = locations->InAt(1).AsX86().AsByteRegister();
+      __ movb(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      Register value = locations->InAt(1).AsX86().AsCpuRegister();
+      __ movw(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      Register value = locations->InAt(1).AsX86().AsCpuRegister();
+      __ movl(Address(obj, offset), value);
+
+      if (field_type == Primitive::kPrimNot) {
+        Register temp = locations->GetTemp(0).AsX86().AsCpuRegister();
+        Register card = locations->GetTemp(1).AsX86().AsCpuRegister();
+        codegen_->MarkGCCard(temp, card, obj, value);
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      X86ManagedRegister value = locations->InAt(1).AsX86();
+      __ movl(Address(obj, offset), value.AsRegisterPairLow());
+      __ movl(Address(obj, kX86WordSize + offset), value.AsRegisterPairHigh());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << field_type;
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << field_type;
+  }
+}
+
+void CodeGeneratorX86::MarkGCCard(Register temp, Register card, Register object, Register value) {
+  Label is_null;
+  __ testl(value, value);
+  __ j(kEqual, &is_null);
+  __ fs()->movl(card, Address::Absolute(Thread::CardTableOffset<kX86WordSize>()));
+  __ movl(temp, object);
+  __ shrl(temp, Immediate(gc::accounting::CardTable::kCardShift));
+  // The low byte of the biased card table base is the dirty card value.
+  __ movb(Address(temp, card, TIMES_1, 0),
+          X86ManagedRegister::FromCpuRegister(card).AsByteRegister());
+  __ Bind(&is_null);
+}
+
+void LocationsBuilderX86::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movl(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      // The output may alias the object, load the half in the other register first.
+      X86ManagedRegister out = locations->Out().AsX86();
+      if (out.AsRegisterPairLow() == obj) {
+        __ movl(out.AsRegisterPairHigh(), Address(obj, kX86WordSize + offset));
+        __ movl(out.AsRegisterPairLow(), Address(obj, offset));
+      } else {
+        __ movl(out.AsRegisterPairLow(), Address(obj, offset));
+        __ movl(out.AsRegisterPairHigh(), Address(obj, kX86WordSize + offset));
+      }
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathX86(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  DCHECK_EQ(obj, locations->Out().AsX86().AsCpuRegister());
+
+  __ testl(obj, obj);
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register index = locations->InAt(1).AsX86().AsCpuRegister();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int16_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movl(out, Address(obj, index, TIMES_4, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      // The output may alias the array or the index, compute the address of the element
+      // in its low register first.
+      X86ManagedRegister out = locations->Out().AsX86();
+      __ leal(out.AsRegisterPairLow(), Address(obj, index, TIMES_8, data_offset));
+      __ movl(out.AsRegisterPairHigh(), Address(out.AsRegisterPairLow(), kX86WordSize));
+      __ movl(out.AsRegisterPairLow(), Address(out.AsRegisterPairLow(), 0));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << instruction->GetType();
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  Primitive::Type value_type = instruction->GetComponentType();
+  if (value_type == Primitive::kPrimBoolean || value_type == Primitive::kPrimByte) {
+    // Ensure the value is in a byte register.
+    locations->SetInAt(2, X86CpuLocation(EAX));
+  } else {
+    locations->SetInAt(2, Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register index = locations->InAt(1).AsX86().AsCpuRegister();
+  Primitive::Type value_type = instruction->GetComponentType();
+
+  switch (value_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      ByteRegister value = locations->InAt(2).AsX86().AsByteRegister();
+      __ movb(Address(obj, index, TIMES_1, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register value = locations->InAt(2).AsX86().AsCpuRegister();
+      __ movw(Address(obj, index, TIMES_2, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimInt: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register value = locations->InAt(2).AsX86().AsCpuRegister();
+      __ movl(Address(obj, index, TIMES_4, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      X86ManagedRegister value = locations->InAt(2).AsX86();
+      __ movl(Address(obj, index, TIMES_8, data_offset), value.AsRegisterPairLow());
+      __ movl(Address(obj, index, TIMES_8, data_offset + kX86WordSize),
+              value.AsRegisterPairHigh());
+      break;
+    }
+
+    case Primitive::kPrimNot:
+      // The builder does not support aput-object yet.
+      LOG(FATAL) << "Unimplemented register type " << value_type;
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      LOG(FATAL) << "Unimplemented register type " << value_type;
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << value_type;
+  }
+}
+
+void LocationsBuilderX86::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  __ movl(out, Address(obj, offset));
+}
+
+void LocationsBuilderX86::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The slow path passes the index and the length to the runtime.
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, X86CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, X86CpuLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) BoundsCheckSlowPathX86(instruction->GetDexPc());
+  codegen_->AddSlowPath(slow_path);
+
+  Register index = locations->InAt(0).AsX86().AsCpuRegister();
+  Register length = locations->InAt(1).AsX86().AsCpuRegister();
+
+  // An unsigned compare also catches negative indices.
+  __ cmpl(index, length);
+  __ j(kAboveEqual, slow_path->GetEntryLabel());
+}
+
+// Number of int elements in an XMM register.
+static constexpr int32_t kVecIntElements = 4;
+static constexpr int32_t kVecRegisterSize = 16;
+
+static void CompareWithTo(X86Assembler* assembler, Register index, Location to) {
+  if (to.IsRegister()) {
+    assembler->cmpl(index, to.AsX86().AsCpuRegister());
+  } else {
+    assembler->cmpl(index, Address(ESP, to.GetStackIndex()));
+  }
+}
+
+void LocationsBuilderX86::HandleVecArrayOperation(HInstruction* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // Only four registers are available for the arrays and the index.
+  locations->SetInAt(0, Location::Any());
+  for (size_t i = 1; i < instruction->InputCount(); ++i) {
+    locations->SetInAt(i, Location::RequiresRegister());
+  }
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::GenerateVecArrayOperation(HInstruction* instruction,
+                                                            int32_t from) {
+  LocationSummary* locations = instruction->GetLocations();
+  Location to = locations->InAt(0);
+  Register index = locations->Out().AsX86().AsCpuRegister();
+  uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  Label vector_loop, vector_done, scalar_loop, fail, done;
+
+  // An empty range is left to the loop. This also keeps the index below the
+  // length of the arrays, so that stepping it by four cannot overflow.
+  __ movl(index, Immediate(from));
+  CompareWithTo(GetAssembler(), index, to);
+  __ j(kGreaterEqual, &fail);
+  for (size_t i = 1; i < instruction->InputCount(); ++i) {
+    if (instruction->InputAt(i)->GetType() != Primitive::kPrimNot) {
+      // The value of a fill.
+      continue;
+    }
+    Register array = locations->InAt(i).AsX86().AsCpuRegister();
+    __ testl(array, array);
+    __ j(kEqual, &fail);
+    __ movl(index, Address(array, length_offset));
+    CompareWithTo(GetAssembler(), index, to);
+    __ j(kLess, &fail);
+  }
+
+  __ movl(index, Immediate(from));
+  __ Bind(&vector_loop);
+  __ addl(index, Immediate(kVecIntElements));
+  CompareWithTo(GetAssembler(), index, to);
+  __ j(kGreater, &vector_done);
+  GenerateVecElements(instruction, index, true);
+  __ jmp(&vector_loop);
+  __ Bind(&vector_done);
+  __ subl(index, Immediate(kVecIntElements));
+
+  __ Bind(&scalar_loop);
+  CompareWithTo(GetAssembler(), index, to);
+  __ j(kGreaterEqual, &done);
+  GenerateVecElements(instruction, index, false);
+  __ addl(index, Immediate(1));
+  __ jmp(&scalar_loop);
+
+  __ Bind(&fail);
+  __ movl(index, Immediate(from));
+  __ Bind(&done);
+}
+
+void InstructionCodeGeneratorX86::GenerateVecElements(HInstruction* instruction,
+                                                      Register index,
+                                                      bool packed) {
+  LocationSummary* locations = instruction->GetLocations();
+  int32_t offset = mirror::Array::DataOffset(sizeof(int32_t)).Int32Value();
+  if (packed) {
+    // `index` is past the four elements.
+    offset -= kVecRegisterSize;
+  }
+  Register destination = locations->InAt(1).AsX86().AsCpuRegister();
+  Address destination_address(destination, index, TIMES_4, offset);
+
+  if (instruction->AsVecFill() != nullptr) {
+    // VisitVecFill broadcasts the value in XMM1.
+    if (packed) {
+      __ movdqu(destination_address, XMM1);
+    } else {
+      __ movl(destination_address, locations->InAt(2).AsX86().AsCpuRegister());
+    }
+    return;
+  }
+
+  Register left = locations->InAt(2).AsX86().AsCpuRegister();
+  Address left_address(left, index, TIMES_4, offset);
+  if (packed) {
+    __ movdqu(XMM0, left_address);
+  } else {
+    __ movd(XMM0, left_address);
+  }
+
+  if (instruction->AsVecCopy() == nullptr) {
+    Register right = locations->InAt(3).AsX86().AsCpuRegister();
+    Address right_address(right, index, TIMES_4, offset);
+    if (packed) {
+      __ movdqu(XMM1, right_address);
+    } else {
+      __ movd(XMM1, right_address);
+    }
+    if (instruction->AsVecAdd() != nullptr) {
+      __ paddd(XMM0, XMM1);
+    } else {
+      DCHECK(instruction->AsVecSub() != nullptr);
+      __ psubd(XMM0, XMM1);
+    }
+  }
+
+  if (packed) {
+    __ movdqu(destination_address, XMM0);
+  } else {
+    __ movd(destination_address, XMM0);
+  }
+}
+
+void LocationsBuilderX86::VisitVecFill(HVecFill* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorX86::VisitVecFill(HVecFill* instruction) {
+  __ movd(XMM1, instruction->GetLocations()->InAt(2).AsX86().AsCpuRegister());
+  __ pshufd(XMM1, XMM1, Immediate(0));
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderX86::VisitVecCopy(HVecCopy* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorX86::VisitVecCopy(HVecCopy* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderX86::VisitVecAdd(HVecAdd* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorX86::VisitVecAdd(HVecAdd* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderX86::VisitVecSub(HVecSub* instruction) {
+  HandleVecArrayOperation(instruction);
+}
+
+void InstructionCodeGeneratorX86::VisitVecSub(HVecSub* instruction) {
+  GenerateVecArrayOperation(instruction, instruction->GetFrom());
+}
+
+void LocationsBuilderX86::VisitVecSum(HVecSum* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitVecSum(HVecSum* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register array = locations->InAt(0).AsX86().AsCpuRegister();
+  Register index = locations->GetTemp(0).AsX86().AsCpuRegister();
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  Address length(array, mirror::Array::LengthOffset().Int32Value());
+  int32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Int32Value();
+  Label vector_loop, vector_done, scalar_loop, done;
+
+  // Sum four lanes in XMM0.
+  __ pxor(XMM0, XMM0);
+  __ movl(index, Immediate(0));
+  __ Bind(&vector_loop);
+  __ addl(index, Immediate(kVecIntElements));
+  __ cmpl(index, length);
+  __ j(kGreater, &vector_done);
+  __ movdqu(XMM1, Address(array, index, TIMES_4, data_offset - kVecRegisterSize));
+  __ paddd(XMM0, XMM1);
+  __ jmp(&vector_loop);
+  __ Bind(&vector_done);
+  __ subl(index, Immediate(kVecIntElements));
+
+  // MOVD clears the other lanes, so the remaining elements are added to the
+  // first lane.
+  __ Bind(&scalar_loop);
+  __ cmpl(index, length);
+  __ j(kGreaterEqual, &done);
+  __ movd(XMM1, Address(array, index, TIMES_4, data_offset));
+  __ paddd(XMM0, XMM1);
+  __ addl(index, Immediate(1));
+  __ jmp(&scalar_loop);
+  __ Bind(&done);
+
+  // Add the lanes together.
+  __ pshufd(XMM1, XMM0, Immediate(0x4e));
+  __ paddd(XMM0, XMM1);
+  __ pshufd(XMM1, XMM0, Immediate(0xb1));
+  __ paddd(XMM0, XMM1);
+  __ movd(out, XMM0);
+}
+
+void LocationsBuilderX86::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderX86::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void InstructionCodeGeneratorX86::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+X86Assembler* ParallelMoveResolverX86::GetAssembler() const {
+  return codegen_->GetAssembler();
+}
+
+void ParallelMoveResolverX86::MoveMemoryToMemory(int dst, int src) {
+  // The address of a pop is computed after incrementing ESP, so the
+  // offsets are the ones of the original stack pointer.
+  __ pushl(Address(ESP, src));
+  __ popl(Address(ESP, dst));
+}
+
+void ParallelMoveResolverX86::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister()) {
+    if (destination.IsRegister()) {
+      __ movl(destination.AsX86().AsCpuRegister(), source.AsX86().AsCpuRegister());
+    } else {
+      DCHECK(destination.IsStackSlot());
+      __ movl(Address(ESP, destination.GetStackIndex()), source.AsX86().AsCpuRegister());
+    }
+  } else if (source.IsStackSlot()) {
+    if (destination.IsRegister()) {
+      __ movl(destination.AsX86().AsCpuRegister(), Address(ESP, source.GetStackIndex()));
+    } else {
+      DCHECK(destination.IsStackSlot());
+      MoveMemoryToMemory(destination.GetStackIndex(), source.GetStackIndex());
+    }
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
+}
+
+void ParallelMoveResolverX86::Exchange(Register reg, int mem) {
+  __ xchgl(reg, Address(ESP, mem));
+}
+
+void ParallelMoveResolverX86::Exchange(int mem1, int mem2) {
+  // The second push and the first pop see ESP one word lower.
+  __ pushl(Address(ESP, mem1));
+  __ pushl(Address(ESP, mem2 + kX86WordSize));
+  __ popl(Address(ESP, mem1 + kX86WordSize));
+  __ popl(Address(ESP, mem2));
+}
+
+void ParallelMoveResolverX86::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    __ xchgl(destination.AsX86().AsCpuRegister(), source.AsX86().AsCpuRegister());
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(source.AsX86().AsCpuRegister(), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(destination.AsX86().AsCpuRegister(), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(destination.GetStackIndex(), source.GetStackIndex());
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
 }
 
 }  // namespace x86
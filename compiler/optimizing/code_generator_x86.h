@@ -71,6 +71,10 @@ class LocationsBuilderX86 : public HGraphVisitor {
 
 #undef DECLARE_VISIT_INSTRUCTION
 
+  void VisitCondition(HCondition* comp);
+  void HandleInvoke(HInvoke* invoke);
+  void HandleVecArrayOperation(HInstruction* instruction);
+
  private:
   CodeGeneratorX86* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
@@ -89,8 +93,17 @@ class InstructionCodeGeneratorX86 : public HGraphVisitor {
 
 #undef DECLARE_VISIT_INSTRUCTION
 
+  void VisitCondition(HCondition* comp);
   void LoadCurrentMethod(Register reg);
 
+  // Emits the loops of a vector array operation, leaving the index of the
+  // first element not processed in the output register.
+  void GenerateVecArrayOperation(HInstruction* instruction, int32_t from);
+
+  // Emits the operation of `instruction` on the four elements before `index`
+  // if `packed`, or on the element at `index` otherwise.
+  void GenerateVecElements(HInstruction* instruction, Register index, bool packed);
+
   X86Assembler* GetAssembler() const { return assembler_; }
 
  private:
@@ -100,6 +113,27 @@ class InstructionCodeGeneratorX86 : public HGraphVisitor {
   DISALLOW_COPY_AND_ASSIGN(InstructionCodeGeneratorX86);
 };
 
+class ParallelMoveResolverX86 : public ParallelMoveResolver {
+ public:
+  ParallelMoveResolverX86(ArenaAllocator* allocator, CodeGeneratorX86* codegen)
+      : ParallelMoveResolver(allocator), codegen_(codegen) {}
+
+  X86Assembler* GetAssembler() const;
+
+ protected:
+  virtual void EmitMove(size_t index) OVERRIDE;
+  virtual void EmitSwap(size_t index) OVERRIDE;
+
+ private:
+  void MoveMemoryToMemory(int dst, int src);
+  void Exchange(Register reg, int mem);
+  void Exchange(int mem1, int mem2);
+
+  CodeGeneratorX86* const codegen_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMoveResolverX86);
+};
+
 class CodeGeneratorX86 : public CodeGenerator {
  public:
   explicit CodeGeneratorX86(HGraph* graph);
@@ -114,6 +148,8 @@ class CodeGeneratorX86 : public CodeGenerator {
     return kX86WordSize;
   }
 
+  virtual size_t FrameEntrySpillSize() const OVERRIDE;
+
   virtual HGraphVisitor* GetLocationBuilder() OVERRIDE {
     return &location_builder_;
   }
@@ -128,13 +164,29 @@ class CodeGeneratorX86 : public CodeGenerator {
 
   virtual size_t GetNumberOfRegisters() const OVERRIDE;
   virtual void SetupBlockedRegisters(bool* blocked_registers) const OVERRIDE;
+
+  virtual size_t GetNumberOfCoreRegisters() const OVERRIDE {
+    return kNumberOfCpuRegisters;
+  }
+
   virtual ManagedRegister AllocateFreeRegister(
       Primitive::Type type, bool* blocked_registers) const OVERRIDE;
 
   int32_t GetStackSlot(HLocal* local) const;
   virtual Location GetStackLocation(HLoadLocal* load) const OVERRIDE;
+  virtual Location GetTemporaryLocation(HTemporary* temp) const OVERRIDE;
+
+  virtual ParallelMoveResolverX86* GetMoveResolver() OVERRIDE {
+    return &move_resolver_;
+  }
+
+  // Emit a write barrier.
+  void MarkGCCard(Register temp, Register card, Register object, Register value);
 
  private:
+  // Blocks the register pairs of which a register is already blocked.
+  void UpdateBlockedPairRegisters(bool* blocked_registers) const;
+
   // Helper method to move a 32bits value between two locations.
   void Move32(Location destination, Location source);
   // Helper method to move a 64bits value between two locations.
@@ -142,6 +194,7 @@ class CodeGeneratorX86 : public CodeGenerator {
 
   LocationsBuilderX86 location_builder_;
   InstructionCodeGeneratorX86 instruction_visitor_;
+  ParallelMoveResolverX86 move_resolver_;
   X86Assembler assembler_;
 
   DISALLOW_COPY_AND_ASSIGN(CodeGeneratorX86);
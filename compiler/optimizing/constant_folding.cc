@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_folding.h"
+
+namespace art {
+
+void HConstantFolding::Run() {
+  // Process basic blocks in reverse post-order, so that an instruction is
+  // visited after the instructions it uses, and folding cascades.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(*block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      HBinaryOperation* operation = instruction->AsBinaryOperation();
+      if (operation == nullptr) {
+        continue;
+      }
+      HInstruction* constant = operation->TryStaticEvaluation(graph_->GetArena());
+      if (constant != nullptr) {
+        block->ReplaceAndRemoveInstructionWith(operation, constant);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits>
+
+#include "base/arena_allocator.h"
+#include "builder.h"
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
+#include "dex_file.h"
+#include "dex_instruction.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HGraph* BuildSsaGraph(ArenaAllocator* allocator, const uint16_t* data) {
+  HGraphBuilder builder(allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  return graph;
+}
+
+static size_t CountInstructions(HGraph* graph, HInstruction::InstructionKind kind) {
+  size_t count = 0;
+  for (HReversePostOrderIterator it(*graph); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(*block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      if (inst_it.Current()->GetKind() == kind) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+// Returns the input of the last instruction of the block before the exit block.
+static HInstruction* GetReturnedValue(HGraph* graph) {
+  HBasicBlock* exit = graph->GetExitBlock();
+  HInstruction* last = exit->GetPredecessors()->Get(0)->GetLastInstruction();
+  return last->InputAt(0);
+}
+
+static void TestFolding(const uint16_t* data, int32_t expected) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+
+  HConstantFolding(graph).Run();
+  HDeadCodeElimination(graph).Run();
+
+  HInstruction* value = GetReturnedValue(graph);
+  ASSERT_NE(value->AsIntConstant(), nullptr);
+  ASSERT_EQ(expected, value->AsIntConstant()->GetValue());
+  ASSERT_EQ(0u, CountInstructions(graph, HInstruction::kAdd));
+  ASSERT_EQ(0u, CountInstructions(graph, HInstruction::kSub));
+  // The inputs of the folded instructions are dead.
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kIntConstant));
+}
+
+TEST(ConstantFoldingTest, IntegerAddition) {
+  /*
+   * Test the following snippet:
+   *  return 1 + 2;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::ADD_INT, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestFolding(data, 3);
+}
+
+TEST(ConstantFoldingTest, IntegerAdditionWrapsAround) {
+  /*
+   * Test the following snippet:
+   *  return 0x7fffffff + 1;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST | 0 << 8, 0xffff, 0x7fff,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::ADD_INT, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestFolding(data, std::numeric_limits<int32_t>::min());
+}
+
+TEST(ConstantFoldingTest, CascadedOperations) {
+  /*
+   * Test the following snippet:
+   *  var a = 5, b = 3;
+   *  a = a - b;
+   *  a = a + b;
+   *  return a;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 5 << 12,
+    Instruction::CONST_4 | 1 << 8 | 3 << 12,
+    Instruction::SUB_INT_2ADDR | 0 << 8 | 1 << 12,
+    Instruction::ADD_INT_2ADDR | 0 << 8 | 1 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestFolding(data, 5);
+}
+
+TEST(ConstantFoldingTest, Condition) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  if (a == a) {}
+   *  return;
+   */
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_EQ, 3,
+    Instruction::GOTO | 0x100,
+    Instruction::RETURN_VOID);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+
+  HConstantFolding(graph).Run();
+  HDeadCodeElimination(graph).Run();
+
+  ASSERT_EQ(0u, CountInstructions(graph, HInstruction::kEqual));
+  HInstruction* branch = graph->GetEntryBlock()->GetSuccessors()->Get(0)->GetLastInstruction();
+  ASSERT_NE(branch->AsIf(), nullptr);
+  ASSERT_NE(branch->InputAt(0)->AsIntConstant(), nullptr);
+  ASSERT_EQ(1, branch->InputAt(0)->AsIntConstant()->GetValue());
+}
+
+TEST(DeadCodeEliminationTest, UnusedAddition) {
+  /*
+   * Test the following snippet:
+   *  var a = 1, b = 2;
+   *  b = a + b;
+   *  return a;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::ADD_INT | 1 << 8, 1 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSsaGraph(&allocator, data);
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kAdd));
+
+  HDeadCodeElimination(graph).Run();
+
+  ASSERT_EQ(0u, CountInstructions(graph, HInstruction::kAdd));
+  ASSERT_EQ(1u, CountInstructions(graph, HInstruction::kIntConstant));
+  HInstruction* value = GetReturnedValue(graph);
+  ASSERT_NE(value->AsIntConstant(), nullptr);
+  ASSERT_EQ(1, value->AsIntConstant()->GetValue());
+}
+
+}  // namespace art
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dead_code_elimination.h"
+
+namespace art {
+
+static bool IsDead(HInstruction* instruction) {
+  return !instruction->HasUses()
+      && !instruction->HasSideEffects()
+      && !instruction->CanThrow()
+      && !instruction->IsControlFlow();
+}
+
+void HDeadCodeElimination::Run() {
+  // Process basic blocks in post-order, and their instructions backwards, so
+  // that the users of an instruction are removed before the instruction itself
+  // is considered. Uses through a loop back edge only go to phis.
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HBackwardInstructionIterator inst_it(*block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      if (IsDead(instruction)) {
+        block->RemoveInstruction(instruction);
+      }
+    }
+    for (HInstructionIterator phi_it(*block->GetPhis()); !phi_it.Done(); phi_it.Advance()) {
+      HPhi* phi = phi_it.Current()->AsPhi();
+      if (IsDead(phi)) {
+        block->RemovePhi(phi);
+      }
+    }
+  }
+}
+
+}  // namespace art
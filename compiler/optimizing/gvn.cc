@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gvn.h"
+
+namespace art {
+
+void GlobalValueNumberer::Run() {
+  side_effects_.Run();
+
+  sets_.Put(graph_->GetEntryBlock()->GetBlockId(), new (allocator_) ValueSet(allocator_));
+
+  // Do reverse post order to ensure the non back-edge predecessors of a block are
+  // visited before the block itself.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    VisitBasicBlock(it.Current());
+  }
+}
+
+void GlobalValueNumberer::VisitBasicBlock(HBasicBlock* block) {
+  ValueSet* set = nullptr;
+  const GrowableArray<HBasicBlock*>& predecessors = *block->GetPredecessors();
+  if (predecessors.Size() == 0) {
+    // The entry block has its set created in `Run`.
+    set = sets_.Get(block->GetBlockId());
+  } else {
+    // Start from the set of the dominator: its instructions dominate `block`.
+    HBasicBlock* dominator = block->GetDominator();
+    set = sets_.Get(dominator->GetBlockId())->Copy();
+    if (block->IsLoopHeader()) {
+      // The back edges have not been visited yet. Remove the instructions
+      // that may be affected by the loop.
+      DCHECK_EQ(dominator, block->GetLoopInformation()->GetPreHeader());
+      set->Kill(side_effects_.GetLoopEffects(block));
+    } else if (predecessors.Size() > 1) {
+      // Only keep the instructions that are still valid at the end of each
+      // predecessor, that is not killed by a block between the dominator and
+      // the predecessor.
+      for (size_t i = 0, e = predecessors.Size(); i < e; ++i) {
+        set->IntersectWith(sets_.Get(predecessors.Get(i)->GetBlockId()));
+        if (set->IsEmpty()) {
+          break;
+        }
+      }
+    }
+  }
+
+  sets_.Put(block->GetBlockId(), set);
+
+  HInstruction* current = block->GetFirstInstruction();
+  while (current != nullptr) {
+    set->Kill(current->GetSideEffects());
+    // Save the next instruction in case `current` is removed from the graph.
+    HInstruction* next = current->GetNext();
+    if (current->CanBeMoved()) {
+      HInstruction* existing = set->Lookup(current);
+      if (existing != nullptr) {
+        current->ReplaceWith(existing);
+        current->GetBlock()->RemoveInstruction(current);
+      } else {
+        set->Add(current);
+      }
+    }
+    current = next;
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_GVN_H_
+#define ART_COMPILER_OPTIMIZING_GVN_H_
+
+#include "nodes.h"
+#include "optimization.h"
+#include "side_effects_analysis.h"
+
+namespace art {
+
+/**
+ * A node in the collision list of a ValueSet. Encodes the instruction,
+ * the hash code, and the next node in the collision list.
+ */
+class ValueSetNode : public ArenaObject {
+ public:
+  ValueSetNode(HInstruction* instruction, size_t hash_code, ValueSetNode* next)
+      : instruction_(instruction), hash_code_(hash_code), next_(next) {}
+
+  size_t GetHashCode() const { return hash_code_; }
+  HInstruction* GetInstruction() const { return instruction_; }
+  ValueSetNode* GetNext() const { return next_; }
+  void SetNext(ValueSetNode* node) { next_ = node; }
+
+ private:
+  HInstruction* const instruction_;
+  const size_t hash_code_;
+  ValueSetNode* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSetNode);
+};
+
+/**
+ * A ValueSet holds instructions that can replace other instructions. It is
+ * updated through the `Add` method, and the `Kill` method. The `Kill` method
+ * removes instructions that are affected by the given side effects.
+ *
+ * The `Lookup` method returns an equivalent instruction to the given
+ * instruction if there is one in the set. In GVN, we would say those
+ * instructions have the same "number".
+ */
+class ValueSet : public ArenaObject {
+ public:
+  explicit ValueSet(ArenaAllocator* allocator) : allocator_(allocator), number_of_entries_(0) {
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      buckets_[i] = nullptr;
+    }
+  }
+
+  // Adds an instruction in the set.
+  void Add(HInstruction* instruction) {
+    DCHECK(Lookup(instruction) == nullptr);
+    size_t hash_code = instruction->ComputeHashCode();
+    size_t index = hash_code % kNumberOfBuckets;
+    buckets_[index] = new (allocator_) ValueSetNode(instruction, hash_code, buckets_[index]);
+    ++number_of_entries_;
+  }
+
+  // If in the set, returns an equivalent instruction to the given instruction. Returns
+  // null otherwise.
+  HInstruction* Lookup(HInstruction* instruction) const {
+    size_t hash_code = instruction->ComputeHashCode();
+    for (ValueSetNode* node = buckets_[hash_code % kNumberOfBuckets];
+         node != nullptr;
+         node = node->GetNext()) {
+      if (node->GetHashCode() == hash_code && node->GetInstruction()->Equals(instruction)) {
+        return node->GetInstruction();
+      }
+    }
+    return nullptr;
+  }
+
+  // Returns whether `instruction` itself is in the set.
+  bool Contains(HInstruction* instruction) const {
+    size_t hash_code = instruction->ComputeHashCode();
+    for (ValueSetNode* node = buckets_[hash_code % kNumberOfBuckets];
+         node != nullptr;
+         node = node->GetNext()) {
+      if (node->GetInstruction() == instruction) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Removes all instructions in the set that are affected by the given side effects.
+  void Kill(SideEffects side_effects) {
+    if (!side_effects.HasSideEffects()) {
+      return;
+    }
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      ValueSetNode* previous = nullptr;
+      for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+        if (node->GetInstruction()->GetSideEffects().DependsOn(side_effects)) {
+          RemoveNode(i, previous, node);
+        } else {
+          previous = node;
+        }
+      }
+    }
+  }
+
+  // Updates this set by intersecting with instructions in `other`.
+  void IntersectWith(ValueSet* other) {
+    if (IsEmpty()) {
+      return;
+    } else if (other->IsEmpty()) {
+      Clear();
+    } else {
+      for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+        ValueSetNode* previous = nullptr;
+        for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+          if (!other->Contains(node->GetInstruction())) {
+            RemoveNode(i, previous, node);
+          } else {
+            previous = node;
+          }
+        }
+      }
+    }
+  }
+
+  // Returns a copy of this set, sharing the instructions but not the nodes.
+  ValueSet* Copy() const {
+    ValueSet* copy = new (allocator_) ValueSet(allocator_);
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+        copy->buckets_[i] = new (allocator_) ValueSetNode(
+            node->GetInstruction(), node->GetHashCode(), copy->buckets_[i]);
+      }
+    }
+    copy->number_of_entries_ = number_of_entries_;
+    return copy;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      buckets_[i] = nullptr;
+    }
+    number_of_entries_ = 0;
+  }
+
+  bool IsEmpty() const { return number_of_entries_ == 0; }
+  size_t GetNumberOfEntries() const { return number_of_entries_; }
+
+ private:
+  static constexpr size_t kNumberOfBuckets = 8;
+
+  // Removes `node`, which follows `previous` in the bucket at `index`.
+  void RemoveNode(size_t index, ValueSetNode* previous, ValueSetNode* node) {
+    if (previous == nullptr) {
+      buckets_[index] = node->GetNext();
+    } else {
+      previous->SetNext(node->GetNext());
+    }
+    --number_of_entries_;
+  }
+
+  ArenaAllocator* const allocator_;
+
+  // The internal implementation of the set. It uses a fixed number of buckets,
+  // each holding a list of the instructions whose hash code falls in it.
+  ValueSetNode* buckets_[kNumberOfBuckets];
+
+  // The number of instructions in the set.
+  size_t number_of_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSet);
+};
+
+/**
+ * Optimization phase that removes redundant instruction, using the dominator
+ * tree: an instruction is replaced by an equal instruction of a dominating
+ * block, or of the same block, if no instruction in between writes the memory
+ * the instruction reads.
+ */
+class GlobalValueNumberer : public HOptimization {
+ public:
+  GlobalValueNumberer(ArenaAllocator* allocator, HGraph* graph)
+      : HOptimization(graph, kGlobalValueNumberingPassName),
+        allocator_(allocator),
+        side_effects_(allocator, graph),
+        sets_(allocator, graph->GetBlocks().Size()) {
+    sets_.SetSize(graph->GetBlocks().Size());
+  }
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kGlobalValueNumberingPassName = "GVN";
+
+ private:
+  // Per-block GVN. The ValueSet of the block starts from the one of its
+  // dominator, and is then updated with the instructions of the block.
+  void VisitBasicBlock(HBasicBlock* block);
+
+  ArenaAllocator* const allocator_;
+
+  // Side effects of individual blocks and loops. The GVN algorithm uses them
+  // to update the ValueSet of individual blocks.
+  SideEffectsAnalysis side_effects_;
+
+  // ValueSet for blocks. Initially null, but for an individual block they
+  // are allocated and populated by the dominator, and updated by all blocks
+  // in the path from the dominator to the block.
+  GrowableArray<ValueSet*> sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(GlobalValueNumberer);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_GVN_H_
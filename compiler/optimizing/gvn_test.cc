@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "gvn.h"
+#include "nodes.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static HGraph* CreateGraph(ArenaAllocator* allocator) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  return graph;
+}
+
+static HInstruction* CreateFieldGet(ArenaAllocator* allocator,
+                                    HInstruction* object,
+                                    size_t offset) {
+  return new (allocator) HInstanceFieldGet(object, Primitive::kPrimNot, MemberOffset(offset));
+}
+
+static void RunGvn(ArenaAllocator* allocator, HGraph* graph) {
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  GlobalValueNumberer(allocator, graph).Run();
+}
+
+TEST(GVNTest, LocalFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  HInstruction* index = new (&allocator) HIntConstant(1);
+  entry->AddInstruction(parameter);
+  entry->AddInstruction(index);
+  entry->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+
+  HInstruction* first = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(first);
+  // An array store does not change the value of a field.
+  block->AddInstruction(new (&allocator) HArraySet(
+      parameter, index, parameter, Primitive::kPrimNot));
+  HInstruction* to_remove = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(to_remove);
+  HInstruction* different_offset = CreateFieldGet(&allocator, parameter, 43);
+  block->AddInstruction(different_offset);
+  // Kill the value.
+  block->AddInstruction(new (&allocator) HInstanceFieldSet(
+      parameter, parameter, Primitive::kPrimNot, MemberOffset(42)));
+  HInstruction* after_store = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(after_store);
+  HInstruction* use_after_store = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(use_after_store);
+  block->AddInstruction(new (&allocator) HReturn(use_after_store));
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  block->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(&allocator, graph);
+
+  ASSERT_EQ(first->GetBlock(), block);
+  ASSERT_TRUE(to_remove->GetBlock() == nullptr);
+  ASSERT_EQ(different_offset->GetBlock(), block);
+  ASSERT_EQ(after_store->GetBlock(), block);
+  ASSERT_TRUE(use_after_store->GetBlock() == nullptr);
+  ASSERT_EQ(block->GetLastInstruction()->InputAt(0), after_store);
+}
+
+TEST(GVNTest, GlobalFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+  entry->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* field_get = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(field_get);
+  block->AddInstruction(new (&allocator) HIf(field_get));
+
+  HBasicBlock* then = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* else_ = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* join = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(then);
+  graph->AddBlock(else_);
+  graph->AddBlock(join);
+
+  block->AddSuccessor(then);
+  block->AddSuccessor(else_);
+  then->AddSuccessor(join);
+  else_->AddSuccessor(join);
+
+  HInstruction* in_then = CreateFieldGet(&allocator, parameter, 42);
+  then->AddInstruction(in_then);
+  then->AddInstruction(new (&allocator) HGoto());
+  HInstruction* in_else = CreateFieldGet(&allocator, parameter, 42);
+  else_->AddInstruction(in_else);
+  else_->AddInstruction(new (&allocator) HGoto());
+  HInstruction* in_join = CreateFieldGet(&allocator, parameter, 42);
+  join->AddInstruction(in_join);
+  join->AddInstruction(new (&allocator) HReturnVoid());
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  join->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(&allocator, graph);
+
+  ASSERT_EQ(field_get->GetBlock(), block);
+  ASSERT_TRUE(in_then->GetBlock() == nullptr);
+  ASSERT_TRUE(in_else->GetBlock() == nullptr);
+  ASSERT_TRUE(in_join->GetBlock() == nullptr);
+}
+
+TEST(GVNTest, KilledOnOnePath) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+  entry->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* field_get = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(field_get);
+  block->AddInstruction(new (&allocator) HIf(field_get));
+
+  HBasicBlock* then = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* else_ = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* join = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(then);
+  graph->AddBlock(else_);
+  graph->AddBlock(join);
+
+  block->AddSuccessor(then);
+  block->AddSuccessor(else_);
+  then->AddSuccessor(join);
+  else_->AddSuccessor(join);
+
+  then->AddInstruction(new (&allocator) HInstanceFieldSet(
+      parameter, parameter, Primitive::kPrimNot, MemberOffset(42)));
+  then->AddInstruction(new (&allocator) HGoto());
+  HInstruction* in_else = CreateFieldGet(&allocator, parameter, 42);
+  else_->AddInstruction(in_else);
+  else_->AddInstruction(new (&allocator) HGoto());
+  HInstruction* in_join = CreateFieldGet(&allocator, parameter, 42);
+  join->AddInstruction(in_join);
+  join->AddInstruction(new (&allocator) HReturnVoid());
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  join->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(&allocator, graph);
+
+  ASSERT_TRUE(in_else->GetBlock() == nullptr);
+  // The store in `then` may have changed the field.
+  ASSERT_EQ(in_join->GetBlock(), join);
+}
+
+TEST(GVNTest, LoopFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+  entry->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* before_loop = CreateFieldGet(&allocator, parameter, 42);
+  block->AddInstruction(before_loop);
+  block->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* loop_header = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* loop_body = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(loop_header);
+  graph->AddBlock(loop_body);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  block->AddSuccessor(loop_header);
+  loop_header->AddSuccessor(loop_body);
+  loop_header->AddSuccessor(exit);
+  loop_body->AddSuccessor(loop_header);
+
+  HInstruction* in_header = CreateFieldGet(&allocator, parameter, 42);
+  loop_header->AddInstruction(in_header);
+  loop_header->AddInstruction(new (&allocator) HIf(in_header));
+
+  // Side effects do not tell fields apart, so the store in the loop also
+  // changes a field of a different offset.
+  HInstruction* other_field_before = CreateFieldGet(&allocator, parameter, 43);
+  block->InsertInstructionBefore(other_field_before, block->GetLastInstruction());
+  HInstruction* other_field_in_body = CreateFieldGet(&allocator, parameter, 43);
+  loop_body->AddInstruction(other_field_in_body);
+
+  HInstruction* in_body = CreateFieldGet(&allocator, parameter, 42);
+  loop_body->AddInstruction(in_body);
+  loop_body->AddInstruction(new (&allocator) HInstanceFieldSet(
+      parameter, in_body, Primitive::kPrimNot, MemberOffset(42)));
+  loop_body->AddInstruction(new (&allocator) HGoto());
+
+  HInstruction* in_exit = CreateFieldGet(&allocator, parameter, 42);
+  exit->AddInstruction(in_exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(&allocator, graph);
+
+  ASSERT_EQ(before_loop->GetBlock(), block);
+  // The loop stores to the field, so the value read in the header is not the
+  // one read before the loop.
+  ASSERT_EQ(in_header->GetBlock(), loop_header);
+  // In the body and after the loop, the header's read is still valid.
+  ASSERT_TRUE(in_body->GetBlock() == nullptr);
+  ASSERT_TRUE(in_exit->GetBlock() == nullptr);
+  ASSERT_EQ(other_field_in_body->GetBlock(), loop_body);
+}
+
+}  // namespace art
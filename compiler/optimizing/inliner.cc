@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inliner.h"
+
+#include "builder.h"
+#include "class_linker.h"
+#include "dex_instruction-inl.h"
+#include "driver/compiler_driver-inl.h"
+#include "driver/dex_compilation_unit.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "mirror/dex_cache.h"
+#include "register_allocator.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref-inl.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+// Callees larger than this are not inlined.
+static constexpr uint32_t kMaxInlineCodeUnits = 32;
+
+// Calls in a callee graph are inlined up to this depth. A callee that still
+// contains a call after that is not inlined.
+static constexpr size_t kMaxInlineDepth = 3;
+
+void HInliner::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(*block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HInvoke* invoke = inst_it.Current()->AsInvoke();
+      if (invoke != nullptr) {
+        TryInline(invoke);
+      }
+    }
+  }
+}
+
+static HEnvironment* CopyEnvironment(ArenaAllocator* arena, HEnvironment* environment) {
+  GrowableArray<HInstruction*>* vregs = environment->GetVRegs();
+  HEnvironment* copy = new (arena) HEnvironment(arena, vregs->Size());
+  copy->Populate(*vregs);
+  return copy;
+}
+
+bool HInliner::PrepareBody(HBasicBlock* body, HInvoke* invoke_instruction, bool is_static) const {
+  ArenaAllocator* arena = graph_->GetArena();
+  for (HInstructionIterator it(*body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current->NeedsEnvironment()
+        && current->AsNullCheck() == nullptr
+        && current->AsBoundsCheck() == nullptr) {
+      // Calls into other methods and into the runtime need a frame of their
+      // own, so that the runtime can walk the stack.
+      return false;
+    }
+  }
+
+  for (HInstructionIterator it(*body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    HNullCheck* null_check = current->AsNullCheck();
+    HBoundsCheck* bounds_check = current->AsBoundsCheck();
+    if (null_check == nullptr && bounds_check == nullptr) {
+      continue;
+    }
+
+    HParameterValue* parameter = current->InputAt(0)->AsParameterValue();
+    if (null_check != nullptr && !is_static && parameter != nullptr && parameter->GetIndex() == 0) {
+      // The caller has already checked the receiver.
+      current->ReplaceWith(parameter);
+      body->RemoveInstruction(current);
+      continue;
+    }
+
+    // The remaining checks throw on behalf of the call: they take its dex pc,
+    // and the environment of the caller at the call.
+    HInstruction* replacement = nullptr;
+    if (null_check != nullptr) {
+      replacement = new (arena) HNullCheck(current->InputAt(0), invoke_instruction->GetDexPc());
+    } else {
+      replacement = new (arena) HBoundsCheck(
+          current->InputAt(0), current->InputAt(1), invoke_instruction->GetDexPc());
+    }
+    body->ReplaceAndRemoveInstructionWith(current, replacement);
+    replacement->SetEnvironment(CopyEnvironment(arena, invoke_instruction->GetEnvironment()));
+  }
+  return true;
+}
+
+// Returns whether `code_item` only returns, without a value.
+static bool IsEmptyMethod(const DexFile::CodeItem* code_item) {
+  return code_item != nullptr
+      && code_item->insns_size_in_code_units_ == 1
+      && Instruction::At(code_item->insns_)->Opcode() == Instruction::RETURN_VOID;
+}
+
+bool HInliner::TryInline(HInvoke* invoke_instruction) const {
+  const DexFile& dex_file = *outer_compilation_unit_.GetDexFile();
+  uint32_t dex_pc = invoke_instruction->GetDexPc();
+  const Instruction* instruction =
+      Instruction::At(outer_compilation_unit_.GetCodeItem()->insns_ + dex_pc);
+  InvokeType invoke_type;
+  switch (instruction->Opcode()) {
+    case Instruction::INVOKE_STATIC:
+    case Instruction::INVOKE_STATIC_RANGE:
+      invoke_type = kStatic;
+      break;
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_DIRECT_RANGE:
+      invoke_type = kDirect;
+      break;
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+      invoke_type = kVirtual;
+      break;
+    default:
+      return false;
+  }
+
+  // Let the compiler driver sharpen the call: a virtual call that can only
+  // reach one method becomes a direct call to that method.
+  InvokeType sharp_type = invoke_type;
+  MethodReference target_method(&dex_file, instruction->VRegB());
+  int vtable_index;
+  uintptr_t direct_code;
+  uintptr_t direct_method;
+  bool enable_devirtualization = outer_compilation_unit_.GetVerifiedMethod() != nullptr;
+  if (!compiler_driver_->ComputeInvokeInfo(&outer_compilation_unit_, dex_pc,
+                                           false, enable_devirtualization,
+                                           &sharp_type, &target_method, &vtable_index,
+                                           &direct_code, &direct_method)
+      || (sharp_type != kStatic && sharp_type != kDirect)) {
+    return false;
+  }
+
+  if (target_method.dex_file == &dex_file
+      && target_method.dex_method_index == outer_compilation_unit_.GetDexMethodIndex()) {
+    return false;
+  }
+  // A method of another dex file can only be resolved from the index of the
+  // call if the call was not devirtualized.
+  uint32_t resolved_index = target_method.dex_method_index;
+  if (target_method.dex_file != &dex_file) {
+    if (sharp_type != invoke_type) {
+      return false;
+    }
+    resolved_index = instruction->VRegB();
+  }
+
+  const DexFile::CodeItem* code_item = nullptr;
+  uint16_t class_def_index;
+  uint32_t method_index;
+  uint32_t access_flags;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    SirtRef<mirror::DexCache> dex_cache(soa.Self(),
+        outer_compilation_unit_.GetClassLinker()->FindDexCache(dex_file));
+    SirtRef<mirror::ClassLoader> class_loader(soa.Self(),
+        soa.Decode<mirror::ClassLoader*>(outer_compilation_unit_.GetClassLoader()));
+    mirror::ArtMethod* resolved_method = compiler_driver_->ResolveMethod(
+        soa, dex_cache, class_loader, &outer_compilation_unit_, resolved_index, invoke_type);
+    if (resolved_method == nullptr) {
+      return false;
+    }
+    mirror::Class* declaring_class = resolved_method->GetDeclaringClass();
+    if (!declaring_class->IsVerified()
+        // The runtime locks the receiver of synchronized methods on entry.
+        || resolved_method->IsSynchronized()) {
+      return false;
+    }
+    // The call would initialize the class of a static method.
+    mirror::Class* referrer_class = compiler_driver_->ResolveCompilingMethodsClass(
+        soa, dex_cache, class_loader, &outer_compilation_unit_);
+    if (referrer_class == nullptr
+        || compiler_driver_->NeedsClassInitialization(referrer_class, resolved_method)) {
+      return false;
+    }
+    const DexFile& declaring_dex_file = *declaring_class->GetDexCache()->GetDexFile();
+    code_item = declaring_dex_file.GetCodeItem(resolved_method->GetCodeItemOffset());
+    if (IsEmptyMethod(code_item)) {
+      // Nothing to inline, whatever the dex file of the callee. This is
+      // notably the case of the constructor of java.lang.Object.
+      invoke_instruction->GetBlock()->RemoveInstruction(invoke_instruction);
+      VLOG(compiler) << "Removed call to empty " << PrettyMethod(resolved_method);
+      return true;
+    }
+    // The inlined code uses the dex cache of the caller.
+    if (declaring_class->GetDexCache() != dex_cache.get()) {
+      return false;
+    }
+    class_def_index = declaring_class->GetDexClassDefIndex();
+    // Constructors of classes with final fields need a barrier on return.
+    if (resolved_method->IsConstructor()
+        && compiler_driver_->RequiresConstructorBarrier(soa.Self(), &dex_file, class_def_index)) {
+      return false;
+    }
+    method_index = resolved_method->GetDexMethodIndex();
+    access_flags = resolved_method->GetAccessFlags();
+  }
+
+  if (code_item == nullptr || code_item->insns_size_in_code_units_ > kMaxInlineCodeUnits) {
+    return false;
+  }
+
+  DexCompilationUnit dex_compilation_unit(
+      nullptr, outer_compilation_unit_.GetClassLoader(), outer_compilation_unit_.GetClassLinker(),
+      dex_file, code_item, class_def_index, method_index, access_flags,
+      compiler_driver_->GetVerifiedMethod(&dex_file, method_index));
+  if (dex_compilation_unit.GetVerifiedMethod() == nullptr) {
+    return false;
+  }
+
+  HGraphBuilder builder(graph_->GetArena(), &dex_compilation_unit, &dex_file, compiler_driver_);
+  HGraph* callee_graph = builder.BuildGraph(*code_item);
+  // The method compiled was accepted by the register allocator: do not bring in
+  // values it cannot handle.
+  if (callee_graph == nullptr
+      || !RegisterAllocator::CanAllocateRegistersFor(*callee_graph,
+                                                     compiler_driver_->GetInstructionSet())) {
+    return false;
+  }
+
+  callee_graph->BuildDominatorTree();
+  callee_graph->TransformToSSA();
+  if (depth_ + 1 < kMaxInlineDepth) {
+    HInliner inliner(callee_graph, dex_compilation_unit, compiler_driver_, depth_ + 1);
+    inliner.Run();
+  }
+
+  // Only methods made of a single block, between the entry and exit blocks,
+  // are inlined.
+  if (callee_graph->GetBlocks().Size() != 3) {
+    return false;
+  }
+  HBasicBlock* body = callee_graph->GetEntryBlock()->GetSuccessors()->Get(0);
+  if (!PrepareBody(body, invoke_instruction, dex_compilation_unit.IsStatic())) {
+    return false;
+  }
+
+  callee_graph->InlineInto(graph_, invoke_instruction);
+  VLOG(compiler) << "Inlined " << PrettyMethod(method_index, dex_file) << " in "
+                 << PrettyMethod(outer_compilation_unit_.GetDexMethodIndex(), dex_file);
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_INLINER_H_
+#define ART_COMPILER_OPTIMIZING_INLINER_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+class CompilerDriver;
+class DexCompilationUnit;
+
+/**
+ * Optimization pass replacing calls to small methods with the body of the
+ * called method. Only calls the compiler driver can resolve to a single
+ * target, in the same dex file, are considered. Calls to empty methods, like
+ * the constructor of java.lang.Object, are removed whatever their dex file.
+ */
+class HInliner : public HOptimization {
+ public:
+  HInliner(HGraph* graph,
+           const DexCompilationUnit& outer_compilation_unit,
+           CompilerDriver* compiler_driver,
+           size_t depth = 0)
+      : HOptimization(graph, kInlinerPassName),
+        outer_compilation_unit_(outer_compilation_unit),
+        compiler_driver_(compiler_driver),
+        depth_(depth) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kInlinerPassName = "inliner";
+
+ private:
+  bool TryInline(HInvoke* invoke_instruction) const;
+
+  // Returns whether the single block `body` of a callee graph can replace
+  // `invoke_instruction`. If so, prepares the instructions that need an
+  // environment to be executed in the frame of the caller.
+  bool PrepareBody(HBasicBlock* body, HInvoke* invoke_instruction, bool is_static) const;
+
+  const DexCompilationUnit& outer_compilation_unit_;
+  CompilerDriver* const compiler_driver_;
+
+  // The position of `graph_` in the chain of inlined callees, 0 for the
+  // method compiled.
+  const size_t depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInliner);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_INLINER_H_
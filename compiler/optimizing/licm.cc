@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "licm.h"
+
+namespace art {
+
+static bool InputsAreDefinedBeforeLoop(HInstruction* instruction,
+                                       HLoopInformation* loop_info) {
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    if (loop_info->Contains(*instruction->InputAt(i)->GetBlock())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The SSA builder creates a phi in the loop header for every local live on
+// entry of the loop. Replaces the phis of the locals the loop does not write,
+// which only merge their entry value with themselves, with that value.
+static void RemoveInvariantPhis(HBasicBlock* header) {
+  for (HInstructionIterator it(*header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    HInstruction* value = nullptr;
+    bool is_invariant = true;
+    for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+      HInstruction* input = phi->InputAt(i);
+      if (input == phi) {
+        continue;
+      } else if (value == nullptr) {
+        value = input;
+      } else if (input != value) {
+        is_invariant = false;
+      }
+    }
+    if (is_invariant && value != nullptr) {
+      phi->ReplaceWith(value);
+      header->RemovePhi(phi);
+    }
+  }
+}
+
+void LICM::Run() {
+  side_effects_.Run();
+
+  // Visit inner loops first, so that the instructions they hoist can then be
+  // hoisted out of the outer loops.
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader()) {
+      VisitLoop(block->GetLoopInformation());
+    }
+  }
+}
+
+bool LICM::UpdateEnvironmentForPreHeader(HInstruction* instruction,
+                                         HLoopInformation* loop_info) {
+  HBasicBlock* header = loop_info->GetHeader();
+  HEnvironment* environment = instruction->GetEnvironment();
+  GrowableArray<HInstruction*>* vregs = environment->GetVRegs();
+  for (size_t i = 0, e = vregs->Size(); i < e; ++i) {
+    HInstruction* vreg = vregs->Get(i);
+    if (vreg != nullptr
+        && loop_info->Contains(*vreg->GetBlock())
+        && (vreg->GetBlock() != header || vreg->AsPhi() == nullptr)) {
+      return false;
+    }
+  }
+
+  size_t pre_header_index = header->GetPredecessorIndexOf(loop_info->GetPreHeader());
+  for (size_t i = 0, e = vregs->Size(); i < e; ++i) {
+    HInstruction* vreg = vregs->Get(i);
+    if (vreg != nullptr && vreg->GetBlock() == header) {
+      HInstruction* entry_value = vreg->InputAt(pre_header_index);
+      vreg->RemoveEnvironmentUser(environment, i);
+      environment->SetRawEnvAt(i, entry_value);
+      entry_value->AddEnvUseAt(environment, i);
+    }
+  }
+  return true;
+}
+
+void LICM::VisitLoop(HLoopInformation* loop_info) {
+  HBasicBlock* header = loop_info->GetHeader();
+  HBasicBlock* pre_header = loop_info->GetPreHeader();
+  RemoveInvariantPhis(header);
+  if (pre_header->GetSuccessors()->Size() != 1) {
+    // The instructions would also be executed when the loop is not entered.
+    return;
+  }
+  SideEffects loop_effects = side_effects_.GetLoopEffects(header);
+
+  for (HReversePostOrderIterator block_it(*graph_); !block_it.Done(); block_it.Advance()) {
+    HBasicBlock* block = block_it.Current();
+    if (!loop_info->Contains(*block)) {
+      continue;
+    }
+
+    // Instructions that can throw must keep their order with the other
+    // instructions that throw or write memory, and must be executed on every
+    // iteration. So they are only hoisted from the beginning of the header.
+    bool can_hoist_throwing = (block == header);
+    for (HInstructionIterator inst_it(*block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      bool can_throw = instruction->CanThrow() || instruction->NeedsEnvironment();
+      if (instruction->CanBeMoved()
+          && (!can_throw || can_hoist_throwing)
+          && !instruction->GetSideEffects().DependsOn(loop_effects)
+          && InputsAreDefinedBeforeLoop(instruction, loop_info)
+          && (!instruction->HasEnvironment()
+              || UpdateEnvironmentForPreHeader(instruction, loop_info))) {
+        pre_header->MoveInstructionBefore(instruction, pre_header->GetLastInstruction());
+      } else if (can_throw || instruction->HasSideEffects()) {
+        can_hoist_throwing = false;
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_LICM_H_
+#define ART_COMPILER_OPTIMIZING_LICM_H_
+
+#include "nodes.h"
+#include "optimization.h"
+#include "side_effects_analysis.h"
+
+namespace art {
+
+/**
+ * Optimization pass moving loop invariant instructions to the pre header of
+ * their loop. An instruction is invariant if its inputs are defined outside
+ * the loop, and if the memory it reads is not written in the loop.
+ */
+class LICM : public HOptimization {
+ public:
+  explicit LICM(HGraph* graph)
+      : HOptimization(graph, kLoopInvariantCodeMotionPassName),
+        side_effects_(graph->GetArena(), graph) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kLoopInvariantCodeMotionPassName = "licm";
+
+ private:
+  void VisitLoop(HLoopInformation* loop_info);
+
+  // Returns whether `instruction`, which needs an environment, can be executed
+  // in the pre header instead of the header of the loop. If so, updates its
+  // environment with the values the loop phis have on entry of the loop.
+  bool UpdateEnvironmentForPreHeader(HInstruction* instruction, HLoopInformation* loop_info);
+
+  SideEffectsAnalysis side_effects_;
+
+  DISALLOW_COPY_AND_ASSIGN(LICM);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_LICM_H_
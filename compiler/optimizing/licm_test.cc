@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "licm.h"
+#include "nodes.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Builds an empty loop in SSA form: the entry block, which is also the pre
+ * header of the loop, holds an object parameter and the constants 0 and 1.
+ * The loop header branches to the body or, when its condition is true, to
+ * the return block.
+ */
+static HGraph* CreateLoopGraph(ArenaAllocator* allocator) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  entry->AddInstruction(new (allocator) HParameterValue(0, Primitive::kPrimNot));
+  entry->AddInstruction(new (allocator) HIntConstant(0));
+  entry->AddInstruction(new (allocator) HIntConstant(1));
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* header = new (allocator) HBasicBlock(graph);
+  HBasicBlock* body = new (allocator) HBasicBlock(graph);
+  HBasicBlock* return_block = new (allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(header);
+  graph->AddBlock(body);
+  graph->AddBlock(return_block);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  entry->AddSuccessor(header);
+  header->AddSuccessor(return_block);
+  header->AddSuccessor(body);
+  body->AddSuccessor(header);
+  return_block->AddSuccessor(exit);
+  body->AddInstruction(new (allocator) HGoto());
+  return_block->AddInstruction(new (allocator) HReturnVoid());
+  exit->AddInstruction(new (allocator) HExit());
+
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  return graph;
+}
+
+static HBasicBlock* GetHeader(HGraph* graph) {
+  return graph->GetEntryBlock()->GetSuccessors()->Get(0);
+}
+
+static HBasicBlock* GetBody(HGraph* graph) {
+  return GetHeader(graph)->GetSuccessors()->Get(1);
+}
+
+// Adds a loop counter to the loop of `graph`, and returns it.
+static HPhi* AddCounter(ArenaAllocator* allocator, HGraph* graph) {
+  HInstruction* zero = graph->GetEntryBlock()->GetFirstInstruction()->GetNext();
+  HInstruction* one = zero->GetNext();
+  HBasicBlock* body = GetBody(graph);
+  HPhi* phi = new (allocator) HPhi(allocator, 0, 0, Primitive::kPrimInt);
+  GetHeader(graph)->AddPhi(phi);
+  HInstruction* add = new (allocator) HAdd(Primitive::kPrimInt, phi, one);
+  body->InsertInstructionBefore(add, body->GetLastInstruction());
+  phi->AddInput(zero);
+  phi->AddInput(add);
+  return phi;
+}
+
+static void SetEnvironment(ArenaAllocator* allocator,
+                           HInstruction* instruction,
+                           HInstruction* vreg) {
+  GrowableArray<HInstruction*> vregs(allocator, 1);
+  vregs.Add(vreg);
+  HEnvironment* environment = new (allocator) HEnvironment(allocator, 1);
+  environment->Populate(vregs);
+  instruction->SetEnvironment(environment);
+}
+
+TEST(LICMTest, ArrayLength) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateLoopGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HBasicBlock* header = GetHeader(graph);
+  HInstruction* array = entry->GetFirstInstruction();
+  HInstruction* zero = array->GetNext();
+  HPhi* counter = AddCounter(&allocator, graph);
+
+  HInstruction* null_check = new (&allocator) HNullCheck(array, 0);
+  HInstruction* length = new (&allocator) HArrayLength(null_check);
+  HInstruction* condition = new (&allocator) HGreaterThanOrEqual(counter, length);
+  header->AddInstruction(null_check);
+  header->AddInstruction(length);
+  header->AddInstruction(condition);
+  header->AddInstruction(new (&allocator) HIf(condition));
+  SetEnvironment(&allocator, null_check, counter);
+
+  LICM(graph).Run();
+
+  ASSERT_EQ(null_check->GetBlock(), entry);
+  ASSERT_EQ(length->GetBlock(), entry);
+  ASSERT_EQ(condition->GetBlock(), header);
+  ASSERT_EQ(entry->GetLastInstruction()->GetPrevious(), length);
+  // On entry of the loop, the counter is zero.
+  ASSERT_EQ(null_check->GetEnvironment()->GetVRegs()->Get(0), zero);
+  ASSERT_TRUE(counter->GetEnvUses() == nullptr);
+}
+
+TEST(LICMTest, InvariantPhi) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateLoopGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HBasicBlock* header = GetHeader(graph);
+  HInstruction* array = entry->GetFirstInstruction();
+  HPhi* counter = AddCounter(&allocator, graph);
+
+  // The phi the SSA builder creates for a local the loop does not write.
+  HPhi* phi = new (&allocator) HPhi(&allocator, 1, 0, Primitive::kPrimNot);
+  header->AddPhi(phi);
+  phi->AddInput(array);
+  phi->AddInput(phi);
+
+  HInstruction* null_check = new (&allocator) HNullCheck(phi, 0);
+  HInstruction* length = new (&allocator) HArrayLength(null_check);
+  HInstruction* condition = new (&allocator) HGreaterThanOrEqual(counter, length);
+  header->AddInstruction(null_check);
+  header->AddInstruction(length);
+  header->AddInstruction(condition);
+  header->AddInstruction(new (&allocator) HIf(condition));
+  SetEnvironment(&allocator, null_check, phi);
+
+  LICM(graph).Run();
+
+  ASSERT_TRUE(phi->GetBlock() == nullptr);
+  ASSERT_EQ(HInstructionIterator(*header->GetPhis()).Current(), counter);
+  ASSERT_EQ(null_check->InputAt(0), array);
+  ASSERT_EQ(null_check->GetEnvironment()->GetVRegs()->Get(0), array);
+  ASSERT_EQ(null_check->GetBlock(), entry);
+  ASSERT_EQ(length->GetBlock(), entry);
+}
+
+TEST(LICMTest, FieldWrittenInLoop) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateLoopGraph(&allocator);
+  HBasicBlock* header = GetHeader(graph);
+  HBasicBlock* body = GetBody(graph);
+  HInstruction* object = graph->GetEntryBlock()->GetFirstInstruction();
+
+  HInstruction* field_get = new (&allocator) HInstanceFieldGet(
+      object, Primitive::kPrimInt, MemberOffset(42));
+  HInstruction* other_field_get = new (&allocator) HInstanceFieldGet(
+      object, Primitive::kPrimInt, MemberOffset(43));
+  header->AddInstruction(field_get);
+  header->AddInstruction(new (&allocator) HIf(field_get));
+  body->InsertInstructionBefore(other_field_get, body->GetLastInstruction());
+  body->InsertInstructionBefore(new (&allocator) HInstanceFieldSet(
+      object, other_field_get, Primitive::kPrimInt, MemberOffset(42)), body->GetLastInstruction());
+
+  LICM(graph).Run();
+
+  // Side effects do not tell fields apart, so no field read is invariant.
+  ASSERT_EQ(field_get->GetBlock(), header);
+  ASSERT_EQ(other_field_get->GetBlock(), body);
+}
+
+TEST(LICMTest, ThrowingInstructions) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateLoopGraph(&allocator);
+  HBasicBlock* entry = graph->GetEntryBlock();
+  HBasicBlock* header = GetHeader(graph);
+  HBasicBlock* body = GetBody(graph);
+  HInstruction* object = entry->GetFirstInstruction();
+  HPhi* counter = AddCounter(&allocator, graph);
+
+  HInstruction* in_header = new (&allocator) HNullCheck(object, 0);
+  HInstruction* after_store = new (&allocator) HNullCheck(object, 0);
+  HInstruction* condition = new (&allocator) HEqual(counter, after_store);
+  header->AddInstruction(in_header);
+  header->AddInstruction(new (&allocator) HInstanceFieldSet(
+      object, counter, Primitive::kPrimInt, MemberOffset(42)));
+  header->AddInstruction(after_store);
+  header->AddInstruction(condition);
+  header->AddInstruction(new (&allocator) HIf(condition));
+  SetEnvironment(&allocator, in_header, counter);
+  SetEnvironment(&allocator, after_store, counter);
+
+  // Invariant, but not executed on every iteration.
+  HInstruction* in_body = new (&allocator) HNullCheck(object, 0);
+  body->InsertInstructionBefore(in_body, body->GetLastInstruction());
+  SetEnvironment(&allocator, in_body, counter);
+
+  LICM(graph).Run();
+
+  ASSERT_EQ(in_header->GetBlock(), entry);
+  // The exception must not be thrown before the store.
+  ASSERT_EQ(after_store->GetBlock(), header);
+  ASSERT_EQ(in_body->GetBlock(), body);
+  ASSERT_EQ(after_store->GetEnvironment()->GetVRegs()->Get(0), counter);
+  ASSERT_EQ(in_body->GetEnvironment()->GetVRegs()->Get(0), counter);
+}
+
+}  // namespace art
@@ -169,11 +169,124 @@ void HGraph::SimplifyCFG() {
   }
 }
 
+void HGraph::SplitCriticalEdges() {
+  for (size_t i = post_order_.Size(); i > 0; --i) {
+    HBasicBlock* block = post_order_.Get(i - 1);
+    if (block->GetSuccessors()->Size() > 1) {
+      for (size_t j = 0; j < block->GetSuccessors()->Size(); ++j) {
+        HBasicBlock* successor = block->GetSuccessors()->Get(j);
+        if (successor->GetPredecessors()->Size() > 1) {
+          SplitEdge(block, j, i - 1);
+        }
+      }
+    }
+  }
+}
+
+void HGraph::SplitEdge(HBasicBlock* block, size_t successor_index, size_t post_order_index) {
+  HBasicBlock* successor = block->GetSuccessors()->Get(successor_index);
+  HBasicBlock* new_block = new (arena_) HBasicBlock(this);
+  AddBlock(new_block);
+  new_block->AddInstruction(new (arena_) HGoto());
+  block->ReplaceSuccessorAt(successor_index, new_block);
+  new_block->SetDominator(block);
+  // Insert the new block right after `block` in the reverse post order.
+  post_order_.InsertAt(post_order_index, new_block);
+
+  if (successor->IsLoopHeader()) {
+    HLoopInformation* info = successor->GetLoopInformation();
+    if (info->GetPreHeader() == block) {
+      successor->SetDominator(new_block);
+      info->SetPreHeader(new_block);
+    } else {
+      info->ReplaceBackEdge(block, new_block);
+    }
+  }
+}
+
+void HGraph::InlineInto(HGraph* outer_graph, HInvoke* invoke) {
+  DCHECK_EQ(blocks_.Size(), 3u);
+  HBasicBlock* body = entry_block_->GetSuccessors()->Get(0);
+  DCHECK_EQ(body->GetSuccessors()->Get(0), exit_block_);
+  HBasicBlock* invoke_block = invoke->GetBlock();
+
+  // The entry block contains the parameters, which are replaced with the
+  // arguments of the call, and constants, which are moved before the call.
+  size_t parameter_index = 0;
+  for (HInstructionIterator it(*entry_block_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current->AsParameterValue() != nullptr) {
+      current->ReplaceWith(invoke->InputAt(parameter_index++));
+      entry_block_->RemoveInstruction(current);
+    } else if (current->AsGoto() == nullptr) {
+      invoke_block->MoveInstructionBefore(current, invoke);
+    }
+  }
+  DCHECK_EQ(parameter_index, invoke->InputCount());
+
+  HInstruction* last = body->GetLastInstruction();
+  for (HInstructionIterator it(*body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current != last) {
+      invoke_block->MoveInstructionBefore(current, invoke);
+    }
+  }
+
+  // Replace the result of the call with the value returned by this graph.
+  if (last->AsReturn() != nullptr) {
+    invoke->ReplaceWith(last->InputAt(0));
+  } else {
+    DCHECK(last->AsReturnVoid() != nullptr);
+  }
+  body->RemoveInstruction(last);
+  invoke_block->RemoveInstruction(invoke);
+
+  outer_graph->UpdateNumberOfTemporaries(number_of_temporaries_);
+  outer_graph->UpdateMaximumNumberOfOutVRegs(maximum_number_of_out_vregs_);
+}
+
 void HLoopInformation::SetPreHeader(HBasicBlock* block) {
   DCHECK_EQ(header_->GetDominator(), block);
   pre_header_ = block;
 }
 
+void HLoopInformation::PopulateRecursive(HBasicBlock* block) {
+  if (blocks_.IsBitSet(block->GetBlockId())) {
+    return;
+  }
+
+  blocks_.SetBit(block->GetBlockId());
+  for (size_t i = 0, e = block->GetPredecessors()->Size(); i < e; ++i) {
+    PopulateRecursive(block->GetPredecessors()->Get(i));
+  }
+}
+
+void HLoopInformation::Populate() {
+  blocks_.ClearAllBits();
+  // The header is marked first, so that walking up from the back edges stops there.
+  blocks_.SetBit(header_->GetBlockId());
+  for (size_t i = 0, e = back_edges_.Size(); i < e; ++i) {
+    PopulateRecursive(back_edges_.Get(i));
+  }
+}
+
+bool HLoopInformation::Contains(const HBasicBlock& block) const {
+  return blocks_.IsBitSet(block.GetBlockId());
+}
+
+bool HBasicBlock::Dominates(HBasicBlock* other) const {
+  // Walk up the dominator tree from `other`, to find out if this block
+  // is an ancestor.
+  HBasicBlock* current = other;
+  while (current != nullptr) {
+    if (current == this) {
+      return true;
+    }
+    current = current->GetDominator();
+  }
+  return false;
+}
+
 static void Add(HInstructionList* instruction_list,
                 HBasicBlock* block,
                 HInstruction* instruction) {
@@ -188,6 +301,34 @@ void HBasicBlock::AddInstruction(HInstruction* instruction) {
   Add(&instructions_, this, instruction);
 }
 
+void HBasicBlock::InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
+  DCHECK(cursor->AsPhi() == nullptr);
+  DCHECK_EQ(cursor->GetBlock(), this);
+  DCHECK(instruction->GetBlock() == nullptr);
+  DCHECK_EQ(instruction->GetId(), -1);
+  instruction->SetBlock(this);
+  instruction->SetId(GetGraph()->GetNextInstructionId());
+  instructions_.InsertInstructionBefore(instruction, cursor);
+}
+
+void HBasicBlock::ReplaceAndRemoveInstructionWith(HInstruction* initial,
+                                                  HInstruction* replacement) {
+  DCHECK(initial->GetBlock() == this);
+  InsertInstructionBefore(replacement, initial);
+  initial->ReplaceWith(replacement);
+  RemoveInstruction(initial);
+}
+
+void HBasicBlock::MoveInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
+  DCHECK(instruction->AsPhi() == nullptr);
+  DCHECK_EQ(cursor->GetBlock(), this);
+  instruction->GetBlock()->instructions_.RemoveInstruction(instruction);
+  instructions_.LinkBefore(instruction, cursor);
+  instruction->SetBlock(this);
+  // Instruction ids are only unique within a graph.
+  instruction->SetId(GetGraph()->GetNextInstructionId());
+}
+
 void HBasicBlock::AddPhi(HPhi* phi) {
   Add(&phis_, this, phi);
 }
@@ -204,6 +345,17 @@ static void Remove(HInstructionList* instruction_list,
   for (size_t i = 0; i < instruction->InputCount(); i++) {
     instruction->InputAt(i)->RemoveUser(instruction, i);
   }
+
+  if (instruction->HasEnvironment()) {
+    HEnvironment* environment = instruction->GetEnvironment();
+    GrowableArray<HInstruction*>* vregs = environment->GetVRegs();
+    for (size_t i = 0, e = vregs->Size(); i < e; ++i) {
+      HInstruction* vreg = vregs->Get(i);
+      if (vreg != nullptr) {
+        vreg->RemoveEnvironmentUser(environment, i);
+      }
+    }
+  }
 }
 
 void HBasicBlock::RemoveInstruction(HInstruction* instruction) {
@@ -214,22 +366,32 @@ void HBasicBlock::RemovePhi(HPhi* phi) {
   Remove(&phis_, this, phi);
 }
 
-void HInstruction::RemoveUser(HInstruction* user, size_t input_index) {
-  HUseListNode<HInstruction>* previous = nullptr;
-  HUseListNode<HInstruction>* current = uses_;
+template <typename T>
+static void RemoveFromUseList(T* user, size_t input_index, HUseListNode<T>** list) {
+  HUseListNode<T>* previous = nullptr;
+  HUseListNode<T>* current = *list;
   while (current != nullptr) {
     if (current->GetUser() == user && current->GetIndex() == input_index) {
-      if (previous == NULL) {
-        uses_ = current->GetTail();
+      if (previous == nullptr) {
+        *list = current->GetTail();
       } else {
         previous->SetTail(current->GetTail());
       }
+      return;
     }
     previous = current;
     current = current->GetTail();
   }
 }
 
+void HInstruction::RemoveUser(HInstruction* user, size_t input_index) {
+  RemoveFromUseList(user, input_index, &uses_);
+}
+
+void HInstruction::RemoveEnvironmentUser(HEnvironment* user, size_t input_index) {
+  RemoveFromUseList(user, input_index, &env_uses_);
+}
+
 void HInstructionList::AddInstruction(HInstruction* instruction) {
   if (first_instruction_ == nullptr) {
     DCHECK(last_instruction_ == nullptr);
@@ -244,6 +406,24 @@ void HInstructionList::AddInstruction(HInstruction* instruction) {
   }
 }
 
+void HInstructionList::LinkBefore(HInstruction* instruction, HInstruction* cursor) {
+  if (cursor == first_instruction_) {
+    first_instruction_ = instruction;
+  } else {
+    cursor->previous_->next_ = instruction;
+  }
+  instruction->previous_ = cursor->previous_;
+  instruction->next_ = cursor;
+  cursor->previous_ = instruction;
+}
+
+void HInstructionList::InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
+  LinkBefore(instruction, cursor);
+  for (size_t i = 0; i < instruction->InputCount(); i++) {
+    instruction->InputAt(i)->AddUseAt(instruction, i);
+  }
+}
+
 void HInstructionList::RemoveInstruction(HInstruction* instruction) {
   if (instruction->previous_ != nullptr) {
     instruction->previous_->next_ = instruction->next_;
@@ -280,6 +460,46 @@ void HInstruction::ReplaceWith(HInstruction* other) {
   env_uses_ = nullptr;
 }
 
+bool HInstruction::Equals(HInstruction* other) const {
+  if (GetKind() != other->GetKind()) return false;
+  if (GetType() != other->GetType()) return false;
+  if (!CanBeMoved() || !other->CanBeMoved()) return false;
+  if (!InstructionDataEquals(other)) return false;
+  if (InputCount() != other->InputCount()) return false;
+
+  for (size_t i = 0, e = InputCount(); i < e; ++i) {
+    if (InputAt(i) != other->InputAt(i)) return false;
+  }
+  DCHECK_EQ(ComputeHashCode(), other->ComputeHashCode());
+  return true;
+}
+
+size_t HInstruction::ComputeHashCode() const {
+  size_t result = GetKind();
+  for (size_t i = 0, e = InputCount(); i < e; ++i) {
+    result = (result * 31) + InputAt(i)->GetId();
+  }
+  return result;
+}
+
+HInstruction* HBinaryOperation::TryStaticEvaluation(ArenaAllocator* allocator) const {
+  if (GetLeft()->AsIntConstant() != nullptr && GetRight()->AsIntConstant() != nullptr) {
+    int32_t value = Evaluate(GetLeft()->AsIntConstant()->GetValue(),
+                             GetRight()->AsIntConstant()->GetValue());
+    return new (allocator) HIntConstant(value);
+  } else if (GetLeft()->AsLongConstant() != nullptr && GetRight()->AsLongConstant() != nullptr) {
+    int64_t value = Evaluate(GetLeft()->AsLongConstant()->GetValue(),
+                             GetRight()->AsLongConstant()->GetValue());
+    if (GetResultType() == Primitive::kPrimLong) {
+      return new (allocator) HLongConstant(value);
+    } else {
+      // Comparisons of longs produce an int.
+      return new (allocator) HIntConstant(static_cast<int32_t>(value));
+    }
+  }
+  return nullptr;
+}
+
 void HPhi::AddInput(HInstruction* input) {
   DCHECK(input->GetBlock() != nullptr);
   inputs_.Add(input);
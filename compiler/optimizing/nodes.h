@@ -17,6 +17,8 @@
 #ifndef ART_COMPILER_OPTIMIZING_NODES_H_
 #define ART_COMPILER_OPTIMIZING_NODES_H_
 
+#include "locations.h"
+#include "offsets.h"
 #include "utils/allocation.h"
 #include "utils/arena_bit_vector.h"
 #include "utils/growable_array.h"
@@ -24,17 +26,34 @@
 namespace art {
 
 class HBasicBlock;
+class HBinaryOperation;
+class HCondition;
 class HEnvironment;
 class HInstruction;
 class HIntConstant;
+class HInvoke;
 class HGraphVisitor;
 class HPhi;
+class LiveInterval;
 class LocationSummary;
 
 static const int kDefaultNumberOfBlocks = 8;
 static const int kDefaultNumberOfSuccessors = 2;
 static const int kDefaultNumberOfPredecessors = 2;
 static const int kDefaultNumberOfBackEdges = 1;
+static const int kDefaultNumberOfLoops = 2;
+static const int kDefaultNumberOfMoves = 4;
+
+static constexpr size_t kNoLifetime = -1;
+
+enum IfCondition {
+  kCondEQ,
+  kCondNE,
+  kCondLT,
+  kCondLE,
+  kCondGT,
+  kCondGE,
+};
 
 class HInstructionList {
  public:
@@ -43,7 +62,13 @@ class HInstructionList {
   void AddInstruction(HInstruction* instruction);
   void RemoveInstruction(HInstruction* instruction);
 
+  // Insert `instruction` before `cursor`, which must be in this list.
+  void InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor);
+
  private:
+  // Link `instruction` before `cursor`, without updating the uses of its inputs.
+  void LinkBefore(HInstruction* instruction, HInstruction* cursor);
+
   HInstruction* first_instruction_;
   HInstruction* last_instruction_;
 
@@ -64,6 +89,7 @@ class HGraph : public ArenaObject {
         maximum_number_of_out_vregs_(0),
         number_of_vregs_(0),
         number_of_in_vregs_(0),
+        number_of_temporaries_(0),
         current_instruction_id_(0) { }
 
   ArenaAllocator* GetArena() const { return arena_; }
@@ -81,10 +107,25 @@ class HGraph : public ArenaObject {
   void TransformToSSA();
   void SimplifyCFG();
 
+  // Split the edges going from a block with multiple successors to a block
+  // with multiple predecessors, so that the register allocator always has a
+  // block where to insert the moves of an edge. Must be called on an SSA graph.
+  void SplitCriticalEdges();
+
+  // Replace `invoke`, an instruction of `outer_graph`, with the body of this
+  // graph. This graph must be in SSA form, and made of a single block between
+  // its entry and exit blocks. The parameters of this graph are replaced with
+  // the arguments of `invoke`.
+  void InlineInto(HGraph* outer_graph, HInvoke* invoke);
+
   int GetNextInstructionId() {
     return current_instruction_id_++;
   }
 
+  int GetCurrentInstructionId() const {
+    return current_instruction_id_;
+  }
+
   uint16_t GetMaximumNumberOfOutVRegs() const {
     return maximum_number_of_out_vregs_;
   }
@@ -109,6 +150,14 @@ class HGraph : public ArenaObject {
     return number_of_in_vregs_;
   }
 
+  void UpdateNumberOfTemporaries(size_t count) {
+    number_of_temporaries_ = std::max(count, number_of_temporaries_);
+  }
+
+  size_t GetNumberOfTemporaries() const {
+    return number_of_temporaries_;
+  }
+
   const GrowableArray<HBasicBlock*>& GetPostOrder() const {
     return post_order_;
   }
@@ -123,6 +172,7 @@ class HGraph : public ArenaObject {
                               ArenaBitVector* visited,
                               ArenaBitVector* visiting);
   void RemoveDeadBlocks(const ArenaBitVector& visited) const;
+  void SplitEdge(HBasicBlock* block, size_t successor_index, size_t post_order_index);
 
   ArenaAllocator* const arena_;
 
@@ -144,6 +194,9 @@ class HGraph : public ArenaObject {
   // The number of virtual registers used by parameters of this method.
   uint16_t number_of_in_vregs_;
 
+  // The number of stack slots the code generator needs for HTemporary instructions.
+  size_t number_of_temporaries_;
+
   // The current id to assign to a newly added instruction. See HInstruction.id_.
   int current_instruction_id_;
 
@@ -154,12 +207,27 @@ class HLoopInformation : public ArenaObject {
  public:
   HLoopInformation(HBasicBlock* header, HGraph* graph)
       : header_(header),
-        back_edges_(graph->GetArena(), kDefaultNumberOfBackEdges) { }
+        back_edges_(graph->GetArena(), kDefaultNumberOfBackEdges),
+        blocks_(graph->GetArena(), graph->GetBlocks().Size(), true) { }
 
   void AddBackEdge(HBasicBlock* back_edge) {
     back_edges_.Add(back_edge);
   }
 
+  void ReplaceBackEdge(HBasicBlock* existing, HBasicBlock* new_back_edge) {
+    for (size_t i = 0, e = back_edges_.Size(); i < e; ++i) {
+      if (back_edges_.Get(i) == existing) {
+        back_edges_.Put(i, new_back_edge);
+        return;
+      }
+    }
+    LOG(FATAL) << "Unreachable";
+  }
+
+  HBasicBlock* GetHeader() const {
+    return header_;
+  }
+
   int NumberOfBackEdges() const {
     return back_edges_.Size();
   }
@@ -174,10 +242,20 @@ class HLoopInformation : public ArenaObject {
     return &back_edges_;
   }
 
+  // Compute the blocks of the loop: the header, and the blocks that can reach
+  // a back edge without going through the header. Inner loops are included.
+  void Populate();
+
+  // Returns whether `block` is in the loop. Only valid after `Populate`.
+  bool Contains(const HBasicBlock& block) const;
+
  private:
+  void PopulateRecursive(HBasicBlock* block);
+
   HBasicBlock* pre_header_;
   HBasicBlock* header_;
   GrowableArray<HBasicBlock*> back_edges_;
+  ArenaBitVector blocks_;
 
   DISALLOW_COPY_AND_ASSIGN(HLoopInformation);
 };
@@ -193,7 +271,9 @@ class HBasicBlock : public ArenaObject {
         successors_(graph->GetArena(), kDefaultNumberOfSuccessors),
         loop_information_(nullptr),
         dominator_(nullptr),
-        block_id_(-1) { }
+        block_id_(-1),
+        lifetime_start_(kNoLifetime),
+        lifetime_end_(kNoLifetime) { }
 
   const GrowableArray<HBasicBlock*>* GetPredecessors() const {
     return &predecessors_;
@@ -241,8 +321,43 @@ class HBasicBlock : public ArenaObject {
     }
   }
 
+  // Replace the edge to the successor at `index` with an edge to `new_block`.
+  // `new_block` takes the place of this block in the predecessors of the old
+  // successor, so that the inputs of its phis stay in order.
+  void ReplaceSuccessorAt(size_t index, HBasicBlock* new_block) {
+    HBasicBlock* existing = successors_.Get(index);
+    GrowableArray<HBasicBlock*>* predecessors = &existing->predecessors_;
+    for (size_t i = 0, e = predecessors->Size(); i < e; ++i) {
+      if (predecessors->Get(i) == this) {
+        predecessors->Put(i, new_block);
+        new_block->successors_.Add(existing);
+        successors_.Put(index, new_block);
+        new_block->predecessors_.Add(this);
+        return;
+      }
+    }
+    LOG(FATAL) << "Unreachable";
+  }
+
+  size_t GetPredecessorIndexOf(HBasicBlock* predecessor) const {
+    for (size_t i = 0, e = predecessors_.Size(); i < e; ++i) {
+      if (predecessors_.Get(i) == predecessor) {
+        return i;
+      }
+    }
+    LOG(FATAL) << "Unreachable";
+    return -1;
+  }
+
   void AddInstruction(HInstruction* instruction);
   void RemoveInstruction(HInstruction* instruction);
+  void InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor);
+  // Replace `initial` with `replacement` in the block and in the uses of
+  // `initial`, and remove `initial` from the graph.
+  void ReplaceAndRemoveInstructionWith(HInstruction* initial, HInstruction* replacement);
+  // Move `instruction`, which can be in a block of another graph, before
+  // `cursor`. The uses of the instruction and its inputs are not changed.
+  void MoveInstructionBefore(HInstruction* instruction, HInstruction* cursor);
   void AddPhi(HPhi* phi);
   void RemovePhi(HPhi* phi);
 
@@ -254,6 +369,15 @@ class HBasicBlock : public ArenaObject {
     return loop_information_;
   }
 
+  // Returns whether this block dominates `other`. A block dominates itself.
+  bool Dominates(HBasicBlock* other) const;
+
+  size_t GetLifetimeStart() const { return lifetime_start_; }
+  size_t GetLifetimeEnd() const { return lifetime_end_; }
+
+  void SetLifetimeStart(size_t start) { lifetime_start_ = start; }
+  void SetLifetimeEnd(size_t end) { lifetime_end_ = end; }
+
  private:
   HGraph* const graph_;
   GrowableArray<HBasicBlock*> predecessors_;
@@ -264,37 +388,63 @@ class HBasicBlock : public ArenaObject {
   HBasicBlock* dominator_;
   int block_id_;
 
+  // Positions of the block in the linear order used by the register allocator.
+  size_t lifetime_start_;
+  size_t lifetime_end_;
+
   DISALLOW_COPY_AND_ASSIGN(HBasicBlock);
 };
 
 #define FOR_EACH_INSTRUCTION(M)                            \
   M(Add)                                                   \
+  M(ArrayGet)                                              \
+  M(ArrayLength)                                           \
+  M(ArraySet)                                              \
+  M(BoundsCheck)                                           \
+  M(Compare)                                               \
   M(Equal)                                                 \
   M(Exit)                                                  \
   M(Goto)                                                  \
+  M(GreaterThan)                                           \
+  M(GreaterThanOrEqual)                                    \
   M(If)                                                    \
+  M(InstanceFieldGet)                                      \
+  M(InstanceFieldSet)                                      \
   M(IntConstant)                                           \
   M(InvokeStatic)                                          \
+  M(InvokeVirtual)                                         \
+  M(LessThan)                                              \
+  M(LessThanOrEqual)                                       \
   M(LoadLocal)                                             \
   M(Local)                                                 \
   M(LongConstant)                                          \
   M(NewInstance)                                           \
   M(Not)                                                   \
+  M(NotEqual)                                              \
+  M(NullCheck)                                             \
+  M(ParallelMove)                                          \
   M(ParameterValue)                                        \
   M(Phi)                                                   \
   M(Return)                                                \
   M(ReturnVoid)                                            \
   M(StoreLocal)                                            \
   M(Sub)                                                   \
+  M(Temporary)                                             \
+  M(VecAdd)                                                \
+  M(VecCopy)                                               \
+  M(VecFill)                                               \
+  M(VecSub)                                                \
+  M(VecSum)                                                \
 
 #define FORWARD_DECLARATION(type) class H##type;
 FOR_EACH_INSTRUCTION(FORWARD_DECLARATION)
 #undef FORWARD_DECLARATION
 
-#define DECLARE_INSTRUCTION(type)                          \
-  virtual void Accept(HGraphVisitor* visitor);             \
-  virtual const char* DebugName() const { return #type; }  \
-  virtual H##type* As##type() { return this; }             \
+#define DECLARE_INSTRUCTION(type)                              \
+  virtual InstructionKind GetKind() const { return k##type; }  \
+  virtual void Accept(HGraphVisitor* visitor);                 \
+  virtual const char* DebugName() const { return #type; }      \
+  virtual H##type* As##type() { return this; }                 \
 
 template <typename T>
 class HUseListNode : public ArenaObject {
@@ -316,9 +466,77 @@ class HUseListNode : public ArenaObject {
   DISALLOW_COPY_AND_ASSIGN(HUseListNode);
 };
 
+/**
+ * Represents the memory an instruction writes (its side effects) and the
+ * memory it reads (its dependencies). Fields and arrays are kept apart, so
+ * that an array store does not invalidate a field load.
+ */
+class SideEffects : public ValueObject {
+ public:
+  SideEffects() : flags_(0) {}
+
+  static SideEffects None() {
+    return SideEffects(0);
+  }
+
+  static SideEffects All() {
+    return SideEffects(kAllWrites | kAllReads);
+  }
+
+  static SideEffects FieldWrites() {
+    return SideEffects(1 << kFieldWriteBit);
+  }
+
+  static SideEffects ArrayWrites() {
+    return SideEffects(1 << kArrayWriteBit);
+  }
+
+  static SideEffects FieldReads() {
+    return SideEffects(1 << (kFieldWriteBit + kReadShift));
+  }
+
+  static SideEffects ArrayReads() {
+    return SideEffects(1 << (kArrayWriteBit + kReadShift));
+  }
+
+  SideEffects Union(SideEffects other) const {
+    return SideEffects(flags_ | other.flags_);
+  }
+
+  bool HasSideEffects() const {
+    return (flags_ & kAllWrites) != 0;
+  }
+
+  bool HasDependencies() const {
+    return (flags_ & kAllReads) != 0;
+  }
+
+  // Returns whether the memory read by this may be written by `other`.
+  bool DependsOn(SideEffects other) const {
+    return ((flags_ & kAllReads) >> kReadShift & other.flags_) != 0;
+  }
+
+ private:
+  static constexpr int kFieldWriteBit = 0;
+  static constexpr int kArrayWriteBit = 1;
+  static constexpr int kReadShift = 2;
+  static constexpr uint32_t kAllWrites = (1 << kReadShift) - 1;
+  static constexpr uint32_t kAllReads = kAllWrites << kReadShift;
+
+  explicit SideEffects(uint32_t flags) : flags_(flags) {}
+
+  uint32_t flags_;
+};
+
 class HInstruction : public ArenaObject {
  public:
-  HInstruction()
+  enum InstructionKind {
+#define DECLARE_KIND(type) k##type,
+    FOR_EACH_INSTRUCTION(DECLARE_KIND)
+#undef DECLARE_KIND
+  };
+
+  explicit HInstruction(SideEffects side_effects)
       : previous_(nullptr),
         next_(nullptr),
         block_(nullptr),
@@ -327,7 +545,10 @@ class HInstruction : public ArenaObject {
         uses_(nullptr),
         env_uses_(nullptr),
         environment_(nullptr),
-        locations_(nullptr) { }
+        locations_(nullptr),
+        live_interval_(nullptr),
+        lifetime_position_(kNoLifetime),
+        side_effects_(side_effects) { }
 
   virtual ~HInstruction() { }
 
@@ -347,6 +568,26 @@ class HInstruction : public ArenaObject {
   virtual void SetRawInputAt(size_t index, HInstruction* input) = 0;
 
   virtual bool NeedsEnvironment() const { return false; }
+  virtual bool IsControlFlow() const { return false; }
+  virtual bool CanThrow() const { return false; }
+
+  SideEffects GetSideEffects() const { return side_effects_; }
+  bool HasSideEffects() const { return side_effects_.HasSideEffects(); }
+
+  virtual InstructionKind GetKind() const = 0;
+
+  // Returns whether the instruction computes a value that only depends on its
+  // inputs, its kind and its data, and the memory described by its side effects.
+  // Such an instruction can be replaced by an equal instruction dominating it.
+  virtual bool CanBeMoved() const { return false; }
+
+  // Returns whether the data of this instruction, other than its kind, type
+  // and inputs, is the same as the one of `other`, which has the same kind.
+  virtual bool InstructionDataEquals(HInstruction* other) const { return false; }
+
+  // Returns whether this instruction and `other` compute the same value.
+  bool Equals(HInstruction* other) const;
+  virtual size_t ComputeHashCode() const;
 
   void AddUseAt(HInstruction* user, size_t index) {
     uses_ = new (block_->GetGraph()->GetArena()) HUseListNode<HInstruction>(user, index, uses_);
@@ -358,6 +599,7 @@ class HInstruction : public ArenaObject {
   }
 
   void RemoveUser(HInstruction* user, size_t index);
+  void RemoveEnvironmentUser(HEnvironment* user, size_t index);
 
   HUseListNode<HInstruction>* GetUses() const { return uses_; }
   HUseListNode<HEnvironment>* GetEnvUses() const { return env_uses_; }
@@ -378,8 +620,17 @@ class HInstruction : public ArenaObject {
   LocationSummary* GetLocations() const { return locations_; }
   void SetLocations(LocationSummary* locations) { locations_ = locations; }
 
+  size_t GetLifetimePosition() const { return lifetime_position_; }
+  void SetLifetimePosition(size_t position) { lifetime_position_ = position; }
+  LiveInterval* GetLiveInterval() const { return live_interval_; }
+  void SetLiveInterval(LiveInterval* interval) { live_interval_ = interval; }
+
   void ReplaceWith(HInstruction* instruction);
 
+  virtual HBinaryOperation* AsBinaryOperation() { return nullptr; }
+  virtual HCondition* AsCondition() { return nullptr; }
+  virtual HInvoke* AsInvoke() { return nullptr; }
+
 #define INSTRUCTION_TYPE_CHECK(type)                                           \
   virtual H##type* As##type() { return nullptr; }
 
@@ -410,6 +661,15 @@ class HInstruction : public ArenaObject {
   // Set by the code generator.
   LocationSummary* locations_;
 
+  // Set by the liveness analysis.
+  LiveInterval* live_interval_;
+
+  // Set by the liveness analysis, this is the position in a linear
+  // order of blocks where this instruction's live interval start.
+  size_t lifetime_position_;
+
+  const SideEffects side_effects_;
+
   friend class HBasicBlock;
   friend class HInstructionList;
 
@@ -576,7 +836,8 @@ class EmbeddedArray<T, 0> {
 template<intptr_t N>
 class HTemplateInstruction: public HInstruction {
  public:
-  HTemplateInstruction<N>() : inputs_() { }
+  explicit HTemplateInstruction<N>(SideEffects side_effects)
+      : HInstruction(side_effects), inputs_() { }
   virtual ~HTemplateInstruction() { }
 
   virtual size_t InputCount() const { return N; }
@@ -597,7 +858,9 @@ class HTemplateInstruction: public HInstruction {
 // instruction that branches to the exit block.
 class HReturnVoid : public HTemplateInstruction<0> {
  public:
-  HReturnVoid() { }
+  HReturnVoid() : HTemplateInstruction(SideEffects::None()) { }
+
+  virtual bool IsControlFlow() const { return true; }
 
   DECLARE_INSTRUCTION(ReturnVoid)
 
@@ -609,10 +872,12 @@ class HReturnVoid : public HTemplateInstruction<0> {
 // instruction that branches to the exit block.
 class HReturn : public HTemplateInstruction<1> {
  public:
-  explicit HReturn(HInstruction* value) {
+  explicit HReturn(HInstruction* value) : HTemplateInstruction(SideEffects::None()) {
     SetRawInputAt(0, value);
   }
 
+  virtual bool IsControlFlow() const { return true; }
+
   DECLARE_INSTRUCTION(Return)
 
  private:
@@ -624,7 +889,9 @@ class HReturn : public HTemplateInstruction<1> {
 // exit block.
 class HExit : public HTemplateInstruction<0> {
  public:
-  HExit() { }
+  HExit() : HTemplateInstruction(SideEffects::None()) { }
+
+  virtual bool IsControlFlow() const { return true; }
 
   DECLARE_INSTRUCTION(Exit)
 
@@ -635,7 +902,9 @@ class HExit : public HTemplateInstruction<0> {
 // Jumps from one block to another.
 class HGoto : public HTemplateInstruction<0> {
  public:
-  HGoto() { }
+  HGoto() : HTemplateInstruction(SideEffects::None()) { }
+
+  virtual bool IsControlFlow() const { return true; }
 
   HBasicBlock* GetSuccessor() const {
     return GetBlock()->GetSuccessors()->Get(0);
@@ -651,10 +920,12 @@ class HGoto : public HTemplateInstruction<0> {
 // two successors.
 class HIf : public HTemplateInstruction<1> {
  public:
-  explicit HIf(HInstruction* input) {
+  explicit HIf(HInstruction* input) : HTemplateInstruction(SideEffects::None()) {
     SetRawInputAt(0, input);
   }
 
+  virtual bool IsControlFlow() const { return true; }
+
   HBasicBlock* IfTrueSuccessor() const {
     return GetBlock()->GetSuccessors()->Get(0);
   }
@@ -673,7 +944,8 @@ class HBinaryOperation : public HTemplateInstruction<2> {
  public:
   HBinaryOperation(Primitive::Type result_type,
                    HInstruction* left,
-                   HInstruction* right) : result_type_(result_type) {
+                   HInstruction* right)
+      : HTemplateInstruction(SideEffects::None()), result_type_(result_type) {
     SetRawInputAt(0, left);
     SetRawInputAt(1, right);
   }
@@ -685,6 +957,20 @@ class HBinaryOperation : public HTemplateInstruction<2> {
   virtual bool IsCommutative() { return false; }
   virtual Primitive::Type GetType() const { return GetResultType(); }
 
+  virtual HBinaryOperation* AsBinaryOperation() { return this; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  // Returns a new constant holding the result of this operation if both
+  // inputs are constants, or null otherwise. The constant is not added to
+  // the graph.
+  HInstruction* TryStaticEvaluation(ArenaAllocator* allocator) const;
+
+  // Apply this operation to `x` and `y`.
+  virtual int32_t Evaluate(int32_t x, int32_t y) const = 0;
+  virtual int64_t Evaluate(int64_t x, int64_t y) const = 0;
+
  private:
   const Primitive::Type result_type_;
 
@@ -692,26 +978,161 @@ class HBinaryOperation : public HTemplateInstruction<2> {
 };
 
 
+class HCondition : public HBinaryOperation {
+ public:
+  HCondition(HInstruction* first, HInstruction* second)
+      : HBinaryOperation(Primitive::kPrimBoolean, first, second) {}
+
+  virtual IfCondition GetCondition() const = 0;
+
+  virtual HCondition* AsCondition() { return this; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HCondition);
+};
+
 // Instruction to check if two inputs are equal to each other.
-class HEqual : public HBinaryOperation {
+class HEqual : public HCondition {
  public:
   HEqual(HInstruction* first, HInstruction* second)
-      : HBinaryOperation(Primitive::kPrimBoolean, first, second) {}
+      : HCondition(first, second) {}
 
   virtual bool IsCommutative() { return true; }
 
-  virtual Primitive::Type GetType() const { return Primitive::kPrimBoolean; }
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x == y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x == y ? 1 : 0; }
 
   DECLARE_INSTRUCTION(Equal)
 
+  virtual IfCondition GetCondition() const {
+    return kCondEQ;
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(HEqual);
 };
 
+class HNotEqual : public HCondition {
+ public:
+  HNotEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual bool IsCommutative() { return true; }
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x != y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x != y ? 1 : 0; }
+
+  DECLARE_INSTRUCTION(NotEqual)
+
+  virtual IfCondition GetCondition() const {
+    return kCondNE;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HNotEqual);
+};
+
+class HLessThan : public HCondition {
+ public:
+  HLessThan(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x < y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x < y ? 1 : 0; }
+
+  DECLARE_INSTRUCTION(LessThan)
+
+  virtual IfCondition GetCondition() const {
+    return kCondLT;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HLessThan);
+};
+
+class HLessThanOrEqual : public HCondition {
+ public:
+  HLessThanOrEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x <= y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x <= y ? 1 : 0; }
+
+  DECLARE_INSTRUCTION(LessThanOrEqual)
+
+  virtual IfCondition GetCondition() const {
+    return kCondLE;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HLessThanOrEqual);
+};
+
+class HGreaterThan : public HCondition {
+ public:
+  HGreaterThan(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x > y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x > y ? 1 : 0; }
+
+  DECLARE_INSTRUCTION(GreaterThan)
+
+  virtual IfCondition GetCondition() const {
+    return kCondGT;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HGreaterThan);
+};
+
+class HGreaterThanOrEqual : public HCondition {
+ public:
+  HGreaterThanOrEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const { return x >= y ? 1 : 0; }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const { return x >= y ? 1 : 0; }
+
+  DECLARE_INSTRUCTION(GreaterThanOrEqual)
+
+  virtual IfCondition GetCondition() const {
+    return kCondGE;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HGreaterThanOrEqual);
+};
+
+
+// Instruction to check how two inputs compare to each other.
+// Result is 0 if input0 == input1, 1 if input0 > input1, or -1 if input0 < input1.
+class HCompare : public HBinaryOperation {
+ public:
+  HCompare(Primitive::Type type, HInstruction* first, HInstruction* second)
+      : HBinaryOperation(Primitive::kPrimInt, first, second) {
+    DCHECK_EQ(type, first->GetType());
+    DCHECK_EQ(type, second->GetType());
+  }
+
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    return x == y ? 0 : (x > y ? 1 : -1);
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    return x == y ? 0 : (x > y ? 1 : -1);
+  }
+
+  DECLARE_INSTRUCTION(Compare);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HCompare);
+};
+
 // A local in the graph. Corresponds to a Dex register.
 class HLocal : public HTemplateInstruction<0> {
  public:
-  explicit HLocal(uint16_t reg_number) : reg_number_(reg_number) { }
+  explicit HLocal(uint16_t reg_number)
+      : HTemplateInstruction(SideEffects::None()), reg_number_(reg_number) { }
 
   DECLARE_INSTRUCTION(Local)
 
@@ -727,7 +1148,8 @@ class HLocal : public HTemplateInstruction<0> {
 // Load a given local. The local is an input of this instruction.
 class HLoadLocal : public HTemplateInstruction<1> {
  public:
-  explicit HLoadLocal(HLocal* local, Primitive::Type type) : type_(type) {
+  HLoadLocal(HLocal* local, Primitive::Type type)
+      : HTemplateInstruction(SideEffects::None()), type_(type) {
     SetRawInputAt(0, local);
   }
 
@@ -747,7 +1169,7 @@ class HLoadLocal : public HTemplateInstruction<1> {
 // and the local.
 class HStoreLocal : public HTemplateInstruction<2> {
  public:
-  HStoreLocal(HLocal* local, HInstruction* value) {
+  HStoreLocal(HLocal* local, HInstruction* value) : HTemplateInstruction(SideEffects::None()) {
     SetRawInputAt(0, local);
     SetRawInputAt(1, value);
   }
@@ -764,11 +1186,17 @@ class HStoreLocal : public HTemplateInstruction<2> {
 // synthesized (for example with the if-eqz instruction).
 class HIntConstant : public HTemplateInstruction<0> {
  public:
-  explicit HIntConstant(int32_t value) : value_(value) { }
+  explicit HIntConstant(int32_t value)
+      : HTemplateInstruction(SideEffects::None()), value_(value) { }
 
   int32_t GetValue() const { return value_; }
   virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsIntConstant()->value_ == value_;
+  }
+
   DECLARE_INSTRUCTION(IntConstant)
 
  private:
@@ -779,12 +1207,18 @@ class HIntConstant : public HTemplateInstruction<0> {
 
 class HLongConstant : public HTemplateInstruction<0> {
  public:
-  explicit HLongConstant(int64_t value) : value_(value) { }
+  explicit HLongConstant(int64_t value)
+      : HTemplateInstruction(SideEffects::None()), value_(value) { }
 
   int64_t GetValue() const { return value_; }
 
   virtual Primitive::Type GetType() const { return Primitive::kPrimLong; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsLongConstant()->value_ == value_;
+  }
+
   DECLARE_INSTRUCTION(LongConstant)
 
  private:
@@ -799,7 +1233,8 @@ class HInvoke : public HInstruction {
           uint32_t number_of_arguments,
           Primitive::Type return_type,
           uint32_t dex_pc)
-    : inputs_(arena, number_of_arguments),
+    : HInstruction(SideEffects::All()),
+      inputs_(arena, number_of_arguments),
       return_type_(return_type),
       dex_pc_(dex_pc) {
     inputs_.SetSize(number_of_arguments);
@@ -812,6 +1247,8 @@ class HInvoke : public HInstruction {
   // know their environment.
   virtual bool NeedsEnvironment() const { return true; }
 
+  virtual bool CanThrow() const { return true; }
+
   void SetArgumentAt(size_t index, HInstruction* argument) {
     SetRawInputAt(index, argument);
   }
@@ -824,6 +1261,8 @@ class HInvoke : public HInstruction {
 
   uint32_t GetDexPc() const { return dex_pc_; }
 
+  virtual HInvoke* AsInvoke() { return this; }
+
  protected:
   GrowableArray<HInstruction*> inputs_;
   const Primitive::Type return_type_;
@@ -853,23 +1292,55 @@ class HInvokeStatic : public HInvoke {
   DISALLOW_COPY_AND_ASSIGN(HInvokeStatic);
 };
 
+class HInvokeVirtual : public HInvoke {
+ public:
+  HInvokeVirtual(ArenaAllocator* arena,
+                 uint32_t number_of_arguments,
+                 Primitive::Type return_type,
+                 uint32_t dex_pc,
+                 uint32_t vtable_index)
+      : HInvoke(arena, number_of_arguments, return_type, dex_pc),
+        vtable_index_(vtable_index) {}
+
+  uint32_t GetVTableIndex() const { return vtable_index_; }
+
+  DECLARE_INSTRUCTION(InvokeVirtual)
+
+ private:
+  const uint32_t vtable_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInvokeVirtual);
+};
+
 class HNewInstance : public HTemplateInstruction<0> {
  public:
-  HNewInstance(uint32_t dex_pc, uint16_t type_index) : dex_pc_(dex_pc), type_index_(type_index) {}
+  HNewInstance(uint32_t dex_pc, uint16_t type_index, bool can_be_removed)
+      : HTemplateInstruction(SideEffects::All()),
+        dex_pc_(dex_pc),
+        type_index_(type_index),
+        can_be_removed_(can_be_removed) {}
 
   uint32_t GetDexPc() const { return dex_pc_; }
   uint16_t GetTypeIndex() const { return type_index_; }
 
+  // Whether the allocation has no effect other than creating the object: the
+  // class is known to be initialized, accessible, instantiable and without a
+  // finalizer. The object can then be removed if it does not escape.
+  bool CanBeRemoved() const { return can_be_removed_; }
+
   virtual Primitive::Type GetType() const { return Primitive::kPrimNot; }
 
   // Calls runtime so needs an environment.
   virtual bool NeedsEnvironment() const { return true; }
 
+  virtual bool CanThrow() const { return true; }
+
   DECLARE_INSTRUCTION(NewInstance)
 
  private:
   const uint32_t dex_pc_;
   const uint16_t type_index_;
+  const bool can_be_removed_;
 
   DISALLOW_COPY_AND_ASSIGN(HNewInstance);
 };
@@ -881,6 +1352,14 @@ class HAdd : public HBinaryOperation {
 
   virtual bool IsCommutative() { return true; }
 
+  // The addition wraps around, like in Java.
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    return static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(y));
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    return static_cast<int64_t>(static_cast<uint64_t>(x) + static_cast<uint64_t>(y));
+  }
+
   DECLARE_INSTRUCTION(Add);
 
  private:
@@ -894,6 +1373,13 @@ class HSub : public HBinaryOperation {
 
   virtual bool IsCommutative() { return false; }
 
+  virtual int32_t Evaluate(int32_t x, int32_t y) const {
+    return static_cast<int32_t>(static_cast<uint32_t>(x) - static_cast<uint32_t>(y));
+  }
+  virtual int64_t Evaluate(int64_t x, int64_t y) const {
+    return static_cast<int64_t>(static_cast<uint64_t>(x) - static_cast<uint64_t>(y));
+  }
+
   DECLARE_INSTRUCTION(Sub);
 
  private:
@@ -905,7 +1391,9 @@ class HSub : public HBinaryOperation {
 class HParameterValue : public HTemplateInstruction<0> {
  public:
   HParameterValue(uint8_t index, Primitive::Type parameter_type)
-      : index_(index), parameter_type_(parameter_type) {}
+      : HTemplateInstruction(SideEffects::None()),
+        index_(index),
+        parameter_type_(parameter_type) {}
 
   uint8_t GetIndex() const { return index_; }
 
@@ -925,12 +1413,15 @@ class HParameterValue : public HTemplateInstruction<0> {
 
 class HNot : public HTemplateInstruction<1> {
  public:
-  explicit HNot(HInstruction* input) {
+  explicit HNot(HInstruction* input) : HTemplateInstruction(SideEffects::None()) {
     SetRawInputAt(0, input);
   }
 
   virtual Primitive::Type GetType() const { return Primitive::kPrimBoolean; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
   DECLARE_INSTRUCTION(Not);
 
  private:
@@ -940,7 +1431,8 @@ class HNot : public HTemplateInstruction<1> {
 class HPhi : public HInstruction {
  public:
   HPhi(ArenaAllocator* arena, uint32_t reg_number, size_t number_of_inputs, Primitive::Type type)
-      : inputs_(arena, number_of_inputs),
+      : HInstruction(SideEffects::None()),
+        inputs_(arena, number_of_inputs),
         reg_number_(reg_number),
         type_(type) {
     inputs_.SetSize(number_of_inputs);
@@ -970,6 +1462,417 @@ class HPhi : public HInstruction {
   DISALLOW_COPY_AND_ASSIGN(HPhi);
 };
 
+class HInstanceFieldGet : public HTemplateInstruction<1> {
+ public:
+  HInstanceFieldGet(HInstruction* value,
+                    Primitive::Type field_type,
+                    MemberOffset field_offset)
+      : HTemplateInstruction(SideEffects::FieldReads()),
+        field_type_(field_type),
+        field_offset_(field_offset) {
+    SetRawInputAt(0, value);
+  }
+
+  MemberOffset GetFieldOffset() const { return field_offset_; }
+  Primitive::Type GetFieldType() const { return field_type_; }
+
+  virtual Primitive::Type GetType() const { return field_type_; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    size_t other_offset = other->AsInstanceFieldGet()->GetFieldOffset().SizeValue();
+    return other_offset == GetFieldOffset().SizeValue();
+  }
+
+  DECLARE_INSTRUCTION(InstanceFieldGet);
+
+ private:
+  const Primitive::Type field_type_;
+  const MemberOffset field_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstanceFieldGet);
+};
+
+class HInstanceFieldSet : public HTemplateInstruction<2> {
+ public:
+  HInstanceFieldSet(HInstruction* object,
+                    HInstruction* value,
+                    Primitive::Type field_type,
+                    MemberOffset field_offset)
+      : HTemplateInstruction(SideEffects::FieldWrites()),
+        field_type_(field_type),
+        field_offset_(field_offset) {
+    SetRawInputAt(0, object);
+    SetRawInputAt(1, value);
+  }
+
+  MemberOffset GetFieldOffset() const { return field_offset_; }
+  Primitive::Type GetFieldType() const { return field_type_; }
+
+  DECLARE_INSTRUCTION(InstanceFieldSet);
+
+ private:
+  const Primitive::Type field_type_;
+  const MemberOffset field_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstanceFieldSet);
+};
+
+class HArrayGet : public HTemplateInstruction<2> {
+ public:
+  HArrayGet(HInstruction* array, HInstruction* index, Primitive::Type type)
+      : HTemplateInstruction(SideEffects::ArrayReads()), type_(type) {
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+  }
+
+  virtual Primitive::Type GetType() const { return type_; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  DECLARE_INSTRUCTION(ArrayGet);
+
+ private:
+  const Primitive::Type type_;
+
+  DISALLOW_COPY_AND_ASSIGN(HArrayGet);
+};
+
+class HArraySet : public HTemplateInstruction<3> {
+ public:
+  HArraySet(HInstruction* array,
+            HInstruction* index,
+            HInstruction* value,
+            Primitive::Type component_type)
+      : HTemplateInstruction(SideEffects::ArrayWrites()), component_type_(component_type) {
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+    SetRawInputAt(2, value);
+  }
+
+  Primitive::Type GetComponentType() const { return component_type_; }
+
+  DECLARE_INSTRUCTION(ArraySet);
+
+ private:
+  const Primitive::Type component_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(HArraySet);
+};
+
+class HArrayLength : public HTemplateInstruction<1> {
+ public:
+  explicit HArrayLength(HInstruction* array) : HTemplateInstruction(SideEffects::None()) {
+    SetRawInputAt(0, array);
+  }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  DECLARE_INSTRUCTION(ArrayLength);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HArrayLength);
+};
+
+class HNullCheck : public HTemplateInstruction<1> {
+ public:
+  HNullCheck(HInstruction* value, uint32_t dex_pc)
+      : HTemplateInstruction(SideEffects::None()), dex_pc_(dex_pc) {
+    SetRawInputAt(0, value);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  virtual bool CanThrow() const { return true; }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimNot; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(NullCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HNullCheck);
+};
+
+class HBoundsCheck : public HTemplateInstruction<2> {
+ public:
+  HBoundsCheck(HInstruction* index, HInstruction* length, uint32_t dex_pc)
+      : HTemplateInstruction(SideEffects::None()), dex_pc_(dex_pc) {
+    DCHECK(index->GetType() == Primitive::kPrimInt);
+    SetRawInputAt(0, index);
+    SetRawInputAt(1, length);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  virtual bool CanThrow() const { return true; }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(BoundsCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HBoundsCheck);
+};
+
+/**
+ * Base class of the instructions the vectorizer inserts before a counted loop,
+ * to process the int elements [from, to) of arrays several elements at a
+ * time. `from` is a non-negative constant, `to` is input 0 and the other
+ * inputs are the arrays, and the value of a fill. Elements are only processed
+ * if all the arrays are non null and have at least `to` elements. The
+ * instruction returns the index of the first element it did not process:
+ * `from` if the arrays could not be accessed, the greater of `from` and `to`
+ * otherwise. The loop then only processes the remaining elements, and throws
+ * if an array cannot be accessed.
+ */
+template <intptr_t N>
+class HVecArrayOperation : public HTemplateInstruction<N> {
+ public:
+  HVecArrayOperation(int32_t from, HInstruction* to)
+      : HTemplateInstruction<N>(SideEffects::ArrayWrites().Union(SideEffects::ArrayReads())),
+        from_(from) {
+    DCHECK_GE(from, 0);
+    this->SetRawInputAt(0, to);
+  }
+
+  int32_t GetFrom() const { return from_; }
+  HInstruction* GetTo() const { return this->InputAt(0); }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+ private:
+  const int32_t from_;
+
+  DISALLOW_COPY_AND_ASSIGN(HVecArrayOperation);
+};
+
+// Stores `value` in the elements of `array`.
+class HVecFill : public HVecArrayOperation<3> {
+ public:
+  HVecFill(int32_t from, HInstruction* to, HInstruction* array, HInstruction* value)
+      : HVecArrayOperation(from, to) {
+    SetRawInputAt(1, array);
+    SetRawInputAt(2, value);
+  }
+
+  HInstruction* GetArray() const { return InputAt(1); }
+  HInstruction* GetValue() const { return InputAt(2); }
+
+  DECLARE_INSTRUCTION(VecFill);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecFill);
+};
+
+// Copies the elements of `source` to `destination`.
+class HVecCopy : public HVecArrayOperation<3> {
+ public:
+  HVecCopy(int32_t from, HInstruction* to, HInstruction* destination, HInstruction* source)
+      : HVecArrayOperation(from, to) {
+    SetRawInputAt(1, destination);
+    SetRawInputAt(2, source);
+  }
+
+  HInstruction* GetDestination() const { return InputAt(1); }
+  HInstruction* GetSource() const { return InputAt(2); }
+
+  DECLARE_INSTRUCTION(VecCopy);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecCopy);
+};
+
+// Stores the result of an operation on the elements of `left` and `right` in
+// the elements of `destination`.
+class HVecBinaryOperation : public HVecArrayOperation<4> {
+ public:
+  HVecBinaryOperation(int32_t from,
+                      HInstruction* to,
+                      HInstruction* destination,
+                      HInstruction* left,
+                      HInstruction* right)
+      : HVecArrayOperation(from, to) {
+    SetRawInputAt(1, destination);
+    SetRawInputAt(2, left);
+    SetRawInputAt(3, right);
+  }
+
+  HInstruction* GetDestination() const { return InputAt(1); }
+  HInstruction* GetLeft() const { return InputAt(2); }
+  HInstruction* GetRight() const { return InputAt(3); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecBinaryOperation);
+};
+
+class HVecAdd : public HVecBinaryOperation {
+ public:
+  HVecAdd(int32_t from,
+          HInstruction* to,
+          HInstruction* destination,
+          HInstruction* left,
+          HInstruction* right)
+      : HVecBinaryOperation(from, to, destination, left, right) {}
+
+  DECLARE_INSTRUCTION(VecAdd);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecAdd);
+};
+
+class HVecSub : public HVecBinaryOperation {
+ public:
+  HVecSub(int32_t from,
+          HInstruction* to,
+          HInstruction* destination,
+          HInstruction* left,
+          HInstruction* right)
+      : HVecBinaryOperation(from, to, destination, left, right) {}
+
+  DECLARE_INSTRUCTION(VecSub);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecSub);
+};
+
+// Returns the sum of all the elements of `array`, an int array that is known
+// to be non null. The sum wraps around like the additions it replaces.
+class HVecSum : public HTemplateInstruction<1> {
+ public:
+  explicit HVecSum(HInstruction* array) : HTemplateInstruction(SideEffects::ArrayReads()) {
+    SetRawInputAt(0, array);
+  }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  DECLARE_INSTRUCTION(VecSum);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecSum);
+};
+
+/**
+ * Some DEX instructions are folded into multiple HInstructions that need
+ * to stay live until the last HInstruction. This class
+ * is used as a marker for the baseline compiler to ensure its preceding
+ * HInstruction stays live. `index` is the temporary number that is used
+ * for knowing the stack offset where to store the instruction.
+ */
+class HTemporary : public HTemplateInstruction<0> {
+ public:
+  explicit HTemporary(size_t index) : HTemplateInstruction(SideEffects::None()), index_(index) {}
+
+  size_t GetIndex() const { return index_; }
+
+  DECLARE_INSTRUCTION(Temporary);
+
+ private:
+  const size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTemporary);
+};
+
+class MoveOperands : public ArenaObject {
+ public:
+  MoveOperands(Location source, Location destination)
+      : source_(source), destination_(destination) {}
+
+  Location GetSource() const { return source_; }
+  Location GetDestination() const { return destination_; }
+
+  void SetSource(Location value) { source_ = value; }
+  void SetDestination(Location value) { destination_ = value; }
+
+  // The parallel move resolver marks moves as "in-progress" by clearing the
+  // destination (but not the source).
+  Location MarkPending() {
+    DCHECK(!IsPending());
+    Location dest = destination_;
+    destination_ = Location();
+    return dest;
+  }
+
+  void ClearPending(Location dest) {
+    DCHECK(IsPending());
+    destination_ = dest;
+  }
+
+  bool IsPending() const {
+    DCHECK(source_.IsValid() || !destination_.IsValid());
+    return !destination_.IsValid() && source_.IsValid();
+  }
+
+  // True if this blocks a move from the given location.
+  bool Blocks(Location loc) const {
+    return !IsEliminated() && source_.Equals(loc);
+  }
+
+  // A move is redundant if it's been eliminated, if its source and
+  // destination are the same, or if its destination is unneeded.
+  bool IsRedundant() const {
+    return IsEliminated() || !destination_.IsValid() || source_.Equals(destination_);
+  }
+
+  // We clear both operands to indicate move that's been eliminated.
+  void Eliminate() {
+    source_ = destination_ = Location();
+  }
+
+  bool IsEliminated() const {
+    DCHECK(source_.IsValid() || !destination_.IsValid());
+    return !source_.IsValid();
+  }
+
+ private:
+  Location source_;
+  Location destination_;
+
+  DISALLOW_COPY_AND_ASSIGN(MoveOperands);
+};
+
+// A set of moves inserted by the register allocator, that must be performed
+// as if they all happened at the same time.
+class HParallelMove : public HTemplateInstruction<0> {
+ public:
+  explicit HParallelMove(ArenaAllocator* arena)
+      : HTemplateInstruction(SideEffects::None()), moves_(arena, kDefaultNumberOfMoves) {}
+
+  void AddMove(MoveOperands* move) {
+    moves_.Add(move);
+  }
+
+  MoveOperands* MoveOperandsAt(size_t index) const {
+    return moves_.Get(index);
+  }
+
+  size_t NumMoves() const { return moves_.Size(); }
+
+  DECLARE_INSTRUCTION(ParallelMove)
+
+ private:
+  GrowableArray<MoveOperands*> moves_;
+
+  DISALLOW_COPY_AND_ASSIGN(HParallelMove);
+};
+
 class HGraphVisitor : public ValueObject {
  public:
   explicit HGraphVisitor(HGraph* graph) : graph_(graph) { }
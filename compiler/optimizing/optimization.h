@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
+#define ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
+
+#include "nodes.h"
+
+namespace art {
+
+class TimingLogger;
+
+/**
+ * Abstraction to implement an optimization pass on an `HGraph` in SSA form.
+ */
+class HOptimization : public ValueObject {
+ public:
+  HOptimization(HGraph* graph, const char* pass_name)
+      : graph_(graph), pass_name_(pass_name) {}
+
+  virtual ~HOptimization() {}
+
+  // Return the name of the pass, used for timings.
+  const char* GetPassName() const { return pass_name_; }
+
+  // Perform the analysis itself.
+  virtual void Run() = 0;
+
+ protected:
+  HGraph* const graph_;
+
+ private:
+  const char* const pass_name_;
+
+  DISALLOW_COPY_AND_ASSIGN(HOptimization);
+};
+
+/**
+ * Runs a list of optimization passes in order. If given a `TimingLogger`,
+ * each pass is recorded in its own split.
+ */
+class HPassManager : public ValueObject {
+ public:
+  HPassManager(ArenaAllocator* allocator, TimingLogger* timings)
+      : passes_(allocator, kDefaultNumberOfPasses), timings_(timings) {}
+
+  void AddPass(HOptimization* pass) {
+    passes_.Add(pass);
+  }
+
+  void RunPasses();
+
+ private:
+  static constexpr size_t kDefaultNumberOfPasses = 8;
+
+  GrowableArray<HOptimization*> passes_;
+  TimingLogger* const timings_;
+
+  DISALLOW_COPY_AND_ASSIGN(HPassManager);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_OPTIMIZATION_H_
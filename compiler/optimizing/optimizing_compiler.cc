@@ -16,14 +16,25 @@
 
 #include <stdint.h>
 
+#include "base/arena_allocator.h"
+#include "base/timing_logger.h"
+#include "bounds_check_elimination.h"
 #include "builder.h"
 #include "code_generator.h"
 #include "compilers.h"
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
 #include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
+#include "gvn.h"
+#include "inliner.h"
+#include "licm.h"
 #include "nodes.h"
+#include "optimization.h"
+#include "register_allocator.h"
+#include "scalar_replacement.h"
 #include "ssa_liveness_analysis.h"
-#include "utils/arena_allocator.h"
+#include "vectorizer.h"
 
 namespace art {
 
@@ -50,6 +61,36 @@ class CodeVectorAllocator FINAL : public CodeAllocator {
   DISALLOW_COPY_AND_ASSIGN(CodeVectorAllocator);
 };
 
+/**
+ * Run the optimization passes on a graph in SSA form. Each pass gets a split
+ * in `timings`, if not null.
+ */
+static void RunOptimizations(HGraph* graph,
+                             CompilerDriver* driver,
+                             const DexCompilationUnit& dex_compilation_unit,
+                             TimingLogger* timings) {
+  HInliner inliner(graph, dex_compilation_unit, driver);
+  HScalarReplacement scalar_replacement(graph);
+  HConstantFolding constant_folding(graph);
+  GlobalValueNumberer global_value_numbering(graph->GetArena(), graph);
+  LICM licm(graph);
+  BoundsCheckElimination bounds_check_elimination(graph);
+  HVectorizer vectorizer(graph, driver->GetInstructionSet(), driver->GetInstructionSetFeatures());
+  HDeadCodeElimination dead_code_elimination(graph);
+
+  HPassManager pass_manager(graph->GetArena(), timings);
+  pass_manager.AddPass(&inliner);
+  pass_manager.AddPass(&scalar_replacement);
+  pass_manager.AddPass(&constant_folding);
+  pass_manager.AddPass(&global_value_numbering);
+  pass_manager.AddPass(&licm);
+  pass_manager.AddPass(&bounds_check_elimination);
+  pass_manager.AddPass(&vectorizer);
+  // Remove the inputs of folded instructions, and values no longer used.
+  pass_manager.AddPass(&dead_code_elimination);
+  pass_manager.RunPasses();
+}
+
 
 CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_item,
                                                uint32_t access_flags,
@@ -69,7 +110,7 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
 
   ArenaPool pool;
   ArenaAllocator arena(&pool);
-  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file);
+  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
   HGraph* graph = builder.BuildGraph(*code_item);
   if (graph == nullptr) {
     if (shouldCompile) {
@@ -92,7 +133,40 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
   }
 
   CodeVectorAllocator allocator;
-  codegen->Compile(&allocator);
+  if (RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set)) {
+    graph->BuildDominatorTree();
+    graph->TransformToSSA();
+
+    bool dump_passes = GetCompilerDriver()->GetDumpPasses();
+    TimingLogger timings("OptimizingCompiler", true, false);
+    RunOptimizations(graph, GetCompilerDriver(), dex_compilation_unit,
+                     dump_passes ? &timings : nullptr);
+    if (dump_passes) {
+      GetCompilerDriver()->GetTimingsLogger()->AddLogger(timings);
+    }
+
+    graph->SplitCriticalEdges();
+    SsaLivenessAnalysis liveness(*graph);
+    liveness.Analyze();
+    RegisterAllocator register_allocator(graph->GetArena(), codegen, liveness);
+    if (register_allocator.AllocateRegisters()) {
+      codegen->CompileOptimized(&allocator, liveness.GetLinearOrder());
+    } else {
+      // The graph has been modified, build it again for the baseline compiler.
+      HGraphBuilder baseline_builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
+      graph = baseline_builder.BuildGraph(*code_item);
+      DCHECK(graph != nullptr);
+      codegen = CodeGenerator::Create(&arena, graph, instruction_set);
+      codegen->CompileBaseline(&allocator);
+    }
+  } else {
+    codegen->CompileBaseline(&allocator);
+
+    // Run these phases to get some test coverage.
+    graph->BuildDominatorTree();
+    graph->TransformToSSA();
+    SsaLivenessAnalysis(*graph).Analyze();
+  }
 
   std::vector<uint8_t> mapping_table;
   codegen->BuildMappingTable(&mapping_table);
@@ -101,11 +175,6 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
   std::vector<uint8_t> gc_map;
   codegen->BuildNativeGCMap(&gc_map, dex_compilation_unit);
 
-  // Run these phases to get some test coverage.
-  graph->BuildDominatorTree();
-  graph->TransformToSSA();
-  SsaLivenessAnalysis(*graph).Analyze();
-
   return new CompiledMethod(GetCompilerDriver(),
                             instruction_set,
                             allocator.GetMemory(),
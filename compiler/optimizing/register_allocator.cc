@@ -0,0 +1,958 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "register_allocator.h"
+
+#include "code_generator.h"
+#include "ssa_liveness_analysis.h"
+
+namespace art {
+
+static constexpr size_t kMaxLifetimePosition = -1;
+static constexpr size_t kDefaultNumberOfSpillSlots = 4;
+static constexpr size_t kNoGcMapIndex = -1;
+
+RegisterAllocator::RegisterAllocator(ArenaAllocator* allocator,
+                                     CodeGenerator* codegen,
+                                     const SsaLivenessAnalysis& liveness)
+      : allocator_(allocator),
+        codegen_(codegen),
+        liveness_(liveness),
+        unhandled_(allocator, 0),
+        handled_(allocator, 0),
+        active_(allocator, 0),
+        inactive_(allocator, 0),
+        physical_register_intervals_(allocator, codegen->GetNumberOfCoreRegisters()),
+        temp_intervals_(allocator, 4),
+        spill_slots_(allocator, kDefaultNumberOfSpillSlots),
+        safepoints_(allocator, 0),
+        number_of_registers_(codegen->GetNumberOfCoreRegisters()),
+        registers_array_(static_cast<size_t*>(
+            allocator->Alloc(number_of_registers_ * sizeof(size_t), kArenaAllocRegAlloc))),
+        blocked_registers_(static_cast<bool*>(allocator->Alloc(
+            codegen->GetNumberOfRegisters() * sizeof(bool), kArenaAllocRegAlloc))),
+        allocation_failed_(false) {
+  for (size_t i = 0, e = codegen->GetNumberOfRegisters(); i < e; ++i) {
+    blocked_registers_[i] = false;
+  }
+  codegen->SetupBlockedRegisters(blocked_registers_);
+  physical_register_intervals_.SetSize(number_of_registers_);
+}
+
+static bool IsSupportedType(Primitive::Type type) {
+  // Register pairs and floating point registers are not modeled yet.
+  return type != Primitive::kPrimLong
+      && type != Primitive::kPrimFloat
+      && type != Primitive::kPrimDouble;
+}
+
+bool RegisterAllocator::CanAllocateRegistersFor(const HGraph& graph,
+                                                InstructionSet instruction_set) {
+  if (instruction_set != kArm
+      && instruction_set != kThumb2
+      && instruction_set != kX86
+      && instruction_set != kX86_64) {
+    return false;
+  }
+  for (size_t i = 0, e = graph.GetBlocks().Size(); i < e; ++i) {
+    HBasicBlock* block = graph.GetBlocks().Get(i);
+    for (HInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
+      if (!IsSupportedType(it.Current()->GetType())) {
+        return false;
+      }
+    }
+    for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
+      if (!IsSupportedType(it.Current()->GetType())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool RegisterAllocator::AllocateRegisters() {
+  const GrowableArray<HBasicBlock*>& linear_order = liveness_.GetLinearOrder();
+
+  // Ask the code generator for the constraints of each instruction. Constants
+  // are usually generated at their use sites by the baseline compiler, here
+  // they are values like any other.
+  HGraphVisitor* location_builder = codegen_->GetLocationBuilder();
+  for (size_t i = 0, e = linear_order.Size(); i < e; ++i) {
+    HBasicBlock* block = linear_order.Get(i);
+    for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
+      it.Current()->Accept(location_builder);
+    }
+    for (HInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* current = it.Current();
+      current->Accept(location_builder);
+      if (current->GetLocations() == nullptr && current->AsIntConstant() != nullptr) {
+        LocationSummary* locations = new (allocator_) LocationSummary(current);
+        locations->SetOut(Location::Any());
+        current->SetLocations(locations);
+      }
+    }
+  }
+
+  // Iterate backward so that intervals are added to the unhandled list in
+  // decreasing order of their start, and ranges of fixed intervals are added
+  // in decreasing order of position.
+  for (size_t i = linear_order.Size(); i > 0; --i) {
+    HBasicBlock* block = linear_order.Get(i - 1);
+    for (HBackwardInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
+      ProcessInstruction(it.Current());
+    }
+    for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
+      ProcessInstruction(it.Current());
+    }
+  }
+
+  LinearScan();
+  if (allocation_failed_) {
+    return false;
+  }
+  if (kIsDebugBuild) {
+    Validate(true);
+  }
+  return Resolve();
+}
+
+void RegisterAllocator::BlockRegister(Location location, size_t start, size_t end) {
+  int reg = location.reg().RegId();
+  DCHECK_LT(static_cast<size_t>(reg), number_of_registers_);
+  LiveInterval* interval = physical_register_intervals_.Get(reg);
+  if (interval == nullptr) {
+    interval = LiveInterval::MakeFixedInterval(allocator_, reg, Primitive::kPrimInt);
+    physical_register_intervals_.Put(reg, interval);
+    inactive_.Add(interval);
+  }
+  DCHECK_EQ(interval->GetRegister(), reg);
+  interval->AddRange(start, end);
+}
+
+void RegisterAllocator::ProcessInstruction(HInstruction* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  size_t position = instruction->GetLifetimePosition();
+
+  if (locations == nullptr) return;
+
+  // Create synthesized intervals for temporaries.
+  for (size_t i = 0; i < locations->GetTempCount(); ++i) {
+    Location temp = locations->GetTemp(i);
+    if (temp.IsRegister()) {
+      BlockRegister(temp, position, position + 1);
+    } else {
+      LiveInterval* interval =
+          LiveInterval::MakeTempInterval(allocator_, instruction, Primitive::kPrimInt);
+      temp_intervals_.Add(interval);
+      interval->AddRange(position, position + 1);
+      AddToUnhandled(interval);
+    }
+  }
+
+  if (locations->WillCall()) {
+    // Block all registers: values live across the call end up in a stack slot,
+    // where the GC can find them.
+    for (size_t i = 0; i < number_of_registers_; ++i) {
+      BlockRegister(Location::RegisterLocation(ManagedRegister(i)), position, position + 1);
+    }
+    safepoints_.Add(instruction);
+  }
+
+  for (size_t i = 0; i < instruction->InputCount(); ++i) {
+    Location input = locations->InAt(i);
+    if (input.IsRegister() || input.IsStackSlot()) {
+      if (input.IsRegister()) {
+        BlockRegister(input, position, position + 1);
+      }
+      // The value is moved to its fixed location just before the instruction. If
+      // this is its last use, and all its uses here are fixed, it does not need to
+      // be live while the instruction executes.
+      LiveInterval* interval = instruction->InputAt(i)->GetLiveInterval();
+      if (interval->GetEnd() == position + 1) {
+        bool only_fixed_uses = true;
+        for (size_t j = 0; j < instruction->InputCount(); ++j) {
+          if (instruction->InputAt(j) == instruction->InputAt(i)
+              && locations->InAt(j).IsUnallocated()) {
+            only_fixed_uses = false;
+          }
+        }
+        if (only_fixed_uses) {
+          interval->SetTo(position);
+        }
+      }
+    }
+  }
+
+  LiveInterval* current = instruction->GetLiveInterval();
+  if (current == nullptr) {
+    if (instruction->AsPhi() != nullptr) {
+      return;
+    }
+    Location output = locations->Out();
+    if (output.IsUnallocated()) {
+      // The instruction has no uses, but the code generator still needs a
+      // location for its output.
+      current = new (allocator_) LiveInterval(allocator_, instruction->GetType(), instruction);
+      current->AddRange(position, position + 1);
+      instruction->SetLiveInterval(current);
+    } else {
+      if (output.IsRegister()) {
+        BlockRegister(output, position, position + 1);
+      }
+      return;
+    }
+  }
+
+  Location output = locations->Out();
+  if (output.IsUnallocated()
+      && output.GetPolicy() == Location::kSameAsFirstInput
+      && locations->InAt(0).IsRegister()) {
+    locations->SetOut(locations->InAt(0));
+    output = locations->Out();
+  }
+
+  if (output.IsRegister() || output.IsStackSlot()) {
+    if (output.IsRegister()) {
+      // Parameters are in their register from the method entry.
+      size_t start = instruction->AsParameterValue() != nullptr ? 0 : position;
+      BlockRegister(output, start, position + 1);
+    }
+    // The output is moved to the location of the interval right after the
+    // instruction.
+    current->SetFrom(position + 1);
+  }
+
+  AddToUnhandled(current);
+}
+
+void RegisterAllocator::AddToUnhandled(LiveInterval* interval) {
+  size_t insert_at = 0;
+  for (size_t i = unhandled_.Size(); i > 0; --i) {
+    LiveInterval* current = unhandled_.Get(i - 1);
+    if (current->StartsAfter(interval)) {
+      insert_at = i;
+      break;
+    }
+  }
+  unhandled_.InsertAt(insert_at, interval);
+}
+
+// By the book implementation of a linear scan register allocator.
+void RegisterAllocator::LinearScan() {
+  while (!unhandled_.IsEmpty()) {
+    // (1) Remove interval with the lowest start position from unhandled.
+    LiveInterval* current = unhandled_.Pop();
+    DCHECK(!current->IsFixed() && !current->HasRegister());
+    size_t position = current->GetStart();
+
+    // (2) Remove currently active intervals that are dead at this position.
+    //     Move active intervals that have a lifetime hole at this position
+    //     to inactive.
+    for (size_t i = 0; i < active_.Size(); ++i) {
+      LiveInterval* interval = active_.Get(i);
+      if (interval->IsDeadAt(position)) {
+        active_.Delete(interval);
+        --i;
+        handled_.Add(interval);
+      } else if (!interval->Covers(position)) {
+        active_.Delete(interval);
+        --i;
+        inactive_.Add(interval);
+      }
+    }
+
+    // (3) Remove currently inactive intervals that are dead at this position.
+    //     Move inactive intervals that cover this position to active.
+    for (size_t i = 0; i < inactive_.Size(); ++i) {
+      LiveInterval* interval = inactive_.Get(i);
+      if (interval->IsDeadAt(position)) {
+        inactive_.Delete(interval);
+        --i;
+        handled_.Add(interval);
+      } else if (interval->Covers(position)) {
+        inactive_.Delete(interval);
+        --i;
+        active_.Add(interval);
+      }
+    }
+
+    // (4) Try to find an available register.
+    bool success = TryAllocateFreeReg(current);
+
+    // (5) If no register could be found, we need to spill.
+    if (!success) {
+      success = AllocateBlockedReg(current);
+      if (allocation_failed_) {
+        return;
+      }
+    }
+
+    // (6) If the interval had a register allocated, add it to the list of active
+    //     intervals.
+    if (success) {
+      active_.Add(current);
+    } else {
+      handled_.Add(current);
+    }
+  }
+}
+
+bool RegisterAllocator::IsBlocked(int reg) const {
+  return blocked_registers_[reg];
+}
+
+// Find a free register. If multiple are found, pick the register that
+// is free the longest.
+bool RegisterAllocator::TryAllocateFreeReg(LiveInterval* current) {
+  size_t* free_until = registers_array_;
+
+  // First set all registers to be free.
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    free_until[i] = kMaxLifetimePosition;
+  }
+
+  // For each active interval, set its register to not free.
+  for (size_t i = 0, e = active_.Size(); i < e; ++i) {
+    LiveInterval* interval = active_.Get(i);
+    DCHECK(interval->HasRegister());
+    free_until[interval->GetRegister()] = 0;
+  }
+
+  // For each inactive interval, set its register to be free until
+  // the next intersection with `current`.
+  for (size_t i = 0, e = inactive_.Size(); i < e; ++i) {
+    LiveInterval* inactive = inactive_.Get(i);
+    DCHECK(inactive->HasRegister());
+    size_t next_intersection = inactive->FirstIntersectionWith(current);
+    if (next_intersection != kNoLifetime) {
+      free_until[inactive->GetRegister()] =
+          std::min(free_until[inactive->GetRegister()], next_intersection);
+    }
+  }
+
+  int reg = -1;
+  // If the instruction defines its output in a fixed register, try to keep
+  // the value in that register to avoid a move.
+  HInstruction* defined_by = current->GetDefinedBy();
+  if (defined_by != nullptr && !current->IsTemp()) {
+    Location output = defined_by->GetLocations()->Out();
+    if (output.IsRegister()) {
+      int hint = output.reg().RegId();
+      if (free_until[hint] >= current->GetEnd()) {
+        reg = hint;
+      }
+    }
+  }
+
+  if (reg == -1) {
+    // Pick the register that is free the longest.
+    for (size_t i = 0; i < number_of_registers_; ++i) {
+      if (IsBlocked(i)) continue;
+      if (reg == -1 || free_until[i] > free_until[reg]) {
+        reg = i;
+        if (free_until[i] == kMaxLifetimePosition) break;
+      }
+    }
+  }
+
+  // If we could not find a register, we need to spill.
+  if (reg == -1 || free_until[reg] <= current->GetStart()) {
+    return false;
+  }
+
+  current->SetRegister(reg);
+  if (!current->IsDeadAt(free_until[reg])) {
+    // If the register is only available for a subset of live ranges
+    // covered by `current`, split `current` at the position where
+    // the register is not available anymore.
+    LiveInterval* split = Split(current, free_until[reg]);
+    DCHECK(split != nullptr);
+    AddToUnhandled(split);
+  }
+  return true;
+}
+
+// Find the register that is used the last, and spill the interval
+// that holds it. If the first use of `current` is after that register
+// we spill `current` instead.
+bool RegisterAllocator::AllocateBlockedReg(LiveInterval* current) {
+  size_t first_register_use = current->FirstRegisterUse();
+  if (first_register_use == kNoLifetime) {
+    AllocateSpillSlotFor(current);
+    return false;
+  }
+
+  // First set all registers as not being used.
+  size_t* next_use = registers_array_;
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    next_use[i] = kMaxLifetimePosition;
+  }
+
+  // For each active interval, find the next use of its register after the
+  // start of current.
+  for (size_t i = 0, e = active_.Size(); i < e; ++i) {
+    LiveInterval* active = active_.Get(i);
+    DCHECK(active->HasRegister());
+    if (active->IsFixed()) {
+      next_use[active->GetRegister()] = current->GetStart();
+    } else {
+      size_t use = active->FirstRegisterUseAfter(current->GetStart());
+      if (use != kNoLifetime) {
+        next_use[active->GetRegister()] = std::min(use, next_use[active->GetRegister()]);
+      }
+    }
+  }
+
+  // For each inactive interval, find the next use of its register after the
+  // start of current.
+  for (size_t i = 0, e = inactive_.Size(); i < e; ++i) {
+    LiveInterval* inactive = inactive_.Get(i);
+    DCHECK(inactive->HasRegister());
+    size_t next_intersection = inactive->FirstIntersectionWith(current);
+    if (next_intersection != kNoLifetime) {
+      if (inactive->IsFixed()) {
+        next_use[inactive->GetRegister()] =
+            std::min(next_intersection, next_use[inactive->GetRegister()]);
+      } else {
+        size_t use = inactive->FirstRegisterUseAfter(current->GetStart());
+        if (use != kNoLifetime) {
+          next_use[inactive->GetRegister()] = std::min(use, next_use[inactive->GetRegister()]);
+        }
+      }
+    }
+  }
+
+  // Pick the register that is used the last.
+  int reg = -1;
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    if (IsBlocked(i)) continue;
+    if (reg == -1 || next_use[i] > next_use[reg]) {
+      reg = i;
+      if (next_use[i] == kMaxLifetimePosition) break;
+    }
+  }
+  DCHECK_NE(reg, -1);
+
+  if (first_register_use >= next_use[reg]) {
+    if (first_register_use == current->GetStart()) {
+      // All registers are used by other intervals at the position where
+      // `current` needs one: the constraints of the instruction cannot be met.
+      allocation_failed_ = true;
+      return false;
+    }
+    // If the first use of that instruction is after the last use of the found
+    // register, we split this interval just before its first register use.
+    AllocateSpillSlotFor(current);
+    LiveInterval* split = Split(current, first_register_use);
+    AddToUnhandled(split);
+    return false;
+  } else {
+    // Use this register and spill the active and inactive intervals that
+    // have that register.
+    current->SetRegister(reg);
+
+    for (size_t i = 0, e = active_.Size(); i < e; ++i) {
+      LiveInterval* active = active_.Get(i);
+      if (active->GetRegister() == reg) {
+        DCHECK(!active->IsFixed());
+        LiveInterval* split = Split(active, current->GetStart());
+        active_.Delete(active);
+        if (split != active) {
+          handled_.Add(active);
+        }
+        AddToUnhandled(split);
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < inactive_.Size(); ++i) {
+      LiveInterval* inactive = inactive_.Get(i);
+      if (inactive->GetRegister() == reg) {
+        size_t next_intersection = inactive->FirstIntersectionWith(current);
+        if (next_intersection == kNoLifetime) {
+          continue;
+        }
+        if (inactive->IsFixed()) {
+          // The register is blocked at that position: `current` must be somewhere
+          // else from there.
+          LiveInterval* split = Split(current, next_intersection);
+          AddToUnhandled(split);
+        } else {
+          LiveInterval* split = Split(inactive, current->GetStart());
+          inactive_.Delete(inactive);
+          --i;
+          handled_.Add(inactive);
+          AddToUnhandled(split);
+        }
+      }
+    }
+
+    return true;
+  }
+}
+
+LiveInterval* RegisterAllocator::Split(LiveInterval* interval, size_t position) {
+  DCHECK(position >= interval->GetStart());
+  DCHECK(!interval->IsDeadAt(position));
+  if (position == interval->GetStart()) {
+    // Spill slot will be allocated when handling `interval` again.
+    interval->ClearRegister();
+    return interval;
+  } else {
+    LiveInterval* new_interval = interval->SplitAt(position);
+    return new_interval;
+  }
+}
+
+void RegisterAllocator::AllocateSpillSlotFor(LiveInterval* interval) {
+  LiveInterval* parent = interval->GetParent();
+
+  // An instruction gets a spill slot for its entire lifetime. If the parent
+  // of this interval already has a spill slot, there is nothing to do.
+  if (parent->HasSpillSlot()) {
+    return;
+  }
+
+  // Parameters already have a stack slot, in the frame of the caller.
+  if (parent->GetDefinedBy()->AsParameterValue() != nullptr) {
+    return;
+  }
+
+  LiveInterval* last_sibling = interval;
+  while (last_sibling->GetNextSibling() != nullptr) {
+    last_sibling = last_sibling->GetNextSibling();
+  }
+  size_t end = last_sibling->GetEnd();
+
+  // Find an available spill slot.
+  size_t slot = 0;
+  for (size_t e = spill_slots_.Size(); slot < e; ++slot) {
+    if (spill_slots_.Get(slot) <= parent->GetStart()) {
+      break;
+    }
+  }
+
+  if (slot == spill_slots_.Size()) {
+    // We need a new spill slot.
+    spill_slots_.Add(end);
+  } else {
+    spill_slots_.Put(slot, end);
+  }
+
+  parent->SetSpillSlot(slot);
+}
+
+Location RegisterAllocator::ConvertToLocation(LiveInterval* interval) const {
+  if (interval->HasRegister()) {
+    return Location::RegisterLocation(ManagedRegister(interval->GetRegister()));
+  }
+  LiveInterval* parent = interval->GetParent();
+  HParameterValue* parameter = parent->GetDefinedBy()->AsParameterValue();
+  if (parameter != nullptr) {
+    return Location::StackSlot(codegen_->GetStackSlotOfParameter(parameter));
+  }
+  DCHECK(parent->HasSpillSlot());
+  return Location::StackSlot(codegen_->GetSpillSlotOffset(parent->GetSpillSlot()));
+}
+
+bool RegisterAllocator::Resolve() {
+  // Spill slots below the number of dex registers reuse the area where the
+  // baseline compiler stores dex registers, so that the GC map can describe them.
+  size_t number_of_locals =
+      codegen_->GetGraph()->GetNumberOfVRegs() - codegen_->GetGraph()->GetNumberOfInVRegs();
+  codegen_->ComputeFrameSize(std::max(spill_slots_.Size(), number_of_locals));
+
+  // Set the locations of the inputs, temporaries and outputs of each instruction.
+  for (size_t i = 0, e = liveness_.GetMaxLifetimePosition(); i < e; i += 2) {
+    HInstruction* instruction = liveness_.GetInstructionFromPosition(i);
+    if (instruction == nullptr || instruction->GetLocations() == nullptr) {
+      continue;
+    }
+    LocationSummary* locations = instruction->GetLocations();
+    size_t position = instruction->GetLifetimePosition();
+    bool same_as_first_input = locations->Out().IsUnallocated()
+        && locations->Out().GetPolicy() == Location::kSameAsFirstInput;
+
+    for (size_t j = 0, f = instruction->InputCount(); j < f; ++j) {
+      Location location = locations->InAt(j);
+      LiveInterval* interval = instruction->InputAt(j)->GetLiveInterval();
+      if (j == 0 && same_as_first_input) {
+        // Handled with the output.
+        continue;
+      } else if (location.IsUnallocated()) {
+        locations->SetInAt(j, ConvertToLocation(interval->GetSiblingAt(position)));
+      } else if (location.IsValid()) {
+        // The instruction requires the value in a fixed location: move it there
+        // just before the instruction.
+        Location source = ConvertToLocation(interval->GetSiblingAt(position - 1));
+        InsertParallelMoveAt(position - 1, source, location);
+      }
+    }
+
+    LiveInterval* current = instruction->GetLiveInterval();
+    if (current == nullptr) {
+      continue;
+    }
+    Location output = locations->Out();
+    if (instruction->AsParameterValue() != nullptr && output.IsStackSlot()) {
+      // Now that we know the frame size, adjust the parameter's location.
+      output = Location::StackSlot(output.GetStackIndex() + codegen_->GetFrameSize());
+      locations->SetOut(output);
+    }
+    Location destination = ConvertToLocation(current);
+    if (output.IsUnallocated()) {
+      if (same_as_first_input) {
+        // Move the first input to the output location, the instruction then
+        // works in place.
+        LiveInterval* input = instruction->InputAt(0)->GetLiveInterval();
+        Location source = ConvertToLocation(input->GetSiblingAt(position - 1));
+        InsertParallelMoveAt(position - 1, source, destination);
+        locations->SetInAt(0, destination);
+      }
+      locations->SetOut(destination);
+    } else {
+      // The instruction defines its output in a fixed location: move it to the
+      // location of its interval right after the instruction.
+      InsertParallelMoveAt(position, output, destination);
+    }
+  }
+
+  // Assign the registers of temporaries, in the order they were created.
+  for (size_t i = 0, e = temp_intervals_.Size(); i < e; ++i) {
+    LiveInterval* temp = temp_intervals_.Get(i);
+    LocationSummary* locations = temp->GetDefinedBy()->GetLocations();
+    for (size_t j = 0, f = locations->GetTempCount(); j < f; ++j) {
+      if (locations->GetTemp(j).IsUnallocated()) {
+        locations->SetTempAt(j, ConvertToLocation(temp));
+        break;
+      }
+    }
+  }
+
+  // Set the output location of phis. Their inputs are moved on the edges.
+  const GrowableArray<HBasicBlock*>& linear_order = liveness_.GetLinearOrder();
+  for (size_t i = 0, e = linear_order.Size(); i < e; ++i) {
+    HBasicBlock* block = linear_order.Get(i);
+    for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
+      HInstruction* phi = it.Current();
+      if (phi->GetLiveInterval() != nullptr) {
+        phi->GetLocations()->SetOut(ConvertToLocation(phi->GetLiveInterval()));
+      }
+    }
+  }
+
+  // Connect siblings within blocks.
+  for (size_t i = 0, e = liveness_.GetNumberOfSsaValues(); i < e; ++i) {
+    ConnectSiblings(liveness_.GetInstructionFromSsaIndex(i)->GetLiveInterval());
+  }
+
+  // Resolve non-linear control flow across branches, and the inputs of phis.
+  for (size_t i = 0, e = linear_order.Size(); i < e; ++i) {
+    HBasicBlock* block = linear_order.Get(i);
+    for (size_t j = 0, f = block->GetSuccessors()->Size(); j < f; ++j) {
+      HBasicBlock* successor = block->GetSuccessors()->Get(j);
+      BitVector::Iterator iterator(liveness_.GetLiveInSet(*successor));
+      for (int32_t index = iterator.Next(); index != -1; index = iterator.Next()) {
+        LiveInterval* interval = liveness_.GetInstructionFromSsaIndex(index)->GetLiveInterval();
+        ConnectSplitSiblings(interval, block, successor);
+      }
+
+      size_t input_index = successor->GetPredecessorIndexOf(block);
+      for (HInstructionIterator it(*successor->GetPhis()); !it.Done(); it.Advance()) {
+        HInstruction* phi = it.Current();
+        if (phi->GetLiveInterval() == nullptr) {
+          continue;
+        }
+        LiveInterval* input = phi->InputAt(input_index)->GetLiveInterval();
+        Location source = ConvertToLocation(input->GetSiblingAt(block->GetLifetimeEnd() - 1));
+        InsertParallelMoveAtExitOf(block, source, phi->GetLocations()->Out());
+      }
+    }
+  }
+
+  return ComputeStackMasks();
+}
+
+void RegisterAllocator::ConnectSiblings(LiveInterval* interval) const {
+  LiveInterval* current = interval;
+  while (current->GetNextSibling() != nullptr) {
+    LiveInterval* next_sibling = current->GetNextSibling();
+    size_t position = next_sibling->GetStart();
+    // Siblings split in a lifetime hole, or at the start of a block, are
+    // connected on the control flow edges.
+    if (current->GetEnd() == position
+        && (position % 2 == 1 || liveness_.GetInstructionFromPosition(position) != nullptr)) {
+      InsertParallelMoveAt(position - 1,
+                           ConvertToLocation(current),
+                           ConvertToLocation(next_sibling));
+    }
+    current = next_sibling;
+  }
+}
+
+void RegisterAllocator::ConnectSplitSiblings(LiveInterval* interval,
+                                             HBasicBlock* from,
+                                             HBasicBlock* to) const {
+  if (interval->GetNextSibling() == nullptr) {
+    // Nothing to connect. The whole range was allocated to the same location.
+    return;
+  }
+
+  LiveInterval* source = interval->GetSiblingAt(from->GetLifetimeEnd() - 1);
+  LiveInterval* destination = interval->GetSiblingAt(to->GetLifetimeStart());
+  DCHECK(source != nullptr);
+  DCHECK(destination != nullptr);
+
+  if (source == destination) {
+    // Interval was not split between these blocks.
+    return;
+  }
+
+  // Critical edges have been split, so either `from` has a single successor,
+  // or `to` has a single predecessor.
+  if (from->GetSuccessors()->Size() == 1) {
+    InsertParallelMoveAtExitOf(
+        from, ConvertToLocation(source), ConvertToLocation(destination));
+  } else {
+    DCHECK_EQ(to->GetPredecessors()->Size(), 1u);
+    InsertParallelMoveAtEntryOf(
+        to, ConvertToLocation(source), ConvertToLocation(destination));
+  }
+}
+
+void RegisterAllocator::InsertParallelMoveAt(size_t position,
+                                             Location source,
+                                             Location destination) const {
+  if (source.Equals(destination)) return;
+
+  HParallelMove* move;
+  if (position % 2 == 1) {
+    // Move between two instructions: it goes right before the instruction
+    // at the next position, after the moves for the outputs of the previous one.
+    HInstruction* next = liveness_.GetInstructionFromPosition(position + 1);
+    DCHECK(next != nullptr);
+    HInstruction* previous = next->GetPrevious();
+    move = previous == nullptr ? nullptr : previous->AsParallelMove();
+    if (move == nullptr || move->GetLifetimePosition() != position) {
+      move = new (allocator_) HParallelMove(allocator_);
+      move->SetLifetimePosition(position);
+      next->GetBlock()->InsertInstructionBefore(move, next);
+    }
+  } else {
+    // Move for the output of the instruction at `position`: it goes right
+    // after the instruction.
+    HInstruction* at = liveness_.GetInstructionFromPosition(position);
+    DCHECK(at != nullptr);
+    DCHECK(at->GetNext() != nullptr);
+    move = at->GetNext()->AsParallelMove();
+    if (move == nullptr || move->GetLifetimePosition() != position) {
+      move = new (allocator_) HParallelMove(allocator_);
+      move->SetLifetimePosition(position);
+      at->GetBlock()->InsertInstructionBefore(move, at->GetNext());
+    }
+  }
+  move->AddMove(new (allocator_) MoveOperands(source, destination));
+}
+
+void RegisterAllocator::InsertParallelMoveAtExitOf(HBasicBlock* block,
+                                                   Location source,
+                                                   Location destination) const {
+  if (source.Equals(destination)) return;
+
+  DCHECK_EQ(block->GetSuccessors()->Size(), 1u);
+  HInstruction* last = block->GetLastInstruction();
+  HInstruction* previous = last->GetPrevious();
+  HParallelMove* move = previous == nullptr ? nullptr : previous->AsParallelMove();
+  // The moves of the edge are distinguished from the moves of the last
+  // instruction by their lifetime position.
+  if (move == nullptr || move->GetLifetimePosition() != block->GetLifetimeEnd()) {
+    move = new (allocator_) HParallelMove(allocator_);
+    move->SetLifetimePosition(block->GetLifetimeEnd());
+    block->InsertInstructionBefore(move, last);
+  }
+  move->AddMove(new (allocator_) MoveOperands(source, destination));
+}
+
+void RegisterAllocator::InsertParallelMoveAtEntryOf(HBasicBlock* block,
+                                                    Location source,
+                                                    Location destination) const {
+  if (source.Equals(destination)) return;
+
+  HInstruction* first = block->GetFirstInstruction();
+  HParallelMove* move = first->AsParallelMove();
+  if (move == nullptr || move->GetLifetimePosition() != block->GetLifetimeStart()) {
+    move = new (allocator_) HParallelMove(allocator_);
+    move->SetLifetimePosition(block->GetLifetimeStart());
+    block->InsertInstructionBefore(move, first);
+  }
+  move->AddMove(new (allocator_) MoveOperands(source, destination));
+}
+
+void RegisterAllocator::ComputeReferenceValues(ArenaBitVector* is_reference) const {
+  // Phis are not typed yet. Start by assuming every phi holds a reference, and
+  // remove the ones with an input that is not a reference, a phi holding a
+  // reference, or the null constant, until nothing changes.
+  for (size_t i = 0, e = liveness_.GetNumberOfSsaValues(); i < e; ++i) {
+    HInstruction* instruction = liveness_.GetInstructionFromSsaIndex(i);
+    if (instruction->GetType() == Primitive::kPrimNot || instruction->AsPhi() != nullptr) {
+      is_reference->SetBit(i);
+    }
+  }
+
+  bool changed;
+  do {
+    changed = false;
+    for (size_t i = 0, e = liveness_.GetNumberOfSsaValues(); i < e; ++i) {
+      HInstruction* phi = liveness_.GetInstructionFromSsaIndex(i);
+      if (phi->AsPhi() == nullptr || !is_reference->IsBitSet(i)) {
+        continue;
+      }
+      for (size_t j = 0, f = phi->InputCount(); j < f; ++j) {
+        HInstruction* input = phi->InputAt(j);
+        HIntConstant* constant = input->AsIntConstant();
+        bool is_null = constant != nullptr && constant->GetValue() == 0;
+        if (!is_null && !is_reference->IsBitSet(input->GetSsaIndex())) {
+          is_reference->ClearBit(i);
+          changed = true;
+          break;
+        }
+      }
+    }
+  } while (changed);
+}
+
+size_t RegisterAllocator::GetGcMapIndexOf(LiveInterval* interval) const {
+  DCHECK(!interval->HasRegister());
+  HGraph* graph = codegen_->GetGraph();
+  size_t number_of_locals = graph->GetNumberOfVRegs() - graph->GetNumberOfInVRegs();
+  LiveInterval* parent = interval->GetParent();
+  HParameterValue* parameter = parent->GetDefinedBy()->AsParameterValue();
+  if (parameter != nullptr) {
+    return number_of_locals + parameter->GetIndex();
+  }
+  size_t slot = parent->GetSpillSlot();
+  return slot < number_of_locals ? slot : kNoGcMapIndex;
+}
+
+bool RegisterAllocator::ComputeStackMasks() {
+  if (safepoints_.IsEmpty()) {
+    return true;
+  }
+
+  ArenaBitVector is_reference(allocator_, liveness_.GetNumberOfSsaValues(), false);
+  ComputeReferenceValues(&is_reference);
+
+  for (size_t i = 0, e = safepoints_.Size(); i < e; ++i) {
+    HInstruction* safepoint = safepoints_.Get(i);
+    size_t position = safepoint->GetLifetimePosition();
+    BitVector::Iterator iterator(&is_reference);
+    for (int32_t index = iterator.Next(); index != -1; index = iterator.Next()) {
+      LiveInterval* interval = liveness_.GetInstructionFromSsaIndex(index)->GetLiveInterval();
+      LiveInterval* sibling = interval->GetSiblingAt(position);
+      if (sibling == nullptr || !sibling->Covers(position + 1)) {
+        // The value is not live across the call.
+        continue;
+      }
+      size_t gc_map_index = GetGcMapIndexOf(sibling);
+      if (gc_map_index == kNoGcMapIndex) {
+        // The reference is in a slot the GC map of the method cannot describe.
+        return false;
+      }
+      safepoint->GetLocations()->SetStackBit(gc_map_index);
+    }
+  }
+  return true;
+}
+
+void RegisterAllocator::DumpInterval(std::ostream& stream, LiveInterval* interval) const {
+  interval->Dump(stream);
+  stream << ": ";
+  if (interval->HasRegister()) {
+    stream << "register " << interval->GetRegister();
+  } else if (interval->IsFixed()) {
+    stream << "fixed";
+  } else {
+    stream << "spilled";
+  }
+  stream << std::endl;
+}
+
+bool RegisterAllocator::Validate(bool log_fatal_on_failure) const {
+  GrowableArray<LiveInterval*> intervals(allocator_, 0);
+  for (size_t i = 0, e = liveness_.GetNumberOfSsaValues(); i < e; ++i) {
+    LiveInterval* current = liveness_.GetInstructionFromSsaIndex(i)->GetLiveInterval();
+    while (current != nullptr) {
+      intervals.Add(current);
+      current = current->GetNextSibling();
+    }
+  }
+  for (size_t i = 0, e = temp_intervals_.Size(); i < e; ++i) {
+    intervals.Add(temp_intervals_.Get(i));
+  }
+  for (size_t i = 0, e = physical_register_intervals_.Size(); i < e; ++i) {
+    if (physical_register_intervals_.Get(i) != nullptr) {
+      intervals.Add(physical_register_intervals_.Get(i));
+    }
+  }
+
+  // Two intervals with the same register must not be live at the same time.
+  for (size_t i = 0, e = intervals.Size(); i < e; ++i) {
+    LiveInterval* first = intervals.Get(i);
+    if (!first->HasRegister()) continue;
+    for (size_t j = i + 1; j < e; ++j) {
+      LiveInterval* second = intervals.Get(j);
+      if (second->HasRegister()
+          && first->GetRegister() == second->GetRegister()
+          && first->FirstIntersectionWith(second) != kNoLifetime) {
+        if (log_fatal_on_failure) {
+          std::ostringstream message;
+          message << "Register conflict at " << first->FirstIntersectionWith(second) << std::endl;
+          DumpInterval(message, first);
+          DumpInterval(message, second);
+          LOG(FATAL) << message.str();
+        }
+        return false;
+      }
+    }
+  }
+
+  // Two instructions sharing a spill slot must not be live at the same time.
+  for (size_t i = 0, e = liveness_.GetNumberOfSsaValues(); i < e; ++i) {
+    LiveInterval* first = liveness_.GetInstructionFromSsaIndex(i)->GetLiveInterval();
+    if (!first->HasSpillSlot()) continue;
+    for (size_t j = i + 1; j < e; ++j) {
+      LiveInterval* second = liveness_.GetInstructionFromSsaIndex(j)->GetLiveInterval();
+      if (!second->HasSpillSlot() || first->GetSpillSlot() != second->GetSpillSlot()) continue;
+      LiveInterval* first_last = first;
+      while (first_last->GetNextSibling() != nullptr) {
+        first_last = first_last->GetNextSibling();
+      }
+      LiveInterval* second_last = second;
+      while (second_last->GetNextSibling() != nullptr) {
+        second_last = second_last->GetNextSibling();
+      }
+      if (first->GetStart() < second_last->GetEnd() && second->GetStart() < first_last->GetEnd()) {
+        if (log_fatal_on_failure) {
+          LOG(FATAL) << "Spill slot conflict for slot " << first->GetSpillSlot();
+        }
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
+#define ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
+
+#include "base/macros.h"
+#include "instruction_set.h"
+#include "locations.h"
+#include "utils/allocation.h"
+#include "utils/growable_array.h"
+
+namespace art {
+
+class CodeGenerator;
+class HBasicBlock;
+class HGraph;
+class HInstruction;
+class HParameterValue;
+class LiveInterval;
+class SsaLivenessAnalysis;
+
+/**
+ * An implementation of a linear scan register allocator on an `HGraph` with SSA form.
+ * The algorithm follows "Linear Scan Register Allocation on SSA Form" by Wimmer and
+ * Franz: intervals computed by the liveness analysis are split when no register is
+ * available for their whole lifetime, and the allocator then inserts `HParallelMove`
+ * instructions to connect the split siblings, within blocks and on control flow edges.
+ */
+class RegisterAllocator : public ValueObject {
+ public:
+  RegisterAllocator(ArenaAllocator* allocator,
+                    CodeGenerator* codegen,
+                    const SsaLivenessAnalysis& liveness);
+
+  // Main entry point for the register allocator. Given the liveness analysis,
+  // allocates registers to live intervals, sets the locations of the instructions,
+  // and inserts the moves needed between the siblings of an interval.
+  // Returns whether the allocation succeeded. On failure, the graph must be
+  // compiled with the baseline code generator.
+  bool AllocateRegisters();
+
+  // Validate that the register allocator did not allocate the same register to
+  // intervals that intersect each other, and that parents sharing a spill slot
+  // are never live at the same time. Returns false if it did not.
+  bool Validate(bool log_fatal_on_failure) const;
+
+  // Returns whether the graph only contains instructions and types the register
+  // allocator and the code generator of `instruction_set` can handle.
+  static bool CanAllocateRegistersFor(const HGraph& graph, InstructionSet instruction_set);
+
+  size_t GetNumberOfSpillSlots() const {
+    return spill_slots_.Size();
+  }
+
+ private:
+  // Main methods of the allocator.
+  void LinearScan();
+  bool TryAllocateFreeReg(LiveInterval* interval);
+  bool AllocateBlockedReg(LiveInterval* interval);
+
+  // Add `interval` in the sorted list of unhandled intervals.
+  void AddToUnhandled(LiveInterval* interval);
+
+  // Split `interval` at the position `at`. The new interval starts at `at`.
+  LiveInterval* Split(LiveInterval* interval, size_t at);
+
+  // Returns whether `reg` is blocked by the code generator.
+  bool IsBlocked(int reg) const;
+
+  // Allocate a spill slot for the given interval.
+  void AllocateSpillSlotFor(LiveInterval* interval);
+
+  // Create the fixed interval of `reg` if needed, and block it at [start, end).
+  void BlockRegister(Location location, size_t start, size_t end);
+
+  // Collect the live intervals and the register constraints of `instruction`.
+  void ProcessInstruction(HInstruction* instruction);
+
+  // Returns the location the register allocator has given to `interval`.
+  Location ConvertToLocation(LiveInterval* interval) const;
+
+  // Set the locations of the instructions, and insert the moves between siblings.
+  bool Resolve();
+  void ConnectSiblings(LiveInterval* interval) const;
+  void ConnectSplitSiblings(LiveInterval* interval, HBasicBlock* from, HBasicBlock* to) const;
+
+  // Helpers to insert a move between `source` and `destination` at `position`.
+  void InsertParallelMoveAt(size_t position, Location source, Location destination) const;
+  void InsertParallelMoveAtExitOf(HBasicBlock* block,
+                                  Location source,
+                                  Location destination) const;
+  void InsertParallelMoveAtEntryOf(HBasicBlock* block,
+                                   Location source,
+                                   Location destination) const;
+
+  // Record the stack slots holding references in the stack mask of the
+  // instructions that call. Returns false if a reference lives in a slot
+  // the GC map cannot describe.
+  bool ComputeStackMasks();
+  void ComputeReferenceValues(ArenaBitVector* is_reference) const;
+
+  // Returns the GC map index of the stack slot of `interval`, which must not
+  // have a register.
+  size_t GetGcMapIndexOf(LiveInterval* interval) const;
+
+  // Helper method for validation.
+  void DumpInterval(std::ostream& stream, LiveInterval* interval) const;
+
+  ArenaAllocator* const allocator_;
+  CodeGenerator* const codegen_;
+  const SsaLivenessAnalysis& liveness_;
+
+  // List of intervals that must be processed, ordered by start position. Last entry
+  // is the interval that has the lowest start position.
+  GrowableArray<LiveInterval*> unhandled_;
+
+  // List of intervals that have been processed.
+  GrowableArray<LiveInterval*> handled_;
+
+  // List of intervals that are currently active when processing a new live interval.
+  // That is, they have a live range that spans the start of the new interval.
+  GrowableArray<LiveInterval*> active_;
+
+  // List of intervals that are currently inactive when processing a new live interval.
+  // That is, they have a lifetime hole that spans the start of the new interval.
+  GrowableArray<LiveInterval*> inactive_;
+
+  // Fixed intervals for physical registers. Such an interval covers the positions
+  // where an instruction requires a specific register.
+  GrowableArray<LiveInterval*> physical_register_intervals_;
+
+  // Intervals for temporaries. Such an interval covers the position where an
+  // instruction requires a temporary.
+  GrowableArray<LiveInterval*> temp_intervals_;
+
+  // The spill slots allocated for live intervals. Each entry is the lifetime
+  // position where the slot becomes free.
+  GrowableArray<size_t> spill_slots_;
+
+  // Instructions that call, and need a stack mask for the GC map.
+  GrowableArray<HInstruction*> safepoints_;
+
+  // The number of registers the allocator can choose from.
+  size_t number_of_registers_;
+
+  // Temporary array, allocated ahead of time for simplicity.
+  size_t* registers_array_;
+
+  // Registers the code generator reserves for its own use.
+  bool* const blocked_registers_;
+
+  // Whether an interval could not get the register it requires.
+  bool allocation_failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegisterAllocator);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
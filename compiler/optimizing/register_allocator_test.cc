@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "builder.h"
+#include "code_generator.h"
+#include "dex_file.h"
+#include "dex_instruction.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "register_allocator.h"
+#include "ssa_liveness_analysis.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+// Note: the register allocator tests rely on the fact that constants have live
+// intervals and registers get allocated to them.
+
+static bool Check(const uint16_t* data) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraphBuilder builder(&allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  graph->SplitCriticalEdges();
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  CodeGenerator* codegen = CodeGenerator::Create(&allocator, graph, kX86);
+  RegisterAllocator register_allocator(&allocator, codegen, liveness);
+  return register_allocator.AllocateRegisters() && register_allocator.Validate(false);
+}
+
+TEST(RegisterAllocatorTest, ReturnConstant) {
+  /*
+   * Test the following snippet:
+   *  return 0;
+   */
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::RETURN);
+
+  ASSERT_TRUE(Check(data));
+}
+
+TEST(RegisterAllocatorTest, Add) {
+  /*
+   * Test the following snippet:
+   *  return 3 + 4;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 3 << 12 | 0,
+    Instruction::CONST_4 | 4 << 12 | 1 << 8,
+    Instruction::ADD_INT, 1 << 8 | 0,
+    Instruction::RETURN);
+
+  ASSERT_TRUE(Check(data));
+}
+
+TEST(RegisterAllocatorTest, Diamond) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  if (a == 0) {
+   *    a = 4;
+   *  } else {
+   *    a = 5;
+   *  }
+   *  return a;
+   */
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_EQ, 4,
+    Instruction::CONST_4 | 4 << 12 | 0,
+    Instruction::GOTO | 0x200,
+    Instruction::CONST_4 | 5 << 12 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  ASSERT_TRUE(Check(data));
+}
+
+TEST(RegisterAllocatorTest, Loop) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  while (a == a) {
+   *    a = a + 1;
+   *  }
+   *  return a;
+   */
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_EQ, 5,
+    Instruction::ADD_INT_LIT8, 1 << 8 | 0,
+    Instruction::GOTO | 0xFC00,
+    Instruction::RETURN | 0 << 8);
+
+  ASSERT_TRUE(Check(data));
+}
+
+TEST(RegisterAllocatorTest, MoreValuesThanRegisters) {
+  /*
+   * Test the following snippet, where six values are live at the same
+   * time, more than the number of allocatable registers on x86:
+   *  var a = 1, b = 2, c = 3, d = 4, e = 5, f = 6;
+   *  return a + b + c + d + e + f;
+   */
+  const uint16_t data[] = {
+    6, 0, 0, 0, 0, 0, 12, 0,
+    Instruction::CONST_4 | 1 << 12 | 0 << 8,
+    Instruction::CONST_4 | 2 << 12 | 1 << 8,
+    Instruction::CONST_4 | 3 << 12 | 2 << 8,
+    Instruction::CONST_4 | 4 << 12 | 3 << 8,
+    Instruction::CONST_4 | 5 << 12 | 4 << 8,
+    Instruction::CONST_4 | 6 << 12 | 5 << 8,
+    Instruction::ADD_INT_2ADDR | 1 << 12 | 0 << 8,
+    Instruction::ADD_INT_2ADDR | 2 << 12 | 0 << 8,
+    Instruction::ADD_INT_2ADDR | 3 << 12 | 0 << 8,
+    Instruction::ADD_INT_2ADDR | 4 << 12 | 0 << 8,
+    Instruction::ADD_INT_2ADDR | 5 << 12 | 0 << 8,
+    Instruction::RETURN | 0 << 8 };
+
+  ASSERT_TRUE(Check(data));
+}
+
+TEST(RegisterAllocatorTest, SplitInRange) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  LiveInterval* interval = new (&allocator) LiveInterval(&allocator, Primitive::kPrimInt);
+  // Ranges must be added in decreasing order.
+  interval->AddRange(20, 30);
+  interval->AddRange(0, 10);
+
+  LiveInterval* sibling = interval->SplitAt(5);
+  ASSERT_NE(sibling, nullptr);
+  ASSERT_EQ(interval->GetNextSibling(), sibling);
+  ASSERT_EQ(sibling->GetParent(), interval);
+  ASSERT_EQ(interval->GetStart(), 0u);
+  ASSERT_EQ(interval->GetEnd(), 5u);
+  ASSERT_EQ(sibling->GetStart(), 5u);
+  ASSERT_EQ(sibling->GetEnd(), 30u);
+  ASSERT_TRUE(sibling->Covers(5));
+  ASSERT_FALSE(sibling->Covers(15));
+  ASSERT_EQ(interval->GetSiblingAt(22), sibling);
+}
+
+TEST(RegisterAllocatorTest, SplitInLifetimeHole) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  LiveInterval* interval = new (&allocator) LiveInterval(&allocator, Primitive::kPrimInt);
+  interval->AddRange(20, 30);
+  interval->AddRange(0, 10);
+
+  LiveInterval* sibling = interval->SplitAt(15);
+  ASSERT_NE(sibling, nullptr);
+  ASSERT_EQ(interval->GetEnd(), 10u);
+  ASSERT_EQ(sibling->GetStart(), 20u);
+  ASSERT_EQ(sibling->GetEnd(), 30u);
+
+  // Splitting after the end of an interval does not create a sibling.
+  ASSERT_EQ(sibling->SplitAt(30), nullptr);
+}
+
+}  // namespace art
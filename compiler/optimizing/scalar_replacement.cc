@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scalar_replacement.h"
+
+#include "safe_map.h"
+
+namespace art {
+
+// Returns the object whose field `instruction` reads or writes, without its
+// null check, or null if `instruction` is not a field access.
+static HInstruction* GetAccessedObject(HInstruction* instruction) {
+  if (instruction->AsInstanceFieldGet() == nullptr
+      && instruction->AsInstanceFieldSet() == nullptr) {
+    return nullptr;
+  }
+  HInstruction* object = instruction->InputAt(0);
+  HNullCheck* null_check = object->AsNullCheck();
+  return null_check == nullptr ? object : null_check->InputAt(0);
+}
+
+// Returns whether `user`, which uses an object as input `index`, accesses a
+// field of that object in `block`. Storing the object in a field lets it
+// escape.
+static bool IsLocalFieldAccess(HInstruction* user, size_t index, HBasicBlock* block) {
+  return user->GetBlock() == block
+      && index == 0
+      && (user->AsInstanceFieldGet() != nullptr || user->AsInstanceFieldSet() != nullptr);
+}
+
+static void RemoveEnvironmentUses(HInstruction* instruction) {
+  while (instruction->GetEnvUses() != nullptr) {
+    HUseListNode<HEnvironment>* use = instruction->GetEnvUses();
+    use->GetUser()->SetRawEnvAt(use->GetIndex(), nullptr);
+    instruction->RemoveEnvironmentUser(use->GetUser(), use->GetIndex());
+  }
+}
+
+void HScalarReplacement::Run() {
+  GrowableArray<HNewInstance*> allocations(graph_->GetArena(), 0);
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(*it.Current()->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HNewInstance* allocation = inst_it.Current()->AsNewInstance();
+      if (allocation != nullptr && allocation->CanBeRemoved()) {
+        allocations.Add(allocation);
+      }
+    }
+  }
+
+  // Replacing the fields of an allocation removes instructions of its block,
+  // so only do it once all blocks are visited.
+  for (size_t i = 0, e = allocations.Size(); i < e; ++i) {
+    HNewInstance* allocation = allocations.Get(i);
+    if (CanReplaceFields(allocation)) {
+      ReplaceFields(allocation);
+    }
+  }
+}
+
+bool HScalarReplacement::CanReplaceFields(HNewInstance* allocation) const {
+  HBasicBlock* block = allocation->GetBlock();
+  for (HUseIterator<HInstruction> it(allocation->GetUses()); !it.Done(); it.Advance()) {
+    HInstruction* user = it.Current()->GetUser();
+    if (user->AsNullCheck() != nullptr && user->GetBlock() == block) {
+      for (HUseIterator<HInstruction> it2(user->GetUses()); !it2.Done(); it2.Advance()) {
+        if (!IsLocalFieldAccess(it2.Current()->GetUser(), it2.Current()->GetIndex(), block)) {
+          return false;
+        }
+      }
+    } else if (!IsLocalFieldAccess(user, it.Current()->GetIndex(), block)) {
+      return false;
+    }
+  }
+
+  // A field read before any write reads the default value of its type. There
+  // is no null constant to stand for the default value of references.
+  SafeMap<size_t, HInstruction*> written_fields;
+  for (HInstruction* current = allocation->GetNext();
+       current != nullptr;
+       current = current->GetNext()) {
+    if (GetAccessedObject(current) != allocation) {
+      continue;
+    }
+    HInstanceFieldSet* field_set = current->AsInstanceFieldSet();
+    if (field_set != nullptr) {
+      written_fields.Overwrite(field_set->GetFieldOffset().SizeValue(), field_set);
+      continue;
+    }
+    HInstanceFieldGet* field_get = current->AsInstanceFieldGet();
+    if (field_get->GetFieldType() == Primitive::kPrimNot
+        && written_fields.find(field_get->GetFieldOffset().SizeValue()) == written_fields.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HScalarReplacement::ReplaceFields(HNewInstance* allocation) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* block = allocation->GetBlock();
+  SafeMap<size_t, HInstruction*> field_values;
+  HInstruction* next = nullptr;
+  for (HInstruction* current = allocation->GetNext(); current != nullptr; current = next) {
+    next = current->GetNext();
+    if (GetAccessedObject(current) != allocation) {
+      continue;
+    }
+    HInstanceFieldSet* field_set = current->AsInstanceFieldSet();
+    if (field_set != nullptr) {
+      field_values.Overwrite(field_set->GetFieldOffset().SizeValue(), field_set->InputAt(1));
+      block->RemoveInstruction(field_set);
+      continue;
+    }
+
+    HInstanceFieldGet* field_get = current->AsInstanceFieldGet();
+    size_t offset = field_get->GetFieldOffset().SizeValue();
+    SafeMap<size_t, HInstruction*>::const_iterator value_it = field_values.find(offset);
+    HInstruction* value = nullptr;
+    if (value_it != field_values.end()) {
+      value = value_it->second;
+    } else {
+      // The field still has its default value.
+      if (field_get->GetType() == Primitive::kPrimLong) {
+        value = new (arena) HLongConstant(0);
+      } else {
+        DCHECK_NE(field_get->GetType(), Primitive::kPrimNot);
+        value = new (arena) HIntConstant(0);
+      }
+      block->InsertInstructionBefore(value, field_get);
+      field_values.Put(offset, value);
+    }
+    field_get->ReplaceWith(value);
+    block->RemoveInstruction(field_get);
+  }
+
+  // The remaining uses are the null checks of the field accesses, which can
+  // no longer throw. The environments do not need to hold the object.
+  while (allocation->GetUses() != nullptr) {
+    HInstruction* null_check = allocation->GetUses()->GetUser();
+    DCHECK(null_check->AsNullCheck() != nullptr);
+    DCHECK(null_check->GetUses() == nullptr);
+    RemoveEnvironmentUses(null_check);
+    block->RemoveInstruction(null_check);
+  }
+  RemoveEnvironmentUses(allocation);
+  block->RemoveInstruction(allocation);
+}
+
+}  // namespace art
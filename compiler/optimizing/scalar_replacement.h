@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
+#define ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Optimization pass removing the allocations that do not escape the method:
+ * the object is only used to read and write its own fields, in the block of
+ * the allocation. The fields are then replaced with the values written, and
+ * the allocation is removed. Run after the inliner, which brings in the
+ * constructors and accessors the object is passed to.
+ */
+class HScalarReplacement : public HOptimization {
+ public:
+  explicit HScalarReplacement(HGraph* graph)
+      : HOptimization(graph, kScalarReplacementPassName) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kScalarReplacementPassName = "scalar_replacement";
+
+ private:
+  // Returns whether `allocation` is only used by accesses to its fields, in
+  // its block, and whether every field read has a known value.
+  bool CanReplaceFields(HNewInstance* allocation) const;
+
+  // Replaces the field reads of `allocation` with the values last written,
+  // and removes the allocation and its field accesses.
+  void ReplaceFields(HNewInstance* allocation);
+
+  DISALLOW_COPY_AND_ASSIGN(HScalarReplacement);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
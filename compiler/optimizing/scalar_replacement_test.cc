@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "nodes.h"
+#include "scalar_replacement.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Builds a graph made of an entry block, holding an int parameter, a body
+ * block where the tests add their instructions, and the exit block.
+ */
+static HGraph* CreateGraph(ArenaAllocator* allocator) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  entry->AddInstruction(new (allocator) HParameterValue(0, Primitive::kPrimInt));
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* body = new (allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(body);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  entry->AddSuccessor(body);
+  body->AddSuccessor(exit);
+  exit->AddInstruction(new (allocator) HExit());
+
+  graph->BuildDominatorTree();
+  return graph;
+}
+
+static HBasicBlock* GetBody(HGraph* graph) {
+  return graph->GetEntryBlock()->GetSuccessors()->Get(0);
+}
+
+// Adds a write of `value` to the field at `offset` of `object` to `block`.
+static HInstruction* AddFieldSet(ArenaAllocator* allocator,
+                                 HBasicBlock* block,
+                                 HInstruction* object,
+                                 HInstruction* value,
+                                 size_t offset) {
+  HInstruction* null_check = new (allocator) HNullCheck(object, 0);
+  block->AddInstruction(null_check);
+  HInstruction* field_set = new (allocator) HInstanceFieldSet(
+      null_check, value, value->GetType(), MemberOffset(offset));
+  block->AddInstruction(field_set);
+  return field_set;
+}
+
+// Adds a read of the field at `offset` of `object` to `block`.
+static HInstruction* AddFieldGet(ArenaAllocator* allocator,
+                                 HBasicBlock* block,
+                                 HInstruction* object,
+                                 Primitive::Type type,
+                                 size_t offset) {
+  HInstruction* null_check = new (allocator) HNullCheck(object, 0);
+  block->AddInstruction(null_check);
+  HInstruction* field_get = new (allocator) HInstanceFieldGet(
+      null_check, type, MemberOffset(offset));
+  block->AddInstruction(field_get);
+  return field_get;
+}
+
+TEST(ScalarReplacementTest, ReplaceFields) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* body = GetBody(graph);
+  HInstruction* parameter = graph->GetEntryBlock()->GetFirstInstruction();
+
+  HInstruction* allocation = new (&allocator) HNewInstance(0, 0, true);
+  body->AddInstruction(allocation);
+  HInstruction* field_set = AddFieldSet(&allocator, body, allocation, parameter, 8);
+  HInstruction* written = AddFieldGet(&allocator, body, allocation, Primitive::kPrimInt, 8);
+  HInstruction* unwritten = AddFieldGet(&allocator, body, allocation, Primitive::kPrimInt, 12);
+  HInstruction* add = new (&allocator) HAdd(Primitive::kPrimInt, written, unwritten);
+  body->AddInstruction(add);
+  body->AddInstruction(new (&allocator) HReturn(add));
+
+  HScalarReplacement(graph).Run();
+
+  ASSERT_TRUE(allocation->GetBlock() == nullptr);
+  ASSERT_TRUE(field_set->GetBlock() == nullptr);
+  ASSERT_TRUE(written->GetBlock() == nullptr);
+  ASSERT_TRUE(unwritten->GetBlock() == nullptr);
+  ASSERT_EQ(add->InputAt(0), parameter);
+  HIntConstant* zero = add->InputAt(1)->AsIntConstant();
+  ASSERT_TRUE(zero != nullptr);
+  ASSERT_EQ(zero->GetValue(), 0);
+  // Only the default value, the add and the return are left.
+  ASSERT_EQ(body->GetFirstInstruction(), zero);
+  ASSERT_EQ(zero->GetNext(), add);
+}
+
+TEST(ScalarReplacementTest, EscapingObject) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* body = GetBody(graph);
+  HInstruction* parameter = graph->GetEntryBlock()->GetFirstInstruction();
+
+  HInstruction* allocation = new (&allocator) HNewInstance(0, 0, true);
+  HInstruction* other = new (&allocator) HNewInstance(0, 0, true);
+  body->AddInstruction(allocation);
+  body->AddInstruction(other);
+  HInstruction* field_set = AddFieldSet(&allocator, body, allocation, parameter, 8);
+  // Storing `allocation` in a field of `other` publishes it if `other` escapes.
+  HInstruction* other_set = AddFieldSet(&allocator, body, other, allocation, 8);
+  body->AddInstruction(new (&allocator) HReturn(other));
+
+  HScalarReplacement(graph).Run();
+
+  ASSERT_EQ(allocation->GetBlock(), body);
+  ASSERT_EQ(other->GetBlock(), body);
+  ASSERT_EQ(field_set->GetBlock(), body);
+  ASSERT_EQ(other_set->GetBlock(), body);
+}
+
+TEST(ScalarReplacementTest, AllocationWithSideEffects) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* body = GetBody(graph);
+  HInstruction* parameter = graph->GetEntryBlock()->GetFirstInstruction();
+
+  // The allocation may initialize its class, or register a finalizer.
+  HInstruction* allocation = new (&allocator) HNewInstance(0, 0, false);
+  body->AddInstruction(allocation);
+  AddFieldSet(&allocator, body, allocation, parameter, 8);
+  HInstruction* field_get = AddFieldGet(&allocator, body, allocation, Primitive::kPrimInt, 8);
+  body->AddInstruction(new (&allocator) HReturn(field_get));
+
+  HScalarReplacement(graph).Run();
+
+  ASSERT_EQ(allocation->GetBlock(), body);
+  ASSERT_EQ(field_get->GetBlock(), body);
+}
+
+TEST(ScalarReplacementTest, UnwrittenReferenceField) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = CreateGraph(&allocator);
+  HBasicBlock* body = GetBody(graph);
+
+  HInstruction* allocation = new (&allocator) HNewInstance(0, 0, true);
+  body->AddInstruction(allocation);
+  HInstruction* field_get = AddFieldGet(&allocator, body, allocation, Primitive::kPrimNot, 8);
+  body->AddInstruction(new (&allocator) HReturn(field_get));
+
+  HScalarReplacement(graph).Run();
+
+  // There is no constant for the null default value.
+  ASSERT_EQ(allocation->GetBlock(), body);
+  ASSERT_EQ(field_get->GetBlock(), body);
+}
+
+}  // namespace art
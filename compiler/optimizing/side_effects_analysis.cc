@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "side_effects_analysis.h"
+
+namespace art {
+
+void SideEffectsAnalysis::UpdateLoopEffects(HLoopInformation* info, SideEffects effects) {
+  int id = info->GetHeader()->GetBlockId();
+  loop_effects_.Put(id, loop_effects_.Get(id).Union(effects));
+}
+
+void SideEffectsAnalysis::Run() {
+  const GrowableArray<HBasicBlock*>& blocks = graph_->GetBlocks();
+
+  // Find the blocks of each loop.
+  GrowableArray<HLoopInformation*> loops(allocator_, kDefaultNumberOfLoops);
+  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
+    HBasicBlock* block = blocks.Get(i);
+    if (block->IsLoopHeader()) {
+      block->GetLoopInformation()->Populate();
+      loops.Add(block->GetLoopInformation());
+    }
+  }
+
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    SideEffects effects = SideEffects::None();
+    // Update `effects` with the side effects of all instructions in this block.
+    for (HInstructionIterator inst_it(*block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      effects = effects.Union(inst_it.Current()->GetSideEffects());
+    }
+    block_effects_.Put(block->GetBlockId(), effects);
+
+    // Update the side effects of the loops containing the block.
+    for (size_t i = 0, e = loops.Size(); i < e; ++i) {
+      if (loops.Get(i)->Contains(*block)) {
+        UpdateLoopEffects(loops.Get(i), effects);
+      }
+    }
+  }
+}
+
+SideEffects SideEffectsAnalysis::GetBlockEffects(HBasicBlock* block) const {
+  return block_effects_.Get(block->GetBlockId());
+}
+
+SideEffects SideEffectsAnalysis::GetLoopEffects(HBasicBlock* block) const {
+  DCHECK(block->IsLoopHeader());
+  return loop_effects_.Get(block->GetBlockId());
+}
+
+}  // namespace art
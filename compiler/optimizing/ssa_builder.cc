@@ -65,9 +65,9 @@ void SsaBuilder::VisitBasicBlock(HBasicBlock* block) {
     for (size_t local = 0; local < current_locals_->Size(); local++) {
       HInstruction* incoming = ValueOfLocal(block->GetLoopInformation()->GetPreHeader(), local);
       if (incoming != nullptr) {
-        // TODO: Compute union type.
+        // TODO: Compute union type. Use the type of the incoming value for now.
         HPhi* phi = new (GetGraph()->GetArena()) HPhi(
-            GetGraph()->GetArena(), local, 0, Primitive::kPrimVoid);
+            GetGraph()->GetArena(), local, 0, incoming->GetType());
         block->AddPhi(phi);
         current_locals_->Put(local, phi);
       }
@@ -80,17 +80,24 @@ void SsaBuilder::VisitBasicBlock(HBasicBlock* block) {
     // We merge the values of all locals, creating phis if those values differ.
     for (size_t local = 0; local < current_locals_->Size(); local++) {
       bool is_different = false;
+      bool is_undefined = false;
       HInstruction* value = ValueOfLocal(block->GetPredecessors()->Get(0), local);
-      for (size_t i = 1; i < block->GetPredecessors()->Size(); i++) {
-        if (ValueOfLocal(block->GetPredecessors()->Get(i), local) != value) {
+      for (size_t i = 0; i < block->GetPredecessors()->Size(); i++) {
+        HInstruction* incoming = ValueOfLocal(block->GetPredecessors()->Get(i), local);
+        if (incoming == nullptr) {
+          is_undefined = true;
+        } else if (incoming != value) {
           is_different = true;
-          break;
         }
       }
-      if (is_different) {
-        // TODO: Compute union type.
+      if (is_undefined) {
+        // The local is not initialized on all paths, so the verifier guarantees
+        // it is not read after this point.
+        value = nullptr;
+      } else if (is_different) {
+        // TODO: Compute union type. Use the type of the first input for now.
         HPhi* phi = new (GetGraph()->GetArena()) HPhi(
-            GetGraph()->GetArena(), local, block->GetPredecessors()->Size(), Primitive::kPrimVoid);
+            GetGraph()->GetArena(), local, block->GetPredecessors()->Size(), value->GetType());
         for (size_t i = 0; i < block->GetPredecessors()->Size(); i++) {
           phi->SetRawInputAt(i, ValueOfLocal(block->GetPredecessors()->Get(i), local));
         }
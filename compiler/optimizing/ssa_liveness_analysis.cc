@@ -20,28 +20,58 @@
 namespace art {
 
 void SsaLivenessAnalysis::Analyze() {
+  LinearizeGraph();
   NumberInstructions();
   ComputeSets();
+  ComputeLiveRanges();
+}
+
+void SsaLivenessAnalysis::LinearizeGraph() {
+  for (HReversePostOrderIterator it(graph_); !it.Done(); it.Advance()) {
+    linear_order_.Add(it.Current());
+  }
 }
 
 void SsaLivenessAnalysis::NumberInstructions() {
   int ssa_index = 0;
-  for (HReversePostOrderIterator it(graph_); !it.Done(); it.Advance()) {
-    HBasicBlock* block = it.Current();
+  size_t lifetime_position = 0;
+  // Each instruction gets a lifetime position, and a block gets a lifetime
+  // start and end position. Phis take the lifetime start of their block as
+  // position, other instructions have distinct positions. Positions are
+  // incremented by two, so that the register allocator can insert moves
+  // between two instructions.
+  ArenaAllocator* arena = graph_.GetArena();
+  for (size_t i = 0, e = linear_order_.Size(); i < e; ++i) {
+    HBasicBlock* block = linear_order_.Get(i);
+    block->SetLifetimeStart(lifetime_position);
 
     for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
       HInstruction* current = it.Current();
       if (current->HasUses()) {
+        instructions_from_ssa_index_.Add(current);
         current->SetSsaIndex(ssa_index++);
+        current->SetLiveInterval(
+            new (arena) LiveInterval(arena, current->GetType(), current));
       }
+      current->SetLifetimePosition(lifetime_position);
     }
+    instructions_from_lifetime_position_.Add(nullptr);
+    lifetime_position += 2;
 
     for (HInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
       HInstruction* current = it.Current();
       if (current->HasUses()) {
+        instructions_from_ssa_index_.Add(current);
         current->SetSsaIndex(ssa_index++);
+        current->SetLiveInterval(
+            new (arena) LiveInterval(arena, current->GetType(), current));
       }
+      current->SetLifetimePosition(lifetime_position);
+      instructions_from_lifetime_position_.Add(current);
+      lifetime_position += 2;
     }
+
+    block->SetLifetimeEnd(lifetime_position);
   }
   number_of_ssa_values_ = ssa_index;
 }
@@ -125,6 +155,77 @@ void SsaLivenessAnalysis::ComputeInitialSets() {
   }
 }
 
+void SsaLivenessAnalysis::ComputeLiveRanges() {
+  ArenaBitVector live(graph_.GetArena(), number_of_ssa_values_, false);
+  // Visit the blocks and their instructions backward, so that the ranges and
+  // uses of an interval are added in decreasing order of position.
+  for (size_t i = linear_order_.Size(); i > 0; --i) {
+    HBasicBlock* block = linear_order_.Get(i - 1);
+    live.Copy(GetLiveOutSet(*block));
+
+    // The inputs of the phis of the successors that correspond to this block
+    // are live at the end of the block.
+    for (size_t j = 0, e = block->GetSuccessors()->Size(); j < e; ++j) {
+      HBasicBlock* successor = block->GetSuccessors()->Get(j);
+      size_t phi_input_index = successor->GetPredecessorIndexOf(block);
+      for (HInstructionIterator it(*successor->GetPhis()); !it.Done(); it.Advance()) {
+        HInstruction* phi = it.Current();
+        if (phi->HasSsaIndex()) {
+          HInstruction* input = phi->InputAt(phi_input_index);
+          input->GetLiveInterval()->AddPhiUse(phi, phi_input_index, block);
+          live.SetBit(input->GetSsaIndex());
+        }
+      }
+    }
+
+    // Add a range that covers this block to all instructions live at its end.
+    BitVector::Iterator iterator(&live);
+    for (int32_t index = iterator.Next(); index != -1; index = iterator.Next()) {
+      GetInstructionFromSsaIndex(index)->GetLiveInterval()->AddRange(
+          block->GetLifetimeStart(), block->GetLifetimeEnd());
+    }
+
+    for (HBackwardInstructionIterator it(*block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* current = it.Current();
+      if (current->HasSsaIndex()) {
+        // Kill the instruction and shorten its interval.
+        live.ClearBit(current->GetSsaIndex());
+        current->GetLiveInterval()->SetFrom(current->GetLifetimePosition());
+      }
+
+      // All inputs of an instruction must be live.
+      for (size_t j = 0, e = current->InputCount(); j < e; ++j) {
+        HInstruction* input = current->InputAt(j);
+        DCHECK(input->HasSsaIndex());
+        live.SetBit(input->GetSsaIndex());
+        input->GetLiveInterval()->AddUse(current, j, false);
+      }
+
+      if (current->HasEnvironment()) {
+        // All instructions in the environment must be live.
+        GrowableArray<HInstruction*>* environment = current->GetEnvironment()->GetVRegs();
+        for (size_t j = 0, e = environment->Size(); j < e; ++j) {
+          HInstruction* instruction = environment->Get(j);
+          if (instruction != nullptr) {
+            DCHECK(instruction->HasSsaIndex());
+            live.SetBit(instruction->GetSsaIndex());
+            instruction->GetLiveInterval()->AddUse(current, j, true);
+          }
+        }
+      }
+    }
+
+    // Kill the phis defined in this block.
+    for (HInstructionIterator it(*block->GetPhis()); !it.Done(); it.Advance()) {
+      HInstruction* current = it.Current();
+      if (current->HasSsaIndex()) {
+        live.ClearBit(current->GetSsaIndex());
+        current->GetLiveInterval()->SetFrom(block->GetLifetimeStart());
+      }
+    }
+  }
+}
+
 void SsaLivenessAnalysis::ComputeLiveInAndLiveOutSets() {
   bool changed;
   do {
@@ -44,11 +44,454 @@ class BlockInfo : public ArenaObject {
   DISALLOW_COPY_AND_ASSIGN(BlockInfo);
 };
 
+/**
+ * A live range contains the start and end of a range where an instruction
+ * is live.
+ */
+class LiveRange : public ArenaObject {
+ public:
+  LiveRange(size_t start, size_t end, LiveRange* next) : start_(start), end_(end), next_(next) {
+    DCHECK_LT(start, end);
+    DCHECK(next_ == nullptr || next_->GetStart() > GetEnd());
+  }
+
+  size_t GetStart() const { return start_; }
+  size_t GetEnd() const { return end_; }
+  LiveRange* GetNext() const { return next_; }
+
+  bool IntersectsWith(const LiveRange& other) const {
+    return (start_ >= other.start_ && start_ < other.end_)
+        || (other.start_ >= start_ && other.start_ < end_);
+  }
+
+  bool IsBefore(const LiveRange& other) const {
+    return end_ <= other.start_;
+  }
+
+  void Dump(std::ostream& stream) const {
+    stream << "[" << start_ << ", " << end_ << ")";
+  }
+
+ private:
+  size_t start_;
+  size_t end_;
+  LiveRange* next_;
+
+  friend class LiveInterval;
+
+  DISALLOW_COPY_AND_ASSIGN(LiveRange);
+};
+
+/**
+ * A use position represents a live interval use at a given position.
+ */
+class UsePosition : public ArenaObject {
+ public:
+  UsePosition(HInstruction* user,
+              size_t input_index,
+              bool is_environment,
+              size_t position,
+              UsePosition* next)
+      : user_(user),
+        input_index_(input_index),
+        is_environment_(is_environment),
+        position_(position),
+        next_(next) {
+    DCHECK(next_ == nullptr || next->GetPosition() >= GetPosition());
+  }
+
+  size_t GetPosition() const { return position_; }
+
+  UsePosition* GetNext() const { return next_; }
+
+  HInstruction* GetUser() const { return user_; }
+
+  bool GetIsEnvironment() const { return is_environment_; }
+
+  size_t GetInputIndex() const { return input_index_; }
+
+  void Dump(std::ostream& stream) const {
+    stream << position_;
+  }
+
+ private:
+  HInstruction* const user_;
+  const size_t input_index_;
+  const bool is_environment_;
+  const size_t position_;
+  UsePosition* const next_;
+
+  DISALLOW_COPY_AND_ASSIGN(UsePosition);
+};
+
+static constexpr int kNoRegister = -1;
+
+/**
+ * An interval is a list of disjoint live ranges where an instruction is live.
+ * Each instruction that has uses gets an interval. The register allocator
+ * splits intervals, and the resulting siblings share the parent's use positions.
+ */
+class LiveInterval : public ArenaObject {
+ public:
+  LiveInterval(ArenaAllocator* allocator,
+               Primitive::Type type,
+               HInstruction* defined_by = nullptr,
+               bool is_fixed = false,
+               int reg = kNoRegister,
+               bool is_temp = false)
+      : allocator_(allocator),
+        first_range_(nullptr),
+        last_range_(nullptr),
+        first_use_(nullptr),
+        type_(type),
+        next_sibling_(nullptr),
+        parent_(this),
+        register_(reg),
+        spill_slot_(kNoSpillSlot),
+        is_fixed_(is_fixed),
+        is_temp_(is_temp),
+        defined_by_(defined_by) {}
+
+  static LiveInterval* MakeFixedInterval(ArenaAllocator* allocator, int reg, Primitive::Type type) {
+    return new (allocator) LiveInterval(allocator, type, nullptr, true, reg, false);
+  }
+
+  static LiveInterval* MakeTempInterval(ArenaAllocator* allocator,
+                                        HInstruction* defined_by,
+                                        Primitive::Type type) {
+    return new (allocator) LiveInterval(allocator, type, defined_by, false, kNoRegister, true);
+  }
+
+  bool IsFixed() const { return is_fixed_; }
+  bool IsTemp() const { return is_temp_; }
+
+  void AddUse(HInstruction* instruction, size_t input_index, bool is_environment) {
+    // Set the use within the instruction.
+    size_t position = instruction->GetLifetimePosition();
+    // An input must stay live while the instruction executes. A value only
+    // needed by the environment of the instruction is not read by it.
+    size_t end = is_environment ? position : position + 1;
+    HBasicBlock* block = instruction->GetBlock();
+
+    first_use_ = new (allocator_) UsePosition(
+        instruction, input_index, is_environment, position, first_use_);
+
+    if (first_range_ == nullptr) {
+      // First time we see a use of that interval.
+      first_range_ = last_range_ = new (allocator_) LiveRange(
+          block->GetLifetimeStart(), end, nullptr);
+    } else if (first_range_->GetStart() == block->GetLifetimeStart()) {
+      // There is a use later in the same block or in a following block.
+      // Note that in such a case, `AddRange` for the whole blocks has been called
+      // before arriving in this method, and this is the reason the start of
+      // `first_range_` is before the given `position`.
+      DCHECK_LE(position, first_range_->GetEnd());
+    } else {
+      DCHECK(first_range_->GetStart() > position);
+      // There is a hole in the interval. Create a new range.
+      first_range_ = new (allocator_) LiveRange(block->GetLifetimeStart(), end, first_range_);
+    }
+  }
+
+  void AddPhiUse(HInstruction* instruction, size_t input_index, HBasicBlock* block) {
+    DCHECK(instruction->AsPhi() != nullptr);
+    first_use_ = new (allocator_) UsePosition(
+        instruction, input_index, false, block->GetLifetimeEnd(), first_use_);
+  }
+
+  void AddRange(size_t start, size_t end) {
+    if (first_range_ == nullptr) {
+      first_range_ = last_range_ = new (allocator_) LiveRange(start, end, first_range_);
+    } else if (first_range_->GetStart() <= end) {
+      // There is a use in the following block, or, for fixed intervals,
+      // another reason to block the register at this position.
+      DCHECK(is_fixed_ || first_range_->GetStart() == end);
+      first_range_->start_ = std::min(first_range_->start_, start);
+      first_range_->end_ = std::max(first_range_->end_, end);
+    } else {
+      // There is a hole in the interval. Create a new range.
+      first_range_ = new (allocator_) LiveRange(start, end, first_range_);
+    }
+  }
+
+  bool HasSpillSlot() const { return spill_slot_ != kNoSpillSlot; }
+  void SetSpillSlot(size_t slot) { spill_slot_ = slot; }
+  size_t GetSpillSlot() const { return spill_slot_; }
+
+  void SetFrom(size_t from) {
+    if (first_range_ != nullptr) {
+      first_range_->start_ = from;
+    } else {
+      // Instruction without uses.
+      DCHECK(!defined_by_->HasUses());
+      first_range_ = last_range_ = new (allocator_) LiveRange(from, from + 2, nullptr);
+    }
+  }
+
+  // Shorten the end of the interval to `to`, which must be in its last range.
+  void SetTo(size_t to) {
+    DCHECK_GT(to, last_range_->GetStart());
+    DCHECK_LE(to, last_range_->GetEnd());
+    last_range_->end_ = to;
+  }
+
+  LiveInterval* GetParent() const { return parent_; }
+
+  LiveRange* GetFirstRange() const { return first_range_; }
+
+  int GetRegister() const { return register_; }
+  void SetRegister(int reg) { register_ = reg; }
+  void ClearRegister() { register_ = kNoRegister; }
+  bool HasRegister() const { return register_ != kNoRegister; }
+
+  bool IsDeadAt(size_t position) const {
+    return last_range_->GetEnd() <= position;
+  }
+
+  bool Covers(size_t position) const {
+    LiveRange* current = first_range_;
+    while (current != nullptr) {
+      if (position < current->GetStart()) {
+        return false;
+      }
+      if (position < current->GetEnd()) {
+        return true;
+      }
+      current = current->GetNext();
+    }
+    return false;
+  }
+
+  // Returns the first position where this interval and `other` are both
+  // live, or kNoLifetime if they never are.
+  size_t FirstIntersectionWith(LiveInterval* other) const {
+    LiveRange* my_range = first_range_;
+    LiveRange* other_range = other->first_range_;
+    while (my_range != nullptr && other_range != nullptr) {
+      if (my_range->IntersectsWith(*other_range)) {
+        return std::max(my_range->GetStart(), other_range->GetStart());
+      } else if (my_range->IsBefore(*other_range)) {
+        my_range = my_range->GetNext();
+      } else {
+        DCHECK(other_range->IsBefore(*my_range));
+        other_range = other_range->GetNext();
+      }
+    }
+    return kNoLifetime;
+  }
+
+  size_t GetStart() const {
+    return first_range_->GetStart();
+  }
+
+  size_t GetEnd() const {
+    return last_range_->GetEnd();
+  }
+
+  // Returns the first position at or after `position` where this interval
+  // needs to be in a register, or kNoLifetime if there is no such position.
+  size_t FirstRegisterUseAfter(size_t position) const {
+    if (is_temp_) {
+      return position == GetStart() ? position : kNoLifetime;
+    }
+    if (position == GetStart() && defined_by_ != nullptr) {
+      LocationSummary* locations = defined_by_->GetLocations();
+      Location location = locations->Out();
+      // This interval is the first interval of the instruction. If the output
+      // of the instruction requires a register, we return the position of that instruction
+      // as the first register use.
+      if (location.IsUnallocated()) {
+        if ((location.GetPolicy() == Location::kRequiresRegister)
+             || (location.GetPolicy() == Location::kSameAsFirstInput
+                 && locations->InAt(0).IsUnallocated()
+                 && locations->InAt(0).GetPolicy() == Location::kRequiresRegister)) {
+          return position;
+        }
+      }
+    }
+
+    UsePosition* use = first_use_;
+    size_t end = GetEnd();
+    while (use != nullptr && use->GetPosition() <= end) {
+      size_t use_position = use->GetPosition();
+      if (use_position >= position && !use->GetIsEnvironment()) {
+        Location location = use->GetUser()->GetLocations()->InAt(use->GetInputIndex());
+        if (location.IsUnallocated() && location.GetPolicy() == Location::kRequiresRegister) {
+          return use_position;
+        }
+      }
+      use = use->GetNext();
+    }
+    return kNoLifetime;
+  }
+
+  size_t FirstRegisterUse() const {
+    return FirstRegisterUseAfter(GetStart());
+  }
+
+  UsePosition* GetFirstUse() const {
+    return first_use_;
+  }
+
+  Primitive::Type GetType() const {
+    return type_;
+  }
+
+  HInstruction* GetDefinedBy() const {
+    return defined_by_;
+  }
+
+  /**
+   * Split this interval at `position`. This interval is changed to:
+   * [start ... position).
+   *
+   * The new interval covers:
+   * [position ... end)
+   */
+  LiveInterval* SplitAt(size_t position) {
+    DCHECK(!is_temp_);
+    DCHECK(!is_fixed_);
+    DCHECK_GT(position, GetStart());
+
+    if (last_range_->GetEnd() <= position) {
+      // This range dies before `position`, no need to split.
+      return nullptr;
+    }
+
+    LiveInterval* new_interval = new (allocator_) LiveInterval(allocator_, type_);
+    new_interval->next_sibling_ = next_sibling_;
+    next_sibling_ = new_interval;
+    new_interval->parent_ = parent_;
+
+    new_interval->first_use_ = first_use_;
+    LiveRange* current = first_range_;
+    LiveRange* previous = nullptr;
+    // Iterate over the ranges, and either find a range that covers this position, or
+    // two ranges in between this position (that is, the position is in a lifetime hole).
+    do {
+      if (position >= current->GetEnd()) {
+        // Move to next range.
+        previous = current;
+        current = current->next_;
+      } else if (position <= current->GetStart()) {
+        // If the previous range did not cover this position, we know position is in
+        // a lifetime hole. We can just break the first_range_ and last_range_ links
+        // and return the new interval.
+        DCHECK(previous != nullptr);
+        DCHECK(current != first_range_);
+        new_interval->last_range_ = last_range_;
+        last_range_ = previous;
+        previous->next_ = nullptr;
+        new_interval->first_range_ = current;
+        return new_interval;
+      } else {
+        // This range covers position. We create a new last_range_ for this interval
+        // that covers last_range_->Start() and position. We also shorten the current
+        // range and make it the first range of the new interval.
+        DCHECK(position < current->GetEnd() && position > current->GetStart());
+        new_interval->last_range_ = last_range_;
+        last_range_ = new (allocator_) LiveRange(current->start_, position, nullptr);
+        if (previous != nullptr) {
+          previous->next_ = last_range_;
+        } else {
+          first_range_ = last_range_;
+        }
+        new_interval->first_range_ = current;
+        current->start_ = position;
+        return new_interval;
+      }
+    } while (current != nullptr);
+
+    LOG(FATAL) << "Unreachable";
+    return nullptr;
+  }
+
+  bool StartsBefore(LiveInterval* other) const {
+    return GetStart() <= other->GetStart();
+  }
+
+  bool StartsAfter(LiveInterval* other) const {
+    return GetStart() >= other->GetStart();
+  }
+
+  LiveInterval* GetNextSibling() const { return next_sibling_; }
+
+  // Returns the sibling of this interval that is live at `position`, or
+  // nullptr if the instruction is not live at that position.
+  LiveInterval* GetSiblingAt(size_t position) {
+    LiveInterval* current = this;
+    while (current != nullptr && !current->Covers(position)) {
+      current = current->GetNextSibling();
+    }
+    return current;
+  }
+
+  void Dump(std::ostream& stream) const {
+    stream << "ranges: { ";
+    LiveRange* current = first_range_;
+    do {
+      current->Dump(stream);
+      stream << " ";
+    } while ((current = current->GetNext()) != nullptr);
+    stream << "}, uses: { ";
+    UsePosition* use = first_use_;
+    if (use != nullptr) {
+      do {
+        use->Dump(stream);
+        stream << " ";
+      } while ((use = use->GetNext()) != nullptr);
+    }
+    stream << "}";
+  }
+
+ private:
+  static constexpr size_t kNoSpillSlot = -1;
+
+  ArenaAllocator* const allocator_;
+
+  // Ranges of this interval. We need a quick access to the last range to test
+  // for liveness (see `IsDeadAt`).
+  LiveRange* first_range_;
+  LiveRange* last_range_;
+
+  // Uses of this interval. Note that this linked list is shared amongst siblings.
+  UsePosition* first_use_;
+
+  // The instruction type this interval corresponds to.
+  const Primitive::Type type_;
+
+  // Live interval that is the result of a split.
+  LiveInterval* next_sibling_;
+
+  // The first interval from which split intervals come from.
+  LiveInterval* parent_;
+
+  // The register allocated to this interval.
+  int register_;
+
+  // The spill slot allocated to this interval.
+  size_t spill_slot_;
+
+  // Whether the interval is for a fixed register.
+  const bool is_fixed_;
+
+  // Whether the interval is for a temporary.
+  const bool is_temp_;
+
+  // The instruction represented by this interval.
+  HInstruction* const defined_by_;
+
+  DISALLOW_COPY_AND_ASSIGN(LiveInterval);
+};
+
 class SsaLivenessAnalysis : public ValueObject {
  public:
   explicit SsaLivenessAnalysis(const HGraph& graph)
       : graph_(graph),
+        linear_order_(graph.GetArena(), graph.GetBlocks().Size()),
         block_infos_(graph.GetArena(), graph.GetBlocks().Size()),
+        instructions_from_ssa_index_(graph.GetArena(), 0),
+        instructions_from_lifetime_position_(graph.GetArena(), 0),
         number_of_ssa_values_(0) {
     block_infos_.SetSize(graph.GetBlocks().Size());
   }
@@ -67,7 +510,35 @@ class SsaLivenessAnalysis : public ValueObject {
     return &block_infos_.Get(block.GetBlockId())->kill_;
   }
 
+  // The order in which blocks are laid out for lifetime positions and code generation.
+  const GrowableArray<HBasicBlock*>& GetLinearOrder() const {
+    return linear_order_;
+  }
+
+  HInstruction* GetInstructionFromSsaIndex(size_t index) const {
+    return instructions_from_ssa_index_.Get(index);
+  }
+
+  // Returns the instruction at lifetime position `position`, or nullptr
+  // if `position` is the start of a block.
+  HInstruction* GetInstructionFromPosition(size_t position) const {
+    return instructions_from_lifetime_position_.Get(position / 2);
+  }
+
+  size_t GetMaxLifetimePosition() const {
+    return instructions_from_lifetime_position_.Size() * 2 - 1;
+  }
+
+  size_t GetNumberOfSsaValues() const {
+    return number_of_ssa_values_;
+  }
+
  private:
+  // Compute the linear order of blocks. We use the reverse post order: a block
+  // is after its dominator, and a block inserted to split a critical edge directly
+  // follows the block it comes from.
+  void LinearizeGraph();
+
   // Give an SSA number to each instruction that defines a value used by another instruction.
   void NumberInstructions();
 
@@ -89,8 +560,19 @@ class SsaLivenessAnalysis : public ValueObject {
   // Update the live_out set of the block and returns whether it has changed.
   bool UpdateLiveOut(const HBasicBlock& block);
 
+  // Compute the live interval of each SSA value, using the live_out sets.
+  void ComputeLiveRanges();
+
   const HGraph& graph_;
+  GrowableArray<HBasicBlock*> linear_order_;
   GrowableArray<BlockInfo*> block_infos_;
+
+  // Map from SSA index to the instruction defining the value.
+  GrowableArray<HInstruction*> instructions_from_ssa_index_;
+
+  // Map from lifetime position (divided by two) to the instruction at that
+  // position. Used when inserting moves in the graph.
+  GrowableArray<HInstruction*> instructions_from_lifetime_position_;
   size_t number_of_ssa_values_;
 
   DISALLOW_COPY_AND_ASSIGN(SsaLivenessAnalysis);
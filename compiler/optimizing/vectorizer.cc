@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vectorizer.h"
+
+#include "bounds_check_elimination.h"
+
+namespace art {
+
+static HInstruction* SkipNullCheck(HInstruction* instruction) {
+  HNullCheck* null_check = instruction->AsNullCheck();
+  return null_check == nullptr ? instruction : null_check->InputAt(0);
+}
+
+static void ReplacePhiInput(HPhi* phi, size_t index, HInstruction* replacement) {
+  phi->InputAt(index)->RemoveUser(phi, index);
+  phi->SetRawInputAt(index, replacement);
+  replacement->AddUseAt(phi, index);
+}
+
+// Returns whether `instruction` accesses the int element at `index` of an
+// array defined before the loop.
+static bool IsElementAccess(HInstruction* instruction,
+                            HPhi* index,
+                            HLoopInformation* loop_info) {
+  HInstruction* array = SkipNullCheck(instruction->InputAt(0));
+  HInstruction* element = instruction->InputAt(1);
+  if (element->AsBoundsCheck() != nullptr) {
+    element = element->InputAt(0);
+  }
+  return element == index && !loop_info->Contains(*array->GetBlock());
+}
+
+// Returns whether the checks of the loop body only test the arrays in
+// `arrays`, which the vectorized loop is known to access safely.
+static bool ChecksCoveredArrays(HBasicBlock* body,
+                                HPhi* index,
+                                HInstruction* const* arrays,
+                                size_t number_of_arrays) {
+  for (HInstructionIterator it(*body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    HInstruction* array = nullptr;
+    if (instruction->AsNullCheck() != nullptr || instruction->AsArrayLength() != nullptr) {
+      array = instruction->InputAt(0);
+    } else if (instruction->AsBoundsCheck() != nullptr) {
+      HInstruction* length = instruction->InputAt(1);
+      if (instruction->InputAt(0) != index || length->AsArrayLength() == nullptr) {
+        return false;
+      }
+      array = length->InputAt(0);
+    } else {
+      continue;
+    }
+
+    array = SkipNullCheck(array);
+    bool covered = false;
+    for (size_t i = 0; i < number_of_arrays; ++i) {
+      covered = covered || (array == arrays[i]);
+    }
+    if (!covered) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HVectorizer::CanVectorize() const {
+  switch (instruction_set_) {
+    case kArm:
+    case kThumb2:
+      return instruction_set_features_.HasNeon();
+    case kX86:
+      // SSE2 is part of the baseline of the x86 targets.
+      return true;
+    default:
+      return false;
+  }
+}
+
+void HVectorizer::Run() {
+  if (!CanVectorize()) {
+    return;
+  }
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader()) {
+      TryVectorize(block->GetLoopInformation());
+    }
+  }
+}
+
+bool HVectorizer::TryVectorize(HLoopInformation* loop_info) {
+  // The loop must be made of its header and a single body block, and be
+  // entered from a pre header that only leads to it.
+  HBasicBlock* header = loop_info->GetHeader();
+  HBasicBlock* pre_header = loop_info->GetPreHeader();
+  if (header->NumberOfBackEdges() != 1
+      || header->GetPredecessors()->Size() != 2
+      || pre_header->GetSuccessors()->Size() != 1) {
+    return false;
+  }
+  HBasicBlock* body = loop_info->GetBackEdges()->Get(0);
+  if (body->GetPredecessors()->Size() != 1
+      || body->GetPredecessors()->Get(0) != header
+      || body->GetSuccessors()->Size() != 1) {
+    return false;
+  }
+  loop_info->Populate();
+  size_t pre_header_index = header->GetPredecessorIndexOf(pre_header);
+  size_t back_edge_index = header->GetPredecessorIndexOf(body);
+
+  // The header only evaluates the loop condition.
+  HIf* branch = header->GetLastInstruction()->AsIf();
+  HCondition* condition = (branch == nullptr) ? nullptr : branch->InputAt(0)->AsCondition();
+  if (condition == nullptr
+      || header->GetFirstInstruction() != condition
+      || condition->GetNext() != branch) {
+    return false;
+  }
+
+  // Find the induction variable, compared with the loop invariant bound, and
+  // the optional sum.
+  HPhi* index = nullptr;
+  HPhi* sum = nullptr;
+  for (HInstructionIterator it(*header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (index == nullptr && (phi == condition->GetLeft() || phi == condition->GetRight())) {
+      index = phi;
+    } else if (sum == nullptr && phi->GetType() == Primitive::kPrimInt) {
+      sum = phi;
+    } else {
+      return false;
+    }
+  }
+  if (index == nullptr) {
+    return false;
+  }
+  HAdd* increment = BoundsCheckElimination::FindUnitStrideIncrement(index);
+  HInstruction* to = (condition->GetLeft() == index) ? condition->GetRight() : condition->GetLeft();
+  if (increment == nullptr
+      || increment->GetBlock() != body
+      || to->GetType() != Primitive::kPrimInt
+      || loop_info->Contains(*to->GetBlock())
+      || BoundsCheckElimination::GetInBoundsSuccessor(condition, index, to) != body) {
+    return false;
+  }
+  int32_t from = index->InputAt(pre_header_index)->AsIntConstant()->GetValue();
+
+  // Classify the instructions of the body.
+  HArraySet* store = nullptr;
+  HBinaryOperation* operation = nullptr;
+  HAdd* reduction = nullptr;
+  size_t number_of_loads = 0;
+  for (HInstructionIterator it(*body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction == increment
+        || instruction->AsGoto() != nullptr
+        // Temporaries are only markers for the baseline compiler.
+        || instruction->AsTemporary() != nullptr
+        || instruction->AsNullCheck() != nullptr
+        || instruction->AsArrayLength() != nullptr
+        || instruction->AsBoundsCheck() != nullptr) {
+      // The checks are verified once the arrays accessed are known.
+      continue;
+    }
+    if (instruction->AsArrayGet() != nullptr) {
+      if (instruction->GetType() != Primitive::kPrimInt
+          || !IsElementAccess(instruction, index, loop_info)) {
+        return false;
+      }
+      ++number_of_loads;
+    } else if (instruction->AsArraySet() != nullptr) {
+      if (store != nullptr
+          || instruction->AsArraySet()->GetComponentType() != Primitive::kPrimInt
+          || !IsElementAccess(instruction, index, loop_info)) {
+        return false;
+      }
+      store = instruction->AsArraySet();
+    } else if (instruction->AsAdd() != nullptr || instruction->AsSub() != nullptr) {
+      HBinaryOperation* binary = instruction->AsBinaryOperation();
+      if (binary->GetResultType() != Primitive::kPrimInt) {
+        return false;
+      }
+      if (sum != nullptr && instruction == sum->InputAt(back_edge_index)) {
+        reduction = instruction->AsAdd();
+        if (reduction == nullptr
+            || (reduction->GetLeft() != sum && reduction->GetRight() != sum)) {
+          return false;
+        }
+      } else if (operation == nullptr) {
+        operation = binary;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* cursor = pre_header->GetLastInstruction();
+
+  if (sum != nullptr) {
+    // The sum must only be updated by the reduction, over the whole array.
+    if (reduction == nullptr || store != nullptr || operation != nullptr || number_of_loads != 1) {
+      return false;
+    }
+    for (HUseIterator<HInstruction> it(sum->GetUses()); !it.Done(); it.Advance()) {
+      HInstruction* user = it.Current()->GetUser();
+      if (user != reduction && loop_info->Contains(*user->GetBlock())) {
+        return false;
+      }
+    }
+    HInstruction* load =
+        (reduction->GetLeft() == sum) ? reduction->GetRight() : reduction->GetLeft();
+    HArrayLength* length = to->AsArrayLength();
+    if (load->AsArrayGet() == nullptr
+        || load->GetBlock() != body
+        || from != 0
+        || length == nullptr
+        // The array is known to be non null before the loop.
+        || length->InputAt(0)->AsNullCheck() == nullptr) {
+      return false;
+    }
+    HInstruction* array = SkipNullCheck(length->InputAt(0));
+    if (SkipNullCheck(load->InputAt(0)) != array || !ChecksCoveredArrays(body, index, &array, 1)) {
+      return false;
+    }
+
+    HVecSum* vector_sum = new (arena) HVecSum(length->InputAt(0));
+    pre_header->InsertInstructionBefore(vector_sum, cursor);
+    HAdd* initial_sum = new (arena) HAdd(
+        Primitive::kPrimInt, sum->InputAt(pre_header_index), vector_sum);
+    pre_header->InsertInstructionBefore(initial_sum, cursor);
+    ReplacePhiInput(sum, pre_header_index, initial_sum);
+    ReplacePhiInput(index, pre_header_index, to);
+    return true;
+  }
+
+  if (store == nullptr || reduction != nullptr) {
+    return false;
+  }
+  HInstruction* destination = SkipNullCheck(store->InputAt(0));
+  HInstruction* value = store->InputAt(2);
+  HInstruction* vector_operation = nullptr;
+  if (!loop_info->Contains(*value->GetBlock())) {
+    if (operation != nullptr || number_of_loads != 0
+        || !ChecksCoveredArrays(body, index, &destination, 1)) {
+      return false;
+    }
+    vector_operation = new (arena) HVecFill(from, to, destination, value);
+  } else if (value->AsArrayGet() != nullptr) {
+    HInstruction* arrays[] = { destination, SkipNullCheck(value->InputAt(0)) };
+    if (operation != nullptr || number_of_loads != 1
+        || !ChecksCoveredArrays(body, index, arrays, arraysize(arrays))) {
+      return false;
+    }
+    vector_operation = new (arena) HVecCopy(from, to, arrays[0], arrays[1]);
+  } else if (value == operation) {
+    HInstruction* left = operation->GetLeft();
+    HInstruction* right = operation->GetRight();
+    if (left->AsArrayGet() == nullptr || right->AsArrayGet() == nullptr) {
+      return false;
+    }
+    HInstruction* arrays[] = {
+        destination, SkipNullCheck(left->InputAt(0)), SkipNullCheck(right->InputAt(0)) };
+    if (number_of_loads != ((left == right) ? 1u : 2u)
+        || !ChecksCoveredArrays(body, index, arrays, arraysize(arrays))) {
+      return false;
+    }
+    if (operation->AsAdd() != nullptr) {
+      vector_operation = new (arena) HVecAdd(from, to, arrays[0], arrays[1], arrays[2]);
+    } else {
+      vector_operation = new (arena) HVecSub(from, to, arrays[0], arrays[1], arrays[2]);
+    }
+  } else {
+    return false;
+  }
+
+  // The loop resumes where the vector instruction stopped.
+  pre_header->InsertInstructionBefore(vector_operation, cursor);
+  ReplacePhiInput(index, pre_header_index, vector_operation);
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_VECTORIZER_H_
+#define ART_COMPILER_OPTIMIZING_VECTORIZER_H_
+
+#include "instruction_set.h"
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Optimization pass processing the int arrays of simple counted loops several
+ * elements at a time, with the SIMD instructions of the target. The loops
+ * considered have a single body block, indexed by a unit stride induction
+ * variable, which either stores in an array a loop invariant value, an
+ * element of another array, or the sum or difference of elements of two
+ * arrays, or which sums the elements of an array. A vector instruction
+ * inserted before the loop does most of the work, and the loop processes the
+ * remaining elements, or all of them if the arrays cannot be accessed, so
+ * that exceptions are still thrown where expected.
+ */
+class HVectorizer : public HOptimization {
+ public:
+  HVectorizer(HGraph* graph,
+              InstructionSet instruction_set,
+              const InstructionSetFeatures& instruction_set_features)
+      : HOptimization(graph, kVectorizerPassName),
+        instruction_set_(instruction_set),
+        instruction_set_features_(instruction_set_features) {}
+
+  virtual void Run() OVERRIDE;
+
+  static constexpr const char* kVectorizerPassName = "vectorizer";
+
+ private:
+  // Returns whether the code generator of the target has vector instructions.
+  bool CanVectorize() const;
+
+  bool TryVectorize(HLoopInformation* loop_info);
+
+  const InstructionSet instruction_set_;
+  const InstructionSetFeatures instruction_set_features_;
+
+  DISALLOW_COPY_AND_ASSIGN(HVectorizer);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_VECTORIZER_H_
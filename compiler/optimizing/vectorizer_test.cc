@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "nodes.h"
+#include "vectorizer.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+enum LoopBody {
+  // a[i] = b[i] + c[i];
+  kAddArrays,
+  // a[i] = b[i] + c[i]; d.length;
+  kAddArraysAndCheckOtherArray,
+  // sum += a[i];
+  kSumArray,
+};
+
+/**
+ * Builds the graph of the following loop, once the null check of `a` and its
+ * length have been hoisted before it, and returns its header:
+ *
+ *   for (int i = 0; i < a.length; ++i) {
+ *     <body>
+ *   }
+ *   return sum;
+ */
+static HBasicBlock* BuildArrayLoop(ArenaAllocator* allocator, LoopBody kind) {
+  HGraph* graph = new (allocator) HGraph(allocator);
+  HBasicBlock* entry = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  HInstruction* a = new (allocator) HParameterValue(0, Primitive::kPrimNot);
+  HInstruction* b = new (allocator) HParameterValue(1, Primitive::kPrimNot);
+  HInstruction* c = new (allocator) HParameterValue(2, Primitive::kPrimNot);
+  HInstruction* d = new (allocator) HParameterValue(3, Primitive::kPrimNot);
+  HInstruction* zero = new (allocator) HIntConstant(0);
+  HInstruction* one = new (allocator) HIntConstant(1);
+  entry->AddInstruction(a);
+  entry->AddInstruction(b);
+  entry->AddInstruction(c);
+  entry->AddInstruction(d);
+  entry->AddInstruction(zero);
+  entry->AddInstruction(one);
+  entry->AddInstruction(new (allocator) HGoto());
+
+  HBasicBlock* header = new (allocator) HBasicBlock(graph);
+  HBasicBlock* body = new (allocator) HBasicBlock(graph);
+  HBasicBlock* return_block = new (allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (allocator) HBasicBlock(graph);
+  graph->AddBlock(header);
+  graph->AddBlock(body);
+  graph->AddBlock(return_block);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  entry->AddSuccessor(header);
+  header->AddSuccessor(return_block);
+  header->AddSuccessor(body);
+  body->AddSuccessor(header);
+  return_block->AddSuccessor(exit);
+  body->AddInstruction(new (allocator) HGoto());
+  exit->AddInstruction(new (allocator) HExit());
+
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+
+  // The loop is built in SSA form directly.
+  HInstruction* a_checked = new (allocator) HNullCheck(a, 0);
+  HInstruction* length = new (allocator) HArrayLength(a_checked);
+  entry->InsertInstructionBefore(a_checked, entry->GetLastInstruction());
+  entry->InsertInstructionBefore(length, entry->GetLastInstruction());
+
+  HPhi* index = new (allocator) HPhi(allocator, 0, 0, Primitive::kPrimInt);
+  header->AddPhi(index);
+  HPhi* sum = nullptr;
+  HInstruction* cursor = body->GetLastInstruction();
+  if (kind == kSumArray) {
+    sum = new (allocator) HPhi(allocator, 1, 0, Primitive::kPrimInt);
+    header->AddPhi(sum);
+    HInstruction* load = new (allocator) HArrayGet(a_checked, index, Primitive::kPrimInt);
+    HInstruction* add = new (allocator) HAdd(Primitive::kPrimInt, sum, load);
+    body->InsertInstructionBefore(load, cursor);
+    body->InsertInstructionBefore(add, cursor);
+    sum->AddInput(zero);
+    sum->AddInput(add);
+  } else {
+    HInstruction* loads[2];
+    HInstruction* arrays[] = { b, c };
+    for (size_t i = 0; i < 2; ++i) {
+      HInstruction* checked = new (allocator) HNullCheck(arrays[i], 0);
+      HInstruction* array_length = new (allocator) HArrayLength(checked);
+      HInstruction* bounds_check = new (allocator) HBoundsCheck(index, array_length, 0);
+      loads[i] = new (allocator) HArrayGet(checked, bounds_check, Primitive::kPrimInt);
+      body->InsertInstructionBefore(checked, cursor);
+      body->InsertInstructionBefore(array_length, cursor);
+      body->InsertInstructionBefore(bounds_check, cursor);
+      body->InsertInstructionBefore(loads[i], cursor);
+    }
+    HInstruction* add = new (allocator) HAdd(Primitive::kPrimInt, loads[0], loads[1]);
+    body->InsertInstructionBefore(add, cursor);
+    body->InsertInstructionBefore(
+        new (allocator) HArraySet(a_checked, index, add, Primitive::kPrimInt), cursor);
+    if (kind == kAddArraysAndCheckOtherArray) {
+      HInstruction* checked = new (allocator) HNullCheck(d, 0);
+      body->InsertInstructionBefore(checked, cursor);
+      body->InsertInstructionBefore(new (allocator) HArrayLength(checked), cursor);
+    }
+  }
+  HInstruction* increment = new (allocator) HAdd(Primitive::kPrimInt, index, one);
+  body->InsertInstructionBefore(increment, cursor);
+  index->AddInput(zero);
+  index->AddInput(increment);
+
+  // The loop is exited when the condition is true.
+  HInstruction* condition = new (allocator) HGreaterThanOrEqual(index, length);
+  header->AddInstruction(condition);
+  header->AddInstruction(new (allocator) HIf(condition));
+  return_block->AddInstruction(new (allocator) HReturn((sum == nullptr) ? zero : sum));
+  return header;
+}
+
+static void RunVectorizer(HBasicBlock* header, InstructionSet instruction_set, bool has_neon) {
+  InstructionSetFeatures features;
+  features.SetHasNeon(has_neon);
+  HVectorizer(header->GetGraph(), instruction_set, features).Run();
+}
+
+static HPhi* GetPhi(HBasicBlock* header, size_t index) {
+  HInstructionIterator it(*header->GetPhis());
+  for (size_t i = 0; i < index; ++i) {
+    it.Advance();
+  }
+  return it.Current()->AsPhi();
+}
+
+TEST(VectorizerTest, AddArrays) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBasicBlock* header = BuildArrayLoop(&allocator, kAddArrays);
+  HBasicBlock* pre_header = header->GetLoopInformation()->GetPreHeader();
+  HPhi* index = GetPhi(header, 0);
+  RunVectorizer(header, kX86, false);
+
+  // The loop resumes at the index returned by the vector instruction.
+  HVecAdd* vector_add = index->InputAt(0)->AsVecAdd();
+  ASSERT_NE(vector_add, nullptr);
+  ASSERT_EQ(vector_add->GetBlock(), pre_header);
+  ASSERT_EQ(vector_add->GetFrom(), 0);
+  ASSERT_EQ(vector_add->GetTo(), header->GetFirstInstruction()->InputAt(1));
+  ASSERT_NE(vector_add->GetDestination()->AsParameterValue(), nullptr);
+  ASSERT_EQ(vector_add->GetDestination()->AsParameterValue()->GetIndex(), 0);
+  ASSERT_EQ(vector_add->GetLeft()->AsParameterValue()->GetIndex(), 1);
+  ASSERT_EQ(vector_add->GetRight()->AsParameterValue()->GetIndex(), 2);
+}
+
+TEST(VectorizerTest, ArmNeedsNeon) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBasicBlock* header = BuildArrayLoop(&allocator, kAddArrays);
+  RunVectorizer(header, kThumb2, false);
+  ASSERT_NE(GetPhi(header, 0)->InputAt(0)->AsIntConstant(), nullptr);
+
+  RunVectorizer(header, kThumb2, true);
+  ASSERT_NE(GetPhi(header, 0)->InputAt(0)->AsVecAdd(), nullptr);
+}
+
+TEST(VectorizerTest, UncoveredCheck) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  // The vector instruction does not test `d`, whose null check must throw on
+  // the first iteration.
+  HBasicBlock* header = BuildArrayLoop(&allocator, kAddArraysAndCheckOtherArray);
+  RunVectorizer(header, kX86, false);
+
+  ASSERT_NE(GetPhi(header, 0)->InputAt(0)->AsIntConstant(), nullptr);
+}
+
+TEST(VectorizerTest, SumArray) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HBasicBlock* header = BuildArrayLoop(&allocator, kSumArray);
+  HBasicBlock* pre_header = header->GetLoopInformation()->GetPreHeader();
+  HPhi* index = GetPhi(header, 0);
+  HPhi* sum = GetPhi(header, 1);
+  HInstruction* length = header->GetFirstInstruction()->InputAt(1);
+  RunVectorizer(header, kX86, false);
+
+  // The loop is skipped, and the sum starts with the sum of the array.
+  ASSERT_EQ(index->InputAt(0), length);
+  HAdd* initial_sum = sum->InputAt(0)->AsAdd();
+  ASSERT_NE(initial_sum, nullptr);
+  ASSERT_EQ(initial_sum->GetBlock(), pre_header);
+  ASSERT_NE(initial_sum->GetLeft()->AsIntConstant(), nullptr);
+  HVecSum* vector_sum = initial_sum->GetRight()->AsVecSum();
+  ASSERT_NE(vector_sum, nullptr);
+  ASSERT_EQ(vector_sum->InputAt(0), length->InputAt(0));
+}
+
+}  // namespace art
@@ -17,6 +17,8 @@
 #ifndef ART_COMPILER_SEA_IR_TYPES_TYPE_INFERENCE_H_
 #define ART_COMPILER_SEA_IR_TYPES_TYPE_INFERENCE_H_
 
+#include "base/scoped_arena_allocator.h"
+#include "runtime.h"
 #include "safe_map.h"
 #include "dex_file-inl.h"
 #include "sea_ir/types/types.h"
@@ -31,7 +33,9 @@ class InstructionNode;
 // precise verification (which is the job of the verifier).
 class TypeInference {
  public:
-  TypeInference() : type_cache_(new art::verifier::RegTypeCache(false)) {
+  TypeInference()
+      : arena_stack_(art::Runtime::Current()->GetArenaPool()), arena_(&arena_stack_),
+        type_cache_(new art::verifier::RegTypeCache(false, arena_)) {
   }
 
   // Computes the types for the method with SEA IR representation provided by @graph.
@@ -42,6 +46,8 @@ class TypeInference {
   }
   // Returns true if @descriptor corresponds to a primitive type.
   static bool IsPrimitiveDescriptor(char descriptor);
+  art::ArenaStack arena_stack_;
+  art::ScopedArenaAllocator arena_;
   TypeData type_data_;    // TODO: Make private, add accessor and not publish a SafeMap above.
   art::verifier::RegTypeCache* const type_cache_;    // TODO: Make private.
 };
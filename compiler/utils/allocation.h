@@ -17,7 +17,7 @@
 #ifndef ART_COMPILER_UTILS_ALLOCATION_H_
 #define ART_COMPILER_UTILS_ALLOCATION_H_
 
-#include "arena_allocator.h"
+#include "base/arena_allocator.h"
 #include "base/logging.h"
 
 namespace art {
@@ -15,7 +15,7 @@
  */
 
 #include "gtest/gtest.h"
-#include "utils/arena_allocator.h"
+#include "base/arena_allocator.h"
 #include "utils/arena_bit_vector.h"
 
 namespace art {
@@ -30,4 +30,54 @@ TEST(ArenaAllocator, Test) {
   EXPECT_EQ(2U, bv.GetStorageSize());
 }
 
+TEST(ArenaAllocator, CountAllocations) {
+  ArenaPool counting_pool(true);
+  {
+    ArenaAllocator arena(&counting_pool);
+    arena.Alloc(12, kArenaAllocMisc);
+    arena.Alloc(5, kArenaAllocLIR);
+    EXPECT_EQ(20U, arena.BytesAllocated());
+  }
+  ArenaPool pool(false);
+  {
+    ArenaAllocator arena(&pool);
+    arena.Alloc(12, kArenaAllocMisc);
+    EXPECT_EQ(0U, arena.BytesAllocated());
+  }
+}
+
+TEST(ArenaAllocator, BytesUsed) {
+  ArenaPool pool(false);
+  ArenaAllocator arena(&pool);
+  EXPECT_EQ(0U, arena.BytesUsed());
+  arena.Alloc(12, kArenaAllocMisc);
+  EXPECT_EQ(12U, arena.BytesUsed());
+  // Does not fit in the first arena.
+  arena.Alloc(Arena::kDefaultSize, kArenaAllocMisc);
+  arena.Alloc(5, kArenaAllocLIR);
+  EXPECT_EQ(20U + Arena::kDefaultSize, arena.BytesUsed());
+}
+
+TEST(ArenaAllocator, ReleaseArenas) {
+  // The pool only keeps one default size arena.
+  ArenaPool pool(false, Arena::kDefaultSize);
+  uint8_t* kept_arena;
+  {
+    ArenaAllocator arena(&pool);
+    arena.Alloc(Arena::kDefaultSize, kArenaAllocMisc);
+    kept_arena = reinterpret_cast<uint8_t*>(arena.Alloc(Arena::kDefaultSize, kArenaAllocMisc));
+    kept_arena[0] = 1u;
+    // Too large to be kept.
+    arena.Alloc(2 * Arena::kDefaultSize, kArenaAllocMisc);
+  }
+  {
+    // The arenas are given back newest first: the large one is released, the
+    // second one is kept, and the first one is above the limit.
+    ArenaAllocator arena(&pool);
+    uint8_t* reused = reinterpret_cast<uint8_t*>(arena.Alloc(16, kArenaAllocMisc));
+    EXPECT_TRUE(reused == kept_arena);
+    EXPECT_EQ(0U, reused[0]);
+  }
+}
+
 }  // namespace art
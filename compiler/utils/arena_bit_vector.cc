@@ -14,9 +14,10 @@
  * limitations under the License.
  */
 
-#include "arena_allocator.h"
 #include "arena_bit_vector.h"
 
+#include "base/arena_allocator.h"
+
 namespace art {
 
 template <typename ArenaAlloc>
@@ -18,8 +18,8 @@
 #define ART_COMPILER_UTILS_ARENA_BIT_VECTOR_H_
 
 #include "base/bit_vector.h"
-#include "utils/arena_allocator.h"
-#include "utils/scoped_arena_allocator.h"
+#include "base/arena_allocator.h"
+#include "base/scoped_arena_allocator.h"
 
 namespace art {
 
@@ -1028,6 +1028,104 @@ void ArmAssembler::vmstat(Condition cond) {  // VMRS APSR_nzcv, FPSCR
 }
 
 
+void ArmAssembler::EmitNeonddd(int32_t opcode,
+                               DRegister dd, DRegister dn, DRegister dm) {
+  CHECK_NE(dd, kNoDRegister);
+  CHECK_NE(dn, kNoDRegister);
+  CHECK_NE(dm, kNoDRegister);
+  // Advanced SIMD data-processing instructions are unconditional.
+  int32_t encoding = (kSpecialCondition << kConditionShift) | B25 | opcode |
+                     ((static_cast<int32_t>(dd) >> 4)*B22) |
+                     ((static_cast<int32_t>(dn) & 0xf)*B16) |
+                     ((static_cast<int32_t>(dd) & 0xf)*B12) |
+                     ((static_cast<int32_t>(dn) >> 4)*B7) |
+                     ((static_cast<int32_t>(dm) >> 4)*B5) |
+                     (static_cast<int32_t>(dm) & 0xf);
+  Emit(encoding);
+}
+
+
+void ArmAssembler::EmitNeonqqq(int32_t opcode,
+                               QRegister qd, QRegister qn, QRegister qm) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(qn, kNoQRegister);
+  CHECK_NE(qm, kNoQRegister);
+  EmitNeonddd(opcode | B6,
+              static_cast<DRegister>(qd * 2),
+              static_cast<DRegister>(qn * 2),
+              static_cast<DRegister>(qm * 2));
+}
+
+
+void ArmAssembler::EmitNeonLoadStore(int32_t opcode, QRegister qd, Register rn) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(rn, kNoRegister);
+  CHECK_NE(rn, PC);
+  int32_t d = static_cast<int32_t>(qd) * 2;
+  // Two registers of 32-bit elements, with no alignment requirement and no
+  // write back (Rm is PC).
+  int32_t encoding = (kSpecialCondition << kConditionShift) | B26 | opcode |
+                     ((d >> 4)*B22) |
+                     (static_cast<int32_t>(rn)*B16) |
+                     ((d & 0xf)*B12) |
+                     B11 | B9 | B7 |
+                     static_cast<int32_t>(PC);
+  Emit(encoding);
+}
+
+
+void ArmAssembler::vld1q32(QRegister qd, Register rn) {
+  EmitNeonLoadStore(B21, qd, rn);
+}
+
+
+void ArmAssembler::vst1q32(QRegister qd, Register rn) {
+  EmitNeonLoadStore(0, qd, rn);
+}
+
+
+void ArmAssembler::vdupq32(QRegister qd, Register rt, Condition cond) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(rt, kNoRegister);
+  CHECK_NE(rt, SP);
+  CHECK_NE(rt, PC);
+  CHECK_NE(cond, kNoCondition);
+  int32_t d = static_cast<int32_t>(qd) * 2;
+  int32_t encoding = (static_cast<int32_t>(cond) << kConditionShift) |
+                     B27 | B26 | B25 | B23 | B21 |
+                     ((d & 0xf)*B16) |
+                     (static_cast<int32_t>(rt)*B12) |
+                     B11 | B9 | B8 |
+                     ((d >> 4)*B7) | B4;
+  Emit(encoding);
+}
+
+
+void ArmAssembler::vaddqi32(QRegister qd, QRegister qn, QRegister qm) {
+  EmitNeonqqq(B21 | B11, qd, qn, qm);
+}
+
+
+void ArmAssembler::vsubqi32(QRegister qd, QRegister qn, QRegister qm) {
+  EmitNeonqqq(B24 | B21 | B11, qd, qn, qm);
+}
+
+
+void ArmAssembler::veorq(QRegister qd, QRegister qn, QRegister qm) {
+  EmitNeonqqq(B24 | B8 | B4, qd, qn, qm);
+}
+
+
+void ArmAssembler::vaddi32(DRegister dd, DRegister dn, DRegister dm) {
+  EmitNeonddd(B21 | B11, dd, dn, dm);
+}
+
+
+void ArmAssembler::vpaddi32(DRegister dd, DRegister dn, DRegister dm) {
+  EmitNeonddd(B21 | B11 | B9 | B8 | B4, dd, dn, dm);
+}
+
+
 void ArmAssembler::svc(uint32_t imm24) {
   CHECK(IsUint(24, imm24)) << imm24;
   int32_t encoding = (AL << kConditionShift) | B27 | B26 | B25 | B24 | imm24;
@@ -358,6 +358,18 @@ class ArmAssembler FINAL : public Assembler {
   void vcmpdz(DRegister dd, Condition cond = AL);
   void vmstat(Condition cond = AL);  // VMRS APSR_nzcv, FPSCR
 
+  // Advanced SIMD (NEON) integer instructions. The q variants work on four
+  // 32-bit lanes, the others on two. Loads and stores do not need aligned
+  // addresses.
+  void vld1q32(QRegister qd, Register rn);
+  void vst1q32(QRegister qd, Register rn);
+  void vdupq32(QRegister qd, Register rt, Condition cond = AL);
+  void vaddqi32(QRegister qd, QRegister qn, QRegister qm);
+  void vsubqi32(QRegister qd, QRegister qn, QRegister qm);
+  void veorq(QRegister qd, QRegister qn, QRegister qm);
+  void vaddi32(DRegister dd, DRegister dn, DRegister dm);
+  void vpaddi32(DRegister dd, DRegister dn, DRegister dm);
+
   // Branch instructions.
   void b(Label* label, Condition cond = AL);
   void bl(Label* label, Condition cond = AL);
@@ -619,6 +631,18 @@ class ArmAssembler FINAL : public Assembler {
                  DRegister dd,
                  SRegister sm);
 
+  void EmitNeonddd(int32_t opcode,
+                   DRegister dd,
+                   DRegister dn,
+                   DRegister dm);
+
+  void EmitNeonqqq(int32_t opcode,
+                   QRegister qd,
+                   QRegister qn,
+                   QRegister qm);
+
+  void EmitNeonLoadStore(int32_t opcode, QRegister qd, Register rn);
+
   void EmitBranch(Condition cond, Label* label, bool link);
   static int32_t EncodeBranchOffset(int offset, int32_t inst);
   static int DecodeBranchOffset(int32_t inst);
@@ -100,6 +100,30 @@ enum DRegister {
 std::ostream& operator<<(std::ostream& os, const DRegister& rhs);
 
 
+// Values for the quadword registers of the Advanced SIMD (NEON) extension.
+// Qn overlaps D(2n) and D(2n+1).
+enum QRegister {
+  Q0  =  0,
+  Q1  =  1,
+  Q2  =  2,
+  Q3  =  3,
+  Q4  =  4,
+  Q5  =  5,
+  Q6  =  6,
+  Q7  =  7,
+  Q8  =  8,
+  Q9  =  9,
+  Q10 = 10,
+  Q11 = 11,
+  Q12 = 12,
+  Q13 = 13,
+  Q14 = 14,
+  Q15 = 15,
+  kNumberOfQRegisters = 16,
+  kNoQRegister = -1,
+};
+
+
 // Values for the condition field as defined in section A3.2.
 enum Condition {
   kNoCondition = -1,
@@ -16,6 +16,8 @@
 
 #include "assembler.h"
 
+#include <pthread.h>
+
 #include <algorithm>
 #include <vector>
 
@@ -29,6 +31,39 @@
 
 namespace art {
 
+// The data area of the last assembler buffer each thread destroyed, reused by the next buffer
+// the thread creates, since the compiler threads assemble one method after the other.
+struct CachedContents {
+  byte* contents;
+  size_t capacity;
+};
+
+static pthread_key_t cached_contents_key;
+static pthread_once_t cached_contents_key_once = PTHREAD_ONCE_INIT;
+
+static void DeleteCachedContents(void* arg) {
+  CachedContents* cached = reinterpret_cast<CachedContents*>(arg);
+  delete[] cached->contents;
+  delete cached;
+}
+
+static void CreateCachedContentsKey() {
+  CHECK_PTHREAD_CALL(pthread_key_create, (&cached_contents_key, DeleteCachedContents),
+                     "assembler buffer cache key");
+}
+
+static CachedContents* GetCachedContents() {
+  pthread_once(&cached_contents_key_once, CreateCachedContentsKey);
+  CachedContents* cached = reinterpret_cast<CachedContents*>(
+      pthread_getspecific(cached_contents_key));
+  if (cached == NULL) {
+    cached = new CachedContents();
+    CHECK_PTHREAD_CALL(pthread_setspecific, (cached_contents_key, cached),
+                       "assembler buffer cache");
+  }
+  return cached;
+}
+
 static byte* NewContents(size_t capacity) {
   return new byte[capacity];
 }
@@ -36,9 +71,19 @@ static byte* NewContents(size_t capacity) {
 
 AssemblerBuffer::AssemblerBuffer() {
   static const size_t kInitialBufferCapacity = 4 * KB;
-  contents_ = NewContents(kInitialBufferCapacity);
+  CachedContents* cached = GetCachedContents();
+  size_t capacity;
+  if (cached->contents != NULL) {
+    contents_ = cached->contents;
+    capacity = cached->capacity;
+    cached->contents = NULL;
+    cached->capacity = 0;
+  } else {
+    contents_ = NewContents(kInitialBufferCapacity);
+    capacity = kInitialBufferCapacity;
+  }
   cursor_ = contents_;
-  limit_ = ComputeLimit(contents_, kInitialBufferCapacity);
+  limit_ = ComputeLimit(contents_, capacity);
   fixup_ = NULL;
   slow_path_ = NULL;
 #ifndef NDEBUG
@@ -47,13 +92,24 @@ AssemblerBuffer::AssemblerBuffer() {
 #endif
 
   // Verify internal state.
-  CHECK_EQ(Capacity(), kInitialBufferCapacity);
+  CHECK_EQ(Capacity(), capacity);
   CHECK_EQ(Size(), 0U);
 }
 
 
 AssemblerBuffer::~AssemblerBuffer() {
-  delete[] contents_;
+  // Keep the data area for the next buffer of the thread, unless it is only needed by the
+  // largest methods, or the thread keeps a larger one already.
+  static const size_t kMaxCachedCapacity = 256 * KB;
+  CachedContents* cached = GetCachedContents();
+  size_t capacity = Capacity();
+  if (capacity <= kMaxCachedCapacity && capacity > cached->capacity) {
+    delete[] cached->contents;
+    cached->contents = contents_;
+    cached->capacity = capacity;
+  } else {
+    delete[] contents_;
+  }
 }
 
 
@@ -79,22 +135,27 @@ void AssemblerBuffer::FinalizeInstructions(const MemoryRegion& instructions) {
 
 
 void AssemblerBuffer::ExtendCapacity() {
-  size_t old_size = Size();
   size_t old_capacity = Capacity();
-  size_t new_capacity = std::min(old_capacity * 2, old_capacity + 1 * MB);
+  Reserve(std::min(old_capacity * 2, old_capacity + 1 * MB));
+}
+
+
+void AssemblerBuffer::Reserve(size_t new_capacity) {
+  if (new_capacity <= Capacity()) {
+    return;
+  }
+  size_t old_size = Size();
 
   // Allocate the new data area and copy contents of the old one to it.
   byte* new_contents = NewContents(new_capacity);
   memmove(reinterpret_cast<void*>(new_contents),
           reinterpret_cast<void*>(contents_),
           old_size);
+  delete[] contents_;
 
-  // Compute the relocation delta and switch to the new contents area.
-  ptrdiff_t delta = new_contents - contents_;
+  // Switch to the new contents area, update the cursor and recompute the limit.
   contents_ = new_contents;
-
-  // Update the cursor and recompute the limit.
-  cursor_ += delta;
+  cursor_ = new_contents + old_size;
   limit_ = ComputeLimit(new_contents, new_capacity);
 
   // Verify internal state.
@@ -229,6 +229,10 @@ class AssemblerBuffer {
   // and apply all fixups.
   void FinalizeInstructions(const MemoryRegion& region);
 
+  // Grows the data area to hold at least capacity bytes, so that code of an expected size is
+  // emitted without extending the capacity repeatedly.
+  void Reserve(size_t capacity);
+
   // To emit an instruction to the assembler buffer, the EnsureCapacity helper
   // must be used to guarantee that the underlying data area is big enough to
   // hold the emitted instruction. Usage:
@@ -351,6 +355,11 @@ class Assembler {
     buffer_.FinalizeInstructions(region);
   }
 
+  // Makes room for code_size bytes of code, estimated before emitting it.
+  void ReserveCodeSize(size_t code_size) {
+    buffer_.Reserve(code_size);
+  }
+
   // TODO: Implement with disassembler.
   virtual void Comment(const char* format, ...) { }
 
@@ -17,8 +17,10 @@
 #ifndef ART_COMPILER_UTILS_DEDUPE_SET_H_
 #define ART_COMPILER_UTILS_DEDUPE_SET_H_
 
-#include <set>
+#include <algorithm>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include "base/mutex.h"
 #include "base/stl_util.h"
@@ -26,59 +28,120 @@
 
 namespace art {
 
-// A set of Keys that support a HashFunc returning HashType. Used to find duplicates of Key in the
-// Add method. The data-structure is thread-safe through the use of internal locks, it also
-// supports the lock being sharded.
-template <typename Key, typename HashType, typename HashFunc, HashType kShard = 1>
+// A set of StoreKeys, sequences copied from the InKeys given to the Add method, which finds the
+// duplicates with a HashFunc of InKey returning HashType. The StoreKeys are constructed with an
+// allocator given to the set. The data-structure is thread-safe through the use of internal
+// locks, it also supports the lock being sharded. Each shard is an open addressing hash table of
+// the hashes and the keys, so that a lookup only compares the keys of equal hashes.
+template <typename InKey, typename StoreKey, typename HashType, typename HashFunc>
 class DedupeSet {
-  typedef std::pair<HashType, Key*> HashedKey;
-
-  class Comparator {
-   public:
-    bool operator()(const HashedKey& a, const HashedKey& b) const {
-      if (a.first != b.first) {
-        return a.first < b.first;
-      } else {
-        return *a.second < *b.second;
-      }
-    }
+  struct Slot {
+    HashType hash;
+    StoreKey* key;  // nullptr for an empty slot.
+  };
+
+  struct Shard {
+    std::string lock_name;
+    UniquePtr<Mutex> lock;
+    std::vector<Slot> slots;  // The capacity is a power of two.
+    size_t size;
+    size_t hits;
   };
 
  public:
-  Key* Add(Thread* self, const Key& key) {
+  StoreKey* Add(Thread* self, const InKey& key) {
+    // Hash outside of the lock.
     HashType raw_hash = HashFunc()(key);
-    HashType shard_hash = raw_hash / kShard;
-    HashType shard_bin = raw_hash % kShard;
-    HashedKey hashed_key(shard_hash, const_cast<Key*>(&key));
-    MutexLock lock(self, *lock_[shard_bin]);
-    auto it = keys_[shard_bin].find(hashed_key);
-    if (it != keys_[shard_bin].end()) {
-      return it->second;
+    HashType shard_hash = raw_hash / num_shards_;
+    Shard* shard = shards_[raw_hash % num_shards_];
+    MutexLock lock(self, *shard->lock);
+    size_t mask = shard->slots.size() - 1;
+    size_t index = shard_hash & mask;
+    for (; shard->slots[index].key != nullptr; index = (index + 1) & mask) {
+      const Slot& slot = shard->slots[index];
+      if (slot.hash == shard_hash && slot.key->size() == key.size() &&
+          std::equal(key.begin(), key.end(), slot.key->begin())) {
+        ++shard->hits;
+        return slot.key;
+      }
+    }
+    StoreKey* new_key = new StoreKey(key.begin(), key.end(), allocator_);
+    shard->slots[index].hash = shard_hash;
+    shard->slots[index].key = new_key;
+    ++shard->size;
+    if (shard->size * kMaxLoadDenominator > shard->slots.size() * kMaxLoadNumerator) {
+      Grow(shard);
     }
-    hashed_key.second = new Key(key);
-    keys_[shard_bin].insert(hashed_key);
-    return hashed_key.second;
+    return new_key;
   }
 
-  explicit DedupeSet(const char* set_name) {
-    for (HashType i = 0; i < kShard; ++i) {
-      std::ostringstream oss;
-      oss << set_name << " lock " << i;
-      lock_name_[i] = oss.str();
-      lock_[i].reset(new Mutex(lock_name_[i].c_str()));
+  // The sets of the compiler driver are shared by all the compiler threads, a number of shards
+  // in proportion keeps them from waiting on each other.
+  explicit DedupeSet(const char* set_name, size_t num_shards = 1,
+                     const typename StoreKey::allocator_type& allocator =
+                         typename StoreKey::allocator_type())
+      : set_name_(set_name), num_shards_(num_shards), allocator_(allocator) {
+    CHECK_NE(num_shards_, 0u);
+    for (size_t i = 0; i < num_shards_; ++i) {
+      Shard* shard = new Shard;
+      shard->lock_name = StringPrintf("%s lock %zd", set_name, i);
+      shard->lock.reset(new Mutex(shard->lock_name.c_str()));
+      Slot empty = { 0, nullptr };
+      shard->slots.resize(kInitialCapacity, empty);
+      shard->size = 0u;
+      shard->hits = 0u;
+      shards_.push_back(shard);
     }
   }
 
   ~DedupeSet() {
-    for (HashType i = 0; i < kShard; ++i) {
-      STLDeleteValues(&keys_[i]);
+    for (Shard* shard : shards_) {
+      for (const Slot& slot : shard->slots) {
+        delete slot.key;
+      }
     }
+    STLDeleteElements(&shards_);
+  }
+
+  // Dumps how many of the added Keys were duplicates. Not synchronized with Add.
+  void DumpStats(std::ostream& os) const {
+    size_t unique = 0u;
+    size_t hits = 0u;
+    for (const Shard* shard : shards_) {
+      unique += shard->size;
+      hits += shard->hits;
+    }
+    size_t adds = unique + hits;
+    os << set_name_ << ": " << adds << " added, " << hits << " duplicates ("
+       << ((adds != 0u) ? hits * 100 / adds : 0u) << "%), " << unique << " unique\n";
   }
 
  private:
-  std::string lock_name_[kShard];
-  UniquePtr<Mutex> lock_[kShard];
-  std::set<HashedKey, Comparator> keys_[kShard];
+  static constexpr size_t kInitialCapacity = 64u;
+  static constexpr size_t kMaxLoadNumerator = 3u;
+  static constexpr size_t kMaxLoadDenominator = 4u;
+
+  static void Grow(Shard* shard) {
+    std::vector<Slot> old_slots;
+    old_slots.swap(shard->slots);
+    Slot empty = { 0, nullptr };
+    shard->slots.resize(old_slots.size() * 2u, empty);
+    size_t mask = shard->slots.size() - 1;
+    for (const Slot& slot : old_slots) {
+      if (slot.key != nullptr) {
+        size_t index = slot.hash & mask;
+        while (shard->slots[index].key != nullptr) {
+          index = (index + 1) & mask;
+        }
+        shard->slots[index] = slot;
+      }
+    }
+  }
+
+  const std::string set_name_;
+  const size_t num_shards_;
+  const typename StoreKey::allocator_type allocator_;
+  std::vector<Shard*> shards_;
 
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
@@ -35,7 +35,7 @@ class DedupeHashFunc {
 TEST(DedupeSetTest, Test) {
   Thread* self = Thread::Current();
   typedef std::vector<uint8_t> ByteArray;
-  DedupeSet<ByteArray, size_t, DedupeHashFunc> deduplicator("test");
+  DedupeSet<ByteArray, ByteArray, size_t, DedupeHashFunc> deduplicator("test");
   ByteArray* array1;
   {
     ByteArray test1;
@@ -72,4 +72,26 @@ TEST(DedupeSetTest, Test) {
   }
 }
 
+TEST(DedupeSetTest, ManyShards) {
+  Thread* self = Thread::Current();
+  typedef std::vector<uint8_t> ByteArray;
+  DedupeSet<ByteArray, ByteArray, size_t, DedupeHashFunc> deduplicator("test", 8);
+  // Enough arrays for the shards to grow.
+  std::vector<ByteArray*> arrays;
+  for (size_t i = 0; i != 1000; ++i) {
+    ByteArray test(1, static_cast<uint8_t>(i));
+    test.push_back(static_cast<uint8_t>(i >> 8));
+    arrays.push_back(deduplicator.Add(self, test));
+    ASSERT_EQ(test, *arrays.back());
+  }
+  for (size_t i = 0; i != 1000; ++i) {
+    ByteArray test(1, static_cast<uint8_t>(i));
+    test.push_back(static_cast<uint8_t>(i >> 8));
+    ASSERT_EQ(arrays[i], deduplicator.Add(self, test));
+  }
+  std::ostringstream oss;
+  deduplicator.DumpStats(oss);
+  ASSERT_EQ("test: 2000 added, 1000 duplicates (50%), 1000 unique\n", oss.str());
+}
+
 }  // namespace art
@@ -19,7 +19,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
-#include "arena_allocator.h"
+#include "base/arena_allocator.h"
 
 namespace art {
 
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "swap_space.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "base/stl_util.h"
+#include "thread-inl.h"
+#include "utils.h"
+
+namespace art {
+
+// The blocks are aligned like the native heap would align them.
+static constexpr size_t kSwapAlignment = 8u;
+
+// Growing the file in large chunks keeps the number of mappings low.
+static constexpr size_t kMinimumMapSize = 16 * MB;
+
+SwapSpace::SwapSpace(int fd, size_t initial_size)
+    : fd_(fd), size_(0u), lock_("SwapSpace lock") {
+  CHECK_NE(fd_, -1);
+  MutexLock mu(Thread::Current(), lock_);
+  AddFileChunk(initial_size);
+}
+
+SwapSpace::~SwapSpace() {
+  STLDeleteElements(&maps_);
+  close(fd_);
+}
+
+void* SwapSpace::Alloc(size_t size) {
+  size = RoundUp(size, kSwapAlignment);
+  MutexLock mu(Thread::Current(), lock_);
+  std::set<std::pair<size_t, uint8_t*> >::iterator it =
+      free_by_size_.lower_bound(std::make_pair(size, static_cast<uint8_t*>(nullptr)));
+  if (it == free_by_size_.end()) {
+    AddFileChunk(size);
+    it = free_by_size_.lower_bound(std::make_pair(size, static_cast<uint8_t*>(nullptr)));
+    CHECK(it != free_by_size_.end());
+  }
+  size_t block_size = it->first;
+  uint8_t* begin = it->second;
+  RemoveFreeBlock(begin, block_size);
+  if (block_size != size) {
+    AddFreeBlock(begin + size, block_size - size);
+  }
+  return begin;
+}
+
+void SwapSpace::Free(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  size = RoundUp(size, kSwapAlignment);
+  uint8_t* begin = reinterpret_cast<uint8_t*>(ptr);
+  MutexLock mu(Thread::Current(), lock_);
+  // Coalesce with the free blocks right before and after.
+  SafeMap<uint8_t*, size_t>::iterator next = free_by_begin_.lower_bound(begin);
+  if (next != free_by_begin_.end() && begin + size == next->first) {
+    size_t next_size = next->second;
+    RemoveFreeBlock(begin + size, next_size);
+    size += next_size;
+  }
+  SafeMap<uint8_t*, size_t>::iterator prev = free_by_begin_.lower_bound(begin);
+  if (prev != free_by_begin_.begin()) {
+    --prev;
+    if (prev->first + prev->second == begin) {
+      uint8_t* prev_begin = prev->first;
+      size_t prev_size = prev->second;
+      RemoveFreeBlock(prev_begin, prev_size);
+      begin = prev_begin;
+      size += prev_size;
+    }
+  }
+  AddFreeBlock(begin, size);
+}
+
+size_t SwapSpace::GetSize() {
+  MutexLock mu(Thread::Current(), lock_);
+  return size_;
+}
+
+void SwapSpace::AddFileChunk(size_t min_size) {
+  size_t chunk_size = RoundUp(std::max(min_size, kMinimumMapSize), kPageSize);
+  if (ftruncate(fd_, size_ + chunk_size) != 0) {
+    PLOG(FATAL) << "Failed to grow the swap file to " << (size_ + chunk_size) << " bytes";
+  }
+  std::string error_msg;
+  MemMap* map = MemMap::MapFile(chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, size_,
+                                "swap space", &error_msg);
+  CHECK(map != nullptr) << "Failed to map the swap file: " << error_msg;
+  maps_.push_back(map);
+  size_ += chunk_size;
+  AddFreeBlock(map->Begin(), chunk_size);
+}
+
+void SwapSpace::AddFreeBlock(uint8_t* begin, size_t size) {
+  free_by_begin_.Put(begin, size);
+  free_by_size_.insert(std::make_pair(size, begin));
+}
+
+void SwapSpace::RemoveFreeBlock(uint8_t* begin, size_t size) {
+  free_by_begin_.erase(begin);
+  free_by_size_.erase(std::make_pair(size, begin));
+}
+
+}  // namespace art
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_UTILS_SWAP_SPACE_H_
+#define ART_COMPILER_UTILS_SWAP_SPACE_H_
+
+#include <stdlib.h>
+
+#include <set>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "safe_map.h"
+
+namespace art {
+
+// Memory backed by a file, which the kernel can write back and drop under memory pressure
+// instead of keeping it resident like the native heap. The file grows by mapping chunks of at
+// least 16 MB, and freed blocks are coalesced and reused. Thread-safe.
+class SwapSpace {
+ public:
+  // Takes ownership of fd, which should be an empty file that nothing else uses.
+  SwapSpace(int fd, size_t initial_size);
+  ~SwapSpace();
+
+  void* Alloc(size_t size) LOCKS_EXCLUDED(lock_);
+  void Free(void* ptr, size_t size) LOCKS_EXCLUDED(lock_);
+
+  // The size of the file.
+  size_t GetSize() LOCKS_EXCLUDED(lock_);
+
+ private:
+  // Maps a new chunk of the file of at least min_size bytes and adds it to the free blocks.
+  void AddFileChunk(size_t min_size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void AddFreeBlock(uint8_t* begin, size_t size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void RemoveFreeBlock(uint8_t* begin, size_t size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const int fd_;
+  size_t size_ GUARDED_BY(lock_);
+  std::vector<MemMap*> maps_ GUARDED_BY(lock_);
+
+  // The free blocks, by address for coalescing, and by size for the best fit.
+  SafeMap<uint8_t*, size_t> free_by_begin_ GUARDED_BY(lock_);
+  std::set<std::pair<size_t, uint8_t*> > free_by_size_ GUARDED_BY(lock_);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+
+  DISALLOW_COPY_AND_ASSIGN(SwapSpace);
+};
+
+// A standard allocator in a SwapSpace, or in the native heap if there is none.
+template <typename T>
+class SwapAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef SwapAllocator<U> other;
+  };
+
+  explicit SwapAllocator(SwapSpace* swap_space = nullptr) : swap_space_(swap_space) {}
+
+  template <typename U>
+  SwapAllocator(const SwapAllocator<U>& other) : swap_space_(other.swap_space_) {}
+
+  size_type max_size() const {
+    return static_cast<size_type>(-1) / sizeof(T);
+  }
+
+  pointer address(reference x) const { return &x; }
+  const_pointer address(const_reference x) const { return &x; }
+
+  pointer allocate(size_type n, const void* /* hint */ = nullptr) {
+    DCHECK_LE(n, max_size());
+    if (swap_space_ == nullptr) {
+      return reinterpret_cast<T*>(malloc(n * sizeof(T)));
+    }
+    return reinterpret_cast<T*>(swap_space_->Alloc(n * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n) {
+    if (swap_space_ == nullptr) {
+      free(p);
+    } else {
+      swap_space_->Free(p, n * sizeof(T));
+    }
+  }
+
+  void construct(pointer p, const_reference val) {
+    new (static_cast<void*>(p)) value_type(val);
+  }
+
+  template <class U, class... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  void destroy(pointer p) {
+    p->~value_type();
+  }
+
+  template <class U>
+  void destroy(U* p) {
+    p->~U();
+  }
+
+ private:
+  SwapSpace* swap_space_;
+
+  template <typename U>
+  friend class SwapAllocator;
+
+  template <typename U>
+  friend bool operator==(const SwapAllocator<U>& lhs, const SwapAllocator<U>& rhs);
+};
+
+template <typename T>
+inline bool operator==(const SwapAllocator<T>& lhs, const SwapAllocator<T>& rhs) {
+  return lhs.swap_space_ == rhs.swap_space_;
+}
+
+template <typename T>
+inline bool operator!=(const SwapAllocator<T>& lhs, const SwapAllocator<T>& rhs) {
+  return !(lhs == rhs);
+}
+
+// The byte arrays of the compiled code and tables.
+typedef std::vector<uint8_t, SwapAllocator<uint8_t> > SwapVector;
+
+}  // namespace art
+
+#endif  // ART_COMPILER_UTILS_SWAP_SPACE_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "swap_space.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static int CreateSwapFile() {
+  FILE* file = tmpfile();
+  CHECK(file != nullptr);
+  int fd = dup(fileno(file));
+  fclose(file);
+  CHECK_NE(fd, -1);
+  return fd;
+}
+
+TEST(SwapSpaceTest, ReuseFreedBlocks) {
+  SwapSpace swap_space(CreateSwapFile(), 1 * MB);
+  size_t initial_size = swap_space.GetSize();
+  uint8_t* first = reinterpret_cast<uint8_t*>(swap_space.Alloc(100));
+  uint8_t* second = reinterpret_cast<uint8_t*>(swap_space.Alloc(100));
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  ASSERT_NE(first, second);
+  memset(first, 1, 100);
+  memset(second, 2, 100);
+  ASSERT_EQ(1, first[99]);
+
+  // The freed blocks are coalesced and reused for a larger allocation.
+  swap_space.Free(first, 100);
+  swap_space.Free(second, 100);
+  uint8_t* both = reinterpret_cast<uint8_t*>(swap_space.Alloc(200));
+  ASSERT_EQ(std::min(first, second), both);
+  swap_space.Free(both, 200);
+  ASSERT_EQ(initial_size, swap_space.GetSize());
+}
+
+TEST(SwapSpaceTest, Grow) {
+  SwapSpace swap_space(CreateSwapFile(), 1 * MB);
+  size_t initial_size = swap_space.GetSize();
+  // More than the initial size, the file grows.
+  void* large = swap_space.Alloc(initial_size + 1);
+  ASSERT_TRUE(large != nullptr);
+  memset(large, 3, initial_size + 1);
+  ASSERT_LT(initial_size, swap_space.GetSize());
+  swap_space.Free(large, initial_size + 1);
+}
+
+TEST(SwapSpaceTest, SwapVector) {
+  SwapSpace swap_space(CreateSwapFile(), 1 * MB);
+  SwapAllocator<uint8_t> allocator(&swap_space);
+  SwapVector vector(allocator);
+  for (size_t i = 0; i != 10000; ++i) {
+    vector.push_back(static_cast<uint8_t>(i));
+  }
+  for (size_t i = 0; i != 10000; ++i) {
+    ASSERT_EQ(static_cast<uint8_t>(i), vector[i]);
+  }
+  // Without a swap space, the arrays are in the native heap.
+  SwapVector native_vector(vector.begin(), vector.end(), SwapAllocator<uint8_t>());
+  ASSERT_TRUE(std::equal(vector.begin(), vector.end(), native_vector.begin()));
+}
+
+}  // namespace art
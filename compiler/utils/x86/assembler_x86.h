@@ -264,6 +264,17 @@ class X86Assembler FINAL : public Assembler {
 
   void movd(XmmRegister dst, Register src);
   void movd(Register dst, XmmRegister src);
+  void movd(XmmRegister dst, const Address& src);
+  void movd(const Address& dst, XmmRegister src);
+
+  // Packed integer operations, on four 32-bit lanes. The memory operands of
+  // movdqu do not need to be aligned.
+  void movdqu(XmmRegister dst, const Address& src);
+  void movdqu(const Address& dst, XmmRegister src);
+  void paddd(XmmRegister dst, XmmRegister src);
+  void psubd(XmmRegister dst, XmmRegister src);
+  void pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm);
+  void pxor(XmmRegister dst, XmmRegister src);
 
   void addss(XmmRegister dst, XmmRegister src);
   void addss(XmmRegister dst, const Address& src);
@@ -14,13 +14,20 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <valgrind.h>
 
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -38,6 +45,7 @@
 #include "driver/compiler_callbacks_impl.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
+#include "driver/previous_oat_file.h"
 #include "elf_fixup.h"
 #include "elf_stripper.h"
 #include "gc/space/image_space.h"
@@ -49,9 +57,11 @@
 #include "mirror/class_loader.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
+#include "oat_file.h"
 #include "oat_writer.h"
 #include "object_utils.h"
 #include "os.h"
+#include "profiler.h"
 #include "runtime.h"
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
@@ -128,6 +138,20 @@ static void Usage(const char* fmt, ...) {
   UsageError("  --image-classes=<classname-file>: specifies classes to include in an image.");
   UsageError("      Example: --image=frameworks/base/preloaded-classes");
   UsageError("");
+  UsageError("  --image-layout=(walk|startup): specifies how the objects of an image are ordered.");
+  UsageError("      walk lays them out in the order they are reached from the roots. startup");
+  UsageError("      groups the objects written at runtime, then the objects of the classes used");
+  UsageError("      during startup, then the other objects and strings.");
+  UsageError("      Example: --image-layout=startup");
+  UsageError("      Default: walk");
+  UsageError("");
+  UsageError("  --compress-image: writes the image file in zlib compressed blocks, which the");
+  UsageError("      runtime decompresses in parallel when loading the image.");
+  UsageError("");
+  UsageError("  --startup-classes=<classname-file>: specifies the classes used during startup,");
+  UsageError("      in the format of --image-classes, for --image-layout=startup.");
+  UsageError("      Example: --startup-classes=frameworks/base/startup-classes");
+  UsageError("");
   UsageError("  --base=<hex-address>: specifies the base address when creating a boot image.");
   UsageError("      Example: --base=0x50000000");
   UsageError("");
@@ -153,8 +177,10 @@ static void Usage(const char* fmt, ...) {
   UsageError("      Example: --compiler-backend=Portable");
   UsageError("      Default: Quick");
   UsageError("");
-  UsageError("  --compiler-filter=(verify-none|interpret-only|space|balanced|speed|everything):");
-  UsageError("      select compiler filter.");
+  UsageError("  --compiler-filter=(verify-none|interpret-only|profiled|space|balanced|speed|"
+             "everything):");
+  UsageError("      select compiler filter. profiled only compiles the hot methods of the");
+  UsageError("      --profile-file. space runs a lean pipeline of Quick optimization passes.");
   UsageError("      Example: --compiler-filter=everything");
 #if ART_SMALL_MODE
   UsageError("      Default: interpret-only");
@@ -198,6 +224,56 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
+  UsageError("  --dump-passes: display the time spent in each compiler pass, and the runs,");
+  UsageError("      time and arena memory of each Quick optimization pass");
+  UsageError("");
+  UsageError("  --dump-arena-stats: count the arena allocations by kind, and display them");
+  UsageError("      for the methods using the most compiler memory");
+  UsageError("");
+  UsageError("  --dump-timing-json=<file>: write the time spent in each phase, the methods");
+  UsageError("      compiled per second, the arena peak memory and the compiler threads");
+  UsageError("      utilization to <file> as JSON. With --dump-passes, also includes the time");
+  UsageError("      spent in each compiler pass.");
+  UsageError("      Example: --dump-timing-json=/tmp/dex2oat-timing.json");
+  UsageError("");
+  UsageError("  --reuse-oat-file=<file.oat>: reuse the code of the methods that did not change");
+  UsageError("      since the compilation of <file.oat>. Requires the dex files it was compiled");
+  UsageError("      from to be specified with --reuse-dex-file.");
+  UsageError("      Example: --reuse-oat-file=/data/dalvik-cache/old.odex");
+  UsageError("");
+  UsageError("  --reuse-dex-file=<dex-file>: specifies a dex file the --reuse-oat-file was");
+  UsageError("      compiled from. Use a separate --reuse-dex-file switch for each dex file.");
+  UsageError("      Example: --reuse-dex-file=/data/local/tmp/old.dex");
+  UsageError("");
+  UsageError("  --verified-oat-file=<file.oat>: an oat file written by dex2oat, whose copies of");
+  UsageError("      the dex files were verified. The dex files identical to these copies are not");
+  UsageError("      verified again.");
+  UsageError("      Example: --verified-oat-file=/system/app/Calculator.odex");
+  UsageError("");
+  UsageError("  --swap-file=<file-name>: keep the compiled code and tables in a temporary file");
+  UsageError("      instead of the native heap until the oat file is written, so that the");
+  UsageError("      kernel can page them out.");
+  UsageError("      Example: --swap-file=/data/dalvik-cache/dex2oat.swap");
+  UsageError("");
+  UsageError("  --swap-fd=<number>: like --swap-file, with an empty file open for reading and");
+  UsageError("      writing. The file descriptor is closed once the compilation is done.");
+  UsageError("      Example: --swap-fd=10");
+  UsageError("");
+  UsageError("  --compile-server=<socket-path>: instead of compiling, create the runtime once");
+  UsageError("      and serve the compile requests received on the unix domain socket");
+  UsageError("      <socket-path>. Each request is compiled in a process forked from the server,");
+  UsageError("      which shares the boot image and the classes linked from it. The server uses");
+  UsageError("      the --boot-image, --runtime-arg, --instruction-set, --compiler-backend and");
+  UsageError("      --instruction-set-features options, the other options come with each");
+  UsageError("      request and must match these.");
+  UsageError("      Example: --compile-server=/tmp/dex2oat.socket");
+  UsageError("");
+  UsageError("  --use-compile-server=<socket-path>: send the compilation to the compile server");
+  UsageError("      listening on <socket-path> and wait for it. Compiles without the server if it");
+  UsageError("      isn't running, was started with different server options, or if file");
+  UsageError("      descriptors are passed with --zip-fd, --oat-fd or --swap-fd.");
+  UsageError("      Example: --use-compile-server=/tmp/dex2oat.socket");
+  UsageError("");
   UsageError("  --runtime-arg <argument>: used to specify various arguments for the runtime,");
   UsageError("      such as initial heap size, maximum heap size, and verbose output.");
   UsageError("      Use a separate --runtime-arg switch for each argument.");
@@ -214,6 +290,89 @@ static void Usage(const char* fmt, ...) {
   exit(EXIT_FAILURE);
 }
 
+static void DumpPassStats() {
+  std::ostringstream oss;
+  PassDriver::DumpPassStats(oss);
+  LOG(INFO) << oss.str();
+}
+
+static const char* GetCompilerBackendName(Compiler::Kind compiler_kind) {
+  switch (compiler_kind) {
+    case Compiler::kQuick: return "Quick";
+    case Compiler::kOptimizing: return "Optimizing";
+    case Compiler::kPortable: return "Portable";
+  }
+  return "Unknown";
+}
+
+// Writes the timings of the compilation as JSON, for tools tracking the compile speed. The
+// compiler phases and passes are only timed with --dump-passes.
+static void DumpTimingJson(const std::string& filename, const TimingLogger& timings,
+                           const CompilerDriver& driver, Compiler::Kind compiler_kind,
+                           bool dump_passes) {
+  std::ofstream os(filename.c_str());
+  if (!os.good()) {
+    LOG(ERROR) << "Failed to open " << filename << " for the timings";
+    return;
+  }
+  os << "{\n";
+  os << "  \"backend\": \"" << GetCompilerBackendName(compiler_kind) << "\",\n";
+  os << "  \"instruction_set\": \"" << GetInstructionSetString(driver.GetInstructionSet())
+     << "\",\n";
+  os << "  \"threads\": " << driver.GetThreadCount() << ",\n";
+  os << "  \"total_ns\": " << timings.GetTotalNs() << ",\n";
+
+  os << "  \"phases\": [";
+  uint64_t compile_ns = 0;
+  const TimingLogger::SplitTimings& splits = timings.GetSplits();
+  for (size_t i = 0; i != splits.size(); ++i) {
+    os << ((i != 0u) ? "," : "") << "\n    {\"name\": \"" << splits[i].second
+       << "\", \"time_ns\": " << splits[i].first << "}";
+    if (strcmp(splits[i].second, "Compile Dex File") == 0) {
+      compile_ns += splits[i].first;
+    }
+  }
+  os << "\n  ],\n";
+
+  size_t compiled_methods = driver.GetCompiledMethodCount();
+  uint64_t methods_per_second =
+      (compile_ns != 0u) ? compiled_methods * UINT64_C(1000000000) / compile_ns : 0u;
+  os << "  \"compiled_methods\": " << compiled_methods << ",\n";
+  os << "  \"compile_ns\": " << compile_ns << ",\n";
+  os << "  \"methods_per_second\": " << methods_per_second << ",\n";
+  os << "  \"arena_peak_bytes\": " << driver.GetArenaPool()->GetPeakBytesInUse() << ",\n";
+
+  // The utilization is the share of the wall time of the parallel phases the threads worked.
+  uint64_t wall_ns = driver.GetParallelWallNs();
+  const std::vector<uint64_t>& busy_ns = driver.GetParallelBusyNs();
+  uint64_t total_busy_ns = 0;
+  os << "  \"parallel_wall_ns\": " << wall_ns << ",\n";
+  os << "  \"thread_busy_ns\": [";
+  for (size_t i = 0; i != busy_ns.size(); ++i) {
+    os << ((i != 0u) ? ", " : "") << busy_ns[i];
+    total_busy_ns += busy_ns[i];
+  }
+  os << "],\n";
+  uint64_t available_ns = wall_ns * busy_ns.size();
+  os << "  \"thread_utilization_percent\": "
+     << ((available_ns != 0u) ? total_busy_ns * 100 / available_ns : 0u);
+
+  if (dump_passes) {
+    std::vector<CumulativeLogger::LabelTotal> totals;
+    driver.GetTimingsLogger()->GetLabelTotals(&totals);
+    os << ",\n  \"compiler_phases\": [";
+    for (size_t i = 0; i != totals.size(); ++i) {
+      os << ((i != 0u) ? "," : "") << "\n    {\"name\": \"" << totals[i].label
+         << "\", \"count\": " << totals[i].count << ", \"time_ns\": " << totals[i].total_ns
+         << "}";
+    }
+    os << "\n  ],\n";
+    os << "  \"passes\": ";
+    PassDriver::DumpPassStatsJson(os);
+  }
+  os << "\n}\n";
+}
+
 class Dex2Oat {
  public:
   static bool Create(Dex2Oat** p_dex2oat,
@@ -253,6 +412,12 @@ class Dex2Oat {
               << " (threads: " << thread_count_ << ")";
   }
 
+  // Called in the process forked by a compile server for a job, which reuses the runtime.
+  void StartJob(size_t thread_count) {
+    thread_count_ = thread_count;
+    start_ns_ = NanoTime();
+  }
+
 
   // Reads the class names (java.lang.Object) and returns a set of descriptors (Ljava/lang/Object;)
   CompilerDriver::DescriptorSet* ReadImageClassesFromFile(const char* image_classes_filename) {
@@ -318,9 +483,13 @@ class Dex2Oat {
                                       UniquePtr<CompilerDriver::DescriptorSet>& image_classes,
                                       bool dump_stats,
                                       bool dump_passes,
+                                      bool dump_arena_stats,
                                       TimingLogger& timings,
                                       CumulativeLogger& compiler_phases_timings,
-                                      std::string profile_file) {
+                                      std::string profile_file,
+                                      int swap_fd,
+                                      const std::string& reuse_oat_filename,
+                                      const std::vector<std::string>& reuse_dex_filenames) {
     // SirtRef and ClassLoader creation needs to come after Runtime::Create
     jobject class_loader = NULL;
     Thread* self = Thread::Current();
@@ -350,14 +519,13 @@ class Dex2Oat {
                                                         thread_count_,
                                                         dump_stats,
                                                         dump_passes,
+                                                        dump_arena_stats,
                                                         &compiler_phases_timings,
-                                                        profile_file));
+                                                        profile_file,
+                                                        swap_fd));
 
     driver->GetCompiler()->SetBitcodeFileName(*driver.get(), bitcode_filename);
 
-    driver->CompileAll(class_loader, dex_files, &timings);
-
-    timings.NewSplit("dex2oat OatWriter");
     std::string image_file_location;
     uint32_t image_file_location_oat_checksum = 0;
     uintptr_t image_file_location_oat_data_begin = 0;
@@ -370,6 +538,30 @@ class Dex2Oat {
       image_file_location = image_space->GetImageFilename();
     }
 
+    if (!reuse_oat_filename.empty()) {
+      TimingLogger::ScopedSplit split("Opening previous oat file", &timings);
+      std::string error_msg;
+      PreviousOatFile* previous_oat_file =
+          PreviousOatFile::Open(reuse_oat_filename, reuse_dex_filenames, dex_files,
+                                instruction_set_, instruction_set_features_,
+                                image_file_location_oat_checksum,
+                                image_file_location_oat_data_begin, &error_msg);
+      if (previous_oat_file == nullptr) {
+        LOG(WARNING) << "Not reusing " << reuse_oat_filename << ": " << error_msg;
+      } else {
+        driver->SetPreviousOatFile(previous_oat_file);
+      }
+    }
+
+    driver->CompileAll(class_loader, dex_files, &timings);
+
+    if (driver->GetPreviousOatFile() != nullptr) {
+      LOG(INFO) << "Reused the code of " << driver->GetPreviousOatFile()->GetReusedMethodCount()
+                << " methods from " << reuse_oat_filename;
+    }
+
+    timings.NewSplit("dex2oat OatWriter");
+
     OatWriter oat_writer(dex_files,
                          image_file_location_oat_checksum,
                          image_file_location_oat_data_begin,
@@ -390,12 +582,15 @@ class Dex2Oat {
                        uintptr_t image_base,
                        const std::string& oat_filename,
                        const std::string& oat_location,
-                       const CompilerDriver& compiler)
+                       const CompilerDriver& compiler,
+                       bool startup_layout,
+                       const CompilerDriver::DescriptorSet* startup_classes,
+                       bool compress_image)
       LOCKS_EXCLUDED(Locks::mutator_lock_) {
     uintptr_t oat_data_begin;
     {
       // ImageWriter is scoped so it can free memory before doing FixupElf
-      ImageWriter image_writer(compiler);
+      ImageWriter image_writer(compiler, startup_layout, startup_classes, compress_image);
       if (!image_writer.Write(image_filename, image_base, oat_filename, oat_location)) {
         LOG(ERROR) << "Failed to create image file " << image_filename;
         return false;
@@ -513,8 +708,29 @@ static bool ParseInt(const char* in, int* out) {
   return true;
 }
 
+// Opens the copy of the dex file of the given location in verified_oat_file, if there is one.
+static const DexFile* OpenVerifiedDexFile(const OatFile* verified_oat_file,
+                                          const std::string& dex_location) {
+  if (verified_oat_file == nullptr) {
+    return nullptr;
+  }
+  const OatFile::OatDexFile* oat_dex_file =
+      verified_oat_file->GetOatDexFile(dex_location.c_str(), nullptr, false);
+  if (oat_dex_file == nullptr) {
+    return nullptr;
+  }
+  std::string error_msg;
+  const DexFile* dex_file = oat_dex_file->OpenDexFile(&error_msg);
+  if (dex_file == nullptr) {
+    LOG(WARNING) << "Failed to open the verified copy of '" << dex_location << "' in '"
+                 << verified_oat_file->GetLocation() << "': " << error_msg;
+  }
+  return dex_file;
+}
+
 static size_t OpenDexFiles(const std::vector<const char*>& dex_filenames,
                            const std::vector<const char*>& dex_locations,
+                           const OatFile* verified_oat_file,
                            std::vector<const DexFile*>& dex_files) {
   size_t failure_count = 0;
   for (size_t i = 0; i < dex_filenames.size(); i++) {
@@ -526,7 +742,10 @@ static size_t OpenDexFiles(const std::vector<const char*>& dex_filenames,
       LOG(WARNING) << "Skipping non-existent dex file '" << dex_filename << "'";
       continue;
     }
-    const DexFile* dex_file = DexFile::Open(dex_filename, dex_location, &error_msg);
+    UniquePtr<const DexFile> verified_dex_file(OpenVerifiedDexFile(verified_oat_file,
+                                                                   dex_location));
+    const DexFile* dex_file = DexFile::Open(dex_filename, dex_location, verified_dex_file.get(),
+                                            &error_msg);
     if (dex_file == NULL) {
       LOG(WARNING) << "Failed to open .dex from file '" << dex_filename << "': " << error_msg;
       ++failure_count;
@@ -693,6 +912,24 @@ static InstructionSetFeatures ParseFeatureList(std::string str) {
     } else if (feature == "nolpae") {
       // Turn off support for Large Physical Address Extension.
       result.SetHasLpae(false);
+    } else if (feature == "neon") {
+      // Supports the Advanced SIMD instructions.
+      result.SetHasNeon(true);
+    } else if (feature == "noneon") {
+      // Turn off support for the Advanced SIMD instructions.
+      result.SetHasNeon(false);
+    } else if (feature == "sse4.1") {
+      // Supports the SSE4.1 instructions.
+      result.SetHasSse4_1(true);
+    } else if (feature == "nosse4.1") {
+      // Turn off support for the SSE4.1 instructions.
+      result.SetHasSse4_1(false);
+    } else if (feature == "popcnt") {
+      // Supports the popcnt instruction.
+      result.SetHasPopcnt(true);
+    } else if (feature == "nopopcnt") {
+      // Turn off support for the popcnt instruction.
+      result.SetHasPopcnt(false);
     } else {
       Usage("Unknown instruction set feature: '%s'", feature.c_str());
     }
@@ -701,6 +938,323 @@ static InstructionSetFeatures ParseFeatureList(std::string str) {
   return result;
 }
 
+// A compile server creates the runtime once, mapping the boot image and linking the classes of the
+// boot class path, then forks a process for each compile request received on its unix domain
+// socket. The job parses its arguments like a dex2oat command line and compiles with the runtime
+// it inherited copy-on-write from the server.
+//
+// A request is the working directory of the client followed by the job arguments, each NUL
+// terminated, after their total size as a uint32_t. The size comes with the standard error of the
+// client as SCM_RIGHTS, which becomes the standard error of the job. The server replies with the
+// exit status of the job as an int32_t once it is done.
+struct CompileServer {
+  std::string boot_image_option;
+  std::vector<std::string> runtime_args;
+  Compiler::Kind compiler_kind;
+  InstructionSet instruction_set;
+  InstructionSetFeatures instruction_set_features;
+  // The options the compiler state of the runtime points to, overwritten by each job.
+  CompilerOptions* compiler_options;
+  Dex2Oat* dex2oat;
+};
+
+// Set in the processes forked by a compile server to run a job.
+static CompileServer* compile_server = nullptr;
+
+// Exit status of a job which the server was started with different options for, the client
+// compiles by itself instead.
+static const int kCompileServerMismatch = 64;
+
+static const size_t kMaxCompileRequestSize = 1 * MB;
+
+// How often the server looks for finished jobs while some are running.
+static const int kCompileServerReapIntervalMs = 100;
+
+static int dex2oat(int argc, char** argv);
+
+static bool ReadFromSocket(int fd, void* buffer, size_t byte_count) {
+  byte* p = reinterpret_cast<byte*>(buffer);
+  while (byte_count > 0) {
+    ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, p, byte_count));
+    if (bytes_read <= 0) {
+      return false;
+    }
+    p += bytes_read;
+    byte_count -= bytes_read;
+  }
+  return true;
+}
+
+static bool WriteToSocket(int fd, const void* buffer, size_t byte_count) {
+  const byte* p = reinterpret_cast<const byte*>(buffer);
+  while (byte_count > 0) {
+    ssize_t bytes_written = TEMP_FAILURE_RETRY(send(fd, p, byte_count, MSG_NOSIGNAL));
+    if (bytes_written <= 0) {
+      return false;
+    }
+    p += bytes_written;
+    byte_count -= bytes_written;
+  }
+  return true;
+}
+
+static bool MakeSocketAddress(const std::string& socket_path, sockaddr_un* address) {
+  if (socket_path.size() >= sizeof(address->sun_path)) {
+    LOG(ERROR) << "Compile server socket path too long: " << socket_path;
+    return false;
+  }
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  strncpy(address->sun_path, socket_path.c_str(), sizeof(address->sun_path) - 1);
+  return true;
+}
+
+// Sends a job to the compile server listening on socket_path and waits for its exit status.
+// Returns false if the server couldn't run the job, which is then compiled by this process.
+static bool RunOnCompileServer(const std::string& socket_path,
+                               const std::vector<std::string>& args, int* exit_status) {
+  sockaddr_un address;
+  if (!MakeSocketAddress(socket_path, &address)) {
+    return false;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    PLOG(WARNING) << "Failed to create a socket for the compile server";
+    return false;
+  }
+  if (TEMP_FAILURE_RETRY(connect(fd, reinterpret_cast<sockaddr*>(&address),
+                                 sizeof(address))) != 0) {
+    PLOG(WARNING) << "Compiling without the compile server " << socket_path;
+    close(fd);
+    return false;
+  }
+  char cwd[PATH_MAX];
+  if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+    PLOG(WARNING) << "Compiling without the compile server, failed to get the working directory";
+    close(fd);
+    return false;
+  }
+  std::string request(cwd);
+  request.push_back('\0');
+  for (size_t i = 0; i < args.size(); ++i) {
+    request += args[i];
+    request.push_back('\0');
+  }
+  uint32_t request_size = request.size();
+  iovec iov;
+  iov.iov_base = &request_size;
+  iov.iov_len = sizeof(request_size);
+  char control[CMSG_SPACE(sizeof(int))];
+  memset(control, 0, sizeof(control));
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+  control_message->cmsg_level = SOL_SOCKET;
+  control_message->cmsg_type = SCM_RIGHTS;
+  control_message->cmsg_len = CMSG_LEN(sizeof(int));
+  const int stderr_fd = STDERR_FILENO;
+  memcpy(CMSG_DATA(control_message), &stderr_fd, sizeof(stderr_fd));
+  int32_t status;
+  bool replied =
+      TEMP_FAILURE_RETRY(sendmsg(fd, &message, MSG_NOSIGNAL)) == sizeof(request_size) &&
+      WriteToSocket(fd, request.data(), request.size()) &&
+      ReadFromSocket(fd, &status, sizeof(status));
+  close(fd);
+  if (!replied) {
+    LOG(WARNING) << "The compile server " << socket_path << " didn't run the job, compiling here";
+    return false;
+  }
+  if (status == kCompileServerMismatch) {
+    LOG(WARNING) << "The compile server " << socket_path << " can't run the job, compiling here";
+    return false;
+  }
+  *exit_status = status;
+  return true;
+}
+
+// Runs in the process forked for a request, returns the exit status of the job.
+static int RunCompileServerJob(int connection_fd, const char* program_name) {
+  Thread::Current()->InitAfterFork();
+  uint32_t request_size = 0;
+  iovec iov;
+  iov.iov_base = &request_size;
+  iov.iov_len = sizeof(request_size);
+  char control[CMSG_SPACE(sizeof(int))];
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t received = TEMP_FAILURE_RETRY(recvmsg(connection_fd, &message, 0));
+  cmsghdr* control_message = received > 0 ? CMSG_FIRSTHDR(&message) : nullptr;
+  if (control_message != nullptr && control_message->cmsg_level == SOL_SOCKET &&
+      control_message->cmsg_type == SCM_RIGHTS) {
+    int stderr_fd;
+    memcpy(&stderr_fd, CMSG_DATA(control_message), sizeof(stderr_fd));
+    dup2(stderr_fd, STDERR_FILENO);
+    close(stderr_fd);
+  }
+  if (received != sizeof(request_size) || request_size == 0 ||
+      request_size > kMaxCompileRequestSize) {
+    LOG(ERROR) << "Malformed compile server request";
+    return EXIT_FAILURE;
+  }
+  std::vector<char> request(request_size);
+  if (!ReadFromSocket(connection_fd, &request[0], request_size) || request.back() != '\0') {
+    LOG(ERROR) << "Malformed compile server request";
+    return EXIT_FAILURE;
+  }
+  // The server replies with the exit status of this process.
+  close(connection_fd);
+  const char* cwd = &request[0];
+  if (chdir(cwd) != 0) {
+    PLOG(ERROR) << "Failed to change to the working directory of the client " << cwd;
+    return EXIT_FAILURE;
+  }
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(program_name));
+  for (size_t i = strlen(cwd) + 1; i < request.size(); i += strlen(&request[i]) + 1) {
+    argv.push_back(&request[i]);
+  }
+  argv.push_back(nullptr);
+  return dex2oat(argv.size() - 1, &argv[0]);
+}
+
+// Replies to the clients of the finished jobs with their exit status.
+static void ReapCompileServerJobs(std::map<pid_t, int>* jobs) {
+  while (!jobs->empty()) {
+    int status;
+    pid_t pid = TEMP_FAILURE_RETRY(waitpid(-1, &status, WNOHANG));
+    if (pid <= 0) {
+      return;
+    }
+    std::map<pid_t, int>::iterator it = jobs->find(pid);
+    if (it == jobs->end()) {
+      continue;
+    }
+    int32_t exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    if (!WriteToSocket(it->second, &exit_status, sizeof(exit_status))) {
+      PLOG(WARNING) << "Failed to reply to a compile server client";
+    }
+    close(it->second);
+    jobs->erase(it);
+  }
+}
+
+static int RunCompileServer(const std::string& socket_path,
+                            const std::string& boot_image_filename,
+                            const std::vector<const char*>& runtime_args,
+                            Compiler::Kind compiler_kind,
+                            InstructionSet instruction_set,
+                            const InstructionSetFeatures& instruction_set_features,
+                            size_t thread_count,
+                            const char* program_name) {
+  CompileServer server;
+  server.boot_image_option = "-Ximage:";
+  if (boot_image_filename.empty()) {
+    server.boot_image_option += GetAndroidRoot();
+    server.boot_image_option += "/framework/boot.art";
+  } else {
+    server.boot_image_option += boot_image_filename;
+  }
+  server.runtime_args.assign(runtime_args.begin(), runtime_args.end());
+  server.compiler_kind = compiler_kind;
+  server.instruction_set = instruction_set;
+  server.instruction_set_features = instruction_set_features;
+
+  CompilerOptions compiler_options;
+  VerificationResults verification_results(&compiler_options);
+  DexFileToMethodInlinerMap method_inliner_map;
+  CompilerCallbacksImpl callbacks(&verification_results, &method_inliner_map);
+  Runtime::Options runtime_options;
+  runtime_options.push_back(std::make_pair(server.boot_image_option.c_str(),
+                                           reinterpret_cast<void*>(NULL)));
+  for (size_t i = 0; i < runtime_args.size(); i++) {
+    runtime_options.push_back(std::make_pair(runtime_args[i], reinterpret_cast<void*>(NULL)));
+  }
+  runtime_options.push_back(std::make_pair("compilercallbacks", &callbacks));
+  runtime_options.push_back(
+      std::make_pair("imageinstructionset",
+                     reinterpret_cast<const void*>(GetInstructionSetString(instruction_set))));
+  Dex2Oat* p_dex2oat;
+  if (!Dex2Oat::Create(&p_dex2oat,
+                       runtime_options,
+                       compiler_options,
+                       compiler_kind,
+                       instruction_set,
+                       instruction_set_features,
+                       &verification_results,
+                       &method_inliner_map,
+                       thread_count)) {
+    LOG(ERROR) << "Failed to create dex2oat";
+    return EXIT_FAILURE;
+  }
+  UniquePtr<Dex2Oat> dex2oat(p_dex2oat);
+  Thread* self = Thread::Current();
+  self->TransitionFromRunnableToSuspended(kNative);
+  WellKnownClasses::Init(self->GetJniEnv());
+  server.compiler_options = &compiler_options;
+  server.dex2oat = dex2oat.get();
+
+  sockaddr_un address;
+  if (!MakeSocketAddress(socket_path, &address)) {
+    return EXIT_FAILURE;
+  }
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd == -1) {
+    PLOG(ERROR) << "Failed to create the compile server socket";
+    return EXIT_FAILURE;
+  }
+  // Replace the socket of a previous server.
+  unlink(socket_path.c_str());
+  if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    PLOG(ERROR) << "Failed to listen on " << socket_path;
+    close(listen_fd);
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Compile server listening on " << socket_path;
+
+  // The connections of the running jobs, by pid.
+  std::map<pid_t, int> jobs;
+  while (true) {
+    pollfd poll_fd;
+    poll_fd.fd = listen_fd;
+    poll_fd.events = POLLIN;
+    poll_fd.revents = 0;
+    int ready = poll(&poll_fd, 1, jobs.empty() ? -1 : kCompileServerReapIntervalMs);
+    ReapCompileServerJobs(&jobs);
+    if (ready <= 0) {
+      continue;
+    }
+    int connection_fd = TEMP_FAILURE_RETRY(accept(listen_fd, nullptr, nullptr));
+    if (connection_fd == -1) {
+      PLOG(WARNING) << "Failed to accept a compile server connection";
+      continue;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(listen_fd);
+      for (std::map<pid_t, int>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        close(it->second);
+      }
+      compile_server = &server;
+      exit(RunCompileServerJob(connection_fd, program_name));
+    }
+    if (pid == -1) {
+      PLOG(ERROR) << "Failed to fork a compile server job";
+      close(connection_fd);
+      continue;
+    }
+    jobs.insert(std::make_pair(pid, connection_fd));
+  }
+}
+
 static int dex2oat(int argc, char** argv) {
   original_argc = argc;
   original_argv = argv;
@@ -718,6 +1272,29 @@ static int dex2oat(int argc, char** argv) {
     Usage("No arguments specified");
   }
 
+  // Hand the job to a compile server when there is one. File descriptors can't be forwarded.
+  std::string use_compile_server;
+  std::vector<std::string> compile_server_args;
+  bool passes_fds = false;
+  for (int i = 0; i < argc; i++) {
+    const StringPiece option(argv[i]);
+    if (option.starts_with("--use-compile-server=")) {
+      use_compile_server = option.substr(strlen("--use-compile-server=")).data();
+      continue;
+    }
+    if (option.starts_with("--zip-fd=") || option.starts_with("--oat-fd=") ||
+        option.starts_with("--swap-fd=")) {
+      passes_fds = true;
+    }
+    compile_server_args.push_back(argv[i]);
+  }
+  if (!use_compile_server.empty() && !passes_fds) {
+    int exit_status;
+    if (RunOnCompileServer(use_compile_server, compile_server_args, &exit_status)) {
+      return exit_status;
+    }
+  }
+
   std::vector<const char*> dex_filenames;
   std::vector<const char*> dex_locations;
   int zip_fd = -1;
@@ -729,6 +1306,9 @@ static int dex2oat(int argc, char** argv) {
   std::string bitcode_filename;
   const char* image_classes_zip_filename = NULL;
   const char* image_classes_filename = NULL;
+  bool startup_layout = false;
+  const char* startup_classes_filename = NULL;
+  bool compress_image = false;
   std::string image_filename;
   std::string boot_image_filename;
   uintptr_t image_base = 0;
@@ -748,16 +1328,25 @@ static int dex2oat(int argc, char** argv) {
   // Take the default set of instruction features from the build.
   InstructionSetFeatures instruction_set_features =
       ParseFeatureList(Runtime::GetDefaultInstructionSetFeatures());
+  bool instruction_set_features_specified = false;
 
   InstructionSet instruction_set = kRuntimeISA;
 
   // Profile file to use
   std::string profile_file;
+  std::string reuse_oat_filename;
+  std::string verified_oat_filename;
+  std::string swap_file_name;
+  int swap_fd = -1;
+  std::string compile_server_socket;
+  std::vector<std::string> reuse_dex_filenames;
 
   bool is_host = false;
   bool dump_stats = false;
   bool dump_timing = false;
   bool dump_passes = false;
+  bool dump_arena_stats = false;
+  std::string dump_timing_json_filename;
   bool dump_slow_timing = kIsDebugBuild;
   bool watch_dog_enabled = !kIsTargetBuild;
   bool generate_gdb_information = kIsDebugBuild;
@@ -817,6 +1406,19 @@ static int dex2oat(int argc, char** argv) {
       image_classes_filename = option.substr(strlen("--image-classes=")).data();
     } else if (option.starts_with("--image-classes-zip=")) {
       image_classes_zip_filename = option.substr(strlen("--image-classes-zip=")).data();
+    } else if (option.starts_with("--image-layout=")) {
+      StringPiece layout = option.substr(strlen("--image-layout="));
+      if (layout == "walk") {
+        startup_layout = false;
+      } else if (layout == "startup") {
+        startup_layout = true;
+      } else {
+        Usage("Unknown image layout: %s", layout.data());
+      }
+    } else if (option == "--compress-image") {
+      compress_image = true;
+    } else if (option.starts_with("--startup-classes=")) {
+      startup_classes_filename = option.substr(strlen("--startup-classes=")).data();
     } else if (option.starts_with("--base=")) {
       const char* image_base_str = option.substr(strlen("--base=")).data();
       char* end;
@@ -844,6 +1446,7 @@ static int dex2oat(int argc, char** argv) {
     } else if (option.starts_with("--instruction-set-features=")) {
       StringPiece str = option.substr(strlen("--instruction-set-features=")).data();
       instruction_set_features = ParseFeatureList(str.as_string());
+      instruction_set_features_specified = true;
     } else if (option.starts_with("--compiler-backend=")) {
       StringPiece backend_str = option.substr(strlen("--compiler-backend=")).data();
       if (backend_str == "Quick") {
@@ -911,9 +1514,33 @@ static int dex2oat(int argc, char** argv) {
       dump_passes = true;
     } else if (option == "--dump-stats") {
       dump_stats = true;
+    } else if (option == "--dump-arena-stats") {
+      dump_arena_stats = true;
+    } else if (option.starts_with("--dump-timing-json=")) {
+      dump_timing_json_filename = option.substr(strlen("--dump-timing-json=")).data();
     } else if (option.starts_with("--profile-file=")) {
       profile_file = option.substr(strlen("--profile-file=")).data();
       VLOG(compiler) << "dex2oat: profile file is " << profile_file;
+    } else if (option.starts_with("--swap-file=")) {
+      swap_file_name = option.substr(strlen("--swap-file=")).data();
+    } else if (option.starts_with("--swap-fd=")) {
+      const char* swap_fd_str = option.substr(strlen("--swap-fd=")).data();
+      if (!ParseInt(swap_fd_str, &swap_fd)) {
+        Usage("Failed to parse --swap-fd argument '%s' as an integer", swap_fd_str);
+      }
+      if (swap_fd < 0) {
+        Usage("--swap-fd passed a negative value %d", swap_fd);
+      }
+    } else if (option.starts_with("--reuse-oat-file=")) {
+      reuse_oat_filename = option.substr(strlen("--reuse-oat-file=")).data();
+    } else if (option.starts_with("--reuse-dex-file=")) {
+      reuse_dex_filenames.push_back(option.substr(strlen("--reuse-dex-file=")).data());
+    } else if (option.starts_with("--verified-oat-file=")) {
+      verified_oat_filename = option.substr(strlen("--verified-oat-file=")).data();
+    } else if (option.starts_with("--compile-server=")) {
+      compile_server_socket = option.substr(strlen("--compile-server=")).data();
+    } else if (option.starts_with("--use-compile-server=")) {
+      // The compile server couldn't run the job.
     } else if (option == "--no-profile-file") {
       // No profile
     } else if (option == "--print-pass-names") {
@@ -926,6 +1553,40 @@ static int dex2oat(int argc, char** argv) {
     }
   }
 
+  // On the device the code is compiled for the CPU running dex2oat unless the features are given.
+  const bool compiling_for_this_cpu =
+      instruction_set == kRuntimeISA || (instruction_set == kThumb2 && kRuntimeISA == kArm);
+  if (kIsTargetBuild && !instruction_set_features_specified && compiling_for_this_cpu) {
+    InstructionSetFeatures cpu_features = InstructionSetFeatures::GuessInstructionSetFeatures();
+    if (cpu_features.HasDivideInstruction()) {
+      instruction_set_features.SetHasDivideInstruction(true);
+    }
+    if (cpu_features.HasLpae()) {
+      instruction_set_features.SetHasLpae(true);
+    }
+    if (cpu_features.HasNeon()) {
+      instruction_set_features.SetHasNeon(true);
+    }
+    if (cpu_features.HasSse4_1()) {
+      instruction_set_features.SetHasSse4_1(true);
+    }
+    if (cpu_features.HasPopcnt()) {
+      instruction_set_features.SetHasPopcnt(true);
+    }
+  }
+
+  if (!compile_server_socket.empty()) {
+    if (compile_server != nullptr) {
+      Usage("--compile-server should not be used by a compile server job");
+    }
+    if (!image_filename.empty()) {
+      Usage("--compile-server should not be used with --image");
+    }
+    return RunCompileServer(compile_server_socket, boot_image_filename, runtime_args,
+                            compiler_kind, instruction_set, instruction_set_features,
+                            thread_count, original_argv[0]);
+  }
+
   if (oat_filename.empty() && oat_fd == -1) {
     Usage("Output must be supplied with either --oat-file or --oat-fd");
   }
@@ -946,6 +1607,18 @@ static int dex2oat(int argc, char** argv) {
     Usage("--oat-fd should not be used with --image");
   }
 
+  if (!swap_file_name.empty() && swap_fd != -1) {
+    Usage("--swap-file should not be used with --swap-fd");
+  }
+
+  if (!reuse_oat_filename.empty() && !image_filename.empty()) {
+    Usage("--reuse-oat-file should not be used with --image");
+  }
+
+  if (reuse_oat_filename.empty() != reuse_dex_filenames.empty()) {
+    Usage("--reuse-oat-file and --reuse-dex-file should be used together");
+  }
+
   if (android_root.empty()) {
     const char* android_root_env_var = getenv("ANDROID_ROOT");
     if (android_root_env_var == NULL) {
@@ -973,6 +1646,18 @@ static int dex2oat(int argc, char** argv) {
     Usage("--image-classes should not be used with --boot-image");
   }
 
+  if (startup_layout && !image) {
+    Usage("--image-layout=startup should only be used with --image");
+  }
+
+  if (compress_image && !image) {
+    Usage("--compress-image should only be used with --image");
+  }
+
+  if (startup_classes_filename != NULL && !startup_layout) {
+    Usage("--startup-classes should only be used with --image-layout=startup");
+  }
+
   if (image_classes_zip_filename != NULL && image_classes_filename == NULL) {
     Usage("--image-classes-zip should be used with --image-classes");
   }
@@ -1035,6 +1720,8 @@ static int dex2oat(int argc, char** argv) {
     compiler_filter = CompilerOptions::kVerifyNone;
   } else if (strcmp(compiler_filter_string, "interpret-only") == 0) {
     compiler_filter = CompilerOptions::kInterpretOnly;
+  } else if (strcmp(compiler_filter_string, "profiled") == 0) {
+    compiler_filter = CompilerOptions::kProfiled;
   } else if (strcmp(compiler_filter_string, "space") == 0) {
     compiler_filter = CompilerOptions::kSpace;
   } else if (strcmp(compiler_filter_string, "balanced") == 0) {
@@ -1047,7 +1734,7 @@ static int dex2oat(int argc, char** argv) {
     Usage("Unknown --compiler-filter value %s", compiler_filter_string);
   }
 
-  CompilerOptions compiler_options(compiler_filter,
+  CompilerOptions job_compiler_options(compiler_filter,
                                    huge_method_threshold,
                                    large_method_threshold,
                                    small_method_threshold,
@@ -1055,9 +1742,15 @@ static int dex2oat(int argc, char** argv) {
                                    num_dex_methods_threshold,
                                    generate_gdb_information
 #ifdef ART_SEA_IR_MODE
-                                   , compiler_options.sea_ir_ = true;
+                                   , job_compiler_options.sea_ir_ = true;
 #endif
                                    );  // NOLINT(whitespace/parens)
+  // The compiler state of the runtime of a compile server points to the options of the server.
+  if (compile_server != nullptr) {
+    *compile_server->compiler_options = job_compiler_options;
+  }
+  CompilerOptions& compiler_options =
+      compile_server != nullptr ? *compile_server->compiler_options : job_compiler_options;
 
   // Done with usage checks, enable watchdog if requested
   WatchDog watch_dog(watch_dog_enabled);
@@ -1083,13 +1776,23 @@ static int dex2oat(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (!swap_file_name.empty()) {
+    swap_fd = open(swap_file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (swap_fd == -1) {
+      PLOG(ERROR) << "Failed to create swap file: " << swap_file_name;
+      return EXIT_FAILURE;
+    }
+    // Only the file descriptor is used, the space is freed when it is closed.
+    unlink(swap_file_name.c_str());
+  }
+
   timings.StartSplit("dex2oat Setup");
   LOG(INFO) << CommandLine();
 
   Runtime::Options runtime_options;
   std::vector<const DexFile*> boot_class_path;
   if (boot_image_option.empty()) {
-    size_t failure_count = OpenDexFiles(dex_filenames, dex_locations, boot_class_path);
+    size_t failure_count = OpenDexFiles(dex_filenames, dex_locations, nullptr, boot_class_path);
     if (failure_count > 0) {
       LOG(ERROR) << "Failed to open some dex files: " << failure_count;
       return EXIT_FAILURE;
@@ -1112,28 +1815,45 @@ static int dex2oat(int argc, char** argv) {
                      reinterpret_cast<const void*>(GetInstructionSetString(instruction_set))));
 
   Dex2Oat* p_dex2oat;
-  if (!Dex2Oat::Create(&p_dex2oat,
-                       runtime_options,
-                       compiler_options,
-                       compiler_kind,
-                       instruction_set,
-                       instruction_set_features,
-                       &verification_results,
-                       &method_inliner_map,
-                       thread_count)) {
+  if (compile_server != nullptr) {
+    // The runtime of the server is ready, it only has to be the one this job would create.
+    if (compile_server->boot_image_option != boot_image_option ||
+        compile_server->runtime_args != std::vector<std::string>(runtime_args.begin(),
+                                                                 runtime_args.end()) ||
+        compile_server->compiler_kind != compiler_kind ||
+        compile_server->instruction_set != instruction_set ||
+        compile_server->instruction_set_features != instruction_set_features) {
+      LOG(ERROR) << "The compile server was started with different runtime options";
+      return kCompileServerMismatch;
+    }
+    p_dex2oat = compile_server->dex2oat;
+    p_dex2oat->StartJob(thread_count);
+  } else if (!Dex2Oat::Create(&p_dex2oat,
+                              runtime_options,
+                              compiler_options,
+                              compiler_kind,
+                              instruction_set,
+                              instruction_set_features,
+                              &verification_results,
+                              &method_inliner_map,
+                              thread_count)) {
     LOG(ERROR) << "Failed to create dex2oat";
     return EXIT_FAILURE;
   }
+  // A compile server job owns its copy of the server state, it is torn down like the runtime of a
+  // standalone dex2oat.
   UniquePtr<Dex2Oat> dex2oat(p_dex2oat);
-  // Runtime::Create acquired the mutator_lock_ that is normally given away when we Runtime::Start,
-  // give it away now so that we don't starve GC.
   Thread* self = Thread::Current();
-  self->TransitionFromRunnableToSuspended(kNative);
-  // If we're doing the image, override the compiler filter to force full compilation. Must be
-  // done ahead of WellKnownClasses::Init that causes verification.  Note: doesn't force
-  // compilation of class initializers.
-  // Whilst we're in native take the opportunity to initialize well known classes.
-  WellKnownClasses::Init(self->GetJniEnv());
+  if (compile_server == nullptr) {
+    // Runtime::Create acquired the mutator_lock_ that is normally given away when we
+    // Runtime::Start, give it away now so that we don't starve GC.
+    self->TransitionFromRunnableToSuspended(kNative);
+    // If we're doing the image, override the compiler filter to force full compilation. Must be
+    // done ahead of WellKnownClasses::Init that causes verification.  Note: doesn't force
+    // compilation of class initializers.
+    // Whilst we're in native take the opportunity to initialize well known classes.
+    WellKnownClasses::Init(self->GetJniEnv());
+  }
 
   // If --image-classes was specified, calculate the full list of classes to include in the image
   UniquePtr<CompilerDriver::DescriptorSet> image_classes(NULL);
@@ -1153,10 +1873,29 @@ static int dex2oat(int argc, char** argv) {
     }
   }
 
+  UniquePtr<CompilerDriver::DescriptorSet> startup_classes(NULL);
+  if (startup_classes_filename != NULL) {
+    startup_classes.reset(dex2oat->ReadImageClassesFromFile(startup_classes_filename));
+    if (startup_classes.get() == NULL) {
+      LOG(ERROR) << "Failed to read the startup classes from '" << startup_classes_filename << "'";
+      return EXIT_FAILURE;
+    }
+  }
+
   std::vector<const DexFile*> dex_files;
   if (boot_image_option.empty()) {
     dex_files = Runtime::Current()->GetClassLinker()->GetBootClassPath();
   } else {
+    UniquePtr<const OatFile> verified_oat_file;
+    if (!verified_oat_filename.empty()) {
+      std::string error_msg;
+      verified_oat_file.reset(OatFile::Open(verified_oat_filename, verified_oat_filename, nullptr,
+                                            false, &error_msg));
+      if (verified_oat_file.get() == nullptr) {
+        LOG(WARNING) << "Verifying all the dex files, failed to open '" << verified_oat_filename
+                     << "': " << error_msg;
+      }
+    }
     if (dex_filenames.empty()) {
       ATRACE_BEGIN("Opening zip archive from file descriptor");
       std::string error_msg;
@@ -1167,7 +1906,10 @@ static int dex2oat(int argc, char** argv) {
             << error_msg;
         return EXIT_FAILURE;
       }
-      const DexFile* dex_file = DexFile::Open(*zip_archive.get(), zip_location, &error_msg);
+      UniquePtr<const DexFile> verified_dex_file(OpenVerifiedDexFile(verified_oat_file.get(),
+                                                                     zip_location));
+      const DexFile* dex_file = DexFile::Open(*zip_archive.get(), zip_location,
+                                              verified_dex_file.get(), &error_msg);
       if (dex_file == NULL) {
         LOG(ERROR) << "Failed to open dex from file descriptor for zip file '" << zip_location
             << "': " << error_msg;
@@ -1176,7 +1918,8 @@ static int dex2oat(int argc, char** argv) {
       dex_files.push_back(dex_file);
       ATRACE_END();
     } else {
-      size_t failure_count = OpenDexFiles(dex_filenames, dex_locations, dex_files);
+      size_t failure_count = OpenDexFiles(dex_filenames, dex_locations, verified_oat_file.get(),
+                                          dex_files);
       if (failure_count > 0) {
         LOG(ERROR) << "Failed to open some dex files: " << failure_count;
         return EXIT_FAILURE;
@@ -1206,6 +1949,15 @@ static int dex2oat(int argc, char** argv) {
     }
   }
 
+  // Lay out the instance fields the profile saw accessed together. The boot image is left alone,
+  // the runtime relies on the layout of the classes it mirrors.
+  if (!image && !profile_file.empty()) {
+    std::map<std::string, std::vector<std::string>> hot_fields;
+    if (ProfileHelper::LoadHotFields(hot_fields, profile_file)) {
+      Runtime::Current()->GetClassLinker()->SetHotFields(hot_fields, dex_files);
+    }
+  }
+
   /*
    * If we're not in interpret-only or verify-none mode, go ahead and compile small applications.
    * Don't bother to check if we're doing the image.
@@ -1233,9 +1985,13 @@ static int dex2oat(int argc, char** argv) {
                                                                   image_classes,
                                                                   dump_stats,
                                                                   dump_passes,
+                                                                  dump_arena_stats,
                                                                   timings,
                                                                   compiler_phases_timings,
-                                                                  profile_file));
+                                                                  profile_file,
+                                                                  swap_fd,
+                                                                  reuse_oat_filename,
+                                                                  reuse_dex_filenames));
 
   if (compiler.get() == NULL) {
     LOG(ERROR) << "Failed to create oat file: " << oat_location;
@@ -1300,7 +2056,10 @@ static int dex2oat(int argc, char** argv) {
                                                            image_base,
                                                            oat_unstripped,
                                                            oat_location,
-                                                           *compiler.get());
+                                                           *compiler.get(),
+                                                           startup_layout,
+                                                           startup_classes.get(),
+                                                           compress_image);
     if (!image_creation_success) {
       return EXIT_FAILURE;
     }
@@ -1313,6 +2072,11 @@ static int dex2oat(int argc, char** argv) {
     }
     if (dump_passes) {
       LOG(INFO) << Dumpable<CumulativeLogger>(*compiler.get()->GetTimingsLogger());
+      DumpPassStats();
+    }
+    if (!dump_timing_json_filename.empty()) {
+      DumpTimingJson(dump_timing_json_filename, timings, *compiler.get(), compiler_kind,
+                     dump_passes);
     }
     return EXIT_SUCCESS;
   }
@@ -1358,6 +2122,11 @@ static int dex2oat(int argc, char** argv) {
   }
   if (dump_passes) {
     LOG(INFO) << Dumpable<CumulativeLogger>(compiler_phases_timings);
+    DumpPassStats();
+  }
+  if (!dump_timing_json_filename.empty()) {
+    DumpTimingJson(dump_timing_json_filename, timings, *compiler.get(), compiler_kind,
+                   dump_passes);
   }
 
   // Everything was successfully written, do an explicit exit here to avoid running Runtime
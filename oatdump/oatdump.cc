@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -84,13 +87,24 @@ static void usage() {
           "    Example: --dump:raw_gc_map\n"
           "    Default: neither\n"
           "\n");
+  fprintf(stderr,
+          "  --stats: instead of dumping every method and object, dump the sizes of the\n"
+          "      compiled code and tables per package, class and method, how much of them\n"
+          "      is shared by deduplication, and why methods were not compiled.\n"
+          "      Example: --stats\n"
+          "\n");
+  fprintf(stderr,
+          "  --dirty-pages=<pid>: with --image, compare the image mapped by process <pid>\n"
+          "      with the image file and report the classes of the objects it wrote to, and\n"
+          "      the methods on the pages of oat code it has resident.\n"
+          "      Example: --dirty-pages=1234\n"
+          "\n");
   exit(EXIT_FAILURE);
 }
 
 const char* image_roots_descriptions_[] = {
   "kResolutionMethod",
   "kImtConflictMethod",
-  "kDefaultImt",
   "kCalleeSaveMethod",
   "kRefsOnlySaveMethod",
   "kRefsAndArgsSaveMethod",
@@ -98,13 +112,23 @@ const char* image_roots_descriptions_[] = {
   "kClassRoots",
 };
 
+// Discards what is written to it.
+class NullBuffer : public std::streambuf {
+ private:
+  int_type overflow(int_type c) {
+    return std::char_traits<char>::not_eof(c);
+  }
+};
+
 class OatDumper {
  public:
-  explicit OatDumper(const OatFile& oat_file, bool dump_raw_mapping_table, bool dump_raw_gc_map)
+  explicit OatDumper(const OatFile& oat_file, bool dump_raw_mapping_table, bool dump_raw_gc_map,
+                     bool dump_stats)
     : oat_file_(oat_file),
       oat_dex_files_(oat_file.GetOatDexFiles()),
       dump_raw_mapping_table_(dump_raw_mapping_table),
       dump_raw_gc_map_(dump_raw_gc_map),
+      dump_stats_(dump_stats),
       disassembler_(Disassembler::Create(oat_file_.GetOatHeader().GetInstructionSet())) {
     AddAllOffsets();
   }
@@ -177,6 +201,11 @@ class OatDumper {
 
     os << std::flush;
 
+    if (dump_stats_) {
+      DumpStats(os);
+      return;
+    }
+
     for (size_t i = 0; i < oat_dex_files_.size(); i++) {
       const OatFile::OatDexFile* oat_dex_file = oat_dex_files_[i];
       CHECK(oat_dex_file != NULL);
@@ -584,22 +613,13 @@ class OatDumper {
   uint32_t DumpMappingAtOffset(std::ostream& os, const OatFile::OatMethod& oat_method,
                                size_t offset, bool suspend_point_mapping) {
     MappingTable table(oat_method.GetMappingTable());
-    if (suspend_point_mapping && table.PcToDexSize() > 0) {
-      typedef MappingTable::PcToDexIterator It;
-      for (It cur = table.PcToDexBegin(), end = table.PcToDexEnd(); cur != end; ++cur) {
-        if (offset == cur.NativePcOffset()) {
-          os << StringPrintf("suspend point dex PC: 0x%04x\n", cur.DexPc());
-          return cur.DexPc();
-        }
-      }
-    } else if (!suspend_point_mapping && table.DexToPcSize() > 0) {
-      typedef MappingTable::DexToPcIterator It;
-      for (It cur = table.DexToPcBegin(), end = table.DexToPcEnd(); cur != end; ++cur) {
-        if (offset == cur.NativePcOffset()) {
-          os << StringPrintf("catch entry dex PC: 0x%04x\n", cur.DexPc());
-          return cur.DexPc();
-        }
-      }
+    uint32_t dex_pc;
+    if (suspend_point_mapping && table.FindPcToDex(offset, &dex_pc)) {
+      os << StringPrintf("suspend point dex PC: 0x%04x\n", dex_pc);
+      return dex_pc;
+    } else if (!suspend_point_mapping && table.FindDexToPc(offset, &dex_pc)) {
+      os << StringPrintf("catch entry dex PC: 0x%04x\n", dex_pc);
+      return dex_pc;
     }
     return DexFile::kDexNoIndex;
   }
@@ -725,10 +745,245 @@ class OatDumper {
     }
   }
 
+  // The sizes of the compiled data of a method, or of all the methods of a class or a package.
+  struct OatSizes {
+    OatSizes()
+        : methods(0),
+          compiled_methods(0),
+          code_bytes(0),
+          mapping_table_bytes(0),
+          vmap_table_bytes(0),
+          gc_map_bytes(0) {}
+
+    size_t TotalBytes() const {
+      return code_bytes + mapping_table_bytes + vmap_table_bytes + gc_map_bytes;
+    }
+
+    void Add(const OatSizes& other) {
+      methods += other.methods;
+      compiled_methods += other.compiled_methods;
+      code_bytes += other.code_bytes;
+      mapping_table_bytes += other.mapping_table_bytes;
+      vmap_table_bytes += other.vmap_table_bytes;
+      gc_map_bytes += other.gc_map_bytes;
+    }
+
+    size_t methods;
+    size_t compiled_methods;
+    size_t code_bytes;
+    size_t mapping_table_bytes;
+    size_t vmap_table_bytes;
+    size_t gc_map_bytes;
+  };
+
+  typedef std::pair<std::string, OatSizes> NamedOatSizes;
+
+  // Why a method has no compiled code.
+  enum NotCompiledReason {
+    kNotCompiledAbstract,       // No code item.
+    kNotCompiledNative,         // Native method using the generic JNI trampoline.
+    kNotCompiledUnverified,     // Its class failed verification, or has to be verified at runtime.
+    kNotCompiledFiltered,       // Left to the interpreter by the compiler filter or a bailout.
+    kNotCompiledReasonCount
+  };
+
+  // The sizes of the compiled data of all methods, counting data shared by several methods once.
+  struct DedupeStats {
+    DedupeStats() : unique_bytes(0), total_bytes(0) {}
+
+    void Add(uint32_t offset, size_t bytes) {
+      if (offset == 0) {
+        return;
+      }
+      total_bytes += bytes;
+      if (offsets.insert(offset).second) {
+        unique_bytes += bytes;
+      }
+    }
+
+    double SharingRatio() const {
+      return unique_bytes == 0 ? 1.0
+                               : static_cast<double>(total_bytes) /
+                                     static_cast<double>(unique_bytes);
+    }
+
+    std::set<uint32_t> offsets;
+    size_t unique_bytes;
+    size_t total_bytes;
+  };
+
+  static bool CompareTotalBytes(const NamedOatSizes& lhs, const NamedOatSizes& rhs) {
+    return lhs.second.TotalBytes() > rhs.second.TotalBytes();
+  }
+
+  // Returns the package of a class descriptor, e.g. "java.lang" for "Ljava/lang/String;".
+  static std::string GetPackageName(const char* descriptor) {
+    std::string class_name(PrettyDescriptor(descriptor));
+    size_t last_dot = class_name.rfind('.');
+    return last_dot == std::string::npos ? "<default>" : class_name.substr(0, last_dot);
+  }
+
+  void DumpStats(std::ostream& os) {
+    SafeMap<std::string, OatSizes> package_sizes;
+    std::vector<NamedOatSizes> class_sizes;
+    std::vector<NamedOatSizes> method_sizes;
+    OatSizes total_sizes;
+    DedupeStats code_dedupe;
+    DedupeStats mapping_table_dedupe;
+    DedupeStats vmap_table_dedupe;
+    DedupeStats gc_map_dedupe;
+    size_t not_compiled[kNotCompiledReasonCount] = {};
+
+    for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+      CHECK(oat_dex_file != nullptr);
+      std::string error_msg;
+      UniquePtr<const DexFile> dex_file(oat_dex_file->OpenDexFile(&error_msg));
+      if (dex_file.get() == nullptr) {
+        LOG(WARNING) << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation()
+            << "': " << error_msg;
+        continue;
+      }
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           class_def_index++) {
+        const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+        const byte* class_data = dex_file->GetClassData(class_def);
+        if (class_data == nullptr) {
+          continue;
+        }
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+        bool is_verified = oat_class.GetStatus() >= mirror::Class::kStatusVerified;
+        OatSizes class_total;
+        ClassDataItemIterator it(*dex_file, class_data);
+        SkipAllFields(it);
+        for (uint32_t class_method_index = 0; it.HasNext(); class_method_index++, it.Next()) {
+          const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+          OatSizes sizes;
+          sizes.methods = 1;
+          if (oat_method.GetCodeOffset() == 0) {
+            if (it.GetMethodCodeItem() == nullptr) {
+              not_compiled[(it.GetMemberAccessFlags() & kAccNative) != 0 ? kNotCompiledNative
+                                                                         : kNotCompiledAbstract]++;
+            } else {
+              not_compiled[is_verified ? kNotCompiledFiltered : kNotCompiledUnverified]++;
+            }
+          } else {
+            sizes.compiled_methods = 1;
+            sizes.code_bytes = oat_method.GetQuickCode() != nullptr
+                ? oat_method.GetQuickCodeSize()
+                : oat_method.GetPortableCodeSize();
+            sizes.mapping_table_bytes = ComputeSize(oat_method.GetMappingTable());
+            sizes.vmap_table_bytes = ComputeSize(oat_method.GetVmapTable());
+            sizes.gc_map_bytes = ComputeSize(oat_method.GetNativeGcMap());
+            code_dedupe.Add(oat_method.GetCodeOffset() & ~0x1, sizes.code_bytes);
+            mapping_table_dedupe.Add(oat_method.GetMappingTableOffset(),
+                                     sizes.mapping_table_bytes);
+            vmap_table_dedupe.Add(oat_method.GetVmapTableOffset(), sizes.vmap_table_bytes);
+            gc_map_dedupe.Add(oat_method.GetNativeGcMapOffset(), sizes.gc_map_bytes);
+            method_sizes.push_back(
+                std::make_pair(PrettyMethod(it.GetMemberIndex(), *dex_file, true), sizes));
+          }
+          class_total.Add(sizes);
+        }
+        const char* descriptor = dex_file->GetClassDescriptor(class_def);
+        std::string package_name(GetPackageName(descriptor));
+        SafeMap<std::string, OatSizes>::iterator package_it = package_sizes.find(package_name);
+        if (package_it == package_sizes.end()) {
+          package_sizes.Put(package_name, class_total);
+        } else {
+          package_it->second.Add(class_total);
+        }
+        class_sizes.push_back(std::make_pair(PrettyDescriptor(descriptor), class_total));
+        total_sizes.Add(class_total);
+      }
+    }
+
+    os << "STATS:\n";
+    Indenter indent1_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent1_os(&indent1_filter);
+    indent1_os << StringPrintf("oat_file_bytes      = %10zd\n", oat_file_.Size());
+    DumpSizes(indent1_os, "all methods", total_sizes);
+    indent1_os << "\n";
+
+    indent1_os << "Deduplication (bytes referenced by methods / bytes in the oat file):\n";
+    {
+      Indenter indent2_filter(indent1_os.rdbuf(), kIndentChar, kIndentBy1Count);
+      std::ostream indent2_os(&indent2_filter);
+      DumpDedupe(indent2_os, "code", code_dedupe);
+      DumpDedupe(indent2_os, "mapping_table", mapping_table_dedupe);
+      DumpDedupe(indent2_os, "vmap_table", vmap_table_dedupe);
+      DumpDedupe(indent2_os, "gc_map", gc_map_dedupe);
+    }
+    indent1_os << "\n";
+
+    size_t methods = std::max<size_t>(total_sizes.methods, 1);
+    double compiled_percent = total_sizes.compiled_methods * 100.0 / methods;
+    indent1_os << StringPrintf("Methods not compiled: %zd of %zd (%.1f%% compiled)\n",
+                               total_sizes.methods - total_sizes.compiled_methods,
+                               total_sizes.methods, compiled_percent);
+    {
+      static const char* const kReasonNames[kNotCompiledReasonCount] = {
+        "abstract", "native (generic JNI)", "class not verified", "interpreted by filter",
+      };
+      Indenter indent2_filter(indent1_os.rdbuf(), kIndentChar, kIndentBy1Count);
+      std::ostream indent2_os(&indent2_filter);
+      for (size_t i = 0; i < kNotCompiledReasonCount; ++i) {
+        indent2_os << StringPrintf("%-22s %8zd (%4.1f%% of methods)\n", kReasonNames[i],
+                                   not_compiled[i], not_compiled[i] * 100.0 / methods);
+      }
+    }
+    indent1_os << "\n";
+
+    std::vector<NamedOatSizes> packages(package_sizes.begin(), package_sizes.end());
+    DumpLargest(indent1_os, "packages", &packages, packages.size());
+    DumpLargest(indent1_os, "classes", &class_sizes, kStatsLargestCount);
+    DumpLargest(indent1_os, "methods", &method_sizes, kStatsLargestCount);
+    os << std::flush;
+  }
+
+  static void DumpSizes(std::ostream& os, const std::string& name, const OatSizes& sizes) {
+    os << name << StringPrintf(": %zd methods, %zd compiled\n",
+                               sizes.methods, sizes.compiled_methods);
+    Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent_os(&indent_filter);
+    indent_os << StringPrintf("total_bytes         = %10zd\n"
+                              "code_bytes          = %10zd\n"
+                              "mapping_table_bytes = %10zd\n"
+                              "vmap_table_bytes    = %10zd\n"
+                              "gc_map_bytes        = %10zd\n",
+                              sizes.TotalBytes(), sizes.code_bytes, sizes.mapping_table_bytes,
+                              sizes.vmap_table_bytes, sizes.gc_map_bytes);
+  }
+
+  static void DumpDedupe(std::ostream& os, const char* name, const DedupeStats& dedupe) {
+    os << StringPrintf("%-13s %10zd / %10zd = %.2f\n", name, dedupe.total_bytes,
+                       dedupe.unique_bytes, dedupe.SharingRatio());
+  }
+
+  // Dumps the `count` entries of `sizes` with the most bytes, largest first.
+  static void DumpLargest(std::ostream& os, const char* what, std::vector<NamedOatSizes>* sizes,
+                          size_t count) {
+    count = std::min(count, sizes->size());
+    std::partial_sort(sizes->begin(), sizes->begin() + count, sizes->end(), CompareTotalBytes);
+    os << "Largest " << what << " (" << count << " of " << sizes->size() << "):\n";
+    Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent_os(&indent_filter);
+    for (size_t i = 0; i < count; ++i) {
+      DumpSizes(indent_os, (*sizes)[i].first, (*sizes)[i].second);
+    }
+    os << "\n";
+  }
+
+  enum {
+    // Number of classes and methods listed by --stats.
+    kStatsLargestCount = 50
+  };
+
   const OatFile& oat_file_;
   std::vector<const OatFile::OatDexFile*> oat_dex_files_;
   bool dump_raw_mapping_table_;
   bool dump_raw_gc_map_;
+  bool dump_stats_;
   std::set<uintptr_t> offsets_;
   UniquePtr<Disassembler> disassembler_;
 };
@@ -737,10 +992,11 @@ class ImageDumper {
  public:
   explicit ImageDumper(std::ostream* os, gc::space::ImageSpace& image_space,
                        const ImageHeader& image_header, bool dump_raw_mapping_table,
-                       bool dump_raw_gc_map)
+                       bool dump_raw_gc_map, bool dump_stats)
       : os_(os), image_space_(image_space), image_header_(image_header),
         dump_raw_mapping_table_(dump_raw_mapping_table),
-        dump_raw_gc_map_(dump_raw_gc_map) {}
+        dump_raw_gc_map_(dump_raw_gc_map),
+        dump_stats_(dump_stats) {}
 
   void Dump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     std::ostream& os = *os_;
@@ -751,6 +1007,18 @@ class ImageDumper {
     os << "IMAGE BITMAP OFFSET: " << reinterpret_cast<void*>(image_header_.GetImageBitmapOffset())
        << " SIZE: " << reinterpret_cast<void*>(image_header_.GetImageBitmapSize()) << "\n\n";
 
+    os << "IMAGE CLASS TABLE OFFSET: "
+       << reinterpret_cast<void*>(image_header_.GetClassTableOffset())
+       << " SIZE: " << reinterpret_cast<void*>(image_header_.GetClassTableSize()) << "\n\n";
+
+    os << "IMAGE INTERN TABLE OFFSET: "
+       << reinterpret_cast<void*>(image_header_.GetInternTableOffset())
+       << " SIZE: " << reinterpret_cast<void*>(image_header_.GetInternTableSize()) << "\n\n";
+
+    os << "IMAGE RELOCATIONS OFFSET: "
+       << reinterpret_cast<void*>(image_header_.GetRelocationsOffset())
+       << " SIZE: " << reinterpret_cast<void*>(image_header_.GetRelocationsSize()) << "\n\n";
+
     os << "OAT CHECKSUM: " << StringPrintf("0x%08x\n\n", image_header_.GetOatChecksum());
 
     os << "OAT FILE BEGIN:" << reinterpret_cast<void*>(image_header_.GetOatFileBegin()) << "\n\n";
@@ -819,7 +1087,7 @@ class ImageDumper {
     stats_.oat_file_bytes = oat_file->Size();
 
     oat_dumper_.reset(new OatDumper(*oat_file, dump_raw_mapping_table_,
-        dump_raw_gc_map_));
+        dump_raw_gc_map_, dump_stats_));
 
     for (const OatFile::OatDexFile* oat_dex_file : oat_file->GetOatDexFiles()) {
       CHECK(oat_dex_file != NULL);
@@ -853,7 +1121,10 @@ class ImageDumper {
     {
       std::ostream* saved_os = os_;
       Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
-      std::ostream indent_os(&indent_filter);
+      // With --stats, the objects are only walked to count them per class.
+      NullBuffer null_buffer;
+      std::ostream indent_os(dump_stats_ ? static_cast<std::streambuf*>(&null_buffer)
+                                         : &indent_filter);
       os_ = &indent_os;
       ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
       for (const auto& space : spaces) {
@@ -1442,10 +1713,316 @@ class ImageDumper {
   const ImageHeader& image_header_;
   bool dump_raw_mapping_table_;
   bool dump_raw_gc_map_;
+  bool dump_stats_;
 
   DISALLOW_COPY_AND_ASSIGN(ImageDumper);
 };
 
+// Compares the boot image and oat file mapped by a live process, such as an app forked from the
+// zygote, with the files: the image pages the process wrote to, and the classes of the objects
+// on them, and the pages of oat code the process has resident. The image and oat file are not
+// relocated, so the process maps them at the same addresses as this one.
+class DirtyPageDumper {
+ public:
+  explicit DirtyPageDumper(std::ostream* os, gc::space::ImageSpace& image_space,
+                           const ImageHeader& image_header, pid_t pid)
+      : os_(os), image_space_(image_space), image_header_(image_header), pid_(pid),
+        image_begin_(image_header.GetImageBegin()) {}
+
+  bool Dump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    os << "PROCESS: " << pid_ << "\n\n";
+
+    std::string maps;
+    std::string maps_filename(StringPrintf("/proc/%d/maps", pid_));
+    if (!ReadFileToString(maps_filename, &maps)) {
+      os << "Failed to read " << maps_filename << "\n";
+      return false;
+    }
+    std::string image_filename = image_space_.GetImageFilename();
+    if (!IsMapped(maps, image_begin_, image_filename)) {
+      os << "Image " << image_filename << " is not mapped at "
+         << reinterpret_cast<void*>(image_begin_) << "\n";
+      return false;
+    }
+
+    std::string mem_filename(StringPrintf("/proc/%d/mem", pid_));
+    std::string pagemap_filename(StringPrintf("/proc/%d/pagemap", pid_));
+    UniquePtr<File> mem_file(OS::OpenFileForReading(mem_filename.c_str()));
+    UniquePtr<File> pagemap_file(OS::OpenFileForReading(pagemap_filename.c_str()));
+    UniquePtr<File> image_file(OS::OpenFileForReading(image_filename.c_str()));
+    if (mem_file.get() == nullptr || pagemap_file.get() == nullptr || image_file.get() == nullptr) {
+      os << "Failed to open " << mem_filename << ", " << pagemap_filename << " or "
+         << image_filename << "\n";
+      return false;
+    }
+
+    size_t image_size = image_header_.GetImageSize();
+    remote_image_.resize(image_size);
+    file_image_.resize(image_size);
+    if (!ReadFully(mem_file.get(), &remote_image_[0], image_size,
+                   reinterpret_cast<uintptr_t>(image_begin_)) ||
+        !ReadFully(image_file.get(), &file_image_[0], image_size, 0)) {
+      os << "Failed to read the image from " << mem_filename << " or " << image_filename << "\n";
+      return false;
+    }
+    std::vector<uint64_t> image_pagemap;
+    if (!ReadPagemap(pagemap_file.get(), image_begin_, image_size, &image_pagemap)) {
+      os << "Failed to read " << pagemap_filename << "\n";
+      return false;
+    }
+
+    DumpImage(os, image_pagemap);
+
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    std::string oat_location = ImageHeader::GetOatLocationFromImageLocation(image_filename);
+    std::string error_msg;
+    const OatFile* oat_file = class_linker->FindOatFileFromOatLocation(oat_location, &error_msg);
+    if (oat_file == nullptr) {
+      os << "Oat file " << oat_location << " not found: " << error_msg << "\n";
+      return false;
+    }
+    const byte* text_begin = AlignDown(image_header_.GetOatDataBegin() +
+                                       oat_file->GetOatHeader().GetExecutableOffset(), kPageSize);
+    const byte* text_end = AlignUp(image_header_.GetOatDataEnd(), kPageSize);
+    if (!IsMapped(maps, text_begin, oat_file->GetLocation())) {
+      os << "Oat file " << oat_file->GetLocation() << " is not mapped at "
+         << reinterpret_cast<const void*>(text_begin) << "\n";
+      return false;
+    }
+    std::vector<uint64_t> text_pagemap;
+    if (!ReadPagemap(pagemap_file.get(), text_begin, text_end - text_begin, &text_pagemap)) {
+      os << "Failed to read " << pagemap_filename << "\n";
+      return false;
+    }
+
+    DumpOatText(os, *oat_file, text_begin, text_pagemap);
+    os << std::flush;
+    return true;
+  }
+
+ private:
+  // Bits of the /proc/<pid>/pagemap entry of a page.
+  static constexpr uint64_t kPagemapPresent = UINT64_C(1) << 63;
+  static constexpr uint64_t kPagemapSwapped = UINT64_C(1) << 62;
+
+  struct DirtyStats {
+    DirtyStats() : objects(0), dirty_objects(0), dirty_bytes(0) {}
+
+    size_t objects;
+    size_t dirty_objects;
+    size_t dirty_bytes;
+    std::set<size_t> dirty_pages;
+  };
+
+  // A method of the oat file and its code.
+  struct MethodRange {
+    MethodRange(const byte* begin, const byte* end, const std::string& name)
+        : begin(begin), end(end), name(name) {}
+
+    bool operator<(const MethodRange& other) const {
+      return begin < other.begin;
+    }
+
+    const byte* begin;
+    const byte* end;
+    std::string name;
+  };
+
+  static bool IsResident(uint64_t pagemap_entry) {
+    return (pagemap_entry & (kPagemapPresent | kPagemapSwapped)) != 0;
+  }
+
+  // Returns whether the line of /proc/<pid>/maps of the mapping at address is of filename.
+  static bool IsMapped(const std::string& maps, const byte* address, const std::string& filename) {
+    std::vector<std::string> lines;
+    Split(maps, '\n', lines);
+    for (const std::string& line : lines) {
+      uintptr_t begin;
+      uintptr_t end;
+      if (sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR, &begin, &end) != 2) {
+        continue;
+      }
+      if (begin <= reinterpret_cast<uintptr_t>(address) &&
+          reinterpret_cast<uintptr_t>(address) < end) {
+        return EndsWith(line, filename.c_str());
+      }
+    }
+    return false;
+  }
+
+  static bool ReadFully(File* file, byte* buffer, size_t byte_count, int64_t offset) {
+    while (byte_count > 0) {
+      int64_t bytes_read = file->Read(reinterpret_cast<char*>(buffer), byte_count, offset);
+      if (bytes_read <= 0) {
+        return false;
+      }
+      buffer += bytes_read;
+      byte_count -= bytes_read;
+      offset += bytes_read;
+    }
+    return true;
+  }
+
+  static bool ReadPagemap(File* pagemap_file, const byte* begin, size_t byte_count,
+                          std::vector<uint64_t>* entries) {
+    size_t pages = RoundUp(byte_count, kPageSize) / kPageSize;
+    entries->resize(pages);
+    int64_t offset = reinterpret_cast<uintptr_t>(begin) / kPageSize * sizeof(uint64_t);
+    return ReadFully(pagemap_file, reinterpret_cast<byte*>(&(*entries)[0]),
+                     pages * sizeof(uint64_t), offset);
+  }
+
+  void DumpImage(std::ostream& os, const std::vector<uint64_t>& pagemap)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    size_t resident_pages = 0;
+    size_t dirty_pages = 0;
+    for (size_t page = 0; page < pagemap.size(); ++page) {
+      if (IsResident(pagemap[page])) {
+        resident_pages++;
+      }
+      size_t begin = page * kPageSize;
+      size_t length = std::min<size_t>(kPageSize, remote_image_.size() - begin);
+      if (memcmp(&remote_image_[begin], &file_image_[begin], length) != 0) {
+        dirty_pages++;
+      }
+    }
+    os << StringPrintf("IMAGE: %zd pages, %zd resident, %zd dirty (%.1f%%)\n\n",
+                       pagemap.size(), resident_pages, dirty_pages,
+                       dirty_pages * 100.0 / pagemap.size());
+
+    image_space_.GetLiveBitmap()->Walk(DirtyPageDumper::Callback, this);
+
+    os << "Dirty objects by class:\n";
+    Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent_os(&indent_filter);
+    for (const auto& class_stats : dirty_stats_) {
+      const DirtyStats& stats = class_stats.second;
+      if (stats.dirty_objects == 0) {
+        continue;
+      }
+      indent_os << StringPrintf("%-40s %6zd of %6zd objects %8zd bytes on %5zd dirty pages\n",
+                                class_stats.first.c_str(), stats.dirty_objects, stats.objects,
+                                stats.dirty_bytes, stats.dirty_pages.size());
+    }
+    os << "\n";
+  }
+
+  static void Callback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    DirtyPageDumper* state = reinterpret_cast<DirtyPageDumper*>(arg);
+    if (!state->image_space_.Contains(obj)) {
+      return;
+    }
+    std::string descriptor(PrettyDescriptor(obj->GetClass()));
+    SafeMap<std::string, DirtyStats>::iterator it = state->dirty_stats_.find(descriptor);
+    if (it == state->dirty_stats_.end()) {
+      state->dirty_stats_.Put(descriptor, DirtyStats());
+      it = state->dirty_stats_.find(descriptor);
+    }
+    DirtyStats& stats = it->second;
+    stats.objects++;
+    size_t begin = reinterpret_cast<byte*>(obj) - state->image_begin_;
+    size_t object_bytes = obj->SizeOf();
+    if (memcmp(&state->remote_image_[begin], &state->file_image_[begin], object_bytes) == 0) {
+      return;
+    }
+    stats.dirty_objects++;
+    stats.dirty_bytes += object_bytes;
+    for (size_t offset = begin; offset < begin + object_bytes; ++offset) {
+      if (state->remote_image_[offset] != state->file_image_[offset]) {
+        stats.dirty_pages.insert(offset / kPageSize);
+      }
+    }
+  }
+
+  void DumpOatText(std::ostream& os, const OatFile& oat_file, const byte* text_begin,
+                   const std::vector<uint64_t>& pagemap) {
+    std::vector<MethodRange> methods;
+    for (const OatFile::OatDexFile* oat_dex_file : oat_file.GetOatDexFiles()) {
+      std::string error_msg;
+      UniquePtr<const DexFile> dex_file(oat_dex_file->OpenDexFile(&error_msg));
+      if (dex_file.get() == nullptr) {
+        LOG(WARNING) << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation()
+            << "': " << error_msg;
+        continue;
+      }
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           class_def_index++) {
+        const byte* class_data = dex_file->GetClassData(dex_file->GetClassDef(class_def_index));
+        if (class_data == nullptr) {
+          continue;
+        }
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+        ClassDataItemIterator it(*dex_file, class_data);
+        while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+          it.Next();
+        }
+        for (uint32_t class_method_index = 0; it.HasNext(); class_method_index++, it.Next()) {
+          const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+          const void* code = oat_method.GetQuickCode();
+          if (code == nullptr) {
+            continue;
+          }
+          // Clear the Thumb bit.
+          const byte* begin = reinterpret_cast<const byte*>(
+              reinterpret_cast<uintptr_t>(code) & ~static_cast<uintptr_t>(1));
+          methods.push_back(MethodRange(begin, begin + oat_method.GetQuickCodeSize(),
+                                        PrettyMethod(it.GetMemberIndex(), *dex_file, true)));
+        }
+      }
+    }
+    std::sort(methods.begin(), methods.end());
+
+    size_t resident_pages = 0;
+    for (uint64_t entry : pagemap) {
+      if (IsResident(entry)) {
+        resident_pages++;
+      }
+    }
+    os << StringPrintf("OAT TEXT: %zd pages, %zd resident (%.1f%%), %zd methods\n\n",
+                       pagemap.size(), resident_pages, resident_pages * 100.0 / pagemap.size(),
+                       methods.size());
+
+    // Methods that share a page with resident code, with the number of their resident pages.
+    // Methods are deduplicated, so several methods may share the same range.
+    os << "Methods on resident pages:\n";
+    Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent_os(&indent_filter);
+    size_t resident_methods = 0;
+    for (const MethodRange& method : methods) {
+      size_t first_page = (method.begin - text_begin) / kPageSize;
+      size_t last_page = (method.end - 1 - text_begin) / kPageSize;
+      size_t method_resident_pages = 0;
+      for (size_t page = first_page; page <= last_page && page < pagemap.size(); ++page) {
+        if (IsResident(pagemap[page])) {
+          method_resident_pages++;
+        }
+      }
+      if (method_resident_pages != 0) {
+        resident_methods++;
+        indent_os << StringPrintf("%p-%p %zd/%zd pages %s\n", method.begin, method.end,
+                                  method_resident_pages, last_page - first_page + 1,
+                                  method.name.c_str());
+      }
+    }
+    os << StringPrintf("%zd of %zd methods on resident pages\n\n", resident_methods,
+                       methods.size());
+  }
+
+  std::ostream* os_;
+  gc::space::ImageSpace& image_space_;
+  const ImageHeader& image_header_;
+  const pid_t pid_;
+  byte* const image_begin_;
+  std::vector<byte> remote_image_;
+  std::vector<byte> file_image_;
+  SafeMap<std::string, DirtyStats> dirty_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirtyPageDumper);
+};
+
 static int oatdump(int argc, char** argv) {
   InitLogging(argv);
 
@@ -1466,6 +2043,8 @@ static int oatdump(int argc, char** argv) {
   UniquePtr<std::ofstream> out;
   bool dump_raw_mapping_table = false;
   bool dump_raw_gc_map = false;
+  bool dump_stats = false;
+  pid_t dirty_pages_pid = 0;
 
   for (int i = 0; i < argc; i++) {
     const StringPiece option(argv[i]);
@@ -1484,6 +2063,16 @@ static int oatdump(int argc, char** argv) {
           fprintf(stderr, "Unknown argument %s\n", option.data());
           usage();
         }
+    } else if (option == "--stats") {
+      dump_stats = true;
+    } else if (option.starts_with("--dirty-pages=")) {
+      const char* pid_str = option.substr(strlen("--dirty-pages=")).data();
+      char* end;
+      dirty_pages_pid = strtol(pid_str, &end, 10);
+      if (end == pid_str || *end != '\0' || dirty_pages_pid <= 0) {
+        fprintf(stderr, "Failed to parse --dirty-pages argument '%s' as a pid\n", pid_str);
+        usage();
+      }
     } else if (option.starts_with("--output=")) {
       const char* filename = option.substr(strlen("--output=")).data();
       out.reset(new std::ofstream(filename));
@@ -1508,6 +2097,11 @@ static int oatdump(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (dirty_pages_pid != 0 && image_filename == NULL) {
+    fprintf(stderr, "--dirty-pages requires --image\n");
+    return EXIT_FAILURE;
+  }
+
   if (oat_filename != NULL) {
     std::string error_msg;
     OatFile* oat_file =
@@ -1516,7 +2110,7 @@ static int oatdump(int argc, char** argv) {
       fprintf(stderr, "Failed to open oat file from '%s': %s\n", oat_filename, error_msg.c_str());
       return EXIT_FAILURE;
     }
-    OatDumper oat_dumper(*oat_file, dump_raw_mapping_table, dump_raw_gc_map);
+    OatDumper oat_dumper(*oat_file, dump_raw_mapping_table, dump_raw_gc_map, dump_stats);
     oat_dumper.Dump(*os);
     return EXIT_SUCCESS;
   }
@@ -1559,8 +2153,12 @@ static int oatdump(int argc, char** argv) {
     fprintf(stderr, "Invalid image header %s\n", image_filename);
     return EXIT_FAILURE;
   }
+  if (dirty_pages_pid != 0) {
+    DirtyPageDumper dirty_page_dumper(os, *image_space, image_header, dirty_pages_pid);
+    return dirty_page_dumper.Dump() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
   ImageDumper image_dumper(os, *image_space, image_header,
-                           dump_raw_mapping_table, dump_raw_gc_map);
+                           dump_raw_mapping_table, dump_raw_gc_map, dump_stats);
   image_dumper.Dump();
   return EXIT_SUCCESS;
 }
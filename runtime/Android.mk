@@ -22,10 +22,12 @@ LIBART_COMMON_SRC_FILES := \
 	atomic.cc.arm \
 	barrier.cc \
 	base/allocator.cc \
+	base/arena_allocator.cc \
 	base/bit_vector.cc \
 	base/hex_dump.cc \
 	base/logging.cc \
 	base/mutex.cc \
+	base/scoped_arena_allocator.cc \
 	base/stringpiece.cc \
 	base/stringprintf.cc \
 	base/timing_logger.cc \
@@ -36,7 +38,10 @@ LIBART_COMMON_SRC_FILES := \
 	base/unix_file/string_file.cc \
 	check_jni.cc \
 	catch_block_stack_visitor.cc \
+	catch_handler_cache.cc \
 	class_linker.cc \
+	class_member_index.cc \
+	class_table.cc \
 	common_throws.cc \
 	debugger.cc \
 	deoptimize_stack_visitor.cc \
@@ -52,6 +57,8 @@ LIBART_COMMON_SRC_FILES := \
 	gc/accounting/mod_union_table.cc \
 	gc/accounting/remembered_set.cc \
 	gc/accounting/space_bitmap.cc \
+	gc/allocation_sampler.cc \
+	gc/allocation_site_table.cc \
 	gc/collector/concurrent_copying.cc \
 	gc/collector/garbage_collector.cc \
 	gc/collector/immune_region.cc \
@@ -68,6 +75,7 @@ LIBART_COMMON_SRC_FILES := \
 	gc/space/image_space.cc \
 	gc/space/large_object_space.cc \
 	gc/space/malloc_space.cc \
+	gc/space/region_space.cc \
 	gc/space/rosalloc_space.cc \
 	gc/space/space.cc \
 	gc/space/zygote_space.cc \
@@ -77,8 +85,10 @@ LIBART_COMMON_SRC_FILES := \
 	instruction_set.cc \
 	instrumentation.cc \
 	intern_table.cc \
+	interpreter/inline_cache.cc \
 	interpreter/interpreter.cc \
 	interpreter/interpreter_common.cc \
+	interpreter/interpreter_mterp_impl.cc \
 	interpreter/interpreter_switch_impl.cc \
 	jdwp/jdwp_event.cc \
 	jdwp/jdwp_expand_buf.cc \
@@ -87,10 +97,14 @@ LIBART_COMMON_SRC_FILES := \
 	jdwp/jdwp_request.cc \
 	jdwp/jdwp_socket.cc \
 	jdwp/object_registry.cc \
+	jit/jit.cc \
+	jit/jit_code_cache.cc \
 	jni_internal.cc \
 	jobject_comparator.cc \
+	lock_profiler.cc \
 	mem_map.cc \
 	memory_region.cc \
+	metrics_page.cc \
 	mirror/art_field.cc \
 	mirror/art_method.cc \
 	mirror/array.cc \
@@ -133,10 +147,14 @@ LIBART_COMMON_SRC_FILES := \
 	primitive.cc \
 	quick_exception_handler.cc \
 	quick/inline_method_analyser.cc \
+	read_barrier.cc \
 	reference_table.cc \
 	reflection.cc \
 	runtime.cc \
+	safepoint_stats.cc \
 	signal_catcher.cc \
+	signal_sampler.cc \
+	startup_class_verifier.cc \
 	stack.cc \
 	thread.cc \
 	thread_list.cc \
@@ -154,6 +172,7 @@ LIBART_COMMON_SRC_FILES := \
 	verifier/reg_type.cc \
 	verifier/reg_type_cache.cc \
 	verifier/register_line.cc \
+	verifier/verifier_deps.cc \
 	well_known_classes.cc \
 	zip_archive.cc
 
@@ -188,6 +207,7 @@ LIBART_COMMON_SRC_FILES += \
 	entrypoints/quick/quick_jni_entrypoints.cc \
 	entrypoints/quick/quick_lock_entrypoints.cc \
 	entrypoints/quick/quick_math_entrypoints.cc \
+	entrypoints/quick/quick_read_barrier_entrypoints.cc \
 	entrypoints/quick/quick_thread_entrypoints.cc \
 	entrypoints/quick/quick_throw_entrypoints.cc \
 	entrypoints/quick/quick_trampoline_entrypoints.cc
@@ -209,6 +229,7 @@ LIBART_TARGET_SRC_FILES := \
 LIBART_TARGET_SRC_FILES_arm := \
 	arch/arm/context_arm.cc.arm \
 	arch/arm/entrypoints_init_arm.cc \
+	arch/arm/interpreter_arm.S \
 	arch/arm/jni_entrypoints_arm.S \
 	arch/arm/portable_entrypoints_arm.S \
 	arch/arm/quick_entrypoints_arm.S \
@@ -219,6 +240,7 @@ LIBART_TARGET_SRC_FILES_arm := \
 LIBART_TARGET_SRC_FILES_arm64 := \
 	arch/arm64/context_arm64.cc \
 	arch/arm64/entrypoints_init_arm64.cc \
+	arch/arm64/interpreter_arm64.S \
 	arch/arm64/jni_entrypoints_arm64.S \
 	arch/arm64/portable_entrypoints_arm64.S \
 	arch/arm64/quick_entrypoints_arm64.S \
@@ -238,6 +260,7 @@ LIBART_TARGET_SRC_FILES_x86 := \
 LIBART_TARGET_SRC_FILES_x86_64 := \
 	arch/x86_64/context_x86_64.cc \
 	arch/x86_64/entrypoints_init_x86_64.cc \
+	arch/x86_64/interpreter_x86_64.S \
 	arch/x86_64/jni_entrypoints_x86_64.S \
 	arch/x86_64/portable_entrypoints_x86_64.S \
 	arch/x86_64/quick_entrypoints_x86_64.S \
@@ -275,6 +298,7 @@ ifneq ($(BUILD_HOST_64bit),)
 LIBART_HOST_SRC_FILES += \
 	arch/x86_64/context_x86_64.cc \
 	arch/x86_64/entrypoints_init_x86_64.cc \
+	arch/x86_64/interpreter_x86_64.S \
 	arch/x86_64/jni_entrypoints_x86_64.S \
 	arch/x86_64/portable_entrypoints_x86_64.S \
 	arch/x86_64/quick_entrypoints_x86_64.S \
@@ -83,6 +83,24 @@ TEST_F(ArchTest, ARM) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
+#ifdef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#undef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#endif
+#ifdef SHADOWFRAME_DEX_PC_OFFSET
+#undef SHADOWFRAME_DEX_PC_OFFSET
+#endif
+#ifdef SHADOWFRAME_VREGS_OFFSET
+#undef SHADOWFRAME_VREGS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
@@ -141,6 +159,24 @@ TEST_F(ArchTest, ARM64) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
+#ifdef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#undef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#endif
+#ifdef SHADOWFRAME_DEX_PC_OFFSET
+#undef SHADOWFRAME_DEX_PC_OFFSET
+#endif
+#ifdef SHADOWFRAME_VREGS_OFFSET
+#undef SHADOWFRAME_VREGS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
@@ -199,6 +235,24 @@ TEST_F(ArchTest, MIPS) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
+#ifdef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#undef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#endif
+#ifdef SHADOWFRAME_DEX_PC_OFFSET
+#undef SHADOWFRAME_DEX_PC_OFFSET
+#endif
+#ifdef SHADOWFRAME_VREGS_OFFSET
+#undef SHADOWFRAME_VREGS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
@@ -257,6 +311,24 @@ TEST_F(ArchTest, X86) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
+#ifdef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#undef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#endif
+#ifdef SHADOWFRAME_DEX_PC_OFFSET
+#undef SHADOWFRAME_DEX_PC_OFFSET
+#endif
+#ifdef SHADOWFRAME_VREGS_OFFSET
+#undef SHADOWFRAME_VREGS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
@@ -315,6 +387,24 @@ TEST_F(ArchTest, X86_64) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
+#ifdef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#undef SHADOWFRAME_NUMBER_OF_VREGS_OFFSET
+#endif
+#ifdef SHADOWFRAME_DEX_PC_OFFSET
+#undef SHADOWFRAME_DEX_PC_OFFSET
+#endif
+#ifdef SHADOWFRAME_VREGS_OFFSET
+#undef SHADOWFRAME_VREGS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
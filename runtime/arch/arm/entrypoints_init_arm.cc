@@ -20,6 +20,7 @@
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "entrypoints/math_entrypoints.h"
+#include "instruction_set.h"
 
 namespace art {
 
@@ -93,6 +94,7 @@ extern "C" double fmod(double a, double b);         // REM_DOUBLE[_2ADDR]
 
 // Integer arithmetics.
 extern "C" int __aeabi_idivmod(int32_t, int32_t);  // [DIV|REM]_INT[_2ADDR|_LIT8|_LIT16]
+extern "C" int art_quick_idivmod_sdiv(int32_t, int32_t);  // Same, with the sdiv instruction.
 
 // Long long arithmetics - REM_LONG[_2ADDR] and DIV_LONG[_2ADDR]
 extern "C" int64_t __aeabi_ldivmod(int64_t, int64_t);
@@ -105,6 +107,7 @@ extern "C" uint64_t art_quick_ushr_long(uint64_t, uint32_t);
 extern "C" int32_t __memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" uint32_t art_quick_string_equals(void*, void*);
 
 // Invoke entrypoints.
 extern "C" void art_quick_imt_conflict_trampoline(mirror::ArtMethod*);
@@ -128,9 +131,14 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Read barrier entrypoints.
+extern "C" mirror::Object* artReadBarrierMark(mirror::Object*);
+
 // Generic JNI downcall
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking);
+
 void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
                      PortableEntryPoints* ppoints, QuickEntryPoints* qpoints) {
   // Interpreter
@@ -202,7 +210,13 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pL2f = __aeabi_l2f;
   qpoints->pD2iz = __aeabi_d2iz;
   qpoints->pF2iz = __aeabi_f2iz;
-  qpoints->pIdivmod = __aeabi_idivmod;
+  // The code compiled for CPUs without a divide instruction calls this, it can still use the
+  // instruction when the CPU running it has one.
+  if (InstructionSetFeatures::GuessInstructionSetFeatures().HasDivideInstruction()) {
+    qpoints->pIdivmod = art_quick_idivmod_sdiv;
+  } else {
+    qpoints->pIdivmod = __aeabi_idivmod;
+  }
   qpoints->pD2l = art_d2l;
   qpoints->pF2l = art_f2l;
   qpoints->pLdiv = __aeabi_ldivmod;
@@ -216,6 +230,7 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pIndexOf = art_quick_indexof;
   qpoints->pMemcmp16 = __memcmp16;
   qpoints->pStringCompareTo = art_quick_string_compareto;
+  qpoints->pStringEquals = art_quick_string_equals;
   qpoints->pMemcpy = memcpy;
 
   // Invocation
@@ -239,6 +254,13 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Read barrier
+  UpdateReadBarrierEntrypoints(qpoints, false);
 };
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking) {
+  qpoints->pReadBarrierMark = is_marking ? artReadBarrierMark : nullptr;
+}
+
 }  // namespace art
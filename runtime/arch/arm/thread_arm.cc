@@ -26,6 +26,10 @@ void Thread::InitCpu() {
   CHECK_EQ(THREAD_CARD_TABLE_OFFSET, CardTableOffset<4>().Int32Value());
   CHECK_EQ(THREAD_EXCEPTION_OFFSET, ExceptionOffset<4>().Int32Value());
   CHECK_EQ(THREAD_ID_OFFSET, ThinLockIdOffset<4>().Int32Value());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_NUMBER_OF_VREGS_OFFSET),
+           ShadowFrame::NumberOfVRegsOffset());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_DEX_PC_OFFSET), ShadowFrame::DexPCOffset());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_VREGS_OFFSET), ShadowFrame::VRegsOffset());
 }
 
 void Thread::CleanupCpu() {
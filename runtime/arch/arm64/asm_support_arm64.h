@@ -31,11 +31,21 @@
 // Offset of field Thread::suspend_count_ verified in InitCpu
 #define THREAD_FLAGS_OFFSET 0
 // Offset of field Thread::card_table_ verified in InitCpu
-#define THREAD_CARD_TABLE_OFFSET 112
+#define THREAD_CARD_TABLE_OFFSET 120
 // Offset of field Thread::exception_ verified in InitCpu
-#define THREAD_EXCEPTION_OFFSET 120
+#define THREAD_EXCEPTION_OFFSET 128
 // Offset of field Thread::thin_lock_thread_id_ verified in InitCpu
 #define THREAD_ID_OFFSET 12
+// Offsets of fields Thread::tlsPtr_.thread_local_pos, thread_local_end and thread_local_objects
+// verified in InitCpu
+#define THREAD_LOCAL_POS_OFFSET 1440
+#define THREAD_LOCAL_END_OFFSET 1448
+#define THREAD_LOCAL_OBJECTS_OFFSET 1456
+
+// Offsets of the ShadowFrame fields used by the assembly interpreter verified in InitCpu
+#define SHADOWFRAME_NUMBER_OF_VREGS_OFFSET 0
+#define SHADOWFRAME_DEX_PC_OFFSET 24
+#define SHADOWFRAME_VREGS_OFFSET 28
 
 #define FRAME_SIZE_SAVE_ALL_CALLEE_SAVE 368
 #define FRAME_SIZE_REFS_ONLY_CALLEE_SAVE 176
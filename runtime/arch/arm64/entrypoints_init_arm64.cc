@@ -94,6 +94,7 @@ extern "C" uint64_t art_quick_ushr_long(uint64_t, uint32_t);
 extern "C" int32_t __memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" uint32_t art_quick_string_equals(void*, void*);
 
 // Invoke entrypoints.
 extern "C" void art_quick_imt_conflict_trampoline(mirror::ArtMethod*);
@@ -117,11 +118,16 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Read barrier entrypoints.
+extern "C" mirror::Object* artReadBarrierMark(mirror::Object*);
+
 extern void ResetQuickAllocEntryPoints(QuickEntryPoints* qpoints);
 
 // Generic JNI downcall
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking);
+
 void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
                      PortableEntryPoints* ppoints, QuickEntryPoints* qpoints) {
   // Interpreter
@@ -208,6 +214,7 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pIndexOf = art_quick_indexof;
   qpoints->pMemcmp16 = __memcmp16;
   qpoints->pStringCompareTo = art_quick_string_compareto;
+  qpoints->pStringEquals = art_quick_string_equals;
   qpoints->pMemcpy = memcpy;
 
   // Invocation
@@ -231,6 +238,13 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Read barrier
+  UpdateReadBarrierEntrypoints(qpoints, false);
 };
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking) {
+  qpoints->pReadBarrierMark = is_marking ? artReadBarrierMark : nullptr;
+}
+
 }  // namespace art
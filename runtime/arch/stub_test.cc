@@ -352,6 +352,32 @@ TEST_F(StubTest, Memcpy) {
 #endif
 }
 
+#if defined(__arm__)
+extern "C" void art_quick_idivmod_sdiv(void);
+#endif
+
+TEST_F(StubTest, IdivmodSdiv) {
+#if defined(__arm__)
+  if (!InstructionSetFeatures::GuessInstructionSetFeatures().HasDivideInstruction()) {
+    LOG(INFO) << "Skipping idivmod_sdiv as the CPU has no divide instruction";
+    return;
+  }
+  Thread* self = Thread::Current();
+  uintptr_t code = reinterpret_cast<uintptr_t>(&art_quick_idivmod_sdiv);
+  EXPECT_EQ(3U, static_cast<uint32_t>(Invoke3(7U, 2U, 0U, code, self)));
+  EXPECT_EQ(static_cast<uint32_t>(-3),
+            static_cast<uint32_t>(Invoke3(static_cast<size_t>(-7), 2U, 0U, code, self)));
+  // Overflows like the Java division.
+  EXPECT_EQ(0x80000000U,
+            static_cast<uint32_t>(Invoke3(0x80000000U, static_cast<uint32_t>(-1), 0U, code,
+                                          self)));
+#else
+  LOG(INFO) << "Skipping idivmod_sdiv as it only exists on arm";
+  // Force-print to std::cout so it's also outside the logcat.
+  std::cout << "Skipping idivmod_sdiv as it only exists on arm" << std::endl;
+#endif
+}
+
 #if defined(__i386__) || defined(__arm__) || defined(__x86_64__)
 extern "C" void art_quick_lock_object(void);
 #endif
@@ -972,8 +998,10 @@ TEST_F(StubTest, StringCompareTo) {
   // Use array so we can index into it and use a matrix for expected results
   // Setup: The first half is standard. The second half uses a non-zero offset.
   // TODO: Shared backing arrays.
-  constexpr size_t base_string_count = 7;
-  const char* c[base_string_count] = { "", "", "a", "aa", "ab", "aac", "aac" , };
+  constexpr size_t base_string_count = 10;
+  const char* c[base_string_count] = { "", "", "a", "aa", "ab", "aac", "aac",
+                                       "aacaacaacaacaacaacaac", "aacaacaacaacaacaacaad",
+                                       "aacaacaacaacabcaacaac" };
 
   constexpr size_t string_count = 2 * base_string_count;
 
@@ -1052,6 +1080,62 @@ TEST_F(StubTest, StringCompareTo) {
 }
 
 
+#if defined(__i386__) || defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)
+extern "C" void art_quick_string_equals(void);
+#endif
+
+TEST_F(StubTest, StringEquals) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+
+#if defined(__i386__) || defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+
+  // Lengths on both sides of the sixteen bytes compared at a time.
+  constexpr size_t string_count = 8;
+  const char* c[string_count] = { "", "a", "ab", "abcdefgh", "abcdefgi", "abcdefghijklmnopq",
+                                  "abcdefghijklmnopr", "abcdefghijklmnopq" };
+
+  SirtRef<mirror::String>* s[string_count];
+  for (size_t i = 0; i < string_count; ++i) {
+    s[i] = new SirtRef<mirror::String>(soa.Self(), mirror::String::AllocFromModifiedUtf8(soa.Self(),
+                                                                                         c[i]));
+  }
+
+  for (size_t x = 0; x < string_count; ++x) {
+    for (size_t y = 0; y < string_count; ++y) {
+      size_t result = Invoke3(reinterpret_cast<size_t>(s[x]->get()),
+                              reinterpret_cast<size_t>(s[y]->get()), 0U,
+                              reinterpret_cast<uintptr_t>(&art_quick_string_equals), self);
+      EXPECT_FALSE(self->IsExceptionPending());
+      EXPECT_EQ(s[x]->get()->Equals(s[y]->get()) ? 1U : 0U, result & 0xFF)
+          << "x=" << c[x] << " y=" << c[y];
+    }
+  }
+
+  // Null and objects other than strings aren't equal to a string.
+  size_t result = Invoke3(reinterpret_cast<size_t>(s[0]->get()), 0U, 0U,
+                          reinterpret_cast<uintptr_t>(&art_quick_string_equals), self);
+  EXPECT_EQ(0U, result & 0xFF);
+  {
+    SirtRef<mirror::CharArray> array(soa.Self(), mirror::CharArray::Alloc(soa.Self(), 0));
+    result = Invoke3(reinterpret_cast<size_t>(s[0]->get()), reinterpret_cast<size_t>(array.get()),
+                     0U, reinterpret_cast<uintptr_t>(&art_quick_string_equals), self);
+    EXPECT_EQ(0U, result & 0xFF);
+  }
+
+  for (size_t i = string_count; i > 0; --i) {
+    delete s[i - 1];
+  }
+#else
+  LOG(INFO) << "Skipping string_equals as I don't know how to do that on " << kRuntimeISA;
+  // Force-print to std::cout so it's also outside the logcat.
+  std::cout << "Skipping string_equals as I don't know how to do that on " << kRuntimeISA <<
+      std::endl;
+#endif
+}
+
+
 #if defined(__i386__) || defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)
 extern "C" void art_quick_set32_static(void);
 extern "C" void art_quick_get32_static(void);
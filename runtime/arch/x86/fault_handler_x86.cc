@@ -16,12 +16,16 @@
 
 
 #include "fault_handler.h"
+#include <string.h>
 #include <sys/ucontext.h>
 #include "base/macros.h"
 #include "globals.h"
 #include "base/logging.h"
 #include "base/hex_dump.h"
-
+#include "mirror/art_method.h"
+#include "mirror/art_method-inl.h"
+#include "thread.h"
+#include "thread-inl.h"
 
 //
 // X86 specific fault handler functions.
@@ -29,19 +33,139 @@
 
 namespace art {
 
+extern "C" void art_quick_throw_stack_overflow_from_signal();
+extern "C" void art_quick_implicit_suspend();
+
+// The implicit suspend check is the following instruction sequence:
+// 64 8b 05 xx xx xx xx   mov eax, fs:[xxxxxxxx]  ; suspend_trigger_
+// .. some intervening instructions
+// 8b 00                  mov eax, [eax]
+static constexpr uint8_t kSuspendCheckLoad[] = { 0x8b, 0x00 };
+static constexpr size_t kSuspendCheckTriggerLoadSize = 7;
+
+// The implicit stack overflow check is:
+// 85 84 24 xx xx xx xx   test eax, [esp - kStackOverflowReservedBytes]
+static constexpr size_t kStackOverflowCheckSize = 7;
+
 void FaultManager::GetMethodAndReturnPCAndSP(void* context, mirror::ArtMethod** out_method,
                                              uintptr_t* out_return_pc, uintptr_t* out_sp) {
+  struct ucontext *uc = reinterpret_cast<struct ucontext*>(context);
+  *out_sp = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_ESP]);
+  VLOG(signals) << "sp: " << std::hex << *out_sp;
+  if (*out_sp == 0) {
+    return;
+  }
+
+  // In the case of a stack overflow, the frame is not built yet and we can't
+  // get the method from the top of the stack.  However it's in eax.
+  uintptr_t fault_addr = static_cast<uintptr_t>(uc->uc_mcontext.cr2);
+  uintptr_t overflow_addr = *out_sp - Thread::kStackOverflowReservedBytes;
+  uint8_t* pc = reinterpret_cast<uint8_t*>(uc->uc_mcontext.gregs[REG_EIP]);
+  VLOG(signals) << "pc: " << std::hex << static_cast<void*>(pc);
+  if (overflow_addr == fault_addr) {
+    *out_method = reinterpret_cast<mirror::ArtMethod*>(uc->uc_mcontext.gregs[REG_EAX]);
+    *out_return_pc = reinterpret_cast<uintptr_t>(pc) + kStackOverflowCheckSize;
+  } else {
+    // The method is at the top of the stack.
+    *out_method = reinterpret_cast<mirror::ArtMethod*>(reinterpret_cast<uintptr_t*>(*out_sp)[0]);
+    // Only the suspend check load is decoded, the return PC of other faults does not map to a
+    // safepoint and is only used to tell that the PC is in generated code.
+    *out_return_pc = reinterpret_cast<uintptr_t>(pc) + sizeof(kSuspendCheckLoad);
+  }
 }
 
 bool NullPointerHandler::Action(int sig, siginfo_t* info, void* context) {
+  // Implicit null checks are not supported on x86, see Runtime::Init.
   return false;
 }
 
+// To check for a suspend check, we examine the instruction that caused the fault and look
+// for the load of the suspend trigger a little before it.
 bool SuspensionHandler::Action(int sig, siginfo_t* info, void* context) {
-  return false;
+  uint8_t checkinst1[kSuspendCheckTriggerLoadSize] = { 0x64, 0x8b, 0x05 };
+  const uint32_t trigger_offset = Thread::ThreadSuspendTriggerOffset<4>().Uint32Value();
+  memcpy(&checkinst1[3], &trigger_offset, sizeof(trigger_offset));
+
+  struct ucontext *uc = reinterpret_cast<struct ucontext*>(context);
+  uint8_t* ptr2 = reinterpret_cast<uint8_t*>(uc->uc_mcontext.gregs[REG_EIP]);
+  VLOG(signals) << "checking suspend";
+
+  if (memcmp(ptr2, kSuspendCheckLoad, sizeof(kSuspendCheckLoad)) != 0) {
+    // Second instruction is not good, not ours.
+    return false;
+  }
+
+  // The first instruction can be a little bit up the stream due to load hoisting
+  // in the compiler.
+  uint8_t* ptr1 = ptr2 - kSuspendCheckTriggerLoadSize;
+  uint8_t* limit = ptr1 - 40;
+  bool found = false;
+  while (ptr1 > limit) {
+    if (memcmp(ptr1, checkinst1, sizeof(checkinst1)) == 0) {
+      found = true;
+      break;
+    }
+    --ptr1;
+  }
+  if (!found) {
+    return false;
+  }
+
+  VLOG(signals) << "suspend check match";
+  // This is a suspend check.  Arrange for the signal handler to return to
+  // art_quick_implicit_suspend as if it had been called by the faulting load, so
+  // that it returns to the instruction after it (eax is dead, the trigger is null).
+  // The signal is handled on the alternate signal stack, pushing is safe.
+  uintptr_t* sp = reinterpret_cast<uintptr_t*>(uc->uc_mcontext.gregs[REG_ESP]) - 1;
+  *sp = reinterpret_cast<uintptr_t>(ptr2) + sizeof(kSuspendCheckLoad);
+  uc->uc_mcontext.gregs[REG_ESP] = reinterpret_cast<uintptr_t>(sp);
+  uc->uc_mcontext.gregs[REG_EIP] = reinterpret_cast<uintptr_t>(art_quick_implicit_suspend);
+
+  // Now remove the suspend trigger that caused this fault.
+  Thread::Current()->RemoveSuspendTrigger();
+  VLOG(signals) << "removed suspend trigger invoking test suspend";
+  return true;
 }
 
+// Stack overflow fault handler.
+//
+// This checks that the fault address is equal to the current stack pointer
+// minus the overflow region size (16K typically).  The check is the first
+// instruction of the method, the return address is still at the top of the
+// stack and the method in eax:
+//
+// test eax, [esp - 16384]
+//
+// If we determine this is a stack overflow we need to move the stack pointer
+// to the overflow region below the protected region.
 bool StackOverflowHandler::Action(int sig, siginfo_t* info, void* context) {
-  return false;
+  struct ucontext *uc = reinterpret_cast<struct ucontext*>(context);
+  uintptr_t sp = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_ESP]);
+  uintptr_t fault_addr = static_cast<uintptr_t>(uc->uc_mcontext.cr2);
+  VLOG(signals) << "checking for stack overflow, sp: " << std::hex << sp <<
+    ", fault_addr: " << fault_addr;
+
+  uintptr_t overflow_addr = sp - Thread::kStackOverflowReservedBytes;
+
+  // Check that the fault address is the value expected for a stack overflow.
+  if (fault_addr != overflow_addr) {
+    VLOG(signals) << "Not a stack overflow";
+    return false;
+  }
+
+  // We know this is a stack overflow.  Pass the next available address below
+  // the protected region to art_quick_throw_stack_overflow_from_signal in eax,
+  // which it moves the stack pointer to.  esp is left on the return address into
+  // the caller so that the throw looks like it was called from there.
+  Thread* self = Thread::Current();
+  uintptr_t pregion = reinterpret_cast<uintptr_t>(self->GetStackEnd()) -
+      Thread::kStackOverflowProtectedSize;
+  VLOG(signals) << "setting sp to overflow region at " << std::hex << pregion;
+  uc->uc_mcontext.gregs[REG_EAX] = pregion;
+  uc->uc_mcontext.gregs[REG_EIP] =
+      reinterpret_cast<uintptr_t>(art_quick_throw_stack_overflow_from_signal);
+
+  // The kernel will now return to art_quick_throw_stack_overflow_from_signal.
+  return true;
 }
 }       // namespace art
@@ -87,6 +87,7 @@ extern "C" uint64_t art_quick_lushr(uint64_t, uint32_t);
 extern "C" int32_t art_quick_memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" uint32_t art_quick_string_equals(void*, void*);
 extern "C" void* art_quick_memcpy(void*, const void*, size_t);
 
 // Invoke entrypoints.
@@ -111,11 +112,16 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Read barrier entrypoints.
+extern "C" mirror::Object* art_quick_read_barrier_mark(mirror::Object*);
+
 // Generic JNI entrypoint
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
 extern void ResetQuickAllocEntryPoints(QuickEntryPoints* qpoints);
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking);
+
 void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
                      PortableEntryPoints* ppoints, QuickEntryPoints* qpoints) {
   // Interpreter
@@ -201,6 +207,7 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pIndexOf = art_quick_indexof;
   qpoints->pMemcmp16 = art_quick_memcmp16;
   qpoints->pStringCompareTo = art_quick_string_compareto;
+  qpoints->pStringEquals = art_quick_string_equals;
   qpoints->pMemcpy = art_quick_memcpy;
 
   // Invocation
@@ -224,6 +231,13 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Read barrier
+  UpdateReadBarrierEntrypoints(qpoints, false);
 };
 
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking) {
+  qpoints->pReadBarrierMark = is_marking ? art_quick_read_barrier_mark : nullptr;
+}
+
 }  // namespace art
@@ -31,6 +31,9 @@
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 12
+#define CLASS_OBJECT_SIZE_OFFSET 88
+#define CLASS_STATUS_OFFSET 104
+#define CLASS_SECONDARY_SUPER_CACHE_OFFSET 108
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 8
@@ -51,6 +54,9 @@
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 20
+#define CLASS_OBJECT_SIZE_OFFSET 96
+#define CLASS_STATUS_OFFSET 112
+#define CLASS_SECONDARY_SUPER_CACHE_OFFSET 116
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 16
@@ -69,4 +75,18 @@
 
 #endif
 
+// Value of java.lang.Class.status for an initialized class.
+#define CLASS_STATUS_INITIALIZED 9
+
+// Alignment of the objects of the bump pointer space, minus one.
+#define OBJECT_ALIGNMENT_MASK 7
+#define OBJECT_ALIGNMENT_MASK_TOGGLED 0xFFFFFFF8
+
+// The arm64 and x86-64 quick entrypoints allocate objects of resolved classes from the
+// thread-local allocation buffer without calling into the runtime. The objects need no read
+// barrier pointer then.
+#if (defined(__aarch64__) || defined(__x86_64__)) && !defined(USE_BAKER_OR_BROOKS_READ_BARRIER)
+#define QUICK_TLAB_ALLOC_FAST_PATH
+#endif
+
 #endif  // ART_RUNTIME_ASM_SUPPORT_H_
@@ -31,8 +31,7 @@ static constexpr bool kUseMemSet = true && kUseMemMap;
 static constexpr size_t kValgrindRedZoneBytes = 8;
 constexpr size_t Arena::kDefaultSize;
 
-template <bool kCount>
-const char* ArenaAllocatorStatsImpl<kCount>::kAllocNames[kNumArenaAllocKinds] = {
+const char* ArenaAllocatorStats::kAllocNames[kNumArenaAllocKinds] = {
   "Misc       ",
   "BasicBlock ",
   "LIR        ",
@@ -47,40 +46,35 @@ const char* ArenaAllocatorStatsImpl<kCount>::kAllocNames[kNumArenaAllocKinds] =
   "Data       ",
   "Preds      ",
   "STL        ",
+  "Verifier   ",
 };
 
-template <bool kCount>
-ArenaAllocatorStatsImpl<kCount>::ArenaAllocatorStatsImpl()
+ArenaAllocatorStats::ArenaAllocatorStats()
     : num_allocations_(0u) {
   std::fill_n(alloc_stats_, arraysize(alloc_stats_), 0u);
 }
 
-template <bool kCount>
-void ArenaAllocatorStatsImpl<kCount>::Copy(const ArenaAllocatorStatsImpl& other) {
+void ArenaAllocatorStats::Copy(const ArenaAllocatorStats& other) {
   num_allocations_ = other.num_allocations_;
   std::copy(other.alloc_stats_, other.alloc_stats_ + arraysize(alloc_stats_), alloc_stats_);
 }
 
-template <bool kCount>
-void ArenaAllocatorStatsImpl<kCount>::RecordAlloc(size_t bytes, ArenaAllocKind kind) {
+void ArenaAllocatorStats::RecordAlloc(size_t bytes, ArenaAllocKind kind) {
   alloc_stats_[kind] += bytes;
   ++num_allocations_;
 }
 
-template <bool kCount>
-size_t ArenaAllocatorStatsImpl<kCount>::NumAllocations() const {
+size_t ArenaAllocatorStats::NumAllocations() const {
   return num_allocations_;
 }
 
-template <bool kCount>
-size_t ArenaAllocatorStatsImpl<kCount>::BytesAllocated() const {
+size_t ArenaAllocatorStats::BytesAllocated() const {
   const size_t init = 0u;  // Initial value of the correct type.
   return std::accumulate(alloc_stats_, alloc_stats_ + arraysize(alloc_stats_), init);
 }
 
-template <bool kCount>
-void ArenaAllocatorStatsImpl<kCount>::Dump(std::ostream& os, const Arena* first,
-                                           ssize_t lost_bytes_adjustment) const {
+void ArenaAllocatorStats::Dump(std::ostream& os, const Arena* first,
+                               ssize_t lost_bytes_adjustment) const {
   size_t malloc_bytes = 0u;
   size_t lost_bytes = 0u;
   size_t num_arenas = 0u;
@@ -106,9 +100,6 @@ void ArenaAllocatorStatsImpl<kCount>::Dump(std::ostream& os, const Arena* first,
   }
 }
 
-// Explicitly instantiate the used implementation.
-template class ArenaAllocatorStatsImpl<kArenaAllocatorCountAllocations>;
-
 Arena::Arena(size_t size)
     : bytes_allocated_(0),
       map_(nullptr),
@@ -145,9 +136,24 @@ void Arena::Reset() {
   }
 }
 
-ArenaPool::ArenaPool()
-    : lock_("Arena pool lock"),
-      free_arenas_(nullptr) {
+ArenaPool::ArenaPool(bool count_allocations, size_t max_free_bytes)
+    : count_allocations_(count_allocations),
+      max_free_bytes_(max_free_bytes),
+      lock_("Arena pool lock"),
+      free_arenas_(nullptr),
+      free_bytes_(0u),
+      bytes_in_use_(0u),
+      peak_bytes_in_use_(0u) {
+}
+
+void ArenaPool::AddBytesInUse(size_t bytes) {
+  bytes_in_use_ += bytes;
+  peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+}
+
+size_t ArenaPool::GetPeakBytesInUse() const {
+  MutexLock lock(Thread::Current(), lock_);
+  return peak_bytes_in_use_;
 }
 
 ArenaPool::~ArenaPool() {
@@ -166,10 +172,14 @@ Arena* ArenaPool::AllocArena(size_t size) {
     if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
       ret = free_arenas_;
       free_arenas_ = free_arenas_->next_;
+      free_bytes_ -= ret->Size();
+      AddBytesInUse(ret->Size());
     }
   }
   if (ret == nullptr) {
     ret = new Arena(size);
+    MutexLock lock(self, lock_);
+    AddBytesInUse(ret->Size());
   }
   ret->Reset();
   return ret;
@@ -181,15 +191,29 @@ void ArenaPool::FreeArenaChain(Arena* first) {
       VALGRIND_MAKE_MEM_UNDEFINED(arena->memory_, arena->bytes_allocated_);
     }
   }
-  if (first != nullptr) {
-    Arena* last = first;
-    while (last->next_ != nullptr) {
-      last = last->next_;
-    }
+  Arena* released = nullptr;
+  {
     Thread* self = Thread::Current();
     MutexLock lock(self, lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+    Arena* next = nullptr;
+    for (Arena* arena = first; arena != nullptr; arena = next) {
+      next = arena->next_;
+      bytes_in_use_ -= arena->Size();
+      if (arena->Size() > Arena::kDefaultSize || free_bytes_ + arena->Size() > max_free_bytes_) {
+        arena->next_ = released;
+        released = arena;
+      } else {
+        arena->next_ = free_arenas_;
+        free_arenas_ = arena;
+        free_bytes_ += arena->Size();
+      }
+    }
+  }
+  // Give the memory back to the system outside of the lock.
+  while (released != nullptr) {
+    Arena* arena = released;
+    released = released->next_;
+    delete arena;
   }
 }
 
@@ -197,13 +221,26 @@ size_t ArenaAllocator::BytesAllocated() const {
   return ArenaAllocatorStats::BytesAllocated();
 }
 
+size_t ArenaAllocator::BytesUsed() const {
+  if (arena_head_ == nullptr) {
+    return 0u;
+  }
+  // The head arena has not been updated with the latest allocations yet.
+  size_t total = ptr_ - begin_;
+  for (const Arena* arena = arena_head_->next_; arena != nullptr; arena = arena->next_) {
+    total += arena->bytes_allocated_;
+  }
+  return total;
+}
+
 ArenaAllocator::ArenaAllocator(ArenaPool* pool)
   : pool_(pool),
     begin_(nullptr),
     end_(nullptr),
     ptr_(nullptr),
     arena_head_(nullptr),
-    running_on_valgrind_(RUNNING_ON_VALGRIND > 0) {
+    running_on_valgrind_(RUNNING_ON_VALGRIND > 0),
+    use_slow_path_(running_on_valgrind_ || pool->CountsAllocations()) {
 }
 
 void ArenaAllocator::UpdateBytesAllocated() {
@@ -214,6 +251,24 @@ void ArenaAllocator::UpdateBytesAllocated() {
   }
 }
 
+void* ArenaAllocator::AllocSlowPath(size_t bytes, ArenaAllocKind kind) {
+  if (running_on_valgrind_) {
+    return AllocValgrind(bytes, kind);
+  }
+  bytes = RoundUp(bytes, 4);
+  if (UNLIKELY(ptr_ + bytes > end_)) {
+    // Obtain a new block.
+    ObtainNewArenaForAllocation(bytes);
+    if (UNLIKELY(ptr_ == nullptr)) {
+      return nullptr;
+    }
+  }
+  ArenaAllocatorStats::RecordAlloc(bytes, kind);
+  uint8_t* ret = ptr_;
+  ptr_ += bytes;
+  return ret;
+}
+
 void* ArenaAllocator::AllocValgrind(size_t bytes, ArenaAllocKind kind) {
   size_t rounded_bytes = (bytes + 3 + kValgrindRedZoneBytes) & ~3;
   if (UNLIKELY(ptr_ + rounded_bytes > end_)) {
@@ -14,8 +14,8 @@
  * limitations under the License.
  */
 
-#ifndef ART_COMPILER_UTILS_ARENA_ALLOCATOR_H_
-#define ART_COMPILER_UTILS_ARENA_ALLOCATOR_H_
+#ifndef ART_RUNTIME_BASE_ARENA_ALLOCATOR_H_
+#define ART_RUNTIME_BASE_ARENA_ALLOCATOR_H_
 
 #include <stdint.h>
 #include <stddef.h>
@@ -34,6 +34,7 @@ class ArenaStack;
 class ScopedArenaAllocator;
 class MemStats;
 
+// Whether the arena pools count the allocations by kind when not told otherwise.
 static constexpr bool kArenaAllocatorCountAllocations = false;
 
 // Type of allocation for memory tuning.
@@ -52,36 +53,19 @@ enum ArenaAllocKind {
   kArenaAllocData,
   kArenaAllocPredecessors,
   kArenaAllocSTL,
+  kArenaAllocVerifier,
   kNumArenaAllocKinds
 };
 
-template <bool kCount>
-class ArenaAllocatorStatsImpl;
-
-template <>
-class ArenaAllocatorStatsImpl<false> {
- public:
-  ArenaAllocatorStatsImpl() = default;
-  ArenaAllocatorStatsImpl(const ArenaAllocatorStatsImpl& other) = default;
-  ArenaAllocatorStatsImpl& operator = (const ArenaAllocatorStatsImpl& other) = delete;
-
-  void Copy(const ArenaAllocatorStatsImpl& other) { UNUSED(other); }
-  void RecordAlloc(size_t bytes, ArenaAllocKind kind) { UNUSED(bytes); UNUSED(kind); }
-  size_t NumAllocations() const { return 0u; }
-  size_t BytesAllocated() const { return 0u; }
-  void Dump(std::ostream& os, const Arena* first, ssize_t lost_bytes_adjustment) const {
-    UNUSED(os); UNUSED(first); UNUSED(lost_bytes_adjustment);
-  }
-};
-
-template <bool kCount>
-class ArenaAllocatorStatsImpl {
+// Statistics of an allocator, by kind of allocation. They are only recorded
+// by the allocators of an ArenaPool created to count allocations.
+class ArenaAllocatorStats {
  public:
-  ArenaAllocatorStatsImpl();
-  ArenaAllocatorStatsImpl(const ArenaAllocatorStatsImpl& other) = default;
-  ArenaAllocatorStatsImpl& operator = (const ArenaAllocatorStatsImpl& other) = delete;
+  ArenaAllocatorStats();
+  ArenaAllocatorStats(const ArenaAllocatorStats& other) = default;
+  ArenaAllocatorStats& operator = (const ArenaAllocatorStats& other) = delete;
 
-  void Copy(const ArenaAllocatorStatsImpl& other);
+  void Copy(const ArenaAllocatorStats& other);
   void RecordAlloc(size_t bytes, ArenaAllocKind kind);
   size_t NumAllocations() const;
   size_t BytesAllocated() const;
@@ -95,8 +79,6 @@ class ArenaAllocatorStatsImpl {
   static const char* kAllocNames[kNumArenaAllocKinds];
 };
 
-typedef ArenaAllocatorStatsImpl<kArenaAllocatorCountAllocations> ArenaAllocatorStats;
-
 class Arena {
  public:
   static constexpr size_t kDefaultSize = 128 * KB;
@@ -129,20 +111,42 @@ class Arena {
   friend class ArenaAllocator;
   friend class ArenaStack;
   friend class ScopedArenaAllocator;
-  template <bool kCount> friend class ArenaAllocatorStatsImpl;
+  friend class ArenaAllocatorStats;
   DISALLOW_COPY_AND_ASSIGN(Arena);
 };
 
 class ArenaPool {
  public:
-  ArenaPool();
+  // The pool keeps up to this many bytes of free arenas for reuse.
+  static constexpr size_t kDefaultMaxFreeBytes = 8 * MB;
+
+  explicit ArenaPool(bool count_allocations = kArenaAllocatorCountAllocations,
+                     size_t max_free_bytes = kDefaultMaxFreeBytes);
   ~ArenaPool();
   Arena* AllocArena(size_t size);
+  // Gives the arenas back to the pool. Arenas larger than the default size,
+  // which only the largest methods need, and arenas above the maximum number
+  // of free bytes, are released to the system.
   void FreeArenaChain(Arena* first);
 
+  // Whether the allocators using this pool record their statistics.
+  bool CountsAllocations() const {
+    return count_allocations_;
+  }
+
+  // The largest number of bytes of arenas handed out and not given back at any one time.
+  size_t GetPeakBytesInUse() const LOCKS_EXCLUDED(lock_);
+
  private:
-  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  void AddBytesInUse(size_t bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const bool count_allocations_;
+  const size_t max_free_bytes_;
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   Arena* free_arenas_ GUARDED_BY(lock_);
+  size_t free_bytes_ GUARDED_BY(lock_);
+  size_t bytes_in_use_ GUARDED_BY(lock_);
+  size_t peak_bytes_in_use_ GUARDED_BY(lock_);
   DISALLOW_COPY_AND_ASSIGN(ArenaPool);
 };
 
@@ -153,8 +157,8 @@ class ArenaAllocator : private ArenaAllocatorStats {
 
   // Returns zeroed memory.
   void* Alloc(size_t bytes, ArenaAllocKind kind) ALWAYS_INLINE {
-    if (UNLIKELY(running_on_valgrind_)) {
-      return AllocValgrind(bytes, kind);
+    if (UNLIKELY(use_slow_path_)) {
+      return AllocSlowPath(bytes, kind);
     }
     bytes = RoundUp(bytes, 4);
     if (UNLIKELY(ptr_ + bytes > end_)) {
@@ -164,15 +168,18 @@ class ArenaAllocator : private ArenaAllocatorStats {
         return nullptr;
       }
     }
-    ArenaAllocatorStats::RecordAlloc(bytes, kind);
     uint8_t* ret = ptr_;
     ptr_ += bytes;
     return ret;
   }
 
+  // Allocation when running on valgrind, or when counting allocations.
+  void* AllocSlowPath(size_t bytes, ArenaAllocKind kind);
   void* AllocValgrind(size_t bytes, ArenaAllocKind kind);
   void ObtainNewArenaForAllocation(size_t allocation_size);
   size_t BytesAllocated() const;
+  // Bytes handed out so far, available even when the allocations are not counted.
+  size_t BytesUsed() const;
   MemStats GetMemStats() const;
 
  private:
@@ -183,7 +190,8 @@ class ArenaAllocator : private ArenaAllocatorStats {
   uint8_t* end_;
   uint8_t* ptr_;
   Arena* arena_head_;
-  bool running_on_valgrind_;
+  const bool running_on_valgrind_;
+  const bool use_slow_path_;
 
   DISALLOW_COPY_AND_ASSIGN(ArenaAllocator);
 };  // ArenaAllocator
@@ -203,4 +211,4 @@ class MemStats {
 
 }  // namespace art
 
-#endif  // ART_COMPILER_UTILS_ARENA_ALLOCATOR_H_
+#endif  // ART_RUNTIME_BASE_ARENA_ALLOCATOR_H_
@@ -25,6 +25,7 @@
 
 #include "cutils/atomic-inline.h"
 #include "cutils/trace.h"
+#include "lock_profiler.h"
 #include "runtime.h"
 #include "thread.h"
 
@@ -94,10 +95,11 @@ struct __attribute__((__may_alias__)) glibc_pthread_rwlock_t {
 class ScopedContentionRecorder {
  public:
   ScopedContentionRecorder(BaseMutex* mutex, uint64_t blocked_tid, uint64_t owner_tid)
-      : mutex_(kLogLockContentions ? mutex : NULL),
+      : mutex_(mutex),
         blocked_tid_(kLogLockContentions ? blocked_tid : 0),
         owner_tid_(kLogLockContentions ? owner_tid : 0),
-        start_nano_time_(kLogLockContentions ? NanoTime() : 0) {
+        profile_(LockProfiler::IsEnabled()),
+        start_nano_time_((kLogLockContentions || profile_) ? NanoTime() : 0) {
     std::string msg = StringPrintf("Lock contention on %s (owner tid: %" PRIu64 ")",
                                    mutex->GetName(), owner_tid);
     ATRACE_BEGIN(msg.c_str());
@@ -105,9 +107,14 @@ class ScopedContentionRecorder {
 
   ~ScopedContentionRecorder() {
     ATRACE_END();
-    if (kLogLockContentions) {
-      uint64_t end_nano_time = NanoTime();
-      mutex_->RecordContention(blocked_tid_, owner_tid_, end_nano_time - start_nano_time_);
+    if (kLogLockContentions || profile_) {
+      uint64_t wait_ns = NanoTime() - start_nano_time_;
+      if (kLogLockContentions) {
+        mutex_->RecordContention(blocked_tid_, owner_tid_, wait_ns);
+      }
+      if (profile_) {
+        LockProfiler::RecordMutexContention(mutex_, wait_ns);
+      }
     }
   }
 
@@ -115,6 +122,8 @@ class ScopedContentionRecorder {
   BaseMutex* const mutex_;
   const uint64_t blocked_tid_;
   const uint64_t owner_tid_;
+  // Whether the lock profiler was enabled when the wait started.
+  const bool profile_;
   const uint64_t start_nano_time_;
 };
 
@@ -187,19 +196,11 @@ inline void ReaderWriterMutex::SharedLock(Thread* self) {
   bool done = false;
   do {
     int32_t cur_state = state_;
-    if (LIKELY(cur_state >= 0)) {
+    if (LIKELY(cur_state >= 0) && LIKELY(!writer_preference_ || num_pending_writers_ == 0)) {
       // Add as an extra reader.
       done = android_atomic_acquire_cas(cur_state, cur_state + 1, &state_) == 0;
     } else {
-      // Owner holds it exclusively, hang up.
-      ScopedContentionRecorder scr(this, GetExclusiveOwnerTid(), SafeGetTid(self));
-      android_atomic_inc(&num_pending_readers_);
-      if (futex(&state_, FUTEX_WAIT, cur_state, NULL, NULL, 0) != 0) {
-        if (errno != EAGAIN) {
-          PLOG(FATAL) << "futex wait failed for " << name_;
-        }
-      }
-      android_atomic_dec(&num_pending_readers_);
+      HandleSharedLockContention(self, cur_state);
     }
   } while (!done);
 #else
@@ -235,6 +236,18 @@ inline void ReaderWriterMutex::SharedUnlock(Thread* self) {
 #endif
 }
 
+inline void ReaderWriterMutex::TransitionFromSuspendedToRunnable(Thread* self) {
+  DCHECK(self == NULL || self == Thread::Current());
+  RegisterAsLocked(self);
+  AssertSharedHeld(self);
+}
+
+inline void ReaderWriterMutex::TransitionFromRunnableToSuspended(Thread* self) {
+  DCHECK(self == NULL || self == Thread::Current());
+  AssertSharedHeld(self);
+  RegisterAsUnlocked(self);
+}
+
 inline bool Mutex::IsExclusiveHeld(const Thread* self) const {
   DCHECK(self == NULL || self == Thread::Current());
   bool result = (GetExclusiveOwnerTid() == SafeGetTid(self));
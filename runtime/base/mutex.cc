@@ -17,10 +17,14 @@
 #include "mutex.h"
 
 #include <errno.h>
+#include <sched.h>
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "atomic.h"
 #include "base/logging.h"
+#include "lock_profiler.h"
 #include "mutex-inl.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
@@ -34,6 +38,7 @@ Mutex* Locks::breakpoint_lock_ = nullptr;
 ReaderWriterMutex* Locks::classlinker_classes_lock_ = nullptr;
 ReaderWriterMutex* Locks::heap_bitmap_lock_ = nullptr;
 Mutex* Locks::logging_lock_ = nullptr;
+Mutex* Locks::mem_maps_lock_ = nullptr;
 ReaderWriterMutex* Locks::mutator_lock_ = nullptr;
 Mutex* Locks::runtime_shutdown_lock_ = nullptr;
 Mutex* Locks::thread_list_lock_ = nullptr;
@@ -443,13 +448,17 @@ std::ostream& operator<<(std::ostream& os, const Mutex& mu) {
   return os;
 }
 
-ReaderWriterMutex::ReaderWriterMutex(const char* name, LockLevel level)
+ReaderWriterMutex::ReaderWriterMutex(const char* name, LockLevel level, bool writer_preference)
     : BaseMutex(name, level)
 #if ART_USE_FUTEXES
-    , state_(0), exclusive_owner_(0), num_pending_readers_(0), num_pending_writers_(0)
+    , state_(0), exclusive_owner_(0), num_pending_readers_(0), num_pending_writers_(0),
+      writer_preference_(writer_preference), spin_limit_(kInitialSpins)
 #endif
+    , exclusive_acquire_ns_(0)
 {  // NOLINT(whitespace/braces)
 #if !ART_USE_FUTEXES
+  // pthread_rwlock_t has no portable writer preference.
+  UNUSED(writer_preference);
   CHECK_MUTEX_CALL(pthread_rwlock_init, (&rwlock_, NULL));
 #endif
 }
@@ -480,13 +489,18 @@ void ReaderWriterMutex::ExclusiveLock(Thread* self) {
   AssertNotExclusiveHeld(self);
 #if ART_USE_FUTEXES
   bool done = false;
+  bool spun = false;
   do {
     int32_t cur_state = state_;
     if (LIKELY(cur_state == 0)) {
       // Change state from 0 to -1.
       done =  __sync_bool_compare_and_swap(&state_, 0 /* cur_state*/, -1 /* new state */);
+    } else if (!spun && SpinWhileState(cur_state)) {
+      // Only spin once per acquisition, the lock may be handed around between other threads.
+      spun = true;
     } else {
       // Failed to acquire, hang up.
+      spun = true;
       ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
       num_pending_writers_++;
       if (futex(&state_, FUTEX_WAIT, cur_state, NULL, NULL, 0) != 0) {
@@ -506,12 +520,14 @@ void ReaderWriterMutex::ExclusiveLock(Thread* self) {
 #endif
   RegisterAsLocked(self);
   AssertExclusiveHeld(self);
+  RecordExclusiveAcquired();
 }
 
 void ReaderWriterMutex::ExclusiveUnlock(Thread* self) {
   DCHECK(self == NULL || self == Thread::Current());
   AssertExclusiveHeld(self);
   RegisterAsUnlocked(self);
+  RecordExclusiveReleased();
 #if ART_USE_FUTEXES
   bool done = false;
   do {
@@ -587,10 +603,59 @@ bool ReaderWriterMutex::ExclusiveLockWithTimeout(Thread* self, int64_t ms, int32
 #endif
   RegisterAsLocked(self);
   AssertSharedHeld(self);
+  RecordExclusiveAcquired();
   return true;
 }
 #endif
 
+#if ART_USE_FUTEXES
+bool ReaderWriterMutex::SpinWhileState(int32_t cur_state) {
+  const int32_t spin_limit = spin_limit_;
+  for (int32_t i = 0; i < spin_limit; ++i) {
+    if (state_ != cur_state) {
+      // Spinning paid off, allow longer spins. The limit is racily updated, it is only a hint.
+      spin_limit_ = std::min(spin_limit * 2, kMaxSpins);
+      return true;
+    }
+    SpinPause();
+  }
+  spin_limit_ = std::max(spin_limit / 2, kMinSpins);
+  return false;
+}
+
+void ReaderWriterMutex::HandleSharedLockContention(Thread* self, int32_t cur_state) {
+  if (SpinWhileState(cur_state)) {
+    return;
+  }
+  if (cur_state == 0) {
+    // Free with a writer pending, which is about to take the lock. Nothing would wake us up if it
+    // took and released it before we waited, yield rather than wait.
+    sched_yield();
+    return;
+  }
+  // Owner holds it exclusively, or readers hold it while a writer waits, hang up.
+  ScopedContentionRecorder scr(this, GetExclusiveOwnerTid(), SafeGetTid(self));
+  android_atomic_inc(&num_pending_readers_);
+  if (futex(&state_, FUTEX_WAIT, cur_state, NULL, NULL, 0) != 0) {
+    if (errno != EAGAIN) {
+      PLOG(FATAL) << "futex wait failed for " << name_;
+    }
+  }
+  android_atomic_dec(&num_pending_readers_);
+}
+#endif
+
+void ReaderWriterMutex::RecordExclusiveAcquired() {
+  exclusive_acquire_ns_ = LockProfiler::IsEnabled() ? NanoTime() : 0;
+}
+
+void ReaderWriterMutex::RecordExclusiveReleased() {
+  if (UNLIKELY(exclusive_acquire_ns_ != 0)) {
+    LockProfiler::RecordMutexHold(this, NanoTime() - exclusive_acquire_ns_);
+    exclusive_acquire_ns_ = 0;
+  }
+}
+
 bool ReaderWriterMutex::SharedTryLock(Thread* self) {
   DCHECK(self == NULL || self == Thread::Current());
 #if ART_USE_FUTEXES
@@ -818,6 +883,7 @@ void Locks::Init() {
     DCHECK(classlinker_classes_lock_ != nullptr);
     DCHECK(heap_bitmap_lock_ != nullptr);
     DCHECK(logging_lock_ != nullptr);
+    DCHECK(mem_maps_lock_ != nullptr);
     DCHECK(mutator_lock_ != nullptr);
     DCHECK(thread_list_lock_ != nullptr);
     DCHECK(thread_suspend_count_lock_ != nullptr);
@@ -835,9 +901,9 @@ void Locks::Init() {
     classlinker_classes_lock_ = new ReaderWriterMutex("ClassLinker classes lock",
                                                       kClassLinkerClassesLock);
     DCHECK(heap_bitmap_lock_ == nullptr);
-    heap_bitmap_lock_ = new ReaderWriterMutex("heap bitmap lock", kHeapBitmapLock);
+    heap_bitmap_lock_ = new ReaderWriterMutex("heap bitmap lock", kHeapBitmapLock, true);
     DCHECK(mutator_lock_ == nullptr);
-    mutator_lock_ = new ReaderWriterMutex("mutator lock", kMutatorLock);
+    mutator_lock_ = new ReaderWriterMutex("mutator lock", kMutatorLock, true);
     DCHECK(runtime_shutdown_lock_ == nullptr);
     runtime_shutdown_lock_ = new Mutex("runtime shutdown lock", kRuntimeShutdownLock);
     DCHECK(thread_list_lock_ == nullptr);
@@ -852,6 +918,8 @@ void Locks::Init() {
     unexpected_signal_lock_ = new Mutex("unexpected signal lock", kUnexpectedSignalLock, true);
     DCHECK(intern_table_lock_ == nullptr);
     intern_table_lock_ = new Mutex("InternTable lock", kInternTableLock);
+    DCHECK(mem_maps_lock_ == nullptr);
+    mem_maps_lock_ = new Mutex("mem maps lock", kMemMapsLock);
   }
 }
 
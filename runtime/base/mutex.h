@@ -57,6 +57,7 @@ enum LockLevel {
   kUnexpectedSignalLock,
   kThreadSuspendCountLock,
   kAbortLock,
+  kMemMapsLock,
   kJdwpSocketLock,
   kRosAllocGlobalLock,
   kRosAllocBracketLock,
@@ -65,11 +66,16 @@ enum LockLevel {
   kReferenceProcessorLock,
   kDexFileMethodInlinerLock,
   kDexFileToMethodInlinerMapLock,
+  kMarkStackSegmentPoolLock,
   kMarkSweepMarkStackLock,
+  kConcurrentCopyingMarkStackLock,
   kTransactionLogLock,
   kInternTableLock,
   kMonitorPoolLock,
+  kMonitorHashCodesLock,
   kDefaultMutexLevel,
+  kJitLock,
+  kJniWeakGlobalsLock,
   kMarkSweepLargeObjectLock,
   kPinTableLock,
   kLoadLibraryLock,
@@ -107,6 +113,19 @@ const bool kLogLockContentions = false;
 const bool kLogLockContentions = false;
 #endif
 const size_t kContentionLogSize = 4;
+
+// Tells the CPU that we are busy waiting, which saves power and lets a sibling hardware thread,
+// possibly the lock owner, run.
+static inline void SpinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" : : : "memory");
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7A__)
+  __asm__ __volatile__("yield" : : : "memory");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
 const size_t kContentionLogDataSize = kLogLockContentions ? 1 : 0;
 const size_t kAllMutexDataSize = kLogLockContentions ? 1 : 0;
 
@@ -265,10 +284,22 @@ class LOCKABLE Mutex : public BaseMutex {
 // Exclusive | Block         | Free            | Block            | error
 // Shared(n) | Block         | error           | SharedLock(n+1)* | Shared(n-1) or Free
 // * for large values of n the SharedLock may block.
+//
+// With writer preference, SharedLock also blocks while a writer waits, so that a steady stream
+// of readers can't starve the writer, e.g. SuspendAll acquiring the mutator lock. A contended
+// acquisition spins for a learned number of pauses before waiting on the futex, the lock being
+// usually held briefly. When the LockProfiler is enabled the exclusive hold times are recorded
+// along with the wait times.
 std::ostream& operator<<(std::ostream& os, const ReaderWriterMutex& mu);
 class LOCKABLE ReaderWriterMutex : public BaseMutex {
  public:
-  explicit ReaderWriterMutex(const char* name, LockLevel level = kDefaultMutexLevel);
+  // Bounds of the number of pauses a contended acquisition spins for.
+  static constexpr int32_t kMinSpins = 16;
+  static constexpr int32_t kInitialSpins = 128;
+  static constexpr int32_t kMaxSpins = 1024;
+
+  explicit ReaderWriterMutex(const char* name, LockLevel level = kDefaultMutexLevel,
+                             bool writer_preference = false);
   ~ReaderWriterMutex();
 
   virtual bool IsReaderWriterMutex() const { return true; }
@@ -299,6 +330,13 @@ class LOCKABLE ReaderWriterMutex : public BaseMutex {
   void SharedUnlock(Thread* self) UNLOCK_FUNCTION() ALWAYS_INLINE;
   void ReaderUnlock(Thread* self) UNLOCK_FUNCTION() { SharedUnlock(self); }
 
+  // Register or unregister a share of the access without changing the state of the lock. Used for
+  // mutator_lock_ by the transitions of a thread to and from the runnable state: a runnable thread
+  // is kept from running during a suspend all by the thread suspension protocol rather than by
+  // the lock, see Thread::TransitionFromSuspendedToRunnable and ThreadList::SuspendAll.
+  void TransitionFromSuspendedToRunnable(Thread* self) SHARED_LOCK_FUNCTION() ALWAYS_INLINE;
+  void TransitionFromRunnableToSuspended(Thread* self) UNLOCK_FUNCTION() ALWAYS_INLINE;
+
   // Is the current thread the exclusive holder of the ReaderWriterMutex.
   bool IsExclusiveHeld(const Thread* self) const;
 
@@ -344,6 +382,19 @@ class LOCKABLE ReaderWriterMutex : public BaseMutex {
   virtual void Dump(std::ostream& os) const;
 
  private:
+#if ART_USE_FUTEXES
+  // Spins while state_ is cur_state, for at most spin_limit_ pauses. Returns true if the state
+  // changed, the caller retries the acquisition rather than waiting.
+  bool SpinWhileState(int32_t cur_state);
+
+  // The slow path of SharedLock, the lock was held exclusively or a writer is preferred.
+  void HandleSharedLockContention(Thread* self, int32_t cur_state);
+#endif
+
+  // Record the exclusive hold time for the LockProfiler.
+  void RecordExclusiveAcquired();
+  void RecordExclusiveReleased();
+
 #if ART_USE_FUTEXES
   // -1 implies held exclusive, +ve shared held by state_ many owners.
   volatile int32_t state_;
@@ -353,9 +404,15 @@ class LOCKABLE ReaderWriterMutex : public BaseMutex {
   volatile int32_t num_pending_readers_;
   // Pending writers.
   AtomicInteger num_pending_writers_;
+  // Whether readers wait for the pending writers.
+  const bool writer_preference_;
+  // Learned number of pauses to spin before waiting, see kInitialSpins.
+  volatile int32_t spin_limit_;
 #else
   pthread_rwlock_t rwlock_;
 #endif
+  // When the exclusive owner acquired the lock if the LockProfiler was enabled, 0 otherwise.
+  uint64_t exclusive_acquire_ns_;
   DISALLOW_COPY_AND_ASSIGN(ReaderWriterMutex);
 };
 
@@ -558,6 +615,10 @@ class Locks {
   // Have an exclusive aborting thread.
   static Mutex* abort_lock_ ACQUIRED_AFTER(classlinker_classes_lock_);
 
+  // Guards the ranges of the low 4GB reservation of MemMap, maps are created and released with
+  // other locks held.
+  static Mutex* mem_maps_lock_ ACQUIRED_AFTER(abort_lock_);
+
   // Allow mutual exclusion when manipulating Thread::suspend_count_.
   // TODO: Does the trade-off of a per-thread lock make sense?
   static Mutex* thread_suspend_count_lock_ ACQUIRED_AFTER(abort_lock_);
@@ -16,7 +16,7 @@
 
 #include "scoped_arena_allocator.h"
 
-#include "utils/arena_allocator.h"
+#include "base/arena_allocator.h"
 #include <memcheck/memcheck.h>
 
 namespace art {
@@ -30,7 +30,8 @@ ArenaStack::ArenaStack(ArenaPool* arena_pool)
     top_arena_(nullptr),
     top_ptr_(nullptr),
     top_end_(nullptr),
-    running_on_valgrind_(RUNNING_ON_VALGRIND > 0) {
+    running_on_valgrind_(RUNNING_ON_VALGRIND > 0),
+    use_slow_path_(running_on_valgrind_ || arena_pool->CountsAllocations()) {
 }
 
 ArenaStack::~ArenaStack() {
@@ -91,6 +92,20 @@ void ArenaStack::UpdateBytesAllocated() {
   }
 }
 
+void* ArenaStack::AllocSlowPath(size_t bytes, ArenaAllocKind kind) {
+  if (running_on_valgrind_) {
+    return AllocValgrind(bytes, kind);
+  }
+  size_t rounded_bytes = RoundUp(bytes, 4);
+  uint8_t* ptr = top_ptr_;
+  if (UNLIKELY(static_cast<size_t>(top_end_ - ptr) < rounded_bytes)) {
+    ptr = AllocateFromNextArena(rounded_bytes);
+  }
+  CurrentStats()->RecordAlloc(bytes, kind);
+  top_ptr_ = ptr + rounded_bytes;
+  return ptr;
+}
+
 void* ArenaStack::AllocValgrind(size_t bytes, ArenaAllocKind kind) {
   size_t rounded_bytes = RoundUp(bytes + kValgrindRedZoneBytes, 4);
   uint8_t* ptr = top_ptr_;
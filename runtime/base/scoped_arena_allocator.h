@@ -14,13 +14,13 @@
  * limitations under the License.
  */
 
-#ifndef ART_COMPILER_UTILS_SCOPED_ARENA_ALLOCATOR_H_
-#define ART_COMPILER_UTILS_SCOPED_ARENA_ALLOCATOR_H_
+#ifndef ART_RUNTIME_BASE_SCOPED_ARENA_ALLOCATOR_H_
+#define ART_RUNTIME_BASE_SCOPED_ARENA_ALLOCATOR_H_
 
 #include "base/logging.h"
 #include "base/macros.h"
-#include "utils/arena_allocator.h"
-#include "utils/debug_stack.h"
+#include "base/arena_allocator.h"
+#include "base/debug_stack.h"
 #include "globals.h"
 
 namespace art {
@@ -64,15 +64,14 @@ class ArenaStack : private DebugStackRefCounter {
 
   // Private - access via ScopedArenaAllocator or ScopedArenaAllocatorAdapter.
   void* Alloc(size_t bytes, ArenaAllocKind kind) ALWAYS_INLINE {
-    if (UNLIKELY(running_on_valgrind_)) {
-      return AllocValgrind(bytes, kind);
+    if (UNLIKELY(use_slow_path_)) {
+      return AllocSlowPath(bytes, kind);
     }
     size_t rounded_bytes = RoundUp(bytes, 4);
     uint8_t* ptr = top_ptr_;
     if (UNLIKELY(static_cast<size_t>(top_end_ - ptr) < rounded_bytes)) {
       ptr = AllocateFromNextArena(rounded_bytes);
     }
-    CurrentStats()->RecordAlloc(bytes, kind);
     top_ptr_ = ptr + rounded_bytes;
     return ptr;
   }
@@ -80,6 +79,8 @@ class ArenaStack : private DebugStackRefCounter {
   uint8_t* AllocateFromNextArena(size_t rounded_bytes);
   void UpdatePeakStatsAndRestore(const ArenaAllocatorStats& restore_stats);
   void UpdateBytesAllocated();
+  // Allocation when running on valgrind, or when counting allocations.
+  void* AllocSlowPath(size_t bytes, ArenaAllocKind kind);
   void* AllocValgrind(size_t bytes, ArenaAllocKind kind);
 
   StatsAndPool stats_and_pool_;
@@ -89,6 +90,7 @@ class ArenaStack : private DebugStackRefCounter {
   uint8_t* top_end_;
 
   const bool running_on_valgrind_;
+  const bool use_slow_path_;
 
   friend class ScopedArenaAllocator;
   template <typename T>
@@ -243,4 +245,4 @@ inline ScopedArenaAllocatorAdapter<void> ScopedArenaAllocator::Adapter() {
 
 }  // namespace art
 
-#endif  // ART_COMPILER_UTILS_SCOPED_ARENA_ALLOCATOR_H_
+#endif  // ART_RUNTIME_BASE_SCOPED_ARENA_ALLOCATOR_H_
@@ -84,6 +84,14 @@ void CumulativeLogger::Dump(std::ostream &os) const {
   DumpHistogram(os);
 }
 
+void CumulativeLogger::GetLabelTotals(std::vector<LabelTotal>* totals) const {
+  MutexLock mu(Thread::Current(), lock_);
+  for (const Histogram<uint64_t>* histogram : histograms_) {
+    LabelTotal total = { histogram->Name(), histogram->SampleSize(), histogram->Sum() * kAdjust };
+    totals->push_back(total);
+  }
+}
+
 void CumulativeLogger::AddPair(const std::string& label, uint64_t delta_time) {
   // Convert delta time to microseconds so that we don't overflow our counters.
   delta_time /= kAdjust;
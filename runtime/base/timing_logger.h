@@ -45,6 +45,14 @@ class CumulativeLogger {
   void AddLogger(const TimingLogger& logger) LOCKS_EXCLUDED(lock_);
   size_t GetIterations() const;
 
+  // The number of times a label was logged, and the total time of these splits.
+  struct LabelTotal {
+    std::string label;
+    uint64_t count;
+    uint64_t total_ns;
+  };
+  void GetLabelTotals(std::vector<LabelTotal>* totals) const LOCKS_EXCLUDED(lock_);
+
  private:
   class HistogramComparator {
    public:
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "catch_handler_cache.h"
+
+#include "mirror/art_method.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "runtime.h"
+
+namespace art {
+
+CatchHandlerCache::CatchHandlerCache() : entries_(new Entry[kNumEntries]) {
+  for (size_t i = 0; i < kNumEntries; ++i) {
+    Entry* entry = &entries_[i];
+    entry->method = nullptr;
+    entry->exception_class = nullptr;
+    entry->dex_pc = 0;
+    entry->handler_dex_pc = 0;
+  }
+}
+
+bool CatchHandlerCache::Lookup(mirror::ArtMethod* method, uint32_t dex_pc,
+                               mirror::Class* exception_class, uint32_t* handler_dex_pc) const {
+  const Entry* entry = &entries_[IndexOf(method, dex_pc)];
+  if (entry->method != method || entry->dex_pc != dex_pc ||
+      entry->exception_class != exception_class) {
+    return false;
+  }
+  *handler_dex_pc = entry->handler_dex_pc;
+  return true;
+}
+
+void CatchHandlerCache::Add(mirror::ArtMethod* method, uint32_t dex_pc,
+                            mirror::Class* exception_class, uint32_t handler_dex_pc) {
+  Entry* entry = &entries_[IndexOf(method, dex_pc)];
+  entry->method = method;
+  entry->exception_class = exception_class;
+  entry->dex_pc = dex_pc;
+  entry->handler_dex_pc = handler_dex_pc;
+}
+
+bool CatchHandlerCache::IsBootEntry(const Entry* entry) {
+  mirror::Class* declaring_class = entry->method->GetFieldObject<mirror::Class, kVerifyNone>(
+      mirror::ArtMethod::DeclaringClassOffset());
+  return declaring_class->GetClassLoader() == nullptr &&
+      (entry->exception_class == nullptr ||
+       entry->exception_class->GetClassLoader() == nullptr);
+}
+
+void CatchHandlerCache::VisitRoots(RootCallback* visitor, void* arg, uint32_t tid) {
+  const bool drop_unloadable = Runtime::Current()->CanUnloadClasses();
+  for (size_t i = 0; i < kNumEntries; ++i) {
+    Entry* entry = &entries_[i];
+    if (drop_unloadable && entry->method != nullptr && !IsBootEntry(entry)) {
+      entry->method = nullptr;
+      entry->exception_class = nullptr;
+      continue;
+    }
+    if (entry->exception_class != nullptr) {
+      visitor(reinterpret_cast<mirror::Object**>(&entry->exception_class), arg, tid,
+              kRootVMInternal);
+    }
+  }
+}
+
+}  // namespace art
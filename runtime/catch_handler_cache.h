@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CATCH_HANDLER_CACHE_H_
+#define ART_RUNTIME_CATCH_HANDLER_CACHE_H_
+
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Class;
+}  // namespace mirror
+
+// The catch handlers found by ArtMethod::FindCatchBlock, so that an exception thrown again
+// through the same frames doesn't decode the try items and resolve the handler types of every
+// frame again. The ArtMethod layout mirrors java.lang.reflect.ArtMethod so the cache is a
+// direct-mapped side table indexed by the method and the dex pc of the throwing instruction,
+// remembering the handler for one exception class. Methods don't move; classes do, so they
+// aren't hashed and are visited as roots of the owning thread. When classes may be unloaded the
+// entries involving classes of other class loaders than the boot class loader are dropped as the
+// roots are visited, so the cache neither keeps those classes alive nor outlives them.
+//
+// Each thread has its own cache, see Thread::GetCatchHandlerCache, which needs no locking.
+class CatchHandlerCache {
+ public:
+  // The number of entries of the table, a power of two.
+  static constexpr size_t kNumEntries = 64;
+
+  CatchHandlerCache();
+
+  // Returns true and sets handler_dex_pc to the handler of method at dex_pc for exceptions of
+  // exception_class, DexFile::kDexNoIndex if there is none, when the cache knows the answer.
+  bool Lookup(mirror::ArtMethod* method, uint32_t dex_pc, mirror::Class* exception_class,
+              uint32_t* handler_dex_pc) const;
+
+  // Records the handler of method at dex_pc for exceptions of exception_class.
+  void Add(mirror::ArtMethod* method, uint32_t dex_pc, mirror::Class* exception_class,
+           uint32_t handler_dex_pc);
+
+  void VisitRoots(RootCallback* visitor, void* arg, uint32_t tid)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  struct Entry {
+    mirror::ArtMethod* method;
+    mirror::Class* exception_class;
+    uint32_t dex_pc;
+    uint32_t handler_dex_pc;
+  };
+
+  // Whether the method and exception class of a used entry are boot classes.
+  static bool IsBootEntry(const Entry* entry) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static size_t IndexOf(mirror::ArtMethod* method, uint32_t dex_pc) {
+    uintptr_t key = reinterpret_cast<uintptr_t>(method) >> 3;
+    return (key ^ (dex_pc * 0x9e3779b1u)) & (kNumEntries - 1);
+  }
+
+  UniquePtr<Entry[]> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(CatchHandlerCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CATCH_HANDLER_CACHE_H_
@@ -19,6 +19,7 @@
 #include <sys/mman.h>
 #include <zlib.h>
 
+#include "atomic.h"
 #include "base/logging.h"
 #include "class_linker.h"
 #include "class_linker-inl.h"
@@ -148,11 +149,14 @@ static bool ShouldTrace(JavaVMExt* vm, mirror::ArtMethod* method)
 
 class ScopedCheck {
  public:
-  // For JNIEnv* functions.
-  explicit ScopedCheck(JNIEnv* env, int flags, const char* functionName)
+  // For JNIEnv* functions. calls counts the calls of the function for the sampling of the argument
+  // checks, see JavaVMExt::check_jni_sample_rate.
+  explicit ScopedCheck(JNIEnv* env, int flags, const char* functionName, Atomic<uint32_t>* calls)
       SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
       : soa_(env) {
     Init(flags, functionName, true);
+    uint32_t sample_rate = soa_.Vm()->check_jni_sample_rate;
+    sampled_ = sample_rate <= 1 || (calls->FetchAndAdd(1) % sample_rate) == 0;
     CheckThread(flags);
   }
 
@@ -179,7 +183,7 @@ class ScopedCheck {
   // times, so using "java.lang.Thread" instead of "java/lang/Thread" might work in some
   // circumstances, but this is incorrect.
   void CheckClassName(const char* class_name) {
-    if (!IsValidJniClassName(class_name)) {
+    if (sampled_ && !IsValidJniClassName(class_name)) {
       JniAbortF(function_name_,
                 "illegal class name '%s'\n"
                 "    (should be of the form 'package/Class', [Lpackage/Class;' or '[[B')",
@@ -195,6 +199,9 @@ class ScopedCheck {
    */
   void CheckFieldType(jvalue value, jfieldID fid, char prim, bool isStatic)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::ArtField* f = CheckFieldID(fid);
     if (f == nullptr) {
       return;
@@ -243,6 +250,9 @@ class ScopedCheck {
    */
   void CheckInstanceFieldID(jobject java_object, jfieldID fid)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::Object* o = soa_.Decode<mirror::Object*>(java_object);
     if (o == nullptr || !Runtime::Current()->GetHeap()->IsValidObjectAddress(o)) {
       Runtime::Current()->GetHeap()->DumpSpaces();
@@ -278,6 +288,9 @@ class ScopedCheck {
    */
   void CheckSig(jmethodID mid, const char* expectedType, bool isStatic)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::ArtMethod* m = CheckMethodID(mid);
     if (m == nullptr) {
       return;
@@ -304,6 +317,9 @@ class ScopedCheck {
    */
   void CheckStaticFieldID(jclass java_class, jfieldID fid)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::Class* c = soa_.Decode<mirror::Class*>(java_class);
     mirror::ArtField* f = CheckFieldID(fid);
     if (f == nullptr) {
@@ -326,6 +342,9 @@ class ScopedCheck {
    */
   void CheckStaticMethod(jclass java_class, jmethodID mid)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::ArtMethod* m = CheckMethodID(mid);
     if (m == nullptr) {
       return;
@@ -346,6 +365,9 @@ class ScopedCheck {
    */
   void CheckVirtualMethod(jobject java_object, jmethodID mid)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!sampled_) {
+      return;
+    }
     mirror::ArtMethod* m = CheckMethodID(mid);
     if (m == nullptr) {
       return;
@@ -542,8 +564,8 @@ class ScopedCheck {
       }
     }
 
-    // We always do the thorough checks on entry, and never on exit...
-    if (entry) {
+    // We always do the thorough checks on entry of the sampled calls, and never on exit...
+    if (entry && sampled_) {
       va_start(ap, fmt0);
       for (const char* fmt = fmt0; *fmt; ++fmt) {
         char ch = *fmt;
@@ -665,6 +687,7 @@ class ScopedCheck {
     flags_ = flags;
     function_name_ = functionName;
     has_method_ = has_method;
+    sampled_ = true;
   }
 
   /*
@@ -883,12 +906,15 @@ class ScopedCheck {
   int flags_;
   bool has_method_;
   int indent_;
+  // Whether the arguments of this call are checked.
+  bool sampled_;
 
   DISALLOW_COPY_AND_ASSIGN(ScopedCheck);
 };
 
 #define CHECK_JNI_ENTRY(flags, types, args...) \
-  ScopedCheck sc(env, flags, __FUNCTION__); \
+  static Atomic<uint32_t> check_jni_calls; \
+  ScopedCheck sc(env, flags, __FUNCTION__, &check_jni_calls); \
   sc.Check(true, types, ##args)
 
 #define CHECK_JNI_EXIT(type, exp) ({ \
@@ -66,6 +66,7 @@
 #include "UniquePtr.h"
 #include "utils.h"
 #include "verifier/method_verifier.h"
+#include "verifier/verifier_deps.h"
 #include "well_known_classes.h"
 
 namespace art {
@@ -124,12 +125,14 @@ static void WrapExceptionInInitializer() SHARED_LOCKS_REQUIRED(Locks::mutator_lo
 }
 
 static size_t Hash(const char* s) {
-  // This is the java.lang.String hashcode for convenience, not interoperability.
-  size_t hash = 0;
-  for (; *s != '\0'; ++s) {
-    hash = hash * 31 + *s;
-  }
-  return hash;
+  return ClassTable::HashDescriptor(s);
+}
+
+// The hash of the name of a method. Linking compares it first, most methods have another name and
+// the name and signature comparison, which is a string comparison across dex files, is skipped.
+static size_t MethodNameHash(mirror::ArtMethod* method)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  return Hash(MethodHelper(method).GetName());
 }
 
 const char* ClassLinker::class_roots_descriptors_[] = {
@@ -173,6 +176,7 @@ const char* ClassLinker::class_roots_descriptors_[] = {
 ClassLinker::ClassLinker(InternTable* intern_table)
     // dex_lock_ is recursive as it may be used in stack dumping.
     : dex_lock_("ClassLinker dex lock", kDefaultMutexLevel),
+      allow_new_class_loaders_(true),
       dex_cache_image_class_lookup_required_(false),
       failed_dex_cache_class_lookups_(0),
       class_roots_(nullptr),
@@ -333,11 +337,10 @@ void ClassLinker::InitFromCompiler(const std::vector<const DexFile*>& boot_class
   InitializePrimitiveClass(char_class.get(), Primitive::kPrimChar);
   SetClassRoot(kPrimitiveChar, char_class.get());  // needs descriptor
 
-  // Create runtime resolution and imt conflict methods. Also setup the default imt.
+  // Create runtime resolution and imt conflict methods.
   Runtime* runtime = Runtime::Current();
   runtime->SetResolutionMethod(runtime->CreateResolutionMethod());
   runtime->SetImtConflictMethod(runtime->CreateImtConflictMethod());
-  runtime->SetDefaultImt(runtime->CreateDefaultImt(this));
 
   // Object, String and DexCache need to be rerun through FindSystemClass to finish init
   java_lang_Object->SetStatus(mirror::Class::kStatusNotReady, self);
@@ -455,6 +458,9 @@ void ClassLinker::InitFromCompiler(const std::vector<const DexFile*>& boot_class
   mirror::Class* java_lang_ClassLoader = FindSystemClass(self, "Ljava/lang/ClassLoader;");
   CHECK_EQ(java_lang_ClassLoader->GetObjectSize(), sizeof(mirror::ClassLoader));
   SetClassRoot(kJavaLangClassLoader, java_lang_ClassLoader);
+  // The collectors which unload classes look for the class loaders they scan.
+  java_lang_ClassLoader->SetAccessFlags(
+      java_lang_ClassLoader->GetAccessFlags() | kAccClassIsClassLoader);
 
   // Set up java.lang.Throwable, java.lang.ClassNotFoundException, and
   // java.lang.StackTraceElement as a convenience.
@@ -583,6 +589,12 @@ bool ClassLinker::GenerateOatFile(const char* dex_filename,
   argv.push_back(dex_file_option);
   argv.push_back(oat_fd_option);
   argv.push_back(oat_location_option);
+  // An odex next to the dex file is out of date, typically compiled against another boot image,
+  // but still holds a verified copy of the dex file when the dex file didn't change.
+  std::string odex_filename(OatFile::DexFilenameToOdexFilename(dex_filename));
+  if (OS::FileExists(odex_filename.c_str())) {
+    argv.push_back("--verified-oat-file=" + odex_filename);
+  }
   const std::vector<std::string>& compiler_options = Runtime::Current()->GetCompilerOptions();
   for (size_t i = 0; i < compiler_options.size(); ++i) {
     argv.push_back(compiler_options[i].c_str());
@@ -612,9 +624,19 @@ OatFile& ClassLinker::GetImageOatFile(gc::space::ImageSpace* space) {
 }
 
 const OatFile* ClassLinker::FindOpenedOatFileForDexFile(const DexFile& dex_file) {
+  // Classes are loaded, verified and linked without taking the dex lock once their dex file knows
+  // its oat file.
+  const OatFile* oat_file = dex_file.GetOatFile();
+  if (oat_file != nullptr) {
+    return oat_file;
+  }
   const char* dex_location = dex_file.GetLocation().c_str();
   uint32_t dex_location_checksum = dex_file.GetLocationChecksum();
-  return FindOpenedOatFileFromDexLocation(dex_location, &dex_location_checksum);
+  oat_file = FindOpenedOatFileFromDexLocation(dex_location, &dex_location_checksum);
+  if (oat_file != nullptr) {
+    dex_file.SetOatFile(oat_file);
+  }
+  return oat_file;
 }
 
 const OatFile* ClassLinker::FindOpenedOatFileFromDexLocation(const char* dex_location,
@@ -1062,6 +1084,22 @@ void ClassLinker::InitFromImage() {
   // bitmap walk.
   mirror::ArtMethod::SetClass(GetClassRoot(kJavaLangReflectArtMethod));
 
+  Runtime::Current()->StartupSplit("ClassLinker::InitFromImage class and intern tables");
+  if (space->GetClassTableBegin() != nullptr) {
+    // The image writer laid out the image classes in a table, no need to search the dex caches
+    // or to move their classes into the class table.
+    class_table_.SetImageSlots(
+        reinterpret_cast<const ClassTable::ImageSlot*>(space->GetClassTableBegin()),
+        space->GetClassTableSize() / sizeof(ClassTable::ImageSlot));
+    dex_cache_image_class_lookup_required_ = false;
+  }
+  if (space->GetInternTableBegin() != nullptr) {
+    intern_table_->SetImageSlots(
+        reinterpret_cast<const InternTable::ImageSlot*>(space->GetInternTableBegin()),
+        space->GetInternTableSize() / sizeof(InternTable::ImageSlot));
+  }
+  Runtime::Current()->StartupSplit("ClassLinker::InitFromImage roots");
+
   // Set entry point to interpreter if in InterpretOnly mode.
   if (Runtime::Current()->GetInstrumentation()->InterpretOnly()) {
     ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
@@ -1099,15 +1137,30 @@ void ClassLinker::InitFromImage() {
 void ClassLinker::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags) {
   callback(reinterpret_cast<mirror::Object**>(&class_roots_), arg, 0, kRootVMInternal);
   Thread* self = Thread::Current();
+  // When unloading classes, the classes of the class loaders and the dex caches they use are
+  // marked with the class loaders instead, see VisitClassLoaderClasses.
+  const bool unload_classes = (flags & kVisitRootFlagClassUnloading) != 0;
+  std::set<const DexFile*> class_loader_dex_files;
+  if (unload_classes) {
+    ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
+    for (const auto& entry : class_loader_classes_) {
+      class_loader_dex_files.insert(entry.second.dex_files.begin(), entry.second.dex_files.end());
+    }
+  }
   {
     ReaderMutexLock mu(self, dex_lock_);
     if ((flags & kVisitRootFlagAllRoots) != 0) {
-      for (auto dex_cache : dex_caches_) {
-        callback(reinterpret_cast<mirror::Object**>(&dex_cache), arg, 0, kRootVMInternal);
+      for (auto& entry : dex_caches_) {
+        if (class_loader_dex_files.find(entry.first) == class_loader_dex_files.end()) {
+          callback(reinterpret_cast<mirror::Object**>(&entry.second), arg, 0, kRootVMInternal);
+        }
       }
     } else if ((flags & kVisitRootFlagNewRoots) != 0) {
-      for (auto index : new_dex_cache_roots_) {
-        callback(reinterpret_cast<mirror::Object**>(&dex_caches_[index]), arg, 0, kRootVMInternal);
+      for (const DexFile* dex_file : new_dex_cache_roots_) {
+        auto it = dex_caches_.find(dex_file);
+        if (it != dex_caches_.end()) {
+          callback(reinterpret_cast<mirror::Object**>(&it->second), arg, 0, kRootVMInternal);
+        }
       }
     }
     if ((flags & kVisitRootFlagClearRootLog) != 0) {
@@ -1122,9 +1175,7 @@ void ClassLinker::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
   {
     WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
     if ((flags & kVisitRootFlagAllRoots) != 0) {
-      for (std::pair<const size_t, mirror::Class*>& it : class_table_) {
-        callback(reinterpret_cast<mirror::Object**>(&it.second), arg, 0, kRootStickyClass);
-      }
+      class_table_.VisitRoots(callback, arg, unload_classes);
     } else if ((flags & kVisitRootFlagNewRoots) != 0) {
       for (auto& pair : new_class_roots_) {
         mirror::Object* old_ref = pair.second;
@@ -1133,13 +1184,7 @@ void ClassLinker::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
           // Uh ohes, GC moved a root in the log. Need to search the class_table and update the
           // corresponding object. This is slow, but luckily for us, this may only happen with a
           // concurrent moving GC.
-          for (auto it = class_table_.lower_bound(pair.first), end = class_table_.end();
-              it != end && it->first == pair.first; ++it) {
-            // If the class stored matches the old class, update it to the new value.
-            if (old_ref == it->second) {
-              it->second = pair.second;
-            }
-          }
+          class_table_.UpdateClass(pair.first, down_cast<mirror::Class*>(old_ref), pair.second);
         }
       }
     }
@@ -1151,13 +1196,18 @@ void ClassLinker::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
     } else if ((flags & kVisitRootFlagStopLoggingNewRoots) != 0) {
       log_new_class_table_roots_ = false;
     }
+    if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+      // In a pause, no lock free lookup can be reading the storage replaced by rehashes.
+      class_table_.FreeRetiredStorage();
+    }
     // We deliberately ignore the class roots in the image since we
     // handle image roots by using the MS/CMS rescanning of dirty cards.
   }
   callback(reinterpret_cast<mirror::Object**>(&array_iftable_), arg, 0, kRootVMInternal);
   DCHECK(array_iftable_ != nullptr);
   for (size_t i = 0; i < kFindArrayCacheSize; ++i) {
-    if (find_array_class_cache_[i] != nullptr) {
+    mirror::Class* array_class = find_array_class_cache_[i];
+    if (array_class != nullptr && (!unload_classes || array_class->GetClassLoader() == nullptr)) {
       callback(reinterpret_cast<mirror::Object**>(&find_array_class_cache_[i]), arg, 0,
                kRootVMInternal);
     }
@@ -1169,11 +1219,7 @@ void ClassLinker::VisitClasses(ClassVisitor* visitor, void* arg) {
     MoveImageClassesToClassTable();
   }
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-    if (!visitor(it.second, arg)) {
-      return;
-    }
-  }
+  class_table_.VisitClasses(visitor, arg);
 }
 
 static bool GetClassesVisitor(mirror::Class* c, void* arg) {
@@ -1241,8 +1287,14 @@ mirror::DexCache* ClassLinker::AllocDexCache(Thread* self, const DexFile& dex_fi
   if (methods.get() == NULL) {
     return NULL;
   }
+  size_t num_resolved_fields = dex_file.NumFieldIds();
+  if (Runtime::Current()->UseCompactDexCacheFields() && !Runtime::Current()->IsCompiler()) {
+    // The compiler resolves every field, it keeps the dense array.
+    num_resolved_fields = std::min(
+        num_resolved_fields, static_cast<size_t>(mirror::DexCache::kCompactResolvedFieldsSize));
+  }
   SirtRef<mirror::ObjectArray<mirror::ArtField> >
-      fields(self, AllocArtFieldArray(self, dex_file.NumFieldIds()));
+      fields(self, AllocArtFieldArray(self, num_resolved_fields));
   if (fields.get() == NULL) {
     return NULL;
   }
@@ -1388,6 +1440,14 @@ mirror::Class* ClassLinker::FindClass(Thread* self, const char* descriptor,
 
   } else {
     ScopedObjectAccessUnchecked soa(self);
+    mirror::Class* path_class = nullptr;
+    if (FindClassInPathClassLoader(soa, self, descriptor, class_loader, &path_class)) {
+      if (path_class != nullptr || self->IsExceptionPending()) {
+        return path_class;
+      }
+      // None of the class loaders has the class. Let ClassLoader.loadClass throw the
+      // ClassNotFoundException, with the message and suppressed exceptions of libcore.
+    }
     ScopedLocalRef<jobject> class_loader_object(soa.Env(),
                                                 soa.AddLocalReference<jobject>(class_loader.get()));
     std::string class_name_string(DescriptorToDot(descriptor));
@@ -1422,6 +1482,102 @@ mirror::Class* ClassLinker::FindClass(Thread* self, const char* descriptor,
   return NULL;
 }
 
+bool ClassLinker::FindClassInPathClassLoader(const ScopedObjectAccessUnchecked& soa, Thread* self,
+                                             const char* descriptor,
+                                             const SirtRef<mirror::ClassLoader>& class_loader,
+                                             mirror::Class** result) {
+  mirror::Class* class_loader_class = class_loader->GetClass();
+  if (class_loader_class ==
+      soa.Decode<mirror::Class*>(WellKnownClasses::java_lang_BootClassLoader)) {
+    // BootClassLoader.findClass defines the class from the boot class path.
+    mirror::Class* klass = LookupClass(descriptor, nullptr);
+    if (klass != nullptr) {
+      *result = EnsureResolved(self, klass);
+      return true;
+    }
+    DexFile::ClassPathEntry pair = DexFile::FindInClassPath(descriptor, boot_class_path_);
+    if (pair.second != nullptr) {
+      SirtRef<mirror::ClassLoader> boot_class_loader(self, nullptr);
+      *result = DefineClass(descriptor, boot_class_loader, *pair.first, *pair.second);
+    } else {
+      *result = nullptr;
+    }
+    return true;
+  }
+  // Subclasses may override loadClass or findClass.
+  if (class_loader_class !=
+          soa.Decode<mirror::Class*>(WellKnownClasses::dalvik_system_PathClassLoader) &&
+      class_loader_class !=
+          soa.Decode<mirror::Class*>(WellKnownClasses::dalvik_system_DexClassLoader)) {
+    return false;
+  }
+  // findLoadedClass, then the parent, then findClass. Nothing is defined before the whole chain
+  // is known to be understood.
+  mirror::Class* klass = LookupClass(descriptor, class_loader.get());
+  if (klass != nullptr) {
+    *result = EnsureResolved(self, klass);
+    return true;
+  }
+  mirror::Object* parent = soa.DecodeField(
+      WellKnownClasses::java_lang_ClassLoader_parent)->GetObject(class_loader.get());
+  if (parent == nullptr) {
+    return false;
+  }
+  SirtRef<mirror::ClassLoader> parent_class_loader(self, down_cast<mirror::ClassLoader*>(parent));
+  if (!FindClassInPathClassLoader(soa, self, descriptor, parent_class_loader, result)) {
+    return false;
+  }
+  if (*result != nullptr || self->IsExceptionPending()) {
+    return true;
+  }
+  // BaseDexClassLoader.findClass searches the dex files of its DexPathList in order.
+  mirror::Object* path_list = soa.DecodeField(
+      WellKnownClasses::dalvik_system_BaseDexClassLoader_pathList)->GetObject(class_loader.get());
+  if (path_list == nullptr) {
+    return false;
+  }
+  mirror::Object* dex_elements = soa.DecodeField(
+      WellKnownClasses::dalvik_system_DexPathList_dexElements)->GetObject(path_list);
+  if (dex_elements == nullptr) {
+    return false;
+  }
+  mirror::ArtField* dex_file_field =
+      soa.DecodeField(WellKnownClasses::dalvik_system_DexPathList$Element_dexFile);
+  mirror::ArtField* cookie_field = soa.DecodeField(WellKnownClasses::dalvik_system_DexFile_cookie);
+  mirror::ObjectArray<mirror::Object>* elements = dex_elements->AsObjectArray<mirror::Object>();
+  for (int32_t i = 0; i < elements->GetLength(); ++i) {
+    mirror::Object* element = elements->Get(i);
+    if (element == nullptr) {
+      return false;
+    }
+    // Resource only elements have no dex file, closed dex files no cookie.
+    mirror::Object* dex_file_object = dex_file_field->GetObject(element);
+    if (dex_file_object == nullptr) {
+      continue;
+    }
+    const DexFile* dex_file = reinterpret_cast<const DexFile*>(
+        static_cast<uintptr_t>(cookie_field->GetLong(dex_file_object)));
+    if (dex_file == nullptr) {
+      continue;
+    }
+    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor);
+    if (dex_class_def == nullptr) {
+      continue;
+    }
+    RegisterDexFile(*dex_file);
+    *result = DefineClass(descriptor, class_loader, *dex_file, *dex_class_def);
+    if (*result == nullptr) {
+      // DexPathList.findClass goes on with the next dex file and reports the failure as
+      // suppressed by its ClassNotFoundException, leave that to the Java code.
+      self->ClearException();
+      return false;
+    }
+    return true;
+  }
+  *result = nullptr;
+  return true;
+}
+
 mirror::Class* ClassLinker::DefineClass(const char* descriptor,
                                         const SirtRef<mirror::ClassLoader>& class_loader,
                                         const DexFile& dex_file,
@@ -2061,6 +2217,11 @@ mirror::ArtMethod* ClassLinker::LoadMethod(Thread* self, const DexFile& dex_file
       }
     }
   }
+  if (UNLIKELY((access_flags & kAccNative) != 0)) {
+    // Select the reduced JNI transitions the compiled stub was generated for.
+    access_flags |= dex_file.GetNativeMethodOptimizationFlags(
+        dex_file.GetClassDef(klass->GetDexClassDefIndex()), dex_method_idx, access_flags);
+  }
   dst->SetAccessFlags(access_flags);
 
   self->EndAssertNoThreadSuspension(old_cause);
@@ -2109,7 +2270,6 @@ void ClassLinker::RegisterDexFileLocked(const DexFile& dex_file,
   dex_caches_.insert(std::make_pair(&dex_file, dex_cache.get()));
   dex_cache->SetDexFile(&dex_file);
   if (log_new_dex_caches_roots_) {
-    // TODO: This is not safe if we can remove dex caches.
     new_dex_cache_roots_.push_back(&dex_file);
   }
 }
@@ -2389,8 +2549,7 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
     LOG(INFO) << "Loaded class " << descriptor << source;
   }
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  mirror::Class* existing =
-      LookupClassFromTableLocked(descriptor, klass->GetClassLoader(), hash);
+  mirror::Class* existing = class_table_.Lookup(descriptor, klass->GetClassLoader(), hash);
   if (existing != NULL) {
     return existing;
   }
@@ -2403,35 +2562,167 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
     }
   }
   VerifyObject(klass);
-  class_table_.insert(std::make_pair(hash, klass));
+  class_table_.Insert(klass, hash);
   if (log_new_class_table_roots_) {
     new_class_roots_.push_back(std::make_pair(hash, klass));
   }
+  mirror::ClassLoader* class_loader = klass->GetClassLoader();
+  if (class_loader != NULL) {
+    AddClassLoaderClass(class_loader, klass);
+  }
   return NULL;
 }
 
-bool ClassLinker::RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader) {
-  size_t hash = Hash(descriptor);
+void ClassLinker::AddClassLoaderClass(mirror::ClassLoader* class_loader, mirror::Class* klass) {
+  auto it = class_loader_classes_.find(class_loader);
+  if (it == class_loader_classes_.end()) {
+    it = class_loader_classes_.insert(std::make_pair(class_loader, ClassLoaderClasses())).first;
+    it->second.defined_while_disallowed = !allow_new_class_loaders_;
+  }
+  // A class which then fails to link is removed from the class table but stays here, it is
+  // unloaded with its class loader.
+  it->second.classes.push_back(klass);
+  mirror::DexCache* dex_cache = klass->GetDexCache();
+  if (dex_cache != NULL) {
+    it->second.dex_files.insert(dex_cache->GetDexFile());
+  }
+}
+
+void ClassLinker::VisitClassLoaderClasses(mirror::ClassLoader* class_loader,
+                                          RootCallback* callback, void* arg) {
+  ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  auto it = class_loader_classes_.find(class_loader);
+  if (it == class_loader_classes_.end()) {
+    return;
+  }
+  for (mirror::Class*& klass : it->second.classes) {
+    callback(reinterpret_cast<mirror::Object**>(&klass), arg, 0, kRootStickyClass);
+  }
+}
+
+void ClassLinker::GetClassLoaders(std::vector<mirror::ClassLoader*>* class_loaders) {
+  ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  for (const auto& entry : class_loader_classes_) {
+    class_loaders->push_back(entry.first);
+  }
+}
+
+void ClassLinker::SweepClassLoaders(IsMarkedCallback* callback, void* arg) {
+  Thread* self = Thread::Current();
+  std::set<mirror::ClassLoader*> dead_class_loaders;
+  std::set<const DexFile*> dead_dex_files;
+  size_t num_unloaded_classes = 0;
+  {
+    WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
+    std::map<mirror::ClassLoader*, ClassLoaderClasses> moved;
+    for (auto it = class_loader_classes_.begin(); it != class_loader_classes_.end(); ) {
+      ClassLoaderClasses& entry = it->second;
+      mirror::Object* class_loader = callback(it->first, arg);
+      if (class_loader == nullptr && !entry.defined_while_disallowed) {
+        // Nothing references the class loader, its classes or their instances: the classes
+        // reference their class loader. Free their native data, the class table forgets them.
+        dead_class_loaders.insert(it->first);
+        dead_dex_files.insert(entry.dex_files.begin(), entry.dex_files.end());
+        for (mirror::Class* klass : entry.classes) {
+          klass->DeleteMemberIndex();
+        }
+        num_unloaded_classes += entry.classes.size();
+        class_loader_classes_.erase(it++);
+        continue;
+      }
+      for (mirror::Class*& klass : entry.classes) {
+        // The classes defined after the marking aren't marked, they are left as they are.
+        mirror::Object* new_klass = callback(klass, arg);
+        if (new_klass != nullptr) {
+          klass = down_cast<mirror::Class*>(new_klass);
+        }
+      }
+      if (class_loader != nullptr && class_loader != it->first) {
+        ClassLoaderClasses& moved_entry = moved[down_cast<mirror::ClassLoader*>(class_loader)];
+        moved_entry.classes.swap(entry.classes);
+        moved_entry.dex_files.swap(entry.dex_files);
+        moved_entry.defined_while_disallowed = entry.defined_while_disallowed;
+        class_loader_classes_.erase(it++);
+        continue;
+      }
+      ++it;
+    }
+    class_loader_classes_.insert(moved.begin(), moved.end());
+    if (dead_class_loaders.empty()) {
+      return;
+    }
+    class_table_.RemoveClassesOf(dead_class_loaders);
+    for (size_t i = 0; i < kFindArrayCacheSize; ++i) {
+      mirror::Class* array_class = find_array_class_cache_[i];
+      if (array_class != nullptr &&
+          dead_class_loaders.find(array_class->GetClassLoader()) != dead_class_loaders.end()) {
+        find_array_class_cache_[i] = nullptr;
+      }
+    }
+    // A dex file may also be used by a class loader which is still alive.
+    for (const auto& entry : class_loader_classes_) {
+      for (const DexFile* dex_file : entry.second.dex_files) {
+        dead_dex_files.erase(dex_file);
+      }
+    }
+  }
+  VLOG(class_linker) << "Unloaded " << num_unloaded_classes << " classes of "
+                     << dead_class_loaders.size() << " class loaders";
+  std::vector<const DexFile*> closed_dex_files;
+  {
+    WriterMutexLock mu(self, dex_lock_);
+    for (const DexFile* dex_file : dead_dex_files) {
+      auto it = dex_caches_.find(dex_file);
+      // The dex cache may still be referenced from elsewhere, it then stays registered.
+      if (it == dex_caches_.end() || callback(it->second, arg) != nullptr) {
+        continue;
+      }
+      dex_caches_.erase(it);
+      if (closed_dex_files_.erase(dex_file) != 0) {
+        closed_dex_files.push_back(dex_file);
+      }
+    }
+  }
+  STLDeleteElements(&closed_dex_files);
+}
+
+void ClassLinker::DisallowNewClassLoaders() {
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end(); it != end && it->first == hash;
-       ++it) {
-    mirror::Class* klass = it->second;
-    ClassHelper kh(klass);
-    if ((klass->GetClassLoader() == class_loader) &&
-        (strcmp(descriptor, kh.GetDescriptor()) == 0)) {
-      class_table_.erase(it);
-      return true;
+  allow_new_class_loaders_ = false;
+}
+
+void ClassLinker::AllowNewClassLoaders() {
+  WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  allow_new_class_loaders_ = true;
+  for (auto& entry : class_loader_classes_) {
+    entry.second.defined_while_disallowed = false;
+  }
+}
+
+void ClassLinker::CloseDexFile(const DexFile* dex_file) {
+  {
+    WriterMutexLock mu(Thread::Current(), dex_lock_);
+    if (IsDexFileRegisteredLocked(*dex_file)) {
+      // Classes may still be defined from it, it is deleted once they are unloaded.
+      closed_dex_files_.insert(dex_file);
+      return;
     }
   }
-  return false;
+  delete dex_file;
+}
+
+bool ClassLinker::RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader) {
+  size_t hash = Hash(descriptor);
+  WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  return class_table_.Remove(descriptor, class_loader, hash);
 }
 
 mirror::Class* ClassLinker::LookupClass(const char* descriptor,
                                         const mirror::ClassLoader* class_loader) {
   size_t hash = Hash(descriptor);
   {
-    ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    mirror::Class* result = LookupClassFromTableLocked(descriptor, class_loader, hash);
+    // The class table lookup is lock free.
+    mirror::Class* result = class_table_.Lookup(descriptor, class_loader, hash);
     if (result != NULL) {
       return result;
     }
@@ -2456,32 +2747,6 @@ mirror::Class* ClassLinker::LookupClass(const char* descriptor,
   }
 }
 
-mirror::Class* ClassLinker::LookupClassFromTableLocked(const char* descriptor,
-                                                       const mirror::ClassLoader* class_loader,
-                                                       size_t hash) {
-  auto end = class_table_.end();
-  for (auto it = class_table_.lower_bound(hash); it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    ClassHelper kh(klass);
-    if ((klass->GetClassLoader() == class_loader) &&
-        (strcmp(descriptor, kh.GetDescriptor()) == 0)) {
-      if (kIsDebugBuild) {
-        // Check for duplicates in the table.
-        for (++it; it != end && it->first == hash; ++it) {
-          mirror::Class* klass2 = it->second;
-          ClassHelper kh(klass2);
-          CHECK(!((klass2->GetClassLoader() == class_loader) &&
-                  (strcmp(descriptor, kh.GetDescriptor()) == 0)))
-              << PrettyClass(klass) << " " << klass << " " << klass->GetClassLoader() << " "
-              << PrettyClass(klass2) << " " << klass2 << " " << klass2->GetClassLoader();
-        }
-      }
-      return klass;
-    }
-  }
-  return NULL;
-}
-
 static mirror::ObjectArray<mirror::DexCache>* GetImageDexCaches()
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   gc::space::ImageSpace* image = Runtime::Current()->GetHeap()->GetImageSpace();
@@ -2509,12 +2774,12 @@ void ClassLinker::MoveImageClassesToClassTable() {
         DCHECK(klass->GetClassLoader() == NULL);
         const char* descriptor = kh.GetDescriptor();
         size_t hash = Hash(descriptor);
-        mirror::Class* existing = LookupClassFromTableLocked(descriptor, NULL, hash);
+        mirror::Class* existing = class_table_.Lookup(descriptor, NULL, hash);
         if (existing != NULL) {
           CHECK(existing == klass) << PrettyClassAndClassLoader(existing) << " != "
               << PrettyClassAndClassLoader(klass);
         } else {
-          class_table_.insert(std::make_pair(hash, klass));
+          class_table_.Insert(klass, hash);
           if (log_new_class_table_roots_) {
             new_class_roots_.push_back(std::make_pair(hash, klass));
           }
@@ -2534,18 +2799,14 @@ mirror::Class* ClassLinker::LookupClassFromImage(const char* descriptor) {
   for (int32_t i = 0; i < dex_caches->GetLength(); ++i) {
     mirror::DexCache* dex_cache = dex_caches->Get(i);
     const DexFile* dex_file = dex_cache->GetDexFile();
-    // Try binary searching the string/type index.
-    const DexFile::StringId* string_id = dex_file->FindStringId(descriptor);
-    if (string_id != NULL) {
-      const DexFile::TypeId* type_id =
-          dex_file->FindTypeId(dex_file->GetIndexForStringId(*string_id));
-      if (type_id != NULL) {
-        uint16_t type_idx = dex_file->GetIndexForTypeId(*type_id);
-        mirror::Class* klass = dex_cache->GetResolvedType(type_idx);
-        if (klass != NULL) {
-          self->EndAssertNoThreadSuspension(old_no_suspend_cause);
-          return klass;
-        }
+    // Try the type index of the dex file.
+    const DexFile::TypeId* type_id = dex_file->FindTypeId(descriptor);
+    if (type_id != NULL) {
+      uint16_t type_idx = dex_file->GetIndexForTypeId(*type_id);
+      mirror::Class* klass = dex_cache->GetResolvedType(type_idx);
+      if (klass != NULL) {
+        self->EndAssertNoThreadSuspension(old_no_suspend_cause);
+        return klass;
       }
     }
   }
@@ -2560,14 +2821,7 @@ void ClassLinker::LookupClasses(const char* descriptor, std::vector<mirror::Clas
   }
   size_t hash = Hash(descriptor);
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end();
-      it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    ClassHelper kh(klass);
-    if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
-      result.push_back(klass);
-    }
-  }
+  class_table_.LookupAll(descriptor, hash, &result);
 }
 
 void ClassLinker::VerifyClass(const SirtRef<mirror::Class>& klass) {
@@ -2649,13 +2903,27 @@ void ClassLinker::VerifyClass(const SirtRef<mirror::Class>& klass) {
   }
   verifier::MethodVerifier::FailureKind verifier_failure = verifier::MethodVerifier::kNoFailure;
   std::string error_msg;
-  if (!preverified) {
+  bool has_failures = false;
+  bool verified_using_dependencies =
+      !preverified &&
+      oat_file_class_status == mirror::Class::kStatusRetryVerificationAtRuntime &&
+      VerifyClassUsingDependencies(dex_file, klass.get(), &has_failures);
+  if (verified_using_dependencies) {
+    // The classes the compile time verification depended on are unchanged, the soft failures
+    // it found are handled by slow paths.
+    VLOG(class_linker) << "Skipping runtime verification of " << PrettyDescriptor(klass.get())
+        << " whose compile time dependencies are unchanged";
+    if (has_failures) {
+      verifier_failure = verifier::MethodVerifier::kSoftFailure;
+    }
+  } else if (!preverified) {
     verifier_failure = verifier::MethodVerifier::VerifyClass(klass.get(),
                                                              Runtime::Current()->IsCompiler(),
                                                              &error_msg);
   }
   if (preverified || verifier_failure != verifier::MethodVerifier::kHardFailure) {
-    if (!preverified && verifier_failure != verifier::MethodVerifier::kNoFailure) {
+    if (!preverified && !verified_using_dependencies &&
+        verifier_failure != verifier::MethodVerifier::kNoFailure) {
       VLOG(class_linker) << "Soft verification failure in class " << PrettyDescriptor(klass.get())
           << " in " << klass->GetDexCache()->GetLocation()->ToModifiedUtf8()
           << " because: " << error_msg;
@@ -2704,6 +2972,32 @@ void ClassLinker::VerifyClass(const SirtRef<mirror::Class>& klass) {
   }
 }
 
+bool ClassLinker::VerifyClassUsingDependencies(const DexFile& dex_file, mirror::Class* klass,
+                                               bool* has_failures) {
+  // The dependencies are checked against the classes of the runtime class path only.
+  if (Runtime::Current()->IsCompiler()) {
+    return false;
+  }
+  const OatFile* oat_file = FindOpenedOatFileForDexFile(dex_file);
+  if (oat_file == NULL) {
+    return false;
+  }
+  uint dex_location_checksum = dex_file.GetLocationChecksum();
+  const OatFile::OatDexFile* oat_dex_file = oat_file->GetOatDexFile(dex_file.GetLocation().c_str(),
+                                                                    &dex_location_checksum);
+  if (oat_dex_file == NULL) {
+    return false;
+  }
+  const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(klass->GetDexClassDefIndex());
+  if (oat_class.GetVerifierDepsSize() == 0) {
+    return false;
+  }
+  SirtRef<mirror::ClassLoader> class_loader(Thread::Current(), klass->GetClassLoader());
+  return verifier::VerifierDeps::Check(dex_file, oat_class.GetVerifierDeps(),
+                                       oat_class.GetVerifierDepsSize(), class_loader,
+                                       has_failures);
+}
+
 bool ClassLinker::VerifyClassUsingOatFile(const DexFile& dex_file, mirror::Class* klass,
                                           mirror::Class::Status& oat_file_class_status) {
   // If we're compiling, we can only verify the class using the oat file if
@@ -2892,8 +3186,9 @@ mirror::Class* ClassLinker::CreateProxyClass(ScopedObjectAccess& soa, jstring na
   }
 
   // Create virtual method using specified prototypes.
-  size_t num_virtual_methods =
-      soa.Decode<mirror::ObjectArray<mirror::ArtMethod>*>(methods)->GetLength();
+  SirtRef<mirror::ObjectArray<mirror::ArtMethod> > prototypes(
+      self, soa.Decode<mirror::ObjectArray<mirror::ArtMethod>*>(methods));
+  size_t num_virtual_methods = prototypes->GetLength();
   {
     mirror::ObjectArray<mirror::ArtMethod>* virtuals = AllocArtMethodArray(self, num_virtual_methods);
     if (UNLIKELY(virtuals == NULL)) {
@@ -2902,10 +3197,9 @@ mirror::Class* ClassLinker::CreateProxyClass(ScopedObjectAccess& soa, jstring na
     }
     klass->SetVirtualMethods(virtuals);
   }
+  SirtRef<mirror::ArtMethod> prototype(self, nullptr);
   for (size_t i = 0; i < num_virtual_methods; ++i) {
-    mirror::ObjectArray<mirror::ArtMethod>* decoded_methods =
-        soa.Decode<mirror::ObjectArray<mirror::ArtMethod>*>(methods);
-    SirtRef<mirror::ArtMethod> prototype(self, decoded_methods->Get(i));
+    prototype.reset(prototypes->Get(i));
     mirror::ArtMethod* clone = CreateProxyMethod(self, klass, prototype);
     if (UNLIKELY(clone == NULL)) {
       CHECK(self->IsExceptionPending());  // OOME.
@@ -2938,9 +3232,7 @@ mirror::Class* ClassLinker::CreateProxyClass(ScopedObjectAccess& soa, jstring na
     CHECK(klass->GetIFields() == NULL);
     CheckProxyConstructor(klass->GetDirectMethod(0));
     for (size_t i = 0; i < num_virtual_methods; ++i) {
-      mirror::ObjectArray<mirror::ArtMethod>* decoded_methods =
-          soa.Decode<mirror::ObjectArray<mirror::ArtMethod>*>(methods);
-      SirtRef<mirror::ArtMethod> prototype(self, decoded_methods->Get(i));
+      prototype.reset(prototypes->Get(i));
       CheckProxyMethod(klass->GetVirtualMethod(i), prototype);
     }
 
@@ -3286,6 +3578,43 @@ bool ClassLinker::InitializeClass(const SirtRef<mirror::Class>& klass, bool can_
   return success;
 }
 
+bool ClassLinker::InitializeClassUsingOatFile(const SirtRef<mirror::Class>& klass) {
+  if (klass->IsInitialized()) {
+    return true;
+  }
+  if (Runtime::Current()->IsCompiler() || !klass->IsVerified()) {
+    return false;
+  }
+  // dex2oat records kStatusInitialized for the classes of an app that it could initialize without
+  // running code: no <clinit>, no encoded static values and initialized super classes. Check
+  // again as the super classes may not be initialized yet in this process.
+  const DexFile& dex_file = *klass->GetDexCache()->GetDexFile();
+  mirror::Class::Status oat_file_class_status(mirror::Class::kStatusNotReady);
+  VerifyClassUsingOatFile(dex_file, klass.get(), oat_file_class_status);
+  if (oat_file_class_status != mirror::Class::kStatusInitialized ||
+      !CanWeInitializeClass(klass.get(), false, false)) {
+    return false;
+  }
+  Thread* self = Thread::Current();
+  ObjectLock<mirror::Class> lock(self, &klass);
+  if (klass->GetStatus() != mirror::Class::kStatusVerified) {
+    // Another thread is initializing the class or did already.
+    return klass->IsInitialized();
+  }
+  if (!ValidateSuperClassDescriptors(klass)) {
+    // Leave throwing the error to InitializeClass.
+    self->ClearException();
+    return false;
+  }
+  ++Runtime::Current()->GetStats()->class_init_count;
+  ++self->GetStats()->class_init_count;
+  klass->SetStatus(mirror::Class::kStatusInitialized, self);
+  VLOG(class_linker) << "Initialized class " << PrettyDescriptor(klass.get())
+      << " using the oat file";
+  FixupStaticTrampolines(klass.get());
+  return true;
+}
+
 bool ClassLinker::WaitForInitializeClass(const SirtRef<mirror::Class>& klass, Thread* self,
                                          ObjectLock<mirror::Class>& lock)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -3504,6 +3833,9 @@ bool ClassLinker::LinkSuperClass(const SirtRef<mirror::Class>& klass) {
   if (reference_flags != 0) {
     klass->SetAccessFlags(klass->GetAccessFlags() | reference_flags);
   }
+  if (super->IsClassLoaderClass()) {
+    klass->SetAccessFlags(klass->GetAccessFlags() | kAccClassIsClassLoader);
+  }
   // Disallow custom direct subclasses of java.lang.ref.Reference.
   if (init_done_ && super == GetClassRoot(kJavaLangRefReference)) {
     ThrowLinkageError(klass.get(),
@@ -3557,12 +3889,21 @@ bool ClassLinker::LinkVirtualMethods(const SirtRef<mirror::Class>& klass) {
       CHECK(self->IsExceptionPending());  // OOME.
       return false;
     }
+    std::vector<size_t> name_hashes;
+    name_hashes.reserve(max_count);
+    for (size_t j = 0; j < actual_count; ++j) {
+      name_hashes.push_back(MethodNameHash(vtable->Get(j)));
+    }
     // See if any of our virtual methods override the superclass.
     for (size_t i = 0; i < klass->NumVirtualMethods(); ++i) {
       mirror::ArtMethod* local_method = klass->GetVirtualMethodDuringLinking(i);
       MethodHelper local_mh(local_method);
+      const size_t local_name_hash = MethodNameHash(local_method);
       size_t j = 0;
       for (; j < actual_count; ++j) {
+        if (name_hashes[j] != local_name_hash) {
+          continue;
+        }
         mirror::ArtMethod* super_method = vtable->Get(j);
         MethodHelper super_mh(super_method);
         if (local_mh.HasSameNameAndSignature(&super_mh)) {
@@ -3587,6 +3928,7 @@ bool ClassLinker::LinkVirtualMethods(const SirtRef<mirror::Class>& klass) {
         // Not overriding, append.
         vtable->Set<false>(actual_count, local_method);
         local_method->SetMethodIndex(actual_count);
+        name_hashes.push_back(local_name_hash);
         actual_count += 1;
       }
     }
@@ -3629,8 +3971,11 @@ bool ClassLinker::LinkVirtualMethods(const SirtRef<mirror::Class>& klass) {
 
 bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
                                        const SirtRef<mirror::ObjectArray<mirror::Class> >& interfaces) {
-  // Set the imt table to be all conflicts by default.
-  klass->SetImTable(Runtime::Current()->GetDefaultImt());
+  // Set the imt to be all conflicts by default.
+  mirror::ArtMethod* imt_conflict_method = Runtime::Current()->GetImtConflictMethod();
+  for (size_t i = 0; i < kImtSize; i++) {
+    klass->SetEmbeddedImTableEntry(i, imt_conflict_method);
+  }
   size_t super_ifcount;
   if (klass->HasSuperClass()) {
     super_ifcount = klass->GetSuperClass()->GetIfTableCount();
@@ -3745,14 +4090,13 @@ bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
   if (klass->IsInterface()) {
     return true;
   }
-  // Allocate imtable
-  bool imtable_changed = false;
-  SirtRef<mirror::ObjectArray<mirror::ArtMethod> > imtable(self, AllocArtMethodArray(self, kImtSize));
-  if (UNLIKELY(imtable.get() == NULL)) {
-    CHECK(self->IsExceptionPending());  // OOME.
-    return false;
-  }
+  // The interface methods of each imt entry paired with their implementation, null for miranda
+  // methods. Methods don't move.
+  std::vector<mirror::ArtMethod*> imt_methods[kImtSize];
   std::vector<mirror::ArtMethod*> miranda_list;
+  std::vector<size_t> miranda_name_hashes;
+  // The vtable doesn't change until the miranda methods are appended, hash its names once.
+  std::vector<size_t> vtable_name_hashes;
   for (size_t i = 0; i < ifcount; ++i) {
     size_t num_methods = iftable->GetInterface(i)->NumVirtualMethods();
     if (num_methods > 0) {
@@ -3765,9 +4109,16 @@ bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
       iftable->SetMethodArray(i, method_array.get());
       SirtRef<mirror::ObjectArray<mirror::ArtMethod> > vtable(self,
                                                               klass->GetVTableDuringLinking());
+      if (vtable_name_hashes.empty()) {
+        vtable_name_hashes.reserve(vtable->GetLength());
+        for (int32_t k = 0; k < vtable->GetLength(); ++k) {
+          vtable_name_hashes.push_back(MethodNameHash(vtable->Get(k)));
+        }
+      }
       for (size_t j = 0; j < num_methods; ++j) {
         mirror::ArtMethod* interface_method = iftable->GetInterface(i)->GetVirtualMethod(j);
         MethodHelper interface_mh(interface_method);
+        const size_t interface_name_hash = MethodNameHash(interface_method);
         int32_t k;
         // For each method listed in the interface's method list, find the
         // matching method in our class's method list.  We want to favor the
@@ -3778,6 +4129,9 @@ bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
         // those don't end up in the virtual method table, so it shouldn't
         // matter which direction we go.  We walk it backward anyway.)
         for (k = vtable->GetLength() - 1; k >= 0; --k) {
+          if (vtable_name_hashes[k] != interface_name_hash) {
+            continue;
+          }
           mirror::ArtMethod* vtable_method = vtable->Get(k);
           MethodHelper vtable_mh(vtable_method);
           if (interface_mh.HasSameNameAndSignature(&vtable_mh)) {
@@ -3789,20 +4143,18 @@ bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
               return false;
             }
             method_array->Set<false>(j, vtable_method);
-            // Place method in imt if entry is empty, place conflict otherwise.
             uint32_t imt_index = interface_method->GetDexMethodIndex() % kImtSize;
-            if (imtable->Get(imt_index) == NULL) {
-              imtable->Set<false>(imt_index, vtable_method);
-              imtable_changed = true;
-            } else {
-              imtable->Set<false>(imt_index, Runtime::Current()->GetImtConflictMethod());
-            }
+            imt_methods[imt_index].push_back(interface_method);
+            imt_methods[imt_index].push_back(vtable_method);
             break;
           }
         }
         if (k < 0) {
           SirtRef<mirror::ArtMethod> miranda_method(self, NULL);
           for (size_t mir = 0; mir < miranda_list.size(); mir++) {
+            if (miranda_name_hashes[mir] != interface_name_hash) {
+              continue;
+            }
             mirror::ArtMethod* mir_method = miranda_list[mir];
             MethodHelper vtable_mh(mir_method);
             if (interface_mh.HasSameNameAndSignature(&vtable_mh)) {
@@ -3819,21 +4171,22 @@ bool ClassLinker::LinkInterfaceMethods(const SirtRef<mirror::Class>& klass,
             }
             // TODO: If a methods move then the miranda_list may hold stale references.
             miranda_list.push_back(miranda_method.get());
+            miranda_name_hashes.push_back(interface_name_hash);
           }
           method_array->Set<false>(j, miranda_method.get());
+          // Calls of the miranda method go through the runtime, which throws.
+          uint32_t imt_index = interface_method->GetDexMethodIndex() % kImtSize;
+          imt_methods[imt_index].push_back(interface_method);
+          imt_methods[imt_index].push_back(nullptr);
         }
       }
     }
   }
-  if (imtable_changed) {
-    // Fill in empty entries in interface method table with conflict.
-    mirror::ArtMethod* imt_conflict_method = Runtime::Current()->GetImtConflictMethod();
-    for (size_t i = 0; i < kImtSize; i++) {
-      if (imtable->Get(i) == NULL) {
-        imtable->Set<false>(i, imt_conflict_method);
-      }
+  for (size_t i = 0; i < kImtSize; i++) {
+    if (!FillImtEntry(self, klass, i, imt_methods[i])) {
+      CHECK(self->IsExceptionPending());  // OOME.
+      return false;
     }
-    klass->SetImTable(imtable.get());
   }
   if (!miranda_list.empty()) {
     int old_method_count = klass->NumVirtualMethods();
@@ -3887,6 +4240,43 @@ bool ClassLinker::LinkInstanceFields(const SirtRef<mirror::Class>& klass) {
   return LinkFields(klass, false);
 }
 
+bool ClassLinker::FillImtEntry(Thread* self, const SirtRef<mirror::Class>& klass,
+                               uint32_t imt_index, const std::vector<mirror::ArtMethod*>& methods) {
+  if (methods.size() == 2 && methods[1] != nullptr) {
+    // A single interface method, call its implementation directly.
+    klass->SetEmbeddedImTableEntry(imt_index, methods[1]);
+    return true;
+  }
+  size_t num_implemented = 0;
+  for (size_t i = 1; i < methods.size(); i += 2) {
+    if (methods[i] != nullptr) {
+      num_implemented++;
+    }
+  }
+  if (methods.size() == 2 || num_implemented == 0) {
+    // Leave the conflict method of the runtime, which calls into the runtime.
+    return true;
+  }
+  // Several interface methods share the entry, give it a conflict method with their table.
+  SirtRef<mirror::ArtMethod> conflict_method(self, Runtime::Current()->CreateImtConflictMethod());
+  if (UNLIKELY(conflict_method.get() == nullptr)) {
+    return false;
+  }
+  mirror::ObjectArray<mirror::ArtMethod>* table = AllocArtMethodArray(self, 2 * num_implemented);
+  if (UNLIKELY(table == nullptr)) {
+    return false;
+  }
+  for (size_t i = 0, j = 0; i < methods.size(); i += 2) {
+    if (methods[i + 1] != nullptr) {
+      table->Set<false>(j++, methods[i]);
+      table->Set<false>(j++, methods[i + 1]);
+    }
+  }
+  conflict_method->SetImtConflictTable(table);
+  klass->SetEmbeddedImTableEntry(imt_index, conflict_method.get());
+  return true;
+}
+
 bool ClassLinker::LinkStaticFields(const SirtRef<mirror::Class>& klass) {
   CHECK(klass.get() != NULL);
   size_t allocated_class_size = klass->GetClassSize();
@@ -3895,33 +4285,116 @@ bool ClassLinker::LinkStaticFields(const SirtRef<mirror::Class>& klass) {
   return success;
 }
 
+void ClassLinker::SetHotFields(const std::map<std::string, std::vector<std::string>>& hot_fields,
+                               const std::vector<const DexFile*>& dex_files) {
+  CHECK(Runtime::Current()->IsCompiler());
+  hot_fields_ = hot_fields;
+  hot_field_dex_files_.insert(dex_files.begin(), dex_files.end());
+}
+
+void ClassLinker::GetHotFieldIndices(const DexFile& dex_file, uint16_t class_def_idx,
+                                     std::vector<uint32_t>* field_indices) const {
+  if (hot_field_dex_files_.find(&dex_file) == hot_field_dex_files_.end()) {
+    return;
+  }
+  const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_idx);
+  auto it = hot_fields_.find(dex_file.GetClassDescriptor(class_def));
+  const byte* class_data = dex_file.GetClassData(class_def);
+  if (it == hot_fields_.end() || class_data == nullptr) {
+    return;
+  }
+  ClassDataItemIterator field_it(dex_file, class_data);
+  while (field_it.HasNextStaticField()) {
+    field_it.Next();
+  }
+  SafeMap<std::string, uint32_t> instance_fields;
+  for (; field_it.HasNextInstanceField(); field_it.Next()) {
+    uint32_t field_idx = field_it.GetMemberIndex();
+    instance_fields.Put(dex_file.GetFieldName(dex_file.GetFieldId(field_idx)), field_idx);
+  }
+  for (const std::string& name : it->second) {
+    auto field = instance_fields.find(name);
+    if (field != instance_fields.end()) {
+      field_indices->push_back(field->second);
+    }
+  }
+}
+
+void ClassLinker::GetHotFieldsForLinking(const SirtRef<mirror::Class>& klass,
+                                         std::vector<uint32_t>* field_indices) {
+  // The classes of the boot class path have the layout of their mirror classes.
+  if (klass->GetClassLoader() == nullptr || klass->GetDexCache() == nullptr) {
+    return;
+  }
+  const DexFile& dex_file = *klass->GetDexCache()->GetDexFile();
+  uint16_t class_def_idx = klass->GetDexClassDefIndex();
+  if (hot_field_dex_files_.find(&dex_file) != hot_field_dex_files_.end()) {
+    GetHotFieldIndices(dex_file, class_def_idx, field_indices);
+    return;
+  }
+  // Compiled code has the offsets of the fields, lay them out as the compiler did.
+  const OatFile* oat_file = FindOpenedOatFileForDexFile(dex_file);
+  if (oat_file == nullptr) {
+    return;
+  }
+  uint32_t dex_location_checksum = dex_file.GetLocationChecksum();
+  const OatFile::OatDexFile* oat_dex_file = oat_file->GetOatDexFile(dex_file.GetLocation().c_str(),
+                                                                    &dex_location_checksum);
+  if (oat_dex_file == nullptr) {
+    return;
+  }
+  const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_idx);
+  field_indices->assign(oat_class.GetHotFields(),
+                        oat_class.GetHotFields() + oat_class.GetHotFieldsSize());
+}
+
+// Orders the fields to assign offsets. Reference fields come first, since the GC scans them as
+// one block, then 64-bit and finally 32-bit fields. Hot fields are placed together in the
+// middle: the hot reference fields end the reference fields and the hot primitive fields, in the
+// order of the profile, start the primitive fields.
 struct LinkFieldsComparator {
-  explicit LinkFieldsComparator() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  explicit LinkFieldsComparator(const SafeMap<uint32_t, size_t>& hot_field_ranks)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : hot_field_ranks_(hot_field_ranks) {
   }
   // No thread safety analysis as will be called from STL. Checked lock held in constructor.
   bool operator()(mirror::ArtField* field1, mirror::ArtField* field2)
       NO_THREAD_SAFETY_ANALYSIS {
-    // First come reference fields, then 64-bit, and finally 32-bit
     FieldHelper fh1(field1);
     Primitive::Type type1 = fh1.GetTypeAsPrimitiveType();
     FieldHelper fh2(field2);
     Primitive::Type type2 = fh2.GetTypeAsPrimitiveType();
-    if (type1 != type2) {
-      bool is_primitive1 = type1 != Primitive::kPrimNot;
-      bool is_primitive2 = type2 != Primitive::kPrimNot;
-      bool is64bit1 = is_primitive1 && (type1 == Primitive::kPrimLong || type1 == Primitive::kPrimDouble);
-      bool is64bit2 = is_primitive2 && (type2 == Primitive::kPrimLong || type2 == Primitive::kPrimDouble);
-      int order1 = !is_primitive1 ? 0 : (is64bit1 ? 1 : 2);
-      int order2 = !is_primitive2 ? 0 : (is64bit2 ? 1 : 2);
-      if (order1 != order2) {
-        return order1 < order2;
-      }
+    auto hot1 = hot_field_ranks_.find(field1->GetDexFieldIndex());
+    auto hot2 = hot_field_ranks_.find(field2->GetDexFieldIndex());
+    bool is_hot1 = hot1 != hot_field_ranks_.end();
+    bool is_hot2 = hot2 != hot_field_ranks_.end();
+    int order1 = GetOrder(type1, is_hot1);
+    int order2 = GetOrder(type2, is_hot2);
+    if (order1 != order2) {
+      return order1 < order2;
+    }
+    // Hot fields of the same group are sorted by hotness.
+    if (is_hot1) {
+      return hot1->second < hot2->second;
     }
     // same basic group? then sort by string.
     const char* name1 = fh1.GetName();
     const char* name2 = fh2.GetName();
     return strcmp(name1, name2) < 0;
   }
+
+ private:
+  static int GetOrder(Primitive::Type type, bool is_hot) {
+    if (type == Primitive::kPrimNot) {
+      return is_hot ? 1 : 0;
+    }
+    if (is_hot) {
+      return 2;
+    }
+    return (type == Primitive::kPrimLong || type == Primitive::kPrimDouble) ? 3 : 4;
+  }
+
+  const SafeMap<uint32_t, size_t>& hot_field_ranks_;
 };
 
 bool ClassLinker::LinkFields(const SirtRef<mirror::Class>& klass, bool is_static) {
@@ -3948,6 +4421,15 @@ bool ClassLinker::LinkFields(const SirtRef<mirror::Class>& klass, bool is_static
 
   CHECK_EQ(num_fields == 0, fields == NULL);
 
+  SafeMap<uint32_t, size_t> hot_field_ranks;
+  if (!is_static && num_fields != 0) {
+    std::vector<uint32_t> hot_fields;
+    GetHotFieldsForLinking(klass, &hot_fields);
+    for (size_t i = 0; i < hot_fields.size(); ++i) {
+      hot_field_ranks.Put(hot_fields[i], i);
+    }
+  }
+
   // we want a relatively stable order so that adding new fields
   // minimizes disruption of C++ version such as Class and Method.
   std::deque<mirror::ArtField*> grouped_and_sorted_fields;
@@ -3957,7 +4439,7 @@ bool ClassLinker::LinkFields(const SirtRef<mirror::Class>& klass, bool is_static
     grouped_and_sorted_fields.push_back(f);
   }
   std::sort(grouped_and_sorted_fields.begin(), grouped_and_sorted_fields.end(),
-            LinkFieldsComparator());
+            LinkFieldsComparator(hot_field_ranks));
 
   // References should be at the front.
   size_t current_field = 0;
@@ -3979,41 +4461,37 @@ bool ClassLinker::LinkFields(const SirtRef<mirror::Class>& klass, bool is_static
 
   // Now we want to pack all of the double-wide fields together.  If
   // we're not aligned, though, we want to shuffle one 32-bit field
-  // into place.  If we can't find one, we'll have to pad it.
-  if (current_field != num_fields && !IsAligned<8>(field_offset.Uint32Value())) {
-    for (size_t i = 0; i < grouped_and_sorted_fields.size(); i++) {
-      mirror::ArtField* field = grouped_and_sorted_fields[i];
-      FieldHelper fh(field);
-      Primitive::Type type = fh.GetTypeAsPrimitiveType();
-      CHECK(type != Primitive::kPrimNot);  // should only be working on primitive types
-      if (type == Primitive::kPrimLong || type == Primitive::kPrimDouble) {
-        continue;
-      }
-      fields->Set<false>(current_field++, field);
-      field->SetOffset(field_offset);
-      // drop the consumed field
-      grouped_and_sorted_fields.erase(grouped_and_sorted_fields.begin() + i);
-      break;
-    }
-    // whether we found a 32-bit field for padding or not, we advance
-    field_offset = MemberOffset(field_offset.Uint32Value() + sizeof(uint32_t));
-  }
-
-  // Alignment is good, shuffle any double-wide fields forward, and
-  // finish assigning field offsets to all fields.
-  DCHECK(current_field == num_fields || IsAligned<8>(field_offset.Uint32Value()));
+  // into place.  If we can't find one, we'll have to pad it. Hot
+  // fields may interleave double-wide and 32-bit fields, so this is
+  // done for every double-wide field.
   while (!grouped_and_sorted_fields.empty()) {
     mirror::ArtField* field = grouped_and_sorted_fields.front();
-    grouped_and_sorted_fields.pop_front();
     FieldHelper fh(field);
     Primitive::Type type = fh.GetTypeAsPrimitiveType();
     CHECK(type != Primitive::kPrimNot);  // should only be working on primitive types
+    bool is_wide = type == Primitive::kPrimLong || type == Primitive::kPrimDouble;
+    if (is_wide && !IsAligned<8>(field_offset.Uint32Value())) {
+      for (size_t i = 1; i < grouped_and_sorted_fields.size(); i++) {
+        mirror::ArtField* padding_field = grouped_and_sorted_fields[i];
+        Primitive::Type padding_type = FieldHelper(padding_field).GetTypeAsPrimitiveType();
+        if (padding_type == Primitive::kPrimLong || padding_type == Primitive::kPrimDouble) {
+          continue;
+        }
+        fields->Set<false>(current_field++, padding_field);
+        padding_field->SetOffset(field_offset);
+        // drop the consumed field
+        grouped_and_sorted_fields.erase(grouped_and_sorted_fields.begin() + i);
+        break;
+      }
+      // whether we found a 32-bit field for padding or not, we advance
+      field_offset = MemberOffset(field_offset.Uint32Value() + sizeof(uint32_t));
+    }
+    DCHECK(!is_wide || IsAligned<8>(field_offset.Uint32Value()));
+    grouped_and_sorted_fields.pop_front();
     fields->Set<false>(current_field, field);
     field->SetOffset(field_offset);
     field_offset = MemberOffset(field_offset.Uint32Value() +
-                                ((type == Primitive::kPrimLong || type == Primitive::kPrimDouble)
-                                 ? sizeof(uint64_t)
-                                 : sizeof(uint32_t)));
+                                (is_wide ? sizeof(uint64_t) : sizeof(uint32_t)));
     current_field++;
   }
 
@@ -4410,6 +4888,11 @@ const char* ClassLinker::MethodShorty(uint32_t method_idx, mirror::ArtMethod* re
   return dex_file.GetMethodShorty(method_id, length);
 }
 
+static bool AppendClassVisitor(mirror::Class* c, void* arg) {
+  reinterpret_cast<std::vector<mirror::Class*>*>(arg)->push_back(c);
+  return true;
+}
+
 void ClassLinker::DumpAllClasses(int flags) {
   if (dex_cache_image_class_lookup_required_) {
     MoveImageClassesToClassTable();
@@ -4419,9 +4902,7 @@ void ClassLinker::DumpAllClasses(int flags) {
   std::vector<mirror::Class*> all_classes;
   {
     ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-      all_classes.push_back(it.second);
-    }
+    class_table_.VisitClasses(AppendClassVisitor, &all_classes);
   }
 
   for (size_t i = 0; i < all_classes.size(); ++i) {
@@ -4434,7 +4915,22 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  os << "Loaded classes: " << class_table_.size() << " allocated classes\n";
+  os << "Loaded classes: " << class_table_.Size() << " allocated classes\n";
+  size_t zygote_slots_size;
+  const void* zygote_slots = class_table_.GetZygoteSlots(&zygote_slots_size);
+  if (zygote_slots != nullptr && !Runtime::Current()->IsZygote()) {
+    os << "Zygote class table: "
+       << DescribePrivatePages(zygote_slots, zygote_slots_size) << "\n";
+  }
+}
+
+void ClassLinker::PreZygoteFork() {
+  // Move the image classes too, rather than have every child move them.
+  if (dex_cache_image_class_lookup_required_) {
+    MoveImageClassesToClassTable();
+  }
+  WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  class_table_.PreZygoteFork();
 }
 
 size_t ClassLinker::NumLoadedClasses() {
@@ -4442,7 +4938,7 @@ size_t ClassLinker::NumLoadedClasses() {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  return class_table_.size();
+  return class_table_.Size();
 }
 
 pid_t ClassLinker::GetClassesLockOwner() {
@@ -18,12 +18,14 @@
 #define ART_RUNTIME_CLASS_LINKER_H_
 
 #include <string>
+#include <set>
 #include <utility>
 #include <vector>
 #include <map>
 
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_table.h"
 #include "dex_file.h"
 #include "gtest/gtest.h"
 #include "jni.h"
@@ -48,6 +50,7 @@ namespace mirror {
 class InternTable;
 template<class T> class ObjectLock;
 class ScopedObjectAccess;
+class ScopedObjectAccessUnchecked;
 template<class T> class SirtRef;
 
 typedef bool (ClassVisitor)(mirror::Class* c, void* arg);
@@ -56,10 +59,8 @@ enum VisitRootFlags : uint8_t;
 
 class ClassLinker {
  public:
-  // Interface method table size. Increasing this value reduces the chance of two interface methods
-  // colliding in the interface method table but increases the size of classes that implement
-  // (non-marker) interfaces.
-  static constexpr size_t kImtSize = 64;
+  // Interface method table size, the imt is embedded in the classes.
+  static constexpr size_t kImtSize = mirror::Class::kImtSize;
 
   explicit ClassLinker(InternTable* intern_table);
   ~ClassLinker();
@@ -110,8 +111,8 @@ class ClassLinker {
 
   mirror::Class* FindPrimitiveClass(char type) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // General class unloading is not supported, this is used to prune
-  // unwanted classes during image writing.
+  // Used to prune unwanted classes during image writing. The classes of unreachable class
+  // loaders are unloaded by SweepClassLoaders.
   bool RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader)
       LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -124,6 +125,11 @@ class ClassLinker {
       LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Moves the classes loaded by the zygote to a table that its children only read.
+  void PreZygoteFork()
+      LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   size_t NumLoadedClasses()
       LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -248,6 +254,32 @@ class ClassLinker {
   void VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags)
       LOCKS_EXCLUDED(Locks::classlinker_classes_lock_, dex_lock_);
 
+  // With kVisitRootFlagClassUnloading the classes defined by class loaders other than the boot
+  // class loader aren't roots, the collector visits them when it marks their class loader.
+  void VisitClassLoaderClasses(mirror::ClassLoader* class_loader, RootCallback* callback,
+                               void* arg)
+      LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Appends the class loaders which defined classes to class_loaders.
+  void GetClassLoaders(std::vector<mirror::ClassLoader*>* class_loaders)
+      LOCKS_EXCLUDED(Locks::classlinker_classes_lock_);
+
+  // Unloads the classes of the class loaders which aren't marked, and the dex caches only they
+  // used, and updates the class loaders and classes which moved. Swept with the system weaks.
+  void SweepClassLoaders(IsMarkedCallback* callback, void* arg)
+      LOCKS_EXCLUDED(Locks::classlinker_classes_lock_, dex_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // A class loader which defines its first class while the system weaks are disallowed may not
+  // have been marked by the collection in progress, it isn't swept until they are allowed again.
+  void DisallowNewClassLoaders() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_);
+  void AllowNewClassLoaders() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_);
+
+  // Deletes a dex file closed by its DexFile object, or defers it until its classes are
+  // unloaded if it is registered.
+  void CloseDexFile(const DexFile* dex_file) LOCKS_EXCLUDED(dex_lock_);
+
   mirror::DexCache* FindDexCache(const DexFile& dex_file) const
       LOCKS_EXCLUDED(dex_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -317,9 +349,19 @@ class ClassLinker {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void VerifyClass(const SirtRef<mirror::Class>& klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Initializes a verified class without running code if the oat file says that its
+  // initialization has no effect besides its status. Returns whether the class is initialized.
+  bool InitializeClassUsingOatFile(const SirtRef<mirror::Class>& klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool VerifyClassUsingOatFile(const DexFile& dex_file, mirror::Class* klass,
                                mirror::Class::Status& oat_file_class_status)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Whether the classes the compile time verification of a class with status
+  // kStatusRetryVerificationAtRuntime depended on are unchanged, so that the class doesn't need
+  // to be verified again. Sets has_failures if its methods had soft failures.
+  bool VerifyClassUsingDependencies(const DexFile& dex_file, mirror::Class* klass,
+                                    bool* has_failures)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void ResolveClassExceptionHandlerTypes(const DexFile& dex_file,
                                          const SirtRef<mirror::Class>& klass)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -379,6 +421,17 @@ class ClassLinker {
     return intern_table_;
   }
 
+  // Looks up a class the way ClassLoader.loadClass does, without calling into Java, when
+  // class_loader and its parents are PathClassLoaders and DexClassLoaders ending with the boot
+  // class loader. Returns false if the chain has any other class loader. Otherwise sets result
+  // to the class, or to null with an exception pending if it failed to load, or to null if no
+  // class loader of the chain has it.
+  bool FindClassInPathClassLoader(const ScopedObjectAccessUnchecked& soa, Thread* self,
+                                  const char* descriptor,
+                                  const SirtRef<mirror::ClassLoader>& class_loader,
+                                  mirror::Class** result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Attempts to insert a class into a class table.  Returns NULL if
   // the class was inserted, otherwise returns an existing class with
   // the same descriptor and ClassLoader.
@@ -389,6 +442,17 @@ class ClassLinker {
   // Special code to allocate an art method, use this instead of class->AllocObject.
   mirror::ArtMethod* AllocArtMethod(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Sets the names of the hot instance fields of classes by class descriptor, hottest first, as
+  // read from a profile. LinkFields lays them out together in the classes of dex_files, which
+  // must not be loaded yet. Used by the compiler, the oat file records the layout it chose.
+  void SetHotFields(const std::map<std::string, std::vector<std::string>>& hot_fields,
+                    const std::vector<const DexFile*>& dex_files);
+
+  // Appends the field indices of the hot instance fields set by SetHotFields for the class,
+  // hottest first.
+  void GetHotFieldIndices(const DexFile& dex_file, uint16_t class_def_idx,
+                          std::vector<uint32_t>* field_indices) const;
+
  private:
   const OatFile::OatMethod GetOatMethodFor(mirror::ArtMethod* method)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -506,12 +570,23 @@ class ClassLinker {
                             const SirtRef<mirror::ObjectArray<mirror::Class> >& interfaces)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Sets entry imt_index of the imt of klass given the interface methods of the entry paired with
+  // their implementations. Returns false if an exception is pending.
+  bool FillImtEntry(Thread* self, const SirtRef<mirror::Class>& klass, uint32_t imt_index,
+                    const std::vector<mirror::ArtMethod*>& methods)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   bool LinkStaticFields(const SirtRef<mirror::Class>& klass)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool LinkInstanceFields(const SirtRef<mirror::Class>& klass)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool LinkFields(const SirtRef<mirror::Class>& klass, bool is_static)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // The hot instance fields of a class, from SetHotFields when compiling and from the oat file
+  // otherwise.
+  void GetHotFieldsForLinking(const SirtRef<mirror::Class>& klass,
+                              std::vector<uint32_t>* field_indices)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
 
   void CreateReferenceInstanceOffsets(const SirtRef<mirror::Class>& klass)
@@ -562,25 +637,43 @@ class ClassLinker {
   std::map<const DexFile*, mirror::DexCache*> dex_caches_ GUARDED_BY(dex_lock_);
   std::vector<const OatFile*> oat_files_ GUARDED_BY(dex_lock_);
 
+  // The hot instance fields by class descriptor and the dex files whose classes use them, see
+  // SetHotFields.
+  std::map<std::string, std::vector<std::string>> hot_fields_;
+  std::set<const DexFile*> hot_field_dex_files_;
+
 
-  // multimap from a string hash code of a class descriptor to
-  // mirror::Class* instances. Results should be compared for a matching
-  // Class::descriptor_ and Class::class_loader_.
-  typedef std::multimap<size_t, mirror::Class*> Table;
-  Table class_table_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  // The loaded classes by descriptor hash. Lookups don't lock, changes need the
+  // classlinker_classes_lock_ held exclusively.
+  ClassTable class_table_;
   std::vector<std::pair<size_t, mirror::Class*> > new_class_roots_;
 
+  // The classes defined by a class loader other than the boot class loader, and the dex files
+  // they were defined from, see VisitClassLoaderClasses and SweepClassLoaders.
+  struct ClassLoaderClasses {
+    ClassLoaderClasses() : defined_while_disallowed(false) {}
+
+    std::vector<mirror::Class*> classes;
+    std::set<const DexFile*> dex_files;
+    // The first class was defined after DisallowNewClassLoaders.
+    bool defined_while_disallowed;
+  };
+  void AddClassLoaderClass(mirror::ClassLoader* class_loader, mirror::Class* klass)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  std::map<mirror::ClassLoader*, ClassLoaderClasses> class_loader_classes_
+      GUARDED_BY(Locks::classlinker_classes_lock_);
+  bool allow_new_class_loaders_ GUARDED_BY(Locks::classlinker_classes_lock_);
+
+  // Registered dex files whose DexFile object was closed, deleted once they are unregistered.
+  std::set<const DexFile*> closed_dex_files_ GUARDED_BY(dex_lock_);
+
   // Do we need to search dex caches to find image classes?
   bool dex_cache_image_class_lookup_required_;
   // Number of times we've searched dex caches for a class. After a certain number of misses we move
   // the classes into the class_table_ to avoid dex cache based searches.
   AtomicInteger failed_dex_cache_class_lookups_;
 
-  mirror::Class* LookupClassFromTableLocked(const char* descriptor,
-                                            const mirror::ClassLoader* class_loader,
-                                            size_t hash)
-      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
-
   void MoveImageClassesToClassTable() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::Class* LookupClassFromImage(const char* descriptor)
@@ -985,6 +985,12 @@ TEST_F(ClassLinkerTest, Interfaces) {
   EXPECT_TRUE(J->IsAssignableFrom(K));
   EXPECT_TRUE(K->IsAssignableFrom(B));
   EXPECT_TRUE(J->IsAssignableFrom(B));
+  // Checked again with the last interface found cached.
+  EXPECT_TRUE(J->IsAssignableFrom(B));
+  EXPECT_TRUE(K->IsAssignableFrom(B));
+  EXPECT_FALSE(K->IsAssignableFrom(A));
+  EXPECT_TRUE(J->IsAssignableFrom(A));
+  EXPECT_FALSE(I->IsAssignableFrom(B));
 
   const Signature void_sig = I->GetDexCache()->GetDexFile()->CreateSignature("()V");
   mirror::ArtMethod* Ii = I->FindVirtualMethod("i", void_sig);
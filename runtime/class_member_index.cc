@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_member_index.h"
+
+#include "mirror/art_field-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+
+namespace art {
+
+static size_t NumMembers(mirror::Class* klass, ClassMemberIndex::Kind kind)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  switch (kind) {
+    case ClassMemberIndex::kDirectMethods:
+      return klass->NumDirectMethods();
+    case ClassMemberIndex::kVirtualMethods:
+      return klass->NumVirtualMethods();
+    case ClassMemberIndex::kInstanceFields:
+      return klass->NumInstanceFields();
+    case ClassMemberIndex::kStaticFields:
+      return klass->NumStaticFields();
+    default:
+      LOG(FATAL) << "Unexpected member kind " << kind;
+      return 0;
+  }
+}
+
+bool ClassMemberIndex::ShouldIndex(mirror::Class* klass, Kind kind) {
+  return NumMembers(klass, kind) >= kMinIndexedMembers;
+}
+
+ClassMemberIndex::ClassMemberIndex(mirror::Class* klass) {
+  DCHECK(klass->IsResolved());
+  for (size_t kind = 0; kind < kNumKinds; ++kind) {
+    indexed_[kind] = ShouldIndex(klass, static_cast<Kind>(kind));
+  }
+  MethodHelper mh;
+  for (Kind kind : { kDirectMethods, kVirtualMethods }) {
+    if (!indexed_[kind]) {
+      continue;
+    }
+    for (size_t i = 0, e = NumMembers(klass, kind); i < e; ++i) {
+      mirror::ArtMethod* method =
+          (kind == kDirectMethods) ? klass->GetDirectMethod(i) : klass->GetVirtualMethod(i);
+      mh.ChangeMethod(method);
+      // Equal keys are inserted after the existing ones, keeping declaration order.
+      by_name_[kind].insert(std::make_pair(StringPiece(mh.GetName()), i));
+      if (by_dex_index_[kind].find(method->GetDexMethodIndex()) == by_dex_index_[kind].end()) {
+        by_dex_index_[kind].Put(method->GetDexMethodIndex(), i);
+      }
+    }
+  }
+  FieldHelper fh;
+  for (Kind kind : { kInstanceFields, kStaticFields }) {
+    if (!indexed_[kind]) {
+      continue;
+    }
+    for (size_t i = 0, e = NumMembers(klass, kind); i < e; ++i) {
+      mirror::ArtField* field =
+          (kind == kInstanceFields) ? klass->GetInstanceField(i) : klass->GetStaticField(i);
+      fh.ChangeField(field);
+      by_name_[kind].insert(std::make_pair(StringPiece(fh.GetName()), i));
+      if (by_dex_index_[kind].find(field->GetDexFieldIndex()) == by_dex_index_[kind].end()) {
+        by_dex_index_[kind].Put(field->GetDexFieldIndex(), i);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_MEMBER_INDEX_H_
+#define ART_RUNTIME_CLASS_MEMBER_INDEX_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <utility>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/stringpiece.h"
+#include "safe_map.h"
+
+namespace art {
+
+namespace mirror {
+  class Class;
+}  // namespace mirror
+
+// The positions of the members of a resolved class by name and by dex member index, so that
+// looking up a member of a class with many members, such as generated protocol buffer or RPC
+// classes, doesn't compare the name of every member. Overloaded methods share a name, their
+// positions are kept in declaration order so that lookups find the same member as a linear
+// search.
+//
+// An index is built the first time a member of a class with many members is looked up, see
+// mirror::Class::GetMemberIndex, and lives as long as the class. The names point into the dex
+// files, which outlive the classes.
+class ClassMemberIndex {
+ public:
+  enum Kind {
+    kDirectMethods,
+    kVirtualMethods,
+    kInstanceFields,
+    kStaticFields,
+    kNumKinds,
+  };
+
+  typedef std::multimap<StringPiece, uint32_t>::const_iterator NameIterator;
+
+  // Members of a kind are indexed when the class has at least this many of them, fewer are
+  // searched linearly.
+  static constexpr size_t kMinIndexedMembers = 32;
+
+  explicit ClassMemberIndex(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether the class has enough members of the kind to index them.
+  static bool ShouldIndex(mirror::Class* klass, Kind kind)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  bool IsIndexed(Kind kind) const {
+    return indexed_[kind];
+  }
+
+  // The positions of the members of the kind named name.
+  std::pair<NameIterator, NameIterator> LookupName(Kind kind, const StringPiece& name) const {
+    DCHECK(IsIndexed(kind));
+    return by_name_[kind].equal_range(name);
+  }
+
+  // The position of the member of the kind with the dex member index, -1 if there is none.
+  int32_t LookupDexIndex(Kind kind, uint32_t dex_member_idx) const {
+    DCHECK(IsIndexed(kind));
+    auto it = by_dex_index_[kind].find(dex_member_idx);
+    return (it != by_dex_index_[kind].end()) ? static_cast<int32_t>(it->second) : -1;
+  }
+
+ private:
+  bool indexed_[kNumKinds];
+  std::multimap<StringPiece, uint32_t> by_name_[kNumKinds];
+  SafeMap<uint32_t, uint32_t> by_dex_index_[kNumKinds];
+
+  DISALLOW_COPY_AND_ASSIGN(ClassMemberIndex);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_MEMBER_INDEX_H_
@@ -0,0 +1,385 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include "atomic.h"
+#include "base/stl_util.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "object_utils.h"
+#include "utils.h"
+
+namespace art {
+
+mirror::Class* const ClassTable::kRemovedClass = reinterpret_cast<mirror::Class*>(1);
+
+ClassTable::Storage::Storage(size_t capacity)
+    : mask_(capacity - 1), slots_(new Slot[capacity]) {
+  DCHECK(IsPowerOfTwo(capacity));
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].hash_ = 0;
+    slots_[i].klass_ = nullptr;
+  }
+}
+
+ClassTable::Storage::~Storage() {
+  delete[] slots_;
+}
+
+ClassTable::ClassTable()
+    : storage_(new Storage(kInitialCapacity)), num_classes_(0), num_removed_(0),
+      zygote_storage_(nullptr), num_zygote_classes_(0),
+      image_slots_(nullptr), image_mask_(0), num_image_classes_(0) {
+}
+
+ClassTable::~ClassTable() {
+  delete storage_;
+  delete zygote_storage_;
+  STLDeleteElements(&retired_storage_);
+}
+
+bool ClassTable::Matches(mirror::Class* klass, const char* descriptor,
+                         const mirror::ClassLoader* class_loader) {
+  if (klass->GetClassLoader() != class_loader) {
+    return false;
+  }
+  ClassHelper kh(klass);
+  return strcmp(descriptor, kh.GetDescriptor()) == 0;
+}
+
+void ClassTable::BuildImageSlots(const std::vector<std::pair<size_t, uint32_t>>& classes,
+                                 std::vector<ImageSlot>* slots) {
+  // The table is never written to, it can be at most half full.
+  size_t capacity = kInitialCapacity;
+  while (classes.size() * 2 > capacity) {
+    capacity *= 2;
+  }
+  const size_t mask = capacity - 1;
+  ImageSlot empty_slot = { 0, 0 };
+  slots->assign(capacity, empty_slot);
+  for (const std::pair<size_t, uint32_t>& entry : classes) {
+    const uint32_t hash = static_cast<uint32_t>(entry.first);
+    size_t i = FirstImageSlot(hash, mask);
+    while ((*slots)[i].klass_ != 0) {
+      i = (i + 1) & mask;
+    }
+    CHECK_NE(entry.second, 0U);
+    (*slots)[i].hash_ = hash;
+    (*slots)[i].klass_ = entry.second;
+  }
+}
+
+void ClassTable::SetImageSlots(const ImageSlot* slots, size_t num_slots) {
+  CHECK(IsPowerOfTwo(num_slots)) << num_slots;
+  image_slots_ = slots;
+  image_mask_ = num_slots - 1;
+  num_image_classes_ = 0;
+  for (size_t i = 0; i < num_slots; ++i) {
+    if (slots[i].klass_ != 0) {
+      ++num_image_classes_;
+    }
+  }
+}
+
+mirror::Class* ClassTable::LookupImage(const char* descriptor, size_t hash) const {
+  const uint32_t image_hash = static_cast<uint32_t>(hash);
+  for (size_t i = FirstImageSlot(image_hash, image_mask_); ; i = (i + 1) & image_mask_) {
+    const ImageSlot& slot = image_slots_[i];
+    if (slot.klass_ == 0) {
+      return nullptr;
+    }
+    if (slot.hash_ == image_hash) {
+      mirror::Class* klass = ImageSlotClass(slot);
+      if (Matches(klass, descriptor, nullptr)) {
+        return klass;
+      }
+    }
+  }
+}
+
+mirror::Class* ClassTable::Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                                  size_t hash) const {
+  if (class_loader == nullptr && image_slots_ != nullptr) {
+    // The image classes are all boot classes.
+    mirror::Class* klass = LookupImage(descriptor, hash);
+    if (klass != nullptr) {
+      return klass;
+    }
+  }
+  if (zygote_storage_ != nullptr) {
+    mirror::Class* klass = LookupInStorage(zygote_storage_, descriptor, class_loader, hash);
+    if (klass != nullptr) {
+      return klass;
+    }
+  }
+  // The loads below depend on the storage address, no barrier is needed to see its slots.
+  return LookupInStorage(storage_, descriptor, class_loader, hash);
+}
+
+mirror::Class* ClassTable::LookupInStorage(const Storage* storage, const char* descriptor,
+                                           const mirror::ClassLoader* class_loader,
+                                           size_t hash) {
+  for (size_t i = FirstSlot(hash, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    const Slot& slot = storage->slots_[i];
+    mirror::Class* klass = slot.klass_;
+    if (klass == nullptr) {
+      return nullptr;
+    }
+    // A stale hash read while the slot is being filled only makes us miss the class being
+    // inserted, as if the lookup had come first.
+    if (klass != kRemovedClass && slot.hash_ == hash &&
+        Matches(klass, descriptor, class_loader)) {
+      return klass;
+    }
+  }
+}
+
+void ClassTable::LookupAll(const char* descriptor, size_t hash,
+                           std::vector<mirror::Class*>* result) const {
+  if (image_slots_ != nullptr) {
+    mirror::Class* klass = LookupImage(descriptor, hash);
+    if (klass != nullptr) {
+      result->push_back(klass);
+    }
+  }
+  if (zygote_storage_ != nullptr) {
+    LookupAllInStorage(zygote_storage_, descriptor, hash, result);
+  }
+  LookupAllInStorage(storage_, descriptor, hash, result);
+}
+
+void ClassTable::LookupAllInStorage(const Storage* storage, const char* descriptor, size_t hash,
+                                    std::vector<mirror::Class*>* result) {
+  for (size_t i = FirstSlot(hash, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    const Slot& slot = storage->slots_[i];
+    mirror::Class* klass = slot.klass_;
+    if (klass == nullptr) {
+      return;
+    }
+    if (klass != kRemovedClass && slot.hash_ == hash) {
+      ClassHelper kh(klass);
+      if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
+        result->push_back(klass);
+      }
+    }
+  }
+}
+
+void ClassTable::Insert(mirror::Class* klass, size_t hash) {
+  DCHECK(klass != nullptr);
+  if (kIsDebugBuild) {
+    ClassHelper kh(klass);
+    CHECK(Lookup(kh.GetDescriptor(), klass->GetClassLoader(), hash) == nullptr)
+        << PrettyClassAndClassLoader(klass);
+  }
+  if ((num_classes_ + num_removed_ + 1) * 100 > (storage_->mask_ + 1) * kMaxLoadPercent) {
+    Rehash(num_classes_ + 1);
+  }
+  Storage* storage = storage_;
+  size_t i = FirstSlot(hash, storage->mask_);
+  // Removed slots are not reused, a concurrent lookup could pair the old hash with the new class.
+  while (storage->slots_[i].klass_ != nullptr) {
+    i = (i + 1) & storage->mask_;
+  }
+  Slot& slot = storage->slots_[i];
+  slot.hash_ = hash;
+  // Publish the hash before the class.
+  QuasiAtomic::MembarStoreStore();
+  slot.klass_ = klass;
+  ++num_classes_;
+}
+
+bool ClassTable::Remove(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) {
+  if (RemoveFromStorage(storage_, descriptor, class_loader, hash)) {
+    --num_classes_;
+    ++num_removed_;
+    return true;
+  }
+  // Dirties a page of the zygote storage, only happens for a class that failed to load.
+  if (zygote_storage_ != nullptr &&
+      RemoveFromStorage(zygote_storage_, descriptor, class_loader, hash)) {
+    --num_zygote_classes_;
+    return true;
+  }
+  return false;
+}
+
+bool ClassTable::RemoveFromStorage(Storage* storage, const char* descriptor,
+                                   const mirror::ClassLoader* class_loader, size_t hash) {
+  for (size_t i = FirstSlot(hash, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    Slot& slot = storage->slots_[i];
+    mirror::Class* klass = slot.klass_;
+    if (klass == nullptr) {
+      return false;
+    }
+    if (klass != kRemovedClass && slot.hash_ == hash &&
+        Matches(klass, descriptor, class_loader)) {
+      slot.klass_ = kRemovedClass;
+      return true;
+    }
+  }
+}
+
+void ClassTable::UpdateClass(size_t hash, mirror::Class* old_class, mirror::Class* new_class) {
+  if (!UpdateClassInStorage(storage_, hash, old_class, new_class) &&
+      zygote_storage_ != nullptr) {
+    UpdateClassInStorage(zygote_storage_, hash, old_class, new_class);
+  }
+}
+
+bool ClassTable::UpdateClassInStorage(Storage* storage, size_t hash, mirror::Class* old_class,
+                                      mirror::Class* new_class) {
+  for (size_t i = FirstSlot(hash, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    Slot& slot = storage->slots_[i];
+    if (slot.klass_ == nullptr) {
+      return false;
+    }
+    if (slot.klass_ == old_class) {
+      slot.klass_ = new_class;
+      return true;
+    }
+  }
+}
+
+bool ClassTable::VisitClasses(bool (*visitor)(mirror::Class*, void*), void* arg) {
+  if (image_slots_ != nullptr) {
+    for (size_t i = 0; i <= image_mask_; ++i) {
+      if (image_slots_[i].klass_ != 0 && !visitor(ImageSlotClass(image_slots_[i]), arg)) {
+        return false;
+      }
+    }
+  }
+  if (zygote_storage_ != nullptr && !VisitClassesInStorage(zygote_storage_, visitor, arg)) {
+    return false;
+  }
+  return VisitClassesInStorage(storage_, visitor, arg);
+}
+
+bool ClassTable::VisitClassesInStorage(const Storage* storage,
+                                       bool (*visitor)(mirror::Class*, void*), void* arg) {
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    mirror::Class* klass = storage->slots_[i].klass_;
+    if (klass != nullptr && klass != kRemovedClass && !visitor(klass, arg)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ClassTable::VisitRoots(RootCallback* callback, void* arg, bool boot_classes_only) {
+  // The image classes are not visited, the image space is never collected nor moved.
+  if (zygote_storage_ != nullptr) {
+    // The zygote classes are in the zygote space, which doesn't move. Only write back a class
+    // that did move so that the GC doesn't dirty the shared slots.
+    for (size_t i = 0; i <= zygote_storage_->mask_; ++i) {
+      Slot& slot = zygote_storage_->slots_[i];
+      mirror::Class* klass = slot.klass_;
+      if (klass != nullptr && klass != kRemovedClass) {
+        mirror::Object* root = klass;
+        callback(&root, arg, 0, kRootStickyClass);
+        if (UNLIKELY(root != klass)) {
+          slot.klass_ = down_cast<mirror::Class*>(root);
+        }
+      }
+    }
+  }
+  Storage* storage = storage_;
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    Slot& slot = storage->slots_[i];
+    mirror::Class* klass = slot.klass_;
+    if (klass != nullptr && klass != kRemovedClass &&
+        (!boot_classes_only || klass->GetClassLoader() == nullptr)) {
+      callback(reinterpret_cast<mirror::Object**>(const_cast<mirror::Class**>(&slot.klass_)), arg,
+               0, kRootStickyClass);
+    }
+  }
+}
+
+size_t ClassTable::RemoveClassesOf(const std::set<mirror::ClassLoader*>& class_loaders) {
+  Storage* storage = storage_;
+  size_t removed = 0;
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    Slot& slot = storage->slots_[i];
+    mirror::Class* klass = slot.klass_;
+    if (klass != nullptr && klass != kRemovedClass &&
+        class_loaders.find(klass->GetClassLoader()) != class_loaders.end()) {
+      // Lookups probe past the removed marker, and can't be looking for the class since its
+      // class loader is unreachable.
+      slot.klass_ = kRemovedClass;
+      ++removed;
+    }
+  }
+  num_classes_ -= removed;
+  num_removed_ += removed;
+  return removed;
+}
+
+void ClassTable::FreeRetiredStorage() {
+  DCHECK(Locks::mutator_lock_->IsExclusiveHeld(Thread::Current()));
+  STLDeleteElements(&retired_storage_);
+}
+
+void ClassTable::PreZygoteFork() {
+  if (zygote_storage_ != nullptr || num_classes_ == 0) {
+    return;
+  }
+  // The zygote and its children insert into new storage from now on, so that the pages of the
+  // zygote storage stay shared.
+  zygote_storage_ = storage_;
+  num_zygote_classes_ = num_classes_;
+  storage_ = new Storage(kInitialCapacity);
+  num_classes_ = 0;
+  num_removed_ = 0;
+}
+
+const void* ClassTable::GetZygoteSlots(size_t* size) const {
+  if (zygote_storage_ == nullptr) {
+    *size = 0;
+    return nullptr;
+  }
+  *size = (zygote_storage_->mask_ + 1) * sizeof(Slot);
+  return zygote_storage_->slots_;
+}
+
+void ClassTable::Rehash(size_t min_classes) {
+  size_t capacity = storage_->mask_ + 1;
+  while (min_classes * 100 > capacity * kMaxLoadPercent / 2) {
+    capacity *= 2;
+  }
+  Storage* old_storage = storage_;
+  Storage* new_storage = new Storage(capacity);
+  for (size_t i = 0; i <= old_storage->mask_; ++i) {
+    const Slot& slot = old_storage->slots_[i];
+    if (slot.klass_ == nullptr || slot.klass_ == kRemovedClass) {
+      continue;
+    }
+    size_t j = FirstSlot(slot.hash_, new_storage->mask_);
+    while (new_storage->slots_[j].klass_ != nullptr) {
+      j = (j + 1) & new_storage->mask_;
+    }
+    new_storage->slots_[j].hash_ = slot.hash_;
+    new_storage->slots_[j].klass_ = slot.klass_;
+  }
+  // Publish the copied slots before the storage.
+  QuasiAtomic::MembarStoreStore();
+  storage_ = new_storage;
+  retired_storage_.push_back(old_storage);
+  num_removed_ = 0;
+}
+
+}  // namespace art
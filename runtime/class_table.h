@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_TABLE_H_
+#define ART_RUNTIME_CLASS_TABLE_H_
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+namespace mirror {
+  class Class;
+  class ClassLoader;
+}  // namespace mirror
+
+// The loaded classes of the class linker, keyed by descriptor hash. An open addressing hash set
+// with linear probing which stores the hashes next to the classes, so that a lookup mostly only
+// touches one or two cache lines and compares the descriptors of the classes with a matching hash.
+//
+// Lookups don't lock. Insertions, removals and root updates are serialized by the caller holding
+// the classlinker_classes_lock_ exclusively. To stay safe for concurrent readers:
+// - a slot is published by storing its hash before its class, and a class is only ever replaced
+//   by the moved copy of itself or by the removed marker;
+// - removed slots are only reclaimed when the table is rehashed into new storage;
+// - the storage replaced by a rehash is kept until FreeRetiredStorage is called during a
+//   collection pause, when no lookup can be running. Removals can make a rehash keep the
+//   capacity, so without this the retired storage would grow with every load and unload cycle.
+//
+// The boot image classes can come in a second, read only table built by the image writer and
+// mapped from the image file, so that they don't need to be inserted one by one at startup.
+//
+// Before the zygote forks, its classes are moved to a third table that is only read afterwards,
+// so that the children share its pages instead of copying them on their first class load.
+class ClassTable {
+ public:
+  // A slot of the image class table. The layout is the same for every target, the hash is the
+  // low 32 bits of the descriptor hash and the class is its image address, zero for an empty slot.
+  struct ImageSlot {
+    uint32_t hash_;
+    uint32_t klass_;
+  };
+
+  ClassTable();
+  ~ClassTable();
+
+  // The hash of a class descriptor that the table is keyed with.
+  static size_t HashDescriptor(const char* descriptor) {
+    // This is the java.lang.String hashcode for convenience, not interoperability.
+    size_t hash = 0;
+    for (; *descriptor != '\0'; ++descriptor) {
+      hash = hash * 31 + *descriptor;
+    }
+    return hash;
+  }
+
+  // Lay out the image class table for the (descriptor hash, image address) pairs of the image
+  // classes.
+  static void BuildImageSlots(const std::vector<std::pair<size_t, uint32_t>>& classes,
+                              std::vector<ImageSlot>* slots);
+
+  // Look up the boot class loader classes in the image class table first. The slots must stay
+  // mapped as long as the table is used. num_slots is a power of two.
+  void SetImageSlots(const ImageSlot* slots, size_t num_slots);
+
+  // Return the class with the descriptor and the class loader, or null. Lock free.
+  mirror::Class* Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Append every class with the descriptor, whatever its class loader, to result.
+  void LookupAll(const char* descriptor, size_t hash, std::vector<mirror::Class*>* result) const
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
+
+  // Add klass, which must not already be in the table.
+  void Insert(mirror::Class* klass, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Remove the class with the descriptor and the class loader, returns false if there is none.
+  bool Remove(const char* descriptor, const mirror::ClassLoader* class_loader, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Replace old_class, which has the given hash, by the moved new_class.
+  void UpdateClass(size_t hash, mirror::Class* old_class, mirror::Class* new_class)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Call the visitor on every class until it returns false. Returns false if it did.
+  bool VisitClasses(bool (*visitor)(mirror::Class*, void*), void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Visit the class slots as roots, the callback may move the classes. When boot_classes_only is
+  // set the classes defined by other class loaders since the zygote forked are skipped, their
+  // class loaders keep them alive in the collections which unload classes.
+  void VisitRoots(RootCallback* callback, void* arg, bool boot_classes_only)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Remove the classes defined by the given class loaders, which are being unloaded. The zygote
+  // classes are always visited as roots so they are never unloaded. Returns the number of classes
+  // removed.
+  size_t RemoveClassesOf(const std::set<mirror::ClassLoader*>& class_loaders)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Free the storage replaced by rehashes. The caller holds the mutator lock exclusively, so no
+  // lookup can still be reading it.
+  void FreeRetiredStorage() EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Move the classes to the zygote table. Only called once, while the zygote is single threaded
+  // before forking, since lookups don't lock.
+  void PreZygoteFork() EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // The slots of the zygote table and their size in bytes, null if there is no zygote table.
+  const void* GetZygoteSlots(size_t* size) const
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // The number of classes, including the image classes.
+  size_t Size() const SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_) {
+    return num_classes_ + num_zygote_classes_ + num_image_classes_;
+  }
+
+  // Initial number of slots, a power of two.
+  static constexpr size_t kInitialCapacity = 1024;
+  // The table is rehashed once the used and removed slots make up this percentage of the slots.
+  static constexpr size_t kMaxLoadPercent = 70;
+
+ private:
+  struct Slot {
+    volatile size_t hash_;
+    // Null for a never used slot, kRemovedClass for a removed one.
+    mirror::Class* volatile klass_;
+  };
+
+  struct Storage {
+    explicit Storage(size_t capacity);
+    ~Storage();
+
+    const size_t mask_;
+    Slot* const slots_;
+
+    DISALLOW_COPY_AND_ASSIGN(Storage);
+  };
+
+  // Marks the removed slots, which lookups probe past.
+  static mirror::Class* const kRemovedClass;
+
+  // The first slot to probe for hash, mixes the high bits in since the descriptor hash is a
+  // polynomial string hash whose low bits alone cluster.
+  static size_t FirstSlot(size_t hash, size_t mask) {
+    return (hash ^ (hash >> 16)) & mask;
+  }
+  // Same for the image slots, which only have the low 32 bits of the hash.
+  static size_t FirstImageSlot(uint32_t hash, size_t mask) {
+    return (hash ^ (hash >> 16)) & mask;
+  }
+
+  static mirror::Class* ImageSlotClass(const ImageSlot& slot) {
+    return reinterpret_cast<mirror::Class*>(static_cast<uintptr_t>(slot.klass_));
+  }
+
+  mirror::Class* LookupImage(const char* descriptor, size_t hash) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The operations on the slots of one storage.
+  static mirror::Class* LookupInStorage(const Storage* storage, const char* descriptor,
+                                        const mirror::ClassLoader* class_loader, size_t hash)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void LookupAllInStorage(const Storage* storage, const char* descriptor, size_t hash,
+                                 std::vector<mirror::Class*>* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool RemoveFromStorage(Storage* storage, const char* descriptor,
+                                const mirror::ClassLoader* class_loader, size_t hash)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool UpdateClassInStorage(Storage* storage, size_t hash, mirror::Class* old_class,
+                                   mirror::Class* new_class);
+  static bool VisitClassesInStorage(const Storage* storage,
+                                    bool (*visitor)(mirror::Class*, void*), void* arg);
+
+  static bool Matches(mirror::Class* klass, const char* descriptor,
+                      const mirror::ClassLoader* class_loader)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Move the classes to new storage with room for at least min_classes classes.
+  void Rehash(size_t min_classes) EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // The storage used by readers, only replaced by Rehash.
+  Storage* volatile storage_;
+  // Storage replaced by Rehash which concurrent lookups may still be reading.
+  std::vector<Storage*> retired_storage_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  size_t num_classes_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  size_t num_removed_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  // The classes of the zygote, set before it forks and never inserted into after.
+  Storage* zygote_storage_;
+  size_t num_zygote_classes_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  // The image class table, set before any lookup and never changed after.
+  const ImageSlot* image_slots_;
+  size_t image_mask_;
+  size_t num_image_classes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_TABLE_H_
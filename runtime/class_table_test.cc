@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include <string>
+#include <vector>
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class ClassTableTest : public CommonRuntimeTest {};
+
+static bool CollectClassVisitor(mirror::Class* c, void* arg) {
+  reinterpret_cast<std::vector<mirror::Class*>*>(arg)->push_back(c);
+  return true;
+}
+
+// Any hash works as long as it is the same for a descriptor.
+static size_t TestHash(const char* descriptor) {
+  size_t hash = 0;
+  for (; *descriptor != '\0'; ++descriptor) {
+    hash = hash * 31 + *descriptor;
+  }
+  return hash;
+}
+
+TEST_F(ClassTableTest, InsertLookupRemove) {
+  ScopedObjectAccess soa(Thread::Current());
+  // The classes loaded so far, usually enough to rehash the table a few times.
+  std::vector<mirror::Class*> classes;
+  class_linker_->NumLoadedClasses();  // Moves the image classes into the class linker table.
+  class_linker_->VisitClasses(CollectClassVisitor, &classes);
+  ASSERT_FALSE(classes.empty());
+  std::vector<std::string> descriptors;
+  for (mirror::Class* klass : classes) {
+    descriptors.push_back(ClassHelper(klass).GetDescriptor());
+  }
+
+  ClassTable table;
+  WriterMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
+  for (size_t i = 0; i < classes.size(); ++i) {
+    const char* descriptor = descriptors[i].c_str();
+    EXPECT_TRUE(table.Lookup(descriptor, classes[i]->GetClassLoader(), TestHash(descriptor)) ==
+                nullptr);
+    table.Insert(classes[i], TestHash(descriptor));
+  }
+  EXPECT_EQ(classes.size(), table.Size());
+  for (size_t i = 0; i < classes.size(); ++i) {
+    const char* descriptor = descriptors[i].c_str();
+    EXPECT_EQ(classes[i], table.Lookup(descriptor, classes[i]->GetClassLoader(),
+                                       TestHash(descriptor)));
+  }
+
+  // Remove every other class, the others must still be found past the removed slots.
+  for (size_t i = 0; i < classes.size(); i += 2) {
+    const char* descriptor = descriptors[i].c_str();
+    EXPECT_TRUE(table.Remove(descriptor, classes[i]->GetClassLoader(), TestHash(descriptor)));
+    EXPECT_FALSE(table.Remove(descriptor, classes[i]->GetClassLoader(), TestHash(descriptor)));
+  }
+  EXPECT_EQ(classes.size() / 2, table.Size());
+  for (size_t i = 0; i < classes.size(); ++i) {
+    const char* descriptor = descriptors[i].c_str();
+    mirror::Class* expected = (i % 2 == 0) ? nullptr : classes[i];
+    EXPECT_EQ(expected, table.Lookup(descriptor, classes[i]->GetClassLoader(),
+                                     TestHash(descriptor)));
+  }
+
+  std::vector<mirror::Class*> visited;
+  EXPECT_TRUE(table.VisitClasses(CollectClassVisitor, &visited));
+  EXPECT_EQ(table.Size(), visited.size());
+}
+
+TEST_F(ClassTableTest, PreZygoteFork) {
+  ScopedObjectAccess soa(Thread::Current());
+  std::vector<mirror::Class*> classes;
+  class_linker_->NumLoadedClasses();  // Moves the image classes into the class linker table.
+  class_linker_->VisitClasses(CollectClassVisitor, &classes);
+  ASSERT_GE(classes.size(), 4U);
+  std::vector<std::string> descriptors;
+  for (mirror::Class* klass : classes) {
+    descriptors.push_back(ClassHelper(klass).GetDescriptor());
+  }
+
+  // The first half of the classes goes to the zygote table, the second half is inserted after.
+  ClassTable table;
+  WriterMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
+  const size_t half = classes.size() / 2;
+  for (size_t i = 0; i < half; ++i) {
+    table.Insert(classes[i], TestHash(descriptors[i].c_str()));
+  }
+  size_t zygote_slots_size;
+  EXPECT_TRUE(table.GetZygoteSlots(&zygote_slots_size) == nullptr);
+  table.PreZygoteFork();
+  EXPECT_TRUE(table.GetZygoteSlots(&zygote_slots_size) != nullptr);
+  EXPECT_NE(0U, zygote_slots_size);
+  for (size_t i = half; i < classes.size(); ++i) {
+    table.Insert(classes[i], TestHash(descriptors[i].c_str()));
+  }
+  EXPECT_EQ(classes.size(), table.Size());
+  for (size_t i = 0; i < classes.size(); ++i) {
+    const char* descriptor = descriptors[i].c_str();
+    EXPECT_EQ(classes[i], table.Lookup(descriptor, classes[i]->GetClassLoader(),
+                                       TestHash(descriptor)));
+  }
+
+  // Removing works on both tables.
+  const char* zygote_descriptor = descriptors[0].c_str();
+  EXPECT_TRUE(table.Remove(zygote_descriptor, classes[0]->GetClassLoader(),
+                           TestHash(zygote_descriptor)));
+  const char* descriptor = descriptors[half].c_str();
+  EXPECT_TRUE(table.Remove(descriptor, classes[half]->GetClassLoader(), TestHash(descriptor)));
+  EXPECT_EQ(classes.size() - 2, table.Size());
+  EXPECT_TRUE(table.Lookup(zygote_descriptor, classes[0]->GetClassLoader(),
+                           TestHash(zygote_descriptor)) == nullptr);
+
+  std::vector<mirror::Class*> visited;
+  EXPECT_TRUE(table.VisitClasses(CollectClassVisitor, &visited));
+  EXPECT_EQ(table.Size(), visited.size());
+}
+
+}  // namespace art
@@ -406,6 +406,16 @@ void ThrowNullPointerExceptionFromDexPC(const ThrowLocation& throw_location) {
       }
       break;
     }
+    case Instruction::INVOKE_SUPER_QUICK:
+    case Instruction::INVOKE_SUPER_RANGE_QUICK: {
+      // The vtable index is the one of the super class of the caller.
+      uint32_t vtable_idx = (instr->Opcode() == Instruction::INVOKE_SUPER_QUICK)
+          ? instr->VRegB_35c() : instr->VRegB_3rc();
+      mirror::Class* super_class = throw_location.GetMethod()->GetDeclaringClass()->GetSuperClass();
+      mirror::ArtMethod* method = super_class->GetVTable()->Get(vtable_idx);
+      ThrowNullPointerExceptionForMethodAccess(throw_location, method, kSuper);
+      break;
+    }
     case Instruction::IGET:
     case Instruction::IGET_WIDE:
     case Instruction::IGET_OBJECT:
@@ -22,6 +22,8 @@
 
 namespace art {
 
+class ThreadPool;
+
 namespace verifier {
 
 class MethodVerifier;
@@ -36,8 +38,20 @@ class CompilerCallbacks {
         SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) = 0;
     virtual void ClassRejected(ClassReference ref) = 0;
 
+    // The thread pool used to verify the methods of classes with a lot of code in parallel while
+    // the compiler verifies a dex file, or nullptr to verify them on the verifying thread.
+    ThreadPool* GetVerificationThreadPool() const {
+      return verification_thread_pool_;
+    }
+    void SetVerificationThreadPool(ThreadPool* thread_pool) {
+      verification_thread_pool_ = thread_pool;
+    }
+
   protected:
-    CompilerCallbacks() { }
+    CompilerCallbacks() : verification_thread_pool_(nullptr) { }
+
+  private:
+    ThreadPool* verification_thread_pool_;
 };
 
 }  // namespace art
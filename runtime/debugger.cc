@@ -108,16 +108,20 @@ struct Breakpoint {
   mirror::ArtMethod* method;
   uint32_t dex_pc;
 
-  // Indicates whether breakpoint needs full deoptimization or selective deoptimization.
-  bool need_full_deoptimization;
+  // The methods that may have inlined the method and are deoptimized along with it.
+  std::vector<mirror::ArtMethod*> inlining_callers;
 
-  Breakpoint(mirror::ArtMethod* method, uint32_t dex_pc, bool need_full_deoptimization)
-    : method(method), dex_pc(dex_pc), need_full_deoptimization(need_full_deoptimization) {}
+  Breakpoint(mirror::ArtMethod* method, uint32_t dex_pc,
+             const std::vector<mirror::ArtMethod*>& inlining_callers)
+    : method(method), dex_pc(dex_pc), inlining_callers(inlining_callers) {}
 
   void VisitRoots(RootCallback* callback, void* arg) {
     if (method != nullptr) {
       callback(reinterpret_cast<mirror::Object**>(&method), arg, 0, kRootDebugger);
     }
+    for (mirror::ArtMethod*& caller : inlining_callers) {
+      callback(reinterpret_cast<mirror::Object**>(&caller), arg, 0, kRootDebugger);
+    }
   }
 };
 
@@ -226,7 +230,6 @@ size_t Dbg::alloc_record_count_ = 0;
 Mutex* Dbg::deoptimization_lock_ = nullptr;
 std::vector<DeoptimizationRequest> Dbg::deoptimization_requests_;
 size_t Dbg::full_deoptimization_event_count_ = 0;
-size_t Dbg::delayed_full_undeoptimization_count_ = 0;
 
 // Breakpoints.
 static std::vector<Breakpoint> gBreakpoints GUARDED_BY(Locks::breakpoint_lock_);
@@ -667,7 +670,6 @@ void Dbg::GoActive() {
     MutexLock mu(Thread::Current(), *deoptimization_lock_);
     CHECK_EQ(deoptimization_requests_.size(), 0U);
     CHECK_EQ(full_deoptimization_event_count_, 0U);
-    CHECK_EQ(delayed_full_undeoptimization_count_, 0U);
   }
 
   Runtime* runtime = Runtime::Current();
@@ -706,7 +708,6 @@ void Dbg::Disconnected() {
       MutexLock mu(Thread::Current(), *deoptimization_lock_);
       deoptimization_requests_.clear();
       full_deoptimization_event_count_ = 0U;
-      delayed_full_undeoptimization_count_ = 0U;
     }
     runtime->GetInstrumentation()->RemoveListener(&gDebugInstrumentationListener, kListenerEvents);
     runtime->GetInstrumentation()->DisableDeoptimization();
@@ -2501,7 +2502,9 @@ JDWP::ObjectId Dbg::GetThisObjectIdForEvent(mirror::Object* this_object) {
 
 void Dbg::PostLocationEvent(mirror::ArtMethod* m, int dex_pc, mirror::Object* this_object,
                             int event_flags, const JValue* return_value) {
-  if (!IsDebuggerActive()) {
+  // Method entry and exit are reported for every method once any event needs them, don't register
+  // the class of the method unless an event of the kind could match.
+  if (!IsDebuggerActive() || !gJdwpState->HasLocationEvents(event_flags)) {
     return;
   }
   DCHECK(m != nullptr);
@@ -2516,7 +2519,7 @@ void Dbg::PostLocationEvent(mirror::ArtMethod* m, int dex_pc, mirror::Object* th
 
 void Dbg::PostFieldAccessEvent(mirror::ArtMethod* m, int dex_pc,
                                mirror::Object* this_object, mirror::ArtField* f) {
-  if (!IsDebuggerActive()) {
+  if (!IsDebuggerActive() || !gJdwpState->HasEvents(JDWP::EK_FIELD_ACCESS)) {
     return;
   }
   DCHECK(m != nullptr);
@@ -2534,7 +2537,7 @@ void Dbg::PostFieldAccessEvent(mirror::ArtMethod* m, int dex_pc,
 void Dbg::PostFieldModificationEvent(mirror::ArtMethod* m, int dex_pc,
                                      mirror::Object* this_object, mirror::ArtField* f,
                                      const JValue* field_value) {
-  if (!IsDebuggerActive()) {
+  if (!IsDebuggerActive() || !gJdwpState->HasEvents(JDWP::EK_FIELD_MODIFICATION)) {
     return;
   }
   DCHECK(m != nullptr);
@@ -2697,27 +2700,6 @@ void Dbg::ProcessDeoptimizationRequest(const DeoptimizationRequest& request) {
   }
 }
 
-void Dbg::DelayFullUndeoptimization() {
-  MutexLock mu(Thread::Current(), *deoptimization_lock_);
-  ++delayed_full_undeoptimization_count_;
-  DCHECK_LE(delayed_full_undeoptimization_count_, full_deoptimization_event_count_);
-}
-
-void Dbg::ProcessDelayedFullUndeoptimizations() {
-  // TODO: avoid taking the lock twice (once here and once in ManageDeoptimization).
-  {
-    MutexLock mu(Thread::Current(), *deoptimization_lock_);
-    while (delayed_full_undeoptimization_count_ > 0) {
-      DeoptimizationRequest req;
-      req.kind = DeoptimizationRequest::kFullUndeoptimization;
-      req.method = nullptr;
-      RequestDeoptimizationLocked(req);
-      --delayed_full_undeoptimization_count_;
-    }
-  }
-  ManageDeoptimization();
-}
-
 void Dbg::RequestDeoptimization(const DeoptimizationRequest& req) {
   if (req.kind == DeoptimizationRequest::kNothing) {
     // Nothing to do.
@@ -2818,6 +2800,93 @@ static bool IsMethodPossiblyInlined(Thread* self, mirror::ArtMethod* m)
   return InlineMethodAnalyser::AnalyseMethodCode(&verifier, nullptr);
 }
 
+// Finds the methods that may have inlined m. The compiler only inlines methods resolved through
+// the method ids of the caller's dex file, so these are the methods of that dex file invoking a
+// method id with the name and signature of m.
+static void FindInliningCallers(mirror::ArtMethod* m, std::vector<mirror::ArtMethod*>* callers)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  struct InliningCallerFinder {
+    InliningCallerFinder(mirror::ArtMethod* m, std::vector<mirror::ArtMethod*>* callers)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+        : method(m), dex_cache(m->GetDeclaringClass()->GetDexCache()), callers(callers) {
+      MethodHelper mh(m);
+      dex_file = &mh.GetDexFile();
+      const DexFile::MethodId& method_id = dex_file->GetMethodId(m->GetDexMethodIndex());
+      name_idx = method_id.name_idx_;
+      proto_idx = method_id.proto_idx_;
+    }
+
+    static bool Visit(mirror::Class* c, void* arg) {
+      return reinterpret_cast<InliningCallerFinder*>(arg)->Visit(c);
+    }
+
+    // TODO: Enable annotalysis. We know lock is held in constructor, but abstraction confuses
+    // annotalysis.
+    bool Visit(mirror::Class* c) NO_THREAD_SAFETY_ANALYSIS {
+      if (c->GetDexCache() != dex_cache || !c->IsResolved()) {
+        return true;
+      }
+      for (size_t i = 0, e = c->NumDirectMethods(); i < e; ++i) {
+        VisitMethod(c->GetDirectMethod(i));
+      }
+      for (size_t i = 0, e = c->NumVirtualMethods(); i < e; ++i) {
+        VisitMethod(c->GetVirtualMethod(i));
+      }
+      return true;
+    }
+
+    void VisitMethod(mirror::ArtMethod* caller) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+      if (caller == method || caller->IsNative() || caller->IsAbstract() ||
+          caller->IsProxyMethod()) {
+        return;
+      }
+      const DexFile::CodeItem* code_item = MethodHelper(caller).GetCodeItem();
+      if (code_item == nullptr) {
+        return;
+      }
+      const Instruction* const end =
+          Instruction::At(code_item->insns_ + code_item->insns_size_in_code_units_);
+      for (const Instruction* inst = Instruction::At(code_item->insns_); inst < end;
+           inst = inst->Next()) {
+        uint32_t method_idx;
+        switch (inst->Opcode()) {
+          case Instruction::INVOKE_VIRTUAL:
+          case Instruction::INVOKE_SUPER:
+          case Instruction::INVOKE_DIRECT:
+          case Instruction::INVOKE_STATIC:
+          case Instruction::INVOKE_INTERFACE:
+            method_idx = inst->VRegB_35c();
+            break;
+          case Instruction::INVOKE_VIRTUAL_RANGE:
+          case Instruction::INVOKE_SUPER_RANGE:
+          case Instruction::INVOKE_DIRECT_RANGE:
+          case Instruction::INVOKE_STATIC_RANGE:
+          case Instruction::INVOKE_INTERFACE_RANGE:
+            method_idx = inst->VRegB_3rc();
+            break;
+          default:
+            continue;
+        }
+        const DexFile::MethodId& method_id = dex_file->GetMethodId(method_idx);
+        if (method_id.name_idx_ == name_idx && method_id.proto_idx_ == proto_idx) {
+          callers->push_back(caller);
+          return;
+        }
+      }
+    }
+
+    mirror::ArtMethod* const method;
+    mirror::DexCache* const dex_cache;
+    const DexFile* dex_file;
+    uint32_t name_idx;
+    uint16_t proto_idx;
+    std::vector<mirror::ArtMethod*>* const callers;
+  };
+
+  InliningCallerFinder finder(m, callers);
+  Runtime::Current()->GetClassLinker()->VisitClasses(InliningCallerFinder::Visit, &finder);
+}
+
 static const Breakpoint* FindFirstBreakpointForMethod(mirror::ArtMethod* m)
     EXCLUSIVE_LOCKS_REQUIRED(Locks::breakpoint_lock_) {
   for (const Breakpoint& breakpoint : gBreakpoints) {
@@ -2829,94 +2898,94 @@ static const Breakpoint* FindFirstBreakpointForMethod(mirror::ArtMethod* m)
 }
 
 // Sanity checks all existing breakpoints on the same method.
-static void SanityCheckExistingBreakpoints(mirror::ArtMethod* m, bool need_full_deoptimization)
+static void SanityCheckExistingBreakpoints(mirror::ArtMethod* m,
+                                           const std::vector<mirror::ArtMethod*>& inlining_callers)
     EXCLUSIVE_LOCKS_REQUIRED(Locks::breakpoint_lock_)  {
   if (kIsDebugBuild) {
+    instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
     for (const Breakpoint& breakpoint : gBreakpoints) {
-      CHECK_EQ(need_full_deoptimization, breakpoint.need_full_deoptimization);
+      if (breakpoint.method == m) {
+        CHECK(breakpoint.inlining_callers == inlining_callers);
+      }
     }
-    if (need_full_deoptimization) {
-      // We should have deoptimized everything but not "selectively" deoptimized this method.
-      CHECK(Runtime::Current()->GetInstrumentation()->AreAllMethodsDeoptimized());
-      CHECK(!Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
-    } else {
-      // We should have "selectively" deoptimized this method.
-      // Note: while we have not deoptimized everything for this method, we may have done it for
-      // another event.
-      CHECK(Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
+    // We should have "selectively" deoptimized this method and its possible inlining callers.
+    CHECK(instrumentation->IsDeoptimized(m));
+    for (mirror::ArtMethod* caller : inlining_callers) {
+      CHECK(instrumentation->IsDeoptimized(caller));
     }
   }
 }
 
-// Installs a breakpoint at the specified location. Also indicates through the deoptimization
-// request if we need to deoptimize.
-void Dbg::WatchLocation(const JDWP::JdwpLocation* location, DeoptimizationRequest* req) {
+static void AddDeoptimizationRequest(DeoptimizationRequest::Kind kind, mirror::ArtMethod* m,
+                                     std::vector<DeoptimizationRequest>* reqs) {
+  DeoptimizationRequest req;
+  req.kind = kind;
+  req.method = m;
+  reqs->push_back(req);
+}
+
+// Installs a breakpoint at the specified location. Also adds the deoptimization requests needed
+// by the breakpoint: the first breakpoint of a method deoptimizes it and, if it may be inlined,
+// the methods which may have inlined it.
+void Dbg::WatchLocation(const JDWP::JdwpLocation* location,
+                        std::vector<DeoptimizationRequest>* reqs) {
   Thread* const self = Thread::Current();
   mirror::ArtMethod* m = FromMethodId(location->method_id);
   DCHECK(m != nullptr) << "No method for method id " << location->method_id;
 
   MutexLock mu(self, *Locks::breakpoint_lock_);
   const Breakpoint* const existing_breakpoint = FindFirstBreakpointForMethod(m);
-  bool need_full_deoptimization;
+  std::vector<mirror::ArtMethod*> inlining_callers;
   if (existing_breakpoint == nullptr) {
-    // There is no breakpoint on this method yet: we need to deoptimize. If this method may be
-    // inlined, we deoptimize everything; otherwise we deoptimize only this method.
-    need_full_deoptimization = IsMethodPossiblyInlined(self, m);
-    if (need_full_deoptimization) {
-      req->kind = DeoptimizationRequest::kFullDeoptimization;
-      req->method = nullptr;
-    } else {
-      req->kind = DeoptimizationRequest::kSelectiveDeoptimization;
-      req->method = m;
+    // There is no breakpoint on this method yet: we need to deoptimize it. If this method may be
+    // inlined, we also deoptimize the methods which may have inlined it rather than everything.
+    if (IsMethodPossiblyInlined(self, m)) {
+      FindInliningCallers(m, &inlining_callers);
+    }
+    AddDeoptimizationRequest(DeoptimizationRequest::kSelectiveDeoptimization, m, reqs);
+    for (mirror::ArtMethod* caller : inlining_callers) {
+      AddDeoptimizationRequest(DeoptimizationRequest::kSelectiveDeoptimization, caller, reqs);
     }
   } else {
     // There is at least one breakpoint for this method: we don't need to deoptimize.
-    req->kind = DeoptimizationRequest::kNothing;
-    req->method = nullptr;
-
-    need_full_deoptimization = existing_breakpoint->need_full_deoptimization;
-    SanityCheckExistingBreakpoints(m, need_full_deoptimization);
+    inlining_callers = existing_breakpoint->inlining_callers;
+    SanityCheckExistingBreakpoints(m, inlining_callers);
   }
 
-  gBreakpoints.push_back(Breakpoint(m, location->dex_pc, need_full_deoptimization));
+  gBreakpoints.push_back(Breakpoint(m, location->dex_pc, inlining_callers));
   VLOG(jdwp) << "Set breakpoint #" << (gBreakpoints.size() - 1) << ": "
              << gBreakpoints[gBreakpoints.size() - 1];
 }
 
-// Uninstalls a breakpoint at the specified location. Also indicates through the deoptimization
-// request if we need to undeoptimize.
-void Dbg::UnwatchLocation(const JDWP::JdwpLocation* location, DeoptimizationRequest* req) {
+// Uninstalls a breakpoint at the specified location. Also adds the undeoptimization requests of
+// the last breakpoint of a method.
+void Dbg::UnwatchLocation(const JDWP::JdwpLocation* location,
+                          std::vector<DeoptimizationRequest>* reqs) {
   mirror::ArtMethod* m = FromMethodId(location->method_id);
   DCHECK(m != nullptr) << "No method for method id " << location->method_id;
 
   MutexLock mu(Thread::Current(), *Locks::breakpoint_lock_);
-  bool need_full_deoptimization = false;
+  std::vector<mirror::ArtMethod*> inlining_callers;
   for (size_t i = 0, e = gBreakpoints.size(); i < e; ++i) {
     if (gBreakpoints[i].method == m && gBreakpoints[i].dex_pc == location->dex_pc) {
       VLOG(jdwp) << "Removed breakpoint #" << i << ": " << gBreakpoints[i];
-      need_full_deoptimization = gBreakpoints[i].need_full_deoptimization;
-      DCHECK_NE(need_full_deoptimization, Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
+      DCHECK(Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
+      inlining_callers = gBreakpoints[i].inlining_callers;
       gBreakpoints.erase(gBreakpoints.begin() + i);
       break;
     }
   }
   const Breakpoint* const existing_breakpoint = FindFirstBreakpointForMethod(m);
   if (existing_breakpoint == nullptr) {
-    // There is no more breakpoint on this method: we need to undeoptimize.
-    if (need_full_deoptimization) {
-      // This method required full deoptimization: we need to undeoptimize everything.
-      req->kind = DeoptimizationRequest::kFullUndeoptimization;
-      req->method = nullptr;
-    } else {
-      // This method required selective deoptimization: we need to undeoptimize only that method.
-      req->kind = DeoptimizationRequest::kSelectiveUndeoptimization;
-      req->method = m;
+    // There is no more breakpoint on this method: we need to undeoptimize it and the methods we
+    // deoptimized along with it.
+    AddDeoptimizationRequest(DeoptimizationRequest::kSelectiveUndeoptimization, m, reqs);
+    for (mirror::ArtMethod* caller : inlining_callers) {
+      AddDeoptimizationRequest(DeoptimizationRequest::kSelectiveUndeoptimization, caller, reqs);
     }
   } else {
     // There is at least one breakpoint for this method: we don't need to undeoptimize.
-    req->kind = DeoptimizationRequest::kNothing;
-    req->method = nullptr;
-    SanityCheckExistingBreakpoints(m, need_full_deoptimization);
+    SanityCheckExistingBreakpoints(m, inlining_callers);
   }
 }
 
@@ -3097,6 +3166,10 @@ JDWP::JdwpError Dbg::ConfigureStep(JDWP::ObjectId thread_id, JDWP::JdwpStepSize
   single_step_control->step_depth = step_depth;
   single_step_control->is_active = true;
 
+  // Rather than deoptimizing everything, install exit stubs in the frames of this thread so that
+  // the compiled methods it returns to continue in the interpreter while it is stepping.
+  Runtime::Current()->GetInstrumentation()->InstrumentThreadStack(thread);
+
   if (VLOG_IS_ON(jdwp)) {
     VLOG(jdwp) << "Single-step thread: " << *thread;
     VLOG(jdwp) << "Single-step step size: " << single_step_control->step_size;
@@ -3125,6 +3198,24 @@ void Dbg::UnconfigureStep(JDWP::ObjectId thread_id) {
   }
 }
 
+bool Dbg::IsForcedInterpreterNeededForCalling(Thread* thread, mirror::ArtMethod* m) {
+  if (LIKELY(!gDebuggerActive)) {
+    return false;
+  }
+  const SingleStepControl* const single_step_control = thread->GetSingleStepControl();
+  return single_step_control != nullptr && single_step_control->is_active &&
+      single_step_control->step_depth == JDWP::SD_INTO && !m->IsNative() &&
+      !m->IsProxyMethod();
+}
+
+bool Dbg::IsForcedInterpreterNeededForUpcall(Thread* thread, mirror::ArtMethod* m) {
+  if (LIKELY(!gDebuggerActive)) {
+    return false;
+  }
+  const SingleStepControl* const single_step_control = thread->GetSingleStepControl();
+  return single_step_control != nullptr && single_step_control->is_active && !m->IsNative();
+}
+
 static char JdwpTagToShortyChar(JDWP::JdwpTag tag) {
   switch (tag) {
     default:
@@ -3549,11 +3640,14 @@ void Dbg::DdmSendThreadNotification(Thread* t, uint32_t type) {
     ScopedObjectAccessUnchecked soa(Thread::Current());
     SirtRef<mirror::String> name(soa.Self(), t->GetThreadName(soa));
     size_t char_count = (name.get() != NULL) ? name->GetLength() : 0;
-    const jchar* chars = (name.get() != NULL) ? name->GetCharArray()->GetData() : NULL;
+    std::vector<uint16_t> chars(char_count);
+    if (char_count != 0) {
+      name->GetChars(0, char_count, &chars[0]);
+    }
 
     std::vector<uint8_t> bytes;
     JDWP::Append4BE(bytes, t->GetThreadId());
-    JDWP::AppendUtf16BE(bytes, chars, char_count);
+    JDWP::AppendUtf16BE(bytes, chars.empty() ? nullptr : &chars[0], char_count);
     CHECK_EQ(bytes.size(), char_count*2 + sizeof(uint32_t)*2);
     Dbg::DdmSendChunk(type, bytes);
   }
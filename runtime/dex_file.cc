@@ -108,7 +108,8 @@ bool DexFile::GetChecksum(const char* filename, uint32_t* checksum, std::string*
     return true;
   }
   if (IsDexMagic(magic)) {
-    UniquePtr<const DexFile> dex_file(DexFile::OpenFile(fd.release(), filename, false, error_msg));
+    UniquePtr<const DexFile> dex_file(DexFile::OpenFile(fd.release(), filename, false, nullptr,
+                                                        error_msg));
     if (dex_file.get() == NULL) {
       return false;
     }
@@ -121,6 +122,7 @@ bool DexFile::GetChecksum(const char* filename, uint32_t* checksum, std::string*
 
 const DexFile* DexFile::Open(const char* filename,
                              const char* location,
+                             const DexFile* verified_dex_file,
                              std::string* error_msg) {
   uint32_t magic;
   ScopedFd fd(OpenAndReadMagic(filename, &magic, error_msg));
@@ -129,10 +131,10 @@ const DexFile* DexFile::Open(const char* filename,
     return NULL;
   }
   if (IsZipMagic(magic)) {
-    return DexFile::OpenZip(fd.release(), location, error_msg);
+    return DexFile::OpenZip(fd.release(), location, verified_dex_file, error_msg);
   }
   if (IsDexMagic(magic)) {
-    return DexFile::OpenFile(fd.release(), location, true, error_msg);
+    return DexFile::OpenFile(fd.release(), location, true, verified_dex_file, error_msg);
   }
   *error_msg = StringPrintf("Expected valid zip or dex file: '%s'", filename);
   return nullptr;
@@ -169,7 +171,7 @@ bool DexFile::DisableWrite() const {
 }
 
 const DexFile* DexFile::OpenFile(int fd, const char* location, bool verify,
-                                 std::string* error_msg) {
+                                 const DexFile* verified_dex_file, std::string* error_msg) {
   CHECK(location != nullptr);
   UniquePtr<MemMap> map;
   {
@@ -207,8 +209,7 @@ const DexFile* DexFile::OpenFile(int fd, const char* location, bool verify,
     return nullptr;
   }
 
-  if (verify && !DexFileVerifier::Verify(dex_file, dex_file->Begin(), dex_file->Size(), location,
-                                         error_msg)) {
+  if (verify && !Verify(dex_file, verified_dex_file, location, error_msg)) {
     return nullptr;
   }
 
@@ -217,13 +218,14 @@ const DexFile* DexFile::OpenFile(int fd, const char* location, bool verify,
 
 const char* DexFile::kClassesDex = "classes.dex";
 
-const DexFile* DexFile::OpenZip(int fd, const std::string& location, std::string* error_msg) {
+const DexFile* DexFile::OpenZip(int fd, const std::string& location,
+                                const DexFile* verified_dex_file, std::string* error_msg) {
   UniquePtr<ZipArchive> zip_archive(ZipArchive::OpenFromFd(fd, location.c_str(), error_msg));
   if (zip_archive.get() == nullptr) {
     DCHECK(!error_msg->empty());
     return nullptr;
   }
-  return DexFile::Open(*zip_archive, location, error_msg);
+  return DexFile::Open(*zip_archive, location, verified_dex_file, error_msg);
 }
 
 const DexFile* DexFile::OpenMemory(const std::string& location,
@@ -239,13 +241,26 @@ const DexFile* DexFile::OpenMemory(const std::string& location,
 }
 
 const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& location,
-                             std::string* error_msg) {
+                             const DexFile* verified_dex_file, std::string* error_msg) {
   CHECK(!location.empty());
   UniquePtr<ZipEntry> zip_entry(zip_archive.Find(kClassesDex, error_msg));
   if (zip_entry.get() == NULL) {
     return nullptr;
   }
-  UniquePtr<MemMap> map(zip_entry->ExtractToMemMap(kClassesDex, error_msg));
+  // A stored classes.dex is mapped from the archive when it is word aligned, which the dex file
+  // structures need, rather than copied to private memory of each process opening it.
+  UniquePtr<MemMap> map;
+  if (zip_entry->IsUncompressed()) {
+    std::string map_error_msg;
+    map.reset(zip_entry->MapDirectlyFromFile(kClassesDex, 4, &map_error_msg));
+    if (map.get() == NULL) {
+      VLOG(class_linker) << "Extracting '" << kClassesDex << "' from '" << location << "': "
+                         << map_error_msg;
+    }
+  }
+  if (map.get() == NULL) {
+    map.reset(zip_entry->ExtractToMemMap(kClassesDex, error_msg));
+  }
   if (map.get() == NULL) {
     *error_msg = StringPrintf("Failed to extract '%s' from '%s': %s", kClassesDex, location.c_str(),
                               error_msg->c_str());
@@ -258,8 +273,7 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& l
                               error_msg->c_str());
     return nullptr;
   }
-  if (!DexFileVerifier::Verify(dex_file.get(), dex_file->Begin(), dex_file->Size(),
-                               location.c_str(), error_msg)) {
+  if (!Verify(dex_file.get(), verified_dex_file, location.c_str(), error_msg)) {
     return nullptr;
   }
   if (!dex_file->DisableWrite()) {
@@ -270,6 +284,22 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& l
   return dex_file.release();
 }
 
+bool DexFile::Verify(const DexFile* dex_file, const DexFile* verified_dex_file,
+                     const char* location, std::string* error_msg) {
+  // The checksums rule out most other dex files without reading them. Comparing the contents is
+  // still much cheaper than verifying them.
+  if (verified_dex_file != nullptr &&
+      verified_dex_file->GetHeader().checksum_ == dex_file->GetHeader().checksum_ &&
+      verified_dex_file->Size() == dex_file->Size() &&
+      memcmp(verified_dex_file->Begin(), dex_file->Begin(), dex_file->Size()) == 0) {
+    VLOG(verifier) << "Skipped the verification of dex file '" << location
+                   << "', identical to the verified '" << verified_dex_file->GetLocation() << "'";
+    return true;
+  }
+  return DexFileVerifier::Verify(dex_file, dex_file->Begin(), dex_file->Size(), location,
+                                 error_msg);
+}
+
 const DexFile* DexFile::OpenMemory(const byte* base,
                                    size_t size,
                                    const std::string& location,
@@ -299,7 +329,9 @@ DexFile::DexFile(const byte* base, size_t size,
       field_ids_(reinterpret_cast<const FieldId*>(base + header_->field_ids_off_)),
       method_ids_(reinterpret_cast<const MethodId*>(base + header_->method_ids_off_)),
       proto_ids_(reinterpret_cast<const ProtoId*>(base + header_->proto_ids_off_)),
-      class_defs_(reinterpret_cast<const ClassDef*>(base + header_->class_defs_off_)) {
+      class_defs_(reinterpret_cast<const ClassDef*>(base + header_->class_defs_off_)),
+      type_index_(nullptr),
+      oat_file_(nullptr) {
   CHECK(begin_ != NULL) << GetLocation();
   CHECK_GT(size_, 0U) << GetLocation();
 }
@@ -309,6 +341,7 @@ DexFile::~DexFile() {
   // that's only called after DetachCurrentThread, which means there's no JNIEnv. We could
   // re-attach, but cleaning up these global references is not obviously useful. It's not as if
   // the global reference table is otherwise empty!
+  delete type_index_.Load();
 }
 
 bool DexFile::Init(std::string* error_msg) {
@@ -358,26 +391,94 @@ uint32_t DexFile::GetVersion() const {
 }
 
 const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor) const {
-  size_t num_class_defs = NumClassDefs();
-  if (num_class_defs == 0) {
+  if (NumClassDefs() == 0) {
     return NULL;
   }
-  const StringId* string_id = FindStringId(descriptor);
-  if (string_id == NULL) {
+  const TypeIndex::Entry* entry = GetTypeIndex()->Find(*this, descriptor);
+  if (entry == NULL || entry->class_def_idx_ == kDexNoIndex16) {
     return NULL;
   }
-  const TypeId* type_id = FindTypeId(GetIndexForStringId(*string_id));
-  if (type_id == NULL) {
-    return NULL;
+  return &GetClassDef(entry->class_def_idx_);
+}
+
+static uint32_t HashDescriptor(const char* descriptor) {
+  uint32_t hash = 0;
+  for (; *descriptor != '\0'; ++descriptor) {
+    hash = hash * 31 + *descriptor;
   }
-  uint16_t type_idx = GetIndexForTypeId(*type_id);
-  for (size_t i = 0; i < num_class_defs; ++i) {
-    const ClassDef& class_def = GetClassDef(i);
-    if (class_def.class_idx_ == type_idx) {
-      return &class_def;
+  return hash;
+}
+
+static size_t FirstTypeIndexEntry(uint32_t hash, size_t mask) {
+  return (hash ^ (hash >> 16)) & mask;
+}
+
+DexFile::TypeIndex::TypeIndex(const DexFile& dex_file) {
+  const size_t num_type_ids = dex_file.NumTypeIds();
+  // At most half full.
+  size_t capacity = 16;
+  while (num_type_ids * 2 > capacity) {
+    capacity *= 2;
+  }
+  mask_ = capacity - 1;
+  Entry empty_entry = { 0, kDexNoIndex16, kDexNoIndex16 };
+  entries_.assign(capacity, empty_entry);
+  std::vector<uint16_t> class_def_idxs(num_type_ids, kDexNoIndex16);
+  for (size_t i = 0; i < dex_file.NumClassDefs(); ++i) {
+    // Keep the first definition of a type, as the linear search did.
+    const uint16_t class_idx = dex_file.GetClassDef(i).class_idx_;
+    if (class_idx < num_type_ids && class_def_idxs[class_idx] == kDexNoIndex16) {
+      class_def_idxs[class_idx] = static_cast<uint16_t>(i);
+    }
+  }
+  for (size_t type_idx = 0; type_idx < num_type_ids; ++type_idx) {
+    const uint32_t hash = HashDescriptor(dex_file.StringByTypeIdx(type_idx));
+    size_t i = FirstTypeIndexEntry(hash, mask_);
+    while (entries_[i].type_idx_ != kDexNoIndex16) {
+      i = (i + 1) & mask_;
+    }
+    entries_[i].hash_ = hash;
+    entries_[i].type_idx_ = static_cast<uint16_t>(type_idx);
+    entries_[i].class_def_idx_ = class_def_idxs[type_idx];
+  }
+}
+
+const DexFile::TypeIndex::Entry* DexFile::TypeIndex::Find(const DexFile& dex_file,
+                                                          const char* descriptor) const {
+  const uint32_t hash = HashDescriptor(descriptor);
+  for (size_t i = FirstTypeIndexEntry(hash, mask_); ; i = (i + 1) & mask_) {
+    const Entry& entry = entries_[i];
+    if (entry.type_idx_ == kDexNoIndex16) {
+      return NULL;
+    }
+    // Modified UTF-8 encodings are unique, equal strings have equal bytes.
+    if (entry.hash_ == hash && strcmp(descriptor, dex_file.StringByTypeIdx(entry.type_idx_)) == 0) {
+      return &entry;
     }
   }
-  return NULL;
+}
+
+const DexFile::TypeIndex* DexFile::GetTypeIndex() const {
+  TypeIndex* type_index = type_index_.Load();
+  if (LIKELY(type_index != NULL)) {
+    return type_index;
+  }
+  TypeIndex* new_type_index = new TypeIndex(*this);
+  // The compare and swap publishes the entries before the index.
+  if (type_index_.CompareAndSwap(NULL, new_type_index)) {
+    return new_type_index;
+  }
+  // Another thread built it first.
+  delete new_type_index;
+  return type_index_.Load();
+}
+
+const DexFile::TypeId* DexFile::FindTypeId(const char* descriptor) const {
+  const TypeIndex::Entry* entry = GetTypeIndex()->Find(*this, descriptor);
+  if (entry == NULL) {
+    return NULL;
+  }
+  return &GetTypeId(entry->type_idx_);
 }
 
 const DexFile::ClassDef* DexFile::FindClassDef(uint16_t type_idx) const {
@@ -587,11 +688,7 @@ bool DexFile::CreateTypeList(const StringPiece& signature, uint16_t* return_type
     }
     // TODO: avoid creating a std::string just to get a 0-terminated char array
     std::string descriptor(signature.data() + start_offset, offset - start_offset);
-    const DexFile::StringId* string_id = FindStringId(descriptor.c_str());
-    if (string_id == NULL) {
-      return false;
-    }
-    const DexFile::TypeId* type_id = FindTypeId(GetIndexForStringId(*string_id));
+    const DexFile::TypeId* type_id = FindTypeId(descriptor.c_str());
     if (type_id == NULL) {
       return false;
     }
@@ -865,6 +962,67 @@ bool DexFile::LineNumForPcCb(void* raw_context, uint32_t address, uint32_t line_
   }
 }
 
+bool DexFile::IsMethodAnnotationPresent(const ClassDef& class_def, uint32_t method_idx,
+                                        const char* descriptor, uint8_t visibility) const {
+  if (class_def.annotations_off_ == 0) {
+    return false;
+  }
+  const AnnotationsDirectoryItem* directory =
+      reinterpret_cast<const AnnotationsDirectoryItem*>(begin_ + class_def.annotations_off_);
+  // The method annotations follow the field annotations, sorted by method index.
+  const FieldAnnotationsItem* fields = reinterpret_cast<const FieldAnnotationsItem*>(directory + 1);
+  const MethodAnnotationsItem* methods =
+      reinterpret_cast<const MethodAnnotationsItem*>(fields + directory->fields_size_);
+  for (uint32_t i = 0; i < directory->methods_size_ && methods[i].method_idx_ <= method_idx; ++i) {
+    if (methods[i].method_idx_ != method_idx) {
+      continue;
+    }
+    const AnnotationSetItem* set =
+        reinterpret_cast<const AnnotationSetItem*>(begin_ + methods[i].annotations_off_);
+    for (uint32_t j = 0; j < set->size_; ++j) {
+      const AnnotationItem* item =
+          reinterpret_cast<const AnnotationItem*>(begin_ + set->entries_[j]);
+      if (item->visibility_ != visibility) {
+        continue;
+      }
+      // The encoded annotation starts with its type index.
+      const byte* annotation = item->annotation_;
+      uint32_t type_idx = DecodeUnsignedLeb128(&annotation);
+      if (strcmp(StringByTypeIdx(type_idx), descriptor) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return false;
+}
+
+uint32_t DexFile::GetNativeMethodOptimizationFlags(const ClassDef& class_def, uint32_t method_idx,
+                                                   uint32_t access_flags) const {
+  if ((access_flags & kAccNative) == 0 || class_def.annotations_off_ == 0) {
+    return 0;
+  }
+  // The annotations have class retention, they are only visible to the build.
+  static const char* kFastNativeDescriptor = "Ldalvik/annotation/optimization/FastNative;";
+  static const char* kCriticalNativeDescriptor = "Ldalvik/annotation/optimization/CriticalNative;";
+  if (IsMethodAnnotationPresent(class_def, method_idx, kCriticalNativeDescriptor,
+                                kDexVisibilityBuild)) {
+    const char* shorty = GetMethodShorty(GetMethodId(method_idx));
+    if ((access_flags & (kAccStatic | kAccSynchronized)) == kAccStatic &&
+        strchr(shorty, 'L') == nullptr) {
+      // Critical natives never leave Runnable either, whichever way they are called.
+      return kAccFastNative | kAccCriticalNative;
+    }
+    LOG(WARNING) << "Ignoring @CriticalNative on " << PrettyMethod(method_idx, *this)
+        << ", it must be static, not synchronized and only take and return primitives";
+  }
+  if (IsMethodAnnotationPresent(class_def, method_idx, kFastNativeDescriptor,
+                                kDexVisibilityBuild)) {
+    return kAccFastNative;
+  }
+  return 0;
+}
+
 std::ostream& operator<<(std::ostream& os, const DexFile& dex_file) {
   os << StringPrintf("[DexFile: %s dex-checksum=%08x location-checksum=%08x %p-%p]",
                      dex_file.GetLocation().c_str(),
@@ -925,10 +1083,12 @@ std::ostream& operator<<(std::ostream& os, const Signature& sig) {
 // Decodes the header section from the class data bytes.
 void ClassDataItemIterator::ReadClassDataHeader() {
   CHECK(ptr_pos_ != NULL);
-  header_.static_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.instance_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.direct_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.virtual_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t sizes[4];
+  DecodeUnsignedLeb128Array(&ptr_pos_, sizes, arraysize(sizes));
+  header_.static_fields_size_ = sizes[0];
+  header_.instance_fields_size_ = sizes[1];
+  header_.direct_methods_size_ = sizes[2];
+  header_.virtual_methods_size_ = sizes[3];
 }
 
 void ClassDataItemIterator::ReadClassDataField() {
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/mutex.h"  // For Locks::mutator_lock_.
 #include "globals.h"
@@ -41,6 +42,7 @@ namespace mirror {
   class DexCache;
 }  // namespace mirror
 class ClassLinker;
+class OatFile;
 class Signature;
 template <typename T>
 class SirtRef;
@@ -354,7 +356,14 @@ class DexFile {
   static bool GetChecksum(const char* filename, uint32_t* checksum, std::string* error_msg);
 
   // Opens .dex file, guessing the container format based on file extension
-  static const DexFile* Open(const char* filename, const char* location, std::string* error_msg);
+  static const DexFile* Open(const char* filename, const char* location, std::string* error_msg) {
+    return Open(filename, location, nullptr, error_msg);
+  }
+
+  // Like Open, but the DexFileVerifier checks are skipped if the contents are identical to those of
+  // verified_dex_file, such as the copy of the dex file in an oat file which dex2oat verified.
+  static const DexFile* Open(const char* filename, const char* location,
+                             const DexFile* verified_dex_file, std::string* error_msg);
 
   // Opens .dex file, backed by existing memory
   static const DexFile* Open(const uint8_t* base, size_t size,
@@ -366,7 +375,14 @@ class DexFile {
 
   // Opens .dex file from the classes.dex in a zip archive
   static const DexFile* Open(const ZipArchive& zip_archive, const std::string& location,
-                             std::string* error_msg);
+                             std::string* error_msg) {
+    return Open(zip_archive, location, nullptr, error_msg);
+  }
+
+  // Like the above, skipping the DexFileVerifier checks if the contents are identical to those of
+  // verified_dex_file.
+  static const DexFile* Open(const ZipArchive& zip_archive, const std::string& location,
+                             const DexFile* verified_dex_file, std::string* error_msg);
 
   // Closes a .dex file.
   virtual ~DexFile();
@@ -381,6 +397,16 @@ class DexFile {
     return location_checksum_;
   }
 
+  // The opened oat file containing this dex file, as found by the class linker, or null if it
+  // wasn't looked up yet. Saves the class linker a locked search of its oat files for each class.
+  const OatFile* GetOatFile() const {
+    return oat_file_.Load();
+  }
+
+  void SetOatFile(const OatFile* oat_file) const {
+    oat_file_.CompareAndSwap(nullptr, oat_file);
+  }
+
   const Header& GetHeader() const {
     DCHECK(header_ != NULL) << GetLocation();
     return *header_;
@@ -485,6 +511,9 @@ class DexFile {
   // Looks up a type for the given string index
   const TypeId* FindTypeId(uint32_t string_idx) const;
 
+  // Looks up a type by its descriptor, in constant time through the type index.
+  const TypeId* FindTypeId(const char* descriptor) const;
+
   // Returns the number of field identifiers in the .dex file.
   size_t NumFieldIds() const {
     DCHECK(header_ != NULL) << GetLocation();
@@ -804,6 +833,17 @@ class DexFile {
     }
   }
 
+  // Returns true if the method of the class definition has an annotation of the type with the
+  // descriptor and the visibility.
+  bool IsMethodAnnotationPresent(const ClassDef& class_def, uint32_t method_idx,
+                                 const char* descriptor, uint8_t visibility) const;
+
+  // Returns the flags selecting the reduced JNI transitions of a native method annotated with
+  // @FastNative or @CriticalNative, kAccFastNative and kAccCriticalNative, or 0. A misplaced
+  // @CriticalNative, on a method that isn't static or takes or returns references, is ignored.
+  uint32_t GetNativeMethodOptimizationFlags(const ClassDef& class_def, uint32_t method_idx,
+                                            uint32_t access_flags) const;
+
   int GetPermissions() const;
 
   bool IsReadOnly() const;
@@ -822,10 +862,16 @@ class DexFile {
 
  private:
   // Opens a .dex file
-  static const DexFile* OpenFile(int fd, const char* location, bool verify, std::string* error_msg);
+  static const DexFile* OpenFile(int fd, const char* location, bool verify,
+                                 const DexFile* verified_dex_file, std::string* error_msg);
 
   // Opens a dex file from within a .jar, .zip, or .apk file
-  static const DexFile* OpenZip(int fd, const std::string& location, std::string* error_msg);
+  static const DexFile* OpenZip(int fd, const std::string& location,
+                                const DexFile* verified_dex_file, std::string* error_msg);
+
+  // Runs the DexFileVerifier on dex_file, unless it is identical to verified_dex_file.
+  static bool Verify(const DexFile* dex_file, const DexFile* verified_dex_file,
+                     const char* location, std::string* error_msg);
 
   // Opens a .dex file at the given address backed by a MemMap
   static const DexFile* OpenMemory(const std::string& location,
@@ -893,6 +939,36 @@ class DexFile {
 
   // Points to the base of the class definition list.
   const ClassDef* const class_defs_;
+
+  // An open addressing hash table from the type descriptors to the type and class definition
+  // indexes. Saves the binary searches of the string ids, which compare MUTF-8 strings, for the
+  // descriptor lookups done when loading classes.
+  struct TypeIndex {
+    struct Entry {
+      uint32_t hash_;
+      // kDexNoIndex16 for an empty entry.
+      uint16_t type_idx_;
+      // kDexNoIndex16 if the type has no class definition in this file.
+      uint16_t class_def_idx_;
+    };
+
+    explicit TypeIndex(const DexFile& dex_file);
+
+    // Returns the entry of the descriptor, or null.
+    const Entry* Find(const DexFile& dex_file, const char* descriptor) const;
+
+    size_t mask_;
+    std::vector<Entry> entries_;
+  };
+
+  // Returns the type index, building it on first use.
+  const TypeIndex* GetTypeIndex() const;
+
+  // Published by a compare and swap since concurrent first lookups may build it twice.
+  mutable Atomic<TypeIndex*> type_index_;
+
+  // The oat files are never closed, concurrent first lookups store the same oat file.
+  mutable Atomic<const OatFile*> oat_file_;
 };
 std::ostream& operator<<(std::ostream& os, const DexFile& dex_file);
 
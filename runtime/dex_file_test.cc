@@ -198,6 +198,25 @@ TEST_F(DexFileTest, GetChecksum) {
   EXPECT_EQ(java_lang_dex_file_->GetLocationChecksum(), checksum);
 }
 
+TEST_F(DexFileTest, OpenWithVerifiedCopy) {
+  std::string filename(GetLibCoreDexFileName());
+  std::string error_msg;
+  // The core library is large enough for its data sections to be verified in parallel.
+  UniquePtr<const DexFile> verified(DexFile::Open(filename.c_str(), filename.c_str(),
+                                                  &error_msg));
+  ASSERT_TRUE(verified.get() != nullptr) << error_msg;
+  UniquePtr<const DexFile> copy(DexFile::Open(filename.c_str(), filename.c_str(), verified.get(),
+                                              &error_msg));
+  ASSERT_TRUE(copy.get() != nullptr) << error_msg;
+  EXPECT_EQ(verified->GetLocationChecksum(), copy->GetLocationChecksum());
+  // Another dex file is verified as usual.
+  std::string other_filename(GetDexFileName("core-junit"));
+  UniquePtr<const DexFile> other(DexFile::Open(other_filename.c_str(), other_filename.c_str(),
+                                               verified.get(), &error_msg));
+  ASSERT_TRUE(other.get() != nullptr) << error_msg;
+  EXPECT_NE(verified->GetHeader().checksum_, other->GetHeader().checksum_);
+}
+
 TEST_F(DexFileTest, ClassDefs) {
   ScopedObjectAccess soa(Thread::Current());
   const DexFile* raw(OpenTestDexFile("Nested"));
@@ -289,6 +308,21 @@ TEST_F(DexFileTest, FindTypeId) {
   }
 }
 
+TEST_F(DexFileTest, FindTypeIdByDescriptor) {
+  for (size_t i = 0; i < java_lang_dex_file_->NumTypeIds(); i++) {
+    const char* type_str = java_lang_dex_file_->StringByTypeIdx(i);
+    const DexFile::TypeId* type_id = java_lang_dex_file_->FindTypeId(type_str);
+    ASSERT_TRUE(type_id != NULL);
+    EXPECT_EQ(java_lang_dex_file_->GetIndexForTypeId(*type_id), i);
+  }
+  EXPECT_TRUE(java_lang_dex_file_->FindTypeId("LNoSuchClass;") == NULL);
+  for (size_t i = 0; i < java_lang_dex_file_->NumClassDefs(); i++) {
+    const DexFile::ClassDef& class_def = java_lang_dex_file_->GetClassDef(i);
+    const char* descriptor = java_lang_dex_file_->GetClassDescriptor(class_def);
+    EXPECT_EQ(&class_def, java_lang_dex_file_->FindClassDef(descriptor)) << descriptor;
+  }
+}
+
 TEST_F(DexFileTest, FindProtoId) {
   for (size_t i = 0; i < java_lang_dex_file_->NumProtoIds(); i++) {
     const DexFile::ProtoId& to_find = java_lang_dex_file_->GetProtoId(i);
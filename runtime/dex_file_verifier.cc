@@ -16,8 +16,14 @@
 
 #include "dex_file_verifier.h"
 
+#include <pthread.h>
+#include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
+
+#include "atomic.h"
+#include "base/stl_util.h"
 #include "base/stringprintf.h"
 #include "dex_file-inl.h"
 #include "leb128.h"
@@ -66,16 +72,71 @@ static bool IsDataSectionType(uint32_t map_type) {
   return true;
 }
 
+// The sections checked by CheckIntraDataSection.
+static bool IsDataItemSectionType(uint16_t map_type) {
+  switch (map_type) {
+    case DexFile::kDexTypeTypeList:
+    case DexFile::kDexTypeAnnotationSetRefList:
+    case DexFile::kDexTypeAnnotationSetItem:
+    case DexFile::kDexTypeClassDataItem:
+    case DexFile::kDexTypeCodeItem:
+    case DexFile::kDexTypeStringDataItem:
+    case DexFile::kDexTypeDebugInfoItem:
+    case DexFile::kDexTypeAnnotationItem:
+    case DexFile::kDexTypeEncodedArrayItem:
+    case DexFile::kDexTypeAnnotationsDirectoryItem:
+      return true;
+  }
+  return false;
+}
+
+// The intra-section checks of a data section, made ahead by a verifier of its own.
+struct DexFileVerifier::DataSectionCheck {
+  const DexFile::MapItem* item;
+  // The bytes up to the next section, an estimate of the cost of the checks.
+  size_t span;
+  UniquePtr<DexFileVerifier> verifier;
+  bool passed;
+
+  static bool HasLargerSpan(const DataSectionCheck* lhs, const DataSectionCheck* rhs) {
+    return lhs->span > rhs->span;
+  }
+};
+
+// The data section checks shared by the threads of a parallel verification.
+struct DexFileVerifier::ParallelDataSectionChecks {
+  // By decreasing span, so that the largest sections don't end up being checked last.
+  std::vector<DataSectionCheck*> checks;
+  // The index of the next check to make.
+  Atomic<size_t> next;
+};
+
 bool DexFileVerifier::Verify(const DexFile* dex_file, const byte* begin, size_t size,
                              const char* location, std::string* error_msg) {
+  const uint64_t start_ns = NanoTime();
   UniquePtr<DexFileVerifier> verifier(new DexFileVerifier(dex_file, begin, size, location));
-  if (!verifier->Verify()) {
+  bool verified = verifier->Verify();
+  const uint64_t duration_ns = NanoTime() - start_ns;
+  if (duration_ns > MsToNs(100)) {
+    LOG(WARNING) << "Verification of dex file '" << location << "' (" << PrettySize(size)
+                 << ") took " << PrettyDuration(duration_ns) << " on "
+                 << verifier->thread_count_ << " threads";
+  } else {
+    VLOG(verifier) << "Verification of dex file '" << location << "' (" << PrettySize(size)
+                   << ") took " << PrettyDuration(duration_ns) << " on "
+                   << verifier->thread_count_ << " threads";
+  }
+  if (!verified) {
     *error_msg = verifier->FailureReason();
     return false;
   }
   return true;
 }
 
+DexFileVerifier::~DexFileVerifier() {
+  STLDeleteElements(&data_section_checks_);
+}
+
 bool DexFileVerifier::CheckShortyDescriptorMatch(char shorty_char, const char* descriptor,
                                                 bool is_return_type) {
   switch (shorty_char) {
@@ -1217,10 +1278,87 @@ bool DexFileVerifier::CheckIntraDataSection(size_t offset, uint32_t count, uint1
   return true;
 }
 
+void DexFileVerifier::CheckDataSectionsInParallel(const DexFile::MapList* map) {
+  DCHECK(data_section_checks_.empty());
+  long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);  // NOLINT(runtime/int) sysconf's return type.
+  size_t max_thread_count = std::min(static_cast<size_t>(std::max(cpu_count, 1L)),
+                                     static_cast<size_t>(kMaxVerificationThreads));
+  if (max_thread_count < 2) {
+    return;
+  }
+  // CheckMap made sure the items are in increasing offset order, within the file.
+  const DexFile::MapItem* items = map->list_;
+  for (uint32_t i = 0; i < map->size_; ++i) {
+    if (!IsDataItemSectionType(items[i].type_)) {
+      continue;
+    }
+    size_t section_end = (i + 1 < map->size_) ? items[i + 1].offset_ : size_;
+    DataSectionCheck* check = new DataSectionCheck;
+    check->item = &items[i];
+    check->span = section_end - items[i].offset_;
+    check->verifier.reset(new DexFileVerifier(dex_file_, begin_, size_, location_));
+    check->passed = false;
+    data_section_checks_.push_back(check);
+  }
+  if (data_section_checks_.size() < 2) {
+    STLDeleteElements(&data_section_checks_);
+    return;
+  }
+
+  ParallelDataSectionChecks parallel;
+  parallel.checks = data_section_checks_;
+  std::sort(parallel.checks.begin(), parallel.checks.end(), DataSectionCheck::HasLargerSpan);
+  thread_count_ = std::min(max_thread_count, data_section_checks_.size());
+  std::vector<pthread_t> pthreads(thread_count_ - 1);
+  for (pthread_t& pthread : pthreads) {
+    CHECK_PTHREAD_CALL(pthread_create, (&pthread, nullptr, &RunDataSectionChecks, &parallel),
+                       "dex file verifier thread");
+  }
+  RunDataSectionChecks(&parallel);
+  for (pthread_t& pthread : pthreads) {
+    CHECK_PTHREAD_CALL(pthread_join, (pthread, nullptr), "dex file verifier thread shutdown");
+  }
+}
+
+void* DexFileVerifier::RunDataSectionChecks(void* arg) {
+  ParallelDataSectionChecks* parallel = reinterpret_cast<ParallelDataSectionChecks*>(arg);
+  while (true) {
+    size_t index = parallel->next.FetchAndAdd(1);
+    if (index >= parallel->checks.size()) {
+      return nullptr;
+    }
+    DataSectionCheck* check = parallel->checks[index];
+    const DexFile::MapItem* item = check->item;
+    DexFileVerifier* verifier = check->verifier.get();
+    verifier->ptr_ = verifier->begin_ + item->offset_;
+    check->passed = verifier->CheckIntraDataSection(item->offset_, item->size_, item->type_);
+  }
+}
+
+bool DexFileVerifier::TakeDataSectionCheck(const DataSectionCheck* check) {
+  const DexFileVerifier* verifier = check->verifier.get();
+  if (!check->passed) {
+    failure_reason_ = verifier->failure_reason_;
+    return false;
+  }
+  for (const auto& entry : verifier->offset_to_type_map_) {
+    offset_to_type_map_.Put(entry.first, entry.second);
+  }
+  ptr_ = verifier->ptr_;
+  return true;
+}
+
 bool DexFileVerifier::CheckIntraSection() {
   const DexFile::MapList* map = reinterpret_cast<const DexFile::MapList*>(begin_ + header_->map_off_);
   const DexFile::MapItem* item = map->list_;
 
+  if (size_ >= kParallelVerificationMinSize) {
+    CheckDataSectionsInParallel(map);
+  }
+  // The outcome of the checks made ahead is taken in map order, so that the same failure is
+  // reported as when the sections are checked one after the other.
+  std::vector<DataSectionCheck*>::const_iterator data_section_check = data_section_checks_.begin();
+
   uint32_t count = map->size_;
   size_t offset = 0;
   ptr_ = begin_;
@@ -1287,7 +1425,13 @@ bool DexFileVerifier::CheckIntraSection() {
       case DexFile::kDexTypeAnnotationItem:
       case DexFile::kDexTypeEncodedArrayItem:
       case DexFile::kDexTypeAnnotationsDirectoryItem:
-        if (!CheckIntraDataSection(section_offset, section_count, type)) {
+        if (data_section_check != data_section_checks_.end()) {
+          DCHECK_EQ((*data_section_check)->item, item);
+          if (!TakeDataSectionCheck(*data_section_check)) {
+            return false;
+          }
+          ++data_section_check;
+        } else if (!CheckIntraDataSection(section_offset, section_count, type)) {
           return false;
         }
         offset = ptr_ - begin_;
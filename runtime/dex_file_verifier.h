@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_DEX_FILE_VERIFIER_H_
 #define ART_RUNTIME_DEX_FILE_VERIFIER_H_
 
+#include <vector>
+
 #include "dex_file.h"
 #include "safe_map.h"
 
@@ -24,17 +26,29 @@ namespace art {
 
 class DexFileVerifier {
  public:
+  // Checks the structure of the dex file. The data sections of a large dex file, such as the string
+  // data, code items and annotations, are checked on several threads.
   static bool Verify(const DexFile* dex_file, const byte* begin, size_t size,
                      const char* location, std::string* error_msg);
 
+  ~DexFileVerifier();
+
   const std::string& FailureReason() const {
     return failure_reason_;
   }
 
  private:
+  struct DataSectionCheck;
+  struct ParallelDataSectionChecks;
+
+  // Dex files smaller than this are verified on the calling thread only.
+  static constexpr size_t kParallelVerificationMinSize = 512 * KB;
+  // The most threads verifying a dex file, the calling thread included.
+  static constexpr size_t kMaxVerificationThreads = 4;
+
   DexFileVerifier(const DexFile* dex_file, const byte* begin, size_t size, const char* location)
       : dex_file_(dex_file), begin_(begin), size_(size), location_(location),
-        header_(&dex_file->GetHeader()), ptr_(NULL), previous_item_(NULL)  {
+        header_(&dex_file->GetHeader()), ptr_(NULL), previous_item_(NULL), thread_count_(1) {
   }
 
   bool Verify();
@@ -70,6 +84,13 @@ class DexFileVerifier {
   bool CheckIntraDataSection(size_t offset, uint32_t count, uint16_t type);
   bool CheckIntraSection();
 
+  // Makes the intra-section checks of the data sections ahead of CheckIntraSection, each by a
+  // verifier of its own, on up to kMaxVerificationThreads threads.
+  void CheckDataSectionsInParallel(const DexFile::MapList* map);
+  static void* RunDataSectionChecks(void* arg);
+  // Takes the outcome of the checks of a data section made ahead, as if they were made now.
+  bool TakeDataSectionCheck(const DataSectionCheck* check);
+
   bool CheckOffsetToTypeMap(size_t offset, uint16_t type);
   uint16_t FindFirstClassDataDefiner(const byte* ptr) const;
   uint16_t FindFirstAnnotationsDirectoryDefiner(const byte* ptr) const;
@@ -101,6 +122,11 @@ class DexFileVerifier {
   const byte* ptr_;
   const void* previous_item_;
 
+  // The checks of the data sections made ahead, in map order. Empty if the data sections are
+  // checked on the way by CheckIntraSection.
+  std::vector<DataSectionCheck*> data_section_checks_;
+  size_t thread_count_;
+
   std::string failure_reason_;
 };
 
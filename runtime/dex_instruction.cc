@@ -160,9 +160,10 @@ std::string Instruction::DumpString(const DexFile* file) const {
     case k21c: {
       switch (Opcode()) {
         case CONST_STRING:
+        case CONST_STRING_QUICK:
           if (file != NULL) {
             uint32_t string_idx = VRegB_21c();
-            os << StringPrintf("const-string v%d, %s // string@%d", VRegA_21c(),
+            os << StringPrintf("%s v%d, %s // string@%d", opcode, VRegA_21c(),
                                PrintableString(file->StringDataByIdx(string_idx)).c_str(), string_idx);
             break;
           }  // else fall-through
@@ -182,6 +183,9 @@ std::string Instruction::DumpString(const DexFile* file) const {
         case SGET_BYTE:
         case SGET_CHAR:
         case SGET_SHORT:
+        case SGET_QUICK:
+        case SGET_WIDE_QUICK:
+        case SGET_OBJECT_QUICK:
           if (file != NULL) {
             uint32_t field_idx = VRegB_21c();
             os << opcode << "  v" << static_cast<int>(VRegA_21c()) << ", " << PrettyField(field_idx, *file, true)
@@ -195,6 +199,9 @@ std::string Instruction::DumpString(const DexFile* file) const {
         case SPUT_BYTE:
         case SPUT_CHAR:
         case SPUT_SHORT:
+        case SPUT_QUICK:
+        case SPUT_WIDE_QUICK:
+        case SPUT_OBJECT_QUICK:
           if (file != NULL) {
             uint32_t field_idx = VRegB_21c();
             os << opcode << " v" << static_cast<int>(VRegA_21c()) << ", " << PrettyField(field_idx, *file, true)
@@ -329,6 +336,7 @@ std::string Instruction::DumpString(const DexFile* file) const {
             break;
           }  // else fall-through
         case INVOKE_VIRTUAL_QUICK:
+        case INVOKE_SUPER_QUICK:
           if (file != NULL) {
             os << opcode << " {";
             uint32_t method_idx = VRegB_35c();
@@ -362,6 +370,7 @@ std::string Instruction::DumpString(const DexFile* file) const {
             break;
           }  // else fall-through
         case INVOKE_VIRTUAL_RANGE_QUICK:
+        case INVOKE_SUPER_RANGE_QUICK:
           if (file != NULL) {
             uint32_t method_idx = VRegB_3rc();
             os << StringPrintf("%s, {v%d .. v%d}, ", opcode, VRegC_3rc(), (VRegC_3rc() + VRegA_3rc() - 1))
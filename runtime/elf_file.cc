@@ -107,6 +107,7 @@ ElfFile::ElfFile(File* file, bool writable, bool program_header_only)
   : file_(file),
     writable_(writable),
     program_header_only_(program_header_only),
+    executable_(false),
     header_(NULL),
     base_address_(NULL),
     program_headers_start_(NULL),
@@ -118,6 +119,7 @@ ElfFile::ElfFile(File* file, bool writable, bool program_header_only)
     strtab_section_start_(NULL),
     dynstr_section_start_(NULL),
     hash_section_start_(NULL),
+    gnu_hash_section_start_(NULL),
     symtab_symbol_table_(NULL),
     dynsym_symbol_table_(NULL),
     jit_elf_image_(NULL),
@@ -245,6 +247,10 @@ bool ElfFile::Setup(std::string* error_msg) {
           hash_section_start_ = reinterpret_cast<Elf32_Word*>(section_addr);
           break;
         }
+        case SHT_GNU_HASH: {
+          gnu_hash_section_start_ = reinterpret_cast<Elf32_Word*>(section_addr);
+          break;
+        }
       }
     }
   }
@@ -559,25 +565,99 @@ static unsigned elfhash(const char *_name) {
   return h;
 }
 
+// The hash function of .gnu.hash, from bionic.
+static uint32_t gnuhash(const char* name) {
+  uint32_t h = 5381;
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(name); *p != 0; ++p) {
+    h += (h << 5) + *p;  // h * 33 + c
+  }
+  return h;
+}
+
 Elf32_Shdr& ElfFile::GetSectionNameStringSection() const {
   return GetSectionHeader(GetHeader().e_shstrndx);
 }
 
 const byte* ElfFile::FindDynamicSymbolAddress(const std::string& symbol_name) const {
+  CHECK(gnu_hash_section_start_ != NULL || hash_section_start_ != NULL) << file_->GetPath();
+  Elf32_Sym* symbol = FindDynamicSymbol(symbol_name);
+  if (symbol == NULL) {
+    return NULL;
+  }
+  return base_address_ + symbol->st_value;
+}
+
+Elf32_Sym* ElfFile::FindDynamicSymbol(const std::string& symbol_name) const {
+  if (gnu_hash_section_start_ != NULL) {
+    return FindDynamicSymbolByGnuHash(symbol_name);
+  }
+  if (hash_section_start_ != NULL) {
+    return FindDynamicSymbolByHash(symbol_name);
+  }
+  return NULL;
+}
+
+Elf32_Sym* ElfFile::FindDynamicSymbolByHash(const std::string& symbol_name) const {
   Elf32_Word hash = elfhash(symbol_name.c_str());
   Elf32_Word bucket_index = hash % GetHashBucketNum();
   Elf32_Word symbol_and_chain_index = GetHashBucket(bucket_index);
   while (symbol_and_chain_index != 0 /* STN_UNDEF */) {
     Elf32_Sym& symbol = GetSymbol(SHT_DYNSYM, symbol_and_chain_index);
     const char* name = GetString(SHT_DYNSYM, symbol.st_name);
-    if (symbol_name == name) {
-      return base_address_ + symbol.st_value;
+    if (name != NULL && symbol_name == name) {
+      return &symbol;
     }
     symbol_and_chain_index = GetHashChain(symbol_and_chain_index);
   }
   return NULL;
 }
 
+Elf32_Sym* ElfFile::FindDynamicSymbolByGnuHash(const std::string& symbol_name) const {
+  // The section starts with nbucket, symoffset, bloom_size and bloom_shift, followed by the bloom
+  // filter words, the buckets, and the hashes of the symbols from symoffset on.
+  const Elf32_Word* section = gnu_hash_section_start_;
+  Elf32_Word bucket_num = section[0];
+  Elf32_Word symbol_offset = section[1];
+  Elf32_Word bloom_size = section[2];
+  Elf32_Word bloom_shift = section[3];
+  if (bucket_num == 0 || bloom_size == 0) {
+    return NULL;
+  }
+  const Elf32_Word* bloom = section + 4;
+  const Elf32_Word* buckets = bloom + bloom_size;
+  const Elf32_Word* chains = buckets + bucket_num;
+
+  // The bloom filter rules out most of the missing symbols without reading the symbol table.
+  const uint32_t kBloomWordBits = 32;
+  uint32_t hash = gnuhash(symbol_name.c_str());
+  Elf32_Word bloom_word = bloom[(hash / kBloomWordBits) % bloom_size];
+  Elf32_Word bloom_mask = (1U << (hash % kBloomWordBits)) |
+      (1U << ((hash >> bloom_shift) % kBloomWordBits));
+  if ((bloom_word & bloom_mask) != bloom_mask) {
+    return NULL;
+  }
+
+  // The symbols of a bucket are consecutive, the low bit of a hash marks the last one.
+  Elf32_Word symbol_index = buckets[hash % bucket_num];
+  if (symbol_index < symbol_offset) {
+    return NULL;
+  }
+  while (true) {
+    Elf32_Word chain_hash = chains[symbol_index - symbol_offset];
+    if ((chain_hash | 1) == (hash | 1)) {
+      Elf32_Sym& symbol = GetSymbol(SHT_DYNSYM, symbol_index);
+      const char* name = GetString(SHT_DYNSYM, symbol.st_name);
+      if (name != NULL && symbol_name == name) {
+        return &symbol;
+      }
+    }
+    if ((chain_hash & 1) != 0) {
+      return NULL;
+    }
+    ++symbol_index;
+  }
+}
+
 bool ElfFile::IsSymbolSectionType(Elf32_Word section_type) {
   return ((section_type == SHT_SYMTAB) || (section_type == SHT_DYNSYM));
 }
@@ -616,6 +696,11 @@ Elf32_Sym* ElfFile::FindSymbolByName(Elf32_Word section_type,
   CHECK(!program_header_only_) << file_->GetPath();
   CHECK(IsSymbolSectionType(section_type)) << file_->GetPath() << " " << section_type;
 
+  if (section_type == SHT_DYNSYM &&
+      (gnu_hash_section_start_ != NULL || hash_section_start_ != NULL)) {
+    return FindDynamicSymbol(symbol_name);
+  }
+
   SymbolTable** symbol_table = GetSymbolTable(section_type);
   if (*symbol_table != NULL || build_map) {
     if (*symbol_table == NULL) {
@@ -772,8 +857,27 @@ size_t ElfFile::GetLoadedSize() const {
   return loaded_size;
 }
 
-bool ElfFile::Load(bool executable, std::string* error_msg) {
+int ElfFile::GetSegmentProtection(const Elf32_Phdr& program_header) const {
+  int prot = 0;
+  if (executable_ && ((program_header.p_flags & PF_X) != 0)) {
+    prot |= PROT_EXEC;
+  }
+  if ((program_header.p_flags & PF_W) != 0) {
+    prot |= PROT_WRITE;
+  }
+  if ((program_header.p_flags & PF_R) != 0) {
+    prot |= PROT_READ;
+  }
+  if (writable_) {
+    prot |= PROT_WRITE;
+  }
+  return prot;
+}
+
+bool ElfFile::Load(bool executable, ptrdiff_t load_bias, std::string* error_msg) {
   CHECK(program_header_only_) << file_->GetPath();
+  executable_ = executable;
+  base_address_ = reinterpret_cast<byte*>(load_bias);
 
   if (executable) {
     InstructionSet elf_ISA = kNone;
@@ -842,6 +946,11 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
     }
     size_t file_length = static_cast<size_t>(temp_file_length);
     if (program_header.p_vaddr == 0) {
+      if (load_bias != 0) {
+        *error_msg = StringPrintf("Failed to relocate '%s' which isn't linked at fixed addresses",
+                                  file_->GetPath().c_str());
+        return false;
+      }
       std::string reservation_name("ElfFile reservation for ");
       reservation_name += file_->GetPath();
       UniquePtr<MemMap> reserve(MemMap::MapAnonymous(reservation_name.c_str(),
@@ -860,23 +969,8 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
       continue;
     }
     byte* p_vaddr = base_address_ + program_header.p_vaddr;
-    int prot = 0;
-    if (executable && ((program_header.p_flags & PF_X) != 0)) {
-      prot |= PROT_EXEC;
-    }
-    if ((program_header.p_flags & PF_W) != 0) {
-      prot |= PROT_WRITE;
-    }
-    if ((program_header.p_flags & PF_R) != 0) {
-      prot |= PROT_READ;
-    }
-    int flags = 0;
-    if (writable_) {
-      prot |= PROT_WRITE;
-      flags |= MAP_SHARED;
-    } else {
-      flags |= MAP_PRIVATE;
-    }
+    int prot = GetSegmentProtection(program_header);
+    int flags = writable_ ? MAP_SHARED : MAP_PRIVATE;
     if (file_length < (program_header.p_offset + program_header.p_memsz)) {
       *error_msg = StringPrintf("File size of %zd bytes not large enough to contain ELF segment "
                                 "%d of %d bytes: '%s'", file_length, i,
@@ -921,6 +1015,15 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
         hash_section_start_ = reinterpret_cast<Elf32_Word*>(d_ptr);
         break;
       }
+      case DT_GNU_HASH: {
+        if (!ValidPointer(d_ptr)) {
+          *error_msg = StringPrintf("DT_GNU_HASH value %p does not refer to a loaded ELF segment "
+                                    "of %s", d_ptr, file_->GetPath().c_str());
+          return false;
+        }
+        gnu_hash_section_start_ = reinterpret_cast<Elf32_Word*>(d_ptr);
+        break;
+      }
       case DT_STRTAB: {
         if (!ValidPointer(d_ptr)) {
           *error_msg = StringPrintf("DT_HASH value %p does not refer to a loaded ELF segment of %s",
@@ -959,6 +1062,29 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
   return true;
 }
 
+bool ElfFile::SetWritable(bool writable, std::string* error_msg) {
+  CHECK(program_header_only_) << file_->GetPath();
+  for (Elf32_Word i = 0; i < GetProgramHeaderNum(); i++) {
+    Elf32_Phdr& program_header = GetProgramHeader(i);
+    if (program_header.p_type != PT_LOAD || program_header.p_memsz == 0) {
+      continue;
+    }
+    byte* begin = AlignDown(base_address_ + program_header.p_vaddr, kPageSize);
+    byte* end = AlignUp(base_address_ + program_header.p_vaddr + program_header.p_memsz,
+                        kPageSize);
+    int prot = GetSegmentProtection(program_header);
+    if (writable) {
+      prot |= PROT_WRITE;
+    }
+    if (mprotect(begin, end - begin, prot) != 0) {
+      *error_msg = StringPrintf("Failed to change the protection of ELF file segment %d from %s: "
+                                "%s", i, file_->GetPath().c_str(), strerror(errno));
+      return false;
+    }
+  }
+  return true;
+}
+
 bool ElfFile::ValidPointer(const byte* start) const {
   for (size_t i = 0; i < segments_.size(); ++i) {
     const MemMap* segment = segments_[i];
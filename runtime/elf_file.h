@@ -73,7 +73,7 @@ class ElfFile {
 
   Elf32_Shdr& GetSectionNameStringSection() const;
 
-  // Find .dynsym using .hash for more efficient lookup than FindSymbolAddress.
+  // Find .dynsym using .gnu.hash or .hash for more efficient lookup than FindSymbolAddress.
   const byte* FindDynamicSymbolAddress(const std::string& symbol_name) const;
 
   static bool IsSymbolSectionType(Elf32_Word section_type);
@@ -82,12 +82,11 @@ class ElfFile {
 
   // Find symbol in specified table, returning NULL if it is not found.
   //
-  // If build_map is true, builds a map to speed repeated access. The
-  // map does not included untyped symbol values (aka STT_NOTYPE)
-  // since they can contain duplicates. If build_map is false, the map
-  // will be used if it was already created. Typically build_map
-  // should be set unless only a small number of symbols will be
-  // looked up.
+  // The .dynsym symbols are looked up through .gnu.hash or .hash, when the file has one of these,
+  // and build_map is ignored. Otherwise if build_map is true, builds a map to speed repeated
+  // access. The map does not included untyped symbol values (aka STT_NOTYPE) since they can
+  // contain duplicates. If build_map is false, the map will be used if it was already created.
+  // Typically build_map should be set unless only a small number of symbols will be looked up.
   Elf32_Sym* FindSymbolByName(Elf32_Word section_type,
                               const std::string& symbol_name,
                               bool build_map);
@@ -119,8 +118,13 @@ class ElfFile {
   size_t GetLoadedSize() const;
 
   // Load segments into memory based on PT_LOAD program headers.
-  // executable is true at run time, false at compile time.
-  bool Load(bool executable, std::string* error_msg);
+  // executable is true at run time, false at compile time. A file linked at fixed addresses is
+  // loaded load_bias bytes away from them, its addresses are then relocated by the caller.
+  bool Load(bool executable, ptrdiff_t load_bias, std::string* error_msg);
+
+  // Adds write access to the loaded segments so that relocations can be applied to them, or
+  // restores the protection Load gave them.
+  bool SetWritable(bool writable, std::string* error_msg);
 
  private:
   ElfFile(File* file, bool writable, bool program_header_only);
@@ -129,6 +133,9 @@ class ElfFile {
 
   bool SetMap(MemMap* map, std::string* error_msg);
 
+  // The protection of a loaded PT_LOAD segment.
+  int GetSegmentProtection(const Elf32_Phdr& program_header) const;
+
   byte* GetProgramHeadersStart() const;
   byte* GetSectionHeadersStart() const;
   Elf32_Phdr& GetDynamicProgramHeader() const;
@@ -143,6 +150,12 @@ class ElfFile {
   Elf32_Word GetHashBucket(size_t i) const;
   Elf32_Word GetHashChain(size_t i) const;
 
+  // Looks symbol_name up in .dynsym through .gnu.hash, or else .hash. Returns NULL if it is not
+  // found, or if there is no hash section.
+  Elf32_Sym* FindDynamicSymbol(const std::string& symbol_name) const;
+  Elf32_Sym* FindDynamicSymbolByGnuHash(const std::string& symbol_name) const;
+  Elf32_Sym* FindDynamicSymbolByHash(const std::string& symbol_name) const;
+
   typedef std::map<std::string, Elf32_Sym*> SymbolTable;
   SymbolTable** GetSymbolTable(Elf32_Word section_type);
 
@@ -151,6 +164,8 @@ class ElfFile {
   const File* const file_;
   const bool writable_;
   const bool program_header_only_;
+  // Whether the segments were loaded executable.
+  bool executable_;
 
   // ELF header mapping. If program_header_only_ is false, will
   // actually point to the entire elf file.
@@ -174,8 +189,10 @@ class ElfFile {
   char* strtab_section_start_;
   char* dynstr_section_start_;
   Elf32_Word* hash_section_start_;
+  Elf32_Word* gnu_hash_section_start_;
 
   SymbolTable* symtab_symbol_table_;
+  // Only built for a .dynsym without a hash section.
   SymbolTable* dynsym_symbol_table_;
 
   // Support for GDB JIT
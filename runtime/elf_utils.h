@@ -42,6 +42,9 @@
 #define DT_FINI_ARRAYSZ 28
 #define DT_RUNPATH 29
 #define DT_FLAGS 30
+#define DT_GNU_HASH 0x6ffffef5
+
+#define SHT_GNU_HASH 0x6ffffff6
 
 /* MIPS dependent d_tag field for Elf32_Dyn.  */
 #define DT_MIPS_RLD_VERSION  0x70000001 /* Runtime Linker Interface ID */
@@ -135,7 +135,11 @@ ALWAYS_INLINE static inline mirror::Object* AllocObjectFromCode(uint32_t type_id
     return klass->Alloc<kInstrumented>(self, Runtime::Current()->GetHeap()->GetCurrentAllocator());
   }
   DCHECK(klass != nullptr);
-  return klass->Alloc<kInstrumented>(self, allocator_type);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Object* obj =
+      klass->Alloc<kInstrumented>(self, heap->GetAllocatorForSite(method, klass, allocator_type));
+  heap->RecordAllocationSite(method, obj);
+  return obj;
 }
 
 // Given the context of a calling Method and a resolved class, create an instance.
@@ -158,7 +162,11 @@ ALWAYS_INLINE static inline mirror::Object* AllocObjectFromCodeResolved(mirror::
     return klass->Alloc<kInstrumented, false>(self, heap->GetCurrentAllocator());
   }
   // Pass in false since the object can not be finalizable.
-  return klass->Alloc<kInstrumented, false>(self, allocator_type);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Object* obj = klass->Alloc<kInstrumented, false>(
+      self, heap->GetAllocatorForSite(method, klass, allocator_type));
+  heap->RecordAllocationSite(method, obj);
+  return obj;
 }
 
 // Given the context of a calling Method and an initialized class, create an instance.
@@ -171,7 +179,11 @@ ALWAYS_INLINE static inline mirror::Object* AllocObjectFromCodeInitialized(mirro
     NO_THREAD_SAFETY_ANALYSIS {
   DCHECK(klass != nullptr);
   // Pass in false since the object can not be finalizable.
-  return klass->Alloc<kInstrumented, false>(self, allocator_type);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Object* obj = klass->Alloc<kInstrumented, false>(
+      self, heap->GetAllocatorForSite(method, klass, allocator_type));
+  heap->RecordAllocationSite(method, obj);
+  return obj;
 }
 
 
@@ -232,8 +244,12 @@ ALWAYS_INLINE static inline mirror::Array* AllocArrayFromCode(uint32_t type_idx,
                                                klass->GetComponentSize(),
                                                heap->GetCurrentAllocator());
   }
-  return mirror::Array::Alloc<kInstrumented>(self, klass, component_count,
-                                             klass->GetComponentSize(), allocator_type);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Array* array = mirror::Array::Alloc<kInstrumented>(
+      self, klass, component_count, klass->GetComponentSize(),
+      heap->GetAllocatorForSite(method, klass, allocator_type));
+  heap->RecordAllocationSite(method, array);
+  return array;
 }
 
 template <bool kAccessCheck, bool kInstrumented>
@@ -257,8 +273,12 @@ ALWAYS_INLINE static inline mirror::Array* AllocArrayFromCodeResolved(mirror::Cl
   }
   // No need to retry a slow-path allocation as the above code won't cause a GC or thread
   // suspension.
-  return mirror::Array::Alloc<kInstrumented>(self, klass, component_count,
-                                             klass->GetComponentSize(), allocator_type);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Array* array = mirror::Array::Alloc<kInstrumented>(
+      self, klass, component_count, klass->GetComponentSize(),
+      heap->GetAllocatorForSite(method, klass, allocator_type));
+  heap->RecordAllocationSite(method, array);
+  return array;
 }
 
 extern mirror::Array* CheckAndAllocArrayFromCode(uint32_t type_idx, mirror::ArtMethod* method,
@@ -457,8 +477,7 @@ static inline mirror::ArtMethod* FindMethodFromCode(uint32_t method_idx,
     }
     case kInterface: {
       uint32_t imt_index = resolved_method->GetDexMethodIndex() % ClassLinker::kImtSize;
-      mirror::ObjectArray<mirror::ArtMethod>* imt_table = sirt_this->GetClass()->GetImTable();
-      mirror::ArtMethod* imt_method = imt_table->Get(imt_index);
+      mirror::ArtMethod* imt_method = sirt_this->GetClass()->GetEmbeddedImTableEntry(imt_index);
       if (!imt_method->IsImtConflictMethod()) {
         return imt_method;
       } else {
@@ -16,26 +16,23 @@
 
 #include "base/logging.h"
 #include "entrypoints/entrypoint_utils.h"
+#include "jni_internal.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/object-inl.h"
 #include "object_utils.h"
+#include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
 
 namespace art {
 
-// Used by the JNI dlsym stub to find the native method to invoke if none is registered.
-extern "C" void* artFindNativeMethod() {
-  Thread* self = Thread::Current();
-  Locks::mutator_lock_->AssertNotHeld(self);  // We come here as Native.
-  ScopedObjectAccess soa(self);
-
+static void* FindNativeMethod(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   mirror::ArtMethod* method = self->GetCurrentMethod(NULL);
   DCHECK(method != NULL);
 
   // Lookup symbol address for method, on failure we'll return NULL with an exception set,
   // otherwise we return the address of the method we found.
-  void* native_code = soa.Vm()->FindCodeForNativeMethod(method);
+  void* native_code = Runtime::Current()->GetJavaVM()->FindCodeForNativeMethod(method);
   if (native_code == NULL) {
     DCHECK(self->IsExceptionPending());
     return NULL;
@@ -46,4 +43,18 @@ extern "C" void* artFindNativeMethod() {
   }
 }
 
+// Used by the JNI dlsym stub to find the native method to invoke if none is registered.
+// TODO: NO_THREAD_SAFETY_ANALYSIS due to different control paths depending on fast JNI.
+extern "C" void* artFindNativeMethod() NO_THREAD_SAFETY_ANALYSIS {
+  Thread* self = Thread::Current();
+  if (self->GetState() == kRunnable) {
+    // Fast and critical natives come here without leaving Runnable.
+    Locks::mutator_lock_->AssertSharedHeld(self);
+    return FindNativeMethod(self);
+  }
+  Locks::mutator_lock_->AssertNotHeld(self);  // We come here as Native.
+  ScopedObjectAccess soa(self);
+  return FindNativeMethod(self);
+}
+
 }  // namespace art
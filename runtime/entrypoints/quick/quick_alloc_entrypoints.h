@@ -17,11 +17,20 @@
 #ifndef ART_RUNTIME_ENTRYPOINTS_QUICK_QUICK_ALLOC_ENTRYPOINTS_H_
 #define ART_RUNTIME_ENTRYPOINTS_QUICK_QUICK_ALLOC_ENTRYPOINTS_H_
 
+#include "asm_support.h"
 #include "gc/heap.h"
 #include "quick_entrypoints.h"
 
 namespace art {
 
+// Whether the non-instrumented TLAB entrypoints allocate objects of resolved classes without
+// calling into the runtime, bypassing Heap::AllocObjectWithAllocator.
+#ifdef QUICK_TLAB_ALLOC_FAST_PATH
+static constexpr bool kQuickTlabAllocFastPath = true;
+#else
+static constexpr bool kQuickTlabAllocFastPath = false;
+#endif
+
 namespace gc {
 enum AllocatorType;
 }  // namespace gc
@@ -118,6 +118,7 @@ struct PACKED(4) QuickEntryPoints {
   int32_t (*pIndexOf)(void*, uint32_t, uint32_t, uint32_t);
   int32_t (*pMemcmp16)(void*, void*, int32_t);
   int32_t (*pStringCompareTo)(void*, void*);
+  uint32_t (*pStringEquals)(void*, void*);
   void* (*pMemcpy)(void*, const void*, size_t);
 
   // Invocation
@@ -141,6 +142,9 @@ struct PACKED(4) QuickEntryPoints {
   void (*pThrowNoSuchMethod)(int32_t);
   void (*pThrowNullPointer)();
   void (*pThrowStackOverflow)(void*);
+
+  // Read barrier, null unless the concurrent copying collector is marking.
+  mirror::Object* (*pReadBarrierMark)(mirror::Object*);
 };
 
 
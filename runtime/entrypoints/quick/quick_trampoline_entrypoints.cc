@@ -1167,12 +1167,13 @@ class ComputeGenericJniFrameSize FINAL {
   }
 
   // WARNING: After this, *sp won't be pointing to the method anymore!
-  void ComputeLayout(mirror::ArtMethod*** m, bool is_static, const char* shorty, uint32_t shorty_len,
-                     void* sp, StackIndirectReferenceTable** table, uint32_t* sirt_entries,
+  void ComputeLayout(mirror::ArtMethod*** m, bool is_static, bool is_critical_native,
+                     const char* shorty, uint32_t shorty_len, void* sp,
+                     StackIndirectReferenceTable** table, uint32_t* sirt_entries,
                      uintptr_t** start_stack, uintptr_t** start_gpr, uint32_t** start_fpr,
                      void** code_return, size_t* overall_size)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    ComputeAll(is_static, shorty, shorty_len);
+    ComputeAll(is_static, is_critical_native, shorty, shorty_len);
 
     mirror::ArtMethod* method = **m;
 
@@ -1231,15 +1232,21 @@ class ComputeGenericJniFrameSize FINAL {
 
   void ComputeSirtOffset() { }  // nothing to do, static right now
 
-  void ComputeAll(bool is_static, const char* shorty, uint32_t shorty_len)
+  void ComputeAll(bool is_static, bool is_critical_native, const char* shorty,
+                  uint32_t shorty_len)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     BuildGenericJniFrameStateMachine<ComputeGenericJniFrameSize> sm(this);
 
-    // JNIEnv
-    sm.AdvancePointer(nullptr);
+    if (!is_critical_native) {
+      // JNIEnv
+      sm.AdvancePointer(nullptr);
 
-    // Class object or this as first argument
-    sm.AdvanceSirt(reinterpret_cast<mirror::Object*>(0x12345678));
+      // Class object or this as first argument
+      sm.AdvanceSirt(reinterpret_cast<mirror::Object*>(0x12345678));
+    } else {
+      // The class is still held in the SIRT, it is only not passed.
+      PushSirt(nullptr);
+    }
 
     for (uint32_t i = 1; i < shorty_len; ++i) {
       Primitive::Type cur_type_ = Primitive::GetType(shorty[i]);
@@ -1302,16 +1309,22 @@ class ComputeGenericJniFrameSize FINAL {
 // of transitioning into native code.
 class BuildGenericJniFrameVisitor FINAL : public QuickArgumentVisitor {
  public:
-  BuildGenericJniFrameVisitor(mirror::ArtMethod*** sp, bool is_static, const char* shorty,
-                              uint32_t shorty_len, Thread* self) :
+  BuildGenericJniFrameVisitor(mirror::ArtMethod*** sp, bool is_static, bool is_critical_native,
+                              const char* shorty, uint32_t shorty_len, Thread* self) :
       QuickArgumentVisitor(*sp, is_static, shorty, shorty_len), sm_(this) {
     ComputeGenericJniFrameSize fsc;
-    fsc.ComputeLayout(sp, is_static, shorty, shorty_len, *sp, &sirt_, &sirt_expected_refs_,
-                      &cur_stack_arg_, &cur_gpr_reg_, &cur_fpr_reg_, &code_return_,
-                      &alloca_used_size_);
+    fsc.ComputeLayout(sp, is_static, is_critical_native, shorty, shorty_len, *sp, &sirt_,
+                      &sirt_expected_refs_, &cur_stack_arg_, &cur_gpr_reg_, &cur_fpr_reg_,
+                      &code_return_, &alloca_used_size_);
     sirt_number_of_references_ = 0;
     cur_sirt_entry_ = reinterpret_cast<StackReference<mirror::Object>*>(GetFirstSirtEntry());
 
+    if (is_critical_native) {
+      // Neither the jni environment nor the class are arguments of a critical native.
+      PushSirt((**sp)->GetDeclaringClass());
+      return;
+    }
+
     // jni environment is always first argument
     sm_.AdvancePointer(self->GetJniEnv());
 
@@ -1486,8 +1499,8 @@ extern "C" ssize_t artQuickGenericJniTrampoline(Thread* self, mirror::ArtMethod*
   // run the visitor
   MethodHelper mh(called);
 
-  BuildGenericJniFrameVisitor visitor(&sp, called->IsStatic(), mh.GetShorty(), mh.GetShortyLength(),
-                                      self);
+  BuildGenericJniFrameVisitor visitor(&sp, called->IsStatic(), called->IsCriticalNative(),
+                                      mh.GetShorty(), mh.GetShortyLength(), self);
   visitor.VisitArguments();
   visitor.FinalizeSirt(self);
 
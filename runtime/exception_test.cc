@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "catch_handler_cache.h"
 #include "class_linker.h"
 #include "common_runtime_test.h"
 #include "dex_file.h"
@@ -153,6 +154,47 @@ TEST_F(ExceptionTest, FindCatchHandler) {
   }
 }
 
+TEST_F(ExceptionTest, FindCatchBlockIsCached) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile::CodeItem* code_item = dex_->GetCodeItem(method_f_->GetCodeItemOffset());
+  ASSERT_TRUE(code_item != NULL);
+  CatchHandlerIterator iter(*code_item, 4 /* Dex PC in the first try block */);
+  uint32_t io_exception_handler = iter.GetHandlerAddress();
+  iter.Next();
+  uint32_t exception_handler = iter.GetHandlerAddress();
+
+  SirtRef<mirror::Class> io_exception(soa.Self(),
+                                      class_linker_->FindSystemClass(soa.Self(),
+                                                                     "Ljava/io/IOException;"));
+  SirtRef<mirror::Class> runtime_exception(
+      soa.Self(), class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/RuntimeException;"));
+  SirtRef<mirror::Class> error(soa.Self(),
+                               class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Error;"));
+  ASSERT_TRUE(io_exception.get() != NULL);
+  ASSERT_TRUE(runtime_exception.get() != NULL);
+  ASSERT_TRUE(error.get() != NULL);
+
+  CatchHandlerCache* cache = soa.Self()->GetCatchHandlerCache();
+  uint32_t cached_dex_pc;
+  // The answers are the same whether they come from the try items or from the cache.
+  for (size_t i = 0; i < 2; ++i) {
+    bool has_no_move_exception = false;
+    EXPECT_EQ(io_exception_handler,
+              method_f_->FindCatchBlock(io_exception, 4, &has_no_move_exception));
+    ASSERT_TRUE(cache->Lookup(method_f_, 4, io_exception.get(), &cached_dex_pc));
+    EXPECT_EQ(io_exception_handler, cached_dex_pc);
+    EXPECT_EQ(exception_handler,
+              method_f_->FindCatchBlock(runtime_exception, 4, &has_no_move_exception));
+    EXPECT_EQ(DexFile::kDexNoIndex, method_f_->FindCatchBlock(error, 4, &has_no_move_exception));
+    ASSERT_TRUE(cache->Lookup(method_f_, 4, error.get(), &cached_dex_pc));
+    EXPECT_EQ(DexFile::kDexNoIndex, cached_dex_pc);
+  }
+  // Methods without try items don't use the cache.
+  bool has_no_move_exception = false;
+  EXPECT_EQ(DexFile::kDexNoIndex, method_g_->FindCatchBlock(error, 0, &has_no_move_exception));
+  EXPECT_FALSE(cache->Lookup(method_g_, 0, error.get(), &cached_dex_pc));
+}
+
 TEST_F(ExceptionTest, StackTraceElement) {
   Thread* thread = Thread::Current();
   thread->TransitionFromSuspendedToRunnable();
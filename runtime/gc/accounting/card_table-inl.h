@@ -17,6 +17,14 @@
 #ifndef ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 #define ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "base/logging.h"
 #include "card_table.h"
 #include "cutils/atomic-inline.h"
@@ -42,6 +50,53 @@ static inline bool byte_cas(byte old_value, byte new_value, byte* address) {
   return success;
 }
 
+inline byte* CardTable::SkipCleanCards(byte* card_begin, byte* card_end) {
+  DCHECK(IsAligned<sizeof(uintptr_t)>(card_begin));
+  DCHECK(IsAligned<sizeof(uintptr_t)>(card_end));
+  byte* card_cur = card_begin;
+  // Clean cards are zero, so a vector of cards is clean when it compares equal to zero.
+#if defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  while (card_end - card_cur >= static_cast<ptrdiff_t>(sizeof(__m256i))) {
+    const __m256i cards = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(card_cur));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(cards, zero)) != -1) {
+      break;
+    }
+    card_cur += sizeof(__m256i);
+  }
+#elif defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  while (card_end - card_cur >= static_cast<ptrdiff_t>(sizeof(__m128i))) {
+    const __m128i cards = _mm_loadu_si128(reinterpret_cast<const __m128i*>(card_cur));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(cards, zero)) != 0xFFFF) {
+      break;
+    }
+    card_cur += sizeof(__m128i);
+  }
+#elif defined(__aarch64__)
+  while (card_end - card_cur >= static_cast<ptrdiff_t>(sizeof(uint8x16_t))) {
+    if (vmaxvq_u8(vld1q_u8(card_cur)) != 0) {
+      break;
+    }
+    card_cur += sizeof(uint8x16_t);
+  }
+#elif defined(__ARM_NEON__)
+  while (card_end - card_cur >= static_cast<ptrdiff_t>(sizeof(uint8x16_t))) {
+    const uint8x16_t cards = vld1q_u8(card_cur);
+    const uint8x8_t folded = vorr_u8(vget_low_u8(cards), vget_high_u8(cards));
+    if (vget_lane_u64(vreinterpret_u64_u8(folded), 0) != 0) {
+      break;
+    }
+    card_cur += sizeof(uint8x16_t);
+  }
+#endif
+  // Finish with words, this also finds the first non clean word of a non clean vector.
+  while (card_cur < card_end && *reinterpret_cast<uintptr_t*>(card_cur) == 0) {
+    card_cur += sizeof(uintptr_t);
+  }
+  return card_cur;
+}
+
 template <typename Visitor>
 inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, byte* scan_end,
                               const Visitor& visitor, const byte minimum_age) const {
@@ -69,11 +124,10 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, b
   uintptr_t* word_end = reinterpret_cast<uintptr_t*>(aligned_end);
   for (uintptr_t* word_cur = reinterpret_cast<uintptr_t*>(card_cur); word_cur < word_end;
       ++word_cur) {
-    while (LIKELY(*word_cur == 0)) {
-      ++word_cur;
-      if (UNLIKELY(word_cur >= word_end)) {
-        goto exit_for;
-      }
+    word_cur = reinterpret_cast<uintptr_t*>(SkipCleanCards(reinterpret_cast<byte*>(word_cur),
+                                                           aligned_end));
+    if (UNLIKELY(word_cur >= word_end)) {
+      break;
     }
 
     // Find the first dirty card.
@@ -93,7 +147,6 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, b
       start += kCardSize;
     }
   }
-  exit_for:
 
   // Handle any unaligned cards at the end.
   card_cur = reinterpret_cast<byte*>(word_end);
@@ -166,6 +219,13 @@ inline void CardTable::ModifyCardsAtomic(byte* scan_begin, byte* scan_end, const
 
   // TODO: Parallelize.
   while (word_cur < word_end) {
+    // The cards are only read to skip the clean ones, the mutators may dirty cards concurrently so
+    // the cards which need modifying are still changed with a word CAS.
+    word_cur = reinterpret_cast<uintptr_t*>(SkipCleanCards(reinterpret_cast<byte*>(word_cur),
+                                                           reinterpret_cast<byte*>(word_end)));
+    if (UNLIKELY(word_cur >= word_end)) {
+      break;
+    }
     while (true) {
       expected_word = *word_cur;
       if (LIKELY(expected_word == 0)) {
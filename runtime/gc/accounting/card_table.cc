@@ -55,9 +55,9 @@ CardTable* CardTable::Create(const byte* heap_begin, size_t heap_capacity) {
   size_t capacity = heap_capacity / kCardSize;
   /* Allocate an extra 256 bytes to allow fixed low-byte of base */
   std::string error_msg;
-  UniquePtr<MemMap> mem_map(MemMap::MapAnonymous("card table", NULL,
-                                                 capacity + 256, PROT_READ | PROT_WRITE,
-                                                 false, &error_msg));
+  // The table covers the whole heap reservation, its pages are only committed once a card in them
+  // is dirtied, so a heap which stays far below its growth limit doesn't pay for the rest.
+  UniquePtr<MemMap> mem_map(MemMap::MapAnonymousLazy("card table", capacity + 256, &error_msg));
   CHECK(mem_map.get() != NULL) << "couldn't allocate card table: " << error_msg;
   // All zeros is the correct initial value; all clean. Anonymous mmaps are initialized to zero, we
   // don't clear the card table to avoid unnecessary pages being allocated
@@ -108,6 +108,10 @@ class CardTable {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Returns the first card between card_begin and card_end which is not clean, or card_end if they
+  // are all clean. Both must be word aligned. Uses vector instructions when available.
+  static byte* SkipCleanCards(byte* card_begin, byte* card_end) ALWAYS_INLINE;
+
   // Assertion used to check the given address is covered by the card table
   void CheckAddrIsInCardTable(const byte* addr) const;
 
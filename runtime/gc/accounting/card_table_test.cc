@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "card_table.h"
+
+#include <stdint.h>
+
+#include "card_table-inl.h"
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "globals.h"
+#include "UniquePtr.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class CardTableTest : public CommonRuntimeTest {
+ protected:
+  static constexpr size_t kHeapCapacity = 4 * MB;
+
+  CardTableTest() : heap_begin_(reinterpret_cast<byte*>(0x10000000)) {}
+
+  byte* heap_begin_;
+};
+
+class CountModifiedVisitor {
+ public:
+  explicit CountModifiedVisitor(size_t* count) : count_(count) {}
+
+  void operator()(byte* /*card*/, byte expected_value, byte new_value) const {
+    EXPECT_NE(expected_value, new_value);
+    ++*count_;
+  }
+
+ private:
+  size_t* const count_;
+};
+
+// Pseudo random card values, a third of the cards are not clean.
+static byte CardValueAt(size_t i) {
+  const size_t hash = (i * 2654435761U) >> 7;
+  switch (hash % 9) {
+    case 0:
+      return CardTable::kCardDirty;
+    case 1:
+      return CardTable::kCardDirty - 1;
+    case 2:
+      return 1;
+    default:
+      return CardTable::kCardClean;
+  }
+}
+
+TEST_F(CardTableTest, SkipCleanCards) {
+  UniquePtr<CardTable> card_table(CardTable::Create(heap_begin_, kHeapCapacity));
+  ASSERT_TRUE(card_table.get() != nullptr);
+  byte* card_begin = AlignUp(card_table->CardFromAddr(heap_begin_), sizeof(uintptr_t));
+  const size_t num_cards = 1024;
+  byte* card_end = card_begin + num_cards;
+  EXPECT_EQ(card_end, CardTable::SkipCleanCards(card_begin, card_end));
+  for (size_t i = 0; i < num_cards; ++i) {
+    card_begin[i] = CardTable::kCardDirty;
+    byte* expected = card_begin + RoundDown(i, sizeof(uintptr_t));
+    EXPECT_EQ(expected, CardTable::SkipCleanCards(card_begin, card_end)) << i;
+    card_begin[i] = CardTable::kCardClean;
+  }
+}
+
+TEST_F(CardTableTest, ModifyCardsAtomicAgesCards) {
+  UniquePtr<CardTable> card_table(CardTable::Create(heap_begin_, kHeapCapacity));
+  ASSERT_TRUE(card_table.get() != nullptr);
+  const size_t num_cards = kHeapCapacity / CardTable::kCardSize;
+  byte* card_begin = card_table->CardFromAddr(heap_begin_);
+  // Unaligned bounds exercise the scalar head and tail as well.
+  for (size_t begin_offset = 0; begin_offset < 2 * sizeof(uintptr_t); begin_offset += 3) {
+    for (size_t end_offset = 0; end_offset < 2 * sizeof(uintptr_t); end_offset += 5) {
+      size_t expected_modified = 0;
+      for (size_t i = 0; i < num_cards; ++i) {
+        card_begin[i] = CardValueAt(i + begin_offset + end_offset);
+      }
+      const size_t first = begin_offset;
+      const size_t last = num_cards - end_offset;
+      for (size_t i = first; i < last; ++i) {
+        if (AgeCardVisitor()(card_begin[i]) != card_begin[i]) {
+          ++expected_modified;
+        }
+      }
+      size_t modified = 0;
+      card_table->ModifyCardsAtomic(heap_begin_ + first * CardTable::kCardSize,
+                                    heap_begin_ + last * CardTable::kCardSize, AgeCardVisitor(),
+                                    CountModifiedVisitor(&modified));
+      EXPECT_EQ(expected_modified, modified);
+      for (size_t i = 0; i < num_cards; ++i) {
+        const byte old_value = CardValueAt(i + begin_offset + end_offset);
+        const byte expected = (i >= first && i < last) ? AgeCardVisitor()(old_value) : old_value;
+        ASSERT_EQ(expected, card_begin[i]) << i;
+      }
+    }
+  }
+}
+
+// Not a correctness test, logs how long aging a mostly clean card table takes.
+TEST_F(CardTableTest, BenchmarkModifyCardsAtomic) {
+  const size_t heap_capacity = 512 * MB;
+  UniquePtr<CardTable> card_table(CardTable::Create(heap_begin_, heap_capacity));
+  ASSERT_TRUE(card_table.get() != nullptr);
+  const size_t num_cards = heap_capacity / CardTable::kCardSize;
+  const size_t kIterations = 16;
+  uint64_t total_ns = 0;
+  for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+    // Dirty one card in 256, roughly what a sticky GC sees on a large heap.
+    for (size_t i = 0; i < num_cards; i += 256) {
+      card_table->MarkCard(heap_begin_ + i * CardTable::kCardSize);
+    }
+    const uint64_t start_ns = NanoTime();
+    size_t modified = 0;
+    card_table->ModifyCardsAtomic(heap_begin_, heap_begin_ + heap_capacity, AgeCardVisitor(),
+                                  CountModifiedVisitor(&modified));
+    total_ns += NanoTime() - start_ns;
+    EXPECT_EQ(num_cards / 256, modified);
+  }
+  LOG(INFO) << "Aged " << num_cards << " cards in " << PrettyDuration(total_ns / kIterations);
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -16,6 +16,9 @@
 
 #include "mod_union_table.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "base/stl_util.h"
 #include "card_table-inl.h"
 #include "heap_bitmap.h"
@@ -213,10 +216,89 @@ class ModUnionCheckReferences {
   const std::set<const Object*>& references_;
 };
 
+void ModUnionTableReferenceCache::SetCardReferences(const byte* card, ReferenceVector* refs) {
+  COMPILE_ASSERT(CardTable::kCardSize / sizeof(mirror::HeapReference<Object>) <= 32,
+                 card_references_do_not_fit_the_mask);
+  spanning_references_.erase(card);
+  if (refs->empty()) {
+    references_.erase(card);
+    return;
+  }
+  const uintptr_t card_begin =
+      reinterpret_cast<uintptr_t>(heap_->GetCardTable()->AddrFromCard(card));
+  const uintptr_t card_end = card_begin + CardTable::kCardSize;
+  std::sort(refs->begin(), refs->end());
+  CardReferences card_refs;
+  card_refs.in_card_mask = 0;
+  card_refs.num_spanning = 0;
+  card_refs.rescan = false;
+  std::vector<uint16_t> deltas;
+  uintptr_t prev = card_end;
+  for (mirror::HeapReference<Object>* ref : *refs) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(ref);
+    DCHECK_GE(addr, card_begin);
+    DCHECK_ALIGNED(addr, sizeof(mirror::HeapReference<Object>));
+    if (addr < card_end) {
+      card_refs.in_card_mask |= 1U << ((addr - card_begin) / sizeof(mirror::HeapReference<Object>));
+      continue;
+    }
+    const uintptr_t delta = (addr - prev) / sizeof(mirror::HeapReference<Object>);
+    if (deltas.size() == kMaxSpanningReferences || delta > std::numeric_limits<uint16_t>::max()) {
+      // Caching the references of a large object would cost more than rescanning it.
+      card_refs.rescan = true;
+      break;
+    }
+    deltas.push_back(delta);
+    prev = addr;
+  }
+  if (card_refs.rescan) {
+    card_refs.in_card_mask = 0;
+  } else if (!deltas.empty()) {
+    card_refs.num_spanning = deltas.size();
+    spanning_references_.Put(card, deltas);
+  }
+  references_.Overwrite(card, card_refs);
+}
+
+void ModUnionTableReferenceCache::ScanCard(const byte* card, ReferenceVector* refs) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(heap_->GetCardTable()->AddrFromCard(card));
+  uintptr_t end = start + CardTable::kCardSize;
+  auto* space = heap_->FindContinuousSpaceFromObject(reinterpret_cast<Object*>(start), false);
+  DCHECK(space != nullptr);
+  ModUnionReferenceVisitor add_visitor(this, refs);
+  space->GetLiveBitmap()->VisitMarkedRange(start, end, add_visitor);
+}
+
+void ModUnionTableReferenceCache::GetCardReferences(const byte* card,
+                                                    const CardReferences& card_refs,
+                                                    ReferenceVector* refs) {
+  if (card_refs.rescan) {
+    ScanCard(card, refs);
+    return;
+  }
+  byte* card_begin = reinterpret_cast<byte*>(heap_->GetCardTable()->AddrFromCard(card));
+  auto* ref_begin = reinterpret_cast<mirror::HeapReference<Object>*>(card_begin);
+  for (uint32_t mask = card_refs.in_card_mask; mask != 0; mask &= mask - 1) {
+    refs->push_back(ref_begin + CTZ(mask));
+  }
+  if (card_refs.num_spanning != 0) {
+    auto* ref = reinterpret_cast<mirror::HeapReference<Object>*>(card_begin + CardTable::kCardSize);
+    const std::vector<uint16_t>& deltas = spanning_references_.Get(card);
+    DCHECK_EQ(deltas.size(), card_refs.num_spanning);
+    for (uint16_t delta : deltas) {
+      ref += delta;
+      refs->push_back(ref);
+    }
+  }
+}
+
 void ModUnionTableReferenceCache::Verify() {
   // Start by checking that everything in the mod union table is marked.
+  ReferenceVector card_references;
   for (const auto& ref_pair : references_) {
-    for (mirror::HeapReference<Object>* ref : ref_pair.second) {
+    card_references.clear();
+    GetCardReferences(ref_pair.first, ref_pair.second, &card_references);
+    for (mirror::HeapReference<Object>* ref : card_references) {
       CHECK(heap_->IsLiveObjectLocked(ref->AsMirrorPtr()));
     }
   }
@@ -227,8 +309,10 @@ void ModUnionTableReferenceCache::Verify() {
   for (const auto& ref_pair : references_) {
     const byte* card = ref_pair.first;
     if (*card == CardTable::kCardClean) {
+      card_references.clear();
+      GetCardReferences(card, ref_pair.second, &card_references);
       std::set<const Object*> reference_set;
-      for (mirror::HeapReference<Object>* obj_ptr : ref_pair.second) {
+      for (mirror::HeapReference<Object>* obj_ptr : card_references) {
         reference_set.insert(obj_ptr->AsMirrorPtr());
       }
       ModUnionCheckReferences visitor(this, reference_set);
@@ -247,12 +331,15 @@ void ModUnionTableReferenceCache::Dump(std::ostream& os) {
     os << reinterpret_cast<void*>(start) << "-" << reinterpret_cast<void*>(end) << ",";
   }
   os << "]\nModUnionTable references: [";
+  ReferenceVector card_references;
   for (const auto& ref_pair : references_) {
     const byte* card_addr = ref_pair.first;
     uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card_addr));
     uintptr_t end = start + CardTable::kCardSize;
     os << reinterpret_cast<void*>(start) << "-" << reinterpret_cast<void*>(end) << "->{";
-    for (mirror::HeapReference<Object>* ref : ref_pair.second) {
+    card_references.clear();
+    GetCardReferences(card_addr, ref_pair.second, &card_references);
+    for (mirror::HeapReference<Object>* ref : card_references) {
       os << reinterpret_cast<const void*>(ref->AsMirrorPtr()) << ",";
     }
     os << "},";
@@ -261,43 +348,27 @@ void ModUnionTableReferenceCache::Dump(std::ostream& os) {
 
 void ModUnionTableReferenceCache::UpdateAndMarkReferences(MarkHeapReferenceCallback* callback,
                                                           void* arg) {
-  CardTable* card_table = heap_->GetCardTable();
-
-  std::vector<mirror::HeapReference<Object>*> cards_references;
-  ModUnionReferenceVisitor add_visitor(this, &cards_references);
-
+  ReferenceVector cards_references;
   for (const auto& card : cleared_cards_) {
     // Clear and re-compute alloc space references associated with this card.
     cards_references.clear();
-    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card));
-    uintptr_t end = start + CardTable::kCardSize;
-    auto* space = heap_->FindContinuousSpaceFromObject(reinterpret_cast<Object*>(start), false);
-    DCHECK(space != nullptr);
-    ContinuousSpaceBitmap* live_bitmap = space->GetLiveBitmap();
-    live_bitmap->VisitMarkedRange(start, end, add_visitor);
-
+    ScanCard(card, &cards_references);
     // Update the corresponding references for the card.
-    auto found = references_.find(card);
-    if (found == references_.end()) {
-      if (cards_references.empty()) {
-        // No reason to add empty array.
-        continue;
-      }
-      references_.Put(card, cards_references);
-    } else {
-      found->second = cards_references;
-    }
+    SetCardReferences(card, &cards_references);
   }
   cleared_cards_.clear();
   size_t count = 0;
-  for (const auto& ref : references_) {
-    for (mirror::HeapReference<Object>* obj_ptr : ref.second) {
+  for (const auto& ref_pair : references_) {
+    cards_references.clear();
+    GetCardReferences(ref_pair.first, ref_pair.second, &cards_references);
+    for (mirror::HeapReference<Object>* obj_ptr : cards_references) {
       callback(obj_ptr, arg);
     }
-    count += ref.second.size();
+    count += cards_references.size();
   }
   if (VLOG_IS_ON(heap)) {
-    VLOG(gc) << "Marked " << count << " references in mod union table";
+    VLOG(gc) << "Marked " << count << " references in mod union table, "
+             << references_.size() << " cards cached";
   }
 }
 
@@ -94,6 +94,10 @@ class ModUnionTable {
 };
 
 // Reference caching implementation. Caches references pointing to alloc space(s) for each card.
+// The references are stored as offsets from the card begin rather than as pointers: a bit mask for
+// the references inside the card and delta encoded offsets for the fields of an object which
+// spans past the end of the card. Cards with too many spanning references are rescanned instead,
+// like ModUnionTableCardCache does.
 class ModUnionTableReferenceCache : public ModUnionTable {
  public:
   explicit ModUnionTableReferenceCache(const std::string& name, Heap* heap,
@@ -118,16 +122,46 @@ class ModUnionTableReferenceCache : public ModUnionTable {
   // Function that tells whether or not to add a reference to the table.
   virtual bool ShouldAddReference(const mirror::Object* ref) const = 0;
 
-  void Dump(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Cards which are rescanned need the live bitmap, the heap verification which dumps the table
+  // holds the heap bitmap lock.
+  void Dump(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Number of references past the end of a card above which the card is rescanned instead.
+  static constexpr size_t kMaxSpanningReferences = 32;
 
  protected:
+  // The encoded references of a card.
+  struct CardReferences {
+    // Bit i is set if the i-th heap reference of the card is cached.
+    uint32_t in_card_mask;
+    // Number of deltas of the card in spanning_references_.
+    uint16_t num_spanning;
+    // The card has too many spanning references to cache, its objects are rescanned.
+    bool rescan;
+  };
+
+  typedef std::vector<mirror::HeapReference<mirror::Object>*> ReferenceVector;
+
+  // Replace the cached references of card with refs, which is sorted in the process.
+  void SetCardReferences(const byte* card, ReferenceVector* refs);
+  // Decode the references of a card, rescanning it if needed.
+  void GetCardReferences(const byte* card, const CardReferences& card_refs, ReferenceVector* refs)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+  // Collect the references of the objects starting in card which ShouldAddReference accepts.
+  void ScanCard(const byte* card, ReferenceVector* refs)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
   // Cleared card array, used to update the mod-union table.
   ModUnionTable::CardSet cleared_cards_;
 
   // Maps from dirty cards to their corresponding alloc space references.
-  SafeMap<const byte*, std::vector<mirror::HeapReference<mirror::Object>*>, std::less<const byte*>,
-      GcAllocator<std::pair<const byte*, std::vector<mirror::HeapReference<mirror::Object>*> > > >
-      references_;
+  SafeMap<const byte*, CardReferences, std::less<const byte*>,
+      GcAllocator<std::pair<const byte*, CardReferences> > > references_;
+
+  // Offsets of the references past the end of their card, in heap references. The first delta is
+  // from the end of the card, the following ones from the previous reference.
+  SafeMap<const byte*, std::vector<uint16_t>, std::less<const byte*>,
+      GcAllocator<std::pair<const byte*, std::vector<uint16_t> > > > spanning_references_;
 };
 
 // Card caching implementation. Keeps track of which cards we cleared and only this information.
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_SEGMENTED_STACK_H_
+#define ART_RUNTIME_GC_ACCOUNTING_SEGMENTED_STACK_H_
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "thread.h"
+
+namespace art {
+
+namespace mirror {
+  class Object;
+}  // namespace mirror
+
+namespace gc {
+namespace accounting {
+
+// A stack made of page sized segments linked together. Unlike an AtomicStack it never overflows:
+// when the top segment is full another one is linked on top of it, so that growing never copies
+// the elements already pushed. Whole segments can be detached and handed to other threads, which
+// is how the parallel mark tasks share their work without copying it either.
+//
+// The stack itself is not thread safe, the segments come from a Pool which is.
+template <typename T>
+class SegmentedStack {
+ public:
+  class Segment {
+   public:
+    // Number of elements in a segment, chosen so that a segment fills a page.
+    static constexpr size_t kCapacity = (kPageSize - 2 * sizeof(void*)) / sizeof(T);
+
+    Segment() : next_(nullptr), size_(0) {}
+
+    size_t Size() const {
+      return size_;
+    }
+
+    bool IsEmpty() const {
+      return size_ == 0;
+    }
+
+    bool IsFull() const {
+      return size_ == kCapacity;
+    }
+
+    void PushBack(const T& value) {
+      DCHECK(!IsFull());
+      slots_[size_++] = value;
+    }
+
+    T PopBack() {
+      DCHECK(!IsEmpty());
+      return slots_[--size_];
+    }
+
+    void Clear() {
+      size_ = 0;
+    }
+
+    // Moves the top count elements to the top of dest, keeping their order.
+    void MoveBack(size_t count, Segment* dest) {
+      DCHECK_LE(count, size_);
+      DCHECK_LE(dest->size_ + count, static_cast<size_t>(kCapacity));
+      std::copy(slots_ + size_ - count, slots_ + size_, dest->slots_ + dest->size_);
+      size_ -= count;
+      dest->size_ += count;
+    }
+
+    // The segment below this one in a stack, or the next free segment in a pool.
+    Segment* GetNext() const {
+      return next_;
+    }
+
+    void SetNext(Segment* next) {
+      next_ = next;
+    }
+
+   private:
+    Segment* next_;
+    size_t size_;
+    T slots_[kCapacity];
+
+    DISALLOW_COPY_AND_ASSIGN(Segment);
+  };
+
+  // Thread safe free list of segments. The stacks of a collector share one, so that the segments
+  // of a collection are reused by the next one instead of being allocated again.
+  class Pool {
+   public:
+    explicit Pool(const char* name)
+        : lock_(name, kMarkStackSegmentPoolLock), free_list_(nullptr), free_count_(0) {
+    }
+
+    ~Pool() {
+      Trim(0);
+    }
+
+    Segment* Allocate() LOCKS_EXCLUDED(lock_) {
+      {
+        MutexLock mu(Thread::Current(), lock_);
+        Segment* segment = free_list_;
+        if (segment != nullptr) {
+          free_list_ = segment->GetNext();
+          --free_count_;
+          segment->SetNext(nullptr);
+          return segment;
+        }
+      }
+      return new Segment;
+    }
+
+    void Free(Segment* segment) LOCKS_EXCLUDED(lock_) {
+      DCHECK(segment->IsEmpty());
+      MutexLock mu(Thread::Current(), lock_);
+      segment->SetNext(free_list_);
+      free_list_ = segment;
+      ++free_count_;
+    }
+
+    // Releases the free segments beyond the first max_free_segments.
+    void Trim(size_t max_free_segments) LOCKS_EXCLUDED(lock_) {
+      Segment* released = nullptr;
+      {
+        MutexLock mu(Thread::Current(), lock_);
+        while (free_count_ > max_free_segments) {
+          Segment* segment = free_list_;
+          free_list_ = segment->GetNext();
+          --free_count_;
+          segment->SetNext(released);
+          released = segment;
+        }
+      }
+      while (released != nullptr) {
+        Segment* next = released->GetNext();
+        delete released;
+        released = next;
+      }
+    }
+
+    size_t GetFreeCount() LOCKS_EXCLUDED(lock_) {
+      MutexLock mu(Thread::Current(), lock_);
+      return free_count_;
+    }
+
+   private:
+    Mutex lock_;
+    Segment* free_list_ GUARDED_BY(lock_);
+    size_t free_count_ GUARDED_BY(lock_);
+
+    DISALLOW_COPY_AND_ASSIGN(Pool);
+  };
+
+  explicit SegmentedStack(Pool* pool) : pool_(pool), top_(nullptr), spare_(nullptr), size_(0) {
+  }
+
+  ~SegmentedStack() {
+    Reset();
+  }
+
+  // Returns all the segments to the pool.
+  void Reset() {
+    while (top_ != nullptr) {
+      Segment* segment = top_;
+      top_ = segment->GetNext();
+      ReleaseSegment(segment);
+    }
+    if (spare_ != nullptr) {
+      pool_->Free(spare_);
+      spare_ = nullptr;
+    }
+    size_ = 0;
+  }
+
+  void PushBack(const T& value) {
+    if (UNLIKELY(top_ == nullptr || top_->IsFull())) {
+      Segment* segment = spare_;
+      if (segment != nullptr) {
+        spare_ = nullptr;
+      } else {
+        segment = pool_->Allocate();
+      }
+      segment->SetNext(top_);
+      top_ = segment;
+    }
+    top_->PushBack(value);
+    ++size_;
+  }
+
+  T PopBack() {
+    DCHECK(!IsEmpty());
+    T value = top_->PopBack();
+    --size_;
+    if (UNLIKELY(top_->IsEmpty())) {
+      // Keep the segment below the top non-empty. The emptied segment is kept as a spare so that
+      // pushing and popping around a segment boundary doesn't go through the pool.
+      Segment* segment = top_;
+      top_ = segment->GetNext();
+      ReleaseSegment(segment);
+    }
+    return value;
+  }
+
+  // Detaches up to max_size elements from the top of the stack as a segment owned by the caller.
+  // The top segment is detached as is when it is small enough, otherwise its top max_size elements
+  // are moved to a segment of the pool. Returns nullptr if the stack is empty.
+  Segment* PopSegment(size_t max_size) {
+    DCHECK_GT(max_size, 0U);
+    if (top_ == nullptr) {
+      return nullptr;
+    }
+    Segment* segment;
+    if (top_->Size() <= max_size) {
+      segment = top_;
+      top_ = segment->GetNext();
+      segment->SetNext(nullptr);
+      size_ -= segment->Size();
+    } else {
+      segment = pool_->Allocate();
+      top_->MoveBack(max_size, segment);
+      size_ -= max_size;
+    }
+    return segment;
+  }
+
+  // Links a segment detached by PopSegment back on top of the stack, taking ownership of it.
+  void PushSegment(Segment* segment) {
+    DCHECK(segment->GetNext() == nullptr);
+    if (segment->IsEmpty()) {
+      pool_->Free(segment);
+      return;
+    }
+    segment->SetNext(top_);
+    top_ = segment;
+    size_ += segment->Size();
+  }
+
+  bool IsEmpty() const {
+    return size_ == 0;
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  Pool* GetPool() const {
+    return pool_;
+  }
+
+ private:
+  void ReleaseSegment(Segment* segment) {
+    segment->Clear();
+    segment->SetNext(nullptr);
+    if (spare_ == nullptr) {
+      spare_ = segment;
+    } else {
+      pool_->Free(segment);
+    }
+  }
+
+  Pool* const pool_;
+
+  // The segment holding the most recently pushed elements, none of the linked segments are empty.
+  Segment* top_;
+
+  // An empty segment kept for the next push which needs one.
+  Segment* spare_;
+
+  // Number of elements in all the linked segments.
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentedStack);
+};
+
+typedef SegmentedStack<mirror::Object*> SegmentedObjectStack;
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_SEGMENTED_STACK_H_
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "segmented_stack.h"
+
+#include "common_runtime_test.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+typedef SegmentedStack<size_t> Stack;
+
+static const size_t kCapacity = Stack::Segment::kCapacity;
+
+class SegmentedStackTest : public CommonRuntimeTest {};
+
+TEST_F(SegmentedStackTest, PushPop) {
+  Stack::Pool pool("segmented stack test pool");
+  Stack stack(&pool);
+  EXPECT_TRUE(stack.IsEmpty());
+  // Enough elements to link a few segments.
+  const size_t count = 3 * kCapacity + 7;
+  for (size_t i = 0; i < count; ++i) {
+    stack.PushBack(i);
+  }
+  EXPECT_EQ(count, stack.Size());
+  for (size_t i = count; i != 0; --i) {
+    EXPECT_EQ(i - 1, stack.PopBack());
+  }
+  EXPECT_TRUE(stack.IsEmpty());
+  // One emptied segment is kept as a spare, the others went back to the pool.
+  EXPECT_EQ(3U, pool.GetFreeCount());
+  stack.Reset();
+  EXPECT_EQ(4U, pool.GetFreeCount());
+}
+
+TEST_F(SegmentedStackTest, SegmentBoundary) {
+  Stack::Pool pool("segmented stack test pool");
+  Stack stack(&pool);
+  for (size_t i = 0; i < kCapacity; ++i) {
+    stack.PushBack(i);
+  }
+  // Pushing and popping around the end of a segment reuses the spare segment.
+  for (size_t i = 0; i < 10; ++i) {
+    stack.PushBack(kCapacity);
+    EXPECT_EQ(kCapacity, stack.PopBack());
+  }
+  EXPECT_EQ(0U, pool.GetFreeCount());
+  EXPECT_EQ(kCapacity, stack.Size());
+}
+
+TEST_F(SegmentedStackTest, PopSegment) {
+  Stack::Pool pool("segmented stack test pool");
+  Stack stack(&pool);
+  const size_t count = kCapacity + 10;
+  for (size_t i = 0; i < count; ++i) {
+    stack.PushBack(i);
+  }
+  // The top segment holds 10 elements, it is detached as is.
+  Stack::Segment* whole = stack.PopSegment(kCapacity);
+  ASSERT_TRUE(whole != nullptr);
+  EXPECT_EQ(10U, whole->Size());
+  EXPECT_EQ(kCapacity, stack.Size());
+  // Only the top 4 elements of the next one are taken, in their order.
+  Stack::Segment* part = stack.PopSegment(4);
+  ASSERT_TRUE(part != nullptr);
+  EXPECT_EQ(4U, part->Size());
+  EXPECT_EQ(kCapacity - 4, stack.Size());
+  for (size_t i = kCapacity; i != kCapacity - 4; --i) {
+    EXPECT_EQ(i - 1, part->PopBack());
+  }
+  pool.Free(part);
+  // Linking the detached segment back restores its elements.
+  stack.PushSegment(whole);
+  EXPECT_EQ(kCapacity + 6, stack.Size());
+  for (size_t i = count; i != kCapacity; --i) {
+    EXPECT_EQ(i - 1, stack.PopBack());
+  }
+  EXPECT_EQ(kCapacity - 5, stack.PopBack());
+  stack.Reset();
+  EXPECT_TRUE(stack.PopSegment(1) == nullptr);
+}
+
+TEST_F(SegmentedStackTest, Trim) {
+  Stack::Pool pool("segmented stack test pool");
+  {
+    Stack stack(&pool);
+    for (size_t i = 0; i < 8 * kCapacity; ++i) {
+      stack.PushBack(i);
+    }
+  }
+  EXPECT_EQ(8U, pool.GetFreeCount());
+  pool.Trim(2);
+  EXPECT_EQ(2U, pool.GetFreeCount());
+  // The free segments are reused.
+  Stack stack(&pool);
+  stack.PushBack(0);
+  EXPECT_EQ(1U, pool.GetFreeCount());
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
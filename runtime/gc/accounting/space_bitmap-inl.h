@@ -67,6 +67,35 @@ inline bool SpaceBitmap<kAlignment>::Test(const mirror::Object* obj) const {
   return (bitmap_begin_[OffsetToIndex(offset)] & OffsetToMask(offset)) != 0;
 }
 
+template<size_t kAlignment>
+inline size_t SpaceBitmap<kAlignment>::SkipZeroWords(const uword* words, size_t index,
+                                                     size_t end) {
+  while (index + 4 <= end &&
+      (words[index] | words[index + 1] | words[index + 2] | words[index + 3]) == 0) {
+    index += 4;
+  }
+  while (index < end && words[index] == 0) {
+    ++index;
+  }
+  return index;
+}
+
+template<size_t kAlignment> template<typename Visitor>
+inline void SpaceBitmap<kAlignment>::VisitWord(uintptr_t ptr_base, uword w,
+                                               const Visitor& visitor) {
+  DCHECK_NE(w, 0U);
+  // The word is a copy, so objects marked by the visitor are not visited either way.
+  for (uword prefetch = w; prefetch != 0; prefetch &= prefetch - 1) {
+    __builtin_prefetch(reinterpret_cast<void*>(ptr_base + CTZ(prefetch) * kAlignment));
+  }
+  do {
+    const size_t shift = CTZ(w);
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+    visitor(obj);
+    w ^= (static_cast<uword>(1)) << shift;
+  } while (w != 0);
+}
+
 template<size_t kAlignment> template<typename Visitor>
 inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin, uintptr_t visit_end,
                                                       const Visitor& visitor) const {
@@ -111,26 +140,16 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin, uin
 
     // Traverse left edge.
     if (left_edge != 0) {
-      const uintptr_t ptr_base = IndexToOffset(index_start) + heap_begin_;
-      do {
-        const size_t shift = CTZ(left_edge);
-        mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-        visitor(obj);
-        left_edge ^= (static_cast<uword>(1)) << shift;
-      } while (left_edge != 0);
+      VisitWord(IndexToOffset(index_start) + heap_begin_, left_edge, visitor);
     }
 
     // Traverse the middle, full part.
-    for (size_t i = index_start + 1; i < index_end; ++i) {
-      uword w = bitmap_begin_[i];
+    for (size_t i = SkipZeroWords(bitmap_begin_, index_start + 1, index_end); i < index_end;
+         i = SkipZeroWords(bitmap_begin_, i + 1, index_end)) {
+      // The words are read after the previous ones are visited, as without the skipping.
+      const uword w = bitmap_begin_[i];
       if (w != 0) {
-        const uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
-        do {
-          const size_t shift = CTZ(w);
-          mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-          visitor(obj);
-          w ^= (static_cast<uword>(1)) << shift;
-        } while (w != 0);
+        VisitWord(IndexToOffset(i) + heap_begin_, w, visitor);
       }
     }
 
@@ -150,13 +169,7 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin, uin
   // Right edge handling.
   right_edge &= ((static_cast<uword>(1) << bit_end) - 1);
   if (right_edge != 0) {
-    const uintptr_t ptr_base = IndexToOffset(index_end) + heap_begin_;
-    do {
-      const size_t shift = CTZ(right_edge);
-      mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-      visitor(obj);
-      right_edge ^= (static_cast<uword>(1)) << shift;
-    } while (right_edge != 0);
+    VisitWord(IndexToOffset(index_end) + heap_begin_, right_edge, visitor);
   }
 #endif
 }
@@ -51,8 +51,9 @@ SpaceBitmap<kAlignment>* SpaceBitmap<kAlignment>::Create(
   // Round up since heap_capacity is not necessarily a multiple of kAlignment * kBitsPerWord.
   const size_t bitmap_size = ComputeBitmapSize(heap_capacity);
   std::string error_msg;
-  UniquePtr<MemMap> mem_map(MemMap::MapAnonymous(name.c_str(), nullptr, bitmap_size,
-                                                 PROT_READ | PROT_WRITE, false, &error_msg));
+  // Sized for the whole capacity, only the pages covering the part of the space in use get
+  // committed.
+  UniquePtr<MemMap> mem_map(MemMap::MapAnonymousLazy(name.c_str(), bitmap_size, &error_msg));
   if (UNLIKELY(mem_map.get() == nullptr)) {
     LOG(ERROR) << "Failed to allocate bitmap " << name << ": " << error_msg;
     return nullptr;
@@ -85,7 +86,16 @@ void SpaceBitmap<kAlignment>::Clear() {
 template<size_t kAlignment>
 void SpaceBitmap<kAlignment>::CopyFrom(SpaceBitmap* source_bitmap) {
   DCHECK_EQ(Size(), source_bitmap->Size());
-  std::copy(source_bitmap->Begin(), source_bitmap->Begin() + source_bitmap->Size() / kWordSize, Begin());
+  // Only write the words which differ, a plain copy would commit every page of this bitmap even
+  // where both are empty. Reading the untouched pages of either bitmap commits nothing.
+  const uword* src = source_bitmap->Begin();
+  uword* dest = Begin();
+  const size_t words = source_bitmap->Size() / kWordSize;
+  for (size_t i = 0; i < words; ++i) {
+    if (dest[i] != src[i]) {
+      dest[i] = src[i];
+    }
+  }
 }
 
 template<size_t kAlignment>
@@ -93,19 +103,33 @@ void SpaceBitmap<kAlignment>::Walk(ObjectCallback* callback, void* arg) {
   CHECK(bitmap_begin_ != NULL);
   CHECK(callback != NULL);
 
-  uintptr_t end = OffsetToIndex(HeapLimit() - heap_begin_ - 1);
+  const uintptr_t end = OffsetToIndex(HeapLimit() - heap_begin_ - 1) + 1;
   uword* bitmap_begin = bitmap_begin_;
-  for (uintptr_t i = 0; i <= end; ++i) {
+  // The callback runs kWalkPrefetchDistance objects behind the bitmap traversal, which prefetches
+  // the objects as it finds them. This is fine since the callback may not change the bitmap.
+  mirror::Object* window[kWalkPrefetchDistance];
+  size_t found = 0;
+  for (uintptr_t i = SkipZeroWords(bitmap_begin, 0, end); i < end;
+       i = SkipZeroWords(bitmap_begin, i + 1, end)) {
     uword w = bitmap_begin[i];
-    if (w != 0) {
-      uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
-      do {
-        const size_t shift = CTZ(w);
-        mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-        (*callback)(obj, arg);
-        w ^= (static_cast<uword>(1)) << shift;
-      } while (w != 0);
-    }
+    uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
+    do {
+      const size_t shift = CTZ(w);
+      mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+      __builtin_prefetch(obj);
+      mirror::Object** slot = &window[found % kWalkPrefetchDistance];
+      if (found >= kWalkPrefetchDistance) {
+        (*callback)(*slot, arg);
+      }
+      *slot = obj;
+      ++found;
+      w ^= (static_cast<uword>(1)) << shift;
+    } while (w != 0);
+  }
+  // Visit what is left in the window, oldest first.
+  for (size_t j = found > kWalkPrefetchDistance ? found - kWalkPrefetchDistance : 0; j < found;
+       ++j) {
+    (*callback)(window[j % kWalkPrefetchDistance], arg);
   }
 }
 
@@ -135,14 +159,19 @@ void SpaceBitmap<kAlignment>::SweepWalk(const SpaceBitmap<kAlignment>& live_bitm
   CHECK_LT(end, live_bitmap.Size() / kWordSize);
   uword* live = live_bitmap.bitmap_begin_;
   uword* mark = mark_bitmap.bitmap_begin_;
-  for (size_t i = start; i <= end; i++) {
+  // Garbage is live, so the runs of words without live objects can be skipped.
+  for (size_t i = SkipZeroWords(live, start, end + 1); i <= end;
+       i = SkipZeroWords(live, i + 1, end + 1)) {
     uword garbage = live[i] & ~mark[i];
     if (UNLIKELY(garbage != 0)) {
       uintptr_t ptr_base = IndexToOffset(i) + live_bitmap.heap_begin_;
       do {
         const size_t shift = CTZ(garbage);
         garbage ^= (static_cast<uword>(1)) << shift;
-        *pb++ = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+        *pb = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+        // The callback frees the objects, which reads their headers.
+        __builtin_prefetch(*pb);
+        ++pb;
       } while (garbage != 0);
       // Make sure that there are always enough slots available for an
       // entire word of one bits.
@@ -207,6 +207,18 @@ class SpaceBitmap {
   template<bool kSetBit>
   bool Modify(const mirror::Object* obj);
 
+  // Returns the index of the first non zero word in words[index, end), or end. Checks four words
+  // per branch to get through empty runs quickly.
+  static size_t SkipZeroWords(const uword* words, size_t index, size_t end) ALWAYS_INLINE;
+
+  // Visit the objects marked in the bitmap word w, which starts at ptr_base. All of their headers
+  // are prefetched before the first visit so that the misses of a dense word overlap.
+  template <typename Visitor>
+  static void VisitWord(uintptr_t ptr_base, uword w, const Visitor& visitor) ALWAYS_INLINE;
+
+  // How many objects ahead of the callback Walk prefetches.
+  static constexpr size_t kWalkPrefetchDistance = 8;
+
   // For an unvisited object, visit it then all its children found via fields.
   static void WalkFieldsInOrder(SpaceBitmap* visited, ObjectCallback* callback, mirror::Object* obj,
                                 void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
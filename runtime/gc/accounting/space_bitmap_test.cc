@@ -20,6 +20,7 @@
 
 #include "common_runtime_test.h"
 #include "globals.h"
+#include "mem_map.h"
 #include "space_bitmap-inl.h"
 #include "UniquePtr.h"
 
@@ -165,6 +166,62 @@ TEST_F(SpaceBitmapTest, VisitorPageAlignment) {
   RunTest<kPageSize>();
 }
 
+// Reads the first word of every visited object, like visitors which look at the class do.
+class ReadingVisitor {
+ public:
+  explicit ReadingVisitor(uintptr_t* sum) : sum_(sum) {}
+
+  void operator()(mirror::Object* obj) const {
+    *sum_ += *reinterpret_cast<uintptr_t*>(obj);
+  }
+
+  uintptr_t* const sum_;
+};
+
+static void ReadingCallback(mirror::Object* obj, void* arg) {
+  ReadingVisitor visitor(reinterpret_cast<uintptr_t*>(arg));
+  visitor(obj);
+}
+
+// Not a correctness test, logs how long visiting sparse and dense bitmaps takes. The heap is
+// mapped since the objects are read.
+TEST_F(SpaceBitmapTest, BenchmarkVisit) {
+  const size_t heap_capacity = 64 * MB;
+  std::string error_msg;
+  UniquePtr<MemMap> heap(MemMap::MapAnonymous("benchmark heap", nullptr, heap_capacity,
+                                              PROT_READ | PROT_WRITE, false, &error_msg));
+  ASSERT_TRUE(heap.get() != nullptr) << error_msg;
+  memset(heap->Begin(), 1, heap_capacity);
+  const uintptr_t heap_begin = reinterpret_cast<uintptr_t>(heap->Begin());
+  // One object every 4KB and one object every 64 bytes.
+  const size_t strides[] = { 4 * KB, 64 };
+  for (size_t stride : strides) {
+    UniquePtr<ContinuousSpaceBitmap> space_bitmap(
+        ContinuousSpaceBitmap::Create("test bitmap", heap->Begin(), heap_capacity));
+    size_t num_objects = 0;
+    for (size_t offset = 0; offset < heap_capacity; offset += stride) {
+      space_bitmap->Set(reinterpret_cast<mirror::Object*>(heap_begin + offset));
+      ++num_objects;
+    }
+    uintptr_t visit_sum = 0;
+    uint64_t start_ns = NanoTime();
+    space_bitmap->VisitMarkedRange(heap_begin, heap_begin + heap_capacity,
+                                   ReadingVisitor(&visit_sum));
+    const uint64_t visit_ns = NanoTime() - start_ns;
+    uintptr_t walk_sum = 0;
+    uint64_t walk_ns;
+    {
+      ReaderMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+      start_ns = NanoTime();
+      space_bitmap->Walk(ReadingCallback, &walk_sum);
+      walk_ns = NanoTime() - start_ns;
+    }
+    EXPECT_EQ(visit_sum, walk_sum);
+    LOG(INFO) << num_objects << " objects, VisitMarkedRange " << PrettyDuration(visit_ns)
+              << " Walk " << PrettyDuration(walk_ns);
+  }
+}
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_sampler.h"
+
+#include <math.h>
+
+#include <ostream>
+#include <set>
+
+#include "base/stringprintf.h"
+#include "mirror/art_method-inl.h"
+#include "object_utils.h"
+#include "stack.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+class SampleStackVisitor : public StackVisitor {
+ public:
+  SampleStackVisitor(Thread* thread, std::vector<std::pair<mirror::ArtMethod*, uint32_t>>* frames)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), frames_(frames) {}
+
+  bool VisitFrame() NO_THREAD_SAFETY_ANALYSIS {
+    if (frames_->size() >= AllocationSampler::kMaxStackDepth) {
+      return false;
+    }
+    mirror::ArtMethod* m = GetMethod();
+    if (!m->IsRuntimeMethod()) {
+      frames_->push_back(std::make_pair(m, GetDexPc()));
+    }
+    return true;
+  }
+
+ private:
+  std::vector<std::pair<mirror::ArtMethod*, uint32_t>>* const frames_;
+};
+
+AllocationSampler::AllocationSampler(size_t mean_interval)
+    : mean_interval_(mean_interval), lock_("allocation sampler lock"),
+      allow_new_samples_(true),
+      new_samples_condition_("allocation sampler disallow condition", lock_),
+      random_state_(NanoTime() | 1) {
+  CHECK_GT(mean_interval, 0u);
+  StackNode root;
+  root.parent_ = 0;
+  root.method_ = nullptr;
+  root.dex_pc_ = 0;
+  stack_nodes_.push_back(root);
+}
+
+void AllocationSampler::RecordSample(Thread* self, mirror::Object* obj, size_t byte_count,
+                                     bool first) {
+  std::vector<std::pair<mirror::ArtMethod*, uint32_t>> frames;
+  if (!first) {
+    SampleStackVisitor visitor(self, &frames);
+    visitor.WalkStack();
+  }
+  MutexLock mu(self, lock_);
+  self->SetAllocationSampleBytesLeft(NextInterval());
+  if (first) {
+    return;
+  }
+  while (UNLIKELY(!allow_new_samples_)) {
+    new_samples_condition_.WaitHoldingLocks(self);
+  }
+  const uint32_t stack_id = InternStack(frames);
+  if (sites_.find(stack_id) == sites_.end()) {
+    Site site = { 0, 0, 0, 0 };
+    sites_.Put(stack_id, site);
+  }
+  Site& site = sites_.find(stack_id)->second;
+  ++site.allocated_objects_;
+  site.allocated_bytes_ += byte_count;
+  Sample sample;
+  sample.obj_ = obj;
+  sample.stack_id_ = stack_id;
+  sample.byte_count_ = byte_count;
+  samples_.push_back(sample);
+}
+
+size_t AllocationSampler::NextInterval() {
+  // xorshift64*, then an exponential variate of mean mean_interval_ from a uniform one in (0, 1].
+  random_state_ ^= random_state_ >> 12;
+  random_state_ ^= random_state_ << 25;
+  random_state_ ^= random_state_ >> 27;
+  const uint64_t bits = (random_state_ * UINT64_C(2685821657736338717)) >> 11;
+  const double uniform = (static_cast<double>(bits) + 1.0) / 9007199254740992.0;
+  const double interval = -log(uniform) * mean_interval_;
+  // Never zero, which stands for a thread which didn't draw its first interval yet.
+  return static_cast<size_t>(std::min(std::max(interval, 1.0), 1e9));
+}
+
+uint32_t AllocationSampler::InternStack(
+    const std::vector<std::pair<mirror::ArtMethod*, uint32_t>>& frames) {
+  uint32_t id = 0;
+  for (auto it = frames.rbegin(), end = frames.rend(); it != end; ++it) {
+    StackNode node;
+    node.parent_ = id;
+    node.method_ = it->first;
+    node.dex_pc_ = it->second;
+    auto found = stack_node_ids_.find(node);
+    if (found != stack_node_ids_.end()) {
+      id = found->second;
+    } else {
+      id = stack_nodes_.size();
+      stack_nodes_.push_back(node);
+      stack_node_ids_.Put(node, id);
+    }
+  }
+  return id;
+}
+
+void AllocationSampler::SweepSamples(IsMarkedCallback* is_marked, void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t kept = 0;
+  for (size_t i = 0; i < samples_.size(); ++i) {
+    Sample sample = samples_[i];
+    mirror::Object* obj = is_marked(sample.obj_, arg);
+    if (obj == nullptr) {
+      Site& site = sites_.find(sample.stack_id_)->second;
+      ++site.freed_objects_;
+      site.freed_bytes_ += sample.byte_count_;
+    } else {
+      sample.obj_ = obj;
+      samples_[kept++] = sample;
+    }
+  }
+  samples_.resize(kept);
+}
+
+void AllocationSampler::DisallowNewSamples() {
+  MutexLock mu(Thread::Current(), lock_);
+  allow_new_samples_ = false;
+}
+
+void AllocationSampler::AllowNewSamples() {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, lock_);
+  allow_new_samples_ = true;
+  new_samples_condition_.Broadcast(self);
+}
+
+void AllocationSampler::DumpPprof(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  // pprof scales the sampled values up with the sampling period.
+  os << "--- heapz 1 ---\n";
+  os << "format = java\n";
+  os << "resolution = bytes\n";
+  os << "sampling period = " << mean_interval_ << "\n";
+  std::set<uint32_t> nodes;
+  for (const auto& entry : sites_) {
+    const Site& site = entry.second;
+    const uint64_t live_objects = site.allocated_objects_ - site.freed_objects_;
+    if (live_objects == 0) {
+      continue;
+    }
+    os << (site.allocated_bytes_ - site.freed_bytes_) << " " << live_objects << " @";
+    for (uint32_t id = entry.first; id != 0; id = stack_nodes_[id].parent_) {
+      os << StringPrintf(" 0x%x", id);
+      nodes.insert(id);
+    }
+    os << "\n";
+  }
+  for (uint32_t id : nodes) {
+    const StackNode& node = stack_nodes_[id];
+    MethodHelper mh(node.method_);
+    const char* source_file = mh.GetDeclaringClassSourceFile();
+    os << StringPrintf("0x%x %s (%s:%d)\n", id, PrettyMethod(node.method_, false).c_str(),
+                       source_file != nullptr ? source_file : "unknown",
+                       mh.GetLineNumFromDexPC(node.dex_pc_));
+  }
+}
+
+void AllocationSampler::DumpForSigQuit(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  uint64_t allocated_bytes = 0;
+  uint64_t freed_bytes = 0;
+  for (const auto& entry : sites_) {
+    allocated_bytes += entry.second.allocated_bytes_;
+    freed_bytes += entry.second.freed_bytes_;
+  }
+  os << "Allocation sampler: one sample every " << PrettySize(mean_interval_) << " on average, "
+     << samples_.size() << " live samples, " << sites_.size() << " sites, "
+     << stack_nodes_.size() << " stack frames, " << PrettySize(allocated_bytes)
+     << " sampled allocations of which " << PrettySize(freed_bytes) << " freed\n";
+}
+
+}  // namespace gc
+}  // namespace art
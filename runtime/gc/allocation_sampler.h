@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+#define ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+#include "safe_map.h"
+#include "thread.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Object;
+}  // namespace mirror
+
+namespace gc {
+
+// A heap profiler which samples the allocations rather than recording all of them like the DDMS
+// allocation tracking. The distance in bytes between two sampled allocations of a thread is drawn
+// from an exponential distribution, so that an allocation of n bytes is sampled with a probability
+// of about n / mean interval whatever the size of the other allocations.
+//
+// The stack of a sampled allocation is interned in a trie of (method, dex pc) frames, the node
+// of the innermost frame identifies the allocation site. The sampled objects are kept until they
+// die, the sweep of the system weaks accounts for the freed ones. DumpPprof writes the samples
+// still alive in the legacy text format pprof reads for Java heap profiles.
+class AllocationSampler {
+ public:
+  explicit AllocationSampler(size_t mean_interval);
+
+  // Called by the instrumented allocation paths for every allocation of self, only takes a lock
+  // and walks the stack when the allocation is sampled.
+  void RecordAllocation(Thread* self, mirror::Object* obj, size_t byte_count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_) {
+    const size_t bytes_left = self->GetAllocationSampleBytesLeft();
+    if (LIKELY(byte_count < bytes_left)) {
+      self->SetAllocationSampleBytesLeft(bytes_left - byte_count);
+      return;
+    }
+    RecordSample(self, obj, byte_count, bytes_left == 0);
+  }
+
+  // Updates the sampled objects which moved and accounts for the ones which died, is_marked
+  // returns null for those.
+  void SweepSamples(IsMarkedCallback* is_marked, void* arg) LOCKS_EXCLUDED(lock_);
+
+  // New samples wait while the system weaks are swept concurrently, is_marked wouldn't know
+  // about their objects.
+  void DisallowNewSamples() LOCKS_EXCLUDED(lock_);
+  void AllowNewSamples() LOCKS_EXCLUDED(lock_);
+
+  // Writes the samples still alive as a pprof Java heap profile.
+  void DumpPprof(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(lock_);
+
+  void DumpForSigQuit(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+  size_t GetMeanInterval() const {
+    return mean_interval_;
+  }
+
+  // Frames beyond this depth are left out of the sampled stacks.
+  static constexpr size_t kMaxStackDepth = 64;
+
+ private:
+  // A frame of the trie, identified by its index in stack_nodes_. The root, with a null method,
+  // is at index 0.
+  struct StackNode {
+    uint32_t parent_;
+    mirror::ArtMethod* method_;
+    uint32_t dex_pc_;
+
+    bool operator<(const StackNode& rhs) const {
+      if (parent_ != rhs.parent_) {
+        return parent_ < rhs.parent_;
+      }
+      if (method_ != rhs.method_) {
+        return method_ < rhs.method_;
+      }
+      return dex_pc_ < rhs.dex_pc_;
+    }
+  };
+
+  struct Site {
+    uint64_t allocated_objects_;
+    uint64_t allocated_bytes_;
+    uint64_t freed_objects_;
+    uint64_t freed_bytes_;
+  };
+
+  struct Sample {
+    mirror::Object* obj_;
+    uint32_t stack_id_;
+    size_t byte_count_;
+  };
+
+  // Samples obj unless the thread hasn't drawn its first interval yet, and draws the next one.
+  void RecordSample(Thread* self, mirror::Object* obj, size_t byte_count, bool first)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  size_t NextInterval() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the node of the innermost of the (method, dex pc) frames, listed from the innermost.
+  uint32_t InternStack(const std::vector<std::pair<mirror::ArtMethod*, uint32_t>>& frames)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const size_t mean_interval_;
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  bool allow_new_samples_ GUARDED_BY(lock_);
+  ConditionVariable new_samples_condition_ GUARDED_BY(lock_);
+  // State of the xorshift generator the intervals are drawn from.
+  uint64_t random_state_ GUARDED_BY(lock_);
+  // Methods are not moved, so the trie doesn't need to be swept.
+  std::vector<StackNode> stack_nodes_ GUARDED_BY(lock_);
+  SafeMap<StackNode, uint32_t> stack_node_ids_ GUARDED_BY(lock_);
+  // The sites by the node of their innermost frame.
+  SafeMap<uint32_t, Site> sites_ GUARDED_BY(lock_);
+  // The sampled objects which haven't died yet.
+  std::vector<Sample> samples_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSampler);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
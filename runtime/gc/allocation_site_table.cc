@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_site_table.h"
+
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "thread.h"
+
+namespace art {
+namespace gc {
+
+AllocationSiteTable::AllocationSiteTable() : lock_("allocation site table lock") {
+  for (Site& site : sites_) {
+    site.method_ = nullptr;
+    site.type_idx_ = 0;
+    site.samples_ = 0;
+    site.survivors_ = 0;
+    site.pretenure_ = false;
+  }
+}
+
+void AllocationSiteTable::RecordAllocation(mirror::ArtMethod* method, mirror::Object* obj) {
+  // Sampling on the address avoids keeping a counter which every allocating thread would write.
+  if ((reinterpret_cast<uintptr_t>(obj) / kObjectAlignment) % kSampleInterval != 0) {
+    return;
+  }
+  const uint32_t type_idx = obj->GetClass()->GetDexTypeIndex();
+  MutexLock mu(Thread::Current(), lock_);
+  Site& site = sites_[SiteIndex(method, type_idx)];
+  if (site.method_ != method || site.type_idx_ != type_idx) {
+    if (site.pretenure_) {
+      // Keep the pretenured site rather than thrashing between the two.
+      return;
+    }
+    site.method_ = method;
+    site.type_idx_ = type_idx;
+    site.samples_ = 0;
+    site.survivors_ = 0;
+  }
+  Sample sample;
+  sample.obj_ = obj;
+  sample.method_ = method;
+  sample.type_idx_ = type_idx;
+  samples_.push_back(sample);
+}
+
+void AllocationSiteTable::SweepSamples(IsMarkedCallback* is_marked_callback, void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  for (const Sample& sample : samples_) {
+    Site& site = sites_[SiteIndex(sample.method_, sample.type_idx_)];
+    if (site.method_ != sample.method_ || site.type_idx_ != sample.type_idx_) {
+      // The site was evicted after the sample was taken.
+      continue;
+    }
+    ++site.samples_;
+    if (is_marked_callback(sample.obj_, arg) != nullptr) {
+      ++site.survivors_;
+    }
+  }
+  samples_.clear();
+  for (Site& site : sites_) {
+    if (site.samples_ < kMinSamples) {
+      continue;
+    }
+    site.pretenure_ = site.survivors_ * 100 >= site.samples_ * kSurvivalPercentThreshold;
+    // Decay the counts so that the rate follows the recent behavior of the site.
+    site.samples_ /= 2;
+    site.survivors_ /= 2;
+  }
+}
+
+size_t AllocationSiteTable::GetNumPretenuredSites() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t count = 0;
+  for (const Site& site : sites_) {
+    if (site.pretenure_) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATION_SITE_TABLE_H_
+#define ART_RUNTIME_GC_ALLOCATION_SITE_TABLE_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Object;
+}  // namespace mirror
+
+namespace gc {
+
+// Survival feedback for allocation sites, used by the generational semi-space collector to
+// pretenure the objects which would otherwise be copied into the promotion space anyway. A site
+// is the allocating method together with the dex type index of the allocated class, since the
+// quick alloc entrypoints are not passed the dex pc. A sample of the bump pointer space allocations of each site is
+// checked by the next collection, and the sites whose samples mostly survived allocate directly
+// into the promotion space from then on.
+class AllocationSiteTable {
+ public:
+  AllocationSiteTable();
+
+  // Whether the allocations of klass by method should go to the promotion space. Called on every
+  // allocation, so it does not lock. A racy read can only send one allocation to the other space,
+  // which is harmless.
+  bool ShouldPretenure(mirror::ArtMethod* method, uint32_t type_idx) const {
+    const Site& site = sites_[SiteIndex(method, type_idx)];
+    return site.pretenure_ && site.method_ == method && site.type_idx_ == type_idx;
+  }
+
+  // Record an allocation by method into the bump pointer space, only one in kSampleInterval
+  // allocations is sampled.
+  void RecordAllocation(mirror::ArtMethod* method, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Called by the collector once marking is done, is_marked_callback returns null for the sampled
+  // objects which died. Updates the survival rates and the pretenuring decisions.
+  void SweepSamples(IsMarkedCallback* is_marked_callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  size_t GetNumPretenuredSites() LOCKS_EXCLUDED(lock_);
+
+  // Number of sites tracked at the same time, sites which hash alike evict each other unless
+  // already pretenured.
+  static constexpr size_t kNumSites = 1024;
+  // Roughly one in kSampleInterval allocations is sampled.
+  static constexpr size_t kSampleInterval = 64;
+  // Survival rate from which a site is pretenured, once it has at least kMinSamples samples.
+  static constexpr size_t kSurvivalPercentThreshold = 90;
+  static constexpr size_t kMinSamples = 16;
+
+ private:
+  struct Site {
+    mirror::ArtMethod* method_;
+    uint32_t type_idx_;
+    size_t samples_;
+    size_t survivors_;
+    bool pretenure_;
+  };
+
+  struct Sample {
+    mirror::Object* obj_;
+    mirror::ArtMethod* method_;
+    uint32_t type_idx_;
+  };
+
+  // Methods are not moved, unlike classes, so the method address and the type index identify the
+  // site across collections.
+  static size_t SiteIndex(mirror::ArtMethod* method, uint32_t type_idx) {
+    const uintptr_t hash = reinterpret_cast<uintptr_t>(method) / kObjectAlignment * 31 + type_idx;
+    return hash % kNumSites;
+  }
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Written with lock_ held, read without it by ShouldPretenure.
+  Site sites_[kNumSites];
+  // The objects sampled since the last collection.
+  std::vector<Sample> samples_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSiteTable);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATION_SITE_TABLE_H_
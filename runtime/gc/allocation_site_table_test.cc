@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_site_table.h"
+
+#include "common_runtime_test.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+namespace gc {
+
+class AllocationSiteTableTest : public CommonRuntimeTest {};
+
+static mirror::Object* AllSurviveCallback(mirror::Object* obj, void*) {
+  return obj;
+}
+
+static mirror::Object* NoneSurviveCallback(mirror::Object*, void*) {
+  return nullptr;
+}
+
+TEST_F(AllocationSiteTableTest, PretenuresSurvivingSites) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* klass = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(klass != nullptr);
+  // The methods only serve as keys.
+  mirror::ArtMethod* surviving_site = klass->FindDeclaredDirectMethod("<init>", "()V");
+  mirror::ArtMethod* dying_site = klass->FindDeclaredVirtualMethod("toString",
+                                                                   "()Ljava/lang/String;");
+  ASSERT_TRUE(surviving_site != nullptr);
+  ASSERT_TRUE(dying_site != nullptr);
+  AllocationSiteTable table;
+  // Enough allocations for kMinSamples samples whatever the addresses are.
+  const size_t num_allocations = 4 * AllocationSiteTable::kMinSamples *
+      AllocationSiteTable::kSampleInterval;
+  for (size_t i = 0; i < num_allocations; ++i) {
+    table.RecordAllocation(surviving_site, klass->AllocObject(soa.Self()));
+  }
+  table.SweepSamples(AllSurviveCallback, nullptr);
+  for (size_t i = 0; i < num_allocations; ++i) {
+    table.RecordAllocation(dying_site, klass->AllocObject(soa.Self()));
+  }
+  table.SweepSamples(NoneSurviveCallback, nullptr);
+  EXPECT_TRUE(table.ShouldPretenure(surviving_site, klass->GetDexTypeIndex()));
+  EXPECT_FALSE(table.ShouldPretenure(dying_site, klass->GetDexTypeIndex()));
+  EXPECT_EQ(1U, table.GetNumPretenuredSites());
+}
+
+}  // namespace gc
+}  // namespace art
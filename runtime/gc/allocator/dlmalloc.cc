@@ -47,6 +47,7 @@ static void art_heap_usage_error(const char* function, void* p) {
 }
 
 #include "globals.h"
+#include "mem_map.h"
 #include "utils.h"
 #include <sys/mman.h>
 
@@ -55,9 +56,10 @@ extern "C" void DlmallocMadviseCallback(void* start, void* end, size_t used_byte
   if (used_bytes != 0) {
     return;
   }
-  // Do we have any whole pages to give back?
-  start = reinterpret_cast<void*>(art::RoundUp(reinterpret_cast<uintptr_t>(start), art::kPageSize));
-  end = reinterpret_cast<void*>(art::RoundDown(reinterpret_cast<uintptr_t>(end), art::kPageSize));
+  // Do we have any whole pages to give back? Huge pages are given back whole or not at all.
+  const size_t alignment = art::MemMap::GetReleaseAlignment();
+  start = reinterpret_cast<void*>(art::RoundUp(reinterpret_cast<uintptr_t>(start), alignment));
+  end = reinterpret_cast<void*>(art::RoundDown(reinterpret_cast<uintptr_t>(end), alignment));
   if (end > start) {
     size_t length = reinterpret_cast<uint8_t*>(end) - reinterpret_cast<uint8_t*>(start);
     int rc = madvise(start, length, MADV_DONTNEED);
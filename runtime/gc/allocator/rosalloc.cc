@@ -20,8 +20,11 @@
 #include "mirror/object-inl.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "rosalloc.h"
 
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <list>
 #include <vector>
@@ -35,6 +38,8 @@ extern "C" void* art_heap_rosalloc_morecore(RosAlloc* rosalloc, intptr_t increme
 static constexpr bool kUsePrefetchDuringAllocRun = true;
 static constexpr bool kPrefetchNewRunDataByZeroing = false;
 static constexpr size_t kPrefetchStride = 64;
+// How many runs a task of the parallel verification checks the slots of.
+static constexpr size_t kVerifySlotsRunsPerTask = 256;
 
 size_t RosAlloc::bracketSizes[kNumOfSizeBrackets];
 size_t RosAlloc::numOfPages[kNumOfSizeBrackets];
@@ -48,17 +53,20 @@ RosAlloc::Run* RosAlloc::dedicated_full_run_ =
     reinterpret_cast<RosAlloc::Run*>(dedicated_full_run_storage_);
 
 RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
-                   PageReleaseMode page_release_mode, size_t page_release_size_threshold)
+                   PageReleaseMode page_release_mode, size_t page_release_size_threshold,
+                   size_t num_thread_local_size_brackets)
     : base_(reinterpret_cast<byte*>(base)), footprint_(capacity),
       capacity_(capacity), max_capacity_(max_capacity),
       lock_("rosalloc global lock", kRosAllocGlobalLock),
       bulk_free_lock_("rosalloc bulk free lock", kRosAllocBulkFreeLock),
       page_release_mode_(page_release_mode),
-      page_release_size_threshold_(page_release_size_threshold) {
+      page_release_size_threshold_(page_release_size_threshold),
+      num_thread_local_size_brackets_(num_thread_local_size_brackets) {
   DCHECK_EQ(RoundUp(capacity, kPageSize), capacity);
   DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
   CHECK_LE(capacity, max_capacity);
   CHECK(IsAligned<kPageSize>(page_release_size_threshold_));
+  CHECK_LE(num_thread_local_size_brackets_, kMaxNumThreadLocalSizeBrackets);
   if (!initialized_) {
     Initialize();
   }
@@ -548,7 +556,7 @@ RosAlloc::Run* RosAlloc::AllocRun(Thread* self, size_t idx) {
     DCHECK(!new_run->IsThreadLocal());
     DCHECK_EQ(new_run->first_search_vec_idx_, 0U);
     DCHECK(!new_run->to_be_bulk_freed_);
-    if (kUsePrefetchDuringAllocRun && idx < kNumThreadLocalSizeBrackets) {
+    if (kUsePrefetchDuringAllocRun && idx < num_thread_local_size_brackets_) {
       // Take ownership of the cache lines if we are likely to be thread local run.
       if (kPrefetchNewRunDataByZeroing) {
         // Zeroing the data is sometimes faster than prefetching but it increases memory usage
@@ -650,7 +658,7 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
 
   void* slot_addr;
 
-  if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
+  if (LIKELY(idx < num_thread_local_size_brackets_)) {
     // Use a thread-local run.
     Run* thread_local_run = reinterpret_cast<Run*>(self->GetRosAllocRun(idx));
     // Allow invalid since this will always fail the allocation.
@@ -754,7 +762,7 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
   }
   if (LIKELY(run->IsThreadLocal())) {
     // It's a thread-local run. Just mark the thread-local free bit map and return.
-    DCHECK_LT(run->size_bracket_idx_, kNumThreadLocalSizeBrackets);
+    DCHECK_LT(run->size_bracket_idx_, num_thread_local_size_brackets_);
     DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
     DCHECK(full_runs_[idx].find(run) == full_runs_[idx].end());
     run->MarkThreadLocalFreeBitMap(ptr);
@@ -1246,7 +1254,7 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
     size_t idx = run->size_bracket_idx_;
     MutexLock mu(self, *size_bracket_locks_[idx]);
     if (run->IsThreadLocal()) {
-      DCHECK_LT(run->size_bracket_idx_, kNumThreadLocalSizeBrackets);
+      DCHECK_LT(run->size_bracket_idx_, num_thread_local_size_brackets_);
       DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
       DCHECK(full_runs_[idx].find(run) == full_runs_[idx].end());
       run->UnionBulkFreeBitMapToThreadLocalFreeBitMap();
@@ -1636,11 +1644,25 @@ void RosAlloc::SetFootprintLimit(size_t new_capacity) {
   }
 }
 
+size_t RosAlloc::LargestFreePageRunBytes() {
+  MutexLock mu(Thread::Current(), lock_);
+  const size_t tail_bytes = capacity_ - footprint_;
+  size_t largest = tail_bytes;
+  for (FreePageRun* fpr : free_page_runs_) {
+    size_t fpr_bytes = fpr->ByteSize(this);
+    if (fpr->IsAtEndOfSpace(this)) {
+      fpr_bytes += tail_bytes;
+    }
+    largest = std::max(largest, fpr_bytes);
+  }
+  return largest;
+}
+
 void RosAlloc::RevokeThreadLocalRuns(Thread* thread) {
   Thread* self = Thread::Current();
   // Avoid race conditions on the bulk free bit maps with BulkFree() (GC).
   WriterMutexLock wmu(self, bulk_free_lock_);
-  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; idx++) {
+  for (size_t idx = 0; idx < num_thread_local_size_brackets_; idx++) {
     MutexLock mu(self, *size_bracket_locks_[idx]);
     Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
     CHECK(thread_local_run != nullptr);
@@ -1692,7 +1714,7 @@ void RosAlloc::RevokeRun(Thread* self, size_t idx, Run* run) {
 void RosAlloc::RevokeThreadUnsafeCurrentRuns() {
   // Revoke the current runs which share the same idx as thread local runs.
   Thread* self = Thread::Current();
-  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+  for (size_t idx = 0; idx < num_thread_local_size_brackets_; ++idx) {
     MutexLock mu(self, *size_bracket_locks_[idx]);
     if (current_runs_[idx] != dedicated_full_run_) {
       RevokeRun(self, idx, current_runs_[idx]);
@@ -1718,7 +1740,7 @@ void RosAlloc::AssertThreadLocalRunsAreRevoked(Thread* thread) {
     Thread* self = Thread::Current();
     // Avoid race conditions on the bulk free bit maps with BulkFree() (GC).
     WriterMutexLock wmu(self, bulk_free_lock_);
-    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; idx++) {
+    for (size_t idx = 0; idx < num_thread_local_size_brackets_; idx++) {
       MutexLock mu(self, *size_bracket_locks_[idx]);
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
       DCHECK(thread_local_run == nullptr || thread_local_run == dedicated_full_run_);
@@ -1735,7 +1757,7 @@ void RosAlloc::AssertAllThreadLocalRunsAreRevoked() {
     for (Thread* t : thread_list) {
       AssertThreadLocalRunsAreRevoked(t);
     }
-    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+    for (size_t idx = 0; idx < num_thread_local_size_brackets_; ++idx) {
       MutexLock mu(self, *size_bracket_locks_[idx]);
       CHECK_EQ(current_runs_[idx], dedicated_full_run_);
     }
@@ -1859,13 +1881,52 @@ void RosAlloc::ObjectsAllocatedCallback(void* start, void* end, size_t used_byte
   ++(*objects_allocated);
 }
 
-void RosAlloc::Verify() {
+// Checks the slots of a range of the runs found by RosAlloc::Verify.
+class VerifyRunSlotsTask : public Task {
+ public:
+  VerifyRunSlotsTask(RosAlloc::Run** begin, RosAlloc::Run** end) : begin_(begin), end_(end) {}
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    for (RosAlloc::Run** it = begin_; it != end_; ++it) {
+      (*it)->VerifySlots();
+    }
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  RosAlloc::Run** const begin_;
+  RosAlloc::Run** const end_;
+};
+
+void RosAlloc::Verify(ThreadPool* thread_pool) {
   Thread* self = Thread::Current();
   CHECK(Locks::mutator_lock_->IsExclusiveHeld(self))
       << "The mutator locks isn't exclusively locked at RosAlloc::Verify()";
+  const bool parallel = thread_pool != nullptr && thread_pool->GetThreadCount() > 0;
+  std::vector<Run*> runs;
+  VerifyPageMapAndRuns(&runs, !parallel);
+  if (parallel) {
+    // The runs can't change while the mutators are suspended. The locks of the page map and run
+    // verification are released by now, waiting for the workers while holding them would go
+    // against the lock order.
+    for (size_t i = 0; i < runs.size(); i += kVerifySlotsRunsPerTask) {
+      const size_t end = std::min(i + kVerifySlotsRunsPerTask, runs.size());
+      thread_pool->AddTask(self, new VerifyRunSlotsTask(&runs[i], &runs[0] + end));
+    }
+    thread_pool->SetMaxActiveWorkers(thread_pool->GetThreadCount());
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  }
+}
+
+void RosAlloc::VerifyPageMapAndRuns(std::vector<Run*>* runs, bool verify_slots) {
+  Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::thread_list_lock_);
   WriterMutexLock wmu(self, bulk_free_lock_);
-  std::vector<Run*> runs;
   {
     MutexLock mu(self, lock_);
     size_t pm_end = page_map_size_;
@@ -1939,7 +2000,7 @@ void RosAlloc::Verify() {
                 << std::endl << DumpPageMap();
           }
           // Don't verify the dedicated_full_run_ since it doesn't have any real allocations.
-          runs.push_back(run);
+          runs->push_back(run);
           i += num_pages;
           CHECK_LE(i, pm_end) << "Page map index " << i << " out of range < " << pm_end
                               << std::endl << DumpPageMap();
@@ -1955,7 +2016,7 @@ void RosAlloc::Verify() {
   }
   std::list<Thread*> threads = Runtime::Current()->GetThreadList()->GetList();
   for (Thread* thread : threads) {
-    for (size_t i = 0; i < kNumThreadLocalSizeBrackets; ++i) {
+    for (size_t i = 0; i < num_thread_local_size_brackets_; ++i) {
       MutexLock mu(self, *size_bracket_locks_[i]);
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(i));
       CHECK(thread_local_run != nullptr);
@@ -1975,12 +2036,12 @@ void RosAlloc::Verify() {
     }
   }
   // Call Verify() here for the lock order.
-  for (auto& run : runs) {
-    run->Verify(self, this);
+  for (auto& run : *runs) {
+    run->Verify(self, this, verify_slots);
   }
 }
 
-void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
+void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool verify_slots) {
   DCHECK_EQ(magic_num_, kMagicNum) << "Bad magic number : " << Dump();
   const size_t idx = size_bracket_idx_;
   CHECK_LT(idx, kNumOfSizeBrackets) << "Out of range size bracket index : " << Dump();
@@ -2006,7 +2067,7 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
     std::list<Thread*> thread_list = Runtime::Current()->GetThreadList()->GetList();
     for (auto it = thread_list.begin(); it != thread_list.end(); ++it) {
       Thread* thread = *it;
-      for (size_t i = 0; i < kNumThreadLocalSizeBrackets; i++) {
+      for (size_t i = 0; i < rosalloc->num_thread_local_size_brackets_; i++) {
         MutexLock mu(self, *rosalloc->size_bracket_locks_[i]);
         Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(i));
         if (thread_local_run == this) {
@@ -2061,6 +2122,17 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
       }
     }
   }
+  if (verify_slots) {
+    VerifySlots();
+  }
+}
+
+void RosAlloc::Run::VerifySlots() {
+  const size_t idx = size_bracket_idx_;
+  byte* slot_base = reinterpret_cast<byte*>(this) + headerSizes[idx];
+  const size_t num_slots = numOfSlots[idx];
+  const size_t num_vec = RoundUp(num_slots, 32) / 32;
+  const size_t bracket_size = IndexToBracketSize(idx);
   // Check each slot.
   size_t slots = 0;
   for (size_t v = 0; v < num_vec; v++, slots += 32) {
@@ -2090,16 +2162,32 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
 
 size_t RosAlloc::ReleasePages() {
   VLOG(heap) << "RosAlloc::ReleasePages()";
+  size_t page_idx = 0;
+  bool finished;
+  return ReleasePages(&page_idx, std::numeric_limits<uint64_t>::max(), &finished);
+}
+
+size_t RosAlloc::ReleasePages(size_t* page_idx, uint64_t deadline_ns, bool* finished) {
   DCHECK(!DoesReleaseAllPages());
   Thread* self = Thread::Current();
+  const bool bounded = deadline_ns != std::numeric_limits<uint64_t>::max();
   size_t reclaimed_bytes = 0;
-  size_t i = 0;
-  while (true) {
+  size_t i = *page_idx;
+  // The page runs may have changed since the previous call stopped.
+  bool resumed = i != 0;
+  *finished = false;
+  for (size_t iterations = 0; ; ++iterations) {
+    // Checking the time is not free, do it only every so many pages.
+    if (bounded && iterations % kReleasePagesDeadlineCheckInterval == 0 &&
+        NanoTime() >= deadline_ns) {
+      break;
+    }
     MutexLock mu(self, lock_);
     // Check the page map size which might have changed due to grow/shrink.
     size_t pm_end = page_map_size_;
     if (i >= pm_end) {
       // Reached the end.
+      *finished = true;
       break;
     }
     byte pm = page_map_[i];
@@ -2107,6 +2195,15 @@ size_t RosAlloc::ReleasePages() {
       case kPageMapEmpty: {
         // The start of a free page run. Release pages.
         FreePageRun* fpr = reinterpret_cast<FreePageRun*>(base_ + i * kPageSize);
+        if (resumed) {
+          if (free_page_runs_.find(fpr) == free_page_runs_.end()) {
+            // The page was merged into a free page run starting before it, skip the rest of the
+            // run.
+            ++i;
+            break;
+          }
+          resumed = false;
+        }
         DCHECK(free_page_runs_.find(fpr) != free_page_runs_.end());
         size_t fpr_size = fpr->ByteSize(this);
         DCHECK(IsAligned<kPageSize>(fpr_size));
@@ -2117,8 +2214,7 @@ size_t RosAlloc::ReleasePages() {
           start = reinterpret_cast<byte*>(fpr) + kPageSize;
         }
         byte* end = reinterpret_cast<byte*>(fpr) + fpr_size;
-        CHECK_EQ(madvise(start, end - start, MADV_DONTNEED), 0);
-        reclaimed_bytes += fpr_size;
+        reclaimed_bytes += ReleasePageRange(start, end);
         size_t num_pages = fpr_size / kPageSize;
         if (kIsDebugBuild) {
           for (size_t j = i + 1; j < i + num_pages; ++j) {
@@ -2133,6 +2229,7 @@ size_t RosAlloc::ReleasePages() {
       case kPageMapLargeObjectPart:  // Fall through.
       case kPageMapRun:              // Fall through.
       case kPageMapRunPart:          // Fall through.
+        resumed = false;
         ++i;
         break;  // Skip.
       default:
@@ -2140,6 +2237,7 @@ size_t RosAlloc::ReleasePages() {
         break;
     }
   }
+  *page_idx = i;
   return reclaimed_bytes;
 }
 
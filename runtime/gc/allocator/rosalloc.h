@@ -54,6 +54,8 @@ using __gnu_cxx::hash_set;
 
 namespace art {
 
+class ThreadPool;
+
 namespace gc {
 namespace allocator {
 
@@ -131,17 +133,30 @@ class RosAlloc {
         byte_size -= kPageSize;
         if (byte_size > 0) {
           if (release_pages) {
-            madvise(start, byte_size, MADV_DONTNEED);
+            ReleasePageRange(start, start + byte_size);
           }
         }
       } else {
         if (release_pages) {
-          madvise(start, byte_size, MADV_DONTNEED);
+          ReleasePageRange(start, start + byte_size);
         }
       }
     }
   };
 
+  // Give the pages of [start, end) back to the kernel, rounded inwards to the release alignment
+  // so that huge pages are not split. Returns how many bytes were released.
+  static size_t ReleasePageRange(byte* start, byte* end) {
+    const size_t alignment = MemMap::GetReleaseAlignment();
+    start = AlignUp(start, alignment);
+    end = AlignDown(end, alignment);
+    if (start >= end) {
+      return 0;
+    }
+    CHECK_EQ(madvise(start, end - start, MADV_DONTNEED), 0);
+    return end - start;
+  }
+
   // Represents a run of memory slots of the same size.
   //
   // A run's memory layout:
@@ -280,10 +295,13 @@ class RosAlloc {
     void InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes, void* callback_arg), void* arg);
     // Dump the run metadata for debugging.
     std::string Dump();
-    // Verify for debugging.
-    void Verify(Thread* self, RosAlloc* rosalloc)
+    // Verify for debugging. The slots are only checked if verify_slots is true.
+    void Verify(Thread* self, RosAlloc* rosalloc, bool verify_slots)
         EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
         EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_);
+    // Check that the allocated slots hold objects of the run's size bracket. Takes no lock, so
+    // that the runs can be checked in parallel.
+    void VerifySlots() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
    private:
     // The common part of MarkFreeBitMap() and MarkThreadLocalFreeBitMap(). Returns the bracket
@@ -436,10 +454,16 @@ class RosAlloc {
 
   // The default value for page_release_size_threshold_.
   static constexpr size_t kDefaultPageReleaseSizeThreshold = 4 * MB;
+  // How many pages ReleasePages goes through between two checks of its deadline.
+  static constexpr size_t kReleasePagesDeadlineCheckInterval = 64;
 
   // We use thread-local runs for the size Brackets whose indexes
-  // are less than this index. We use shared (current) runs for the rest.
-  static const size_t kNumThreadLocalSizeBrackets = 11;
+  // are less than num_thread_local_size_brackets_. We use shared
+  // (current) runs for the rest. Thread local runs avoid the size
+  // bracket lock but each thread holds on to a run per bracket, which
+  // costs more memory for the larger brackets.
+  static constexpr size_t kMaxNumThreadLocalSizeBrackets = kNumOfSizeBrackets;
+  static constexpr size_t kDefaultNumThreadLocalSizeBrackets = 11;
 
  private:
   // The base address of the memory region that's managed by this allocator.
@@ -510,6 +534,8 @@ class RosAlloc {
   // Under kPageReleaseModeSize(AndEnd), if the free page run size is
   // greater than or equal to this value, release pages.
   const size_t page_release_size_threshold_;
+  // The number of size brackets, from the smallest one, which use thread-local runs.
+  const size_t num_thread_local_size_brackets_;
 
   // The base address of the memory region that's managed by this allocator.
   byte* Begin() { return base_; }
@@ -557,7 +583,8 @@ class RosAlloc {
  public:
   RosAlloc(void* base, size_t capacity, size_t max_capacity,
            PageReleaseMode page_release_mode,
-           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold);
+           size_t page_release_size_threshold = kDefaultPageReleaseSizeThreshold,
+           size_t num_thread_local_size_brackets = kDefaultNumThreadLocalSizeBrackets);
   ~RosAlloc();
   // If kThreadUnsafe is true then the allocator may avoid acquiring some locks as an optimization.
   // If used, this may cause race conditions if multiple threads are allocating at the same time.
@@ -587,12 +614,20 @@ class RosAlloc {
       LOCKS_EXCLUDED(lock_);
   // Release empty pages.
   size_t ReleasePages() LOCKS_EXCLUDED(lock_);
+  // Release the empty pages from the page *page_idx on, stopping once deadline_ns is past. The
+  // index of the page to resume from is stored back into *page_idx and *finished tells whether
+  // the end was reached. Returns the number of bytes released.
+  size_t ReleasePages(size_t* page_idx, uint64_t deadline_ns, bool* finished)
+      LOCKS_EXCLUDED(lock_);
   // Returns the current footprint.
   size_t Footprint() LOCKS_EXCLUDED(lock_);
   // Returns the current capacity, maximum footprint.
   size_t FootprintLimit() LOCKS_EXCLUDED(lock_);
   // Update the current capacity.
   void SetFootprintLimit(size_t bytes) LOCKS_EXCLUDED(lock_);
+  // Returns the size of the largest free page run, including the pages the footprint can still
+  // grow into after the last run.
+  size_t LargestFreePageRunBytes() LOCKS_EXCLUDED(lock_);
   // Releases the thread-local runs assigned to the given thread back to the common set of runs.
   void RevokeThreadLocalRuns(Thread* thread);
   // Releases the thread-local runs assigned to all the threads back to the common set of runs.
@@ -615,9 +650,19 @@ class RosAlloc {
   bool DoesReleaseAllPages() const {
     return page_release_mode_ == kPageReleaseModeAll;
   }
+  size_t NumThreadLocalSizeBrackets() const {
+    return num_thread_local_size_brackets_;
+  }
+
+  // Verify for debugging. The slots of the runs are checked on thread_pool if it is not null.
+  void Verify(ThreadPool* thread_pool = nullptr) EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  // Verify the page map and the runs, returning the runs in runs.
+  void VerifyPageMapAndRuns(std::vector<Run*>* runs, bool verify_slots)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Verify for debugging.
-  void Verify() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  friend class VerifyRunSlotsTask;
 };
 
 }  // namespace allocator
@@ -16,10 +16,544 @@
 
 #include "concurrent_copying.h"
 
+#include "base/logging.h"
+#include "base/mutex-inl.h"
+#include "base/timing_logger.h"
+#include "class_linker.h"
+#include "gc/accounting/heap_bitmap-inl.h"
+#include "gc/accounting/mod_union_table.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "gc/heap.h"
+#include "gc/reference_processor.h"
+#include "gc/space/bump_pointer_space.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/large_object_space.h"
+#include "gc/space/space-inl.h"
+#include "lock_word.h"
+#include "mirror/array-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/reference-inl.h"
+#include "read_barrier.h"
+#include "runtime.h"
+#include "thread-inl.h"
+#include "thread_list.h"
+#include "utils.h"
+
 namespace art {
 namespace gc {
 namespace collector {
 
+static constexpr bool kProtectFromSpace = true;
+// How much to-space a thread grabs at a time for the objects it copies.
+static constexpr size_t kCopyTlabSize = 32 * KB;
+
+ConcurrentCopying::ConcurrentCopying(Heap* heap, bool /*generational*/,
+                                     const std::string& name_prefix)
+    : GarbageCollector(heap,
+                       name_prefix + (name_prefix.empty() ? "" : " ") +
+                       "concurrent copying + mark sweep"),
+      from_space_(nullptr),
+      to_space_(nullptr),
+      from_space_bytes_(0),
+      from_space_objects_(0),
+      heap_mark_bitmap_(nullptr),
+      thread_running_gc_(nullptr),
+      mutator_mark_stack_lock_("concurrent copying mutator mark stack lock",
+                               kConcurrentCopyingMarkStackLock),
+      is_marking_(false) {
+}
+
+void ConcurrentCopying::RunPhases() {
+  CHECK(kUseBakerReadBarrier) << "The concurrent copying collector requires read barriers";
+  Thread* self = Thread::Current();
+  thread_running_gc_ = self;
+  Locks::mutator_lock_->AssertNotHeld(self);
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    InitializePhase();
+  }
+  {
+    ScopedPause pause(this);
+    GetHeap()->PreGcVerificationPaused(this);
+    FlipPhase();
+  }
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    MarkingPhase();
+  }
+  {
+    ScopedPause pause(this);
+    FinalPausePhase();
+  }
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    ReclaimPhase();
+  }
+  GetHeap()->PostGcVerification(this);
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    FinishPhase();
+  }
+  thread_running_gc_ = nullptr;
+}
+
+void ConcurrentCopying::InitializePhase() {
+  TimingLogger::ScopedSplit split("InitializePhase", &timings_);
+  immune_region_.Reset();
+  objects_moved_ = 0;
+  bytes_moved_ = 0;
+  bytes_wasted_ = 0;
+  DCHECK(mark_stack_.empty());
+  {
+    ReaderMutexLock mu(thread_running_gc_, *Locks::heap_bitmap_lock_);
+    heap_mark_bitmap_ = heap_->GetMarkBitmap();
+  }
+}
+
+void ConcurrentCopying::BindBitmaps() {
+  TimingLogger::ScopedSplit split("BindBitmaps", &timings_);
+  WriterMutexLock mu(thread_running_gc_, *Locks::heap_bitmap_lock_);
+  // Mark all of the spaces we never collect as immune.
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->GetGcRetentionPolicy() == space::kGcRetentionPolicyNeverCollect ||
+        space->GetGcRetentionPolicy() == space::kGcRetentionPolicyFullCollect) {
+      CHECK(immune_region_.AddContinuousSpace(space)) << "Failed to add space " << *space;
+    }
+  }
+}
+
+void ConcurrentCopying::FlipPhase() {
+  Thread* self = thread_running_gc_;
+  TimingLogger::ScopedSplit split("(Paused)FlipPhase", &timings_);
+  // The TLABs point into the from-space, revoke them so that the next allocations go to the
+  // to-space.
+  RevokeAllThreadLocalBuffers();
+  if (kUseThreadLocalAllocationStack) {
+    timings_.NewSplit("RevokeAllThreadLocalAllocationStacks");
+    heap_->RevokeAllThreadLocalAllocationStacks(self);
+  }
+  timings_.NewSplit("SwapStacks");
+  heap_->SwapStacks(self);
+  {
+    WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    // Everything allocated in the non-moving spaces so far is live at the start of marking.
+    accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+    heap_->MarkAllocStackAsLive(live_stack);
+    live_stack->Reset();
+  }
+  timings_.EndSplit();
+  BindBitmaps();
+  // Record the dirty cards of the immune spaces in their mod-union tables. Nothing else needs the
+  // cards during this collection since the read barrier keeps marking precise.
+  heap_->ProcessCards(timings_, false);
+  timings_.NewSplit("ClearCardTable");
+  heap_->GetCardTable()->ClearCardTable();
+  timings_.EndSplit();
+  // Swap the semi spaces so that the mutators allocate into the to-space once they resume.
+  from_space_ = heap_->bump_pointer_space_;
+  to_space_ = heap_->temp_space_;
+  CHECK(to_space_->IsEmpty());
+  from_space_bytes_ = from_space_->GetBytesAllocated();
+  from_space_objects_ = from_space_->GetObjectsAllocated();
+  heap_->SwapSemiSpaces();
+  // New system weaks could hold from-space references, block them until they are swept.
+  Runtime::Current()->DisallowNewSystemWeaks();
+  is_marking_ = true;
+  ReadBarrier::SetIsMarking(true);
+  {
+    TimingLogger::ScopedSplit split("MarkRoots", &timings_);
+    // After this, the mutators only ever see to-space references.
+    Runtime::Current()->VisitRoots(MarkRootCallback, this);
+  }
+  UpdateAndMarkModUnion();
+}
+
+void ConcurrentCopying::UpdateAndMarkModUnion() {
+  for (auto& space : heap_->GetContinuousSpaces()) {
+    if (immune_region_.ContainsSpace(space)) {
+      accounting::ModUnionTable* table = heap_->FindModUnionTableFromSpace(space);
+      if (table != nullptr) {
+        TimingLogger::ScopedSplit split(
+            space->IsZygoteSpace() ? "UpdateAndMarkZygoteModUnionTable" :
+                                     "UpdateAndMarkImageModUnionTable",
+                                     &timings_);
+        table->UpdateAndMarkReferences(MarkHeapReferenceCallback, this);
+      }
+    }
+  }
+}
+
+void ConcurrentCopying::MarkingPhase() {
+  TimingLogger::ScopedSplit split("MarkingPhase", &timings_);
+  // Evacuate the objects reachable from the roots while the mutators run.
+  ProcessMarkStack();
+}
+
+void ConcurrentCopying::MarkAllocStackAsMarked() {
+  Thread* self = thread_running_gc_;
+  TimingLogger::ScopedSplit split("MarkAllocStackAsMarked", &timings_);
+  if (kUseThreadLocalAllocationStack) {
+    TimingLogger::ScopedSplit split2("RevokeAllThreadLocalAllocationStacks", &timings_);
+    heap_->RevokeAllThreadLocalAllocationStacks(self);
+  }
+  heap_->SwapStacks(self);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+  heap_->MarkAllocStackAsLive(live_stack);
+  // Their references were all loaded through the read barrier, so they need no scanning.
+  for (mirror::Object** it = live_stack->Begin(); it != live_stack->End(); ++it) {
+    mirror::Object* obj = *it;
+    if (obj != nullptr) {
+      MarkNonMoving(obj);
+    }
+  }
+  live_stack->Reset();
+}
+
+void ConcurrentCopying::FinalPausePhase() {
+  Thread* self = thread_running_gc_;
+  TimingLogger::ScopedSplit split("(Paused)FinalPausePhase", &timings_);
+  // Drain what the mutators pushed since the marking phase finished.
+  ProcessMarkStack();
+  MarkAllocStackAsMarked();
+  ProcessReferences(self);
+  SweepSystemWeaks(self);
+  // Nothing refers to the from-space any more.
+  ReadBarrier::SetIsMarking(false);
+  is_marking_ = false;
+  Runtime::Current()->AllowNewSystemWeaks();
+  timings_.StartSplit("PreSweepingGcVerification");
+  heap_->PreSweepingGcVerification(this);
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::ProcessReferences(Thread* self) {
+  TimingLogger::ScopedSplit split("ProcessReferences", &timings_);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  GetHeap()->GetReferenceProcessor()->ProcessReferences(
+      false, &timings_, clear_soft_references_, &IsMarkedCallback, &MarkObjectCallback,
+      &ProcessMarkStackCallback, this);
+}
+
+void ConcurrentCopying::SweepSystemWeaks(Thread* self) {
+  TimingLogger::ScopedSplit split("SweepSystemWeaks", &timings_);
+  ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  Runtime::Current()->SweepSystemWeaks(IsMarkedCallback, this);
+}
+
+void ConcurrentCopying::ReclaimPhase() {
+  TimingLogger::ScopedSplit split("ReclaimPhase", &timings_);
+  ReleaseFromSpace();
+  {
+    WriterMutexLock mu(thread_running_gc_, *Locks::heap_bitmap_lock_);
+    Sweep(false);
+    timings_.StartSplit("SwapBitmaps");
+    SwapBitmaps();
+    timings_.EndSplit();
+    TimingLogger::ScopedSplit split("UnBindBitmaps", &timings_);
+    GetHeap()->UnBindBitmaps();
+  }
+  if (bytes_wasted_.Load() > 0) {
+    VLOG(heap) << "Copies lost to races wasted " << PrettySize(bytes_wasted_.Load());
+  }
+}
+
+void ConcurrentCopying::ReleaseFromSpace() {
+  TimingLogger::ScopedSplit split("RecordFree", &timings_);
+  const int64_t from_bytes = from_space_bytes_;
+  const int64_t to_bytes = bytes_moved_.Load();
+  const uint64_t from_objects = from_space_objects_;
+  const uint64_t to_objects = objects_moved_.Load();
+  CHECK_LE(to_objects, from_objects);
+  // Note: Freed bytes can be negative if we copy into the non-moving space.
+  RecordFree(from_objects - to_objects, from_bytes - to_bytes);
+  // Clear and protect the from space.
+  from_space_->Clear();
+  VLOG(heap) << "Protecting from_space_: " << *from_space_;
+  from_space_->GetMemMap()->Protect(kProtectFromSpace ? PROT_NONE : PROT_READ);
+}
+
+bool ConcurrentCopying::ShouldSweepSpace(space::ContinuousSpace* space) const {
+  return !space->IsBumpPointerSpace() && !immune_region_.ContainsSpace(space);
+}
+
+void ConcurrentCopying::Sweep(bool swap_bitmaps) {
+  DCHECK(mark_stack_.empty());
+  TimingLogger::ScopedSplit split("Sweep", &timings_);
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->IsContinuousMemMapAllocSpace() && ShouldSweepSpace(space)) {
+      space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
+      TimingLogger::ScopedSplit split(
+          alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepAllocSpace", &timings_);
+      size_t freed_objects = 0;
+      size_t freed_bytes = 0;
+      alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+      RecordFree(freed_objects, freed_bytes);
+    }
+  }
+  TimingLogger::ScopedSplit los_split("SweepLargeObjects", &timings_);
+  size_t freed_objects = 0;
+  size_t freed_bytes = 0;
+  heap_->GetLargeObjectsSpace()->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+  RecordFreeLargeObjects(freed_objects, freed_bytes);
+}
+
+void ConcurrentCopying::FinishPhase() {
+  TimingLogger::ScopedSplit split("FinishPhase", &timings_);
+  CHECK(mark_stack_.empty());
+  {
+    MutexLock mu(thread_running_gc_, mutator_mark_stack_lock_);
+    CHECK(mutator_mark_stack_.empty());
+  }
+  // Null the "to" and "from" spaces since compacting from one to the other isn't valid until
+  // further action is done by the heap.
+  from_space_ = nullptr;
+  to_space_ = nullptr;
+  WriterMutexLock mu(thread_running_gc_, *Locks::heap_bitmap_lock_);
+  heap_->ClearMarkedObjects();
+}
+
+void ConcurrentCopying::RevokeAllThreadLocalBuffers() {
+  timings_.StartSplit("(Paused)RevokeAllThreadLocalBuffers");
+  GetHeap()->RevokeAllThreadLocalBuffers();
+  timings_.EndSplit();
+}
+
+inline mirror::Object* ConcurrentCopying::GetFwdPtr(mirror::Object* from_ref) {
+  DCHECK(from_space_->HasAddress(from_ref));
+  LockWord lock_word = from_ref->GetLockWord(false);
+  if (lock_word.GetState() != LockWord::kForwardingAddress) {
+    return nullptr;
+  }
+  return reinterpret_cast<mirror::Object*>(lock_word.ForwardingAddress());
+}
+
+class ConcurrentCopyingLargeObjectSetVisitor {
+ public:
+  void operator()(const mirror::Object* obj) const {
+    // Marking a large object, make sure its aligned as a sanity check.
+    DCHECK(IsAligned<kPageSize>(obj)) << obj;
+  }
+};
+
+inline bool ConcurrentCopying::MarkNonMoving(mirror::Object* ref) NO_THREAD_SAFETY_ANALYSIS {
+  ConcurrentCopyingLargeObjectSetVisitor visitor;
+  return !heap_mark_bitmap_->AtomicTestAndSet(ref, visitor);
+}
+
+mirror::Object* ConcurrentCopying::Mark(mirror::Object* from_ref) {
+  if (from_ref == nullptr) {
+    return nullptr;
+  }
+  if (from_space_->HasAddress(from_ref)) {
+    mirror::Object* to_ref = GetFwdPtr(from_ref);
+    if (to_ref == nullptr) {
+      to_ref = Copy(from_ref);
+    }
+    return to_ref;
+  }
+  if (to_space_->HasAddress(from_ref) || immune_region_.ContainsObject(from_ref)) {
+    // Already copied, allocated during marking, or assumed to be marked.
+    return from_ref;
+  }
+  if (MarkNonMoving(from_ref)) {
+    PushOntoMarkStack(Thread::Current(), from_ref);
+  }
+  return from_ref;
+}
+
+mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) NO_THREAD_SAFETY_ANALYSIS {
+  if (from_space_->HasAddress(from_ref)) {
+    return GetFwdPtr(from_ref);
+  }
+  if (to_space_->HasAddress(from_ref) || immune_region_.ContainsObject(from_ref)) {
+    return from_ref;
+  }
+  return heap_mark_bitmap_->Test(from_ref) ? from_ref : nullptr;
+}
+
+mirror::Object* ConcurrentCopying::AllocateCopy(Thread* self, size_t num_bytes,
+                                                size_t* bytes_allocated,
+                                                bool* in_non_moving_space) {
+  *in_non_moving_space = false;
+  if (self->TlabSize() < num_bytes &&
+      !to_space_->AllocNewTlab(self, std::max(num_bytes, kCopyTlabSize))) {
+    // The mutators filled up the to-space, fall back to the non-moving space.
+    space::MallocSpace* non_moving_space = heap_->GetNonMovingSpace();
+    mirror::Object* ret = non_moving_space->Alloc(self, num_bytes, bytes_allocated, nullptr);
+    if (ret != nullptr) {
+      *in_non_moving_space = true;
+    }
+    return ret;
+  }
+  *bytes_allocated = num_bytes;
+  return self->AllocTlab(num_bytes);
+}
+
+void ConcurrentCopying::FillWithDummyObject(mirror::Object* dummy, size_t byte_size) {
+  mirror::Class* int_array_class = mirror::IntArray::GetArrayClass();
+  const size_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).SizeValue();
+  CHECK_GE(byte_size, data_offset);
+  dummy->SetClass(int_array_class);
+  down_cast<mirror::Array*>(dummy)->SetLength((byte_size - data_offset) / sizeof(int32_t));
+  DCHECK_EQ(RoundUp(dummy->SizeOf(), space::BumpPointerSpace::kAlignment), byte_size);
+}
+
+mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref) {
+  Thread* self = Thread::Current();
+  const size_t object_size = from_ref->SizeOf();
+  const size_t region_size = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
+  size_t bytes_allocated = 0;
+  bool in_non_moving_space;
+  mirror::Object* to_ref = AllocateCopy(self, region_size, &bytes_allocated, &in_non_moving_space);
+  if (UNLIKELY(to_ref == nullptr)) {
+    heap_->DumpSpaces(LOG(ERROR));
+    LOG(FATAL) << "Out of memory while evacuating " << from_ref << " (" << object_size << " bytes)";
+  }
+  // Nobody but the copying threads can reach the from-space object, so its contents are stable
+  // until the forwarding pointer is installed.
+  LockWord old_lock_word = from_ref->GetLockWord(false);
+  if (old_lock_word.GetState() == LockWord::kForwardingAddress) {
+    // Lost the race before copying anything.
+    if (in_non_moving_space) {
+      heap_->GetNonMovingSpace()->Free(self, to_ref);
+    } else {
+      FillWithDummyObject(to_ref, region_size);
+      bytes_wasted_.FetchAndAdd(region_size);
+    }
+    return reinterpret_cast<mirror::Object*>(old_lock_word.ForwardingAddress());
+  }
+  memcpy(reinterpret_cast<void*>(to_ref), from_ref, object_size);
+  to_ref->SetLockWord(old_lock_word, false);
+  LockWord new_lock_word = LockWord::FromForwardingAddress(reinterpret_cast<size_t>(to_ref));
+  if (!from_ref->CasLockWord(old_lock_word, new_lock_word)) {
+    // Another thread installed its copy first.
+    mirror::Object* winner = GetFwdPtr(from_ref);
+    CHECK(winner != nullptr);
+    if (in_non_moving_space) {
+      heap_->GetNonMovingSpace()->Free(self, to_ref);
+    } else {
+      FillWithDummyObject(to_ref, region_size);
+      bytes_wasted_.FetchAndAdd(region_size);
+    }
+    return winner;
+  }
+  ++objects_moved_;
+  bytes_moved_.FetchAndAdd(bytes_allocated);
+  if (in_non_moving_space) {
+    // The copy is in a space collected by marking, set both bits so that it survives the sweep.
+    // Mark() may be called with the heap bitmap lock held, so use the atomic operations instead.
+    heap_->GetNonMovingSpace()->GetLiveBitmap()->AtomicTestAndSet(to_ref);
+    heap_->GetNonMovingSpace()->GetMarkBitmap()->AtomicTestAndSet(to_ref);
+  }
+  // The copy may still have from-space references, it is gray until scanned.
+  PushOntoMarkStack(self, to_ref);
+  return to_ref;
+}
+
+void ConcurrentCopying::PushOntoMarkStack(Thread* self, mirror::Object* to_ref) {
+  if (self == thread_running_gc_) {
+    mark_stack_.push_back(to_ref);
+  } else {
+    MutexLock mu(self, mutator_mark_stack_lock_);
+    mutator_mark_stack_.push_back(to_ref);
+  }
+}
+
+void ConcurrentCopying::ProcessMarkStack() {
+  TimingLogger::ScopedSplit split("ProcessMarkStack", &timings_);
+  Thread* self = thread_running_gc_;
+  std::vector<mirror::Object*> mutator_objects;
+  while (true) {
+    while (!mark_stack_.empty()) {
+      mirror::Object* to_ref = mark_stack_.back();
+      mark_stack_.pop_back();
+      Scan(to_ref);
+    }
+    {
+      MutexLock mu(self, mutator_mark_stack_lock_);
+      mutator_objects.swap(mutator_mark_stack_);
+    }
+    if (mutator_objects.empty()) {
+      break;
+    }
+    mark_stack_.insert(mark_stack_.end(), mutator_objects.begin(), mutator_objects.end());
+    mutator_objects.clear();
+  }
+}
+
+// Forwards the reference fields of a gray object.
+class ConcurrentCopyingRefFieldsVisitor {
+ public:
+  explicit ConcurrentCopyingRefFieldsVisitor(ConcurrentCopying* collector)
+      : collector_(collector) {}
+
+  void operator()(mirror::Object* obj, MemberOffset offset, bool /* is_static */)
+      const ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Object* ref =
+        obj->GetFieldObject<mirror::Object, kVerifyNone, kWithoutReadBarrier>(offset);
+    mirror::Object* to_ref = collector_->Mark(ref);
+    if (to_ref != ref) {
+      // A mutator may store to the field concurrently. Whatever it stores is already a to-space
+      // reference, so losing the CAS is fine.
+      obj->CasFieldObject<false, false, kVerifyNone>(offset, ref, to_ref);
+    }
+  }
+
+  void operator()(mirror::Class* klass, mirror::Reference* ref) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    collector_->DelayReferenceReferent(klass, ref);
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+void ConcurrentCopying::Scan(mirror::Object* to_ref) {
+  DCHECK(!from_space_->HasAddress(to_ref)) << "Scanning object " << to_ref << " in from space";
+  ConcurrentCopyingRefFieldsVisitor visitor(this);
+  to_ref->VisitReferences<true>(visitor, visitor);
+}
+
+void ConcurrentCopying::DelayReferenceReferent(mirror::Class* klass,
+                                               mirror::Reference* reference) {
+  heap_->GetReferenceProcessor()->DelayReferenceReferent(klass, reference, IsMarkedCallback,
+                                                         this);
+}
+
+void ConcurrentCopying::MarkRootCallback(mirror::Object** root, void* arg,
+                                         uint32_t /*thread_id*/, RootType /*root_type*/) {
+  mirror::Object* ref = *root;
+  mirror::Object* to_ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(ref);
+  if (to_ref != ref) {
+    *root = to_ref;
+  }
+}
+
+mirror::Object* ConcurrentCopying::MarkObjectCallback(mirror::Object* from_ref, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->Mark(from_ref);
+}
+
+void ConcurrentCopying::MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref_addr,
+                                                  void* arg) {
+  // Only called with the mutators suspended.
+  mirror::Object* ref = ref_addr->AsMirrorPtr();
+  mirror::Object* to_ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(ref);
+  if (to_ref != ref) {
+    ref_addr->Assign(to_ref);
+  }
+}
+
+mirror::Object* ConcurrentCopying::IsMarkedCallback(mirror::Object* from_ref, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->IsMarked(from_ref);
+}
+
+void ConcurrentCopying::ProcessMarkStackCallback(void* arg) {
+  reinterpret_cast<ConcurrentCopying*>(arg)->ProcessMarkStack();
+}
+
 }  // namespace collector
 }  // namespace gc
 }  // namespace art
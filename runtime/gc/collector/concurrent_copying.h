@@ -17,32 +17,185 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 #define ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
 #include "garbage_collector.h"
+#include "gc/accounting/heap_bitmap.h"
+#include "immune_region.h"
+#include "object_callbacks.h"
+#include "offsets.h"
 
 namespace art {
+
+class Thread;
+
+namespace mirror {
+  class Class;
+  class Object;
+  class Reference;
+}  // namespace mirror
+
 namespace gc {
+
+class Heap;
+
+namespace space {
+  class BumpPointerSpace;
+  class ContinuousSpace;
+}  // namespace space
+
 namespace collector {
 
+// A mostly concurrent copying collector. Objects are evacuated from the bump pointer space
+// (from-space) into the temp space (to-space) while the mutators run. The mutators maintain the
+// to-space invariant through the Baker-style read barrier in ReadBarrier::Barrier(): while the
+// collector is marking, every reference loaded from the heap is passed through Mark(), which
+// returns the to-space copy of from-space objects (copying them if needed) and marks objects in
+// the non-moving spaces. Objects in the non-moving spaces and the large object space are marked
+// in the mark bitmaps and swept concurrently, like the concurrent mark sweep collector does.
+//
+// There are two short pauses: the flip pause, which switches the allocator to the to-space and
+// forwards the roots, and the final pause, which drains the remaining gray objects and processes
+// references and system weaks.
+//
+// Requires USE_BAKER_READ_BARRIER. Quick-compiled code does not emit read barriers, so this
+// collector is only safe with the interpreter.
 class ConcurrentCopying : public GarbageCollector {
  public:
   explicit ConcurrentCopying(Heap* heap, bool generational = false,
-                             const std::string& name_prefix = "")
-      : GarbageCollector(heap,
-                         name_prefix + (name_prefix.empty() ? "" : " ") +
-                         "concurrent copying + mark sweep") {}
+                             const std::string& name_prefix = "");
 
   ~ConcurrentCopying() {}
 
-  virtual void RunPhases() OVERRIDE {}
+  virtual void RunPhases() OVERRIDE NO_THREAD_SAFETY_ANALYSIS;
+  void InitializePhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void FlipPhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void MarkingPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void FinalPausePhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void ReclaimPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void FinishPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   virtual GcType GetGcType() const OVERRIDE {
     return kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
   }
-  virtual void RevokeAllThreadLocalBuffers() OVERRIDE {}
+  virtual void RevokeAllThreadLocalBuffers() OVERRIDE;
+
+  // Returns true between the flip pause and the end of the final pause.
+  bool IsMarking() const {
+    return is_marking_;
+  }
+
+  // Returns the to-space address of from_ref and makes sure it is marked. Called by the read
+  // barrier as well as by the collector itself. Thread safe.
+  mirror::Object* Mark(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns null if the object is not marked, otherwise returns the forwarding address (same as
+  // object for non movable things).
+  mirror::Object* IsMarked(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Scan the reference fields of a gray object, forwarding them to the to-space.
+  void Scan(mirror::Object* to_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Schedules an unmarked referent for reference processing.
+  void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* reference)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void MarkRootCallback(mirror::Object** root, void* arg, uint32_t /*tid*/,
+                               RootType /*root_type*/)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static mirror::Object* MarkObjectCallback(mirror::Object* from_ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref_addr, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static mirror::Object* IsMarkedCallback(mirror::Object* from_ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void ProcessMarkStackCallback(void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
+  // Returns the forwarding address of a from-space object or null if it has not been copied yet.
+  mirror::Object* GetFwdPtr(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copy a from-space object to the to-space and install the forwarding pointer. If another
+  // thread wins the race to copy the object, the other thread's copy is returned.
+  mirror::Object* Copy(mirror::Object* from_ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Allocate the storage for a copy, in the TLAB of self or, if the to-space is exhausted, in the
+  // non-moving space.
+  mirror::Object* AllocateCopy(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                               bool* in_non_moving_space)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Turn a copy that lost the race into a dead int array so that the to-space stays walkable.
+  void FillWithDummyObject(mirror::Object* dummy, size_t byte_size)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Mark an object in a non-moving or large object space. Returns true if newly marked.
+  bool MarkNonMoving(mirror::Object* ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Push a gray object. The collector thread uses its own stack, mutators share a locked one.
+  void PushOntoMarkStack(Thread* self, mirror::Object* to_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Scan gray objects until both the collector's and the mutators' mark stacks are empty.
+  void ProcessMarkStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Forward the references from the immune spaces recorded in the mod-union tables.
+  void UpdateAndMarkModUnion() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Add the image and zygote spaces to the immune region.
+  void BindBitmaps() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Objects allocated in the non-moving spaces while marking are allocated black.
+  void MarkAllocStackAsMarked() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void ProcessReferences(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SweepSystemWeaks(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Sweep the non-moving spaces and the large object space.
+  void Sweep(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+  bool ShouldSweepSpace(space::ContinuousSpace* space) const;
+
+  // Record how much was freed by evacuating the from-space, then release it.
+  void ReleaseFromSpace() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  space::BumpPointerSpace* from_space_;
+  space::BumpPointerSpace* to_space_;
+
+  // Size of the from-space at the flip. The thread local counts of the TLABs in the to-space would
+  // otherwise be included when querying the from-space later on.
+  uint64_t from_space_bytes_;
+  uint64_t from_space_objects_;
+
+  // Cached heap mark bitmap.
+  accounting::HeapBitmap* heap_mark_bitmap_;
+
+  // Every object inside the immune region is assumed to be marked.
+  ImmuneRegion immune_region_;
+
+  // The thread running the collection. It pushes onto mark_stack_ without locking.
+  Thread* thread_running_gc_;
+  std::vector<mirror::Object*> mark_stack_;
+
+  // Gray objects copied or marked by the mutators through the read barrier.
+  Mutex mutator_mark_stack_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<mirror::Object*> mutator_mark_stack_ GUARDED_BY(mutator_mark_stack_lock_);
+
+  volatile bool is_marking_;
+
+  // How many objects and bytes were evacuated, by both the collector and the mutators.
+  AtomicInteger objects_moved_;
+  Atomic<size_t> bytes_moved_;
+  // Bytes wasted by copies that lost the race to another thread.
+  Atomic<size_t> bytes_wasted_;
+
+  friend class ConcurrentCopyingRefFieldsVisitor;
   DISALLOW_COPY_AND_ASSIGN(ConcurrentCopying);
 };
 
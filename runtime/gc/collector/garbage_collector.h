@@ -121,7 +121,12 @@ class GarbageCollector {
   }
 
   // Reset the cumulative timings and pause histogram.
-  void ResetMeasurements();
+  virtual void ResetMeasurements();
+
+  // Dump collector specific performance information in addition to the timings.
+  virtual void DumpPerformanceInfo(std::ostream& os) {
+    UNUSED(os);
+  }
 
   // Returns the estimated throughput in bytes / second.
   uint64_t GetEstimatedMeanThroughput() const;
@@ -37,6 +37,10 @@ inline void MarkSweep::ScanObjectVisit(mirror::Object* obj, const MarkVisitor& v
     LOG(FATAL) << "Scanning unmarked object " << obj;
   }
   obj->VisitReferences<false>(visitor, ref_visitor);
+  if (unload_classes_ &&
+      UNLIKELY(obj->GetClass<kVerifyNone>()->IsClassLoaderClass<kVerifyNone>())) {
+    RecordScannedClassLoader(obj);
+  }
   if (kCountScannedTypes) {
     mirror::Class* klass = obj->GetClass<kVerifyNone>();
     if (UNLIKELY(klass == mirror::Class::GetJavaLangClass())) {
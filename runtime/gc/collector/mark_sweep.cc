@@ -16,6 +16,8 @@
 
 #include "mark_sweep.h"
 
+#include <sched.h>
+
 #include <functional>
 #include <numeric>
 #include <climits>
@@ -26,6 +28,7 @@
 #include "base/macros.h"
 #include "base/mutex-inl.h"
 #include "base/timing_logger.h"
+#include "class_linker.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/accounting/mod_union_table.h"
@@ -37,6 +40,7 @@
 #include "gc/space/space-inl.h"
 #include "mark_sweep-inl.h"
 #include "mirror/art_field-inl.h"
+#include "mirror/class_loader.h"
 #include "mirror/object-inl.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
@@ -67,6 +71,12 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+// Number of free mark stack segments kept for the next GC, as much memory as the heap's initial
+// mark stack on 64-bit.
+static constexpr size_t kMaxFreeMarkStackSegments = 128;
+static constexpr bool kParallelSweep = true;
+// Don't split the sweeping of a space into ranges smaller than this.
+static constexpr size_t kMinimumParallelSweepRange = 1 * MB;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -83,6 +93,12 @@ static constexpr bool kVerifyRootsMarked = kIsDebugBuild;
 // checkpoint, as opposed to during the pause.
 static constexpr bool kRevokeRosAllocThreadLocalBuffersAtCheckpoint = true;
 
+// Mark the roots of suspended threads on the heap thread pool at checkpoints.
+static constexpr bool kParallelThreadRootMarking = true;
+
+// Sweep the system weak tables on the heap thread pool.
+static constexpr bool kParallelSystemWeakSweeping = true;
+
 void MarkSweep::BindBitmaps() {
   timings_.StartSplit("BindBitmaps");
   WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
@@ -99,15 +115,16 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent, const std::string& name_pre
     : GarbageCollector(heap,
                        name_prefix +
                        (is_concurrent ? "concurrent mark sweep": "mark sweep")),
+      mark_stack_segments_("mark sweep mark stack segments"),
+      mark_stack_(&mark_stack_segments_),
       gc_barrier_(new Barrier(0)),
       mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
-      is_concurrent_(is_concurrent) {
+      is_concurrent_(is_concurrent),
+      unload_classes_(false) {
 }
 
 void MarkSweep::InitializePhase() {
   TimingLogger::ScopedSplit split("InitializePhase", &timings_);
-  mark_stack_ = heap_->mark_stack_.get();
-  DCHECK(mark_stack_ != nullptr);
   immune_region_.Reset();
   class_count_ = 0;
   array_count_ = 0;
@@ -131,6 +148,9 @@ void MarkSweep::InitializePhase() {
     // Always clear soft references if a non-sticky collection.
     clear_soft_references_ = GetGcType() != collector::kGcTypeSticky;
   }
+  // The sticky collections don't scan enough of the heap to tell that a class loader is dead.
+  unload_classes_ = GetGcType() != collector::kGcTypeSticky &&
+      Runtime::Current()->CanUnloadClasses();
 }
 
 void MarkSweep::RunPhases() {
@@ -326,33 +346,12 @@ void MarkSweep::FindDefaultSpaceBitmap() {
   }
 }
 
-void MarkSweep::ExpandMarkStack() {
-  ResizeMarkStack(mark_stack_->Capacity() * 2);
-}
-
-void MarkSweep::ResizeMarkStack(size_t new_size) {
-  // Rare case, no need to have Thread::Current be a parameter.
-  if (UNLIKELY(mark_stack_->Size() < mark_stack_->Capacity())) {
-    // Someone else acquired the lock and expanded the mark stack before us.
-    return;
-  }
-  std::vector<Object*> temp(mark_stack_->Begin(), mark_stack_->End());
-  CHECK_LE(mark_stack_->Size(), new_size);
-  mark_stack_->Resize(new_size);
-  for (const auto& obj : temp) {
-    mark_stack_->PushBack(obj);
-  }
-}
-
 inline void MarkSweep::MarkObjectNonNullParallel(Object* obj) {
   DCHECK(obj != nullptr);
   if (MarkObjectParallel(obj)) {
     MutexLock mu(Thread::Current(), mark_stack_lock_);
-    if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
-      ExpandMarkStack();
-    }
     // The object must be pushed on to the mark stack.
-    mark_stack_->PushBack(obj);
+    mark_stack_.PushBack(obj);
   }
 }
 
@@ -423,13 +422,8 @@ inline void MarkSweep::MarkObjectNonNull(Object* obj) {
 }
 
 inline void MarkSweep::PushOnMarkStack(Object* obj) {
-  if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
-    // Lock is not needed but is here anyways to please annotalysis.
-    MutexLock mu(Thread::Current(), mark_stack_lock_);
-    ExpandMarkStack();
-  }
   // The object must be pushed on to the mark stack.
-  mark_stack_->PushBack(obj);
+  mark_stack_.PushBack(obj);
 }
 
 inline bool MarkSweep::MarkObjectParallel(const Object* obj) {
@@ -500,10 +494,13 @@ void MarkSweep::VerifyRoots() {
 }
 
 void MarkSweep::MarkRoots(Thread* self) {
+  const int class_unloading = unload_classes_ ? kVisitRootFlagClassUnloading : 0;
   if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
     // If we exclusively hold the mutator lock, all threads must be suspended.
     timings_.StartSplit("MarkRoots");
-    Runtime::Current()->VisitRoots(MarkRootCallback, this);
+    Runtime::Current()->VisitRoots(MarkRootCallback, this,
+                                   static_cast<VisitRootFlags>(kVisitRootFlagAllRoots |
+                                                               class_unloading));
     timings_.EndSplit();
     RevokeAllThreadLocalAllocationStacks(self);
   } else {
@@ -511,10 +508,39 @@ void MarkSweep::MarkRoots(Thread* self) {
     // At this point the live stack should no longer have any mutators which push into it.
     MarkNonThreadRoots();
     MarkConcurrentRoots(
-        static_cast<VisitRootFlags>(kVisitRootFlagAllRoots | kVisitRootFlagStartLoggingNewRoots));
+        static_cast<VisitRootFlags>(kVisitRootFlagAllRoots | kVisitRootFlagStartLoggingNewRoots |
+                                    class_unloading));
+  }
+  if (unload_classes_) {
+    // The objects of the immune spaces aren't scanned, their class loaders are never unloaded.
+    std::vector<mirror::ClassLoader*> class_loaders;
+    Runtime::Current()->GetClassLinker()->GetClassLoaders(&class_loaders);
+    for (mirror::ClassLoader* class_loader : class_loaders) {
+      if (immune_region_.ContainsObject(class_loader)) {
+        RecordScannedClassLoader(class_loader);
+      }
+    }
   }
 }
 
+void MarkSweep::RecordScannedClassLoader(mirror::Object* class_loader) {
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  scanned_class_loaders_.push_back(down_cast<mirror::ClassLoader*>(class_loader));
+}
+
+bool MarkSweep::MarkClassLoaderClasses() {
+  std::vector<mirror::ClassLoader*> class_loaders;
+  {
+    MutexLock mu(Thread::Current(), mark_stack_lock_);
+    class_loaders.swap(scanned_class_loaders_);
+  }
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  for (mirror::ClassLoader* class_loader : class_loaders) {
+    class_linker->VisitClassLoaderClasses(class_loader, MarkRootCallback, this);
+  }
+  return !class_loaders.empty();
+}
+
 void MarkSweep::MarkNonThreadRoots() {
   timings_.StartSplit("MarkNonThreadRoots");
   Runtime::Current()->VisitNonThreadRoots(MarkRootCallback, this);
@@ -561,26 +587,23 @@ class DelayReferenceReferentVisitor {
   MarkSweep* const collector_;
 };
 
+typedef accounting::SegmentedObjectStack::Segment MarkStackSegment;
+
 template <bool kUseFinger = false>
 class MarkStackTask : public Task {
  public:
-  MarkStackTask(ThreadPool* thread_pool, MarkSweep* mark_sweep, size_t mark_stack_size,
-                Object** mark_stack)
+  // Takes ownership of the mark stack segment, or starts with an empty one if it is null.
+  MarkStackTask(ThreadPool* thread_pool, MarkSweep* mark_sweep, MarkStackSegment* mark_stack)
       : mark_sweep_(mark_sweep),
         thread_pool_(thread_pool),
-        mark_stack_pos_(mark_stack_size) {
-    // We may have to copy part of an existing mark stack when another mark stack overflows.
-    if (mark_stack_size != 0) {
-      DCHECK(mark_stack != NULL);
-      // TODO: Check performance?
-      std::copy(mark_stack, mark_stack + mark_stack_size, mark_stack_);
-    }
+        mark_stack_(mark_stack != nullptr ? mark_stack :
+                    mark_sweep->mark_stack_segments_.Allocate()) {
     if (kCountTasks) {
       ++mark_sweep_->work_chunks_created_;
     }
   }
 
-  static const size_t kMaxSize = 1 * KB;
+  static const size_t kMaxSize = MarkStackSegment::kCapacity;
 
  protected:
   class MarkObjectParallelVisitor {
@@ -629,7 +652,8 @@ class MarkStackTask : public Task {
 
   virtual ~MarkStackTask() {
     // Make sure that we have cleared our mark stack.
-    DCHECK_EQ(mark_stack_pos_, 0U);
+    DCHECK(mark_stack_->IsEmpty());
+    mark_sweep_->mark_stack_segments_.Free(mark_stack_);
     if (kCountTasks) {
       ++mark_sweep_->work_chunks_deleted_;
     }
@@ -638,21 +662,18 @@ class MarkStackTask : public Task {
   MarkSweep* const mark_sweep_;
   ThreadPool* const thread_pool_;
   // Thread local mark stack for this task.
-  Object* mark_stack_[kMaxSize];
-  // Mark stack position.
-  size_t mark_stack_pos_;
+  MarkStackSegment* mark_stack_;
 
   void MarkStackPush(Object* obj) ALWAYS_INLINE {
-    if (UNLIKELY(mark_stack_pos_ == kMaxSize)) {
-      // Mark stack overflow, give 1/2 the stack to the thread pool as a new work task.
-      mark_stack_pos_ /= 2;
-      auto* task = new MarkStackTask(thread_pool_, mark_sweep_, kMaxSize - mark_stack_pos_,
-                                     mark_stack_ + mark_stack_pos_);
+    if (UNLIKELY(mark_stack_->IsFull())) {
+      // Mark stack overflow, give the full segment to the thread pool as a new work task and
+      // continue with an empty one. Nothing is copied.
+      auto* task = new MarkStackTask(thread_pool_, mark_sweep_, mark_stack_);
+      mark_stack_ = mark_sweep_->mark_stack_segments_.Allocate();
       thread_pool_->AddTask(Thread::Current(), task);
     }
     DCHECK(obj != nullptr);
-    DCHECK_LT(mark_stack_pos_, kMaxSize);
-    mark_stack_[mark_stack_pos_++] = obj;
+    mark_stack_->PushBack(obj);
   }
 
   virtual void Finalize() {
@@ -669,8 +690,8 @@ class MarkStackTask : public Task {
     for (;;) {
       Object* obj = nullptr;
       if (kUseMarkStackPrefetch) {
-        while (mark_stack_pos_ != 0 && prefetch_fifo.size() < kFifoSize) {
-          Object* obj = mark_stack_[--mark_stack_pos_];
+        while (!mark_stack_->IsEmpty() && prefetch_fifo.size() < kFifoSize) {
+          Object* obj = mark_stack_->PopBack();
           DCHECK(obj != nullptr);
           __builtin_prefetch(obj);
           prefetch_fifo.push_back(obj);
@@ -681,10 +702,10 @@ class MarkStackTask : public Task {
         obj = prefetch_fifo.front();
         prefetch_fifo.pop_front();
       } else {
-        if (UNLIKELY(mark_stack_pos_ == 0)) {
+        if (UNLIKELY(mark_stack_->IsEmpty())) {
           break;
         }
-        obj = mark_stack_[--mark_stack_pos_];
+        obj = mark_stack_->PopBack();
       }
       DCHECK(obj != nullptr);
       visitor(obj);
@@ -696,9 +717,8 @@ class CardScanTask : public MarkStackTask<false> {
  public:
   CardScanTask(ThreadPool* thread_pool, MarkSweep* mark_sweep,
                accounting::ContinuousSpaceBitmap* bitmap,
-               byte* begin, byte* end, byte minimum_age, size_t mark_stack_size,
-               Object** mark_stack_obj)
-      : MarkStackTask<false>(thread_pool, mark_sweep, mark_stack_size, mark_stack_obj),
+               byte* begin, byte* end, byte minimum_age, MarkStackSegment* mark_stack)
+      : MarkStackTask<false>(thread_pool, mark_sweep, mark_stack),
         bitmap_(bitmap),
         begin_(begin),
         end_(end),
@@ -748,9 +768,7 @@ void MarkSweep::ScanGrayObjects(bool paused, byte minimum_age) {
     // scanned at the same time.
     timings_.StartSplit(paused ? "(Paused)ScanGrayObjects" : "ScanGrayObjects");
     // Try to take some of the mark stack since we can pass this off to the worker tasks.
-    Object** mark_stack_begin = mark_stack_->Begin();
-    Object** mark_stack_end = mark_stack_->End();
-    const size_t mark_stack_size = mark_stack_end - mark_stack_begin;
+    const size_t mark_stack_size = mark_stack_.Size();
     // Estimated number of work tasks we will create.
     const size_t mark_stack_tasks = GetHeap()->GetContinuousSpaces().size() * thread_count;
     DCHECK_NE(mark_stack_tasks, 0U);
@@ -777,16 +795,14 @@ void MarkSweep::ScanGrayObjects(bool paused, byte minimum_age) {
         // Add a range of cards.
         size_t addr_remaining = card_end - card_begin;
         size_t card_increment = std::min(card_delta, addr_remaining);
-        // Take from the back of the mark stack.
-        size_t mark_stack_remaining = mark_stack_end - mark_stack_begin;
-        size_t mark_stack_increment = std::min(mark_stack_delta, mark_stack_remaining);
-        mark_stack_end -= mark_stack_increment;
-        mark_stack_->PopBackCount(static_cast<int32_t>(mark_stack_increment));
-        DCHECK_EQ(mark_stack_end, mark_stack_->End());
+        // Take from the back of the mark stack, the task starts with an empty stack once it is
+        // exhausted.
+        MarkStackSegment* mark_stack = mark_stack_.PopSegment(mark_stack_delta);
         // Add the new task to the thread pool.
         auto* task = new CardScanTask(thread_pool, this, space->GetMarkBitmap(), card_begin,
-                                      card_begin + card_increment, minimum_age,
-                                      mark_stack_increment, mark_stack_end);
+                                      card_begin + card_increment, minimum_age, mark_stack);
+        // Leave the cards to a worker on the node of their objects if the pool is NUMA aware.
+        task->SetNumaNode(thread_pool->GetNumaNodeOfAddress(card_begin));
         thread_pool->AddTask(self, task);
         card_begin += card_increment;
       }
@@ -830,7 +846,7 @@ class RecursiveMarkTask : public MarkStackTask<false> {
  public:
   RecursiveMarkTask(ThreadPool* thread_pool, MarkSweep* mark_sweep,
                     accounting::ContinuousSpaceBitmap* bitmap, uintptr_t begin, uintptr_t end)
-      : MarkStackTask<false>(thread_pool, mark_sweep, 0, NULL),
+      : MarkStackTask<false>(thread_pool, mark_sweep, nullptr),
         bitmap_(bitmap),
         begin_(begin),
         end_(end) {
@@ -867,7 +883,7 @@ void MarkSweep::RecursiveMark() {
     ThreadPool* thread_pool = heap_->GetThreadPool();
     size_t thread_count = GetThreadCount(false);
     const bool parallel = kParallelRecursiveMark && thread_count > 1;
-    mark_stack_->Reset();
+    mark_stack_.Reset();
     for (const auto& space : GetHeap()->GetContinuousSpaces()) {
       if ((space->GetGcRetentionPolicy() == space::kGcRetentionPolicyAlwaysCollect) ||
           (!partial && space->GetGcRetentionPolicy() == space::kGcRetentionPolicyFullCollect)) {
@@ -877,7 +893,7 @@ void MarkSweep::RecursiveMark() {
         }
         if (parallel) {
           // We will use the mark stack the future.
-          // CHECK(mark_stack_->IsEmpty());
+          // CHECK(mark_stack_.IsEmpty());
           // This function does not handle heap end increasing, so we must use the space end.
           uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin());
           uintptr_t end = reinterpret_cast<uintptr_t>(space->End());
@@ -893,6 +909,7 @@ void MarkSweep::RecursiveMark() {
             begin += delta;
             auto* task = new RecursiveMarkTask(thread_pool, this, current_space_bitmap_, start,
                                                begin);
+            task->SetNumaNode(thread_pool->GetNumaNodeOfAddress(reinterpret_cast<void*>(start)));
             thread_pool->AddTask(self, task);
           }
           thread_pool->SetMaxActiveWorkers(thread_count - 1);
@@ -941,7 +958,8 @@ void MarkSweep::ReMarkRoots() {
 void MarkSweep::SweepSystemWeaks(Thread* self) {
   WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
   timings_.StartSplit("SweepSystemWeaks");
-  Runtime::Current()->SweepSystemWeaks(IsMarkedCallback, this);
+  ThreadPool* thread_pool = kParallelSystemWeakSweeping ? heap_->GetThreadPool() : nullptr;
+  Runtime::Current()->SweepSystemWeaks(IsMarkedCallback, this, thread_pool);
   timings_.EndSplit();
 }
 
@@ -1002,9 +1020,13 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self,
   CheckpointMarkThreadRoots check_point(this, revoke_ros_alloc_thread_local_buffers_at_checkpoint);
   timings_.StartSplit("MarkRootsCheckpoint");
   ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  // The roots of the threads suspended in native code are marked by the GC thread, spread them
+  // over the thread pool since there may be hundreds of such threads.
+  ThreadPool* thread_pool = kParallelThreadRootMarking ? heap_->GetThreadPool() : nullptr;
   // Request the check point is run on all threads returning a count of the threads that must
   // run through the barrier including self.
-  size_t barrier_count = thread_list->RunCheckpoint(&check_point);
+  size_t barrier_count = thread_list->RunCheckpoint(&check_point, thread_pool);
+  timings_.NewSplit("MarkRootsCheckpointWait");
   // Release locks then wait for all mutator threads to pass the barrier.
   // TODO: optimize to not release locks when there are no threads to wait for.
   Locks::heap_bitmap_lock_->ExclusiveUnlock(self);
@@ -1133,21 +1155,88 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
   live_stack->Reset();
   timings_.EndSplit();
 
-  DCHECK(mark_stack_->IsEmpty());
+  DCHECK(mark_stack_.IsEmpty());
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     if (space->IsContinuousMemMapAllocSpace()) {
       space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
       TimingLogger::ScopedSplit split(
           alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepMallocSpace", &timings_);
-      size_t freed_objects = 0;
-      size_t freed_bytes = 0;
-      alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
-      RecordFree(freed_objects, freed_bytes);
+      if (kParallelSweep && thread_count > 1 &&
+          alloc_space->Size() >= 2 * kMinimumParallelSweepRange) {
+        SweepSpaceParallel(alloc_space, swap_bitmaps, thread_count);
+      } else {
+        size_t freed_objects = 0;
+        size_t freed_bytes = 0;
+        alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+        RecordFree(freed_objects, freed_bytes);
+      }
     }
   }
   SweepLargeObjects(swap_bitmaps);
 }
 
+class SweepTask : public Task {
+ public:
+  SweepTask(space::ContinuousMemMapAllocSpace* space, bool swap_bitmaps, uintptr_t begin,
+            uintptr_t end, Atomic<size_t>* freed_objects, Atomic<size_t>* freed_bytes)
+      : space_(space), swap_bitmaps_(swap_bitmaps), begin_(begin), end_(end),
+        freed_objects_(freed_objects), freed_bytes_(freed_bytes) {
+  }
+
+ protected:
+  space::ContinuousMemMapAllocSpace* const space_;
+  const bool swap_bitmaps_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  Atomic<size_t>* const freed_objects_;
+  Atomic<size_t>* const freed_bytes_;
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+  // The thread running the GC holds the heap bitmap lock exclusively until all tasks are done.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    size_t freed_objects = 0;
+    size_t freed_bytes = 0;
+    space_->SweepRange(swap_bitmaps_, begin_, end_, true, &freed_objects, &freed_bytes);
+    freed_objects_->FetchAndAdd(freed_objects);
+    freed_bytes_->FetchAndAdd(freed_bytes);
+  }
+};
+
+void MarkSweep::SweepSpaceParallel(space::ContinuousMemMapAllocSpace* space, bool swap_bitmaps,
+                                   size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  // This function does not handle heap end increasing, so we must use the space end.
+  uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(space->End());
+  DCHECK_ALIGNED(begin, space::ContinuousMemMapAllocSpace::kSweepRangeAlignment);
+  // Create a few more tasks than threads since the garbage is rarely spread evenly. The range
+  // bounds are aligned so that no two tasks clear bits in the same live bitmap word.
+  const size_t delta = std::max(
+      RoundUp((end - begin) / (thread_count * 2),
+              space::ContinuousMemMapAllocSpace::kSweepRangeAlignment),
+      kMinimumParallelSweepRange);
+  Atomic<size_t> freed_objects(0);
+  Atomic<size_t> freed_bytes(0);
+  while (begin < end) {
+    const uintptr_t task_end = std::min(begin + delta, end);
+    auto* task = new SweepTask(space, swap_bitmaps, begin, task_end, &freed_objects,
+                               &freed_bytes);
+    task->SetNumaNode(thread_pool->GetNumaNodeOfAddress(reinterpret_cast<void*>(begin)));
+    thread_pool->AddTask(self, task);
+    begin = task_end;
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  RecordFree(freed_objects.Load(), freed_bytes.Load());
+}
+
 void MarkSweep::SweepLargeObjects(bool swap_bitmaps) {
   TimingLogger::ScopedSplit split("SweepLargeObjects", &timings_);
   size_t freed_objects = 0;
@@ -1197,23 +1286,222 @@ void MarkSweep::ProcessMarkStackCallback(void* arg) {
   reinterpret_cast<MarkSweep*>(arg)->ProcessMarkStack(false);
 }
 
+// A mark stack which other GC threads steal from once they run out of work. The thread running
+// the task pushes to and pops from its current segment without locking. Full segments are published
+// on a deque, the owner takes back the newest ones and the thieves take the oldest ones, which are
+// the most likely to lead to large subgraphs.
+class WorkStealingMarkStackTask : public WorkStealingTask {
+ public:
+  explicit WorkStealingMarkStackTask(MarkSweep* mark_sweep)
+      : mark_sweep_(mark_sweep),
+        segments_(&mark_sweep->mark_stack_segments_),
+        lock_("work stealing mark stack lock", kMarkSweepMarkStackLock),
+        current_(nullptr),
+        spare_(nullptr) {
+  }
+
+  virtual ~WorkStealingMarkStackTask() NO_THREAD_SAFETY_ANALYSIS {
+    DCHECK(published_.empty());
+    if (current_ != nullptr) {
+      DCHECK(current_->IsEmpty());
+      segments_->Free(current_);
+    }
+    if (spare_ != nullptr) {
+      segments_->Free(spare_);
+    }
+  }
+
+  // Publishes a segment of the mark stack, used to hand out the work before the task runs.
+  void AddSegment(Thread* self, MarkStackSegment* segment) {
+    MutexLock mu(self, lock_);
+    published_.push_back(segment);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    ProcessSegments(self);
+  }
+
+  // Steal the oldest segment published by the source and process it.
+  virtual void StealFrom(Thread* self, WorkStealingTask* source) NO_THREAD_SAFETY_ANALYSIS {
+    WorkStealingMarkStackTask* victim = down_cast<WorkStealingMarkStackTask*>(source);
+    MarkStackSegment* stolen = nullptr;
+    {
+      MutexLock mu(self, victim->lock_);
+      if (!victim->published_.empty()) {
+        stolen = victim->published_.front();
+        victim->published_.pop_front();
+      }
+    }
+    if (stolen == nullptr) {
+      // The victim is busy scanning but has not filled a segment, give it a chance to push more.
+      sched_yield();
+      return;
+    }
+    AddSegment(self, stolen);
+    ProcessSegments(self);
+  }
+
+ private:
+  class MarkObjectVisitor {
+   public:
+    explicit MarkObjectVisitor(WorkStealingMarkStackTask* task) ALWAYS_INLINE : task_(task) {}
+
+    void operator()(Object* obj, MemberOffset offset, bool /* static */) const ALWAYS_INLINE
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+      mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+      if (ref != nullptr && task_->mark_sweep_->MarkObjectParallel(ref)) {
+        task_->Push(ref);
+      }
+    }
+
+   private:
+    WorkStealingMarkStackTask* const task_;
+  };
+
+  void Push(Object* obj) {
+    if (UNLIKELY(current_->IsFull())) {
+      // Publish the full segment so that idle threads can steal it and continue with an empty one.
+      AddSegment(Thread::Current(), current_);
+      current_ = TakeEmptySegment();
+    }
+    current_->PushBack(obj);
+  }
+
+  // The spare segment is a per thread cache which saves going through the shared pool each time
+  // the current segment is published and taken back.
+  MarkStackSegment* TakeEmptySegment() {
+    MarkStackSegment* segment = spare_;
+    if (segment != nullptr) {
+      spare_ = nullptr;
+      return segment;
+    }
+    return segments_->Allocate();
+  }
+
+  // Scan objects from the current segment, then from the segments published by this task, until
+  // there are none left.
+  void ProcessSegments(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    MarkObjectVisitor mark_visitor(this);
+    DelayReferenceReferentVisitor ref_visitor(mark_sweep_);
+    if (current_ == nullptr) {
+      current_ = TakeEmptySegment();
+    }
+    size_t scanned = 0;
+    for (;;) {
+      if (UNLIKELY(current_->IsEmpty())) {
+        MarkStackSegment* next = nullptr;
+        {
+          MutexLock mu(self, lock_);
+          if (!published_.empty()) {
+            next = published_.back();
+            published_.pop_back();
+          }
+        }
+        if (next == nullptr) {
+          break;
+        }
+        if (spare_ == nullptr) {
+          spare_ = current_;
+        } else {
+          segments_->Free(current_);
+        }
+        current_ = next;
+        continue;
+      }
+      Object* obj = current_->PopBack();
+      mark_sweep_->ScanObjectVisit(obj, mark_visitor, ref_visitor);
+      ++scanned;
+    }
+    mark_sweep_->RecordWorkStealingScannedObjects(self, scanned);
+  }
+
+  MarkSweep* const mark_sweep_;
+  accounting::SegmentedObjectStack::Pool* const segments_;
+  Mutex lock_;
+  // Segments which other threads may steal.
+  std::deque<MarkStackSegment*> published_ GUARDED_BY(lock_);
+  // The segments only used by the thread running the task.
+  MarkStackSegment* current_;
+  MarkStackSegment* spare_;
+};
+
+void MarkSweep::ProcessMarkStackWorkStealing(size_t thread_count) {
+  Thread* self = Thread::Current();
+  WorkStealingThreadPool* thread_pool = GetHeap()->GetWorkStealingThreadPool();
+  // At most one task per worker, the workers balance the load between themselves by stealing.
+  // Small mark stacks are split so that every worker starts with some work.
+  const size_t chunk_size = std::min(mark_stack_.Size() / thread_count + 1,
+                                     static_cast<size_t>(MarkStackSegment::kCapacity));
+  std::vector<WorkStealingMarkStackTask*> tasks;
+  for (size_t i = 0; !mark_stack_.IsEmpty(); ++i) {
+    if (i < thread_count) {
+      tasks.push_back(new WorkStealingMarkStackTask(this));
+    }
+    tasks[i % thread_count]->AddSegment(self, mark_stack_.PopSegment(chunk_size));
+  }
+  for (WorkStealingMarkStackTask* task : tasks) {
+    thread_pool->AddTask(self, task);
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count);
+  thread_pool->StartWorkers(self);
+  // The work stealing workers only steal from tasks run by other workers, we can't help out.
+  thread_pool->Wait(self, false, true);
+  thread_pool->StopWorkers(self);
+  mark_stack_.Reset();
+}
+
+void MarkSweep::RecordWorkStealingScannedObjects(Thread* self, size_t count) {
+  MutexLock mu(self, mark_stack_lock_);
+  auto it = work_stealing_scanned_objects_.find(self->GetTid());
+  if (it == work_stealing_scanned_objects_.end()) {
+    work_stealing_scanned_objects_.Put(self->GetTid(), count);
+  } else {
+    it->second += count;
+  }
+}
+
+void MarkSweep::ResetMeasurements() {
+  GarbageCollector::ResetMeasurements();
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  work_stealing_scanned_objects_.clear();
+}
+
+void MarkSweep::DumpPerformanceInfo(std::ostream& os) {
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  if (work_stealing_scanned_objects_.empty()) {
+    return;
+  }
+  os << GetName() << " work stealing objects scanned per thread:";
+  for (const auto& pair : work_stealing_scanned_objects_) {
+    os << " " << pair.first << "=" << pair.second;
+  }
+  os << "\n";
+}
+
 void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
+  if (kUseWorkStealingMarking && GetHeap()->GetWorkStealingThreadPool() != nullptr) {
+    ProcessMarkStackWorkStealing(thread_count);
+    return;
+  }
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
-  const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
+  const size_t chunk_size = std::min(mark_stack_.Size() / thread_count + 1,
                                      static_cast<size_t>(MarkStackTask<false>::kMaxSize));
   CHECK_GT(chunk_size, 0U);
-  // Split the current mark stack up into work tasks.
-  for (mirror::Object **it = mark_stack_->Begin(), **end = mark_stack_->End(); it < end; ) {
-    const size_t delta = std::min(static_cast<size_t>(end - it), chunk_size);
-    thread_pool->AddTask(self, new MarkStackTask<false>(thread_pool, this, delta, it));
-    it += delta;
+  // Split the current mark stack up into work tasks, whole segments are handed over as they are.
+  while (!mark_stack_.IsEmpty()) {
+    thread_pool->AddTask(self, new MarkStackTask<false>(thread_pool, this,
+                                                        mark_stack_.PopSegment(chunk_size)));
   }
   thread_pool->SetMaxActiveWorkers(thread_count - 1);
   thread_pool->StartWorkers(self);
   thread_pool->Wait(self, true, true);
   thread_pool->StopWorkers(self);
-  mark_stack_->Reset();
+  mark_stack_.Reset();
   CHECK_EQ(work_chunks_created_, work_chunks_deleted_) << " some of the work chunks were leaked";
 }
 
@@ -1221,37 +1509,41 @@ void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
 void MarkSweep::ProcessMarkStack(bool paused) {
   timings_.StartSplit(paused ? "(Paused)ProcessMarkStack" : "ProcessMarkStack");
   size_t thread_count = GetThreadCount(paused);
-  if (kParallelProcessMarkStack && thread_count > 1 &&
-      mark_stack_->Size() >= kMinimumParallelMarkStackSize) {
-    ProcessMarkStackParallel(thread_count);
-  } else {
-    // TODO: Tune this.
-    static const size_t kFifoSize = 4;
-    BoundedFifoPowerOfTwo<Object*, kFifoSize> prefetch_fifo;
-    for (;;) {
-      Object* obj = NULL;
-      if (kUseMarkStackPrefetch) {
-        while (!mark_stack_->IsEmpty() && prefetch_fifo.size() < kFifoSize) {
-          Object* obj = mark_stack_->PopBack();
-          DCHECK(obj != NULL);
-          __builtin_prefetch(obj);
-          prefetch_fifo.push_back(obj);
-        }
-        if (prefetch_fifo.empty()) {
-          break;
-        }
-        obj = prefetch_fifo.front();
-        prefetch_fifo.pop_front();
-      } else {
-        if (mark_stack_->IsEmpty()) {
-          break;
+  // The classes of the class loaders scanned are marked once the mark stack is empty, which may
+  // fill it again.
+  do {
+    if (kParallelProcessMarkStack && thread_count > 1 &&
+        mark_stack_.Size() >= kMinimumParallelMarkStackSize) {
+      ProcessMarkStackParallel(thread_count);
+    } else {
+      // TODO: Tune this.
+      static const size_t kFifoSize = 4;
+      BoundedFifoPowerOfTwo<Object*, kFifoSize> prefetch_fifo;
+      for (;;) {
+        Object* obj = NULL;
+        if (kUseMarkStackPrefetch) {
+          while (!mark_stack_.IsEmpty() && prefetch_fifo.size() < kFifoSize) {
+            Object* obj = mark_stack_.PopBack();
+            DCHECK(obj != NULL);
+            __builtin_prefetch(obj);
+            prefetch_fifo.push_back(obj);
+          }
+          if (prefetch_fifo.empty()) {
+            break;
+          }
+          obj = prefetch_fifo.front();
+          prefetch_fifo.pop_front();
+        } else {
+          if (mark_stack_.IsEmpty()) {
+            break;
+          }
+          obj = mark_stack_.PopBack();
         }
-        obj = mark_stack_->PopBack();
+        DCHECK(obj != nullptr);
+        ScanObject(obj);
       }
-      DCHECK(obj != nullptr);
-      ScanObject(obj);
     }
-  }
+  } while (MarkClassLoaderClasses());
   timings_.EndSplit();
 }
 
@@ -1288,8 +1580,9 @@ void MarkSweep::FinishPhase() {
     VLOG(gc) << "Marked: null=" << mark_null_count_ << " immune=" <<  mark_immune_count_
         << " fastpath=" << mark_fastpath_count_ << " slowpath=" << mark_slowpath_count_;
   }
-  CHECK(mark_stack_->IsEmpty());  // Ensure that the mark stack is empty.
-  mark_stack_->Reset();
+  CHECK(mark_stack_.IsEmpty());  // Ensure that the mark stack is empty.
+  mark_stack_.Reset();
+  mark_stack_segments_.Trim(kMaxFreeMarkStackSegments);
   WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
   heap_->ClearMarkedObjects();
 }
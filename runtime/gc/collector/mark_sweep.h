@@ -17,21 +17,26 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_MARK_SWEEP_H_
 #define ART_RUNTIME_GC_COLLECTOR_MARK_SWEEP_H_
 
+#include <vector>
+
 #include "atomic.h"
 #include "barrier.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "garbage_collector.h"
 #include "gc/accounting/heap_bitmap.h"
+#include "gc/accounting/segmented_stack.h"
 #include "immune_region.h"
 #include "object_callbacks.h"
 #include "offsets.h"
+#include "safe_map.h"
 #include "UniquePtr.h"
 
 namespace art {
 
 namespace mirror {
   class Class;
+  class ClassLoader;
   class Object;
   class Reference;
 }  // namespace mirror
@@ -48,6 +53,10 @@ namespace accounting {
   typedef AtomicStack<mirror::Object*> ObjectStack;
 }  // namespace accounting
 
+namespace space {
+  class ContinuousMemMapAllocSpace;
+}  // namespace space
+
 namespace collector {
 
 class MarkSweep : public GarbageCollector {
@@ -78,6 +87,9 @@ class MarkSweep : public GarbageCollector {
     return is_concurrent_ ? kCollectorTypeCMS : kCollectorTypeMS;
   }
 
+  virtual void ResetMeasurements() OVERRIDE LOCKS_EXCLUDED(mark_stack_lock_);
+  virtual void DumpPerformanceInfo(std::ostream& os) OVERRIDE LOCKS_EXCLUDED(mark_stack_lock_);
+
   // Initializes internal structures.
   void Init();
 
@@ -136,6 +148,32 @@ class MarkSweep : public GarbageCollector {
   // all allocation spaces. Partial and sticky GCs want to just sweep a subset of the heap.
   virtual void Sweep(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // Process the mark stack with the work stealing thread pool, each worker stealing half of the
+  // objects of another worker's deque once its own is empty.
+  void ProcessMarkStackWorkStealing(size_t thread_count)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Record how many objects a thread scanned during work stealing marking.
+  void RecordWorkStealingScannedObjects(Thread* self, size_t count)
+      LOCKS_EXCLUDED(mark_stack_lock_);
+
+  // When unloading classes, records a class loader which was scanned so that its classes are
+  // marked once the mark stack is empty, see MarkClassLoaderClasses.
+  void RecordScannedClassLoader(mirror::Object* class_loader) LOCKS_EXCLUDED(mark_stack_lock_);
+
+  // Marks the classes of the class loaders scanned since the last call. Returns false if there
+  // were none, otherwise the mark stack needs to be processed again.
+  bool MarkClassLoaderClasses()
+      LOCKS_EXCLUDED(mark_stack_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Sweeps a space by splitting it into address ranges which are swept on the heap thread pool.
+  void SweepSpaceParallel(space::ContinuousMemMapAllocSpace* space, bool swap_bitmaps,
+                          size_t thread_count)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
   // Sweeps unmarked objects to complete the garbage collection.
   void SweepLargeObjects(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
@@ -233,10 +271,6 @@ class MarkSweep : public GarbageCollector {
   void VerifyRoots()
       NO_THREAD_SAFETY_ANALYSIS;
 
-  // Expand mark stack to 2x its current size.
-  void ExpandMarkStack() EXCLUSIVE_LOCKS_REQUIRED(mark_stack_lock_);
-  void ResizeMarkStack(size_t new_size) EXCLUSIVE_LOCKS_REQUIRED(mark_stack_lock_);
-
   // Returns how many threads we should use for the current GC phase based on if we are paused,
   // whether or not we care about pauses.
   size_t GetThreadCount(bool paused) const;
@@ -280,7 +314,10 @@ class MarkSweep : public GarbageCollector {
   // Cache the heap's mark bitmap to prevent having to do 2 loads during slow path marking.
   accounting::HeapBitmap* mark_bitmap_;
 
-  accounting::ObjectStack* mark_stack_;
+  // Segments of the mark stack and of the parallel mark tasks, kept from one GC to the next.
+  accounting::SegmentedObjectStack::Pool mark_stack_segments_;
+  // Grows by linking segments, so it never needs to be expanded.
+  accounting::SegmentedObjectStack mark_stack_;
 
   // Immune region, every object inside the immune range is assumed to be marked.
   ImmuneRegion immune_region_;
@@ -310,8 +347,19 @@ class MarkSweep : public GarbageCollector {
   UniquePtr<Barrier> gc_barrier_;
   Mutex mark_stack_lock_ ACQUIRED_AFTER(Locks::classlinker_classes_lock_);
 
+  // Number of objects scanned by each GC thread (by tid) during work stealing marking, since the
+  // last time the measurements were reset.
+  SafeMap<pid_t, uint64_t> work_stealing_scanned_objects_ GUARDED_BY(mark_stack_lock_);
+
+  // The class loaders scanned whose classes aren't marked yet.
+  std::vector<mirror::ClassLoader*> scanned_class_loaders_ GUARDED_BY(mark_stack_lock_);
+
   const bool is_concurrent_;
 
+  // Whether this collection unloads the classes of unreachable class loaders. Their classes are
+  // then marked when the class loaders are instead of as roots.
+  bool unload_classes_;
+
  private:
   friend class AddIfReachesAllocSpaceVisitor;  // Used by mod-union table.
   friend class CardScanTask;
@@ -329,6 +377,7 @@ class MarkSweep : public GarbageCollector {
   template<bool kUseFinger> friend class MarkStackTask;
   friend class FifoMarkStackChunk;
   friend class MarkSweepMarkObjectSlowPath;
+  friend class WorkStealingMarkStackTask;
 
   DISALLOW_COPY_AND_ASSIGN(MarkSweep);
 };
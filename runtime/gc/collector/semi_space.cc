@@ -29,6 +29,7 @@
 #include "gc/accounting/mod_union_table.h"
 #include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/allocation_site_table.h"
 #include "gc/heap.h"
 #include "gc/reference_processor.h"
 #include "gc/space/bump_pointer_space.h"
@@ -67,6 +68,8 @@ static constexpr bool kProtectFromSpace = true;
 static constexpr bool kStoreStackTraces = false;
 static constexpr size_t kBytesPromotedThreshold = 4 * MB;
 static constexpr size_t kLargeObjectBytesAllocatedThreshold = 16 * MB;
+// Sweep the system weak tables on the heap thread pool.
+static constexpr bool kParallelSystemWeakSweeping = true;
 
 void SemiSpace::BindBitmaps() {
   timings_.StartSplit("BindBitmaps");
@@ -237,10 +240,11 @@ void SemiSpace::MarkingPhase() {
   heap_->GetCardTable()->ClearCardTable();
   // Need to do this before the checkpoint since we don't want any threads to add references to
   // the live stack during the recursive mark.
-  timings_.NewSplit("SwapStacks");
   if (kUseThreadLocalAllocationStack) {
+    timings_.NewSplit("RevokeAllThreadLocalAllocationStacks");
     heap_->RevokeAllThreadLocalAllocationStacks(self_);
   }
+  timings_.NewSplit("SwapStacks");
   heap_->SwapStacks(self_);
   {
     WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
@@ -254,6 +258,7 @@ void SemiSpace::MarkingPhase() {
   {
     ReaderMutexLock mu(self_, *Locks::heap_bitmap_lock_);
     SweepSystemWeaks();
+    SweepAllocationSites();
   }
   timings_.NewSplit("RecordFree");
   // Revoke buffers before measuring how many objects were moved since the TLABs need to be revoked
@@ -654,10 +659,20 @@ mirror::Object* SemiSpace::MarkedForwardingAddressCallback(mirror::Object* objec
 
 void SemiSpace::SweepSystemWeaks() {
   timings_.StartSplit("SweepSystemWeaks");
-  Runtime::Current()->SweepSystemWeaks(MarkedForwardingAddressCallback, this);
+  ThreadPool* thread_pool = kParallelSystemWeakSweeping ? GetHeap()->GetThreadPool() : nullptr;
+  Runtime::Current()->SweepSystemWeaks(MarkedForwardingAddressCallback, this, thread_pool);
   timings_.EndSplit();
 }
 
+void SemiSpace::SweepAllocationSites() {
+  AllocationSiteTable* allocation_site_table = GetHeap()->GetAllocationSiteTable();
+  // The sampled objects were all allocated in the bump pointer space.
+  if (allocation_site_table != nullptr && from_space_->IsBumpPointerSpace()) {
+    TimingLogger::ScopedSplit split("SweepAllocationSites", &timings_);
+    allocation_site_table->SweepSamples(MarkedForwardingAddressCallback, this);
+  }
+}
+
 bool SemiSpace::ShouldSweepSpace(space::ContinuousSpace* space) const {
   return space != from_space_ && space != to_space_ && !immune_region_.ContainsSpace(space);
 }
@@ -38,6 +38,11 @@ enum CollectorType {
   kCollectorTypeHeapTrim,
   // A (mostly) concurrent copying collector.
   kCollectorTypeCC,
+  // Compaction of the main space into the backup space, with the same allocator.
+  kCollectorTypeHomogeneousSpaceCompact,
+  // Instance queries of the debuggers walking the heap on the heap thread pool, doesn't do any
+  // actual collecting.
+  kCollectorTypeHeapWalk,
 };
 std::ostream& operator<<(std::ostream& os, const CollectorType& collector_type);
 
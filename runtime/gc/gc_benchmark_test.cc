@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/histogram-inl.h"
+#include "common_runtime_test.h"
+#include "gc/collector/garbage_collector.h"
+#include "gc/heap.h"
+#include "mirror/array-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-inl.h"
+#include "sirt_ref.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+// Allocator and collector benchmarks. The tests are disabled so that the gtest targets only build
+// them, "make test-art-host-gc-benchmark" runs them. Every workload prints a line of space
+// separated key=value pairs with its throughput and footprint, followed by a line with the pause
+// percentiles of each collector which ran, all starting with "gc_benchmark".
+//
+// The runtime of the gtests is not started, so there is no GC daemon: the collections are the
+// ones triggered by the allocations.
+class GcBenchmarkTest : public CommonRuntimeTest {
+ public:
+  typedef void (GcBenchmarkTest::*Workload)(Thread* self);
+
+  explicit GcBenchmarkTest(const char* collector_name)
+      : collector_name_(collector_name), peak_footprint_(0) {}
+
+  virtual void SetUpRuntimeOptions(Runtime::Options* options) {
+    gc_option_ = std::string("-Xgc:") + collector_name_;
+    options->push_back(std::make_pair(gc_option_.c_str(), nullptr));
+  }
+
+  void RunWorkload(const char* workload_name, Workload workload) {
+    Thread* self = Thread::Current();
+    Heap* heap = Runtime::Current()->GetHeap();
+    // Leave out the garbage and the collections of the runtime creation.
+    heap->CollectGarbage(false);
+    const std::vector<collector::GarbageCollector*>& collectors = heap->GetGarbageCollectors();
+    for (collector::GarbageCollector* collector : collectors) {
+      collector->ResetMeasurements();
+    }
+    peak_footprint_ = heap->GetTotalMemory();
+    size_t bytes_allocated_before = heap->GetBytesAllocatedEver();
+    uint64_t start_time = NanoTime();
+    (this->*workload)(self);
+    uint64_t duration_ns = NanoTime() - start_time;
+    size_t bytes_allocated = heap->GetBytesAllocatedEver() - bytes_allocated_before;
+    SampleFootprint();
+
+    size_t gc_count = 0;
+    uint64_t gc_time_ns = 0;
+    for (collector::GarbageCollector* collector : collectors) {
+      gc_count += collector->GetIterations();
+      gc_time_ns += collector->GetCumulativeTimings().GetTotalNs();
+    }
+    double seconds = static_cast<double>(duration_ns) / 1e9;
+    printf("gc_benchmark collector=%s workload=%s duration_ms=%" PRIu64 " bytes_allocated=%zd "
+           "throughput_mb_per_s=%.1f gc_count=%zd gc_time_ms=%" PRIu64 " "
+           "peak_footprint_bytes=%zd final_footprint_bytes=%zd live_bytes=%zd\n",
+           collector_name_, workload_name, duration_ns / MsToNs(1), bytes_allocated,
+           static_cast<double>(bytes_allocated) / MB / seconds, gc_count, gc_time_ns / MsToNs(1),
+           peak_footprint_.Load(), heap->GetTotalMemory(), heap->GetBytesAllocated());
+    for (collector::GarbageCollector* collector : collectors) {
+      const Histogram<uint64_t>& pause_histogram = collector->GetPauseHistogram();
+      if (pause_histogram.SampleSize() == 0) {
+        continue;
+      }
+      Histogram<uint64_t>::CumulativeData cumulative_data;
+      pause_histogram.CreateHistogram(&cumulative_data);
+      printf("gc_benchmark collector=%s workload=%s gc=\"%s\" iterations=%zd pauses=%" PRIu64 " "
+             "pause_p50_us=%.0f pause_p90_us=%.0f pause_p99_us=%.0f pause_max_us=%" PRIu64 "\n",
+             collector_name_, workload_name, collector->GetName(), collector->GetIterations(),
+             pause_histogram.SampleSize(), pause_histogram.Percentile(0.5, cumulative_data),
+             pause_histogram.Percentile(0.9, cumulative_data),
+             pause_histogram.Percentile(0.99, cumulative_data), pause_histogram.Max());
+    }
+    fflush(stdout);
+  }
+
+  // Records the footprint of the heap if it is the largest seen by the workload.
+  void SampleFootprint() {
+    size_t footprint = Runtime::Current()->GetHeap()->GetTotalMemory();
+    size_t peak_footprint;
+    do {
+      peak_footprint = peak_footprint_.Load();
+      if (footprint <= peak_footprint) {
+        return;
+      }
+    } while (!peak_footprint_.CompareAndSwap(peak_footprint, footprint));
+  }
+
+  // Many small arrays which die young.
+  void AllocationStorm(Thread* self) {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i < kStormAllocations; ++i) {
+      CHECK(mirror::IntArray::Alloc(self, i % 16) != nullptr);
+      if (i % kFootprintSampleInterval == 0) {
+        SampleFootprint();
+      }
+    }
+  }
+
+  // A cache of small arrays whose entries are replaced in a random order, which keeps a large
+  // live set and fragments the heap.
+  void LongLivedCache(Thread* self) {
+    ScopedObjectAccess soa(self);
+    SirtRef<mirror::Class> object_array_class(self, GetObjectArrayClass(self));
+    SirtRef<mirror::ObjectArray<mirror::Object> > cache(self,
+        mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class.get(), kCacheSize));
+    CHECK(cache.get() != nullptr);
+    uint32_t random = 42;
+    for (size_t i = 0; i < kCacheSize + kCacheReplacements; ++i) {
+      mirror::IntArray* entry = mirror::IntArray::Alloc(self, 8 + i % 32);
+      CHECK(entry != nullptr);
+      // Fill the cache in order, then replace the entries in a pseudo-random order.
+      random = random * 1103515245 + 12345;
+      size_t index = i < kCacheSize ? i : (random >> 8) % kCacheSize;
+      cache->Set<false>(index, entry);
+      if (i % kFootprintSampleInterval == 0) {
+        SampleFootprint();
+      }
+    }
+  }
+
+  // Arrays larger than the large object threshold, a few of which stay live.
+  void LargeArrays(Thread* self) {
+    ScopedObjectAccess soa(self);
+    SirtRef<mirror::Class> object_array_class(self, GetObjectArrayClass(self));
+    SirtRef<mirror::ObjectArray<mirror::Object> > live(self,
+        mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class.get(), kLiveArrays));
+    CHECK(live.get() != nullptr);
+    for (size_t i = 0; i < kLargeArrayAllocations; ++i) {
+      size_t length = Heap::kDefaultLargeObjectThreshold * (1 + i % 64);
+      mirror::ByteArray* array = mirror::ByteArray::Alloc(self, length);
+      CHECK(array != nullptr);
+      live->Set<false>(i % kLiveArrays, array);
+      SampleFootprint();
+    }
+  }
+
+  class AllocationTask : public Task {
+   public:
+    explicit AllocationTask(GcBenchmarkTest* test) : test_(test) {}
+
+    void Run(Thread* self) {
+      test_->AllocationStorm(self);
+    }
+
+    void Finalize() {
+      delete this;
+    }
+
+   private:
+    GcBenchmarkTest* const test_;
+  };
+
+  // Allocation storms in several threads at once.
+  void MultiThreadedAllocation(Thread* self) {
+    ThreadPool thread_pool("GC benchmark thread pool", kAllocationThreads);
+    for (size_t i = 0; i < kAllocationThreads; ++i) {
+      thread_pool.AddTask(self, new AllocationTask(this));
+    }
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, false, false);
+  }
+
+  // Binary trees of object arrays, the last two of which stay live, which makes the collectors
+  // trace many references.
+  void ReferenceGraph(Thread* self) {
+    ScopedObjectAccess soa(self);
+    SirtRef<mirror::Class> object_array_class(self, GetObjectArrayClass(self));
+    SirtRef<mirror::ObjectArray<mirror::Object> > live(self,
+        mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class.get(), 2));
+    CHECK(live.get() != nullptr);
+    for (size_t i = 0; i < kTrees; ++i) {
+      mirror::ObjectArray<mirror::Object>* tree = BuildTree(self, object_array_class, kTreeDepth);
+      live->Set<false>(i % 2, tree);
+      SampleFootprint();
+    }
+  }
+
+  mirror::ObjectArray<mirror::Object>* BuildTree(Thread* self,
+                                                 const SirtRef<mirror::Class>& object_array_class,
+                                                 size_t depth)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    SirtRef<mirror::ObjectArray<mirror::Object> > node(self,
+        mirror::ObjectArray<mirror::Object>::Alloc(self, object_array_class.get(), 2));
+    CHECK(node.get() != nullptr);
+    if (depth > 0) {
+      // The allocations of the children may move the node.
+      mirror::ObjectArray<mirror::Object>* left = BuildTree(self, object_array_class, depth - 1);
+      node->Set<false>(0, left);
+      mirror::ObjectArray<mirror::Object>* right = BuildTree(self, object_array_class, depth - 1);
+      node->Set<false>(1, right);
+    }
+    return node.get();
+  }
+
+  mirror::Class* GetObjectArrayClass(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Class* object_array_class =
+        class_linker_->FindSystemClass(self, "[Ljava/lang/Object;");
+    CHECK(object_array_class != nullptr);
+    return object_array_class;
+  }
+
+ private:
+  static constexpr size_t kStormAllocations = 1 << 20;
+  static constexpr size_t kCacheSize = 32 * KB;
+  static constexpr size_t kCacheReplacements = 1 << 20;
+  static constexpr size_t kLargeArrayAllocations = 2 * KB;
+  static constexpr size_t kLiveArrays = 8;
+  static constexpr size_t kAllocationThreads = 4;
+  static constexpr size_t kTrees = 64;
+  static constexpr size_t kTreeDepth = 14;
+  static constexpr size_t kFootprintSampleInterval = 4 * KB;
+
+  const char* const collector_name_;
+  std::string gc_option_;
+  Atomic<size_t> peak_footprint_;
+};
+
+// Declares the fixture running the workloads with the collector named option, as for -Xgc.
+#define GC_BENCHMARKS(name, option) \
+  class GcBenchmark##name##Test : public GcBenchmarkTest { \
+   public: \
+    GcBenchmark##name##Test() : GcBenchmarkTest(option) {} \
+  }; \
+  TEST_F(GcBenchmark##name##Test, DISABLED_AllocationStorm) { \
+    RunWorkload("allocation_storm", &GcBenchmarkTest::AllocationStorm); \
+  } \
+  TEST_F(GcBenchmark##name##Test, DISABLED_LongLivedCache) { \
+    RunWorkload("long_lived_cache", &GcBenchmarkTest::LongLivedCache); \
+  } \
+  TEST_F(GcBenchmark##name##Test, DISABLED_LargeArrays) { \
+    RunWorkload("large_arrays", &GcBenchmarkTest::LargeArrays); \
+  } \
+  TEST_F(GcBenchmark##name##Test, DISABLED_MultiThreadedAllocation) { \
+    RunWorkload("multi_threaded_allocation", &GcBenchmarkTest::MultiThreadedAllocation); \
+  } \
+  TEST_F(GcBenchmark##name##Test, DISABLED_ReferenceGraph) { \
+    RunWorkload("reference_graph", &GcBenchmarkTest::ReferenceGraph); \
+  }
+
+GC_BENCHMARKS(MS, "MS")
+GC_BENCHMARKS(CMS, "CMS")
+GC_BENCHMARKS(SS, "SS")
+GC_BENCHMARKS(GSS, "GSS")
+GC_BENCHMARKS(CC, "CC")
+
+}  // namespace gc
+}  // namespace art
@@ -32,6 +32,7 @@ const char* PrettyCause(GcCause cause) {
     case kGcCauseCollectorTransition: return "CollectorTransition";
     case kGcCauseDisableMovingGc: return "DisableMovingGc";
     case kGcCauseTrim: return "HeapTrim";
+    case kGcCauseHomogeneousSpaceCompact: return "HomogeneousSpaceCompact";
     default:
       LOG(FATAL) << "Unreachable";
   }
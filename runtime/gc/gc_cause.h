@@ -39,6 +39,10 @@ enum GcCause {
   kGcCauseDisableMovingGc,
   // Not a real GC cause, used when we trim the heap.
   kGcCauseTrim,
+  // GC triggered for compacting the main space into the backup space.
+  kGcCauseHomogeneousSpaceCompact,
+  // Number of different GC causes.
+  kGcCauseMax,
 };
 
 const char* PrettyCause(GcCause cause);
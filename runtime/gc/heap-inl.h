@@ -20,6 +20,8 @@
 #include "heap.h"
 
 #include "debugger.h"
+#include "gc/allocation_sampler.h"
+#include "gc/allocation_site_table.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/collector/semi_space.h"
 #include "gc/space/bump_pointer_space-inl.h"
@@ -95,8 +97,13 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
   if (kIsDebugBuild && Runtime::Current()->IsStarted()) {
     CHECK_LE(obj->SizeOf(), usable_size);
   }
-  const size_t new_num_bytes_allocated =
-      static_cast<size_t>(num_bytes_allocated_.FetchAndAdd(bytes_allocated)) + bytes_allocated;
+  size_t new_num_bytes_allocated;
+  if (allocator == kAllocatorTypeTLAB) {
+    // The whole TLAB was counted when it was allocated.
+    new_num_bytes_allocated = static_cast<size_t>(num_bytes_allocated_.Load());
+  } else {
+    new_num_bytes_allocated = CountAllocatedBytes(self, bytes_allocated);
+  }
   // TODO: Deprecate.
   if (kInstrumented) {
     if (Runtime::Current()->HasStatsEnabled()) {
@@ -117,6 +124,9 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
     if (Dbg::IsAllocTrackingEnabled()) {
       Dbg::RecordAllocation(klass, bytes_allocated);
     }
+    if (UNLIKELY(allocation_sampler_.get() != nullptr)) {
+      allocation_sampler_->RecordAllocation(self, obj, bytes_allocated);
+    }
   } else {
     DCHECK(!Dbg::IsAllocTrackingEnabled());
   }
@@ -132,8 +142,27 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
   return obj;
 }
 
-// The size of a thread-local allocation stack in the number of references.
+// The size of the first thread-local allocation stack of a thread in the number of references.
 static constexpr size_t kThreadLocalAllocationStackSize = 128;
+// Bounds of the adaptive size of the thread-local allocation stacks.
+static constexpr size_t kMinThreadLocalAllocationStackSize = 32;
+static constexpr size_t kMaxThreadLocalAllocationStackSize = 1024;
+
+// Returns the size of the next thread-local allocation stack of self. A thread which fills its
+// stack gets one twice as big, up to kMaxThreadLocalAllocationStackSize, so that it bumps the
+// shared allocation stack less often. The size is halved again when a stack is revoked mostly
+// unused, see Heap::RevokeAllThreadLocalAllocationStacks.
+static inline size_t NextThreadLocalAllocationStackSize(Thread* self) {
+  size_t size = self->GetThreadLocalAllocationStackSizeHint();
+  if (size == 0) {
+    size = kThreadLocalAllocationStackSize;
+  } else if (self->HasThreadLocalAllocationStack()) {
+    // The thread filled its stack, as opposed to having it revoked by the GC.
+    size = std::min(size * 2, kMaxThreadLocalAllocationStackSize);
+  }
+  self->SetThreadLocalAllocationStackSizeHint(size);
+  return size;
+}
 
 inline void Heap::PushOnAllocationStack(Thread* self, mirror::Object** obj) {
   if (kUseThreadLocalAllocationStack) {
@@ -142,8 +171,8 @@ inline void Heap::PushOnAllocationStack(Thread* self, mirror::Object** obj) {
       // Slow path. Allocate a new thread-local allocation stack.
       mirror::Object** start_address;
       mirror::Object** end_address;
-      while (!allocation_stack_->AtomicBumpBack(kThreadLocalAllocationStackSize,
-                                                &start_address, &end_address)) {
+      const size_t stack_size = NextThreadLocalAllocationStackSize(self);
+      while (!allocation_stack_->AtomicBumpBack(stack_size, &start_address, &end_address)) {
         // Disable verify object in SirtRef as obj isn't on the alloc stack yet.
         SirtRefNoVerify<mirror::Object> ref(self, *obj);
         CollectGarbageInternal(collector::kGcTypeSticky, kGcCauseForAlloc, false);
@@ -232,9 +261,16 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, AllocatorType allocator
       if (UNLIKELY(self->TlabSize() < alloc_size)) {
         // Try allocating a new thread local buffer, if the allocaiton fails the space must be
         // full so return nullptr.
-        if (!bump_pointer_space_->AllocNewTlab(self, alloc_size + kDefaultTLABSize)) {
+        const size_t tlab_size = alloc_size + space::BumpPointerSpace::NextTlabSize(self);
+        // AllocNewTlab revokes the current TLAB whether it succeeds or not.
+        ReturnUnusedTlabBytes(self);
+        if (!bump_pointer_space_->AllocNewTlab(self, tlab_size)) {
           return nullptr;
         }
+        // Count the whole TLAB as allocated up front so that the quick entrypoints can allocate
+        // from it without updating the heap, the unused tail is taken back when it is revoked.
+        num_bytes_allocated_.FetchAndAdd(tlab_size);
+        self->AddAllocatedBytes(tlab_size);
       }
       // The allocation can't fail.
       ret = self->AllocTlab(alloc_size);
@@ -251,6 +287,17 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, AllocatorType allocator
   return ret;
 }
 
+inline size_t Heap::CountAllocatedBytes(Thread* self, size_t bytes_allocated) {
+  self->AddAllocatedBytes(bytes_allocated);
+  const size_t unflushed_bytes = self->GetUnflushedAllocatedBytes() + bytes_allocated;
+  if (LIKELY(unflushed_bytes < kMaxUnflushedAllocatedBytes)) {
+    self->SetUnflushedAllocatedBytes(unflushed_bytes);
+    return static_cast<size_t>(num_bytes_allocated_.Load()) + unflushed_bytes;
+  }
+  self->SetUnflushedAllocatedBytes(0);
+  return static_cast<size_t>(num_bytes_allocated_.FetchAndAdd(unflushed_bytes)) + unflushed_bytes;
+}
+
 inline Heap::AllocationTimer::AllocationTimer(Heap* heap, mirror::Object** allocated_obj_ptr)
     : heap_(heap), allocated_obj_ptr_(allocated_obj_ptr) {
   if (kMeasureAllocationTime) {
@@ -308,6 +355,24 @@ inline void Heap::CheckConcurrentGC(Thread* self, size_t new_num_bytes_allocated
   }
 }
 
+inline AllocatorType Heap::GetAllocatorForSite(mirror::ArtMethod* method, mirror::Class* klass,
+                                               AllocatorType allocator) {
+  if (allocation_site_table_.get() != nullptr &&
+      (allocator == kAllocatorTypeBumpPointer || allocator == kAllocatorTypeTLAB) &&
+      UNLIKELY(allocation_site_table_->ShouldPretenure(method, klass->GetDexTypeIndex()))) {
+    // Allocate where the generational semi-space collector would promote the object to.
+    return kUseRosAlloc ? kAllocatorTypeRosAlloc : kAllocatorTypeDlMalloc;
+  }
+  return allocator;
+}
+
+inline void Heap::RecordAllocationSite(mirror::ArtMethod* method, mirror::Object* obj) {
+  if (allocation_site_table_.get() != nullptr && obj != nullptr &&
+      bump_pointer_space_->HasAddress(obj)) {
+    allocation_site_table_->RecordAllocation(method, obj);
+  }
+}
+
 }  // namespace gc
 }  // namespace art
 
@@ -19,11 +19,13 @@
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <cutils/trace.h>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
 #include "base/histogram-inl.h"
 #include "base/stl_util.h"
+#include "base/unix_file/fd_file.h"
 #include "common_throws.h"
 #include "cutils/sched_policy.h"
 #include "debugger.h"
@@ -34,6 +36,8 @@
 #include "gc/accounting/mod_union_table-inl.h"
 #include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/allocation_sampler.h"
+#include "gc/allocation_site_table.h"
 #include "gc/collector/concurrent_copying.h"
 #include "gc/collector/mark_sweep-inl.h"
 #include "gc/collector/partial_mark_sweep.h"
@@ -44,12 +48,14 @@
 #include "gc/space/dlmalloc_space-inl.h"
 #include "gc/space/image_space.h"
 #include "gc/space/large_object_space.h"
+#include "gc/space/region_space.h"
 #include "gc/space/rosalloc_space-inl.h"
 #include "gc/space/space-inl.h"
 #include "gc/space/zygote_space.h"
 #include "entrypoints/quick/quick_alloc_entrypoints.h"
 #include "heap-inl.h"
 #include "image.h"
+#include "metrics_page.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object.h"
@@ -77,27 +83,61 @@ static constexpr bool kGCALotMode = false;
 static constexpr size_t kGcAlotInterval = KB;
 // Minimum amount of remaining bytes before a concurrent GC is triggered.
 static constexpr size_t kMinConcurrentRemainingBytes = 128 * KB;
-static constexpr size_t kMaxConcurrentRemainingBytes = 512 * KB;
+// Weight of the last measurement in the decaying means of the allocation rate and of the GC
+// duration, which forecast the bytes allocated during the next concurrent GC.
+static constexpr double kConcurrentStartForecastWeight = 0.25;
+// Margin on the forecast bytes allocated during the next concurrent GC.
+static constexpr double kConcurrentStartForecastMargin = 1.25;
 // Sticky GC throughput adjustment, divided by 4. Increasing this causes sticky GC to occur more
 // relative to partial/full GC. This may be desirable since sticky GCs interfere less with mutator
 // threads (lower pauses, use less memory bandwidth).
 static constexpr double kStickyGcThroughputAdjustment = 1.0;
+// Whether the next GC type is the one which frees the most bytes per ms of pause, rather than
+// the sticky GC throughput heuristic above.
+static constexpr bool kUseAdaptiveGcTypeSelection = true;
+// Weight of the last collection in the decaying mean of the bytes freed per ms of pause.
+static constexpr double kGcTypeEfficiencyWeight = 0.5;
+// Pauses are counted as at least this long, the concurrent collections can pause for next to
+// nothing but still cost the mutators (milliseconds).
+static constexpr double kMinGcTypeEfficiencyPauseMs = 0.5;
+// A GC type which has not run for this many collections is retried, the mean of a type which
+// is never chosen would otherwise never get updated.
+static constexpr size_t kGcTypeRetryInterval = 16;
 // Whether or not we use the free list large object space.
 static constexpr bool kUseFreeListSpaceForLOS = false;
+// Whether or not we use the chunked large object space, which does not map each large object.
+static constexpr bool kUseChunkedSpaceForLOS = true;
 // Whtehr or not we compact the zygote in PreZygoteFork.
 static constexpr bool kCompactZygote = kMovingCollector;
+// Whether or not we reserve a backup space to compact the main space into when it fragments.
+static constexpr bool kUseHomogeneousSpaceCompaction = kMovingCollector && kUseRosAlloc;
 static constexpr size_t kNonMovingSpaceCapacity = 64 * MB;
+// Whether or not the heap verification is split over the heap thread pool.
+static constexpr bool kParallelHeapVerification = true;
+// How many bitmap ranges each thread of the parallel heap verification gets on average.
+static constexpr size_t kHeapVerificationRangesPerThread = 4;
+// Whether or not the instance and referring object queries of the debuggers are split over the
+// heap thread pool.
+static constexpr bool kParallelHeapWalk = true;
+// Initial bucket width and bucket count of the GC cause histograms, in microseconds.
+static constexpr uint64_t kGcCauseBucketSize = 500;
+static constexpr size_t kGcCauseBucketCount = 32;
 
 Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max_free,
            double target_utilization, double foreground_heap_growth_multiplier, size_t capacity,
            const std::string& image_file_name, const InstructionSet image_instruction_set,
            CollectorType foreground_collector_type, CollectorType background_collector_type,
-           size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
+           size_t parallel_gc_threads, size_t conc_gc_threads, bool numa_aware_gc_threads,
+           bool native_allocation_pacing,
+           bool low_memory_mode,
            size_t long_pause_log_threshold, size_t long_gc_log_threshold,
+           size_t pause_time_target, double gc_time_percent_target,
            bool ignore_max_footprint, bool use_tlab,
+           size_t rosalloc_thread_local_brackets, size_t soft_ref_lru_policy_ms_per_mb,
            bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
            bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
-           bool verify_post_gc_rosalloc)
+           bool verify_post_gc_rosalloc, size_t heap_sample_interval,
+           const std::string& heap_sample_file)
     : non_moving_space_(nullptr),
       rosalloc_space_(nullptr),
       dlmalloc_space_(nullptr),
@@ -110,8 +150,17 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       last_trim_time_(0),
       heap_transition_target_time_(0),
       heap_trim_request_pending_(false),
+      heap_trim_slices_(0),
+      heap_trim_bytes_released_(0),
+      heap_trim_max_slice_bytes_(0),
+      homogeneous_space_compactions_(0),
+      last_homogeneous_space_compaction_time_(0),
+      allocation_stalls_(0),
+      total_allocation_stall_ns_(0),
+      allocation_stall_histogram_("Allocation stall", kGcCauseBucketSize, kGcCauseBucketCount),
       parallel_gc_threads_(parallel_gc_threads),
       conc_gc_threads_(conc_gc_threads),
+      numa_aware_gc_threads_(numa_aware_gc_threads),
       low_memory_mode_(low_memory_mode),
       long_pause_log_threshold_(long_pause_log_threshold),
       long_gc_log_threshold_(long_gc_log_threshold),
@@ -121,12 +170,19 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       collector_type_running_(kCollectorTypeNone),
       last_gc_type_(collector::kGcTypeNone),
       next_gc_type_(collector::kGcTypePartial),
+      gc_type_selections_(0),
       capacity_(capacity),
       growth_limit_(growth_limit),
       max_allowed_footprint_(initial_size),
       native_footprint_gc_watermark_(initial_size),
       native_footprint_limit_(2 * initial_size),
       native_need_to_run_finalization_(false),
+      native_allocation_pacing_(native_allocation_pacing),
+      native_pacing_next_gc_(initial_size),
+      native_pacing_step_(std::max(initial_size / kNativePacingSteps, kMinNativePacingStep)),
+      last_native_blocking_gc_time_ns_(0),
+      native_alloc_gc_count_(0),
+      native_alloc_blocking_gc_count_(0),
       // Initially assume we perceive jank in case the process state is never updated.
       process_state_(kProcessStateJankPerceptible),
       concurrent_start_bytes_(std::numeric_limits<size_t>::max()),
@@ -144,7 +200,11 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       verify_pre_gc_rosalloc_(verify_pre_gc_rosalloc),
       verify_pre_sweeping_rosalloc_(verify_pre_sweeping_rosalloc),
       verify_post_gc_rosalloc_(verify_post_gc_rosalloc),
+      allocation_sample_file_(heap_sample_file),
+      last_gc_time_ns_(NanoTime()),
       allocation_rate_(0),
+      mean_allocation_rate_(0.0),
+      mean_gc_duration_ns_(0.0),
       /* For GC a lot mode, we limit the allocations stacks to be kGcAlotInterval allocations. This
        * causes a lot of GC since we do a GC for alloc whenever the stack is full. When heap
        * verification is enabled, we limit the size of allocation stacks to speed up their
@@ -160,15 +220,38 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       max_free_(max_free),
       target_utilization_(target_utilization),
       foreground_heap_growth_multiplier_(foreground_heap_growth_multiplier),
+      pause_time_target_(pause_time_target),
+      gc_time_percent_target_(gc_time_percent_target),
+      gc_time_ratio_(0.0),
       total_wait_time_(0),
       total_allocation_time_(0),
       verify_object_mode_(kVerifyObjectModeDisabled),
       disable_moving_gc_count_(0),
       running_on_valgrind_(Runtime::Current()->RunningOnValgrind()),
-      use_tlab_(use_tlab) {
+      use_tlab_(use_tlab),
+      rosalloc_thread_local_brackets_(rosalloc_thread_local_brackets) {
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() entering";
   }
+  reference_processor_.SetSoftReferenceLruPolicy(soft_ref_lru_policy_ms_per_mb);
+  for (GcTypeEfficiency& efficiency : gc_type_efficiency_) {
+    efficiency.bytes_freed_per_pause_ms = 0.0;
+    efficiency.samples = 0;
+    efficiency.selections = 0;
+    efficiency.collections_since_run = 0;
+  }
+  if (!kUseBakerReadBarrier) {
+    // The concurrent copying collector relies on the read barrier to keep the mutators in the
+    // to-space.
+    if (foreground_collector_type_ == kCollectorTypeCC) {
+      LOG(WARNING) << "Concurrent copying requires read barriers, using semi-space instead";
+      foreground_collector_type_ = kCollectorTypeSS;
+      desired_collector_type_ = kCollectorTypeSS;
+    }
+    if (background_collector_type_ == kCollectorTypeCC) {
+      background_collector_type_ = kCollectorTypeSS;
+    }
+  }
   const bool is_zygote = Runtime::Current()->IsZygote();
   // If we aren't the zygote, switch to the default non zygote allocator. This may update the
   // entrypoints.
@@ -187,6 +270,7 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   // Requested begin for the alloc space, to follow the mapped image and oat files
   byte* requested_alloc_space_begin = nullptr;
   if (!image_file_name.empty()) {
+    Runtime::Current()->StartupSplit("ImageSpace::Create");
     space::ImageSpace* image_space = space::ImageSpace::Create(image_file_name.c_str(),
                                                                image_instruction_set);
     CHECK(image_space != nullptr) << "Failed to create space for " << image_file_name;
@@ -196,6 +280,7 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     byte* oat_file_end_addr = image_space->GetImageHeader().GetOatFileEnd();
     CHECK_GT(oat_file_end_addr, image_space->End());
     requested_alloc_space_begin = AlignUp(oat_file_end_addr, kPageSize);
+    Runtime::Current()->StartupSplit("Heap::Heap spaces");
   }
   if (is_zygote) {
     // Reserve the address range before we create the non moving space to make sure bitmaps don't
@@ -212,6 +297,16 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
         requested_alloc_space_begin, false);
     non_moving_space_->SetFootprintLimit(non_moving_space_->Capacity());
     CreateMainMallocSpace(mem_map, initial_size, growth_limit, capacity);
+    if (kUseHomogeneousSpaceCompaction) {
+      // Only reserved, the backup space takes no memory until the main space is compacted into it.
+      MemMap* backup_mem_map = MemMap::MapAnonymous("main space 1", nullptr, capacity,
+                                                    PROT_READ | PROT_WRITE, true, &error_str);
+      CHECK(backup_mem_map != nullptr) << error_str;
+      main_space_backup_.reset(CreateMallocSpaceFromMemMap(backup_mem_map, initial_size,
+                                                           growth_limit, capacity,
+                                                           "main rosalloc space 1", true));
+      CHECK(main_space_backup_.get() != nullptr) << "Failed to create backup main space";
+    }
   } else {
     std::string error_str;
     MemMap* mem_map = MemMap::MapAnonymous("main/non-moving space", requested_alloc_space_begin,
@@ -248,10 +343,17 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   if (main_space_ != nullptr) {
     AddSpace(main_space_);
   }
+  if (main_space_backup_.get() != nullptr) {
+    // Added until the card table is created so that the card table covers it.
+    AddSpace(main_space_backup_.get());
+  }
 
   // Allocate the large object space.
   if (kUseFreeListSpaceForLOS) {
     large_object_space_ = space::FreeListSpace::Create("large object space", nullptr, capacity);
+  } else if (kUseChunkedSpaceForLOS && !running_on_valgrind_) {
+    // Valgrind needs the red zones of ValgrindLargeObjectMapSpace.
+    large_object_space_ = space::ChunkedLargeObjectSpace::Create("large object space");
   } else {
     large_object_space_ = space::LargeObjectMapSpace::Create("large object space");
   }
@@ -269,6 +371,9 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   // Allocate the card table.
   card_table_.reset(accounting::CardTable::Create(heap_begin, heap_capacity));
   CHECK(card_table_.get() != NULL) << "Failed to create card table";
+  if (main_space_backup_.get() != nullptr) {
+    RemoveSpace(main_space_backup_.get());
+  }
 
   // Card cache for now since it makes it easier for us to update the references to the copying
   // spaces.
@@ -330,6 +435,9 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     semi_space_collector_ = new collector::SemiSpace(this, generational,
                                                      generational ? "generational" : "");
     garbage_collectors_.push_back(semi_space_collector_);
+    if (generational && kUseAllocationSitePretenuring) {
+      allocation_site_table_.reset(new AllocationSiteTable);
+    }
 
     concurrent_copying_collector_ = new collector::ConcurrentCopying(this);
     garbage_collectors_.push_back(concurrent_copying_collector_);
@@ -338,12 +446,40 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   if (running_on_valgrind_) {
     Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
   }
+  if (kQuickTlabAllocFastPath && use_tlab_ && allocation_site_table_.get() != nullptr) {
+    // The allocation sites are only sampled by the runtime, not by the TLAB fast paths.
+    Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
+  }
+  if (heap_sample_interval != 0) {
+    allocation_sampler_.reset(new AllocationSampler(heap_sample_interval));
+    // Only the instrumented allocation paths count the bytes allocated towards the next sample.
+    Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
+  }
 
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() exiting";
   }
 }
 
+space::MallocSpace* Heap::CreateMallocSpaceFromMemMap(MemMap* mem_map, size_t initial_size,
+                                                      size_t growth_limit, size_t capacity,
+                                                      const char* name, bool can_move_objects) {
+  space::MallocSpace* malloc_space = nullptr;
+  if (kUseRosAlloc) {
+    malloc_space = space::RosAllocSpace::CreateFromMemMap(
+        mem_map, name, kDefaultStartingSize, initial_size, growth_limit, capacity,
+        low_memory_mode_, can_move_objects, rosalloc_thread_local_brackets_);
+  } else {
+    malloc_space = space::DlMallocSpace::CreateFromMemMap(
+        mem_map, name, kDefaultStartingSize, initial_size, growth_limit, capacity,
+        can_move_objects);
+  }
+  if (malloc_space != nullptr) {
+    malloc_space->SetFootprintLimit(malloc_space->Capacity());
+  }
+  return malloc_space;
+}
+
 void Heap::CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t growth_limit,
                                  size_t capacity) {
   // Is background compaction is enabled?
@@ -358,20 +494,15 @@ void Heap::CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t gr
     // that getting primitive array elements is faster.
     can_move_objects = !have_zygote_space_;
   }
+  main_space_ = CreateMallocSpaceFromMemMap(mem_map, initial_size, growth_limit, capacity,
+                                            kUseRosAlloc ? "main rosalloc space" :
+                                                "main dlmalloc space", can_move_objects);
+  CHECK(main_space_ != nullptr) << "Failed to create main space";
   if (kUseRosAlloc) {
-    rosalloc_space_ = space::RosAllocSpace::CreateFromMemMap(
-        mem_map, "main rosalloc space", kDefaultStartingSize, initial_size, growth_limit, capacity,
-        low_memory_mode_, can_move_objects);
-    main_space_ = rosalloc_space_;
-    CHECK(main_space_ != nullptr) << "Failed to create rosalloc space";
+    rosalloc_space_ = main_space_->AsRosAllocSpace();
   } else {
-    dlmalloc_space_ = space::DlMallocSpace::CreateFromMemMap(
-        mem_map, "main dlmalloc space", kDefaultStartingSize, initial_size, growth_limit, capacity,
-        can_move_objects);
-    main_space_ = dlmalloc_space_;
-    CHECK(main_space_ != nullptr) << "Failed to create dlmalloc space";
+    dlmalloc_space_ = main_space_->AsDlMallocSpace();
   }
-  main_space_->SetFootprintLimit(main_space_->Capacity());
   VLOG(heap) << "Created main space " << main_space_;
 }
 
@@ -509,6 +640,26 @@ void Heap::DecrementDisableMovingGC(Thread* self) {
   --disable_moving_gc_count_;
 }
 
+void Heap::PinObject(Thread* self, mirror::Object* obj) {
+  DCHECK(IsMovableObject(obj)) << obj;
+  space::ContinuousSpace* space = FindContinuousSpaceFromObject(obj, false);
+  if (space->IsRegionSpace()) {
+    space->AsRegionSpace()->PinObject(obj);
+  } else {
+    IncrementDisableMovingGC(self);
+  }
+}
+
+void Heap::UnpinObject(Thread* self, mirror::Object* obj) {
+  DCHECK(IsMovableObject(obj)) << obj;
+  space::ContinuousSpace* space = FindContinuousSpaceFromObject(obj, false);
+  if (space->IsRegionSpace()) {
+    space->AsRegionSpace()->UnpinObject(obj);
+  } else {
+    DecrementDisableMovingGC(self);
+  }
+}
+
 void Heap::UpdateProcessState(ProcessState process_state) {
   if (process_state_ != process_state) {
     process_state_ = process_state;
@@ -533,7 +684,14 @@ void Heap::UpdateProcessState(ProcessState process_state) {
 void Heap::CreateThreadPool() {
   const size_t num_threads = std::max(parallel_gc_threads_, conc_gc_threads_);
   if (num_threads != 0) {
-    thread_pool_.reset(new ThreadPool("Heap thread pool", num_threads));
+    thread_pool_.reset(new ThreadPool("Heap thread pool", num_threads, numa_aware_gc_threads_));
+    if (kUseWorkStealingMarking) {
+      // The thread running the GC only waits for the work stealing workers, so add one more
+      // worker in its place.
+      work_stealing_thread_pool_.reset(
+          new WorkStealingThreadPool("Heap work stealing thread pool", num_threads + 1,
+                                     numa_aware_gc_threads_));
+    }
   }
 }
 
@@ -541,6 +699,12 @@ void Heap::VisitObjects(ObjectCallback callback, void* arg) {
   Thread* self = Thread::Current();
   // GCs can move objects, so don't allow this.
   const char* old_cause = self->StartAssertNoThreadSuspension("Visiting objects");
+  VisitObjectsOutsideLiveBitmap(callback, arg);
+  GetLiveBitmap()->Walk(callback, arg);
+  self->EndAssertNoThreadSuspension(old_cause);
+}
+
+void Heap::VisitObjectsOutsideLiveBitmap(ObjectCallback callback, void* arg) {
   if (bump_pointer_space_ != nullptr) {
     // Visit objects in bump pointer space.
     bump_pointer_space_->Walk(callback, arg);
@@ -556,8 +720,6 @@ void Heap::VisitObjects(ObjectCallback callback, void* arg) {
       callback(obj, arg);
     }
   }
-  GetLiveBitmap()->Walk(callback, arg);
-  self->EndAssertNoThreadSuspension(old_cause);
 }
 
 void Heap::MarkAllocStackAsLive(accounting::ObjectStack* stack) {
@@ -579,6 +741,7 @@ void Heap::MarkAllocStackAsLive(accounting::ObjectStack* stack) {
 
 void Heap::DeleteThreadPool() {
   thread_pool_.reset(nullptr);
+  work_stealing_thread_pool_.reset(nullptr);
 }
 
 void Heap::AddSpace(space::Space* space) {
@@ -668,6 +831,69 @@ void Heap::RegisterGCDeAllocation(size_t bytes) {
   }
 }
 
+Heap::GcCauseStats::GcCauseStats()
+    : collections(0),
+      total_duration_ns(0),
+      total_paused_ns(0),
+      duration_histogram("GC time", kGcCauseBucketSize, kGcCauseBucketCount),
+      pause_histogram("GC paused", kGcCauseBucketSize, kGcCauseBucketCount),
+      waits(0),
+      total_wait_ns(0) {
+}
+
+void Heap::RecordGcCause(GcCause cause, collector::GarbageCollector* collector) {
+  DCHECK_LT(cause, kGcCauseMax);
+  const uint64_t duration_ns = collector->GetDurationNs();
+  MutexLock mu(Thread::Current(), *gc_complete_lock_);
+  GcCauseStats& stats = gc_cause_stats_[cause];
+  ++stats.collections;
+  stats.total_duration_ns += duration_ns;
+  stats.duration_histogram.AddValue(duration_ns / 1000);
+  for (uint64_t pause : collector->GetPauseTimes()) {
+    stats.total_paused_ns += pause;
+    stats.pause_histogram.AddValue(pause / 1000);
+  }
+}
+
+void Heap::RecordAllocationStall(Thread* self, uint64_t stall_ns) {
+  self->AddAllocationStall(stall_ns);
+  MutexLock mu(self, *gc_complete_lock_);
+  ++allocation_stalls_;
+  total_allocation_stall_ns_ += stall_ns;
+  allocation_stall_histogram_.AddValue(stall_ns / 1000);
+}
+
+// The histograms hold microseconds.
+static uint64_t HistogramMaxNs(const Histogram<uint64_t>& histogram) {
+  return histogram.SampleSize() != 0 ? histogram.Max() * 1000 : 0;
+}
+
+void Heap::GetGcCauseStats(uint64_t* stats) {
+  MutexLock mu(Thread::Current(), *gc_complete_lock_);
+  for (size_t i = 0; i < kGcCauseMax; ++i) {
+    const GcCauseStats& cause_stats = gc_cause_stats_[i];
+    *stats++ = cause_stats.collections;
+    *stats++ = cause_stats.total_duration_ns;
+    *stats++ = cause_stats.total_paused_ns;
+    *stats++ = HistogramMaxNs(cause_stats.pause_histogram);
+    *stats++ = cause_stats.waits;
+    *stats++ = cause_stats.total_wait_ns;
+  }
+  *stats++ = allocation_stalls_;
+  *stats++ = total_allocation_stall_ns_;
+  *stats++ = HistogramMaxNs(allocation_stall_histogram_);
+}
+
+static void DumpConfidenceIntervals(std::ostream& os, const char* prefix,
+                                    const Histogram<uint64_t>& histogram) {
+  if (histogram.SampleSize() != 0) {
+    Histogram<uint64_t>::CumulativeData cumulative_data;
+    histogram.CreateHistogram(&cumulative_data);
+    os << prefix << " ";
+    histogram.PrintConfidenceIntervals(os, 0.99, cumulative_data);
+  }
+}
+
 void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   // Dump cumulative timings.
   os << "Dumping cumulative Gc timings\n";
@@ -694,6 +920,7 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
          << " objects with total size " << PrettySize(freed_bytes) << "\n"
          << collector->GetName() << " throughput: " << freed_objects / seconds << "/s / "
          << PrettySize(freed_bytes / seconds) << "/s\n";
+      collector->DumpPerformanceInfo(os);
       total_duration += total_ns;
       total_paused_time += total_pause_ns;
     }
@@ -717,8 +944,73 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
     os << "Mean allocation time: " << PrettyDuration(allocation_time / total_objects_allocated)
        << "\n";
   }
+  if (kUseAdaptiveGcTypeSelection && gc_type_selections_ != 0) {
+    for (size_t i = 0; i < collector::kGcTypeMax; ++i) {
+      const GcTypeEfficiency& efficiency = gc_type_efficiency_[i];
+      if (efficiency.samples != 0 || efficiency.selections != 0) {
+        const int64_t bytes_per_ms = static_cast<int64_t>(efficiency.bytes_freed_per_pause_ms);
+        os << static_cast<collector::GcType>(i) << " GC chosen " << efficiency.selections
+           << " times, freed " << PrettySize(bytes_per_ms) << " per ms of pause\n";
+      }
+    }
+    os << "Last GC type choices:";
+    const size_t num_choices = std::min(gc_type_selections_, kGcTypeSelectionHistorySize);
+    for (size_t i = gc_type_selections_ - num_choices; i < gc_type_selections_; ++i) {
+      os << " " << gc_type_selection_history_[i % kGcTypeSelectionHistorySize];
+    }
+    os << "\n";
+  }
+  os << "Native allocation GCs: " << GetNativeAllocGcCount() << " requested, "
+     << GetNativeAllocBlockingGcCount() << " blocking\n";
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
+  {
+    MutexLock mu(Thread::Current(), *gc_complete_lock_);
+    for (size_t i = 0; i < kGcCauseMax; ++i) {
+      const GcCauseStats& stats = gc_cause_stats_[i];
+      if (stats.collections == 0 && stats.waits == 0) {
+        continue;
+      }
+      const char* cause = PrettyCause(static_cast<GcCause>(i));
+      os << cause << " GCs: " << stats.collections
+         << " total time: " << PrettyDuration(stats.total_duration_ns)
+         << " paused: " << PrettyDuration(stats.total_paused_ns)
+         << " waits: " << stats.waits
+         << " wait time: " << PrettyDuration(stats.total_wait_ns) << "\n";
+      DumpConfidenceIntervals(os, cause, stats.duration_histogram);
+      DumpConfidenceIntervals(os, cause, stats.pause_histogram);
+    }
+    if (allocation_stalls_ != 0) {
+      os << "Allocation stalls: " << allocation_stalls_
+         << " total time: " << PrettyDuration(total_allocation_stall_ns_) << "\n";
+      Histogram<uint64_t>::CumulativeData cumulative_data;
+      allocation_stall_histogram_.CreateHistogram(&cumulative_data);
+      allocation_stall_histogram_.PrintConfidenceIntervals(os, 0.99, cumulative_data);
+    }
+    if (homogeneous_space_compactions_ != 0) {
+      os << "Homogeneous space compactions: " << homogeneous_space_compactions_ << "\n";
+    }
+  }
+  {
+    MutexLock mu(Thread::Current(), *heap_trim_request_lock_);
+    if (heap_trim_slices_ != 0) {
+      os << "Heap trim slices: " << heap_trim_slices_ << " released "
+         << PrettySize(heap_trim_bytes_released_) << " mean per slice "
+         << PrettySize(heap_trim_bytes_released_ / heap_trim_slices_) << " max per slice "
+         << PrettySize(heap_trim_max_slice_bytes_) << "\n";
+    }
+  }
+  if (thread_pool_.get() != nullptr && thread_pool_->IsNumaAware()) {
+    os << "Heap thread pool tasks run on another NUMA node: "
+       << thread_pool_->GetCrossNodeTaskCount(Thread::Current()) << "\n";
+  }
+  if (work_stealing_thread_pool_.get() != nullptr) {
+    uint64_t steals;
+    uint64_t cross_node_steals;
+    work_stealing_thread_pool_->GetStealCounts(Thread::Current(), &steals, &cross_node_steals);
+    os << "Work stealing steals: " << steals << " from another NUMA node: " << cross_node_steals
+       << "\n";
+  }
   os << "Approximate GC data structures memory overhead: " << gc_memory_overhead_;
   BaseMutex::DumpAll(os);
 }
@@ -740,10 +1032,15 @@ Heap::~Heap() {
 
 space::ContinuousSpace* Heap::FindContinuousSpaceFromObject(const mirror::Object* obj,
                                                             bool fail_ok) const {
-  for (const auto& space : continuous_spaces_) {
-    if (space->Contains(obj)) {
-      return space;
-    }
+  // The spaces are sorted by begin and don't overlap, only the last one beginning at or before
+  // obj may contain it.
+  const byte* byte_obj = reinterpret_cast<const byte*>(obj);
+  auto it = std::upper_bound(continuous_spaces_.begin(), continuous_spaces_.end(), byte_obj,
+                             [](const byte* addr, const space::ContinuousSpace* space) {
+    return addr < space->Begin();
+  });
+  if (it != continuous_spaces_.begin() && (*--it)->Contains(obj)) {
+    return *it;
   }
   if (!fail_ok) {
     LOG(FATAL) << "object " << reinterpret_cast<const void*>(obj) << " not inside any spaces!";
@@ -844,6 +1141,10 @@ void Heap::DoPendingTransitionOrTrim() {
     runtime->GetThreadList()->SuspendAll();
     runtime->GetMonitorList()->DeflateMonitors();
     runtime->GetThreadList()->ResumeAll();
+    // Compacting the main space also lets the trim release more of it.
+    if (IsMainSpaceFragmented()) {
+      PerformHomogeneousSpaceCompact();
+    }
     // Do a heap trim if it is needed.
     Trim();
   }
@@ -859,29 +1160,66 @@ void Heap::Trim() {
     last_trim_time_ = NanoTime();
     heap_trim_request_pending_ = false;
   }
-  {
-    // Need to do this before acquiring the locks since we don't want to get suspended while
-    // holding any locks.
-    ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
-    // Pretend we are doing a GC to prevent background compaction from deleting the space we are
-    // trimming.
-    MutexLock mu(self, *gc_complete_lock_);
-    // Ensure there is only one GC at a time.
-    WaitForGcToCompleteLocked(kGcCauseTrim, self);
-    collector_type_running_ = kCollectorTypeHeapTrim;
-  }
   uint64_t start_ns = NanoTime();
   // Trim the managed spaces.
   uint64_t total_alloc_space_allocated = 0;
   uint64_t total_alloc_space_size = 0;
   uint64_t managed_reclaimed = 0;
-  for (const auto& space : continuous_spaces_) {
-    if (space->IsMallocSpace()) {
-      gc::space::MallocSpace* alloc_space = space->AsMallocSpace();
-      total_alloc_space_size += alloc_space->Size();
-      managed_reclaimed += alloc_space->Trim();
+  // The spaces which are done with this trim, the other ones are resumed by the next slice.
+  std::vector<space::MallocSpace*> trimmed_spaces;
+  bool finished = false;
+  for (size_t slice = 0; !finished; ++slice) {
+    if (slice != 0) {
+      // Let the mutators allocate and collect between two slices.
+      ScopedThreadStateChange tsc(self, kSleeping);
+      usleep(kHeapTrimSliceInterval / 1000);  // Usleep takes microseconds.
+    }
+    {
+      // Need to do this before acquiring the locks since we don't want to get suspended while
+      // holding any locks.
+      ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+      // Pretend we are doing a GC to prevent background compaction from deleting the space we
+      // are trimming.
+      MutexLock mu(self, *gc_complete_lock_);
+      // Ensure there is only one GC at a time.
+      WaitForGcToCompleteLocked(kGcCauseTrim, self);
+      collector_type_running_ = kCollectorTypeHeapTrim;
+    }
+    const uint64_t deadline_ns = kUseIncrementalHeapTrim ?
+        NanoTime() + kHeapTrimSliceDuration : std::numeric_limits<uint64_t>::max();
+    uint64_t slice_reclaimed = 0;
+    finished = true;
+    total_alloc_space_size = 0;
+    for (const auto& space : continuous_spaces_) {
+      if (space->IsMallocSpace()) {
+        gc::space::MallocSpace* alloc_space = space->AsMallocSpace();
+        total_alloc_space_size += alloc_space->Size();
+        if (std::find(trimmed_spaces.begin(), trimmed_spaces.end(), alloc_space) !=
+            trimmed_spaces.end()) {
+          continue;
+        }
+        bool space_finished;
+        slice_reclaimed += alloc_space->TrimSlice(deadline_ns, &space_finished);
+        if (space_finished) {
+          trimmed_spaces.push_back(alloc_space);
+        } else {
+          finished = false;
+        }
+      }
     }
+    // We never move things in the native heap, so we can finish the GC at this point.
+    FinishGC(self, collector::kGcTypeNone);
+    managed_reclaimed += slice_reclaimed;
+    {
+      MutexLock mu(self, *heap_trim_request_lock_);
+      ++heap_trim_slices_;
+      heap_trim_bytes_released_ += slice_reclaimed;
+      heap_trim_max_slice_bytes_ = std::max(heap_trim_max_slice_bytes_, slice_reclaimed);
+    }
+    VLOG(heap) << "Heap trim slice " << slice << " advised " << PrettySize(slice_reclaimed);
   }
+  // The large object space is never deleted, it does not need the pretend GC.
+  managed_reclaimed += large_object_space_->Trim();
   total_alloc_space_allocated = GetBytesAllocated() - large_object_space_->GetBytesAllocated();
   if (bump_pointer_space_ != nullptr) {
     total_alloc_space_allocated -= bump_pointer_space_->Size();
@@ -889,8 +1227,6 @@ void Heap::Trim() {
   const float managed_utilization = static_cast<float>(total_alloc_space_allocated) /
       static_cast<float>(total_alloc_space_size);
   uint64_t gc_heap_end_ns = NanoTime();
-  // We never move things in the native heap, so we can finish the GC at this point.
-  FinishGC(self, collector::kGcTypeNone);
   // Trim the native heap.
   dlmalloc_trim(0);
   size_t native_reclaimed = 0;
@@ -903,6 +1239,16 @@ void Heap::Trim() {
       << "%.";
 }
 
+uint64_t Heap::GetHeapTrimSlices() {
+  MutexLock mu(Thread::Current(), *heap_trim_request_lock_);
+  return heap_trim_slices_;
+}
+
+uint64_t Heap::GetHeapTrimBytesReleased() {
+  MutexLock mu(Thread::Current(), *heap_trim_request_lock_);
+  return heap_trim_bytes_released_;
+}
+
 bool Heap::IsValidObjectAddress(const mirror::Object* obj) const {
   // Note: we deliberately don't take the lock here, and mustn't test anything that would require
   // taking the lock.
@@ -1066,10 +1412,34 @@ void Heap::RecordFree(uint64_t freed_objects, int64_t freed_bytes) {
   }
 }
 
+// Adds the time an allocation waits for the GC, or runs one, to the allocation statistics.
+class ScopedGcForAllocTime {
+ public:
+  explicit ScopedGcForAllocTime(Thread* self) : self_(self), start_time_ns_(NanoTime()) {
+  }
+
+  ~ScopedGcForAllocTime() {
+    Runtime* runtime = Runtime::Current();
+    uint64_t duration_ns = NanoTime() - start_time_ns_;
+    runtime->GetHeap()->RecordAllocationStall(self_, duration_ns);
+    if (runtime->HasStatsEnabled()) {
+      runtime->GetStats()->gc_for_alloc_time_ns += duration_ns;
+      self_->GetStats()->gc_for_alloc_time_ns += duration_ns;
+    }
+  }
+
+ private:
+  Thread* const self_;
+  const uint64_t start_time_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedGcForAllocTime);
+};
+
 mirror::Object* Heap::AllocateInternalWithGc(Thread* self, AllocatorType allocator,
                                              size_t alloc_size, size_t* bytes_allocated,
                                              size_t* usable_size,
                                              mirror::Class** klass) {
+  ScopedGcForAllocTime gc_for_alloc_time(self);
   mirror::Object* ptr = nullptr;
   bool was_default_allocator = allocator == GetCurrentAllocator();
   DCHECK(klass != nullptr);
@@ -1142,6 +1512,20 @@ mirror::Object* Heap::AllocateInternalWithGc(Thread* self, AllocatorType allocat
       return nullptr;
     }
     ptr = TryToAllocate<true, true>(self, allocator, alloc_size, bytes_allocated, usable_size);
+    if (ptr == nullptr && allocator == kAllocatorTypeRosAlloc && IsMainSpaceFragmented()) {
+      bool compact;
+      {
+        MutexLock mu(self, *gc_complete_lock_);
+        compact = last_homogeneous_space_compaction_time_ == 0 ||
+            NanoTime() - last_homogeneous_space_compaction_time_ >=
+                kMinHomogeneousSpaceCompactIntervalForOom;
+      }
+      // The free bytes may be enough but too scattered, compact them before giving up.
+      if (compact && PerformHomogeneousSpaceCompact() == kHomogeneousSpaceCompactSuccess) {
+        ptr = TryToAllocate<true, true>(self, allocator, alloc_size, bytes_allocated,
+                                        usable_size);
+      }
+    }
     if (ptr == nullptr) {
       ThrowOutOfMemoryError(self, alloc_size, false);
     }
@@ -1172,33 +1556,69 @@ size_t Heap::GetBytesAllocatedEver() const {
   return GetBytesFreedEver() + GetBytesAllocated();
 }
 
+bool Heap::TryStartParallelHeapWalk(Thread* self) {
+  if (!kParallelHeapWalk || GetThreadPool() == nullptr || parallel_gc_threads_ == 0) {
+    return false;
+  }
+  // Pretend we are doing a GC so that no collection uses the thread pool meanwhile. Waiting for a
+  // running collection would suspend the caller, which may move the objects of the query.
+  MutexLock mu(self, *gc_complete_lock_);
+  if (collector_type_running_ != kCollectorTypeNone) {
+    return false;
+  }
+  collector_type_running_ = kCollectorTypeHeapWalk;
+  return true;
+}
+
+// Appends the objects to out, up to max_count objects in out if max_count isn't 0.
+static void AppendObjects(const std::vector<mirror::Object*>& objects, uint32_t max_count,
+                          std::vector<mirror::Object*>& out) {
+  for (mirror::Object* obj : objects) {
+    if (max_count != 0 && out.size() >= max_count) {
+      break;
+    }
+    out.push_back(obj);
+  }
+}
+
 class InstanceCounter {
  public:
-  InstanceCounter(const std::vector<mirror::Class*>& classes, bool use_is_assignable_from, uint64_t* counts)
+  InstanceCounter(const std::vector<mirror::Class*>& classes, bool use_is_assignable_from)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      : classes_(classes), use_is_assignable_from_(use_is_assignable_from), counts_(counts) {
+      : classes_(&classes), use_is_assignable_from_(use_is_assignable_from),
+        counts_(classes.size(), 0) {
   }
+
   static void Callback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
-    InstanceCounter* instance_counter = reinterpret_cast<InstanceCounter*>(arg);
+    reinterpret_cast<InstanceCounter*>(arg)->operator()(obj);
+  }
+
+  // For bitmap Visit.
+  void operator()(mirror::Object* obj) const NO_THREAD_SAFETY_ANALYSIS {
     mirror::Class* instance_class = obj->GetClass();
     CHECK(instance_class != nullptr);
-    for (size_t i = 0; i < instance_counter->classes_.size(); ++i) {
-      if (instance_counter->use_is_assignable_from_) {
-        if (instance_counter->classes_[i]->IsAssignableFrom(instance_class)) {
-          ++instance_counter->counts_[i];
+    for (size_t i = 0; i < classes_->size(); ++i) {
+      if (use_is_assignable_from_) {
+        if ((*classes_)[i]->IsAssignableFrom(instance_class)) {
+          ++counts_[i];
         }
-      } else if (instance_class == instance_counter->classes_[i]) {
-        ++instance_counter->counts_[i];
+      } else if (instance_class == (*classes_)[i]) {
+        ++counts_[i];
       }
     }
   }
 
+  void AddCounts(uint64_t* counts) const {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      counts[i] += counts_[i];
+    }
+  }
+
  private:
-  const std::vector<mirror::Class*>& classes_;
+  const std::vector<mirror::Class*>* classes_;
   bool use_is_assignable_from_;
-  uint64_t* const counts_;
-  DISALLOW_COPY_AND_ASSIGN(InstanceCounter);
+  mutable std::vector<uint64_t> counts_;
 };
 
 void Heap::CountInstances(const std::vector<mirror::Class*>& classes, bool use_is_assignable_from,
@@ -1206,36 +1626,76 @@ void Heap::CountInstances(const std::vector<mirror::Class*>& classes, bool use_i
   // Can't do any GC in this function since this may move classes.
   Thread* self = Thread::Current();
   auto* old_cause = self->StartAssertNoThreadSuspension("CountInstances");
-  InstanceCounter counter(classes, use_is_assignable_from, counts);
+  const bool parallel = TryStartParallelHeapWalk(self);
+  {
+    InstanceCounter counter(classes, use_is_assignable_from);
+    std::vector<InstanceCounter> range_counters;
+    WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    VisitObjectsOutsideLiveBitmap(InstanceCounter::Callback, &counter);
+    counter.AddCounts(counts);
+    VisitLiveBitmapRanges(InstanceCounter(classes, use_is_assignable_from), parallel,
+                          &range_counters);
+    for (const InstanceCounter& range_counter : range_counters) {
+      range_counter.AddCounts(counts);
+    }
+  }
+  if (parallel) {
+    FinishGC(self, collector::kGcTypeNone);
+  }
+  self->EndAssertNoThreadSuspension(old_cause);
+}
+
+static void PendingFinalizerCounterCallback(mirror::Object* obj, void* arg)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+  mirror::Class* klass = obj->GetClass();
+  if (klass != nullptr && klass->IsFinalizerReferenceClass() &&
+      obj->AsFinalizerReference()->GetZombie() != nullptr) {
+    ++*reinterpret_cast<uint64_t*>(arg);
+  }
+}
+
+uint64_t Heap::CountPendingFinalizers() {
+  // Can't do any GC in this function since finalizer references would be enqueued meanwhile.
+  Thread* self = Thread::Current();
+  auto* old_cause = self->StartAssertNoThreadSuspension("CountPendingFinalizers");
+  uint64_t count = 0;
   WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  VisitObjects(InstanceCounter::Callback, &counter);
+  VisitObjects(PendingFinalizerCounterCallback, &count);
   self->EndAssertNoThreadSuspension(old_cause);
+  return count;
 }
 
 class InstanceCollector {
  public:
-  InstanceCollector(mirror::Class* c, int32_t max_count, std::vector<mirror::Object*>& instances)
+  InstanceCollector(mirror::Class* c, int32_t max_count)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      : class_(c), max_count_(max_count), instances_(instances) {
+      : class_(c), max_count_(max_count) {
   }
+
   static void Callback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
     DCHECK(arg != nullptr);
-    InstanceCollector* instance_collector = reinterpret_cast<InstanceCollector*>(arg);
+    reinterpret_cast<InstanceCollector*>(arg)->operator()(obj);
+  }
+
+  // For bitmap Visit.
+  void operator()(mirror::Object* obj) const NO_THREAD_SAFETY_ANALYSIS {
     mirror::Class* instance_class = obj->GetClass();
-    if (instance_class == instance_collector->class_) {
-      if (instance_collector->max_count_ == 0 ||
-          instance_collector->instances_.size() < instance_collector->max_count_) {
-        instance_collector->instances_.push_back(obj);
+    if (instance_class == class_) {
+      if (max_count_ == 0 || instances_.size() < max_count_) {
+        instances_.push_back(obj);
       }
     }
   }
 
+  const std::vector<mirror::Object*>& GetInstances() const {
+    return instances_;
+  }
+
  private:
   mirror::Class* class_;
   uint32_t max_count_;
-  std::vector<mirror::Object*>& instances_;
-  DISALLOW_COPY_AND_ASSIGN(InstanceCollector);
+  mutable std::vector<mirror::Object*> instances_;
 };
 
 void Heap::GetInstances(mirror::Class* c, int32_t max_count,
@@ -1243,18 +1703,30 @@ void Heap::GetInstances(mirror::Class* c, int32_t max_count,
   // Can't do any GC in this function since this may move classes.
   Thread* self = Thread::Current();
   auto* old_cause = self->StartAssertNoThreadSuspension("GetInstances");
-  InstanceCollector collector(c, max_count, instances);
-  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  VisitObjects(&InstanceCollector::Callback, &collector);
+  const bool parallel = TryStartParallelHeapWalk(self);
+  {
+    InstanceCollector collector(c, max_count);
+    std::vector<InstanceCollector> range_collectors;
+    WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    VisitObjectsOutsideLiveBitmap(&InstanceCollector::Callback, &collector);
+    AppendObjects(collector.GetInstances(), max_count, instances);
+    VisitLiveBitmapRanges(InstanceCollector(c, max_count), parallel, &range_collectors);
+    // The ranges are in address order, the instances are those of a serial walk.
+    for (const InstanceCollector& range_collector : range_collectors) {
+      AppendObjects(range_collector.GetInstances(), max_count, instances);
+    }
+  }
+  if (parallel) {
+    FinishGC(self, collector::kGcTypeNone);
+  }
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
 class ReferringObjectsFinder {
  public:
-  ReferringObjectsFinder(mirror::Object* object, int32_t max_count,
-                         std::vector<mirror::Object*>& referring_objects)
+  ReferringObjectsFinder(mirror::Object* object, int32_t max_count)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      : object_(object), max_count_(max_count), referring_objects_(referring_objects) {
+      : object_(object), max_count_(max_count) {
   }
 
   static void Callback(mirror::Object* obj, void* arg)
@@ -1278,11 +1750,14 @@ class ReferringObjectsFinder {
     }
   }
 
+  const std::vector<mirror::Object*>& GetReferringObjects() const {
+    return referring_objects_;
+  }
+
  private:
   mirror::Object* object_;
   uint32_t max_count_;
-  std::vector<mirror::Object*>& referring_objects_;
-  DISALLOW_COPY_AND_ASSIGN(ReferringObjectsFinder);
+  mutable std::vector<mirror::Object*> referring_objects_;
 };
 
 void Heap::GetReferringObjects(mirror::Object* o, int32_t max_count,
@@ -1290,9 +1765,21 @@ void Heap::GetReferringObjects(mirror::Object* o, int32_t max_count,
   // Can't do any GC in this function since this may move the object o.
   Thread* self = Thread::Current();
   auto* old_cause = self->StartAssertNoThreadSuspension("GetReferringObjects");
-  ReferringObjectsFinder finder(o, max_count, referring_objects);
-  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  VisitObjects(&ReferringObjectsFinder::Callback, &finder);
+  const bool parallel = TryStartParallelHeapWalk(self);
+  {
+    ReferringObjectsFinder finder(o, max_count);
+    std::vector<ReferringObjectsFinder> range_finders;
+    WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    VisitObjectsOutsideLiveBitmap(&ReferringObjectsFinder::Callback, &finder);
+    AppendObjects(finder.GetReferringObjects(), max_count, referring_objects);
+    VisitLiveBitmapRanges(ReferringObjectsFinder(o, max_count), parallel, &range_finders);
+    for (const ReferringObjectsFinder& range_finder : range_finders) {
+      AppendObjects(range_finder.GetReferringObjects(), max_count, referring_objects);
+    }
+  }
+  if (parallel) {
+    FinishGC(self, collector::kGcTypeNone);
+  }
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
@@ -1302,6 +1789,92 @@ void Heap::CollectGarbage(bool clear_soft_references) {
   CollectGarbageInternal(gc_plan_.back(), kGcCauseExplicit, clear_soft_references);
 }
 
+bool Heap::IsMainSpaceFragmented() {
+  if (main_space_backup_.get() == nullptr || !main_space_->IsRosAllocSpace()) {
+    return false;
+  }
+  const size_t capacity = main_space_->Capacity();
+  const size_t bytes_allocated = main_space_->GetBytesAllocated();
+  if (bytes_allocated + kMinFragmentedFreeBytes > capacity) {
+    return false;
+  }
+  const size_t free_bytes = capacity - bytes_allocated;
+  const size_t largest_free_run =
+      main_space_->AsRosAllocSpace()->GetRosAlloc()->LargestFreePageRunBytes();
+  return largest_free_run < free_bytes * kHomogeneousSpaceCompactFragmentation;
+}
+
+Heap::HomogeneousSpaceCompactResult Heap::PerformHomogeneousSpaceCompact() {
+  Thread* self = Thread::Current();
+  ScopedThreadStateChange tsc(self, kWaitingPerformingGc);
+  Locks::mutator_lock_->AssertNotHeld(self);
+  {
+    ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+    MutexLock mu(self, *gc_complete_lock_);
+    // Ensure there is only one GC at a time.
+    WaitForGcToCompleteLocked(kGcCauseHomogeneousSpaceCompact, self);
+    if (main_space_backup_.get() == nullptr || !main_space_->CanMoveObjects()) {
+      return kHomogeneousSpaceCompactErrorUnsupported;
+    }
+    // GC can be disabled if someone has a used GetPrimitiveArrayCritical, and a moving collector
+    // has no main space to compact.
+    if (disable_moving_gc_count_ != 0 || IsMovingGc(collector_type_)) {
+      return kHomogeneousSpaceCompactErrorReject;
+    }
+    collector_type_running_ = kCollectorTypeHomogeneousSpaceCompact;
+  }
+  if (Runtime::Current()->IsShuttingDown(self)) {
+    // Don't allow heap compaction to happen if the runtime is shutting down since it can cause
+    // objects to get finalized.
+    FinishGC(self, collector::kGcTypeNone);
+    return kHomogeneousSpaceCompactErrorShuttingDown;
+  }
+  uint64_t start_time = NanoTime();
+  ThreadList* tl = Runtime::Current()->GetThreadList();
+  tl->SuspendAll();
+  space::MallocSpace* to_space = main_space_backup_.release();
+  space::MallocSpace* from_space = main_space_;
+  to_space->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
+  AddSpace(to_space);
+  const size_t from_space_size = from_space->GetBytesAllocated();
+  // The semi-space collector clears the from space once the live objects are copied out of it.
+  Compact(to_space, from_space, kGcCauseHomogeneousSpaceCompact);
+  RemoveSpace(from_space);
+  if (collector::SemiSpace::kUseRememberedSet) {
+    accounting::RememberedSet* from_space_rem_set = FindRememberedSetFromSpace(from_space);
+    if (from_space_rem_set != nullptr) {
+      RemoveRememberedSet(from_space);
+      delete from_space_rem_set;
+      accounting::RememberedSet* to_space_rem_set =
+          new accounting::RememberedSet("Main space remembered set", this, to_space);
+      CHECK(to_space_rem_set != nullptr) << "Failed to create main space remembered set";
+      AddRememberedSet(to_space_rem_set);
+    }
+  }
+  main_space_ = to_space;
+  if (kUseRosAlloc) {
+    rosalloc_space_ = to_space->AsRosAllocSpace();
+  } else {
+    dlmalloc_space_ = to_space->AsDlMallocSpace();
+  }
+  main_space_backup_.reset(from_space);
+  const size_t to_space_size = to_space->GetBytesAllocated();
+  tl->ResumeAll();
+  // Can't call into java code with all threads suspended.
+  reference_processor_.EnqueueClearedReferences();
+  uint64_t duration = NanoTime() - start_time;
+  GrowForUtilization(semi_space_collector_);
+  FinishGC(self, collector::kGcTypeFull);
+  {
+    MutexLock mu(self, *gc_complete_lock_);
+    ++homogeneous_space_compactions_;
+    last_homogeneous_space_compaction_time_ = NanoTime();
+  }
+  LOG(INFO) << "Heap homogeneous space compaction took " << PrettyDuration(duration) << " size: "
+      << PrettySize(from_space_size) << " -> " << PrettySize(to_space_size);
+  return kHomogeneousSpaceCompactSuccess;
+}
+
 void Heap::TransitionCollector(CollectorType collector_type) {
   if (collector_type == collector_type_) {
     return;
@@ -1354,7 +1927,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         // We are transitioning from non moving GC -> moving GC, since we copied from the bump
         // pointer space last transition it will be protected.
         bump_pointer_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
-        Compact(bump_pointer_space_, main_space_);
+        Compact(bump_pointer_space_, main_space_, kGcCauseCollectorTransition);
         // Remove the main space so that we don't try to trim it, this doens't work for debug
         // builds since RosAlloc attempts to read the magic number from a protected page.
         // TODO: Clean this up by getting rid of the remove_as_default parameter.
@@ -1369,7 +1942,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         // Compact to the main space from the bump pointer space, don't need to swap semispaces.
         AddSpace(main_space_);
         main_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
-        Compact(main_space_, bump_pointer_space_);
+        Compact(main_space_, bump_pointer_space_, kGcCauseCollectorTransition);
       }
       break;
     }
@@ -1398,7 +1971,12 @@ void Heap::ChangeCollector(CollectorType collector_type) {
     collector_type_ = collector_type;
     gc_plan_.clear();
     switch (collector_type_) {
-      case kCollectorTypeCC:  // Fall-through.
+      case kCollectorTypeCC: {
+        gc_plan_.push_back(collector::kGcTypeFull);
+        // The collector copies into TLABs of the to-space while the mutators allocate into theirs.
+        ChangeAllocator(kAllocatorTypeTLAB);
+        break;
+      }
       case kCollectorTypeSS:  // Fall-through.
       case kCollectorTypeGSS: {
         gc_plan_.push_back(collector::kGcTypeFull);
@@ -1552,6 +2130,7 @@ void Heap::PreZygoteFork() {
   MutexLock mu(self, zygote_creation_lock_);
   // Try to see if we have any Zygote spaces.
   if (have_zygote_space_) {
+    CleanZygoteSpaceCards();
     return;
   }
   VLOG(heap) << "Starting PreZygoteFork";
@@ -1640,6 +2219,7 @@ void Heap::PreZygoteFork() {
       new accounting::ModUnionTableCardCache("zygote space mod-union table", this, zygote_space);
   CHECK(mod_union_table != nullptr) << "Failed to create zygote space mod-union table";
   AddModUnionTable(mod_union_table);
+  CleanZygoteSpaceCards();
   if (collector::SemiSpace::kUseRememberedSet) {
     // Add a new remembered set for the post-zygote non-moving space.
     accounting::RememberedSet* post_zygote_non_moving_space_rem_set =
@@ -1651,6 +2231,26 @@ void Heap::PreZygoteFork() {
   }
 }
 
+space::ZygoteSpace* Heap::FindZygoteSpace() const {
+  for (const auto& space : continuous_spaces_) {
+    if (space->IsZygoteSpace()) {
+      return space->AsZygoteSpace();
+    }
+  }
+  return nullptr;
+}
+
+void Heap::CleanZygoteSpaceCards() {
+  space::ZygoteSpace* zygote_space = FindZygoteSpace();
+  accounting::ModUnionTable* mod_union_table = FindModUnionTableFromSpace(zygote_space);
+  CHECK(mod_union_table != nullptr);
+  // The first pass records the dirty cards and ages them, the second one clears the aged cards.
+  // The mod-union table keeps the cards it recorded, so the zygote space references are still
+  // scanned by every GC.
+  mod_union_table->ClearCards();
+  mod_union_table->ClearCards();
+}
+
 void Heap::FlushAllocStack() {
   MarkAllocStackAsLive(allocation_stack_.get());
   allocation_stack_->Reset();
@@ -1684,7 +2284,7 @@ void Heap::SwapSemiSpaces() {
 }
 
 void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
-                   space::ContinuousMemMapAllocSpace* source_space) {
+                   space::ContinuousMemMapAllocSpace* source_space, GcCause gc_cause) {
   CHECK(kMovingCollector);
   CHECK_NE(target_space, source_space) << "In-place compaction currently unsupported";
   if (target_space != source_space) {
@@ -1692,7 +2292,8 @@ void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
     semi_space_collector_->SetSwapSemiSpaces(false);
     semi_space_collector_->SetFromSpace(source_space);
     semi_space_collector_->SetToSpace(target_space);
-    semi_space_collector_->Run(kGcCauseCollectorTransition, false);
+    semi_space_collector_->Run(gc_cause, false);
+    RecordGcCause(gc_cause, semi_space_collector_);
   }
 }
 
@@ -1745,6 +2346,8 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
   // Back to back GCs can cause 0 ms of wait time in between GC invocations.
   if (LIKELY(ms_delta != 0)) {
     allocation_rate_ = ((gc_start_size - last_gc_size_) * 1000) / ms_delta;
+    mean_allocation_rate_ = DecayingMean(mean_allocation_rate_, allocation_rate_,
+                                         kConcurrentStartForecastWeight);
     VLOG(heap) << "Allocation rate: " << PrettySize(allocation_rate_) << "/s";
   }
 
@@ -1782,6 +2385,7 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
       << static_cast<size_t>(collector_type_) << " and gc_type=" << gc_type;
   ATRACE_BEGIN(StringPrintf("%s %s GC", PrettyCause(gc_cause), collector->GetName()).c_str());
   collector->Run(gc_cause, clear_soft_references || runtime->IsZygote());
+  RecordGcCause(gc_cause, collector);
   total_objects_freed_ever_ += collector->GetFreedObjects();
   total_bytes_freed_ever_ += collector->GetFreedBytes();
   RequestHeapTrim();
@@ -1802,6 +2406,14 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
       log_gc = log_gc || pause >= long_pause_log_threshold_;
     }
   }
+  // The TLABs were revoked by the collection, the unused tails are reported with the GC.
+  size_t tlab_bytes_wasted = 0;
+  if (bump_pointer_space_ != nullptr) {
+    tlab_bytes_wasted += bump_pointer_space_->GetAndResetTlabBytesWasted();
+  }
+  if (temp_space_ != nullptr) {
+    tlab_bytes_wasted += temp_space_->GetAndResetTlabBytesWasted();
+  }
   if (log_gc) {
     const size_t percent_free = GetPercentFree();
     const size_t current_heap_size = GetBytesAllocated();
@@ -1818,9 +2430,13 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
               << PrettySize(collector->GetFreedLargeObjectBytes()) << ") LOS objects, "
               << percent_free << "% free, " << PrettySize(current_heap_size) << "/"
               << PrettySize(total_memory) << ", " << "paused " << pause_string.str()
-              << " total " << PrettyDuration((duration / 1000) * 1000);
+              << " total " << PrettyDuration((duration / 1000) * 1000)
+              << (tlab_bytes_wasted != 0 ? " TLAB waste " + PrettySize(tlab_bytes_wasted) : "");
     VLOG(heap) << ConstDumpable<TimingLogger>(collector->GetTimings());
   }
+  if (runtime->GetMetricsPage() != nullptr) {
+    runtime->GetMetricsPage()->RecordGc(collector);
+  }
   FinishGC(self, gc_type);
   ATRACE_END();
 
@@ -2022,6 +2638,104 @@ class VerifyObjectVisitor {
   const bool verify_referent_;
 };
 
+// Visit the objects in a range of a live bitmap with the visitor of the range.
+template <typename Visitor, typename Bitmap>
+class LiveBitmapRangeTask : public Task {
+ public:
+  LiveBitmapRangeTask(const Visitor* visitor, Bitmap* bitmap, uintptr_t begin, uintptr_t end)
+      : visitor_(visitor), bitmap_(bitmap), begin_(begin), end_(end) {
+  }
+
+  // The thread which started the walk holds the locks for the workers.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    bitmap_->VisitMarkedRange(begin_, end_, *visitor_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  const Visitor* const visitor_;
+  Bitmap* const bitmap_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+};
+
+template <typename Visitor>
+void Heap::VisitLiveBitmapRanges(const Visitor& visitor, bool use_thread_pool,
+                                 std::vector<Visitor>* range_visitors) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetThreadPool();
+  const bool parallel = use_thread_pool && thread_pool != nullptr && parallel_gc_threads_ != 0;
+  const size_t num_ranges = parallel ? (parallel_gc_threads_ + 1) * kHeapVerificationRangesPerThread
+                                     : 1;
+  accounting::HeapBitmap* live_bitmap = GetLiveBitmap();
+  // Split the bitmaps first, the range visitors must not move once the tasks point to them.
+  struct Range {
+    accounting::ContinuousSpaceBitmap* bitmap;
+    accounting::LargeObjectBitmap* large_object_bitmap;
+    uintptr_t begin;
+    uintptr_t end;
+  };
+  std::vector<Range> ranges;
+  for (const auto& bitmap : live_bitmap->continuous_space_bitmaps_) {
+    const uintptr_t begin = bitmap->HeapBegin();
+    const uintptr_t end = bitmap->HeapLimit();
+    const uintptr_t range_size = std::max(RoundUp((end - begin) / num_ranges, KB),
+                                          static_cast<uintptr_t>(KB));
+    for (uintptr_t range_begin = begin; range_begin < end; range_begin += range_size) {
+      ranges.push_back({bitmap, nullptr, range_begin, std::min(range_begin + range_size, end)});
+    }
+  }
+  // The large objects are few, a range for each bitmap is enough.
+  for (const auto& bitmap : live_bitmap->large_object_bitmaps_) {
+    ranges.push_back({nullptr, bitmap, bitmap->HeapBegin(), bitmap->HeapLimit()});
+  }
+  range_visitors->clear();
+  range_visitors->reserve(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    range_visitors->push_back(visitor);
+  }
+  std::vector<Task*> tasks;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    const Range& range = ranges[i];
+    if (range.bitmap != nullptr) {
+      tasks.push_back(new LiveBitmapRangeTask<Visitor, accounting::ContinuousSpaceBitmap>(
+          &(*range_visitors)[i], range.bitmap, range.begin, range.end));
+    } else {
+      tasks.push_back(new LiveBitmapRangeTask<Visitor, accounting::LargeObjectBitmap>(
+          &(*range_visitors)[i], range.large_object_bitmap, range.begin, range.end));
+    }
+  }
+  if (parallel) {
+    for (Task* task : tasks) {
+      thread_pool->AddTask(self, task);
+    }
+    thread_pool->SetMaxActiveWorkers(parallel_gc_threads_);
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  } else {
+    for (Task* task : tasks) {
+      task->Run(self);
+      task->Finalize();
+    }
+  }
+}
+
+template <typename Visitor>
+bool Heap::VerifyLiveBitmap(const Visitor& visitor) {
+  std::vector<Visitor> range_visitors;
+  VisitLiveBitmapRanges(visitor, kParallelHeapVerification, &range_visitors);
+  for (const Visitor& range_visitor : range_visitors) {
+    if (range_visitor.Failed()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Must do this with mutators suspended since we are directly accessing the allocation stacks.
 bool Heap::VerifyHeapReferences(bool verify_referents) {
   Thread* self = Thread::Current();
@@ -2038,10 +2752,13 @@ bool Heap::VerifyHeapReferences(bool verify_referents) {
   // 2. Allocated during the GC (pre sweep GC verification).
   // We don't want to verify the objects in the live stack since they themselves may be
   // pointing to dead objects if they are not reachable.
-  VisitObjects(VerifyObjectVisitor::VisitCallback, &visitor);
+  const char* old_cause = self->StartAssertNoThreadSuspension("Verifying heap references");
+  VisitObjectsOutsideLiveBitmap(VerifyObjectVisitor::VisitCallback, &visitor);
+  const bool live_bitmap_verified = VerifyLiveBitmap(visitor);
+  self->EndAssertNoThreadSuspension(old_cause);
   // Verify the roots:
   Runtime::Current()->VisitRoots(VerifyReferenceVisitor::VerifyRoots, &visitor);
-  if (visitor.Failed()) {
+  if (visitor.Failed() || !live_bitmap_verified) {
     // Dump mod-union tables.
     for (const auto& table_pair : mod_union_tables_) {
       accounting::ModUnionTable* mod_union_table = table_pair.second;
@@ -2162,7 +2879,7 @@ bool Heap::VerifyMissingCardMarks() {
   // thread-local allocation stacks.
   RevokeAllThreadLocalAllocationStacks(self);
   VerifyLiveStackReferences visitor(this);
-  GetLiveBitmap()->Visit(visitor);
+  const bool live_bitmap_verified = VerifyLiveBitmap(visitor);
 
   // We can verify objects in the live stack since none of these should reference dead objects.
   for (mirror::Object** it = live_stack_->Begin(); it != live_stack_->End(); ++it) {
@@ -2171,7 +2888,7 @@ bool Heap::VerifyMissingCardMarks() {
     }
   }
 
-  if (visitor.Failed()) {
+  if (visitor.Failed() || !live_bitmap_verified) {
     DumpSpaces();
     return false;
   }
@@ -2192,6 +2909,14 @@ void Heap::RevokeAllThreadLocalAllocationStacks(Thread* self) {
   MutexLock mu2(self, *Locks::thread_list_lock_);
   std::list<Thread*> thread_list = Runtime::Current()->GetThreadList()->GetList();
   for (Thread* t : thread_list) {
+    const size_t stack_size = t->GetThreadLocalAllocationStackSizeHint();
+    if (t->HasThreadLocalAllocationStack() &&
+        t->GetThreadLocalAllocationStackFreeSlots() * 2 > stack_size) {
+      // Most of the stack is still unused, the thread allocates slower than its stack size
+      // assumes.
+      t->SetThreadLocalAllocationStackSizeHint(
+          std::max(stack_size / 2, kMinThreadLocalAllocationStackSize));
+    }
     t->RevokeThreadLocalAllocationStack();
   }
 }
@@ -2356,7 +3081,7 @@ void Heap::RosAllocVerification(TimingLogger* timings, const char* name) {
   for (const auto& space : continuous_spaces_) {
     if (space->IsRosAllocSpace()) {
       VLOG(heap) << name << " : " << space->GetName();
-      space->AsRosAllocSpace()->Verify();
+      space->AsRosAllocSpace()->Verify(kParallelHeapVerification ? GetThreadPool() : nullptr);
     }
   }
 }
@@ -2370,15 +3095,22 @@ collector::GcType Heap::WaitForGcToComplete(GcCause cause, Thread* self) {
 collector::GcType Heap::WaitForGcToCompleteLocked(GcCause cause, Thread* self) {
   collector::GcType last_gc_type = collector::kGcTypeNone;
   uint64_t wait_start = NanoTime();
+  bool waited = false;
   while (collector_type_running_ != kCollectorTypeNone) {
     ATRACE_BEGIN("GC: Wait For Completion");
     // We must wait, change thread state then sleep on gc_complete_cond_;
     gc_complete_cond_->Wait(self);
     last_gc_type = last_gc_type_;
+    waited = true;
     ATRACE_END();
   }
   uint64_t wait_time = NanoTime() - wait_start;
   total_wait_time_ += wait_time;
+  if (waited) {
+    GcCauseStats& stats = gc_cause_stats_[cause];
+    ++stats.waits;
+    stats.total_wait_ns += wait_time;
+  }
   if (wait_time > long_pause_log_threshold_) {
     LOG(INFO) << "WaitForGcToComplete blocked for " << PrettyDuration(wait_time)
         << " for cause " << cause;
@@ -2390,6 +3122,42 @@ void Heap::DumpForSigQuit(std::ostream& os) {
   os << "Heap: " << GetPercentFree() << "% free, " << PrettySize(GetBytesAllocated()) << "/"
      << PrettySize(GetTotalMemory()) << "; " << GetObjectsAllocated() << " objects\n";
   DumpGcPerformanceInfo(os);
+  if (allocation_sampler_.get() != nullptr) {
+    allocation_sampler_->DumpForSigQuit(os);
+  }
+  space::ZygoteSpace* zygote_space = have_zygote_space_ ? FindZygoteSpace() : nullptr;
+  if (zygote_space != nullptr && !Runtime::Current()->IsZygote()) {
+    // The zygote structures that the children copy on write.
+    const byte* card_begin = card_table_->CardFromAddr(zygote_space->Begin());
+    const byte* card_end = card_table_->CardFromAddr(zygote_space->Limit());
+    os << "Zygote space cards: " << DescribePrivatePages(card_begin, card_end - card_begin)
+       << "\n";
+    accounting::ContinuousSpaceBitmap* live_bitmap = zygote_space->GetLiveBitmap();
+    os << "Zygote space live bitmap: "
+       << DescribePrivatePages(live_bitmap->Begin(), live_bitmap->Size()) << "\n";
+    accounting::ContinuousSpaceBitmap* mark_bitmap = zygote_space->GetMarkBitmap();
+    if (mark_bitmap != nullptr && mark_bitmap != live_bitmap) {
+      os << "Zygote space mark bitmap: "
+         << DescribePrivatePages(mark_bitmap->Begin(), mark_bitmap->Size()) << "\n";
+    }
+  }
+}
+
+void Heap::DumpAllocationSamples() {
+  if (allocation_sampler_.get() == nullptr || allocation_sample_file_.empty()) {
+    return;
+  }
+  std::ostringstream os;
+  allocation_sampler_->DumpPprof(os);
+  UniquePtr<File> file(OS::CreateEmptyFile(allocation_sample_file_.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create heap sample file " << allocation_sample_file_;
+    return;
+  }
+  std::string profile(os.str());
+  if (!file->WriteFully(profile.data(), profile.size())) {
+    PLOG(WARNING) << "Failed to write heap sample file " << allocation_sample_file_;
+  }
 }
 
 size_t Heap::GetPercentFree() {
@@ -2427,6 +3195,9 @@ void Heap::UpdateMaxNativeFootprint() {
   }
   native_footprint_gc_watermark_ = target_size;
   native_footprint_limit_ = 2 * target_size - native_size;
+  native_pacing_step_ = std::max((target_size - native_size) / kNativePacingSteps,
+                                 kMinNativePacingStep);
+  native_pacing_next_gc_ = native_size + native_pacing_step_;
 }
 
 collector::GarbageCollector* Heap::FindCollectorByGcType(collector::GcType gc_type) {
@@ -2451,8 +3222,10 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran) {
   // We know what our utilization is at this moment.
   // This doesn't actually resize any memory. It just lets the heap grow more when necessary.
   const uint64_t bytes_allocated = GetBytesAllocated();
+  const uint64_t gc_end_time_ns = NanoTime();
+  const uint64_t gc_interval_ns = gc_end_time_ns - last_gc_time_ns_;
   last_gc_size_ = bytes_allocated;
-  last_gc_time_ns_ = NanoTime();
+  last_gc_time_ns_ = gc_end_time_ns;
   uint64_t target_size;
   collector::GcType gc_type = collector_ran->GetGcType();
   if (gc_type != collector::kGcTypeSticky) {
@@ -2493,22 +3266,38 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran) {
       target_size = std::max(bytes_allocated, static_cast<uint64_t>(max_allowed_footprint_));
     }
   }
+  if (kUseAdaptiveGcTypeSelection) {
+    RecordGcTypeEfficiency(collector_ran);
+    next_gc_type_ = SelectNextGcType(bytes_allocated);
+  }
+  if (pause_time_target_ != 0 || gc_time_percent_target_ != 0.0) {
+    target_size = ApplyGcTargets(collector_ran, bytes_allocated, target_size, gc_interval_ns);
+  }
   if (!ignore_max_footprint_) {
     SetIdealFootprint(target_size);
     if (IsGcConcurrent()) {
       // Calculate when to perform the next ConcurrentGC.
-      // Calculate the estimated GC duration.
-      const double gc_duration_seconds = NsToMs(collector_ran->GetDurationNs()) / 1000.0;
-      // Estimate how many remaining bytes we will have when we need to start the next GC.
-      size_t remaining_bytes = allocation_rate_ * gc_duration_seconds;
-      remaining_bytes = std::min(remaining_bytes, kMaxConcurrentRemainingBytes);
+      // Forecast the GC duration, the slower of the last GC and of the recent ones.
+      const uint64_t gc_duration_ns = collector_ran->GetDurationNs();
+      mean_gc_duration_ns_ = DecayingMean(mean_gc_duration_ns_, gc_duration_ns,
+                                          kConcurrentStartForecastWeight);
+      const double gc_duration_seconds =
+          std::max(mean_gc_duration_ns_, static_cast<double>(gc_duration_ns)) / MsToNs(1000);
+      // Forecast the bytes allocated during the GC. Bursts are what runs the heap full before the
+      // GC completes, so use the faster of the last and of the recent allocation rates.
+      const double allocation_rate =
+          std::max(mean_allocation_rate_, static_cast<double>(allocation_rate_));
+      const uint64_t forecast_bytes =
+          allocation_rate * gc_duration_seconds * kConcurrentStartForecastMargin;
+      // When the forecast exceeds the footprint, the GC starts right away below.
+      size_t remaining_bytes = std::min(forecast_bytes,
+                                        static_cast<uint64_t>(max_allowed_footprint_));
       remaining_bytes = std::max(remaining_bytes, kMinConcurrentRemainingBytes);
-      if (UNLIKELY(remaining_bytes > max_allowed_footprint_)) {
-        // A never going to happen situation that from the estimated allocation rate we will exceed
-        // the applications entire footprint with the given estimated allocation rate. Schedule
-        // another GC nearly straight away.
-        remaining_bytes = kMinConcurrentRemainingBytes;
-      }
+      remaining_bytes = std::min(remaining_bytes, max_allowed_footprint_);
+      VLOG(heap) << "Concurrent GC forecast: " << PrettySize(static_cast<int64_t>(allocation_rate))
+                 << "/s for "
+                 << PrettyDuration(static_cast<uint64_t>(gc_duration_seconds * MsToNs(1000)))
+                 << ", starting " << PrettySize(remaining_bytes) << " before the footprint limit";
       DCHECK_LE(remaining_bytes, max_allowed_footprint_);
       DCHECK_LE(max_allowed_footprint_, growth_limit_);
       // Start a concurrent GC when we get close to the estimated remaining bytes. When the
@@ -2520,6 +3309,116 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran) {
   }
 }
 
+double Heap::DecayingMean(double mean, double value, double weight) {
+  if (mean == 0.0) {
+    return value;
+  }
+  return mean + (value - mean) * weight;
+}
+
+void Heap::RecordGcTypeEfficiency(collector::GarbageCollector* collector_ran) {
+  const collector::GcType gc_type = collector_ran->GetGcType();
+  DCHECK_LT(static_cast<size_t>(gc_type), static_cast<size_t>(collector::kGcTypeMax));
+  uint64_t total_pause_ns = 0;
+  for (uint64_t pause : collector_ran->GetPauseTimes()) {
+    total_pause_ns += pause;
+  }
+  const double pause_ms = std::max(static_cast<double>(total_pause_ns) / MsToNs(1),
+                                   kMinGcTypeEfficiencyPauseMs);
+  const int64_t freed_bytes = collector_ran->GetFreedBytes() +
+      collector_ran->GetFreedLargeObjectBytes();
+  const double bytes_freed_per_pause_ms = std::max<int64_t>(freed_bytes, 0) / pause_ms;
+  for (GcTypeEfficiency& efficiency : gc_type_efficiency_) {
+    ++efficiency.collections_since_run;
+  }
+  GcTypeEfficiency& efficiency = gc_type_efficiency_[gc_type];
+  if (efficiency.samples == 0) {
+    efficiency.bytes_freed_per_pause_ms = bytes_freed_per_pause_ms;
+  } else {
+    efficiency.bytes_freed_per_pause_ms =
+        efficiency.bytes_freed_per_pause_ms * (1.0 - kGcTypeEfficiencyWeight) +
+        bytes_freed_per_pause_ms * kGcTypeEfficiencyWeight;
+  }
+  ++efficiency.samples;
+  efficiency.collections_since_run = 0;
+}
+
+collector::GcType Heap::SelectNextGcType(uint64_t bytes_allocated) {
+  collector::GcType selected = collector::kGcTypeNone;
+  double best_bytes_freed_per_pause_ms = -1.0;
+  // The plan is ordered from the cheapest type, which wins the ties.
+  for (collector::GcType gc_type : gc_plan_) {
+    if (gc_type == collector::kGcTypePartial && !have_zygote_space_) {
+      continue;
+    }
+    // Sticky GCs don't reclaim the objects which died after surviving a collection, they could
+    // accumulate if the sticky GC stayed the most efficient.
+    if (gc_type == collector::kGcTypeSticky && bytes_allocated > max_allowed_footprint_) {
+      continue;
+    }
+    const GcTypeEfficiency& efficiency = gc_type_efficiency_[gc_type];
+    if (efficiency.samples == 0 || efficiency.collections_since_run >= kGcTypeRetryInterval) {
+      selected = gc_type;
+      break;
+    }
+    if (efficiency.bytes_freed_per_pause_ms > best_bytes_freed_per_pause_ms) {
+      best_bytes_freed_per_pause_ms = efficiency.bytes_freed_per_pause_ms;
+      selected = gc_type;
+    }
+  }
+  if (selected == collector::kGcTypeNone) {
+    DCHECK(!gc_plan_.empty());
+    selected = gc_plan_.back();
+  }
+  ++gc_type_efficiency_[selected].selections;
+  gc_type_selection_history_[gc_type_selections_ % kGcTypeSelectionHistorySize] = selected;
+  ++gc_type_selections_;
+  return selected;
+}
+
+uint64_t Heap::ApplyGcTargets(collector::GarbageCollector* collector_ran,
+                              uint64_t bytes_allocated, uint64_t target_size,
+                              uint64_t gc_interval_ns) {
+  // How much to scale the free space by, at a steady allocation rate the GCs happen proportionally
+  // less often as the free space grows.
+  double free_scale = 1.0;
+  if (gc_time_percent_target_ != 0.0 && gc_interval_ns != 0) {
+    const double gc_time_ratio =
+        std::min(static_cast<double>(collector_ran->GetDurationNs()) / gc_interval_ns, 1.0);
+    gc_time_ratio_ = (gc_time_ratio_ + gc_time_ratio) / 2;
+    free_scale = gc_time_ratio_ * 100.0 / gc_time_percent_target_;
+  }
+  if (pause_time_target_ != 0) {
+    uint64_t longest_pause = 0;
+    for (uint64_t pause : collector_ran->GetPauseTimes()) {
+      longest_pause = std::max(longest_pause, pause);
+    }
+    if (longest_pause > pause_time_target_ && !IsGcConcurrent()) {
+      // The collection is a single pause, which is shorter the less was allocated since the last
+      // one. The pause target takes precedence over the GC time target.
+      free_scale = std::min(free_scale, static_cast<double>(pause_time_target_) / longest_pause);
+    }
+    // Keep doing sticky GCs while the non sticky ones pause for too long and the sticky ones
+    // don't, unless the footprint limit is exceeded, see the sticky GC choice above.
+    if (next_gc_type_ != collector::kGcTypeSticky && bytes_allocated <= max_allowed_footprint_) {
+      collector::GarbageCollector* sticky_collector =
+          FindCollectorByGcType(collector::kGcTypeSticky);
+      collector::GarbageCollector* next_collector = FindCollectorByGcType(next_gc_type_);
+      if (sticky_collector != nullptr && next_collector != nullptr &&
+          next_collector->GetPauseHistogram().SampleSize() > 0 &&
+          next_collector->GetPauseHistogram().Mean() > pause_time_target_ &&
+          (sticky_collector->GetPauseHistogram().SampleSize() == 0 ||
+           sticky_collector->GetPauseHistogram().Mean() <= pause_time_target_)) {
+        next_gc_type_ = collector::kGcTypeSticky;
+      }
+    }
+  }
+  free_scale = std::max(std::min(free_scale, kMaxGcTargetFreeScale), kMinGcTargetFreeScale);
+  DCHECK_GE(target_size, bytes_allocated);
+  const uint64_t free_bytes = static_cast<uint64_t>((target_size - bytes_allocated) * free_scale);
+  return bytes_allocated + std::max(free_bytes, static_cast<uint64_t>(min_free_));
+}
+
 void Heap::ClearGrowthLimit() {
   growth_limit_ = capacity_;
   non_moving_space_->ClearGrowthLimit();
@@ -2636,21 +3535,66 @@ void Heap::SignalHeapTrimDaemon(Thread* self) {
 }
 
 void Heap::RevokeThreadLocalBuffers(Thread* thread) {
+  FlushAllocatedBytes(thread);
   if (rosalloc_space_ != nullptr) {
     rosalloc_space_->RevokeThreadLocalBuffers(thread);
   }
   if (bump_pointer_space_ != nullptr) {
+    ReturnUnusedTlabBytes(thread);
     bump_pointer_space_->RevokeThreadLocalBuffers(thread);
   }
 }
 
+bool Heap::HasCountedTlab(Thread* thread) const {
+  return bump_pointer_space_ != nullptr && thread->HasTlab() &&
+      bump_pointer_space_->HasAddress(reinterpret_cast<mirror::Object*>(thread->GetTlabStart()));
+}
+
+void Heap::ReturnUnusedTlabBytes(Thread* thread) {
+  if (HasCountedTlab(thread)) {
+    num_bytes_allocated_.FetchAndSub(thread->TlabSize());
+    thread->SubtractAllocatedBytes(thread->TlabSize());
+  }
+}
+
+void Heap::FlushAllocatedBytes(Thread* thread) {
+  const size_t unflushed_bytes = thread->GetUnflushedAllocatedBytes();
+  if (unflushed_bytes != 0) {
+    thread->SetUnflushedAllocatedBytes(0);
+    num_bytes_allocated_.FetchAndAdd(unflushed_bytes);
+  }
+}
+
+uint64_t Heap::GetBytesAllocatedByThread(Thread* thread) {
+  uint64_t allocated_bytes = thread->GetAllocatedBytes();
+  if (HasCountedTlab(thread)) {
+    // The unused tail of the TLAB isn't allocated yet.
+    allocated_bytes -= thread->TlabSize();
+  }
+  return allocated_bytes;
+}
+
 void Heap::RevokeRosAllocThreadLocalBuffers(Thread* thread) {
+  // The GC counts the bytes freed from the thread's runs, the bytes allocated in them must be
+  // counted first.
+  FlushAllocatedBytes(thread);
   if (rosalloc_space_ != nullptr) {
     rosalloc_space_->RevokeThreadLocalBuffers(thread);
   }
 }
 
 void Heap::RevokeAllThreadLocalBuffers() {
+  {
+    Thread* self = Thread::Current();
+    MutexLock mu(self, *Locks::runtime_shutdown_lock_);
+    MutexLock mu2(self, *Locks::thread_list_lock_);
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      FlushAllocatedBytes(thread);
+      if (bump_pointer_space_ != nullptr) {
+        ReturnUnusedTlabBytes(thread);
+      }
+    }
+  }
   if (rosalloc_space_ != nullptr) {
     rosalloc_space_->RevokeAllThreadLocalBuffers();
   }
@@ -2677,6 +3621,11 @@ void Heap::RunFinalization(JNIEnv* env) {
 
 void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
   Thread* self = ThreadForEnv(env);
+  if (native_allocation_pacing_) {
+    native_bytes_allocated_.FetchAndAdd(bytes);
+    PaceNativeAllocation(env, self);
+    return;
+  }
   if (native_need_to_run_finalization_) {
     RunFinalization(env);
     UpdateMaxNativeFootprint();
@@ -2691,22 +3640,9 @@ void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
     // The second watermark is higher than the gc watermark. If you hit this it means you are
     // allocating native objects faster than the GC can keep up with.
     if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_limit_) {
-      if (WaitForGcToComplete(kGcCauseForNativeAlloc, self) != collector::kGcTypeNone) {
-        // Just finished a GC, attempt to run finalizers.
-        RunFinalization(env);
-        CHECK(!env->ExceptionCheck());
-      }
-      // If we still are over the watermark, attempt a GC for alloc and run finalizers.
-      if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_limit_) {
-        CollectGarbageInternal(gc_type, kGcCauseForNativeAlloc, false);
-        RunFinalization(env);
-        native_need_to_run_finalization_ = false;
-        CHECK(!env->ExceptionCheck());
-      }
-      // We have just run finalizers, update the native watermark since it is very likely that
-      // finalizers released native managed allocations.
-      UpdateMaxNativeFootprint();
+      RunNativeAllocationGc(env, self);
     } else if (!IsGCRequestPending()) {
+      native_alloc_gc_count_.FetchAndAdd(1);
       if (IsGcConcurrent()) {
         RequestConcurrentGC(self);
       } else {
@@ -2716,6 +3652,56 @@ void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
   }
 }
 
+void Heap::RunNativeAllocationGc(JNIEnv* env, Thread* self) {
+  ScopedGcForAllocTime gc_for_alloc_time(self);
+  native_alloc_blocking_gc_count_.FetchAndAdd(1);
+  if (WaitForGcToComplete(kGcCauseForNativeAlloc, self) != collector::kGcTypeNone) {
+    // Just finished a GC, attempt to run finalizers.
+    RunFinalization(env);
+    CHECK(!env->ExceptionCheck());
+  }
+  // If we still are over the watermark, attempt a GC for alloc and run finalizers.
+  if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_limit_) {
+    CollectGarbageInternal(have_zygote_space_ ? collector::kGcTypePartial :
+                           collector::kGcTypeFull, kGcCauseForNativeAlloc, false);
+    RunFinalization(env);
+    native_need_to_run_finalization_ = false;
+    CHECK(!env->ExceptionCheck());
+  }
+  // We have just run finalizers, update the native watermark since it is very likely that
+  // finalizers released native managed allocations.
+  UpdateMaxNativeFootprint();
+}
+
+void Heap::PaceNativeAllocation(JNIEnv* env, Thread* self) {
+  size_t native_bytes = native_bytes_allocated_;
+  if (native_need_to_run_finalization_) {
+    // A GC finished since the watermarks were last set. The finalizer daemon frees the native
+    // memory of what it collected, move the watermarks from where the native bytes are now rather
+    // than waiting for the finalizers.
+    native_need_to_run_finalization_ = false;
+    UpdateMaxNativeFootprint();
+  }
+  if (native_bytes > native_footprint_limit_) {
+    uint64_t now = NanoTime();
+    if (now - last_native_blocking_gc_time_ns_ >= kMinNativeBlockingGcInterval) {
+      last_native_blocking_gc_time_ns_ = now;
+      RunNativeAllocationGc(env, self);
+      return;
+    }
+  }
+  if (native_bytes > native_pacing_next_gc_ && !IsGCRequestPending()) {
+    native_pacing_next_gc_ = native_bytes + native_pacing_step_;
+    native_alloc_gc_count_.FetchAndAdd(1);
+    if (IsGcConcurrent()) {
+      RequestConcurrentGC(self);
+    } else {
+      CollectGarbageInternal(have_zygote_space_ ? collector::kGcTypePartial :
+                             collector::kGcTypeFull, kGcCauseForNativeAlloc, false);
+    }
+  }
+}
+
 void Heap::RegisterNativeFree(JNIEnv* env, int bytes) {
   int expected_size, new_size;
   do {
@@ -49,12 +49,15 @@ class Thread;
 class TimingLogger;
 
 namespace mirror {
+  class ArtMethod;
   class Class;
   class Object;
 }  // namespace mirror
 
 namespace gc {
 
+class AllocationSampler;
+class AllocationSiteTable;
 class ReferenceProcessor;
 
 namespace accounting {
@@ -82,6 +85,7 @@ namespace space {
   class Space;
   class SpaceTest;
   class ContinuousMemMapAllocSpace;
+  class ZygoteSpace;
 }  // namespace space
 
 class AgeCardVisitor {
@@ -101,6 +105,14 @@ static constexpr bool kUseRosAlloc = true;
 // If true, use thread-local allocation stack.
 static constexpr bool kUseThreadLocalAllocationStack = true;
 
+// If true, parallel mark stack processing uses a work stealing thread pool instead of splitting
+// the mark stack into fixed chunks up front.
+static constexpr bool kUseWorkStealingMarking = false;
+
+// If true, the generational semi-space collector pretenures the allocation sites whose objects
+// tend to survive.
+static constexpr bool kUseAllocationSitePretenuring = true;
+
 // The process state passed in from the activity manager, used to determine when to do trimming
 // and compaction.
 enum ProcessState {
@@ -125,7 +137,9 @@ class Heap {
   static constexpr size_t kDefaultMinFree = kDefaultMaxFree / 4;
   static constexpr size_t kDefaultLongPauseLogThreshold = MsToNs(5);
   static constexpr size_t kDefaultLongGCLogThreshold = MsToNs(100);
-  static constexpr size_t kDefaultTLABSize = 256 * KB;
+  // Bounds of how much the pause time sizing policy scales the free space by after one GC.
+  static constexpr double kMinGcTargetFreeScale = 0.5;
+  static constexpr double kMaxGcTargetFreeScale = 2.0;
   static constexpr double kDefaultTargetUtilization = 0.5;
   static constexpr double kDefaultHeapGrowthMultiplier = 2.0;
 
@@ -134,8 +148,33 @@ class Heap {
 
   // How often we allow heap trimming to happen (nanoseconds).
   static constexpr uint64_t kHeapTrimWait = MsToNs(5000);
+  // Trim the managed heap in bounded slices so that a trim does not hold it for long.
+  static constexpr bool kUseIncrementalHeapTrim = true;
+  // How long a slice of an incremental heap trim lasts at most (nanoseconds).
+  static constexpr uint64_t kHeapTrimSliceDuration = MsToNs(1);
+  // How long the trimming thread sleeps between two slices, letting the mutators allocate and
+  // collect (nanoseconds).
+  static constexpr uint64_t kHeapTrimSliceInterval = MsToNs(2);
   // How long we wait after a transition request to perform a collector transition (nanoseconds).
   static constexpr uint64_t kCollectorTransitionWait = MsToNs(5000);
+  // The main space is compacted into the backup space when its largest free page run is less than
+  // this fraction of its free bytes, and it has at least kMinFragmentedFreeBytes free.
+  static constexpr double kHomogeneousSpaceCompactFragmentation = 0.5;
+  static constexpr size_t kMinFragmentedFreeBytes = 4 * MB;
+  // Minimum time between two compactions of the main space before throwing an OOM.
+  static constexpr uint64_t kMinHomogeneousSpaceCompactIntervalForOom = MsToNs(100 * 1000);
+  // How many of the last choices of the next GC type DumpGcPerformanceInfo prints.
+  static constexpr size_t kGcTypeSelectionHistorySize = 32;
+  // With native allocation pacing, a concurrent GC is requested each time the native bytes grow
+  // by this fraction of the distance from the last GC to the GC watermark, at least
+  // kMinNativePacingStep.
+  static constexpr size_t kNativePacingSteps = 2;
+  static constexpr size_t kMinNativePacingStep = 256 * KB;
+  // With native allocation pacing, the minimum time between two GCs blocking native allocations.
+  static constexpr uint64_t kMinNativeBlockingGcInterval = MsToNs(1000);
+  // Bytes a thread may allocate outside of TLABs before they are added to the heap's count, the
+  // concurrent GC is requested at most this late per allocating thread.
+  static constexpr size_t kMaxUnflushedAllocatedBytes = 16 * KB;
 
   // Create a heap with the requested sizes. The possible empty
   // image_file_names names specify Spaces to load based on
@@ -146,12 +185,16 @@ class Heap {
                 const std::string& original_image_file_name,
                 const InstructionSet image_instruction_set,
                 CollectorType foreground_collector_type, CollectorType background_collector_type,
-                size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
+                size_t parallel_gc_threads, size_t conc_gc_threads, bool numa_aware_gc_threads,
+                bool native_allocation_pacing, bool low_memory_mode,
                 size_t long_pause_threshold, size_t long_gc_threshold,
+                size_t pause_time_target, double gc_time_percent_target,
                 bool ignore_max_footprint, bool use_tlab,
+                size_t rosalloc_thread_local_brackets, size_t soft_ref_lru_policy_ms_per_mb,
                 bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
                 bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
-                bool verify_post_gc_rosalloc);
+                bool verify_post_gc_rosalloc, size_t heap_sample_interval,
+                const std::string& heap_sample_file);
 
   ~Heap();
 
@@ -199,6 +242,14 @@ class Heap {
   void RegisterNativeAllocation(JNIEnv* env, int bytes);
   void RegisterNativeFree(JNIEnv* env, int bytes);
 
+  // The GCs requested, and the GCs run blocking the allocating thread, by native allocations.
+  size_t GetNativeAllocGcCount() const {
+    return native_alloc_gc_count_;
+  }
+  size_t GetNativeAllocBlockingGcCount() const {
+    return native_alloc_blocking_gc_count_;
+  }
+
   // Change the allocator, updates entrypoints.
   void ChangeAllocator(AllocatorType allocator)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
@@ -207,6 +258,20 @@ class Heap {
   // Transition the garbage collector during runtime, may copy objects from one space to another.
   void TransitionCollector(CollectorType collector_type);
 
+  enum HomogeneousSpaceCompactResult {
+    kHomogeneousSpaceCompactSuccess,
+    // There is no backup space, or the main space does not move objects.
+    kHomogeneousSpaceCompactErrorUnsupported,
+    // Moving objects is currently disabled or a moving collector is in use.
+    kHomogeneousSpaceCompactErrorReject,
+    kHomogeneousSpaceCompactErrorShuttingDown,
+  };
+  // Copy the live objects of the main space into the backup space, which becomes the main space.
+  // The old main space is cleared and kept as the backup space for the next compaction.
+  HomogeneousSpaceCompactResult PerformHomogeneousSpaceCompact() LOCKS_EXCLUDED(gc_complete_lock_);
+  // Whether the free memory of the main space is fragmented enough to be worth compacting.
+  bool IsMainSpaceFragmented();
+
   // Change the collector to be one of the possible options (MS, CMS, SS).
   void ChangeCollector(CollectorType collector_type)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -247,6 +312,13 @@ class Heap {
   void IncrementDisableMovingGC(Thread* self);
   void DecrementDisableMovingGC(Thread* self);
 
+  // Keep the movable object obj in place until UnpinObject, for the JNI critical sections. An
+  // object in a region space only holds up the evacuation of its region. The other moving spaces
+  // are evacuated as a whole, so pinning disables the moving GC, which may wait for a running one
+  // and let obj move before it returns.
+  void PinObject(Thread* self, mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void UnpinObject(Thread* self, mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Clear all of the mark bits, doesn't clear bitmaps which have the same live bits as mark bits.
   void ClearMarkedObjects() EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
@@ -259,10 +331,17 @@ class Heap {
 
   // Implements VMDebug.countInstancesOfClass and JDWP VM_InstanceCount.
   // The boolean decides whether to use IsAssignableFrom or == when comparing classes.
+  // Like GetInstances and GetReferringObjects, walks the live bitmap on the heap thread pool
+  // unless a collection is running.
   void CountInstances(const std::vector<mirror::Class*>& classes, bool use_is_assignable_from,
                       uint64_t* counts)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Returns the number of objects scheduled for finalization whose finalizer hasn't run yet,
+  // the finalizer references that still hold a zombie.
+  uint64_t CountPendingFinalizers()
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Implements JDWP RT_Instances.
   void GetInstances(mirror::Class* c, int32_t max_count, std::vector<mirror::Object*>& instances)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
@@ -371,11 +450,16 @@ class Heap {
 
   void AddFinalizerReference(Thread* self, mirror::Object** object);
 
-  // Returns the number of bytes currently allocated.
+  // Returns the number of bytes currently allocated. Each thread may have allocated up to
+  // kMaxUnflushedAllocatedBytes more which are not counted yet.
   size_t GetBytesAllocated() const {
     return num_bytes_allocated_;
   }
 
+  // Returns the number of bytes allocated by the thread since it started, freed or not. The thread
+  // must be the caller or suspended.
+  uint64_t GetBytesAllocatedByThread(Thread* thread);
+
   // Returns the number of objects currently allocated.
   size_t GetObjectsAllocated() const LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
 
@@ -422,6 +506,10 @@ class Heap {
 
   void DumpForSigQuit(std::ostream& os);
 
+  // Writes the allocation samples to the heap sample file as a pprof heap profile, does nothing
+  // unless both the sampling interval and the file were set.
+  void DumpAllocationSamples() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
 
   // Do a pending heap transition or trim.
   void DoPendingTransitionOrTrim() LOCKS_EXCLUDED(heap_trim_request_lock_);
@@ -429,9 +517,14 @@ class Heap {
   // Trim the managed and native heaps by releasing unused memory back to the OS.
   void Trim() LOCKS_EXCLUDED(heap_trim_request_lock_);
 
+  // Number of heap trim slices and the bytes of the managed heap they released.
+  uint64_t GetHeapTrimSlices() LOCKS_EXCLUDED(heap_trim_request_lock_);
+  uint64_t GetHeapTrimBytesReleased() LOCKS_EXCLUDED(heap_trim_request_lock_);
+
   void RevokeThreadLocalBuffers(Thread* thread);
   void RevokeRosAllocThreadLocalBuffers(Thread* thread);
-  void RevokeAllThreadLocalBuffers();
+  void RevokeAllThreadLocalBuffers() LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_,
+                                                    Locks::thread_list_lock_);
   void AssertAllBumpPointerSpaceThreadLocalBuffersAreRevoked();
   void RosAllocVerification(TimingLogger* timings, const char* name)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -523,6 +616,25 @@ class Heap {
   // GC performance measuring
   void DumpGcPerformanceInfo(std::ostream& os);
 
+  // The values GetGcCauseStats writes for each GC cause, and in all.
+  static constexpr size_t kGcCauseStatsFields = 6;
+  static constexpr size_t kGcCauseStatsLength = kGcCauseMax * kGcCauseStatsFields + 3;
+
+  // Writes the kGcCauseStatsLength cumulative statistics of the GC causes to stats. For each cause
+  // in the order of GcCause: the collections run for the cause, their total time and paused time,
+  // their longest pause, how many times mutators waited for a collection with that cause and the
+  // total wait time. The allocation stalls follow: their number, total time and longest stall.
+  // Times are in nanoseconds.
+  void GetGcCauseStats(uint64_t* stats) LOCKS_EXCLUDED(gc_complete_lock_);
+
+  // Records that an allocation of self stalled for stall_ns, waiting for or running a GC.
+  void RecordAllocationStall(Thread* self, uint64_t stall_ns) LOCKS_EXCLUDED(gc_complete_lock_);
+
+  // The collectors the heap may run, whose pause histograms and timings measure the GC.
+  const std::vector<collector::GarbageCollector*>& GetGarbageCollectors() const {
+    return garbage_collectors_;
+  }
+
   // Returns true if we currently care about pause times.
   bool CareAboutPauseTimes() const {
     return process_state_ == kProcessStateJankPerceptible;
@@ -531,9 +643,32 @@ class Heap {
   // Thread pool.
   void CreateThreadPool();
   void DeleteThreadPool();
+  // Returns the work stealing thread pool used for marking, null unless
+  // kUseWorkStealingMarking is set.
+  WorkStealingThreadPool* GetWorkStealingThreadPool() {
+    return work_stealing_thread_pool_.get();
+  }
   ThreadPool* GetThreadPool() {
     return thread_pool_.get();
   }
+
+  // Returns the survival feedback of the allocation sites, null unless the foreground collector
+  // is the generational semi-space collector and kUseAllocationSitePretenuring is set.
+  AllocationSiteTable* GetAllocationSiteTable() {
+    return allocation_site_table_.get();
+  }
+  // Returns the allocator for an allocation of klass by method: the promotion space if the site is
+  // pretenured, otherwise allocator.
+  ALWAYS_INLINE AllocatorType GetAllocatorForSite(mirror::ArtMethod* method, mirror::Class* klass,
+                                                  AllocatorType allocator)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Returns the sampling heap profiler, null unless -XX:HeapSampleInterval was set.
+  AllocationSampler* GetAllocationSampler() {
+    return allocation_sampler_.get();
+  }
+  // Feed an allocation by method back to the allocation site table.
+  ALWAYS_INLINE void RecordAllocationSite(mirror::ArtMethod* method, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   size_t GetParallelGCThreadCount() const {
     return parallel_gc_threads_;
   }
@@ -541,6 +676,12 @@ class Heap {
     return conc_gc_threads_;
   }
   accounting::ModUnionTable* FindModUnionTableFromSpace(space::Space* space);
+
+  // Clears the cards of the zygote space into its mod-union table before the zygote forks, so
+  // that the first GC of each child doesn't write the card table pages of the zygote space.
+  void CleanZygoteSpaceCards();
+
+  space::ZygoteSpace* FindZygoteSpace() const;
   void AddModUnionTable(accounting::ModUnionTable* mod_union_table);
 
   accounting::RememberedSet* FindRememberedSetFromSpace(space::Space* space);
@@ -553,13 +694,17 @@ class Heap {
   }
   bool HasImageSpace() const;
 
+  collector::ConcurrentCopying* ConcurrentCopyingCollector() {
+    return concurrent_copying_collector_;
+  }
+
   ReferenceProcessor* GetReferenceProcessor() {
     return &reference_processor_;
   }
 
  private:
   void Compact(space::ContinuousMemMapAllocSpace* target_space,
-               space::ContinuousMemMapAllocSpace* source_space)
+               space::ContinuousMemMapAllocSpace* source_space, GcCause gc_cause)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void FinishGC(Thread* self, collector::GcType gc_type) LOCKS_EXCLUDED(gc_complete_lock_);
@@ -570,11 +715,15 @@ class Heap {
         allocator_type != kAllocatorTypeTLAB;
   }
   static ALWAYS_INLINE bool AllocatorMayHaveConcurrentGC(AllocatorType allocator_type) {
-    return AllocatorHasAllocationStack(allocator_type);
+    // The concurrent copying collector allocates into TLABs, which is only possible with the
+    // read barrier.
+    return AllocatorHasAllocationStack(allocator_type) ||
+        (kUseBakerReadBarrier && allocator_type == kAllocatorTypeTLAB);
   }
   static bool IsMovingGc(CollectorType collector_type) {
     return collector_type == kCollectorTypeSS || collector_type == kCollectorTypeGSS ||
-        collector_type == kCollectorTypeCC;
+        collector_type == kCollectorTypeCC ||
+        collector_type == kCollectorTypeHomogeneousSpaceCompact;
   }
   bool ShouldAllocLargeObject(mirror::Class* c, size_t byte_count) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -616,6 +765,24 @@ class Heap {
   void ThrowOutOfMemoryError(Thread* self, size_t byte_count, bool large_object_allocation)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Takes the unused tail of the TLAB of thread back from num_bytes_allocated_ before the TLAB is
+  // revoked, see TryToAllocate.
+  void ReturnUnusedTlabBytes(Thread* thread);
+
+  // Whether the TLAB of the thread was counted as allocated when the thread got it. Only the TLABs
+  // of the mutators are, the collectors may copy into TLABs of other bump pointer spaces.
+  bool HasCountedTlab(Thread* thread) const;
+
+  // Counts an allocation outside of a TLAB. The bytes are added to the thread's unflushed bytes,
+  // which are only added to num_bytes_allocated_ once they reach kMaxUnflushedAllocatedBytes so
+  // that the allocating threads don't all update the same counter. Returns num_bytes_allocated_
+  // with the unflushed bytes of the thread included.
+  ALWAYS_INLINE size_t CountAllocatedBytes(Thread* self, size_t bytes_allocated);
+
+  // Adds the unflushed bytes of the thread to num_bytes_allocated_. The thread must be the caller
+  // or suspended.
+  void FlushAllocatedBytes(Thread* thread);
+
   template <bool kGrow>
   bool IsOutOfMemoryOnAllocation(AllocatorType allocator_type, size_t alloc_size);
 
@@ -628,6 +795,10 @@ class Heap {
 
   // Blocks the caller until the garbage collector becomes idle and returns the type of GC we
   // waited for.
+  // Adds a collection run for cause to the statistics of the cause.
+  void RecordGcCause(GcCause cause, collector::GarbageCollector* collector)
+      LOCKS_EXCLUDED(gc_complete_lock_);
+
   collector::GcType WaitForGcToCompleteLocked(GcCause cause, Thread* self)
       EXCLUSIVE_LOCKS_REQUIRED(gc_complete_lock_);
 
@@ -662,9 +833,19 @@ class Heap {
   // bytes allocated and the target utilization ratio.
   void UpdateMaxNativeFootprint();
 
+  // RegisterNativeAllocation with native allocation pacing, see native_allocation_pacing_.
+  void PaceNativeAllocation(JNIEnv* env, Thread* self);
+  // Collects and runs the finalizers on the allocating thread when the native bytes are over the
+  // limit.
+  void RunNativeAllocationGc(JNIEnv* env, Thread* self);
+
   // Find a collector based on GC type.
   collector::GarbageCollector* FindCollectorByGcType(collector::GcType gc_type);
 
+  // Create a free list space with the main allocator, RosAlloc or DlMalloc.
+  space::MallocSpace* CreateMallocSpaceFromMemMap(MemMap* mem_map, size_t initial_size,
+                                                  size_t growth_limit, size_t capacity,
+                                                  const char* name, bool can_move_objects);
   // Create the main free list space, typically either a RosAlloc space or DlMalloc space.
   void CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t growth_limit,
                              size_t capacity);
@@ -674,6 +855,47 @@ class Heap {
   // collection.
   void GrowForUtilization(collector::GarbageCollector* collector_ran);
 
+  // The optional pause time sizing policy: scales the free space of target_size to meet the GC
+  // time target and the pause target, and prefers sticky GCs when only they meet the pause
+  // target. Returns the adjusted target size.
+  uint64_t ApplyGcTargets(collector::GarbageCollector* collector_ran, uint64_t bytes_allocated,
+                          uint64_t target_size, uint64_t gc_interval_ns);
+
+  // Visit the objects of the allocation stack and of the bump pointer space, which are live but
+  // not marked in the live bitmap.
+  void VisitObjectsOutsideLiveBitmap(ObjectCallback callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Visit the objects of the live bitmap with copies of visitor, one for each bitmap range, which
+  // are returned in range_visitors in address order. The ranges are split over the heap thread
+  // pool if use_thread_pool and there is one.
+  template <typename Visitor>
+  void VisitLiveBitmapRanges(const Visitor& visitor, bool use_thread_pool,
+                             std::vector<Visitor>* range_visitors)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Visit the objects of the live bitmap with copies of the verification visitor, one for each
+  // bitmap range. The ranges are split over the heap thread pool if there is one. Returns false
+  // if any of the copies failed.
+  template <typename Visitor>
+  bool VerifyLiveBitmap(const Visitor& visitor)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Claims the heap thread pool for a walk of the heap outside of a collection, by pretending to
+  // run one as the heap trim does. Returns false, without waiting, if a collection is running or
+  // there is no thread pool; the walk is then serial. A claim is released with FinishGC.
+  bool TryStartParallelHeapWalk(Thread* self) LOCKS_EXCLUDED(gc_complete_lock_);
+
+  // Returns mean moved towards value by weight, or value for the first value.
+  static double DecayingMean(double mean, double value, double weight);
+
+  // Update the bytes freed per ms of pause of the GC type which just ran.
+  void RecordGcTypeEfficiency(collector::GarbageCollector* collector_ran);
+  // Choose the GC type which recently freed the most bytes per ms of pause among the types of
+  // the current collector, retrying the types which have not run for a while.
+  collector::GcType SelectNextGcType(uint64_t bytes_allocated);
+
   size_t GetPercentFree();
 
   static void VerificationCallback(mirror::Object* obj, void* arg)
@@ -722,6 +944,10 @@ class Heap {
   // space is typically either the dlmalloc_space_ or the rosalloc_space_.
   space::MallocSpace* main_space_;
 
+  // Empty space of the same type as the main space which the main space is compacted into by
+  // PerformHomogeneousSpaceCompact, null if homogeneous space compaction is not supported.
+  UniquePtr<space::MallocSpace> main_space_backup_;
+
   // The large object space we are currently allocating into.
   space::LargeObjectSpace* large_object_space_;
 
@@ -751,6 +977,32 @@ class Heap {
   uint64_t heap_transition_target_time_ GUARDED_BY(heap_trim_request_lock_);
   // If we have a heap trim request pending.
   bool heap_trim_request_pending_ GUARDED_BY(heap_trim_request_lock_);
+  // Statistics of the managed heap trim slices.
+  uint64_t heap_trim_slices_ GUARDED_BY(heap_trim_request_lock_);
+  uint64_t heap_trim_bytes_released_ GUARDED_BY(heap_trim_request_lock_);
+  uint64_t heap_trim_max_slice_bytes_ GUARDED_BY(heap_trim_request_lock_);
+  // Statistics of the homogeneous space compactions.
+  size_t homogeneous_space_compactions_ GUARDED_BY(gc_complete_lock_);
+  uint64_t last_homogeneous_space_compaction_time_ GUARDED_BY(gc_complete_lock_);
+
+  // Statistics of the collections run for a cause and of the waits of the mutators for a
+  // collection with that cause, which tell the GC pauses from the allocation stalls.
+  struct GcCauseStats {
+    GcCauseStats();
+
+    uint64_t collections;
+    uint64_t total_duration_ns;
+    uint64_t total_paused_ns;
+    Histogram<uint64_t> duration_histogram;
+    Histogram<uint64_t> pause_histogram;
+    uint64_t waits;
+    uint64_t total_wait_ns;
+  };
+  GcCauseStats gc_cause_stats_[kGcCauseMax] GUARDED_BY(gc_complete_lock_);
+  // Allocations which waited for, or ran, a GC before they could succeed.
+  uint64_t allocation_stalls_ GUARDED_BY(gc_complete_lock_);
+  uint64_t total_allocation_stall_ns_ GUARDED_BY(gc_complete_lock_);
+  Histogram<uint64_t> allocation_stall_histogram_ GUARDED_BY(gc_complete_lock_);
 
   // How many GC threads we may use for paused parts of garbage collection.
   const size_t parallel_gc_threads_;
@@ -758,6 +1010,9 @@ class Heap {
   // How many GC threads we may use for unpaused parts of garbage collection.
   const size_t conc_gc_threads_;
 
+  // Whether the GC threads are pinned to NUMA nodes and prefer the work of their node.
+  const bool numa_aware_gc_threads_;
+
   // Boolean for if we are in low memory mode.
   const bool low_memory_mode_;
 
@@ -793,6 +1048,22 @@ class Heap {
   volatile collector::GcType last_gc_type_ GUARDED_BY(gc_complete_lock_);
   collector::GcType next_gc_type_;
 
+  // What each GC type frees per ms of pause. Only written by the thread which is running the GC,
+  // DumpGcPerformanceInfo reads it racily.
+  struct GcTypeEfficiency {
+    // Decaying mean of the bytes freed per ms of pause.
+    double bytes_freed_per_pause_ms;
+    size_t samples;
+    // How many times the type was chosen as the next GC type.
+    size_t selections;
+    // Collections since the type last ran.
+    size_t collections_since_run;
+  };
+  GcTypeEfficiency gc_type_efficiency_[collector::kGcTypeMax];
+  // Ring buffer of the last choices of SelectNextGcType.
+  collector::GcType gc_type_selection_history_[kGcTypeSelectionHistorySize];
+  size_t gc_type_selections_;
+
   // Maximum size that the heap can reach.
   const size_t capacity_;
 
@@ -813,6 +1084,20 @@ class Heap {
   // Whether or not we need to run finalizers in the next native allocation.
   bool native_need_to_run_finalization_;
 
+  // Whether concurrent GCs are requested in proportion to the growth of the native bytes, and
+  // native allocations over native_footprint_limit_ only block in a GC and finalization once per
+  // kMinNativeBlockingGcInterval. Finalizers are otherwise left to the finalizer daemon.
+  const bool native_allocation_pacing_;
+
+  // With native allocation pacing, the native bytes at which the next concurrent GC is requested,
+  // how much they grow between two requests, and when a native allocation last blocked.
+  size_t native_pacing_next_gc_;
+  size_t native_pacing_step_;
+  uint64_t last_native_blocking_gc_time_ns_;
+
+  Atomic<size_t> native_alloc_gc_count_;
+  Atomic<size_t> native_alloc_blocking_gc_count_;
+
   // Whether or not we currently care about pause times.
   ProcessState process_state_;
 
@@ -874,6 +1159,14 @@ class Heap {
 
   // Parallel GC data structures.
   UniquePtr<ThreadPool> thread_pool_;
+  UniquePtr<WorkStealingThreadPool> work_stealing_thread_pool_;
+
+  // Allocation site survival feedback for pretenuring.
+  UniquePtr<AllocationSiteTable> allocation_site_table_;
+
+  // Sampled allocations and their stacks, and where DumpAllocationSamples writes them.
+  UniquePtr<AllocationSampler> allocation_sampler_;
+  const std::string allocation_sample_file_;
 
   // The nanosecond time at which the last GC ended.
   uint64_t last_gc_time_ns_;
@@ -885,6 +1178,11 @@ class Heap {
   // and the start of the current one.
   uint64_t allocation_rate_;
 
+  // Decaying means of allocation_rate_ and of the GC durations, which forecast when to start the
+  // next concurrent GC, see GrowForUtilization.
+  double mean_allocation_rate_;
+  double mean_gc_duration_ns_;
+
   // For a GC cycle, a bitmap that is set corresponding to the
   UniquePtr<accounting::HeapBitmap> live_bitmap_ GUARDED_BY(Locks::heap_bitmap_lock_);
   UniquePtr<accounting::HeapBitmap> mark_bitmap_ GUARDED_BY(Locks::heap_bitmap_lock_);
@@ -925,6 +1223,14 @@ class Heap {
   // How much more we grow the heap when we are a foreground app instead of background.
   double foreground_heap_growth_multiplier_;
 
+  // Targets of the optional pause time sizing policy, zero when unset: the longest acceptable
+  // pause in nanoseconds and the percentage of the wall time which may be spent in GC.
+  const size_t pause_time_target_;
+  const double gc_time_percent_target_;
+
+  // Smoothed fraction of the wall time spent in GC, measured between the ends of two GCs.
+  double gc_time_ratio_;
+
   // Total time which mutators are paused or waiting for GC to complete.
   uint64_t total_wait_time_;
 
@@ -943,7 +1249,10 @@ class Heap {
 
   const bool running_on_valgrind_;
   const bool use_tlab_;
+  // Number of RosAlloc size brackets which use thread-local runs.
+  const size_t rosalloc_thread_local_brackets_;
 
+  friend class collector::ConcurrentCopying;
   friend class collector::GarbageCollector;
   friend class collector::MarkSweep;
   friend class collector::SemiSpace;
@@ -17,6 +17,7 @@
 #include "common_runtime_test.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "mirror/array-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
@@ -58,6 +59,100 @@ TEST_F(HeapTest, GarbageCollectClassLinkerInit) {
   Runtime::Current()->GetHeap()->CollectGarbage(false);
 }
 
+TEST_F(HeapTest, BytesAllocatedByThread) {
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  Heap* heap = Runtime::Current()->GetHeap();
+  heap->RevokeThreadLocalBuffers(self);
+  const uint64_t thread_bytes_before = heap->GetBytesAllocatedByThread(self);
+  const size_t heap_bytes_before = heap->GetBytesAllocated();
+  // Fewer bytes than a thread may allocate before the heap counts them.
+  SirtRef<mirror::ByteArray> small(self, mirror::ByteArray::Alloc(self, 100));
+  ASSERT_TRUE(small.get() != nullptr);
+  const size_t small_size = small->SizeOf();
+  EXPECT_GE(heap->GetBytesAllocatedByThread(self), thread_bytes_before + small_size);
+  // Flushing the thread's bytes makes the heap count them.
+  heap->RevokeThreadLocalBuffers(self);
+  EXPECT_GE(heap->GetBytesAllocated(), heap_bytes_before + small_size);
+  // The thread counts the bytes it allocates whether the heap does yet or not.
+  size_t allocated_size = 0;
+  while (allocated_size < 2 * Heap::kMaxUnflushedAllocatedBytes) {
+    mirror::ByteArray* array = mirror::ByteArray::Alloc(self, 1000);
+    ASSERT_TRUE(array != nullptr);
+    allocated_size += array->SizeOf();
+  }
+  EXPECT_GE(heap->GetBytesAllocatedByThread(self),
+            thread_bytes_before + small_size + allocated_size);
+}
+
+TEST_F(HeapTest, InstanceQueries) {
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  Heap* heap = Runtime::Current()->GetHeap();
+  static const size_t kNumInstances = 100;
+  SirtRef<mirror::Class> holder_class(self, class_linker_->FindSystemClass(self,
+                                                                           "[Ljava/lang/Object;"));
+  SirtRef<mirror::Class> instance_class(
+      self, class_linker_->FindSystemClass(self, "[Ljava/lang/Runnable;"));
+  ASSERT_TRUE(holder_class.get() != nullptr);
+  ASSERT_TRUE(instance_class.get() != nullptr);
+  std::vector<mirror::Class*> classes;
+  classes.push_back(instance_class.get());
+  heap->CollectGarbage(false);
+  uint64_t count_before = 0;
+  heap->CountInstances(classes, false, &count_before);
+  SirtRef<mirror::ObjectArray<mirror::Object> > holder(self,
+      mirror::ObjectArray<mirror::Object>::Alloc(self, holder_class.get(), kNumInstances));
+  ASSERT_TRUE(holder.get() != nullptr);
+  for (size_t i = 0; i < kNumInstances; ++i) {
+    if (i == kNumInstances / 2) {
+      // The first instances move from the allocation stack to the live bitmap, the others stay.
+      heap->CollectGarbage(false);
+    }
+    mirror::Object* instance = mirror::ObjectArray<mirror::Object>::Alloc(self,
+                                                                          instance_class.get(), 1);
+    ASSERT_TRUE(instance != nullptr);
+    holder->Set<false>(i, instance);
+  }
+  uint64_t count = 0;
+  heap->CountInstances(classes, false, &count);
+  EXPECT_EQ(count_before + kNumInstances, count);
+
+  std::vector<mirror::Object*> instances;
+  heap->GetInstances(instance_class.get(), 0, instances);
+  EXPECT_EQ(count, instances.size());
+  for (size_t i = 0; i < kNumInstances; ++i) {
+    EXPECT_NE(std::find(instances.begin(), instances.end(), holder->Get(i)), instances.end());
+  }
+  instances.clear();
+  heap->GetInstances(instance_class.get(), 3, instances);
+  EXPECT_EQ(3U, instances.size());
+
+  std::vector<mirror::Object*> referring_objects;
+  heap->GetReferringObjects(holder->Get(kNumInstances - 1), 0, referring_objects);
+  ASSERT_EQ(1U, referring_objects.size());
+  EXPECT_EQ(holder.get(), referring_objects[0]);
+}
+
+TEST_F(HeapTest, GcCauseStats) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  const size_t explicit_stats = kGcCauseExplicit * Heap::kGcCauseStatsFields;
+  uint64_t before[Heap::kGcCauseStatsLength];
+  heap->GetGcCauseStats(before);
+  heap->CollectGarbage(false);
+  uint64_t after[Heap::kGcCauseStatsLength];
+  heap->GetGcCauseStats(after);
+  EXPECT_EQ(before[explicit_stats] + 1, after[explicit_stats]);
+  EXPECT_GT(after[explicit_stats + 1], before[explicit_stats + 1]);
+  EXPECT_GE(after[explicit_stats + 1], after[explicit_stats + 2]);
+  // The other causes didn't run a collection.
+  for (size_t i = 0; i < kGcCauseMax; ++i) {
+    if (i != kGcCauseExplicit) {
+      EXPECT_EQ(before[i * Heap::kGcCauseStatsFields], after[i * Heap::kGcCauseStatsFields]);
+    }
+  }
+}
+
 TEST_F(HeapTest, HeapBitmapCapacityTest) {
   byte* heap_begin = reinterpret_cast<byte*>(0x1000);
   const size_t heap_capacity = kObjectAlignment * (sizeof(intptr_t) * 8 + 1);
@@ -16,6 +16,11 @@
 
 #include "reference_processor.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "gc/heap.h"
+#include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/reference-inl.h"
 #include "reflection.h"
@@ -27,9 +32,12 @@ namespace art {
 namespace gc {
 
 ReferenceProcessor::ReferenceProcessor()
-    : process_references_args_(nullptr, nullptr, nullptr), slow_path_enabled_(false),
+    : process_references_args_(this, nullptr, nullptr, nullptr), slow_path_enabled_(false),
       preserving_references_(false), lock_("reference processor lock", kReferenceProcessorLock),
-      condition_("reference processor condition", lock_) {
+      condition_("reference processor condition", lock_),
+      soft_reference_clock_ms_(static_cast<uint32_t>(NsToMs(NanoTime()))),
+      soft_reference_ms_per_mb_(kDefaultSoftReferenceMsPerMb), finalizers_enqueued_(0) {
+  memset(soft_reference_accesses_, 0, sizeof(soft_reference_accesses_));
 }
 
 void ReferenceProcessor::EnableSlowPath() {
@@ -47,6 +55,9 @@ void ReferenceProcessor::DisableSlowPath(Thread* self) {
 
 mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference* reference) {
   mirror::Object* const referent = reference->GetReferent();
+  if (referent != nullptr && reference->GetClass()->IsSoftReferenceClass()) {
+    RecordSoftReferenceAccess(reference);
+  }
   if (LIKELY(!slow_path_enabled_)) {
     return referent;
   }
@@ -76,12 +87,45 @@ mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference*
   return reference->GetReferent();
 }
 
-mirror::Object* ReferenceProcessor::PreserveSoftReferenceCallback(mirror::Object* obj, void* arg) {
+mirror::Object* ReferenceProcessor::PreserveSoftReferenceCallback(mirror::Reference* ref,
+                                                                  mirror::Object* obj, void* arg) {
   auto* const args = reinterpret_cast<ProcessReferencesArgs*>(arg);
-  // TODO: Not preserve all soft references.
+  mirror::Object* const forward_address = args->is_marked_callback_(obj, args->arg_);
+  if (forward_address != nullptr) {
+    return forward_address;
+  }
+  if (!args->processor_->ShouldPreserveSoftReference(ref, args->now_ms_,
+                                                     args->max_soft_reference_age_ms_)) {
+    return nullptr;
+  }
   return args->mark_callback_(obj, args->arg_);
 }
 
+bool ReferenceProcessor::ShouldPreserveSoftReference(mirror::Reference* ref, uint32_t now_ms,
+                                                     uint32_t max_age_ms) {
+  const uint32_t tag = SoftReferenceTag(ref);
+  uint64_t* const entry = &soft_reference_accesses_[tag % kNumSoftReferenceAccesses];
+  const uint64_t access = *entry;
+  if (static_cast<uint32_t>(access >> 32) != tag) {
+    // Not dereferenced since it was allocated or moved, or another reference took the entry. Start
+    // aging it from now rather than clearing a reference which may be in use.
+    *entry = (static_cast<uint64_t>(tag) << 32) | soft_reference_clock_ms_;
+    return true;
+  }
+  // Unsigned arithmetic handles the wrap around of the millisecond clock.
+  const uint32_t age_ms = now_ms - static_cast<uint32_t>(access);
+  return age_ms <= max_age_ms;
+}
+
+uint32_t ReferenceProcessor::MaxSoftReferenceAgeMs() const {
+  Heap* const heap = Runtime::Current()->GetHeap();
+  const size_t max_memory = heap->GetMaxMemory();
+  const size_t free_mb = (max_memory - std::min(max_memory, heap->GetBytesAllocated())) / MB;
+  const uint64_t max_age_ms = static_cast<uint64_t>(free_mb) * soft_reference_ms_per_mb_;
+  return static_cast<uint32_t>(std::min<uint64_t>(max_age_ms,
+                                                  std::numeric_limits<uint32_t>::max()));
+}
+
 void ReferenceProcessor::StartPreservingReferences(Thread* self) {
   MutexLock mu(self, lock_);
   preserving_references_ = true;
@@ -115,10 +159,16 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
   } else {
     timings->StartSplit("(Paused)ProcessReferences");
   }
-  // Unless required to clear soft references with white references, preserve some white referents.
+  // Unless required to clear soft references with white references, preserve the white referents
+  // which were used recently.
   if (!clear_soft_references) {
     TimingLogger::ScopedSplit split(concurrent ? "PreserveSomeSoftReferences" :
         "(Paused)PreserveSomeSoftReferences", timings);
+    {
+      MutexLock mu(self, lock_);
+      process_references_args_.now_ms_ = static_cast<uint32_t>(NsToMs(NanoTime()));
+      process_references_args_.max_soft_reference_age_ms_ = MaxSoftReferenceAgeMs();
+    }
     if (concurrent) {
       StartPreservingReferences(self);
     }
@@ -141,8 +191,10 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
       StartPreservingReferences(self);
     }
     // Preserve all white objects with finalize methods and schedule them for finalization.
-    finalizer_reference_queue_.EnqueueFinalizerReferences(cleared_references_, is_marked_callback,
-                                                          mark_object_callback, arg);
+    finalizers_enqueued_ +=
+        finalizer_reference_queue_.EnqueueFinalizerReferences(cleared_references_,
+                                                              is_marked_callback,
+                                                              mark_object_callback, arg);
     process_mark_stack_callback(arg);
     if (concurrent) {
       StopPreservingReferences(self);
@@ -163,6 +215,7 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     // Done processing, disable the slow path and broadcast to the waiters.
     DisableSlowPath(self);
   }
+  soft_reference_clock_ms_ = static_cast<uint32_t>(NsToMs(NanoTime()));
   timings->EndSplit();
 }
 
@@ -172,13 +225,12 @@ void ReferenceProcessor::DelayReferenceReferent(mirror::Class* klass, mirror::Re
                                                 IsMarkedCallback is_marked_callback, void* arg) {
   // klass can be the class of the old object if the visitor already updated the class of ref.
   DCHECK(klass->IsReferenceClass());
-  mirror::Object* referent = ref->GetReferent();
+  mirror::Object* referent = ref->GetReferent<kWithoutReadBarrier>();
   if (referent != nullptr) {
     mirror::Object* forward_address = is_marked_callback(referent, arg);
     // Null means that the object is not currently marked.
     if (forward_address == nullptr) {
       Thread* self = Thread::Current();
-      // TODO: Remove these locks, and use atomic stacks for storing references?
       // We need to check that the references haven't already been enqueued since we can end up
       // scanning the same reference multiple times due to dirty cards.
       if (klass->IsSoftReferenceClass()) {
@@ -40,7 +40,9 @@ class Heap;
 class ReferenceProcessor {
  public:
   explicit ReferenceProcessor();
-  static mirror::Object* PreserveSoftReferenceCallback(mirror::Object* obj, void* arg);
+  static mirror::Object* PreserveSoftReferenceCallback(mirror::Reference* ref,
+                                                       mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void ProcessReferences(bool concurrent, TimingLogger* timings, bool clear_soft_references,
                          IsMarkedCallback* is_marked_callback,
                          MarkObjectCallback* mark_object_callback,
@@ -55,23 +57,57 @@ class ReferenceProcessor {
   mirror::Object* GetReferent(Thread* self, mirror::Reference* reference)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
   void EnqueueClearedReferences() LOCKS_EXCLUDED(Locks::mutator_lock_);
+  // The number of objects scheduled for finalization since the runtime started.
+  uint64_t GetFinalizersEnqueued() const {
+    return finalizers_enqueued_;
+  }
   void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* ref,
                               IsMarkedCallback is_marked_callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Softly reachable referents are kept if their reference was dereferenced within the last
+  // ms_per_mb milliseconds per free megabyte of heap, the -XX:SoftRefLRUPolicyMSPerMB policy.
+  void SetSoftReferenceLruPolicy(size_t ms_per_mb) {
+    soft_reference_ms_per_mb_ = ms_per_mb;
+  }
+
+  static constexpr size_t kDefaultSoftReferenceMsPerMb = 1000;
+  // Number of soft reference access times tracked, references which hash alike share an entry.
+  static constexpr size_t kNumSoftReferenceAccesses = 4096;
 
  private:
   class ProcessReferencesArgs {
    public:
-    ProcessReferencesArgs(IsMarkedCallback* is_marked_callback,
+    ProcessReferencesArgs(ReferenceProcessor* processor, IsMarkedCallback* is_marked_callback,
                           MarkObjectCallback* mark_callback, void* arg)
-        : is_marked_callback_(is_marked_callback), mark_callback_(mark_callback), arg_(arg) {
+        : processor_(processor), is_marked_callback_(is_marked_callback),
+          mark_callback_(mark_callback), arg_(arg), now_ms_(0), max_soft_reference_age_ms_(0) {
     }
 
+    ReferenceProcessor* const processor_;
     // The is marked callback is null when the args aren't set up.
     IsMarkedCallback* is_marked_callback_;
     MarkObjectCallback* mark_callback_;
     void* arg_;
+    // Used by PreserveSoftReferenceCallback.
+    uint32_t now_ms_;
+    uint32_t max_soft_reference_age_ms_;
   };
+  // An access entry holds the tag of the reference in its high half and the soft reference clock
+  // of the access in its low half.
+  static uint32_t SoftReferenceTag(mirror::Reference* ref) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ref) / kObjectAlignment);
+  }
+  // Called by GetReferent, does not lock since a torn or lost update can only make a soft
+  // reference look older or younger than it is.
+  void RecordSoftReferenceAccess(mirror::Reference* ref) {
+    const uint32_t tag = SoftReferenceTag(ref);
+    soft_reference_accesses_[tag % kNumSoftReferenceAccesses] =
+        (static_cast<uint64_t>(tag) << 32) | soft_reference_clock_ms_;
+  }
+  // Whether the white referent of ref was used recently enough to be kept.
+  bool ShouldPreserveSoftReference(mirror::Reference* ref, uint32_t now_ms, uint32_t max_age_ms);
+  // The largest age in milliseconds of the soft references to preserve, given the free heap.
+  uint32_t MaxSoftReferenceAgeMs() const;
   // Called by ProcessReferences.
   void DisableSlowPath(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(lock_);
   // If we are preserving references it means that some dead objects may become live, we use start
@@ -97,6 +133,14 @@ class ReferenceProcessor {
   ReferenceQueue finalizer_reference_queue_;
   ReferenceQueue phantom_reference_queue_;
   ReferenceQueue cleared_references_;
+  // Time in milliseconds of the end of the last reference processing, accesses are stamped with
+  // it so that GetReferent does not need to read the clock.
+  volatile uint32_t soft_reference_clock_ms_;
+  size_t soft_reference_ms_per_mb_;
+  // The last access of the soft references, written without a lock by the mutators.
+  uint64_t soft_reference_accesses_[kNumSoftReferenceAccesses];
+  // Only written by reference processing, which a single collector thread does at a time.
+  uint64_t finalizers_enqueued_;
 };
 
 }  // namespace gc
@@ -27,14 +27,40 @@ namespace gc {
 
 ReferenceQueue::ReferenceQueue()
     : lock_("reference queue lock"),
-      list_(nullptr) {
+      list_(nullptr),
+      atomic_list_(nullptr) {
 }
 
 void ReferenceQueue::AtomicEnqueueIfNotEnqueued(Thread* self, mirror::Reference* ref) {
   DCHECK(ref != NULL);
-  MutexLock mu(self, lock_);
-  if (!ref->IsEnqueued()) {
+  if (UNLIKELY(Runtime::Current()->IsActiveTransaction())) {
+    MutexLock mu(self, lock_);
+    if (!ref->IsEnqueued()) {
+      EnqueuePendingReference(ref);
+    }
+    return;
+  }
+  // Only the thread which sets the pending next first enqueues the reference.
+  if (!ref->CasPendingNext(nullptr, ref)) {
+    return;
+  }
+  mirror::Reference* head;
+  do {
+    head = atomic_list_.Load();
+    ref->SetPendingNext<false>(head != nullptr ? head : ref);
+  } while (!atomic_list_.CompareAndSwap(head, ref));
+}
+
+void ReferenceQueue::MergeAtomicList() {
+  mirror::Reference* ref = atomic_list_.Load();
+  if (ref == nullptr) {
+    return;
+  }
+  atomic_list_ = nullptr;
+  while (ref != nullptr) {
+    mirror::Reference* next = ref->GetPendingNext();
     EnqueuePendingReference(ref);
+    ref = next != ref ? next : nullptr;
   }
 }
 
@@ -65,6 +91,7 @@ void ReferenceQueue::EnqueuePendingReference(mirror::Reference* ref) {
 
 mirror::Reference* ReferenceQueue::DequeuePendingReference() {
   DCHECK(!IsEmpty());
+  MergeAtomicList();
   mirror::Reference* head = list_->GetPendingNext();
   DCHECK(head != nullptr);
   mirror::Reference* ref;
@@ -109,7 +136,7 @@ void ReferenceQueue::ClearWhiteReferences(ReferenceQueue& cleared_references,
                                           void* arg) {
   while (!IsEmpty()) {
     mirror::Reference* ref = DequeuePendingReference();
-    mirror::Object* referent = ref->GetReferent();
+    mirror::Object* referent = ref->GetReferent<kWithoutReadBarrier>();
     if (referent != nullptr) {
       mirror::Object* forward_address = preserve_callback(referent, arg);
       if (forward_address == nullptr) {
@@ -130,13 +157,14 @@ void ReferenceQueue::ClearWhiteReferences(ReferenceQueue& cleared_references,
   }
 }
 
-void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue& cleared_references,
-                                                IsMarkedCallback* is_marked_callback,
-                                                MarkObjectCallback* mark_object_callback,
-                                                void* arg) {
+size_t ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue& cleared_references,
+                                                  IsMarkedCallback* is_marked_callback,
+                                                  MarkObjectCallback* mark_object_callback,
+                                                  void* arg) {
+  size_t enqueued = 0;
   while (!IsEmpty()) {
     mirror::FinalizerReference* ref = DequeuePendingReference()->AsFinalizerReference();
-    mirror::Object* referent = ref->GetReferent();
+    mirror::Object* referent = ref->GetReferent<kWithoutReadBarrier>();
     if (referent != nullptr) {
       mirror::Object* forward_address = is_marked_callback(referent, arg);
       // If the referent isn't marked, mark it and update the
@@ -153,20 +181,23 @@ void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue& cleared_referenc
           ref->ClearReferent<false>();
         }
         cleared_references.EnqueueReference(ref);
+        ++enqueued;
       } else if (referent != forward_address) {
         ref->SetReferent<false>(forward_address);
       }
     }
   }
+  return enqueued;
 }
 
-void ReferenceQueue::PreserveSomeSoftReferences(IsMarkedCallback* preserve_callback, void* arg) {
+void ReferenceQueue::PreserveSomeSoftReferences(PreserveReferenceCallback* preserve_callback,
+                                                void* arg) {
   ReferenceQueue cleared;
   while (!IsEmpty()) {
     mirror::Reference* ref = DequeuePendingReference();
-    mirror::Object* referent = ref->GetReferent();
+    mirror::Object* referent = ref->GetReferent<kWithoutReadBarrier>();
     if (referent != nullptr) {
-      mirror::Object* forward_address = preserve_callback(referent, arg);
+      mirror::Object* forward_address = preserve_callback(ref, referent, arg);
       if (forward_address == nullptr) {
         // Either the reference isn't marked or we don't wish to preserve it.
         cleared.EnqueuePendingReference(ref);
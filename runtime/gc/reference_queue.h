@@ -39,6 +39,11 @@ namespace gc {
 
 class Heap;
 
+// Decides whether the white referent of a soft reference is kept, returns the new address of the
+// referent if it is marked or preserved, null if it may be cleared.
+typedef mirror::Object* (PreserveReferenceCallback)(mirror::Reference* ref,
+                                                    mirror::Object* referent, void* arg);
+
 // Used to temporarily store java.lang.ref.Reference(s) during GC and prior to queueing on the
 // appropriate java.lang.ref.ReferenceQueue. The linked list is maintained in the
 // java.lang.ref.Reference objects.
@@ -46,8 +51,9 @@ class ReferenceQueue {
  public:
   explicit ReferenceQueue();
   // Enqueue a reference if is not already enqueued. Thread safe to call from multiple threads
-  // since it uses a lock to avoid a race between checking for the references presence and adding
-  // it.
+  // without locking: the reference is claimed with a CAS of its pending next field and pushed on
+  // a lock-free stack, which is merged into the list once marking is done. The lock is only used
+  // during transactions, since the CAS is not recorded by the transaction.
   void AtomicEnqueueIfNotEnqueued(Thread* self, mirror::Reference* ref)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
   // Enqueue a reference, unlike EnqueuePendingReference, enqueue reference checks that the
@@ -57,15 +63,15 @@ class ReferenceQueue {
   void EnqueuePendingReference(mirror::Reference* ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::Reference* DequeuePendingReference() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Enqueues finalizer references with white referents.  White referents are blackened, moved to the
-  // zombie field, and the referent field is cleared.
-  void EnqueueFinalizerReferences(ReferenceQueue& cleared_references,
-                                  IsMarkedCallback* is_marked_callback,
-                                  MarkObjectCallback* mark_object_callback, void* arg)
+  // zombie field, and the referent field is cleared. Returns the number of references enqueued.
+  size_t EnqueueFinalizerReferences(ReferenceQueue& cleared_references,
+                                    IsMarkedCallback* is_marked_callback,
+                                    MarkObjectCallback* mark_object_callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Walks the reference list marking any references subject to the reference clearing policy.
   // References with a black referent are removed from the list.  References with white referents
   // biased toward saving are blackened and also removed from the list.
-  void PreserveSomeSoftReferences(IsMarkedCallback* preserve_callback, void* arg)
+  void PreserveSomeSoftReferences(PreserveReferenceCallback* preserve_callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Unlink the reference list clearing references objects with white referents.  Cleared references
   // registered to a reference queue are scheduled for appending by the heap worker thread.
@@ -76,21 +82,30 @@ class ReferenceQueue {
   void Dump(std::ostream& os) const
         SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool IsEmpty() const {
-    return list_ == nullptr;
+    return list_ == nullptr && atomic_list_.Load() == nullptr;
   }
   void Clear() {
+    DCHECK(atomic_list_.Load() == nullptr);
     list_ = nullptr;
   }
   mirror::Reference* GetList() {
+    DCHECK(atomic_list_.Load() == nullptr);
     return list_;
   }
 
  private:
-  // Lock, used for parallel GC reference enqueuing. It allows for multiple threads simultaneously
-  // calling AtomicEnqueueIfNotEnqueued.
+  // Move the references pushed by AtomicEnqueueIfNotEnqueued to the list. Not thread safe, only
+  // called by the methods which run once marking is done.
+  void MergeAtomicList() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Lock, used for parallel GC reference enqueuing during transactions.
   Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   // The actual reference list. Not a root since it will be nullptr when the GC is not running.
   mirror::Reference* list_;
+  // Lock-free stack of the references pushed by AtomicEnqueueIfNotEnqueued, linked through their
+  // pending next fields. The last reference of the stack points to itself so that all of them
+  // are seen as enqueued.
+  Atomic<mirror::Reference*> atomic_list_;
 };
 
 }  // namespace gc
@@ -46,7 +46,7 @@ BumpPointerSpace::BumpPointerSpace(const std::string& name, byte* begin, byte* l
     : ContinuousMemMapAllocSpace(name, nullptr, begin, begin, limit,
                                  kGcRetentionPolicyAlwaysCollect),
       growth_end_(limit),
-      objects_allocated_(0), bytes_allocated_(0),
+      objects_allocated_(0), bytes_allocated_(0), tlab_bytes_wasted_(0),
       block_lock_("Block lock"),
       main_block_size_(0),
       num_blocks_(0) {
@@ -56,7 +56,7 @@ BumpPointerSpace::BumpPointerSpace(const std::string& name, MemMap* mem_map)
     : ContinuousMemMapAllocSpace(name, mem_map, mem_map->Begin(), mem_map->Begin(), mem_map->End(),
                                  kGcRetentionPolicyAlwaysCollect),
       growth_end_(mem_map->End()),
-      objects_allocated_(0), bytes_allocated_(0),
+      objects_allocated_(0), bytes_allocated_(0), tlab_bytes_wasted_(0),
       block_lock_("Block lock"),
       main_block_size_(0),
       num_blocks_(0) {
@@ -91,6 +91,10 @@ mirror::Object* BumpPointerSpace::GetNextObject(mirror::Object* obj) {
 
 void BumpPointerSpace::RevokeThreadLocalBuffers(Thread* thread) {
   MutexLock mu(Thread::Current(), block_lock_);
+  if (thread->HasTlab() && thread->TlabSize() > thread->GetThreadLocalBytesAllocated()) {
+    // Most of the buffer is still unused, the thread allocates slower than its TLAB size assumes.
+    thread->SetTlabSizeHint(std::max(thread->GetTlabSizeHint() / 2, kMinTlabSize));
+  }
   RevokeThreadLocalBuffersLocked(thread);
 }
 
@@ -241,6 +245,7 @@ uint64_t BumpPointerSpace::GetObjectsAllocated() {
 void BumpPointerSpace::RevokeThreadLocalBuffersLocked(Thread* thread) {
   objects_allocated_.FetchAndAdd(thread->GetThreadLocalObjectsAllocated());
   bytes_allocated_.FetchAndAdd(thread->GetThreadLocalBytesAllocated());
+  tlab_bytes_wasted_.FetchAndAdd(thread->TlabSize());
   thread->SetTlab(nullptr, nullptr);
 }
 
@@ -255,6 +260,24 @@ bool BumpPointerSpace::AllocNewTlab(Thread* self, size_t bytes) {
   return true;
 }
 
+size_t BumpPointerSpace::NextTlabSize(Thread* self) {
+  size_t size = self->GetTlabSizeHint();
+  if (size == 0) {
+    size = kMinTlabSize;
+  } else if (self->HasTlab()) {
+    // The thread used up its TLAB, as opposed to having it revoked by the GC.
+    size = std::min(size * 2, kMaxTlabSize);
+  }
+  self->SetTlabSizeHint(size);
+  return size;
+}
+
+size_t BumpPointerSpace::GetAndResetTlabBytesWasted() {
+  const size_t wasted = tlab_bytes_wasted_.Load();
+  tlab_bytes_wasted_.FetchAndSub(wasted);
+  return wasted;
+}
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
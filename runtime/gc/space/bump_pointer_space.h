@@ -135,6 +135,13 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   // Allocate a new TLAB, returns false if the allocation failed.
   bool AllocNewTlab(Thread* self, size_t bytes);
 
+  // Returns the size of the next TLAB of self. A thread which used up its TLAB gets one twice as
+  // big, up to kMaxTlabSize. The size is halved again when a TLAB is revoked mostly unused.
+  static size_t NextTlabSize(Thread* self);
+
+  // Returns the bytes left unused in the TLABs revoked since the previous call.
+  size_t GetAndResetTlabBytesWasted();
+
   BumpPointerSpace* AsBumpPointerSpace() OVERRIDE {
     return this;
   }
@@ -147,6 +154,9 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
 
   // Object alignment within the space.
   static constexpr size_t kAlignment = 8;
+  // Bounds of the adaptive TLAB size.
+  static constexpr size_t kMinTlabSize = 16 * KB;
+  static constexpr size_t kMaxTlabSize = 1 * MB;
 
  protected:
   BumpPointerSpace(const std::string& name, MemMap* mem_map);
@@ -163,6 +173,7 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   byte* growth_end_;
   AtomicInteger objects_allocated_;  // Accumulated from revoked thread local regions.
   AtomicInteger bytes_allocated_;  // Accumulated from revoked thread local regions.
+  Atomic<size_t> tlab_bytes_wasted_;  // Unused tails of revoked thread local regions.
   Mutex block_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   // The objects at the start of the space are stored in the main block. The main block doesn't
   // have a header, this lets us walk empty spaces which are mprotected.
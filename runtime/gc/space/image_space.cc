@@ -16,9 +16,18 @@
 
 #include "image_space.h"
 
+#include <pthread.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <vector>
+
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
+#include "class_table.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "intern_table.h"
+#include "leb128.h"
 #include "mirror/art_method.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
@@ -34,9 +43,12 @@ namespace space {
 Atomic<uint32_t> ImageSpace::bitmap_index_(0);
 
 ImageSpace::ImageSpace(const std::string& image_filename, const char* image_location,
-                       MemMap* mem_map, accounting::ContinuousSpaceBitmap* live_bitmap)
+                       MemMap* mem_map, accounting::ContinuousSpaceBitmap* live_bitmap,
+                       MemMap* class_table_map, MemMap* intern_table_map)
     : MemMapSpace(image_filename, mem_map, mem_map->Begin(), mem_map->End(), mem_map->End(),
                   kGcRetentionPolicyNeverCollect),
+      class_table_map_(class_table_map),
+      intern_table_map_(intern_table_map),
       image_location_(image_location) {
   DCHECK(live_bitmap != nullptr);
   live_bitmap_.reset(live_bitmap);
@@ -144,8 +156,14 @@ ImageSpace* ImageSpace::Create(const char* image_location,
   std::string error_msg;
   bool is_system = false;
   if (FindImageFilename(image_location, image_isa, &image_filename, &is_system)) {
+    // A compressed /system image is decompressed to where a generated image would go.
+    std::string cache_filename;
+    if (is_system && Runtime::Current()->ShouldCacheDecompressedImage()) {
+      const std::string dalvik_cache = GetDalvikCacheOrDie(GetInstructionSetString(image_isa));
+      cache_filename = GetDalvikCacheFilenameOrDie(image_location, dalvik_cache.c_str());
+    }
     ImageSpace* space = ImageSpace::Init(image_filename.c_str(), image_location,
-                                         !is_system, &error_msg);
+                                         !is_system, cache_filename, &error_msg);
     if (space != nullptr) {
       return space;
     }
@@ -162,7 +180,8 @@ ImageSpace* ImageSpace::Create(const char* image_location,
 
   CHECK(GenerateImage(image_filename, &error_msg))
       << "Failed to generate image '" << image_filename << "': " << error_msg;
-  ImageSpace* space = ImageSpace::Init(image_filename.c_str(), image_location, true, &error_msg);
+  ImageSpace* space = ImageSpace::Init(image_filename.c_str(), image_location, true, "",
+                                       &error_msg);
   if (space == nullptr) {
     LOG(FATAL) << "Failed to load image '" << image_filename << "': " << error_msg;
   }
@@ -183,8 +202,399 @@ void ImageSpace::VerifyImageAllocations() {
   }
 }
 
+MemMap* ImageSpace::MapSection(int fd, size_t offset, size_t size, int prot,
+                               const char* image_filename, const char* section_name,
+                               std::string* error_msg) {
+  MemMap* map = MemMap::MapFileAtAddress(nullptr, size, prot, MAP_PRIVATE, fd, offset,
+                                         false, image_filename, error_msg);
+  if (map == nullptr) {
+    *error_msg = StringPrintf("Failed to map image %s: %s", section_name, error_msg->c_str());
+  }
+  return map;
+}
+
+// Returns a random delta to load the image and oat file at, keeping them in the low 4GB.
+static ptrdiff_t ChooseRelocationDelta(const ImageHeader& image_header, uint32_t* seed) {
+  static constexpr size_t kMaxRelocationDelta = 16 * MB;
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(image_header.GetImageBegin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(image_header.GetOatFileEnd());
+  while (true) {
+    ptrdiff_t delta = static_cast<ptrdiff_t>(rand_r(seed) % (2 * kMaxRelocationDelta / kPageSize))
+        - static_cast<ptrdiff_t>(kMaxRelocationDelta / kPageSize);
+    delta *= kPageSize;
+    if (delta != 0 && static_cast<int64_t>(begin) + delta > 0 &&
+        static_cast<int64_t>(end) + delta <= INT64_C(0x100000000)) {
+      return delta;
+    }
+  }
+}
+
+MemMap* ImageSpace::MapImage(int fd, const ImageHeader& image_header,
+                             const char* image_filename, ptrdiff_t* delta,
+                             std::string* error_msg) {
+  static constexpr size_t kMaxRelocationAttempts = 8;
+  const bool relocatable = image_header.GetRelocationsSize() != 0;
+  uint32_t seed = static_cast<uint32_t>(NanoTime()) ^ static_cast<uint32_t>(getpid());
+  for (size_t attempt = 0; ; ++attempt) {
+    ptrdiff_t attempt_delta = 0;
+    if (relocatable && (attempt != 0 || Runtime::Current()->ShouldRelocateImage())) {
+      attempt_delta = ChooseRelocationDelta(image_header, &seed);
+    }
+    // Note: The image header is part of the image due to mmap page alignment required of offset.
+    byte* image_begin = image_header.GetImageBegin() + attempt_delta;
+    UniquePtr<MemMap> map;
+    if (fd != -1) {
+      map.reset(MemMap::MapFileAtAddress(image_begin,
+                                         image_header.GetImageSize(),
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE,
+                                         fd,
+                                         0,
+                                         false,
+                                         image_filename,
+                                         error_msg));
+    } else {
+      map.reset(MemMap::MapAnonymous(image_filename, image_begin, image_header.GetImageSize(),
+                                     PROT_READ | PROT_WRITE, false, error_msg));
+    }
+    if (map.get() != nullptr) {
+      // The oat file is loaded at fixed addresses right after the image, make sure they're free.
+      byte* oat_file_begin = image_header.GetOatFileBegin() + attempt_delta;
+      UniquePtr<MemMap> oat_reservation(
+          MemMap::MapAnonymous("oat file reservation", oat_file_begin,
+                               image_header.GetOatFileEnd() - image_header.GetOatFileBegin(),
+                               PROT_NONE, false, error_msg));
+      if (oat_reservation.get() != nullptr) {
+        *delta = attempt_delta;
+        return map.release();
+      }
+    }
+    if (!relocatable || attempt == kMaxRelocationAttempts) {
+      DCHECK(!error_msg->empty());
+      return nullptr;
+    }
+    VLOG(startup) << "Relocating image " << image_filename << ": " << *error_msg;
+  }
+}
+
+// Adds delta to the 32-bit words of [begin, end) listed at *data, see
+// ImageHeader::GetRelocationsOffset. Returns false if the list is malformed.
+static bool ApplyRelocations(const uint8_t** data, const uint8_t* data_end, byte* begin,
+                             byte* end, ptrdiff_t delta) {
+  if (*data >= data_end) {
+    return false;
+  }
+  const uint32_t delta32 = static_cast<uint32_t>(delta);
+  const size_t size = end - begin;
+  uint32_t count = DecodeUnsignedLeb128(data);
+  size_t offset = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (*data >= data_end) {
+      return false;
+    }
+    offset += DecodeUnsignedLeb128(data);
+    if (size < sizeof(uint32_t) || offset > size - sizeof(uint32_t)) {
+      return false;
+    }
+    // Patched code isn't necessarily aligned.
+    uint32_t value;
+    memcpy(&value, begin + offset, sizeof(value));
+    value += delta32;
+    memcpy(begin + offset, &value, sizeof(value));
+  }
+  return true;
+}
+
+template <typename Slot>
+static void RelocateSlots(MemMap* map, ptrdiff_t delta) {
+  if (map == nullptr) {
+    return;
+  }
+  Slot* slots = reinterpret_cast<Slot*>(map->Begin());
+  Slot* slots_end = reinterpret_cast<Slot*>(map->End());
+  for (Slot* slot = slots; slot < slots_end; ++slot) {
+    uint32_t* address = reinterpret_cast<uint32_t*>(slot) + 1;
+    if (*address != 0) {
+      *address += static_cast<uint32_t>(delta);
+    }
+  }
+  CHECK(map->Protect(PROT_READ));
+}
+
+bool ImageSpace::MapImageSections(int fd, const ImageHeader& image_header,
+                                  const char* image_filename, ImageSections* sections,
+                                  ptrdiff_t* delta, std::string* error_msg) {
+  sections->image.reset(MapImage(fd, image_header, image_filename, delta, error_msg));
+  if (sections->image.get() == nullptr) {
+    DCHECK(!error_msg->empty());
+    return false;
+  }
+  sections->bitmap.reset(MapSection(fd, image_header.GetBitmapOffset(),
+                                    image_header.GetImageBitmapSize(), PROT_READ, image_filename,
+                                    "bitmap", error_msg));
+  if (sections->bitmap.get() == nullptr) {
+    return false;
+  }
+  // The table slots hold image addresses, they are written once when relocating.
+  const int table_prot = (*delta != 0) ? PROT_READ | PROT_WRITE : PROT_READ;
+  if (image_header.GetClassTableSize() != 0) {
+    sections->class_table.reset(MapSection(fd, image_header.GetClassTableOffset(),
+                                           image_header.GetClassTableSize(), table_prot,
+                                           image_filename, "class table", error_msg));
+    if (sections->class_table.get() == nullptr) {
+      return false;
+    }
+  }
+  if (image_header.GetInternTableSize() != 0) {
+    sections->intern_table.reset(MapSection(fd, image_header.GetInternTableOffset(),
+                                            image_header.GetInternTableSize(), table_prot,
+                                            image_filename, "intern table", error_msg));
+    if (sections->intern_table.get() == nullptr) {
+      return false;
+    }
+  }
+  if (*delta != 0) {
+    sections->relocations.reset(MapSection(fd, image_header.GetRelocationsOffset(),
+                                           image_header.GetRelocationsSize(), PROT_READ,
+                                           image_filename, "relocations", error_msg));
+    if (sections->relocations.get() == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The blocks of a compressed image which one thread decompresses, every stride-th one from first.
+struct ImageBlockInflation {
+  const ImageHeader::CompressedBlock* blocks;
+  const std::vector<byte*>* destinations;
+  const byte* compressed_begin;
+  size_t first;
+  size_t stride;
+  bool failed;
+};
+
+static void* InflateImageBlocks(void* arg) {
+  ImageBlockInflation* job = reinterpret_cast<ImageBlockInflation*>(arg);
+  for (size_t i = job->first; i < job->destinations->size(); i += job->stride) {
+    const ImageHeader::CompressedBlock& block = job->blocks[i];
+    uLongf size = block.size;
+    int result = uncompress((*job->destinations)[i], &size,
+                            job->compressed_begin + block.compressed_offset,
+                            block.compressed_size);
+    if (result != Z_OK || size != block.size) {
+      job->failed = true;
+      break;
+    }
+  }
+  return nullptr;
+}
+
+bool ImageSpace::DecompressImageSections(File* file, const ImageHeader& image_header,
+                                         const char* image_filename, ImageSections* sections,
+                                         ptrdiff_t* delta, std::string* error_msg) {
+  // Inflating is mostly CPU bound, a few threads keep ahead of the reads of the compressed file.
+  static constexpr size_t kMaxDecompressionThreads = 4;
+  const int64_t file_length = file->GetLength();
+  const size_t num_blocks = image_header.GetCompressedBlocks();
+  const size_t blocks_end = kPageSize + num_blocks * sizeof(ImageHeader::CompressedBlock);
+  if (file_length < static_cast<int64_t>(blocks_end) ||
+      image_header.GetImageSize() < kPageSize) {
+    *error_msg = StringPrintf("Truncated compressed image '%s'", image_filename);
+    return false;
+  }
+  UniquePtr<MemMap> compressed(MemMap::MapFile(file_length, PROT_READ, MAP_PRIVATE, file->Fd(),
+                                               0, image_filename, error_msg));
+  if (compressed.get() == nullptr) {
+    *error_msg = StringPrintf("Failed to map compressed image: %s", error_msg->c_str());
+    return false;
+  }
+
+  // The image goes at its address, the other sections in anonymous memory.
+  sections->image.reset(MapImage(-1, image_header, image_filename, delta, error_msg));
+  if (sections->image.get() == nullptr) {
+    DCHECK(!error_msg->empty());
+    return false;
+  }
+  struct Section {
+    const char* name;
+    size_t offset;
+    size_t size;
+    UniquePtr<MemMap>* map;
+  };
+  Section file_sections[] = {
+    { nullptr, 0, image_header.GetImageSize(), &sections->image },
+    { "image bitmap", image_header.GetBitmapOffset(), image_header.GetImageBitmapSize(),
+      &sections->bitmap },
+    { "image class table", image_header.GetClassTableOffset(), image_header.GetClassTableSize(),
+      &sections->class_table },
+    { "image intern table", image_header.GetInternTableOffset(),
+      image_header.GetInternTableSize(), &sections->intern_table },
+    { "image relocations", image_header.GetRelocationsOffset(),
+      image_header.GetRelocationsSize(), &sections->relocations },
+  };
+  size_t expected_size = 0;
+  for (Section& section : file_sections) {
+    if (section.map->get() == nullptr && section.size != 0) {
+      section.map->reset(MemMap::MapAnonymous(section.name, nullptr, section.size,
+                                              PROT_READ | PROT_WRITE, false, error_msg));
+      if (section.map->get() == nullptr) {
+        return false;
+      }
+    }
+    expected_size += section.size;
+  }
+
+  // The first page is stored as is, each block decompresses into the section holding it.
+  memcpy(sections->image->Begin(), compressed->Begin(), kPageSize);
+  const ImageHeader::CompressedBlock* blocks =
+      reinterpret_cast<const ImageHeader::CompressedBlock*>(compressed->Begin() + kPageSize);
+  std::vector<byte*> destinations(num_blocks, nullptr);
+  size_t decompressed_size = kPageSize;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const ImageHeader::CompressedBlock& block = blocks[i];
+    for (const Section& section : file_sections) {
+      if (block.offset >= section.offset && block.offset - section.offset < section.size &&
+          block.size <= section.size - (block.offset - section.offset)) {
+        destinations[i] = section.map->get()->Begin() + (block.offset - section.offset);
+        break;
+      }
+    }
+    if (destinations[i] == nullptr || block.compressed_offset < blocks_end ||
+        block.compressed_offset > file_length ||
+        block.compressed_size > file_length - block.compressed_offset) {
+      *error_msg = StringPrintf("Invalid compressed block %zd in image '%s'", i, image_filename);
+      return false;
+    }
+    decompressed_size += block.size;
+  }
+  if (decompressed_size != expected_size) {
+    *error_msg = StringPrintf("Compressed blocks of image '%s' hold %zd bytes rather than %zd",
+                              image_filename, decompressed_size, expected_size);
+    return false;
+  }
+
+  // Like ValidateOatFile, the threads aren't attached and the caller takes the first share.
+  const size_t num_threads = std::max<size_t>(std::min(kMaxDecompressionThreads, num_blocks), 1);
+  std::vector<ImageBlockInflation> jobs(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    jobs[i].blocks = blocks;
+    jobs[i].destinations = &destinations;
+    jobs[i].compressed_begin = compressed->Begin();
+    jobs[i].first = i;
+    jobs[i].stride = num_threads;
+    jobs[i].failed = false;
+  }
+  std::vector<pthread_t> pthreads(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i) {
+    CHECK_PTHREAD_CALL(pthread_create, (&pthreads[i - 1], nullptr, InflateImageBlocks, &jobs[i]),
+                       "image decompression thread");
+  }
+  InflateImageBlocks(&jobs[0]);
+  for (pthread_t pthread : pthreads) {
+    CHECK_PTHREAD_CALL(pthread_join, (pthread, nullptr), "image decompression thread");
+  }
+  for (const ImageBlockInflation& job : jobs) {
+    if (job.failed) {
+      *error_msg = StringPrintf("Failed to decompress image '%s'", image_filename);
+      return false;
+    }
+  }
+
+  // The sections are read only once decompressed, except for the tables which are relocated.
+  CHECK(sections->bitmap->Protect(PROT_READ));
+  if (sections->relocations.get() != nullptr) {
+    CHECK(sections->relocations->Protect(PROT_READ));
+  }
+  if (*delta == 0) {
+    if (sections->class_table.get() != nullptr) {
+      CHECK(sections->class_table->Protect(PROT_READ));
+    }
+    if (sections->intern_table.get() != nullptr) {
+      CHECK(sections->intern_table->Protect(PROT_READ));
+    }
+  }
+  return true;
+}
+
+// The header of the uncompressed image file a compressed image decompresses to.
+static ImageHeader DecompressedImageHeader(const ImageHeader& image_header) {
+  ImageHeader decompressed_header(image_header);
+  decompressed_header.SetCompressedBlocks(0);
+  return decompressed_header;
+}
+
+File* ImageSpace::OpenDecompressedImage(const std::string& filename,
+                                        const ImageHeader& image_header) {
+  UniquePtr<File> file(OS::OpenFileForReading(filename.c_str()));
+  if (file.get() == nullptr) {
+    return nullptr;
+  }
+  // The header holds the checksum of the oat file, a cache left by another build won't match.
+  const ImageHeader expected_header(DecompressedImageHeader(image_header));
+  ImageHeader cached_header;
+  if (!file->ReadFully(&cached_header, sizeof(cached_header)) ||
+      memcmp(&cached_header, &expected_header, sizeof(ImageHeader)) != 0 ||
+      file->GetLength() < static_cast<int64_t>(image_header.GetRelocationsOffset() +
+                                               image_header.GetRelocationsSize())) {
+    return nullptr;
+  }
+  return file.release();
+}
+
+static const byte* GetSectionBegin(const UniquePtr<MemMap>& map) {
+  return map.get() != nullptr ? map->Begin() : nullptr;
+}
+
+void ImageSpace::WriteDecompressedImage(const std::string& filename,
+                                        const ImageHeader& image_header,
+                                        const ImageSections& sections) {
+  // Written aside and renamed, so that a start never sees a partial file.
+  std::string temp_filename(StringPrintf("%s.%d", filename.c_str(), getpid()));
+  UniquePtr<File> file(OS::CreateEmptyFile(temp_filename.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create decompressed image " << temp_filename;
+    return;
+  }
+  const ImageHeader decompressed_header(DecompressedImageHeader(image_header));
+  const size_t header_size = sizeof(ImageHeader);
+  struct Section {
+    size_t offset;
+    const byte* data;
+    size_t size;
+  };
+  const Section file_sections[] = {
+    { 0, reinterpret_cast<const byte*>(&decompressed_header), header_size },
+    { header_size, sections.image->Begin() + header_size,
+      image_header.GetImageSize() - header_size },
+    { image_header.GetBitmapOffset(), sections.bitmap->Begin(),
+      image_header.GetImageBitmapSize() },
+    { image_header.GetClassTableOffset(), GetSectionBegin(sections.class_table),
+      image_header.GetClassTableSize() },
+    { image_header.GetInternTableOffset(), GetSectionBegin(sections.intern_table),
+      image_header.GetInternTableSize() },
+    { image_header.GetRelocationsOffset(), GetSectionBegin(sections.relocations),
+      image_header.GetRelocationsSize() },
+  };
+  bool success = fchmod(file->Fd(), 0644) == 0;
+  for (const Section& section : file_sections) {
+    success = success && (section.size == 0 ||
+        file->Write(reinterpret_cast<const char*>(section.data), section.size, section.offset) ==
+            static_cast<int64_t>(section.size));
+  }
+  success = success && file->Flush() == 0 && file->Close() == 0 &&
+      rename(temp_filename.c_str(), filename.c_str()) == 0;
+  if (success) {
+    LOG(INFO) << "Wrote decompressed image " << filename;
+  } else {
+    PLOG(WARNING) << "Failed to write decompressed image " << filename;
+    unlink(temp_filename.c_str());
+  }
+}
+
 ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_location,
-                             bool validate_oat_file, std::string* error_msg) {
+                             bool validate_oat_file, const std::string& cache_filename,
+                             std::string* error_msg) {
   CHECK(image_filename != nullptr);
   CHECK(image_location != nullptr);
 
@@ -206,38 +616,62 @@ ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_locat
     return nullptr;
   }
 
-  // Note: The image header is part of the image due to mmap page alignment required of offset.
-  UniquePtr<MemMap> map(MemMap::MapFileAtAddress(image_header.GetImageBegin(),
-                                                 image_header.GetImageSize(),
-                                                 PROT_READ | PROT_WRITE,
-                                                 MAP_PRIVATE,
-                                                 file->Fd(),
-                                                 0,
-                                                 false,
-                                                 image_filename,
-                                                 error_msg));
-  if (map.get() == NULL) {
+  // A compressed image is mapped from its decompressed copy when one was kept, the oat file
+  // is still the one next to the compressed image.
+  bool write_cache = false;
+  if (image_header.IsCompressed() && !cache_filename.empty()) {
+    File* cache_file = OpenDecompressedImage(cache_filename, image_header);
+    if (cache_file != nullptr) {
+      VLOG(startup) << "Using decompressed image " << cache_filename;
+      file.reset(cache_file);
+      image_header.SetCompressedBlocks(0);
+    } else {
+      write_cache = true;
+    }
+  }
+
+  ptrdiff_t delta = 0;
+  ImageSections sections;
+  if (image_header.IsCompressed()) {
+    if (!DecompressImageSections(file.get(), image_header, image_filename, &sections, &delta,
+                                 error_msg)) {
+      DCHECK(!error_msg->empty());
+      return nullptr;
+    }
+    if (write_cache) {
+      WriteDecompressedImage(cache_filename, image_header, sections);
+    }
+  } else if (!MapImageSections(file->Fd(), image_header, image_filename, &sections, &delta,
+                               error_msg)) {
     DCHECK(!error_msg->empty());
     return nullptr;
   }
-  CHECK_EQ(image_header.GetImageBegin(), map->Begin());
+  MemMap* map = sections.image.get();
+  CHECK_EQ(image_header.GetImageBegin() + delta, map->Begin());
   DCHECK_EQ(0, memcmp(&image_header, map->Begin(), sizeof(ImageHeader)));
 
-  UniquePtr<MemMap> image_map(MemMap::MapFileAtAddress(nullptr, image_header.GetImageBitmapSize(),
-                                                       PROT_READ, MAP_PRIVATE,
-                                                       file->Fd(), image_header.GetBitmapOffset(),
-                                                       false,
-                                                       image_filename,
-                                                       error_msg));
-  if (image_map.get() == nullptr) {
-    *error_msg = StringPrintf("Failed to map image bitmap: %s", error_msg->c_str());
-    return nullptr;
+  // Move the addresses held by the image, the addresses held by the oat file are moved once it is
+  // loaded.
+  const uint8_t* relocations = nullptr;
+  const uint8_t* relocations_end = nullptr;
+  if (delta != 0) {
+    relocations = sections.relocations->Begin();
+    relocations_end = sections.relocations->End();
+    if (!ApplyRelocations(&relocations, relocations_end, map->Begin(),
+                          map->Begin() + image_header.GetImageSize(), delta)) {
+      *error_msg = StringPrintf("Invalid image relocations in '%s'", image_filename);
+      return nullptr;
+    }
+    image_header.Relocate(delta);
+    reinterpret_cast<ImageHeader*>(map->Begin())->Relocate(delta);
+    LOG(INFO) << "Relocated image " << image_filename << " by " << delta << " bytes";
   }
+
   uint32_t bitmap_index = bitmap_index_.FetchAndAdd(1);
   std::string bitmap_name(StringPrintf("imagespace %s live-bitmap %u", image_filename,
                                        bitmap_index));
   UniquePtr<accounting::ContinuousSpaceBitmap> bitmap(
-      accounting::ContinuousSpaceBitmap::CreateFromMemMap(bitmap_name, image_map.release(),
+      accounting::ContinuousSpaceBitmap::CreateFromMemMap(bitmap_name, sections.bitmap.release(),
                                                           reinterpret_cast<byte*>(map->Begin()),
                                                           map->Size()));
   if (bitmap.get() == nullptr) {
@@ -245,13 +679,15 @@ ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_locat
     return nullptr;
   }
 
+  if (delta != 0) {
+    RelocateSlots<ClassTable::ImageSlot>(sections.class_table.get(), delta);
+    RelocateSlots<InternTable::ImageSlot>(sections.intern_table.get(), delta);
+  }
   Runtime* runtime = Runtime::Current();
   mirror::Object* resolution_method = image_header.GetImageRoot(ImageHeader::kResolutionMethod);
   runtime->SetResolutionMethod(down_cast<mirror::ArtMethod*>(resolution_method));
   mirror::Object* imt_conflict_method = image_header.GetImageRoot(ImageHeader::kImtConflictMethod);
   runtime->SetImtConflictMethod(down_cast<mirror::ArtMethod*>(imt_conflict_method));
-  mirror::Object* default_imt = image_header.GetImageRoot(ImageHeader::kDefaultImt);
-  runtime->SetDefaultImt(down_cast<mirror::ObjectArray<mirror::ArtMethod>*>(default_imt));
 
   mirror::Object* callee_save_method = image_header.GetImageRoot(ImageHeader::kCalleeSaveMethod);
   runtime->SetCalleeSaveMethod(down_cast<mirror::ArtMethod*>(callee_save_method), Runtime::kSaveAll);
@@ -261,16 +697,34 @@ ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_locat
   runtime->SetCalleeSaveMethod(down_cast<mirror::ArtMethod*>(callee_save_method), Runtime::kRefsAndArgs);
 
   UniquePtr<ImageSpace> space(new ImageSpace(image_filename, image_location,
-                                             map.release(), bitmap.release()));
+                                             sections.image.release(), bitmap.release(),
+                                             sections.class_table.release(),
+                                             sections.intern_table.release()));
   if (kIsDebugBuild) {
     space->VerifyImageAllocations();
   }
 
-  space->oat_file_.reset(space->OpenOatFile(image_filename, error_msg));
+  space->oat_file_.reset(space->OpenOatFile(image_filename, delta, error_msg));
   if (space->oat_file_.get() == nullptr) {
     DCHECK(!error_msg->empty());
     return nullptr;
   }
+  if (delta != 0) {
+    OatFile* oat_file = space->oat_file_.get();
+    byte* oat_begin = const_cast<byte*>(reinterpret_cast<const byte*>(&oat_file->GetOatHeader()));
+    byte* oat_end = oat_begin + oat_file->Size();
+    if (!oat_file->SetWritable(true, error_msg)) {
+      return nullptr;
+    }
+    if (!ApplyRelocations(&relocations, relocations_end, oat_begin, oat_end, delta)) {
+      *error_msg = StringPrintf("Invalid oat file relocations in '%s'", image_filename);
+      return nullptr;
+    }
+    if (!oat_file->SetWritable(false, error_msg)) {
+      return nullptr;
+    }
+    __builtin___clear_cache(reinterpret_cast<char*>(oat_begin), reinterpret_cast<char*>(oat_end));
+  }
 
   if (validate_oat_file && !space->ValidateOatFile(error_msg)) {
     DCHECK(!error_msg->empty());
@@ -284,12 +738,19 @@ ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_locat
   return space.release();
 }
 
-OatFile* ImageSpace::OpenOatFile(const char* image_path, std::string* error_msg) const {
+OatFile* ImageSpace::OpenOatFile(const char* image_path, ptrdiff_t delta,
+                                 std::string* error_msg) const {
   const ImageHeader& image_header = GetImageHeader();
   std::string oat_filename = ImageHeader::GetOatLocationFromImageLocation(image_path);
 
-  OatFile* oat_file = OatFile::Open(oat_filename, oat_filename, image_header.GetOatDataBegin(),
-                                    !Runtime::Current()->IsCompiler(), error_msg);
+  OatFile* oat_file;
+  if (delta == 0) {
+    oat_file = OatFile::Open(oat_filename, oat_filename, image_header.GetOatDataBegin(),
+                             !Runtime::Current()->IsCompiler(), error_msg);
+  } else {
+    oat_file = OatFile::OpenRelocated(oat_filename, oat_filename, image_header.GetOatDataBegin(),
+                                      delta, !Runtime::Current()->IsCompiler(), error_msg);
+  }
   if (oat_file == NULL) {
     *error_msg = StringPrintf("Failed to open oat file '%s' referenced from image %s: %s",
                               oat_filename.c_str(), GetName(), error_msg->c_str());
@@ -305,16 +766,66 @@ OatFile* ImageSpace::OpenOatFile(const char* image_path, std::string* error_msg)
   return oat_file;
 }
 
+// The dex files whose location checksums one thread reads for ValidateOatFile, every stride-th
+// one from first.
+struct DexFileChecksums {
+  const std::vector<const OatFile::OatDexFile*>* oat_dex_files;
+  size_t first;
+  size_t stride;
+  std::vector<uint32_t>* checksums;
+  std::vector<std::string>* error_msgs;
+};
+
+static void* ReadDexFileChecksums(void* arg) {
+  DexFileChecksums* job = reinterpret_cast<DexFileChecksums*>(arg);
+  for (size_t i = job->first; i < job->oat_dex_files->size(); i += job->stride) {
+    const std::string& location = (*job->oat_dex_files)[i]->GetDexFileLocation();
+    std::string error_msg;
+    if (!DexFile::GetChecksum(location.c_str(), &(*job->checksums)[i], &error_msg)) {
+      (*job->error_msgs)[i] = error_msg.empty() ? "unknown error" : error_msg;
+    }
+  }
+  return nullptr;
+}
+
 bool ImageSpace::ValidateOatFile(std::string* error_msg) const {
   CHECK(oat_file_.get() != NULL);
-  for (const OatFile::OatDexFile* oat_dex_file : oat_file_->GetOatDexFiles()) {
+  // Each boot class path jar is a separate archive whose central directory has to be read for
+  // the checksum. The reads are independent and only do file I/O, so they are spread over a few
+  // threads not attached to the runtime, the caller taking the first share.
+  static constexpr size_t kMaxChecksumThreads = 4;
+  const std::vector<const OatFile::OatDexFile*> oat_dex_files = oat_file_->GetOatDexFiles();
+  std::vector<uint32_t> checksums(oat_dex_files.size(), 0);
+  std::vector<std::string> error_msgs(oat_dex_files.size());
+  const size_t num_threads = std::max<size_t>(std::min(kMaxChecksumThreads, oat_dex_files.size()),
+                                              1);
+  std::vector<DexFileChecksums> jobs(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    jobs[i].oat_dex_files = &oat_dex_files;
+    jobs[i].first = i;
+    jobs[i].stride = num_threads;
+    jobs[i].checksums = &checksums;
+    jobs[i].error_msgs = &error_msgs;
+  }
+  std::vector<pthread_t> pthreads(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i) {
+    CHECK_PTHREAD_CALL(pthread_create, (&pthreads[i - 1], nullptr, ReadDexFileChecksums, &jobs[i]),
+                       "dex file checksum thread");
+  }
+  ReadDexFileChecksums(&jobs[0]);
+  for (pthread_t pthread : pthreads) {
+    CHECK_PTHREAD_CALL(pthread_join, (pthread, nullptr), "dex file checksum thread");
+  }
+
+  for (size_t i = 0; i < oat_dex_files.size(); ++i) {
+    const OatFile::OatDexFile* oat_dex_file = oat_dex_files[i];
     const std::string& dex_file_location = oat_dex_file->GetDexFileLocation();
-    uint32_t dex_file_location_checksum;
-    if (!DexFile::GetChecksum(dex_file_location.c_str(), &dex_file_location_checksum, error_msg)) {
+    if (!error_msgs[i].empty()) {
       *error_msg = StringPrintf("Failed to get checksum of dex file '%s' referenced by image %s: "
-                                "%s", dex_file_location.c_str(), GetName(), error_msg->c_str());
+                                "%s", dex_file_location.c_str(), GetName(), error_msgs[i].c_str());
       return false;
     }
+    uint32_t dex_file_location_checksum = checksums[i];
     if (dex_file_location_checksum != oat_dex_file->GetDexFileLocationChecksum()) {
       *error_msg = StringPrintf("ValidateOatFile found checksum mismatch between oat file '%s' and "
                                 "dex file '%s' (0x%x != 0x%x)",
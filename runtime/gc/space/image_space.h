@@ -18,6 +18,7 @@
 #define ART_RUNTIME_GC_SPACE_IMAGE_SPACE_H_
 
 #include "gc/accounting/space_bitmap.h"
+#include "os.h"
 #include "runtime.h"
 #include "space.h"
 
@@ -95,6 +96,24 @@ class ImageSpace : public MemMapSpace {
     return false;
   }
 
+  // The class table built by the image writer, null if the image has none. Holds
+  // GetClassTableSize() bytes of ClassTable::ImageSlot entries.
+  const byte* GetClassTableBegin() const {
+    return class_table_map_.get() != nullptr ? class_table_map_->Begin() : nullptr;
+  }
+  size_t GetClassTableSize() const {
+    return GetImageHeader().GetClassTableSize();
+  }
+
+  // The intern table built by the image writer, null if the image has none. Holds
+  // GetInternTableSize() bytes of InternTable::ImageSlot entries.
+  const byte* GetInternTableBegin() const {
+    return intern_table_map_.get() != nullptr ? intern_table_map_->Begin() : nullptr;
+  }
+  size_t GetInternTableSize() const {
+    return GetImageHeader().GetInternTableSize();
+  }
+
  private:
   // Tries to initialize an ImageSpace from the given image path,
   // returning NULL on error.
@@ -103,8 +122,13 @@ class ImageSpace : public MemMapSpace {
   // image's OatFile is up-to-date relative to its DexFile
   // inputs. Otherwise (for /data), validate the inputs and generate
   // the OatFile in /data/dalvik-cache if necessary.
+  //
+  // A compressed image is decompressed in parallel into anonymous memory. With a
+  // cache_filename, the decompressed image is written there and mapped from there by the
+  // next starts, as long as it matches the compressed image.
   static ImageSpace* Init(const char* image_filename, const char* image_location,
-                          bool validate_oat_file, std::string* error_msg)
+                          bool validate_oat_file, const std::string& cache_filename,
+                          std::string* error_msg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Returns the filename of the image corresponding to
@@ -118,7 +142,8 @@ class ImageSpace : public MemMapSpace {
                                 std::string* location,
                                 bool* is_system);
 
-  OatFile* OpenOatFile(const char* image, std::string* error_msg) const
+  // Opens the oat file of the image, loaded delta bytes away from where it was compiled for.
+  OatFile* OpenOatFile(const char* image, ptrdiff_t delta, std::string* error_msg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   bool ValidateOatFile(std::string* error_msg) const
@@ -131,7 +156,56 @@ class ImageSpace : public MemMapSpace {
   UniquePtr<accounting::ContinuousSpaceBitmap> live_bitmap_;
 
   ImageSpace(const std::string& name, const char* image_location,
-             MemMap* mem_map, accounting::ContinuousSpaceBitmap* live_bitmap);
+             MemMap* mem_map, accounting::ContinuousSpaceBitmap* live_bitmap,
+             MemMap* class_table_map, MemMap* intern_table_map);
+
+  // Maps a section of the image file, returns null on error.
+  static MemMap* MapSection(int fd, size_t offset, size_t size, int prot,
+                            const char* image_filename, const char* section_name,
+                            std::string* error_msg);
+
+  // Maps the image at the address it was compiled for. An image with relocations is mapped
+  // delta bytes away instead when the runtime relocates images or when the address range of the
+  // image or of its oat file is taken. With an fd of -1, maps anonymous memory to decompress the
+  // image into. Returns null on error.
+  static MemMap* MapImage(int fd, const ImageHeader& image_header,
+                          const char* image_filename, ptrdiff_t* delta, std::string* error_msg);
+
+  // The sections of an image file. The relocations are only needed to move the image, the
+  // tables may be null.
+  struct ImageSections {
+    UniquePtr<MemMap> image;
+    UniquePtr<MemMap> bitmap;
+    UniquePtr<MemMap> class_table;
+    UniquePtr<MemMap> intern_table;
+    UniquePtr<MemMap> relocations;
+  };
+
+  // Maps the sections of an uncompressed image file, returns false on error.
+  static bool MapImageSections(int fd, const ImageHeader& image_header,
+                               const char* image_filename, ImageSections* sections,
+                               ptrdiff_t* delta, std::string* error_msg);
+
+  // Decompresses the blocks of a compressed image file into its sections, spread over a few
+  // threads. Returns false on error.
+  static bool DecompressImageSections(File* file, const ImageHeader& image_header,
+                                      const char* image_filename, ImageSections* sections,
+                                      ptrdiff_t* delta, std::string* error_msg);
+
+  // Opens the decompressed copy of the compressed image with image_header kept at filename,
+  // returns null if there is none or it doesn't match.
+  static File* OpenDecompressedImage(const std::string& filename,
+                                     const ImageHeader& image_header);
+
+  // Writes the decompressed sections to filename as an uncompressed image file, before they are
+  // relocated. Failures are only logged, the image is decompressed again at the next start.
+  static void WriteDecompressedImage(const std::string& filename,
+                                     const ImageHeader& image_header,
+                                     const ImageSections& sections);
+
+  // The read only mappings of the image class and intern tables, may be null.
+  UniquePtr<MemMap> class_table_map_;
+  UniquePtr<MemMap> intern_table_map_;
 
   // The OatFile associated with the image during early startup to
   // reserve space contiguous to the image. It is later released to
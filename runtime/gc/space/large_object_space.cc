@@ -394,6 +394,370 @@ void FreeListSpace::Dump(std::ostream& os) const {
   }
 }
 
+ChunkedLargeObjectSpace::Chunk::Chunk(MemMap* mem_map) : mem_map(mem_map) {
+  memset(block_pages, 0, sizeof(block_pages));
+  memset(block_flags, 0, sizeof(block_flags));
+  memset(page_state, kPageClean, sizeof(page_state));
+}
+
+void ChunkedLargeObjectSpace::Chunk::SetBlock(size_t page_idx, size_t num_pages, uint8_t flags) {
+  DCHECK_GT(num_pages, 0U);
+  DCHECK_LE(page_idx + num_pages, kChunkPages);
+  block_pages[page_idx] = num_pages;
+  block_pages[page_idx + num_pages - 1] = num_pages;
+  block_flags[page_idx] = flags | kBlockStart;
+}
+
+ChunkedLargeObjectSpace* ChunkedLargeObjectSpace::Create(const std::string& name) {
+  return new ChunkedLargeObjectSpace(name);
+}
+
+ChunkedLargeObjectSpace::ChunkedLargeObjectSpace(const std::string& name)
+    : LargeObjectSpace(name, nullptr, nullptr),
+      lock_("chunked large object space lock", kAllocSpaceLock),
+      num_empty_chunks_(0) {
+}
+
+ChunkedLargeObjectSpace::~ChunkedLargeObjectSpace() {
+  STLDeleteValues(&chunks_);
+  STLDeleteValues(&mem_maps_);
+}
+
+size_t ChunkedLargeObjectSpace::SizeClassBytes(size_t num_bytes) {
+  const size_t num_pages = RoundUp(num_bytes, kPageSize) / kPageSize;
+  if (num_pages <= kSizeClassesPerDoubling) {
+    // Even an empty allocation needs a block of its own.
+    return (num_pages == 0 ? 1 : num_pages) * kPageSize;
+  }
+  const size_t power_of_two = static_cast<size_t>(1) << (kBitsPerWord - 1 - CLZ(num_pages));
+  return RoundUp(num_pages, power_of_two / kSizeClassesPerDoubling) * kPageSize;
+}
+
+mirror::Object* ChunkedLargeObjectSpace::Alloc(Thread* self, size_t num_bytes,
+                                               size_t* bytes_allocated, size_t* usable_size) {
+  DCHECK(bytes_allocated != nullptr);
+  mirror::Object* obj = num_bytes > kMaxChunkAllocationSize ?
+      AllocMemMap(self, num_bytes, bytes_allocated) :
+      AllocFromChunk(self, num_bytes, bytes_allocated);
+  if (obj != nullptr && usable_size != nullptr) {
+    *usable_size = *bytes_allocated;
+  }
+  return obj;
+}
+
+mirror::Object* ChunkedLargeObjectSpace::AllocMemMap(Thread* self, size_t num_bytes,
+                                                     size_t* bytes_allocated) {
+  std::string error_msg;
+  MemMap* mem_map = MemMap::MapAnonymous("large object space allocation", NULL, num_bytes,
+                                         PROT_READ | PROT_WRITE, true, &error_msg);
+  if (UNLIKELY(mem_map == NULL)) {
+    LOG(WARNING) << "Large object allocation failed: " << error_msg;
+    return NULL;
+  }
+  MutexLock mu(self, lock_);
+  mirror::Object* obj = reinterpret_cast<mirror::Object*>(mem_map->Begin());
+  mem_maps_.Put(obj, mem_map);
+  UpdateBounds(mem_map->Begin(), mem_map->End());
+  RecordAllocation(mem_map->Size());
+  *bytes_allocated = mem_map->Size();
+  return obj;
+}
+
+mirror::Object* ChunkedLargeObjectSpace::AllocFromChunk(Thread* self, size_t num_bytes,
+                                                        size_t* bytes_allocated) {
+  const size_t allocation_size = SizeClassBytes(num_bytes);
+  const size_t num_pages = allocation_size / kPageSize;
+  byte* begin;
+  Chunk* chunk;
+  size_t page_idx;
+  {
+    MutexLock mu(self, lock_);
+    // Best fit, the smallest free block which is large enough.
+    const std::pair<size_t, byte*> key(num_pages, nullptr);
+    FreeBlocks::iterator found = free_blocks_.lower_bound(key);
+    if (found == free_blocks_.end()) {
+      if (!AddChunk()) {
+        return nullptr;
+      }
+      found = free_blocks_.lower_bound(key);
+      DCHECK(found != free_blocks_.end());
+    }
+    const size_t block_pages = found->first;
+    begin = found->second;
+    free_blocks_.erase(found);
+    chunk = FindChunk(begin);
+    DCHECK(chunk != nullptr);
+    page_idx = chunk->PageIndex(begin);
+    const uint8_t block_flags = chunk->block_flags[page_idx];
+    DCHECK_EQ(block_flags & (kBlockStart | kBlockAllocated), kBlockStart);
+    DCHECK_EQ(chunk->block_pages[page_idx], block_pages);
+    if (block_pages == kChunkPages) {
+      DCHECK_GT(num_empty_chunks_, 0U);
+      --num_empty_chunks_;
+    }
+    chunk->SetBlock(page_idx, num_pages, kBlockAllocated);
+    if (block_pages > num_pages) {
+      // Give the rest of the block back to the free blocks.
+      const size_t rest_idx = page_idx + num_pages;
+      chunk->SetBlock(rest_idx, block_pages - num_pages, 0);
+      free_blocks_.insert(std::make_pair(block_pages - num_pages, chunk->PageAddress(rest_idx)));
+    }
+    RecordAllocation(allocation_size);
+  }
+  // Only clear the pages which still hold the contents of freed objects, the clean ones read as
+  // zeroes and clearing them would only commit them. The pages belong to this allocation now, no
+  // other thread looks at their state.
+  const size_t end_idx = page_idx + num_pages;
+  for (size_t idx = page_idx; idx < end_idx; ) {
+    if (chunk->page_state[idx] == kPageClean) {
+      ++idx;
+      continue;
+    }
+    size_t run_end = idx + 1;
+    while (run_end < end_idx && chunk->page_state[run_end] != kPageClean) {
+      ++run_end;
+    }
+    memset(chunk->PageAddress(idx), 0, (run_end - idx) * kPageSize);
+    idx = run_end;
+  }
+  *bytes_allocated = allocation_size;
+  return reinterpret_cast<mirror::Object*>(begin);
+}
+
+bool ChunkedLargeObjectSpace::AddChunk() {
+  std::string error_msg;
+  MemMap* mem_map = MemMap::MapAnonymous("large object space chunk", NULL, kChunkSize,
+                                         PROT_READ | PROT_WRITE, true, &error_msg);
+  if (UNLIKELY(mem_map == NULL)) {
+    LOG(WARNING) << "Large object space chunk allocation failed: " << error_msg;
+    return false;
+  }
+  Chunk* chunk = new Chunk(mem_map);
+  chunk->SetBlock(0, kChunkPages, 0);
+  chunks_.Put(mem_map->Begin(), chunk);
+  free_blocks_.insert(std::make_pair(kChunkPages, mem_map->Begin()));
+  ++num_empty_chunks_;
+  UpdateBounds(mem_map->Begin(), mem_map->End());
+  return true;
+}
+
+ChunkedLargeObjectSpace::Chunk* ChunkedLargeObjectSpace::FindChunk(const void* addr) const {
+  Chunks::const_iterator it = chunks_.upper_bound(reinterpret_cast<byte*>(const_cast<void*>(addr)));
+  if (it == chunks_.begin()) {
+    return nullptr;
+  }
+  --it;
+  return it->second->mem_map->HasAddress(addr) ? it->second : nullptr;
+}
+
+void ChunkedLargeObjectSpace::UpdateBounds(byte* begin, byte* end) {
+  if (begin_ == nullptr || begin < begin_) {
+    begin_ = begin;
+  }
+  if (end_ == nullptr || end > end_) {
+    end_ = end;
+  }
+}
+
+void ChunkedLargeObjectSpace::RecordAllocation(size_t allocation_size) {
+  num_bytes_allocated_ += allocation_size;
+  total_bytes_allocated_ += allocation_size;
+  ++num_objects_allocated_;
+  ++total_objects_allocated_;
+}
+
+size_t ChunkedLargeObjectSpace::Free(Thread* self, mirror::Object* obj) {
+  MutexLock mu(self, lock_);
+  Chunk* chunk = FindChunk(obj);
+  if (chunk == nullptr) {
+    MemMaps::iterator found = mem_maps_.find(obj);
+    CHECK(found != mem_maps_.end()) << "Attempted to free large object which was not live";
+    const size_t allocation_size = found->second->Size();
+    DCHECK_GE(num_bytes_allocated_, allocation_size);
+    num_bytes_allocated_ -= allocation_size;
+    --num_objects_allocated_;
+    delete found->second;
+    mem_maps_.erase(found);
+    return allocation_size;
+  }
+  size_t page_idx = chunk->PageIndex(obj);
+  CHECK_EQ(chunk->block_flags[page_idx], kBlockStart | kBlockAllocated)
+      << "Attempted to free large object which was not live";
+  size_t num_pages = chunk->block_pages[page_idx];
+  const size_t allocation_size = num_pages * kPageSize;
+  // The contents of the freed object are left in place until its pages age or the heap is trimmed.
+  memset(&chunk->page_state[page_idx], kPageDirty, num_pages);
+  // Coalesce with the previous block if it is free.
+  if (page_idx != 0) {
+    const size_t prev_pages = chunk->block_pages[page_idx - 1];
+    const size_t prev_idx = page_idx - prev_pages;
+    DCHECK_NE(chunk->block_flags[prev_idx] & kBlockStart, 0);
+    if ((chunk->block_flags[prev_idx] & kBlockAllocated) == 0) {
+      size_t erased = free_blocks_.erase(std::make_pair(prev_pages, chunk->PageAddress(prev_idx)));
+      DCHECK_EQ(erased, 1U);
+      chunk->block_flags[page_idx] = 0;
+      page_idx = prev_idx;
+      num_pages += prev_pages;
+    }
+  }
+  // Coalesce with the next block if it is free.
+  const size_t next_idx = page_idx + num_pages;
+  if (next_idx != kChunkPages && (chunk->block_flags[next_idx] & kBlockAllocated) == 0) {
+    DCHECK_NE(chunk->block_flags[next_idx] & kBlockStart, 0);
+    const size_t next_pages = chunk->block_pages[next_idx];
+    size_t erased = free_blocks_.erase(std::make_pair(next_pages, chunk->PageAddress(next_idx)));
+    DCHECK_EQ(erased, 1U);
+    chunk->block_flags[next_idx] = 0;
+    num_pages += next_pages;
+  }
+  if (num_pages == kChunkPages && num_empty_chunks_ >= kMaxEmptyChunks) {
+    // Enough empty chunks are kept around for the next allocations, unmap this one.
+    chunks_.erase(chunk->mem_map->Begin());
+    delete chunk;
+  } else {
+    if (num_pages == kChunkPages) {
+      ++num_empty_chunks_;
+    }
+    chunk->SetBlock(page_idx, num_pages, 0);
+    free_blocks_.insert(std::make_pair(num_pages, chunk->PageAddress(page_idx)));
+  }
+  DCHECK_GE(num_bytes_allocated_, allocation_size);
+  num_bytes_allocated_ -= allocation_size;
+  --num_objects_allocated_;
+  return allocation_size;
+}
+
+size_t ChunkedLargeObjectSpace::AllocationSize(mirror::Object* obj, size_t* usable_size) {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t allocation_size;
+  Chunk* chunk = FindChunk(obj);
+  if (chunk != nullptr) {
+    const size_t page_idx = chunk->PageIndex(obj);
+    CHECK_EQ(chunk->block_flags[page_idx], kBlockStart | kBlockAllocated)
+        << "Attempted to get size of a large object which is not live";
+    allocation_size = chunk->block_pages[page_idx] * kPageSize;
+  } else {
+    auto found = mem_maps_.find(obj);
+    CHECK(found != mem_maps_.end()) << "Attempted to get size of a large object which is not live";
+    allocation_size = found->second->Size();
+  }
+  if (usable_size != nullptr) {
+    *usable_size = allocation_size;
+  }
+  return allocation_size;
+}
+
+void ChunkedLargeObjectSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  for (const auto& chunk_pair : chunks_) {
+    Chunk* chunk = chunk_pair.second;
+    for (size_t page_idx = 0; page_idx < kChunkPages; page_idx += chunk->block_pages[page_idx]) {
+      if ((chunk->block_flags[page_idx] & kBlockAllocated) != 0) {
+        byte* begin = chunk->PageAddress(page_idx);
+        const size_t allocation_size = chunk->block_pages[page_idx] * kPageSize;
+        callback(begin, begin + allocation_size, allocation_size, arg);
+        callback(NULL, NULL, 0, arg);
+      }
+    }
+  }
+  for (const auto& mem_map_pair : mem_maps_) {
+    MemMap* mem_map = mem_map_pair.second;
+    callback(mem_map->Begin(), mem_map->End(), mem_map->Size(), arg);
+    callback(NULL, NULL, 0, arg);
+  }
+}
+
+bool ChunkedLargeObjectSpace::ContainsLocked(const mirror::Object* obj) const {
+  Chunk* chunk = FindChunk(obj);
+  if (chunk != nullptr) {
+    return chunk->block_flags[chunk->PageIndex(obj)] == (kBlockStart | kBlockAllocated);
+  }
+  return mem_maps_.find(const_cast<mirror::Object*>(obj)) != mem_maps_.end();
+}
+
+bool ChunkedLargeObjectSpace::Contains(const mirror::Object* obj) const {
+  Thread* self = Thread::Current();
+  if (lock_.IsExclusiveHeld(self)) {
+    // We hold lock_ so do the check.
+    return ContainsLocked(obj);
+  } else {
+    MutexLock mu(self, lock_);
+    return ContainsLocked(obj);
+  }
+}
+
+size_t ChunkedLargeObjectSpace::ReleasePages(Chunk* chunk, size_t page_idx, size_t num_pages,
+                                             PageState min_state) {
+  const size_t release_alignment = MemMap::GetReleaseAlignment();
+  const size_t end_idx = page_idx + num_pages;
+  size_t released = 0;
+  for (size_t idx = page_idx; idx < end_idx; ) {
+    if (chunk->page_state[idx] < min_state) {
+      ++idx;
+      continue;
+    }
+    size_t run_end = idx + 1;
+    while (run_end < end_idx && chunk->page_state[run_end] >= min_state) {
+      ++run_end;
+    }
+    // Releasing part of a huge page would split it, only the whole ones of the run are released.
+    byte* release_begin = AlignUp(chunk->PageAddress(idx), release_alignment);
+    byte* release_end = AlignDown(chunk->PageAddress(run_end), release_alignment);
+    if (release_begin < release_end) {
+      const size_t size = release_end - release_begin;
+      CHECK_EQ(madvise(release_begin, size, MADV_DONTNEED), 0);
+      memset(&chunk->page_state[chunk->PageIndex(release_begin)], kPageClean, size / kPageSize);
+      released += size;
+    }
+    idx = run_end;
+  }
+  return released;
+}
+
+size_t ChunkedLargeObjectSpace::Trim() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t reclaimed = 0;
+  for (const auto& block : free_blocks_) {
+    Chunk* chunk = FindChunk(block.second);
+    DCHECK(chunk != nullptr);
+    reclaimed += ReleasePages(chunk, chunk->PageIndex(block.second), block.first, kPageDirty);
+  }
+  return reclaimed;
+}
+
+size_t ChunkedLargeObjectSpace::ReleaseAgedPages() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t released = 0;
+  for (const auto& block : free_blocks_) {
+    Chunk* chunk = FindChunk(block.second);
+    DCHECK(chunk != nullptr);
+    const size_t page_idx = chunk->PageIndex(block.second);
+    released += ReleasePages(chunk, page_idx, block.first, kPageAged);
+    // The pages freed since the last sweep are released by the next one unless they are reused.
+    for (size_t idx = page_idx; idx < page_idx + block.first; ++idx) {
+      if (chunk->page_state[idx] == kPageDirty) {
+        chunk->page_state[idx] = kPageAged;
+      }
+    }
+  }
+  return released;
+}
+
+size_t ChunkedLargeObjectSpace::GetNumChunks() {
+  MutexLock mu(Thread::Current(), lock_);
+  return chunks_.size();
+}
+
+void ChunkedLargeObjectSpace::Dump(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), lock_);
+  os << GetName() << " -"
+     << " begin: " << reinterpret_cast<void*>(Begin())
+     << " end: " << reinterpret_cast<void*>(End())
+     << " chunks: " << chunks_.size()
+     << " free blocks: " << free_blocks_.size()
+     << " separately mapped objects: " << mem_maps_.size() << "\n";
+}
+
 void LargeObjectSpace::SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg) {
   SweepCallbackContext* context = static_cast<SweepCallbackContext*>(arg);
   space::LargeObjectSpace* space = context->space->AsLargeObjectSpace();
@@ -429,6 +793,7 @@ void LargeObjectSpace::Sweep(bool swap_bitmaps, size_t* out_freed_objects,
                                            reinterpret_cast<uintptr_t>(End()), SweepCallback, &scc);
   *out_freed_objects += scc.freed_objects;
   *out_freed_bytes += scc.freed_bytes;
+  ReleaseAgedPages();
 }
 
 }  // namespace space
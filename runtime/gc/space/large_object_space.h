@@ -75,6 +75,19 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
 
   void Sweep(bool swap_bitmaps, size_t* out_freed_objects, size_t* out_freed_bytes);
 
+  // Hands the pages which are free but still resident back to the system, returns how many bytes
+  // were released.
+  virtual size_t Trim() {
+    return 0;
+  }
+
+  // Called at the end of each sweep. Hands the pages of the objects which were freed by an earlier
+  // sweep and haven't been reused since back to the system, so that the allocations which reuse
+  // them later get zeroed pages for free. Returns how many bytes were released.
+  virtual size_t ReleaseAgedPages() {
+    return 0;
+  }
+
   virtual bool CanMoveObjects() const OVERRIDE {
     return false;
   }
@@ -266,6 +279,116 @@ class FreeListSpace FINAL : public LargeObjectSpace {
   FreeBlocks free_blocks_ GUARDED_BY(lock_);
 };
 
+// A discontinuous large object space which serves the objects from multi-megabyte chunks instead
+// of mapping each of them. Allocations are rounded up to size classes and placed best fit in the
+// free blocks of the chunks. Freed blocks are coalesced with their free neighbours. The pages which
+// still hold the contents of freed objects are tracked one by one: an allocation only clears those
+// of its pages, and they are given back to the system once they stayed free for a whole GC, or
+// when the heap is trimmed. Objects which are too large for a chunk get a memory map of their own
+// like in LargeObjectMapSpace, which is zeroed already.
+class ChunkedLargeObjectSpace FINAL : public LargeObjectSpace {
+ public:
+  static ChunkedLargeObjectSpace* Create(const std::string& name);
+  virtual ~ChunkedLargeObjectSpace();
+
+  size_t AllocationSize(mirror::Object* obj, size_t* usable_size) OVERRIDE LOCKS_EXCLUDED(lock_);
+  mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                        size_t* usable_size) OVERRIDE LOCKS_EXCLUDED(lock_);
+  size_t Free(Thread* self, mirror::Object* obj) OVERRIDE LOCKS_EXCLUDED(lock_);
+  void Walk(DlMallocSpace::WalkCallback callback, void* arg) OVERRIDE LOCKS_EXCLUDED(lock_);
+  // TODO: disabling thread safety analysis as this may be called when we already hold lock_.
+  bool Contains(const mirror::Object* obj) const OVERRIDE NO_THREAD_SAFETY_ANALYSIS;
+  size_t Trim() OVERRIDE LOCKS_EXCLUDED(lock_);
+  size_t ReleaseAgedPages() OVERRIDE LOCKS_EXCLUDED(lock_);
+
+  void Dump(std::ostream& os) const;
+
+  // Number of chunks currently mapped.
+  size_t GetNumChunks() LOCKS_EXCLUDED(lock_);
+
+  // Round num_bytes up to its size class. The classes are page multiples, with
+  // kSizeClassesPerDoubling classes between two powers of two, which wastes at most a quarter of
+  // an allocation but lets freed blocks fit later allocations of similar sizes.
+  static size_t SizeClassBytes(size_t num_bytes);
+
+  static constexpr size_t kChunkSize = 4 * MB;
+  // Larger allocations get a memory map of their own.
+  static constexpr size_t kMaxChunkAllocationSize = kChunkSize / 2;
+  static constexpr size_t kSizeClassesPerDoubling = 4;
+  // How many entirely free chunks are kept mapped, the others are unmapped when they empty.
+  static constexpr size_t kMaxEmptyChunks = 1;
+
+ private:
+  static constexpr size_t kChunkPages = kChunkSize / kPageSize;
+
+  enum BlockFlags {
+    kBlockStart = 1 << 0,      // First page of a block.
+    kBlockAllocated = 1 << 1,  // The block holds an object.
+  };
+
+  // The state of a free page, ordered by how long it has been holding stale contents. The state of
+  // an allocated page is meaningless, freeing the object makes all its pages dirty.
+  enum PageState {
+    kPageClean = 0,  // Never touched or released since, reads as zeroes.
+    kPageDirty,      // Holds the contents of an object freed by the last sweep.
+    kPageAged,       // Holds the contents of an object freed by an earlier sweep.
+  };
+
+  struct Chunk {
+    explicit Chunk(MemMap* mem_map);
+
+    UniquePtr<MemMap> mem_map;
+    // The size in pages of each block, stored at its first and at its last page.
+    uint32_t block_pages[kChunkPages];
+    // The BlockFlags of each block, stored at its first page.
+    uint8_t block_flags[kChunkPages];
+    // The PageState of each page.
+    uint8_t page_state[kChunkPages];
+
+    byte* PageAddress(size_t page_idx) const {
+      return mem_map->Begin() + page_idx * kPageSize;
+    }
+    size_t PageIndex(const void* addr) const {
+      return (reinterpret_cast<const byte*>(addr) - mem_map->Begin()) / kPageSize;
+    }
+    // Record a block of num_pages pages starting at page_idx.
+    void SetBlock(size_t page_idx, size_t num_pages, uint8_t flags);
+  };
+
+  // Free blocks by size in pages, then by address.
+  typedef std::set<std::pair<size_t, byte*>, std::less<std::pair<size_t, byte*> >,
+                   accounting::GcAllocator<std::pair<size_t, byte*> > > FreeBlocks;
+  typedef SafeMap<byte*, Chunk*, std::less<byte*>,
+                  accounting::GcAllocator<std::pair<byte*, Chunk*> > > Chunks;
+  typedef SafeMap<mirror::Object*, MemMap*, std::less<mirror::Object*>,
+                  accounting::GcAllocator<std::pair<mirror::Object*, MemMap*> > > MemMaps;
+
+  explicit ChunkedLargeObjectSpace(const std::string& name);
+
+  mirror::Object* AllocFromChunk(Thread* self, size_t num_bytes, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(lock_);
+  mirror::Object* AllocMemMap(Thread* self, size_t num_bytes, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(lock_);
+  // Map a new chunk and add its free block, returns false if the mapping failed.
+  bool AddChunk() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Release the runs of pages at least in min_state among the num_pages pages of a free block,
+  // returns how many bytes were released.
+  size_t ReleasePages(Chunk* chunk, size_t page_idx, size_t num_pages, PageState min_state)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns the chunk containing addr, or null.
+  Chunk* FindChunk(const void* addr) const EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Whether obj is the start of an allocated block or of a separately mapped object.
+  bool ContainsLocked(const mirror::Object* obj) const EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void UpdateBounds(byte* begin, byte* end) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void RecordAllocation(size_t allocation_size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  Chunks chunks_ GUARDED_BY(lock_);
+  FreeBlocks free_blocks_ GUARDED_BY(lock_);
+  size_t num_empty_chunks_ GUARDED_BY(lock_);
+  MemMaps mem_maps_ GUARDED_BY(lock_);
+};
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
@@ -29,12 +29,14 @@ class LargeObjectSpaceTest : public SpaceTest {
 
 void LargeObjectSpaceTest::LargeObjectTest() {
   size_t rand_seed = 0;
-  for (size_t i = 0; i < 2; ++i) {
+  for (size_t i = 0; i < 3; ++i) {
     LargeObjectSpace* los = nullptr;
     if (i == 0) {
       los = space::LargeObjectMapSpace::Create("large object space");
-    } else {
+    } else if (i == 1) {
       los = space::FreeListSpace::Create("large object space", nullptr, 128 * MB);
+    } else {
+      los = space::ChunkedLargeObjectSpace::Create("large object space");
     }
 
     static const size_t num_allocations = 64;
@@ -94,6 +96,53 @@ TEST_F(LargeObjectSpaceTest, LargeObjectTest) {
   LargeObjectTest();
 }
 
+TEST_F(LargeObjectSpaceTest, ChunkedSpaceReusesAndZeroesBlocks) {
+  UniquePtr<ChunkedLargeObjectSpace> los(ChunkedLargeObjectSpace::Create("large object space"));
+  Thread* self = Thread::Current();
+  const size_t request_size = 5 * kPageSize + 1;
+  size_t allocation_size = 0;
+  mirror::Object* first = los->Alloc(self, request_size, &allocation_size, nullptr);
+  ASSERT_TRUE(first != nullptr);
+  EXPECT_EQ(ChunkedLargeObjectSpace::SizeClassBytes(request_size), allocation_size);
+  EXPECT_EQ(1U, los->GetNumChunks());
+  memset(first, 0xAB, request_size);
+  los->Free(self, first);
+  // The freed block is handed out again, cleared.
+  mirror::Object* second = los->Alloc(self, request_size, &allocation_size, nullptr);
+  ASSERT_EQ(first, second);
+  for (size_t k = 0; k < allocation_size; ++k) {
+    ASSERT_EQ(0, reinterpret_cast<const byte*>(second)[k]);
+  }
+  EXPECT_TRUE(los->Contains(second));
+  los->Free(self, second);
+  EXPECT_FALSE(los->Contains(second));
+  EXPECT_EQ(1U, los->GetNumChunks());
+  EXPECT_EQ(0U, los->GetBytesAllocated());
+  EXPECT_GE(los->Trim(), allocation_size);
+}
+
+TEST_F(LargeObjectSpaceTest, ChunkedSpaceReleasesAgedPages) {
+  UniquePtr<ChunkedLargeObjectSpace> los(ChunkedLargeObjectSpace::Create("large object space"));
+  Thread* self = Thread::Current();
+  const size_t request_size = 8 * kPageSize;
+  size_t allocation_size = 0;
+  mirror::Object* first = los->Alloc(self, request_size, &allocation_size, nullptr);
+  ASSERT_TRUE(first != nullptr);
+  memset(first, 0xAB, request_size);
+  los->Free(self, first);
+  // The pages of a freed object are released by the second sweep after it, not the first.
+  EXPECT_EQ(0U, los->ReleaseAgedPages());
+  EXPECT_EQ(allocation_size, los->ReleaseAgedPages());
+  EXPECT_EQ(0U, los->Trim());
+  // A larger block reusing the released pages is still handed out zeroed.
+  mirror::Object* second = los->Alloc(self, 2 * request_size, &allocation_size, nullptr);
+  ASSERT_EQ(first, second);
+  for (size_t k = 0; k < allocation_size; ++k) {
+    ASSERT_EQ(0, reinterpret_cast<const byte*>(second)[k]);
+  }
+  los->Free(self, second);
+}
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
@@ -77,6 +77,14 @@ class MallocSpace : public ContinuousMemMapAllocSpace {
   // Hands unused pages back to the system.
   virtual size_t Trim() = 0;
 
+  // Hands unused pages back to the system until deadline_ns is past. *finished is set once the
+  // whole space was trimmed, the next call starts over. Spaces which cannot stop midway trim in
+  // one go.
+  virtual size_t TrimSlice(uint64_t /*deadline_ns*/, bool* finished) {
+    *finished = true;
+    return Trim();
+  }
+
   // Perform a mspace_inspect_all which calls back for each allocation chunk. The chunk may not be
   // in use, indicated by num_bytes equaling zero.
   virtual void Walk(WalkCallback callback, void* arg) = 0;
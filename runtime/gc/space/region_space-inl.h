@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_REGION_SPACE_INL_H_
+#define ART_RUNTIME_GC_SPACE_REGION_SPACE_INL_H_
+
+#include "region_space.h"
+#include "thread.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+inline mirror::Object* RegionSpace::Alloc(Thread*, size_t num_bytes, size_t* bytes_allocated,
+                                          size_t* usable_size) {
+  num_bytes = RoundUp(num_bytes, kAlignment);
+  mirror::Object* ret = AllocNonvirtual(num_bytes);
+  if (LIKELY(ret != nullptr)) {
+    *bytes_allocated = num_bytes;
+    if (usable_size != nullptr) {
+      *usable_size = num_bytes;
+    }
+  }
+  return ret;
+}
+
+inline mirror::Object* RegionSpace::Region::Alloc(size_t num_bytes) {
+  DCHECK(IsAligned<kAlignment>(num_bytes));
+  byte* old_top;
+  byte* new_top;
+  do {
+    old_top = top_;
+    new_top = old_top + num_bytes;
+    // If there is no more room in the region, the caller has to get a new one.
+    if (UNLIKELY(new_top > end_)) {
+      return nullptr;
+    }
+  } while (!__sync_bool_compare_and_swap(reinterpret_cast<volatile intptr_t*>(&top_),
+                                         reinterpret_cast<intptr_t>(old_top),
+                                         reinterpret_cast<intptr_t>(new_top)));
+  objects_allocated_.FetchAndAdd(1);
+  return reinterpret_cast<mirror::Object*>(old_top);
+}
+
+inline mirror::Object* RegionSpace::AllocNonvirtual(size_t num_bytes) {
+  DCHECK(IsAligned<kAlignment>(num_bytes));
+  if (UNLIKELY(num_bytes > kRegionSize)) {
+    return AllocLarge(num_bytes);
+  }
+  mirror::Object* obj = current_region_->Alloc(num_bytes);
+  if (LIKELY(obj != nullptr)) {
+    return obj;
+  }
+  MutexLock mu(Thread::Current(), region_lock_);
+  // Retry with the current region since another thread may have updated it.
+  obj = current_region_->Alloc(num_bytes);
+  if (obj != nullptr) {
+    return obj;
+  }
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (r->IsFree()) {
+      r->Unfree(kRegionStateAllocated);
+      ++num_non_free_regions_;
+      obj = r->Alloc(num_bytes);
+      CHECK(obj != nullptr);
+      current_region_ = r;
+      return obj;
+    }
+  }
+  return nullptr;
+}
+
+inline size_t RegionSpace::AllocationSizeNonvirtual(mirror::Object* obj, size_t* usable_size) {
+  size_t num_bytes = obj->SizeOf();
+  if (usable_size != nullptr) {
+    if (LIKELY(num_bytes <= kRegionSize)) {
+      *usable_size = RoundUp(num_bytes, kAlignment);
+    } else {
+      *usable_size = RoundUp(num_bytes, kRegionSize);
+    }
+  }
+  return num_bytes;
+}
+
+inline void RegionSpace::AddLiveBytes(mirror::Object* ref, size_t num_bytes) {
+  Region* r = RefToRegion(ref);
+  DCHECK(!r->IsFree());
+  DCHECK(!r->IsLargeTail());
+  r->AddLiveBytes(num_bytes);
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_REGION_SPACE_INL_H_
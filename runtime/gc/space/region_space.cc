@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "region_space.h"
+#include "region_space-inl.h"
+
+#include <sys/mman.h>
+
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+RegionSpace* RegionSpace::Create(const std::string& name, size_t capacity,
+                                 byte* requested_begin) {
+  capacity = RoundUp(capacity, kRegionSize);
+  std::string error_msg;
+  UniquePtr<MemMap> mem_map(MemMap::MapAnonymous(name.c_str(), requested_begin, capacity,
+                                                 PROT_READ | PROT_WRITE, true, &error_msg));
+  if (mem_map.get() == nullptr) {
+    LOG(ERROR) << "Failed to allocate pages for alloc space (" << name << ") of size "
+        << PrettySize(capacity) << " with message " << error_msg;
+    return nullptr;
+  }
+  return new RegionSpace(name, mem_map.release());
+}
+
+RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
+    : ContinuousMemMapAllocSpace(name, mem_map, mem_map->Begin(), mem_map->End(), mem_map->End(),
+                                 kGcRetentionPolicyAlwaysCollect),
+      region_lock_("Region lock"),
+      num_regions_(mem_map->Size() / kRegionSize),
+      regions_(new Region[num_regions_]),
+      num_non_free_regions_(0),
+      current_region_(&full_region_) {
+  CHECK_ALIGNED(mem_map->Size(), kRegionSize);
+  CHECK_GT(num_regions_, 0U);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    byte* region_begin = Begin() + i * kRegionSize;
+    regions_[i].Init(i, region_begin, region_begin + kRegionSize);
+  }
+}
+
+void RegionSpace::Region::Clear() {
+  DCHECK(!IsPinned()) << idx_;
+  // Release the pages back to the operating system.
+  CHECK_NE(madvise(begin_, end_ - begin_, MADV_DONTNEED), -1) << "madvise failed";
+  top_ = begin_;
+  state_ = kRegionStateFree;
+  type_ = kRegionTypeNone;
+  objects_allocated_ = 0;
+  live_bytes_ = 0;
+}
+
+void RegionSpace::Clear() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (!r->IsFree()) {
+      r->Clear();
+    }
+  }
+  num_non_free_regions_ = 0;
+  current_region_ = &full_region_;
+}
+
+mirror::Object* RegionSpace::AllocLarge(size_t num_bytes) {
+  const size_t num_regs = RoundUp(num_bytes, kRegionSize) / kRegionSize;
+  MutexLock mu(Thread::Current(), region_lock_);
+  // Find a run of num_regs free regions.
+  size_t left = 0;
+  while (left + num_regs <= num_regions_) {
+    size_t right = left;
+    while (right < left + num_regs && regions_[right].IsFree()) {
+      ++right;
+    }
+    if (right == left + num_regs) {
+      // The first region is the head and holds the accounting, the others are tails.
+      Region* first = &regions_[left];
+      first->Unfree(kRegionStateLarge);
+      first->SetTop(first->Begin() + num_bytes);
+      first->SetObjectsAllocated(1);
+      for (size_t p = left + 1; p < right; ++p) {
+        regions_[p].Unfree(kRegionStateLargeTail);
+      }
+      num_non_free_regions_ += num_regs;
+      return reinterpret_cast<mirror::Object*>(first->Begin());
+    }
+    // Skip past the non-free region that ended the run.
+    left = right + 1;
+  }
+  return nullptr;
+}
+
+void RegionSpace::Dump(std::ostream& os) const {
+  os << GetName() << " "
+      << reinterpret_cast<void*>(Begin()) << "-" << reinterpret_cast<void*>(Limit())
+      << " regions=" << num_regions_;
+}
+
+void RegionSpace::Region::Dump(std::ostream& os) const {
+  os << "Region[" << idx_ << "]=" << reinterpret_cast<void*>(begin_) << "-"
+     << reinterpret_cast<void*>(top_) << "-" << reinterpret_cast<void*>(end_)
+     << " state=" << static_cast<int>(state_) << " type=" << static_cast<int>(type_)
+     << " objects_allocated=" << ObjectsAllocated() << " live_bytes=" << LiveBytes() << "\n";
+}
+
+void RegionSpace::DumpRegions(std::ostream& os) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    regions_[i].Dump(os);
+  }
+}
+
+uint64_t RegionSpace::GetBytesAllocated() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (!r->IsFree() && !r->IsLargeTail()) {
+      bytes += r->BytesAllocated();
+    }
+  }
+  return bytes;
+}
+
+uint64_t RegionSpace::GetObjectsAllocated() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  uint64_t objects = 0;
+  for (size_t i = 0; i < num_regions_; ++i) {
+    objects += regions_[i].ObjectsAllocated();
+  }
+  return objects;
+}
+
+size_t RegionSpace::GetNumAllocatedRegions() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  size_t count = 0;
+  for (size_t i = 0; i < num_regions_; ++i) {
+    if (!regions_[i].IsFree() && !regions_[i].IsLargeTail()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+mirror::Object* RegionSpace::GetNextObject(mirror::Object* obj) {
+  const uintptr_t position = reinterpret_cast<uintptr_t>(obj) + obj->SizeOf();
+  return reinterpret_cast<mirror::Object*>(RoundUp(position, kAlignment));
+}
+
+void RegionSpace::Walk(ObjectCallback* callback, void* arg) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (r->IsFree() || r->IsLargeTail()) {
+      continue;
+    }
+    if (r->IsLarge()) {
+      mirror::Object* obj = reinterpret_cast<mirror::Object*>(r->Begin());
+      if (obj->GetClass() != nullptr) {
+        callback(obj, arg);
+      }
+      continue;
+    }
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(r->Begin());
+    const mirror::Object* end = reinterpret_cast<const mirror::Object*>(r->Top());
+    // There is a race condition where a thread has just allocated an object but not set the
+    // class. We can't know the size of this object, so stop walking the region when we hit it.
+    while (obj < end && obj->GetClass() != nullptr) {
+      callback(obj, arg);
+      obj = GetNextObject(obj);
+    }
+  }
+}
+
+accounting::ContinuousSpaceBitmap::SweepCallback* RegionSpace::GetSweepCallback() {
+  LOG(FATAL) << "Unimplemented";
+  return nullptr;
+}
+
+void RegionSpace::ClearLiveBytes() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    regions_[i].ClearLiveBytes();
+  }
+}
+
+void RegionSpace::PinObject(mirror::Object* obj) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  Region* r = RefToRegion(obj);
+  DCHECK(!r->IsFree() && !r->IsLargeTail()) << obj;
+  DCHECK(!r->IsInFromSpace()) << obj;
+  r->Pin();
+}
+
+void RegionSpace::UnpinObject(mirror::Object* obj) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  RefToRegion(obj)->Unpin();
+}
+
+bool RegionSpace::IsPinned(mirror::Object* obj) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  return RefToRegion(obj)->IsPinned();
+}
+
+size_t RegionSpace::SetFromSpace(float evacuation_threshold) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  size_t num_evacuated = 0;
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (r->IsFree() || r->IsLargeTail()) {
+      continue;
+    }
+    const size_t bytes_allocated = r->BytesAllocated();
+    bool evacuate;
+    if (r->IsPinned()) {
+      // Native code points into the region.
+      evacuate = false;
+    } else if (r->IsLarge()) {
+      // Large objects are not worth copying, they are only released once dead.
+      evacuate = r->LiveBytes() == 0;
+    } else {
+      evacuate = r->LiveBytes() < bytes_allocated * evacuation_threshold;
+    }
+    r->SetType(evacuate ? kRegionTypeFromSpace : kRegionTypeUnevacFromSpace);
+    if (r->IsLarge()) {
+      // The tails share the fate of their head.
+      for (size_t p = i + 1; p < num_regions_ && regions_[p].IsLargeTail(); ++p) {
+        regions_[p].SetType(evacuate ? kRegionTypeFromSpace : kRegionTypeUnevacFromSpace);
+      }
+    }
+    if (evacuate) {
+      ++num_evacuated;
+    }
+  }
+  // Start allocating into a fresh to-space region.
+  current_region_ = &full_region_;
+  return num_evacuated;
+}
+
+void RegionSpace::ClearFromSpace(uint64_t* freed_bytes, uint64_t* freed_objects) {
+  DCHECK(freed_bytes != nullptr);
+  DCHECK(freed_objects != nullptr);
+  MutexLock mu(Thread::Current(), region_lock_);
+  for (size_t i = 0; i < num_regions_; ++i) {
+    Region* r = &regions_[i];
+    if (r->IsInFromSpace()) {
+      if (!r->IsLargeTail()) {
+        *freed_bytes += r->BytesAllocated();
+        *freed_objects += r->ObjectsAllocated();
+      }
+      r->Clear();
+      --num_non_free_regions_;
+    } else if (r->IsInUnevacFromSpace()) {
+      r->SetType(kRegionTypeToSpace);
+    }
+  }
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_REGION_SPACE_H_
+#define ART_RUNTIME_GC_SPACE_REGION_SPACE_H_
+
+#include "atomic.h"
+#include "object_callbacks.h"
+#include "space.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+// A region space divides its memory into fixed size regions which are allocated into with a bump
+// pointer. Each region tracks the bytes found live by the last mark, which lets a collector
+// evacuate only the sparsely populated regions and leave the dense ones in place. Objects larger
+// than a region get a run of contiguous regions to themselves and are never evacuated.
+class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
+ public:
+  SpaceType GetType() const OVERRIDE {
+    return kSpaceTypeRegionSpace;
+  }
+
+  // Create a region space with the requested sizes. The requested base address is not
+  // guaranteed to be granted, if it is required, the caller should call Begin on the returned
+  // space to confirm the request was granted.
+  static RegionSpace* Create(const std::string& name, size_t capacity, byte* requested_begin);
+
+  // Allocate num_bytes, returns nullptr if the space is full.
+  mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                        size_t* usable_size) OVERRIDE LOCKS_EXCLUDED(region_lock_);
+  // The allocation is thread safe anyway, there is no cheaper version.
+  mirror::Object* AllocThreadUnsafe(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                                    size_t* usable_size)
+      OVERRIDE EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return Alloc(self, num_bytes, bytes_allocated, usable_size);
+  }
+  mirror::Object* AllocNonvirtual(size_t num_bytes) LOCKS_EXCLUDED(region_lock_);
+
+  // Return the storage space required by obj.
+  size_t AllocationSize(mirror::Object* obj, size_t* usable_size) OVERRIDE
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return AllocationSizeNonvirtual(obj, usable_size);
+  }
+  size_t AllocationSizeNonvirtual(mirror::Object* obj, size_t* usable_size)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Regions are only ever freed as a whole by ClearFromSpace.
+  size_t Free(Thread*, mirror::Object*) OVERRIDE {
+    return 0;
+  }
+  size_t FreeList(Thread*, size_t, mirror::Object**) OVERRIDE {
+    return 0;
+  }
+
+  // Allocations do not use thread-local buffers.
+  void RevokeThreadLocalBuffers(Thread*) OVERRIDE {
+  }
+  void RevokeAllThreadLocalBuffers() OVERRIDE {
+  }
+
+  accounting::ContinuousSpaceBitmap* GetLiveBitmap() const OVERRIDE {
+    return nullptr;
+  }
+  accounting::ContinuousSpaceBitmap* GetMarkBitmap() const OVERRIDE {
+    return nullptr;
+  }
+
+  // Reset the space to empty.
+  void Clear() OVERRIDE LOCKS_EXCLUDED(region_lock_);
+
+  void Dump(std::ostream& os) const;
+  void DumpRegions(std::ostream& os) LOCKS_EXCLUDED(region_lock_);
+
+  uint64_t GetBytesAllocated() LOCKS_EXCLUDED(region_lock_);
+  uint64_t GetObjectsAllocated() LOCKS_EXCLUDED(region_lock_);
+
+  bool CanMoveObjects() const OVERRIDE {
+    return true;
+  }
+
+  bool Contains(const mirror::Object* obj) const {
+    const byte* byte_obj = reinterpret_cast<const byte*>(obj);
+    return byte_obj >= Begin() && byte_obj < Limit();
+  }
+
+  RegionSpace* AsRegionSpace() OVERRIDE {
+    return this;
+  }
+
+  // Go through all of the regions and visit the continuous objects.
+  void Walk(ObjectCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(region_lock_);
+
+  accounting::ContinuousSpaceBitmap::SweepCallback* GetSweepCallback() OVERRIDE;
+
+  // Record that the marking found num_bytes live in the region of ref. Thread safe.
+  void AddLiveBytes(mirror::Object* ref, size_t num_bytes);
+  // Forget the liveness of the previous mark, called before marking starts.
+  void ClearLiveBytes() LOCKS_EXCLUDED(region_lock_);
+
+  // Turn every allocated region into from-space. Regions whose live bytes are below
+  // evacuation_threshold of their allocated bytes are to be evacuated, the others are kept in
+  // place as unevacuated from-space. Allocations go to new to-space regions from now on. Called
+  // with the mutators suspended, returns the number of regions to evacuate.
+  size_t SetFromSpace(float evacuation_threshold) LOCKS_EXCLUDED(region_lock_);
+  // Free the evacuated regions and turn the unevacuated ones back into to-space. Returns how much
+  // was freed so that the collector can record it.
+  void ClearFromSpace(uint64_t* freed_bytes, uint64_t* freed_objects)
+      LOCKS_EXCLUDED(region_lock_);
+
+  // Keep the region of obj in place until obj is unpinned, a pinned region is never evacuated.
+  // Used by JNI critical sections, which only need to hold up the regions they point into rather
+  // than every moving collection. The caller must have read obj after the last flip.
+  void PinObject(mirror::Object* obj) LOCKS_EXCLUDED(region_lock_);
+  void UnpinObject(mirror::Object* obj) LOCKS_EXCLUDED(region_lock_);
+  bool IsPinned(mirror::Object* obj) LOCKS_EXCLUDED(region_lock_);
+
+  // Whether ref is in a region being evacuated.
+  bool IsInFromSpace(const mirror::Object* ref) const {
+    return Contains(ref) && RefToRegion(ref)->IsInFromSpace();
+  }
+  // Whether ref is in a from-space region which stays in place.
+  bool IsInUnevacFromSpace(const mirror::Object* ref) const {
+    return Contains(ref) && RefToRegion(ref)->IsInUnevacFromSpace();
+  }
+  bool IsInToSpace(const mirror::Object* ref) const {
+    return Contains(ref) && RefToRegion(ref)->IsInToSpace();
+  }
+
+  size_t GetNumRegions() const {
+    return num_regions_;
+  }
+  // Number of regions which are neither free nor the tail of a large object.
+  size_t GetNumAllocatedRegions() LOCKS_EXCLUDED(region_lock_);
+
+  // Object alignment within the space.
+  static constexpr size_t kAlignment = kObjectAlignment;
+  // The region size.
+  static constexpr size_t kRegionSize = 256 * KB;
+  // Regions which are less than this fraction live are evacuated by default.
+  static constexpr float kDefaultEvacuationThreshold = 0.75f;
+
+ private:
+  RegionSpace(const std::string& name, MemMap* mem_map);
+
+  enum RegionState {
+    kRegionStateFree,       // Free region.
+    kRegionStateAllocated,  // Allocated region.
+    kRegionStateLarge,      // Large allocated (allocation larger than the region size).
+    kRegionStateLargeTail,  // Large tail (non-first regions of a large allocation).
+  };
+
+  enum RegionType {
+    kRegionTypeNone,             // Free region.
+    kRegionTypeToSpace,          // Allocated into since the last evacuation.
+    kRegionTypeFromSpace,        // Being evacuated.
+    kRegionTypeUnevacFromSpace,  // From-space region which is not evacuated.
+  };
+
+  class Region {
+   public:
+    Region()
+        : idx_(static_cast<size_t>(-1)), begin_(nullptr), top_(nullptr), end_(nullptr),
+          state_(kRegionStateAllocated), type_(kRegionTypeToSpace), pin_count_(0) {}
+
+    void Init(size_t idx, byte* begin, byte* end) {
+      idx_ = idx;
+      begin_ = begin;
+      top_ = begin;
+      end_ = end;
+      state_ = kRegionStateFree;
+      type_ = kRegionTypeNone;
+      objects_allocated_ = 0;
+      live_bytes_ = 0;
+      pin_count_ = 0;
+    }
+
+    // Release the pages of the region and make it free again.
+    void Clear();
+
+    // Bump pointer allocation within the region, returns nullptr if the region is full.
+    mirror::Object* Alloc(size_t num_bytes) ALWAYS_INLINE;
+
+    void Unfree(RegionState state) {
+      DCHECK(IsFree());
+      state_ = state;
+      type_ = kRegionTypeToSpace;
+    }
+
+    size_t Idx() const {
+      return idx_;
+    }
+    byte* Begin() const {
+      return begin_;
+    }
+    byte* Top() const {
+      return top_;
+    }
+    void SetTop(byte* new_top) {
+      top_ = new_top;
+    }
+    byte* End() const {
+      return end_;
+    }
+    size_t BytesAllocated() const {
+      return top_ - begin_;
+    }
+    size_t ObjectsAllocated() const {
+      return objects_allocated_.Load();
+    }
+    void SetObjectsAllocated(size_t objects) {
+      objects_allocated_ = objects;
+    }
+    size_t LiveBytes() const {
+      return live_bytes_.Load();
+    }
+    void AddLiveBytes(size_t num_bytes) {
+      live_bytes_.FetchAndAdd(num_bytes);
+    }
+    void ClearLiveBytes() {
+      live_bytes_ = 0;
+    }
+
+    bool IsPinned() const {
+      return pin_count_ != 0;
+    }
+    void Pin() {
+      ++pin_count_;
+    }
+    void Unpin() {
+      DCHECK_NE(pin_count_, 0U);
+      --pin_count_;
+    }
+
+    bool IsFree() const {
+      return state_ == kRegionStateFree;
+    }
+    bool IsLarge() const {
+      return state_ == kRegionStateLarge;
+    }
+    bool IsLargeTail() const {
+      return state_ == kRegionStateLargeTail;
+    }
+    bool IsInFromSpace() const {
+      return type_ == kRegionTypeFromSpace;
+    }
+    bool IsInUnevacFromSpace() const {
+      return type_ == kRegionTypeUnevacFromSpace;
+    }
+    bool IsInToSpace() const {
+      return type_ == kRegionTypeToSpace;
+    }
+    void SetType(RegionType type) {
+      type_ = type;
+    }
+
+    void Dump(std::ostream& os) const;
+
+   private:
+    size_t idx_;              // The region's index in the region space.
+    byte* begin_;             // The begin address of the region.
+    byte* volatile top_;      // The current position of the allocation.
+    byte* end_;               // The end address of the region.
+    RegionState state_;       // The region state (see RegionState).
+    RegionType type_;         // The region type (see RegionType).
+    Atomic<size_t> objects_allocated_;  // The number of objects allocated.
+    Atomic<size_t> live_bytes_;         // The live bytes found by the last mark.
+    size_t pin_count_;        // The number of pins of objects in the region.
+  };
+
+  Region* RefToRegion(const mirror::Object* ref) const {
+    DCHECK(Contains(ref));
+    const size_t idx = (reinterpret_cast<const byte*>(ref) - Begin()) / kRegionSize;
+    DCHECK_LT(idx, num_regions_);
+    return &regions_[idx];
+  }
+
+  // Allocate a run of contiguous free regions for an object larger than a region.
+  mirror::Object* AllocLarge(size_t num_bytes) LOCKS_EXCLUDED(region_lock_);
+  // Return the object which comes after obj, while ensuring alignment.
+  static mirror::Object* GetNextObject(mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  Mutex region_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+
+  const size_t num_regions_;
+  // The regions, their states are only changed with region_lock_ held.
+  UniquePtr<Region[]> regions_;
+  size_t num_non_free_regions_ GUARDED_BY(region_lock_);
+  // The region currently allocated into. Never null, it points to full_region_ when there is no
+  // current region so that the allocation fast path does not need a null check.
+  Region* current_region_;
+  // A dummy region which is always full.
+  Region full_region_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegionSpace);
+};
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_REGION_SPACE_H_
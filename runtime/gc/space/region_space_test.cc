@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "region_space.h"
+#include "region_space-inl.h"
+
+#include "common_runtime_test.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+class RegionSpaceTest : public CommonRuntimeTest {};
+
+TEST_F(RegionSpaceTest, SelectiveEvacuation) {
+  static constexpr size_t kNumRegions = 16;
+  static constexpr size_t kObjectSize = 1 * KB;
+  static constexpr size_t kObjectsPerRegion = RegionSpace::kRegionSize / kObjectSize;
+  Thread* self = Thread::Current();
+  UniquePtr<RegionSpace> space(
+      RegionSpace::Create("test region space", kNumRegions * RegionSpace::kRegionSize, nullptr));
+  ASSERT_TRUE(space.get() != nullptr);
+  EXPECT_EQ(kNumRegions, space->GetNumRegions());
+  EXPECT_EQ(0U, space->GetNumAllocatedRegions());
+
+  // Fill up two regions.
+  std::vector<mirror::Object*> objects;
+  for (size_t i = 0; i < 2 * kObjectsPerRegion; ++i) {
+    size_t bytes_allocated = 0;
+    mirror::Object* obj = space->Alloc(self, kObjectSize, &bytes_allocated, nullptr);
+    ASSERT_TRUE(obj != nullptr);
+    EXPECT_EQ(kObjectSize, bytes_allocated);
+    objects.push_back(obj);
+  }
+  EXPECT_EQ(2U, space->GetNumAllocatedRegions());
+  EXPECT_EQ(2 * RegionSpace::kRegionSize, space->GetBytesAllocated());
+  EXPECT_EQ(2 * kObjectsPerRegion, space->GetObjectsAllocated());
+  mirror::Object* dense_obj = objects.front();
+  mirror::Object* sparse_obj = objects.back();
+
+  // A large object spanning several regions, which the mark finds dead.
+  size_t bytes_allocated = 0;
+  mirror::Object* large_obj = space->Alloc(self, 3 * RegionSpace::kRegionSize - kObjectSize,
+                                           &bytes_allocated, nullptr);
+  ASSERT_TRUE(large_obj != nullptr);
+  EXPECT_EQ(3U, space->GetNumAllocatedRegions());
+
+  // The first region is entirely live, only one object of the second one is.
+  space->ClearLiveBytes();
+  for (size_t i = 0; i < kObjectsPerRegion; ++i) {
+    space->AddLiveBytes(objects[i], kObjectSize);
+  }
+  space->AddLiveBytes(sparse_obj, kObjectSize);
+
+  EXPECT_EQ(2U, space->SetFromSpace(RegionSpace::kDefaultEvacuationThreshold));
+  EXPECT_TRUE(space->IsInUnevacFromSpace(dense_obj));
+  EXPECT_TRUE(space->IsInFromSpace(sparse_obj));
+  EXPECT_TRUE(space->IsInFromSpace(large_obj));
+
+  // New allocations go to a new to-space region.
+  mirror::Object* new_obj = space->Alloc(self, kObjectSize, &bytes_allocated, nullptr);
+  ASSERT_TRUE(new_obj != nullptr);
+  EXPECT_TRUE(space->IsInToSpace(new_obj));
+
+  uint64_t freed_bytes = 0;
+  uint64_t freed_objects = 0;
+  space->ClearFromSpace(&freed_bytes, &freed_objects);
+  EXPECT_EQ(RegionSpace::kRegionSize + 3 * RegionSpace::kRegionSize - kObjectSize, freed_bytes);
+  EXPECT_EQ(kObjectsPerRegion + 1, freed_objects);
+  // The dense region stays in place and becomes to-space again.
+  EXPECT_TRUE(space->IsInToSpace(dense_obj));
+  EXPECT_EQ(2U, space->GetNumAllocatedRegions());
+  EXPECT_EQ(RegionSpace::kRegionSize + kObjectSize, space->GetBytesAllocated());
+}
+
+TEST_F(RegionSpaceTest, PinnedRegionsStayInPlace) {
+  static constexpr size_t kObjectSize = 1 * KB;
+  Thread* self = Thread::Current();
+  UniquePtr<RegionSpace> space(
+      RegionSpace::Create("test region space", 8 * RegionSpace::kRegionSize, nullptr));
+  ASSERT_TRUE(space.get() != nullptr);
+
+  size_t bytes_allocated = 0;
+  mirror::Object* obj = space->Alloc(self, kObjectSize, &bytes_allocated, nullptr);
+  ASSERT_TRUE(obj != nullptr);
+  mirror::Object* large_obj = space->Alloc(self, 2 * RegionSpace::kRegionSize, &bytes_allocated,
+                                           nullptr);
+  ASSERT_TRUE(large_obj != nullptr);
+
+  // Both regions are dead, but pinned until the second collection.
+  space->PinObject(obj);
+  space->PinObject(obj);
+  space->PinObject(large_obj);
+  EXPECT_TRUE(space->IsPinned(obj));
+  space->ClearLiveBytes();
+  EXPECT_EQ(0U, space->SetFromSpace(RegionSpace::kDefaultEvacuationThreshold));
+  EXPECT_TRUE(space->IsInUnevacFromSpace(obj));
+  EXPECT_TRUE(space->IsInUnevacFromSpace(large_obj));
+  uint64_t freed_bytes = 0;
+  uint64_t freed_objects = 0;
+  space->ClearFromSpace(&freed_bytes, &freed_objects);
+  EXPECT_EQ(0U, freed_bytes);
+  EXPECT_TRUE(space->IsInToSpace(obj));
+
+  space->UnpinObject(obj);
+  space->UnpinObject(large_obj);
+  EXPECT_TRUE(space->IsPinned(obj));
+  space->ClearLiveBytes();
+  EXPECT_EQ(1U, space->SetFromSpace(RegionSpace::kDefaultEvacuationThreshold));
+  EXPECT_TRUE(space->IsInUnevacFromSpace(obj));
+  EXPECT_TRUE(space->IsInFromSpace(large_obj));
+
+  space->UnpinObject(obj);
+  EXPECT_FALSE(space->IsPinned(obj));
+  space->ClearFromSpace(&freed_bytes, &freed_objects);
+  space->ClearLiveBytes();
+  EXPECT_EQ(1U, space->SetFromSpace(RegionSpace::kDefaultEvacuationThreshold));
+  EXPECT_TRUE(space->IsInFromSpace(obj));
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
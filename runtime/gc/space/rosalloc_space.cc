@@ -47,17 +47,20 @@ RosAllocSpace::RosAllocSpace(const std::string& name, MemMap* mem_map,
                              size_t starting_size, size_t initial_size, bool low_memory_mode)
     : MallocSpace(name, mem_map, begin, end, limit, growth_limit, true, can_move_objects,
                   starting_size, initial_size),
-      rosalloc_(rosalloc), low_memory_mode_(low_memory_mode) {
+      rosalloc_(rosalloc), low_memory_mode_(low_memory_mode), trim_in_progress_(false),
+      trim_page_idx_(0) {
   CHECK(rosalloc != nullptr);
 }
 
 RosAllocSpace* RosAllocSpace::CreateFromMemMap(MemMap* mem_map, const std::string& name,
                                                size_t starting_size, size_t initial_size,
                                                size_t growth_limit, size_t capacity,
-                                               bool low_memory_mode, bool can_move_objects) {
+                                               bool low_memory_mode, bool can_move_objects,
+                                               size_t num_thread_local_size_brackets) {
   DCHECK(mem_map != nullptr);
   allocator::RosAlloc* rosalloc = CreateRosAlloc(mem_map->Begin(), starting_size, initial_size,
-                                                 capacity, low_memory_mode);
+                                                 capacity, low_memory_mode,
+                                                 num_thread_local_size_brackets);
   if (rosalloc == NULL) {
     LOG(ERROR) << "Failed to initialize rosalloc for alloc space (" << name << ")";
     return NULL;
@@ -87,7 +90,8 @@ RosAllocSpace::~RosAllocSpace() {
 
 RosAllocSpace* RosAllocSpace::Create(const std::string& name, size_t initial_size,
                                      size_t growth_limit, size_t capacity, byte* requested_begin,
-                                     bool low_memory_mode, bool can_move_objects) {
+                                     bool low_memory_mode, bool can_move_objects,
+                                     size_t num_thread_local_size_brackets) {
   uint64_t start_time = 0;
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     start_time = NanoTime();
@@ -113,7 +117,7 @@ RosAllocSpace* RosAllocSpace::Create(const std::string& name, size_t initial_siz
 
   RosAllocSpace* space = CreateFromMemMap(mem_map, name, starting_size, initial_size,
                                           growth_limit, capacity, low_memory_mode,
-                                          can_move_objects);
+                                          can_move_objects, num_thread_local_size_brackets);
   // We start out with only the initial size possibly containing objects.
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "RosAllocSpace::Create exiting (" << PrettyDuration(NanoTime() - start_time)
@@ -124,7 +128,8 @@ RosAllocSpace* RosAllocSpace::Create(const std::string& name, size_t initial_siz
 
 allocator::RosAlloc* RosAllocSpace::CreateRosAlloc(void* begin, size_t morecore_start,
                                                    size_t initial_size,
-                                                   size_t maximum_size, bool low_memory_mode) {
+                                                   size_t maximum_size, bool low_memory_mode,
+                                                   size_t num_thread_local_size_brackets) {
   // clear errno to allow PLOG on error
   errno = 0;
   // create rosalloc using our backing storage starting at begin and
@@ -134,7 +139,9 @@ allocator::RosAlloc* RosAllocSpace::CreateRosAlloc(void* begin, size_t morecore_
       begin, morecore_start, maximum_size,
       low_memory_mode ?
           art::gc::allocator::RosAlloc::kPageReleaseModeAll :
-          art::gc::allocator::RosAlloc::kPageReleaseModeSizeAndEnd);
+          art::gc::allocator::RosAlloc::kPageReleaseModeSizeAndEnd,
+      art::gc::allocator::RosAlloc::kDefaultPageReleaseSizeThreshold,
+      num_thread_local_size_brackets);
   if (rosalloc != NULL) {
     rosalloc->SetFootprintLimit(initial_size);
   } else {
@@ -247,6 +254,25 @@ size_t RosAllocSpace::Trim() {
   return 0;
 }
 
+size_t RosAllocSpace::TrimSlice(uint64_t deadline_ns, bool* finished) {
+  if (!trim_in_progress_) {
+    {
+      MutexLock mu(Thread::Current(), lock_);
+      // Trim to release memory at the end of the space.
+      rosalloc_->Trim();
+    }
+    if (rosalloc_->DoesReleaseAllPages()) {
+      *finished = true;
+      return 0;
+    }
+    trim_in_progress_ = true;
+    trim_page_idx_ = 0;
+  }
+  size_t reclaimed = rosalloc_->ReleasePages(&trim_page_idx_, deadline_ns, finished);
+  trim_in_progress_ = !*finished;
+  return reclaimed;
+}
+
 void RosAllocSpace::Walk(void(*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                          void* arg) {
   InspectAllRosAlloc(callback, arg, true);
@@ -350,9 +376,10 @@ void RosAllocSpace::Clear() {
   live_bitmap_->Clear();
   mark_bitmap_->Clear();
   end_ = begin_ + starting_size_;
+  const size_t num_thread_local_size_brackets = rosalloc_->NumThreadLocalSizeBrackets();
   delete rosalloc_;
   rosalloc_ = CreateRosAlloc(mem_map_->Begin(), starting_size_, initial_size_, Capacity(),
-                             low_memory_mode_);
+                             low_memory_mode_, num_thread_local_size_brackets);
   SetFootprintLimit(footprint_limit);
 }
 
@@ -40,11 +40,15 @@ class RosAllocSpace : public MallocSpace {
   // request was granted.
   static RosAllocSpace* Create(const std::string& name, size_t initial_size, size_t growth_limit,
                                size_t capacity, byte* requested_begin, bool low_memory_mode,
-                               bool can_move_objects);
+                               bool can_move_objects,
+                               size_t num_thread_local_size_brackets =
+                                   allocator::RosAlloc::kDefaultNumThreadLocalSizeBrackets);
   static RosAllocSpace* CreateFromMemMap(MemMap* mem_map, const std::string& name,
                                          size_t starting_size, size_t initial_size,
                                          size_t growth_limit, size_t capacity,
-                                         bool low_memory_mode, bool can_move_objects);
+                                         bool low_memory_mode, bool can_move_objects,
+                                         size_t num_thread_local_size_brackets =
+                                         allocator::RosAlloc::kDefaultNumThreadLocalSizeBrackets);
 
   mirror::Object* AllocWithGrowth(Thread* self, size_t num_bytes, size_t* bytes_allocated,
                                   size_t* usable_size) OVERRIDE LOCKS_EXCLUDED(lock_);
@@ -85,6 +89,7 @@ class RosAllocSpace : public MallocSpace {
   }
 
   size_t Trim() OVERRIDE;
+  size_t TrimSlice(uint64_t deadline_ns, bool* finished) OVERRIDE;
   void Walk(WalkCallback callback, void* arg) OVERRIDE LOCKS_EXCLUDED(lock_);
   size_t GetFootprint() OVERRIDE;
   size_t GetFootprintLimit() OVERRIDE;
@@ -114,8 +119,8 @@ class RosAllocSpace : public MallocSpace {
     return this;
   }
 
-  void Verify() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    rosalloc_->Verify();
+  void Verify(ThreadPool* thread_pool = nullptr) EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    rosalloc_->Verify(thread_pool);
   }
 
   virtual ~RosAllocSpace();
@@ -132,10 +137,12 @@ class RosAllocSpace : public MallocSpace {
 
   void* CreateAllocator(void* base, size_t morecore_start, size_t initial_size,
                         size_t maximum_size, bool low_memory_mode) OVERRIDE {
-    return CreateRosAlloc(base, morecore_start, initial_size, maximum_size, low_memory_mode);
+    return CreateRosAlloc(base, morecore_start, initial_size, maximum_size, low_memory_mode,
+                          rosalloc_->NumThreadLocalSizeBrackets());
   }
   static allocator::RosAlloc* CreateRosAlloc(void* base, size_t morecore_start, size_t initial_size,
-                                             size_t maximum_size, bool low_memory_mode);
+                                             size_t maximum_size, bool low_memory_mode,
+                                             size_t num_thread_local_size_brackets);
 
   void InspectAllRosAlloc(void (*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                           void* arg, bool do_null_callback_at_end)
@@ -150,6 +157,10 @@ class RosAllocSpace : public MallocSpace {
 
   const bool low_memory_mode_;
 
+  // The page TrimSlice resumes releasing pages from, only used by the thread trimming the heap.
+  bool trim_in_progress_;
+  size_t trim_page_idx_;
+
   friend class collector::MarkSweep;
 
   DISALLOW_COPY_AND_ASSIGN(RosAllocSpace);
@@ -47,6 +47,7 @@ class MallocSpace;
 class DlMallocSpace;
 class RosAllocSpace;
 class ImageSpace;
+class RegionSpace;
 class LargeObjectSpace;
 class ZygoteSpace;
 
@@ -70,6 +71,7 @@ enum SpaceType {
   kSpaceTypeZygoteSpace,
   kSpaceTypeBumpPointerSpace,
   kSpaceTypeLargeObjectSpace,
+  kSpaceTypeRegionSpace,
 };
 std::ostream& operator<<(std::ostream& os, const SpaceType& space_type);
 
@@ -130,6 +132,12 @@ class Space {
   }
   virtual BumpPointerSpace* AsBumpPointerSpace();
 
+  // Is this space a region space?
+  bool IsRegionSpace() const {
+    return GetType() == kSpaceTypeRegionSpace;
+  }
+  virtual RegionSpace* AsRegionSpace();
+
   // Does this space hold large objects and implement the large object space abstraction?
   bool IsLargeObjectSpace() const {
     return GetType() == kSpaceTypeLargeObjectSpace;
@@ -174,10 +182,13 @@ class Space {
  protected:
   struct SweepCallbackContext {
    public:
-    SweepCallbackContext(bool swap_bitmaps, space::Space* space);
+    SweepCallbackContext(bool swap_bitmaps, space::Space* space, bool on_gc_worker = false);
     const bool swap_bitmaps;
     space::Space* const space;
     Thread* const self;
+    // True when sweeping on a GC worker thread, in which case the thread running the GC holds the
+    // heap bitmap lock on our behalf.
+    const bool on_gc_worker;
     size_t freed_objects;
     size_t freed_bytes;
   };
@@ -416,8 +427,15 @@ class ContinuousMemMapAllocSpace : public MemMapSpace, public AllocSpace {
   }
 
   void Sweep(bool swap_bitmaps, size_t* freed_objects, size_t* freed_bytes);
+  // Sweep the objects in [sweep_begin, sweep_end). Several GC worker threads may sweep disjoint
+  // ranges of the same space at once as long as the range bounds are aligned to
+  // kSweepRangeAlignment, so that no two threads clear bits in the same live bitmap word.
+  void SweepRange(bool swap_bitmaps, uintptr_t sweep_begin, uintptr_t sweep_end,
+                  bool on_gc_worker, size_t* freed_objects, size_t* freed_bytes);
   virtual accounting::ContinuousSpaceBitmap::SweepCallback* GetSweepCallback() = 0;
 
+  static constexpr size_t kSweepRangeAlignment = kPageSize;
+
  protected:
   UniquePtr<accounting::ContinuousSpaceBitmap> live_bitmap_;
   UniquePtr<accounting::ContinuousSpaceBitmap> mark_bitmap_;
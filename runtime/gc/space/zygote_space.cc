@@ -100,7 +100,9 @@ void ZygoteSpace::SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* ar
   SweepCallbackContext* context = static_cast<SweepCallbackContext*>(arg);
   DCHECK(context->space->IsZygoteSpace());
   ZygoteSpace* zygote_space = context->space->AsZygoteSpace();
-  Locks::heap_bitmap_lock_->AssertExclusiveHeld(context->self);
+  if (!context->on_gc_worker) {
+    Locks::heap_bitmap_lock_->AssertExclusiveHeld(context->self);
+  }
   accounting::CardTable* card_table = Runtime::Current()->GetHeap()->GetCardTable();
   // If the bitmaps aren't swapped we need to clear the bits since the GC isn't going to re-swap
   // the bitmaps as an optimization.
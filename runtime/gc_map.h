@@ -36,6 +36,11 @@ class NativePcOffsetToReferenceMap {
     return data_[2] | (data_[3] << 8);
   }
 
+  // The size in bytes of the header and the table.
+  size_t EncodedSize() const {
+    return 4u + NumEntries() * EntryWidth();
+  }
+
   // Return address of bitmap encoding what are live references.
   const uint8_t* GetBitMap(size_t index) const {
     size_t entry_offset = index * EntryWidth();
@@ -15,27 +15,32 @@
  */
 
 /*
- * Preparation and completion of hprof data generation.  The output is
- * written into two files and then combined.  This is necessary because
- * we generate some of the data (strings and classes) while we dump the
- * heap, and some analysis tools require that the class and string data
- * appear first.
+ * Preparation and completion of hprof data generation.  Some analysis
+ * tools require that the string and class data appear first, but we
+ * find the strings and classes while we dump the heap.  A dump sent to
+ * DDMS buffers the body while it writes the header.  A dump written to
+ * a file walks the heap twice instead, once to find the strings and
+ * classes and once to stream the body to the file, so that the dump
+ * doesn't need memory proportional to the heap.
  */
 
 #include "hprof.h"
 
-#include <cutils/open_memstream.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/uio.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <set>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/stringprintf.h"
@@ -170,6 +175,179 @@ enum HprofBasicType {
 typedef uint32_t HprofStringId;
 typedef uint32_t HprofClassObjectId;
 
+// Where the serialized records of a heap dump go.
+class HprofOutput {
+ public:
+  HprofOutput() : size_(0) {}
+
+  virtual ~HprofOutput() {}
+
+  bool Write(const void* data, size_t length) {
+    size_ += length;
+    return DoWrite(data, length);
+  }
+
+  // Writes out what is buffered. Returns false if any write failed.
+  virtual bool Finish() {
+    return true;
+  }
+
+  // The number of bytes written, before any compression.
+  size_t Size() const {
+    return size_;
+  }
+
+ protected:
+  virtual bool DoWrite(const void* data, size_t length) = 0;
+
+ private:
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofOutput);
+};
+
+// Drops the records, for the walk that only finds the strings and classes.
+class HprofNullOutput : public HprofOutput {
+ public:
+  HprofNullOutput() {}
+
+ protected:
+  bool DoWrite(const void* /*data*/, size_t /*length*/) OVERRIDE {
+    return true;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HprofNullOutput);
+};
+
+// Keeps the records in memory.
+class HprofBufferOutput : public HprofOutput {
+ public:
+  HprofBufferOutput() {}
+
+  const std::vector<uint8_t>& GetData() const {
+    return data_;
+  }
+
+ protected:
+  bool DoWrite(const void* data, size_t length) OVERRIDE {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), bytes, bytes + length);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofBufferOutput);
+};
+
+// Writes the records to a file in chunks of kChunkSize bytes, gzip compressed if requested. The
+// first failed write is remembered and later writes are dropped.
+class HprofFileOutput : public HprofOutput {
+ public:
+  static constexpr size_t kChunkSize = 64 * KB;
+
+  HprofFileOutput(File* file, bool compress)
+      : file_(file), compress_(compress), chunk_(new uint8_t[kChunkSize]), chunk_length_(0),
+        error_(0) {
+    if (compress_) {
+      memset(&stream_, 0, sizeof(stream_));
+      // Favor speed, the dump is taken with the threads suspended. A window of 15 bits plus 16
+      // asks for a gzip header.
+      if (deflateInit2(&stream_, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        compress_ = false;
+        error_ = ENOMEM;
+      }
+    }
+  }
+
+  ~HprofFileOutput() {
+    if (compress_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  bool Finish() OVERRIDE {
+    if (compress_ && error_ == 0) {
+      stream_.next_in = nullptr;
+      stream_.avail_in = 0;
+      Deflate(Z_FINISH);
+    }
+    if (chunk_length_ != 0) {
+      WriteChunk();
+    }
+    return error_ == 0;
+  }
+
+  // The errno of the first failed write, 0 if none failed.
+  int GetError() const {
+    return error_;
+  }
+
+ protected:
+  bool DoWrite(const void* data, size_t length) OVERRIDE {
+    if (error_ != 0) {
+      return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    if (compress_) {
+      stream_.next_in = const_cast<uint8_t*>(bytes);
+      stream_.avail_in = length;
+      return Deflate(Z_NO_FLUSH);
+    }
+    while (length != 0) {
+      size_t count = std::min(length, kChunkSize - chunk_length_);
+      memcpy(&chunk_[chunk_length_], bytes, count);
+      chunk_length_ += count;
+      bytes += count;
+      length -= count;
+      if (chunk_length_ == kChunkSize && !WriteChunk()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Compresses the pending input into the chunk, writing the chunk out whenever it fills up.
+  bool Deflate(int flush) {
+    int rc;
+    do {
+      stream_.next_out = &chunk_[chunk_length_];
+      stream_.avail_out = kChunkSize - chunk_length_;
+      rc = deflate(&stream_, flush);
+      chunk_length_ = kChunkSize - stream_.avail_out;
+      if (rc == Z_STREAM_ERROR) {
+        error_ = EIO;
+        return false;
+      }
+      if (chunk_length_ == kChunkSize && !WriteChunk()) {
+        return false;
+      }
+    } while (stream_.avail_in != 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+    return true;
+  }
+
+  bool WriteChunk() {
+    if (!file_->WriteFully(&chunk_[0], chunk_length_)) {
+      error_ = errno;
+      return false;
+    }
+    chunk_length_ = 0;
+    return true;
+  }
+
+  File* const file_;
+  bool compress_;
+  z_stream stream_;
+  UniquePtr<uint8_t[]> chunk_;
+  size_t chunk_length_;
+  int error_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofFileOutput);
+};
+
 // Represents a top-level hprof record, whose serialized format is:
 // U1  TAG: denoting the type of the record
 // U4  TIME: number of microseconds since the time stamp in the header
@@ -177,7 +355,8 @@ typedef uint32_t HprofClassObjectId;
 // U1* BODY: as many bytes as specified in the above uint32_t field
 class HprofRecord {
  public:
-  HprofRecord() : alloc_length_(128), fp_(nullptr), tag_(0), time_(0), length_(0), dirty_(false) {
+  HprofRecord()
+      : alloc_length_(128), output_(nullptr), tag_(0), time_(0), length_(0), dirty_(false) {
     body_ = reinterpret_cast<unsigned char*>(malloc(alloc_length_));
   }
 
@@ -185,13 +364,13 @@ class HprofRecord {
     free(body_);
   }
 
-  int StartNewRecord(FILE* fp, uint8_t tag, uint32_t time) {
+  int StartNewRecord(HprofOutput* output, uint8_t tag, uint32_t time) {
     int rc = Flush();
     if (rc != 0) {
       return rc;
     }
 
-    fp_ = fp;
+    output_ = output;
     tag_ = tag;
     time_ = time;
     length_ = 0;
@@ -207,12 +386,10 @@ class HprofRecord {
       U4_TO_BUF_BE(headBuf, 1, time_);
       U4_TO_BUF_BE(headBuf, 5, length_);
 
-      int nb = fwrite(headBuf, 1, sizeof(headBuf), fp_);
-      if (nb != sizeof(headBuf)) {
+      if (!output_->Write(headBuf, sizeof(headBuf))) {
         return UNIQUE_ERROR;
       }
-      nb = fwrite(body_, 1, length_, fp_);
-      if (nb != static_cast<int>(length_)) {
+      if (!output_->Write(body_, length_)) {
         return UNIQUE_ERROR;
       }
 
@@ -371,7 +548,7 @@ class HprofRecord {
   size_t alloc_length_;
   unsigned char* body_;
 
-  FILE* fp_;
+  HprofOutput* output_;
   uint8_t tag_;
   uint32_t time_;
   size_t length_;
@@ -382,117 +559,70 @@ class HprofRecord {
 
 class Hprof {
  public:
-  Hprof(const char* output_filename, int fd, bool direct_to_ddms)
+  // Writes to out_fd, which the dump owns, unless direct_to_ddms is set.
+  Hprof(const char* output_filename, int out_fd, bool direct_to_ddms, bool compress)
       : filename_(output_filename),
-        fd_(fd),
+        out_fd_(out_fd),
         direct_to_ddms_(direct_to_ddms),
-        start_ns_(NanoTime()),
+        compress_(compress),
         current_record_(),
         gc_thread_serial_number_(0),
         gc_scan_state_(0),
         current_heap_(HPROF_HEAP_DEFAULT),
         objects_in_segment_(0),
-        header_fp_(NULL),
-        header_data_ptr_(NULL),
-        header_data_size_(0),
-        body_fp_(NULL),
-        body_data_ptr_(NULL),
-        body_data_size_(0),
+        header_output_(nullptr),
+        body_output_(nullptr),
+        size_(0),
         next_string_id_(0x400000) {
-    LOG(INFO) << "hprof: heap dump \"" << filename_ << "\" starting...";
-
-    header_fp_ = open_memstream(&header_data_ptr_, &header_data_size_);
-    if (header_fp_ == NULL) {
-      PLOG(FATAL) << "header open_memstream failed";
-    }
-
-    body_fp_ = open_memstream(&body_data_ptr_, &body_data_size_);
-    if (body_fp_ == NULL) {
-      PLOG(FATAL) << "body open_memstream failed";
-    }
-  }
-
-  ~Hprof() {
-    if (header_fp_ != NULL) {
-      fclose(header_fp_);
-    }
-    if (body_fp_ != NULL) {
-      fclose(body_fp_);
-    }
-    free(header_data_ptr_);
-    free(body_data_ptr_);
   }
 
-  void Dump()
+  // Returns false and sets error_msg if the dump couldn't be written.
+  bool Dump(std::string* error_msg)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
-    // Walk the roots and the heap.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
-    Runtime::Current()->VisitRoots(RootVisitor, this);
-    Thread* self = Thread::Current();
-    {
-      ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
-      Runtime::Current()->GetHeap()->VisitObjects(VisitObjectCallback, this);
-    }
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
-    current_record_.Flush();
-    fflush(body_fp_);
-
-    // Write the header.
-    WriteFixedHeader();
-    // Write the string and class tables, and any stack traces, to the header.
-    // (jhat requires that these appear before any of the data in the body that refers to them.)
-    WriteStringTable();
-    WriteClassTable();
-    WriteStackTraces();
-    current_record_.Flush();
-    fflush(header_fp_);
-
-    bool okay = true;
     if (direct_to_ddms_) {
+      HprofBufferOutput header;
+      HprofBufferOutput body;
+      ProcessHeap(&body);
+      ProcessHeader(&header);
+      size_ = header.Size() + body.Size();
+
       // Send the data off to DDMS.
       iovec iov[2];
-      iov[0].iov_base = header_data_ptr_;
-      iov[0].iov_len = header_data_size_;
-      iov[1].iov_base = body_data_ptr_;
-      iov[1].iov_len = body_data_size_;
+      iov[0].iov_base = const_cast<uint8_t*>(&header.GetData()[0]);
+      iov[0].iov_len = header.Size();
+      iov[1].iov_base = const_cast<uint8_t*>(&body.GetData()[0]);
+      iov[1].iov_len = body.Size();
       Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 2);
-    } else {
-      // Where exactly are we writing to?
-      int out_fd;
-      if (fd_ >= 0) {
-        out_fd = dup(fd_);
-        if (out_fd < 0) {
-          ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd_, strerror(errno));
-          return;
-        }
-      } else {
-        out_fd = open(filename_.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
-        if (out_fd < 0) {
-          ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename_.c_str(),
-                                strerror(errno));
-          return;
-        }
-      }
-
-      UniquePtr<File> file(new File(out_fd, filename_));
-      okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
-          file->WriteFully(body_data_ptr_, body_data_size_);
-      if (!okay) {
-        std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
-                                     filename_.c_str(), strerror(errno)));
-        ThrowRuntimeException("%s", msg.c_str());
-        LOG(ERROR) << msg;
-      }
+      return true;
     }
 
-    // Throw out a log message for the benefit of "runhat".
-    if (okay) {
-      uint64_t duration = NanoTime() - start_ns_;
-      LOG(INFO) << "hprof: heap dump completed ("
-          << PrettySize(header_data_size_ + body_data_size_ + 1023)
-          << ") in " << PrettyDuration(duration);
+    {
+      // Find the strings and classes the header must define before the body refers to them.
+      HprofNullOutput body;
+      ProcessHeap(&body);
+    }
+    UniquePtr<File> file(new File(out_fd_, filename_));
+    HprofFileOutput output(file.get(), compress_);
+    ProcessHeader(&output);
+    size_t num_strings = strings_.size();
+    size_t num_classes = classes_.size();
+    // Nothing runs while the heap is walked, the second walk finds the same strings and classes.
+    ProcessHeap(&output);
+    DCHECK_EQ(num_strings, strings_.size());
+    DCHECK_EQ(num_classes, classes_.size());
+    size_ = output.Size();
+    if (!output.Finish()) {
+      *error_msg = StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s", filename_.c_str(),
+                                strerror(output.GetError()));
+      return false;
     }
+    return true;
+  }
+
+  // The size of the dump, before any compression.
+  size_t Size() const {
+    return size_;
   }
 
  private:
@@ -516,7 +646,33 @@ class Hprof {
 
   int DumpHeapObject(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void Finish() {
+  // Walks the roots and the heap.
+  void ProcessHeap(HprofOutput* output)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
+    body_output_ = output;
+    current_heap_ = HPROF_HEAP_DEFAULT;
+    objects_in_segment_ = 0;
+    current_record_.StartNewRecord(body_output_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    Runtime::Current()->VisitRoots(RootVisitor, this);
+    Thread* self = Thread::Current();
+    {
+      ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+      Runtime::Current()->GetHeap()->VisitObjects(VisitObjectCallback, this);
+    }
+    current_record_.StartNewRecord(body_output_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
+    current_record_.Flush();
+  }
+
+  // Writes the header, then the string and class tables and any stack traces.
+  // (jhat requires that these appear before any of the data in the body that refers to them.)
+  void ProcessHeader(HprofOutput* output) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    header_output_ = output;
+    WriteFixedHeader();
+    WriteStringTable();
+    WriteClassTable();
+    WriteStackTraces();
+    current_record_.Flush();
   }
 
   int WriteClassTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -526,7 +682,7 @@ class Hprof {
     for (mirror::Class* c : classes_) {
       CHECK(c != nullptr);
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
+      int err = current_record_.StartNewRecord(header_output_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
       if (UNLIKELY(err != 0)) {
         return err;
       }
@@ -552,7 +708,7 @@ class Hprof {
       const std::string& string = p.first;
       size_t id = p.second;
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_STRING, HPROF_TIME);
+      int err = current_record_.StartNewRecord(header_output_, HPROF_TAG_STRING, HPROF_TIME);
       if (err != 0) {
         return err;
       }
@@ -576,7 +732,7 @@ class Hprof {
 
   void StartNewHeapDumpSegment() {
     // This flushes the old segment and starts a new one.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    current_record_.StartNewRecord(body_output_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
     objects_in_segment_ = 0;
 
     // Starting a new HEAP_DUMP resets the heap to default.
@@ -632,11 +788,11 @@ class Hprof {
 
     // Write the file header.
     // U1: NUL-terminated magic string.
-    fwrite(magic, 1, sizeof(magic), header_fp_);
+    header_output_->Write(magic, sizeof(magic));
 
     // U4: size of identifiers.  We're using addresses as IDs, so make sure a pointer fits.
     U4_TO_BUF_BE(buf, 0, sizeof(void*));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    header_output_->Write(buf, sizeof(uint32_t));
 
     // The current time, in milliseconds since 0:00 GMT, 1/1/70.
     timeval now;
@@ -649,29 +805,27 @@ class Hprof {
 
     // U4: high word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs >> 32));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    header_output_->Write(buf, sizeof(uint32_t));
 
     // U4: low word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs & 0xffffffffULL));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);  // xxx fix the time
+    header_output_->Write(buf, sizeof(uint32_t));  // xxx fix the time
   }
 
   void WriteStackTraces() {
     // Write a dummy stack trace record so the analysis tools don't freak out.
-    current_record_.StartNewRecord(header_fp_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
+    current_record_.StartNewRecord(header_output_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
     current_record_.AddU4(HPROF_NULL_STACK_TRACE);
     current_record_.AddU4(HPROF_NULL_THREAD);
     current_record_.AddU4(0);    // no frames
   }
 
-  // If direct_to_ddms_ is set, "filename_" and "fd" will be ignored.
-  // Otherwise, "filename_" must be valid, though if "fd" >= 0 it will
-  // only be used for debug messages.
+  // If direct_to_ddms_ is set, "filename_" and "out_fd_" will be ignored.
+  // Otherwise "filename_" is only used for debug messages.
   std::string filename_;
-  int fd_;
+  int out_fd_;
   bool direct_to_ddms_;
-
-  uint64_t start_ns_;
+  bool compress_;
 
   HprofRecord current_record_;
 
@@ -680,13 +834,9 @@ class Hprof {
   HprofHeapId current_heap_;  // Which heap we're currently dumping.
   size_t objects_in_segment_;
 
-  FILE* header_fp_;
-  char* header_data_ptr_;
-  size_t header_data_size_;
-
-  FILE* body_fp_;
-  char* body_data_ptr_;
-  size_t body_data_size_;
+  HprofOutput* header_output_;
+  HprofOutput* body_output_;
+  size_t size_;
 
   std::set<mirror::Class*> classes_;
   HprofStringId next_string_id_;
@@ -1076,16 +1226,76 @@ void Hprof::VisitRoot(const mirror::Object* obj, uint32_t thread_id, RootType ty
   gc_thread_serial_number_ = 0;
 }
 
+// Returns a descriptor of the file to write the dump to, or -1 after throwing.
+static int OpenOutput(const char* filename, int fd) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (fd >= 0) {
+    int out_fd = dup(fd);
+    if (out_fd < 0) {
+      ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd, strerror(errno));
+    }
+    return out_fd;
+  }
+  int out_fd = open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (out_fd < 0) {
+    ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename,
+                          strerror(errno));
+  }
+  return out_fd;
+}
+
+// Dumps the heap from a copy of the process so that the threads can resume right away. Returns
+// false if the process couldn't be forked.
+static bool DumpHeapInChild(const char* filename, int out_fd, bool compress)
+    EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  pid_t pid = fork();
+  if (pid == -1) {
+    PLOG(WARNING) << "hprof: couldn't fork to dump the heap";
+    return false;
+  }
+  if (pid == 0) {
+    // Fork again so that init reaps the process writing the dump. Only the forking thread exists
+    // in the child, which must not log or throw: the suspended threads may hold the locks.
+    if (fork() != 0) {
+      _exit(0);
+    }
+    Hprof hprof(filename, out_fd, false, compress);
+    std::string error_msg;
+    _exit(hprof.Dump(&error_msg) ? 0 : 1);
+  }
+  close(out_fd);
+  TEMP_FAILURE_RETRY(waitpid(pid, nullptr, 0));
+  LOG(INFO) << "hprof: heap dump \"" << filename << "\" continues in a child process";
+  return true;
+}
+
 // If "direct_to_ddms" is true, the other arguments are ignored, and data is
 // sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
-void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
+// If "compress" is true, the output is gzip compressed.
+// If "in_child" is true, the heap is dumped by a forked copy of the process and
+// the threads are only suspended for the time it takes to fork.
+void DumpHeap(const char* filename, int fd, bool direct_to_ddms, bool compress, bool in_child) {
   CHECK(filename != NULL);
+  LOG(INFO) << "hprof: heap dump \"" << filename << "\" starting...";
+  uint64_t start_ns = NanoTime();
 
   Runtime::Current()->GetThreadList()->SuspendAll();
-  Hprof hprof(filename, fd, direct_to_ddms);
-  hprof.Dump();
+  int out_fd = direct_to_ddms ? -1 : OpenOutput(filename, fd);
+  if (direct_to_ddms || out_fd >= 0) {
+    if (direct_to_ddms || !in_child || !DumpHeapInChild(filename, out_fd, compress)) {
+      Hprof hprof(filename, out_fd, direct_to_ddms, compress);
+      std::string error_msg;
+      if (hprof.Dump(&error_msg)) {
+        // Throw out a log message for the benefit of "runhat".
+        LOG(INFO) << "hprof: heap dump completed (" << PrettySize(hprof.Size() + 1023)
+                  << ") in " << PrettyDuration(NanoTime() - start_ns);
+      } else {
+        ThrowRuntimeException("%s", error_msg.c_str());
+        LOG(ERROR) << error_msg;
+      }
+    }
+  }
   Runtime::Current()->GetThreadList()->ResumeAll();
 }
 
@@ -21,7 +21,7 @@ namespace art {
 
 namespace hprof {
 
-void DumpHeap(const char* filename, int fd, bool direct_to_ddms);
+void DumpHeap(const char* filename, int fd, bool direct_to_ddms, bool compress, bool in_child);
 
 }  // namespace hprof
 
@@ -24,12 +24,17 @@
 namespace art {
 
 const byte ImageHeader::kImageMagic[] = { 'a', 'r', 't', '\n' };
-const byte ImageHeader::kImageVersion[] = { '0', '0', '7', '\0' };
+const byte ImageHeader::kImageVersion[] = { '0', '1', '2', '\0' };
 
 ImageHeader::ImageHeader(uint32_t image_begin,
                          uint32_t image_size,
                          uint32_t image_bitmap_offset,
                          uint32_t image_bitmap_size,
+                         uint32_t class_table_offset,
+                         uint32_t class_table_size,
+                         uint32_t intern_table_offset,
+                         uint32_t intern_table_size,
+                         uint32_t relocations_offset,
                          uint32_t image_roots,
                          uint32_t oat_checksum,
                          uint32_t oat_file_begin,
@@ -40,6 +45,13 @@ ImageHeader::ImageHeader(uint32_t image_begin,
     image_size_(image_size),
     image_bitmap_offset_(image_bitmap_offset),
     image_bitmap_size_(image_bitmap_size),
+    class_table_offset_(class_table_offset),
+    class_table_size_(class_table_size),
+    intern_table_offset_(intern_table_offset),
+    intern_table_size_(intern_table_size),
+    relocations_offset_(relocations_offset),
+    relocations_size_(0),
+    compressed_blocks_(0),
     oat_checksum_(oat_checksum),
     oat_file_begin_(oat_file_begin),
     oat_data_begin_(oat_data_begin),
@@ -47,6 +59,9 @@ ImageHeader::ImageHeader(uint32_t image_begin,
     oat_file_end_(oat_file_end),
     image_roots_(image_roots) {
   CHECK_EQ(image_begin, RoundUp(image_begin, kPageSize));
+  CHECK_EQ(class_table_offset, RoundUp(class_table_offset, kPageSize));
+  CHECK_EQ(intern_table_offset, RoundUp(intern_table_offset, kPageSize));
+  CHECK_EQ(relocations_offset, RoundUp(relocations_offset, kPageSize));
   CHECK_EQ(oat_file_begin, RoundUp(oat_file_begin, kPageSize));
   CHECK_EQ(oat_data_begin, RoundUp(oat_data_begin, kPageSize));
   CHECK_LT(image_begin, image_roots);
@@ -68,6 +83,16 @@ bool ImageHeader::IsValid() const {
   return true;
 }
 
+void ImageHeader::Relocate(ptrdiff_t delta) {
+  uint32_t delta32 = static_cast<uint32_t>(delta);
+  image_begin_ += delta32;
+  image_roots_ += delta32;
+  oat_file_begin_ += delta32;
+  oat_data_begin_ += delta32;
+  oat_data_end_ += delta32;
+  oat_file_end_ += delta32;
+}
+
 const char* ImageHeader::GetMagic() const {
   CHECK(IsValid());
   return reinterpret_cast<const char*>(magic_);
@@ -28,12 +28,31 @@ namespace art {
 // header of image files written by ImageWriter, read and validated by Space.
 class PACKED(4) ImageHeader {
  public:
+  // A block of a compressed image file, see GetCompressedBlocks.
+  struct CompressedBlock {
+    // Where the block is in the uncompressed image file.
+    uint32_t offset;
+    uint32_t size;
+    // Where the zlib stream of the block is in the compressed image file.
+    uint32_t compressed_offset;
+    uint32_t compressed_size;
+  };
+
+  // Uncompressed size of the blocks of a compressed image file, the last block of a section may
+  // be shorter.
+  static constexpr size_t kCompressedBlockSize = 256 * KB;
+
   ImageHeader() {}
 
   ImageHeader(uint32_t image_begin,
               uint32_t image_size_,
               uint32_t image_bitmap_offset,
               uint32_t image_bitmap_size,
+              uint32_t class_table_offset,
+              uint32_t class_table_size,
+              uint32_t intern_table_offset,
+              uint32_t intern_table_size,
+              uint32_t relocations_offset,
               uint32_t image_roots,
               uint32_t oat_checksum,
               uint32_t oat_file_begin,
@@ -60,6 +79,57 @@ class PACKED(4) ImageHeader {
     return image_bitmap_size_;
   }
 
+  size_t GetClassTableOffset() const {
+    return class_table_offset_;
+  }
+
+  // Size in bytes of the class table section, zero if the image has none.
+  size_t GetClassTableSize() const {
+    return class_table_size_;
+  }
+
+  size_t GetInternTableOffset() const {
+    return intern_table_offset_;
+  }
+
+  // Size in bytes of the intern table section, zero if the image has none.
+  size_t GetInternTableSize() const {
+    return intern_table_size_;
+  }
+
+  size_t GetRelocationsOffset() const {
+    return relocations_offset_;
+  }
+
+  // Size in bytes of the relocation section, zero if the image can't be relocated.
+  size_t GetRelocationsSize() const {
+    return relocations_size_;
+  }
+
+  void SetRelocationsSize(uint32_t relocations_size) {
+    relocations_size_ = relocations_size;
+  }
+
+  // Number of blocks of a compressed image file, zero if the file isn't compressed. The first
+  // page of a compressed file is the first page of the image stored as is, so that the header
+  // reads the same. The CompressedBlock table follows it, then the zlib streams of the blocks,
+  // which hold the rest of the image and its sections. A block never spans two sections.
+  size_t GetCompressedBlocks() const {
+    return compressed_blocks_;
+  }
+
+  bool IsCompressed() const {
+    return compressed_blocks_ != 0;
+  }
+
+  void SetCompressedBlocks(uint32_t compressed_blocks) {
+    compressed_blocks_ = compressed_blocks;
+  }
+
+  // Moves the addresses of the header by delta, for an image and oat file loaded delta bytes away
+  // from where they were compiled for.
+  void Relocate(ptrdiff_t delta);
+
   uint32_t GetOatChecksum() const {
     return oat_checksum_;
   }
@@ -101,7 +171,6 @@ class PACKED(4) ImageHeader {
   enum ImageRoot {
     kResolutionMethod,
     kImtConflictMethod,
-    kDefaultImt,
     kCalleeSaveMethod,
     kRefsOnlySaveMethod,
     kRefsAndArgsSaveMethod,
@@ -134,6 +203,31 @@ class PACKED(4) ImageHeader {
   // Size of the image bitmap.
   uint32_t image_bitmap_size_;
 
+  // Page aligned offset in the file of the ClassTable::ImageSlot array of the image classes.
+  uint32_t class_table_offset_;
+
+  // Size of the class table in bytes.
+  uint32_t class_table_size_;
+
+  // Page aligned offset in the file of the InternTable::ImageSlot array of the image strings.
+  uint32_t intern_table_offset_;
+
+  // Size of the intern table in bytes.
+  uint32_t intern_table_size_;
+
+  // Page aligned offset in the file of the relocation section. It lists the 32-bit words holding
+  // addresses of the image or oat file: the references and oat pointers of the image objects,
+  // then the absolute addresses the compiled code of the oat file was patched with. Each list is
+  // its length followed by the offsets of the words, from the image begin and from the oat data
+  // begin, in increasing order and encoded as ULEB128 differences from the previous offset.
+  uint32_t relocations_offset_;
+
+  // Size of the relocation section in bytes.
+  uint32_t relocations_size_;
+
+  // Number of compressed blocks, zero for an uncompressed image file.
+  uint32_t compressed_blocks_;
+
   // Checksum of the oat file we link to for load time sanity check.
   uint32_t oat_checksum_;
 
@@ -65,32 +65,44 @@ IndirectReferenceTable::IndirectReferenceTable(size_t initialCount,
                                                size_t maxCount, IndirectRefKind desiredKind) {
   CHECK_GT(initialCount, 0U);
   CHECK_LE(initialCount, maxCount);
+  CHECK_LT(maxCount, 65536U);
   CHECK_NE(desiredKind, kSirtOrInvalid);
 
-  table_ = reinterpret_cast<mirror::Object**>(malloc(initialCount * sizeof(const mirror::Object*)));
-  CHECK(table_ != NULL);
-  memset(table_, 0xd1, initialCount * sizeof(const mirror::Object*));
-
-  slot_data_ = reinterpret_cast<IndirectRefSlot*>(calloc(initialCount, sizeof(IndirectRefSlot)));
-  CHECK(slot_data_ != NULL);
-
-  segment_state_.all = IRT_FIRST_SEGMENT;
-  alloc_entries_ = initialCount;
+  blocks_ = new IrtBlock*[RoundUp(maxCount, kIRTBlockEntries) / kIRTBlockEntries];
+  alloc_entries_ = 0;
   max_entries_ = maxCount;
   kind_ = desiredKind;
+  while (alloc_entries_ < initialCount) {
+    CHECK(Grow());
+  }
+  segment_state_.all = IRT_FIRST_SEGMENT;
 }
 
 IndirectReferenceTable::~IndirectReferenceTable() {
-  free(table_);
-  free(slot_data_);
-  table_ = NULL;
-  slot_data_ = NULL;
+  for (size_t i = 0; i < alloc_entries_ / kIRTBlockEntries; ++i) {
+    free(blocks_[i]);
+  }
+  delete[] blocks_;
+  blocks_ = NULL;
   alloc_entries_ = max_entries_ = -1;
 }
 
+bool IndirectReferenceTable::Grow() {
+  if (alloc_entries_ >= max_entries_) {
+    return false;
+  }
+  IrtBlock* block = reinterpret_cast<IrtBlock*>(calloc(1, sizeof(IrtBlock)));
+  if (block == NULL) {
+    return false;
+  }
+  blocks_[alloc_entries_ / kIRTBlockEntries] = block;
+  alloc_entries_ += kIRTBlockEntries;
+  return true;
+}
+
 // Make sure that the entry at "idx" is correctly paired with "iref".
 bool IndirectReferenceTable::CheckEntry(const char* what, IndirectRef iref, int idx) const {
-  const mirror::Object* obj = table_[idx];
+  const mirror::Object* obj = EntryAt(idx);
   IndirectRef checkRef = ToIndirectRef(obj, idx);
   if (UNLIKELY(checkRef != iref)) {
     LOG(ERROR) << "JNI ERROR (app bug): attempt to " << what
@@ -109,63 +121,36 @@ IndirectRef IndirectReferenceTable::Add(uint32_t cookie, mirror::Object* obj) {
 
   CHECK(obj != NULL);
   VerifyObject(obj);
-  DCHECK(table_ != NULL);
-  DCHECK_LE(alloc_entries_, max_entries_);
+  DCHECK_LE(segment_state_.parts.topIndex, max_entries_);
   DCHECK_GE(segment_state_.parts.numHoles, prevState.parts.numHoles);
 
-  if (topIndex == alloc_entries_) {
-    // reached end of allocated space; did we hit buffer max?
+  // If there's a hole in the current segment, fill it; otherwise, add to
+  // the end of the list.
+  IndirectRef result;
+  int numHoles = segment_state_.parts.numHoles - prevState.parts.numHoles;
+  int hole = (numHoles > 0) ? PopHole(prevState.parts.topIndex) : -1;
+  if (hole >= 0) {
+    UpdateSlotAdd(obj, hole);
+    result = ToIndirectRef(obj, hole);
+    EntryAt(hole) = obj;
+    segment_state_.parts.numHoles--;
+  } else {
     if (topIndex == max_entries_) {
       LOG(FATAL) << "JNI ERROR (app bug): " << kind_ << " table overflow "
                  << "(max=" << max_entries_ << ")\n"
                  << MutatorLockedDumpable<IndirectReferenceTable>(*this);
     }
-
-    size_t newSize = alloc_entries_ * 2;
-    if (newSize > max_entries_) {
-      newSize = max_entries_;
-    }
-    DCHECK_GT(newSize, alloc_entries_);
-
-    table_ = reinterpret_cast<mirror::Object**>(realloc(table_, newSize * sizeof(mirror::Object*)));
-    slot_data_ = reinterpret_cast<IndirectRefSlot*>(realloc(slot_data_,
-                                                            newSize * sizeof(IndirectRefSlot)));
-    if (table_ == NULL || slot_data_ == NULL) {
+    // Reached the end of the allocated space, add a block.
+    if (topIndex == alloc_entries_ && !Grow()) {
       LOG(FATAL) << "JNI ERROR (app bug): unable to expand "
-                 << kind_ << " table (from "
-                 << alloc_entries_ << " to " << newSize
+                 << kind_ << " table (from " << alloc_entries_
                  << ", max=" << max_entries_ << ")\n"
                  << MutatorLockedDumpable<IndirectReferenceTable>(*this);
     }
-
-    // Clear the newly-allocated slot_data_ elements.
-    memset(slot_data_ + alloc_entries_, 0, (newSize - alloc_entries_) * sizeof(IndirectRefSlot));
-
-    alloc_entries_ = newSize;
-  }
-
-  // We know there's enough room in the table.  Now we just need to find
-  // the right spot.  If there's a hole, find it and fill it; otherwise,
-  // add to the end of the list.
-  IndirectRef result;
-  int numHoles = segment_state_.parts.numHoles - prevState.parts.numHoles;
-  if (numHoles > 0) {
-    DCHECK_GT(topIndex, 1U);
-    // Find the first hole; likely to be near the end of the list.
-    mirror::Object** pScan = &table_[topIndex - 1];
-    DCHECK(*pScan != NULL);
-    while (*--pScan != NULL) {
-      DCHECK_GE(pScan, table_ + prevState.parts.topIndex);
-    }
-    UpdateSlotAdd(obj, pScan - table_);
-    result = ToIndirectRef(obj, pScan - table_);
-    *pScan = obj;
-    segment_state_.parts.numHoles--;
-  } else {
     // Add to the end.
     UpdateSlotAdd(obj, topIndex);
     result = ToIndirectRef(obj, topIndex);
-    table_[topIndex++] = obj;
+    EntryAt(topIndex++) = obj;
     segment_state_.parts.topIndex = topIndex;
   }
   if (false) {
@@ -177,6 +162,44 @@ IndirectRef IndirectReferenceTable::Add(uint32_t cookie, mirror::Object* obj) {
   return result;
 }
 
+int IndirectReferenceTable::PopHole(size_t bottomIndex) {
+  const size_t topIndex = segment_state_.parts.topIndex;
+  while (!holes_.empty()) {
+    const size_t idx = holes_.back();
+    if (idx < bottomIndex) {
+      // A hole of an older segment, the holes of the current segment are above it.
+      break;
+    }
+    holes_.pop_back();
+    if (idx < topIndex && EntryAt(idx) == NULL) {
+      return idx;
+    }
+    // Stale, the hole was consumed from the top or popped with its segment.
+  }
+  // The stack is missing a hole of the current segment, which shouldn't happen. Scan for it.
+  LOG(WARNING) << "Missing hole in " << kind_ << " table";
+  for (size_t idx = topIndex; idx > bottomIndex; --idx) {
+    if (EntryAt(idx - 1) == NULL) {
+      return idx - 1;
+    }
+  }
+  LOG(FATAL) << "No hole in " << kind_ << " table segment [" << bottomIndex << ", "
+             << topIndex << ") with " << segment_state_.parts.numHoles << " holes";
+  return -1;
+}
+
+void IndirectReferenceTable::RebuildHoles() {
+  // Ascending order keeps the holes of the newer segments, which are higher, on top.
+  holes_.clear();
+  const size_t topIndex = segment_state_.parts.topIndex;
+  for (size_t idx = 0; idx < topIndex; ++idx) {
+    if (EntryAt(idx) == NULL) {
+      holes_.push_back(idx);
+    }
+  }
+  DCHECK_EQ(holes_.size(), segment_state_.parts.numHoles);
+}
+
 void IndirectReferenceTable::AssertEmpty() {
   if (UNLIKELY(begin() != end())) {
     ScopedObjectAccess soa(Thread::Current());
@@ -207,7 +230,7 @@ bool IndirectReferenceTable::GetChecked(IndirectRef iref) const {
     return false;
   }
 
-  if (UNLIKELY(table_[idx] == NULL)) {
+  if (UNLIKELY(EntryAt(idx) == NULL)) {
     LOG(ERROR) << "JNI ERROR (app bug): accessed deleted " << kind_ << " " << iref;
     AbortMaybe();
     return false;
@@ -220,18 +243,13 @@ bool IndirectReferenceTable::GetChecked(IndirectRef iref) const {
   return true;
 }
 
-static int Find(mirror::Object* direct_pointer, int bottomIndex, int topIndex,
-                mirror::Object** table) {
-  for (int i = bottomIndex; i < topIndex; ++i) {
-    if (table[i] == direct_pointer) {
-      return i;
+bool IndirectReferenceTable::ContainsDirectPointer(mirror::Object* direct_pointer) const {
+  for (size_t i = 0; i < segment_state_.parts.topIndex; ++i) {
+    if (EntryAt(i) == direct_pointer) {
+      return true;
     }
   }
-  return -1;
-}
-
-bool IndirectReferenceTable::ContainsDirectPointer(mirror::Object* direct_pointer) const {
-  return Find(direct_pointer, 0, segment_state_.parts.topIndex, table_) != -1;
+  return false;
 }
 
 // Removes an object. We extract the table offset bits from "iref"
@@ -248,8 +266,6 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
   int topIndex = segment_state_.parts.topIndex;
   int bottomIndex = prevState.parts.topIndex;
 
-  DCHECK(table_ != NULL);
-  DCHECK_LE(alloc_entries_, max_entries_);
   DCHECK_GE(segment_state_.parts.numHoles, prevState.parts.numHoles);
 
   int idx = ExtractIndex(iref);
@@ -280,15 +296,15 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
       return false;
     }
 
-    table_[idx] = NULL;
+    EntryAt(idx) = NULL;
     int numHoles = segment_state_.parts.numHoles - prevState.parts.numHoles;
     if (numHoles != 0) {
       while (--topIndex > bottomIndex && numHoles != 0) {
         if (false) {
           LOG(INFO) << "+++ checking for hole at " << topIndex-1
-                    << " (cookie=" << cookie << ") val=" << table_[topIndex - 1];
+                    << " (cookie=" << cookie << ") val=" << EntryAt(topIndex - 1);
         }
-        if (table_[topIndex-1] != NULL) {
+        if (EntryAt(topIndex - 1) != NULL) {
           break;
         }
         if (false) {
@@ -298,6 +314,12 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
       }
       segment_state_.parts.numHoles = numHoles + prevState.parts.numHoles;
       segment_state_.parts.topIndex = topIndex;
+      // The consumed holes left stale entries in holes_.
+      if (segment_state_.parts.numHoles == 0) {
+        holes_.clear();
+      } else if (holes_.size() > 2 * segment_state_.parts.numHoles + kIRTBlockEntries) {
+        RebuildHoles();
+      }
     } else {
       segment_state_.parts.topIndex = topIndex-1;
       if (false) {
@@ -308,7 +330,7 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
     // Not the top-most entry.  This creates a hole.  We NULL out the
     // entry to prevent somebody from deleting it twice and screwing up
     // the hole count.
-    if (table_[idx] == NULL) {
+    if (EntryAt(idx) == NULL) {
       LOG(INFO) << "--- WEIRD: removing null entry " << idx;
       return false;
     }
@@ -316,8 +338,13 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
       return false;
     }
 
-    table_[idx] = NULL;
+    EntryAt(idx) = NULL;
     segment_state_.parts.numHoles++;
+    if (segment_state_.parts.numHoles == 1) {
+      // Whatever is left is stale, e.g. from popped segments.
+      holes_.clear();
+    }
+    holes_.push_back(idx);
     if (false) {
       LOG(INFO) << "+++ left hole at " << idx << ", holes=" << segment_state_.parts.numHoles;
     }
@@ -336,11 +363,11 @@ void IndirectReferenceTable::VisitRoots(RootCallback* callback, void* arg, uint3
 
 void IndirectReferenceTable::Dump(std::ostream& os) const {
   os << kind_ << " table dump:\n";
-  ReferenceTable::Table entries(table_, table_ + Capacity());
-  // Remove NULLs.
-  for (int i = entries.size() - 1; i >= 0; --i) {
-    if (entries[i] == NULL) {
-      entries.erase(entries.begin() + i);
+  ReferenceTable::Table entries;
+  for (size_t i = 0; i < Capacity(); ++i) {
+    mirror::Object* obj = EntryAt(i);
+    if (obj != NULL) {
+      entries.push_back(obj);
     }
   }
   ReferenceTable::Dump(os, entries);
@@ -350,7 +377,7 @@ mirror::Object* IndirectReferenceTable::Get(IndirectRef iref) const {
   if (!GetChecked(iref)) {
     return kInvalidIndirectRefObject;
   }
-  mirror::Object* obj = table_[ExtractIndex(iref)];;
+  mirror::Object* obj = EntryAt(ExtractIndex(iref));
   if (obj != kClearedJniWeakGlobal) {
     VerifyObject(obj);
   }
@@ -21,6 +21,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/mutex.h"
@@ -134,6 +135,17 @@ struct IndirectRefSlot {
   const mirror::Object* previous[kIRTPrevCount];
 };
 
+/*
+ * The table storage is allocated in blocks of this many entries, which are never moved or freed
+ * before the table is. The entries of a block are contiguous for the GC to scan.
+ */
+static const size_t kIRTBlockEntries = 128;
+struct IrtBlock {
+  mirror::Object* entries[kIRTBlockEntries];
+  /* extended debugging info */
+  IndirectRefSlot slots[kIRTBlockEntries];
+};
+
 /* use as initial value for "cookie", and when table has only one segment */
 static const uint32_t IRT_FIRST_SEGMENT = 0;
 
@@ -146,13 +158,17 @@ static const uint32_t IRT_FIRST_SEGMENT = 0;
  * operations are adding a new entry and removing an entire table segment.
  *
  * If "alloc_entries_" is not equal to "max_entries_", the table may expand
- * when entries are added, which means the memory may move.  If you want
- * to keep pointers into "table" rather than offsets, you must use a
- * fixed-size table.
+ * when entries are added, one block at a time.  The existing entries stay
+ * where they are, so pointers to them remain valid.
  *
  * If we delete entries from the middle of the list, we will be left with
  * "holes".  We track the number of holes so that, when adding new elements,
- * we can quickly decide to do a trivial append or go slot-hunting.
+ * we can quickly decide to do a trivial append or reuse a hole.  The
+ * removed indices are also pushed on a stack, "holes_", from which Add
+ * pops a hole in constant time.  Entries go stale when their hole is
+ * consumed from the top or popped by a segment, they are skipped when
+ * popped.  The holes of the current segment were all pushed after the
+ * segment was, so they are above the holes of the older segments.
  *
  * When the top-most entry is removed, any holes immediately below it are
  * also removed.  Thus, deletion of an entry may reduce "topIndex" by more
@@ -182,20 +198,14 @@ static const uint32_t IRT_FIRST_SEGMENT = 0;
  * stale references aren't possible (though we may be able to get similar
  * benefits with other approaches).
  *
- * TODO: consider a "lastDeleteIndex" for quick hole-filling when an
- * add immediately follows a delete; must invalidate after segment pop
- * (which could increase the cost/complexity of method call/return).
- * Might be worth only using it for JNI globals.
- *
  * TODO: may want completely different add/remove algorithms for global
  * and local refs to improve performance.  A large circular buffer might
  * reduce the amortized cost of adding global references.
  *
- * TODO: if we can guarantee that the underlying storage doesn't move,
- * e.g. by using oversized mmap regions to handle expanding tables, we may
- * be able to avoid having to synchronize lookups.  Might make sense to
- * add a "synchronized lookup" call that takes the mutex as an argument,
- * and either locks or doesn't lock based on internal details.
+ * TODO: now that the underlying storage doesn't move, we may be able to
+ * avoid having to synchronize lookups.  Might make sense to add a
+ * "synchronized lookup" call that takes the mutex as an argument, and
+ * either locks or doesn't lock based on internal details.
  */
 union IRTSegmentState {
   uint32_t          all;
@@ -207,8 +217,8 @@ union IRTSegmentState {
 
 class IrtIterator {
  public:
-  explicit IrtIterator(mirror::Object** table, size_t i, size_t capacity)
-      : table_(table), i_(i), capacity_(capacity) {
+  explicit IrtIterator(IrtBlock* const* blocks, size_t i, size_t capacity)
+      : blocks_(blocks), i_(i), capacity_(capacity) {
     SkipNullsAndTombstones();
   }
 
@@ -219,22 +229,33 @@ class IrtIterator {
   }
 
   mirror::Object** operator*() {
-    return &table_[i_];
+    return Entry();
   }
 
   bool equals(const IrtIterator& rhs) const {
-    return (i_ == rhs.i_ && table_ == rhs.table_);
+    return (i_ == rhs.i_ && blocks_ == rhs.blocks_);
   }
 
  private:
+  mirror::Object** Entry() const {
+    return &blocks_[i_ / kIRTBlockEntries]->entries[i_ % kIRTBlockEntries];
+  }
+
   void SkipNullsAndTombstones() {
     // We skip NULLs and tombstones. Clients don't want to see implementation details.
-    while (i_ < capacity_ && (table_[i_] == NULL || table_[i_] == kClearedJniWeakGlobal)) {
-      ++i_;
+    while (i_ < capacity_) {
+      // Scan the rest of the block without looking the block up again.
+      mirror::Object** entry = Entry();
+      mirror::Object** block_end = entry + (kIRTBlockEntries - i_ % kIRTBlockEntries);
+      for (; entry != block_end && i_ < capacity_; ++entry, ++i_) {
+        if (*entry != NULL && *entry != kClearedJniWeakGlobal) {
+          return;
+        }
+      }
     }
   }
 
-  mirror::Object** table_;
+  IrtBlock* const* blocks_;
   size_t i_;
   size_t capacity_;
 };
@@ -296,15 +317,26 @@ class IndirectReferenceTable {
   }
 
   IrtIterator begin() {
-    return IrtIterator(table_, 0, Capacity());
+    return IrtIterator(blocks_, 0, Capacity());
   }
 
   IrtIterator end() {
-    return IrtIterator(table_, Capacity(), Capacity());
+    return IrtIterator(blocks_, Capacity(), Capacity());
+  }
+
+  // Iterator on the first entry at or after index, lets the table be split between threads.
+  IrtIterator IteratorAt(size_t index) {
+    DCHECK_LE(index, Capacity());
+    return IrtIterator(blocks_, index, Capacity());
   }
 
   void VisitRoots(RootCallback* callback, void* arg, uint32_t tid, RootType root_type);
 
+  // The index of the block holding the entry of iref, for the side tables of the owner.
+  static size_t ExtractBlockIndex(IndirectRef iref) {
+    return ExtractIndex(iref) / kIRTBlockEntries;
+  }
+
   uint32_t GetSegmentState() const {
     return segment_state_.all;
   }
@@ -326,13 +358,23 @@ class IndirectReferenceTable {
     return (uref >> 2) & 0xffff;
   }
 
+  mirror::Object*& EntryAt(size_t index) const {
+    DCHECK_LT(index, alloc_entries_);
+    return blocks_[index / kIRTBlockEntries]->entries[index % kIRTBlockEntries];
+  }
+
+  IndirectRefSlot& SlotAt(size_t index) const {
+    DCHECK_LT(index, alloc_entries_);
+    return blocks_[index / kIRTBlockEntries]->slots[index % kIRTBlockEntries];
+  }
+
   /*
    * The object pointer itself is subject to relocation in some GC
    * implementations, so we shouldn't really be using it here.
    */
   IndirectRef ToIndirectRef(const mirror::Object* /*o*/, uint32_t tableIndex) const {
     DCHECK_LT(tableIndex, 65536U);
-    uint32_t serialChunk = slot_data_[tableIndex].serial;
+    uint32_t serialChunk = SlotAt(tableIndex).serial;
     uintptr_t uref = serialChunk << 20 | (tableIndex << 2) | kind_;
     return reinterpret_cast<IndirectRef>(uref);
   }
@@ -344,13 +386,20 @@ class IndirectReferenceTable {
    * this slot.
    */
   void UpdateSlotAdd(const mirror::Object* obj, int slot) {
-    if (slot_data_ != NULL) {
-      IndirectRefSlot* pSlot = &slot_data_[slot];
-      pSlot->serial++;
-      pSlot->previous[pSlot->serial % kIRTPrevCount] = obj;
-    }
+    IndirectRefSlot* pSlot = &SlotAt(slot);
+    pSlot->serial++;
+    pSlot->previous[pSlot->serial % kIRTPrevCount] = obj;
   }
 
+  /* allocate one more block, returns false at max_entries_ */
+  bool Grow();
+
+  /* pop a hole of the segment starting at bottomIndex, or return -1 */
+  int PopHole(size_t bottomIndex);
+
+  /* refill holes_ from the table once it is mostly stale entries */
+  void RebuildHoles();
+
   /* extra debugging checks */
   bool GetChecked(IndirectRef) const;
   bool CheckEntry(const char*, IndirectRef, int) const;
@@ -358,16 +407,18 @@ class IndirectReferenceTable {
   /* semi-public - read/write by jni down calls */
   IRTSegmentState segment_state_;
 
-  /* bottom of the stack */
-  mirror::Object** table_;
+  /* the allocated blocks, room for enough pointers to hold max_entries_ */
+  IrtBlock** blocks_;
   /* bit mask, ORed into all irefs */
   IndirectRefKind kind_;
-  /* extended debugging info */
-  IndirectRefSlot* slot_data_;
-  /* #of entries we have space for */
+  /* #of entries we have space for, a multiple of kIRTBlockEntries */
   size_t alloc_entries_;
   /* max #of entries allowed */
   size_t max_entries_;
+  /* indices of removed entries, the most recent last, some may be stale */
+  std::vector<uint32_t> holes_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndirectReferenceTable);
 };
 
 }  // namespace art
@@ -249,4 +249,61 @@ TEST_F(IndirectReferenceTableTest, BasicTest) {
   CheckDump(&irt, 0, 0);
 }
 
+TEST_F(IndirectReferenceTableTest, HolesAndSegments) {
+  ScopedObjectAccess soa(Thread::Current());
+  // Several blocks, the table grows one at a time.
+  static const size_t kTableInitial = 1;
+  static const size_t kTableMax = 4 * kIRTBlockEntries;
+  IndirectReferenceTable irt(kTableInitial, kTableMax, kLocal);
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  mirror::Object* obj = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj != NULL);
+
+  const uint32_t cookie = IRT_FIRST_SEGMENT;
+  const size_t kNumRefs = 3 * kIRTBlockEntries;
+  IndirectRef refs[kNumRefs];
+  for (size_t i = 0; i < kNumRefs; ++i) {
+    refs[i] = irt.Add(cookie, obj);
+    ASSERT_TRUE(refs[i] != NULL);
+  }
+  mirror::Object** first_entry = *irt.begin();
+  EXPECT_EQ(kNumRefs, irt.Capacity());
+
+  // Holes are reused most recent first.
+  ASSERT_TRUE(irt.Remove(cookie, refs[10]));
+  ASSERT_TRUE(irt.Remove(cookie, refs[200]));
+  IndirectRef reused = irt.Add(cookie, obj);
+  EXPECT_EQ(refs[200], reinterpret_cast<IndirectRef>(reinterpret_cast<uintptr_t>(reused) -
+                                                     (1 << 20)));  // Next serial.
+  EXPECT_EQ(kNumRefs, irt.Capacity());
+
+  // A new segment doesn't reuse the holes below it.
+  const uint32_t segment_cookie = irt.GetSegmentState();
+  IndirectRef segment_ref0 = irt.Add(segment_cookie, obj);
+  IndirectRef segment_ref1 = irt.Add(segment_cookie, obj);
+  EXPECT_EQ(kNumRefs + 2, irt.Capacity());
+  ASSERT_TRUE(irt.Remove(segment_cookie, segment_ref0));
+  EXPECT_FALSE(irt.Remove(segment_cookie, refs[20]));
+  IndirectRef segment_ref2 = irt.Add(segment_cookie, obj);
+  EXPECT_EQ(kNumRefs + 2, irt.Capacity());
+  EXPECT_EQ(obj, irt.Get(segment_ref1));
+  EXPECT_EQ(obj, irt.Get(segment_ref2));
+  irt.SetSegmentState(segment_cookie);
+
+  // The hole left below the segment is still there.
+  irt.Add(cookie, obj);
+  EXPECT_EQ(kNumRefs, irt.Capacity());
+
+  size_t visited = 0;
+  for (mirror::Object** entry : irt) {
+    EXPECT_EQ(obj, *entry);
+    ++visited;
+  }
+  EXPECT_EQ(kNumRefs, visited);
+  // Growing didn't move the entries.
+  EXPECT_EQ(first_entry, *irt.begin());
+}
+
 }  // namespace art
@@ -16,6 +16,12 @@
 
 #include "instruction_set.h"
 
+#if defined(__arm__)
+#include <sys/auxv.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 #include "globals.h"
 #include "base/logging.h"  // Logging is required for FATAL in the helper functions.
 
@@ -176,11 +182,65 @@ bool Is64BitInstructionSet(InstructionSet isa) {
   }
 }
 
+#if defined(__arm__)
+// From the kernel's asm/hwcap.h, which not all the C libraries export.
+static constexpr unsigned long kHwcapNeon = 1 << 12;  // NOLINT(runtime/int)
+static constexpr unsigned long kHwcapIdivt = 1 << 18;  // NOLINT(runtime/int)
+static constexpr unsigned long kHwcapLpae = 1 << 20;  // NOLINT(runtime/int)
+#elif defined(__i386__) || defined(__x86_64__)
+// The feature bits of ecx for the cpuid leaf 1.
+static constexpr uint32_t kCpuidSse4_1 = 1 << 19;
+static constexpr uint32_t kCpuidPopcnt = 1 << 23;
+#endif
+
+InstructionSetFeatures InstructionSetFeatures::GuessInstructionSetFeatures() {
+  InstructionSetFeatures result;
+#if defined(__arm__)
+  // The kernel reports what the CPU supports in the auxiliary vector. The divide instruction is
+  // only used from Thumb code.
+  unsigned long hwcaps = getauxval(AT_HWCAP);  // NOLINT(runtime/int)
+  result.SetHasDivideInstruction((hwcaps & kHwcapIdivt) != 0);
+  result.SetHasLpae((hwcaps & kHwcapLpae) != 0);
+  result.SetHasNeon((hwcaps & kHwcapNeon) != 0);
+#elif defined(__i386__) || defined(__x86_64__)
+  uint32_t eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0) {
+    result.SetHasSse4_1((ecx & kCpuidSse4_1) != 0);
+    result.SetHasPopcnt((ecx & kCpuidPopcnt) != 0);
+  }
+#endif
+  return result;
+}
+
 std::string InstructionSetFeatures::GetFeatureString() const {
   std::string result;
   if ((mask_ & kHwDiv) != 0) {
     result += "div";
   }
+  if ((mask_ & kHwLpae) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "lpae";
+  }
+  if ((mask_ & kHwNeon) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "neon";
+  }
+  if ((mask_ & kHwSse4_1) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "sse4.1";
+  }
+  if ((mask_ & kHwPopcnt) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "popcnt";
+  }
   if (result.size() == 0) {
     result = "none";
   }
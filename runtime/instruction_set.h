@@ -61,6 +61,9 @@ static constexpr InstructionSet kRuntimeISA = kNone;
 enum InstructionFeatures {
   kHwDiv  = 0x1,              // Supports hardware divide.
   kHwLpae = 0x2,              // Supports Large Physical Address Extension.
+  kHwNeon = 0x4,              // Supports the Advanced SIMD (NEON) extension.
+  kHwSse4_1 = 0x8,            // Supports SSE4.1, for roundss and roundsd.
+  kHwPopcnt = 0x10,           // Supports the popcnt instruction.
 };
 
 // This is a bitmask of supported features per architecture.
@@ -69,6 +72,8 @@ class PACKED(4) InstructionSetFeatures {
   InstructionSetFeatures() : mask_(0) {}
   explicit InstructionSetFeatures(uint32_t mask) : mask_(mask) {}
 
+  // The features of the CPU running this process, as reported by the kernel on ARM and by cpuid
+  // on x86. Only the features of kRuntimeISA are detected.
   static InstructionSetFeatures GuessInstructionSetFeatures();
 
   bool HasDivideInstruction() const {
@@ -87,6 +92,30 @@ class PACKED(4) InstructionSetFeatures {
     mask_ = (mask_ & ~kHwLpae) | (v ? kHwLpae : 0);
   }
 
+  bool HasNeon() const {
+    return (mask_ & kHwNeon) != 0;
+  }
+
+  void SetHasNeon(bool v) {
+    mask_ = (mask_ & ~kHwNeon) | (v ? kHwNeon : 0);
+  }
+
+  bool HasSse4_1() const {
+    return (mask_ & kHwSse4_1) != 0;
+  }
+
+  void SetHasSse4_1(bool v) {
+    mask_ = (mask_ & ~kHwSse4_1) | (v ? kHwSse4_1 : 0);
+  }
+
+  bool HasPopcnt() const {
+    return (mask_ & kHwPopcnt) != 0;
+  }
+
+  void SetHasPopcnt(bool v) {
+    mask_ = (mask_ & ~kHwPopcnt) | (v ? kHwPopcnt : 0);
+  }
+
   std::string GetFeatureString() const;
 
   // Other features in here.
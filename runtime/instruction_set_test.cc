@@ -41,6 +41,31 @@ TEST_F(InstructionSetTest, GetInstructionSetString) {
   EXPECT_STREQ("none", GetInstructionSetString(kNone));
 }
 
+TEST_F(InstructionSetTest, GetFeatureString) {
+  InstructionSetFeatures features;
+  EXPECT_EQ("none", features.GetFeatureString());
+  features.SetHasDivideInstruction(true);
+  features.SetHasLpae(true);
+  EXPECT_EQ("div,lpae", features.GetFeatureString());
+  features.SetHasNeon(true);
+  EXPECT_EQ("div,lpae,neon", features.GetFeatureString());
+  features = InstructionSetFeatures();
+  features.SetHasSse4_1(true);
+  features.SetHasPopcnt(true);
+  EXPECT_EQ("sse4.1,popcnt", features.GetFeatureString());
+}
+
+TEST_F(InstructionSetTest, GuessInstructionSetFeatures) {
+  InstructionSetFeatures features = InstructionSetFeatures::GuessInstructionSetFeatures();
+  if (kRuntimeISA == kArm) {
+    EXPECT_TRUE(features <= InstructionSetFeatures(kHwDiv | kHwLpae | kHwNeon));
+  } else if (kRuntimeISA == kX86 || kRuntimeISA == kX86_64) {
+    EXPECT_TRUE(features <= InstructionSetFeatures(kHwSse4_1 | kHwPopcnt));
+  } else {
+    EXPECT_TRUE(features == InstructionSetFeatures());
+  }
+}
+
 TEST_F(InstructionSetTest, TestRoundTrip) {
   EXPECT_EQ(kRuntimeISA, GetInstructionSetFromString(GetInstructionSetString(kRuntimeISA)));
 }
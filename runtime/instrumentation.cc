@@ -67,6 +67,7 @@ Instrumentation::Instrumentation()
       have_exception_caught_listeners_(false),
       deoptimized_methods_lock_("deoptimized methods lock"),
       deoptimization_enabled_(false),
+      traced_methods_lock_("traced methods lock"),
       interpreter_handler_table_(kMainHandlerTable),
       quick_alloc_entry_points_instrumentation_counter_(0) {
 }
@@ -137,6 +138,7 @@ void Instrumentation::InstallStubsForMethod(mirror::ArtMethod* method) {
       new_quick_code = GetQuickResolutionTrampoline(class_linker);
     }
   } else {  // !uninstall
+    bool needs_entry_exit_stubs = NeedsEntryExitStubs(method);
     if ((interpreter_stubs_installed_ || IsDeoptimized(method)) && !method->IsNative()) {
       new_portable_code = GetPortableToInterpreterBridge();
       new_quick_code = GetQuickToInterpreterBridge();
@@ -149,7 +151,7 @@ void Instrumentation::InstallStubsForMethod(mirror::ArtMethod* method) {
         new_portable_code = class_linker->GetPortableOatCodeFor(method, &have_portable_code);
         new_quick_code = class_linker->GetQuickOatCodeFor(method);
         DCHECK(new_quick_code != GetQuickToInterpreterBridgeTrampoline(class_linker));
-        if (entry_exit_stubs_installed_ && new_quick_code != GetQuickToInterpreterBridge()) {
+        if (needs_entry_exit_stubs && new_quick_code != GetQuickToInterpreterBridge()) {
           DCHECK(new_portable_code != GetPortableToInterpreterBridge());
           new_portable_code = GetPortableToInterpreterBridge();
           new_quick_code = GetQuickInstrumentationEntryPoint();
@@ -559,6 +561,7 @@ void Instrumentation::UpdateMethodsCode(mirror::ArtMethod* method, const void* q
     new_quick_code = quick_code;
     new_have_portable_code = have_portable_code;
   } else {
+    bool needs_entry_exit_stubs = NeedsEntryExitStubs(method);
     if ((interpreter_stubs_installed_ || IsDeoptimized(method)) && !method->IsNative()) {
       new_portable_code = GetPortableToInterpreterBridge();
       new_quick_code = GetQuickToInterpreterBridge();
@@ -571,7 +574,7 @@ void Instrumentation::UpdateMethodsCode(mirror::ArtMethod* method, const void* q
       new_portable_code = portable_code;
       new_quick_code = quick_code;
       new_have_portable_code = have_portable_code;
-    } else if (entry_exit_stubs_installed_) {
+    } else if (needs_entry_exit_stubs) {
       new_quick_code = GetQuickInstrumentationEntryPoint();
       new_portable_code = GetPortableToInterpreterBridge();
       new_have_portable_code = false;
@@ -590,15 +593,14 @@ void Instrumentation::Deoptimize(mirror::ArtMethod* method) {
   CHECK(!method->IsAbstract());
 
   Thread* self = Thread::Current();
-  std::pair<std::set<mirror::ArtMethod*>::iterator, bool> pair;
+  bool already_deoptimized;
   {
     WriterMutexLock mu(self, deoptimized_methods_lock_);
-    pair = deoptimized_methods_.insert(method);
+    already_deoptimized = deoptimized_methods_.find(method) != deoptimized_methods_.end();
+    deoptimized_methods_.insert(method);
   }
-  bool already_deoptimized = !pair.second;
-  CHECK(!already_deoptimized) << "Method " << PrettyMethod(method) << " is already deoptimized";
 
-  if (!interpreter_stubs_installed_) {
+  if (!already_deoptimized && !interpreter_stubs_installed_) {
     UpdateEntrypoints(method, GetQuickToInterpreterBridge(), GetPortableToInterpreterBridge(),
                       false);
 
@@ -616,6 +618,7 @@ void Instrumentation::Undeoptimize(mirror::ArtMethod* method) {
   CHECK(!method->IsAbstract());
 
   Thread* self = Thread::Current();
+  bool still_deoptimized;
   bool empty;
   {
     WriterMutexLock mu(self, deoptimized_methods_lock_);
@@ -623,11 +626,13 @@ void Instrumentation::Undeoptimize(mirror::ArtMethod* method) {
     CHECK(it != deoptimized_methods_.end()) << "Method " << PrettyMethod(method)
         << " is not deoptimized";
     deoptimized_methods_.erase(it);
+    still_deoptimized = deoptimized_methods_.find(method) != deoptimized_methods_.end();
     empty = deoptimized_methods_.empty();
   }
 
-  // Restore code and possibly stack only if we did not deoptimize everything.
-  if (!interpreter_stubs_installed_) {
+  // Restore code and possibly stack only if we did not deoptimize everything and this was the
+  // last deoptimization of the method.
+  if (!still_deoptimized && !interpreter_stubs_installed_) {
     // Restore its code or resolution trampoline.
     ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
     if (method->IsStatic() && !method->IsConstructor() &&
@@ -650,6 +655,11 @@ void Instrumentation::Undeoptimize(mirror::ArtMethod* method) {
   }
 }
 
+void Instrumentation::InstrumentThreadStack(Thread* thread) {
+  instrumentation_stubs_installed_ = true;
+  InstrumentationInstallStack(thread, this);
+}
+
 bool Instrumentation::IsDeoptimized(mirror::ArtMethod* method) const {
   ReaderMutexLock mu(Thread::Current(), deoptimized_methods_lock_);
   DCHECK(method != nullptr);
@@ -704,8 +714,46 @@ void Instrumentation::EnableMethodTracing() {
   ConfigureStubs(!require_interpreter, require_interpreter);
 }
 
+void Instrumentation::EnableFilteredMethodTracing(const std::vector<std::string>& filters) {
+  DCHECK(!filters.empty());
+  CHECK(!entry_exit_stubs_installed_);
+  method_tracing_filters_ = filters;
+  ConfigureStubs(true, false);
+}
+
 void Instrumentation::DisableMethodTracing() {
   ConfigureStubs(false, false);
+  // Removing the stubs reports the exits of the traced methods on the stacks, clear the filters
+  // only afterwards.
+  method_tracing_filters_.clear();
+  WriterMutexLock mu(Thread::Current(), traced_methods_lock_);
+  traced_methods_.clear();
+}
+
+bool Instrumentation::NeedsEntryExitStubs(mirror::ArtMethod* method) const {
+  if (!entry_exit_stubs_installed_) {
+    return false;
+  }
+  if (method_tracing_filters_.empty()) {
+    return true;
+  }
+  std::string name(PrettyMethod(method, false));
+  for (const std::string& filter : method_tracing_filters_) {
+    if (StartsWith(name, filter.c_str())) {
+      WriterMutexLock mu(Thread::Current(), traced_methods_lock_);
+      traced_methods_.insert(method);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Instrumentation::IsMethodTraced(mirror::ArtMethod* method) const {
+  if (LIKELY(method_tracing_filters_.empty())) {
+    return true;
+  }
+  ReaderMutexLock mu(Thread::Current(), traced_methods_lock_);
+  return traced_methods_.find(method) != traced_methods_.end();
 }
 
 const void* Instrumentation::GetQuickCodeFor(mirror::ArtMethod* method) const {
@@ -725,6 +773,9 @@ const void* Instrumentation::GetQuickCodeFor(mirror::ArtMethod* method) const {
 void Instrumentation::MethodEnterEventImpl(Thread* thread, mirror::Object* this_object,
                                            mirror::ArtMethod* method,
                                            uint32_t dex_pc) const {
+  if (!IsMethodTraced(method)) {
+    return;
+  }
   auto it = method_entry_listeners_.begin();
   bool is_end = (it == method_entry_listeners_.end());
   // Implemented this way to prevent problems caused by modification of the list while iterating.
@@ -739,6 +790,9 @@ void Instrumentation::MethodEnterEventImpl(Thread* thread, mirror::Object* this_
 void Instrumentation::MethodExitEventImpl(Thread* thread, mirror::Object* this_object,
                                           mirror::ArtMethod* method,
                                           uint32_t dex_pc, const JValue& return_value) const {
+  if (!IsMethodTraced(method)) {
+    return;
+  }
   auto it = method_exit_listeners_.begin();
   bool is_end = (it == method_exit_listeners_.end());
   // Implemented this way to prevent problems caused by modification of the list while iterating.
@@ -753,7 +807,7 @@ void Instrumentation::MethodExitEventImpl(Thread* thread, mirror::Object* this_o
 void Instrumentation::MethodUnwindEvent(Thread* thread, mirror::Object* this_object,
                                         mirror::ArtMethod* method,
                                         uint32_t dex_pc) const {
-  if (have_method_unwind_listeners_) {
+  if (have_method_unwind_listeners_ && IsMethodTraced(method)) {
     for (InstrumentationListener* listener : method_unwind_listeners_) {
       listener->MethodUnwind(thread, this_object, method, dex_pc);
     }
@@ -875,7 +929,8 @@ uint64_t Instrumentation::PopInstrumentationStackFrame(Thread* self, uintptr_t*
   NthCallerVisitor visitor(self, 1, true);
   visitor.WalkStack(true);
   bool deoptimize = (visitor.caller != NULL) &&
-                    (interpreter_stubs_installed_ || IsDeoptimized(visitor.caller));
+                    (interpreter_stubs_installed_ || IsDeoptimized(visitor.caller) ||
+                     Dbg::IsForcedInterpreterNeededForUpcall(self, visitor.caller));
   if (deoptimize && kVerboseInstrumentation) {
     LOG(INFO) << "Deoptimizing into " << PrettyMethod(visitor.caller);
   }
@@ -923,11 +978,23 @@ void Instrumentation::PopMethodForUnwind(Thread* self, bool is_deoptimization) c
 }
 
 void Instrumentation::VisitRoots(RootCallback* callback, void* arg) {
-  WriterMutexLock mu(Thread::Current(), deoptimized_methods_lock_);
+  Thread* self = Thread::Current();
+  {
+    WriterMutexLock mu(self, traced_methods_lock_);
+    if (!traced_methods_.empty()) {
+      std::set<mirror::ArtMethod*> new_traced_methods;
+      for (mirror::ArtMethod* method : traced_methods_) {
+        callback(reinterpret_cast<mirror::Object**>(&method), arg, 0, kRootVMInternal);
+        new_traced_methods.insert(method);
+      }
+      traced_methods_ = new_traced_methods;
+    }
+  }
+  WriterMutexLock mu(self, deoptimized_methods_lock_);
   if (deoptimized_methods_.empty()) {
     return;
   }
-  std::set<mirror::ArtMethod*> new_deoptimized_methods;
+  std::multiset<mirror::ArtMethod*> new_deoptimized_methods;
   for (mirror::ArtMethod* method : deoptimized_methods_) {
     DCHECK(method != nullptr);
     callback(reinterpret_cast<mirror::Object**>(&method), arg, 0, kRootVMInternal);
@@ -25,6 +25,8 @@
 #include <stdint.h>
 #include <set>
 #include <list>
+#include <string>
+#include <vector>
 
 namespace art {
 namespace mirror {
@@ -149,7 +151,8 @@ class Instrumentation {
 
   // Deoptimize a method by forcing its execution with the interpreter. Nevertheless, a static
   // method (except a class initializer) set to the resolution trampoline will be deoptimized only
-  // once its declaring class is initialized.
+  // once its declaring class is initialized. A method may be deoptimized several times, it runs
+  // its code again once it was undeoptimized as many times.
   void Deoptimize(mirror::ArtMethod* method)
       LOCKS_EXCLUDED(Locks::thread_list_lock_, deoptimized_methods_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -163,15 +166,30 @@ class Instrumentation {
 
   bool IsDeoptimized(mirror::ArtMethod* method) const LOCKS_EXCLUDED(deoptimized_methods_lock_);
 
+  // Install instrumentation exit stubs in the frames of the given suspended thread only, so that
+  // the compiled callers it returns to can be deoptimized.
+  void InstrumentThreadStack(Thread* thread)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Enable method tracing by installing instrumentation entry/exit stubs.
   void EnableMethodTracing()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_);
 
+  // Enable method tracing of the methods whose name, as in "java.lang.String.length", starts with
+  // one of filters. Only these methods get the instrumentation entry/exit stubs, all others keep
+  // running their compiled code, and method entry, exit and unwind events are only reported for
+  // these methods, including the ones run by the interpreter.
+  void EnableFilteredMethodTracing(const std::vector<std::string>& filters)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_,
+                     traced_methods_lock_);
+
   // Disable method tracing by uninstalling instrumentation entry/exit stubs.
   void DisableMethodTracing()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
-      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_);
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_,
+                     traced_methods_lock_);
 
   InterpreterHandlerTable GetInterpreterHandlerTable() const {
     return interpreter_handler_table_;
@@ -325,7 +343,7 @@ class Instrumentation {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void VisitRoots(RootCallback* callback, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      LOCKS_EXCLUDED(deoptimized_methods_lock_);
+      LOCKS_EXCLUDED(deoptimized_methods_lock_, traced_methods_lock_);
 
  private:
   // Does the job of installing or removing instrumentation code within methods.
@@ -334,6 +352,14 @@ class Instrumentation {
       LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_,
                      deoptimized_methods_lock_);
 
+  // Whether method gets entry/exit stubs while they are installed. Records the methods selected
+  // by the filters of EnableFilteredMethodTracing.
+  bool NeedsEntryExitStubs(mirror::ArtMethod* method) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(traced_methods_lock_);
+
+  // Whether method entry, exit and unwind events of method are reported.
+  bool IsMethodTraced(mirror::ArtMethod* method) const LOCKS_EXCLUDED(traced_methods_lock_);
+
   void UpdateInterpreterHandlerTable() {
     interpreter_handler_table_ = IsActive() ? kAlternativeHandlerTable : kMainHandlerTable;
   }
@@ -413,11 +439,18 @@ class Instrumentation {
   std::list<InstrumentationListener*> exception_caught_listeners_ GUARDED_BY(Locks::mutator_lock_);
 
   // The set of methods being deoptimized (by the debugger) which must be executed with interpreter
-  // only.
+  // only. A method is in the set once per outstanding deoptimization.
   mutable ReaderWriterMutex deoptimized_methods_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  std::set<mirror::ArtMethod*> deoptimized_methods_ GUARDED_BY(deoptimized_methods_lock_);
+  std::multiset<mirror::ArtMethod*> deoptimized_methods_ GUARDED_BY(deoptimized_methods_lock_);
   bool deoptimization_enabled_;
 
+  // The filters of EnableFilteredMethodTracing, empty when all methods are traced.
+  std::vector<std::string> method_tracing_filters_;
+
+  // The methods selected by method_tracing_filters_ so far.
+  mutable ReaderWriterMutex traced_methods_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  mutable std::set<mirror::ArtMethod*> traced_methods_ GUARDED_BY(traced_methods_lock_);
+
   // Current interpreter handler table. This is updated each time the thread state flags are
   // modified.
   InterpreterHandlerTable interpreter_handler_table_;
@@ -16,56 +16,358 @@
 
 #include "intern_table.h"
 
-#include "gc/space/image_space.h"
-#include "mirror/dex_cache.h"
-#include "mirror/object_array-inl.h"
+#include "atomic.h"
+#include "base/stl_util.h"
 #include "mirror/object-inl.h"
 #include "mirror/string.h"
+#include "runtime.h"
 #include "thread.h"
 #include "UniquePtr.h"
 #include "utf.h"
+#include "utils.h"
 
 namespace art {
 
+mirror::String* const InternTable::kRemovedString = reinterpret_cast<mirror::String*>(1);
+
+InternTable::Table::Storage::Storage(size_t capacity)
+    : mask_(capacity - 1), slots_(new Slot[capacity]) {
+  DCHECK(IsPowerOfTwo(capacity));
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].hash_code_ = 0;
+    slots_[i].string_ = nullptr;
+  }
+}
+
+InternTable::Table::Storage::~Storage() {
+  delete[] slots_;
+}
+
+InternTable::Table::Table(bool lock_free_lookups)
+    : storage_(new Storage(kInitialCapacity)), lock_free_lookups_(lock_free_lookups),
+      num_strings_(0), num_removed_(0), zygote_storage_(nullptr), num_zygote_strings_(0) {
+}
+
+InternTable::Table::~Table() {
+  delete storage_;
+  delete zygote_storage_;
+  STLDeleteElements(&retired_storage_);
+}
+
+mirror::String* InternTable::Table::Find(mirror::String* s, int32_t hash_code) const {
+  if (zygote_storage_ != nullptr) {
+    mirror::String* existing_string = FindInStorage(zygote_storage_, s, hash_code);
+    if (existing_string != nullptr) {
+      return existing_string;
+    }
+  }
+  // The loads below depend on the storage address, no barrier is needed to see its slots.
+  return FindInStorage(storage_, s, hash_code);
+}
+
+mirror::String* InternTable::Table::FindInStorage(const Storage* storage, mirror::String* s,
+                                                  int32_t hash_code) {
+  for (size_t i = FirstSlot(hash_code, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    const Slot& slot = storage->slots_[i];
+    mirror::String* existing_string = slot.string_;
+    if (existing_string == nullptr) {
+      return nullptr;
+    }
+    // A stale hash code read while the slot is being filled only makes us miss the string being
+    // inserted, as if the lookup had come first.
+    if (existing_string != kRemovedString && slot.hash_code_ == hash_code &&
+        existing_string->Equals(s)) {
+      return existing_string;
+    }
+  }
+}
+
+void InternTable::Table::Insert(mirror::String* s, int32_t hash_code) {
+  DCHECK(s != nullptr);
+  if ((num_strings_ + num_removed_ + 1) * 100 > (storage_->mask_ + 1) * kMaxLoadPercent) {
+    Rehash(num_strings_ + 1);
+  }
+  Storage* storage = storage_;
+  size_t i = FirstSlot(hash_code, storage->mask_);
+  // Removed slots are not reused, a concurrent lookup could pair the old hash with the new string.
+  while (storage->slots_[i].string_ != nullptr) {
+    i = (i + 1) & storage->mask_;
+  }
+  Slot& slot = storage->slots_[i];
+  slot.hash_code_ = hash_code;
+  // Publish the hash code before the string.
+  QuasiAtomic::MembarStoreStore();
+  slot.string_ = s;
+  ++num_strings_;
+}
+
+void InternTable::Table::Remove(mirror::String* s, int32_t hash_code) {
+  if (ReplaceInStorage(storage_, hash_code, s, kRemovedString)) {
+    --num_strings_;
+    ++num_removed_;
+  } else if (zygote_storage_ != nullptr &&
+             ReplaceInStorage(zygote_storage_, hash_code, s, kRemovedString)) {
+    --num_zygote_strings_;
+  }
+}
+
+void InternTable::Table::UpdateString(int32_t hash_code, mirror::String* old_string,
+                                      mirror::String* new_string) {
+  if (!ReplaceInStorage(storage_, hash_code, old_string, new_string) &&
+      zygote_storage_ != nullptr) {
+    ReplaceInStorage(zygote_storage_, hash_code, old_string, new_string);
+  }
+}
+
+bool InternTable::Table::ReplaceInStorage(Storage* storage, int32_t hash_code,
+                                          mirror::String* old_string,
+                                          mirror::String* new_string) {
+  for (size_t i = FirstSlot(hash_code, storage->mask_); ; i = (i + 1) & storage->mask_) {
+    Slot& slot = storage->slots_[i];
+    if (slot.string_ == nullptr) {
+      return false;
+    }
+    if (slot.string_ == old_string) {
+      slot.string_ = new_string;
+      return true;
+    }
+  }
+}
+
+void InternTable::Table::Visit(void (*visitor)(mirror::String*, void*), void* arg) const {
+  if (zygote_storage_ != nullptr) {
+    VisitStorage(zygote_storage_, visitor, arg);
+  }
+  VisitStorage(storage_, visitor, arg);
+}
+
+void InternTable::Table::VisitStorage(const Storage* storage,
+                                      void (*visitor)(mirror::String*, void*), void* arg) {
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    mirror::String* s = storage->slots_[i].string_;
+    if (s != nullptr && s != kRemovedString) {
+      visitor(s, arg);
+    }
+  }
+}
+
+void InternTable::Table::VisitRoots(RootCallback* callback, void* arg) {
+  if (zygote_storage_ != nullptr) {
+    // The zygote strings are in the zygote space, which doesn't move. Only write back a string
+    // that did move so that the GC doesn't dirty the shared slots.
+    for (size_t i = 0; i <= zygote_storage_->mask_; ++i) {
+      Slot& slot = zygote_storage_->slots_[i];
+      mirror::String* s = slot.string_;
+      if (s != nullptr && s != kRemovedString) {
+        mirror::Object* root = s;
+        callback(&root, arg, 0, kRootInternedString);
+        if (UNLIKELY(root != s)) {
+          slot.string_ = down_cast<mirror::String*>(root);
+        }
+      }
+    }
+  }
+  Storage* storage = storage_;
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    Slot& slot = storage->slots_[i];
+    if (slot.string_ != nullptr && slot.string_ != kRemovedString) {
+      callback(reinterpret_cast<mirror::Object**>(const_cast<mirror::String**>(&slot.string_)),
+               arg, 0, kRootInternedString);
+      DCHECK(slot.string_ != nullptr);
+    }
+  }
+}
+
+void InternTable::Table::SweepWeaks(IsMarkedCallback* callback, void* arg) {
+  if (zygote_storage_ != nullptr) {
+    num_zygote_strings_ -= SweepStorage(zygote_storage_, callback, arg);
+  }
+  size_t removed = SweepStorage(storage_, callback, arg);
+  num_strings_ -= removed;
+  num_removed_ += removed;
+}
+
+size_t InternTable::Table::SweepStorage(Storage* storage, IsMarkedCallback* callback, void* arg) {
+  size_t removed = 0;
+  for (size_t i = 0; i <= storage->mask_; ++i) {
+    Slot& slot = storage->slots_[i];
+    mirror::String* s = slot.string_;
+    if (s == nullptr || s == kRemovedString) {
+      continue;
+    }
+    mirror::Object* new_object = callback(s, arg);
+    if (new_object == nullptr) {
+      slot.string_ = kRemovedString;
+      ++removed;
+    } else if (new_object != s) {
+      // Only write the moved strings, the slots of the zygote storage stay shared otherwise.
+      slot.string_ = down_cast<mirror::String*>(new_object);
+    }
+  }
+  return removed;
+}
+
+void InternTable::Table::PreZygoteFork() {
+  if (zygote_storage_ != nullptr || num_strings_ == 0) {
+    return;
+  }
+  // The zygote and its children insert into new storage from now on, so that the pages of the
+  // zygote storage stay shared.
+  zygote_storage_ = storage_;
+  num_zygote_strings_ = num_strings_;
+  storage_ = new Storage(kInitialCapacity);
+  num_strings_ = 0;
+  num_removed_ = 0;
+}
+
+const void* InternTable::Table::GetZygoteSlots(size_t* size) const {
+  if (zygote_storage_ == nullptr) {
+    *size = 0;
+    return nullptr;
+  }
+  *size = (zygote_storage_->mask_ + 1) * sizeof(Slot);
+  return zygote_storage_->slots_;
+}
+
+void InternTable::Table::Rehash(size_t min_strings) {
+  size_t capacity = storage_->mask_ + 1;
+  while (min_strings * 100 > capacity * kMaxLoadPercent / 2) {
+    capacity *= 2;
+  }
+  Storage* old_storage = storage_;
+  Storage* new_storage = new Storage(capacity);
+  for (size_t i = 0; i <= old_storage->mask_; ++i) {
+    const Slot& slot = old_storage->slots_[i];
+    if (slot.string_ == nullptr || slot.string_ == kRemovedString) {
+      continue;
+    }
+    size_t j = FirstSlot(slot.hash_code_, new_storage->mask_);
+    while (new_storage->slots_[j].string_ != nullptr) {
+      j = (j + 1) & new_storage->mask_;
+    }
+    new_storage->slots_[j].hash_code_ = slot.hash_code_;
+    new_storage->slots_[j].string_ = slot.string_;
+  }
+  // Publish the copied slots before the storage.
+  QuasiAtomic::MembarStoreStore();
+  storage_ = new_storage;
+  if (lock_free_lookups_) {
+    retired_storage_.push_back(old_storage);
+  } else {
+    // The weak table is swept at every collection and may be rehashed at the same capacity just
+    // as often, keeping its storage would grow without bound.
+    delete old_storage;
+  }
+  num_removed_ = 0;
+}
+
 InternTable::InternTable()
     : log_new_roots_(false), allow_new_interns_(true),
-      new_intern_condition_("New intern condition", *Locks::intern_table_lock_) {
+      new_intern_condition_("New intern condition", *Locks::intern_table_lock_),
+      strong_interns_(true), weak_interns_(false), image_slots_(nullptr), image_mask_(0),
+      num_image_strings_(0) {
 }
 
 size_t InternTable::Size() const {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.size() + weak_interns_.size();
+  return num_image_strings_ + strong_interns_.Size() + weak_interns_.Size();
 }
 
 void InternTable::DumpForSigQuit(std::ostream& os) const {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  os << "Intern table: " << strong_interns_.size() << " strong; "
-     << weak_interns_.size() << " weak\n";
+  os << "Intern table: " << strong_interns_.Size() << " strong; "
+     << weak_interns_.Size() << " weak; " << num_image_strings_ << " image\n";
+  if (Runtime::Current()->IsZygote()) {
+    return;
+  }
+  size_t zygote_slots_size;
+  const void* zygote_slots = strong_interns_.GetZygoteSlots(&zygote_slots_size);
+  if (zygote_slots != nullptr) {
+    os << "Zygote strong intern table: "
+       << DescribePrivatePages(zygote_slots, zygote_slots_size) << "\n";
+  }
+  zygote_slots = weak_interns_.GetZygoteSlots(&zygote_slots_size);
+  if (zygote_slots != nullptr) {
+    os << "Zygote weak intern table: "
+       << DescribePrivatePages(zygote_slots, zygote_slots_size) << "\n";
+  }
+}
+
+void InternTable::PreZygoteFork() {
+  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
+  strong_interns_.PreZygoteFork();
+  weak_interns_.PreZygoteFork();
+}
+
+void InternTable::BuildImageSlots(const std::vector<std::pair<int32_t, uint32_t> >& strings,
+                                  std::vector<ImageSlot>* slots) {
+  // The table is never written to, it can be at most half full.
+  size_t capacity = 1024;
+  while (strings.size() * 2 > capacity) {
+    capacity *= 2;
+  }
+  const size_t mask = capacity - 1;
+  ImageSlot empty_slot = { 0, 0 };
+  slots->assign(capacity, empty_slot);
+  for (const std::pair<int32_t, uint32_t>& entry : strings) {
+    size_t i = FirstSlot(entry.first, mask);
+    while ((*slots)[i].string_ != 0) {
+      i = (i + 1) & mask;
+    }
+    CHECK_NE(entry.second, 0U);
+    (*slots)[i].hash_ = static_cast<uint32_t>(entry.first);
+    (*slots)[i].string_ = entry.second;
+  }
+}
+
+void InternTable::SetImageSlots(const ImageSlot* slots, size_t num_slots) {
+  CHECK(IsPowerOfTwo(num_slots)) << num_slots;
+  image_slots_ = slots;
+  image_mask_ = num_slots - 1;
+  num_image_strings_ = 0;
+  for (size_t i = 0; i < num_slots; ++i) {
+    if (slots[i].string_ != 0) {
+      ++num_image_strings_;
+    }
+  }
+}
+
+mirror::String* InternTable::LookupImage(mirror::String* s, int32_t hash_code) const {
+  if (image_slots_ == nullptr) {
+    return nullptr;
+  }
+  const uint32_t hash = static_cast<uint32_t>(hash_code);
+  for (size_t i = FirstSlot(hash_code, image_mask_); ; i = (i + 1) & image_mask_) {
+    const ImageSlot& slot = image_slots_[i];
+    if (slot.string_ == 0) {
+      return nullptr;
+    }
+    mirror::String* image_string =
+        reinterpret_cast<mirror::String*>(static_cast<uintptr_t>(slot.string_));
+    if (slot.hash_ == hash && image_string->Equals(s)) {
+      return image_string;
+    }
+  }
+}
+
+void InternTable::VisitInterns(void (*visitor)(mirror::String*, void*), void* arg) {
+  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
+  strong_interns_.Visit(visitor, arg);
+  weak_interns_.Visit(visitor, arg);
 }
 
 void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags) {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
   if ((flags & kVisitRootFlagAllRoots) != 0) {
-    for (auto& strong_intern : strong_interns_) {
-      callback(reinterpret_cast<mirror::Object**>(&strong_intern.second), arg, 0,
-               kRootInternedString);
-      DCHECK(strong_intern.second != nullptr);
-    }
+    strong_interns_.VisitRoots(callback, arg);
   } else if ((flags & kVisitRootFlagNewRoots) != 0) {
     for (auto& pair : new_strong_intern_roots_) {
        mirror::String* old_ref = pair.second;
        callback(reinterpret_cast<mirror::Object**>(&pair.second), arg, 0, kRootInternedString);
        if (UNLIKELY(pair.second != old_ref)) {
-         // Uh ohes, GC moved a root in the log. Need to search the strong interns and update the
-         // corresponding object. This is slow, but luckily for us, this may only happen with a
-         // concurrent moving GC.
-         for (auto it = strong_interns_.lower_bound(pair.first), end = strong_interns_.end();
-             it != end && it->first == pair.first; ++it) {
-           // If the class stored matches the old class, update it to the new value.
-           if (old_ref == it->second) {
-             it->second = pair.second;
-           }
-         }
+         // Uh ohes, GC moved a root in the log. Need to update the corresponding slot of the
+         // strong interns. This may only happen with a concurrent moving GC.
+         strong_interns_.UpdateString(pair.first, old_ref, pair.second);
        }
      }
   }
@@ -81,17 +383,6 @@ void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
   // Note: we deliberately don't visit the weak_interns_ table and the immutable image roots.
 }
 
-mirror::String* InternTable::Lookup(Table& table, mirror::String* s, int32_t hash_code) {
-  Locks::intern_table_lock_->AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    mirror::String* existing_string = it->second;
-    if (existing_string->Equals(s)) {
-      return existing_string;
-    }
-  }
-  return NULL;
-}
-
 mirror::String* InternTable::InsertStrong(mirror::String* s, int32_t hash_code) {
   Runtime* runtime = Runtime::Current();
   if (runtime->IsActiveTransaction()) {
@@ -100,7 +391,7 @@ mirror::String* InternTable::InsertStrong(mirror::String* s, int32_t hash_code)
   if (log_new_roots_) {
     new_strong_intern_roots_.push_back(std::make_pair(hash_code, s));
   }
-  strong_interns_.insert(std::make_pair(hash_code, s));
+  strong_interns_.Insert(s, hash_code);
   return s;
 }
 
@@ -109,7 +400,7 @@ mirror::String* InternTable::InsertWeak(mirror::String* s, int32_t hash_code) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringInsertion(s, hash_code);
   }
-  weak_interns_.insert(std::make_pair(hash_code, s));
+  weak_interns_.Insert(s, hash_code);
   return s;
 }
 
@@ -118,16 +409,7 @@ void InternTable::RemoveWeak(mirror::String* s, int32_t hash_code) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringRemoval(s, hash_code);
   }
-  Remove(weak_interns_, s, hash_code);
-}
-
-void InternTable::Remove(Table& table, mirror::String* s, int32_t hash_code) {
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    if (it->second == s) {
-      table.erase(it);
-      return;
-    }
-  }
+  weak_interns_.Remove(s, hash_code);
 }
 
 // Insert/remove methods used to undo changes made during an aborted transaction.
@@ -141,36 +423,11 @@ mirror::String* InternTable::InsertWeakFromTransaction(mirror::String* s, int32_
 }
 void InternTable::RemoveStrongFromTransaction(mirror::String* s, int32_t hash_code) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  Remove(strong_interns_, s, hash_code);
+  strong_interns_.Remove(s, hash_code);
 }
 void InternTable::RemoveWeakFromTransaction(mirror::String* s, int32_t hash_code) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  Remove(weak_interns_, s, hash_code);
-}
-
-static mirror::String* LookupStringFromImage(mirror::String* s)
-    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-  gc::space::ImageSpace* image = Runtime::Current()->GetHeap()->GetImageSpace();
-  if (image == NULL) {
-    return NULL;  // No image present.
-  }
-  mirror::Object* root = image->GetImageHeader().GetImageRoot(ImageHeader::kDexCaches);
-  mirror::ObjectArray<mirror::DexCache>* dex_caches = root->AsObjectArray<mirror::DexCache>();
-  const std::string utf8 = s->ToModifiedUtf8();
-  for (int32_t i = 0; i < dex_caches->GetLength(); ++i) {
-    mirror::DexCache* dex_cache = dex_caches->Get(i);
-    const DexFile* dex_file = dex_cache->GetDexFile();
-    // Binary search the dex file for the string index.
-    const DexFile::StringId* string_id = dex_file->FindStringId(utf8.c_str());
-    if (string_id != NULL) {
-      uint32_t string_idx = dex_file->GetIndexForStringId(*string_id);
-      mirror::String* image = dex_cache->GetResolvedString(string_idx);
-      if (image != NULL) {
-        return image;
-      }
-    }
-  }
-  return NULL;
+  weak_interns_.Remove(s, hash_code);
 }
 
 void InternTable::AllowNewInterns() {
@@ -187,31 +444,36 @@ void InternTable::DisallowNewInterns() {
 }
 
 mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
+  DCHECK(s != NULL);
+  int32_t hash_code = s->GetHashCode();
+
+  // The image and strong strings are never removed while mutators run, look them up without
+  // locking. Most interning requests are for strings that are already there.
+  mirror::String* image = LookupImage(s, hash_code);
+  if (image != NULL) {
+    return image;
+  }
+  mirror::String* strong = strong_interns_.Find(s, hash_code);
+  if (strong != NULL) {
+    return strong;
+  }
+
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::intern_table_lock_);
 
-  DCHECK(s != NULL);
-  uint32_t hash_code = s->GetHashCode();
-
   while (UNLIKELY(!allow_new_interns_)) {
     new_intern_condition_.WaitHoldingLocks(self);
   }
 
-  if (is_strong) {
-    // Check the strong table for a match.
-    mirror::String* strong = Lookup(strong_interns_, s, hash_code);
-    if (strong != NULL) {
-      return strong;
-    }
-
-    // Check the image for a match.
-    mirror::String* image = LookupStringFromImage(s);
-    if (image != NULL) {
-      return InsertStrong(image, hash_code);
-    }
+  // Check the strong table again, another thread may have inserted the string meanwhile.
+  strong = strong_interns_.Find(s, hash_code);
+  if (strong != NULL) {
+    return strong;
+  }
 
+  if (is_strong) {
     // There is no match in the strong table, check the weak table.
-    mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+    mirror::String* weak = weak_interns_.Find(s, hash_code);
     if (weak != NULL) {
       // A match was found in the weak table. Promote to the strong table.
       RemoveWeak(weak, hash_code);
@@ -223,18 +485,8 @@ mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
     return InsertStrong(s, hash_code);
   }
 
-  // Check the strong table for a match.
-  mirror::String* strong = Lookup(strong_interns_, s, hash_code);
-  if (strong != NULL) {
-    return strong;
-  }
-  // Check the image for a match.
-  mirror::String* image = LookupStringFromImage(s);
-  if (image != NULL) {
-    return InsertWeak(image, hash_code);
-  }
   // Check the weak table for a match.
-  mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+  mirror::String* weak = weak_interns_.Find(s, hash_code);
   if (weak != NULL) {
     return weak;
   }
@@ -269,23 +521,14 @@ mirror::String* InternTable::InternWeak(mirror::String* s) {
 
 bool InternTable::ContainsWeak(mirror::String* s) {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  const mirror::String* found = Lookup(weak_interns_, s, s->GetHashCode());
+  const mirror::String* found = weak_interns_.Find(s, s->GetHashCode());
   return found == s;
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedCallback* callback, void* arg) {
+  // Only the runtime weak table is swept, the image strings are never collected.
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  for (auto it = weak_interns_.begin(), end = weak_interns_.end(); it != end;) {
-    mirror::Object* object = it->second;
-    mirror::Object* new_object = callback(object, arg);
-    if (new_object == nullptr) {
-      // TODO: use it = weak_interns_.erase(it) when we get a c++11 stl.
-      weak_interns_.erase(it++);
-    } else {
-      it->second = down_cast<mirror::String*>(new_object);
-      ++it;
-    }
-  }
+  weak_interns_.SweepWeaks(callback, arg);
 }
 
 }  // namespace art
@@ -17,8 +17,10 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
-#include <map>
+#include <utility>
+#include <vector>
 
+#include "base/macros.h"
 #include "base/mutex.h"
 #include "object_callbacks.h"
 
@@ -40,11 +42,37 @@ class Transaction;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * Both tables are open addressing hash sets. Strings found in the strong table are returned
+ * without taking the intern_table_lock_, which is only held to add or remove strings and to look
+ * up the weak table, whose strings may be swept concurrently.
+ *
+ * The boot image strings interned when the image was written come in a third, read only table
+ * mapped from the image file. It is searched first and never visited nor swept by the GC.
  */
 class InternTable {
  public:
+  // A slot of the image intern table, the string is its image address, zero for an empty slot.
+  struct ImageSlot {
+    uint32_t hash_;
+    uint32_t string_;
+  };
+
   InternTable();
 
+  // Lay out the image intern table for the (hash code, image address) pairs of the image strings.
+  static void BuildImageSlots(const std::vector<std::pair<int32_t, uint32_t> >& strings,
+                              std::vector<ImageSlot>* slots);
+
+  // Search the image intern table before the runtime tables. The slots must stay mapped as long
+  // as the table is used. num_slots is a power of two.
+  void SetImageSlots(const ImageSlot* slots, size_t num_slots);
+
+  // Call the visitor on every string of the strong and weak tables, not the image table.
+  void VisitInterns(void (*visitor)(mirror::String*, void*), void* arg)
+      LOCKS_EXCLUDED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Interns a potentially new string in the 'strong' table. (See above.)
   mirror::String* InternStrong(int32_t utf16_length, const char* utf8_data)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -69,17 +97,125 @@ class InternTable {
 
   void DumpForSigQuit(std::ostream& os) const;
 
+  // Moves the strings interned by the zygote to tables that its children only read.
+  void PreZygoteFork() LOCKS_EXCLUDED(Locks::intern_table_lock_);
+
   void DisallowNewInterns() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
   void AllowNewInterns() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
-  typedef std::multimap<int32_t, mirror::String*> Table;
+  // An open addressing hash set of strings with linear probing. Lookups may run concurrently with
+  // the updates, which are serialized by the intern_table_lock_: a slot is published by storing
+  // its hash before its string and removed slots are only reclaimed by a rehash into new storage.
+  // With lock free lookups the replaced storage is kept until the table is destroyed, otherwise
+  // it is freed by the rehash.
+  class Table {
+   public:
+    explicit Table(bool lock_free_lookups);
+    ~Table();
+
+    // Return the string equal to s, or null.
+    mirror::String* Find(mirror::String* s, int32_t hash_code) const
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+    void Insert(mirror::String* s, int32_t hash_code)
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // Remove s itself, not an equal string.
+    void Remove(mirror::String* s, int32_t hash_code)
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // Replace old_string, which has the given hash code, by the moved new_string.
+    void UpdateString(int32_t hash_code, mirror::String* old_string, mirror::String* new_string)
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    void Visit(void (*visitor)(mirror::String*, void*), void* arg) const
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    void VisitRoots(RootCallback* callback, void* arg)
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // Remove the unmarked strings and update the moved ones.
+    void SweepWeaks(IsMarkedCallback* callback, void* arg)
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // Move the strings to the zygote storage, which is only read afterwards so that the zygote
+    // children share its pages. Only called once, while the zygote is single threaded before
+    // forking, since lookups don't lock.
+    void PreZygoteFork() EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // The slots of the zygote storage and their size in bytes, null if there is none.
+    const void* GetZygoteSlots(size_t* size) const
+        EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    size_t Size() const EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_) {
+      return num_strings_ + num_zygote_strings_;
+    }
+
+   private:
+    struct Slot {
+      volatile int32_t hash_code_;
+      // Null for a never used slot, kRemovedString for a removed one.
+      mirror::String* volatile string_;
+    };
+
+    struct Storage {
+      explicit Storage(size_t capacity);
+      ~Storage();
+
+      const size_t mask_;
+      Slot* const slots_;
+
+      DISALLOW_COPY_AND_ASSIGN(Storage);
+    };
+
+    static constexpr size_t kInitialCapacity = 512;
+    // The table is rehashed once the used and removed slots make up this percentage of the slots.
+    static constexpr size_t kMaxLoadPercent = 70;
+
+    // Move the strings to new storage with room for at least min_strings strings.
+    void Rehash(size_t min_strings) EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+
+    // The operations on the slots of one storage.
+    static mirror::String* FindInStorage(const Storage* storage, mirror::String* s,
+                                         int32_t hash_code)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    static bool ReplaceInStorage(Storage* storage, int32_t hash_code,
+                                 mirror::String* old_string, mirror::String* new_string);
+    static void VisitStorage(const Storage* storage, void (*visitor)(mirror::String*, void*),
+                             void* arg);
+    // Returns the number of strings removed.
+    static size_t SweepStorage(Storage* storage, IsMarkedCallback* callback, void* arg);
+
+    // The storage used by readers, only replaced by Rehash.
+    Storage* volatile storage_;
+    // Whether lookups may run without the intern_table_lock_.
+    const bool lock_free_lookups_;
+    // Storage replaced by Rehash which concurrent lookups may still be reading.
+    std::vector<Storage*> retired_storage_ GUARDED_BY(Locks::intern_table_lock_);
+    size_t num_strings_ GUARDED_BY(Locks::intern_table_lock_);
+    size_t num_removed_ GUARDED_BY(Locks::intern_table_lock_);
+    // The strings of the zygote, set before it forks and never inserted into after.
+    Storage* zygote_storage_;
+    size_t num_zygote_strings_ GUARDED_BY(Locks::intern_table_lock_);
+
+    DISALLOW_COPY_AND_ASSIGN(Table);
+  };
+
+  // Marks the removed slots, which lookups probe past.
+  static mirror::String* const kRemovedString;
+
+  // The first slot to probe for a hash code, the same for the image and the runtime tables.
+  static size_t FirstSlot(int32_t hash_code, size_t mask) {
+    const uint32_t hash = static_cast<uint32_t>(hash_code);
+    return (hash ^ (hash >> 16)) & mask;
+  }
 
   mirror::String* Insert(mirror::String* s, bool is_strong)
       LOCKS_EXCLUDED(Locks::intern_table_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  mirror::String* Lookup(Table& table, mirror::String* s, int32_t hash_code)
+  mirror::String* LookupImage(mirror::String* s, int32_t hash_code) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertStrong(mirror::String* s, int32_t hash_code)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
@@ -87,8 +223,6 @@ class InternTable {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
   void RemoveWeak(mirror::String* s, int32_t hash_code)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-  void Remove(Table& table, mirror::String* s, int32_t hash_code)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
 
   // Transaction rollback access.
   mirror::String* InsertStrongFromTransaction(mirror::String* s, int32_t hash_code)
@@ -104,10 +238,18 @@ class InternTable {
   bool log_new_roots_ GUARDED_BY(Locks::intern_table_lock_);
   bool allow_new_interns_ GUARDED_BY(Locks::intern_table_lock_);
   ConditionVariable new_intern_condition_ GUARDED_BY(Locks::intern_table_lock_);
-  Table strong_interns_ GUARDED_BY(Locks::intern_table_lock_);
+  // Updated with the intern_table_lock_ held, read without it.
+  Table strong_interns_;
   std::vector<std::pair<int32_t, mirror::String*> > new_strong_intern_roots_
       GUARDED_BY(Locks::intern_table_lock_);
-  Table weak_interns_ GUARDED_BY(Locks::intern_table_lock_);
+  // Only read with the intern_table_lock_ held, the GC sweeps it.
+  Table weak_interns_;
+  // The image intern table, set before any lookup and never changed after.
+  const ImageSlot* image_slots_;
+  size_t image_mask_;
+  size_t num_image_strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(InternTable);
 };
 
 }  // namespace art
@@ -19,6 +19,7 @@
 #include "common_runtime_test.h"
 #include "mirror/object.h"
 #include "sirt_ref.h"
+#include "utils.h"
 
 namespace art {
 
@@ -120,6 +121,41 @@ TEST_F(InternTableTest, SweepInternTableWeaks) {
   EXPECT_EQ(3U, t.Size());
 }
 
+TEST_F(InternTableTest, PreZygoteFork) {
+  ScopedObjectAccess soa(Thread::Current());
+  InternTable t;
+  SirtRef<mirror::String> foo(soa.Self(), t.InternStrong(3, "foo"));
+  SirtRef<mirror::String> hello(soa.Self(),
+                                mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello"));
+  SirtRef<mirror::String> world(soa.Self(),
+                                mirror::String::AllocFromModifiedUtf8(soa.Self(), "world"));
+  EXPECT_EQ(hello.get(), t.InternWeak(hello.get()));
+  EXPECT_EQ(world.get(), t.InternWeak(world.get()));
+  t.PreZygoteFork();
+  EXPECT_EQ(3U, t.Size());
+
+  // The strings interned before the fork are still found, new ones go to the other tables.
+  EXPECT_EQ(foo.get(), t.InternStrong(3, "foo"));
+  SirtRef<mirror::String> bar(soa.Self(), t.InternStrong(3, "bar"));
+  EXPECT_EQ(bar.get(), t.InternStrong(3, "bar"));
+  EXPECT_TRUE(t.ContainsWeak(hello.get()));
+  EXPECT_EQ(4U, t.Size());
+
+  // Interning a zygote weak string strongly moves it out of the zygote weak table.
+  EXPECT_EQ(hello.get(), t.InternStrong(5, "hello"));
+  EXPECT_FALSE(t.ContainsWeak(hello.get()));
+  EXPECT_EQ(4U, t.Size());
+
+  // Sweeping removes the unmarked zygote weak strings.
+  TestPredicate p;
+  p.Expect(world.get());
+  {
+    ReaderMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+    t.SweepInternTableWeaks(IsMarkedSweepingCallback, &p);
+  }
+  EXPECT_EQ(3U, t.Size());
+}
+
 TEST_F(InternTableTest, ContainsWeak) {
   ScopedObjectAccess soa(Thread::Current());
   {
@@ -170,4 +206,29 @@ TEST_F(InternTableTest, ContainsWeak) {
   }
 }
 
+TEST_F(InternTableTest, ImageSlots) {
+  ScopedObjectAccess soa(Thread::Current());
+  SirtRef<mirror::String> foo(soa.Self(), mirror::String::AllocFromModifiedUtf8(soa.Self(), "foo"));
+  SirtRef<mirror::String> bar(soa.Self(), mirror::String::AllocFromModifiedUtf8(soa.Self(), "bar"));
+  std::vector<std::pair<int32_t, uint32_t> > strings;
+  strings.push_back(std::make_pair(foo->GetHashCode(), PointerToLowMemUInt32(foo.get())));
+  strings.push_back(std::make_pair(bar->GetHashCode(), PointerToLowMemUInt32(bar.get())));
+  std::vector<InternTable::ImageSlot> slots;
+  InternTable::BuildImageSlots(strings, &slots);
+
+  InternTable t;
+  t.SetImageSlots(&slots[0], slots.size());
+  EXPECT_EQ(2U, t.Size());
+  // Equal strings intern to the image ones, which are neither strong nor weak runtime interns.
+  EXPECT_EQ(foo.get(), t.InternStrong(3, "foo"));
+  SirtRef<mirror::String> bar_2(soa.Self(),
+                                mirror::String::AllocFromModifiedUtf8(soa.Self(), "bar"));
+  EXPECT_EQ(bar.get(), t.InternWeak(bar_2.get()));
+  EXPECT_FALSE(t.ContainsWeak(bar.get()));
+  EXPECT_EQ(2U, t.Size());
+  SirtRef<mirror::String> baz(soa.Self(), t.InternStrong(3, "baz"));
+  EXPECT_TRUE(baz->Equals("baz"));
+  EXPECT_EQ(3U, t.Size());
+}
+
 }  // namespace art
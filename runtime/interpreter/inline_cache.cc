@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inline_cache.h"
+
+#include <sched.h>
+
+#include <algorithm>
+
+#include "base/casts.h"
+#include "mirror/art_method.h"
+#include "mirror/class.h"
+#include "mirror/object.h"
+
+namespace art {
+namespace interpreter {
+
+InlineCacheTable::InlineCacheTable() : entries_(new Entry[kNumEntries]) {
+  for (size_t i = 0; i < kNumEntries; ++i) {
+    Entry* entry = &entries_[i];
+    entry->caller = nullptr;
+    entry->dex_pc = 0;
+    entry->num_receivers = 0;
+    entry->megamorphic = false;
+  }
+}
+
+bool InlineCacheTable::BeginWrite(Entry* entry, bool wait) {
+  while (true) {
+    int32_t sequence = entry->sequence.Load();
+    if ((sequence & 1) == 0 && entry->sequence.CompareAndSwap(sequence, sequence + 1)) {
+      return true;
+    }
+    if (!wait) {
+      return false;
+    }
+    sched_yield();
+  }
+}
+
+void InlineCacheTable::EndWrite(Entry* entry) {
+  // Publish the fields before the even sequence number.
+  QuasiAtomic::MembarStoreStore();
+  ++entry->sequence;
+}
+
+mirror::ArtMethod* InlineCacheTable::Lookup(mirror::ArtMethod* caller, uint32_t dex_pc,
+                                            mirror::Class* klass) {
+  Entry* entry = &entries_[IndexOf(caller, dex_pc)];
+  int32_t sequence = entry->sequence.Load();
+  if ((sequence & 1) != 0) {
+    return nullptr;
+  }
+  QuasiAtomic::MembarLoadLoad();
+  mirror::ArtMethod* target = nullptr;
+  if (entry->caller == caller && entry->dex_pc == dex_pc) {
+    size_t num_receivers = std::min<size_t>(entry->num_receivers, kMaxReceivers);
+    for (size_t i = 0; i < num_receivers; ++i) {
+      if (entry->classes[i] == klass) {
+        target = entry->targets[i];
+        break;
+      }
+    }
+  }
+  // Discard what we read if a writer got in.
+  QuasiAtomic::MembarLoadLoad();
+  return entry->sequence.Load() == sequence ? target : nullptr;
+}
+
+void InlineCacheTable::Update(mirror::ArtMethod* caller, uint32_t dex_pc, mirror::Class* klass,
+                              mirror::ArtMethod* target) {
+  Entry* entry = &entries_[IndexOf(caller, dex_pc)];
+  if (!BeginWrite(entry, false)) {
+    return;
+  }
+  if (entry->caller != caller || entry->dex_pc != dex_pc) {
+    // Evict the site that maps to the same entry.
+    entry->caller = caller;
+    entry->dex_pc = dex_pc;
+    entry->num_receivers = 0;
+    entry->megamorphic = false;
+  }
+  bool known = false;
+  for (size_t i = 0; i < entry->num_receivers; ++i) {
+    known = known || entry->classes[i] == klass;
+  }
+  if (!known) {
+    if (entry->num_receivers < kMaxReceivers) {
+      entry->classes[entry->num_receivers] = klass;
+      entry->targets[entry->num_receivers] = target;
+      ++entry->num_receivers;
+    } else {
+      entry->megamorphic = true;
+    }
+  }
+  EndWrite(entry);
+}
+
+bool InlineCacheTable::GetReceiverClasses(mirror::ArtMethod* caller, uint32_t dex_pc,
+                                          std::vector<mirror::Class*>* classes) {
+  Entry* entry = &entries_[IndexOf(caller, dex_pc)];
+  mirror::Class* copy[kMaxReceivers];
+  size_t num_receivers = 0;
+  bool complete = false;
+  int32_t sequence;
+  do {
+    sequence = entry->sequence.Load();
+    if ((sequence & 1) != 0) {
+      sched_yield();
+      continue;
+    }
+    QuasiAtomic::MembarLoadLoad();
+    complete = entry->caller == caller && entry->dex_pc == dex_pc && !entry->megamorphic;
+    num_receivers = complete ? std::min<size_t>(entry->num_receivers, kMaxReceivers) : 0;
+    for (size_t i = 0; i < num_receivers; ++i) {
+      copy[i] = entry->classes[i];
+    }
+    QuasiAtomic::MembarLoadLoad();
+  } while ((sequence & 1) != 0 || entry->sequence.Load() != sequence);
+  if (!complete || num_receivers == 0) {
+    return false;
+  }
+  classes->assign(copy, copy + num_receivers);
+  return true;
+}
+
+void InlineCacheTable::Sweep(IsMarkedCallback* callback, void* arg) {
+  for (size_t i = 0; i < kNumEntries; ++i) {
+    Entry* entry = &entries_[i];
+    if (entry->caller == nullptr) {
+      continue;
+    }
+    BeginWrite(entry, true);
+    if (callback(entry->caller, arg) != entry->caller) {
+      // The class of the caller was unloaded, or the caller moved and the entry is no longer
+      // where a lookup looks for it.
+      entry->caller = nullptr;
+      entry->num_receivers = 0;
+      entry->megamorphic = false;
+      EndWrite(entry);
+      continue;
+    }
+    size_t kept = 0;
+    for (size_t j = 0; j < entry->num_receivers; ++j) {
+      mirror::Object* new_class = callback(entry->classes[j], arg);
+      if (new_class != nullptr) {
+        entry->classes[kept] = down_cast<mirror::Class*>(new_class);
+        entry->targets[kept] = entry->targets[j];
+        ++kept;
+      }
+    }
+    entry->num_receivers = kept;
+    EndWrite(entry);
+  }
+}
+
+}  // namespace interpreter
+}  // namespace art
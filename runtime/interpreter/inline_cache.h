@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
+#define ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
+
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Class;
+}  // namespace mirror
+
+namespace interpreter {
+
+// The inline caches of the invoke-virtual and invoke-interface instructions run by the
+// interpreter. The ArtMethod layout mirrors java.lang.reflect.ArtMethod so the caches live in a
+// direct-mapped side table indexed by the caller and the dex pc of the call site. Each entry
+// remembers up to kMaxReceivers receiver classes with the method they dispatch to; a site that
+// sees more receiver classes is marked megamorphic and is no longer updated.
+//
+// Lookups don't take a lock: each entry has a sequence number which is odd while the entry is
+// being written, and a reader that races with a write treats the lookup as a miss. A writer that
+// fails to claim an entry drops its update. The receiver classes are weak, the GC updates or
+// clears them through Sweep.
+class InlineCacheTable {
+ public:
+  // The number of receiver classes of a polymorphic site.
+  static constexpr size_t kMaxReceivers = 4;
+
+  // The number of entries of the table, a power of two.
+  static constexpr size_t kNumEntries = 1024;
+
+  InlineCacheTable();
+
+  // Returns the method that the call site of caller at dex_pc dispatched to for receivers of
+  // klass, nullptr if the cache doesn't know klass.
+  mirror::ArtMethod* Lookup(mirror::ArtMethod* caller, uint32_t dex_pc, mirror::Class* klass);
+
+  // Records that the call site of caller at dex_pc dispatches to target for receivers of klass.
+  void Update(mirror::ArtMethod* caller, uint32_t dex_pc, mirror::Class* klass,
+              mirror::ArtMethod* target);
+
+  // Receiver type profile for the compiler. Copies the receiver classes seen by the call site of
+  // caller at dex_pc into classes and returns true if they are all of them. Returns false when
+  // the site wasn't run by the interpreter, has been evicted or is megamorphic.
+  bool GetReceiverClasses(mirror::ArtMethod* caller, uint32_t dex_pc,
+                          std::vector<mirror::Class*>* classes)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Updates the receiver classes moved by the GC and forgets the ones that are dead, and the
+  // sites of the callers that are dead or moved.
+  void Sweep(IsMarkedCallback* callback, void* arg);
+
+ private:
+  struct Entry {
+    AtomicInteger sequence;
+    mirror::ArtMethod* caller;
+    uint32_t dex_pc;
+    uint32_t num_receivers;
+    // Set once the site has seen more than kMaxReceivers receiver classes.
+    bool megamorphic;
+    mirror::Class* classes[kMaxReceivers];
+    mirror::ArtMethod* targets[kMaxReceivers];
+  };
+
+  static size_t IndexOf(mirror::ArtMethod* caller, uint32_t dex_pc) {
+    return ((reinterpret_cast<uintptr_t>(caller) >> 3) ^ (dex_pc * 0x9e3779b1u)) &
+        (kNumEntries - 1);
+  }
+
+  // Claims the entry for writing. Returns false if another thread is writing it, unless wait is
+  // set in which case it yields until the entry is free.
+  static bool BeginWrite(Entry* entry, bool wait);
+  static void EndWrite(Entry* entry);
+
+  UniquePtr<Entry[]> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(InlineCacheTable);
+};
+
+}  // namespace interpreter
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
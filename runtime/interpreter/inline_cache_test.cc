@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inline_cache.h"
+
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "mirror/class.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+namespace interpreter {
+
+class InlineCacheTest : public CommonRuntimeTest {
+ protected:
+  // The cache only compares the methods and classes, they don't need to be real.
+  static mirror::ArtMethod* FakeMethod(uintptr_t index) {
+    return reinterpret_cast<mirror::ArtMethod*>((index + 1) * kObjectAlignment);
+  }
+
+  static mirror::Class* FakeClass(uintptr_t index) {
+    return reinterpret_cast<mirror::Class*>((index + 0x1000) * kObjectAlignment);
+  }
+
+  // Kills FakeClass(1) and FakeMethod(1), and moves FakeClass(2) to FakeClass(3).
+  static mirror::Object* SweepCallback(mirror::Object* obj, void*) {
+    if (obj == FakeClass(1) || obj == FakeMethod(1)) {
+      return nullptr;
+    }
+    return obj == FakeClass(2) ? FakeClass(3) : obj;
+  }
+};
+
+TEST_F(InlineCacheTest, CachesPolymorphicSites) {
+  InlineCacheTable caches;
+  mirror::ArtMethod* caller = FakeMethod(0);
+  EXPECT_TRUE(caches.Lookup(caller, 4, FakeClass(0)) == nullptr);
+
+  for (size_t i = 0; i < InlineCacheTable::kMaxReceivers; ++i) {
+    caches.Update(caller, 4, FakeClass(i), FakeMethod(10 + i));
+  }
+  for (size_t i = 0; i < InlineCacheTable::kMaxReceivers; ++i) {
+    EXPECT_EQ(FakeMethod(10 + i), caches.Lookup(caller, 4, FakeClass(i)));
+  }
+  // Other sites of the caller have their own cache.
+  EXPECT_TRUE(caches.Lookup(caller, 7, FakeClass(0)) == nullptr);
+
+  ScopedObjectAccess soa(Thread::Current());
+  std::vector<mirror::Class*> classes;
+  ASSERT_TRUE(caches.GetReceiverClasses(caller, 4, &classes));
+  ASSERT_EQ(InlineCacheTable::kMaxReceivers, classes.size());
+  EXPECT_EQ(FakeClass(0), classes[0]);
+  EXPECT_FALSE(caches.GetReceiverClasses(caller, 7, &classes));
+}
+
+TEST_F(InlineCacheTest, StopsProfilingMegamorphicSites) {
+  InlineCacheTable caches;
+  mirror::ArtMethod* caller = FakeMethod(0);
+  for (size_t i = 0; i <= InlineCacheTable::kMaxReceivers; ++i) {
+    caches.Update(caller, 0, FakeClass(i), FakeMethod(10 + i));
+  }
+  // The first receivers still hit, the extra one isn't cached.
+  EXPECT_EQ(FakeMethod(10), caches.Lookup(caller, 0, FakeClass(0)));
+  EXPECT_TRUE(caches.Lookup(caller, 0, FakeClass(InlineCacheTable::kMaxReceivers)) == nullptr);
+
+  ScopedObjectAccess soa(Thread::Current());
+  std::vector<mirror::Class*> classes;
+  EXPECT_FALSE(caches.GetReceiverClasses(caller, 0, &classes));
+}
+
+TEST_F(InlineCacheTest, SweepsDeadAndMovedClasses) {
+  InlineCacheTable caches;
+  mirror::ArtMethod* caller = FakeMethod(0);
+  caches.Update(caller, 2, FakeClass(0), FakeMethod(10));
+  caches.Update(caller, 2, FakeClass(1), FakeMethod(11));
+  caches.Update(caller, 2, FakeClass(2), FakeMethod(12));
+
+  caches.Sweep(SweepCallback, nullptr);
+
+  EXPECT_EQ(FakeMethod(10), caches.Lookup(caller, 2, FakeClass(0)));
+  EXPECT_TRUE(caches.Lookup(caller, 2, FakeClass(1)) == nullptr);
+  EXPECT_TRUE(caches.Lookup(caller, 2, FakeClass(2)) == nullptr);
+  EXPECT_EQ(FakeMethod(12), caches.Lookup(caller, 2, FakeClass(3)));
+
+  ScopedObjectAccess soa(Thread::Current());
+  std::vector<mirror::Class*> classes;
+  ASSERT_TRUE(caches.GetReceiverClasses(caller, 2, &classes));
+  EXPECT_EQ(2U, classes.size());
+}
+
+TEST_F(InlineCacheTest, SweepsSitesOfDeadCallers) {
+  InlineCacheTable caches;
+  mirror::ArtMethod* caller = FakeMethod(1);
+  caches.Update(caller, 2, FakeClass(0), FakeMethod(10));
+
+  caches.Sweep(SweepCallback, nullptr);
+
+  // A method allocated where the caller was doesn't find its site.
+  EXPECT_TRUE(caches.Lookup(caller, 2, FakeClass(0)) == nullptr);
+}
+
+}  // namespace interpreter
+}  // namespace art
@@ -48,6 +48,43 @@ static void UnstartedRuntimeJni(Thread* self, ArtMethod* method,
     JValue value;
     value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
     result->SetD(log(value.GetD()));
+  } else if (name == "double java.lang.Math.log10(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(log10(value.GetD()));
+  } else if (name == "double java.lang.Math.sqrt(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(sqrt(value.GetD()));
+  } else if (name == "double java.lang.Math.floor(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(floor(value.GetD()));
+  } else if (name == "double java.lang.Math.ceil(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(ceil(value.GetD()));
+  } else if (name == "double java.lang.Math.sin(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(sin(value.GetD()));
+  } else if (name == "double java.lang.Math.cos(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(cos(value.GetD()));
+  } else if (name == "double java.lang.Math.pow(double, double)") {
+    JValue base;
+    base.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    JValue exponent;
+    exponent.SetJ((static_cast<uint64_t>(args[3]) << 32) | args[2]);
+    result->SetD(pow(base.GetD(), exponent.GetD()));
+  } else if (name == "long java.lang.Double.doubleToRawLongBits(double)") {
+    result->SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  } else if (name == "double java.lang.Double.longBitsToDouble(long)") {
+    result->SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  } else if (name == "char java.lang.String.charAt(int)") {
+    // Throws StringIndexOutOfBoundsException like the native implementation.
+    result->SetC(receiver->AsString()->CharAt(args[0]));
   } else if (name == "java.lang.String java.lang.Class.getNameNative()") {
     result->SetL(receiver->AsClass()->ComputeName());
   } else if (name == "int java.lang.Float.floatToRawIntBits(float)") {
@@ -75,6 +112,17 @@ static void UnstartedRuntimeJni(Thread* self, ArtMethod* method,
     SirtRef<mirror::IntArray> sirt_dimensions(self,
                                               reinterpret_cast<Object*>(args[1])->AsIntArray());
     result->SetL(Array::CreateMultiArray(self, sirt_class, sirt_dimensions));
+  } else if (name == "java.lang.Object java.lang.reflect.Array.createObjectArray(java.lang.Class, int)") {
+    int32_t length = args[1];
+    if (length < 0) {
+      ThrowNegativeArraySizeException(length);
+      return;
+    }
+    mirror::Class* element_class = reinterpret_cast<Object*>(args[0])->AsClass();
+    Runtime* runtime = Runtime::Current();
+    mirror::Class* array_class = runtime->GetClassLinker()->FindArrayClass(self, element_class);
+    DCHECK(array_class != nullptr);
+    result->SetL(mirror::ObjectArray<Object>::Alloc(self, array_class, length));
   } else if (name == "java.lang.Object java.lang.Throwable.nativeFillInStackTrace()") {
     ScopedObjectAccessUnchecked soa(self);
     if (Runtime::Current()->IsActiveTransaction()) {
@@ -131,6 +179,8 @@ static void InterpreterJni(Thread* self, ArtMethod* method, const StringPiece& s
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   // TODO: The following enters JNI code using a typedef-ed function rather than the JNI compiler,
   //       it should be removed and JNI compiled stubs used instead.
+  // The typedef-ed functions all take the JNIEnv*, which critical natives don't.
+  CHECK(!method->IsCriticalNative()) << PrettyMethod(method);
   ScopedObjectAccessUnchecked soa(self);
   if (method->IsStatic()) {
     if (shorty == "L") {
@@ -308,16 +358,11 @@ static void InterpreterJni(Thread* self, ArtMethod* method, const StringPiece& s
   }
 }
 
-enum InterpreterImplKind {
-  kSwitchImpl,            // Switch-based interpreter implementation.
-  kComputedGotoImplKind   // Computed-goto-based interpreter implementation.
-};
-
 #if !defined(__clang__)
-static constexpr InterpreterImplKind kInterpreterImplKind = kComputedGotoImplKind;
+static constexpr bool kGotoImplSupported = true;
 #else
 // Clang 3.4 fails to build the goto interpreter implementation.
-static constexpr InterpreterImplKind kInterpreterImplKind = kSwitchImpl;
+static constexpr bool kGotoImplSupported = false;
 template<bool do_access_check, bool transaction_active>
 JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem* code_item,
                        ShadowFrame& shadow_frame, JValue result_register) {
@@ -343,6 +388,18 @@ JValue ExecuteGotoImpl<false, true>(Thread* self, MethodHelper& mh,
                                      ShadowFrame& shadow_frame, JValue result_register);
 #endif
 
+// The C++ implementation which runs the dex code, or kMterpImplKind to start in the assembly
+// interpreter where there is one and continue in the fastest C++ implementation.
+static InterpreterImplKind interpreter_impl_kind = kMterpImplKind;
+
+void SetInterpreterImplKind(InterpreterImplKind kind) {
+  if (kind == kComputedGotoImplKind && !kGotoImplSupported) {
+    LOG(WARNING) << "The goto interpreter is not built, using the switch interpreter";
+    kind = kSwitchImpl;
+  }
+  interpreter_impl_kind = kind;
+}
+
 static JValue Execute(Thread* self, MethodHelper& mh, const DexFile::CodeItem* code_item,
                       ShadowFrame& shadow_frame, JValue result_register)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -354,17 +411,35 @@ static inline JValue Execute(Thread* self, MethodHelper& mh, const DexFile::Code
   DCHECK(!shadow_frame.GetMethod()->IsAbstract());
   DCHECK(!shadow_frame.GetMethod()->IsNative());
 
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr && shadow_frame.GetDexPC() == 0) {
+    // Entering the method as opposed to deoptimizing.
+    jit->AddSamples(self, shadow_frame.GetMethod(), 1);
+  }
+
   bool transaction_active = Runtime::Current()->IsActiveTransaction();
+  InterpreterImplKind impl_kind = interpreter_impl_kind;
+  if (impl_kind == kMterpImplKind) {
+    impl_kind = kGotoImplSupported ? kComputedGotoImplKind : kSwitchImpl;
+  }
   if (LIKELY(shadow_frame.GetMethod()->IsPreverified())) {
     // Enter the "without access check" interpreter.
-    if (kInterpreterImplKind == kSwitchImpl) {
+    // Start in the assembly interpreter, which doesn't record transactions, and continue from
+    // the instruction it stopped at if it didn't return.
+    if (kMterpSupported && !transaction_active && interpreter_impl_kind == kMterpImplKind) {
+      JValue result;
+      if (ExecuteMterp(self, code_item, shadow_frame, &result)) {
+        return result;
+      }
+    }
+    if (impl_kind == kSwitchImpl) {
       if (transaction_active) {
         return ExecuteSwitchImpl<false, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
         return ExecuteSwitchImpl<false, false>(self, mh, code_item, shadow_frame, result_register);
       }
     } else {
-      DCHECK_EQ(kInterpreterImplKind, kComputedGotoImplKind);
+      DCHECK_EQ(impl_kind, kComputedGotoImplKind);
       if (transaction_active) {
         return ExecuteGotoImpl<false, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
@@ -373,14 +448,14 @@ static inline JValue Execute(Thread* self, MethodHelper& mh, const DexFile::Code
     }
   } else {
     // Enter the "with access check" interpreter.
-    if (kInterpreterImplKind == kSwitchImpl) {
+    if (impl_kind == kSwitchImpl) {
       if (transaction_active) {
         return ExecuteSwitchImpl<true, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
         return ExecuteSwitchImpl<true, false>(self, mh, code_item, shadow_frame, result_register);
       }
     } else {
-      DCHECK_EQ(kInterpreterImplKind, kComputedGotoImplKind);
+      DCHECK_EQ(impl_kind, kComputedGotoImplKind);
       if (transaction_active) {
         return ExecuteGotoImpl<true, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
@@ -33,6 +33,16 @@ class Thread;
 
 namespace interpreter {
 
+// The implementations of the interpreter.
+enum InterpreterImplKind {
+  kSwitchImpl,            // Switch-based interpreter implementation.
+  kComputedGotoImplKind,  // Computed-goto-based interpreter implementation.
+  kMterpImplKind,         // Assembly interpreter where supported, else computed-goto or switch.
+};
+
+// Selects the implementation which runs the dex code, set from -Xinterpreter-impl.
+extern void SetInterpreterImplKind(InterpreterImplKind kind);
+
 // Called by ArtMethod::Invoke, shadow frames arguments are taken from the args array.
 extern void EnterInterpreterFromInvoke(Thread* self, mirror::ArtMethod* method,
                                        mirror::Object* receiver, uint32_t* args, JValue* result)
@@ -15,6 +15,7 @@
  */
 
 #include "interpreter_common.h"
+#include "debugger.h"
 #include "mirror/array-inl.h"
 
 namespace art {
@@ -171,7 +172,12 @@ bool DoCall(ArtMethod* method, Thread* self, ShadowFrame& shadow_frame,
         method->GetEntryPointFromInterpreter() == artInterpreterToCompiledCodeBridge) {
       LOG(FATAL) << "Attempt to call compiled code when -Xint: " << PrettyMethod(method);
     }
-    (method->GetEntryPointFromInterpreter())(self, mh, code_item, new_shadow_frame, result);
+    if (UNLIKELY(Dbg::IsForcedInterpreterNeededForCalling(self, method))) {
+      // Stepping into the callee: interpret it rather than deoptimizing it for every thread.
+      artInterpreterToInterpreterBridge(self, mh, code_item, new_shadow_frame, result);
+    } else {
+      (method->GetEntryPointFromInterpreter())(self, mh, code_item, new_shadow_frame, result);
+    }
   } else {
     UnstartedRuntimeInvoke(self, mh, code_item, new_shadow_frame, result, first_dest_reg);
   }
@@ -284,6 +290,95 @@ void RecordArrayElementsInTransaction(mirror::Array* array, int32_t count)
   }
 }
 
+// Copies the elements in the direction that is correct when src and dst are the same array.
+template <typename ArrayType>
+static void ArrayCopyElements(Thread* self, ArrayType* src, int32_t src_pos, ArrayType* dst,
+                              int32_t dst_pos, int32_t length)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (src != dst || src_pos >= dst_pos) {
+    for (int32_t i = 0; i < length && !self->IsExceptionPending(); ++i) {
+      dst->Set(dst_pos + i, src->Get(src_pos + i));
+    }
+  } else {
+    for (int32_t i = length - 1; i >= 0 && !self->IsExceptionPending(); --i) {
+      dst->Set(dst_pos + i, src->Get(src_pos + i));
+    }
+  }
+}
+
+static void UnstartedRuntimeArrayCopy(Thread* self, Object* src, int32_t src_pos, Object* dst,
+                                      int32_t dst_pos, int32_t length)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (src == nullptr || dst == nullptr) {
+    ThrowNullPointerException(nullptr, "src == null || dst == null");
+    return;
+  }
+  if (!src->IsArrayInstance() || !dst->IsArrayInstance()) {
+    self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(), "Ljava/lang/ArrayStoreException;",
+                             "src and dst must be arrays: %s, %s",
+                             PrettyTypeOf(src).c_str(), PrettyTypeOf(dst).c_str());
+    return;
+  }
+  Array* src_array = src->AsArray();
+  Array* dst_array = dst->AsArray();
+  if (src_pos < 0 || dst_pos < 0 || length < 0 || src_pos > src_array->GetLength() - length ||
+      dst_pos > dst_array->GetLength() - length) {
+    self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                             "Ljava/lang/ArrayIndexOutOfBoundsException;",
+                             "src.length=%d srcPos=%d dst.length=%d dstPos=%d length=%d",
+                             src_array->GetLength(), src_pos, dst_array->GetLength(), dst_pos,
+                             length);
+    return;
+  }
+  Class* src_type = src->GetClass()->GetComponentType();
+  Class* dst_type = dst->GetClass()->GetComponentType();
+  if (src_type->IsPrimitive() || dst_type->IsPrimitive()) {
+    if (src_type != dst_type) {
+      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                               "Ljava/lang/ArrayStoreException;",
+                               "Incompatible types: src=%s, dst=%s",
+                               PrettyTypeOf(src).c_str(), PrettyTypeOf(dst).c_str());
+      return;
+    }
+  }
+  switch (src_type->GetPrimitiveType()) {
+    case Primitive::kPrimNot:
+      // The stores into dst check the assignability of each element.
+      ArrayCopyElements(self, src->AsObjectArray<Object>(), src_pos,
+                        dst->AsObjectArray<Object>(), dst_pos, length);
+      break;
+    case Primitive::kPrimBoolean:
+      ArrayCopyElements(self, src->AsBooleanArray(), src_pos, dst->AsBooleanArray(), dst_pos,
+                        length);
+      break;
+    case Primitive::kPrimByte:
+      ArrayCopyElements(self, src->AsByteArray(), src_pos, dst->AsByteArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimChar:
+      ArrayCopyElements(self, src->AsCharArray(), src_pos, dst->AsCharArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimShort:
+      ArrayCopyElements(self, src->AsShortArray(), src_pos, dst->AsShortArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimInt:
+      ArrayCopyElements(self, src->AsIntArray(), src_pos, dst->AsIntArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimLong:
+      ArrayCopyElements(self, src->AsLongArray(), src_pos, dst->AsLongArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimFloat:
+      ArrayCopyElements(self, src->AsFloatArray(), src_pos, dst->AsFloatArray(), dst_pos, length);
+      break;
+    case Primitive::kPrimDouble:
+      ArrayCopyElements(self, src->AsDoubleArray(), src_pos, dst->AsDoubleArray(), dst_pos,
+                        length);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected component type " << PrettyDescriptor(src_type);
+      break;
+  }
+}
+
 static void UnstartedRuntimeInvoke(Thread* self, MethodHelper& mh,
                                    const DexFile::CodeItem* code_item, ShadowFrame* shadow_frame,
                                    JValue* result, size_t arg_offset) {
@@ -364,35 +459,17 @@ static void UnstartedRuntimeInvoke(Thread* self, MethodHelper& mh,
     ArtMethod* method = shadow_frame->GetVRegReference(arg_offset)->AsArtMethod();
     result->SetL(MethodHelper(method).GetNameAsString());
   } else if (name == "void java.lang.System.arraycopy(java.lang.Object, int, java.lang.Object, int, int)" ||
-             name == "void java.lang.System.arraycopy(char[], int, char[], int, int)") {
+             name == "void java.lang.System.arraycopy(char[], int, char[], int, int)" ||
+             name == "void java.lang.System.arraycopy(byte[], int, byte[], int, int)" ||
+             name == "void java.lang.System.arraycopy(int[], int, int[], int, int)" ||
+             name == "void java.lang.System.arraycopy(long[], int, long[], int, int)") {
     // Special case array copying without initializing System.
-    Class* ctype = shadow_frame->GetVRegReference(arg_offset)->GetClass()->GetComponentType();
-    jint srcPos = shadow_frame->GetVReg(arg_offset + 1);
-    jint dstPos = shadow_frame->GetVReg(arg_offset + 3);
+    Object* src = shadow_frame->GetVRegReference(arg_offset);
+    jint src_pos = shadow_frame->GetVReg(arg_offset + 1);
+    Object* dst = shadow_frame->GetVRegReference(arg_offset + 2);
+    jint dst_pos = shadow_frame->GetVReg(arg_offset + 3);
     jint length = shadow_frame->GetVReg(arg_offset + 4);
-    if (!ctype->IsPrimitive()) {
-      ObjectArray<Object>* src = shadow_frame->GetVRegReference(arg_offset)->AsObjectArray<Object>();
-      ObjectArray<Object>* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsObjectArray<Object>();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else if (ctype->IsPrimitiveChar()) {
-      CharArray* src = shadow_frame->GetVRegReference(arg_offset)->AsCharArray();
-      CharArray* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsCharArray();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else if (ctype->IsPrimitiveInt()) {
-      IntArray* src = shadow_frame->GetVRegReference(arg_offset)->AsIntArray();
-      IntArray* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsIntArray();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else {
-      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(), "Ljava/lang/InternalError;",
-                               "Unimplemented System.arraycopy for type '%s'",
-                               PrettyDescriptor(ctype).c_str());
-    }
+    UnstartedRuntimeArrayCopy(self, src, src_pos, dst, dst_pos, length);
   } else  if (name == "java.lang.Object java.lang.ThreadLocal.get()") {
     std::string caller(PrettyMethod(shadow_frame->GetLink()->GetMethod()));
     if (caller == "java.lang.String java.lang.IntegralToString.convertInt(java.lang.AbstractStringBuilder, int)") {
@@ -29,6 +29,8 @@
 #include "dex_instruction.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "gc/accounting/card_table-inl.h"
+#include "inline_cache.h"
+#include "jit/jit.h"
 #include "nth_caller_visitor.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method.h"
@@ -62,13 +64,29 @@ using ::art::mirror::Throwable;
 namespace art {
 namespace interpreter {
 
-// External references to both interpreter implementations.
+// External references to all interpreter implementations.
 
 template<bool do_access_check, bool transaction_active>
 extern JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh,
                                 const DexFile::CodeItem* code_item,
                                 ShadowFrame& shadow_frame, JValue result_register);
 
+// Whether there is an assembly interpreter for the ISA. The portable compiler's shadow frames
+// flag the reference array in the number of vregs, which the handlers don't decode.
+#if (defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)) && \
+    !defined(ART_USE_PORTABLE_COMPILER)
+static constexpr bool kMterpSupported = true;
+#else
+static constexpr bool kMterpSupported = false;
+#endif
+
+// Run the preverified method in the assembly interpreter from the dex pc of the shadow frame.
+// Returns true if the method returned, with its result in *result, and false if the rest of the
+// method must run in another implementation from the dex pc left in the shadow frame.
+extern bool ExecuteMterp(Thread* self, const DexFile::CodeItem* code_item,
+                         ShadowFrame& shadow_frame, JValue* result)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
 template<bool do_access_check, bool transaction_active>
 extern JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh,
                               const DexFile::CodeItem* code_item,
@@ -103,9 +121,27 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
   const uint32_t method_idx = (is_range) ? inst->VRegB_3rc() : inst->VRegB_35c();
   const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   Object* receiver = (type == kStatic) ? nullptr : shadow_frame.GetVRegReference(vregC);
-  ArtMethod* const method = FindMethodFromCode<type, do_access_check>(method_idx, receiver,
-                                                                      shadow_frame.GetMethod(),
-                                                                      self);
+  // Virtual and interface calls go through the inline cache of the call site first, the classes
+  // it holds have already passed the checks of FindMethodFromCode at this site.
+  const bool use_inline_cache = (type == kVirtual || type == kInterface) && receiver != nullptr;
+  InlineCacheTable* const inline_caches =
+      use_inline_cache ? Runtime::Current()->GetInlineCaches() : nullptr;
+  ArtMethod* method = nullptr;
+  if (use_inline_cache) {
+    method = inline_caches->Lookup(shadow_frame.GetMethod(), shadow_frame.GetDexPC(),
+                                   receiver->GetClass());
+  }
+  if (method == nullptr) {
+    method = FindMethodFromCode<type, do_access_check>(method_idx, receiver,
+                                                       shadow_frame.GetMethod(), self);
+    if (use_inline_cache && method != nullptr && !method->IsAbstract()) {
+      // The lookup may have resolved classes and moved the receiver, the shadow frame has the
+      // updated reference.
+      receiver = shadow_frame.GetVRegReference(vregC);
+      inline_caches->Update(shadow_frame.GetMethod(), shadow_frame.GetDexPC(),
+                            receiver->GetClass(), method);
+    }
+  }
   if (UNLIKELY(method == nullptr)) {
     CHECK(self->IsExceptionPending());
     result->SetJ(0);
@@ -149,15 +185,55 @@ static inline bool DoInvokeVirtualQuick(Thread* self, ShadowFrame& shadow_frame,
   }
 }
 
-// Handles iget-XXX and sget-XXX instructions.
+// Handles invoke-super-quick and invoke-super/range-quick instructions.
 // Returns true on success, otherwise throws an exception and returns false.
-template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check>
+template<bool is_range>
+static inline bool DoInvokeSuperQuick(Thread* self, ShadowFrame& shadow_frame,
+                                      const Instruction* inst, uint16_t inst_data,
+                                      JValue* result) {
+  const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
+  Object* const receiver = shadow_frame.GetVRegReference(vregC);
+  if (UNLIKELY(receiver == nullptr)) {
+    // We lost the reference to the method index so we cannot get a more
+    // precised exception message.
+    ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+    return false;
+  }
+  // The index is in the vtable of the super class of the caller, which quickening checked to be
+  // large enough.
+  const uint32_t vtable_idx = (is_range) ? inst->VRegB_3rc() : inst->VRegB_35c();
+  Class* const super_class = shadow_frame.GetMethod()->GetDeclaringClass()->GetSuperClass();
+  ArtMethod* const method = super_class->GetVTable()->GetWithoutChecks(vtable_idx);
+  if (UNLIKELY(method->IsAbstract())) {
+    ThrowAbstractMethodError(method);
+    result->SetJ(0);
+    return false;
+  } else {
+    // No need to check since we've been quickened.
+    return DoCall<is_range, false>(method, self, shadow_frame, inst, inst_data, result);
+  }
+}
+
+// Returns the field of an sget-XXX-quick or sput-XXX-quick instruction. These keep the field
+// index, quickening only proved that the field is accessible and that its class is initialized
+// whenever the instruction runs, so only the resolution may still be missing from the dex cache.
+static inline ArtField* FindQuickenedStaticField(uint32_t field_idx, ArtMethod* referrer)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  return Runtime::Current()->GetClassLinker()->ResolveField(field_idx, referrer, true);
+}
+
+// Handles iget-XXX, sget-XXX and sget-XXX-quick instructions.
+// Returns true on success, otherwise throws an exception and returns false.
+template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check,
+         bool is_quickened = false>
 static inline bool DoFieldGet(Thread* self, ShadowFrame& shadow_frame,
                               const Instruction* inst, uint16_t inst_data) {
   const bool is_static = (find_type == StaticObjectRead) || (find_type == StaticPrimitiveRead);
   const uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
+  ArtField* f = is_quickened
+      ? FindQuickenedStaticField(field_idx, shadow_frame.GetMethod())
+      : FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
+                                                      Primitive::FieldSize(field_type));
   if (UNLIKELY(f == nullptr)) {
     CHECK(self->IsExceptionPending());
     return false;
@@ -282,16 +358,19 @@ static inline JValue GetFieldValue(const ShadowFrame& shadow_frame, uint32_t vre
   return field_value;
 }
 
-// Handles iput-XXX and sput-XXX instructions.
+// Handles iput-XXX, sput-XXX and sput-XXX-quick instructions.
 // Returns true on success, otherwise throws an exception and returns false.
-template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check, bool transaction_active>
+template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check, bool transaction_active,
+         bool is_quickened = false>
 static inline bool DoFieldPut(Thread* self, const ShadowFrame& shadow_frame,
                               const Instruction* inst, uint16_t inst_data) {
   bool do_assignability_check = do_access_check;
   bool is_static = (find_type == StaticObjectWrite) || (find_type == StaticPrimitiveWrite);
   uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
+  ArtField* f = is_quickened
+      ? FindQuickenedStaticField(field_idx, shadow_frame.GetMethod())
+      : FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
+                                                      Primitive::FieldSize(field_type));
   if (UNLIKELY(f == nullptr)) {
     CHECK(self->IsExceptionPending());
     return false;
@@ -613,7 +692,7 @@ static inline void TraceExecution(const ShadowFrame& shadow_frame, const Instruc
       oss << StringPrintf(" vreg%u=0x%08X", i, raw_value);
       if (ref_value != NULL) {
         if (ref_value->GetClass()->IsStringClass() &&
-            ref_value->AsString()->GetCharArray() != NULL) {
+            ref_value->AsString()->GetArray() != NULL) {
           oss << "/java.lang.String \"" << ref_value->AsString()->ToModifiedUtf8() << "\"";
         } else {
           oss << "/" << PrettyTypeOf(ref_value);
@@ -629,6 +708,24 @@ static inline bool IsBackwardBranch(int32_t branch_offset) {
   return branch_offset <= 0;
 }
 
+// Counts a taken backward branch towards the JIT compilation of the method and, once the method
+// is compiled, continues it in the compiled code at the loop header at target_dex_pc. Returns
+// true if the method completed there, with its result in result or an exception pending.
+static inline bool HandleBackwardBranchJit(Thread* self, ShadowFrame& shadow_frame,
+                                           uint32_t target_dex_pc, jit::Jit* jit, JValue* result)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (jit == nullptr) {
+    return false;
+  }
+  mirror::ArtMethod* method = shadow_frame.GetMethod();
+  jit->AddSamples(self, method, 1);
+  // Only the methods compiled by the jit have loop header entries.
+  if (LIKELY(!jit->GetCodeCache()->Contains(method->GetEntryPointFromQuickCompiledCode()))) {
+    return false;
+  }
+  return jit->DoOnStackReplacement(self, &shadow_frame, target_dex_pc, result);
+}
+
 // Explicitly instantiate all DoInvoke functions.
 #define EXPLICIT_DO_INVOKE_TEMPLATE_DECL(_type, _is_range, _do_check)                      \
   template SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) ALWAYS_INLINE                       \
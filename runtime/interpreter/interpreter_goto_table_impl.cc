@@ -51,6 +51,17 @@ namespace interpreter {
     }                                                                       \
   } while (false)
 
+// Counts the taken backward branch of _offset for the jit and returns the result of the method if
+// it completed in its compiled code.
+#define HANDLE_BACKWARD_BRANCH_JIT(_offset)                                                     \
+  do {                                                                                          \
+    JValue osr_result;                                                                          \
+    if (UNLIKELY(HandleBackwardBranchJit(self, shadow_frame, dex_pc + (_offset), jit,           \
+                                         &osr_result))) {                                       \
+      return osr_result;                                                                        \
+    }                                                                                           \
+  } while (false)
+
 #define UPDATE_HANDLER_TABLE() \
   currentHandlersTable = handlersTable[Runtime::Current()->GetInstrumentation()->GetInterpreterHandlerTable()]
 
@@ -140,6 +151,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     return JValue();
   }
   self->VerifyStack();
+  jit::Jit* const jit = Runtime::Current()->GetJit();
 
   uint32_t dex_pc = shadow_frame.GetDexPC();
   const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
@@ -419,6 +431,18 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   }
   HANDLE_INSTRUCTION_END();
 
+  HANDLE_INSTRUCTION_START(CONST_STRING_QUICK) {
+    // java.lang.String is initialized before any quickened code runs.
+    String* s = mh.ResolveString(inst->VRegB_21c());
+    if (UNLIKELY(s == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_21c(inst_data), s);
+      ADVANCE(2);
+    }
+  }
+  HANDLE_INSTRUCTION_END();
+
   HANDLE_INSTRUCTION_START(CONST_STRING_JUMBO) {
     String* s = ResolveString(self, mh, inst->VRegB_31c());
     if (UNLIKELY(s == NULL)) {
@@ -608,6 +632,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO) {
     int8_t offset = inst->VRegA_10t(inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH_JIT(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -620,6 +645,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_16) {
     int16_t offset = inst->VRegA_20t();
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH_JIT(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -632,6 +658,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_32) {
     int32_t offset = inst->VRegA_30t();
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH_JIT(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -644,6 +671,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(PACKED_SWITCH) {
     int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH_JIT(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -656,6 +684,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(SPARSE_SWITCH) {
     int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH_JIT(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -749,6 +778,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -765,6 +795,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -781,6 +812,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -797,6 +829,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -813,6 +846,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -829,6 +863,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -845,6 +880,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -861,6 +897,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -877,6 +914,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -893,6 +931,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -909,6 +948,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -925,6 +965,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH_JIT(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -1298,6 +1339,24 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   }
   HANDLE_INSTRUCTION_END();
 
+  HANDLE_INSTRUCTION_START(SGET_QUICK) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimInt, false, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
+  HANDLE_INSTRUCTION_START(SGET_WIDE_QUICK) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimLong, false, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
+  HANDLE_INSTRUCTION_START(SGET_OBJECT_QUICK) {
+    bool success = DoFieldGet<StaticObjectRead, Primitive::kPrimNot, false, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
   HANDLE_INSTRUCTION_START(IPUT_BOOLEAN) {
     bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimBoolean, do_access_check, transaction_active>(self, shadow_frame, inst, inst_data);
     POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
@@ -1400,6 +1459,24 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   }
   HANDLE_INSTRUCTION_END();
 
+  HANDLE_INSTRUCTION_START(SPUT_QUICK) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimInt, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
+  HANDLE_INSTRUCTION_START(SPUT_WIDE_QUICK) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimLong, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
+  HANDLE_INSTRUCTION_START(SPUT_OBJECT_QUICK) {
+    bool success = DoFieldPut<StaticObjectWrite, Primitive::kPrimNot, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+  }
+  HANDLE_INSTRUCTION_END();
+
   HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL) {
     bool success = DoInvoke<kVirtual, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
@@ -1484,6 +1561,20 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   }
   HANDLE_INSTRUCTION_END();
 
+  HANDLE_INSTRUCTION_START(INVOKE_SUPER_QUICK) {
+    bool success = DoInvokeSuperQuick<false>(self, shadow_frame, inst, inst_data, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+  }
+  HANDLE_INSTRUCTION_END();
+
+  HANDLE_INSTRUCTION_START(INVOKE_SUPER_RANGE_QUICK) {
+    bool success = DoInvokeSuperQuick<true>(self, shadow_frame, inst, inst_data, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+  }
+  HANDLE_INSTRUCTION_END();
+
   HANDLE_INSTRUCTION_START(NEG_INT)
     shadow_frame.SetVReg(inst->VRegA_12x(inst_data), -shadow_frame.GetVReg(inst->VRegB_12x(inst_data)));
     ADVANCE(1);
@@ -2281,42 +2372,6 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     UnexpectedOpcode(inst, mh);
   HANDLE_INSTRUCTION_END();
 
-  HANDLE_INSTRUCTION_START(UNUSED_EB)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_EC)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_ED)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_EE)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_EF)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_F0)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_F1)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_F2)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
-  HANDLE_INSTRUCTION_START(UNUSED_F3)
-    UnexpectedOpcode(inst, mh);
-  HANDLE_INSTRUCTION_END();
-
   HANDLE_INSTRUCTION_START(UNUSED_F4)
     UnexpectedOpcode(inst, mh);
   HANDLE_INSTRUCTION_END();
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter_common.h"
+
+namespace art {
+namespace interpreter {
+
+// The assembly interpreter, in arch/<arch>/interpreter_<arch>.S. It runs the method from the dex
+// pc of the shadow frame with the interpreter state in registers, threading the dispatch through
+// a table of handlers. Only the simple instructions, moves, constants, integer arithmetic,
+// branches and returns, have a handler: the others, and the suspend checks of the backward
+// branches and returns, are left to the C++ interpreter.
+//
+// Returns true when the method returned, with the result in *result. Returns false with the dex
+// pc of the instruction to run next in the shadow frame.
+#if defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)
+extern "C" bool ExecuteMterpImpl(Thread* self, const uint16_t* insns, ShadowFrame* shadow_frame,
+                                 JValue* result);
+#else
+static bool ExecuteMterpImpl(Thread* self, const uint16_t* insns, ShadowFrame* shadow_frame,
+                             JValue* result) {
+  LOG(FATAL) << "UNREACHABLE";
+  return false;
+}
+#endif
+
+bool ExecuteMterp(Thread* self, const DexFile::CodeItem* code_item, ShadowFrame& shadow_frame,
+                  JValue* result) {
+  DCHECK(kMterpSupported);
+  DCHECK(shadow_frame.GetMethod()->IsPreverified());
+  // The handlers report no instrumentation event. Since they never suspend, the instrumentation
+  // can't change while they run.
+  const instrumentation::Instrumentation* instrumentation =
+      Runtime::Current()->GetInstrumentation();
+  if (instrumentation->HasMethodEntryListeners() || instrumentation->HasMethodExitListeners() ||
+      instrumentation->HasDexPcListeners()) {
+    return false;
+  }
+  return ExecuteMterpImpl(self, code_item->insns_, &shadow_frame, result);
+}
+
+}  // namespace interpreter
+}  // namespace art
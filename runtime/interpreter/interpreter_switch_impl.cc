@@ -47,6 +47,17 @@ namespace interpreter {
     }                                                                             \
   } while (false)
 
+// Counts the taken backward branch of _offset for the jit and returns the result of the method if
+// it completed in its compiled code.
+#define HANDLE_BACKWARD_BRANCH_JIT(_offset)                                                     \
+  do {                                                                                          \
+    JValue osr_result;                                                                          \
+    if (UNLIKELY(HandleBackwardBranchJit(self, shadow_frame, dex_pc + (_offset), jit,           \
+                                         &osr_result))) {                                       \
+      return osr_result;                                                                        \
+    }                                                                                           \
+  } while (false)
+
 // Code to run before each dex instruction.
 #define PREAMBLE()
 
@@ -62,6 +73,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
 
   uint32_t dex_pc = shadow_frame.GetDexPC();
   const instrumentation::Instrumentation* const instrumentation = Runtime::Current()->GetInstrumentation();
+  jit::Jit* const jit = Runtime::Current()->GetJit();
   if (LIKELY(dex_pc == 0)) {  // We are entering the method as opposed to deoptimizing..
     if (UNLIKELY(instrumentation->HasMethodEntryListeners())) {
       instrumentation->MethodEnterEvent(self, shadow_frame.GetThisObject(code_item->ins_size_),
@@ -331,6 +343,18 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         }
         break;
       }
+      case Instruction::CONST_STRING_QUICK: {
+        PREAMBLE();
+        // java.lang.String is initialized before any quickened code runs.
+        String* s = mh.ResolveString(inst->VRegB_21c());
+        if (UNLIKELY(s == NULL)) {
+          HANDLE_PENDING_EXCEPTION();
+        } else {
+          shadow_frame.SetVRegReference(inst->VRegA_21c(inst_data), s);
+          inst = inst->Next_2xx();
+        }
+        break;
+      }
       case Instruction::CONST_STRING_JUMBO: {
         PREAMBLE();
         String* s = ResolveString(self, mh,  inst->VRegB_31c());
@@ -522,6 +546,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int8_t offset = inst->VRegA_10t(inst_data);
         if (IsBackwardBranch(offset)) {
+          HANDLE_BACKWARD_BRANCH_JIT(offset);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -533,6 +558,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int16_t offset = inst->VRegA_20t();
         if (IsBackwardBranch(offset)) {
+          HANDLE_BACKWARD_BRANCH_JIT(offset);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -544,6 +570,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = inst->VRegA_30t();
         if (IsBackwardBranch(offset)) {
+          HANDLE_BACKWARD_BRANCH_JIT(offset);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -555,6 +582,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          HANDLE_BACKWARD_BRANCH_JIT(offset);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -566,6 +594,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          HANDLE_BACKWARD_BRANCH_JIT(offset);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -659,6 +688,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -674,6 +704,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -689,6 +720,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -704,6 +736,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -719,6 +752,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -734,6 +768,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -749,6 +784,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -764,6 +800,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -779,6 +816,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -794,6 +832,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -809,6 +848,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -824,6 +864,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            HANDLE_BACKWARD_BRANCH_JIT(offset);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -1195,6 +1236,24 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
+      case Instruction::SGET_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimInt, false, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
+      case Instruction::SGET_WIDE_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimLong, false, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
+      case Instruction::SGET_OBJECT_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldGet<StaticObjectRead, Primitive::kPrimNot, false, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
       case Instruction::IPUT_BOOLEAN: {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimBoolean, do_access_check, transaction_active>(self, shadow_frame, inst, inst_data);
@@ -1297,6 +1356,24 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
+      case Instruction::SPUT_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimInt, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
+      case Instruction::SPUT_WIDE_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimLong, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
+      case Instruction::SPUT_OBJECT_QUICK: {
+        PREAMBLE();
+        bool success = DoFieldPut<StaticObjectWrite, Primitive::kPrimNot, false, transaction_active, true>(self, shadow_frame, inst, inst_data);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+        break;
+      }
       case Instruction::INVOKE_VIRTUAL: {
         PREAMBLE();
         bool success = DoInvoke<kVirtual, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
@@ -1369,6 +1446,18 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
+      case Instruction::INVOKE_SUPER_QUICK: {
+        PREAMBLE();
+        bool success = DoInvokeSuperQuick<false>(self, shadow_frame, inst, inst_data, &result_register);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+        break;
+      }
+      case Instruction::INVOKE_SUPER_RANGE_QUICK: {
+        PREAMBLE();
+        bool success = DoInvokeSuperQuick<true>(self, shadow_frame, inst, inst_data, &result_register);
+        POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+        break;
+      }
       case Instruction::NEG_INT:
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(inst_data), -shadow_frame.GetVReg(inst->VRegB_12x(inst_data)));
@@ -2141,7 +2230,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         inst = inst->Next_2xx();
         break;
       case Instruction::UNUSED_3E ... Instruction::UNUSED_43:
-      case Instruction::UNUSED_EB ... Instruction::UNUSED_FF:
+      case Instruction::UNUSED_F4 ... Instruction::UNUSED_FF:
       case Instruction::UNUSED_79:
       case Instruction::UNUSED_7A:
         UnexpectedOpcode(inst, mh);
@@ -28,6 +28,8 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <map>
+
 struct iovec;
 
 namespace art {
@@ -283,7 +285,48 @@ struct JdwpState {
       LOCKS_EXCLUDED(event_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  /*
+   * Whether an event of the kind is registered. Doesn't take the event
+   * list lock, so that callers can skip building events that nothing
+   * can match; the answer may be stale.
+   */
+  bool HasEvents(JdwpEventKind eventKind) const {
+    return event_counts_[eventKind] != 0;
+  }
+
+  /*
+   * Whether an event of one of the kinds in "eventFlags", a set of
+   * Dbg::kBreakpoint and the like, is registered. Doesn't lock either.
+   */
+  bool HasLocationEvents(int eventFlags) const;
+
  private:
+  /*
+   * Where an event is filed in event_index_: its kind, and the location
+   * of its LocationOnly mod when it can only match at that location.
+   * Other events have a zero method_id.
+   */
+  struct EventKey {
+    JdwpEventKind kind;
+    MethodId method_id;
+    uint64_t dex_pc;
+
+    bool operator<(const EventKey& other) const {
+      if (kind != other.kind) {
+        return kind < other.kind;
+      }
+      if (method_id != other.method_id) {
+        return method_id < other.method_id;
+      }
+      return dex_pc < other.dex_pc;
+    }
+  };
+  static EventKey GetEventKey(const JdwpEvent* pEvent);
+  void AddMatchingEvents(const EventKey& key, ModBasket* basket, JdwpEvent** match_list,
+                         int* pMatchCount)
+      EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   explicit JdwpState(const JdwpOptions* options);
   size_t ProcessRequest(Request& request, ExpandBuf* pReply);
   bool InvokeInProgress();
@@ -350,6 +393,12 @@ struct JdwpState {
 
   JdwpEvent* event_list_ GUARDED_BY(event_list_lock_);
   size_t event_list_size_ GUARDED_BY(event_list_lock_);  // Number of elements in event_list_.
+  // The events of event_list_ by kind and location, so that posting an event only looks at the
+  // events that can match it.
+  std::multimap<EventKey, JdwpEvent*> event_index_ GUARDED_BY(event_list_lock_);
+  // The number of events of each kind. Written with event_list_lock_ held, read without.
+  static constexpr size_t kNumEventKinds = EK_VM_DISCONNECTED + 1;
+  volatile size_t event_counts_[kNumEventKinds];
 
   // Used to synchronize suspension of the event thread (to avoid receiving "resume"
   // events before the thread has finished suspending itself).
@@ -107,11 +107,24 @@ namespace JDWP {
  * The rest will be zeroed.
  */
 struct ModBasket {
-  ModBasket() : pLoc(NULL), threadId(0), classId(0), excepClassId(0),
+  ModBasket() : pLoc(NULL), hasClassName(false), threadId(0), classId(0), excepClassId(0),
                 caught(false), fieldTypeID(0), fieldId(0), thisPtr(0) { }
 
+  /*
+   * The name of the class of "classId", looked up on first use since only
+   * ClassMatch and ClassExclude mods need it.
+   */
+  const std::string& GetClassName() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!hasClassName) {
+      className = Dbg::GetClassName(classId);
+      hasClassName = true;
+    }
+    return className;
+  }
+
   const JdwpLocation* pLoc;           /* LocationOnly */
   std::string         className;      /* ClassMatch/ClassExclude */
+  bool                hasClassName;
   ObjectId            threadId;       /* ThreadOnly */
   RefTypeId           classId;        /* ClassOnly */
   RefTypeId           excepClassId;   /* ExceptionOnly */
@@ -127,7 +140,6 @@ static bool NeedsFullDeoptimization(JdwpEventKind eventKind) {
       case EK_METHOD_ENTRY:
       case EK_METHOD_EXIT:
       case EK_METHOD_EXIT_WITH_RETURN_VALUE:
-      case EK_SINGLE_STEP:
       case EK_FIELD_ACCESS:
       case EK_FIELD_MODIFICATION:
         return true;
@@ -152,12 +164,12 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
    * If one or more "break"-type mods are used, register them with
    * the interpreter.
    */
-  DeoptimizationRequest req;
+  std::vector<DeoptimizationRequest> reqs;
   for (int i = 0; i < pEvent->modCount; i++) {
     const JdwpEventMod* pMod = &pEvent->mods[i];
     if (pMod->modKind == MK_LOCATION_ONLY) {
       /* should only be for Breakpoint, Step, and Exception */
-      Dbg::WatchLocation(&pMod->locationOnly.loc, &req);
+      Dbg::WatchLocation(&pMod->locationOnly.loc, &reqs);
     } else if (pMod->modKind == MK_STEP) {
       /* should only be for EK_SINGLE_STEP; should only be one */
       JdwpStepSize size = static_cast<JdwpStepSize>(pMod->step.size);
@@ -169,9 +181,11 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
     }
   }
   if (NeedsFullDeoptimization(pEvent->eventKind)) {
-    CHECK_EQ(req.kind, DeoptimizationRequest::kNothing);
-    CHECK(req.method == nullptr);
+    CHECK(reqs.empty());
+    DeoptimizationRequest req;
     req.kind = DeoptimizationRequest::kFullDeoptimization;
+    req.method = nullptr;
+    reqs.push_back(req);
   }
 
   {
@@ -185,16 +199,51 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
     }
     event_list_ = pEvent;
     ++event_list_size_;
+    event_index_.insert(std::make_pair(GetEventKey(pEvent), pEvent));
+    ++event_counts_[pEvent->eventKind];
   }
 
-  // TODO we can do better job here since we should process only one request: the one we just
-  // created.
-  Dbg::RequestDeoptimization(req);
+  // TODO we can do better job here since we should process only the requests we just created.
+  for (const DeoptimizationRequest& req : reqs) {
+    Dbg::RequestDeoptimization(req);
+  }
   Dbg::ManageDeoptimization();
 
   return ERR_NONE;
 }
 
+/*
+ * Find where an event goes in the index.  An event is filed under the
+ * location of its LocationOnly mod unless a Count mod comes first: the
+ * count goes down for every event of its kind, wherever it happens.
+ */
+JdwpState::EventKey JdwpState::GetEventKey(const JdwpEvent* pEvent) {
+  EventKey key;
+  key.kind = pEvent->eventKind;
+  key.method_id = 0;
+  key.dex_pc = 0;
+  for (int i = 0; i < pEvent->modCount; i++) {
+    const JdwpEventMod* pMod = &pEvent->mods[i];
+    if (pMod->modKind == MK_COUNT) {
+      break;
+    }
+    if (pMod->modKind == MK_LOCATION_ONLY && pMod->locationOnly.loc.method_id != 0) {
+      key.method_id = pMod->locationOnly.loc.method_id;
+      key.dex_pc = pMod->locationOnly.loc.dex_pc;
+      break;
+    }
+  }
+  return key;
+}
+
+bool JdwpState::HasLocationEvents(int eventFlags) const {
+  return ((eventFlags & Dbg::kBreakpoint) != 0 && HasEvents(EK_BREAKPOINT)) ||
+      ((eventFlags & Dbg::kSingleStep) != 0 && HasEvents(EK_SINGLE_STEP)) ||
+      ((eventFlags & Dbg::kMethodEntry) != 0 && HasEvents(EK_METHOD_ENTRY)) ||
+      ((eventFlags & Dbg::kMethodExit) != 0 &&
+       (HasEvents(EK_METHOD_EXIT) || HasEvents(EK_METHOD_EXIT_WITH_RETURN_VALUE)));
+}
+
 /*
  * Remove an event from the list.  This will also remove the event from
  * any optimization tables, e.g. breakpoints.
@@ -219,40 +268,44 @@ void JdwpState::UnregisterEvent(JdwpEvent* pEvent) {
   }
   pEvent->prev = NULL;
 
+  auto range = event_index_.equal_range(GetEventKey(pEvent));
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == pEvent) {
+      event_index_.erase(it);
+      break;
+    }
+  }
+  --event_counts_[pEvent->eventKind];
+
   /*
    * Unhook us from the interpreter, if necessary.
    */
-  DeoptimizationRequest req;
+  std::vector<DeoptimizationRequest> reqs;
   for (int i = 0; i < pEvent->modCount; i++) {
     JdwpEventMod* pMod = &pEvent->mods[i];
     if (pMod->modKind == MK_LOCATION_ONLY) {
       /* should only be for Breakpoint, Step, and Exception */
-      Dbg::UnwatchLocation(&pMod->locationOnly.loc, &req);
+      Dbg::UnwatchLocation(&pMod->locationOnly.loc, &reqs);
     }
     if (pMod->modKind == MK_STEP) {
       /* should only be for EK_SINGLE_STEP; should only be one */
       Dbg::UnconfigureStep(pMod->step.threadId);
     }
   }
-  if (pEvent->eventKind == EK_SINGLE_STEP) {
-    // Special case for single-steps where we want to avoid the slow pattern deoptimize/undeoptimize
-    // loop between each single-step. In a IDE, this would happens each time the user click on the
-    // "single-step" button. Here we delay the full undeoptimization to the next resume
-    // (VM.Resume or ThreadReference.Resume) or the end of the debugging session (VM.Dispose or
-    // runtime shutdown).
-    // Therefore, in a singles-stepping sequence, only the first single-step will trigger a full
-    // deoptimization and only the last single-step will trigger a full undeoptimization.
-    Dbg::DelayFullUndeoptimization();
-  } else if (NeedsFullDeoptimization(pEvent->eventKind)) {
-    CHECK_EQ(req.kind, DeoptimizationRequest::kNothing);
-    CHECK(req.method == nullptr);
+  if (NeedsFullDeoptimization(pEvent->eventKind)) {
+    CHECK(reqs.empty());
+    DeoptimizationRequest req;
     req.kind = DeoptimizationRequest::kFullUndeoptimization;
+    req.method = nullptr;
+    reqs.push_back(req);
   }
 
   --event_list_size_;
   CHECK(event_list_size_ != 0 || event_list_ == NULL);
 
-  Dbg::RequestDeoptimization(req);
+  for (const DeoptimizationRequest& req : reqs) {
+    Dbg::RequestDeoptimization(req);
+  }
 }
 
 /*
@@ -435,12 +488,12 @@ static bool ModsMatch(JdwpEvent* pEvent, ModBasket* basket)
       }
       break;
     case MK_CLASS_MATCH:
-      if (!PatternMatch(pMod->classMatch.classPattern, basket->className)) {
+      if (!PatternMatch(pMod->classMatch.classPattern, basket->GetClassName())) {
         return false;
       }
       break;
     case MK_CLASS_EXCLUDE:
-      if (PatternMatch(pMod->classMatch.classPattern, basket->className)) {
+      if (PatternMatch(pMod->classMatch.classPattern, basket->GetClassName())) {
         return false;
       }
       break;
@@ -495,17 +548,34 @@ static bool ModsMatch(JdwpEvent* pEvent, ModBasket* basket)
  */
 void JdwpState::FindMatchingEvents(JdwpEventKind eventKind, ModBasket* basket,
                                    JdwpEvent** match_list, int* pMatchCount) {
+  if (!HasEvents(eventKind)) {
+    return;
+  }
+  EventKey key;
+  key.kind = eventKind;
+  key.method_id = 0;
+  key.dex_pc = 0;
+  AddMatchingEvents(key, basket, match_list, pMatchCount);
+  /* only the events filed under the basket's location can match there */
+  if (basket->pLoc != NULL && basket->pLoc->method_id != 0) {
+    key.method_id = basket->pLoc->method_id;
+    key.dex_pc = basket->pLoc->dex_pc;
+    AddMatchingEvents(key, basket, match_list, pMatchCount);
+  }
+}
+
+void JdwpState::AddMatchingEvents(const EventKey& key, ModBasket* basket,
+                                  JdwpEvent** match_list, int* pMatchCount) {
   /* start after the existing entries */
   match_list += *pMatchCount;
 
-  JdwpEvent* pEvent = event_list_;
-  while (pEvent != NULL) {
-    if (pEvent->eventKind == eventKind && ModsMatch(pEvent, basket)) {
+  auto range = event_index_.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    JdwpEvent* pEvent = it->second;
+    if (ModsMatch(pEvent, basket)) {
       *match_list++ = pEvent;
       (*pMatchCount)++;
     }
-
-    pEvent = pEvent->next;
   }
 }
 
@@ -765,7 +835,6 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
   basket.classId = pLoc->class_id;
   basket.thisPtr = thisPtr;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(pLoc->class_id);
 
   /*
    * On rare occasions we may need to execute interpreted code in the VM
@@ -788,7 +857,7 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
    * method invocation to complete.
    */
   if (InvokeInProgress()) {
-    VLOG(jdwp) << "Not checking breakpoints during invoke (" << basket.className << ")";
+    VLOG(jdwp) << "Not checking breakpoints during invoke (" << basket.GetClassName() << ")";
     return false;
   }
 
@@ -813,7 +882,7 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
     }
     if (match_count != 0) {
       VLOG(jdwp) << "EVENT: " << match_list[0]->eventKind << "(" << match_count << " total) "
-                 << basket.className << "." << Dbg::GetMethodName(pLoc->method_id)
+                 << basket.GetClassName() << "." << Dbg::GetMethodName(pLoc->method_id)
                  << StringPrintf(" thread=%#" PRIx64 "  dex_pc=%#" PRIx64 ")",
                                  basket.threadId, pLoc->dex_pc);
 
@@ -851,7 +920,6 @@ bool JdwpState::PostFieldEvent(const JdwpLocation* pLoc, RefTypeId typeId, Field
   basket.classId = pLoc->class_id;
   basket.thisPtr = thisPtr;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(pLoc->class_id);
   basket.fieldTypeID = typeId;
   basket.fieldId = fieldId;
 
@@ -889,7 +957,7 @@ bool JdwpState::PostFieldEvent(const JdwpLocation* pLoc, RefTypeId typeId, Field
     }
     if (match_count != 0) {
       VLOG(jdwp) << "EVENT: " << match_list[0]->eventKind << "(" << match_count << " total) "
-                 << basket.className << "." << Dbg::GetMethodName(pLoc->method_id)
+                 << basket.GetClassName() << "." << Dbg::GetMethodName(pLoc->method_id)
                  << StringPrintf(" thread=%#" PRIx64 "  dex_pc=%#" PRIx64 ")",
                                  basket.threadId, pLoc->dex_pc);
 
@@ -1024,14 +1092,13 @@ bool JdwpState::PostException(const JdwpLocation* pThrowLoc,
   basket.pLoc = pThrowLoc;
   basket.classId = pThrowLoc->class_id;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(basket.classId);
   basket.excepClassId = exceptionClassId;
   basket.caught = (pCatchLoc->class_id != 0);
   basket.thisPtr = thisPtr;
 
   /* don't try to post an exception caused by the debugger */
   if (InvokeInProgress()) {
-    VLOG(jdwp) << "Not posting exception hit during invoke (" << basket.className << ")";
+    VLOG(jdwp) << "Not posting exception hit during invoke (" << basket.GetClassName() << ")";
     return false;
   }
 
@@ -1095,11 +1162,10 @@ bool JdwpState::PostClassPrepare(JdwpTypeTag tag, RefTypeId refTypeId, const std
 
   basket.classId = refTypeId;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(basket.classId);
 
   /* suppress class prep caused by debugger */
   if (InvokeInProgress()) {
-    VLOG(jdwp) << "Not posting class prep caused by invoke (" << basket.className << ")";
+    VLOG(jdwp) << "Not posting class prep caused by invoke (" << basket.GetClassName() << ")";
     return false;
   }
 
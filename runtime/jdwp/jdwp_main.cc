@@ -224,6 +224,9 @@ JdwpState::JdwpState(const JdwpOptions* options)
       ddm_is_active_(false),
       should_exit_(false),
       exit_status_(0) {
+  for (size_t i = 0; i < kNumEventKinds; ++i) {
+    event_counts_[i] = 0;
+  }
 }
 
 /*
@@ -318,7 +321,8 @@ void JdwpState::ResetState() {
     CHECK(event_list_ == NULL);
   }
 
-  Dbg::ProcessDelayedFullUndeoptimizations();
+  // Process the undeoptimization requests of the unregistered events.
+  Dbg::ManageDeoptimization();
 
   /*
    * Should not have one of these in progress.  If the debugger went away
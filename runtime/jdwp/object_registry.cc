@@ -30,6 +30,85 @@ std::ostream& operator<<(std::ostream& os, const ObjectRegistryEntry& rhs) {
   return os;
 }
 
+ObjectRegistryTable::ObjectRegistryTable()
+    : slots_(kInitialCapacity, Slot()), size_(0), used_(0) {
+}
+
+ObjectRegistryEntry* ObjectRegistryTable::Find(uint64_t key) const {
+  DCHECK_NE(key, 0U);
+  size_t mask = slots_.size() - 1;
+  for (size_t i = Hash(key) & mask; ; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+    if (slot.key == key) {
+      return slot.entry;
+    }
+    if (slot.key == 0) {
+      return nullptr;
+    }
+  }
+}
+
+void ObjectRegistryTable::Insert(uint64_t key, ObjectRegistryEntry* entry) {
+  DCHECK_NE(key, 0U);
+  DCHECK(Find(key) == nullptr);
+  if ((used_ + 1) * 100 > slots_.size() * kMaxLoadPercent) {
+    // Double the capacity if the keys alone would fill it past half the limit, otherwise only
+    // drop the removed slots.
+    size_t capacity = slots_.size();
+    if ((size_ + 1) * 200 > capacity * kMaxLoadPercent) {
+      capacity *= 2;
+    }
+    Rebuild(capacity);
+  }
+  size_t mask = slots_.size() - 1;
+  size_t i = Hash(key) & mask;
+  while (slots_[i].key != 0 && slots_[i].key != kRemovedKey) {
+    i = (i + 1) & mask;
+  }
+  if (slots_[i].key == 0) {
+    ++used_;
+  }
+  slots_[i].key = key;
+  slots_[i].entry = entry;
+  ++size_;
+}
+
+bool ObjectRegistryTable::Erase(uint64_t key) {
+  DCHECK_NE(key, 0U);
+  size_t mask = slots_.size() - 1;
+  for (size_t i = Hash(key) & mask; slots_[i].key != 0; i = (i + 1) & mask) {
+    if (slots_[i].key == key) {
+      slots_[i].key = kRemovedKey;
+      slots_[i].entry = nullptr;
+      --size_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ObjectRegistryTable::TakeAll(std::vector<Slot>* slots) {
+  slots->reserve(slots->size() + size_);
+  for (Slot& slot : slots_) {
+    if (slot.key != 0 && slot.key != kRemovedKey) {
+      slots->push_back(slot);
+    }
+    slot.key = 0;
+    slot.entry = nullptr;
+  }
+  size_ = 0;
+  used_ = 0;
+}
+
+void ObjectRegistryTable::Rebuild(size_t capacity) {
+  std::vector<Slot> slots;
+  TakeAll(&slots);
+  slots_.assign(capacity, Slot());
+  for (const Slot& slot : slots) {
+    Insert(slot.key, slot.entry);
+  }
+}
+
 ObjectRegistry::ObjectRegistry()
     : lock_("ObjectRegistry lock", kJdwpObjectRegistryLock), allow_new_objects_(true),
       condition_("object registry condition", lock_), next_id_(1) {
@@ -53,11 +132,9 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
   while (UNLIKELY(!allow_new_objects_)) {
     condition_.WaitHoldingLocks(soa.Self());
   }
-  ObjectRegistryEntry* entry;
-  auto it = object_to_entry_.find(o);
-  if (it != object_to_entry_.end()) {
-    // This object was already in our map.
-    entry = it->second;
+  ObjectRegistryEntry* entry = object_to_entry_.Find(ObjectKey(o));
+  if (entry != nullptr) {
+    // This object was already in our table.
     ++entry->reference_count;
   } else {
     entry = new ObjectRegistryEntry;
@@ -65,7 +142,7 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
     entry->jni_reference = nullptr;
     entry->reference_count = 0;
     entry->id = 0;
-    object_to_entry_.insert(std::make_pair(o, entry));
+    object_to_entry_.Insert(ObjectKey(o), entry);
 
     // This object isn't in the registry yet, so add it.
     JNIEnv* env = soa.Env();
@@ -77,7 +154,7 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
     entry->reference_count = 1;
     entry->id = next_id_++;
 
-    id_to_entry_.Put(entry->id, entry);
+    id_to_entry_.Insert(entry->id, entry);
 
     env->DeleteLocalRef(local_reference);
   }
@@ -86,37 +163,39 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
 
 bool ObjectRegistry::Contains(mirror::Object* o) {
   MutexLock mu(Thread::Current(), lock_);
-  return object_to_entry_.find(o) != object_to_entry_.end();
+  return object_to_entry_.Find(ObjectKey(o)) != nullptr;
 }
 
 void ObjectRegistry::Clear() {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  VLOG(jdwp) << "Object registry contained " << object_to_entry_.size() << " entries";
-  // Delete all the JNI references.
+  VLOG(jdwp) << "Object registry contained " << id_to_entry_.Size() << " entries";
+  // Clear the tables.
+  std::vector<ObjectRegistryTable::Slot> slots;
+  std::vector<ObjectRegistryTable::Slot> unused_slots;
+  id_to_entry_.TakeAll(&slots);
+  object_to_entry_.TakeAll(&unused_slots);
+  // Delete all the JNI references. The id table also has the entries of the collected objects.
   JNIEnv* env = self->GetJniEnv();
-  for (const auto& pair : object_to_entry_) {
-    const ObjectRegistryEntry& entry = *pair.second;
-    if (entry.jni_reference_type == JNIWeakGlobalRefType) {
-      env->DeleteWeakGlobalRef(entry.jni_reference);
+  for (const ObjectRegistryTable::Slot& slot : slots) {
+    ObjectRegistryEntry* entry = slot.entry;
+    if (entry->jni_reference_type == JNIWeakGlobalRefType) {
+      env->DeleteWeakGlobalRef(entry->jni_reference);
     } else {
-      env->DeleteGlobalRef(entry.jni_reference);
+      env->DeleteGlobalRef(entry->jni_reference);
     }
+    delete entry;
   }
-  // Clear the maps.
-  object_to_entry_.clear();
-  id_to_entry_.clear();
 }
 
 mirror::Object* ObjectRegistry::InternalGet(JDWP::ObjectId id) {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  if (it == id_to_entry_.end()) {
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  if (entry == nullptr) {
     return kInvalidObject;
   }
-  ObjectRegistryEntry& entry = *it->second;
-  return self->DecodeJObject(entry.jni_reference);
+  return self->DecodeJObject(entry->jni_reference);
 }
 
 jobject ObjectRegistry::GetJObject(JDWP::ObjectId id) {
@@ -125,26 +204,25 @@ jobject ObjectRegistry::GetJObject(JDWP::ObjectId id) {
   }
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  CHECK(it != id_to_entry_.end()) << id;
-  ObjectRegistryEntry& entry = *it->second;
-  return entry.jni_reference;
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  CHECK(entry != nullptr) << id;
+  return entry->jni_reference;
 }
 
 void ObjectRegistry::DisableCollection(JDWP::ObjectId id) {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  CHECK(it != id_to_entry_.end());
-  Promote(*it->second);
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  CHECK(entry != nullptr);
+  Promote(*entry);
 }
 
 void ObjectRegistry::EnableCollection(JDWP::ObjectId id) {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  CHECK(it != id_to_entry_.end());
-  Demote(*it->second);
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  CHECK(entry != nullptr);
+  Demote(*entry);
 }
 
 void ObjectRegistry::Demote(ObjectRegistryEntry& entry) {
@@ -172,12 +250,11 @@ void ObjectRegistry::Promote(ObjectRegistryEntry& entry) {
 bool ObjectRegistry::IsCollected(JDWP::ObjectId id) {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  CHECK(it != id_to_entry_.end());
-  ObjectRegistryEntry& entry = *it->second;
-  if (entry.jni_reference_type == JNIWeakGlobalRefType) {
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  CHECK(entry != nullptr);
+  if (entry->jni_reference_type == JNIWeakGlobalRefType) {
     JNIEnv* env = self->GetJniEnv();
-    return env->IsSameObject(entry.jni_reference, NULL);  // Has the jweak been collected?
+    return env->IsSameObject(entry->jni_reference, NULL);  // Has the jweak been collected?
   } else {
     return false;  // We hold a strong reference, so we know this is live.
   }
@@ -186,11 +263,10 @@ bool ObjectRegistry::IsCollected(JDWP::ObjectId id) {
 void ObjectRegistry::DisposeObject(JDWP::ObjectId id, uint32_t reference_count) {
   Thread* self = Thread::Current();
   MutexLock mu(self, lock_);
-  auto it = id_to_entry_.find(id);
-  if (it == id_to_entry_.end()) {
+  ObjectRegistryEntry* entry = id_to_entry_.Find(id);
+  if (entry == nullptr) {
     return;
   }
-  ObjectRegistryEntry* entry = it->second;
   entry->reference_count -= reference_count;
   if (entry->reference_count <= 0) {
     JNIEnv* env = self->GetJniEnv();
@@ -200,28 +276,28 @@ void ObjectRegistry::DisposeObject(JDWP::ObjectId id, uint32_t reference_count)
     } else {
       env->DeleteGlobalRef(entry->jni_reference);
     }
-    object_to_entry_.erase(object);
-    id_to_entry_.erase(id);
+    if (object != nullptr) {
+      object_to_entry_.Erase(ObjectKey(object));
+    }
+    id_to_entry_.Erase(id);
     delete entry;
   }
 }
 
 void ObjectRegistry::UpdateObjectPointers(IsMarkedCallback* callback, void* arg) {
   MutexLock mu(Thread::Current(), lock_);
-  if (object_to_entry_.empty()) {
+  if (object_to_entry_.Size() == 0) {
     return;
   }
-  std::map<mirror::Object*, ObjectRegistryEntry*> new_object_to_entry;
-  for (auto& pair : object_to_entry_) {
-    mirror::Object* new_obj;
-    if (pair.first != nullptr) {
-      new_obj = callback(pair.first, arg);
-      if (new_obj != nullptr) {
-        new_object_to_entry.insert(std::make_pair(new_obj, pair.second));
-      }
+  // The moved objects hash differently, put every live object back under its new address.
+  std::vector<ObjectRegistryTable::Slot> slots;
+  object_to_entry_.TakeAll(&slots);
+  for (const ObjectRegistryTable::Slot& slot : slots) {
+    mirror::Object* new_obj = callback(reinterpret_cast<mirror::Object*>(slot.key), arg);
+    if (new_obj != nullptr) {
+      object_to_entry_.Insert(ObjectKey(new_obj), slot.entry);
     }
   }
-  object_to_entry_ = new_object_to_entry;
 }
 
 void ObjectRegistry::AllowNewObjects() {
@@ -19,7 +19,7 @@
 
 #include <stdint.h>
 
-#include <map>
+#include <vector>
 
 #include "jdwp/jdwp.h"
 #include "mirror/art_field-inl.h"
@@ -27,7 +27,6 @@
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "object_callbacks.h"
-#include "safe_map.h"
 
 namespace art {
 
@@ -46,6 +45,59 @@ struct ObjectRegistryEntry {
 };
 std::ostream& operator<<(std::ostream& os, const ObjectRegistryEntry& rhs);
 
+// An open addressing hash table with linear probing from keys to registry entries. The keys are
+// object addresses or object ids, neither of which is zero. Removed slots are only reclaimed when
+// the table is rebuilt.
+class ObjectRegistryTable {
+ public:
+  struct Slot {
+    // Zero for a never used slot, kRemovedKey for a removed one.
+    uint64_t key;
+    ObjectRegistryEntry* entry;
+  };
+
+  // Initial number of slots, a power of two.
+  static constexpr size_t kInitialCapacity = 64;
+  // The table is rebuilt once the used and removed slots make up this percentage of the slots.
+  static constexpr size_t kMaxLoadPercent = 70;
+
+  ObjectRegistryTable();
+
+  // Returns the entry of key, or null.
+  ObjectRegistryEntry* Find(uint64_t key) const;
+
+  // Add key, which must not already be in the table.
+  void Insert(uint64_t key, ObjectRegistryEntry* entry);
+
+  // Remove key, returns false if it isn't in the table.
+  bool Erase(uint64_t key);
+
+  // Append every slot in use to slots and empty the table.
+  void TakeAll(std::vector<Slot>* slots);
+
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  static constexpr uint64_t kRemovedKey = ~static_cast<uint64_t>(0);
+
+  static size_t Hash(uint64_t key) {
+    // The finalizer of MurmurHash3, spreads both the aligned addresses and the sequential ids.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+  }
+
+  void Rebuild(size_t capacity);
+
+  std::vector<Slot> slots_;
+  // The number of keys, and of keys and removed slots.
+  size_t size_;
+  size_t used_;
+};
+
 // Tracks those objects currently known to the debugger, so we can use consistent ids when
 // referring to them. Normally we keep JNI weak global references to objects, so they can
 // still be garbage collected. The debugger can ask us to retain objects, though, so we can
@@ -89,11 +141,15 @@ class ObjectRegistry {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // We have allow / disallow functionality since we use system weak sweeping logic to update moved
-  // objects inside of the object_to_entry_ map.
+  // objects inside of the object_to_entry_ table.
   void AllowNewObjects() LOCKS_EXCLUDED(lock_);
   void DisallowNewObjects() LOCKS_EXCLUDED(lock_);
 
  private:
+  static uint64_t ObjectKey(mirror::Object* o) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(o));
+  }
+
   JDWP::ObjectId InternalAdd(mirror::Object* o) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::Object* InternalGet(JDWP::ObjectId id) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void Demote(ObjectRegistryEntry& entry) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, lock_);
@@ -103,8 +159,9 @@ class ObjectRegistry {
   bool allow_new_objects_ GUARDED_BY(lock_);
   ConditionVariable condition_ GUARDED_BY(lock_);
 
-  std::map<mirror::Object*, ObjectRegistryEntry*> object_to_entry_ GUARDED_BY(lock_);
-  SafeMap<JDWP::ObjectId, ObjectRegistryEntry*> id_to_entry_ GUARDED_BY(lock_);
+  // Keyed by the address of the object.
+  ObjectRegistryTable object_to_entry_ GUARDED_BY(lock_);
+  ObjectRegistryTable id_to_entry_ GUARDED_BY(lock_);
 
   size_t next_id_ GUARDED_BY(lock_);
 };
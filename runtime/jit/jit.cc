@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit.h"
+
+#include <dlfcn.h>
+
+#include <vector>
+
+#include "base/logging.h"
+#include "debugger.h"
+#include "entrypoints/entrypoint_utils.h"
+#include "instrumentation.h"
+#include "interpreter/interpreter.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+#if defined(__arm__) || defined(__i386__)
+// Calls the on-stack replacement entry of method with the Dalvik registers in vregs and stores
+// its result, as art_quick_invoke_stub does for the method entry.
+extern "C" void art_quick_osr_stub(mirror::ArtMethod* method, uint32_t* vregs, const void* entry,
+                                   Thread* self, JValue* result, const char* shorty);
+#endif
+
+// Compiles one queued method on the compiler thread. The raw method pointer is safe to hold while
+// suspended since ArtMethods are allocated in the non moving space and never unloaded.
+class JitCompileTask : public Task {
+ public:
+  JitCompileTask(Jit* jit, mirror::ArtMethod* method) : jit_(jit), method_(method) {
+  }
+
+  virtual void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    jit_->CompileMethod(self, method_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  Jit* const jit_;
+  mirror::ArtMethod* const method_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompileTask);
+};
+
+// Collects the methods with quick frames on the stack of a thread, their code can't be evicted.
+class LiveMethodsVisitor : public StackVisitor {
+ public:
+  LiveMethodsVisitor(Thread* thread, std::set<mirror::ArtMethod*>* live_methods)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), live_methods_(live_methods) {
+  }
+
+  virtual bool VisitFrame() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (GetCurrentQuickFrame() != nullptr) {
+      live_methods_->insert(GetMethod());
+    }
+    return true;
+  }
+
+ private:
+  std::set<mirror::ArtMethod*>* const live_methods_;
+};
+
+static void AddLiveMethods(Thread* thread, void* arg)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  LiveMethodsVisitor visitor(thread, reinterpret_cast<std::set<mirror::ArtMethod*>*>(arg));
+  visitor.WalkStack();
+}
+
+Jit* Jit::Create(size_t compile_threshold, size_t code_cache_capacity, std::string* error_msg) {
+  CHECK_GT(compile_threshold, 0U);
+  CHECK_LE(compile_threshold, kMaxCompileThreshold);
+  JitCodeCache* code_cache = JitCodeCache::Create(code_cache_capacity, error_msg);
+  if (code_cache == nullptr) {
+    return nullptr;
+  }
+  UniquePtr<Jit> jit(new Jit(compile_threshold, code_cache));
+  if (!jit->LoadCompiler(error_msg)) {
+    return nullptr;
+  }
+  return jit.release();
+}
+
+Jit::Jit(size_t compile_threshold, JitCodeCache* code_cache)
+    : compile_threshold_(compile_threshold),
+      code_cache_(code_cache),
+      jit_library_handle_(nullptr),
+      jit_compiler_handle_(nullptr),
+      jit_load_(nullptr),
+      jit_unload_(nullptr),
+      jit_compile_method_(nullptr),
+      lock_("jit lock", kJitLock),
+      compiled_methods_(0),
+      failed_methods_(0),
+      osr_transitions_(0) {
+  memset(hotness_table_, 0, sizeof(hotness_table_));
+}
+
+bool Jit::LoadCompiler(std::string* error_msg) {
+  const char* library = kIsDebugBuild ? "libartd-compiler.so" : "libart-compiler.so";
+  jit_library_handle_ = dlopen(library, RTLD_NOW);
+  if (jit_library_handle_ == nullptr) {
+    *error_msg = StringPrintf("dlopen(\"%s\") failed: %s", library, dlerror());
+    return false;
+  }
+  jit_load_ = reinterpret_cast<void* (*)()>(dlsym(jit_library_handle_, "jit_load"));
+  jit_unload_ = reinterpret_cast<void (*)(void*)>(dlsym(jit_library_handle_, "jit_unload"));
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, mirror::ArtMethod*, Thread*)>(
+      dlsym(jit_library_handle_, "jit_compile_method"));
+  if (jit_load_ == nullptr || jit_unload_ == nullptr || jit_compile_method_ == nullptr) {
+    *error_msg = StringPrintf("%s lacks the jit entry points", library);
+    dlclose(jit_library_handle_);
+    jit_library_handle_ = nullptr;
+    return false;
+  }
+  jit_compiler_handle_ = jit_load_();
+  CHECK(jit_compiler_handle_ != nullptr);
+  return true;
+}
+
+Jit::~Jit() {
+  DeleteThreadPool();
+  if (jit_compiler_handle_ != nullptr) {
+    jit_unload_(jit_compiler_handle_);
+  }
+  if (jit_library_handle_ != nullptr) {
+    dlclose(jit_library_handle_);
+  }
+}
+
+void Jit::CreateThreadPool() {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = new ThreadPool("Jit thread pool", 1);
+  thread_pool->StartWorkers(self);
+  MutexLock mu(self, lock_);
+  CHECK(thread_pool_.get() == nullptr);
+  thread_pool_.reset(thread_pool);
+}
+
+void Jit::DeleteThreadPool() {
+  ThreadPool* thread_pool;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    thread_pool = thread_pool_.release();
+  }
+  // Waits for the method being compiled, the methods still queued are dropped.
+  delete thread_pool;
+}
+
+bool Jit::CanCompile(mirror::ArtMethod* method) {
+  if (method->IsNative() || method->IsAbstract() || method->IsProxyMethod() ||
+      !method->IsPreverified()) {
+    return false;
+  }
+  // Only methods without code are compiled. This also keeps the code of the static methods of
+  // classes still being initialized on the resolution trampoline, which waits for the
+  // initialization.
+  return method->GetEntryPointFromQuickCompiledCode() == GetQuickToInterpreterBridge();
+}
+
+bool Jit::EnqueueCompilation(Thread* self, mirror::ArtMethod* method) {
+  if (!CanCompile(method)) {
+    return false;
+  }
+  MutexLock mu(self, lock_);
+  if (thread_pool_.get() == nullptr) {
+    // The zygote doesn't compile, the method is queued after the fork if it is still hot.
+    return false;
+  }
+  if (queued_methods_.insert(method).second) {
+    thread_pool_->AddTask(self, new JitCompileTask(this, method));
+  }
+  return true;
+}
+
+bool Jit::CompileMethod(Thread* self, mirror::ArtMethod* method) {
+  uint64_t start_ns = NanoTime();
+  bool success = CanCompile(method) && jit_compile_method_(jit_compiler_handle_, method, self);
+  VLOG(compiler) << "Jit " << (success ? "compiled " : "failed to compile ")
+                 << PrettyMethod(method) << " in " << PrettyDuration(NanoTime() - start_ns);
+  MutexLock mu(self, lock_);
+  if (success) {
+    ++compiled_methods_;
+  } else {
+    ++failed_methods_;
+  }
+  return success;
+}
+
+bool Jit::DoOnStackReplacement(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                               JValue* result) {
+#if defined(__arm__) || defined(__i386__)
+  mirror::ArtMethod* method = shadow_frame->GetMethod();
+  // Listeners and the debugger expect the frame to stay in the interpreter. A synchronized
+  // method keeps the monitor its caller took, the compiled code would release it again.
+  if (method->IsSynchronized() || Runtime::Current()->GetInstrumentation()->IsActive() ||
+      Dbg::IsDebuggerActive() || self->GetManagedStack()->GetTopShadowFrame() != shadow_frame) {
+    return false;
+  }
+  const void* entry = code_cache_->LookupOsrEntry(self, method, dex_pc);
+  if (entry == nullptr) {
+    return false;
+  }
+  // A stack overflow thrown by the entry would be thrown from the compiled frame, past the
+  // handlers of the interpreted code, so the frame must fit well clear of the protected region.
+  uintptr_t sp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+  uintptr_t stack_end = reinterpret_cast<uintptr_t>(self->GetStackEnd());
+  if (sp < stack_end + method->GetFrameSizeInBytes() + Thread::kStackOverflowReservedBytes) {
+    return false;
+  }
+  VLOG(compiler) << "Jit on-stack replacement of " << PrettyMethod(method) << " at dex pc 0x"
+                 << std::hex << dex_pc;
+  ++osr_transitions_;
+  const char* shorty = MethodHelper(method).GetShorty();
+  // The compiled frame replaces the shadow frame, the stack walks must not find both. The
+  // Dalvik registers are copied before the first suspend point of the entry.
+  ShadowFrame* top_shadow_frame = self->PopShadowFrame();
+  DCHECK_EQ(top_shadow_frame, shadow_frame);
+  ManagedStack fragment;
+  self->PushManagedStackFragment(&fragment);
+  art_quick_osr_stub(method, shadow_frame->GetVRegArgs(0), entry, self, result, shorty);
+  if (UNLIKELY(self->GetException(nullptr) == Thread::GetDeoptimizationException())) {
+    // Instrumentation deoptimized the compiled frame, the method finishes in the interpreter.
+    self->ClearException();
+    ShadowFrame* deoptimized_frame = self->GetAndClearDeoptimizationShadowFrame(result);
+    self->SetTopOfStack(nullptr, 0);
+    self->SetTopOfShadowStack(deoptimized_frame);
+    interpreter::EnterInterpreterFromDeoptimize(self, deoptimized_frame, result);
+  }
+  self->PopManagedStackFragment(fragment);
+  // The caller of the interpreter pops the frame.
+  self->PushShadowFrame(shadow_frame);
+  return true;
+#else
+  UNUSED(self);
+  UNUSED(shadow_frame);
+  UNUSED(dex_pc);
+  UNUSED(result);
+  return false;
+#endif
+}
+
+uint8_t* Jit::ReserveCode(Thread* self, mirror::ArtMethod* method, size_t size) {
+  uint8_t* result = code_cache_->ReserveMethod(self, method, size);
+  if (result == nullptr && size <= code_cache_->Capacity()) {
+    CollectCodeCache(self, size);
+    result = code_cache_->ReserveMethod(self, method, size);
+  }
+  return result;
+}
+
+void Jit::CollectCodeCache(Thread* self, size_t size) {
+  uint64_t start_ns = NanoTime();
+  Runtime* runtime = Runtime::Current();
+  ThreadList* thread_list = runtime->GetThreadList();
+  // Threads load the entry point of a method and call it without a suspend check in between, so
+  // once all are suspended, the code of the methods without frames is unreachable.
+  self->TransitionFromRunnableToSuspended(kSuspended);
+  thread_list->SuspendAll();
+  std::set<mirror::ArtMethod*> live_methods;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    thread_list->ForEach(AddLiveMethods, &live_methods);
+  }
+  std::vector<mirror::ArtMethod*> evicted_methods;
+  code_cache_->Collect(self, live_methods, size, &evicted_methods);
+  // The methods stay in queued_methods_, so they aren't compiled again.
+  instrumentation::Instrumentation* instrumentation = runtime->GetInstrumentation();
+  for (mirror::ArtMethod* method : evicted_methods) {
+    instrumentation->UpdateMethodsCode(method, GetQuickToInterpreterBridge(),
+                                       GetPortableToInterpreterBridge(), false);
+    method->SetNativeGcMap(nullptr);
+  }
+  thread_list->ResumeAll();
+  self->TransitionFromSuspendedToRunnable();
+  VLOG(compiler) << "Jit code cache collection evicted " << evicted_methods.size()
+                 << " methods in " << PrettyDuration(NanoTime() - start_ns);
+}
+
+void Jit::GetCompileCounts(size_t* compiled_methods, size_t* failed_methods) {
+  MutexLock mu(Thread::Current(), lock_);
+  *compiled_methods = compiled_methods_;
+  *failed_methods = failed_methods_;
+}
+
+void Jit::DumpInfo(std::ostream& os) {
+  size_t compiled_methods;
+  size_t failed_methods;
+  GetCompileCounts(&compiled_methods, &failed_methods);
+  os << "Jit compiled methods: " << compiled_methods << "\n"
+     << "Jit failed compilations: " << failed_methods << "\n"
+     << "Jit on-stack replacements: " << osr_transitions_ << "\n"
+     << "Jit code cache: " << PrettySize(code_cache_->Size()) << " of "
+     << PrettySize(code_cache_->Capacity()) << " in " << code_cache_->NumberOfMethods()
+     << " methods, " << code_cache_->NumberOfCollections() << " collections evicted "
+     << code_cache_->NumberOfEvictedMethods() << " methods\n";
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_H_
+#define ART_RUNTIME_JIT_JIT_H_
+
+#include <ostream>
+#include <set>
+#include <string>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "jit_code_cache.h"
+#include "thread_pool.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+union JValue;
+class ShadowFrame;
+class Thread;
+
+namespace jit {
+
+// Compiles the methods the interpreter finds hot with the quick compiler of libart-compiler.so.
+//
+// The interpreter adds a sample at each method entry and taken backward branch. When the samples
+// of a method reach the compile threshold, the method is queued for the compiler thread, which
+// writes the code into the code cache and installs it as the entry point of the method. Frames of
+// the method already in the interpreter finish there. When the code cache is full, the code of the
+// oldest methods without frames is discarded and they go back to the interpreter for good.
+//
+// On arm and x86, a frame still in the interpreter moves to the compiled code at the next loop
+// header it branches back to: the code has an on-stack replacement entry at each loop header,
+// which builds the compiled frame from the Dalvik registers of the shadow frame.
+class Jit {
+ public:
+  static constexpr size_t kDefaultCompileThreshold = 1000;
+  // The samples are counted in 16 bits.
+  static constexpr size_t kMaxCompileThreshold = 0xFFFF;
+
+  // Loads the compiler and maps the code cache, returns nullptr with the reason in error_msg on
+  // failure.
+  static Jit* Create(size_t compile_threshold, size_t code_cache_capacity, std::string* error_msg);
+
+  ~Jit();
+
+  // Starts and stops the compiler thread. Kept out of Create so that the zygote doesn't fork with
+  // it running.
+  void CreateThreadPool() LOCKS_EXCLUDED(lock_);
+  void DeleteThreadPool() LOCKS_EXCLUDED(lock_);
+
+  // Adds count samples to method, queueing it for compilation when they reach the threshold.
+  // Called from the interpreter on every invoke and backward branch, so the common case is only
+  // a few loads and a store.
+  void AddSamples(Thread* self, mirror::ArtMethod* method, size_t count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    HotnessEntry* entry = &hotness_table_[HotnessIndex(method)];
+    size_t samples;
+    if (LIKELY(entry->method == method)) {
+      samples = entry->samples;
+      if (samples >= compile_threshold_) {
+        // Queued already.
+        return;
+      }
+    } else {
+      entry->method = method;
+      samples = 0;
+    }
+    samples += count;
+    if (UNLIKELY(samples >= compile_threshold_)) {
+      // A method that can't be compiled yet starts over.
+      entry->samples = EnqueueCompilation(self, method) ? compile_threshold_ : 0U;
+    } else {
+      entry->samples = static_cast<uint16_t>(samples);
+    }
+  }
+
+  // Compiles method on the calling thread and installs its code. Returns false when the method
+  // can't be compiled or the code cache is full.
+  bool CompileMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Reserves size bytes of the code cache for the code of method, collecting the cache if it is
+  // full. Called by the compiler, returns nullptr if the code doesn't fit even then.
+  uint8_t* ReserveCode(Thread* self, mirror::ArtMethod* method, size_t size)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Continues the method of shadow_frame, the top shadow frame of self, in its compiled code at
+  // the loop header at dex_pc if the code has an entry there. Returns false when it doesn't,
+  // otherwise the method completed with its result in result or an exception pending, which the
+  // compiled code already looked for a handler of.
+  bool DoOnStackReplacement(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                            JValue* result) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  JitCodeCache* GetCodeCache() const {
+    return code_cache_.get();
+  }
+
+  size_t GetCompileThreshold() const {
+    return compile_threshold_;
+  }
+
+  // Prints the number of compiled methods and the use and collections of the code cache.
+  void DumpInfo(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+  // Returns the number of methods compiled and of compilations which failed since startup.
+  void GetCompileCounts(size_t* compiled_methods, size_t* failed_methods) LOCKS_EXCLUDED(lock_);
+
+ private:
+  // A slot of the table counting the samples. The table is direct mapped and the slots are
+  // updated without synchronization: a method evicted by another starts over, and racing updates
+  // may lose samples, neither of which matters for a heuristic.
+  struct HotnessEntry {
+    mirror::ArtMethod* method;
+    uint16_t samples;
+  };
+
+  static constexpr size_t kHotnessTableSize = 4096;
+
+  Jit(size_t compile_threshold, JitCodeCache* code_cache);
+
+  static size_t HotnessIndex(mirror::ArtMethod* method) {
+    // ArtMethods are at least 8 byte aligned.
+    return (reinterpret_cast<uintptr_t>(method) >> 3) & (kHotnessTableSize - 1);
+  }
+
+  // Returns false if method can't be compiled now.
+  bool EnqueueCompilation(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Whether it is worth and safe to install compiled code for method now.
+  static bool CanCompile(mirror::ArtMethod* method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  bool LoadCompiler(std::string* error_msg);
+
+  // Suspends all threads and evicts the methods the code cache needs to free to fit size bytes,
+  // reverting their code to the interpreter bridge.
+  void CollectCodeCache(Thread* self, size_t size)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  const size_t compile_threshold_;
+  const UniquePtr<JitCodeCache> code_cache_;
+
+  // The compiler entry points of libart-compiler.so.
+  void* jit_library_handle_;
+  void* jit_compiler_handle_;
+  void* (*jit_load_)();
+  void (*jit_unload_)(void* handle);
+  bool (*jit_compile_method_)(void* handle, mirror::ArtMethod* method, Thread* self);
+
+  HotnessEntry hotness_table_[kHotnessTableSize];
+
+  // Guards the thread pool, which daemon threads may still queue to during shutdown, and the set
+  // of the methods ever queued, so that an evicted method isn't queued twice.
+  Mutex lock_;
+  UniquePtr<ThreadPool> thread_pool_ GUARDED_BY(lock_);
+  std::set<mirror::ArtMethod*> queued_methods_ GUARDED_BY(lock_);
+  size_t compiled_methods_ GUARDED_BY(lock_);
+  size_t failed_methods_ GUARDED_BY(lock_);
+  // Counted without synchronization, only dumped.
+  size_t osr_transitions_;
+
+  DISALLOW_COPY_AND_ASSIGN(Jit);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_H_
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+JitCodeCache* JitCodeCache::Create(size_t capacity, std::string* error_msg) {
+  CHECK_GT(capacity, 0U);
+  // The pages stay writable: the compiler thread writes new methods while other threads run the
+  // ones already installed, so the protection of the pages can't be flipped.
+  MemMap* mem_map = MemMap::MapAnonymous("jit code cache", nullptr, RoundUp(capacity, kPageSize),
+                                         PROT_READ | PROT_WRITE | PROT_EXEC, false, error_msg);
+  if (mem_map == nullptr) {
+    return nullptr;
+  }
+  return new JitCodeCache(mem_map);
+}
+
+JitCodeCache::JitCodeCache(MemMap* mem_map)
+    : lock_("jit code cache lock"), mem_map_(mem_map), top_(mem_map->Begin()), used_bytes_(0),
+      next_sequence_(0), num_collections_(0), num_evicted_methods_(0) {
+}
+
+uint8_t* JitCodeCache::ReserveMethod(Thread* self, mirror::ArtMethod* method, size_t size) {
+  MutexLock mu(self, lock_);
+  size = RoundUp(size, kAlignment);
+  uint8_t* result = nullptr;
+  // First fit, the free chunks are few since a collection merges the chunks it frees.
+  for (auto it = free_chunks_.begin(); it != free_chunks_.end(); ++it) {
+    if (it->second >= size) {
+      result = it->first;
+      size_t remaining = it->second - size;
+      free_chunks_.erase(it);
+      if (remaining != 0) {
+        free_chunks_.Put(result + size, remaining);
+      }
+      break;
+    }
+  }
+  if (result == nullptr) {
+    if (size > static_cast<size_t>(mem_map_->End() - top_)) {
+      return nullptr;
+    }
+    result = top_;
+    top_ += size;
+  }
+  MethodChunk method_chunk = { method, size, next_sequence_++ };
+  method_chunks_.Put(result, method_chunk);
+  used_bytes_ += size;
+  return result;
+}
+
+void JitCodeCache::Collect(Thread* self, const std::set<mirror::ArtMethod*>& live_methods,
+                           size_t size, std::vector<mirror::ArtMethod*>* evicted_methods) {
+  MutexLock mu(self, lock_);
+  ++num_collections_;
+  size = RoundUp(size, kAlignment);
+  std::vector<std::pair<uint64_t, uint8_t*> > candidates;
+  for (const auto& pair : method_chunks_) {
+    if (live_methods.find(pair.second.method) == live_methods.end()) {
+      candidates.push_back(std::make_pair(pair.second.sequence, pair.first));
+    }
+  }
+  // The oldest first: the methods compiled last are the ones that got hot most recently.
+  std::sort(candidates.begin(), candidates.end());
+  const size_t min_free_bytes = Capacity() / kCollectFraction;
+  for (const auto& candidate : candidates) {
+    if (Capacity() - used_bytes_ >= min_free_bytes && LargestFreeChunkLocked() >= size) {
+      break;
+    }
+    auto it = method_chunks_.find(candidate.second);
+    DCHECK(it != method_chunks_.end());
+    evicted_methods->push_back(it->second.method);
+    auto osr_it = osr_entries_.lower_bound(std::make_pair(it->second.method, 0U));
+    while (osr_it != osr_entries_.end() && osr_it->first.first == it->second.method) {
+      osr_entries_.erase(osr_it++);
+    }
+    used_bytes_ -= it->second.size;
+    FreeChunkLocked(it->first, it->second.size);
+    method_chunks_.erase(it);
+    ++num_evicted_methods_;
+  }
+}
+
+void JitCodeCache::AddOsrEntry(Thread* self, mirror::ArtMethod* method, uint32_t dex_pc,
+                               const void* entry) {
+  MutexLock mu(self, lock_);
+  osr_entries_.Put(std::make_pair(method, dex_pc), entry);
+}
+
+const void* JitCodeCache::LookupOsrEntry(Thread* self, mirror::ArtMethod* method,
+                                         uint32_t dex_pc) {
+  MutexLock mu(self, lock_);
+  auto it = osr_entries_.find(std::make_pair(method, dex_pc));
+  return (it != osr_entries_.end()) ? it->second : nullptr;
+}
+
+void JitCodeCache::FreeChunkLocked(uint8_t* chunk, size_t size) {
+  auto next = free_chunks_.upper_bound(chunk);
+  if (next != free_chunks_.end() && chunk + size == next->first) {
+    size += next->second;
+    free_chunks_.erase(next);
+    next = free_chunks_.upper_bound(chunk);
+  }
+  if (next != free_chunks_.begin()) {
+    auto prev = next;
+    --prev;
+    if (prev->first + prev->second == chunk) {
+      prev->second += size;
+      return;
+    }
+  }
+  free_chunks_.Put(chunk, size);
+}
+
+size_t JitCodeCache::LargestFreeChunkLocked() const {
+  size_t largest = mem_map_->End() - top_;
+  for (const auto& pair : free_chunks_) {
+    largest = std::max(largest, pair.second);
+  }
+  return largest;
+}
+
+void JitCodeCache::FlushInstructionCache(uint8_t* begin, uint8_t* end) {
+  // Only uses __builtin___clear_cache if GCC >= 4.3.3
+#if GCC_VERSION >= 40303
+  __builtin___clear_cache(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end));
+#else
+  UNIMPLEMENTED(FATAL) << "cache flush";
+#endif
+}
+
+size_t JitCodeCache::Size() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return used_bytes_;
+}
+
+size_t JitCodeCache::NumberOfMethods() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return method_chunks_.size();
+}
+
+size_t JitCodeCache::NumberOfCollections() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return num_collections_;
+}
+
+size_t JitCodeCache::NumberOfEvictedMethods() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return num_evicted_methods_;
+}
+
+}  // namespace jit
+}  // namespace art
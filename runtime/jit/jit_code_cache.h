@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+#define ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "safe_map.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class Thread;
+
+namespace jit {
+
+// The executable pages holding the code compiled by the JIT. Each method is laid out as in an oat
+// file, its mapping, vmap and gc map tables followed by the OatMethodHeader and the code, so that
+// the ArtMethod accessors of the tables work unchanged. The chunks of the methods are carved out
+// of the free chunks left by collections first, then from the end of the used part. When neither
+// works, the Jit suspends all threads and has Collect free the chunks of the oldest methods that
+// have no frame on any stack.
+class JitCodeCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 2 * MB;
+
+  // The alignment of the reservations, enough for the code of all instruction sets.
+  static constexpr size_t kAlignment = 16;
+
+  // A collection frees at least 1 / kCollectFraction of the capacity, so that a full cache isn't
+  // collected again for every method.
+  static constexpr size_t kCollectFraction = 4;
+
+  // Maps the pages of the cache, returns nullptr with the reason in error_msg on failure.
+  static JitCodeCache* Create(size_t capacity, std::string* error_msg);
+
+  // Reserves size bytes for the code and tables of method. Returns nullptr when no free chunk is
+  // large enough.
+  uint8_t* ReserveMethod(Thread* self, mirror::ArtMethod* method, size_t size)
+      LOCKS_EXCLUDED(lock_);
+
+  // Frees the chunks of the oldest methods not in live_methods until a chunk of size bytes can be
+  // reserved and 1 / kCollectFraction of the capacity is free, and appends the methods to
+  // evicted_methods. The caller must keep all threads suspended until the code of the evicted
+  // methods is reverted.
+  void Collect(Thread* self, const std::set<mirror::ArtMethod*>& live_methods, size_t size,
+               std::vector<mirror::ArtMethod*>* evicted_methods) LOCKS_EXCLUDED(lock_);
+
+  // Records the on-stack replacement entry of the code of method at the loop header at dex_pc.
+  void AddOsrEntry(Thread* self, mirror::ArtMethod* method, uint32_t dex_pc, const void* entry)
+      LOCKS_EXCLUDED(lock_);
+
+  // Returns the entry into the code of method at the loop header at dex_pc, nullptr if there is
+  // none.
+  const void* LookupOsrEntry(Thread* self, mirror::ArtMethod* method, uint32_t dex_pc)
+      LOCKS_EXCLUDED(lock_);
+
+  // Makes the code written to [begin, end) visible to the instruction fetch of all threads.
+  static void FlushInstructionCache(uint8_t* begin, uint8_t* end);
+
+  // Whether ptr points into the part of the cache reserved so far, freed chunks included.
+  bool Contains(const void* ptr) const {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(ptr);
+    return mem_map_->Begin() <= p && p < top_;
+  }
+
+  size_t Capacity() const {
+    return mem_map_->Size();
+  }
+
+  // The bytes used by the methods in the cache.
+  size_t Size() const LOCKS_EXCLUDED(lock_);
+
+  size_t NumberOfMethods() const LOCKS_EXCLUDED(lock_);
+  size_t NumberOfCollections() const LOCKS_EXCLUDED(lock_);
+  size_t NumberOfEvictedMethods() const LOCKS_EXCLUDED(lock_);
+
+ private:
+  // The chunk holding the code of a method, sequence orders the chunks by age.
+  struct MethodChunk {
+    mirror::ArtMethod* method;
+    size_t size;
+    uint64_t sequence;
+  };
+
+  explicit JitCodeCache(MemMap* mem_map);
+
+  // Adds a chunk to the free chunks, merging it with its free neighbours.
+  void FreeChunkLocked(uint8_t* chunk, size_t size) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  size_t LargestFreeChunkLocked() const EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Guards the reservations.
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  const UniquePtr<MemMap> mem_map_;
+  // The end of the part reserved so far. It only grows, so readers don't need the lock.
+  uint8_t* volatile top_;
+  // The chunks of the methods and the free chunks below top_, by address.
+  SafeMap<uint8_t*, MethodChunk> method_chunks_ GUARDED_BY(lock_);
+  SafeMap<uint8_t*, size_t> free_chunks_ GUARDED_BY(lock_);
+  // The on-stack replacement entries by method and loop header dex PC.
+  SafeMap<std::pair<mirror::ArtMethod*, uint32_t>, const void*> osr_entries_ GUARDED_BY(lock_);
+  size_t used_bytes_ GUARDED_BY(lock_);
+  uint64_t next_sequence_ GUARDED_BY(lock_);
+  size_t num_collections_ GUARDED_BY(lock_);
+  size_t num_evicted_methods_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitCodeCache);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+class JitCodeCacheTest : public CommonRuntimeTest {
+ protected:
+  // The cache only uses the methods as keys, they don't need to be real.
+  static mirror::ArtMethod* FakeMethod(uintptr_t index) {
+    return reinterpret_cast<mirror::ArtMethod*>((index + 1) * kObjectAlignment);
+  }
+};
+
+TEST_F(JitCodeCacheTest, ReservesAlignedMethods) {
+  std::string error_msg;
+  UniquePtr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  EXPECT_EQ(kPageSize, code_cache->Capacity());
+  EXPECT_EQ(0U, code_cache->Size());
+  EXPECT_EQ(0U, code_cache->NumberOfMethods());
+
+  Thread* self = Thread::Current();
+  uint8_t* first = code_cache->ReserveMethod(self, FakeMethod(1), 3);
+  uint8_t* second = code_cache->ReserveMethod(self, FakeMethod(1), JitCodeCache::kAlignment + 1);
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  EXPECT_TRUE(IsAligned<JitCodeCache::kAlignment>(first));
+  EXPECT_EQ(first + JitCodeCache::kAlignment, second);
+  EXPECT_EQ(3 * JitCodeCache::kAlignment, code_cache->Size());
+  EXPECT_EQ(2U, code_cache->NumberOfMethods());
+
+  EXPECT_TRUE(code_cache->Contains(first));
+  EXPECT_TRUE(code_cache->Contains(second + JitCodeCache::kAlignment));
+  EXPECT_FALSE(code_cache->Contains(second + 2 * JitCodeCache::kAlignment));
+
+  // The pages are writable and executable.
+  first[0] = 0xc3;
+  JitCodeCache::FlushInstructionCache(first, first + 1);
+}
+
+TEST_F(JitCodeCacheTest, FailsWhenFull) {
+  std::string error_msg;
+  UniquePtr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  Thread* self = Thread::Current();
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(1), kPageSize + 1) == nullptr);
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(1), kPageSize - JitCodeCache::kAlignment) != nullptr);
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(1), JitCodeCache::kAlignment + 1) == nullptr);
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(1), JitCodeCache::kAlignment) != nullptr);
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(1), 1) == nullptr);
+  EXPECT_EQ(kPageSize, code_cache->Size());
+  EXPECT_EQ(2U, code_cache->NumberOfMethods());
+}
+
+TEST_F(JitCodeCacheTest, CollectsOldestMethods) {
+  std::string error_msg;
+  UniquePtr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  Thread* self = Thread::Current();
+  const size_t chunk_size = kPageSize / 8;
+  std::vector<uint8_t*> chunks;
+  for (size_t i = 0; i < 8; ++i) {
+    chunks.push_back(code_cache->ReserveMethod(self, FakeMethod(i), chunk_size));
+    ASSERT_TRUE(chunks.back() != nullptr);
+  }
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(8), chunk_size) == nullptr);
+
+  // The oldest method is live, the next two are evicted to free a quarter of the cache.
+  std::set<mirror::ArtMethod*> live_methods;
+  live_methods.insert(FakeMethod(0));
+  std::vector<mirror::ArtMethod*> evicted_methods;
+  code_cache->Collect(self, live_methods, chunk_size, &evicted_methods);
+  ASSERT_EQ(2U, evicted_methods.size());
+  EXPECT_EQ(FakeMethod(1), evicted_methods[0]);
+  EXPECT_EQ(FakeMethod(2), evicted_methods[1]);
+  EXPECT_EQ(6 * chunk_size, code_cache->Size());
+  EXPECT_EQ(6U, code_cache->NumberOfMethods());
+  EXPECT_EQ(1U, code_cache->NumberOfCollections());
+  EXPECT_EQ(2U, code_cache->NumberOfEvictedMethods());
+
+  // The freed chunks are merged, so a method twice as large fits where they were.
+  EXPECT_EQ(chunks[1], code_cache->ReserveMethod(self, FakeMethod(8), 2 * chunk_size));
+  EXPECT_EQ(kPageSize, code_cache->Size());
+}
+
+TEST_F(JitCodeCacheTest, CollectsUntilTheMethodFits) {
+  std::string error_msg;
+  UniquePtr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  Thread* self = Thread::Current();
+  const size_t chunk_size = kPageSize / 8;
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(code_cache->ReserveMethod(self, FakeMethod(i), chunk_size) != nullptr);
+  }
+
+  // Every other method is live, the free chunks can't be merged.
+  std::set<mirror::ArtMethod*> live_methods;
+  for (size_t i = 0; i < 8; i += 2) {
+    live_methods.insert(FakeMethod(i));
+  }
+  std::vector<mirror::ArtMethod*> evicted_methods;
+  code_cache->Collect(self, live_methods, 2 * chunk_size, &evicted_methods);
+  EXPECT_EQ(4U, evicted_methods.size());
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(8), 2 * chunk_size) == nullptr);
+  EXPECT_TRUE(code_cache->ReserveMethod(self, FakeMethod(8), chunk_size) != nullptr);
+}
+
+TEST_F(JitCodeCacheTest, DropsTheOsrEntriesOfEvictedMethods) {
+  std::string error_msg;
+  UniquePtr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  Thread* self = Thread::Current();
+  uint8_t* first = code_cache->ReserveMethod(self, FakeMethod(0), kPageSize / 2);
+  uint8_t* second = code_cache->ReserveMethod(self, FakeMethod(1), kPageSize / 2);
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  code_cache->AddOsrEntry(self, FakeMethod(0), 0, first + 8);
+  code_cache->AddOsrEntry(self, FakeMethod(0), 12, first + 16);
+  code_cache->AddOsrEntry(self, FakeMethod(1), 0, second + 8);
+  EXPECT_EQ(first + 8, code_cache->LookupOsrEntry(self, FakeMethod(0), 0));
+  EXPECT_EQ(first + 16, code_cache->LookupOsrEntry(self, FakeMethod(0), 12));
+  EXPECT_EQ(second + 8, code_cache->LookupOsrEntry(self, FakeMethod(1), 0));
+  EXPECT_TRUE(code_cache->LookupOsrEntry(self, FakeMethod(0), 4) == nullptr);
+  EXPECT_TRUE(code_cache->LookupOsrEntry(self, FakeMethod(2), 0) == nullptr);
+
+  std::set<mirror::ArtMethod*> live_methods;
+  live_methods.insert(FakeMethod(1));
+  std::vector<mirror::ArtMethod*> evicted_methods;
+  code_cache->Collect(self, live_methods, kPageSize / 2, &evicted_methods);
+  ASSERT_EQ(1U, evicted_methods.size());
+  EXPECT_TRUE(code_cache->LookupOsrEntry(self, FakeMethod(0), 0) == nullptr);
+  EXPECT_TRUE(code_cache->LookupOsrEntry(self, FakeMethod(0), 12) == nullptr);
+  EXPECT_EQ(second + 8, code_cache->LookupOsrEntry(self, FakeMethod(1), 0));
+}
+
+}  // namespace jit
+}  // namespace art
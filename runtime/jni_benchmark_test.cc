@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include "common_compiler_test.h"
+#include "jni_internal.h"
+#include "mirror/class_loader.h"
+#include "scoped_thread_state_change.h"
+#include "utils.h"
+
+namespace art {
+
+// The natives of MyClassNatives the benchmarks call, registered with RegisterNatives.
+static jint BenchmarkBar(JNIEnv*, jobject, jint count) {
+  return count + 1;
+}
+
+static jint BenchmarkSbar(JNIEnv*, jclass, jint count) {
+  return count + 1;
+}
+
+static jobject BenchmarkFooSIOO(JNIEnv*, jclass, jint x, jobject y, jobject z) {
+  return (x & 1) == 0 ? y : z;
+}
+
+static jdouble BenchmarkFooSDD(JNIEnv*, jclass, jdouble x, jdouble y) {
+  return x + y;
+}
+
+static jlong BenchmarkFooJJSynchronized(JNIEnv*, jobject, jlong x, jlong y) {
+  return x + y;
+}
+
+static jint BenchmarkCriticalAdd(jint x, jint y) {
+  return x + y;
+}
+
+// JNI transition benchmarks. The tests are disabled so that the gtest targets only build them,
+// "make test-art-host-jni-benchmark" runs them. Every benchmark prints a line of space separated
+// key=value pairs with the time of one operation, starting with "jni_benchmark".
+//
+// The gtests call the natives through the Call*Method functions, so a downcall is measured
+// together with the upcall running it. The "upcall" benchmark calls the managed constructor of
+// MyClassNatives instead, which is the upcall part alone. CheckJNI is disabled.
+class JniBenchmarkTest : public CommonCompilerTest {
+ public:
+  typedef void (JniBenchmarkTest::*Operation)(size_t iterations);
+
+  virtual void SetUp() {
+    CommonCompilerTest::SetUp();
+    {
+      ScopedObjectAccess soa(Thread::Current());
+      jobject class_loader = LoadDex("MyClassNatives");
+      CompileClass(soa.Decode<mirror::ClassLoader*>(class_loader), "MyClassNatives");
+    }
+    Thread::Current()->TransitionFromSuspendedToRunnable();
+    bool started = runtime_->Start();
+    CHECK(started);
+    runtime_->GetJavaVM()->SetCheckJniEnabled(false);
+
+    env_ = Thread::Current()->GetJniEnv();
+    klass_ = env_->FindClass("MyClassNatives");
+    CHECK(klass_ != nullptr);
+    JNINativeMethod methods[] = {
+      { "bar", "(I)I", reinterpret_cast<void*>(&BenchmarkBar) },
+      { "sbar", "(I)I", reinterpret_cast<void*>(&BenchmarkSbar) },
+      { "fooSIOO", "(ILjava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;",
+        reinterpret_cast<void*>(&BenchmarkFooSIOO) },
+      { "fooSDD", "(DD)D", reinterpret_cast<void*>(&BenchmarkFooSDD) },
+      { "fooJJ_synchronized", "(JJ)J", reinterpret_cast<void*>(&BenchmarkFooJJSynchronized) },
+      { "fastSbar", "(I)I", reinterpret_cast<void*>(&BenchmarkSbar) },
+      { "criticalAdd", "(II)I", reinterpret_cast<void*>(&BenchmarkCriticalAdd) },
+    };
+    CHECK_EQ(JNI_OK, env_->RegisterNatives(klass_, methods, arraysize(methods)));
+    constructor_ = env_->GetMethodID(klass_, "<init>", "()V");
+    CHECK(constructor_ != nullptr);
+    object_ = env_->NewObject(klass_, constructor_);
+    CHECK(object_ != nullptr);
+  }
+
+  void Run(const char* name, Operation operation) {
+    // Warm up, which also resolves the methods.
+    (this->*operation)(kWarmUpIterations);
+    uint64_t start_time = NanoTime();
+    (this->*operation)(kIterations);
+    uint64_t duration_ns = NanoTime() - start_time;
+    printf("jni_benchmark name=%s iterations=%zd ns_per_op=%.1f\n", name, kIterations,
+           static_cast<double>(duration_ns) / kIterations);
+    fflush(stdout);
+  }
+
+  void Upcall(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      env_->CallNonvirtualVoidMethod(object_, klass_, constructor_);
+    }
+  }
+
+  void StaticIntDowncall(size_t iterations) {
+    jmethodID method = env_->GetStaticMethodID(klass_, "sbar", "(I)I");
+    for (size_t i = 0; i < iterations; ++i) {
+      jint result = env_->CallStaticIntMethod(klass_, method, static_cast<jint>(i));
+      CHECK_EQ(static_cast<jint>(i + 1), result);
+    }
+  }
+
+  void InstanceIntDowncall(size_t iterations) {
+    jmethodID method = env_->GetMethodID(klass_, "bar", "(I)I");
+    for (size_t i = 0; i < iterations; ++i) {
+      jint result = env_->CallIntMethod(object_, method, static_cast<jint>(i));
+      CHECK_EQ(static_cast<jint>(i + 1), result);
+    }
+  }
+
+  void StaticReferencesDowncall(size_t iterations) {
+    jmethodID method = env_->GetStaticMethodID(klass_, "fooSIOO",
+        "(ILjava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+    for (size_t i = 0; i < iterations; ++i) {
+      jobject result =
+          env_->CallStaticObjectMethod(klass_, method, static_cast<jint>(i), klass_, object_);
+      env_->DeleteLocalRef(result);
+    }
+  }
+
+  void StaticDoublesDowncall(size_t iterations) {
+    jmethodID method = env_->GetStaticMethodID(klass_, "fooSDD", "(DD)D");
+    for (size_t i = 0; i < iterations; ++i) {
+      CHECK_EQ(3.0, env_->CallStaticDoubleMethod(klass_, method, 1.0, 2.0));
+    }
+  }
+
+  void SynchronizedDowncall(size_t iterations) {
+    jmethodID method = env_->GetMethodID(klass_, "fooJJ_synchronized", "(JJ)J");
+    for (size_t i = 0; i < iterations; ++i) {
+      jlong result = env_->CallLongMethod(object_, method, static_cast<jlong>(i), INT64_C(1));
+      CHECK_EQ(static_cast<jlong>(i + 1), result);
+    }
+  }
+
+  void FastNativeDowncall(size_t iterations) {
+    jmethodID method = env_->GetStaticMethodID(klass_, "fastSbar", "(I)I");
+    for (size_t i = 0; i < iterations; ++i) {
+      jint result = env_->CallStaticIntMethod(klass_, method, static_cast<jint>(i));
+      CHECK_EQ(static_cast<jint>(i + 1), result);
+    }
+  }
+
+  void CriticalNativeDowncall(size_t iterations) {
+    jmethodID method = env_->GetStaticMethodID(klass_, "criticalAdd", "(II)I");
+    for (size_t i = 0; i < iterations; ++i) {
+      jint result = env_->CallStaticIntMethod(klass_, method, static_cast<jint>(i), 1);
+      CHECK_EQ(static_cast<jint>(i + 1), result);
+    }
+  }
+
+  void LocalReferences(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      jobject ref = env_->NewLocalRef(object_);
+      env_->DeleteLocalRef(ref);
+    }
+  }
+
+  // A local frame with a few references, as a native method creating them in a loop would.
+  void LocalFrames(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      CHECK_EQ(JNI_OK, env_->PushLocalFrame(kFrameReferences));
+      for (size_t j = 0; j < kFrameReferences; ++j) {
+        env_->NewLocalRef(object_);
+      }
+      env_->PopLocalFrame(nullptr);
+    }
+  }
+
+  void GlobalReferences(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      jobject ref = env_->NewGlobalRef(object_);
+      env_->DeleteGlobalRef(ref);
+    }
+  }
+
+  void WeakGlobalReferences(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      jweak ref = env_->NewWeakGlobalRef(object_);
+      env_->DeleteWeakGlobalRef(ref);
+    }
+  }
+
+  void IntArrayElements(size_t iterations, jsize length) {
+    jintArray array = env_->NewIntArray(length);
+    CHECK(array != nullptr);
+    for (size_t i = 0; i < iterations; ++i) {
+      jint* elements = env_->GetIntArrayElements(array, nullptr);
+      elements[i % length] = i;
+      env_->ReleaseIntArrayElements(array, elements, 0);
+    }
+    env_->DeleteLocalRef(array);
+  }
+
+  void SmallIntArrayElements(size_t iterations) {
+    IntArrayElements(iterations, kSmallArrayLength);
+  }
+
+  void LargeIntArrayElements(size_t iterations) {
+    IntArrayElements(iterations, kLargeArrayLength);
+  }
+
+  void PrimitiveArrayCritical(size_t iterations) {
+    jintArray array = env_->NewIntArray(kLargeArrayLength);
+    CHECK(array != nullptr);
+    for (size_t i = 0; i < iterations; ++i) {
+      jint* elements = reinterpret_cast<jint*>(env_->GetPrimitiveArrayCritical(array, nullptr));
+      elements[i % kLargeArrayLength] = i;
+      env_->ReleasePrimitiveArrayCritical(array, elements, 0);
+    }
+    env_->DeleteLocalRef(array);
+  }
+
+  void IntArrayRegion(size_t iterations) {
+    jintArray array = env_->NewIntArray(kLargeArrayLength);
+    CHECK(array != nullptr);
+    jint buffer[kSmallArrayLength];
+    for (size_t i = 0; i < iterations; ++i) {
+      env_->GetIntArrayRegion(array, 0, kSmallArrayLength, buffer);
+      env_->SetIntArrayRegion(array, kSmallArrayLength, kSmallArrayLength, buffer);
+    }
+    env_->DeleteLocalRef(array);
+  }
+
+ private:
+  static constexpr size_t kWarmUpIterations = 10 * KB;
+  static constexpr size_t kIterations = 1 * MB;
+  static constexpr size_t kFrameReferences = 4;
+  static constexpr jsize kSmallArrayLength = 16;
+  static constexpr jsize kLargeArrayLength = 1 * KB;
+
+  JNIEnv* env_;
+  jclass klass_;
+  jmethodID constructor_;
+  jobject object_;
+};
+
+TEST_F(JniBenchmarkTest, DISABLED_Upcall) {
+  Run("upcall", &JniBenchmarkTest::Upcall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_StaticIntDowncall) {
+  Run("downcall_static_int", &JniBenchmarkTest::StaticIntDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_InstanceIntDowncall) {
+  Run("downcall_instance_int", &JniBenchmarkTest::InstanceIntDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_StaticReferencesDowncall) {
+  Run("downcall_static_references", &JniBenchmarkTest::StaticReferencesDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_StaticDoublesDowncall) {
+  Run("downcall_static_doubles", &JniBenchmarkTest::StaticDoublesDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_SynchronizedDowncall) {
+  Run("downcall_synchronized", &JniBenchmarkTest::SynchronizedDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_FastNativeDowncall) {
+  Run("downcall_fast_native", &JniBenchmarkTest::FastNativeDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_CriticalNativeDowncall) {
+  Run("downcall_critical_native", &JniBenchmarkTest::CriticalNativeDowncall);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_LocalReferences) {
+  Run("local_reference", &JniBenchmarkTest::LocalReferences);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_LocalFrames) {
+  Run("local_frame", &JniBenchmarkTest::LocalFrames);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_GlobalReferences) {
+  Run("global_reference", &JniBenchmarkTest::GlobalReferences);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_WeakGlobalReferences) {
+  Run("weak_global_reference", &JniBenchmarkTest::WeakGlobalReferences);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_SmallIntArrayElements) {
+  Run("int_array_elements_small", &JniBenchmarkTest::SmallIntArrayElements);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_LargeIntArrayElements) {
+  Run("int_array_elements_large", &JniBenchmarkTest::LargeIntArrayElements);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_PrimitiveArrayCritical) {
+  Run("primitive_array_critical", &JniBenchmarkTest::PrimitiveArrayCritical);
+}
+
+TEST_F(JniBenchmarkTest, DISABLED_IntArrayRegion) {
+  Run("int_array_region", &JniBenchmarkTest::IntArrayRegion);
+}
+
+}  // namespace art
@@ -18,7 +18,9 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
 #include <cstdarg>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -28,6 +30,7 @@
 #include "base/stl_util.h"
 #include "class_linker-inl.h"
 #include "dex_file-inl.h"
+#include "elf_file.h"
 #include "gc/accounting/card_table-inl.h"
 #include "interpreter/interpreter.h"
 #include "jni.h"
@@ -40,6 +43,7 @@
 #include "mirror/string-inl.h"
 #include "mirror/throwable.h"
 #include "object_utils.h"
+#include "os.h"
 #include "parsed_options.h"
 #include "reflection.h"
 #include "runtime.h"
@@ -47,6 +51,7 @@
 #include "scoped_thread_state_change.h"
 #include "ScopedLocalRef.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "utf.h"
 #include "UniquePtr.h"
 #include "well_known_classes.h"
@@ -57,7 +62,8 @@ static const size_t kMonitorsInitial = 32;  // Arbitrary.
 static const size_t kMonitorsMax = 4096;  // Arbitrary sanity check.
 
 static const size_t kLocalsInitial = 64;  // Arbitrary.
-static const size_t kLocalsMax = 512;  // Arbitrary sanity check.
+// Arbitrary sanity check, still low enough to catch leaks. The table only grows as needed.
+static const size_t kLocalsMax = 8192;
 
 static const size_t kPinTableInitial = 16;  // Arbitrary.
 static const size_t kPinTableMax = 1024;  // Arbitrary sanity check.
@@ -67,6 +73,8 @@ static size_t gGlobalsMax = 51200;  // Arbitrary sanity check. (Must fit in 16 b
 
 static const size_t kWeakGlobalsInitial = 16;  // Arbitrary.
 static const size_t kWeakGlobalsMax = 51200;  // Arbitrary sanity check. (Must fit in 16 bits.)
+static const size_t kWeakGlobalsMaxBlocks = RoundUp(kWeakGlobalsMax, kIRTBlockEntries) /
+    kIRTBlockEntries;
 
 static jweak AddWeakGlobalReference(ScopedObjectAccess& soa, mirror::Object* obj)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -340,16 +348,58 @@ static jint JII_AttachCurrentThread(JavaVM* vm, JNIEnv** p_env, void* raw_args,
   }
 }
 
+// Whether the JNI functions a library exports are indexed when it is loaded. ElfFile only reads
+// 32-bit ELF files, the libraries of a 64-bit runtime are searched with dlsym alone.
+static constexpr bool kIndexJniSymbols = sizeof(void*) == sizeof(uint32_t);
+
+// Reads the names of the JNI functions exported by the library at path. Returns false if the file
+// can't be read as an ELF file.
+static bool ReadJniSymbols(const std::string& path, std::set<std::string>* symbols) {
+  UniquePtr<File> file(OS::OpenFileForReading(path.c_str()));
+  if (file.get() == nullptr) {
+    return false;
+  }
+  std::string error_msg;
+  UniquePtr<ElfFile> elf_file(ElfFile::Open(file.get(), false, false, &error_msg));
+  if (elf_file.get() == nullptr) {
+    VLOG(jni) << "[Not indexing \"" << path << "\": " << error_msg << "]";
+    return false;
+  }
+  Elf32_Shdr* dynsym = elf_file->FindSectionByType(SHT_DYNSYM);
+  if (dynsym == nullptr) {
+    return false;
+  }
+  const Elf32_Word num_symbols = elf_file->GetSymbolNum(*dynsym);
+  for (Elf32_Word i = 0; i < num_symbols; ++i) {
+    Elf32_Sym& symbol = elf_file->GetSymbol(SHT_DYNSYM, i);
+    if (symbol.st_shndx == SHN_UNDEF || ELF32_ST_BIND(symbol.st_info) == STB_LOCAL) {
+      continue;
+    }
+    const char* name = elf_file->GetString(SHT_DYNSYM, symbol.st_name);
+    if (name != nullptr && strncmp(name, "Java_", 5) == 0) {
+      symbols->insert(name);
+    }
+  }
+  return true;
+}
+
 class SharedLibrary {
  public:
-  SharedLibrary(const std::string& path, void* handle, mirror::Object* class_loader)
+  // A library with jni_symbols has the index of its JNI functions, one without is searched with
+  // dlsym alone.
+  SharedLibrary(const std::string& path, void* handle, mirror::Object* class_loader,
+                std::set<std::string>* jni_symbols)
       : path_(path),
         handle_(handle),
         class_loader_(class_loader),
+        has_jni_symbols_(jni_symbols != nullptr),
         jni_on_load_lock_("JNI_OnLoad lock"),
         jni_on_load_cond_("JNI_OnLoad condition variable", jni_on_load_lock_),
         jni_on_load_thread_id_(Thread::Current()->GetThreadId()),
         jni_on_load_result_(kPending) {
+    if (jni_symbols != nullptr) {
+      jni_symbols_.swap(*jni_symbols);
+    }
   }
 
   mirror::Object* GetClassLoader() {
@@ -408,6 +458,18 @@ class SharedLibrary {
     return dlsym(handle_, symbol_name.c_str());
   }
 
+  bool HasJniSymbolIndex() const {
+    return has_jni_symbols_;
+  }
+
+  // Looks a JNI function up, without calling dlsym if the index says the library doesn't have it.
+  void* FindJniSymbol(const std::string& symbol_name) {
+    if (has_jni_symbols_ && jni_symbols_.find(symbol_name) == jni_symbols_.end()) {
+      return nullptr;
+    }
+    return FindSymbol(symbol_name);
+  }
+
   void VisitRoots(RootCallback* visitor, void* arg) {
     if (class_loader_ != nullptr) {
       visitor(&class_loader_, arg, 0, kRootVMInternal);
@@ -430,6 +492,10 @@ class SharedLibrary {
   // The ClassLoader this library is associated with.
   mirror::Object* class_loader_;
 
+  // The names of the JNI functions the library exports, if it could be read when loaded.
+  const bool has_jni_symbols_;
+  std::set<std::string> jni_symbols_;
+
   // Guards remaining items.
   Mutex jni_on_load_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   // Wait for JNI_OnLoad in other thread.
@@ -479,6 +545,50 @@ class Libraries {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     std::string jni_short_name(JniShortName(m));
     std::string jni_long_name(JniLongName(m));
+    void* fn = FindNativeMethod(m, jni_short_name, jni_long_name, false);
+    if (fn != nullptr) {
+      return fn;
+    }
+    detail += "No implementation found for ";
+    detail += PrettyMethod(m);
+    detail += " (tried " + jni_short_name + " and " + jni_long_name + ")";
+    LOG(ERROR) << detail;
+    return nullptr;
+  }
+
+  // Binds the other unregistered native methods of the class of m, so that their first calls
+  // don't come here. Only the indexed libraries are searched, a method whose search reaches a
+  // library without an index is left to be found when it is first called.
+  void RegisterClassNativeMethods(Thread* self, mirror::ArtMethod* m)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Class* klass = m->GetDeclaringClass();
+    const size_t num_direct_methods = klass->NumDirectMethods();
+    const size_t num_methods = num_direct_methods + klass->NumVirtualMethods();
+    for (size_t i = 0; i < num_methods; ++i) {
+      mirror::ArtMethod* method = i < num_direct_methods
+          ? klass->GetDirectMethod(i) : klass->GetVirtualMethod(i - num_direct_methods);
+      if (method == m || !method->IsNative() || method->IsRegistered()) {
+        continue;
+      }
+      void* fn = FindNativeMethod(method, JniShortName(method), JniLongName(method), true);
+      if (fn != nullptr) {
+        method->RegisterNative(self, fn, false);
+      }
+    }
+  }
+
+  void VisitRoots(RootCallback* callback, void* arg) {
+    for (auto& lib_pair : libraries_) {
+      lib_pair.second->VisitRoots(callback, arg);
+    }
+  }
+
+ private:
+  // Searches the libraries of the class loader of m in order, the short name then the long name.
+  // With indexed_only, gives up at the first library without an index.
+  void* FindNativeMethod(mirror::ArtMethod* m, const std::string& jni_short_name,
+                         const std::string& jni_long_name, bool indexed_only)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     const mirror::ClassLoader* declaring_class_loader = m->GetDeclaringClass()->GetClassLoader();
     for (const auto& lib : libraries_) {
       SharedLibrary* library = lib.second;
@@ -486,10 +596,13 @@ class Libraries {
         // We only search libraries loaded by the appropriate ClassLoader.
         continue;
       }
+      if (indexed_only && !library->HasJniSymbolIndex()) {
+        return nullptr;
+      }
       // Try the short name then the long name...
-      void* fn = library->FindSymbol(jni_short_name);
+      void* fn = library->FindJniSymbol(jni_short_name);
       if (fn == nullptr) {
-        fn = library->FindSymbol(jni_long_name);
+        fn = library->FindJniSymbol(jni_long_name);
       }
       if (fn != nullptr) {
         VLOG(jni) << "[Found native code for " << PrettyMethod(m)
@@ -497,20 +610,9 @@ class Libraries {
         return fn;
       }
     }
-    detail += "No implementation found for ";
-    detail += PrettyMethod(m);
-    detail += " (tried " + jni_short_name + " and " + jni_long_name + ")";
-    LOG(ERROR) << detail;
     return nullptr;
   }
 
-  void VisitRoots(RootCallback* callback, void* arg) {
-    for (auto& lib_pair : libraries_) {
-      lib_pair.second->VisitRoots(callback, arg);
-    }
-  }
-
- private:
   SafeMap<std::string, SharedLibrary*> libraries_;
 };
 
@@ -1882,8 +1984,7 @@ class JNI {
       ThrowSIOOBE(soa, start, length, s->GetLength());
     } else {
       CHECK_NON_NULL_MEMCPY_ARGUMENT(length, buf);
-      const jchar* chars = s->GetCharArray()->GetData() + s->GetOffset();
-      memcpy(buf, chars + start, length * sizeof(jchar));
+      s->GetChars(start, length, buf);
     }
   }
 
@@ -1896,8 +1997,11 @@ class JNI {
       ThrowSIOOBE(soa, start, length, s->GetLength());
     } else {
       CHECK_NON_NULL_MEMCPY_ARGUMENT(length, buf);
-      const jchar* chars = s->GetCharArray()->GetData() + s->GetOffset();
-      ConvertUtf16ToModifiedUtf8(buf, chars + start, length);
+      if (s->IsCompressed()) {
+        ConvertLatin1ToModifiedUtf8(buf, s->GetValueCompressed() + start, length);
+      } else {
+        ConvertUtf16ToModifiedUtf8(buf, s->GetValue() + start, length);
+      }
     }
   }
 
@@ -1905,17 +2009,13 @@ class JNI {
     CHECK_NON_NULL_ARGUMENT(java_string);
     ScopedObjectAccess soa(env);
     mirror::String* s = soa.Decode<mirror::String*>(java_string);
-    mirror::CharArray* chars = s->GetCharArray();
-    PinPrimitiveArray(soa, chars);
+    PinPrimitiveArray(soa, s->GetArray());
     if (is_copy != nullptr) {
       *is_copy = JNI_TRUE;
     }
     int32_t char_count = s->GetLength();
-    int32_t offset = s->GetOffset();
     jchar* bytes = new jchar[char_count + 1];
-    for (int32_t i = 0; i < char_count; i++) {
-      bytes[i] = chars->Get(i + offset);
-    }
+    s->GetChars(0, char_count, bytes);
     bytes[char_count] = '\0';
     return bytes;
   }
@@ -1924,15 +2024,46 @@ class JNI {
     CHECK_NON_NULL_ARGUMENT(java_string);
     delete[] chars;
     ScopedObjectAccess soa(env);
-    UnpinPrimitiveArray(soa, soa.Decode<mirror::String*>(java_string)->GetCharArray());
+    UnpinPrimitiveArray(soa, soa.Decode<mirror::String*>(java_string)->GetArray());
   }
 
   static const jchar* GetStringCritical(JNIEnv* env, jstring java_string, jboolean* is_copy) {
-    return GetStringChars(env, java_string, is_copy);
+    CHECK_NON_NULL_ARGUMENT(java_string);
+    ScopedObjectAccess soa(env);
+    mirror::String* s = soa.Decode<mirror::String*>(java_string);
+    if (s->IsCompressed()) {
+      // There are no UTF-16 characters to point at, hand out a copy instead.
+      return GetStringChars(env, java_string, is_copy);
+    }
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    if (heap->IsMovableObject(s->GetCharArray())) {
+      heap->PinObject(soa.Self(), s->GetCharArray());
+      // Re-decode in case the object moved since PinObject may wait for GC to complete.
+      s = soa.Decode<mirror::String*>(java_string);
+    }
+    mirror::CharArray* chars = s->GetCharArray();
+    PinPrimitiveArray(soa, chars);
+    if (is_copy != nullptr) {
+      *is_copy = JNI_FALSE;
+    }
+    return chars->GetData() + s->GetOffset();
   }
 
-  static void ReleaseStringCritical(JNIEnv* env, jstring java_string, const jchar* chars) {
-    return ReleaseStringChars(env, java_string, chars);
+  static void ReleaseStringCritical(JNIEnv* env, jstring java_string, const jchar* carray) {
+    CHECK_NON_NULL_ARGUMENT(java_string);
+    ScopedObjectAccess soa(env);
+    mirror::String* s = soa.Decode<mirror::String*>(java_string);
+    if (s->IsCompressed()) {
+      delete[] carray;
+      UnpinPrimitiveArray(soa, s->GetArray());
+      return;
+    }
+    mirror::CharArray* chars = s->GetCharArray();
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    if (heap->IsMovableObject(chars)) {
+      heap->UnpinObject(soa.Self(), chars);
+    }
+    UnpinPrimitiveArray(soa, chars);
   }
 
   static const char* GetStringUTFChars(JNIEnv* env, jstring java_string, jboolean* is_copy) {
@@ -1947,8 +2078,11 @@ class JNI {
     size_t byte_count = s->GetUtfLength();
     char* bytes = new char[byte_count + 1];
     CHECK(bytes != nullptr);  // bionic aborts anyway.
-    const uint16_t* chars = s->GetCharArray()->GetData() + s->GetOffset();
-    ConvertUtf16ToModifiedUtf8(bytes, chars, s->GetLength());
+    if (s->IsCompressed()) {
+      ConvertLatin1ToModifiedUtf8(bytes, s->GetValueCompressed(), s->GetLength());
+    } else {
+      ConvertUtf16ToModifiedUtf8(bytes, s->GetValue(), s->GetLength());
+    }
     bytes[byte_count] = '\0';
     return bytes;
   }
@@ -2078,8 +2212,8 @@ class JNI {
     mirror::Array* array = soa.Decode<mirror::Array*>(java_array);
     gc::Heap* heap = Runtime::Current()->GetHeap();
     if (heap->IsMovableObject(array)) {
-      heap->IncrementDisableMovingGC(soa.Self());
-      // Re-decode in case the object moved since IncrementDisableGC waits for GC to complete.
+      heap->PinObject(soa.Self(), array);
+      // Re-decode in case the object moved since PinObject may wait for GC to complete.
       array = soa.Decode<mirror::Array*>(java_array);
     }
     PinPrimitiveArray(soa, array);
@@ -2535,8 +2669,8 @@ class JNI {
       if (is_copy) {
         delete[] reinterpret_cast<uint64_t*>(elements);
       } else if (heap->IsMovableObject(array)) {
-        // Non copy to a movable object must means that we had disabled the moving GC.
-        heap->DecrementDisableMovingGC(soa.Self());
+        // Non copy to a movable object must means that we had pinned it.
+        heap->UnpinObject(soa.Self(), array);
       }
       UnpinPrimitiveArray(soa, array);
     }
@@ -2838,6 +2972,16 @@ void JNIEnvExt::DeleteLocalRef(jobject obj) SHARED_LOCKS_REQUIRED(Locks::mutator
     locals.Remove(local_ref_cookie, reinterpret_cast<IndirectRef>(obj));
   }
 }
+void JNIEnvExt::Reset(JavaVMExt* vm) {
+  this->vm = vm;
+  local_ref_cookie = IRT_FIRST_SEGMENT;
+  locals.SetSegmentState(IRT_FIRST_SEGMENT);
+  stacked_local_ref_cookies.clear();
+  critical = 0;
+  monitors.Clear();
+  SetCheckJniEnabled(vm->check_jni);
+}
+
 void JNIEnvExt::SetCheckJniEnabled(bool enabled) {
   check_jni = enabled;
   functions = enabled ? GetCheckJniNativeInterface() : &gJniNativeInterface;
@@ -2978,6 +3122,7 @@ JavaVMExt::JavaVMExt(Runtime* runtime, ParsedOptions* options)
       check_jni_abort_hook_data(nullptr),
       check_jni(false),
       force_copy(false),  // TODO: add a way to enable this
+      check_jni_sample_rate(std::max(options->check_jni_sample_rate_, 1U)),
       trace(options->jni_trace_),
       pins_lock("JNI pin table lock", kPinTableLock),
       pin_table("pin table", kPinTableInitial, kPinTableMax),
@@ -2985,10 +3130,12 @@ JavaVMExt::JavaVMExt(Runtime* runtime, ParsedOptions* options)
       globals(gGlobalsInitial, gGlobalsMax, kGlobal),
       libraries_lock("JNI shared libraries map lock", kLoadLibraryLock),
       libraries(new Libraries),
-      weak_globals_lock_("JNI weak global reference table lock"),
+      weak_globals_lock_("JNI weak global reference table lock", kJniWeakGlobalsLock),
       weak_globals_(kWeakGlobalsInitial, kWeakGlobalsMax, kWeakGlobal),
       allow_new_weak_globals_(true),
-      weak_globals_add_condition_("weak globals add condition", weak_globals_lock_) {
+      weak_globals_add_condition_("weak globals add condition", weak_globals_lock_),
+      weak_globals_sweep_epoch_(0),
+      weak_globals_swept_epochs_(new AtomicInteger[kWeakGlobalsMaxBlocks]) {
   functions = unchecked_functions = &gJniInvokeInterface;
   if (options->check_jni_) {
     SetCheckJniEnabled(true);
@@ -3029,6 +3176,9 @@ void JavaVMExt::DumpForSigQuit(std::ostream& os) {
   if (force_copy) {
     os << " (with forcecopy)";
   }
+  if (check_jni && check_jni_sample_rate > 1) {
+    os << " (sampling 1 call in " << check_jni_sample_rate << ")";
+  }
   Thread* self = Thread::Current();
   {
     MutexLock mu(self, pins_lock);
@@ -3055,16 +3205,32 @@ void JavaVMExt::DumpForSigQuit(std::ostream& os) {
 void JavaVMExt::DisallowNewWeakGlobals() {
   MutexLock mu(Thread::Current(), weak_globals_lock_);
   allow_new_weak_globals_ = false;
+  if ((weak_globals_sweep_epoch_.Load() & 1) == 0) {
+    ++weak_globals_sweep_epoch_;
+  }
 }
 
 void JavaVMExt::AllowNewWeakGlobals() {
   Thread* self = Thread::Current();
   MutexLock mu(self, weak_globals_lock_);
   allow_new_weak_globals_ = true;
+  if ((weak_globals_sweep_epoch_.Load() & 1) != 0) {
+    ++weak_globals_sweep_epoch_;
+  }
   weak_globals_add_condition_.Broadcast(self);
 }
 
 mirror::Object* JavaVMExt::DecodeWeakGlobal(Thread* self, IndirectRef ref) {
+  // The epoch only becomes odd while the mutators are suspended, so it can't change from even to
+  // odd while this thread holds the mutator lock. Entries only change under weak_globals_lock_,
+  // except when swept, and a sweep publishes its entries before the epoch or its block marks.
+  int32_t epoch = weak_globals_sweep_epoch_.Load();
+  size_t block = IndirectReferenceTable::ExtractBlockIndex(ref);
+  if (LIKELY((epoch & 1) == 0) ||
+      (block < kWeakGlobalsMaxBlocks && weak_globals_swept_epochs_[block].Load() == epoch)) {
+    QuasiAtomic::MembarLoadLoad();
+    return DecodeWeakGlobalLockFree(ref);
+  }
   MutexLock mu(self, weak_globals_lock_);
   while (UNLIKELY(!allow_new_weak_globals_)) {
     weak_globals_add_condition_.WaitHoldingLocks(self);
@@ -3072,6 +3238,10 @@ mirror::Object* JavaVMExt::DecodeWeakGlobal(Thread* self, IndirectRef ref) {
   return weak_globals_.Get(ref);
 }
 
+mirror::Object* JavaVMExt::DecodeWeakGlobalLockFree(IndirectRef ref) {
+  return weak_globals_.Get(ref);
+}
+
 void JavaVMExt::DumpReferenceTables(std::ostream& os) {
   Thread* self = Thread::Current();
   {
@@ -3140,6 +3310,10 @@ bool JavaVMExt::LoadNativeLibrary(const std::string& path,
   // want to switch from kRunnable while it executes.  This allows the GC to ignore us.
   self->TransitionFromRunnableToSuspended(kWaitingForJniOnLoad);
   void* handle = dlopen(path.empty() ? nullptr : path.c_str(), RTLD_LAZY);
+  // Index the JNI functions of the library while we are suspended, reading them is file I/O.
+  std::set<std::string> jni_symbols;
+  const bool has_jni_symbols = handle != nullptr && kIndexJniSymbols && !path.empty() &&
+      ReadJniSymbols(path, &jni_symbols);
   self->TransitionFromSuspendedToRunnable();
 
   VLOG(jni) << "[Call to dlopen(\"" << path << "\", RTLD_LAZY) returned " << handle << "]";
@@ -3157,7 +3331,8 @@ bool JavaVMExt::LoadNativeLibrary(const std::string& path,
     MutexLock mu(self, libraries_lock);
     library = libraries->Get(path);
     if (library == nullptr) {  // We won race to get libraries_lock
-      library = new SharedLibrary(path, handle, class_loader.get());
+      library = new SharedLibrary(path, handle, class_loader.get(),
+                                  has_jni_symbols ? &jni_symbols : nullptr);
       libraries->Put(path, library);
       created_library = true;
     }
@@ -3236,6 +3411,10 @@ void* JavaVMExt::FindCodeForNativeMethod(mirror::ArtMethod* m) {
   {
     MutexLock mu(self, libraries_lock);
     native_method = libraries->FindNativeMethod(m, detail);
+    if (native_method != nullptr) {
+      // The other natives of a class are usually called soon after the first one.
+      libraries->RegisterClassNativeMethods(self, m);
+    }
   }
   // Throwing can cause libraries_lock to be reacquired.
   if (native_method == nullptr) {
@@ -3245,9 +3424,67 @@ void* JavaVMExt::FindCodeForNativeMethod(mirror::ArtMethod* m) {
   return native_method;
 }
 
-void JavaVMExt::SweepJniWeakGlobals(IsMarkedCallback* callback, void* arg) {
-  MutexLock mu(Thread::Current(), weak_globals_lock_);
-  for (mirror::Object** entry : weak_globals_) {
+class SweepJniWeakGlobalsTask : public Task {
+ public:
+  SweepJniWeakGlobalsTask(JavaVMExt* vm, IsMarkedCallback* callback, void* arg, size_t begin,
+                          size_t end)
+      : vm_(vm), callback_(callback), arg_(arg), begin_(begin), end_(end) {}
+
+  virtual void Run(Thread* self) OVERRIDE {
+    vm_->SweepJniWeakGlobalsRange(callback_, arg_, begin_, end_);
+  }
+
+  virtual void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  JavaVMExt* const vm_;
+  IsMarkedCallback* const callback_;
+  void* const arg_;
+  const size_t begin_;
+  const size_t end_;
+};
+
+void JavaVMExt::SweepJniWeakGlobals(IsMarkedCallback* callback, void* arg,
+                                    ThreadPool* thread_pool) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, weak_globals_lock_);
+  const size_t capacity = weak_globals_.Capacity();
+  if (thread_pool == nullptr || capacity < 2 * kSweepJniWeakGlobalsChunkSize) {
+    SweepJniWeakGlobalsRange(callback, arg, 0, capacity);
+  } else {
+    // The workers sweep the chunks while this thread holds weak_globals_lock_ for them, which
+    // keeps the mutators from adding or deleting weak globals meanwhile.
+    for (size_t begin = 0; begin < capacity; begin += kSweepJniWeakGlobalsChunkSize) {
+      const size_t end = std::min(begin + kSweepJniWeakGlobalsChunkSize, capacity);
+      thread_pool->AddTask(self, new SweepJniWeakGlobalsTask(this, callback, arg, begin, end));
+    }
+    // Not doing work, the other tasks of thread_pool may acquire locks which cannot be acquired
+    // after weak_globals_lock_.
+    thread_pool->Wait(self, false, true);
+  }
+}
+
+void JavaVMExt::SweepJniWeakGlobalsRange(IsMarkedCallback* callback, void* arg, size_t begin,
+                                         size_t end) {
+  // The chunks start at multiples of the block size, mark the blocks of the range as swept once
+  // they are, so that DecodeWeakGlobal can read their entries before the whole table is swept.
+  DCHECK_EQ(begin % kIRTBlockEntries, 0u);
+  const int32_t epoch = weak_globals_sweep_epoch_.Load();
+  for (size_t block_begin = begin; block_begin < end; block_begin += kIRTBlockEntries) {
+    const size_t block_end = std::min(block_begin + kIRTBlockEntries, end);
+    SweepJniWeakGlobalsBlock(callback, arg, block_begin, block_end);
+    QuasiAtomic::MembarStoreStore();
+    weak_globals_swept_epochs_[block_begin / kIRTBlockEntries] = epoch;
+  }
+}
+
+void JavaVMExt::SweepJniWeakGlobalsBlock(IsMarkedCallback* callback, void* arg, size_t begin,
+                                         size_t end) {
+  for (auto it = weak_globals_.IteratorAt(begin), end_it = weak_globals_.IteratorAt(end);
+       it != end_it; ++it) {
+    mirror::Object** entry = *it;
     mirror::Object* obj = *entry;
     mirror::Object* new_obj = callback(obj, arg);
     if (new_obj == nullptr) {
@@ -19,6 +19,7 @@
 
 #include "jni.h"
 
+#include "atomic.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "indirect_reference_table.h"
@@ -48,6 +49,7 @@ class ParsedOptions;
 class ScopedObjectAccess;
 template<class T> class SirtRef;
 class Thread;
+class ThreadPool;
 
 void JniAbortF(const char* jni_function_name, const char* fmt, ...)
     __attribute__((__format__(__printf__, 2, 3)));
@@ -74,6 +76,8 @@ class JavaVMExt : public JavaVM {
   /**
    * Returns a pointer to the code for the native method 'm', found
    * using dlsym(3) on every native library that's been loaded so far.
+   * The other natives of its class found in indexed libraries are
+   * registered as well.
    */
   void* FindCodeForNativeMethod(mirror::ArtMethod* m)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -93,7 +97,18 @@ class JavaVMExt : public JavaVM {
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DeleteWeakGlobalRef(Thread* self, jweak obj)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void SweepJniWeakGlobals(IsMarkedCallback* callback, void* arg);
+  // Sweeps the weak globals, in chunks on thread_pool if there are many of them. The workers of
+  // thread_pool must already be started, the chunks are waited for.
+  void SweepJniWeakGlobals(IsMarkedCallback* callback, void* arg, ThreadPool* thread_pool = nullptr)
+      LOCKS_EXCLUDED(weak_globals_lock_);
+  // Sweeps the weak global entries in [begin, end), the caller holds weak_globals_lock_.
+  void SweepJniWeakGlobalsRange(IsMarkedCallback* callback, void* arg, size_t begin, size_t end)
+      NO_THREAD_SAFETY_ANALYSIS;
+  void SweepJniWeakGlobalsBlock(IsMarkedCallback* callback, void* arg, size_t begin, size_t end)
+      NO_THREAD_SAFETY_ANALYSIS;
+
+  // Number of weak global entries swept by each chunk.
+  static constexpr size_t kSweepJniWeakGlobalsChunkSize = 4 * KB;
   mirror::Object* DecodeWeakGlobal(Thread* self, IndirectRef ref)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -106,6 +121,9 @@ class JavaVMExt : public JavaVM {
   // Extra checking.
   bool check_jni;
   bool force_copy;
+  // CheckJNI checks the arguments of one call in check_jni_sample_rate of each JNI function, the
+  // thread, critical and pending exception checks are done on every call.
+  uint32_t check_jni_sample_rate;
 
   // Extra diagnostics.
   std::string trace;
@@ -131,6 +149,16 @@ class JavaVMExt : public JavaVM {
   IndirectReferenceTable weak_globals_ GUARDED_BY(weak_globals_lock_);
   bool allow_new_weak_globals_ GUARDED_BY(weak_globals_lock_);
   ConditionVariable weak_globals_add_condition_ GUARDED_BY(weak_globals_lock_);
+  // Incremented when new weak globals are disallowed and again when they are allowed, odd while
+  // the GC hasn't swept the weak globals yet. DecodeWeakGlobal reads an entry without
+  // weak_globals_lock_ when it's even, or when the block of the entry was already swept.
+  AtomicInteger weak_globals_sweep_epoch_;
+  // The value of weak_globals_sweep_epoch_ when each block of weak_globals_ was last swept.
+  UniquePtr<AtomicInteger[]> weak_globals_swept_epochs_;
+
+  // Reads an entry of weak_globals_ without weak_globals_lock_, see DecodeWeakGlobal.
+  mirror::Object* DecodeWeakGlobalLockFree(IndirectRef ref)
+      NO_THREAD_SAFETY_ANALYSIS;
 };
 
 struct JNIEnvExt : public JNIEnv {
@@ -142,6 +170,10 @@ struct JNIEnvExt : public JNIEnv {
 
   void SetCheckJniEnabled(bool enabled);
 
+  // Clears the references and frames of the env of a detached thread for the thread reusing it,
+  // see Thread::Recycle.
+  void Reset(JavaVMExt* vm);
+
   void PushFrame(int capacity);
   void PopFrame();
 
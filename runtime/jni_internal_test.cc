@@ -786,8 +786,7 @@ TEST_F(JniInternalTest, GetStringCritical_ReleaseStringCritical) {
 
   jboolean is_copy = JNI_FALSE;
   chars = env_->GetStringCritical(s, &is_copy);
-  // TODO: Fix GetStringCritical to use the same mechanism as GetPrimitiveArrayElementsCritical.
-  EXPECT_EQ(JNI_TRUE, is_copy);
+  EXPECT_EQ(JNI_FALSE, is_copy);
   EXPECT_EQ(expected[0], chars[0]);
   EXPECT_EQ(expected[1], chars[1]);
   EXPECT_EQ(expected[2], chars[2]);
@@ -956,8 +955,8 @@ TEST_F(JniInternalTest, PushLocalFrame_10395422) {
   // Negative capacities are not allowed.
   ASSERT_EQ(JNI_ERR, env_->PushLocalFrame(-1));
 
-  // And it's okay to have an upper limit. Ours is currently 512.
-  ASSERT_EQ(JNI_ERR, env_->PushLocalFrame(8192));
+  // And it's okay to have an upper limit. Ours is currently 8192.
+  ASSERT_EQ(JNI_ERR, env_->PushLocalFrame(16384));
 }
 
 TEST_F(JniInternalTest, PushLocalFrame_PopLocalFrame) {
@@ -1221,4 +1220,20 @@ TEST_F(JniInternalTest, DetachCurrentThread) {
   vm_->AttachCurrentThread(&env_, NULL);  // need attached thread for CommonRuntimeTest::TearDown
 }
 
+TEST_F(JniInternalTest, AttachReusesDetachedThread) {
+  CleanUpJniEnv();
+  Thread* detached = Thread::Current();
+  ASSERT_EQ(JNI_OK, vm_->DetachCurrentThread());
+  ASSERT_EQ(JNI_OK, vm_->AttachCurrentThread(&env_, NULL));
+
+  Thread* self = Thread::Current();
+  EXPECT_EQ(detached, self);
+  JNIEnvExt* env = reinterpret_cast<JNIEnvExt*>(env_);
+  EXPECT_EQ(self->GetJniEnv(), env);
+  EXPECT_EQ(static_cast<uint32_t>(IRT_FIRST_SEGMENT), env->local_ref_cookie);
+  EXPECT_EQ(0U, env->monitors.Size());
+  EXPECT_EQ(0, env->critical);
+  EXPECT_EQ(kNative, self->GetState());
+}
+
 }  // namespace art
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_LEB128_H_
 #define ART_RUNTIME_LEB128_H_
 
+#include <string.h>
+
 #include "globals.h"
 #include "utils.h"
 
@@ -50,6 +52,33 @@ static inline uint32_t DecodeUnsignedLeb128(const uint8_t** data) {
   return static_cast<uint32_t>(result);
 }
 
+// Reads count unsigned LEB128 values into values, updating the given pointer to point just past
+// the end of the last one. Every value takes at least a byte, so while four values are left the
+// next four bytes are read at once and, when none has the continuation bit, taken as four single
+// byte values. That is the common case of the sizes and deltas of class data and of GC maps.
+static inline void DecodeUnsignedLeb128Array(const uint8_t** data, uint32_t* values,
+                                             size_t count) {
+  const uint8_t* ptr = *data;
+  size_t i = 0;
+  while (i < count) {
+    if (count - i >= 4) {
+      uint32_t word;
+      memcpy(&word, ptr, sizeof(word));
+      if ((word & 0x80808080u) == 0) {
+        values[i] = ptr[0];
+        values[i + 1] = ptr[1];
+        values[i + 2] = ptr[2];
+        values[i + 3] = ptr[3];
+        ptr += 4;
+        i += 4;
+        continue;
+      }
+    }
+    values[i++] = DecodeUnsignedLeb128(&ptr);
+  }
+  *data = ptr;
+}
+
 // Reads an unsigned LEB128 + 1 value. updating the given pointer to point
 // just past the end of the read value. This function tolerates
 // non-zero high-order bits in the fifth encoded byte.
@@ -171,6 +171,34 @@ TEST(Leb128Test, UnsignedStream) {
   EXPECT_EQ(data_size, static_cast<size_t>(encoded_data_ptr - encoded_data));
 }
 
+TEST(Leb128Test, UnsignedArray) {
+  // Encode the entries followed by runs of single byte values.
+  uint8_t encoded_data[5 * arraysize(uleb128_tests) + 16];
+  uint32_t expected[arraysize(uleb128_tests) + 16];
+  uint8_t* end = encoded_data;
+  size_t count = 0;
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    end = EncodeUnsignedLeb128(end, uleb128_tests[i].decoded);
+    expected[count++] = uleb128_tests[i].decoded;
+  }
+  for (size_t i = 0; i < 16; ++i) {
+    end = EncodeUnsignedLeb128(end, i * 7);
+    expected[count++] = i * 7;
+  }
+  // Decode all prefixes so that the tail is decoded one value at a time as well.
+  for (size_t n = 0; n <= count; ++n) {
+    uint32_t decoded[arraysize(expected)];
+    const uint8_t* encoded_data_ptr = encoded_data;
+    DecodeUnsignedLeb128Array(&encoded_data_ptr, decoded, n);
+    const uint8_t* scalar_ptr = encoded_data;
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(expected[i], decoded[i]) << " n = " << n << " i = " << i;
+      DecodeUnsignedLeb128(&scalar_ptr);
+    }
+    EXPECT_EQ(scalar_ptr, encoded_data_ptr) << " n = " << n;
+  }
+}
+
 TEST(Leb128Test, SignedSinglesVector) {
   // Test individual encodings.
   for (size_t i = 0; i < arraysize(sleb128_tests); ++i) {
@@ -287,4 +315,46 @@ TEST(Leb128Test, Speed) {
   dec_hist->PrintConfidenceIntervals(std::cout, 0.99, dec_data);
 }
 
+TEST(Leb128Test, ArraySpeed) {
+  UniquePtr<Histogram<uint64_t> > dec_hist(new Histogram<uint64_t>("Leb128DecodeSpeedTest", 5));
+  UniquePtr<Histogram<uint64_t> > arr_hist(
+      new Histogram<uint64_t>("Leb128DecodeArraySpeedTest", 5));
+  // Mostly single byte values with an occasional longer one, like class data.
+  Leb128EncodingVector builder;
+  for (size_t i = 0; i < 1024 * 1024; i++) {
+    builder.PushBackUnsigned((i % 64 == 0) ? i : (i & 0x7f));
+  }
+  std::vector<uint32_t> decoded(1024);
+  const uint8_t* encoded_data_ptr = &builder.GetData()[0];
+  uint64_t last_time = NanoTime();
+  for (size_t i = 0; i < 1024; i++) {
+    for (size_t j = 0; j < 1024; j++) {
+      decoded[j] = DecodeUnsignedLeb128(&encoded_data_ptr);
+    }
+    uint64_t cur_time = NanoTime();
+    dec_hist->AddValue(cur_time - last_time);
+    last_time = cur_time;
+  }
+  const uint8_t* scalar_end = encoded_data_ptr;
+  encoded_data_ptr = &builder.GetData()[0];
+  for (size_t i = 0; i < 1024; i++) {
+    uint64_t start_time = NanoTime();
+    DecodeUnsignedLeb128Array(&encoded_data_ptr, &decoded[0], decoded.size());
+    arr_hist->AddValue(NanoTime() - start_time);
+    for (size_t j = 0; j < 1024; j++) {
+      size_t k = i * 1024 + j;
+      ASSERT_EQ((k % 64 == 0) ? k : (k & 0x7f), decoded[j]);
+    }
+  }
+  EXPECT_EQ(scalar_end, encoded_data_ptr);
+
+  Histogram<uint64_t>::CumulativeData dec_data;
+  dec_hist->CreateHistogram(&dec_data);
+  dec_hist->PrintConfidenceIntervals(std::cout, 0.99, dec_data);
+
+  Histogram<uint64_t>::CumulativeData arr_data;
+  arr_hist->CreateHistogram(&arr_data);
+  arr_hist->PrintConfidenceIntervals(std::cout, 0.99, arr_data);
+}
+
 }  // namespace art
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_profiler.h"
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "atomic.h"
+#include "base/histogram-inl.h"
+#include "base/stl_util.h"
+#include "base/stringprintf.h"
+#include "mirror/art_method-inl.h"
+#include "object_utils.h"
+#include "utils.h"
+
+namespace art {
+
+volatile bool LockProfiler::enabled_ = false;
+
+// Wait times are recorded in microseconds, the unit the histogram pretty prints.
+static constexpr uint64_t kInitialBucketWidthUs = 10;
+
+typedef Histogram<uint64_t> WaitHistogram;
+
+struct LockProfile {
+  // Mutex waits by mutex name.
+  std::map<std::string, WaitHistogram*> mutexes;
+  // Monitor waits by (owner location, waiter location).
+  std::map<std::pair<std::string, std::string>, WaitHistogram*> monitors;
+  // Exclusive holds of reader writer mutexes by mutex name.
+  std::map<std::string, WaitHistogram*> holds;
+};
+
+// A guard for gLockProfile that's not a mutex, see ScopedAllMutexesLock.
+static AtomicInteger gLockProfileGuard(0);
+// Leaked like the set of all mutexes, recording may happen during shutdown.
+static LockProfile* gLockProfile = nullptr;
+
+class ScopedLockProfileLock {
+ public:
+  ScopedLockProfileLock() {
+    while (!gLockProfileGuard.CompareAndSwap(0, 1)) {
+      NanoSleep(100);
+    }
+  }
+  ~ScopedLockProfileLock() {
+    gLockProfileGuard.CompareAndSwap(1, 0);
+  }
+};
+
+static void AddWait(WaitHistogram** histogram, const std::string& name, uint64_t wait_ns) {
+  if (*histogram == nullptr) {
+    *histogram = new WaitHistogram(name.c_str(), kInitialBucketWidthUs);
+  }
+  (*histogram)->AddValue(wait_ns / 1000);
+}
+
+static void ClearLockProfile() {
+  if (gLockProfile != nullptr) {
+    STLDeleteValues(&gLockProfile->mutexes);
+    STLDeleteValues(&gLockProfile->monitors);
+    STLDeleteValues(&gLockProfile->holds);
+  } else {
+    gLockProfile = new LockProfile;
+  }
+}
+
+void LockProfiler::Start() {
+  {
+    ScopedLockProfileLock mu;
+    ClearLockProfile();
+  }
+  enabled_ = true;
+}
+
+void LockProfiler::Stop() {
+  enabled_ = false;
+}
+
+void LockProfiler::RecordMutexContention(const BaseMutex* mutex, uint64_t wait_ns) {
+  if (!enabled_) {
+    return;
+  }
+  const std::string name(mutex->GetName());
+  ScopedLockProfileLock mu;
+  AddWait(&gLockProfile->mutexes[name], name, wait_ns);
+}
+
+void LockProfiler::RecordMutexHold(const BaseMutex* mutex, uint64_t hold_ns) {
+  if (!enabled_) {
+    return;
+  }
+  const std::string name(mutex->GetName());
+  ScopedLockProfileLock mu;
+  AddWait(&gLockProfile->holds[name], name, hold_ns);
+}
+
+static std::string PrettyLocation(mirror::ArtMethod* method, uint32_t dex_pc)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (method == nullptr) {
+    return "<unknown>";
+  }
+  MethodHelper mh(method);
+  const char* source_file = mh.GetDeclaringClassSourceFile();
+  return StringPrintf("%s (%s:%d, dex pc 0x%x)", PrettyMethod(method).c_str(),
+                      source_file != nullptr ? source_file : "", mh.GetLineNumFromDexPC(dex_pc),
+                      dex_pc);
+}
+
+void LockProfiler::RecordMonitorContention(mirror::ArtMethod* owner_method, uint32_t owner_dex_pc,
+                                           mirror::ArtMethod* waiter_method,
+                                           uint32_t waiter_dex_pc, uint64_t wait_ns) {
+  if (!enabled_) {
+    return;
+  }
+  // Format the locations first, the spin lock is held as briefly as possible.
+  std::pair<std::string, std::string> site(PrettyLocation(owner_method, owner_dex_pc),
+                                           PrettyLocation(waiter_method, waiter_dex_pc));
+  const std::string name = site.second + " waiting on " + site.first;
+  ScopedLockProfileLock mu;
+  AddWait(&gLockProfile->monitors[site], name, wait_ns);
+}
+
+bool LockProfiler::HasProfile() {
+  ScopedLockProfileLock mu;
+  return gLockProfile != nullptr &&
+      (!gLockProfile->mutexes.empty() || !gLockProfile->monitors.empty() ||
+       !gLockProfile->holds.empty());
+}
+
+static bool LongerTotalWait(const WaitHistogram* a, const WaitHistogram* b) {
+  return a->Sum() > b->Sum();
+}
+
+template <typename Map>
+static void DumpWaits(std::ostream& os, const Map& waits) {
+  std::vector<WaitHistogram*> histograms;
+  for (const auto& entry : waits) {
+    histograms.push_back(entry.second);
+  }
+  std::sort(histograms.begin(), histograms.end(), LongerTotalWait);
+  WaitHistogram::CumulativeData data;
+  for (WaitHistogram* histogram : histograms) {
+    histogram->CreateHistogram(&data);
+    os << "  " << histogram->SampleSize() << " waits ";
+    histogram->PrintConfidenceIntervals(os, 0.99, data);
+  }
+}
+
+void LockProfiler::Dump(std::ostream& os) {
+  // Writing to os may contend on a mutex, which would record under the spin lock we hold.
+  std::ostringstream profile;
+  {
+    ScopedLockProfileLock mu;
+    profile << "Lock contention profile (" << (enabled_ ? "enabled" : "disabled") << "):\n";
+    if (gLockProfile != nullptr) {
+      profile << "(Mutexes)\n";
+      DumpWaits(profile, gLockProfile->mutexes);
+      profile << "(Monitors)\n";
+      DumpWaits(profile, gLockProfile->monitors);
+      profile << "(Exclusive holds)\n";
+      DumpWaits(profile, gLockProfile->holds);
+    }
+  }
+  os << profile.str();
+}
+
+}  // namespace art
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_LOCK_PROFILER_H_
+#define ART_RUNTIME_LOCK_PROFILER_H_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+// Collects how long threads wait for contended runtime mutexes and Java monitors while it is
+// enabled, which can be done at any time through VMDebug. Mutex waits are aggregated by mutex
+// name and monitor waits by the locations of the owner and the waiter, each in a histogram of
+// the wait times. The exclusive hold times of the reader writer mutexes, such as the mutator
+// lock held by SuspendAll, are aggregated by mutex name too.
+//
+// Only the blocking slow paths record, so a disabled profiler costs a load of IsEnabled. The
+// profile is guarded by a spin lock rather than by a Mutex since the mutex slow paths record
+// with arbitrary locks held.
+class LockProfiler {
+ public:
+  static bool IsEnabled() {
+    return enabled_;
+  }
+
+  // Clear the profile and start recording.
+  static void Start();
+  static void Stop();
+
+  // Record a blocking wait of wait_ns for the mutex.
+  static void RecordMutexContention(const BaseMutex* mutex, uint64_t wait_ns);
+
+  // Record that the mutex was held exclusively for hold_ns, only reader writer mutexes record.
+  static void RecordMutexHold(const BaseMutex* mutex, uint64_t hold_ns);
+
+  // Record a blocking wait of wait_ns for a monitor that owner_method held at owner_dex_pc, either
+  // may be null when the owner was not sampled.
+  static void RecordMonitorContention(mirror::ArtMethod* owner_method, uint32_t owner_dex_pc,
+                                      mirror::ArtMethod* waiter_method, uint32_t waiter_dex_pc,
+                                      uint64_t wait_ns)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether there is anything to dump, the profile is kept after Stop.
+  static bool HasProfile();
+
+  // Dump the contended mutexes and monitor sites, the longest total wait first.
+  static void Dump(std::ostream& os);
+
+ private:
+  static volatile bool enabled_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(LockProfiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_LOCK_PROFILER_H_
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_profiler.h"
+
+#include <sstream>
+#include <string>
+
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class LockProfilerTest : public CommonRuntimeTest {};
+
+TEST_F(LockProfilerTest, RecordsOnlyWhileEnabled) {
+  Mutex mu("lock profiler test mutex");
+  LockProfiler::RecordMutexContention(&mu, 1000);
+  LockProfiler::Start();
+  EXPECT_TRUE(LockProfiler::IsEnabled());
+  EXPECT_FALSE(LockProfiler::HasProfile());
+  LockProfiler::RecordMutexContention(&mu, 5000);
+  LockProfiler::RecordMutexContention(&mu, 7000);
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    LockProfiler::RecordMonitorContention(nullptr, 0, nullptr, 0, 3000);
+  }
+  LockProfiler::Stop();
+  LockProfiler::RecordMutexContention(&mu, 9000);
+  EXPECT_TRUE(LockProfiler::HasProfile());
+
+  std::ostringstream os;
+  LockProfiler::Dump(os);
+  const std::string profile = os.str();
+  EXPECT_NE(std::string::npos, profile.find("2 waits lock profiler test mutex")) << profile;
+  EXPECT_NE(std::string::npos, profile.find("1 waits <unknown> waiting on <unknown>")) << profile;
+
+  // Starting again discards the previous profile.
+  LockProfiler::Start();
+  EXPECT_FALSE(LockProfiler::HasProfile());
+  LockProfiler::Stop();
+}
+
+TEST_F(LockProfilerTest, RecordsExclusiveHolds) {
+  Thread* self = Thread::Current();
+  ReaderWriterMutex mu("lock profiler test reader writer mutex", kDefaultMutexLevel, true);
+  LockProfiler::Start();
+  mu.ExclusiveLock(self);
+  mu.ExclusiveUnlock(self);
+  // Shared holds aren't recorded.
+  mu.SharedLock(self);
+  mu.SharedUnlock(self);
+  LockProfiler::Stop();
+
+  std::ostringstream os;
+  LockProfiler::Dump(os);
+  const std::string profile = os.str();
+  const size_t holds = profile.find("(Exclusive holds)");
+  ASSERT_NE(std::string::npos, holds) << profile;
+  EXPECT_NE(std::string::npos,
+            profile.find("1 waits lock profiler test reader writer mutex", holds)) << profile;
+}
+
+}  // namespace art
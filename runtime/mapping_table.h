@@ -22,183 +22,163 @@
 
 namespace art {
 
-// A utility for processing the raw uleb128 encoded mapping table created by the quick compiler.
+// A utility for processing the mapping table created by the compilers, see MappingTableBuilder.
+//
+// The table starts with the uleb128 encoded total number of entries and number of pc to dex
+// entries, followed by one byte each for the width in bits of a native pc offset and of a dex pc.
+// Then come the pc to dex entries and the dex to pc entries as a little-endian bit stream, each
+// entry being an absolute native pc offset followed by an absolute dex pc. As the entries have
+// a fixed width and each kind is sorted by native pc offset, an entry is found by a binary
+// search rather than by decoding the entries that precede it.
 class MappingTable {
  public:
-  explicit MappingTable(const uint8_t* encoded_map) : encoded_table_(encoded_map) {
+  explicit MappingTable(const uint8_t* encoded_map)
+      : entries_(encoded_map), total_size_(0u), pc_to_dex_size_(0u), native_pc_bits_(0u),
+        dex_pc_bits_(0u) {
+    if (encoded_map != nullptr) {
+      total_size_ = DecodeUnsignedLeb128(&entries_);
+      pc_to_dex_size_ = DecodeUnsignedLeb128(&entries_);
+      native_pc_bits_ = entries_[0];
+      dex_pc_bits_ = entries_[1];
+      entries_ += 2;
+      DCHECK_LE(pc_to_dex_size_, total_size_);
+      DCHECK_LE(native_pc_bits_, 32u);
+      DCHECK_LE(dex_pc_bits_, 32u);
+    }
   }
 
   uint32_t TotalSize() const PURE {
-    const uint8_t* table = encoded_table_;
-    if (table == nullptr) {
-      return 0;
-    } else {
-      return DecodeUnsignedLeb128(&table);
-    }
+    return total_size_;
   }
 
   uint32_t DexToPcSize() const PURE {
-    const uint8_t* table = encoded_table_;
-    if (table == nullptr) {
-      return 0;
-    } else {
-      uint32_t total_size = DecodeUnsignedLeb128(&table);
-      uint32_t pc_to_dex_size = DecodeUnsignedLeb128(&table);
-      return total_size - pc_to_dex_size;
-    }
+    return total_size_ - pc_to_dex_size_;
   }
 
-  const uint8_t* FirstDexToPcPtr() const {
-    const uint8_t* table = encoded_table_;
-    if (table != nullptr) {
-      uint32_t total_size = DecodeUnsignedLeb128(&table);
-      uint32_t pc_to_dex_size = DecodeUnsignedLeb128(&table);
-      // We must have dex to pc entries or else the loop will go beyond the end of the table.
-      DCHECK_GT(total_size, pc_to_dex_size);
-      for (uint32_t i = 0; i < pc_to_dex_size; ++i) {
-        DecodeUnsignedLeb128(&table);  // Move ptr past native PC delta.
-        DecodeSignedLeb128(&table);  // Move ptr past dex PC delta.
-      }
+  uint32_t PcToDexSize() const PURE {
+    return pc_to_dex_size_;
+  }
+
+  // The size in bytes of the encoded table, header included.
+  size_t EncodedSize() const {
+    if (entries_ == nullptr) {
+      return 0u;
     }
-    return table;
+    size_t header_size =
+        UnsignedLeb128Size(total_size_) + UnsignedLeb128Size(pc_to_dex_size_) + 2u;
+    return header_size + (total_size_ * (native_pc_bits_ + dex_pc_bits_) + 7u) / 8u;
+  }
+
+  // Returns true and sets dex_pc when a pc to dex entry maps native_pc_offset.
+  bool FindPcToDex(uint32_t native_pc_offset, uint32_t* dex_pc) const {
+    return FindByNativePcOffset(0u, pc_to_dex_size_, native_pc_offset, dex_pc);
   }
 
-  class DexToPcIterator {
+  // Returns true and sets dex_pc when a dex to pc entry maps native_pc_offset.
+  bool FindDexToPc(uint32_t native_pc_offset, uint32_t* dex_pc) const {
+    return FindByNativePcOffset(pc_to_dex_size_, total_size_, native_pc_offset, dex_pc);
+  }
+
+  // Iterates over the entries in the range [element, end) of the table.
+  class EntryIterator {
    public:
-    DexToPcIterator(const MappingTable* table, uint32_t element) :
-        table_(table), element_(element), end_(table_->DexToPcSize()), encoded_table_ptr_(nullptr),
-        native_pc_offset_(0), dex_pc_(0) {
-      if (element == 0) {  // An iterator wanted from the start.
-        if (end_ > 0) {
-          encoded_table_ptr_ = table_->FirstDexToPcPtr();
-          native_pc_offset_ = DecodeUnsignedLeb128(&encoded_table_ptr_);
-          // First delta is always positive.
-          dex_pc_ = static_cast<uint32_t>(DecodeSignedLeb128(&encoded_table_ptr_));
-        }
-      } else {  // An iterator wanted from the end.
-        DCHECK_EQ(table_->DexToPcSize(), element);
-      }
+    EntryIterator(const MappingTable* table, uint32_t element)
+        : table_(table), element_(element) {
     }
     uint32_t NativePcOffset() const {
-      return native_pc_offset_;
+      return table_->NativePcOffsetAt(element_);
     }
     uint32_t DexPc() const {
-      return dex_pc_;
+      return table_->DexPcAt(element_);
     }
     void operator++() {
       ++element_;
-      if (element_ != end_) {  // Avoid reading beyond the end of the table.
-        native_pc_offset_ += DecodeUnsignedLeb128(&encoded_table_ptr_);
-        // For negative delta, unsigned overflow after static_cast does exactly what we need.
-        dex_pc_ += static_cast<uint32_t>(DecodeSignedLeb128(&encoded_table_ptr_));
-      }
     }
-    bool operator==(const DexToPcIterator& rhs) const {
+    bool operator==(const EntryIterator& rhs) const {
       CHECK(table_ == rhs.table_);
       return element_ == rhs.element_;
     }
-    bool operator!=(const DexToPcIterator& rhs) const {
+    bool operator!=(const EntryIterator& rhs) const {
       CHECK(table_ == rhs.table_);
       return element_ != rhs.element_;
     }
 
    private:
     const MappingTable* const table_;  // The original table.
-    uint32_t element_;  // A value in the range 0 to end_.
-    const uint32_t end_;  // Equal to table_->DexToPcSize().
-    const uint8_t* encoded_table_ptr_;  // Either nullptr or points to encoded data after this entry.
-    uint32_t native_pc_offset_;  // The current value of native pc offset.
-    uint32_t dex_pc_;  // The current value of dex pc.
+    uint32_t element_;  // The index of the current entry in the table.
   };
 
+  typedef EntryIterator DexToPcIterator;
+  typedef EntryIterator PcToDexIterator;
+
   DexToPcIterator DexToPcBegin() const {
-    return DexToPcIterator(this, 0);
+    return DexToPcIterator(this, pc_to_dex_size_);
   }
 
   DexToPcIterator DexToPcEnd() const {
-    uint32_t size = DexToPcSize();
-    return DexToPcIterator(this, size);
+    return DexToPcIterator(this, total_size_);
   }
 
-  uint32_t PcToDexSize() const PURE {
-    const uint8_t* table = encoded_table_;
-    if (table == nullptr) {
-      return 0;
-    } else {
-      DecodeUnsignedLeb128(&table);  // Total_size, unused.
-      uint32_t pc_to_dex_size = DecodeUnsignedLeb128(&table);
-      return pc_to_dex_size;
-    }
+  PcToDexIterator PcToDexBegin() const {
+    return PcToDexIterator(this, 0u);
   }
 
-  const uint8_t* FirstPcToDexPtr() const {
-    const uint8_t* table = encoded_table_;
-    if (table != nullptr) {
-      DecodeUnsignedLeb128(&table);  // Total_size, unused.
-      DecodeUnsignedLeb128(&table);  // PC to Dex size, unused.
-    }
-    return table;
+  PcToDexIterator PcToDexEnd() const {
+    return PcToDexIterator(this, pc_to_dex_size_);
   }
 
-  class PcToDexIterator {
-   public:
-    PcToDexIterator(const MappingTable* table, uint32_t element) :
-        table_(table), element_(element), end_(table_->PcToDexSize()), encoded_table_ptr_(nullptr),
-        native_pc_offset_(0), dex_pc_(0) {
-      if (element == 0) {  // An iterator wanted from the start.
-        if (end_ > 0) {
-          encoded_table_ptr_ = table_->FirstPcToDexPtr();
-          native_pc_offset_ = DecodeUnsignedLeb128(&encoded_table_ptr_);
-          // First delta is always positive.
-          dex_pc_ = static_cast<uint32_t>(DecodeSignedLeb128(&encoded_table_ptr_));
-        }
-      } else {  // An iterator wanted from the end.
-        DCHECK_EQ(table_->PcToDexSize(), element);
-      }
-    }
-    uint32_t NativePcOffset() const {
-      return native_pc_offset_;
-    }
-    uint32_t DexPc() const {
-      return dex_pc_;
-    }
-    void operator++() {
-      ++element_;
-      if (element_ != end_) {  // Avoid reading beyond the end of the table.
-        native_pc_offset_ += DecodeUnsignedLeb128(&encoded_table_ptr_);
-        // For negative delta, unsigned overflow after static_cast does exactly what we need.
-        dex_pc_ += static_cast<uint32_t>(DecodeSignedLeb128(&encoded_table_ptr_));
-      }
-    }
-    bool operator==(const PcToDexIterator& rhs) const {
-      CHECK(table_ == rhs.table_);
-      return element_ == rhs.element_;
+  // Reads num_bits, at most 32, starting at bit_offset of the little-endian bit stream data.
+  static uint32_t ReadBits(const uint8_t* data, size_t bit_offset, size_t num_bits) {
+    if (num_bits == 0u) {
+      return 0u;
     }
-    bool operator!=(const PcToDexIterator& rhs) const {
-      CHECK(table_ == rhs.table_);
-      return element_ != rhs.element_;
+    data += bit_offset / 8u;
+    size_t shift = bit_offset % 8u;
+    uint64_t word = 0u;
+    for (size_t i = 0u, e = (shift + num_bits + 7u) / 8u; i != e; ++i) {
+      word |= static_cast<uint64_t>(data[i]) << (i * 8u);
     }
+    return static_cast<uint32_t>((word >> shift) & ((UINT64_C(1) << num_bits) - 1u));
+  }
 
-   private:
-    const MappingTable* const table_;  // The original table.
-    uint32_t element_;  // A value in the range 0 to PcToDexSize.
-    const uint32_t end_;  // Equal to table_->PcToDexSize().
-    const uint8_t* encoded_table_ptr_;  // Either null or points to encoded data after this entry.
-    uint32_t native_pc_offset_;  // The current value of native pc offset.
-    uint32_t dex_pc_;  // The current value of dex pc.
-  };
+ private:
+  size_t EntryBitOffset(uint32_t element) const {
+    DCHECK_LT(element, total_size_);
+    return static_cast<size_t>(element) * (native_pc_bits_ + dex_pc_bits_);
+  }
 
-  PcToDexIterator PcToDexBegin() const {
-    return PcToDexIterator(this, 0);
+  uint32_t NativePcOffsetAt(uint32_t element) const {
+    return ReadBits(entries_, EntryBitOffset(element), native_pc_bits_);
   }
 
-  PcToDexIterator PcToDexEnd() const {
-    uint32_t size = PcToDexSize();
-    return PcToDexIterator(this, size);
+  uint32_t DexPcAt(uint32_t element) const {
+    return ReadBits(entries_, EntryBitOffset(element) + native_pc_bits_, dex_pc_bits_);
   }
 
- private:
-  const uint8_t* const encoded_table_;
+  // Binary search of the first entry in [first, end) that maps native_pc_offset.
+  bool FindByNativePcOffset(uint32_t first, uint32_t end, uint32_t native_pc_offset,
+                            uint32_t* dex_pc) const {
+    const uint32_t last = end;
+    while (first < end) {
+      uint32_t mid = first + (end - first) / 2u;
+      if (NativePcOffsetAt(mid) < native_pc_offset) {
+        first = mid + 1u;
+      } else {
+        end = mid;
+      }
+    }
+    if (first == last || NativePcOffsetAt(first) != native_pc_offset) {
+      return false;
+    }
+    *dex_pc = DexPcAt(first);
+    return true;
+  }
+
+  const uint8_t* entries_;  // The bit stream of the entries, after the header.
+  uint32_t total_size_;
+  uint32_t pc_to_dex_size_;
+  uint32_t native_pc_bits_;
+  uint32_t dex_pc_bits_;
 };
 
 }  // namespace art
@@ -19,9 +19,13 @@
 #include <inttypes.h>
 #include <backtrace/BacktraceMap.h>
 
+#include <map>
+
 #include "UniquePtr.h"
+#include "base/mutex.h"
 #include "base/stringprintf.h"
 #include "ScopedFd.h"
+#include "thread.h"
 #include "utils.h"
 
 #define USE_ASHMEM 1
@@ -46,11 +50,144 @@ static std::ostream& operator<<(
   return os;
 }
 
+bool MemMap::use_transparent_huge_pages_ = false;
+
 #if defined(__LP64__) && !defined(__x86_64__)
 // Where to start with low memory allocation.
 static constexpr uintptr_t LOW_MEM_START = kPageSize * 2;
 
 uintptr_t MemMap::next_mem_pos_ = LOW_MEM_START;   // first page to check for low-mem extent
+
+// The low_4gb maps are carved out of a region of the low 4GB reserved by an inaccessible mapping
+// the first time one is requested, rather than found by probing the address space page by page.
+// A released map becomes inaccessible again and its range goes back to the free ranges. The
+// reservation is taken from the top of the low 4GB, away from the image and the spaces requested
+// at fixed addresses after it. The maps which don't fit in the reservation fall back to probing.
+static constexpr size_t kLow4GbReservationSize = 1 * GB;
+// The distance between the addresses tried for the reservation.
+static constexpr size_t kLow4GbReservationStep = 256 * MB;
+
+struct Low4GbReservation {
+  Low4GbReservation() : reserved(false), failed(false) {}
+
+  bool reserved;
+  // Set when no reservation could be made, which isn't retried.
+  bool failed;
+  // The free ranges, begin to size.
+  std::map<uintptr_t, size_t> free_ranges;
+  // The ranges given to maps, begin to size.
+  std::map<uintptr_t, size_t> allocations;
+};
+
+// Leaked, maps may be released during shutdown.
+static Low4GbReservation* gLow4GbReservation GUARDED_BY(Locks::mem_maps_lock_) = nullptr;
+
+static void* ReserveInaccessible(void* addr, size_t byte_count, int extra_flags) {
+  return mmap(addr, byte_count, PROT_NONE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | extra_flags, -1, 0);
+}
+
+static bool ReserveLow4Gb(Low4GbReservation* reservation)
+    EXCLUSIVE_LOCKS_REQUIRED(Locks::mem_maps_lock_) {
+  for (uintptr_t begin = 4U * GB - kLow4GbReservationSize; begin >= LOW_MEM_START;
+       begin -= kLow4GbReservationStep) {
+    void* actual = ReserveInaccessible(reinterpret_cast<void*>(begin), kLow4GbReservationSize, 0);
+    if (actual == MAP_FAILED) {
+      break;
+    }
+    if (reinterpret_cast<uintptr_t>(actual) == begin) {
+      reservation->free_ranges.insert(std::make_pair(begin, kLow4GbReservationSize));
+      return true;
+    }
+    // The hint was taken, try lower.
+    munmap(actual, kLow4GbReservationSize);
+  }
+  return false;
+}
+
+// Returns the begin of a range of byte_count bytes of the reservation, 0 if there is none.
+static uintptr_t AllocateLow4Gb(size_t byte_count) LOCKS_EXCLUDED(Locks::mem_maps_lock_) {
+  MutexLock mu(Thread::Current(), *Locks::mem_maps_lock_);
+  if (gLow4GbReservation == nullptr) {
+    gLow4GbReservation = new Low4GbReservation;
+  }
+  Low4GbReservation* reservation = gLow4GbReservation;
+  if (!reservation->reserved && !reservation->failed) {
+    reservation->reserved = ReserveLow4Gb(reservation);
+    reservation->failed = !reservation->reserved;
+  }
+  // First fit, keeping the low addresses for the later maps and the ranges unfragmented.
+  for (auto it = reservation->free_ranges.begin(); it != reservation->free_ranges.end(); ++it) {
+    if (it->second >= byte_count) {
+      const uintptr_t begin = it->first;
+      if (it->second > byte_count) {
+        reservation->free_ranges.insert(std::make_pair(begin + byte_count,
+                                                       it->second - byte_count));
+      }
+      reservation->free_ranges.erase(it);
+      reservation->allocations.insert(std::make_pair(begin, byte_count));
+      return begin;
+    }
+  }
+  return 0;
+}
+
+// Gives the range back to the reservation, coalescing it with the free ranges around it.
+static void FreeLow4GbRangeLocked(uintptr_t begin, size_t byte_count)
+    EXCLUSIVE_LOCKS_REQUIRED(Locks::mem_maps_lock_) {
+  std::map<uintptr_t, size_t>& free_ranges = gLow4GbReservation->free_ranges;
+  auto next = free_ranges.lower_bound(begin);
+  if (next != free_ranges.begin()) {
+    auto prev = next;
+    --prev;
+    if (prev->first + prev->second == begin) {
+      begin = prev->first;
+      byte_count += prev->second;
+      free_ranges.erase(prev);
+    }
+  }
+  if (next != free_ranges.end() && begin + byte_count == next->first) {
+    byte_count += next->second;
+    free_ranges.erase(next);
+  }
+  free_ranges.insert(std::make_pair(begin, byte_count));
+}
+
+// Returns true if the map at begin was carved out of the reservation, after making its range
+// inaccessible and free again.
+static bool FreeLow4Gb(void* begin, size_t byte_count) LOCKS_EXCLUDED(Locks::mem_maps_lock_) {
+  MutexLock mu(Thread::Current(), *Locks::mem_maps_lock_);
+  if (gLow4GbReservation == nullptr) {
+    return false;
+  }
+  auto it = gLow4GbReservation->allocations.find(reinterpret_cast<uintptr_t>(begin));
+  if (it == gLow4GbReservation->allocations.end()) {
+    return false;
+  }
+  DCHECK_EQ(it->second, byte_count);
+  if (ReserveInaccessible(begin, byte_count, MAP_FIXED) == MAP_FAILED) {
+    PLOG(FATAL) << "Failed to give back " << begin << " to the low 4GB reservation";
+  }
+  gLow4GbReservation->allocations.erase(it);
+  FreeLow4GbRangeLocked(reinterpret_cast<uintptr_t>(begin), byte_count);
+  return true;
+}
+
+// RemapAtEnd split a map carved out of the reservation, the tail is released on its own.
+static void SplitLow4Gb(void* begin, size_t head_byte_count)
+    LOCKS_EXCLUDED(Locks::mem_maps_lock_) {
+  MutexLock mu(Thread::Current(), *Locks::mem_maps_lock_);
+  if (gLow4GbReservation == nullptr) {
+    return;
+  }
+  auto it = gLow4GbReservation->allocations.find(reinterpret_cast<uintptr_t>(begin));
+  if (it != gLow4GbReservation->allocations.end()) {
+    const size_t tail_byte_count = it->second - head_byte_count;
+    it->second = head_byte_count;
+    gLow4GbReservation->allocations.insert(
+        std::make_pair(reinterpret_cast<uintptr_t>(begin) + head_byte_count, tail_byte_count));
+  }
+}
 #endif
 
 static bool CheckMapRequest(byte* expected_ptr, void* actual_ptr, size_t byte_count,
@@ -108,18 +245,21 @@ MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count
     return new MemMap(name, nullptr, 0, nullptr, 0, prot);
   }
   size_t page_aligned_byte_count = RoundUp(byte_count, kPageSize);
+  // Transparent huge pages only back anonymous mappings, not ashmem ones.
+  const bool huge_pages = use_transparent_huge_pages_ && page_aligned_byte_count >= kHugePageSize;
 
 #ifdef USE_ASHMEM
   // android_os_Debug.cpp read_mapinfo assumes all ashmem regions associated with the VM are
   // prefixed "dalvik-".
   std::string debug_friendly_name("dalvik-");
   debug_friendly_name += name;
-  ScopedFd fd(ashmem_create_region(debug_friendly_name.c_str(), page_aligned_byte_count));
-  if (fd.get() == -1) {
+  ScopedFd fd(huge_pages ? -1 : ashmem_create_region(debug_friendly_name.c_str(),
+                                                      page_aligned_byte_count));
+  if (!huge_pages && fd.get() == -1) {
     *error_msg = StringPrintf("ashmem_create_region failed for '%s': %s", name, strerror(errno));
     return nullptr;
   }
-  int flags = MAP_PRIVATE;
+  int flags = huge_pages ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_PRIVATE;
 #else
   ScopedFd fd(-1);
   int flags = MAP_PRIVATE | MAP_ANONYMOUS;
@@ -128,14 +268,23 @@ MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count
   // We need to store and potentially set an error number for pretty printing of errors
   int saved_errno = 0;
 
-  // TODO:
-  // A page allocator would be a useful abstraction here, as
-  // 1) It is doubtful that MAP_32BIT on x86_64 is doing the right job for us
-  // 2) The linear scheme, even with simple saving of the last known position, is very crude
+  // TODO: It is doubtful that MAP_32BIT on x86_64 is doing the right job for us, the low 4GB
+  // reservation could be used there too.
 #if defined(__LP64__) && !defined(__x86_64__)
   // MAP_32BIT only available on x86_64.
   void* actual = MAP_FAILED;
+  uintptr_t reserved = 0;
   if (low_4gb && expected == nullptr) {
+    reserved = AllocateLow4Gb(page_aligned_byte_count);
+  }
+  if (reserved != 0) {
+    actual = mmap(reinterpret_cast<void*>(reserved), page_aligned_byte_count, prot,
+                  flags | MAP_FIXED, fd.get(), 0);
+    if (actual == MAP_FAILED) {
+      saved_errno = errno;
+      FreeLow4Gb(reinterpret_cast<void*>(reserved), page_aligned_byte_count);
+    }
+  } else if (low_4gb && expected == nullptr) {
     flags |= MAP_FIXED;
 
     bool first_run = true;
@@ -197,8 +346,26 @@ MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count
   }
 #endif
 
-  void* actual = mmap(expected, page_aligned_byte_count, prot, flags, fd.get(), 0);
+  size_t map_byte_count = page_aligned_byte_count;
+  if (huge_pages && expected == nullptr) {
+    // Map more so that the range can be aligned to a huge page, the excess is unmapped below.
+    map_byte_count += kHugePageSize - kPageSize;
+  }
+  void* actual = mmap(expected, map_byte_count, prot, flags, fd.get(), 0);
   saved_errno = errno;
+  if (actual != MAP_FAILED && map_byte_count != page_aligned_byte_count) {
+    byte* map_begin = reinterpret_cast<byte*>(actual);
+    byte* map_end = map_begin + map_byte_count;
+    byte* aligned_begin = AlignUp(map_begin, kHugePageSize);
+    byte* aligned_end = aligned_begin + page_aligned_byte_count;
+    if (aligned_begin != map_begin) {
+      CHECK_EQ(munmap(map_begin, aligned_begin - map_begin), 0);
+    }
+    if (aligned_end != map_end) {
+      CHECK_EQ(munmap(aligned_end, map_end - aligned_end), 0);
+    }
+    actual = aligned_begin;
+  }
 #endif
 
   if (actual == MAP_FAILED) {
@@ -215,10 +382,38 @@ MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count
     *error_msg = check_map_request_error_msg.str();
     return nullptr;
   }
+#ifdef MADV_HUGEPAGE
+  if (huge_pages && madvise(actual, page_aligned_byte_count, MADV_HUGEPAGE) != 0) {
+    PLOG(WARNING) << "madvise(MADV_HUGEPAGE) failed for " << name;
+  }
+#endif
   return new MemMap(name, reinterpret_cast<byte*>(actual), byte_count, actual,
                     page_aligned_byte_count, prot);
 }
 
+MemMap* MemMap::MapAnonymousLazy(const char* name, size_t byte_count, std::string* error_msg) {
+  if (byte_count == 0) {
+    return new MemMap(name, nullptr, 0, nullptr, 0, PROT_READ | PROT_WRITE);
+  }
+  size_t page_aligned_byte_count = RoundUp(byte_count, kPageSize);
+  // Not an ashmem region: the pages of an ashmem region are committed by the first read as well.
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+  void* actual = mmap(nullptr, page_aligned_byte_count, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (actual == MAP_FAILED) {
+    *error_msg = StringPrintf("Failed lazy anonymous mmap(%zd) for '%s': %s",
+                              page_aligned_byte_count, name, strerror(errno));
+    return nullptr;
+  }
+#ifdef MADV_NOHUGEPAGE
+  // A single card mark would otherwise commit a whole huge page.
+  if (madvise(actual, page_aligned_byte_count, MADV_NOHUGEPAGE) != 0) {
+    PLOG(WARNING) << "madvise(MADV_NOHUGEPAGE) failed for " << name;
+  }
+#endif
+  return new MemMap(name, reinterpret_cast<byte*>(actual), byte_count, actual,
+                    page_aligned_byte_count, PROT_READ | PROT_WRITE);
+}
+
 MemMap* MemMap::MapFileAtAddress(byte* expected, size_t byte_count, int prot, int flags, int fd,
                                  off_t start, bool reuse, const char* filename,
                                  std::string* error_msg) {
@@ -277,6 +472,11 @@ MemMap::~MemMap() {
   if (base_begin_ == nullptr && base_size_ == 0) {
     return;
   }
+#if defined(__LP64__) && !defined(__x86_64__)
+  if (FreeLow4Gb(base_begin_, base_size_)) {
+    return;
+  }
+#endif
   int result = munmap(base_begin_, base_size_);
   if (result == -1) {
     PLOG(FATAL) << "munmap failed";
@@ -316,6 +516,9 @@ MemMap* MemMap::RemapAtEnd(byte* new_end, const char* tail_name, int tail_prot,
   }
   size_ = new_end - reinterpret_cast<byte*>(begin_);
   base_size_ = new_base_end - reinterpret_cast<byte*>(base_begin_);
+#if defined(__LP64__) && !defined(__x86_64__)
+  SplitLow4Gb(base_begin_, base_size_);
+#endif
   DCHECK_LE(begin_ + size_, reinterpret_cast<byte*>(base_begin_) + base_size_);
   size_t tail_size = old_end - new_end;
   byte* tail_base_begin = new_base_end;
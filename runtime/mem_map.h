@@ -41,6 +41,33 @@ class MemMap {
   static MemMap* MapAnonymous(const char* ashmem_name, byte* addr, size_t byte_count, int prot,
                               bool low_4gb, std::string* error_msg);
 
+  // Request a private anonymous region of length 'byte_count' whose pages are only committed when
+  // they are first written. No swap is reserved for the region and it is never backed by huge
+  // pages, so that the side tables sized for the whole heap reservation, such as the card table
+  // and the heap bitmaps, only cost memory for the part of the heap which is in use. Reading an
+  // untouched page maps the shared zero page.
+  //
+  // On success, returns returns a MemMap instance.  On failure, returns a NULL;
+  static MemMap* MapAnonymousLazy(const char* name, size_t byte_count, std::string* error_msg);
+
+  // Whether the anonymous regions of at least kHugePageSize are advised to use transparent huge
+  // pages. They are then aligned to kHugePageSize unless a base address is requested, and are
+  // not ashmem regions. Set by the runtime before the heap is created.
+  static void SetUseTransparentHugePages(bool use_transparent_huge_pages) {
+    use_transparent_huge_pages_ = use_transparent_huge_pages;
+  }
+  static bool UseTransparentHugePages() {
+    return use_transparent_huge_pages_;
+  }
+
+  // The alignment of the ranges which are given back to the kernel with MADV_DONTNEED, releasing
+  // part of a huge page would split it.
+  static size_t GetReleaseAlignment() {
+    return use_transparent_huge_pages_ ? kHugePageSize : kPageSize;
+  }
+
+  static constexpr size_t kHugePageSize = 2 * MB;
+
   // Map part of a file, taking care of non-page aligned offsets.  The
   // "start" offset is absolute, not relative.
   //
@@ -116,6 +143,8 @@ class MemMap {
   size_t base_size_;  // Length of mapping. May be changed by RemapAtEnd (ie Zygote).
   int prot_;  // Protection of the map.
 
+  static bool use_transparent_huge_pages_;
+
 #if defined(__LP64__) && !defined(__x86_64__)
   static uintptr_t next_mem_pos_;   // next memory location to check for low_4g extent
 #endif
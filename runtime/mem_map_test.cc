@@ -16,7 +16,12 @@
 
 #include "mem_map.h"
 
+#include <sys/mman.h>
+
+#include <vector>
+
 #include "UniquePtr.h"
+#include "utils.h"
 #include "gtest/gtest.h"
 
 namespace art {
@@ -157,10 +162,69 @@ TEST_F(MemMapTest, RemapAtEnd) {
   RemapAtEndTest(false);
 }
 
+// Huge page alignment is not done by the linear scan of 64 bit targets other than x86_64.
+#if !defined(__LP64__) || defined(__x86_64__)
+TEST_F(MemMapTest, MapAnonymousHugePageAligned) {
+  MemMap::SetUseTransparentHugePages(true);
+  std::string error_msg;
+  UniquePtr<MemMap> map(MemMap::MapAnonymous("MapAnonymousHugePageAligned",
+                                             nullptr,
+                                             3 * MemMap::kHugePageSize + kPageSize,
+                                             PROT_READ | PROT_WRITE,
+                                             false,
+                                             &error_msg));
+  MemMap::SetUseTransparentHugePages(false);
+  ASSERT_TRUE(map.get() != nullptr) << error_msg;
+  ASSERT_TRUE(error_msg.empty());
+  EXPECT_TRUE(IsAlignedParam(reinterpret_cast<uintptr_t>(BaseBegin(map.get())),
+                             MemMap::kHugePageSize));
+  // The excess of the mapping is unmapped.
+  EXPECT_EQ(3 * MemMap::kHugePageSize + kPageSize, BaseSize(map.get()));
+  memset(map->Begin(), 0xff, map->Size());
+  EXPECT_EQ(kPageSize, MemMap::GetReleaseAlignment());
+}
+#endif
+
+TEST_F(MemMapTest, MapAnonymousLazy) {
+  std::string error_msg;
+  const size_t page_count = 64;
+  UniquePtr<MemMap> map(MemMap::MapAnonymousLazy("MapAnonymousLazy", page_count * kPageSize,
+                                                 &error_msg));
+  ASSERT_TRUE(map.get() != nullptr) << error_msg;
+  ASSERT_TRUE(error_msg.empty());
+  // Only the written page is resident.
+  map->Begin()[5 * kPageSize] = 1;
+  std::vector<unsigned char> resident(page_count);
+  ASSERT_EQ(0, mincore(map->Begin(), map->Size(), &resident[0]));
+  for (size_t i = 0; i < page_count; ++i) {
+    EXPECT_EQ(i == 5, (resident[i] & 1) != 0) << i;
+  }
+}
+
 #ifdef __LP64__
 TEST_F(MemMapTest, RemapAtEnd32bit) {
   RemapAtEndTest(true);
 }
 #endif
 
+#ifdef __LP64__
+TEST_F(MemMapTest, MapAnonymous32bitReleased) {
+  std::string error_msg;
+  for (size_t i = 0; i < 3; ++i) {
+    UniquePtr<MemMap> small(MemMap::MapAnonymous("MapAnonymous32bitReleased", nullptr, kPageSize,
+                                                 PROT_READ | PROT_WRITE, true, &error_msg));
+    ASSERT_TRUE(small.get() != nullptr) << error_msg;
+    UniquePtr<MemMap> large(MemMap::MapAnonymous("MapAnonymous32bitReleased", nullptr, 16 * MB,
+                                                 PROT_READ | PROT_WRITE, true, &error_msg));
+    ASSERT_TRUE(large.get() != nullptr) << error_msg;
+    uintptr_t end = reinterpret_cast<uintptr_t>(BaseBegin(large.get())) + BaseSize(large.get());
+    ASSERT_LE(end, 1ULL << 32);
+    // The maps are usable.
+    large->Begin()[large->Size() - 1] = 1;
+    small->Begin()[0] = 1;
+    EXPECT_FALSE(small->HasAddress(large->Begin()));
+  }
+}
+#endif
+
 }  // namespace art
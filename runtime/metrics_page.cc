@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "metrics_page.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "atomic.h"
+#include "base/stringprintf.h"
+#include "class_linker.h"
+#include "gc/collector/garbage_collector.h"
+#include "gc/heap.h"
+#include "jit/jit.h"
+#include "mem_map.h"
+#include "monitor.h"
+#include "runtime.h"
+#include "thread.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+
+// How many times a reader retries a page being updated before giving up.
+static const size_t kMaxReadAttempts = 1000;
+
+MetricsPage* MetricsPage::Create(const std::string& dir, uint32_t update_interval_ms,
+                                 std::string* error_msg) {
+  std::string filename(StringPrintf("%s/art-metrics-%d", dir.c_str(), getpid()));
+  int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    *error_msg = StringPrintf("Failed to create metrics page '%s': %s", filename.c_str(),
+                              strerror(errno));
+    return nullptr;
+  }
+  size_t byte_count = RoundUp(sizeof(RuntimeMetrics), kPageSize);
+  if (ftruncate(fd, byte_count) != 0) {
+    *error_msg = StringPrintf("Failed to size metrics page '%s': %s", filename.c_str(),
+                              strerror(errno));
+    close(fd);
+    unlink(filename.c_str());
+    return nullptr;
+  }
+  MemMap* mem_map = MemMap::MapFile(byte_count, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0,
+                                    filename.c_str(), error_msg);
+  // The mapping stays valid once the file is closed.
+  close(fd);
+  if (mem_map == nullptr) {
+    unlink(filename.c_str());
+    return nullptr;
+  }
+  return new MetricsPage(filename, mem_map, update_interval_ms);
+}
+
+MetricsPage::MetricsPage(const std::string& filename, MemMap* mem_map,
+                         uint32_t update_interval_ms)
+    : filename_(filename),
+      mem_map_(mem_map),
+      metrics_(reinterpret_cast<RuntimeMetrics*>(mem_map->Begin())),
+      update_interval_ms_(update_interval_ms),
+      lock_("metrics page lock"),
+      cond_("metrics page condition variable", lock_),
+      halt_(false),
+      thread_(nullptr) {
+  // The file was truncated so the page starts zeroed, the magic is written last for the agents
+  // which map the file as soon as it appears.
+  metrics_->version = RuntimeMetrics::kVersion;
+  metrics_->size = sizeof(RuntimeMetrics);
+  metrics_->pid = getpid();
+  QuasiAtomic::MembarStoreStore();
+  metrics_->magic = RuntimeMetrics::kMagic;
+
+  // Create a raw pthread; its start routine will attach to the runtime.
+  CHECK_PTHREAD_CALL(pthread_create, (&pthread_, nullptr, &Run, this), "metrics page thread");
+  Thread* self = Thread::Current();
+  MutexLock mu(self, lock_);
+  while (thread_ == nullptr) {
+    cond_.Wait(self);
+  }
+}
+
+MetricsPage::~MetricsPage() {
+  {
+    Thread* self = Thread::Current();
+    MutexLock mu(self, lock_);
+    halt_ = true;
+    cond_.Signal(self);
+  }
+  CHECK_PTHREAD_CALL(pthread_join, (pthread_, nullptr), "metrics page shutdown");
+  unlink(filename_.c_str());
+}
+
+void* MetricsPage::Run(void* arg) {
+  MetricsPage* metrics_page = reinterpret_cast<MetricsPage*>(arg);
+  Runtime* runtime = Runtime::Current();
+  CHECK(runtime->AttachCurrentThread("Metrics Page", true, runtime->GetSystemThreadGroup(),
+                                     !runtime->IsCompiler()));
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, metrics_page->lock_);
+    metrics_page->thread_ = self;
+    metrics_page->cond_.Broadcast(self);
+  }
+  while (true) {
+    metrics_page->Update(self);
+    MutexLock mu(self, metrics_page->lock_);
+    if (!metrics_page->halt_) {
+      metrics_page->cond_.TimedWait(self, metrics_page->update_interval_ms_, 0);
+    }
+    if (metrics_page->halt_) {
+      break;
+    }
+  }
+  runtime->DetachCurrentThread();
+  return nullptr;
+}
+
+void MetricsPage::BeginWrite() {
+  metrics_->sequence = metrics_->sequence + 1;
+  QuasiAtomic::MembarStoreStore();
+}
+
+void MetricsPage::EndWrite() {
+  metrics_->update_time_ns = NanoTime();
+  QuasiAtomic::MembarStoreStore();
+  metrics_->sequence = metrics_->sequence + 1;
+}
+
+void MetricsPage::RecordGc(gc::collector::GarbageCollector* collector) {
+  uint64_t paused_ns = 0;
+  uint64_t max_paused_ns = 0;
+  for (uint64_t pause : collector->GetPauseTimes()) {
+    paused_ns += pause;
+    max_paused_ns = std::max(max_paused_ns, pause);
+  }
+  const char* name = collector->GetName();
+  MutexLock mu(Thread::Current(), lock_);
+  // Only the writers change num_collectors, so the collector can be looked up before the update.
+  RuntimeMetrics::Collector* entry = nullptr;
+  size_t num_collectors = metrics_->num_collectors;
+  for (size_t i = 0; i < num_collectors; ++i) {
+    if (strncmp(metrics_->collectors[i].name, name, RuntimeMetrics::kCollectorNameLength) == 0) {
+      entry = &metrics_->collectors[i];
+      break;
+    }
+  }
+  BeginWrite();
+  if (entry == nullptr && num_collectors < RuntimeMetrics::kMaxCollectors) {
+    entry = &metrics_->collectors[num_collectors];
+    strncpy(entry->name, name, RuntimeMetrics::kCollectorNameLength - 1);
+    metrics_->num_collectors = num_collectors + 1;
+  }
+  if (entry != nullptr) {
+    ++entry->iterations;
+    entry->total_duration_ns += collector->GetDurationNs();
+    entry->total_paused_ns += paused_ns;
+    entry->max_paused_ns = std::max(entry->max_paused_ns, max_paused_ns);
+    entry->freed_bytes += collector->GetFreedBytes() + collector->GetFreedLargeObjectBytes();
+    entry->freed_objects += collector->GetFreedObjects() + collector->GetFreedLargeObjects();
+  }
+  ++metrics_->gc_count;
+  metrics_->gc_total_paused_ns += paused_ns;
+  EndWrite();
+}
+
+void MetricsPage::Update(Thread* self) {
+  // Read everything before taking the lock, some of the counters need locks of their own.
+  Runtime* runtime = Runtime::Current();
+  gc::Heap* heap = runtime->GetHeap();
+  uint64_t bytes_allocated = heap->GetBytesAllocated();
+  uint64_t total_memory = heap->GetTotalMemory();
+  uint64_t bytes_allocated_ever = heap->GetBytesAllocatedEver();
+  uint64_t objects_allocated_ever = heap->GetObjectsAllocatedEver();
+  uint64_t bytes_freed_ever = heap->GetBytesFreedEver();
+  uint64_t objects_freed_ever = heap->GetObjectsFreedEver();
+  uint64_t loaded_classes = runtime->GetClassLinker()->NumLoadedClasses();
+  size_t jit_compiled_methods = 0;
+  size_t jit_failed_methods = 0;
+  if (runtime->GetJit() != nullptr) {
+    runtime->GetJit()->GetCompileCounts(&jit_compiled_methods, &jit_failed_methods);
+  }
+  MonitorList* monitor_list = runtime->GetMonitorList();
+  uint64_t monitor_inflations = monitor_list->GetInflationCount();
+  uint64_t monitor_contentions = monitor_list->GetContentionCount();
+  uint64_t thread_count;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    thread_count = runtime->GetThreadList()->Size();
+  }
+
+  MutexLock mu(self, lock_);
+  BeginWrite();
+  metrics_->bytes_allocated = bytes_allocated;
+  metrics_->total_memory = total_memory;
+  metrics_->bytes_allocated_ever = bytes_allocated_ever;
+  metrics_->objects_allocated_ever = objects_allocated_ever;
+  metrics_->bytes_freed_ever = bytes_freed_ever;
+  metrics_->objects_freed_ever = objects_freed_ever;
+  metrics_->loaded_classes = loaded_classes;
+  metrics_->jit_compiled_methods = jit_compiled_methods;
+  metrics_->jit_failed_methods = jit_failed_methods;
+  metrics_->monitor_inflations = monitor_inflations;
+  metrics_->monitor_contentions = monitor_contentions;
+  metrics_->thread_count = thread_count;
+  EndWrite();
+}
+
+bool MetricsPage::Read(const RuntimeMetrics* metrics, RuntimeMetrics* out) {
+  if (metrics->magic != RuntimeMetrics::kMagic) {
+    return false;
+  }
+  size_t size = std::min(static_cast<size_t>(metrics->size), sizeof(RuntimeMetrics));
+  for (size_t attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+    uint32_t sequence = metrics->sequence;
+    if ((sequence & 1) != 0) {
+      sched_yield();
+      continue;
+    }
+    QuasiAtomic::MembarLoadLoad();
+    memcpy(out, metrics, size);
+    QuasiAtomic::MembarLoadLoad();
+    if (metrics->sequence == sequence) {
+      out->sequence = sequence;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace art
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_METRICS_PAGE_H_
+#define ART_RUNTIME_METRICS_PAGE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+class MemMap;
+class Thread;
+
+namespace gc {
+namespace collector {
+  class GarbageCollector;
+}  // namespace collector
+}  // namespace gc
+
+// The layout of the metrics page, shared with the monitoring agents that map it. Fields are only
+// ever appended, with a new version, so that an agent can read the fields of the versions it
+// knows from a newer runtime.
+//
+// The runtime updates the page under a sequence lock: sequence is odd while an update is in
+// progress, a reader copies the page and retries when the sequence was odd or changed meanwhile,
+// see MetricsPage::Read. The counters are cumulative since startup, rates such as the allocation
+// rate are the difference between two samples divided by the difference of their update times.
+struct PACKED(8) RuntimeMetrics {
+  static constexpr uint32_t kMagic = 0x6d747261;  // "artm".
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kMaxCollectors = 8;
+  static constexpr size_t kCollectorNameLength = 32;
+
+  struct Collector {
+    char name[kCollectorNameLength];
+    uint64_t iterations;
+    uint64_t total_duration_ns;
+    uint64_t total_paused_ns;
+    uint64_t max_paused_ns;
+    uint64_t freed_bytes;
+    uint64_t freed_objects;
+  };
+
+  uint32_t magic;
+  uint32_t version;
+  // Size of this structure in the runtime which wrote it.
+  uint32_t size;
+  uint32_t pid;
+  volatile uint32_t sequence;
+  uint32_t num_collectors;
+  // CLOCK_MONOTONIC time of the last update.
+  uint64_t update_time_ns;
+
+  // Heap.
+  uint64_t bytes_allocated;
+  uint64_t total_memory;
+  uint64_t bytes_allocated_ever;
+  uint64_t objects_allocated_ever;
+  uint64_t bytes_freed_ever;
+  uint64_t objects_freed_ever;
+
+  // Collections, by collector in the order of their first collection.
+  uint64_t gc_count;
+  uint64_t gc_total_paused_ns;
+  Collector collectors[kMaxCollectors];
+
+  // Class loading, compilation, monitors and threads.
+  uint64_t loaded_classes;
+  uint64_t jit_compiled_methods;
+  uint64_t jit_failed_methods;
+  uint64_t monitor_inflations;
+  uint64_t monitor_contentions;
+  uint64_t thread_count;
+};
+
+// Publishes RuntimeMetrics in a file mapped shared, so that an external agent can sample the
+// runtime by mapping the file read only, without a round trip through the runtime. The collections
+// are recorded as they finish. The other sections are refreshed periodically by a daemon thread.
+class MetricsPage {
+ public:
+  // Creates the file <dir>/art-metrics-<pid> and starts the update thread. Returns nullptr if the
+  // file can't be mapped.
+  static MetricsPage* Create(const std::string& dir, uint32_t update_interval_ms,
+                             std::string* error_msg);
+  // Stops the update thread and removes the file.
+  ~MetricsPage();
+
+  // Adds the collection which just finished to the statistics of its collector.
+  void RecordGc(gc::collector::GarbageCollector* collector) LOCKS_EXCLUDED(lock_);
+
+  // Refreshes the heap, class, compilation, monitor and thread counts.
+  void Update(Thread* self) LOCKS_EXCLUDED(lock_);
+
+  const std::string& GetFilename() const {
+    return filename_;
+  }
+
+  // Copies a consistent snapshot of the page at metrics into out, as an agent does. Returns false
+  // if the page is being updated continuously or isn't a metrics page.
+  static bool Read(const RuntimeMetrics* metrics, RuntimeMetrics* out);
+
+ private:
+  MetricsPage(const std::string& filename, MemMap* mem_map, uint32_t update_interval_ms);
+
+  static void* Run(void* arg);
+
+  void BeginWrite() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void EndWrite() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const std::string filename_;
+  UniquePtr<MemMap> mem_map_;
+  RuntimeMetrics* const metrics_;
+  const uint32_t update_interval_ms_;
+
+  // Serializes the writers of the page and guards the update thread state.
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  ConditionVariable cond_ GUARDED_BY(lock_);
+  bool halt_ GUARDED_BY(lock_);
+  Thread* thread_ GUARDED_BY(lock_);
+  pthread_t pthread_;
+
+  DISALLOW_COPY_AND_ASSIGN(MetricsPage);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_METRICS_PAGE_H_
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "metrics_page.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "common_runtime_test.h"
+
+namespace art {
+
+class MetricsPageTest : public CommonRuntimeTest {};
+
+TEST_F(MetricsPageTest, MapAndRead) {
+  std::string error_msg;
+  UniquePtr<MetricsPage> metrics_page(MetricsPage::Create(dalvik_cache_, 1000, &error_msg));
+  ASSERT_TRUE(metrics_page.get() != nullptr) << error_msg;
+  metrics_page->Update(Thread::Current());
+
+  // Map the page read only from the file, as an agent does.
+  std::string filename(metrics_page->GetFilename());
+  int fd = open(filename.c_str(), O_RDONLY);
+  ASSERT_NE(-1, fd);
+  void* page = mmap(nullptr, sizeof(RuntimeMetrics), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(MAP_FAILED, page);
+
+  RuntimeMetrics metrics;
+  ASSERT_TRUE(MetricsPage::Read(reinterpret_cast<const RuntimeMetrics*>(page), &metrics));
+  EXPECT_EQ(RuntimeMetrics::kMagic, metrics.magic);
+  EXPECT_EQ(RuntimeMetrics::kVersion, metrics.version);
+  EXPECT_EQ(sizeof(RuntimeMetrics), metrics.size);
+  EXPECT_EQ(static_cast<uint32_t>(getpid()), metrics.pid);
+  EXPECT_EQ(0U, metrics.sequence % 2);
+  EXPECT_NE(0U, metrics.update_time_ns);
+  EXPECT_NE(0U, metrics.bytes_allocated);
+  EXPECT_NE(0U, metrics.loaded_classes);
+  // The main thread and the update thread.
+  EXPECT_LE(2U, metrics.thread_count);
+  munmap(page, sizeof(RuntimeMetrics));
+
+  // The file goes away with the page.
+  metrics_page.reset();
+  EXPECT_NE(0, access(filename.c_str(), F_OK));
+}
+
+}  // namespace art
@@ -214,12 +214,47 @@ inline void PrimitiveArray<T>::SetWithoutChecks(int32_t i, T value) {
   DCHECK(CheckIsValidIndex(i));
   GetData()[i] = value;
 }
+// A 64-bit unit of array data, the element type it is read as is unrelated.
+typedef uint64_t __attribute__((__may_alias__)) ArrayCopyUnit;
+
+// Whether a copy of count T sized elements should move 64-bit units. The elements must be
+// smaller than a unit, and the source and destination equally aligned so that once the
+// destination is aligned the source is too. Aligned 64-bit accesses don't tear the elements they
+// contain, and elements are never split between units.
+template<typename T>
+static inline bool UseArrayCopyUnits(T* d, const T* s, int32_t count) {
+  return sizeof(T) < sizeof(ArrayCopyUnit) &&
+      count >= static_cast<int32_t>(2 * sizeof(ArrayCopyUnit) / sizeof(T)) &&
+      ((reinterpret_cast<uintptr_t>(d) ^ reinterpret_cast<uintptr_t>(s)) &
+          (sizeof(ArrayCopyUnit) - 1)) == 0;
+}
+
 // Backward copy where elements are of aligned appropriately for T. Count is in T sized units.
 // Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
 template<typename T>
 static inline void ArrayBackwardCopy(T* d, const T* s, int32_t count) {
   d += count;
   s += count;
+  if (UseArrayCopyUnits(d, s, count)) {
+    while ((reinterpret_cast<uintptr_t>(d) & (sizeof(ArrayCopyUnit) - 1)) != 0) {
+      d--;
+      s--;
+      *d = *s;
+      count--;
+    }
+    const int32_t elements_per_unit = sizeof(ArrayCopyUnit) / sizeof(T);
+    int32_t units = count / elements_per_unit;
+    ArrayCopyUnit* ud = reinterpret_cast<ArrayCopyUnit*>(d);
+    const ArrayCopyUnit* us = reinterpret_cast<const ArrayCopyUnit*>(s);
+    for (int32_t i = 0; i < units; ++i) {
+      ud--;
+      us--;
+      *ud = *us;
+    }
+    d -= units * elements_per_unit;
+    s -= units * elements_per_unit;
+    count -= units * elements_per_unit;
+  }
   for (int32_t i = 0; i < count; ++i) {
     d--;
     s--;
@@ -231,6 +266,26 @@ static inline void ArrayBackwardCopy(T* d, const T* s, int32_t count) {
 // Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
 template<typename T>
 static inline void ArrayForwardCopy(T* d, const T* s, int32_t count) {
+  if (UseArrayCopyUnits(d, s, count)) {
+    while ((reinterpret_cast<uintptr_t>(d) & (sizeof(ArrayCopyUnit) - 1)) != 0) {
+      *d = *s;
+      d++;
+      s++;
+      count--;
+    }
+    const int32_t elements_per_unit = sizeof(ArrayCopyUnit) / sizeof(T);
+    int32_t units = count / elements_per_unit;
+    ArrayCopyUnit* ud = reinterpret_cast<ArrayCopyUnit*>(d);
+    const ArrayCopyUnit* us = reinterpret_cast<const ArrayCopyUnit*>(s);
+    for (int32_t i = 0; i < units; ++i) {
+      *ud = *us;
+      ud++;
+      us++;
+    }
+    d += units * elements_per_unit;
+    s += units * elements_per_unit;
+    count -= units * elements_per_unit;
+  }
   for (int32_t i = 0; i < count; ++i) {
     *d = *s;
     d++;
@@ -154,6 +154,11 @@ class MANAGED PrimitiveArray : public Array {
   void Memcpy(int32_t dst_pos, PrimitiveArray<T>* src, int32_t src_pos, int32_t count)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  static Class* GetArrayClass() {
+    DCHECK(array_class_ != NULL);
+    return array_class_;
+  }
+
   static void SetArrayClass(Class* array_class) {
     CHECK(array_class_ == NULL);
     CHECK(array_class != NULL);
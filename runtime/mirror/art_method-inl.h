@@ -192,7 +192,19 @@ inline bool ArtMethod::IsImtConflictMethod() {
   bool result = this == Runtime::Current()->GetImtConflictMethod();
   // Check that if we do think it is phony it looks like the imt conflict method.
   DCHECK(!result || IsRuntimeMethod());
-  return result;
+  return result || (IsRuntimeMethod() && GetImtConflictTable() != nullptr);
+}
+
+// Runtime methods have no dex cache, an imt conflict method keeps its table in the field of the
+// resolved methods so that the trampolines find it at METHOD_DEX_CACHE_METHODS_OFFSET.
+inline ObjectArray<ArtMethod>* ArtMethod::GetImtConflictTable() {
+  DCHECK(IsRuntimeMethod());
+  return GetFieldObject<ObjectArray<ArtMethod> >(DexCacheResolvedMethodsOffset());
+}
+
+inline void ArtMethod::SetImtConflictTable(ObjectArray<ArtMethod>* table) {
+  DCHECK(IsRuntimeMethod());
+  SetFieldObject<false>(DexCacheResolvedMethodsOffset(), table);
 }
 
 template<VerifyObjectFlags kVerifyFlags>
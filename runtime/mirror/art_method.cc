@@ -19,6 +19,7 @@
 #include "art_field-inl.h"
 #include "art_method-inl.h"
 #include "base/stringpiece.h"
+#include "catch_handler_cache.h"
 #include "class-inl.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
@@ -182,18 +183,9 @@ uint32_t ArtMethod::ToDexPc(const uintptr_t pc, bool abort_on_failure) {
   const void* code = Runtime::Current()->GetInstrumentation()->GetQuickCodeFor(this);
   uint32_t sought_offset = pc - reinterpret_cast<uintptr_t>(code);
   // Assume the caller wants a pc-to-dex mapping so check here first.
-  typedef MappingTable::PcToDexIterator It;
-  for (It cur = table.PcToDexBegin(), end = table.PcToDexEnd(); cur != end; ++cur) {
-    if (cur.NativePcOffset() == sought_offset) {
-      return cur.DexPc();
-    }
-  }
-  // Now check dex-to-pc mappings.
-  typedef MappingTable::DexToPcIterator It2;
-  for (It2 cur = table.DexToPcBegin(), end = table.DexToPcEnd(); cur != end; ++cur) {
-    if (cur.NativePcOffset() == sought_offset) {
-      return cur.DexPc();
-    }
+  uint32_t dex_pc;
+  if (table.FindPcToDex(sought_offset, &dex_pc) || table.FindDexToPc(sought_offset, &dex_pc)) {
+    return dex_pc;
   }
   if (abort_on_failure) {
       LOG(FATAL) << "Failed to find Dex offset for PC offset " << reinterpret_cast<void*>(sought_offset)
@@ -234,30 +226,46 @@ uint32_t ArtMethod::FindCatchBlock(SirtRef<Class>& exception_type, uint32_t dex_
                                    bool* has_no_move_exception) {
   MethodHelper mh(this);
   const DexFile::CodeItem* code_item = mh.GetCodeItem();
-  // Set aside the exception while we resolve its type.
+  if (code_item->tries_size_ == 0) {
+    return DexFile::kDexNoIndex;
+  }
   Thread* self = Thread::Current();
-  ThrowLocation throw_location;
-  SirtRef<mirror::Throwable> exception(self, self->GetException(&throw_location));
-  self->ClearException();
+  CatchHandlerCache* cache = self->GetCatchHandlerCache();
   // Default to handler not found.
   uint32_t found_dex_pc = DexFile::kDexNoIndex;
-  // Iterate over the catch handlers associated with dex_pc.
-  for (CatchHandlerIterator it(*code_item, dex_pc); it.HasNext(); it.Next()) {
-    uint16_t iter_type_idx = it.GetHandlerTypeIndex();
-    // Catch all case
-    if (iter_type_idx == DexFile::kDexNoIndex16) {
-      found_dex_pc = it.GetHandlerAddress();
-      break;
+  if (!cache->Lookup(this, dex_pc, exception_type.get(), &found_dex_pc)) {
+    // Set aside the exception while we resolve its type.
+    ThrowLocation throw_location;
+    SirtRef<mirror::Throwable> exception(self, self->GetException(&throw_location));
+    self->ClearException();
+    bool unresolved = false;
+    // Iterate over the catch handlers associated with dex_pc.
+    for (CatchHandlerIterator it(*code_item, dex_pc); it.HasNext(); it.Next()) {
+      uint16_t iter_type_idx = it.GetHandlerTypeIndex();
+      // Catch all case
+      if (iter_type_idx == DexFile::kDexNoIndex16) {
+        found_dex_pc = it.GetHandlerAddress();
+        break;
+      }
+      // Does this catch exception type apply?
+      Class* iter_exception_type = mh.GetClassFromTypeIdx(iter_type_idx);
+      if (iter_exception_type == nullptr) {
+        self->ClearException();
+        LOG(WARNING) << "Unresolved exception class when finding catch block: "
+          << mh.GetTypeDescriptorFromTypeIdx(iter_type_idx);
+        unresolved = true;
+      } else if (iter_exception_type->IsAssignableFrom(exception_type.get())) {
+        found_dex_pc = it.GetHandlerAddress();
+        break;
+      }
+    }
+    // The handler class may resolve the next time around.
+    if (!unresolved) {
+      cache->Add(this, dex_pc, exception_type.get(), found_dex_pc);
     }
-    // Does this catch exception type apply?
-    Class* iter_exception_type = mh.GetClassFromTypeIdx(iter_type_idx);
-    if (exception_type.get() == nullptr) {
-      self->ClearException();
-      LOG(WARNING) << "Unresolved exception class when finding catch block: "
-        << mh.GetTypeDescriptorFromTypeIdx(iter_type_idx);
-    } else if (iter_exception_type->IsAssignableFrom(exception_type.get())) {
-      found_dex_pc = it.GetHandlerAddress();
-      break;
+    // Put the exception back.
+    if (exception.get() != nullptr) {
+      self->SetException(throw_location, exception.get());
     }
   }
   if (found_dex_pc != DexFile::kDexNoIndex) {
@@ -265,10 +273,6 @@ uint32_t ArtMethod::FindCatchBlock(SirtRef<Class>& exception_type, uint32_t dex_
         Instruction::At(&code_item->insns_[found_dex_pc]);
     *has_no_move_exception = (first_catch_instr->Opcode() != Instruction::MOVE_EXCEPTION);
   }
-  // Put the exception back.
-  if (exception.get() != nullptr) {
-    self->SetException(throw_location, exception.get());
-  }
   return found_dex_pc;
 }
 
@@ -356,8 +360,8 @@ bool ArtMethod::IsRegistered() {
 void ArtMethod::RegisterNative(Thread* self, const void* native_method, bool is_fast) {
   DCHECK(Thread::Current() == self);
   CHECK(IsNative()) << PrettyMethod(this);
-  CHECK(!IsFastNative()) << PrettyMethod(this);
   CHECK(native_method != NULL) << PrettyMethod(this);
+  // The flag may already be set by a @FastNative or @CriticalNative annotation.
   if (is_fast) {
     SetAccessFlags(GetAccessFlags() | kAccFastNative);
   }
@@ -365,7 +369,9 @@ void ArtMethod::RegisterNative(Thread* self, const void* native_method, bool is_
 }
 
 void ArtMethod::UnregisterNative(Thread* self) {
-  CHECK(IsNative() && !IsFastNative()) << PrettyMethod(this);
+  // The fast and critical flags are kept, the compiled JNI stub of an annotated method relies on
+  // them.
+  CHECK(IsNative()) << PrettyMethod(this);
   // restore stub to lookup native pointer via dlsym
   RegisterNative(self, GetJniDlsymLookupStub(), false);
 }
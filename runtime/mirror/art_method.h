@@ -118,6 +118,13 @@ class MANAGED ArtMethod : public Object {
     return (GetAccessFlags() & mask) == mask;
   }
 
+  // A static native taking and returning primitives only, whose native code takes neither the
+  // JNIEnv nor the jclass.
+  bool IsCriticalNative() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    uint32_t mask = kAccCriticalNative | kAccNative;
+    return (GetAccessFlags() & mask) == mask;
+  }
+
   bool IsAbstract() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return (GetAccessFlags() & kAccAbstract) != 0;
   }
@@ -217,19 +224,22 @@ class MANAGED ArtMethod : public Object {
   void Invoke(Thread* self, uint32_t* args, uint32_t args_size, JValue* result,
               const char* shorty) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  static MemberOffset EntryPointFromInterpreterOffset() {
+    return MemberOffset(OFFSETOF_MEMBER(ArtMethod, entry_point_from_interpreter_));
+  }
+
   template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags>
   EntryPointFromInterpreter* GetEntryPointFromInterpreter()
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return GetFieldPtr<EntryPointFromInterpreter*, kVerifyFlags>(
-               OFFSET_OF_OBJECT_MEMBER(ArtMethod, entry_point_from_interpreter_));
+               EntryPointFromInterpreterOffset());
   }
 
   template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags>
   void SetEntryPointFromInterpreter(EntryPointFromInterpreter* entry_point_from_interpreter)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     SetFieldPtr<false, true, kVerifyFlags>(
-        OFFSET_OF_OBJECT_MEMBER(ArtMethod, entry_point_from_interpreter_),
-        entry_point_from_interpreter);
+        EntryPointFromInterpreterOffset(), entry_point_from_interpreter);
   }
 
   static MemberOffset EntryPointFromPortableCompiledCodeOffset() {
@@ -304,12 +314,16 @@ class MANAGED ArtMethod : public Object {
   // Callers should wrap the uint8_t* in a VmapTable instance for convenient access.
   const uint8_t* GetVmapTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  static MemberOffset NativeGcMapOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_);
+  }
+
   const uint8_t* GetNativeGcMap() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return GetFieldPtr<uint8_t*>(OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_));
+    return GetFieldPtr<uint8_t*>(NativeGcMapOffset());
   }
   template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags>
   void SetNativeGcMap(const uint8_t* data) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    SetFieldPtr<false, true, kVerifyFlags>(OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_), data);
+    SetFieldPtr<false, true, kVerifyFlags>(NativeGcMapOffset(), data);
   }
 
   // When building the oat need a convenient place to stuff the offset of the native GC map.
@@ -391,8 +405,16 @@ class MANAGED ArtMethod : public Object {
 
   bool IsResolutionMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Is this the imt conflict method of the runtime or one created for an imt entry of a class?
   bool IsImtConflictMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The conflict table of an imt conflict method created for an imt entry of a class, pairs of
+  // an interface method and its implementation, which art_quick_imt_conflict_trampoline searches
+  // before calling into the runtime. Null for the imt conflict method of the runtime.
+  ObjectArray<ArtMethod>* GetImtConflictTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SetImtConflictTable(ObjectArray<ArtMethod>* table)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   uintptr_t NativePcOffset(const uintptr_t pc) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Converts a native PC to a dex PC.
@@ -132,17 +132,20 @@ inline void Class::SetVTable(ObjectArray<ArtMethod>* new_vtable) {
   SetFieldObject<false>(OFFSET_OF_OBJECT_MEMBER(Class, vtable_), new_vtable);
 }
 
-inline ObjectArray<ArtMethod>* Class::GetImTable() {
-  return GetFieldObject<ObjectArray<ArtMethod> >(OFFSET_OF_OBJECT_MEMBER(Class, imtable_));
+inline ArtMethod* Class::GetEmbeddedImTableEntry(uint32_t i) {
+  return GetFieldObject<ArtMethod>(EmbeddedImTableEntryOffset(i));
 }
 
-inline void Class::SetImTable(ObjectArray<ArtMethod>* new_imtable) {
-  SetFieldObject<false>(OFFSET_OF_OBJECT_MEMBER(Class, imtable_), new_imtable);
+inline void Class::SetEmbeddedImTableEntry(uint32_t i, ArtMethod* method) {
+  SetFieldObject<false>(EmbeddedImTableEntryOffset(i), method);
 }
 
 inline bool Class::Implements(Class* klass) {
   DCHECK(klass != NULL);
   DCHECK(klass->IsInterface()) << PrettyClass(this);
+  if (GetFieldObject<Class>(SecondarySuperCacheOffset()) == klass) {
+    return true;
+  }
   // All interfaces implemented directly and by our superclass, and
   // recursively all super-interfaces of those interfaces, are listed
   // in iftable_, so we can just do a linear scan through that.
@@ -150,6 +153,9 @@ inline bool Class::Implements(Class* klass) {
   IfTable* iftable = GetIfTable();
   for (int32_t i = 0; i < iftable_count; i++) {
     if (iftable->GetInterface(i) == klass) {
+      // Racing threads may overwrite each other's entry, either is a valid answer. The cache
+      // isn't part of the class state a transaction rolls back.
+      SetFieldObject<false, false>(SecondarySuperCacheOffset(), klass);
       return true;
     }
   }
@@ -499,6 +505,10 @@ template <bool kVisitClass, typename Visitor>
 inline void Class::VisitReferences(mirror::Class* klass, const Visitor& visitor) {
   VisitInstanceFieldsReferences<kVisitClass>(klass, visitor);
   VisitStaticFieldsReferences<kVisitClass>(this, visitor);
+  visitor(this, SecondarySuperCacheOffset(), false);
+  for (uint32_t i = 0; i < kImtSize; ++i) {
+    visitor(this, EmbeddedImTableEntryOffset(i), false);
+  }
 }
 
 template<ReadBarrierOption kReadBarrierOption>
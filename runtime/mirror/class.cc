@@ -20,6 +20,7 @@
 #include "art_method-inl.h"
 #include "class-inl.h"
 #include "class_linker.h"
+#include "class_member_index.h"
 #include "class_loader.h"
 #include "dex_cache.h"
 #include "dex_file-inl.h"
@@ -336,6 +337,40 @@ void Class::SetClassLoader(ClassLoader* new_class_loader) {
   }
 }
 
+ClassMemberIndex* Class::GetMemberIndex() {
+  uintptr_t published = static_cast<uintptr_t>(GetField64(MemberIndexOffset()));
+  ClassMemberIndex* index = reinterpret_cast<ClassMemberIndex*>(published);
+  if (index != nullptr || !IsResolved()) {
+    // Members are added until the class is resolved, miranda methods when linking.
+    return index;
+  }
+  bool should_index = false;
+  for (size_t kind = 0; kind < ClassMemberIndex::kNumKinds; ++kind) {
+    should_index |= ClassMemberIndex::ShouldIndex(this, static_cast<ClassMemberIndex::Kind>(kind));
+  }
+  if (!should_index) {
+    return nullptr;
+  }
+  index = new ClassMemberIndex(this);
+  // Another thread may have built an index meanwhile, keep the first one published. The index
+  // isn't part of the class state a transaction rolls back.
+  if (!CasField64<false, false>(MemberIndexOffset(), 0,
+                                static_cast<int64_t>(reinterpret_cast<uintptr_t>(index)))) {
+    delete index;
+    published = static_cast<uintptr_t>(GetField64(MemberIndexOffset()));
+    index = reinterpret_cast<ClassMemberIndex*>(published);
+  }
+  return index;
+}
+
+void Class::DeleteMemberIndex() {
+  uintptr_t published = static_cast<uintptr_t>(GetField64(MemberIndexOffset()));
+  if (published != 0) {
+    SetField64<false, false>(MemberIndexOffset(), 0);
+    delete reinterpret_cast<ClassMemberIndex*>(published);
+  }
+}
+
 ArtMethod* Class::FindInterfaceMethod(const StringPiece& name, const Signature& signature) {
   // Check the current class before checking the interfaces.
   ArtMethod* method = FindDeclaredVirtualMethod(name, signature);
@@ -374,6 +409,18 @@ ArtMethod* Class::FindInterfaceMethod(const DexCache* dex_cache, uint32_t dex_me
 
 ArtMethod* Class::FindDeclaredDirectMethod(const StringPiece& name, const StringPiece& signature) {
   MethodHelper mh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kDirectMethods)) {
+    auto range = index->LookupName(ClassMemberIndex::kDirectMethods, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtMethod* method = GetDirectMethod(it->second);
+      mh.ChangeMethod(method);
+      if (mh.GetSignature() == signature) {
+        return method;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumDirectMethods(); ++i) {
     ArtMethod* method = GetDirectMethod(i);
     mh.ChangeMethod(method);
@@ -386,6 +433,18 @@ ArtMethod* Class::FindDeclaredDirectMethod(const StringPiece& name, const String
 
 ArtMethod* Class::FindDeclaredDirectMethod(const StringPiece& name, const Signature& signature) {
   MethodHelper mh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kDirectMethods)) {
+    auto range = index->LookupName(ClassMemberIndex::kDirectMethods, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtMethod* method = GetDirectMethod(it->second);
+      mh.ChangeMethod(method);
+      if (signature == mh.GetSignature()) {
+        return method;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumDirectMethods(); ++i) {
     ArtMethod* method = GetDirectMethod(i);
     mh.ChangeMethod(method);
@@ -398,6 +457,11 @@ ArtMethod* Class::FindDeclaredDirectMethod(const StringPiece& name, const Signat
 
 ArtMethod* Class::FindDeclaredDirectMethod(const DexCache* dex_cache, uint32_t dex_method_idx) {
   if (GetDexCache() == dex_cache) {
+    ClassMemberIndex* index = GetMemberIndex();
+    if (index != nullptr && index->IsIndexed(ClassMemberIndex::kDirectMethods)) {
+      int32_t i = index->LookupDexIndex(ClassMemberIndex::kDirectMethods, dex_method_idx);
+      return (i != -1) ? GetDirectMethod(i) : NULL;
+    }
     for (size_t i = 0; i < NumDirectMethods(); ++i) {
       ArtMethod* method = GetDirectMethod(i);
       if (method->GetDexMethodIndex() == dex_method_idx) {
@@ -440,6 +504,18 @@ ArtMethod* Class::FindDirectMethod(const DexCache* dex_cache, uint32_t dex_metho
 
 ArtMethod* Class::FindDeclaredVirtualMethod(const StringPiece& name, const StringPiece& signature) {
   MethodHelper mh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kVirtualMethods)) {
+    auto range = index->LookupName(ClassMemberIndex::kVirtualMethods, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtMethod* method = GetVirtualMethod(it->second);
+      mh.ChangeMethod(method);
+      if (mh.GetSignature() == signature) {
+        return method;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumVirtualMethods(); ++i) {
     ArtMethod* method = GetVirtualMethod(i);
     mh.ChangeMethod(method);
@@ -453,6 +529,18 @@ ArtMethod* Class::FindDeclaredVirtualMethod(const StringPiece& name, const Strin
 ArtMethod* Class::FindDeclaredVirtualMethod(const StringPiece& name,
                                             const Signature& signature) {
   MethodHelper mh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kVirtualMethods)) {
+    auto range = index->LookupName(ClassMemberIndex::kVirtualMethods, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtMethod* method = GetVirtualMethod(it->second);
+      mh.ChangeMethod(method);
+      if (signature == mh.GetSignature()) {
+        return method;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumVirtualMethods(); ++i) {
     ArtMethod* method = GetVirtualMethod(i);
     mh.ChangeMethod(method);
@@ -465,6 +553,11 @@ ArtMethod* Class::FindDeclaredVirtualMethod(const StringPiece& name,
 
 ArtMethod* Class::FindDeclaredVirtualMethod(const DexCache* dex_cache, uint32_t dex_method_idx) {
   if (GetDexCache() == dex_cache) {
+    ClassMemberIndex* index = GetMemberIndex();
+    if (index != nullptr && index->IsIndexed(ClassMemberIndex::kVirtualMethods)) {
+      int32_t i = index->LookupDexIndex(ClassMemberIndex::kVirtualMethods, dex_method_idx);
+      return (i != -1) ? GetVirtualMethod(i) : NULL;
+    }
     for (size_t i = 0; i < NumVirtualMethods(); ++i) {
       ArtMethod* method = GetVirtualMethod(i);
       if (method->GetDexMethodIndex() == dex_method_idx) {
@@ -525,6 +618,18 @@ ArtField* Class::FindDeclaredInstanceField(const StringPiece& name, const String
   // Is the field in this class?
   // Interfaces are not relevant because they can't contain instance fields.
   FieldHelper fh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kInstanceFields)) {
+    auto range = index->LookupName(ClassMemberIndex::kInstanceFields, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtField* f = GetInstanceField(it->second);
+      fh.ChangeField(f);
+      if (type == fh.GetTypeDescriptor()) {
+        return f;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumInstanceFields(); ++i) {
     ArtField* f = GetInstanceField(i);
     fh.ChangeField(f);
@@ -537,6 +642,11 @@ ArtField* Class::FindDeclaredInstanceField(const StringPiece& name, const String
 
 ArtField* Class::FindDeclaredInstanceField(const DexCache* dex_cache, uint32_t dex_field_idx) {
   if (GetDexCache() == dex_cache) {
+    ClassMemberIndex* index = GetMemberIndex();
+    if (index != nullptr && index->IsIndexed(ClassMemberIndex::kInstanceFields)) {
+      int32_t i = index->LookupDexIndex(ClassMemberIndex::kInstanceFields, dex_field_idx);
+      return (i != -1) ? GetInstanceField(i) : NULL;
+    }
     for (size_t i = 0; i < NumInstanceFields(); ++i) {
       ArtField* f = GetInstanceField(i);
       if (f->GetDexFieldIndex() == dex_field_idx) {
@@ -574,6 +684,18 @@ ArtField* Class::FindInstanceField(const DexCache* dex_cache, uint32_t dex_field
 ArtField* Class::FindDeclaredStaticField(const StringPiece& name, const StringPiece& type) {
   DCHECK(type != NULL);
   FieldHelper fh;
+  ClassMemberIndex* index = GetMemberIndex();
+  if (index != nullptr && index->IsIndexed(ClassMemberIndex::kStaticFields)) {
+    auto range = index->LookupName(ClassMemberIndex::kStaticFields, name);
+    for (auto it = range.first; it != range.second; ++it) {
+      ArtField* f = GetStaticField(it->second);
+      fh.ChangeField(f);
+      if (type == fh.GetTypeDescriptor()) {
+        return f;
+      }
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < NumStaticFields(); ++i) {
     ArtField* f = GetStaticField(i);
     fh.ChangeField(f);
@@ -586,6 +708,11 @@ ArtField* Class::FindDeclaredStaticField(const StringPiece& name, const StringPi
 
 ArtField* Class::FindDeclaredStaticField(const DexCache* dex_cache, uint32_t dex_field_idx) {
   if (dex_cache == GetDexCache()) {
+    ClassMemberIndex* index = GetMemberIndex();
+    if (index != nullptr && index->IsIndexed(ClassMemberIndex::kStaticFields)) {
+      int32_t i = index->LookupDexIndex(ClassMemberIndex::kStaticFields, dex_field_idx);
+      return (i != -1) ? GetStaticField(i) : NULL;
+    }
     for (size_t i = 0; i < NumStaticFields(); ++i) {
       ArtField* f = GetStaticField(i);
       if (f->GetDexFieldIndex() == dex_field_idx) {
@@ -62,6 +62,7 @@ namespace art {
 
 struct ClassClassOffsets;
 struct ClassOffsets;
+class ClassMemberIndex;
 class Signature;
 class StringPiece;
 
@@ -75,6 +76,10 @@ class IfTable;
 // C++ mirror of java.lang.Class
 class MANAGED Class : public Object {
  public:
+  // Number of entries of the interface method table (imt). Increasing this value reduces the
+  // chance of two interface methods colliding in the table but increases the size of every class.
+  static constexpr size_t kImtSize = 64;
+
   // Class Status
   //
   // kStatusNotReady: If a Class cannot be found in the class table by
@@ -253,6 +258,12 @@ class MANAGED Class : public Object {
     return (GetAccessFlags<kVerifyFlags>() & kAccClassIsPhantomReference) != 0;
   }
 
+  // Returns true if the class is java.lang.ClassLoader or one of its subclasses.
+  template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags>
+  bool IsClassLoaderClass() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return (GetAccessFlags<kVerifyFlags>() & kAccClassIsClassLoader) != 0;
+  }
+
   // Can references of this type be assigned to by things of another type? For non-array types
   // this is a matter of whether sub-classes may exist - which they can't if the type is final.
   // For array classes, where all the classes are final due to there being no sub-classes, an
@@ -451,6 +462,10 @@ class MANAGED Class : public Object {
     return SetField32<false>(OFFSET_OF_OBJECT_MEMBER(Class, object_size_), new_object_size);
   }
 
+  static MemberOffset ObjectSizeOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, object_size_);
+  }
+
   // Returns true if this class is in the same packages as that class.
   bool IsInSamePackage(Class* that) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -613,13 +628,31 @@ class MANAGED Class : public Object {
     return OFFSET_OF_OBJECT_MEMBER(Class, vtable_);
   }
 
-  ObjectArray<ArtMethod>* GetImTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // The method of entry i of the embedded imt, see embedded_imtable_.
+  ArtMethod* GetEmbeddedImTableEntry(uint32_t i) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void SetImTable(ObjectArray<ArtMethod>* new_imtable)
+  void SetEmbeddedImTableEntry(uint32_t i, ArtMethod* method)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  static MemberOffset ImTableOffset() {
-    return OFFSET_OF_OBJECT_MEMBER(Class, imtable_);
+  // The index of the members of the class, built on first use when the class is resolved and has
+  // many members, null otherwise. The Find* lookups of names and dex member indices use it.
+  ClassMemberIndex* GetMemberIndex() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Frees the member index of a class being unloaded.
+  void DeleteMemberIndex() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static MemberOffset MemberIndexOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, member_index_);
+  }
+
+  static MemberOffset SecondarySuperCacheOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, secondary_super_cache_);
+  }
+
+  static MemberOffset EmbeddedImTableEntryOffset(uint32_t i) {
+    DCHECK_LT(i, kImtSize);
+    return MemberOffset(OFFSETOF_MEMBER(Class, embedded_imtable_) +
+                        i * sizeof(HeapReference<ArtMethod>));
   }
 
   // Given a method implemented by this class but potentially from a super class, return the
@@ -907,7 +940,7 @@ class MANAGED Class : public Object {
   // methods for the methods in the interface.
   HeapReference<IfTable> iftable_;
 
-  // Interface method table (imt), for quick "invoke-interface".
+  // Unused, java.lang.Class declares it. The imt is embedded_imtable_.
   HeapReference<ObjectArray<ArtMethod> > imtable_;
 
   // Descriptor for the class such as "java.lang.Class" or "[C". Lazily initialized by ComputeName
@@ -978,6 +1011,21 @@ class MANAGED Class : public Object {
   // values are kept in a table in gDvm.
   // InitiatingLoaderList initiating_loader_list_;
 
+  // The interface this class was last found to implement, which Implements and the check-cast
+  // stubs test before scanning iftable_. A cast to an interface, typically repeated on objects of
+  // the same class, then costs a single compare. It isn't a Java field, it follows them.
+  HeapReference<Class> secondary_super_cache_;
+
+  // Native pointer to the ClassMemberIndex of the class, see GetMemberIndex. Not a Java field.
+  uint64_t member_index_;
+
+  // Interface method table (imt), for quick "invoke-interface". Entry i holds the
+  // implementation of the interface methods whose dex method index is i modulo kImtSize, or an
+  // imt conflict method when several of them share the entry, which searches the conflict table
+  // of the entry. The table is embedded, rather than an ObjectArray, so that compiled code loads
+  // the method with a single load from the class. It isn't a Java field, it follows them.
+  HeapReference<ArtMethod> embedded_imtable_[kImtSize];
+
   // Location of first static field.
   uint32_t fields_[0];
 
@@ -16,8 +16,10 @@
 
 #include "dex_cache.h"
 
+#include "art_field-inl.h"
 #include "art_method-inl.h"
 #include "base/logging.h"
+#include "class-inl.h"
 #include "class_linker.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
@@ -27,6 +29,7 @@
 #include "object_array-inl.h"
 #include "runtime.h"
 #include "string.h"
+#include "utils.h"
 
 namespace art {
 namespace mirror {
@@ -62,6 +65,31 @@ void DexCache::Init(const DexFile* dex_file,
   }
 }
 
+ArtField* DexCache::GetCompactResolvedField(uint32_t field_idx) {
+  ObjectArray<ArtField>* resolved_fields = GetResolvedFields();
+  DCHECK(IsPowerOfTwo(resolved_fields->GetLength()));
+  ArtField* field =
+      resolved_fields->GetWithoutChecks(field_idx & (resolved_fields->GetLength() - 1));
+  // The slot only holds fields declared in this dex file under their own field id, see
+  // SetCompactResolvedField, so the field index and the dex cache identify the entry.
+  if (field != nullptr && field->GetDexFieldIndex() == field_idx &&
+      field->GetDeclaringClass()->GetDexCache() == this) {
+    return field;
+  }
+  return nullptr;
+}
+
+void DexCache::SetCompactResolvedField(uint32_t field_idx, ArtField* resolved) {
+  // A field reached through another field id, for instance through a subclass, can't be told
+  // apart from the other field ids sharing its slot. Leave it to the slow path.
+  if (resolved == nullptr || resolved->GetDexFieldIndex() != field_idx ||
+      resolved->GetDeclaringClass()->GetDexCache() != this) {
+    return;
+  }
+  ObjectArray<ArtField>* resolved_fields = GetResolvedFields();
+  resolved_fields->Set(field_idx & (resolved_fields->GetLength() - 1), resolved);
+}
+
 void DexCache::Fixup(ArtMethod* trampoline) {
   // Fixup the resolve methods array to contain trampoline for resolution.
   CHECK(trampoline != nullptr);
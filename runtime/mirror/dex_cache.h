@@ -80,10 +80,21 @@ class MANAGED DexCache : public Object {
     return GetResolvedMethods()->GetLength();
   }
 
+  // The number of resolved field slots, less than the number of field ids of a compact dex cache.
   size_t NumResolvedFields() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return GetResolvedFields()->GetLength();
   }
 
+  // The resolved fields of a compact dex cache are a direct mapped cache of this many slots
+  // indexed by the low bits of the field index, instead of one slot per field id. Compiled code
+  // never reads the resolved fields, a miss only costs a slow path resolution.
+  static constexpr size_t kCompactResolvedFieldsSize = 1024;
+
+  // Whether the resolved fields are a compact cache, see kCompactResolvedFieldsSize.
+  bool HasCompactResolvedFields() ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return static_cast<size_t>(GetResolvedFields()->GetLength()) < GetDexFile()->NumFieldIds();
+  }
+
   String* GetResolvedString(uint32_t string_idx) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return GetStrings()->Get(string_idx);
   }
@@ -114,11 +125,18 @@ class MANAGED DexCache : public Object {
 
   ArtField* GetResolvedField(uint32_t field_idx) ALWAYS_INLINE
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (UNLIKELY(HasCompactResolvedFields())) {
+      return GetCompactResolvedField(field_idx);
+    }
     return GetResolvedFields()->Get(field_idx);
   }
 
   void SetResolvedField(uint32_t field_idx, ArtField* resolved) ALWAYS_INLINE
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (UNLIKELY(HasCompactResolvedFields())) {
+      SetCompactResolvedField(field_idx, resolved);
+      return;
+    }
     GetResolvedFields()->Set(field_idx, resolved);
   }
 
@@ -151,6 +169,10 @@ class MANAGED DexCache : public Object {
   }
 
  private:
+  ArtField* GetCompactResolvedField(uint32_t field_idx) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SetCompactResolvedField(uint32_t field_idx, ArtField* resolved)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   HeapReference<Object> dex_;
   HeapReference<String> location_;
   HeapReference<ObjectArray<ArtField> > resolved_fields_;
@@ -151,6 +151,14 @@ int32_t Object::IdentityHashCode() const {
     LockWord lw = current_this->GetLockWord(false);
     switch (lw.GetState()) {
       case LockWord::kUnlocked: {
+        if (UNLIKELY(Monitor::MayHaveDisplacedHashCodes())) {
+          // The object may have a hash code from when it was thin locked.
+          int32_t hash_code;
+          if (Monitor::GetThinOrUnlockedHashCode(Thread::Current(), current_this, lw, &hash_code)) {
+            return hash_code;
+          }
+          break;
+        }
         // Try to compare and swap in a new hash, if we succeed we will return the hash on the next
         // loop iteration.
         LockWord hash_word(LockWord::FromHashCode(GenerateIdentityHashCode()));
@@ -161,12 +169,11 @@ int32_t Object::IdentityHashCode() const {
         break;
       }
       case LockWord::kThinLocked: {
-        // Inflate the thin lock to a monitor and stick the hash code inside of the monitor.
-        Thread* self = Thread::Current();
-        SirtRef<mirror::Object> sirt_this(self, current_this);
-        Monitor::InflateThinLocked(self, sirt_this, lw, GenerateIdentityHashCode());
-        // A GC may have occurred when we switched to kBlocked.
-        current_this = sirt_this.get();
+        // The lock word has no room for the hash code, displace it rather than inflate the lock.
+        int32_t hash_code;
+        if (Monitor::GetThinOrUnlockedHashCode(Thread::Current(), current_this, lw, &hash_code)) {
+          return hash_code;
+        }
         break;
       }
       case LockWord::kFatLocked: {
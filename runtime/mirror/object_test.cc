@@ -19,23 +19,31 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "array-inl.h"
 #include "art_field-inl.h"
 #include "asm_support.h"
 #include "class-inl.h"
 #include "class_linker.h"
 #include "class_linker-inl.h"
+#include "class_member_index.h"
 #include "common_runtime_test.h"
 #include "dex_file.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
+#include "gc/space/bump_pointer_space.h"
 #include "iftable-inl.h"
+#include "lock_word-inl.h"
+#include "monitor.h"
 #include "art_method-inl.h"
 #include "object-inl.h"
 #include "object_array-inl.h"
+#include "object_utils.h"
 #include "sirt_ref.h"
 #include "string-inl.h"
+#include "thread_pool.h"
 #include "UniquePtr.h"
 
 namespace art {
@@ -76,6 +84,14 @@ TEST_F(ObjectTest, AsmConstants) {
   EXPECT_EQ(LOCK_WORD_OFFSET, Object::MonitorOffset().Int32Value());
 
   EXPECT_EQ(CLASS_COMPONENT_TYPE_OFFSET, Class::ComponentTypeOffset().Int32Value());
+  EXPECT_EQ(CLASS_OBJECT_SIZE_OFFSET, Class::ObjectSizeOffset().Int32Value());
+  EXPECT_EQ(CLASS_STATUS_OFFSET, Class::StatusOffset().Int32Value());
+  EXPECT_EQ(CLASS_SECONDARY_SUPER_CACHE_OFFSET, Class::SecondarySuperCacheOffset().Int32Value());
+  EXPECT_EQ(CLASS_STATUS_INITIALIZED, Class::kStatusInitialized);
+  EXPECT_EQ(static_cast<size_t>(OBJECT_ALIGNMENT_MASK + 1),
+            static_cast<size_t>(gc::space::BumpPointerSpace::kAlignment));
+  EXPECT_EQ(static_cast<uint32_t>(OBJECT_ALIGNMENT_MASK_TOGGLED),
+            ~static_cast<uint32_t>(OBJECT_ALIGNMENT_MASK));
 
   EXPECT_EQ(ARRAY_LENGTH_OFFSET, Array::LengthOffset().Int32Value());
   EXPECT_EQ(OBJECT_ARRAY_DATA_OFFSET, Array::DataOffset(sizeof(HeapReference<Object>)).Int32Value());
@@ -251,6 +267,50 @@ TEST_F(ObjectTest, PrimitiveArray_Short_Alloc) {
   TestPrimitiveArray<ShortArray>(class_linker_);
 }
 
+template<typename ArrayT>
+void TestPrimitiveArrayMemmove() {
+  typedef typename ArrayT::ElementType T;
+  ScopedObjectAccess soa(Thread::Current());
+  const int32_t kLength = 40;
+  ArrayT* a = ArrayT::Alloc(soa.Self(), kLength);
+  ArrayT* b = ArrayT::Alloc(soa.Self(), kLength);
+  // Copy every range between every pair of positions, forwards, backwards and between arrays,
+  // so that both aligned and unaligned copies of each length are covered.
+  for (int32_t count = 1; count <= kLength / 2; ++count) {
+    for (int32_t src_pos = 0; src_pos + count <= kLength; src_pos += 3) {
+      for (int32_t dst_pos = 0; dst_pos + count <= kLength; ++dst_pos) {
+        std::vector<T> expected(kLength);
+        for (int32_t i = 0; i < kLength; ++i) {
+          a->Set(i, T(i + 1));
+          b->Set(i, T(0));
+          expected[i] = T(i + 1);
+        }
+        for (int32_t i = 0; i < count; ++i) {
+          expected[dst_pos + i] = T(src_pos + i + 1);
+        }
+        b->Memcpy(dst_pos, a, src_pos, count);
+        a->Memmove(dst_pos, a, src_pos, count);
+        for (int32_t i = 0; i < kLength; ++i) {
+          ASSERT_EQ(expected[i], a->Get(i)) << count << " " << src_pos << " " << dst_pos;
+        }
+        for (int32_t i = 0; i < count; ++i) {
+          ASSERT_EQ(expected[dst_pos + i], b->Get(dst_pos + i));
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ObjectTest, PrimitiveArray_Char_Memmove) {
+  TestPrimitiveArrayMemmove<CharArray>();
+}
+TEST_F(ObjectTest, PrimitiveArray_Int_Memmove) {
+  TestPrimitiveArrayMemmove<IntArray>();
+}
+TEST_F(ObjectTest, PrimitiveArray_Long_Memmove) {
+  TestPrimitiveArrayMemmove<LongArray>();
+}
+
 TEST_F(ObjectTest, CheckAndAllocArrayFromCode) {
   // pretend we are trying to call 'new char[3]' from String.toCharArray
   ScopedObjectAccess soa(Thread::Current());
@@ -506,6 +566,39 @@ TEST_F(ObjectTest, StringHashCode) {
   EXPECT_EQ(64578, ABC->GetHashCode());
 }
 
+TEST_F(ObjectTest, StringLatin1) {
+  ScopedObjectAccess soa(Thread::Current());
+  // "caf\u00e9" is compressed when allocated from UTF-16 but not from modified UTF-8.
+  const uint16_t utf16[] = { 'c', 'a', 'f', 0xe9 };
+  SirtRef<String> latin1(soa.Self(), String::AllocFromUtf16(soa.Self(), 4, utf16));
+  SirtRef<String> utf8(soa.Self(), String::AllocFromModifiedUtf8(soa.Self(), "caf\xc3\xa9"));
+  SirtRef<String> ascii(soa.Self(), String::AllocFromModifiedUtf8(soa.Self(), "cafe"));
+  ASSERT_TRUE(latin1.get() != nullptr);
+  ASSERT_TRUE(utf8.get() != nullptr);
+  ASSERT_TRUE(ascii.get() != nullptr);
+  EXPECT_EQ(String::kUseStringCompression, latin1->IsCompressed());
+  EXPECT_FALSE(utf8->IsCompressed());
+  EXPECT_EQ(String::kUseStringCompression, ascii->IsCompressed());
+
+  EXPECT_EQ(4, latin1->GetLength());
+  EXPECT_EQ(0xe9, latin1->CharAt(3));
+  EXPECT_EQ(utf8->GetHashCode(), latin1->GetHashCode());
+  EXPECT_TRUE(latin1->Equals(utf8.get()));
+  EXPECT_TRUE(utf8->Equals(latin1.get()));
+  EXPECT_TRUE(latin1->Equals("caf\xc3\xa9"));
+  EXPECT_EQ(0, latin1->CompareTo(utf8.get()));
+  EXPECT_EQ(0xe9 - 'e', latin1->CompareTo(ascii.get()));
+  EXPECT_EQ(3, latin1->FastIndexOf(0xe9, 0));
+  EXPECT_EQ(-1, ascii->FastIndexOf(0xe9, 0));
+  EXPECT_EQ(5, latin1->GetUtfLength());
+  EXPECT_EQ("caf\xc3\xa9", latin1->ToModifiedUtf8());
+
+  uint16_t chars[2];
+  latin1->GetChars(2, 2, chars);
+  EXPECT_EQ('f', chars[0]);
+  EXPECT_EQ(0xe9, chars[1]);
+}
+
 TEST_F(ObjectTest, InstanceOf) {
   ScopedObjectAccess soa(Thread::Current());
   jobject jclass_loader = LoadDex("XandY");
@@ -690,5 +783,134 @@ TEST_F(ObjectTest, FindStaticField) {
   // TODO: test that interfaces trump superclasses.
 }
 
+TEST_F(ObjectTest, FindMembersWithMemberIndex) {
+  ScopedObjectAccess soa(Thread::Current());
+  Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/String;");
+  ASSERT_TRUE(c != NULL);
+  ASSERT_GE(c->NumVirtualMethods(), ClassMemberIndex::kMinIndexedMembers);
+  ClassMemberIndex* index = c->GetMemberIndex();
+  ASSERT_TRUE(index != NULL);
+  EXPECT_TRUE(index->IsIndexed(ClassMemberIndex::kVirtualMethods));
+  EXPECT_EQ(index, c->GetMemberIndex());
+
+  // Every virtual method, overloads included, is found by name and signature and by index.
+  MethodHelper mh;
+  for (size_t i = 0; i < c->NumVirtualMethods(); ++i) {
+    ArtMethod* method = c->GetVirtualMethod(i);
+    mh.ChangeMethod(method);
+    EXPECT_EQ(method, c->FindDeclaredVirtualMethod(mh.GetName(), mh.GetSignature()));
+    EXPECT_EQ(method, c->FindDeclaredVirtualMethod(mh.GetName(),
+                                                   mh.GetSignature().ToString()));
+    EXPECT_EQ(method, c->FindDeclaredVirtualMethod(c->GetDexCache(),
+                                                   method->GetDexMethodIndex()));
+  }
+  EXPECT_TRUE(c->FindDeclaredVirtualMethod("charAt", "(I)I") == NULL);
+  EXPECT_TRUE(c->FindDeclaredVirtualMethod("charat", "(I)C") == NULL);
+  EXPECT_TRUE(c->FindDeclaredVirtualMethod("charAt", "(I)C") != NULL);
+}
+
+TEST_F(ObjectTest, IdentityHashCodeKeepsLockThin) {
+  ScopedObjectAccess soa(Thread::Current());
+  Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  SirtRef<Object> locked_first(soa.Self(), c->AllocObject(soa.Self()));
+  SirtRef<Object> hashed_first(soa.Self(), c->AllocObject(soa.Self()));
+  ASSERT_TRUE(locked_first.get() != NULL);
+  ASSERT_TRUE(hashed_first.get() != NULL);
+
+  // Hashing a thin locked object displaces the hash code.
+  Monitor::MonitorEnter(soa.Self(), locked_first.get());
+  const int32_t locked_hash = locked_first->IdentityHashCode();
+  EXPECT_EQ(LockWord::kThinLocked, locked_first->GetLockWord(true).GetState());
+  EXPECT_EQ(locked_hash, locked_first->IdentityHashCode());
+  Monitor::MonitorExit(soa.Self(), locked_first.get());
+  // Hashing it unlocked moves the hash code back into the lock word.
+  EXPECT_EQ(locked_hash, locked_first->IdentityHashCode());
+  EXPECT_EQ(LockWord::kHashCode, locked_first->GetLockWord(true).GetState());
+
+  // Locking a hashed object displaces the hash code too.
+  const int32_t hashed_hash = hashed_first->IdentityHashCode();
+  Monitor::MonitorEnter(soa.Self(), hashed_first.get());
+  EXPECT_EQ(LockWord::kThinLocked, hashed_first->GetLockWord(true).GetState());
+  EXPECT_EQ(hashed_hash, hashed_first->IdentityHashCode());
+  Monitor::MonitorEnter(soa.Self(), hashed_first.get());
+  Monitor::MonitorExit(soa.Self(), hashed_first.get());
+  Monitor::MonitorExit(soa.Self(), hashed_first.get());
+  EXPECT_EQ(hashed_hash, hashed_first->IdentityHashCode());
+  EXPECT_EQ(LockWord::kHashCode, hashed_first->GetLockWord(true).GetState());
+}
+
+// Hashes or thin locks each object of an array, racing the other tasks on the same objects.
+class HashOrLockTask : public Task {
+ public:
+  HashOrLockTask(jobject objects, std::vector<int32_t>* hash_codes)
+      : objects_(objects), hash_codes_(hash_codes) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    ObjectArray<Object>* objects = soa.Decode<ObjectArray<Object>*>(objects_);
+    for (int32_t i = 0; i < objects->GetLength(); ++i) {
+      Object* obj = objects->Get(i);
+      if (hash_codes_ != NULL) {
+        hash_codes_->push_back(obj->IdentityHashCode());
+      } else {
+        Monitor::MonitorEnter(self, obj);
+        Monitor::MonitorExit(self, obj);
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  const jobject objects_;
+  std::vector<int32_t>* const hash_codes_;
+};
+
+TEST_F(ObjectTest, IdentityHashCodeWhileLocking) {
+  static const size_t kNumObjects = 10000;
+  static const size_t kNumHashers = 2;
+  Thread* self = Thread::Current();
+  jobject objects;
+  {
+    ScopedObjectAccess soa(self);
+    Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+    ASSERT_TRUE(c != NULL);
+    SirtRef<ObjectArray<Object> > array(soa.Self(),
+        class_linker_->AllocObjectArray<Object>(soa.Self(), kNumObjects));
+    ASSERT_TRUE(array.get() != NULL);
+    for (size_t i = 0; i < kNumObjects; ++i) {
+      Object* obj = c->AllocObject(soa.Self());
+      ASSERT_TRUE(obj != NULL);
+      array->Set(i, obj);
+    }
+    objects = soa.Env()->NewGlobalRef(soa.AddLocalReference<jobject>(array.get()));
+  }
+
+  std::vector<int32_t> hash_codes[kNumHashers];
+  ThreadPool thread_pool("Identity hash code test thread pool", kNumHashers + 2);
+  thread_pool.AddTask(self, new HashOrLockTask(objects, NULL));
+  for (size_t i = 0; i < kNumHashers; ++i) {
+    thread_pool.AddTask(self, new HashOrLockTask(objects, &hash_codes[i]));
+  }
+  thread_pool.AddTask(self, new HashOrLockTask(objects, NULL));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+
+  // Every thread got the same hash code for an object, the one it keeps afterwards.
+  ScopedObjectAccess soa(self);
+  ObjectArray<Object>* array = soa.Decode<ObjectArray<Object>*>(objects);
+  for (size_t i = 0; i < kNumObjects; ++i) {
+    const int32_t hash_code = array->Get(i)->IdentityHashCode();
+    for (size_t j = 0; j < kNumHashers; ++j) {
+      ASSERT_EQ(kNumObjects, hash_codes[j].size());
+      EXPECT_EQ(hash_code, hash_codes[j][i]);
+    }
+  }
+  soa.Env()->DeleteGlobalRef(objects);
+}
+
 }  // namespace mirror
 }  // namespace art
@@ -42,8 +42,10 @@ class MANAGED Reference : public Object {
     return OFFSET_OF_OBJECT_MEMBER(Reference, referent_);
   }
 
+  template<ReadBarrierOption kReadBarrierOption = kWithReadBarrier>
   Object* GetReferent() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return GetFieldObjectVolatile<Object>(ReferentOffset());
+    return GetFieldObjectVolatile<Object, kDefaultVerifyFlags, kReadBarrierOption>(
+        ReferentOffset());
   }
   template<bool kTransactionActive>
   void SetReferent(Object* referent) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -65,6 +67,12 @@ class MANAGED Reference : public Object {
     SetFieldObject<kTransactionActive>(PendingNextOffset(), pending_next);
   }
 
+  // Atomically set the pending next if it is still expected, not recorded by transactions.
+  bool CasPendingNext(Reference* expected, Reference* pending_next)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return CasFieldObject<false>(PendingNextOffset(), expected, pending_next);
+  }
+
   bool IsEnqueued() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     // Since the references are stored as cyclic lists it means that once enqueued, the pending
     // next is always non-null.
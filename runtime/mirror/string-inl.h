@@ -26,17 +26,35 @@
 namespace art {
 namespace mirror {
 
+inline Array* String::GetArray() {
+  return GetFieldObject<Array>(ValueOffset());
+}
+
 inline CharArray* String::GetCharArray() {
+  DCHECK(!IsCompressed());
   return GetFieldObject<CharArray>(ValueOffset());
 }
 
+inline const uint16_t* String::GetValue() {
+  return GetCharArray()->GetData() + GetOffset();
+}
+
+inline const uint8_t* String::GetValueCompressed() {
+  DCHECK(IsCompressed());
+  return reinterpret_cast<const uint8_t*>(
+      GetFieldObject<ByteArray>(ValueOffset())->GetData() + GetOffset());
+}
+
 inline int32_t String::GetLength() {
   int32_t result = GetField32(OFFSET_OF_OBJECT_MEMBER(String, count_));
-  DCHECK(result >= 0 && result <= GetCharArray()->GetLength());
+  if (kUseStringCompression) {
+    result = static_cast<int32_t>(static_cast<uint32_t>(result) & ~kCompressedFlag);
+  }
+  DCHECK(result >= 0 && result <= GetArray()->GetLength());
   return result;
 }
 
-inline void String::SetArray(CharArray* new_array) {
+inline void String::SetArray(Array* new_array) {
   // Array is invariant so use non-transactional mode. Also disable check as we may run inside
   // a transaction.
   DCHECK(new_array != NULL);
@@ -50,14 +68,17 @@ inline String* String::Intern() {
 inline uint16_t String::CharAt(int32_t index) {
   // TODO: do we need this? Equals is the only caller, and could
   // bounds check itself.
-  DCHECK_GE(count_, 0);  // ensures the unsigned comparison is safe.
-  if (UNLIKELY(static_cast<uint32_t>(index) >= static_cast<uint32_t>(count_))) {
+  int32_t count = GetLength();
+  if (UNLIKELY(static_cast<uint32_t>(index) >= static_cast<uint32_t>(count))) {
     Thread* self = Thread::Current();
     ThrowLocation throw_location = self->GetCurrentLocationForThrow();
     self->ThrowNewExceptionF(throw_location, "Ljava/lang/StringIndexOutOfBoundsException;",
-                             "length=%i; index=%i", count_, index);
+                             "length=%i; index=%i", count, index);
     return 0;
   }
+  if (IsCompressed()) {
+    return GetValueCompressed()[index];
+  }
   return GetCharArray()->Get(index + GetOffset());
 }
 
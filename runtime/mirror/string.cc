@@ -32,6 +32,9 @@ namespace mirror {
 // TODO: get global references for these
 Class* String::java_lang_String_ = NULL;
 
+constexpr bool String::kUseStringCompression;
+constexpr uint32_t String::kCompressedFlag;
+
 int32_t String::FastIndexOf(int32_t ch, int32_t start) {
   int32_t count = GetLength();
   if (start < 0) {
@@ -39,7 +42,15 @@ int32_t String::FastIndexOf(int32_t ch, int32_t start) {
   } else if (start > count) {
     start = count;
   }
-  const uint16_t* chars = GetCharArray()->GetData() + GetOffset();
+  if (IsCompressed()) {
+    if (ch < 0 || ch > 0xff) {
+      return -1;
+    }
+    const uint8_t* chars = GetValueCompressed();
+    const void* found = memchr(chars + start, ch, count - start);
+    return (found != nullptr) ? static_cast<const uint8_t*>(found) - chars : -1;
+  }
+  const uint16_t* chars = GetValue();
   const uint16_t* p = chars + start;
   const uint16_t* end = chars + count;
   while (p < end) {
@@ -50,6 +61,19 @@ int32_t String::FastIndexOf(int32_t ch, int32_t start) {
   return -1;
 }
 
+void String::GetChars(int32_t start, int32_t count, uint16_t* chars_out) {
+  DCHECK_LE(0, start);
+  DCHECK_LE(start + count, GetLength());
+  if (IsCompressed()) {
+    const uint8_t* chars = GetValueCompressed() + start;
+    for (int32_t i = 0; i < count; ++i) {
+      chars_out[i] = chars[i];
+    }
+  } else {
+    memcpy(chars_out, GetValue() + start, count * sizeof(uint16_t));
+  }
+}
+
 void String::SetClass(Class* java_lang_String) {
   CHECK(java_lang_String_ == NULL);
   CHECK(java_lang_String != NULL);
@@ -61,23 +85,41 @@ void String::ResetClass() {
   java_lang_String_ = NULL;
 }
 
+static int32_t ComputeStringHash(String* string) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (string->IsCompressed()) {
+    return ComputeLatin1Hash(string->GetValueCompressed(), string->GetLength());
+  }
+  return ComputeUtf16Hash(string->GetValue(), string->GetLength());
+}
+
 int32_t String::GetHashCode() {
   int32_t result = GetField32(OFFSET_OF_OBJECT_MEMBER(String, hash_code_));
   if (UNLIKELY(result == 0)) {
     ComputeHashCode();
   }
   result = GetField32(OFFSET_OF_OBJECT_MEMBER(String, hash_code_));
-  DCHECK(result != 0 || ComputeUtf16Hash(GetCharArray(), GetOffset(), GetLength()) == 0)
-          << ToModifiedUtf8() << " " << result;
+  DCHECK(result != 0 || ComputeStringHash(this) == 0) << ToModifiedUtf8() << " " << result;
   return result;
 }
 
 void String::ComputeHashCode() {
-  SetHashCode(ComputeUtf16Hash(GetCharArray(), GetOffset(), GetLength()));
+  SetHashCode(ComputeStringHash(this));
 }
 
 int32_t String::GetUtfLength() {
-  return CountUtf8Bytes(GetCharArray()->GetData() + GetOffset(), GetLength());
+  if (IsCompressed()) {
+    return CountLatin1Utf8Bytes(GetValueCompressed(), GetLength());
+  }
+  return CountUtf8Bytes(GetValue(), GetLength());
+}
+
+static bool IsLatin1(const uint16_t* chars, int32_t length) {
+  for (int32_t i = 0; i < length; ++i) {
+    if (chars[i] > 0xff) {
+      return false;
+    }
+  }
+  return true;
 }
 
 String* String::AllocFromUtf16(Thread* self,
@@ -85,15 +127,19 @@ String* String::AllocFromUtf16(Thread* self,
                                const uint16_t* utf16_data_in,
                                int32_t hash_code) {
   CHECK(utf16_data_in != nullptr || utf16_length == 0);
-  String* string = Alloc(self, utf16_length);
+  bool compressed = kUseStringCompression && IsLatin1(utf16_data_in, utf16_length);
+  String* string = Alloc(self, utf16_length, compressed);
   if (UNLIKELY(string == nullptr)) {
     return nullptr;
   }
-  CharArray* array = const_cast<CharArray*>(string->GetCharArray());
-  if (UNLIKELY(array == nullptr)) {
-    return nullptr;
+  if (compressed) {
+    uint8_t* chars = const_cast<uint8_t*>(string->GetValueCompressed());
+    for (int32_t i = 0; i < utf16_length; ++i) {
+      chars[i] = utf16_data_in[i];
+    }
+  } else {
+    memcpy(string->GetCharArray()->GetData(), utf16_data_in, utf16_length * sizeof(uint16_t));
   }
-  memcpy(array->GetData(), utf16_data_in, utf16_length * sizeof(uint16_t));
   if (hash_code != 0) {
     DCHECK_EQ(hash_code, ComputeUtf16Hash(utf16_data_in, utf16_length));
     string->SetHashCode(hash_code);
@@ -111,31 +157,45 @@ String* String::AllocFromModifiedUtf8(Thread* self, const char* utf) {
 
 String* String::AllocFromModifiedUtf8(Thread* self, int32_t utf16_length,
                                       const char* utf8_data_in) {
-  String* string = Alloc(self, utf16_length);
+  // Modified UTF-8 encodes every character outside of ASCII, and NUL, in more than one byte. Other
+  // Latin-1 strings are left uncompressed rather than decoding them twice.
+  bool compressed = kUseStringCompression &&
+      strlen(utf8_data_in) == static_cast<size_t>(utf16_length);
+  String* string = Alloc(self, utf16_length, compressed);
   if (UNLIKELY(string == nullptr)) {
     return nullptr;
   }
-  uint16_t* utf16_data_out =
-      const_cast<uint16_t*>(string->GetCharArray()->GetData());
-  ConvertModifiedUtf8ToUtf16(utf16_data_out, utf8_data_in);
+  if (compressed) {
+    memcpy(const_cast<uint8_t*>(string->GetValueCompressed()), utf8_data_in, utf16_length);
+  } else {
+    uint16_t* utf16_data_out =
+        const_cast<uint16_t*>(string->GetCharArray()->GetData());
+    ConvertModifiedUtf8ToUtf16(utf16_data_out, utf8_data_in);
+  }
   string->ComputeHashCode();
   return string;
 }
 
-String* String::Alloc(Thread* self, int32_t utf16_length) {
-  SirtRef<CharArray> array(self, CharArray::Alloc(self, utf16_length));
+String* String::Alloc(Thread* self, int32_t utf16_length, bool compressed) {
+  Array* new_array;
+  if (compressed) {
+    new_array = ByteArray::Alloc(self, utf16_length);
+  } else {
+    new_array = CharArray::Alloc(self, utf16_length);
+  }
+  SirtRef<Array> array(self, new_array);
   if (UNLIKELY(array.get() == nullptr)) {
     return nullptr;
   }
-  return Alloc(self, array);
+  return Alloc(self, array, compressed);
 }
 
-String* String::Alloc(Thread* self, const SirtRef<CharArray>& array) {
+String* String::Alloc(Thread* self, const SirtRef<Array>& array, bool compressed) {
   // Hold reference in case AllocObject causes GC.
   String* string = down_cast<String*>(GetJavaLangString()->AllocObject(self));
   if (LIKELY(string != nullptr)) {
     string->SetArray(array.get());
-    string->SetCount(array->GetLength());
+    string->SetCount(array->GetLength(), compressed);
   }
   return string;
 }
@@ -153,6 +213,10 @@ bool String::Equals(String* that) {
   } else {
     // Note: don't short circuit on hash code as we're presumably here as the
     // hash code was already equal
+    if (this->IsCompressed() && that->IsCompressed()) {
+      return memcmp(this->GetValueCompressed(), that->GetValueCompressed(),
+                    that->GetLength()) == 0;
+    }
     for (int32_t i = 0; i < that->GetLength(); ++i) {
       if (this->CharAt(i) != that->CharAt(i)) {
         return false;
@@ -198,10 +262,13 @@ bool String::Equals(const StringPiece& modified_utf8) {
 
 // Create a modified UTF-8 encoded std::string from a java/lang/String object.
 std::string String::ToModifiedUtf8() {
-  const uint16_t* chars = GetCharArray()->GetData() + GetOffset();
   size_t byte_count = GetUtfLength();
   std::string result(byte_count, static_cast<char>(0));
-  ConvertUtf16ToModifiedUtf8(&result[0], chars, GetLength());
+  if (IsCompressed()) {
+    ConvertLatin1ToModifiedUtf8(&result[0], GetValueCompressed(), GetLength());
+  } else {
+    ConvertUtf16ToModifiedUtf8(&result[0], GetValue(), GetLength());
+  }
   return result;
 }
 
@@ -236,8 +303,17 @@ int32_t String::CompareTo(String* rhs) {
   int rhsCount = rhs->GetLength();
   int countDiff = lhsCount - rhsCount;
   int minCount = (countDiff < 0) ? lhsCount : rhsCount;
-  const uint16_t* lhsChars = lhs->GetCharArray()->GetData() + lhs->GetOffset();
-  const uint16_t* rhsChars = rhs->GetCharArray()->GetData() + rhs->GetOffset();
+  if (UNLIKELY(lhs->IsCompressed() || rhs->IsCompressed())) {
+    for (int i = 0; i < minCount; ++i) {
+      int32_t diff = static_cast<int32_t>(lhs->CharAt(i)) - static_cast<int32_t>(rhs->CharAt(i));
+      if (diff != 0) {
+        return diff;
+      }
+    }
+    return countDiff;
+  }
+  const uint16_t* lhsChars = lhs->GetValue();
+  const uint16_t* rhsChars = rhs->GetValue();
   int otherRes = MemCmp16(lhsChars, rhsChars, minCount);
   if (otherRes != 0) {
     return otherRes;
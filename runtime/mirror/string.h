@@ -34,6 +34,13 @@ namespace mirror {
 // C++ mirror of java.lang.String
 class MANAGED String : public Object {
  public:
+  // Strings whose characters all fit in 8 bits may be stored compressed, one Latin-1 byte per
+  // character in a byte[] value array, which halves the heap taken by mostly ASCII strings. The
+  // top bit of count_ flags a compressed string. This needs the matching java.lang.String, which
+  // reads the value array and the count itself, so it's off by default.
+  static constexpr bool kUseStringCompression = false;
+  static constexpr uint32_t kCompressedFlag = 0x80000000U;
+
   static MemberOffset CountOffset() {
     return OFFSET_OF_OBJECT_MEMBER(String, count_);
   }
@@ -46,8 +53,27 @@ class MANAGED String : public Object {
     return OFFSET_OF_OBJECT_MEMBER(String, offset_);
   }
 
+  // The value array, a CharArray or a ByteArray when the string is compressed.
+  Array* GetArray() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The value array of an uncompressed string.
   CharArray* GetCharArray() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  bool IsCompressed() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return kUseStringCompression &&
+        (static_cast<uint32_t>(GetField32(CountOffset())) & kCompressedFlag) != 0;
+  }
+
+  // The characters of an uncompressed string.
+  const uint16_t* GetValue() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The Latin-1 characters of a compressed string.
+  const uint8_t* GetValueCompressed() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copies count characters from index start, widening the characters of a compressed string.
+  void GetChars(int32_t start, int32_t count, uint16_t* chars_out)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   int32_t GetOffset() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     int32_t result = GetField32(OffsetOffset());
     DCHECK_LE(0, result);
@@ -120,10 +146,15 @@ class MANAGED String : public Object {
     SetField32<false, false>(OFFSET_OF_OBJECT_MEMBER(String, hash_code_), new_hash_code);
   }
 
-  void SetCount(int32_t new_count) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  void SetCount(int32_t new_count, bool compressed = false)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     // Count is invariant so use non-transactional mode. Also disable check as we may run inside
     // a transaction.
     DCHECK_LE(0, new_count);
+    DCHECK(!compressed || kUseStringCompression);
+    if (compressed) {
+      new_count = static_cast<int32_t>(static_cast<uint32_t>(new_count) | kCompressedFlag);
+    }
     SetField32<false, false>(OFFSET_OF_OBJECT_MEMBER(String, count_), new_count);
   }
 
@@ -134,13 +165,13 @@ class MANAGED String : public Object {
     SetField32<false>(OFFSET_OF_OBJECT_MEMBER(String, offset_), new_offset);
   }
 
-  static String* Alloc(Thread* self, int32_t utf16_length)
+  static String* Alloc(Thread* self, int32_t utf16_length, bool compressed = false)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  static String* Alloc(Thread* self, const SirtRef<CharArray>& array)
+  static String* Alloc(Thread* self, const SirtRef<Array>& array, bool compressed)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void SetArray(CharArray* new_array) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SetArray(Array* new_array) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Field order required by test "ValidateFieldOrderOfJavaCppUnionClasses".
   HeapReference<CharArray> array_;
@@ -16,6 +16,9 @@
 
 #include "monitor.h"
 
+#include <sched.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "base/mutex.h"
@@ -23,6 +26,7 @@
 #include "class_linker.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
+#include "lock_profiler.h"
 #include "lock_word-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class-inl.h"
@@ -79,14 +83,21 @@ void Monitor::Init(uint32_t lock_profiling_threshold, bool (*is_sensitive_thread
   is_sensitive_thread_hook_ = is_sensitive_thread_hook;
 }
 
+bool Monitor::IsSamplingOwners() {
+  return lock_profiling_threshold_ != 0 || LockProfiler::IsEnabled();
+}
+
 Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
     : monitor_lock_("a monitor lock", kMonitorLock),
       monitor_contenders_("monitor contenders", monitor_lock_),
       num_waiters_(0),
       owner_(owner),
       lock_count_(0),
+      spin_limit_(kInitialMonitorSpins),
+      num_contentions_(0),
       obj_(obj),
       wait_set_(NULL),
+      notified_set_(NULL),
       hash_code_(hash_code),
       locking_method_(NULL),
       locking_dex_pc_(0),
@@ -116,7 +127,30 @@ bool Monitor::Install(Thread* self) {
     case LockWord::kThinLocked: {
       CHECK_EQ(owner_->GetThreadId(), lw.ThinLockOwner());
       lock_count_ = lw.ThinLockCount();
-      break;
+      // Take over the displaced hash code, if any. The hash code lock is held until the lock word
+      // is published so that GetThinOrUnlockedHashCode doesn't displace one meanwhile.
+      MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+      MutexLock mu2(self, monitor_list->hash_codes_lock_);
+      auto it = monitor_list->hash_codes_.find(obj_);
+      const bool displaced = it != monitor_list->hash_codes_.end();
+      if (displaced) {
+        CHECK(!HasHashCode());
+        hash_code_ = it->second;
+      }
+      LockWord fat(this);
+      bool success = obj_->CasLockWord(lw, fat);
+      if (!success) {
+        if (displaced) {
+          hash_code_ = 0;
+        }
+      } else if (displaced) {
+        monitor_list->hash_codes_.erase(it);
+        --monitor_list->num_hash_codes_;
+      }
+      if (success && IsSamplingOwners()) {
+        locking_method_ = owner_->GetCurrentMethod(&locking_dex_pc_);
+      }
+      return success;
     }
     case LockWord::kHashCode: {
       CHECK_EQ(hash_code_, static_cast<int32_t>(lw.GetHashCode()));
@@ -139,7 +173,7 @@ bool Monitor::Install(Thread* self) {
   // Publish the updated lock word, which may race with other threads.
   bool success = obj_->CasLockWord(lw, fat);
   // Lock profiling.
-  if (success && owner_ != nullptr && lock_profiling_threshold_ != 0) {
+  if (success && owner_ != nullptr && IsSamplingOwners()) {
     locking_method_ = owner_->GetCurrentMethod(&locking_dex_pc_);
   }
   return success;
@@ -150,68 +184,129 @@ Monitor::~Monitor() {
   // Deflated monitors have a null object.
 }
 
-/*
- * Links a thread into a monitor's wait set.  The monitor lock must be
- * held by the caller of this routine.
- */
-void Monitor::AppendToWaitSet(Thread* thread) {
-  DCHECK(owner_ == Thread::Current());
+// Appends thread to the list of threads linked through their wait_next_ starting at *head.
+static void AppendThread(Thread** head, Thread* thread) {
   DCHECK(thread != NULL);
   DCHECK(thread->GetWaitNext() == nullptr) << thread->GetWaitNext();
-  if (wait_set_ == NULL) {
-    wait_set_ = thread;
+  if (*head == NULL) {
+    *head = thread;
     return;
   }
 
   // push_back.
-  Thread* t = wait_set_;
+  Thread* t = *head;
   while (t->GetWaitNext() != nullptr) {
     t = t->GetWaitNext();
   }
   t->SetWaitNext(thread);
 }
 
-/*
- * Unlinks a thread from a monitor's wait set.  The monitor lock must
- * be held by the caller of this routine.
- */
-void Monitor::RemoveFromWaitSet(Thread *thread) {
-  DCHECK(owner_ == Thread::Current());
+// Unlinks thread from the list starting at *head. Returns false if it isn't in the list.
+static bool UnlinkThread(Thread** head, Thread* thread) {
   DCHECK(thread != NULL);
-  if (wait_set_ == NULL) {
-    return;
+  if (*head == NULL) {
+    return false;
   }
-  if (wait_set_ == thread) {
-    wait_set_ = thread->GetWaitNext();
+  if (*head == thread) {
+    *head = thread->GetWaitNext();
     thread->SetWaitNext(nullptr);
-    return;
+    return true;
   }
 
-  Thread* t = wait_set_;
+  Thread* t = *head;
   while (t->GetWaitNext() != NULL) {
     if (t->GetWaitNext() == thread) {
       t->SetWaitNext(thread->GetWaitNext());
       thread->SetWaitNext(nullptr);
-      return;
+      return true;
     }
     t = t->GetWaitNext();
   }
+  return false;
+}
+
+/*
+ * Links a thread into a monitor's wait set.  The monitor lock must be
+ * held by the caller of this routine.
+ */
+void Monitor::AppendToWaitSet(Thread* thread) {
+  DCHECK(owner_ == Thread::Current());
+  AppendThread(&wait_set_, thread);
+}
+
+/*
+ * Unlinks a thread from a monitor's wait set, or from the notified set
+ * if it was notified but not woken yet.  The monitor lock must be held
+ * by the caller of this routine.
+ */
+void Monitor::RemoveFromWaitSet(Thread *thread) {
+  DCHECK(owner_ == Thread::Current());
+  if (!UnlinkThread(&wait_set_, thread)) {
+    UnlinkThread(&notified_set_, thread);
+  }
+}
+
+void Monitor::WakeNotifiedThread(Thread* self) {
+  DCHECK(owner_ == nullptr);
+  while (notified_set_ != NULL) {
+    Thread* thread = notified_set_;
+    notified_set_ = thread->GetWaitNext();
+    thread->SetWaitNext(nullptr);
+
+    // Skip the threads which timed out or were interrupted meanwhile.
+    MutexLock mu(self, *thread->GetWaitMutex());
+    if (thread->GetWaitMonitor() != nullptr) {
+      thread->GetWaitConditionVariable()->Signal(self);
+      return;
+    }
+  }
 }
 
 void Monitor::SetObject(mirror::Object* object) {
   obj_ = object;
 }
 
+// Number of thin lock contention attempts that spin, the last one for 2^kThinLockBackoffSpins
+// pauses, before the remaining ones yield.
+static constexpr size_t kThinLockBackoffSpins = 8;
+
+bool Monitor::SpinOnOwner(Thread* self) {
+  const size_t spin_limit = spin_limit_;
+  bool released = false;
+  monitor_lock_.Unlock(self);
+  for (size_t i = 0; i < spin_limit; ++i) {
+    if (owner_ == nullptr) {
+      released = true;
+      break;
+    }
+    // We are runnable, don't hold up a suspension or a checkpoint.
+    if (UNLIKELY(self->TestAllFlags())) {
+      break;
+    }
+    SpinPause();
+  }
+  monitor_lock_.Lock(self);
+  if (released && owner_ == nullptr) {
+    spin_limit_ = std::min(spin_limit_ * 2, static_cast<size_t>(kMaxMonitorSpins));
+    return true;
+  }
+  spin_limit_ = std::max(spin_limit_ / 2, static_cast<size_t>(kMinMonitorSpins));
+  return released;
+}
+
 void Monitor::Lock(Thread* self) {
   MutexLock mu(self, monitor_lock_);
+  bool spun = false;
   while (true) {
     if (owner_ == nullptr) {  // Unowned.
       owner_ = self;
       CHECK_EQ(lock_count_, 0);
       // When debugging, save the current monitor holder for future
       // acquisition failures to use in sampled logging.
-      if (lock_profiling_threshold_ != 0) {
+      if (IsSamplingOwners()) {
         locking_method_ = self->GetCurrentMethod(&locking_dex_pc_);
+      } else {
+        locking_method_ = nullptr;
       }
       return;
     } else if (owner_ == self) {  // Recursive.
@@ -219,8 +314,20 @@ void Monitor::Lock(Thread* self) {
       return;
     }
     // Contended.
+    if (!spun) {
+      ++num_contentions_;
+      Runtime::Current()->GetMonitorList()->num_contentions_.FetchAndAdd(1);
+      // Short critical sections are usually over before blocking would even be done, spin first.
+      // Only once per acquisition so that a monitor handed around doesn't keep us spinning.
+      spun = true;
+      if (SpinOnOwner(self)) {
+        continue;
+      }
+    }
     const bool log_contention = (lock_profiling_threshold_ != 0);
-    uint64_t wait_start_ms = log_contention ? 0 : MilliTime();
+    const bool profile_contention = LockProfiler::IsEnabled();
+    uint64_t wait_start_ms = log_contention ? MilliTime() : 0;
+    uint64_t wait_start_ns = profile_contention ? NanoTime() : 0;
     mirror::ArtMethod* owners_method = locking_method_;
     uint32_t owners_dex_pc = locking_dex_pc_;
     // Do this before releasing the lock so that we don't get deflated.
@@ -251,6 +358,12 @@ void Monitor::Lock(Thread* self) {
       }
       self->SetMonitorEnterObject(nullptr);
     }
+    if (profile_contention) {
+      uint32_t dex_pc;
+      mirror::ArtMethod* method = self->GetCurrentMethod(&dex_pc);
+      LockProfiler::RecordMonitorContention(owners_method, owners_dex_pc, method, dex_pc,
+                                            NanoTime() - wait_start_ns);
+    }
     monitor_lock_.Lock(self);  // Reacquire locks in order.
     --num_waiters_;
   }
@@ -354,8 +467,9 @@ bool Monitor::Unlock(Thread* self) {
       owner_ = NULL;
       locking_method_ = NULL;
       locking_dex_pc_ = 0;
-      // Wake a contender.
+      // Wake a contender, and the next notified waiter which will contend with it.
       monitor_contenders_.Signal(self);
+      WakeNotifiedThread(self);
     } else {
       --lock_count_;
     }
@@ -440,6 +554,8 @@ void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
   locking_method_ = NULL;
   uintptr_t saved_dex_pc = locking_dex_pc_;
   locking_dex_pc_ = 0;
+  // Hand the monitor over to a notified thread, before taking our own wait mutex.
+  WakeNotifiedThread(self);
 
   /*
    * Update thread state. If the GC wakes up, it'll ignore us, knowing
@@ -540,7 +656,8 @@ void Monitor::Notify(Thread* self) {
     ThrowIllegalMonitorStateExceptionF("object not locked by thread before notify()");
     return;
   }
-  // Signal the first waiting thread in the wait set.
+  // Move the first waiting thread in the wait set to the notified set. It is woken when we release
+  // the monitor, waking it now would only have it block on the monitor we hold.
   while (wait_set_ != NULL) {
     Thread* thread = wait_set_;
     wait_set_ = thread->GetWaitNext();
@@ -549,7 +666,7 @@ void Monitor::Notify(Thread* self) {
     // Check to see if the thread is still waiting.
     MutexLock mu(self, *thread->GetWaitMutex());
     if (thread->GetWaitMonitor() != nullptr) {
-      thread->GetWaitConditionVariable()->Signal(self);
+      AppendThread(&notified_set_, thread);
       return;
     }
   }
@@ -563,12 +680,19 @@ void Monitor::NotifyAll(Thread* self) {
     ThrowIllegalMonitorStateExceptionF("object not locked by thread before notifyAll()");
     return;
   }
-  // Signal all threads in the wait set.
-  while (wait_set_ != NULL) {
-    Thread* thread = wait_set_;
-    wait_set_ = thread->GetWaitNext();
-    thread->SetWaitNext(nullptr);
-    thread->Notify();
+  // Move all threads in the wait set to the notified set. Rather than waking them all at once to
+  // contend for the monitor, each release of the monitor wakes the next one.
+  if (wait_set_ != NULL) {
+    if (notified_set_ == NULL) {
+      notified_set_ = wait_set_;
+    } else {
+      Thread* t = notified_set_;
+      while (t->GetWaitNext() != nullptr) {
+        t = t->GetWaitNext();
+      }
+      t->SetWaitNext(wait_set_);
+    }
+    wait_set_ = NULL;
   }
 }
 
@@ -585,16 +709,24 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
     if (monitor->num_waiters_ > 0) {
       return false;
     }
+    // Keep the monitors contended since the last deflation, they would soon be inflated again.
+    if (monitor->num_contentions_ != 0) {
+      monitor->num_contentions_ = 0;
+      return false;
+    }
     Thread* owner = monitor->owner_;
     if (owner != nullptr) {
-      // Can't deflate if we are locked and have a hash code.
-      if (monitor->HasHashCode()) {
-        return false;
-      }
       // Can't deflate if our lock count is too high.
       if (monitor->lock_count_ > LockWord::kThinLockMaxCount) {
         return false;
       }
+      // The thin lock has no room for the hash code, displace it.
+      if (monitor->HasHashCode()) {
+        MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+        MutexLock mu2(self, monitor_list->hash_codes_lock_);
+        monitor_list->hash_codes_.Put(obj, monitor->GetHashCode());
+        ++monitor_list->num_hash_codes_;
+      }
       // Deflate to a thin lock.
       obj->SetLockWord(LockWord::FromThinLockId(owner->GetThreadId(), monitor->lock_count_), false);
       VLOG(monitor) << "Deflated " << obj << " to thin lock " << owner->GetTid() << " / "
@@ -614,6 +746,81 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
   return true;
 }
 
+bool Monitor::MayHaveDisplacedHashCodes() {
+  // Pairs with the barrier after displacing a hash code in GetThinOrUnlockedHashCode: if the
+  // object's lock word was read unlocked after the hash code was displaced, so is the count.
+  QuasiAtomic::MembarLoadLoad();
+  return Runtime::Current()->GetMonitorList()->num_hash_codes_.Load() != 0;
+}
+
+bool Monitor::GetThinOrUnlockedHashCode(Thread* self, mirror::Object* obj, LockWord lock_word,
+                                        int32_t* hash_code) {
+  DCHECK(lock_word.GetState() == LockWord::kUnlocked ||
+         lock_word.GetState() == LockWord::kThinLocked) << lock_word.GetState();
+  MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+  MutexLock mu(self, monitor_list->hash_codes_lock_);
+  auto it = monitor_list->hash_codes_.find(obj);
+  if (lock_word.GetState() == LockWord::kUnlocked) {
+    // Put the hash code in the lock word, moving back the displaced one if there is one.
+    const bool displaced = it != monitor_list->hash_codes_.end();
+    const int32_t hash = displaced ? it->second : mirror::Object::GenerateIdentityHashCode();
+    if (!obj->CasLockWord(lock_word, LockWord::FromHashCode(hash))) {
+      return false;
+    }
+    if (displaced) {
+      monitor_list->hash_codes_.erase(it);
+      --monitor_list->num_hash_codes_;
+    }
+    *hash_code = hash;
+    return true;
+  }
+  // Thin locked. A displaced hash code stays valid as long as the object is unlocked or thin
+  // locked, which it can only stop being with the hash code lock held.
+  if (it != monitor_list->hash_codes_.end()) {
+    *hash_code = it->second;
+    return true;
+  }
+  const int32_t hash = mirror::Object::GenerateIdentityHashCode();
+  monitor_list->hash_codes_.Put(obj, hash);
+  ++monitor_list->num_hash_codes_;
+  // Make the count visible before checking the lock word, see MayHaveDisplacedHashCodes. The
+  // owner may have unlocked the object since the lock word was read, not inflated it since the
+  // inflation holds the hash code lock.
+  QuasiAtomic::MembarStoreLoad();
+  LockWord current = obj->GetLockWord(true);
+  if (current.GetState() == LockWord::kThinLocked) {
+    *hash_code = hash;
+    return true;
+  }
+  // Unlocked meanwhile, a concurrent IdentityHashCode may have missed the count and be about to
+  // install its own hash code. Only the one whose lock word CAS succeeds wins.
+  const bool installed = current.GetState() == LockWord::kUnlocked &&
+      obj->CasLockWord(current, LockWord::FromHashCode(hash));
+  monitor_list->hash_codes_.erase(obj);
+  --monitor_list->num_hash_codes_;
+  if (!installed) {
+    return false;
+  }
+  *hash_code = hash;
+  return true;
+}
+
+bool Monitor::ThinLockHashed(Thread* self, mirror::Object* obj, LockWord hash_word) {
+  DCHECK_EQ(hash_word.GetState(), LockWord::kHashCode);
+  MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+  MutexLock mu(self, monitor_list->hash_codes_lock_);
+  // Displace the hash code before publishing the thin lock, a concurrent hash code query could
+  // otherwise find neither.
+  monitor_list->hash_codes_.Put(obj, hash_word.GetHashCode());
+  ++monitor_list->num_hash_codes_;
+  if (obj->CasLockWord(hash_word, LockWord::FromThinLockId(self->GetThreadId(), 0))) {
+    return true;
+  }
+  monitor_list->hash_codes_.erase(obj);
+  --monitor_list->num_hash_codes_;
+  return false;
+}
+
 /*
  * Changes the shape of a monitor from thin to fat, preserving the internal lock state. The calling
  * thread must own the lock or the owner must be suspended. There's a race with other threads
@@ -710,7 +917,15 @@ mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
           contention_count++;
           Runtime* runtime = Runtime::Current();
           if (contention_count <= runtime->GetMaxSpinsBeforeThinkLockInflation()) {
-            NanoSleep(1000);  // Sleep for 1us and re-attempt.
+            // Thin locks have nowhere to learn a spin count, back off exponentially instead: spin
+            // on the lock word for the first attempts, then yield the CPU to the owner.
+            if (contention_count <= kThinLockBackoffSpins) {
+              for (size_t i = 0; i < (1U << contention_count); ++i) {
+                SpinPause();
+              }
+            } else {
+              sched_yield();
+            }
           } else {
             contention_count = 0;
             InflateThinLocked(self, sirt_obj, lock_word, 0);
@@ -724,8 +939,11 @@ mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
         return sirt_obj.get();  // Success!
       }
       case LockWord::kHashCode:
-        // Inflate with the existing hashcode.
-        Inflate(self, nullptr, sirt_obj.get(), lock_word.GetHashCode());
+        // Keep the lock thin, the hash code moves out of the lock word.
+        if (ThinLockHashed(self, sirt_obj.get(), lock_word)) {
+          QuasiAtomic::MembarLoadLoad();
+          return sirt_obj.get();  // Success!
+        }
         continue;  // Start from the beginning.
       default: {
         LOG(FATAL) << "Invalid monitor state " << lock_word.GetState();
@@ -1060,7 +1278,9 @@ uint32_t Monitor::GetOwnerThreadId() {
 
 MonitorList::MonitorList()
     : allow_new_monitors_(true), monitor_list_lock_("MonitorList lock", kMonitorListLock),
-      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_) {
+      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_),
+      hash_codes_lock_("MonitorList hash codes lock", kMonitorHashCodesLock),
+      num_hash_codes_(0), num_inflations_(0), num_contentions_(0) {
 }
 
 MonitorList::~MonitorList() {
@@ -1087,9 +1307,15 @@ void MonitorList::Add(Monitor* m) {
     monitor_add_condition_.WaitHoldingLocks(self);
   }
   list_.push_front(m);
+  num_inflations_.FetchAndAdd(1);
 }
 
 void MonitorList::SweepMonitorList(IsMarkedCallback* callback, void* arg) {
+  SweepMonitors(callback, arg);
+  SweepHashCodes(callback, arg);
+}
+
+void MonitorList::SweepMonitors(IsMarkedCallback* callback, void* arg) {
   MutexLock mu(Thread::Current(), monitor_list_lock_);
   for (auto it = list_.begin(); it != list_.end(); ) {
     Monitor* m = *it;
@@ -1118,10 +1344,30 @@ static mirror::Object* MonitorDeflateCallback(mirror::Object* object, void* arg)
   return object;  // Monitor was not deflated.
 }
 
+void MonitorList::SweepHashCodes(IsMarkedCallback* callback, void* arg) {
+  MutexLock mu(Thread::Current(), hash_codes_lock_);
+  SafeMap<mirror::Object*, int32_t> swept;
+  for (const auto& entry : hash_codes_) {
+    mirror::Object* new_obj = callback(entry.first, arg);
+    if (new_obj == nullptr) {
+      continue;
+    }
+    // An object that is no longer locked can have its hash code back in its lock word.
+    LockWord lw(new_obj->GetLockWord(true));
+    if (lw.GetState() == LockWord::kUnlocked &&
+        new_obj->CasLockWord(lw, LockWord::FromHashCode(entry.second))) {
+      continue;
+    }
+    swept.Put(new_obj, entry.second);
+  }
+  hash_codes_.swap(swept);
+  num_hash_codes_ = static_cast<int32_t>(hash_codes_.size());
+}
+
 void MonitorList::DeflateMonitors() {
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertExclusiveHeld(self);
-  SweepMonitorList(MonitorDeflateCallback, reinterpret_cast<Thread*>(self));
+  SweepMonitors(MonitorDeflateCallback, reinterpret_cast<Thread*>(self));
 }
 
 MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(NULL), entry_count_(0) {
@@ -1146,6 +1392,9 @@ MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(NULL), entry_count_(0) {
       for (Thread* waiter = mon->wait_set_; waiter != NULL; waiter = waiter->GetWaitNext()) {
         waiters_.push_back(waiter);
       }
+      for (Thread* waiter = mon->notified_set_; waiter != NULL; waiter = waiter->GetWaitNext()) {
+        waiters_.push_back(waiter);
+      }
       break;
     }
   }
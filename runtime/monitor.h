@@ -27,6 +27,7 @@
 #include "atomic.h"
 #include "base/mutex.h"
 #include "object_callbacks.h"
+#include "safe_map.h"
 #include "thread_state.h"
 
 namespace art {
@@ -48,6 +49,13 @@ class Monitor {
   // a lock word. See Runtime::max_spins_before_thin_lock_inflation_.
   constexpr static size_t kDefaultMaxSpinsBeforeThinLockInflation = 50;
 
+  // Bounds and initial value of the number of pauses a contender spins on the owner of an inflated
+  // monitor before blocking. Each monitor doubles its limit when spinning got it the lock and
+  // halves it when it didn't.
+  constexpr static size_t kMinMonitorSpins = 16;
+  constexpr static size_t kInitialMonitorSpins = 128;
+  constexpr static size_t kMaxMonitorSpins = 1024;
+
   ~Monitor();
 
   static bool IsSensitiveThread();
@@ -120,6 +128,18 @@ class Monitor {
   static bool Deflate(Thread* self, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Return the identity hash code of obj, whose lock word lock_word is unlocked or thin locked,
+  // without inflating it. A thin locked object has no room for a hash code in its lock word, its
+  // hash code is displaced to a table of the monitor list until the object is unlocked and hashed
+  // again, or inflated. Returns false if the lock word changed meanwhile.
+  static bool GetThinOrUnlockedHashCode(Thread* self, mirror::Object* obj, LockWord lock_word,
+                                        int32_t* hash_code)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether an unlocked object may have a displaced hash code, which GetThinOrUnlockedHashCode
+  // would need to move back into the lock word. Cheap, doesn't lock.
+  static bool MayHaveDisplacedHashCodes();
+
  private:
   explicit Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -133,6 +153,10 @@ class Monitor {
   void AppendToWaitSet(Thread* thread) EXCLUSIVE_LOCKS_REQUIRED(monitor_lock_);
   void RemoveFromWaitSet(Thread* thread) EXCLUSIVE_LOCKS_REQUIRED(monitor_lock_);
 
+  // Wakes the first thread of the notified set which is still waiting. Called as the monitor is
+  // released.
+  void WakeNotifiedThread(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(monitor_lock_);
+
   static void Inflate(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -174,6 +198,20 @@ class Monitor {
 
   uint32_t GetOwnerThreadId();
 
+  // Spins until the owner releases the monitor or for spin_limit_ pauses, and adapts spin_limit_
+  // to the outcome. Returns whether the monitor was seen released. Gives up monitor_lock_ while
+  // spinning.
+  bool SpinOnOwner(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(monitor_lock_);
+
+  // Thin lock obj, whose lock word hash_word holds its hash code, by displacing the hash code
+  // rather than inflating. Returns false if the lock word changed meanwhile.
+  static bool ThinLockHashed(Thread* self, mirror::Object* obj, LockWord hash_word)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether to sample the owner's method and dex pc on acquisition, for the contention logging or
+  // the lock profiler.
+  static bool IsSamplingOwners();
+
   static bool (*is_sensitive_thread_hook_)();
   static uint32_t lock_profiling_threshold_;
 
@@ -190,12 +228,24 @@ class Monitor {
   // Owner's recursive lock depth.
   int lock_count_ GUARDED_BY(monitor_lock_);
 
+  // Learned number of pauses to spin on the owner before blocking, see kInitialMonitorSpins.
+  size_t spin_limit_ GUARDED_BY(monitor_lock_);
+
+  // Contended acquisitions since the last deflation. A recently contended monitor is not deflated
+  // since it would likely need to be inflated again, which suspends the owner.
+  size_t num_contentions_ GUARDED_BY(monitor_lock_);
+
   // What object are we part of.
   mirror::Object* obj_;
 
   // Threads currently waiting on this monitor.
   Thread* wait_set_ GUARDED_BY(monitor_lock_);
 
+  // Threads notified but still blocked in Wait, in the order of their notification. Each release
+  // of the monitor wakes one, so that a NotifyAll doesn't wake all the waiters at once only for
+  // them to contend for the monitor.
+  Thread* notified_set_ GUARDED_BY(monitor_lock_);
+
   // Stored object hash code, generated lazily by GetHashCode.
   AtomicInteger hash_code_;
 
@@ -221,14 +271,32 @@ class MonitorList {
 
   void Add(Monitor* m);
 
+  // Sweep the monitors and the displaced hash codes.
   void SweepMonitorList(IsMarkedCallback* callback, void* arg)
-      LOCKS_EXCLUDED(monitor_list_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+      LOCKS_EXCLUDED(monitor_list_lock_, hash_codes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DisallowNewMonitors() LOCKS_EXCLUDED(monitor_list_lock_);
   void AllowNewMonitors() LOCKS_EXCLUDED(monitor_list_lock_);
   void DeflateMonitors() LOCKS_EXCLUDED(monitor_list_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Number of monitors inflated since startup.
+  int32_t GetInflationCount() const {
+    return num_inflations_.Load();
+  }
+
+  // Number of monitor acquisitions since startup which found the monitor owned by another thread.
+  int32_t GetContentionCount() const {
+    return num_contentions_.Load();
+  }
+
  private:
+  void SweepMonitors(IsMarkedCallback* callback, void* arg)
+      LOCKS_EXCLUDED(monitor_list_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Also moves the hash codes of the objects which are no longer locked back to their lock words.
+  void SweepHashCodes(IsMarkedCallback* callback, void* arg)
+      LOCKS_EXCLUDED(hash_codes_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // During sweeping we may free an object and on a separate thread have an object created using
   // the newly freed memory. That object may then have its lock-word inflated and a monitor created.
   // If we allow new monitor registration during sweeping this monitor may be incorrectly freed as
@@ -238,6 +306,18 @@ class MonitorList {
   ConditionVariable monitor_add_condition_ GUARDED_BY(monitor_list_lock_);
   std::list<Monitor*> list_ GUARDED_BY(monitor_list_lock_);
 
+  // The identity hash codes displaced from the lock words of unlocked or thin locked objects. An
+  // object leaves these states with the lock held, that is when it gets a hash code lock word or
+  // an inflated monitor, which then takes over the hash code.
+  Mutex hash_codes_lock_;
+  SafeMap<mirror::Object*, int32_t> hash_codes_ GUARDED_BY(hash_codes_lock_);
+  // The size of hash_codes_, read without the lock to skip looking into the empty table.
+  AtomicInteger num_hash_codes_;
+
+  // Counters read by the metrics page.
+  AtomicInteger num_inflations_;
+  AtomicInteger num_contentions_;
+
   friend class Monitor;
   DISALLOW_COPY_AND_ASSIGN(MonitorList);
 };
@@ -159,10 +159,7 @@ static void DexFile_closeDexFile(JNIEnv* env, jclass, jlong cookie) {
     return;
   }
   ScopedObjectAccess soa(env);
-  if (Runtime::Current()->GetClassLinker()->IsDexFileRegistered(*dex_file)) {
-    return;
-  }
-  delete dex_file;
+  Runtime::Current()->GetClassLinker()->CloseDexFile(dex_file);
 }
 
 static jclass DexFile_defineClassNative(JNIEnv* env, jclass, jstring javaName, jobject javaLoader,
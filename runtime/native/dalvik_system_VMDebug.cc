@@ -17,9 +17,15 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
 #include "class_linker.h"
 #include "common_throws.h"
 #include "debugger.h"
+#include "gc/heap.h"
+#include "gc/reference_processor.h"
 #include "gc/space/bump_pointer_space.h"
 #include "gc/space/dlmalloc_space.h"
 #include "gc/space/large_object_space.h"
@@ -27,9 +33,12 @@
 #include "gc/space/zygote_space.h"
 #include "hprof/hprof.h"
 #include "jni_internal.h"
+#include "lock_profiler.h"
 #include "mirror/class.h"
 #include "ScopedUtfChars.h"
 #include "scoped_fast_native_object_access.h"
+#include "signal_sampler.h"
+#include "thread_list.h"
 #include "toStringArray.h"
 #include "trace.h"
 
@@ -205,11 +214,13 @@ static void VMDebug_dumpHprofData(JNIEnv* env, jclass, jstring javaFilename, job
     }
   }
 
-  hprof::DumpHeap(filename.c_str(), fd, false);
+  // A dump named like a gzip file is compressed.
+  hprof::DumpHeap(filename.c_str(), fd, false, EndsWith(filename, ".gz"),
+                  Runtime::Current()->IsHeapDumpInChild());
 }
 
 static void VMDebug_dumpHprofDataDdms(JNIEnv*, jclass) {
-  hprof::DumpHeap("[DDMS]", -1, true);
+  hprof::DumpHeap("[DDMS]", -1, true, false, false);
 }
 
 static void VMDebug_dumpReferenceTables(JNIEnv* env, jclass) {
@@ -222,6 +233,51 @@ static void VMDebug_dumpReferenceTables(JNIEnv* env, jclass) {
   LOG(INFO) << "---";
 }
 
+static void VMDebug_startLockProfiling(JNIEnv*, jclass) {
+  LockProfiler::Start();
+}
+
+static void VMDebug_stopLockProfiling(JNIEnv*, jclass) {
+  LockProfiler::Stop();
+}
+
+static jstring VMDebug_dumpLockProfile(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  LockProfiler::Dump(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+static jboolean VMDebug_startSignalSampling(JNIEnv*, jclass, jint intervalUs) {
+  if (intervalUs <= 0) {
+    return JNI_FALSE;
+  }
+  return SignalSampler::Start(intervalUs) ? JNI_TRUE : JNI_FALSE;
+}
+
+static void VMDebug_stopSignalSampling(JNIEnv*, jclass) {
+  SignalSampler::Stop();
+}
+
+static jboolean VMDebug_dumpSignalSamples(JNIEnv* env, jclass, jstring javaFilename) {
+  ScopedUtfChars filename(env, javaFilename);
+  if (filename.c_str() == NULL) {
+    return JNI_FALSE;
+  }
+  std::ofstream os(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!os) {
+    PLOG(WARNING) << "Failed to open " << filename.c_str();
+    return JNI_FALSE;
+  }
+  SignalSampler::Dump(os);
+  return os.good() ? JNI_TRUE : JNI_FALSE;
+}
+
+static jstring VMDebug_dumpSafepointStats(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  Runtime::Current()->GetThreadList()->GetSafepointStats()->Dump(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
 static void VMDebug_crash(JNIEnv*, jclass) {
   LOG(FATAL) << "Crashing runtime on request";
 }
@@ -309,13 +365,66 @@ static void VMDebug_getHeapSpaceStats(JNIEnv* env, jclass, jlongArray data) {
   env->ReleasePrimitiveArrayCritical(data, arr, 0);
 }
 
+/*
+ * Fills data with the finalization backlog: the objects waiting for their finalizer, the objects
+ * scheduled for finalization and the objects finalized since the runtime started. The finalizer
+ * throughput is the difference of the last value between two calls.
+ */
+static void VMDebug_getFinalizerStats(JNIEnv* env, jclass, jlongArray data) {
+  uint64_t pending;
+  uint64_t enqueued;
+  {
+    ScopedObjectAccess soa(env);
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    // Read the total first, objects enqueued after it may be counted as pending.
+    enqueued = heap->GetReferenceProcessor()->GetFinalizersEnqueued();
+    pending = heap->CountPendingFinalizers();
+  }
+  if (env->GetArrayLength(data) < 3) {
+    return;
+  }
+  jlong* arr = reinterpret_cast<jlong*>(env->GetPrimitiveArrayCritical(data, 0));
+  if (arr == nullptr) {
+    return;
+  }
+  pending = std::min(pending, enqueued);
+  arr[0] = pending;
+  arr[1] = enqueued;
+  arr[2] = enqueued - pending;
+  env->ReleasePrimitiveArrayCritical(data, arr, 0);
+}
+
+/*
+ * Fills data with the GC statistics of each GC cause followed by the allocation stalls, in the
+ * layout of Heap::GetGcCauseStats. Telling whether jank comes from the GC pauses or from the
+ * allocations waiting for a GC takes the difference of two calls.
+ */
+static void VMDebug_getGcCauseStats(JNIEnv* env, jclass, jlongArray data) {
+  uint64_t stats[gc::Heap::kGcCauseStatsLength];
+  Runtime::Current()->GetHeap()->GetGcCauseStats(stats);
+  if (env->GetArrayLength(data) < static_cast<jsize>(gc::Heap::kGcCauseStatsLength)) {
+    return;
+  }
+  jlong* arr = reinterpret_cast<jlong*>(env->GetPrimitiveArrayCritical(data, 0));
+  if (arr == nullptr) {
+    return;
+  }
+  std::copy(stats, stats + gc::Heap::kGcCauseStatsLength, arr);
+  env->ReleasePrimitiveArrayCritical(data, arr, 0);
+}
+
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMDebug, countInstancesOfClass, "(Ljava/lang/Class;Z)J"),
   NATIVE_METHOD(VMDebug, crash, "()V"),
   NATIVE_METHOD(VMDebug, dumpHprofData, "(Ljava/lang/String;Ljava/io/FileDescriptor;)V"),
   NATIVE_METHOD(VMDebug, dumpHprofDataDdms, "()V"),
+  NATIVE_METHOD(VMDebug, dumpLockProfile, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMDebug, dumpReferenceTables, "()V"),
+  NATIVE_METHOD(VMDebug, dumpSafepointStats, "()Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, dumpSignalSamples, "(Ljava/lang/String;)Z"),
   NATIVE_METHOD(VMDebug, getAllocCount, "(I)I"),
+  NATIVE_METHOD(VMDebug, getFinalizerStats, "([J)V"),
+  NATIVE_METHOD(VMDebug, getGcCauseStats, "([J)V"),
   NATIVE_METHOD(VMDebug, getHeapSpaceStats, "([J)V"),
   NATIVE_METHOD(VMDebug, getInstructionCount, "([I)V"),
   NATIVE_METHOD(VMDebug, getLoadedClassCount, "!()I"),
@@ -331,13 +440,17 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMDebug, startAllocCounting, "()V"),
   NATIVE_METHOD(VMDebug, startEmulatorTracing, "()V"),
   NATIVE_METHOD(VMDebug, startInstructionCounting, "()V"),
+  NATIVE_METHOD(VMDebug, startLockProfiling, "()V"),
   NATIVE_METHOD(VMDebug, startMethodTracingDdmsImpl, "(IIZI)V"),
   NATIVE_METHOD(VMDebug, startMethodTracingFd, "(Ljava/lang/String;Ljava/io/FileDescriptor;IIZI)V"),
   NATIVE_METHOD(VMDebug, startMethodTracingFilename, "(Ljava/lang/String;IIZI)V"),
+  NATIVE_METHOD(VMDebug, startSignalSampling, "(I)Z"),
   NATIVE_METHOD(VMDebug, stopAllocCounting, "()V"),
   NATIVE_METHOD(VMDebug, stopEmulatorTracing, "()V"),
   NATIVE_METHOD(VMDebug, stopInstructionCounting, "()V"),
+  NATIVE_METHOD(VMDebug, stopLockProfiling, "()V"),
   NATIVE_METHOD(VMDebug, stopMethodTracing, "()V"),
+  NATIVE_METHOD(VMDebug, stopSignalSampling, "()V"),
   NATIVE_METHOD(VMDebug, threadCpuTimeNanos, "!()J"),
 };
 
@@ -31,12 +31,15 @@
 #include "mirror/dex_cache-inl.h"
 #include "mirror/object-inl.h"
 #include "object_utils.h"
+#include "profiler.h"
 #include "runtime.h"
 #include "scoped_fast_native_object_access.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
 #include "thread_list.h"
 #include "toStringArray.h"
+#include "ScopedLocalRef.h"
+#include "ScopedUtfChars.h"
 
 namespace art {
 
@@ -385,8 +388,9 @@ static void PreloadDexCachesStatsFilled(DexCacheStats* filled)
         filled->num_types++;
       }
     }
+    // Count the slots, GetResolvedField takes a field index.
     for (size_t i = 0; i < dex_cache->NumResolvedFields(); i++) {
-      mirror::ArtField* field = dex_cache->GetResolvedField(i);
+      mirror::ArtField* field = dex_cache->GetResolvedFields()->Get(i);
       if (field != NULL) {
         filled->num_fields++;
       }
@@ -513,6 +517,42 @@ static void VMRuntime_registerAppInfo(JNIEnv* env, jclass, jstring pkgName, jstr
   env->ReleaseStringUTFChars(pkgName, pkgNameChars);
 }
 
+/*
+ * Loads and verifies the given classes of the app on background threads while the main thread
+ * is busy with other startup work. Does nothing unless enabled with -Xstartupverifythreads.
+ */
+static void VMRuntime_verifyStartupClasses(JNIEnv* env, jobject, jobject javaLoader,
+                                           jobjectArray javaClassNames) {
+  std::vector<std::string> descriptors;
+  jsize count = env->GetArrayLength(javaClassNames);
+  for (jsize i = 0; i < count; ++i) {
+    ScopedLocalRef<jstring> javaClassName(env,
+        reinterpret_cast<jstring>(env->GetObjectArrayElement(javaClassNames, i)));
+    if (javaClassName.get() == NULL) {
+      continue;
+    }
+    ScopedUtfChars className(env, javaClassName.get());
+    descriptors.push_back(DotToDescriptor(className.c_str()));
+  }
+  Runtime::Current()->VerifyStartupClasses(javaLoader, descriptors);
+}
+
+/*
+ * As verifyStartupClasses, for the classes of the methods sampled by an earlier run of the
+ * profiler, hottest first.
+ */
+static void VMRuntime_verifyProfiledStartupClasses(JNIEnv* env, jobject, jobject javaLoader,
+                                                   jstring javaProfileFile) {
+  ScopedUtfChars profileFile(env, javaProfileFile);
+  if (profileFile.c_str() == NULL) {
+    return;
+  }
+  std::vector<std::string> descriptors;
+  if (ProfileHelper::LoadClassDescriptors(descriptors, profileFile.c_str())) {
+    Runtime::Current()->VerifyStartupClasses(javaLoader, descriptors);
+  }
+}
+
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMRuntime, addressOf, "!(Ljava/lang/Object;)J"),
   NATIVE_METHOD(VMRuntime, bootClassPath, "()Ljava/lang/String;"),
@@ -532,6 +572,10 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMRuntime, updateProcessState, "(I)V"),
   NATIVE_METHOD(VMRuntime, startJitCompilation, "()V"),
   NATIVE_METHOD(VMRuntime, trimHeap, "()V"),
+  NATIVE_METHOD(VMRuntime, verifyProfiledStartupClasses,
+                "(Ljava/lang/ClassLoader;Ljava/lang/String;)V"),
+  NATIVE_METHOD(VMRuntime, verifyStartupClasses,
+                "(Ljava/lang/ClassLoader;[Ljava/lang/String;)V"),
   NATIVE_METHOD(VMRuntime, vmVersion, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMRuntime, vmLibrary, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMRuntime, preloadDexCaches, "()V"),
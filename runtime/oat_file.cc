@@ -17,6 +17,7 @@
 #include "oat_file.h"
 
 #include <dlfcn.h>
+#include <sys/mman.h>
 
 #include "base/bit_vector.h"
 #include "base/stl_util.h"
@@ -87,12 +88,29 @@ OatFile* OatFile::Open(const std::string& filename,
     *error_msg = StringPrintf("Failed to open oat filename for reading: %s", strerror(errno));
     return NULL;
   }
-  return OpenElfFile(file.get(), location, requested_base, false, executable, error_msg);
+  return OpenElfFile(file.get(), location, requested_base, 0, false, executable, error_msg);
+}
+
+OatFile* OatFile::OpenRelocated(const std::string& filename,
+                                const std::string& location,
+                                byte* requested_base,
+                                ptrdiff_t load_bias,
+                                bool executable,
+                                std::string* error_msg) {
+  CHECK(!filename.empty()) << location;
+  CheckLocation(filename);
+  UniquePtr<File> file(OS::OpenFileForReading(filename.c_str()));
+  if (file.get() == NULL) {
+    *error_msg = StringPrintf("Failed to open oat filename for reading: %s", strerror(errno));
+    return NULL;
+  }
+  return OpenElfFile(file.get(), location, requested_base, load_bias, false, executable,
+                     error_msg);
 }
 
 OatFile* OatFile::OpenWritable(File* file, const std::string& location, std::string* error_msg) {
   CheckLocation(location);
-  return OpenElfFile(file, location, NULL, true, false, error_msg);
+  return OpenElfFile(file, location, NULL, 0, true, false, error_msg);
 }
 
 OatFile* OatFile::OpenDlopen(const std::string& elf_filename,
@@ -110,11 +128,13 @@ OatFile* OatFile::OpenDlopen(const std::string& elf_filename,
 OatFile* OatFile::OpenElfFile(File* file,
                               const std::string& location,
                               byte* requested_base,
+                              ptrdiff_t load_bias,
                               bool writable,
                               bool executable,
                               std::string* error_msg) {
   UniquePtr<OatFile> oat_file(new OatFile(location));
-  bool success = oat_file->ElfFileOpen(file, requested_base, writable, executable, error_msg);
+  bool success = oat_file->ElfFileOpen(file, requested_base, load_bias, writable, executable,
+                                       error_msg);
   if (!success) {
     CHECK(!error_msg->empty());
     return nullptr;
@@ -171,14 +191,14 @@ bool OatFile::Dlopen(const std::string& elf_filename, byte* requested_base,
   return Setup(error_msg);
 }
 
-bool OatFile::ElfFileOpen(File* file, byte* requested_base, bool writable, bool executable,
-                          std::string* error_msg) {
+bool OatFile::ElfFileOpen(File* file, byte* requested_base, ptrdiff_t load_bias, bool writable,
+                          bool executable, std::string* error_msg) {
   elf_file_.reset(ElfFile::Open(file, writable, true, error_msg));
   if (elf_file_.get() == nullptr) {
     DCHECK(!error_msg->empty());
     return false;
   }
-  bool loaded = elf_file_->Load(executable, error_msg);
+  bool loaded = elf_file_->Load(executable, load_bias, error_msg);
   if (!loaded) {
     DCHECK(!error_msg->empty());
     return false;
@@ -202,9 +222,26 @@ bool OatFile::ElfFileOpen(File* file, byte* requested_base, bool writable, bool
   }
   // Readjust to be non-inclusive upper bound.
   end_ += sizeof(uint32_t);
+  if (executable) {
+    // Setup reads the header of every dex file and class linking reads the dex files and the
+    // class offsets that follow, page by page. Start reading the data before the code in while
+    // the oat file is set up rather than faulting each page in on first use.
+    const byte* exec = elf_file_->FindDynamicSymbolAddress("oatexec");
+    if (exec != nullptr && exec > begin_) {
+      byte* prefetch_begin = const_cast<byte*>(AlignDown(begin_, kPageSize));
+      if (madvise(prefetch_begin, exec - prefetch_begin, MADV_WILLNEED) != 0) {
+        PLOG(WARNING) << "madvise(MADV_WILLNEED) failed for " << file->GetPath();
+      }
+    }
+  }
   return Setup(error_msg);
 }
 
+bool OatFile::SetWritable(bool writable, std::string* error_msg) {
+  CHECK(elf_file_.get() != nullptr) << GetLocation();
+  return elf_file_->SetWritable(writable, error_msg);
+}
+
 bool OatFile::Setup(std::string* error_msg) {
   if (!GetOatHeader().IsValid()) {
     *error_msg = StringPrintf("Invalid oat magic for '%s'", GetLocation().c_str());
@@ -406,6 +443,20 @@ OatFile::OatClass OatFile::OatDexFile::GetOatClass(uint16_t class_def_index) con
   const byte* after_type_pointer = type_pointer + sizeof(int16_t);
   CHECK_LE(after_type_pointer, oat_file_->End()) << oat_file_->GetLocation();
 
+  uint32_t verifier_deps_size = 0;
+  const byte* verifier_deps_pointer = nullptr;
+  if (status == mirror::Class::kStatusRetryVerificationAtRuntime) {
+    verifier_deps_size = *reinterpret_cast<const uint32_t*>(after_type_pointer);
+    verifier_deps_pointer = after_type_pointer + sizeof(verifier_deps_size);
+    after_type_pointer = verifier_deps_pointer + sizeof(uint32_t) * verifier_deps_size;
+    CHECK_LE(after_type_pointer, oat_file_->End()) << oat_file_->GetLocation();
+  }
+
+  uint32_t hot_fields_size = *reinterpret_cast<const uint32_t*>(after_type_pointer);
+  const byte* hot_fields_pointer = after_type_pointer + sizeof(hot_fields_size);
+  after_type_pointer = hot_fields_pointer + sizeof(uint32_t) * hot_fields_size;
+  CHECK_LE(after_type_pointer, oat_file_->End()) << oat_file_->GetLocation();
+
   uint32_t bitmap_size = 0;
   const byte* bitmap_pointer = nullptr;
   const byte* methods_pointer = nullptr;
@@ -422,6 +473,10 @@ OatFile::OatClass OatFile::OatDexFile::GetOatClass(uint16_t class_def_index) con
   return OatClass(oat_file_,
                   status,
                   type,
+                  verifier_deps_size,
+                  reinterpret_cast<const uint32_t*>(verifier_deps_pointer),
+                  hot_fields_size,
+                  reinterpret_cast<const uint32_t*>(hot_fields_pointer),
                   bitmap_size,
                   reinterpret_cast<const uint32_t*>(bitmap_pointer),
                   reinterpret_cast<const OatMethodOffsets*>(methods_pointer));
@@ -430,10 +485,16 @@ OatFile::OatClass OatFile::OatDexFile::GetOatClass(uint16_t class_def_index) con
 OatFile::OatClass::OatClass(const OatFile* oat_file,
                             mirror::Class::Status status,
                             OatClassType type,
+                            uint32_t verifier_deps_size,
+                            const uint32_t* verifier_deps_pointer,
+                            uint32_t hot_fields_size,
+                            const uint32_t* hot_fields_pointer,
                             uint32_t bitmap_size,
                             const uint32_t* bitmap_pointer,
                             const OatMethodOffsets* methods_pointer)
     : oat_file_(oat_file), status_(status), type_(type),
+      verifier_deps_size_(verifier_deps_size), verifier_deps_(verifier_deps_pointer),
+      hot_fields_size_(hot_fields_size), hot_fields_(hot_fields_pointer),
       bitmap_(bitmap_pointer), methods_pointer_(methods_pointer) {
     CHECK(methods_pointer != nullptr);
     switch (type_) {
@@ -49,6 +49,16 @@ class OatFile {
                        bool executable,
                        std::string* error_msg);
 
+  // Open an oat file linked at fixed addresses load_bias bytes away from them, along with the
+  // image it belongs to. The caller relocates the addresses of the oat data, see
+  // gc::space::ImageSpace::Init. Never uses dlopen.
+  static OatFile* OpenRelocated(const std::string& filename,
+                                const std::string& location,
+                                byte* requested_base,
+                                ptrdiff_t load_bias,
+                                bool executable,
+                                std::string* error_msg);
+
   // Open an oat file from an already opened File.
   // Does not use dlopen underneath so cannot be used for runtime use
   // where relocations may be required. Currently used from
@@ -63,6 +73,10 @@ class OatFile {
 
   ~OatFile();
 
+  // Makes an oat file opened with OpenRelocated writable while it is relocated, or restores its
+  // protection.
+  bool SetWritable(bool writable, std::string* error_msg);
+
   const std::string& GetLocation() const {
     return location_;
   }
@@ -165,6 +179,27 @@ class OatFile {
       return type_;
     }
 
+    // The number of words of the encoded verifier::VerifierDeps of a class with status
+    // kStatusRetryVerificationAtRuntime, 0 if there are none.
+    uint32_t GetVerifierDepsSize() const {
+      return verifier_deps_size_;
+    }
+
+    const uint32_t* GetVerifierDeps() const {
+      return verifier_deps_;
+    }
+
+    // The number of instance fields the compiler laid out together, 0 if it used the default
+    // layout.
+    uint32_t GetHotFieldsSize() const {
+      return hot_fields_size_;
+    }
+
+    // The field indices of the hot instance fields, hottest first.
+    const uint32_t* GetHotFields() const {
+      return hot_fields_;
+    }
+
     // get the OatMethod entry based on its index into the class
     // defintion. direct methods come first, followed by virtual
     // methods. note that runtime created methods such as miranda
@@ -175,6 +210,10 @@ class OatFile {
     OatClass(const OatFile* oat_file,
              mirror::Class::Status status,
              OatClassType type,
+             uint32_t verifier_deps_size,
+             const uint32_t* verifier_deps_pointer,
+             uint32_t hot_fields_size,
+             const uint32_t* hot_fields_pointer,
              uint32_t bitmap_size,
              const uint32_t* bitmap_pointer,
              const OatMethodOffsets* methods_pointer);
@@ -185,6 +224,14 @@ class OatFile {
 
     const OatClassType type_;
 
+    const uint32_t verifier_deps_size_;
+
+    const uint32_t* const verifier_deps_;
+
+    const uint32_t hot_fields_size_;
+
+    const uint32_t* const hot_fields_;
+
     const uint32_t* const bitmap_;
 
     const OatMethodOffsets* methods_pointer_;
@@ -253,14 +300,15 @@ class OatFile {
   static OatFile* OpenElfFile(File* file,
                               const std::string& location,
                               byte* requested_base,
+                              ptrdiff_t load_bias,
                               bool writable,
                               bool executable,
                               std::string* error_msg);
 
   explicit OatFile(const std::string& filename);
   bool Dlopen(const std::string& elf_filename, byte* requested_base, std::string* error_msg);
-  bool ElfFileOpen(File* file, byte* requested_base, bool writable, bool executable,
-                   std::string* error_msg);
+  bool ElfFileOpen(File* file, byte* requested_base, ptrdiff_t load_bias, bool writable,
+                   bool executable, std::string* error_msg);
   bool Setup(std::string* error_msg);
 
   const byte* Begin() const;
@@ -20,6 +20,9 @@
 #endif
 
 #include "debugger.h"
+#include "gc/allocator/rosalloc.h"
+#include "gc/reference_processor.h"
+#include "jit/jit.h"
 #include "monitor.h"
 
 namespace art {
@@ -169,6 +172,7 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   }
   // -Xcheck:jni is off by default for regular builds but on by default in debug builds.
   check_jni_ = kIsDebugBuild;
+  check_jni_sample_rate_ = 1;
 
   heap_initial_size_ = gc::Heap::kDefaultInitialSize;
   heap_maximum_size_ = gc::Heap::kDefaultMaximumSize;
@@ -181,6 +185,8 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   parallel_gc_threads_ = sysconf(_SC_NPROCESSORS_CONF) - 1;
   // Only the main GC thread, no workers.
   conc_gc_threads_ = 0;
+  numa_aware_gc_threads_ = false;
+  native_allocation_pacing_ = false;
   // Default is CMS which is Sticky + Partial + Full CMS GC.
   collector_type_ = gc::kCollectorTypeCMS;
   // If background_collector_type_ is kCollectorTypeNone, it defaults to the collector_type_ after
@@ -189,7 +195,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   stack_size_ = 0;  // 0 means default.
   max_spins_before_thin_lock_inflation_ = Monitor::kDefaultMaxSpinsBeforeThinLockInflation;
   low_memory_mode_ = false;
+  use_transparent_huge_pages_ = false;
   use_tlab_ = false;
+  rosalloc_thread_local_brackets_ = gc::allocator::RosAlloc::kDefaultNumThreadLocalSizeBrackets;
+  soft_ref_lru_policy_ms_per_mb_ = gc::ReferenceProcessor::kDefaultSoftReferenceMsPerMb;
   verify_pre_gc_heap_ = false;
   // Pre sweeping is the one that usually fails if the GC corrupted the heap.
   verify_pre_sweeping_heap_ = kIsDebugBuild;
@@ -207,14 +216,28 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   } else {
     interpreter_only_ = false;
   }
+  interpreter_impl_kind_ = interpreter::kMterpImplKind;
+  use_jit_ = false;
+  jit_compile_threshold_ = jit::Jit::kDefaultCompileThreshold;
+  jit_code_cache_capacity_ = jit::JitCodeCache::kDefaultCapacity;
+  startup_verify_threads_ = 0;
   is_explicit_gc_disabled_ = false;
+  heap_dump_in_child_ = false;
+  // Allocations are not sampled unless an interval is set.
+  heap_sample_interval_ = 0;
 
   long_pause_log_threshold_ = gc::Heap::kDefaultLongPauseLogThreshold;
   long_gc_log_threshold_ = gc::Heap::kDefaultLongGCLogThreshold;
+  // The pause time sizing policy is off unless one of its targets is set.
+  pause_time_target_ = 0;
+  gc_time_percent_target_ = 0.0;
   dump_gc_performance_on_shutdown_ = false;
   ignore_max_footprint_ = false;
 
   lock_profiling_threshold_ = 0;
+  low_pause_sigquit_ = false;
+  metrics_page_interval_ms_ = 1000;
+  class_unloading_ = true;
   hook_is_sensitive_thread_ = NULL;
 
   hook_vfprintf_ = vfprintf;
@@ -237,6 +260,7 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   method_trace_ = false;
   method_trace_file_ = "/data/method-trace-file.bin";
   method_trace_file_size_ = 10 * MB;
+  method_trace_stream_ = false;
 
   profile_ = false;
   profile_period_s_ = 10;           // Seconds.
@@ -247,6 +271,9 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   profile_clock_source_ = kDefaultProfilerClockSource;
 
   verify_ = true;
+  compact_dex_cache_fields_ = false;
+  relocate_image_ = false;
+  cache_decompressed_image_ = false;
   image_isa_ = kRuntimeISA;
 
   // Default to explicit checks.  Switch off with -implicit-checks:.
@@ -312,6 +339,11 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseStringAfterChar(option, ':', &image_)) {
         return false;
       }
+    } else if (StartsWith(option, "-Xcheck:jni-sample-rate:")) {
+      if (!ParseUnsignedInteger(option, ':', &check_jni_sample_rate_)) {
+        return false;
+      }
+      check_jni_ = true;
     } else if (StartsWith(option, "-Xcheck:jni")) {
       check_jni_ = true;
     } else if (StartsWith(option, "-Xrunjdwp:") || StartsWith(option, "-agentlib:jdwp=")) {
@@ -376,6 +408,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseUnsignedInteger(option, '=', &conc_gc_threads_)) {
         return false;
       }
+    } else if (option == "-XX:NumaAwareGCThreads") {
+      numa_aware_gc_threads_ = true;
+    } else if (option == "-XX:NativeAllocationPacing") {
+      native_allocation_pacing_ = true;
     } else if (StartsWith(option, "-Xss")) {
       size_t size = ParseMemoryOption(option.substr(strlen("-Xss")).c_str(), 1);
       if (size == 0) {
@@ -399,14 +435,59 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
         return false;
       }
       long_gc_log_threshold_ = MsToNs(value);
+    } else if (StartsWith(option, "-XX:PauseTimeTarget=")) {
+      unsigned int value;
+      if (!ParseUnsignedInteger(option, '=', &value)) {
+        return false;
+      }
+      pause_time_target_ = MsToNs(value);
+    } else if (StartsWith(option, "-XX:GcTimePercentTarget=")) {
+      if (!ParseDouble(option, '=', 0.1, 50.0, &gc_time_percent_target_)) {
+        return false;
+      }
+    } else if (option == "-XX:CompactDexCacheFields") {
+      compact_dex_cache_fields_ = true;
+    } else if (option == "-Xrelocate-image") {
+      relocate_image_ = true;
+    } else if (option == "-Xcache-decompressed-image") {
+      cache_decompressed_image_ = true;
     } else if (option == "-XX:DumpGCPerformanceOnShutdown") {
       dump_gc_performance_on_shutdown_ = true;
+    } else if (option == "-XX:HeapDumpInChild") {
+      heap_dump_in_child_ = true;
+    } else if (StartsWith(option, "-XX:HeapSampleInterval=")) {
+      if (!ParseUnsignedInteger(option, '=', &heap_sample_interval_)) {
+        return false;
+      }
+    } else if (StartsWith(option, "-XX:HeapSampleFile=")) {
+      if (!ParseStringAfterChar(option, '=', &heap_sample_file_)) {
+        return false;
+      }
     } else if (option == "-XX:IgnoreMaxFootprint") {
       ignore_max_footprint_ = true;
     } else if (option == "-XX:LowMemoryMode") {
       low_memory_mode_ = true;
+    } else if (option == "-XX:UseTransparentHugePages") {
+      use_transparent_huge_pages_ = true;
     } else if (option == "-XX:UseTLAB") {
       use_tlab_ = true;
+    } else if (StartsWith(option, "-XX:RosAllocThreadLocalBrackets=")) {
+      unsigned int value;
+      if (!ParseUnsignedInteger(option, '=', &value)) {
+        return false;
+      }
+      if (value > gc::allocator::RosAlloc::kMaxNumThreadLocalSizeBrackets) {
+        Usage("-XX:RosAllocThreadLocalBrackets must be at most %zd, not %u\n",
+              gc::allocator::RosAlloc::kMaxNumThreadLocalSizeBrackets, value);
+        return false;
+      }
+      rosalloc_thread_local_brackets_ = value;
+    } else if (StartsWith(option, "-XX:SoftRefLRUPolicyMSPerMB=")) {
+      unsigned int value;
+      if (!ParseUnsignedInteger(option, '=', &value)) {
+        return false;
+      }
+      soft_ref_lru_policy_ms_per_mb_ = value;
     } else if (StartsWith(option, "-D")) {
       properties_.push_back(option.substr(strlen("-D")));
     } else if (StartsWith(option, "-Xjnitrace:")) {
@@ -421,6 +502,43 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       is_zygote_ = true;
     } else if (option == "-Xint") {
       interpreter_only_ = true;
+    } else if (StartsWith(option, "-Xinterpreter-impl:")) {
+      std::string impl = option.substr(strlen("-Xinterpreter-impl:"));
+      if (impl == "mterp") {
+        interpreter_impl_kind_ = interpreter::kMterpImplKind;
+      } else if (impl == "goto") {
+        interpreter_impl_kind_ = interpreter::kComputedGotoImplKind;
+      } else if (impl == "switch") {
+        interpreter_impl_kind_ = interpreter::kSwitchImpl;
+      } else {
+        Usage("Unknown -Xinterpreter-impl option %s\n", impl.c_str());
+        return false;
+      }
+    } else if (option == "-Xjit") {
+      use_jit_ = true;
+    } else if (StartsWith(option, "-Xjitthreshold:")) {
+      if (!ParseUnsignedInteger(option, ':', &jit_compile_threshold_)) {
+        return false;
+      }
+      if (jit_compile_threshold_ == 0 || jit_compile_threshold_ > jit::Jit::kMaxCompileThreshold) {
+        Usage("-Xjitthreshold must be between 1 and %zd, not %u\n",
+              jit::Jit::kMaxCompileThreshold, jit_compile_threshold_);
+        return false;
+      }
+    } else if (StartsWith(option, "-Xjitcodecachesize:")) {
+      unsigned int value;
+      if (!ParseUnsignedInteger(option, ':', &value)) {
+        return false;
+      }
+      if (value == 0) {
+        Usage("-Xjitcodecachesize must not be 0\n");
+        return false;
+      }
+      jit_code_cache_capacity_ = value * KB;
+    } else if (StartsWith(option, "-Xstartupverifythreads:")) {
+      if (!ParseUnsignedInteger(option, ':', &startup_verify_threads_)) {
+        return false;
+      }
     } else if (StartsWith(option, "-Xgc:")) {
       if (!ParseXGcOption(option)) {
         return false;
@@ -483,6 +601,22 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseStringAfterChar(option, ':', &stack_trace_file_)) {
         return false;
       }
+    } else if (option == "-XX:LowPauseSigQuit") {
+      low_pause_sigquit_ = true;
+    } else if (StartsWith(option, "-Xstartup-timings:")) {
+      if (!ParseStringAfterChar(option, ':', &startup_timings_file_)) {
+        return false;
+      }
+    } else if (StartsWith(option, "-Xmetrics-page:")) {
+      if (!ParseStringAfterChar(option, ':', &metrics_page_dir_)) {
+        return false;
+      }
+    } else if (StartsWith(option, "-XX:MetricsPageInterval=")) {
+      if (!ParseUnsignedInteger(option, '=', &metrics_page_interval_ms_)) {
+        return false;
+      }
+    } else if (option == "-XX:DisableClassUnloading") {
+      class_unloading_ = false;
     } else if (option == "sensitiveThread") {
       const void* hook = options[i].second;
       hook_is_sensitive_thread_ = reinterpret_cast<bool (*)()>(const_cast<void*>(hook));
@@ -516,6 +650,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseUnsignedInteger(option, ':', &method_trace_file_size_)) {
         return false;
       }
+    } else if (option == "-Xmethod-trace-stream") {
+      method_trace_stream_ = true;
+    } else if (StartsWith(option, "-Xmethod-trace-filter:")) {
+      Trace::SetMethodFilters(option.substr(strlen("-Xmethod-trace-filter:")));
     } else if (option == "-Xprofile:threadcpuclock") {
       Trace::SetDefaultClockSource(kProfilerClockSourceThreadCpu);
     } else if (option == "-Xprofile:wallclock") {
@@ -639,8 +777,6 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
                (option == "-Xincludeselectedop") ||
                StartsWith(option, "-Xjitop:") ||
                (option == "-Xincludeselectedmethod") ||
-               StartsWith(option, "-Xjitthreshold:") ||
-               StartsWith(option, "-Xjitcodecachesize:") ||
                (option == "-Xjitblocking") ||
                StartsWith(option, "-Xjitmethod:") ||
                StartsWith(option, "-Xjitclass:") ||
@@ -737,6 +873,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "The following Dalvik options are supported:\n");
   UsageMessage(stream, "  -Xzygote\n");
   UsageMessage(stream, "  -Xjnitrace:substring (eg NativeClass or nativeMethod)\n");
+  UsageMessage(stream, "  -Xcheck:jni-sample-rate:N (check the arguments of 1 call in N)\n");
   UsageMessage(stream, "  -Xstacktracefile:<filename>\n");
   UsageMessage(stream, "  -Xgc:[no]preverify\n");
   UsageMessage(stream, "  -Xgc:[no]postverify\n");
@@ -758,21 +895,46 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Ximage:filename\n");
   UsageMessage(stream, "  -XX:ParallelGCThreads=integervalue\n");
   UsageMessage(stream, "  -XX:ConcGCThreads=integervalue\n");
+  UsageMessage(stream, "  -XX:NumaAwareGCThreads\n");
+  UsageMessage(stream, "  -XX:NativeAllocationPacing\n");
   UsageMessage(stream, "  -XX:MaxSpinsBeforeThinLockInflation=integervalue\n");
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
+  UsageMessage(stream, "  -XX:PauseTimeTarget=integervalue\n");
+  UsageMessage(stream, "  -XX:GcTimePercentTarget=doublevalue\n");
   UsageMessage(stream, "  -XX:DumpGCPerformanceOnShutdown\n");
+  UsageMessage(stream, "  -XX:HeapDumpInChild\n");
+  UsageMessage(stream, "  -XX:HeapSampleInterval=integervalue\n");
+  UsageMessage(stream, "  -XX:HeapSampleFile=filename\n");
+  UsageMessage(stream, "  -XX:CompactDexCacheFields\n");
+  UsageMessage(stream, "  -Xrelocate-image\n");
+  UsageMessage(stream, "  -Xcache-decompressed-image\n");
+  UsageMessage(stream, "  -Xstartup-timings:<filename>\n");
+  UsageMessage(stream, "  -Xmetrics-page:<directory>\n");
+  UsageMessage(stream, "  -XX:MetricsPageInterval=integervalue (milliseconds)\n");
+  UsageMessage(stream, "  -XX:DisableClassUnloading\n");
+  UsageMessage(stream, "  -XX:LowPauseSigQuit\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
+  UsageMessage(stream, "  -XX:UseTransparentHugePages\n");
+  UsageMessage(stream, "  -XX:RosAllocThreadLocalBrackets=integervalue\n");
+  UsageMessage(stream, "  -XX:SoftRefLRUPolicyMSPerMB=integervalue\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
   UsageMessage(stream, "  -Xmethod-trace-file-size:integervalue\n");
+  UsageMessage(stream, "  -Xmethod-trace-stream\n");
+  UsageMessage(stream, "  -Xmethod-trace-filter:prefix[,prefix...]\n");
   UsageMessage(stream, "  -Xprofile=filename\n");
   UsageMessage(stream, "  -Xprofile-period:integervalue\n");
   UsageMessage(stream, "  -Xprofile-duration:integervalue\n");
   UsageMessage(stream, "  -Xprofile-interval:integervalue\n");
   UsageMessage(stream, "  -Xprofile-backoff:integervalue\n");
+  UsageMessage(stream, "  -Xinterpreter-impl:{mterp,goto,switch}\n");
+  UsageMessage(stream, "  -Xjit\n");
+  UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
+  UsageMessage(stream, "  -Xjitcodecachesize:decimalvalueofkbytes\n");
+  UsageMessage(stream, "  -Xstartupverifythreads:integervalue\n");
   UsageMessage(stream, "  -Xcompiler-option dex2oat-option\n");
   UsageMessage(stream, "  -Ximage-compiler-option dex2oat-option\n");
   UsageMessage(stream, "\n");
@@ -799,8 +961,6 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xincludeselectedop\n");
   UsageMessage(stream, "  -Xjitop:hexopvalue[-endvalue][,hexopvalue[-endvalue]]*\n");
   UsageMessage(stream, "  -Xincludeselectedmethod\n");
-  UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
-  UsageMessage(stream, "  -Xjitcodecachesize:decimalvalueofkbytes\n");
   UsageMessage(stream, "  -Xjitblocking\n");
   UsageMessage(stream, "  -Xjitmethod:signature[,signature]* (eg Ljava/lang/String\\;replace)\n");
   UsageMessage(stream, "  -Xjitclass:classname[,classname]*\n");
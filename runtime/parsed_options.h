@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include "interpreter/interpreter.h"
 #include "runtime.h"
 #include "trace.h"
 
@@ -34,12 +35,23 @@ class ParsedOptions {
   std::string class_path_string_;
   std::string image_;
   bool check_jni_;
+  unsigned int check_jni_sample_rate_;
   std::string jni_trace_;
   CompilerCallbacks* compiler_callbacks_;
   bool is_zygote_;
   bool interpreter_only_;
+  interpreter::InterpreterImplKind interpreter_impl_kind_;
+  bool use_jit_;
+  unsigned int jit_compile_threshold_;
+  size_t jit_code_cache_capacity_;
+  unsigned int startup_verify_threads_;
   bool is_explicit_gc_disabled_;
+  bool heap_dump_in_child_;
+  unsigned int heap_sample_interval_;
+  std::string heap_sample_file_;
   bool use_tlab_;
+  size_t rosalloc_thread_local_brackets_;
+  size_t soft_ref_lru_policy_ms_per_mb_;
   bool verify_pre_gc_heap_;
   bool verify_pre_sweeping_heap_;
   bool verify_post_gc_heap_;
@@ -48,6 +60,8 @@ class ParsedOptions {
   bool verify_post_gc_rosalloc_;
   unsigned int long_pause_log_threshold_;
   unsigned int long_gc_log_threshold_;
+  unsigned int pause_time_target_;
+  double gc_time_percent_target_;
   bool dump_gc_performance_on_shutdown_;
   bool ignore_max_footprint_;
   size_t heap_initial_size_;
@@ -59,16 +73,21 @@ class ParsedOptions {
   double foreground_heap_growth_multiplier_;
   unsigned int parallel_gc_threads_;
   unsigned int conc_gc_threads_;
+  bool numa_aware_gc_threads_;
+  bool native_allocation_pacing_;
   gc::CollectorType collector_type_;
   gc::CollectorType background_collector_type_;
   size_t stack_size_;
   unsigned int max_spins_before_thin_lock_inflation_;
   bool low_memory_mode_;
+  bool use_transparent_huge_pages_;
   unsigned int lock_profiling_threshold_;
   std::string stack_trace_file_;
+  bool low_pause_sigquit_;
   bool method_trace_;
   std::string method_trace_file_;
   unsigned int method_trace_file_size_;
+  bool method_trace_stream_;
   bool (*hook_is_sensitive_thread_)();
   jint (*hook_vfprintf_)(FILE* stream, const char* format, va_list ap);
   void (*hook_exit_)(jint status);
@@ -85,6 +104,13 @@ class ParsedOptions {
   bool profile_start_immediately_;
   ProfilerClockSource profile_clock_source_;
   bool verify_;
+  bool compact_dex_cache_fields_;
+  bool relocate_image_;
+  bool cache_decompressed_image_;
+  std::string startup_timings_file_;
+  std::string metrics_page_dir_;
+  uint32_t metrics_page_interval_ms_;
+  bool class_unloading_;
   InstructionSet image_isa_;
 
   static constexpr uint32_t kExplicitNullCheck = 1;
@@ -16,7 +16,9 @@
 
 #include "profiler.h"
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <sys/uio.h>
 #include <sys/file.h>
 
@@ -26,7 +28,10 @@
 #include "common_throws.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
+#include "dex_instruction.h"
 #include "instrumentation.h"
+#include "interpreter/inline_cache.h"
+#include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/dex_cache.h"
@@ -64,7 +69,8 @@ volatile bool BackgroundMethodSamplingProfiler::shutting_down_ = false;
 static void GetSample(Thread* thread, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   BackgroundMethodSamplingProfiler* profiler =
       reinterpret_cast<BackgroundMethodSamplingProfiler*>(arg);
-  mirror::ArtMethod* method = thread->GetCurrentMethod(nullptr);
+  uint32_t dex_pc = 0;
+  mirror::ArtMethod* method = thread->GetCurrentMethod(&dex_pc);
   if (false && method == nullptr) {
     LOG(INFO) << "No current method available";
     std::ostringstream os;
@@ -72,7 +78,7 @@ static void GetSample(Thread* thread, void* arg) SHARED_LOCKS_REQUIRED(Locks::mu
     std::string data(os.str());
     LOG(INFO) << data;
   }
-  profiler->RecordMethod(method);
+  profiler->RecordMethod(method, dex_pc);
 }
 
 
@@ -380,7 +386,7 @@ BackgroundMethodSamplingProfiler::BackgroundMethodSamplingProfiler(int period, i
 
 // A method has been hit, record its invocation in the method map.
 // The mutator_lock must be held (shared) when this is called.
-void BackgroundMethodSamplingProfiler::RecordMethod(mirror::ArtMethod* method) {
+void BackgroundMethodSamplingProfiler::RecordMethod(mirror::ArtMethod* method, uint32_t dex_pc) {
   if (method == nullptr) {
     profile_table_.NullMethod();
     // Don't record a nullptr method.
@@ -414,7 +420,7 @@ void BackgroundMethodSamplingProfiler::RecordMethod(mirror::ArtMethod* method) {
 
   // Add to the profile table unless it is filtered out.
   if (!is_filtered) {
-    profile_table_.Put(method);
+    profile_table_.Put(method, dex_pc);
   }
 }
 
@@ -446,66 +452,122 @@ ProfileSampleResults::~ProfileSampleResults() {
 
 // Add a method to the profile table.  If it the first time the method
 // has been seen, add it with count=1, otherwise increment the count.
-void ProfileSampleResults::Put(mirror::ArtMethod* method) {
+void ProfileSampleResults::Put(mirror::ArtMethod* method, uint32_t dex_pc) {
   lock_.Lock(Thread::Current());
   uint32_t index = Hash(method);
   if (table[index] == nullptr) {
     table[index] = new Map();
   }
-  Map::iterator i = table[index]->find(method);
-  if (i == table[index]->end()) {
-    (*table[index])[method] = 1;
-  } else {
-    i->second++;
-  }
+  MethodSamples& samples = (*table[index])[method];
+  samples.count++;
+  samples.dex_pc_counts[dex_pc]++;
   num_samples_++;
   lock_.Unlock(Thread::Current());
 }
 
+// Collects the receiver classes the interpreter saw at the virtual and interface call sites of
+// the method.
+static void GetInlineCaches(mirror::ArtMethod* method, const DexFile::CodeItem* code_item,
+                            std::map<uint32_t, std::vector<std::string>>* inline_caches)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  interpreter::InlineCacheTable* table = Runtime::Current()->GetInlineCaches();
+  std::vector<mirror::Class*> classes;
+  const uint16_t* insns = code_item->insns_;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_;) {
+    const Instruction* inst = Instruction::At(insns + dex_pc);
+    switch (inst->Opcode()) {
+      case Instruction::INVOKE_VIRTUAL:
+      case Instruction::INVOKE_VIRTUAL_RANGE:
+      case Instruction::INVOKE_INTERFACE:
+      case Instruction::INVOKE_INTERFACE_RANGE:
+        if (table->GetReceiverClasses(method, dex_pc, &classes)) {
+          std::vector<std::string>& descriptors = (*inline_caches)[dex_pc];
+          for (mirror::Class* klass : classes) {
+            descriptors.push_back(ClassHelper(klass).GetDescriptor());
+          }
+        }
+        break;
+      default:
+        break;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+}
+
+// Adds the samples of the instance field accesses of the method to the fields of profile. Fields
+// that aren't resolved yet were never accessed through the dex cache and aren't hot.
+static void GetFieldSamples(mirror::ArtMethod* method, const DexFile::CodeItem* code_item,
+                            const std::map<uint32_t, uint32_t>& dex_pc_counts,
+                            ProfileFile* profile)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::DexCache* dex_cache = method->GetDeclaringClass()->GetDexCache();
+  for (const auto& dex_pc_count : dex_pc_counts) {
+    if (dex_pc_count.first >= code_item->insns_size_in_code_units_) {
+      continue;
+    }
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc_count.first);
+    switch (inst->Opcode()) {
+      case Instruction::IGET:
+      case Instruction::IGET_WIDE:
+      case Instruction::IGET_OBJECT:
+      case Instruction::IGET_BOOLEAN:
+      case Instruction::IGET_BYTE:
+      case Instruction::IGET_CHAR:
+      case Instruction::IGET_SHORT:
+      case Instruction::IPUT:
+      case Instruction::IPUT_WIDE:
+      case Instruction::IPUT_OBJECT:
+      case Instruction::IPUT_BOOLEAN:
+      case Instruction::IPUT_BYTE:
+      case Instruction::IPUT_CHAR:
+      case Instruction::IPUT_SHORT: {
+        mirror::ArtField* field = dex_cache->GetResolvedField(inst->VRegC_22c());
+        if (field != nullptr) {
+          std::string descriptor(ClassHelper(field->GetDeclaringClass()).GetDescriptor());
+          profile->GetFields()[descriptor][FieldHelper(field).GetName()] += dex_pc_count.second;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
 // Write the profile table to the output stream.  Also merge with the previous profile.
 uint32_t ProfileSampleResults::Write(std::ostream &os) {
   ScopedObjectAccess soa(Thread::Current());
-  num_samples_ += previous_num_samples_;
-  num_null_methods_ += previous_num_null_methods_;
-  num_boot_methods_ += previous_num_boot_methods_;
-
-  LOG(DEBUG) << "Profile: " << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_;
-  os << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_ << "\n";
-  uint32_t num_methods = 0;
+  ProfileFile profile;
+  profile.AddSamples(num_samples_, num_null_methods_, num_boot_methods_);
   for (int i = 0 ; i < kHashSize; i++) {
     Map *map = table[i];
     if (map != nullptr) {
       for (const auto &meth_iter : *map) {
         mirror::ArtMethod *method = meth_iter.first;
-        std::string method_name = PrettyMethod(method);
+        ProfileMethodRecord& record = profile.GetMethods()[PrettyMethod(method)];
 
         MethodHelper mh(method);
         const DexFile::CodeItem* codeitem = mh.GetCodeItem();
-        uint32_t method_size = 0;
         if (codeitem != nullptr) {
-          method_size = codeitem->insns_size_in_code_units_;
+          record.method_size = codeitem->insns_size_in_code_units_;
+          GetInlineCaches(method, codeitem, &record.inline_caches);
+          GetFieldSamples(method, codeitem, meth_iter.second.dex_pc_counts, &profile);
         }
-        uint32_t count = meth_iter.second;
-
-        // Merge this profile entry with one from a previous run (if present).  Also
-        // remove the previous entry.
-        PreviousProfile::iterator pi = previous_.find(method_name);
-        if (pi != previous_.end()) {
-          count += pi->second.count_;
-          previous_.erase(pi);
+        // Methods of different class loaders may share a name.
+        record.count += meth_iter.second.count;
+        for (const auto& dex_pc_count : meth_iter.second.dex_pc_counts) {
+          record.dex_pc_counts[dex_pc_count.first] += dex_pc_count.second;
         }
-        os << StringPrintf("%s/%u/%u\n",  method_name.c_str(), count, method_size);
-        ++num_methods;
       }
     }
   }
 
-  // Now we write out the remaining previous methods.
-  for (PreviousProfile::iterator pi = previous_.begin(); pi != previous_.end(); ++pi) {
-    os << StringPrintf("%s/%u/%u\n",  pi->first.c_str(), pi->second.count_, pi->second.method_size_);
-    ++num_methods;
-  }
-  return num_methods;
+  // Merge with the profile of the previous runs.
+  profile.Merge(previous_);
+  LOG(DEBUG) << "Profile: " << profile.GetNumSamples() << "/" << profile.GetNumNullMethods()
+      << "/" << profile.GetNumBootMethods();
+  os << profile.Serialize();
+  return profile.GetMethods().size();
 }
 
 void ProfileSampleResults::Clear() {
@@ -516,70 +578,317 @@ void ProfileSampleResults::Clear() {
      delete table[i];
      table[i] = nullptr;
   }
-  previous_.clear();
+  previous_.Clear();
 }
 
 uint32_t ProfileSampleResults::Hash(mirror::ArtMethod* method) {
   return (PointerToLowMemUInt32(method) >> 3) % kHashSize;
 }
 
-// Read a single line into the given string.  Returns true if everything OK, false
-// on EOF or error.
-static bool ReadProfileLine(int fd, std::string& line) {
-  char buf[4];
-  line.clear();
+// Read the whole file into the given string.  Returns false on error.
+static bool ReadProfile(int fd, std::string* data) {
+  char buf[4096];
+  data->clear();
   while (true) {
-    int n = read(fd, buf, 1);     // TODO: could speed this up but is it worth it?
-    if (n != 1) {
+    ssize_t n = TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)));
+    if (n < 0) {
       return false;
     }
-    if (buf[0] == '\n') {
-      break;
+    if (n == 0) {
+      return true;
     }
-    line += buf[0];
+    data->append(buf, n);
   }
-  return true;
 }
 
 void ProfileSampleResults::ReadPrevious(int fd) {
-  // Reset counters.
-  previous_num_samples_ = previous_num_null_methods_ = previous_num_boot_methods_ = 0;
+  std::string data;
+  if (!ReadProfile(fd, &data) || !previous_.Parse(data)) {
+    previous_.Clear();
+  }
+}
 
-  std::string line;
+const uint8_t ProfileFile::kMagic[] = { 'p', 'r', 'o', '\0' };
+const uint8_t ProfileFile::kVersion[] = { '0', '0', '2', '\0' };
+const uint8_t ProfileFile::kVersionNoFields[] = { '0', '0', '1', '\0' };
 
-  // The first line contains summary information.
-  if (!ReadProfileLine(fd, line)) {
-    return;
+static void AppendU1(std::string* data, uint8_t value) {
+  data->push_back(static_cast<char>(value));
+}
+
+static void AppendU2(std::string* data, uint16_t value) {
+  AppendU1(data, value & 0xff);
+  AppendU1(data, value >> 8);
+}
+
+static void AppendU4(std::string* data, uint32_t value) {
+  AppendU2(data, value & 0xffff);
+  AppendU2(data, value >> 16);
+}
+
+static void AppendString(std::string* data, const std::string& value) {
+  DCHECK_LE(value.size(), 0xffffU);
+  AppendU2(data, value.size());
+  data->append(value);
+}
+
+// Reads the binary profile format, every read fails once the data is exhausted.
+class ProfileReader {
+ public:
+  explicit ProfileReader(const std::string& data) : data_(data), pos_(0) {}
+
+  bool ReadU1(uint8_t* value) {
+    if (pos_ + 1 > data_.size()) {
+      return false;
+    }
+    *value = static_cast<uint8_t>(data_[pos_++]);
+    return true;
+  }
+
+  bool ReadU2(uint16_t* value) {
+    uint8_t lo, hi;
+    if (!ReadU1(&lo) || !ReadU1(&hi)) {
+      return false;
+    }
+    *value = lo | (hi << 8);
+    return true;
+  }
+
+  bool ReadU4(uint32_t* value) {
+    uint16_t lo, hi;
+    if (!ReadU2(&lo) || !ReadU2(&hi)) {
+      return false;
+    }
+    *value = lo | (static_cast<uint32_t>(hi) << 16);
+    return true;
   }
+
+  bool ReadString(std::string* value) {
+    uint16_t length;
+    if (!ReadU2(&length) || pos_ + length > data_.size()) {
+      return false;
+    }
+    value->assign(data_, pos_, length);
+    pos_ += length;
+    return true;
+  }
+
+  bool AtEnd() const {
+    return pos_ == data_.size();
+  }
+
+ private:
+  const std::string& data_;
+  size_t pos_;
+};
+
+bool ProfileFile::Parse(const std::string& data) {
+  Clear();
+  bool ok;
+  if (data.size() >= sizeof(kMagic) && memcmp(data.data(), kMagic, sizeof(kMagic)) == 0) {
+    ok = ParseBinary(data);
+  } else {
+    ok = ParseText(data);
+  }
+  if (!ok) {
+    Clear();
+  }
+  return ok;
+}
+
+bool ProfileFile::ParseBinary(const std::string& data) {
+  if (data.size() < sizeof(kMagic) + sizeof(kVersion)) {
+    return false;
+  }
+  bool has_fields;
+  if (memcmp(data.data() + sizeof(kMagic), kVersion, sizeof(kVersion)) == 0) {
+    has_fields = true;
+  } else if (memcmp(data.data() + sizeof(kMagic), kVersionNoFields,
+                    sizeof(kVersionNoFields)) == 0) {
+    has_fields = false;
+  } else {
+    LOG(WARNING) << "Unsupported profile version";
+    return false;
+  }
+  const std::string contents(data, sizeof(kMagic) + sizeof(kVersion));
+  ProfileReader reader(contents);
+  uint32_t num_methods;
+  if (!reader.ReadU4(&num_samples_) || !reader.ReadU4(&num_null_methods_) ||
+      !reader.ReadU4(&num_boot_methods_) || !reader.ReadU4(&num_methods)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_methods; ++i) {
+    std::string method_name;
+    ProfileMethodRecord record;
+    uint16_t num_dex_pcs;
+    if (!reader.ReadString(&method_name) || !reader.ReadU4(&record.count) ||
+        !reader.ReadU4(&record.method_size) || !reader.ReadU2(&num_dex_pcs)) {
+      return false;
+    }
+    for (uint16_t j = 0; j < num_dex_pcs; ++j) {
+      uint32_t dex_pc, count;
+      if (!reader.ReadU4(&dex_pc) || !reader.ReadU4(&count)) {
+        return false;
+      }
+      record.dex_pc_counts[dex_pc] = count;
+    }
+    uint16_t num_inline_caches;
+    if (!reader.ReadU2(&num_inline_caches)) {
+      return false;
+    }
+    for (uint16_t j = 0; j < num_inline_caches; ++j) {
+      uint32_t dex_pc;
+      uint8_t num_classes;
+      if (!reader.ReadU4(&dex_pc) || !reader.ReadU1(&num_classes)) {
+        return false;
+      }
+      std::vector<std::string>& classes = record.inline_caches[dex_pc];
+      classes.resize(num_classes);
+      for (uint8_t k = 0; k < num_classes; ++k) {
+        if (!reader.ReadString(&classes[k])) {
+          return false;
+        }
+      }
+    }
+    methods_[method_name] = record;
+  }
+  if (has_fields) {
+    uint32_t num_classes;
+    if (!reader.ReadU4(&num_classes)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < num_classes; ++i) {
+      std::string descriptor;
+      uint16_t num_fields;
+      if (!reader.ReadString(&descriptor) || !reader.ReadU2(&num_fields)) {
+        return false;
+      }
+      std::map<std::string, uint32_t>& fields = fields_[descriptor];
+      for (uint16_t j = 0; j < num_fields; ++j) {
+        std::string field_name;
+        uint32_t count;
+        if (!reader.ReadString(&field_name) || !reader.ReadU4(&count)) {
+          return false;
+        }
+        fields[field_name] = count;
+      }
+    }
+  }
+  return reader.AtEnd();
+}
+
+bool ProfileFile::ParseText(const std::string& data) {
+  std::vector<std::string> lines;
+  Split(data, '\n', lines);
+  if (lines.empty()) {
+    return false;
+  }
+  // The first line contains summary information.
   std::vector<std::string> summary_info;
-  Split(line, '/', summary_info);
+  Split(lines[0], '/', summary_info);
   if (summary_info.size() != 3) {
     // Bad summary info.  It should be count/nullcount/bootcount
-    return;
+    return false;
   }
-  previous_num_samples_ = atoi(summary_info[0].c_str());
-  previous_num_null_methods_ = atoi(summary_info[1].c_str());
-  previous_num_boot_methods_ = atoi(summary_info[2].c_str());
+  num_samples_ = atoi(summary_info[0].c_str());
+  num_null_methods_ = atoi(summary_info[1].c_str());
+  num_boot_methods_ = atoi(summary_info[2].c_str());
 
-  // Now read each line until the end of file.  Each line consists of 3 fields separated by /
-  while (true) {
-    if (!ReadProfileLine(fd, line)) {
-      break;
-    }
+  // Each following line consists of 3 fields separated by /
+  for (size_t i = 1; i < lines.size(); ++i) {
     std::vector<std::string> info;
-    Split(line, '/', info);
+    Split(lines[i], '/', info);
     if (info.size() != 3) {
       // Malformed.
       break;
     }
-    std::string methodname = info[0];
-    uint32_t count = atoi(info[1].c_str());
-    uint32_t size = atoi(info[2].c_str());
-    previous_[methodname] = PreviousValue(count, size);
+    ProfileMethodRecord& record = methods_[info[0]];
+    record.count = atoi(info[1].c_str());
+    record.method_size = atoi(info[2].c_str());
   }
+  return true;
 }
 
-bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fileName) {
+std::string ProfileFile::Serialize() const {
+  std::string data(reinterpret_cast<const char*>(kMagic), sizeof(kMagic));
+  data.append(reinterpret_cast<const char*>(kVersion), sizeof(kVersion));
+  AppendU4(&data, num_samples_);
+  AppendU4(&data, num_null_methods_);
+  AppendU4(&data, num_boot_methods_);
+  AppendU4(&data, methods_.size());
+  for (const auto& method : methods_) {
+    const ProfileMethodRecord& record = method.second;
+    AppendString(&data, method.first);
+    AppendU4(&data, record.count);
+    AppendU4(&data, record.method_size);
+    AppendU2(&data, record.dex_pc_counts.size());
+    for (const auto& dex_pc_count : record.dex_pc_counts) {
+      AppendU4(&data, dex_pc_count.first);
+      AppendU4(&data, dex_pc_count.second);
+    }
+    AppendU2(&data, record.inline_caches.size());
+    for (const auto& inline_cache : record.inline_caches) {
+      AppendU4(&data, inline_cache.first);
+      AppendU1(&data, inline_cache.second.size());
+      for (const std::string& descriptor : inline_cache.second) {
+        AppendString(&data, descriptor);
+      }
+    }
+  }
+  AppendU4(&data, fields_.size());
+  for (const auto& klass : fields_) {
+    AppendString(&data, klass.first);
+    AppendU2(&data, klass.second.size());
+    for (const auto& field : klass.second) {
+      AppendString(&data, field.first);
+      AppendU4(&data, field.second);
+    }
+  }
+  return data;
+}
+
+void ProfileFile::Merge(const ProfileFile& other) {
+  AddSamples(other.num_samples_, other.num_null_methods_, other.num_boot_methods_);
+  for (const auto& method : other.methods_) {
+    const ProfileMethodRecord& other_record = method.second;
+    ProfileMethodRecord& record = methods_[method.first];
+    record.count += other_record.count;
+    if (record.method_size == 0) {
+      record.method_size = other_record.method_size;
+    }
+    for (const auto& dex_pc_count : other_record.dex_pc_counts) {
+      record.dex_pc_counts[dex_pc_count.first] += dex_pc_count.second;
+    }
+    for (const auto& inline_cache : other_record.inline_caches) {
+      std::vector<std::string>& classes = record.inline_caches[inline_cache.first];
+      for (const std::string& descriptor : inline_cache.second) {
+        if (std::find(classes.begin(), classes.end(), descriptor) == classes.end()) {
+          classes.push_back(descriptor);
+        }
+      }
+      if (classes.size() > kMaxInlineCacheClasses) {
+        // The site turned megamorphic.
+        record.inline_caches.erase(inline_cache.first);
+      }
+    }
+  }
+  for (const auto& klass : other.fields_) {
+    std::map<std::string, uint32_t>& fields = fields_[klass.first];
+    for (const auto& field : klass.second) {
+      fields[field.first] += field.second;
+    }
+  }
+}
+
+void ProfileFile::Clear() {
+  num_samples_ = 0;
+  num_null_methods_ = 0;
+  num_boot_methods_ = 0;
+  methods_.clear();
+  fields_.clear();
+}
+
+bool ProfileHelper::LoadProfileFile(ProfileFile* profile, const std::string& fileName) {
   LOG(VERBOSE) << "reading profile file " << fileName;
   struct stat st;
   int err = stat(fileName.c_str(), &st);
@@ -590,7 +899,7 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
   if (st.st_size == 0) {
     return false;  // Empty profiles are invalid.
   }
-  std::ifstream in(fileName.c_str());
+  std::ifstream in(fileName.c_str(), std::ios::binary);
   if (!in) {
     LOG(VERBOSE) << "profile file " << fileName << " exists but can't be opened";
     LOG(VERBOSE) << "file owner: " << st.st_uid << ":" << st.st_gid;
@@ -599,50 +908,33 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
     LOG(VERBOSE) << "errno: " << errno;
     return false;
   }
-  // The first line contains summary information.
-  std::string line;
-  std::getline(in, line);
-  if (in.eof()) {
-    return false;
-  }
-  std::vector<std::string> summary_info;
-  Split(line, '/', summary_info);
-  if (summary_info.size() != 3) {
-    // Bad summary info.  It should be count/total/bootpath.
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  return profile->Parse(data);
+}
+
+bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fileName) {
+  ProfileFile profile;
+  if (!LoadProfileFile(&profile, fileName)) {
     return false;
   }
   // This is the number of hits in all methods.
-  uint32_t total_count = 0;
-  for (int i = 0 ; i < 3; ++i) {
-    total_count += atoi(summary_info[i].c_str());
-  }
+  uint32_t total_count = profile.GetNumSamples() + profile.GetNumNullMethods() +
+      profile.GetNumBootMethods();
 
-  // Now read each line until the end of file.  Each line consists of 3 fields separated by '/'.
   // Store the info in descending order given by the most used methods.
-  typedef std::set<std::pair<int, std::vector<std::string>>> ProfileSet;
+  typedef std::set<std::pair<int, const ProfileFile::MethodMap::value_type*>> ProfileSet;
   ProfileSet countSet;
-  while (!in.eof()) {
-    std::getline(in, line);
-    if (in.eof()) {
-      break;
-    }
-    std::vector<std::string> info;
-    Split(line, '/', info);
-    if (info.size() != 3) {
-      // Malformed.
-      break;
-    }
-    int count = atoi(info[1].c_str());
-    countSet.insert(std::make_pair(-count, info));
+  for (const auto& method : profile.GetMethods()) {
+    countSet.insert(std::make_pair(-static_cast<int>(method.second.count), &method));
   }
 
   uint32_t curTotalCount = 0;
   ProfileSet::iterator end = countSet.end();
   const ProfileData* prevData = nullptr;
   for (ProfileSet::iterator it = countSet.begin(); it != end ; it++) {
-    const std::string& methodname = it->second[0];
-    uint32_t count = -it->first;
-    uint32_t size = atoi(it->second[2].c_str());
+    const std::string& methodname = it->second->first;
+    const ProfileMethodRecord& record = it->second->second;
+    uint32_t count = record.count;
     double usedPercent = (count * 100.0) / total_count;
 
     curTotalCount += count;
@@ -652,8 +944,8 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
       : 100 * static_cast<double>(curTotalCount) / static_cast<double>(total_count);
 
     // Add it to the profile map.
-    ProfileData curData = ProfileData(methodname, count, size, usedPercent, topKPercentage);
-    profileMap[methodname] = curData;
+    ProfileData& curData = profileMap[methodname];
+    curData = ProfileData(methodname, record, usedPercent, topKPercentage);
     prevData = &curData;
   }
   return true;
@@ -675,4 +967,75 @@ bool ProfileHelper::LoadTopKSamples(std::set<std::string>& topKSamples, const st
   return true;
 }
 
+// Returns the descriptor of the declaring class of a method named by PrettyMethod, such as
+// "void java.lang.Object.wait(long)", or an empty string if the name is malformed.
+static std::string DeclaringClassDescriptor(const std::string& method_name) {
+  size_t paren = method_name.find('(');
+  if (paren == std::string::npos) {
+    return "";
+  }
+  size_t space = method_name.rfind(' ', paren);
+  size_t start = (space == std::string::npos) ? 0 : space + 1;
+  size_t dot = method_name.rfind('.', paren);
+  if (dot == std::string::npos || dot <= start) {
+    return "";
+  }
+  return DotToDescriptor(method_name.substr(start, dot - start).c_str());
+}
+
+bool ProfileHelper::LoadClassDescriptors(std::vector<std::string>& descriptors,
+                                         const std::string& fileName) {
+  ProfileMap profileMap;
+  if (!LoadProfileMap(profileMap, fileName)) {
+    return false;
+  }
+  std::vector<const ProfileMap::value_type*> methods;
+  for (const auto& method : profileMap) {
+    methods.push_back(&method);
+  }
+  std::stable_sort(methods.begin(), methods.end(),
+                   [](const ProfileMap::value_type* a, const ProfileMap::value_type* b) {
+                     return a->second.GetCount() > b->second.GetCount();
+                   });
+  std::set<std::string> seen;
+  for (const ProfileMap::value_type* method : methods) {
+    std::string descriptor = DeclaringClassDescriptor(method->first);
+    if (!descriptor.empty() && seen.insert(descriptor).second) {
+      descriptors.push_back(descriptor);
+    }
+    for (const auto& inline_cache : method->second.GetInlineCaches()) {
+      for (const std::string& receiver : inline_cache.second) {
+        if (receiver[0] == 'L' && seen.insert(receiver).second) {
+          descriptors.push_back(receiver);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool ProfileHelper::LoadHotFields(std::map<std::string, std::vector<std::string>>& hotFields,
+                                  const std::string& fileName) {
+  ProfileFile profile;
+  if (!LoadProfileFile(&profile, fileName)) {
+    return false;
+  }
+  for (const auto& klass : profile.GetFields()) {
+    std::vector<std::pair<uint32_t, const std::string*>> counts;
+    for (const auto& field : klass.second) {
+      counts.push_back(std::make_pair(field.second, &field.first));
+    }
+    std::stable_sort(counts.begin(), counts.end(),
+                     [](const std::pair<uint32_t, const std::string*>& a,
+                        const std::pair<uint32_t, const std::string*>& b) {
+                       return a.first > b.first;
+                     });
+    std::vector<std::string>& names = hotFields[klass.first];
+    for (const auto& count : counts) {
+      names.push_back(*count.second);
+    }
+  }
+  return true;
+}
+
 }  // namespace art
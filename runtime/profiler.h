@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_PROFILER_H_
 #define ART_RUNTIME_PROFILER_H_
 
+#include <map>
 #include <ostream>
 #include <set>
 #include <string>
@@ -39,6 +40,93 @@ namespace mirror {
 }  // namespace mirror
 class Thread;
 
+// What a profile knows about one method, the profile files key it by its PrettyMethod name.
+struct ProfileMethodRecord {
+  ProfileMethodRecord() : count(0), method_size(0) {}
+
+  // Number of samples that hit the method.
+  uint32_t count;
+  // Size of the method in dex code units.
+  uint32_t method_size;
+  // Number of samples per dex pc of the method, these are its hot loops and call sites.
+  std::map<uint32_t, uint32_t> dex_pc_counts;
+  // Descriptors of the receiver classes seen by the invoke-virtual and invoke-interface
+  // instructions of the method, by dex pc. Megamorphic sites aren't recorded.
+  std::map<uint32_t, std::vector<std::string>> inline_caches;
+};
+
+//
+// The contents of a profile file. The files are written in a binary format:
+//
+//   magic "pro\0", version "002\0"
+//   u4 number of samples, u4 null method samples, u4 boot method samples, u4 number of methods
+//   for each method:
+//     u2 name length, name, u4 count, u4 method size
+//     u2 number of dex pcs, then for each: u4 dex pc, u4 count
+//     u2 number of inline caches, then for each:
+//       u4 dex pc, u1 number of classes, then for each: u2 descriptor length, descriptor
+//   u4 number of classes with sampled field accesses, then for each:
+//     u2 descriptor length, descriptor, u2 number of fields, then for each:
+//       u2 name length, name, u4 count
+//
+// Integers are little endian. Version "001" files, which end after the methods, and the text
+// format written by earlier versions of the profiler, which only has the counts of the methods,
+// can still be parsed.
+class ProfileFile {
+ public:
+  typedef std::map<std::string, ProfileMethodRecord> MethodMap;
+  // Number of samples that hit an instance field access, by field name, by the descriptor of
+  // the class declaring the field.
+  typedef std::map<std::string, std::map<std::string, uint32_t>> FieldMap;
+
+  static const uint8_t kMagic[4];
+  static const uint8_t kVersion[4];
+  static const uint8_t kVersionNoFields[4];
+
+  // Inline caches with more receiver classes are dropped when profiles are merged.
+  static constexpr size_t kMaxInlineCacheClasses = 4;
+
+  ProfileFile() : num_samples_(0), num_null_methods_(0), num_boot_methods_(0) {}
+
+  // Replaces the contents with the profile in data. Returns false if data is malformed, in which
+  // case the contents are cleared.
+  bool Parse(const std::string& data);
+
+  // Returns the profile in the binary format.
+  std::string Serialize() const;
+
+  // Adds the samples of other to this profile.
+  void Merge(const ProfileFile& other);
+
+  void Clear();
+
+  void AddSamples(uint32_t num_samples, uint32_t num_null_methods, uint32_t num_boot_methods) {
+    num_samples_ += num_samples;
+    num_null_methods_ += num_null_methods;
+    num_boot_methods_ += num_boot_methods;
+  }
+
+  uint32_t GetNumSamples() const { return num_samples_; }
+  uint32_t GetNumNullMethods() const { return num_null_methods_; }
+  uint32_t GetNumBootMethods() const { return num_boot_methods_; }
+
+  MethodMap& GetMethods() { return methods_; }
+  const MethodMap& GetMethods() const { return methods_; }
+
+  FieldMap& GetFields() { return fields_; }
+  const FieldMap& GetFields() const { return fields_; }
+
+ private:
+  bool ParseBinary(const std::string& data);
+  bool ParseText(const std::string& data);
+
+  uint32_t num_samples_;
+  uint32_t num_null_methods_;
+  uint32_t num_boot_methods_;
+  MethodMap methods_;
+  FieldMap fields_;
+};
+
 //
 // This class holds all the results for all runs of the profiler.  It also
 // counts the number of null methods (where we can't determine the method) and
@@ -51,7 +139,7 @@ class ProfileSampleResults {
   explicit ProfileSampleResults(Mutex& lock);
   ~ProfileSampleResults();
 
-  void Put(mirror::ArtMethod* method);
+  void Put(mirror::ArtMethod* method, uint32_t dex_pc);
   uint32_t Write(std::ostream &os);
   void ReadPrevious(int fd);
   void Clear();
@@ -67,21 +155,17 @@ class ProfileSampleResults {
   uint32_t num_null_methods_;     // Number of samples where can don't know the method.
   uint32_t num_boot_methods_;     // Number of samples in the boot path.
 
-  typedef std::map<mirror::ArtMethod*, uint32_t> Map;   // Map of method vs its count.
-  Map *table[kHashSize];
-
-  struct PreviousValue {
-    PreviousValue() : count_(0), method_size_(0) {}
-    PreviousValue(uint32_t count, uint32_t method_size) : count_(count), method_size_(method_size) {}
-    uint32_t count_;
-    uint32_t method_size_;
+  struct MethodSamples {
+    MethodSamples() : count(0) {}
+    uint32_t count;
+    std::map<uint32_t, uint32_t> dex_pc_counts;
   };
 
-  typedef std::map<std::string, PreviousValue> PreviousProfile;
-  PreviousProfile previous_;
-  uint32_t previous_num_samples_;
-  uint32_t previous_num_null_methods_;     // Number of samples where can don't know the method.
-  uint32_t previous_num_boot_methods_;     // Number of samples in the boot path.
+  typedef std::map<mirror::ArtMethod*, MethodSamples> Map;   // Map of method vs its samples.
+  Map *table[kHashSize];
+
+  // The profile written by the previous runs, merged with the new samples by Write.
+  ProfileFile previous_;
 };
 
 //
@@ -112,7 +196,8 @@ class BackgroundMethodSamplingProfiler {
   static void Stop() LOCKS_EXCLUDED(Locks::profiler_lock_, wait_lock_);
   static void Shutdown() LOCKS_EXCLUDED(Locks::profiler_lock_);
 
-  void RecordMethod(mirror::ArtMethod *method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void RecordMethod(mirror::ArtMethod *method, uint32_t dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   Barrier& GetBarrier() {
     return *profiler_barrier_;
@@ -194,25 +279,30 @@ class BackgroundMethodSamplingProfiler {
 // in a file.  It is used to determine whether to compile a particular method or not.
 class ProfileData {
  public:
-  ProfileData() : count_(0), method_size_(0), usedPercent_(0) {}
-  ProfileData(const std::string& method_name, uint32_t count, uint32_t method_size,
+  ProfileData() : usedPercent_(0), topKUsedPercentage_(0) {}
+  ProfileData(const std::string& method_name, const ProfileMethodRecord& record,
     double usedPercent, double topKUsedPercentage) :
-    method_name_(method_name), count_(count), method_size_(method_size),
+    method_name_(method_name), record_(record),
     usedPercent_(usedPercent), topKUsedPercentage_(topKUsedPercentage) {
-    // TODO: currently method_size_ and count_ are unused.
-    UNUSED(method_size_);
-    UNUSED(count_);
   }
 
   bool IsAbove(double v) const { return usedPercent_ >= v; }
   double GetUsedPercent() const { return usedPercent_; }
-  uint32_t GetCount() const { return count_; }
+  uint32_t GetCount() const { return record_.count; }
+  uint32_t GetMethodSize() const { return record_.method_size; }
   double GetTopKUsedPercentage() const { return topKUsedPercentage_; }
 
+  // Samples per dex pc.
+  const std::map<uint32_t, uint32_t>& GetDexPcCounts() const { return record_.dex_pc_counts; }
+
+  // Receiver class descriptors per invoke dex pc.
+  const std::map<uint32_t, std::vector<std::string>>& GetInlineCaches() const {
+    return record_.inline_caches;
+  }
+
  private:
   std::string method_name_;    // Method name.
-  uint32_t count_;             // Number of times it has been called.
-  uint32_t method_size_;       // Size of the method on dex instructions.
+  ProfileMethodRecord record_;  // Samples of the method.
   double usedPercent_;         // Percentage of how many times this method was called.
   double topKUsedPercentage_;  // The percentage of the group that comprise K% of the total used
                                // methods this methods belongs to.
@@ -234,6 +324,21 @@ class ProfileHelper {
   // topKPercentage of the total used methods.
   static bool LoadTopKSamples(std::set<std::string>& topKMethods, const std::string& fileName,
                               double topKPercentage);
+
+  // Read the profile data from the given file and appends the descriptors of the classes of the
+  // sampled methods and of the receivers seen by their call sites, hottest methods first.
+  static bool LoadClassDescriptors(std::vector<std::string>& descriptors,
+                                   const std::string& fileName);
+
+  // Read the profile data from the given file and sets the names of the sampled instance fields
+  // of each class, by class descriptor, hottest fields first.
+  static bool LoadHotFields(std::map<std::string, std::vector<std::string>>& hotFields,
+                            const std::string& fileName);
+
+ private:
+  // Reads and parses the given file. Returns false if there was no profile file or it was
+  // malformed.
+  static bool LoadProfileFile(ProfileFile* profile, const std::string& fileName);
 };
 
 }  // namespace art
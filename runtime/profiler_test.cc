@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "profiler.h"
+
+#include <string>
+
+#include "common_runtime_test.h"
+
+namespace art {
+
+class ProfilerTest : public CommonRuntimeTest {
+ protected:
+  static void MakeProfile(ProfileFile* profile) {
+    profile->AddSamples(100, 5, 20);
+    ProfileMethodRecord& hot = profile->GetMethods()["void Main.loop()"];
+    hot.count = 60;
+    hot.method_size = 40;
+    hot.dex_pc_counts[12] = 50;
+    hot.dex_pc_counts[30] = 10;
+    hot.inline_caches[18].push_back("LMain$Circle;");
+    hot.inline_caches[18].push_back("LMain$Square;");
+    ProfileMethodRecord& cold = profile->GetMethods()["int Main.cold(int)"];
+    cold.count = 15;
+    cold.method_size = 8;
+    std::map<std::string, uint32_t>& fields = profile->GetFields()["LMain$Circle;"];
+    fields["radius"] = 30;
+    fields["x"] = 12;
+  }
+};
+
+TEST_F(ProfilerTest, RoundTripsBinaryFormat) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  std::string data = profile.Serialize();
+  ASSERT_EQ(0, memcmp(data.data(), ProfileFile::kMagic, sizeof(ProfileFile::kMagic)));
+
+  ProfileFile parsed;
+  ASSERT_TRUE(parsed.Parse(data));
+  EXPECT_EQ(100U, parsed.GetNumSamples());
+  EXPECT_EQ(5U, parsed.GetNumNullMethods());
+  EXPECT_EQ(20U, parsed.GetNumBootMethods());
+  ASSERT_EQ(2U, parsed.GetMethods().size());
+  const ProfileMethodRecord& hot = parsed.GetMethods()["void Main.loop()"];
+  EXPECT_EQ(60U, hot.count);
+  EXPECT_EQ(40U, hot.method_size);
+  EXPECT_TRUE(hot.dex_pc_counts == profile.GetMethods()["void Main.loop()"].dex_pc_counts);
+  ASSERT_EQ(1U, hot.inline_caches.size());
+  ASSERT_EQ(2U, hot.inline_caches.at(18).size());
+  EXPECT_EQ("LMain$Square;", hot.inline_caches.at(18)[1]);
+  EXPECT_TRUE(parsed.GetFields() == profile.GetFields());
+
+  // Truncated profiles are rejected.
+  EXPECT_FALSE(parsed.Parse(data.substr(0, data.size() - 1)));
+  EXPECT_TRUE(parsed.GetMethods().empty());
+}
+
+TEST_F(ProfilerTest, ParsesTextFormat) {
+  ProfileFile profile;
+  ASSERT_TRUE(profile.Parse("100/5/20\nvoid Main.loop()/60/40\nint Main.cold(int)/15/8\n"));
+  EXPECT_EQ(100U, profile.GetNumSamples());
+  ASSERT_EQ(2U, profile.GetMethods().size());
+  EXPECT_EQ(15U, profile.GetMethods()["int Main.cold(int)"].count);
+  EXPECT_TRUE(profile.GetMethods()["void Main.loop()"].dex_pc_counts.empty());
+
+  EXPECT_FALSE(profile.Parse("garbage"));
+}
+
+TEST_F(ProfilerTest, MergesProfiles) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  ProfileFile other;
+  MakeProfile(&other);
+  std::vector<std::string>& classes = other.GetMethods()["void Main.loop()"].inline_caches[18];
+  classes.push_back("LMain$Triangle;");
+  classes.push_back("LMain$Hexagon;");
+  classes.push_back("LMain$Star;");
+  other.GetMethods()["void Main.loop()"].inline_caches[24].push_back("LMain$Circle;");
+
+  profile.Merge(other);
+  EXPECT_EQ(200U, profile.GetNumSamples());
+  const ProfileMethodRecord& hot = profile.GetMethods()["void Main.loop()"];
+  EXPECT_EQ(120U, hot.count);
+  EXPECT_EQ(100U, hot.dex_pc_counts.at(12));
+  // The site at 18 saw too many receiver classes.
+  EXPECT_EQ(0U, hot.inline_caches.count(18));
+  EXPECT_EQ(1U, hot.inline_caches.at(24).size());
+  EXPECT_EQ(60U, profile.GetFields()["LMain$Circle;"]["radius"]);
+}
+
+TEST_F(ProfilerTest, LoadsProfileMap) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  ScratchFile file;
+  std::string data = profile.Serialize();
+  ASSERT_TRUE(file.GetFile()->WriteFully(data.data(), data.size()));
+
+  ProfileMap profile_map;
+  ASSERT_TRUE(ProfileHelper::LoadProfileMap(profile_map, file.GetFilename()));
+  ASSERT_EQ(2U, profile_map.size());
+  const ProfileData& hot = profile_map["void Main.loop()"];
+  EXPECT_EQ(60U, hot.GetCount());
+  EXPECT_DOUBLE_EQ(48.0, hot.GetUsedPercent());
+  EXPECT_DOUBLE_EQ(48.0, hot.GetTopKUsedPercentage());
+  EXPECT_EQ(50U, hot.GetDexPcCounts().at(12));
+  EXPECT_EQ(2U, hot.GetInlineCaches().at(18).size());
+  EXPECT_DOUBLE_EQ(60.0, profile_map["int Main.cold(int)"].GetTopKUsedPercentage());
+}
+
+TEST_F(ProfilerTest, LoadsClassDescriptors) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  profile.GetMethods()["java.lang.String com.example.Other.name(int, long)"].count = 5;
+  ScratchFile file;
+  std::string data = profile.Serialize();
+  ASSERT_TRUE(file.GetFile()->WriteFully(data.data(), data.size()));
+
+  std::vector<std::string> descriptors;
+  ASSERT_TRUE(ProfileHelper::LoadClassDescriptors(descriptors, file.GetFilename()));
+  ASSERT_EQ(4U, descriptors.size());
+  EXPECT_EQ("LMain;", descriptors[0]);
+  EXPECT_EQ("LMain$Circle;", descriptors[1]);
+  EXPECT_EQ("LMain$Square;", descriptors[2]);
+  EXPECT_EQ("Lcom/example/Other;", descriptors[3]);
+}
+
+TEST_F(ProfilerTest, LoadsHotFields) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  profile.GetFields()["LMain$Circle;"]["y"] = 50;
+  ScratchFile file;
+  std::string data = profile.Serialize();
+  ASSERT_TRUE(file.GetFile()->WriteFully(data.data(), data.size()));
+
+  std::map<std::string, std::vector<std::string>> hot_fields;
+  ASSERT_TRUE(ProfileHelper::LoadHotFields(hot_fields, file.GetFilename()));
+  ASSERT_EQ(1U, hot_fields.size());
+  const std::vector<std::string>& names = hot_fields["LMain$Circle;"];
+  ASSERT_EQ(3U, names.size());
+  EXPECT_EQ("y", names[0]);
+  EXPECT_EQ("radius", names[1]);
+  EXPECT_EQ("x", names[2]);
+}
+
+TEST_F(ProfilerTest, ParsesVersionWithoutFields) {
+  ProfileFile profile;
+  MakeProfile(&profile);
+  profile.GetFields().clear();
+  std::string data = profile.Serialize();
+  // Drop the empty field section and rewrite the version.
+  data.resize(data.size() - 4);
+  memcpy(&data[sizeof(ProfileFile::kMagic)], ProfileFile::kVersionNoFields,
+         sizeof(ProfileFile::kVersionNoFields));
+
+  ProfileFile parsed;
+  ASSERT_TRUE(parsed.Parse(data));
+  EXPECT_EQ(2U, parsed.GetMethods().size());
+  EXPECT_TRUE(parsed.GetFields().empty());
+}
+
+}  // namespace art
@@ -89,7 +89,7 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
   DCHECK(verifier != nullptr);
   DCHECK_EQ(Runtime::Current()->IsCompiler(), method != nullptr);
   DCHECK_EQ(verifier->CanLoadClasses(), method != nullptr);
-  // We currently support only plain return or 2-instruction methods.
+  // We currently support only plain return, 2-instruction methods and short int expressions.
 
   const DexFile::CodeItem* code_item = verifier->CodeItem();
   DCHECK_NE(code_item->insns_size_in_code_units_, 0u);
@@ -113,7 +113,7 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
     case Instruction::CONST_16:
     case Instruction::CONST_HIGH16:
       // TODO: Support wide constants (RETURN_WIDE).
-      return AnalyseConstMethod(code_item, method);
+      return AnalyseConstMethod(code_item, method) || AnalyseExpressionMethod(verifier, method);
     case Instruction::IGET:
     case Instruction::IGET_OBJECT:
     case Instruction::IGET_BOOLEAN:
@@ -131,7 +131,7 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
     case Instruction::IPUT_WIDE:
       return AnalyseIPutMethod(verifier, method);
     default:
-      return false;
+      return AnalyseExpressionMethod(verifier, method);
   }
 }
 
@@ -326,6 +326,91 @@ bool InlineMethodAnalyser::AnalyseIPutMethod(verifier::MethodVerifier* verifier,
   return true;
 }
 
+bool InlineMethodAnalyser::AnalyseExpressionMethod(verifier::MethodVerifier* verifier,
+                                                   InlineMethod* result) {
+  // Only static methods computing an int from int arguments, so that the inlined code
+  // needs neither a null check nor a register pair.
+  const DexFile::CodeItem* code_item = verifier->CodeItem();
+  if ((verifier->GetAccessFlags() & kAccStatic) == 0u ||
+      code_item->tries_size_ != 0u ||
+      code_item->insns_size_in_code_units_ > kMaxExpressionCodeUnits) {
+    return false;
+  }
+  MethodReference ref = verifier->GetMethodReference();
+  const DexFile::MethodId& method_id = ref.dex_file->GetMethodId(ref.dex_method_index);
+  const char* shorty = ref.dex_file->GetMethodShorty(method_id);
+  for (const char* c = shorty; *c != '\0'; ++c) {
+    if (strchr("IZBSC", *c) == nullptr) {
+      return false;
+    }
+  }
+
+  // The code must be a single block of non-throwing int operations, writing a single local
+  // register, the accumulator, which is returned at the end.
+  uint32_t arg_start = code_item->registers_size_ - code_item->ins_size_;
+  uint32_t accumulator = DexFile::kDexNoIndex16;
+  uint32_t dex_pc = 0u;
+  const Instruction* instruction = Instruction::At(code_item->insns_);
+  while (instruction->Opcode() != Instruction::RETURN) {
+    switch (instruction->Opcode()) {
+      case Instruction::DIV_INT:
+      case Instruction::REM_INT:
+      case Instruction::DIV_INT_2ADDR:
+      case Instruction::REM_INT_2ADDR:
+      case Instruction::DIV_INT_LIT16:
+      case Instruction::REM_INT_LIT16:
+      case Instruction::DIV_INT_LIT8:
+      case Instruction::REM_INT_LIT8:
+        return false;
+      case Instruction::CONST_4:
+      case Instruction::CONST_16:
+      case Instruction::CONST:
+      case Instruction::CONST_HIGH16:
+      case Instruction::MOVE:
+      case Instruction::MOVE_FROM16:
+      case Instruction::MOVE_16:
+      case Instruction::NEG_INT:
+      case Instruction::NOT_INT:
+      case Instruction::INT_TO_BYTE:
+      case Instruction::INT_TO_CHAR:
+      case Instruction::INT_TO_SHORT:
+        break;
+      default:
+        if ((Instruction::ADD_INT <= instruction->Opcode() &&
+                instruction->Opcode() <= Instruction::USHR_INT) ||
+            (Instruction::ADD_INT_2ADDR <= instruction->Opcode() &&
+                instruction->Opcode() <= Instruction::USHR_INT_2ADDR) ||
+            (Instruction::ADD_INT_LIT16 <= instruction->Opcode() &&
+                instruction->Opcode() <= Instruction::USHR_INT_LIT8)) {
+          break;
+        }
+        return false;
+    }
+    uint32_t reg = instruction->VRegA();
+    if (reg >= arg_start || (accumulator != DexFile::kDexNoIndex16 && reg != accumulator)) {
+      return false;
+    }
+    accumulator = reg;
+    dex_pc += instruction->SizeInCodeUnits();
+    instruction = instruction->Next();
+  }
+  if (accumulator == DexFile::kDexNoIndex16 || instruction->VRegA_11x() != accumulator) {
+    // A plain return is handled by AnalyseReturnMethod().
+    return false;
+  }
+
+  if (result != nullptr) {
+    result->opcode = kInlineOpExpression;
+    result->flags = kInlineSpecial;
+    InlineExpressionData* data = &result->d.expression_data;
+    data->code_item_offset =
+        reinterpret_cast<const uint8_t*>(code_item) - ref.dex_file->Begin();
+    data->accumulator = accumulator;
+    data->insns_size = dex_pc;
+  }
+  return true;
+}
+
 bool InlineMethodAnalyser::ComputeSpecialAccessorInfo(uint32_t field_idx, bool is_put,
                                                       verifier::MethodVerifier* verifier,
                                                       InlineIGetIPutData* result) {
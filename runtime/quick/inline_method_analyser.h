@@ -43,12 +43,27 @@ enum InlineMethodOpcode : uint16_t {
   kIntrinsicAbsFloat,
   kIntrinsicAbsDouble,
   kIntrinsicMinMaxInt,
+  kIntrinsicMinMaxLong,
+  kIntrinsicMinMaxFloat,
+  kIntrinsicMinMaxDouble,
   kIntrinsicSqrt,
+  kIntrinsicCeil,
+  kIntrinsicFloor,
+  kIntrinsicRint,
+  kIntrinsicRoundFloat,
+  kIntrinsicRoundDouble,
+  kIntrinsicNumberOfLeadingZeros,
+  kIntrinsicNumberOfTrailingZeros,
+  kIntrinsicBitCount,
+  kIntrinsicRotateRight,
+  kIntrinsicRotateLeft,
   kIntrinsicCharAt,
   kIntrinsicCompareTo,
+  kIntrinsicEquals,
   kIntrinsicIsEmptyOrLength,
   kIntrinsicIndexOf,
   kIntrinsicCurrentThread,
+  kIntrinsicSystemArrayCopyCharArray,
   kIntrinsicPeek,
   kIntrinsicPoke,
   kIntrinsicCas,
@@ -60,6 +75,7 @@ enum InlineMethodOpcode : uint16_t {
   kInlineOpNonWideConst,
   kInlineOpIGet,
   kInlineOpIPut,
+  kInlineOpExpression,
 };
 std::ostream& operator<<(std::ostream& os, const InlineMethodOpcode& rhs);
 
@@ -73,7 +89,7 @@ enum InlineMethodFlags : uint16_t {
 enum IntrinsicFlags {
   kIntrinsicFlagNone = 0,
 
-  // kIntrinsicMinMaxInt
+  // kIntrinsicMinMaxInt, kIntrinsicMinMaxLong, kIntrinsicMinMaxFloat, kIntrinsicMinMaxDouble
   kIntrinsicFlagMax = kIntrinsicFlagNone,
   kIntrinsicFlagMin = 1,
 
@@ -84,7 +100,8 @@ enum IntrinsicFlags {
   // kIntrinsicIndexOf
   kIntrinsicFlagBase0 = kIntrinsicFlagMin,
 
-  // kIntrinsicUnsafeGet, kIntrinsicUnsafePut, kIntrinsicUnsafeCas
+  // kIntrinsicUnsafeGet, kIntrinsicUnsafePut, kIntrinsicUnsafeCas, kIntrinsicNumberOfLeadingZeros,
+  // kIntrinsicNumberOfTrailingZeros, kIntrinsicBitCount, kIntrinsicRotateRight, kIntrinsicRotateLeft
   kIntrinsicFlagIsLong     = kIntrinsicFlagMin,
   // kIntrinsicUnsafeGet, kIntrinsicUnsafePut
   kIntrinsicFlagIsVolatile = 2,
@@ -118,6 +135,14 @@ struct InlineReturnArgData {
 };
 COMPILE_ASSERT(sizeof(InlineReturnArgData) == sizeof(uint64_t), InvalidSizeOfInlineReturnArgData);
 
+struct InlineExpressionData {
+  uint32_t code_item_offset;  // Offset of the method's code item in its dex file.
+  uint16_t accumulator;  // The only register written by the method, and returned.
+  uint16_t insns_size;  // Size of the method's code in code units, excluding the return.
+};
+COMPILE_ASSERT(sizeof(InlineExpressionData) == sizeof(uint64_t),
+               InvalidSizeOfInlineExpressionData);
+
 struct InlineMethod {
   InlineMethodOpcode opcode;
   InlineMethodFlags flags;
@@ -125,6 +150,7 @@ struct InlineMethod {
     uint64_t data;
     InlineIGetIPutData ifield_data;
     InlineReturnArgData return_data;
+    InlineExpressionData expression_data;
   } d;
 };
 
@@ -157,6 +183,9 @@ class InlineMethodAnalyser {
     return opcode - Instruction::IPUT;
   }
 
+  // The maximum size, in code units, of a method inlined as an expression.
+  static constexpr uint32_t kMaxExpressionCodeUnits = 16u;
+
   // Determines whether the method is a synthetic accessor (method name starts with "access$").
   static bool IsSyntheticAccessor(MethodReference ref);
 
@@ -167,6 +196,7 @@ class InlineMethodAnalyser {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static bool AnalyseIPutMethod(verifier::MethodVerifier* verifier, InlineMethod* result)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool AnalyseExpressionMethod(verifier::MethodVerifier* verifier, InlineMethod* result);
 
   // Can we fast path instance field access in a verified accessor?
   // If yes, computes field's offset and volatility and whether the method is static or not.
@@ -32,8 +32,13 @@ inline MirrorType* ReadBarrier::Barrier(
   UNUSED(ref_addr);
   const bool with_read_barrier = kReadBarrierOption == kWithReadBarrier;
   if (with_read_barrier && kUseBakerReadBarrier) {
-    // To be implemented.
-    return ref_addr->AsMirrorPtr();
+    MirrorType* ref = ref_addr->AsMirrorPtr();
+    if (UNLIKELY(IsMarking())) {
+      // The concurrent copying collector is running, make sure we only ever see to-space
+      // references.
+      ref = reinterpret_cast<MirrorType*>(Mark(ref));
+    }
+    return ref;
   } else if (with_read_barrier && kUseBrooksReadBarrier) {
     // To be implemented.
     return ref_addr->AsMirrorPtr();
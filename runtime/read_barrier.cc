@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_barrier.h"
+
+#include "gc/collector/concurrent_copying.h"
+#include "gc/heap.h"
+#include "runtime.h"
+#include "thread.h"
+#include "thread_list.h"
+
+namespace art {
+
+volatile bool ReadBarrier::is_marking_ = false;
+
+void ReadBarrier::SetIsMarking(bool is_marking) {
+  is_marking_ = is_marking;
+  // Threads registering from now on pick up the new state in ThreadList::Register.
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    thread->SetReadBarrierMarking(is_marking);
+  }
+}
+
+mirror::Object* ReadBarrier::Mark(mirror::Object* ref) {
+  return Runtime::Current()->GetHeap()->ConcurrentCopyingCollector()->Mark(ref);
+}
+
+}  // namespace art
@@ -37,6 +37,21 @@ class ReadBarrier {
   ALWAYS_INLINE static MirrorType* Barrier(
       mirror::Object* obj, MemberOffset offset, mirror::HeapReference<MirrorType>* ref_addr)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether the concurrent copying collector is marking, in which case the read barrier has to
+  // forward the references it loads.
+  ALWAYS_INLINE static bool IsMarking() {
+    return is_marking_;
+  }
+  // Also switches the read barrier entrypoints of all threads, whose compiled code only calls
+  // into the runtime while the entrypoint is set.
+  static void SetIsMarking(bool is_marking) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // The read barrier slow path, returns the to-space reference of ref.
+  static mirror::Object* Mark(mirror::Object* ref) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  static volatile bool is_marking_;
 };
 
 }  // namespace art
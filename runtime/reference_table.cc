@@ -140,6 +140,10 @@ size_t ReferenceTable::Size() const {
   return entries_.size();
 }
 
+void ReferenceTable::Clear() {
+  entries_.clear();
+}
+
 void ReferenceTable::Dump(std::ostream& os) const {
   os << name_ << " reference table dump:\n";
   Dump(os, entries_);
@@ -45,6 +45,8 @@ class ReferenceTable {
 
   size_t Size() const;
 
+  void Clear();
+
   void Dump(std::ostream& os) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void VisitRoots(RootCallback* visitor, void* arg, uint32_t tid, RootType root_type);
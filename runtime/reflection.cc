@@ -34,6 +34,111 @@
 
 namespace art {
 
+// Returns the type of the primitive boxed by o and sets the zero initialized value to it, or
+// returns kPrimNot if o isn't a box. A box is recognized by its value field rather than by
+// comparing descriptors.
+static Primitive::Type GetBoxedPrimitiveType(mirror::Object* o, JValue* value)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::Class* klass = o->GetClass();
+  if (klass->NumInstanceFields() == 0) {
+    return Primitive::kPrimNot;
+  }
+  mirror::ArtField* f = klass->GetInstanceField(0);
+  Primitive::Type type = FieldHelper(f).GetTypeAsPrimitiveType();
+  jfieldID value_field;
+  switch (type) {
+    case Primitive::kPrimBoolean:
+      value_field = WellKnownClasses::java_lang_Boolean_value;
+      break;
+    case Primitive::kPrimByte:
+      value_field = WellKnownClasses::java_lang_Byte_value;
+      break;
+    case Primitive::kPrimChar:
+      value_field = WellKnownClasses::java_lang_Character_value;
+      break;
+    case Primitive::kPrimShort:
+      value_field = WellKnownClasses::java_lang_Short_value;
+      break;
+    case Primitive::kPrimInt:
+      value_field = WellKnownClasses::java_lang_Integer_value;
+      break;
+    case Primitive::kPrimLong:
+      value_field = WellKnownClasses::java_lang_Long_value;
+      break;
+    case Primitive::kPrimFloat:
+      value_field = WellKnownClasses::java_lang_Float_value;
+      break;
+    case Primitive::kPrimDouble:
+      value_field = WellKnownClasses::java_lang_Double_value;
+      break;
+    default:
+      return Primitive::kPrimNot;
+  }
+  // Field IDs are ArtField pointers, fields don't move.
+  if (f != reinterpret_cast<mirror::ArtField*>(value_field)) {
+    return Primitive::kPrimNot;
+  }
+  switch (type) {
+    case Primitive::kPrimBoolean:
+      value->SetZ(f->GetBoolean(o));
+      break;
+    case Primitive::kPrimByte:
+      value->SetB(f->GetByte(o));
+      break;
+    case Primitive::kPrimChar:
+      value->SetC(f->GetChar(o));
+      break;
+    case Primitive::kPrimShort:
+      value->SetS(f->GetShort(o));
+      break;
+    case Primitive::kPrimInt:
+      value->SetI(f->GetInt(o));
+      break;
+    case Primitive::kPrimLong:
+      value->SetJ(f->GetLong(o));
+      break;
+    case Primitive::kPrimFloat:
+      value->SetF(f->GetFloat(o));
+      break;
+    default:
+      value->SetD(f->GetDouble(o));
+      break;
+  }
+  return type;
+}
+
+// Whether reflection converts a primitive of the src type to the dst type, which it does for the
+// identity and the widening primitive conversions. The same conversions are done by
+// ConvertPrimitiveValue.
+static bool IsPrimitiveWideningConversion(Primitive::Type src, Primitive::Type dst) {
+  if (src == Primitive::kPrimNot || dst == Primitive::kPrimNot) {
+    return false;
+  }
+  if (src == dst) {
+    return true;
+  }
+  switch (dst) {
+    case Primitive::kPrimShort:
+      return src == Primitive::kPrimByte;
+    case Primitive::kPrimInt:
+      return src == Primitive::kPrimByte || src == Primitive::kPrimChar ||
+          src == Primitive::kPrimShort;
+    case Primitive::kPrimLong:
+      return src == Primitive::kPrimByte || src == Primitive::kPrimChar ||
+          src == Primitive::kPrimShort || src == Primitive::kPrimInt;
+    case Primitive::kPrimFloat:
+      return src == Primitive::kPrimByte || src == Primitive::kPrimChar ||
+          src == Primitive::kPrimShort || src == Primitive::kPrimInt ||
+          src == Primitive::kPrimLong;
+    case Primitive::kPrimDouble:
+      return src == Primitive::kPrimByte || src == Primitive::kPrimChar ||
+          src == Primitive::kPrimShort || src == Primitive::kPrimInt ||
+          src == Primitive::kPrimLong || src == Primitive::kPrimFloat;
+    default:
+      return false;
+  }
+}
+
 class ArgArray {
  public:
   explicit ArgArray(const char* shorty, uint32_t shorty_len)
@@ -209,14 +314,6 @@ class ArgArray {
     }
   }
 
-  static void ThrowIllegalPrimitiveArgumentException(const char* expected,
-                                                     const StringPiece& found_descriptor)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    ThrowIllegalArgumentException(nullptr,
-        StringPrintf("Invalid primitive conversion from %s to %s", expected,
-                     PrettyDescriptor(found_descriptor.as_string()).c_str()).c_str());
-  }
-
   bool BuildArgArrayFromObjectArray(const ScopedObjectAccess& soa, mirror::Object* receiver,
                                     mirror::ObjectArray<mirror::Object>* args, MethodHelper& mh)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -240,98 +337,41 @@ class ArgArray {
           return false;
         }
       }
-
-#define DO_FIRST_ARG(match_descriptor, get_fn, append) { \
-          const StringPiece src_descriptor(arg != nullptr \
-              ? ClassHelper(arg->GetClass<>()).GetDescriptor() \
-              : "null"); \
-          if (LIKELY(src_descriptor == match_descriptor)) { \
-            mirror::ArtField* primitive_field = arg->GetClass()->GetIFields()->Get(0); \
-            append(primitive_field-> get_fn(arg));
-
-#define DO_ARG(match_descriptor, get_fn, append) \
-          } else if (LIKELY(src_descriptor == match_descriptor)) { \
-            mirror::ArtField* primitive_field = arg->GetClass()->GetIFields()->Get(0); \
-            append(primitive_field-> get_fn(arg));
-
-#define DO_FAIL(expected) \
-          } else { \
-            if (arg->GetClass<>()->IsPrimitive()) { \
-              ThrowIllegalPrimitiveArgumentException(expected, src_descriptor); \
-            } else { \
-              ThrowIllegalArgumentException(nullptr, \
-                  StringPrintf("method %s argument %zd has type %s, got %s", \
-                      PrettyMethod(mh.GetMethod(), false).c_str(), \
-                      args_offset + 1, \
-                      expected, \
-                      PrettyTypeOf(arg).c_str()).c_str()); \
-            } \
-            return false; \
-          } }
-
-      switch (shorty_[i]) {
-        case 'L':
-          Append(arg);
-          break;
-        case 'Z':
-          DO_FIRST_ARG("Ljava/lang/Boolean;", GetBoolean, Append)
-          DO_FAIL("boolean")
-          break;
-        case 'B':
-          DO_FIRST_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("byte")
-          break;
-        case 'C':
-          DO_FIRST_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_FAIL("char")
-          break;
-        case 'S':
-          DO_FIRST_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("short")
-          break;
-        case 'I':
-          DO_FIRST_ARG("Ljava/lang/Integer;", GetInt, Append)
-          DO_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("int")
-          break;
-        case 'J':
-          DO_FIRST_ARG("Ljava/lang/Long;", GetLong, AppendWide)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendWide)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendWide)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendWide)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendWide)
-          DO_FAIL("long")
+      if (shorty_[i] == 'L') {
+        Append(arg);
+        continue;
+      }
+      // Unbox the argument and widen it to the parameter type.
+      Primitive::Type dst_type = Primitive::GetType(shorty_[i]);
+      JValue boxed_value;
+      Primitive::Type src_type = GetBoxedPrimitiveType(arg, &boxed_value);
+      JValue value;
+      if (UNLIKELY(!IsPrimitiveWideningConversion(src_type, dst_type))) {
+        ThrowIllegalArgumentException(nullptr,
+            StringPrintf("method %s argument %zd has type %s, got %s",
+                PrettyMethod(mh.GetMethod(), false).c_str(),
+                args_offset + 1,
+                PrettyDescriptor(dst_type).c_str(),
+                PrettyTypeOf(arg).c_str()).c_str());
+        return false;
+      }
+      bool converted = ConvertPrimitiveValue(nullptr, false, src_type, dst_type, boxed_value,
+                                             &value);
+      DCHECK(converted);
+      switch (dst_type) {
+        case Primitive::kPrimLong:
+          AppendWide(value.GetJ());
           break;
-        case 'F':
-          DO_FIRST_ARG("Ljava/lang/Float;", GetFloat, AppendFloat)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendFloat)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendFloat)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendFloat)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendFloat)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendFloat)
-          DO_FAIL("float")
+        case Primitive::kPrimFloat:
+          AppendFloat(value.GetF());
           break;
-        case 'D':
-          DO_FIRST_ARG("Ljava/lang/Double;", GetDouble, AppendDouble)
-          DO_ARG("Ljava/lang/Float;", GetFloat, AppendDouble)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendDouble)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendDouble)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendDouble)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendDouble)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendDouble)
-          DO_FAIL("double")
+        case Primitive::kPrimDouble:
+          AppendDouble(value.GetD());
           break;
-#ifndef NDEBUG
         default:
-          LOG(FATAL) << "Unexpected shorty character: " << shorty_[i];
-#endif
+          Append(value.GetI());
+          break;
       }
-#undef DO_FIRST_ARG
-#undef DO_ARG
-#undef DO_FAIL
     }
     return true;
   }
@@ -521,15 +561,16 @@ jobject InvokeMethod(const ScopedObjectAccess& soa, jobject javaMethod,
   if (soa.Self()->IsExceptionPending()) {
     jthrowable th = soa.Env()->ExceptionOccurred();
     soa.Env()->ExceptionClear();
-    jclass exception_class = soa.Env()->FindClass("java/lang/reflect/InvocationTargetException");
-    jmethodID mid = soa.Env()->GetMethodID(exception_class, "<init>", "(Ljava/lang/Throwable;)V");
-    jobject exception_instance = soa.Env()->NewObject(exception_class, mid, th);
+    jobject exception_instance =
+        soa.Env()->NewObject(WellKnownClasses::java_lang_reflect_InvocationTargetException,
+                             WellKnownClasses::java_lang_reflect_InvocationTargetException_init,
+                             th);
     soa.Env()->Throw(reinterpret_cast<jthrowable>(exception_instance));
     return NULL;
   }
 
-  // Box if necessary and return.
-  return soa.AddLocalReference<jobject>(BoxPrimitive(mh.GetReturnType()->GetPrimitiveType(),
+  // Box if necessary and return. The shorty gives the return type without resolving its class.
+  return soa.AddLocalReference<jobject>(BoxPrimitive(Primitive::GetType(mh.GetShorty()[0]),
                                                      result));
 }
 
@@ -741,45 +782,18 @@ static bool UnboxPrimitive(const ThrowLocation* throw_location, mirror::Object*
   }
 
   JValue boxed_value;
-  const StringPiece src_descriptor(ClassHelper(o->GetClass()).GetDescriptor());
-  mirror::Class* src_class = nullptr;
-  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  mirror::ArtField* primitive_field = o->GetClass()->GetIFields()->Get(0);
-  if (src_descriptor == "Ljava/lang/Boolean;") {
-    src_class = class_linker->FindPrimitiveClass('Z');
-    boxed_value.SetZ(primitive_field->GetBoolean(o));
-  } else if (src_descriptor == "Ljava/lang/Byte;") {
-    src_class = class_linker->FindPrimitiveClass('B');
-    boxed_value.SetB(primitive_field->GetByte(o));
-  } else if (src_descriptor == "Ljava/lang/Character;") {
-    src_class = class_linker->FindPrimitiveClass('C');
-    boxed_value.SetC(primitive_field->GetChar(o));
-  } else if (src_descriptor == "Ljava/lang/Float;") {
-    src_class = class_linker->FindPrimitiveClass('F');
-    boxed_value.SetF(primitive_field->GetFloat(o));
-  } else if (src_descriptor == "Ljava/lang/Double;") {
-    src_class = class_linker->FindPrimitiveClass('D');
-    boxed_value.SetD(primitive_field->GetDouble(o));
-  } else if (src_descriptor == "Ljava/lang/Integer;") {
-    src_class = class_linker->FindPrimitiveClass('I');
-    boxed_value.SetI(primitive_field->GetInt(o));
-  } else if (src_descriptor == "Ljava/lang/Long;") {
-    src_class = class_linker->FindPrimitiveClass('J');
-    boxed_value.SetJ(primitive_field->GetLong(o));
-  } else if (src_descriptor == "Ljava/lang/Short;") {
-    src_class = class_linker->FindPrimitiveClass('S');
-    boxed_value.SetS(primitive_field->GetShort(o));
-  } else {
+  Primitive::Type src_type = GetBoxedPrimitiveType(o, &boxed_value);
+  if (UNLIKELY(src_type == Primitive::kPrimNot)) {
     ThrowIllegalArgumentException(throw_location,
                                   StringPrintf("%s has type %s, got %s",
                                                UnboxingFailureKind(f).c_str(),
                                                PrettyDescriptor(dst_class).c_str(),
-                                               PrettyDescriptor(src_descriptor.data()).c_str()).c_str());
+                                               PrettyTypeOf(o).c_str()).c_str());
     return false;
   }
 
   return ConvertPrimitiveValue(throw_location, unbox_for_result,
-                               src_class->GetPrimitiveType(), dst_class->GetPrimitiveType(),
+                               src_type, dst_class->GetPrimitiveType(),
                                boxed_value, unboxed_value);
 }
 
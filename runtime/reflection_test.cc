@@ -20,7 +20,9 @@
 #include <limits.h>
 
 #include "common_compiler_test.h"
+#include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
+#include "well_known_classes.h"
 
 namespace art {
 
@@ -625,4 +627,39 @@ TEST_F(ReflectionTest, NonStaticSumDoubleDoubleDoubleDoubleDoubleMethod) {
   InvokeSumDoubleDoubleDoubleDoubleDoubleMethod(false);
 }
 
+TEST_F(ReflectionTest, UnboxPrimitive) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* integer_class = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Integer;");
+  ASSERT_TRUE(integer_class != nullptr);
+  SirtRef<mirror::Object> boxed(soa.Self(), integer_class->AllocObject(soa.Self()));
+  ASSERT_TRUE(boxed.get() != nullptr);
+  soa.DecodeField(WellKnownClasses::java_lang_Integer_value)->SetInt<false>(boxed.get(), -42);
+  ThrowLocation throw_location;
+
+  // Identity and widening conversions.
+  JValue value;
+  EXPECT_TRUE(UnboxPrimitiveForResult(throw_location, boxed.get(),
+                                      class_linker_->FindPrimitiveClass('I'), &value));
+  EXPECT_EQ(-42, value.GetI());
+  EXPECT_TRUE(UnboxPrimitiveForResult(throw_location, boxed.get(),
+                                      class_linker_->FindPrimitiveClass('J'), &value));
+  EXPECT_EQ(-42, value.GetJ());
+  EXPECT_TRUE(UnboxPrimitiveForResult(throw_location, boxed.get(),
+                                      class_linker_->FindPrimitiveClass('D'), &value));
+  EXPECT_EQ(-42.0, value.GetD());
+  EXPECT_FALSE(soa.Self()->IsExceptionPending());
+
+  // Narrowing conversions fail.
+  EXPECT_FALSE(UnboxPrimitiveForResult(throw_location, boxed.get(),
+                                       class_linker_->FindPrimitiveClass('S'), &value));
+  EXPECT_TRUE(soa.Self()->IsExceptionPending());
+  soa.Self()->ClearException();
+
+  // Objects that aren't boxes fail, even when their class has a primitive field.
+  EXPECT_FALSE(UnboxPrimitiveForResult(throw_location, integer_class,
+                                       class_linker_->FindPrimitiveClass('I'), &value));
+  EXPECT_TRUE(soa.Self()->IsExceptionPending());
+  soa.Self()->ClearException();
+}
+
 }  // namespace art
@@ -26,6 +26,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <sstream>
 #include <limits>
 #include <vector>
 #include <fcntl.h>
@@ -36,15 +37,24 @@
 #include "arch/x86/registers_x86.h"
 #include "arch/x86_64/registers_x86_64.h"
 #include "atomic.h"
+#include "base/arena_allocator.h"
+#include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "debugger.h"
 #include "gc/accounting/card_table-inl.h"
+#include "gc/allocation_sampler.h"
 #include "gc/heap.h"
 #include "gc/space/space.h"
 #include "image.h"
 #include "instrumentation.h"
 #include "intern_table.h"
+#include "interpreter/inline_cache.h"
+#include "interpreter/interpreter.h"
+#include "jit/jit.h"
 #include "jni_internal.h"
+#include "lock_profiler.h"
+#include "mem_map.h"
+#include "metrics_page.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/array.h"
@@ -55,14 +65,18 @@
 #include "monitor.h"
 #include "parsed_options.h"
 #include "oat_file.h"
+#include "os.h"
 #include "reflection.h"
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
 #include "signal_catcher.h"
+#include "signal_sampler.h"
 #include "signal_set.h"
 #include "sirt_ref.h"
+#include "startup_class_verifier.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "transaction.h"
 #include "profiler.h"
@@ -87,11 +101,11 @@ Runtime::Runtime()
     : pre_allocated_OutOfMemoryError_(nullptr),
       resolution_method_(nullptr),
       imt_conflict_method_(nullptr),
-      default_imt_(nullptr),
       compiler_callbacks_(nullptr),
       is_zygote_(false),
       is_concurrent_gc_enabled_(true),
       is_explicit_gc_disabled_(false),
+      is_heap_dump_in_child_(false),
       default_stack_size_(0),
       heap_(nullptr),
       max_spins_before_thin_lock_inflation_(Monitor::kDefaultMaxSpinsBeforeThinLockInflation),
@@ -100,7 +114,12 @@ Runtime::Runtime()
       thread_list_(nullptr),
       intern_table_(nullptr),
       class_linker_(nullptr),
+      arena_pool_(nullptr),
       signal_catcher_(nullptr),
+      low_pause_sigquit_(false),
+      metrics_page_(nullptr),
+      metrics_page_interval_ms_(0),
+      class_unloading_(false),
       java_vm_(nullptr),
       fault_message_lock_("Fault message lock"),
       fault_message_(""),
@@ -134,7 +153,14 @@ Runtime::Runtime()
       null_pointer_handler_(nullptr),
       suspend_handler_(nullptr),
       stack_overflow_handler_(nullptr),
-      verify_(false) {
+      verify_(false),
+      compact_dex_cache_fields_(false),
+      relocate_image_(false),
+      cache_decompressed_image_(false),
+      inline_caches_(nullptr),
+      jit_(nullptr),
+      startup_verify_threads_(0),
+      startup_class_verifier_(nullptr) {
   for (int i = 0; i < Runtime::kLastCalleeSaveType; i++) {
     callee_save_methods_[i] = nullptr;
   }
@@ -158,22 +184,31 @@ Runtime::~Runtime() {
     shutting_down_ = true;
   }
   Trace::Shutdown();
+  SignalSampler::Stop();
 
   // Make sure to let the GC complete if it is running.
   heap_->WaitForGcToComplete(gc::kGcCauseBackground, self);
   heap_->DeleteThreadPool();
+  if (jit_ != nullptr) {
+    jit_->DeleteThreadPool();
+  }
+  delete startup_class_verifier_;
 
   // Make sure our internal threads are dead before we start tearing down things they're using.
   Dbg::StopJdwp();
   delete signal_catcher_;
+  delete metrics_page_;
 
   // Make sure all other non-daemon threads have terminated, and all daemon threads are suspended.
   delete thread_list_;
+  delete jit_;
+  delete inline_caches_;
   delete monitor_list_;
   delete monitor_pool_;
   delete class_linker_;
   delete heap_;
   delete intern_table_;
+  delete arena_pool_;
   delete java_vm_;
   Thread::Shutdown();
   QuasiAtomic::Shutdown();
@@ -282,6 +317,11 @@ void Runtime::Abort() {
 
 void Runtime::PreZygoteFork() {
   heap_->PreZygoteFork();
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_linker_->PreZygoteFork();
+  }
+  intern_table_->PreZygoteFork();
 }
 
 void Runtime::CallExitHook(jint status) {
@@ -292,11 +332,92 @@ void Runtime::CallExitHook(jint status) {
   }
 }
 
-void Runtime::SweepSystemWeaks(IsMarkedCallback* visitor, void* arg) {
-  GetInternTable()->SweepInternTableWeaks(visitor, arg);
-  GetMonitorList()->SweepMonitorList(visitor, arg);
-  GetJavaVM()->SweepJniWeakGlobals(visitor, arg);
-  Dbg::UpdateObjectPointers(visitor, arg);
+class SweepSystemWeakTableTask : public Task {
+ public:
+  enum Table {
+    kInternTable,
+    kMonitorList,
+    kInlineCaches,
+    kDebugger,
+    kAllocationSamples,
+  };
+
+  SweepSystemWeakTableTask(Table table, IsMarkedCallback* visitor, void* arg)
+      : table_(table), visitor_(visitor), arg_(arg) {}
+
+  // The GC thread holds the mutator lock for the workers.
+  virtual void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    Runtime* runtime = Runtime::Current();
+    switch (table_) {
+      case kInternTable:
+        runtime->GetInternTable()->SweepInternTableWeaks(visitor_, arg_);
+        break;
+      case kMonitorList:
+        runtime->GetMonitorList()->SweepMonitorList(visitor_, arg_);
+        break;
+      case kInlineCaches:
+        runtime->GetInlineCaches()->Sweep(visitor_, arg_);
+        break;
+      case kDebugger:
+        Dbg::UpdateObjectPointers(visitor_, arg_);
+        break;
+      case kAllocationSamples:
+        runtime->GetHeap()->GetAllocationSampler()->SweepSamples(visitor_, arg_);
+        break;
+    }
+  }
+
+  virtual void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const Table table_;
+  IsMarkedCallback* const visitor_;
+  void* const arg_;
+};
+
+bool Runtime::CanUnloadClasses() {
+  // The allocation sampler keeps the methods of its stacks, the signal sampler their dex files.
+  return class_unloading_ && !instrumentation_.IsActive() && !Dbg::IsDebuggerActive() &&
+      GetHeap()->GetAllocationSampler() == nullptr && !SignalSampler::HasSamples();
+}
+
+void Runtime::SweepSystemWeaks(IsMarkedCallback* visitor, void* arg, ThreadPool* thread_pool) {
+  // The class loaders first, the classes they unload are then swept from the other tables.
+  GetClassLinker()->SweepClassLoaders(visitor, arg);
+  if (thread_pool == nullptr) {
+    GetInternTable()->SweepInternTableWeaks(visitor, arg);
+    GetMonitorList()->SweepMonitorList(visitor, arg);
+    GetInlineCaches()->Sweep(visitor, arg);
+    GetJavaVM()->SweepJniWeakGlobals(visitor, arg);
+    Dbg::UpdateObjectPointers(visitor, arg);
+    if (GetHeap()->GetAllocationSampler() != nullptr) {
+      GetHeap()->GetAllocationSampler()->SweepSamples(visitor, arg);
+    }
+    return;
+  }
+  Thread* self = Thread::Current();
+  // The tables have their own locks and are swept by different workers.
+  thread_pool->AddTask(self, new SweepSystemWeakTableTask(SweepSystemWeakTableTask::kInternTable,
+                                                          visitor, arg));
+  thread_pool->AddTask(self, new SweepSystemWeakTableTask(SweepSystemWeakTableTask::kMonitorList,
+                                                          visitor, arg));
+  thread_pool->AddTask(self, new SweepSystemWeakTableTask(SweepSystemWeakTableTask::kInlineCaches,
+                                                          visitor, arg));
+  thread_pool->AddTask(self, new SweepSystemWeakTableTask(SweepSystemWeakTableTask::kDebugger,
+                                                          visitor, arg));
+  if (GetHeap()->GetAllocationSampler() != nullptr) {
+    thread_pool->AddTask(self, new SweepSystemWeakTableTask(
+        SweepSystemWeakTableTask::kAllocationSamples, visitor, arg));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_pool->GetThreadCount());
+  thread_pool->StartWorkers(self);
+  // Adds its chunks to the running workers, unless the weak globals are too few to split.
+  GetJavaVM()->SweepJniWeakGlobals(visitor, arg, thread_pool);
+  // StopWorkers doesn't wait, the tables must all be swept before the pause ends.
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
 }
 
 bool Runtime::Create(const Options& options, bool ignore_unrecognized) {
@@ -358,6 +479,7 @@ jobject CreateSystemClassLoader() {
 
 bool Runtime::Start() {
   VLOG(startup) << "Runtime::Start entering";
+  StartupSplit("Runtime::Start");
 
   // Restore main thread state to kNative as expected by native code.
   Thread* self = Thread::Current();
@@ -370,24 +492,34 @@ bool Runtime::Start() {
   InitNativeMethods();
 
   // Initialize well known thread group values that may be accessed threads while attaching.
+  StartupSplit("Runtime::InitThreadGroups");
   InitThreadGroups(self);
 
+  StartupSplit("Thread::FinishStartup");
   Thread::FinishStartup();
 
   if (is_zygote_) {
+    StartupSplit("Runtime::InitZygote");
     if (!InitZygote()) {
       return false;
     }
   } else {
+    StartupSplit("Runtime::DidForkFromZygote");
     DidForkFromZygote();
   }
 
+  StartupSplit("Runtime::StartDaemonThreads");
   StartDaemonThreads();
 
+  StartupSplit("CreateSystemClassLoader");
   system_class_loader_ = CreateSystemClassLoader();
 
   self->GetJniEnv()->locals.AssertEmpty();
 
+  if (startup_timings_.get() != nullptr) {
+    DumpStartupTimings();
+  }
+
   VLOG(startup) << "Runtime::Start exiting";
 
   finished_starting_ = true;
@@ -405,6 +537,26 @@ bool Runtime::Start() {
   return true;
 }
 
+void Runtime::DumpStartupTimings() {
+  startup_timings_->EndSplit();
+  std::ostringstream os;
+  uint64_t start_ns = 0;
+  for (const TimingLogger::SplitTiming& split : startup_timings_->GetSplits()) {
+    os << start_ns << " " << split.first << " " << split.second << "\n";
+    start_ns += split.first;
+  }
+  startup_timings_.reset();
+  UniquePtr<File> file(OS::CreateEmptyFile(startup_timings_file_.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create startup timings file " << startup_timings_file_;
+    return;
+  }
+  std::string timeline(os.str());
+  if (!file->WriteFully(timeline.data(), timeline.size())) {
+    PLOG(WARNING) << "Failed to write startup timings file " << startup_timings_file_;
+  }
+}
+
 void Runtime::EndThreadBirth() EXCLUSIVE_LOCKS_REQUIRED(Locks::runtime_shutdown_lock_) {
   DCHECK_GT(threads_being_born_, 0U);
   threads_being_born_--;
@@ -452,8 +604,12 @@ void Runtime::DidForkFromZygote() {
 
   // Create the thread pool.
   heap_->CreateThreadPool();
+  if (jit_ != nullptr) {
+    jit_->CreateThreadPool();
+  }
 
   StartSignalCatcher();
+  StartMetricsPage();
 
   // Start the JDWP thread. If the command-line debugger flags specified "suspend=y",
   // this will pause the runtime, so we probably want this to come last.
@@ -462,7 +618,17 @@ void Runtime::DidForkFromZygote() {
 
 void Runtime::StartSignalCatcher() {
   if (!is_zygote_) {
-    signal_catcher_ = new SignalCatcher(stack_trace_file_);
+    signal_catcher_ = new SignalCatcher(stack_trace_file_, low_pause_sigquit_);
+  }
+}
+
+void Runtime::StartMetricsPage() {
+  if (!is_zygote_ && !metrics_page_dir_.empty()) {
+    std::string error_msg;
+    metrics_page_ = MetricsPage::Create(metrics_page_dir_, metrics_page_interval_ms_, &error_msg);
+    if (metrics_page_ == nullptr) {
+      LOG(WARNING) << error_msg;
+    }
   }
 }
 
@@ -500,6 +666,12 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   }
   VLOG(startup) << "Runtime::Init -verbose:startup enabled";
 
+  startup_timings_file_ = options->startup_timings_file_;
+  if (!startup_timings_file_.empty()) {
+    startup_timings_.reset(new TimingLogger("Startup", true, false));
+  }
+  StartupSplit("Runtime::Init");
+
   QuasiAtomic::Startup();
 
   Monitor::Init(options->lock_profiling_threshold_, options->hook_is_sensitive_thread_);
@@ -511,6 +683,7 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   compiler_callbacks_ = options->compiler_callbacks_;
   is_zygote_ = options->is_zygote_;
   is_explicit_gc_disabled_ = options->is_explicit_gc_disabled_;
+  is_heap_dump_in_child_ = options->heap_dump_in_child_;
 
   vfprintf_ = options->hook_vfprintf_;
   exit_ = options->hook_exit_;
@@ -518,6 +691,9 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
 
   default_stack_size_ = options->stack_size_;
   stack_trace_file_ = options->stack_trace_file_;
+  low_pause_sigquit_ = options->low_pause_sigquit_;
+  metrics_page_dir_ = options->metrics_page_dir_;
+  metrics_page_interval_ms_ = options->metrics_page_interval_ms_;
 
   compiler_options_ = options->compiler_options_;
   image_compiler_options_ = options->image_compiler_options_;
@@ -525,43 +701,58 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   max_spins_before_thin_lock_inflation_ = options->max_spins_before_thin_lock_inflation_;
 
   monitor_list_ = new MonitorList;
+  inline_caches_ = new interpreter::InlineCacheTable;
   monitor_pool_ = MonitorPool::Create();
   thread_list_ = new ThreadList;
   intern_table_ = new InternTable;
+  arena_pool_ = new ArenaPool;
 
   verify_ = options->verify_;
+  compact_dex_cache_fields_ = options->compact_dex_cache_fields_;
+  relocate_image_ = options->relocate_image_;
+  cache_decompressed_image_ = options->cache_decompressed_image_;
 
   if (options->interpreter_only_) {
     GetInstrumentation()->ForceInterpretOnly();
   }
+  interpreter::SetInterpreterImplKind(options->interpreter_impl_kind_);
 
-  bool implicit_checks_supported = false;
+  const uint32_t all_explicit_checks = ParsedOptions::kExplicitSuspendCheck |
+      ParsedOptions::kExplicitNullCheck | ParsedOptions::kExplicitStackOverflowCheck;
+  // The checks which can be implicit on this ISA.
+  uint32_t implicit_checks_supported = 0;
   switch (kRuntimeISA) {
   case kArm:
   case kThumb2:
-    implicit_checks_supported = true;
+    implicit_checks_supported = all_explicit_checks;
+    break;
+  case kX86:
+  case kX86_64:
+    // The null pointer handler would need to decode any faulting instruction.
+    implicit_checks_supported = ParsedOptions::kExplicitSuspendCheck |
+        ParsedOptions::kExplicitStackOverflowCheck;
     break;
   default:
     break;
   }
+  const uint32_t explicit_checks = options->explicit_checks_ | ~implicit_checks_supported;
 
-  if (implicit_checks_supported &&
-    (options->explicit_checks_ != (ParsedOptions::kExplicitSuspendCheck |
-        ParsedOptions::kExplicitNullCheck |
-        ParsedOptions::kExplicitStackOverflowCheck) || kEnableJavaStackTraceHandler)) {
+  if (implicit_checks_supported != 0 &&
+    ((explicit_checks & all_explicit_checks) != all_explicit_checks ||
+        kEnableJavaStackTraceHandler)) {
     fault_manager.Init();
 
     // These need to be in a specific order.  The null point check handler must be
     // after the suspend check and stack overflow check handlers.
-    if ((options->explicit_checks_ & ParsedOptions::kExplicitSuspendCheck) == 0) {
+    if ((explicit_checks & ParsedOptions::kExplicitSuspendCheck) == 0) {
       suspend_handler_ = new SuspensionHandler(&fault_manager);
     }
 
-    if ((options->explicit_checks_ & ParsedOptions::kExplicitStackOverflowCheck) == 0) {
+    if ((explicit_checks & ParsedOptions::kExplicitStackOverflowCheck) == 0) {
       stack_overflow_handler_ = new StackOverflowHandler(&fault_manager);
     }
 
-    if ((options->explicit_checks_ & ParsedOptions::kExplicitNullCheck) == 0) {
+    if ((explicit_checks & ParsedOptions::kExplicitNullCheck) == 0) {
       null_pointer_handler_ = new NullPointerHandler(&fault_manager);
     }
 
@@ -570,6 +761,8 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
     }
   }
 
+  MemMap::SetUseTransparentHugePages(options->use_transparent_huge_pages_);
+  StartupSplit("Heap::Heap");
   heap_ = new gc::Heap(options->heap_initial_size_,
                        options->heap_growth_limit_,
                        options->heap_min_free_,
@@ -583,20 +776,29 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
                        options->background_collector_type_,
                        options->parallel_gc_threads_,
                        options->conc_gc_threads_,
+                       options->numa_aware_gc_threads_,
+                       options->native_allocation_pacing_,
                        options->low_memory_mode_,
                        options->long_pause_log_threshold_,
                        options->long_gc_log_threshold_,
+                       options->pause_time_target_,
+                       options->gc_time_percent_target_,
                        options->ignore_max_footprint_,
                        options->use_tlab_,
+                       options->rosalloc_thread_local_brackets_,
+                       options->soft_ref_lru_policy_ms_per_mb_,
                        options->verify_pre_gc_heap_,
                        options->verify_pre_sweeping_heap_,
                        options->verify_post_gc_heap_,
                        options->verify_pre_gc_rosalloc_,
                        options->verify_pre_sweeping_rosalloc_,
-                       options->verify_post_gc_rosalloc_);
+                       options->verify_post_gc_rosalloc_,
+                       options->heap_sample_interval_,
+                       options->heap_sample_file_);
 
   dump_gc_performance_on_shutdown_ = options->dump_gc_performance_on_shutdown_;
 
+  StartupSplit("Thread::Startup");
   BlockSignals();
   InitPlatformSignalHandlers();
 
@@ -620,15 +822,32 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   CHECK_GE(GetHeap()->GetContinuousSpaces().size(), 1U);
   class_linker_ = new ClassLinker(intern_table_);
   if (GetHeap()->HasImageSpace()) {
+    StartupSplit("ClassLinker::InitFromImage");
     class_linker_->InitFromImage();
   } else {
     CHECK(options->boot_class_path_ != NULL);
     CHECK_NE(options->boot_class_path_->size(), 0U);
+    StartupSplit("ClassLinker::InitFromCompiler");
     class_linker_->InitFromCompiler(*options->boot_class_path_);
   }
   CHECK(class_linker_ != NULL);
+  StartupSplit("Runtime::Init late");
   verifier::MethodVerifier::Init();
 
+  // The JIT needs compiled code to be allowed, and is of no use to the compiler itself.
+  if (options->use_jit_ && !options->interpreter_only_ &&
+      options->compiler_callbacks_ == nullptr) {
+    std::string error_msg;
+    jit_ = jit::Jit::Create(options->jit_compile_threshold_, options->jit_code_cache_capacity_,
+                            &error_msg);
+    if (jit_ == nullptr) {
+      LOG(WARNING) << "Failed to create the jit, methods without code stay interpreted: "
+                   << error_msg;
+    }
+  }
+
+  startup_verify_threads_ = options->startup_verify_threads_;
+
   method_trace_ = options->method_trace_;
   method_trace_file_ = options->method_trace_file_;
   method_trace_file_size_ = options->method_trace_file_size_;
@@ -641,13 +860,15 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   profile_backoff_coefficient_ = options->profile_backoff_coefficient_;
   profile_start_immediately_ = options->profile_start_immediately_;
   profile_ = options->profile_;
+  class_unloading_ = options->class_unloading_ && options->compiler_callbacks_ == nullptr &&
+      jit_ == nullptr && !profile_;
   profile_output_filename_ = options->profile_output_filename_;
   // TODO: move this to just be an Trace::Start argument
   Trace::SetDefaultClockSource(options->profile_clock_source_);
 
   if (options->method_trace_) {
-    Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_, 0,
-                 false, false, 0);
+    Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_,
+                 options->method_trace_stream_ ? Trace::kTraceStreaming : 0, false, false, 0);
   }
 
   // Pre-allocate an OutOfMemoryError for the double-OOME case.
@@ -671,10 +892,12 @@ void Runtime::InitNativeMethods() {
 
   // First set up JniConstants, which is used by both the runtime's built-in native
   // methods and libcore.
+  StartupSplit("WellKnownClasses::Init");
   JniConstants::init(env);
   WellKnownClasses::Init(env);
 
   // Then set up the native methods provided by the runtime itself.
+  StartupSplit("Runtime::InitNativeMethods");
   RegisterRuntimeNativeMethods(env);
 
   // Then set up libcore, which is just a regular JNI library with a regular JNI_OnLoad.
@@ -692,6 +915,7 @@ void Runtime::InitNativeMethods() {
   }
 
   // Initialize well known classes that may invoke runtime native methods.
+  StartupSplit("WellKnownClasses::LateInit");
   WellKnownClasses::LateInit(env);
 
   VLOG(startup) << "Runtime::InitNativeMethods exiting";
@@ -758,14 +982,23 @@ void Runtime::RegisterRuntimeNativeMethods(JNIEnv* env) {
 }
 
 void Runtime::DumpForSigQuit(std::ostream& os) {
+  DumpSummaryForSigQuit(os);
+  thread_list_->DumpForSigQuit(os);
+  BaseMutex::DumpAll(os);
+  if (LockProfiler::HasProfile()) {
+    LockProfiler::Dump(os);
+  }
+}
+
+void Runtime::DumpSummaryForSigQuit(std::ostream& os) {
   GetClassLinker()->DumpForSigQuit(os);
   GetInternTable()->DumpForSigQuit(os);
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
+  if (jit_ != nullptr) {
+    jit_->DumpInfo(os);
+  }
   os << "\n";
-
-  thread_list_->DumpForSigQuit(os);
-  BaseMutex::DumpAll(os);
 }
 
 void Runtime::DumpLockHolders(std::ostream& os) {
@@ -823,6 +1056,9 @@ int32_t Runtime::GetStat(int kind) {
   case KIND_CLASS_INIT_TIME:
     // Convert ns to us, reduce to 32 bits.
     return static_cast<int>(stats->class_init_time_ns / 1000);
+  case KIND_GC_FOR_ALLOC_TIME:
+    // Convert ns to us, reduce to 32 bits.
+    return static_cast<int>(stats->gc_for_alloc_time_ns / 1000);
   case KIND_EXT_ALLOCATED_OBJECTS:
   case KIND_EXT_ALLOCATED_BYTES:
   case KIND_EXT_FREED_OBJECTS:
@@ -913,9 +1149,6 @@ void Runtime::VisitNonThreadRoots(RootCallback* callback, void* arg) {
   if (HasImtConflictMethod()) {
     callback(reinterpret_cast<mirror::Object**>(&imt_conflict_method_), arg, 0, kRootVMInternal);
   }
-  if (HasDefaultImt()) {
-    callback(reinterpret_cast<mirror::Object**>(&default_imt_), arg, 0, kRootVMInternal);
-  }
   for (int i = 0; i < Runtime::kLastCalleeSaveType; i++) {
     if (callee_save_methods_[i] != nullptr) {
       callback(reinterpret_cast<mirror::Object**>(&callee_save_methods_[i]), arg, 0,
@@ -944,16 +1177,6 @@ void Runtime::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags
   VisitNonConcurrentRoots(callback, arg);
 }
 
-mirror::ObjectArray<mirror::ArtMethod>* Runtime::CreateDefaultImt(ClassLinker* cl) {
-  Thread* self = Thread::Current();
-  SirtRef<mirror::ObjectArray<mirror::ArtMethod> > imtable(self, cl->AllocArtMethodArray(self, 64));
-  mirror::ArtMethod* imt_conflict_method = Runtime::Current()->GetImtConflictMethod();
-  for (size_t i = 0; i < static_cast<size_t>(imtable->GetLength()); i++) {
-    imtable->Set<false>(i, imt_conflict_method);
-  }
-  return imtable.get();
-}
-
 mirror::ArtMethod* Runtime::CreateImtConflictMethod() {
   Thread* self = Thread::Current();
   Runtime* runtime = Runtime::Current();
@@ -1119,17 +1342,25 @@ mirror::ArtMethod* Runtime::CreateCalleeSaveMethod(InstructionSet instruction_se
 }
 
 void Runtime::DisallowNewSystemWeaks() {
+  class_linker_->DisallowNewClassLoaders();
   monitor_list_->DisallowNewMonitors();
   intern_table_->DisallowNewInterns();
   java_vm_->DisallowNewWeakGlobals();
   Dbg::DisallowNewObjectRegistryObjects();
+  if (heap_->GetAllocationSampler() != nullptr) {
+    heap_->GetAllocationSampler()->DisallowNewSamples();
+  }
 }
 
 void Runtime::AllowNewSystemWeaks() {
+  class_linker_->AllowNewClassLoaders();
   monitor_list_->AllowNewMonitors();
   intern_table_->AllowNewInterns();
   java_vm_->AllowNewWeakGlobals();
   Dbg::AllowNewObjectRegistryObjects();
+  if (heap_->GetAllocationSampler() != nullptr) {
+    heap_->GetAllocationSampler()->AllowNewSamples();
+  }
 }
 
 void Runtime::SetCalleeSaveMethod(mirror::ArtMethod* method, CalleeSaveType type) {
@@ -1173,6 +1404,19 @@ void Runtime::StartProfiler(const char* appDir, const char* procName) {
       procName, profile_interval_us_, profile_backoff_coefficient_, profile_start_immediately_);
 }
 
+void Runtime::VerifyStartupClasses(jobject class_loader,
+                                   const std::vector<std::string>& descriptors) {
+  if (startup_verify_threads_ == 0 || !IsVerificationEnabled() || descriptors.empty()) {
+    return;
+  }
+  if (startup_class_verifier_ == nullptr) {
+    startup_class_verifier_ = new StartupClassVerifier(startup_verify_threads_);
+  }
+  VLOG(startup) << "Verifying " << descriptors.size() << " startup classes on "
+                << startup_verify_threads_ << " threads";
+  startup_class_verifier_->Enqueue(Thread::Current(), class_loader, descriptors);
+}
+
 // Transaction support.
 void Runtime::EnterTransactionMode(Transaction* transaction) {
   DCHECK(IsCompiler());
@@ -1295,8 +1539,15 @@ void Runtime::AddCurrentRuntimeFeaturesAsDex2OatArguments(std::vector<std::strin
   argv->push_back("--instruction-set=mips");
 #endif
 
+  // The code is compiled for this device, it can use what the CPU supports beyond the features
+  // the build defaults to.
   std::string features("--instruction-set-features=");
   features += GetDefaultInstructionSetFeatures();
+  InstructionSetFeatures cpu_features = InstructionSetFeatures::GuessInstructionSetFeatures();
+  if (cpu_features != InstructionSetFeatures()) {
+    features += ",";
+    features += cpu_features.GetFeatureString();
+  }
   argv->push_back(features);
 }
 
@@ -27,6 +27,7 @@
 
 #include "base/macros.h"
 #include "base/stringpiece.h"
+#include "base/timing_logger.h"
 #include "gc/collector_type.h"
 #include "gc/heap.h"
 #include "globals.h"
@@ -43,6 +44,12 @@ namespace art {
 namespace gc {
   class Heap;
 }
+namespace interpreter {
+  class InlineCacheTable;
+}  // namespace interpreter
+namespace jit {
+  class Jit;
+}  // namespace jit
 namespace mirror {
   class ArtMethod;
   class ClassLoader;
@@ -56,6 +63,7 @@ namespace mirror {
 namespace verifier {
 class MethodVerifier;
 }
+class ArenaPool;
 class ClassLinker;
 class CompilerCallbacks;
 class DexFile;
@@ -63,8 +71,11 @@ class InternTable;
 class JavaVMExt;
 class MonitorList;
 class MonitorPool;
+class MetricsPage;
 class SignalCatcher;
+class StartupClassVerifier;
 class ThreadList;
+class ThreadPool;
 class Trace;
 class Transaction;
 
@@ -77,6 +88,9 @@ enum VisitRootFlags : uint8_t {
   kVisitRootFlagStartLoggingNewRoots = 0x4,
   kVisitRootFlagStopLoggingNewRoots = 0x8,
   kVisitRootFlagClearRootLog = 0x10,
+  // The classes of class loaders other than the boot class loader aren't roots, see
+  // ClassLinker::VisitClassLoaderClasses.
+  kVisitRootFlagClassUnloading = 0x20,
 };
 
 class Runtime {
@@ -103,6 +117,11 @@ class Runtime {
     return is_explicit_gc_disabled_;
   }
 
+  // Whether heap dumps are written by a forked copy of the process.
+  bool IsHeapDumpInChild() const {
+    return is_heap_dump_in_child_;
+  }
+
   const std::vector<std::string>& GetCompilerOptions() const {
     return compiler_options_;
   }
@@ -168,6 +187,9 @@ class Runtime {
 
   void DumpForSigQuit(std::ostream& os)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // The part of the SIGQUIT dump that describes the runtime rather than its threads.
+  void DumpSummaryForSigQuit(std::ostream& os)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DumpLockHolders(std::ostream& os);
 
   ~Runtime();
@@ -201,6 +223,11 @@ class Runtime {
     return java_vm_;
   }
 
+  // Arenas for short lived allocations of the runtime, such as the state of method verifiers.
+  ArenaPool* GetArenaPool() const {
+    return arena_pool_;
+  }
+
   size_t GetMaxSpinsBeforeThinkLockInflation() const {
     return max_spins_before_thin_lock_inflation_;
   }
@@ -224,6 +251,37 @@ class Runtime {
     return thread_list_;
   }
 
+  // The inline caches of the call sites run by the interpreter.
+  interpreter::InlineCacheTable* GetInlineCaches() const {
+    return inline_caches_;
+  }
+
+  // The shared metrics page, null unless enabled with -Xmetrics-page.
+  MetricsPage* GetMetricsPage() const {
+    return metrics_page_;
+  }
+
+  // The JIT compiler, null unless enabled with -Xjit.
+  jit::Jit* GetJit() const {
+    return jit_;
+  }
+
+  // Whether the classes of unreachable class loaders may be unloaded at all: not by the compiler,
+  // and not with the JIT or the profiler, which keep methods without keeping their classes alive.
+  // Disabled with -XX:DisableClassUnloading.
+  bool IsClassUnloadingEnabled() const {
+    return class_unloading_;
+  }
+
+  // Whether a collection starting now may unload classes, which it may not while methods are
+  // instrumented, a debugger is attached, or a sampler holds methods or dex files.
+  bool CanUnloadClasses();
+
+  // Loads and verifies the given classes of class_loader on background threads, so that the
+  // main thread doesn't verify them during startup. Does nothing unless enabled with
+  // -Xstartupverifythreads.
+  void VerifyStartupClasses(jobject class_loader, const std::vector<std::string>& descriptors);
+
   static const char* GetVersion() {
     return "2.0.0";
   }
@@ -250,8 +308,9 @@ class Runtime {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Sweep system weaks, the system weak is deleted if the visitor return nullptr. Otherwise, the
-  // system weak is updated to be the visitor's returned value.
-  void SweepSystemWeaks(IsMarkedCallback* visitor, void* arg)
+  // system weak is updated to be the visitor's returned value. If thread_pool is not null, the
+  // tables are swept in parallel on it and visitor must be thread safe.
+  void SweepSystemWeaks(IsMarkedCallback* visitor, void* arg, ThreadPool* thread_pool = nullptr)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Constant roots are the roots which never change after the runtime is initialized, they only
@@ -291,23 +350,6 @@ class Runtime {
 
   mirror::ArtMethod* CreateImtConflictMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Returns an imt with every entry set to conflict, used as default imt for all classes.
-  mirror::ObjectArray<mirror::ArtMethod>* GetDefaultImt() const {
-    CHECK(HasDefaultImt());
-    return default_imt_;
-  }
-
-  bool HasDefaultImt() const {
-    return default_imt_ != NULL;
-  }
-
-  void SetDefaultImt(mirror::ObjectArray<mirror::ArtMethod>* imt) {
-    default_imt_ = imt;
-  }
-
-  mirror::ObjectArray<mirror::ArtMethod>* CreateDefaultImt(ClassLinker* cl)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-
   // Returns a special method that describes all callee saves being spilled to the stack.
   enum CalleeSaveType {
     kSaveAll,
@@ -429,6 +471,32 @@ class Runtime {
     return verify_;
   }
 
+  // Whether the dex caches of the dex files loaded at runtime use a fixed size field cache. See
+  // mirror::DexCache::kCompactResolvedFieldsSize.
+  bool UseCompactDexCacheFields() const {
+    return compact_dex_cache_fields_;
+  }
+
+  // Whether the boot image is mapped at a random offset from the address it was compiled for.
+  // See gc::space::ImageSpace::Init.
+  bool ShouldRelocateImage() const {
+    return relocate_image_;
+  }
+
+  // Whether a compressed boot image is decompressed once into the dalvik-cache rather than at
+  // each start. See gc::space::ImageSpace::Create.
+  bool ShouldCacheDecompressedImage() const {
+    return cache_decompressed_image_;
+  }
+
+  // Ends the current startup split and starts the one given by label when -Xstartup-timings was
+  // given, see DumpStartupTimings.
+  void StartupSplit(const char* label) {
+    if (startup_timings_.get() != nullptr) {
+      startup_timings_->NewSplit(label);
+    }
+  }
+
   bool RunningOnValgrind() const {
     return running_on_valgrind_;
   }
@@ -451,7 +519,11 @@ class Runtime {
   void RegisterRuntimeNativeMethods(JNIEnv* env);
 
   void StartDaemonThreads();
+  // Writes the startup splits to the -Xstartup-timings file, one "<start ns> <duration ns>
+  // <label>" line per split with the start relative to the first split.
+  void DumpStartupTimings();
   void StartSignalCatcher();
+  void StartMetricsPage();
 
   // A pointer to the active runtime or NULL.
   static Runtime* instance_;
@@ -466,12 +538,12 @@ class Runtime {
   mirror::Throwable* pre_allocated_OutOfMemoryError_;
   mirror::ArtMethod* resolution_method_;
   mirror::ArtMethod* imt_conflict_method_;
-  mirror::ObjectArray<mirror::ArtMethod>* default_imt_;
 
   CompilerCallbacks* compiler_callbacks_;
   bool is_zygote_;
   bool is_concurrent_gc_enabled_;
   bool is_explicit_gc_disabled_;
+  bool is_heap_dump_in_child_;
 
   std::vector<std::string> compiler_options_;
   std::vector<std::string> image_compiler_options_;
@@ -496,8 +568,17 @@ class Runtime {
 
   ClassLinker* class_linker_;
 
+  ArenaPool* arena_pool_;
+
   SignalCatcher* signal_catcher_;
   std::string stack_trace_file_;
+  bool low_pause_sigquit_;
+
+  MetricsPage* metrics_page_;
+  std::string metrics_page_dir_;
+  uint32_t metrics_page_interval_ms_;
+
+  bool class_unloading_;
 
   JavaVMExt* java_vm_;
 
@@ -576,6 +657,23 @@ class Runtime {
   // If false, verification is disabled. True by default.
   bool verify_;
 
+  bool compact_dex_cache_fields_;
+
+  bool relocate_image_;
+  bool cache_decompressed_image_;
+
+  // The splits from Runtime::Init to the end of Runtime::Start, only with -Xstartup-timings.
+  UniquePtr<TimingLogger> startup_timings_;
+  std::string startup_timings_file_;
+
+  interpreter::InlineCacheTable* inline_caches_;
+
+  jit::Jit* jit_;
+
+  // The number of threads verifying startup classes, 0 if disabled.
+  size_t startup_verify_threads_;
+  StartupClassVerifier* startup_class_verifier_;
+
   DISALLOW_COPY_AND_ASSIGN(Runtime);
 };
 
@@ -30,6 +30,7 @@ enum StatKinds {
   KIND_GC_INVOCATIONS         = 1<<4,
   KIND_CLASS_INIT_COUNT       = 1<<5,
   KIND_CLASS_INIT_TIME        = 1<<6,
+  KIND_GC_FOR_ALLOC_TIME      = 1<<7,
 
   // These values exist for backward compatibility.
   KIND_EXT_ALLOCATED_OBJECTS = 1<<12,
@@ -44,6 +45,7 @@ enum StatKinds {
   KIND_GLOBAL_GC_INVOCATIONS      = KIND_GC_INVOCATIONS,
   KIND_GLOBAL_CLASS_INIT_COUNT    = KIND_CLASS_INIT_COUNT,
   KIND_GLOBAL_CLASS_INIT_TIME     = KIND_CLASS_INIT_TIME,
+  KIND_GLOBAL_GC_FOR_ALLOC_TIME   = KIND_GC_FOR_ALLOC_TIME,
 
   KIND_THREAD_ALLOCATED_OBJECTS   = KIND_ALLOCATED_OBJECTS << 16,
   KIND_THREAD_ALLOCATED_BYTES     = KIND_ALLOCATED_BYTES << 16,
@@ -51,6 +53,7 @@ enum StatKinds {
   KIND_THREAD_FREED_BYTES         = KIND_FREED_BYTES << 16,
 
   KIND_THREAD_GC_INVOCATIONS      = KIND_GC_INVOCATIONS << 16,
+  KIND_THREAD_GC_FOR_ALLOC_TIME   = KIND_GC_FOR_ALLOC_TIME << 16,
 
   // TODO: failedAllocCount, failedAllocSize
 };
@@ -86,6 +89,9 @@ struct PACKED(4) RuntimeStats {
     if ((flags & KIND_CLASS_INIT_TIME) != 0) {
       class_init_time_ns = 0;
     }
+    if ((flags & KIND_GC_FOR_ALLOC_TIME) != 0) {
+      gc_for_alloc_time_ns = 0;
+    }
   }
 
   // Number of objects allocated.
@@ -106,6 +112,9 @@ struct PACKED(4) RuntimeStats {
   // Cumulative time spent in class initialization.
   uint64_t class_init_time_ns;
 
+  // Cumulative time allocations waited for a GC to complete or ran one.
+  uint64_t gc_for_alloc_time_ns;
+
   DISALLOW_COPY_AND_ASSIGN(RuntimeStats);
 };
 
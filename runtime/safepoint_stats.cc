@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "safepoint_stats.h"
+
+#include <ostream>
+
+#include "base/histogram-inl.h"
+#include "mirror/art_method-inl.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+static constexpr uint64_t kInitialBucketWidthUs = 10;
+
+SafepointStats::SafepointStats()
+    : lock_("safepoint stats lock"),
+      suspend_all_times_("SuspendAll time to safepoint", kInitialBucketWidthUs),
+      checkpoint_times_("Checkpoint time to safepoint", kInitialBucketWidthUs) {
+}
+
+void SafepointStats::UpdateSlowest(SlowestThread* slowest, Thread* thread, uint64_t wait_ns) {
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, lock_);
+    if (wait_ns <= slowest->wait_ns) {
+      return;
+    }
+  }
+  // Walk the stack without the lock, this is rare once the slowest waits are seen.
+  std::string thread_name;
+  thread->GetThreadName(thread_name);
+  mirror::ArtMethod* method = thread->GetCurrentMethod(nullptr);
+  std::string method_name(method != nullptr ? PrettyMethod(method) : "<none>");
+  MutexLock mu(self, lock_);
+  if (wait_ns > slowest->wait_ns) {
+    slowest->wait_ns = wait_ns;
+    slowest->thread_name = thread_name;
+    slowest->method = method_name;
+  }
+}
+
+void SafepointStats::RecordSuspendAll(uint64_t wait_ns, Thread* slowest) {
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    suspend_all_times_.AddValue(wait_ns / 1000);
+  }
+  if (slowest != nullptr) {
+    UpdateSlowest(&slowest_suspend_all_, slowest, wait_ns);
+  }
+}
+
+void SafepointStats::RecordCheckpoint(Thread* self, uint64_t wait_ns) {
+  {
+    MutexLock mu(self, lock_);
+    checkpoint_times_.AddValue(wait_ns / 1000);
+  }
+  UpdateSlowest(&slowest_checkpoint_, self, wait_ns);
+}
+
+void SafepointStats::DumpHistogram(std::ostream& os, const Histogram<uint64_t>& histogram,
+                                   const SlowestThread& slowest) {
+  if (histogram.SampleSize() == 0) {
+    return;
+  }
+  Histogram<uint64_t>::CumulativeData data;
+  histogram.CreateHistogram(&data);
+  os << "  " << histogram.SampleSize() << " waits ";
+  histogram.PrintConfidenceIntervals(os, 0.99, data);
+  if (!slowest.thread_name.empty()) {
+    os << "    slowest: \"" << slowest.thread_name << "\" " << PrettyDuration(slowest.wait_ns)
+       << " in " << slowest.method << "\n";
+  }
+}
+
+void SafepointStats::Dump(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "Time to safepoint:\n";
+  DumpHistogram(os, suspend_all_times_, slowest_suspend_all_);
+  DumpHistogram(os, checkpoint_times_, slowest_checkpoint_);
+}
+
+}  // namespace art
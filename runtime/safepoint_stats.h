@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_SAFEPOINT_STATS_H_
+#define ART_RUNTIME_SAFEPOINT_STATS_H_
+
+#include <stdint.h>
+
+#include <iosfwd>
+#include <string>
+
+#include "base/histogram.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class Thread;
+
+// Time to safepoint statistics: how long ThreadList::SuspendAll waits for the runnable threads to
+// reach a suspend point, and how long runnable threads take to run a requested checkpoint. Both
+// are kept in histograms, along with the slowest thread seen and the method it stopped in, which
+// is where a loop without suspend checks usually ends.
+class SafepointStats {
+ public:
+  SafepointStats();
+
+  // Record a SuspendAll which waited wait_ns, slowest is the last thread to suspend or null if no
+  // runnable thread had to be waited for. Called with every other thread suspended.
+  void RecordSuspendAll(uint64_t wait_ns, Thread* slowest)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::thread_list_lock_)
+      LOCKS_EXCLUDED(lock_);
+
+  // Record that self started running its checkpoints wait_ns after the first was requested.
+  void RecordCheckpoint(Thread* self, uint64_t wait_ns)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct SlowestThread {
+    SlowestThread() : wait_ns(0) {}
+
+    uint64_t wait_ns;
+    std::string thread_name;
+    std::string method;
+  };
+
+  // Replace slowest by thread if wait_ns is longer.
+  void UpdateSlowest(SlowestThread* slowest, Thread* thread, uint64_t wait_ns)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  static void DumpHistogram(std::ostream& os, const Histogram<uint64_t>& histogram,
+                            const SlowestThread& slowest);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Wait times in microseconds.
+  Histogram<uint64_t> suspend_all_times_ GUARDED_BY(lock_);
+  Histogram<uint64_t> checkpoint_times_ GUARDED_BY(lock_);
+  SlowestThread slowest_suspend_all_ GUARDED_BY(lock_);
+  SlowestThread slowest_checkpoint_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(SafepointStats);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_SAFEPOINT_STATS_H_
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "safepoint_stats.h"
+
+#include <sstream>
+#include <string>
+
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change.h"
+#include "thread_list.h"
+
+namespace art {
+
+class SafepointStatsTest : public CommonRuntimeTest {};
+
+TEST_F(SafepointStatsTest, RecordsCheckpoints) {
+  SafepointStats stats;
+  {
+    std::ostringstream os;
+    stats.Dump(os);
+    EXPECT_EQ("Time to safepoint:\n", os.str());
+  }
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    stats.RecordCheckpoint(soa.Self(), MsToNs(3));
+    stats.RecordCheckpoint(soa.Self(), MsToNs(1));
+  }
+  std::ostringstream os;
+  stats.Dump(os);
+  const std::string dump = os.str();
+  EXPECT_NE(std::string::npos, dump.find("2 waits Checkpoint time to safepoint")) << dump;
+  EXPECT_EQ(std::string::npos, dump.find("SuspendAll")) << dump;
+  // The test thread has no managed frames.
+  EXPECT_NE(std::string::npos, dump.find("3ms in <none>")) << dump;
+}
+
+TEST_F(SafepointStatsTest, RecordsSuspendAll) {
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  thread_list->SuspendAll();
+  thread_list->ResumeAll();
+  std::ostringstream os;
+  thread_list->GetSafepointStats()->Dump(os);
+  const std::string dump = os.str();
+  EXPECT_NE(std::string::npos, dump.find("waits SuspendAll time to safepoint")) << dump;
+}
+
+}  // namespace art
@@ -28,6 +28,7 @@
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "gc/heap.h"
+#include "lock_profiler.h"
 #include "os.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
@@ -59,8 +60,9 @@ static void DumpCmdLine(std::ostream& os) {
 #endif
 }
 
-SignalCatcher::SignalCatcher(const std::string& stack_trace_file)
+SignalCatcher::SignalCatcher(const std::string& stack_trace_file, bool low_pause_sigquit)
     : stack_trace_file_(stack_trace_file),
+      low_pause_sigquit_(low_pause_sigquit),
       lock_("SignalCatcher lock"),
       cond_("SignalCatcher::cond_", lock_),
       thread_(NULL) {
@@ -115,6 +117,10 @@ void SignalCatcher::Output(const std::string& s) {
 }
 
 void SignalCatcher::HandleSigQuit() {
+  if (low_pause_sigquit_) {
+    HandleSigQuitLowPause();
+    return;
+  }
   Runtime* runtime = Runtime::Current();
   ThreadList* thread_list = runtime->GetThreadList();
 
@@ -153,6 +159,59 @@ void SignalCatcher::HandleSigQuit() {
     self->RunCheckpointFunction();
   }
   Output(os.str());
+  ScopedObjectAccess soa(self);
+  runtime->GetHeap()->DumpAllocationSamples();
+}
+
+// Like HandleSigQuit, but only the thread states, their managed stacks, which show the monitors
+// they hold and wait for, and the held mutexes are dumped with the threads suspended. The native
+// stacks and the runtime summary are dumped once the threads resume.
+void SignalCatcher::HandleSigQuitLowPause() {
+  Runtime* runtime = Runtime::Current();
+  ThreadList* thread_list = runtime->GetThreadList();
+  Thread* self = Thread::Current();
+
+  std::ostringstream threads_os;
+  std::vector<pid_t> native_stack_tids;
+  uint64_t start_ns = NanoTime();
+  thread_list->SuspendAll();
+  Locks::mutator_lock_->AssertExclusiveHeld(self);
+  const char* old_cause = self->StartAssertNoThreadSuspension("Handling SIGQUIT");
+  ThreadState old_state = self->SetStateUnsafe(kRunnable);
+  thread_list->DumpManagedStacksForSigQuit(threads_os, &native_stack_tids);
+  BaseMutex::DumpAll(threads_os);
+  CHECK_EQ(self->SetStateUnsafe(old_state), kRunnable);
+  self->EndAssertNoThreadSuspension(old_cause);
+  thread_list->ResumeAll();
+  uint64_t pause_ns = NanoTime() - start_ns;
+  // Run the checkpoints after resuming the threads to prevent deadlocks if the checkpoint function
+  // acquires the mutator lock.
+  if (self->ReadFlag(kCheckpointRequest)) {
+    self->RunCheckpointFunction();
+  }
+
+  std::ostringstream os;
+  os << "\n"
+      << "----- pid " << getpid() << " at " << GetIsoDate() << " -----\n";
+
+  DumpCmdLine(os);
+
+  os << "Build type: " << (kIsDebugBuild ? "debug" : "optimized") << "\n";
+
+  {
+    ScopedObjectAccess soa(self);
+    runtime->DumpSummaryForSigQuit(os);
+  }
+  os << "Threads suspended for " << PrettyDuration(pause_ns) << "\n";
+  os << threads_os.str();
+  if (LockProfiler::HasProfile()) {
+    LockProfiler::Dump(os);
+  }
+  thread_list->DumpNativeStacksForSigQuit(os, native_stack_tids);
+  os << "----- end " << getpid() << " -----\n";
+  Output(os.str());
+  ScopedObjectAccess soa(self);
+  runtime->GetHeap()->DumpAllocationSamples();
 }
 
 void SignalCatcher::HandleSigUsr1() {
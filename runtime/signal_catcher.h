@@ -32,7 +32,7 @@ class Thread;
  */
 class SignalCatcher {
  public:
-  explicit SignalCatcher(const std::string& stack_trace_file);
+  SignalCatcher(const std::string& stack_trace_file, bool low_pause_sigquit);
   ~SignalCatcher();
 
   void HandleSigQuit() LOCKS_EXCLUDED(Locks::mutator_lock_,
@@ -43,6 +43,9 @@ class SignalCatcher {
  private:
   static void* Run(void* arg);
 
+  void HandleSigQuitLowPause() LOCKS_EXCLUDED(Locks::mutator_lock_,
+                                              Locks::thread_list_lock_,
+                                              Locks::thread_suspend_count_lock_);
   void HandleSigUsr1();
   void Output(const std::string& s);
   void SetHaltFlag(bool new_value);
@@ -50,6 +53,8 @@ class SignalCatcher {
   int WaitForSignal(Thread* self, SignalSet& signals);
 
   std::string stack_trace_file_;
+  // Whether SIGQUIT only keeps the threads suspended while their managed stacks are dumped.
+  const bool low_pause_sigquit_;
 
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ConditionVariable cond_ GUARDED_BY(lock_);
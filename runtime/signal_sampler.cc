@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "signal_sampler.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/ucontext.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "base/stringprintf.h"
+#include "dex_file.h"
+#include "gc/heap.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "runtime.h"
+#include "stack.h"
+#include "thread.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+
+volatile bool SignalSampler::enabled_ = false;
+volatile bool SignalSampler::has_samples_ = false;
+
+// How often the drain thread empties the buffers of the threads.
+static constexpr useconds_t kDrainPeriodUs = 50 * 1000;
+
+// Quick frames larger than this are taken as a sign the walk went wrong.
+static constexpr size_t kMaxQuickFrameSize = 64 * KB;
+
+typedef std::map<std::vector<SampleFrame>, uint64_t> StackCounts;
+
+// Guards the buffers, the aggregated samples and the timer. Created by the first Start and
+// leaked, like the locks of the runtime.
+static Mutex* gSamplerLock = nullptr;
+static std::vector<SampleBuffer*>* gBuffers = nullptr;
+static StackCounts* gStacks = nullptr;
+static uint64_t gDropped = 0;
+static uint32_t gIntervalUs = 0;
+
+// Handlers that may still be using a buffer, Stop waits for them before deleting the buffers.
+static AtomicInteger gHandlersRunning(0);
+static bool gHandlerInstalled = false;
+#if defined(__linux__)
+static timer_t gTimer;
+static bool gTimerCreated = false;
+#endif
+static pthread_t gDrainThread;
+static volatile bool gDraining = false;
+
+static void GetPcAndSp(void* context, uintptr_t* pc, uintptr_t* sp) {
+#if defined(__linux__) && defined(__arm__)
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  *pc = uc->uc_mcontext.arm_pc;
+  *sp = uc->uc_mcontext.arm_sp;
+#elif defined(__linux__) && defined(__aarch64__)
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  *pc = uc->uc_mcontext.pc;
+  *sp = uc->uc_mcontext.sp;
+#elif defined(__linux__) && defined(__i386__)
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  *pc = uc->uc_mcontext.gregs[REG_EIP];
+  *sp = uc->uc_mcontext.gregs[REG_ESP];
+#elif defined(__linux__) && defined(__x86_64__)
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  *pc = uc->uc_mcontext.gregs[REG_RIP];
+  *sp = uc->uc_mcontext.gregs[REG_RSP];
+#else
+  // Only the frames published on the managed stack are walked.
+  UNUSED(context);
+  *pc = 0;
+  *sp = 0;
+#endif
+}
+
+// Whether candidate is an ArtMethod. Called from the signal handler of a runnable thread, so the
+// spaces of the heap don't change underneath.
+static bool IsArtMethod(mirror::ArtMethod* candidate) NO_THREAD_SAFETY_ANALYSIS {
+  if (candidate == nullptr || !IsAligned<kObjectAlignment>(candidate)) {
+    return false;
+  }
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (heap->FindContinuousSpaceFromObject(candidate, true) == nullptr) {
+    return false;
+  }
+  return candidate->GetClass<kVerifyNone>() == mirror::ArtMethod::GetJavaLangReflectArtMethod();
+}
+
+// Returns the dex cache of the method, nullptr for runtime methods, which have no declaring
+// class, and proxy methods.
+static mirror::DexCache* GetDexCache(mirror::ArtMethod* method) NO_THREAD_SAFETY_ANALYSIS {
+  mirror::Class* klass =
+      method->GetFieldObject<mirror::Class, kVerifyNone>(mirror::ArtMethod::DeclaringClassOffset());
+  return klass != nullptr ? klass->GetDexCache<kVerifyNone>() : nullptr;
+}
+
+// Records method as the next frame, skipping runtime and proxy methods. Returns false once the
+// sample is full.
+static bool AddFrame(mirror::ArtMethod* method, SampleBuffer::Sample* sample)
+    NO_THREAD_SAFETY_ANALYSIS {
+  if (sample->depth == SampleBuffer::kMaxFrames) {
+    return false;
+  }
+  mirror::DexCache* dex_cache = GetDexCache(method);
+  if (dex_cache == nullptr) {
+    return true;
+  }
+  SampleFrame& frame = sample->frames[sample->depth++];
+  frame.dex_file = dex_cache->GetDexFile();
+  frame.method_idx = method->GetDexMethodIndex();
+  return true;
+}
+
+// Walks the quick frames starting at frame, up to the bottom of its managed stack fragment.
+static void WalkQuickFrames(Thread* self, uintptr_t frame, SampleBuffer::Sample* sample)
+    NO_THREAD_SAFETY_ANALYSIS {
+  while (IsAligned<sizeof(uintptr_t)>(frame) && self->StackContains(frame)) {
+    mirror::ArtMethod* method = *reinterpret_cast<mirror::ArtMethod**>(frame);
+    if (method == nullptr || !IsArtMethod(method) || !AddFrame(method, sample)) {
+      return;
+    }
+    size_t frame_size = method->GetFrameSizeInBytes<false>();
+    if (frame_size == 0 || frame_size > kMaxQuickFrameSize) {
+      return;
+    }
+    frame += frame_size;
+  }
+}
+
+static void WalkShadowFrames(ShadowFrame* frame, SampleBuffer::Sample* sample)
+    NO_THREAD_SAFETY_ANALYSIS {
+  for (; frame != nullptr; frame = frame->GetLink()) {
+    mirror::ArtMethod* method = frame->GetMethod();
+    if (!IsArtMethod(method) || !AddFrame(method, sample)) {
+      return;
+    }
+  }
+}
+
+// Walks the managed stack of self, which the signal interrupted with context.
+static void WalkStack(Thread* self, void* context, SampleBuffer::Sample* sample)
+    NO_THREAD_SAFETY_ANALYSIS {
+  sample->depth = 0;
+  if (self->GetState() != kRunnable) {
+    // The methods may be moving, don't look at them.
+    sample->frames[0].dex_file = nullptr;
+    sample->frames[0].method_idx = SampleFrame::kNative;
+    sample->depth = 1;
+    return;
+  }
+  uintptr_t pc;
+  uintptr_t sp;
+  GetPcAndSp(context, &pc, &sp);
+  for (const ManagedStack* fragment = self->GetManagedStack(); fragment != nullptr;
+       fragment = fragment->GetLink()) {
+    if (fragment->GetTopShadowFrame() != nullptr) {
+      WalkShadowFrames(fragment->GetTopShadowFrame(), sample);
+      continue;
+    }
+    uintptr_t top = reinterpret_cast<uintptr_t>(fragment->GetTopQuickFrame());
+    if (fragment == self->GetManagedStack() && sp != 0) {
+      // Compiled code doesn't publish its frames, but a method's frame starts with the method.
+      mirror::ArtMethod* method =
+          IsAligned<sizeof(uintptr_t)>(sp) && self->StackContains(sp)
+              ? *reinterpret_cast<mirror::ArtMethod**>(sp) : nullptr;
+      if (IsArtMethod(method) && GetDexCache(method) != nullptr && method->IsWithinQuickCode(pc)) {
+        WalkQuickFrames(self, sp, sample);
+        continue;
+      }
+      // The top quick frame is left behind when the runtime returns to compiled code, it's only
+      // live while it is above the interrupted frame.
+      if (top < sp) {
+        top = 0;
+      }
+    }
+    if (top != 0) {
+      WalkQuickFrames(self, top, sample);
+    } else if (fragment == self->GetManagedStack()) {
+      // Frames we can't find are attributed to nobody rather than to their callers.
+      sample->frames[0].dex_file = nullptr;
+      sample->frames[0].method_idx = SampleFrame::kUnknown;
+      sample->depth = 1;
+      return;
+    }
+  }
+  if (sample->depth == 0) {
+    sample->frames[0].dex_file = nullptr;
+    sample->frames[0].method_idx = SampleFrame::kUnknown;
+    sample->depth = 1;
+  }
+}
+
+void SignalSampler::HandleSignal(int, siginfo_t*, void* context) {
+  int saved_errno = errno;
+  ++gHandlersRunning;
+  Thread* self = enabled_ ? Thread::Current() : nullptr;
+  SampleBuffer* buffer = self != nullptr ? self->GetSampleBuffer() : nullptr;
+  if (buffer != nullptr) {
+    SampleBuffer::Sample* sample = buffer->BeginWrite();
+    if (sample != nullptr) {
+      WalkStack(self, context, sample);
+      buffer->EndWrite();
+    }
+  }
+  --gHandlersRunning;
+  errno = saved_errno;
+}
+
+class AddStack {
+ public:
+  void operator()(const SampleBuffer::Sample& sample) {
+    std::vector<SampleFrame> stack(sample.frames, sample.frames + sample.depth);
+    ++(*gStacks)[stack];
+  }
+};
+
+// Moves the samples of the buffers to gStacks and deletes the buffers of detached threads.
+static void DrainBuffers() EXCLUSIVE_LOCKS_REQUIRED(gSamplerLock) {
+  AddStack visitor;
+  for (auto it = gBuffers->begin(); it != gBuffers->end();) {
+    SampleBuffer* buffer = *it;
+    buffer->Drain(&visitor);
+    if (buffer->IsDetached()) {
+      gDropped += buffer->GetDropped();
+      delete buffer;
+      it = gBuffers->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void* SignalSampler::DrainThread(void*) {
+  while (gDraining) {
+    usleep(kDrainPeriodUs);
+    MutexLock mu(nullptr, *gSamplerLock);
+    DrainBuffers();
+  }
+  return nullptr;
+}
+
+static void AddBuffer(Thread* thread) EXCLUSIVE_LOCKS_REQUIRED(gSamplerLock) {
+  if (thread->GetSampleBuffer() == nullptr) {
+    SampleBuffer* buffer = new SampleBuffer;
+    gBuffers->push_back(buffer);
+    thread->SetSampleBuffer(buffer);
+  }
+}
+
+bool SignalSampler::Start(uint32_t interval_us) {
+#if defined(__linux__)
+  Thread* self = Thread::Current();
+  if (gSamplerLock == nullptr) {
+    gSamplerLock = new Mutex("signal sampler lock");
+    gBuffers = new std::vector<SampleBuffer*>;
+    gStacks = new StackCounts;
+  }
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *gSamplerLock);
+    if (enabled_) {
+      return false;
+    }
+    gStacks->clear();
+    gDropped = 0;
+    gIntervalUs = interval_us;
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      AddBuffer(thread);
+    }
+    enabled_ = true;
+    has_samples_ = true;
+  }
+
+  if (!gHandlerInstalled) {
+    // The handler stays installed after Stop, a SIGPROF that is still pending would otherwise
+    // kill the process.
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = HandleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+    sigaction(SIGPROF, &action, nullptr);
+    gHandlerInstalled = true;
+  }
+
+  gDraining = true;
+  CHECK_PTHREAD_CALL(pthread_create, (&gDrainThread, nullptr, &DrainThread, nullptr),
+                     "signal sampler drain thread");
+
+  struct sigevent event;
+  memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_SIGNAL;
+  event.sigev_signo = SIGPROF;
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = interval_us / 1000000;
+  spec.it_interval.tv_nsec = (interval_us % 1000000) * 1000;
+  spec.it_value = spec.it_interval;
+  if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &gTimer) != 0) {
+    PLOG(WARNING) << "Failed to create the sampling timer";
+    gTimerCreated = false;
+    Stop();
+    return false;
+  }
+  gTimerCreated = true;
+  if (timer_settime(gTimer, 0, &spec, nullptr) != 0) {
+    PLOG(WARNING) << "Failed to arm the sampling timer";
+    Stop();
+    return false;
+  }
+  return true;
+#else
+  UNUSED(interval_us);
+  LOG(WARNING) << "Signal based sampling isn't supported on this platform";
+  return false;
+#endif
+}
+
+void SignalSampler::Stop() {
+#if defined(__linux__)
+  if (!enabled_) {
+    return;
+  }
+  enabled_ = false;
+  if (gTimerCreated) {
+    timer_delete(gTimer);
+    gTimerCreated = false;
+  }
+  // Signals that were already delivered may still be recording.
+  while (gHandlersRunning.Load() != 0) {
+    sched_yield();
+  }
+  gDraining = false;
+  CHECK_PTHREAD_CALL(pthread_join, (gDrainThread, nullptr), "signal sampler drain thread");
+
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  MutexLock mu2(self, *gSamplerLock);
+  DrainBuffers();
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    thread->SetSampleBuffer(nullptr);
+  }
+  for (SampleBuffer* buffer : *gBuffers) {
+    gDropped += buffer->GetDropped();
+    delete buffer;
+  }
+  gBuffers->clear();
+#endif
+}
+
+void SignalSampler::ThreadAttached(Thread* self) {
+  if (!enabled_) {
+    return;
+  }
+  MutexLock mu(self, *gSamplerLock);
+  if (enabled_) {
+    AddBuffer(self);
+  }
+}
+
+void SignalSampler::ThreadDetached(Thread* self) {
+  if (gSamplerLock == nullptr) {
+    return;
+  }
+  MutexLock mu(self, *gSamplerLock);
+  SampleBuffer* buffer = self->GetSampleBuffer();
+  if (buffer != nullptr) {
+    // A signal arriving from now on finds no buffer, the ones before have completed.
+    self->SetSampleBuffer(nullptr);
+    buffer->SetDetached();
+  }
+}
+
+static std::string FrameName(const SampleFrame& frame) {
+  if (frame.dex_file != nullptr) {
+    return PrettyMethod(frame.method_idx, *frame.dex_file);
+  }
+  return frame.method_idx == SampleFrame::kNative ? "[native]" : "[unknown]";
+}
+
+static void WriteWord(std::ostream& os, uintptr_t word) {
+  os.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+void SignalSampler::Dump(std::ostream& os) {
+  if (gSamplerLock == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *gSamplerLock);
+  DrainBuffers();
+
+  // Give each frame a fake address for pprof, named in the symbol section.
+  std::map<SampleFrame, uintptr_t> addresses;
+  for (const auto& stack : *gStacks) {
+    for (const SampleFrame& frame : stack.first) {
+      if (addresses.find(frame) == addresses.end()) {
+        uintptr_t address = (addresses.size() + 1) * 16;
+        addresses[frame] = address;
+      }
+    }
+  }
+  os << "--- symbol\n";
+  os << "binary=" << GetCmdLine() << "\n";
+  for (const auto& address : addresses) {
+    std::string name(FrameName(address.first));
+    os << StringPrintf("0x%016zx %s\n", address.second, name.c_str());
+    // pprof looks callers up at their return address minus one.
+    os << StringPrintf("0x%016zx %s\n", address.second - 1, name.c_str());
+  }
+  os << "---\n";
+  os << "--- profile\n";
+  // The header: header words, version, sampling period and padding.
+  WriteWord(os, 0);
+  WriteWord(os, 3);
+  WriteWord(os, 0);
+  WriteWord(os, gIntervalUs);
+  WriteWord(os, 0);
+  for (const auto& stack : *gStacks) {
+    WriteWord(os, stack.second);
+    WriteWord(os, stack.first.size());
+    for (const SampleFrame& frame : stack.first) {
+      WriteWord(os, addresses[frame]);
+    }
+  }
+  // The trailer.
+  WriteWord(os, 0);
+  WriteWord(os, 1);
+  WriteWord(os, 0);
+  if (gDropped != 0) {
+    LOG(WARNING) << "Signal sampler dropped " << gDropped << " samples";
+  }
+}
+
+}  // namespace art
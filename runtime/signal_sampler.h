@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_SIGNAL_SAMPLER_H_
+#define ART_RUNTIME_SIGNAL_SAMPLER_H_
+
+#include <signal.h>
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class DexFile;
+class Thread;
+
+// A frame of a sample. Methods are recorded by dex file and method index rather than as
+// ArtMethod* so that the samples stay meaningful when the collector moves the methods. Frames
+// that aren't Java methods have no dex file and one of the kinds below as method index.
+struct SampleFrame {
+  enum Kind {
+    kNative,   // The thread wasn't runnable, it was in native or runtime code.
+    kUnknown,  // No frame of the thread could be identified.
+  };
+
+  const DexFile* dex_file;
+  uint32_t method_idx;
+
+  bool operator<(const SampleFrame& other) const {
+    return dex_file != other.dex_file ? dex_file < other.dex_file
+                                      : method_idx < other.method_idx;
+  }
+};
+
+// The samples of one thread. The SIGPROF handler of the thread is the only writer and the drain
+// thread of the sampler the only reader, so the ring needs no lock. Samples that find the ring
+// full are dropped.
+class SampleBuffer {
+ public:
+  static constexpr size_t kMaxFrames = 24;
+
+  // The number of samples in the ring, a power of two.
+  static constexpr size_t kCapacity = 128;
+
+  struct Sample {
+    uint32_t depth;
+    // The innermost frame first.
+    SampleFrame frames[kMaxFrames];
+  };
+
+  SampleBuffer() : head_(0), tail_(0), dropped_(0), detached_(false) {}
+
+  // Returns the slot of the next sample, nullptr if the ring is full.
+  Sample* BeginWrite() {
+    int32_t head = head_.Load();
+    if (static_cast<size_t>(head - tail_.Load()) == kCapacity) {
+      ++dropped_;
+      return nullptr;
+    }
+    return &samples_[head & (kCapacity - 1)];
+  }
+
+  // Publishes the sample returned by BeginWrite.
+  void EndWrite() {
+    QuasiAtomic::MembarStoreStore();
+    head_ = head_.Load() + 1;
+  }
+
+  // Passes the published samples to visitor and frees their slots.
+  template <typename Visitor>
+  void Drain(Visitor* visitor) {
+    int32_t head = head_.Load();
+    QuasiAtomic::MembarLoadLoad();
+    int32_t tail = tail_.Load();
+    for (; tail != head; ++tail) {
+      (*visitor)(samples_[tail & (kCapacity - 1)]);
+    }
+    QuasiAtomic::MembarLoadStore();
+    tail_ = tail;
+  }
+
+  int32_t GetDropped() {
+    return dropped_.Load();
+  }
+
+  // Set once the owning thread detached, the sampler deletes the buffer after draining it.
+  bool IsDetached() const {
+    return detached_;
+  }
+
+  void SetDetached() {
+    detached_ = true;
+  }
+
+ private:
+  AtomicInteger head_;
+  AtomicInteger tail_;
+  AtomicInteger dropped_;
+  bool detached_;
+  Sample samples_[kCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(SampleBuffer);
+};
+
+// A CPU profiler of the Java stacks of the threads. A process CPU time timer sends SIGPROF to
+// whichever thread is using the CPU, and the handler walks the managed stack of that thread into
+// its SampleBuffer. Unlike BackgroundMethodSamplingProfiler, which samples through checkpoints,
+// the sampled thread isn't stopped at a suspend point and there is no round trip per sample.
+//
+// The handler only walks the stack of runnable threads, which hold the mutator lock so no moving
+// collection runs, and checks every method it reads before using it. Threads in native code are
+// recorded as a single native frame. The innermost compiled frame is found from the interrupted
+// stack pointer when the pc is within its code, so frameless leaf methods show up as unknown.
+//
+// A drain thread aggregates the buffers into stack traces periodically. Dump writes them in the
+// legacy CPU profile format of pprof, with a symbol section that names the methods.
+class SignalSampler {
+ public:
+  static bool IsEnabled() {
+    return enabled_;
+  }
+
+  // Whether sampling was ever started. The samples name their methods by DexFile and are kept
+  // after Stop, so the dex files must not be unloaded from then on.
+  static bool HasSamples() {
+    return has_samples_;
+  }
+
+  // Clear the previous samples and sample every interval_us microseconds of CPU time used by the
+  // process. Returns false if the timer can't be set up.
+  static bool Start(uint32_t interval_us)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::thread_suspend_count_lock_);
+  static void Stop()
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::thread_suspend_count_lock_);
+
+  // Give the thread a buffer if sampling is on, called once it is on the thread list.
+  static void ThreadAttached(Thread* self);
+  // Called before the thread is deleted.
+  static void ThreadDetached(Thread* self);
+
+  // Write the samples taken since the last Start. The samples are kept after Stop.
+  static void Dump(std::ostream& os);
+
+ private:
+  static void HandleSignal(int signal_number, siginfo_t* info, void* context);
+  static void* DrainThread(void* arg);
+
+  static volatile bool enabled_;
+  static volatile bool has_samples_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(SignalSampler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_SIGNAL_SAMPLER_H_
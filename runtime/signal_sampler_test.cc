@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "signal_sampler.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "utils.h"
+
+namespace art {
+
+class SignalSamplerTest : public CommonRuntimeTest {};
+
+class CollectDepths {
+ public:
+  void operator()(const SampleBuffer::Sample& sample) {
+    depths.push_back(sample.depth);
+  }
+
+  std::vector<uint32_t> depths;
+};
+
+TEST_F(SignalSamplerTest, BufferDropsSamplesWhenFull) {
+  UniquePtr<SampleBuffer> buffer(new SampleBuffer);
+  for (size_t i = 0; i < SampleBuffer::kCapacity; ++i) {
+    SampleBuffer::Sample* sample = buffer->BeginWrite();
+    ASSERT_TRUE(sample != nullptr);
+    sample->depth = i;
+    buffer->EndWrite();
+  }
+  EXPECT_TRUE(buffer->BeginWrite() == nullptr);
+  EXPECT_EQ(1, buffer->GetDropped());
+
+  CollectDepths visitor;
+  buffer->Drain(&visitor);
+  ASSERT_EQ(SampleBuffer::kCapacity, visitor.depths.size());
+  EXPECT_EQ(0U, visitor.depths[0]);
+  EXPECT_EQ(SampleBuffer::kCapacity - 1, visitor.depths.back());
+
+  // The ring wraps around once drained.
+  SampleBuffer::Sample* sample = buffer->BeginWrite();
+  ASSERT_TRUE(sample != nullptr);
+  sample->depth = 7;
+  buffer->EndWrite();
+  visitor.depths.clear();
+  buffer->Drain(&visitor);
+  ASSERT_EQ(1U, visitor.depths.size());
+  EXPECT_EQ(7U, visitor.depths[0]);
+}
+
+TEST_F(SignalSamplerTest, SamplesNativeCode) {
+  ASSERT_TRUE(SignalSampler::Start(1000));
+  EXPECT_TRUE(SignalSampler::IsEnabled());
+  // Use some CPU time outside of managed code.
+  uint64_t start = ThreadCpuNanoTime();
+  volatile uint64_t sum = 0;
+  while (ThreadCpuNanoTime() - start < MsToNs(100)) {
+    sum += start;
+  }
+  SignalSampler::Stop();
+  EXPECT_FALSE(SignalSampler::IsEnabled());
+
+  std::ostringstream os;
+  SignalSampler::Dump(os);
+  const std::string profile = os.str();
+  EXPECT_EQ(0U, profile.find("--- symbol\n")) << profile;
+  EXPECT_NE(std::string::npos, profile.find(" [native]\n")) << profile;
+  EXPECT_NE(std::string::npos, profile.find("---\n--- profile\n")) << profile;
+}
+
+}  // namespace art
@@ -318,8 +318,8 @@ void StackVisitor::WalkStack(bool include_transitions) {
           context_->FillCalleeSaves(*this);
         }
         size_t frame_size = method->GetFrameSizeInBytes();
-        // Compute PC for next stack frame from return PC.
-        size_t return_pc_offset = method->GetReturnPcOffsetInBytes();
+        // Compute PC for next stack frame from return PC, see GetReturnPcOffsetInBytes.
+        size_t return_pc_offset = frame_size - kPointerSize;
         byte* return_pc_addr = reinterpret_cast<byte*>(cur_quick_frame_) + return_pc_offset;
         uintptr_t return_pc = *reinterpret_cast<uintptr_t*>(return_pc_addr);
         if (UNLIKELY(exit_stubs_installed)) {
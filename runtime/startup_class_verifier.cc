@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_class_verifier.h"
+
+#include "class_linker.h"
+#include "jni_internal.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+#include "thread.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class StartupClassVerifier::VerifyTask : public Task {
+ public:
+  VerifyTask(StartupClassVerifier* verifier, jobject class_loader, const std::string& descriptor)
+      : verifier_(verifier), class_loader_(class_loader), descriptor_(descriptor) {
+  }
+
+  virtual void Run(Thread* self) {
+    verifier_->VerifyClass(self, class_loader_, descriptor_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  StartupClassVerifier* const verifier_;
+  const jobject class_loader_;
+  const std::string descriptor_;
+
+  DISALLOW_COPY_AND_ASSIGN(VerifyTask);
+};
+
+StartupClassVerifier::StartupClassVerifier(size_t num_threads)
+    : num_threads_(num_threads), verified_count_(0), initialized_count_(0) {
+  CHECK_GT(num_threads, 0U);
+}
+
+StartupClassVerifier::~StartupClassVerifier() {
+  // Waits for the classes being verified, the workers don't take the queued tasks any more.
+  thread_pool_.reset();
+  JNIEnv* env = Thread::Current()->GetJniEnv();
+  for (jobject class_loader : class_loaders_) {
+    env->DeleteGlobalRef(class_loader);
+  }
+}
+
+void StartupClassVerifier::Enqueue(Thread* self, jobject class_loader,
+                                   const std::vector<std::string>& descriptors) {
+  if (thread_pool_.get() == nullptr) {
+    // The workers run the class loaders, which are managed code, so they need peers.
+    thread_pool_.reset(new ThreadPool("Startup class verifier thread pool", num_threads_, false,
+                                      true));
+    thread_pool_->StartWorkers(self);
+  }
+  jobject global_class_loader = self->GetJniEnv()->NewGlobalRef(class_loader);
+  class_loaders_.push_back(global_class_loader);
+  for (const std::string& descriptor : descriptors) {
+    thread_pool_->AddTask(self, new VerifyTask(this, global_class_loader, descriptor));
+  }
+}
+
+void StartupClassVerifier::VerifyClass(Thread* self, jobject class_loader,
+                                       const std::string& descriptor) {
+  ScopedObjectAccess soa(self);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  SirtRef<mirror::ClassLoader> loader(self, soa.Decode<mirror::ClassLoader*>(class_loader));
+  SirtRef<mirror::Class> klass(self, class_linker->FindClass(self, descriptor.c_str(), loader));
+  if (klass.get() == nullptr) {
+    // The class list is stale, for example the profile was written by an earlier version of the
+    // app. The main thread throws again if it looks the class up.
+    self->ClearException();
+    return;
+  }
+  if (!klass->IsVerified() && !klass->IsErroneous()) {
+    class_linker->VerifyClass(klass);
+    if (self->IsExceptionPending()) {
+      // The class is now erroneous, the main thread throws the verification error when it uses it.
+      self->ClearException();
+    }
+  }
+  if (klass->IsVerified()) {
+    ++verified_count_;
+    // Classes whose initialization runs no code are initialized here as well, the main thread
+    // then takes neither the initialization path nor the static method trampolines.
+    if (class_linker->InitializeClassUsingOatFile(klass)) {
+      ++initialized_count_;
+    }
+  }
+}
+
+}  // namespace art
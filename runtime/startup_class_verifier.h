@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_STARTUP_CLASS_VERIFIER_H_
+#define ART_RUNTIME_STARTUP_CLASS_VERIFIER_H_
+
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "jni.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+class Thread;
+class ThreadPool;
+
+// Loads and verifies the classes an app uses at startup on a background thread pool, so that
+// the main thread finds them verified instead of verifying each of them the first time it
+// touches them. Only the classes that dex2oat found to have no initialization code are
+// initialized as well, initializing the others would run the code of the app.
+//
+// All status transitions go through ClassLinker::VerifyClass, which holds the lock of the class
+// while verifying it: a class the main thread reaches first is verified by the main thread and
+// skipped by the workers, and the other way around.
+class StartupClassVerifier {
+ public:
+  explicit StartupClassVerifier(size_t num_threads);
+
+  // Waits for the classes being verified, the classes still queued are dropped.
+  ~StartupClassVerifier();
+
+  // Queues the classes named by descriptors, to be looked up with class_loader. The class loader
+  // is kept alive until the verifier is destroyed.
+  void Enqueue(Thread* self, jobject class_loader, const std::vector<std::string>& descriptors)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  // How many of the queued classes were found verified once processed.
+  int32_t GetVerifiedCount() const {
+    return verified_count_.Load();
+  }
+
+  // How many of the queued classes were initialized using the oat file.
+  int32_t GetInitializedCount() const {
+    return initialized_count_.Load();
+  }
+
+ private:
+  class VerifyTask;
+
+  void VerifyClass(Thread* self, jobject class_loader, const std::string& descriptor)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  const size_t num_threads_;
+  UniquePtr<ThreadPool> thread_pool_;
+  // Global references to the class loaders of the queued classes.
+  std::vector<jobject> class_loaders_;
+  AtomicInteger verified_count_;
+  AtomicInteger initialized_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(StartupClassVerifier);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_STARTUP_CLASS_VERIFIER_H_
@@ -25,6 +25,7 @@
 #include "base/mutex-inl.h"
 #include "cutils/atomic-inline.h"
 #include "jni_internal.h"
+#include "utils.h"
 
 namespace art {
 
@@ -97,27 +98,47 @@ inline void Thread::TransitionFromRunnableToSuspended(ThreadState new_state) {
     DCHECK_EQ((old_state_and_flags.as_struct.flags & kCheckpointRequest), 0);
     new_state_and_flags.as_struct.flags = old_state_and_flags.as_struct.flags;
     new_state_and_flags.as_struct.state = new_state;
-    int status = android_atomic_cas(old_state_and_flags.as_int, new_state_and_flags.as_int,
-                                       &tls32_.state_and_flags.as_int);
+    // Release the stores of the runnable thread to a thread suspending all others.
+    int status = android_atomic_release_cas(old_state_and_flags.as_int, new_state_and_flags.as_int,
+                                            &tls32_.state_and_flags.as_int);
     if (LIKELY(status == 0)) {
       break;
     }
   }
-  // Release share on mutator_lock_.
-  Locks::mutator_lock_->SharedUnlock(this);
+  // Release share on mutator_lock_, only the bookkeeping as runnable threads don't hold it.
+  Locks::mutator_lock_->TransitionFromRunnableToSuspended(this);
+  if (UNLIKELY((new_state_and_flags.as_struct.flags & kSuspendRequest) != 0)) {
+    // A thread is waiting for us to suspend, record when for the time to safepoint and wake it.
+    suspend_time_ns_ = NanoTime();
+    MutexLock mu(this, *Locks::thread_suspend_count_lock_);
+    ++suspend_barrier_generation_;
+    suspend_barrier_cond_->Broadcast(this);
+  }
 }
 
 inline ThreadState Thread::TransitionFromSuspendedToRunnable() {
-  bool done = false;
   union StateAndFlags old_state_and_flags;
   old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
   int16_t old_state = old_state_and_flags.as_struct.state;
   DCHECK_NE(static_cast<ThreadState>(old_state), kRunnable);
+  Locks::mutator_lock_->AssertNotHeld(this);  // Otherwise we starve GC..
   do {
-    Locks::mutator_lock_->AssertNotHeld(this);  // Otherwise we starve GC..
     old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
     DCHECK_EQ(old_state_and_flags.as_struct.state, old_state);
-    if (UNLIKELY((old_state_and_flags.as_struct.flags & kSuspendRequest) != 0)) {
+    if (LIKELY((old_state_and_flags.as_struct.flags & kSuspendRequest) == 0)) {
+      // Atomically change from suspended to runnable if no suspend request pending. A suspend
+      // request raised meanwhile fails the CAS, and one raised later finds the thread runnable.
+      union StateAndFlags new_state_and_flags;
+      new_state_and_flags.as_int = old_state_and_flags.as_int;
+      new_state_and_flags.as_struct.state = kRunnable;
+      // Acquire the stores of the thread which suspended all others, if any.
+      if (LIKELY(android_atomic_acquire_cas(old_state_and_flags.as_int, new_state_and_flags.as_int,
+                                            &tls32_.state_and_flags.as_int) == 0)) {
+        // Take share on mutator_lock_, only the bookkeeping as for the release above.
+        Locks::mutator_lock_->TransitionFromSuspendedToRunnable(this);
+        return static_cast<ThreadState>(old_state);
+      }
+    } else {
       // Wait while our suspend count is non-zero.
       MutexLock mu(this, *Locks::thread_suspend_count_lock_);
       old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
@@ -130,25 +151,6 @@ inline ThreadState Thread::TransitionFromSuspendedToRunnable() {
       }
       DCHECK_EQ(GetSuspendCount(), 0);
     }
-    // Re-acquire shared mutator_lock_ access.
-    Locks::mutator_lock_->SharedLock(this);
-    // Atomically change from suspended to runnable if no suspend request pending.
-    old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
-    DCHECK_EQ(old_state_and_flags.as_struct.state, old_state);
-    if (LIKELY((old_state_and_flags.as_struct.flags & kSuspendRequest) == 0)) {
-      union StateAndFlags new_state_and_flags;
-      new_state_and_flags.as_int = old_state_and_flags.as_int;
-      new_state_and_flags.as_struct.state = kRunnable;
-      // CAS the value without a memory barrier, that occurred in the lock above.
-      done = android_atomic_cas(old_state_and_flags.as_int, new_state_and_flags.as_int,
-                                &tls32_.state_and_flags.as_int) == 0;
-    }
-    if (UNLIKELY(!done)) {
-      // Failed to transition to Runnable. Release shared mutator_lock_ access and try again.
-      Locks::mutator_lock_->SharedUnlock(this);
-    } else {
-      return static_cast<ThreadState>(old_state);
-    }
   } while (true);
 }
 
@@ -29,9 +29,11 @@
 #include <cerrno>
 #include <iostream>
 #include <list>
+#include <new>
 
 #include "arch/context.h"
 #include "base/mutex.h"
+#include "catch_handler_cache.h"
 #include "class_linker.h"
 #include "class_linker-inl.h"
 #include "cutils/atomic.h"
@@ -57,6 +59,7 @@
 #include "reflection.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
+#include "signal_sampler.h"
 #include "ScopedLocalRef.h"
 #include "ScopedUtfChars.h"
 #include "sirt_ref.h"
@@ -75,6 +78,8 @@ namespace art {
 bool Thread::is_started_ = false;
 pthread_key_t Thread::pthread_key_self_;
 ConditionVariable* Thread::resume_cond_ = nullptr;
+ConditionVariable* Thread::suspend_barrier_cond_ = nullptr;
+uint32_t Thread::suspend_barrier_generation_ = 0;
 
 static const char* kThreadNameDuringStartup = "<native thread without managed peer>";
 
@@ -88,6 +93,7 @@ static void UnimplementedEntryPoint() {
 
 void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
                      PortableEntryPoints* ppoints, QuickEntryPoints* qpoints);
+void UpdateReadBarrierEntrypoints(QuickEntryPoints* qpoints, bool is_marking);
 
 void Thread::InitTlsEntryPoints() {
   // Insert a placeholder so we can easily tell if we call an unimplemented entry point.
@@ -105,6 +111,10 @@ void Thread::ResetQuickAllocEntryPointsForThread() {
   ResetQuickAllocEntryPoints(&tlsPtr_.quick_entrypoints);
 }
 
+void Thread::SetReadBarrierMarking(bool is_marking) {
+  UpdateReadBarrierEntrypoints(&tlsPtr_.quick_entrypoints, is_marking);
+}
+
 void Thread::SetDeoptimizationShadowFrame(ShadowFrame* sf) {
   tlsPtr_.deoptimization_shadow_frame = sf;
 }
@@ -289,7 +299,7 @@ void Thread::CreateNativeThread(JNIEnv* env, jobject java_peer, size_t stack_siz
     return;
   }
 
-  Thread* child_thread = new Thread(is_daemon);
+  Thread* child_thread = runtime->GetThreadList()->NewThread(is_daemon);
   // Use global JNI ref to hold peer live while child thread starts.
   child_thread->tlsPtr_.jpeer = env->NewGlobalRef(java_peer);
   stack_size = FixStackSize(stack_size);
@@ -351,8 +361,16 @@ void Thread::Init(ThreadList* thread_list, JavaVMExt* java_vm) {
   tls32_.thin_lock_thread_id = thread_list->AllocThreadId(this);
   InitStackHwm();
 
-  tlsPtr_.jni_env = new JNIEnvExt(this, java_vm);
+  if (recycled_jni_env_ != nullptr) {
+    // The local reference table keeps the capacity the recycled thread grew it to.
+    tlsPtr_.jni_env = recycled_jni_env_;
+    recycled_jni_env_ = nullptr;
+    tlsPtr_.jni_env->Reset(java_vm);
+  } else {
+    tlsPtr_.jni_env = new JNIEnvExt(this, java_vm);
+  }
   thread_list->Register(this);
+  SignalSampler::ThreadAttached(this);
 }
 
 Thread* Thread::Attach(const char* thread_name, bool as_daemon, jobject thread_group,
@@ -370,7 +388,7 @@ Thread* Thread::Attach(const char* thread_name, bool as_daemon, jobject thread_g
       return nullptr;
     } else {
       Runtime::Current()->StartThreadBirth();
-      self = new Thread(as_daemon);
+      self = runtime->GetThreadList()->NewThread(as_daemon);
       self->Init(runtime->GetThreadList(), runtime->GetJavaVM());
       Runtime::Current()->EndThreadBirth();
     }
@@ -638,6 +656,7 @@ void Thread::ModifySuspendCount(Thread* self, int delta, bool for_debugger) {
 
 void Thread::RunCheckpointFunction() {
   Closure *checkpoints[kMaxCheckpoints];
+  uint64_t request_time;
 
   // Grab the suspend_count lock and copy the current set of
   // checkpoints.  Then clear the list and the flag.  The RequestCheckpoint
@@ -650,7 +669,10 @@ void Thread::RunCheckpointFunction() {
       tlsPtr_.checkpoint_functions[i] = nullptr;
     }
     AtomicClearFlag(kCheckpointRequest);
+    request_time = checkpoint_request_time_ns_;
   }
+  Runtime::Current()->GetThreadList()->GetSafepointStats()->RecordCheckpoint(
+      this, NanoTime() - request_time);
 
   // Outside the lock, run all the checkpoint functions that
   // we collected.
@@ -685,6 +707,9 @@ bool Thread::RequestCheckpoint(Closure* function) {
     return false;
   }
   tlsPtr_.checkpoint_functions[available_checkpoint] = function;
+  if ((old_state_and_flags.as_struct.flags & kCheckpointRequest) == 0) {
+    checkpoint_request_time_ns_ = NanoTime();
+  }
 
   // Checkpoint function installed now install flag bit.
   // We must be runnable to request a checkpoint.
@@ -814,6 +839,10 @@ void Thread::DumpState(std::ostream& os, const Thread* thread, pid_t tid) {
     os << "  | stack=" << reinterpret_cast<void*>(thread->tlsPtr_.stack_begin) << "-"
         << reinterpret_cast<void*>(thread->tlsPtr_.stack_end) << " stackSize="
         << PrettySize(thread->tlsPtr_.stack_size) << "\n";
+    if (thread->allocation_stalls_ != 0) {
+      os << "  | allocStalls=" << thread->allocation_stalls_
+         << " allocStallTime=" << PrettyDuration(thread->allocation_stall_time_ns_) << "\n";
+    }
   }
 }
 
@@ -939,6 +968,13 @@ void Thread::DumpJavaStack(std::ostream& os) const {
   dumper.WalkStack();
 }
 
+bool Thread::DumpWithoutNativeStack(std::ostream& os) const {
+  DCHECK(this == Thread::Current() || IsSuspended()) << *this;
+  DumpState(os);
+  DumpJavaStack(os);
+  return ShouldShowNativeStack(this);
+}
+
 void Thread::DumpStack(std::ostream& os) const {
   // TODO: we call this code when dying but may not have suspended the thread ourself. The
   //       IsSuspended check is therefore racy with the use for dumping (normally we inhibit
@@ -984,6 +1020,8 @@ void Thread::Startup() {
     MutexLock mu(nullptr, *Locks::thread_suspend_count_lock_);
     resume_cond_ = new ConditionVariable("Thread resumption condition variable",
                                          *Locks::thread_suspend_count_lock_);
+    suspend_barrier_cond_ = new ConditionVariable("Thread suspend barrier condition variable",
+                                                  *Locks::thread_suspend_count_lock_);
   }
 
   // Allocate a TLS slot.
@@ -1015,9 +1053,16 @@ void Thread::Shutdown() {
     delete resume_cond_;
     resume_cond_ = nullptr;
   }
+  if (suspend_barrier_cond_ != nullptr) {
+    delete suspend_barrier_cond_;
+    suspend_barrier_cond_ = nullptr;
+  }
 }
 
-Thread::Thread(bool daemon) : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false) {
+Thread::Thread(bool daemon)
+    : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false), suspend_time_ns_(0),
+      checkpoint_request_time_ns_(0), allocation_stalls_(0), allocation_stall_time_ns_(0),
+      recycled_jni_env_(nullptr) {
   wait_mutex_ = new Mutex("a thread wait mutex");
   wait_cond_ = new ConditionVariable("a thread wait condition variable", *wait_mutex_);
   tlsPtr_.debug_invoke_req = new DebugInvokeReq;
@@ -1026,17 +1071,52 @@ Thread::Thread(bool daemon) : tls32_(daemon), wait_monitor_(nullptr), interrupte
   tlsPtr_.name = new std::string(kThreadNameDuringStartup);
 
   CHECK_EQ((sizeof(Thread) % 4), 0U) << sizeof(Thread);
+  InitTlsValues();
+}
+
+void Thread::InitTlsValues() {
   tls32_.state_and_flags.as_struct.flags = 0;
   tls32_.state_and_flags.as_struct.state = kNative;
   memset(&tlsPtr_.held_mutexes[0], 0, sizeof(tlsPtr_.held_mutexes));
   std::fill(tlsPtr_.rosalloc_runs,
-            tlsPtr_.rosalloc_runs + gc::allocator::RosAlloc::kNumThreadLocalSizeBrackets,
+            tlsPtr_.rosalloc_runs + gc::allocator::RosAlloc::kMaxNumThreadLocalSizeBrackets,
             gc::allocator::RosAlloc::GetDedicatedFullRun());
   for (uint32_t i = 0; i < kMaxCheckpoints; ++i) {
     tlsPtr_.checkpoint_functions[i] = nullptr;
   }
 }
 
+void Thread::Reuse(bool daemon) {
+  DCHECK_EQ(GetState(), kTerminated);
+  DCHECK(tlsPtr_.jni_env == nullptr);
+  Context* long_jump_context = tlsPtr_.long_jump_context;
+  std::deque<instrumentation::InstrumentationStackFrame>* instrumentation_stack =
+      tlsPtr_.instrumentation_stack;
+  std::string* name = tlsPtr_.name;
+  // The debugger requests hold a lock and a condition variable, they are allocated again.
+  delete tlsPtr_.debug_invoke_req;
+  delete tlsPtr_.single_step_control;
+
+  // The daemon flag is const, the values are constructed again rather than assigned.
+  new (&tls32_) tls_32bit_sized_values(daemon);
+  new (&tls64_) tls_64bit_sized_values;
+  new (&tlsPtr_) tls_ptr_sized_values;
+  tlsPtr_.long_jump_context = long_jump_context;
+  instrumentation_stack->clear();
+  tlsPtr_.instrumentation_stack = instrumentation_stack;
+  name->assign(kThreadNameDuringStartup);
+  tlsPtr_.name = name;
+  tlsPtr_.debug_invoke_req = new DebugInvokeReq;
+  tlsPtr_.single_step_control = new SingleStepControl;
+  wait_monitor_ = nullptr;
+  interrupted_ = false;
+  suspend_time_ns_ = 0;
+  checkpoint_request_time_ns_ = 0;
+  allocation_stalls_ = 0;
+  allocation_stall_time_ns_ = 0;
+  InitTlsValues();
+}
+
 bool Thread::IsStillStarting() const {
   // You might think you can check whether the state is kStarting, but for much of thread startup,
   // the thread is in kNative; it might also be in kVmWait.
@@ -1117,7 +1197,7 @@ void Thread::Destroy() {
   }
 }
 
-Thread::~Thread() {
+void Thread::Release() {
   if (tlsPtr_.jni_env != nullptr && tlsPtr_.jpeer != nullptr) {
     // If pthread_create fails we don't have a jni env here.
     tlsPtr_.jni_env->DeleteGlobalRef(tlsPtr_.jpeer);
@@ -1126,10 +1206,6 @@ Thread::~Thread() {
   tlsPtr_.opeer = nullptr;
 
   bool initialized = (tlsPtr_.jni_env != nullptr);  // Did Thread::Init run?
-  if (initialized) {
-    delete tlsPtr_.jni_env;
-    tlsPtr_.jni_env = nullptr;
-  }
   CHECK_NE(GetState(), kRunnable);
   CHECK_NE(ReadFlag(kCheckpointRequest), true);
   CHECK(tlsPtr_.checkpoint_functions[0] == nullptr);
@@ -1139,6 +1215,37 @@ Thread::~Thread() {
   // We may be deleting a still born thread.
   SetStateUnsafe(kTerminated);
 
+  if (initialized) {
+    CleanupCpu();
+  }
+
+  Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
+
+  TearDownAlternateSignalStack();
+}
+
+void Thread::Recycle() {
+  Release();
+  recycled_jni_env_ = tlsPtr_.jni_env;
+  tlsPtr_.jni_env = nullptr;
+  // The sample and the cached handlers refer to classes, which aren't visited while the thread
+  // is pooled.
+  delete tlsPtr_.stack_trace_sample;
+  tlsPtr_.stack_trace_sample = nullptr;
+  delete tlsPtr_.catch_handler_cache;
+  tlsPtr_.catch_handler_cache = nullptr;
+}
+
+Thread::~Thread() {
+  // A recycled thread was released when it entered the pool.
+  if (GetState() != kTerminated) {
+    Release();
+  }
+
+  delete tlsPtr_.jni_env;
+  tlsPtr_.jni_env = nullptr;
+  delete recycled_jni_env_;
+
   delete wait_cond_;
   delete wait_mutex_;
 
@@ -1146,19 +1253,12 @@ Thread::~Thread() {
     delete tlsPtr_.long_jump_context;
   }
 
-  if (initialized) {
-    CleanupCpu();
-  }
-
   delete tlsPtr_.debug_invoke_req;
   delete tlsPtr_.single_step_control;
   delete tlsPtr_.instrumentation_stack;
   delete tlsPtr_.name;
   delete tlsPtr_.stack_trace_sample;
-
-  Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
-
-  TearDownAlternateSignalStack();
+  delete tlsPtr_.catch_handler_cache;
 }
 
 void Thread::HandleUncaughtExceptions(ScopedObjectAccess& soa) {
@@ -1307,12 +1407,6 @@ void Thread::Interrupt(Thread* self) {
   NotifyLocked(self);
 }
 
-void Thread::Notify() {
-  Thread* self = Thread::Current();
-  MutexLock mu(self, *wait_mutex_);
-  NotifyLocked(self);
-}
-
 void Thread::NotifyLocked(Thread* self) {
   if (wait_monitor_ != nullptr) {
     wait_cond_->Signal(self);
@@ -1359,6 +1453,18 @@ class CountStackDepthVisitor : public StackVisitor {
   bool skipping_;
 };
 
+// Tags the pc of a compiled frame in an internal stack trace as a native pc offset.
+static constexpr uint32_t kInternalStackTraceNativePcFlag = 0x80000000U;
+
+uint32_t Thread::InternalStackTraceDexPc(mirror::ArtMethod* method, uint32_t trace_pc) {
+  if ((trace_pc & kInternalStackTraceNativePcFlag) == 0 || trace_pc == DexFile::kDexNoIndex) {
+    return trace_pc;
+  }
+  const void* code = Runtime::Current()->GetInstrumentation()->GetQuickCodeFor(method);
+  return method->ToDexPc(reinterpret_cast<uintptr_t>(code) +
+                         (trace_pc & ~kInternalStackTraceNativePcFlag));
+}
+
 template<bool kTransactionActive>
 class BuildInternalStackTraceVisitor : public StackVisitor {
  public:
@@ -1412,12 +1518,29 @@ class BuildInternalStackTraceVisitor : public StackVisitor {
       return true;  // Ignore runtime frames (in particular callee save).
     }
     method_trace_->Set<kTransactionActive>(count_, m);
-    dex_pc_trace_->Set<kTransactionActive>(count_,
-        m->IsProxyMethod() ? DexFile::kDexNoIndex : GetDexPc());
+    dex_pc_trace_->Set<kTransactionActive>(count_, GetTracePc(m));
     ++count_;
     return true;
   }
 
+  // Searching the mapping table for the dex pc of a compiled frame is the most expensive part of
+  // building the trace, and most traces are never printed. Compiled frames record their native
+  // pc offset instead and the dex pc is found when the trace is converted to StackTraceElements.
+  uint32_t GetTracePc(mirror::ArtMethod* m) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (m->IsProxyMethod()) {
+      return DexFile::kDexNoIndex;
+    }
+    if (GetCurrentShadowFrame() == nullptr && GetCurrentQuickFrame() != nullptr &&
+        !m->IsNative() && !m->IsPortableCompiled()) {
+      uintptr_t native_pc_offset = m->NativePcOffset(GetCurrentQuickFramePc());
+      // The largest offset would read as kDexNoIndex once tagged.
+      if (native_pc_offset < ~kInternalStackTraceNativePcFlag) {
+        return native_pc_offset | kInternalStackTraceNativePcFlag;
+      }
+    }
+    return GetDexPc();
+  }
+
   mirror::ObjectArray<mirror::Object>* GetInternalStackTrace() const {
     return method_trace_;
   }
@@ -1428,7 +1551,7 @@ class BuildInternalStackTraceVisitor : public StackVisitor {
   int32_t skip_depth_;
   // Current position down stack trace.
   uint32_t count_;
-  // Array of dex PC values.
+  // Array of the pcs of the frames, see GetTracePc.
   mirror::IntArray* dex_pc_trace_;
   // An array of the methods on the stack, the last entry is a reference to the PC trace.
   mirror::ObjectArray<mirror::Object>* method_trace_;
@@ -1506,7 +1629,7 @@ jobjectArray Thread::InternalStackTraceToStackTraceElementArray(const ScopedObje
       // source_name_object intentionally left null for proxy methods
     } else {
       mirror::IntArray* pc_trace = down_cast<mirror::IntArray*>(method_trace->Get(depth));
-      uint32_t dex_pc = pc_trace->Get(i);
+      uint32_t dex_pc = InternalStackTraceDexPc(method, pc_trace->Get(i));
       line_number = mh.GetLineNumFromDexPC(dex_pc);
       // Allocate element, potentially triggering GC
       // TODO: reuse class_name_object via Class::name_?
@@ -1832,6 +1955,7 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   QUICK_ENTRY_POINT_INFO(pIndexOf)
   QUICK_ENTRY_POINT_INFO(pMemcmp16)
   QUICK_ENTRY_POINT_INFO(pStringCompareTo)
+  QUICK_ENTRY_POINT_INFO(pStringEquals)
   QUICK_ENTRY_POINT_INFO(pMemcpy)
   QUICK_ENTRY_POINT_INFO(pQuickImtConflictTrampoline)
   QUICK_ENTRY_POINT_INFO(pQuickResolutionTrampoline)
@@ -1849,6 +1973,7 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   QUICK_ENTRY_POINT_INFO(pThrowNoSuchMethod)
   QUICK_ENTRY_POINT_INFO(pThrowNullPointer)
   QUICK_ENTRY_POINT_INFO(pThrowStackOverflow)
+  QUICK_ENTRY_POINT_INFO(pReadBarrierMark)
 #undef QUICK_ENTRY_POINT_INFO
 
   os << offset;
@@ -1895,6 +2020,13 @@ Context* Thread::GetLongJumpContext() {
   return result;
 }
 
+CatchHandlerCache* Thread::GetCatchHandlerCache() {
+  if (tlsPtr_.catch_handler_cache == nullptr) {
+    tlsPtr_.catch_handler_cache = new CatchHandlerCache;
+  }
+  return tlsPtr_.catch_handler_cache;
+}
+
 struct CurrentMethodVisitor FINAL : public StackVisitor {
   CurrentMethodVisitor(Thread* thread, Context* context)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
@@ -2004,44 +2136,90 @@ class ReferenceMapVisitor : public StackVisitor {
   }
 
  private:
+  // The roots of the frames of a compiled method, decoded on the first frame of the method in the
+  // walk. Deep stacks often repeat methods, and the decoding goes through the dex file, the vmap
+  // table and, when instrumentation is installed, the oat file.
+  struct QuickFrameRoots {
+    QuickFrameRoots() : method(nullptr), code(0), native_gc_map(nullptr) {}
+
+    mirror::ArtMethod* method;
+    // The code of the method, native pcs of the gc map are relative to it.
+    uintptr_t code;
+    const uint8_t* native_gc_map;
+    // The location of each dex register which may hold a reference: an offset in the frame, or
+    // the callee save register holding it encoded as -1 - register.
+    std::vector<int32_t> locations;
+  };
+
+  static constexpr size_t kQuickFrameRootsCacheSize = 32;
+
+  const QuickFrameRoots& GetQuickFrameRoots(mirror::ArtMethod* m)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    QuickFrameRoots& roots =
+        quick_frame_roots_[(reinterpret_cast<uintptr_t>(m) / kObjectAlignment) %
+                           kQuickFrameRootsCacheSize];
+    if (roots.method == m) {
+      return roots;
+    }
+    roots.method = m;
+    roots.code = reinterpret_cast<uintptr_t>(
+        Runtime::Current()->GetInstrumentation()->GetQuickCodeFor(m));
+    roots.native_gc_map = m->GetNativeGcMap();
+    CHECK(roots.native_gc_map != nullptr) << PrettyMethod(m);
+    mh_.ChangeMethod(m);
+    const DexFile::CodeItem* code_item = mh_.GetCodeItem();
+    // Can't be nullptr or how would we compile its instructions?
+    DCHECK(code_item != nullptr) << PrettyMethod(m);
+    NativePcOffsetToReferenceMap map(roots.native_gc_map);
+    size_t num_regs = std::min(map.RegWidth() * 8,
+                               static_cast<size_t>(code_item->registers_size_));
+    roots.locations.resize(num_regs);
+    if (num_regs > 0) {
+      const VmapTable vmap_table(m->GetVmapTable());
+      uint32_t core_spills = m->GetCoreSpillMask();
+      uint32_t fp_spills = m->GetFpSpillMask();
+      size_t frame_size = m->GetFrameSizeInBytes();
+      for (size_t reg = 0; reg < num_regs; ++reg) {
+        uint32_t vmap_offset;
+        if (vmap_table.IsInContext(reg, kReferenceVReg, &vmap_offset)) {
+          int vmap_reg = vmap_table.ComputeRegister(core_spills, vmap_offset, kReferenceVReg);
+          roots.locations[reg] = -1 - vmap_reg;
+        } else {
+          roots.locations[reg] = GetVRegOffset(code_item, core_spills, fp_spills, frame_size, reg,
+                                               kRuntimeISA);
+        }
+      }
+    }
+    return roots;
+  }
+
   void VisitQuickFrame() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     mirror::ArtMethod* m = GetMethod();
     // Process register map (which native and runtime methods don't have)
     if (!m->IsNative() && !m->IsRuntimeMethod() && !m->IsProxyMethod()) {
-      const uint8_t* native_gc_map = m->GetNativeGcMap();
-      CHECK(native_gc_map != nullptr) << PrettyMethod(m);
-      mh_.ChangeMethod(m);
-      const DexFile::CodeItem* code_item = mh_.GetCodeItem();
-      DCHECK(code_item != nullptr) << PrettyMethod(m);  // Can't be nullptr or how would we compile its instructions?
-      NativePcOffsetToReferenceMap map(native_gc_map);
-      size_t num_regs = std::min(map.RegWidth() * 8,
-                                 static_cast<size_t>(code_item->registers_size_));
+      const QuickFrameRoots& roots = GetQuickFrameRoots(m);
+      size_t num_regs = roots.locations.size();
       if (num_regs > 0) {
-        const uint8_t* reg_bitmap = map.FindBitMap(GetNativePcOffset());
+        NativePcOffsetToReferenceMap map(roots.native_gc_map);
+        const uint8_t* reg_bitmap = map.FindBitMap(GetCurrentQuickFramePc() - roots.code);
         DCHECK(reg_bitmap != nullptr);
-        const VmapTable vmap_table(m->GetVmapTable());
-        uint32_t core_spills = m->GetCoreSpillMask();
-        uint32_t fp_spills = m->GetFpSpillMask();
-        size_t frame_size = m->GetFrameSizeInBytes();
         // For all dex registers in the bitmap
-        mirror::ArtMethod** cur_quick_frame = GetCurrentQuickFrame();
+        byte* cur_quick_frame = reinterpret_cast<byte*>(GetCurrentQuickFrame());
         DCHECK(cur_quick_frame != nullptr);
         for (size_t reg = 0; reg < num_regs; ++reg) {
           // Does this register hold a reference?
           if (TestBitmap(reg, reg_bitmap)) {
-            uint32_t vmap_offset;
-            if (vmap_table.IsInContext(reg, kReferenceVReg, &vmap_offset)) {
-              int vmap_reg = vmap_table.ComputeRegister(core_spills, vmap_offset, kReferenceVReg);
+            int32_t location = roots.locations[reg];
+            if (location < 0) {
               // This is sound as spilled GPRs will be word sized (ie 32 or 64bit).
-              mirror::Object** ref_addr = reinterpret_cast<mirror::Object**>(GetGPRAddress(vmap_reg));
+              mirror::Object** ref_addr =
+                  reinterpret_cast<mirror::Object**>(GetGPRAddress(-1 - location));
               if (*ref_addr != nullptr) {
                 visitor_(ref_addr, reg, this);
               }
             } else {
               StackReference<mirror::Object>* ref_addr =
-                  reinterpret_cast<StackReference<mirror::Object>*>(
-                      GetVRegAddr(cur_quick_frame, code_item, core_spills, fp_spills, frame_size,
-                                  reg));
+                  reinterpret_cast<StackReference<mirror::Object>*>(cur_quick_frame + location);
               mirror::Object* ref = ref_addr->AsMirrorPtr();
               if (ref != nullptr) {
                 mirror::Object* new_ref = ref;
@@ -2066,6 +2244,9 @@ class ReferenceMapVisitor : public StackVisitor {
 
   // A method helper we keep around to avoid dex file/cache re-computations.
   MethodHelper mh_;
+
+  // Direct mapped by method.
+  QuickFrameRoots quick_frame_roots_[kQuickFrameRootsCacheSize];
 };
 
 class RootCallbackVisitor {
@@ -2107,6 +2288,9 @@ void Thread::VisitRoots(RootCallback* visitor, void* arg) {
   tlsPtr_.jni_env->locals.VisitRoots(visitor, arg, thread_id, kRootJNILocal);
   tlsPtr_.jni_env->monitors.VisitRoots(visitor, arg, thread_id, kRootJNIMonitor);
   SirtVisitRoots(visitor, arg, thread_id);
+  if (tlsPtr_.catch_handler_cache != nullptr) {
+    tlsPtr_.catch_handler_cache->VisitRoots(visitor, arg, thread_id);
+  }
   if (tlsPtr_.debug_invoke_req != nullptr) {
     tlsPtr_.debug_invoke_req->VisitRoots(visitor, arg, thread_id, kRootDebugger);
   }
@@ -63,6 +63,7 @@ namespace mirror {
   class Throwable;
 }  // namespace mirror
 class BaseMutex;
+class CatchHandlerCache;
 class ClassLinker;
 class Closure;
 class Context;
@@ -72,12 +73,14 @@ class JavaVMExt;
 struct JNIEnvExt;
 class Monitor;
 class Runtime;
+class SampleBuffer;
 class ScopedObjectAccess;
 class ScopedObjectAccessUnchecked;
 class ShadowFrame;
 struct SingleStepControl;
 class Thread;
 class ThreadList;
+struct TraceBuffer;
 
 // Thread priorities. These must match the Thread.MIN_PRIORITY,
 // Thread.NORM_PRIORITY, and Thread.MAX_PRIORITY constants.
@@ -161,6 +164,12 @@ class Thread {
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Like Dump but leaves out the native stack, which is slow to unwind and symbolize. Returns
+  // whether Dump would have shown the native stack. The thread must be suspended.
+  bool DumpWithoutNativeStack(std::ostream& os) const
+      LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Dumps the SIGQUIT per-thread header. 'thread' can be NULL for a non-attached thread, in which
   // case we use 'tid' to identify the thread, and we'll include as much information as we can.
   static void DumpState(std::ostream& os, const Thread* thread, pid_t tid)
@@ -297,6 +306,12 @@ class Thread {
     return &tls64_.stats;
   }
 
+  // Counts an allocation of this thread which waited for, or ran, a GC before it could succeed.
+  void AddAllocationStall(uint64_t stall_ns) {
+    ++allocation_stalls_;
+    allocation_stall_time_ns_ += stall_ns;
+  }
+
   bool IsStillStarting() const;
 
   bool IsExceptionPending() const {
@@ -411,7 +426,6 @@ class Thread {
   void SetInterruptedLocked(bool i) EXCLUSIVE_LOCKS_REQUIRED(wait_mutex_) {
     interrupted_ = i;
   }
-  void Notify() LOCKS_EXCLUDED(wait_mutex_);
 
  private:
   void NotifyLocked(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(wait_mutex_);
@@ -464,6 +478,11 @@ class Thread {
       jobject internal, jobjectArray output_array = nullptr, int* stack_depth = nullptr)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Returns the dex pc of a frame given the method and pc recorded in an internal stack trace.
+  // Compiled frames record the native pc, which is only mapped to a dex pc when needed.
+  static uint32_t InternalStackTraceDexPc(mirror::ArtMethod* method, uint32_t trace_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void VisitRoots(RootCallback* visitor, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   ALWAYS_INLINE void VerifyStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -558,6 +577,24 @@ class Thread {
         OFFSETOF_MEMBER(tls_ptr_sized_values, suspend_trigger));
   }
 
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalPosOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_pos));
+  }
+
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalEndOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_end));
+  }
+
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalObjectsOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_objects));
+  }
+
   // Size of stack less any space reserved for stack overflow
   size_t GetStackSize() const {
     return tlsPtr_.stack_size - (tlsPtr_.stack_end - tlsPtr_.stack_begin);
@@ -567,6 +604,12 @@ class Thread {
     return tlsPtr_.stack_end;
   }
 
+  // Whether addr is within the stack of the thread, including the overflow region.
+  bool StackContains(uintptr_t addr) const {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(tlsPtr_.stack_begin);
+    return begin <= addr && addr < begin + tlsPtr_.stack_size;
+  }
+
   // Set the stack end to that to be used during a stack overflow
   void SetStackEndForStackOverflow() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -713,6 +756,33 @@ class Thread {
     tlsPtr_.stack_trace_sample = sample;
   }
 
+  SampleBuffer* GetSampleBuffer() const {
+    return tlsPtr_.sample_buffer;
+  }
+
+  void SetSampleBuffer(SampleBuffer* buffer) {
+    tlsPtr_.sample_buffer = buffer;
+  }
+
+  size_t GetAllocationSampleBytesLeft() const {
+    return tlsPtr_.allocation_sample_bytes_left;
+  }
+
+  void SetAllocationSampleBytesLeft(size_t bytes) {
+    tlsPtr_.allocation_sample_bytes_left = bytes;
+  }
+
+  TraceBuffer* GetTraceBuffer() const {
+    return tlsPtr_.trace_buffer;
+  }
+
+  void SetTraceBuffer(TraceBuffer* buffer) {
+    tlsPtr_.trace_buffer = buffer;
+  }
+
+  // The catch handlers found for the exceptions thrown by this thread, created on first use.
+  CatchHandlerCache* GetCatchHandlerCache();
+
   uint64_t GetTraceClockBase() const {
     return tls64_.trace_clock_base;
   }
@@ -745,12 +815,19 @@ class Thread {
 
   void ResetQuickAllocEntryPointsForThread();
 
+  // Sets the read barrier entrypoint that compiled code checks before calling into the runtime,
+  // see ReadBarrier::SetIsMarking.
+  void SetReadBarrierMarking(bool is_marking);
+
   // Returns the remaining space in the TLAB.
   size_t TlabSize() const;
   // Doesn't check that there is room.
   mirror::Object* AllocTlab(size_t bytes);
   void SetTlab(byte* start, byte* end);
   bool HasTlab() const;
+  byte* GetTlabStart() const {
+    return tlsPtr_.thread_local_start;
+  }
 
   // Remove the suspend trigger for this thread by making the suspend_trigger_ TLS value
   // equal to a valid pointer.
@@ -784,6 +861,58 @@ class Thread {
     return tlsPtr_.thread_local_objects;
   }
 
+  bool HasThreadLocalAllocationStack() const {
+    return tlsPtr_.thread_local_alloc_stack_end != nullptr;
+  }
+
+  // How many references can still be pushed on the thread-local allocation stack.
+  size_t GetThreadLocalAllocationStackFreeSlots() const {
+    return tlsPtr_.thread_local_alloc_stack_end - tlsPtr_.thread_local_alloc_stack_top;
+  }
+
+  // The size of the next thread-local allocation stack in references, adapted by the heap to how
+  // fast the thread allocates.
+  size_t GetThreadLocalAllocationStackSizeHint() const {
+    return tlsPtr_.thread_local_alloc_stack_size;
+  }
+
+  void SetThreadLocalAllocationStackSizeHint(size_t size) {
+    tlsPtr_.thread_local_alloc_stack_size = size;
+  }
+
+  // Bytes allocated by this thread, whole TLABs included, see Heap::GetBytesAllocatedByThread.
+  uint64_t GetAllocatedBytes() const {
+    return tlsPtr_.allocated_bytes;
+  }
+
+  void AddAllocatedBytes(size_t bytes) {
+    tlsPtr_.allocated_bytes += bytes;
+  }
+
+  void SubtractAllocatedBytes(size_t bytes) {
+    DCHECK_LE(bytes, tlsPtr_.allocated_bytes);
+    tlsPtr_.allocated_bytes -= bytes;
+  }
+
+  // Bytes allocated by this thread outside of TLABs and not yet added to the heap's count of
+  // allocated bytes, see Heap::CountAllocatedBytes.
+  size_t GetUnflushedAllocatedBytes() const {
+    return tlsPtr_.unflushed_allocated_bytes;
+  }
+
+  void SetUnflushedAllocatedBytes(size_t bytes) {
+    tlsPtr_.unflushed_allocated_bytes = bytes;
+  }
+
+  // The size of the next TLAB, adapted by the bump pointer space to how fast the thread allocates.
+  size_t GetTlabSizeHint() const {
+    return tlsPtr_.thread_local_tlab_size;
+  }
+
+  void SetTlabSizeHint(size_t size) {
+    tlsPtr_.thread_local_tlab_size = size;
+  }
+
   void* GetRosAllocRun(size_t index) const {
     return tlsPtr_.rosalloc_runs[index];
   }
@@ -798,6 +927,16 @@ class Thread {
                            Locks::thread_suspend_count_lock_);
   void Destroy();
 
+  // Releases what Init set up for the exiting thread, keeping the JNI env and the other
+  // allocations so that ThreadList can hand the object to a thread attaching later.
+  void Recycle() LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_suspend_count_lock_);
+  // Gives a recycled thread the state the constructor gives a new one.
+  void Reuse(bool daemon) NO_THREAD_SAFETY_ANALYSIS;
+  // The part of ~Thread and Recycle that undoes Init.
+  void Release();
+  // The part of the constructor and Reuse that sets up the thread local storage.
+  void InitTlsValues();
+
   void CreatePeer(const char* name, bool as_daemon, jobject thread_group);
 
   template<bool kTransactionActive>
@@ -805,8 +944,8 @@ class Thread {
                 jobject thread_name, jint thread_priority)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Avoid use, callers should use SetState. Used only by SignalCatcher::HandleSigQuit, ~Thread and
-  // Dbg::Disconnected.
+  // Avoid use, callers should use SetState. Used only by SignalCatcher::HandleSigQuit, ~Thread,
+  // Recycle and Dbg::Disconnected.
   ThreadState SetStateUnsafe(ThreadState new_state) {
     ThreadState old_state = GetState();
     tls32_.state_and_flags.as_struct.state = new_state;
@@ -880,6 +1019,11 @@ class Thread {
   // their suspend count is > 0.
   static ConditionVariable* resume_cond_ GUARDED_BY(Locks::thread_suspend_count_lock_);
 
+  // Used to notify the threads suspending all others that a runnable thread with a pending suspend
+  // request left the runnable state, the generation is incremented on each notification.
+  static ConditionVariable* suspend_barrier_cond_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+  static uint32_t suspend_barrier_generation_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+
   /***********************************************************************************************/
   // Thread local storage. Fields are grouped by size to enable 32 <-> 64 searching to account for
   // pointer size differences. To encourage shorter encoding, more frequently used values appear
@@ -955,7 +1099,10 @@ class Thread {
       deoptimization_shadow_frame(nullptr), name(nullptr), pthread_self(0),
       last_no_thread_suspension_cause(nullptr), thread_local_start(nullptr),
       thread_local_pos(nullptr), thread_local_end(nullptr), thread_local_objects(0),
-      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr) {
+      thread_local_tlab_size(0), thread_local_alloc_stack_top(nullptr),
+      thread_local_alloc_stack_end(nullptr), thread_local_alloc_stack_size(0),
+      sample_buffer(nullptr), trace_buffer(nullptr), catch_handler_cache(nullptr),
+      allocation_sample_bytes_left(0), allocated_bytes(0), unflushed_allocated_bytes(0) {
     }
 
     // The biased card table, see CardTable for details.
@@ -1057,13 +1204,38 @@ class Thread {
     byte* thread_local_pos;
     byte* thread_local_end;
     size_t thread_local_objects;
+    // Size of the next thread-local allocation buffer, zero until the first one is allocated.
+    size_t thread_local_tlab_size;
 
-    // There are RosAlloc::kNumThreadLocalSizeBrackets thread-local size brackets per thread.
-    void* rosalloc_runs[gc::allocator::RosAlloc::kNumThreadLocalSizeBrackets];
+    // There are up to RosAlloc::kMaxNumThreadLocalSizeBrackets thread-local size brackets per
+    // thread.
+    void* rosalloc_runs[gc::allocator::RosAlloc::kMaxNumThreadLocalSizeBrackets];
 
     // Thread-local allocation stack data/routines.
     mirror::Object** thread_local_alloc_stack_top;
     mirror::Object** thread_local_alloc_stack_end;
+    // Size of the next thread-local allocation stack in references, zero until the first one is
+    // allocated.
+    size_t thread_local_alloc_stack_size;
+
+    // Where the SIGPROF handler records the samples of this thread, see SignalSampler.
+    SampleBuffer* sample_buffer;
+
+    // The records of this thread not yet handed to the trace writer when streaming a method trace.
+    TraceBuffer* trace_buffer;
+
+    // The catch handlers found by ArtMethod::FindCatchBlock, see CatchHandlerCache.
+    CatchHandlerCache* catch_handler_cache;
+
+    // The bytes this thread allocates before its next sampled allocation, zero until the thread
+    // first allocates, see gc::AllocationSampler.
+    size_t allocation_sample_bytes_left;
+
+    // Bytes allocated by this thread since it started.
+    uint64_t allocated_bytes;
+
+    // Bytes allocated by this thread which the heap doesn't count yet.
+    size_t unflushed_allocated_bytes;
   } tlsPtr_;
 
   // Guards the 'interrupted_' and 'wait_monitor_' members.
@@ -1077,12 +1249,26 @@ class Thread {
   // Thread "interrupted" status; stays raised until queried or thrown.
   bool interrupted_ GUARDED_BY(wait_mutex_);
 
+  // When the thread last left the runnable state with a suspend request pending, which tells
+  // SuspendAll which thread it waited for the longest.
+  uint64_t suspend_time_ns_;
+
+  // When the first of the pending checkpoints was requested.
+  uint64_t checkpoint_request_time_ns_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+
+  // The allocations of this thread stalled by the GC, reported with the thread dump.
+  uint64_t allocation_stalls_;
+  uint64_t allocation_stall_time_ns_;
+
+  // The JNI env kept by Recycle, reset and reused by Init.
+  JNIEnvExt* recycled_jni_env_;
+
   friend class Dbg;  // For SetStateUnsafe.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
   friend class ScopedThreadStateChange;
   friend class SignalCatcher;  // For SetStateUnsafe.
-  friend class ThreadList;  // For ~Thread and Destroy.
+  friend class ThreadList;  // For ~Thread, Destroy, Recycle and Reuse.
 
   DISALLOW_COPY_AND_ASSIGN(Thread);
 };
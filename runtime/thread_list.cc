@@ -27,13 +27,18 @@
 
 #include "base/mutex.h"
 #include "base/mutex-inl.h"
+#include "base/stl_util.h"
 #include "base/timing_logger.h"
 #include "debugger.h"
 #include "jni_internal.h"
 #include "lock_word.h"
 #include "monitor.h"
+#include "read_barrier.h"
 #include "scoped_thread_state_change.h"
+#include "signal_sampler.h"
 #include "thread.h"
+#include "thread_pool.h"
+#include "trace.h"
 #include "utils.h"
 #include "well_known_classes.h"
 
@@ -58,6 +63,13 @@ ThreadList::~ThreadList() {
   // TODO: there's an unaddressed race here where a thread may attach during shutdown, see
   //       Thread::Init.
   SuspendAllDaemonThreads();
+
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  // ~Thread is private, STLDeleteElements can't be used.
+  for (Thread* thread : recycled_threads_) {
+    delete thread;
+  }
+  recycled_threads_.clear();
 }
 
 bool ThreadList::Contains(Thread* thread) {
@@ -87,6 +99,8 @@ void ThreadList::DumpNativeStacks(std::ostream& os) {
 }
 
 void ThreadList::DumpForSigQuit(std::ostream& os) {
+  safepoint_stats_.Dump(os);
+  os << "\n";
   {
     MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
     DumpLocked(os);
@@ -94,6 +108,35 @@ void ThreadList::DumpForSigQuit(std::ostream& os) {
   DumpUnattachedThreads(os);
 }
 
+void ThreadList::DumpManagedStacksForSigQuit(std::ostream& os,
+                                             std::vector<pid_t>* native_stack_tids) {
+  safepoint_stats_.Dump(os);
+  os << "\n";
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  os << "DALVIK THREADS (" << list_.size() << "):\n";
+  for (const auto& thread : list_) {
+    if (thread->DumpWithoutNativeStack(os)) {
+      native_stack_tids->push_back(thread->GetTid());
+    }
+    os << "\n";
+  }
+}
+
+void ThreadList::DumpNativeStacksForSigQuit(std::ostream& os,
+                                            const std::vector<pid_t>& native_stack_tids) {
+  if (!native_stack_tids.empty()) {
+    // The threads ran since their managed stack was dumped, the native stacks may not match it.
+    os << "NATIVE STACKS AFTER RESUMING (" << native_stack_tids.size() << "):\n";
+    for (pid_t tid : native_stack_tids) {
+      os << "sysTid=" << tid << "\n";
+      DumpKernelStack(os, tid, "  kernel: ", false);
+      DumpNativeStack(os, tid, "  native: ");
+      os << "\n";
+    }
+  }
+  DumpUnattachedThreads(os);
+}
+
 static void DumpUnattachedThread(std::ostream& os, pid_t tid) NO_THREAD_SAFETY_ANALYSIS {
   // TODO: No thread safety analysis as DumpState with a NULL thread won't access fields, should
   // refactor DumpState to avoid skipping analysis.
@@ -196,7 +239,50 @@ static void ThreadSuspendSleep(Thread* self, useconds_t* delay_us, useconds_t* t
   }
 }
 
-size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
+// Run the checkpoint for a thread whose suspend count RunCheckpoint raised, once it is suspended.
+static void RunCheckpointOnSuspendedThread(Thread* self, Closure* checkpoint_function,
+                                           Thread* thread)
+    LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_) {
+  if (!thread->IsSuspended()) {
+    // Wait until the thread is suspended.
+    useconds_t total_delay_us = 0;
+    do {
+      useconds_t delay_us = 100;
+      ThreadSuspendSleep(self, &delay_us, &total_delay_us, true);
+    } while (!thread->IsSuspended());
+    // Shouldn't need to wait for longer than 1000 microseconds.
+    constexpr useconds_t kLongWaitThresholdUS = 1000;
+    if (UNLIKELY(total_delay_us > kLongWaitThresholdUS)) {
+      LOG(WARNING) << "Waited " << total_delay_us << " us for thread suspend!";
+    }
+  }
+  // We know for sure that the thread is suspended at this point.
+  checkpoint_function->Run(thread);
+  {
+    MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+    thread->ModifySuspendCount(self, -1, false);
+  }
+}
+
+class SuspendedThreadCheckpointTask : public Task {
+ public:
+  SuspendedThreadCheckpointTask(Closure* checkpoint_function, Thread* thread)
+      : checkpoint_function_(checkpoint_function), thread_(thread) {}
+
+  virtual void Run(Thread* self) OVERRIDE {
+    RunCheckpointOnSuspendedThread(self, checkpoint_function_, thread_);
+  }
+
+  virtual void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Closure* const checkpoint_function_;
+  Thread* const thread_;
+};
+
+size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, ThreadPool* thread_pool) {
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertNotExclusiveHeld(self);
   Locks::thread_list_lock_->AssertNotHeld(self);
@@ -239,25 +325,18 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
   checkpoint_function->Run(self);
 
   // Run the checkpoint on the suspended threads.
-  for (const auto& thread : suspended_count_modified_threads) {
-    if (!thread->IsSuspended()) {
-      // Wait until the thread is suspended.
-      useconds_t total_delay_us = 0;
-      do {
-        useconds_t delay_us = 100;
-        ThreadSuspendSleep(self, &delay_us, &total_delay_us, true);
-      } while (!thread->IsSuspended());
-      // Shouldn't need to wait for longer than 1000 microseconds.
-      constexpr useconds_t kLongWaitThresholdUS = 1000;
-      if (UNLIKELY(total_delay_us > kLongWaitThresholdUS)) {
-        LOG(WARNING) << "Waited " << total_delay_us << " us for thread suspend!";
-      }
+  if (thread_pool != nullptr &&
+      suspended_count_modified_threads.size() >= kMinSuspendedThreadsForThreadPool) {
+    for (const auto& thread : suspended_count_modified_threads) {
+      thread_pool->AddTask(self, new SuspendedThreadCheckpointTask(checkpoint_function, thread));
     }
-    // We know for sure that the thread is suspended at this point.
-    checkpoint_function->Run(thread);
-    {
-      MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
-      thread->ModifySuspendCount(self, -1, false);
+    thread_pool->SetMaxActiveWorkers(thread_pool->GetThreadCount());
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  } else {
+    for (const auto& thread : suspended_count_modified_threads) {
+      RunCheckpointOnSuspendedThread(self, checkpoint_function, thread);
     }
   }
 
@@ -302,6 +381,51 @@ size_t ThreadList::RunCheckpointOnRunnableThreads(Closure* checkpoint_function)
   return count;
 }
 
+void ThreadList::WaitForRunnableThreadsToSuspend(Thread* self, Thread* ignore) {
+#if HAVE_TIMED_RWLOCK
+  const uint64_t start_time = NanoTime();
+#endif
+  bool timed_out = false;
+  while (!timed_out) {
+    uint32_t generation;
+    {
+      MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+      generation = Thread::suspend_barrier_generation_;
+    }
+    bool runnable = false;
+    {
+      MutexLock mu(self, *Locks::thread_list_lock_);
+      for (const auto& thread : list_) {
+        if (thread != self && thread != ignore && thread->GetState() == kRunnable) {
+          runnable = true;
+          break;
+        }
+      }
+    }
+    if (!runnable) {
+      return;
+    }
+    // The suspend requests are raised, a thread leaving the runnable state increments the
+    // generation so that a change after it was read above isn't missed.
+    MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+    while (Thread::suspend_barrier_generation_ == generation) {
+#if HAVE_TIMED_RWLOCK
+      // Timeout if we wait more than 30 seconds.
+      if (NanoTime() - start_time > MsToNs(30 * 1000)) {
+        timed_out = true;
+        break;
+      }
+      Thread::suspend_barrier_cond_->TimedWait(self, 100, 0);
+#else
+      Thread::suspend_barrier_cond_->Wait(self);
+#endif
+    }
+  }
+#if HAVE_TIMED_RWLOCK
+  UnsafeLogFatalForThreadSuspendAllTimeout(self);
+#endif
+}
+
 void ThreadList::SuspendAll() {
   Thread* self = Thread::Current();
   DCHECK(self != nullptr);
@@ -316,6 +440,7 @@ void ThreadList::SuspendAll() {
   if (kDebugLocking) {
     CHECK_NE(self->GetState(), kRunnable);
   }
+  const uint64_t start_time = NanoTime();
   {
     MutexLock mu(self, *Locks::thread_list_lock_);
     MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
@@ -331,7 +456,9 @@ void ThreadList::SuspendAll() {
     }
   }
 
-  // Block on the mutator lock until all Runnable threads release their share of access.
+  // Runnable threads don't hold their share of the mutator lock, wait for them to suspend. Then
+  // block on the mutator lock until the threads holding it explicitly release it.
+  WaitForRunnableThreadsToSuspend(self, nullptr);
 #if HAVE_TIMED_RWLOCK
   // Timeout if we wait more than 30 seconds.
   if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, 30 * 1000, 0)) {
@@ -341,6 +468,21 @@ void ThreadList::SuspendAll() {
   Locks::mutator_lock_->ExclusiveLock(self);
 #endif
 
+  const uint64_t wait_time = NanoTime() - start_time;
+  {
+    // The last thread to suspend is the one which left the runnable state last.
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    Thread* slowest = nullptr;
+    uint64_t slowest_suspend_time = start_time;
+    for (const auto& thread : list_) {
+      if (thread != self && thread->suspend_time_ns_ > slowest_suspend_time) {
+        slowest = thread;
+        slowest_suspend_time = thread->suspend_time_ns_;
+      }
+    }
+    safepoint_stats_.RecordSuspendAll(wait_time, slowest);
+  }
+
   if (kDebugLocking) {
     // Debug check that all threads are suspended.
     AssertThreadsAreSuspended(self, self);
@@ -383,6 +525,10 @@ void ThreadList::ResumeAll() {
     // which may choose to wake up.  No need to wait for them.
     VLOG(threads) << *self << " ResumeAll waking others";
     Thread::resume_cond_->Broadcast(self);
+    // Another thread suspending all may be waiting for this one, which may have made itself
+    // runnable while the others were suspended.
+    ++Thread::suspend_barrier_generation_;
+    Thread::suspend_barrier_cond_->Broadcast(self);
   }
   ATRACE_END();
   VLOG(threads) << *self << " ResumeAll complete";
@@ -585,8 +731,9 @@ void ThreadList::SuspendAllForDebugger() {
     }
   }
 
-  // Block on the mutator lock until all Runnable threads release their share of access then
-  // immediately unlock again.
+  // Wait for the runnable threads to suspend. Then block on the mutator lock until the threads
+  // holding it explicitly release their share of access and immediately unlock again.
+  WaitForRunnableThreadsToSuspend(self, debug_thread);
 #if HAVE_TIMED_RWLOCK
   // Timeout if we wait more than 30 seconds.
   if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, 30 * 1000, 0)) {
@@ -772,6 +919,25 @@ void ThreadList::Register(Thread* self) {
   }
   CHECK(!Contains(self));
   list_.push_back(self);
+  // Under the thread list lock so that ReadBarrier::SetIsMarking either sees the thread or has
+  // already published the new state.
+  self->SetReadBarrierMarking(ReadBarrier::IsMarking());
+}
+
+Thread* ThreadList::NewThread(bool daemon) {
+  Thread* thread = nullptr;
+  {
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    if (!recycled_threads_.empty()) {
+      thread = recycled_threads_.back();
+      recycled_threads_.pop_back();
+    }
+  }
+  if (thread == nullptr) {
+    return new Thread(daemon);
+  }
+  thread->Reuse(daemon);
+  return thread;
 }
 
 void ThreadList::Unregister(Thread* self) {
@@ -782,6 +948,8 @@ void ThreadList::Unregister(Thread* self) {
   // Any time-consuming destruction, plus anything that can call back into managed code or
   // suspend and so on, must happen at this point, and not in ~Thread.
   self->Destroy();
+  SignalSampler::ThreadDetached(self);
+  Trace::StoreExitingThreadInfo(self);
 
   uint32_t thin_lock_id = self->GetThreadId();
   while (self != nullptr) {
@@ -794,7 +962,12 @@ void ThreadList::Unregister(Thread* self) {
     // than yourself you need to hold the thread_list_lock_ (see Thread::ModifySuspendCount).
     if (!self->IsSuspended()) {
       list_.remove(self);
-      delete self;
+      if (recycled_threads_.size() < kMaxRecycledThreads) {
+        self->Recycle();
+        recycled_threads_.push_back(self);
+      } else {
+        delete self;
+      }
       self = nullptr;
     }
     Locks::thread_list_lock_->ExclusiveUnlock(self);
@@ -20,13 +20,16 @@
 #include "base/mutex.h"
 #include "jni.h"
 #include "object_callbacks.h"
+#include "safepoint_stats.h"
 
 #include <bitset>
 #include <list>
+#include <vector>
 
 namespace art {
 class Closure;
 class Thread;
+class ThreadPool;
 class TimingLogger;
 
 class ThreadList {
@@ -34,6 +37,10 @@ class ThreadList {
   static const uint32_t kMaxThreadId = 0xFFFF;
   static const uint32_t kInvalidThreadId = 0;
   static const uint32_t kMainThreadId = 1;
+  // Fewer suspended threads than this are not worth running the checkpoint on a thread pool.
+  static constexpr size_t kMinSuspendedThreadsForThreadPool = 8;
+  // The most detached threads kept for threads attaching later.
+  static constexpr size_t kMaxRecycledThreads = 8;
 
   explicit ThreadList();
   ~ThreadList();
@@ -41,6 +48,14 @@ class ThreadList {
   void DumpForSigQuit(std::ostream& os)
       LOCKS_EXCLUDED(Locks::thread_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // For low pause SIGQUIT dumps, the part of DumpForSigQuit that needs the threads suspended.
+  // Dumps the state and managed stack of the threads and adds to native_stack_tids the threads
+  // whose native stack is dumped by DumpNativeStacksForSigQuit once the threads resume.
+  void DumpManagedStacksForSigQuit(std::ostream& os, std::vector<pid_t>* native_stack_tids)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void DumpNativeStacksForSigQuit(std::ostream& os, const std::vector<pid_t>& native_stack_tids)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::mutator_lock_);
   void DumpLocked(std::ostream& os)  // For thread suspend timeout dumps.
       EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -85,8 +100,9 @@ class ThreadList {
   Thread* FindThreadByThreadId(uint32_t thin_lock_id);
 
   // Run a checkpoint on threads, running threads are not suspended but run the checkpoint inside
-  // of the suspend check. Returns how many checkpoints we should expect to run.
-  size_t RunCheckpoint(Closure* checkpoint_function)
+  // of the suspend check. Returns how many checkpoints we should expect to run. If thread_pool is
+  // not null, the checkpoints of suspended threads are run on it.
+  size_t RunCheckpoint(Closure* checkpoint_function, ThreadPool* thread_pool = nullptr)
       LOCKS_EXCLUDED(Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_);
 
@@ -110,6 +126,9 @@ class ThreadList {
   void ForEach(void (*callback)(Thread*, void*), void* context)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_);
 
+  // Returns a thread recycled by Unregister, or a new one when none is pooled, for Thread::Init.
+  Thread* NewThread(bool daemon) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
   // Add/remove current thread from list.
   void Register(Thread* self)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::runtime_shutdown_lock_)
@@ -122,6 +141,10 @@ class ThreadList {
   void VerifyRoots(VerifyRootCallback* callback, void* arg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  size_t Size() EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_) {
+    return list_.size();
+  }
+
   // Return a copy of the thread list.
   std::list<Thread*> GetList() EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_) {
     return list_;
@@ -130,6 +153,10 @@ class ThreadList {
   void DumpNativeStacks(std::ostream& os)
       LOCKS_EXCLUDED(Locks::thread_list_lock_);
 
+  SafepointStats* GetSafepointStats() {
+    return &safepoint_stats_;
+  }
+
  private:
   uint32_t AllocThreadId(Thread* self);
   void ReleaseThreadId(Thread* self, uint32_t id) LOCKS_EXCLUDED(allocated_ids_lock_);
@@ -140,6 +167,11 @@ class ThreadList {
   void DumpUnattachedThreads(std::ostream& os)
       LOCKS_EXCLUDED(Locks::thread_list_lock_);
 
+  // Waits until the threads other than self and ignore, which may be null, are not runnable.
+  void WaitForRunnableThreadsToSuspend(Thread* self, Thread* ignore)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_,
+                     Locks::thread_suspend_count_lock_);
+
   void SuspendAllDaemonThreads()
       LOCKS_EXCLUDED(Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_);
@@ -157,6 +189,11 @@ class ThreadList {
   // The actual list of all threads.
   std::list<Thread*> list_ GUARDED_BY(Locks::thread_list_lock_);
 
+  // Detached threads, with their JNI envs and other allocations, reused by NewThread. Threads
+  // attaching and detaching repeatedly, like the binder threads calling into managed code, don't
+  // allocate and free them every time.
+  std::vector<Thread*> recycled_threads_ GUARDED_BY(Locks::thread_list_lock_);
+
   // Ongoing suspend all requests, used to ensure threads added to list_ respect SuspendAll.
   int suspend_all_count_ GUARDED_BY(Locks::thread_suspend_count_lock_);
   int debug_suspend_all_count_ GUARDED_BY(Locks::thread_suspend_count_lock_);
@@ -164,6 +201,9 @@ class ThreadList {
   // Signaled when threads terminate. Used to determine when all non-daemons have terminated.
   ConditionVariable thread_exit_cond_ GUARDED_BY(Locks::thread_list_lock_);
 
+  // Time to safepoint of SuspendAll and of the checkpoints.
+  SafepointStats safepoint_stats_;
+
   friend class Thread;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadList);
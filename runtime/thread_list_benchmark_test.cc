@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "atomic.h"
+#include "barrier.h"
+#include "base/histogram-inl.h"
+#include "common_runtime_test.h"
+#include "entrypoints/entrypoint_utils.h"
+#include "scoped_thread_state_change.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+
+// Thread suspension benchmarks. The tests are disabled so that the gtest targets only build them,
+// "make test-art-host-thread-benchmark" runs them. Every benchmark prints a line of space
+// separated key=value pairs with the latency percentiles of SuspendAll or of a checkpoint run by
+// all the threads, starting with "thread_benchmark".
+//
+// The runnable threads spin on suspend checks, as managed code in a loop does. The native threads
+// sleep, as threads blocked in native code do, so they are suspended already.
+class ThreadListBenchmarkTest : public CommonRuntimeTest {
+ public:
+  typedef uint64_t (ThreadListBenchmarkTest::*Operation)(Thread* self);
+
+  ThreadListBenchmarkTest() : started_barrier_(0), checkpoint_barrier_(0) {}
+
+  void Run(const char* name, size_t runnable_threads, size_t native_threads,
+           Operation operation) {
+    Thread* self = Thread::Current();
+    stop_ = 0;
+    std::vector<pthread_t> threads;
+    for (size_t i = 0; i < runnable_threads + native_threads; ++i) {
+      pthread_t thread;
+      void* (*entry)(void*) = (i < runnable_threads) ? &RunnableThread : &NativeThread;
+      CHECK_PTHREAD_CALL(pthread_create, (&thread, nullptr, entry, this), "benchmark thread");
+      threads.push_back(thread);
+    }
+    started_barrier_.Increment(self, threads.size());
+
+    for (size_t i = 0; i < kWarmUpIterations; ++i) {
+      (this->*operation)(self);
+    }
+    Histogram<uint64_t> latencies(name, kInitialBucketSize, kBucketCount);
+    for (size_t i = 0; i < kIterations; ++i) {
+      latencies.AddValue((this->*operation)(self) / 1000);
+    }
+
+    stop_ = 1;
+    for (pthread_t thread : threads) {
+      CHECK_PTHREAD_CALL(pthread_join, (thread, nullptr), "benchmark thread");
+    }
+
+    Histogram<uint64_t>::CumulativeData cumulative_data;
+    latencies.CreateHistogram(&cumulative_data);
+    printf("thread_benchmark name=%s runnable_threads=%zd native_threads=%zd iterations=%zd "
+           "p50_us=%.0f p90_us=%.0f p99_us=%.0f max_us=%" PRIu64 "\n",
+           name, runnable_threads, native_threads, kIterations,
+           latencies.Percentile(0.5, cumulative_data), latencies.Percentile(0.9, cumulative_data),
+           latencies.Percentile(0.99, cumulative_data), latencies.Max());
+    fflush(stdout);
+  }
+
+  // Returns the time until all the threads are suspended.
+  uint64_t SuspendAll(Thread* self) {
+    ThreadList* thread_list = Runtime::Current()->GetThreadList();
+    uint64_t start_time = NanoTime();
+    thread_list->SuspendAll();
+    uint64_t duration_ns = NanoTime() - start_time;
+    thread_list->ResumeAll();
+    return duration_ns;
+  }
+
+  class BarrierClosure : public Closure {
+   public:
+    explicit BarrierClosure(Barrier* barrier) : barrier_(barrier) {}
+
+    void Run(Thread* thread) {
+      barrier_->Pass(Thread::Current());
+    }
+
+   private:
+    Barrier* const barrier_;
+  };
+
+  // Returns the time until all the threads ran the checkpoint. The requesting thread runs the
+  // checkpoints of the suspended threads itself.
+  uint64_t Checkpoint(Thread* self) {
+    BarrierClosure closure(&checkpoint_barrier_);
+    uint64_t start_time = NanoTime();
+    size_t count = Runtime::Current()->GetThreadList()->RunCheckpoint(&closure);
+    checkpoint_barrier_.Increment(self, count);
+    return NanoTime() - start_time;
+  }
+
+ private:
+  static void* RunnableThread(void* arg) {
+    ThreadListBenchmarkTest* test = reinterpret_cast<ThreadListBenchmarkTest*>(arg);
+    CHECK(Runtime::Current()->AttachCurrentThread("runnable benchmark thread", true, nullptr,
+                                                  false));
+    Thread* self = Thread::Current();
+    test->started_barrier_.Pass(self);
+    {
+      ScopedObjectAccess soa(self);
+      while (test->stop_.Load() == 0) {
+        CheckSuspend(self);
+      }
+    }
+    Runtime::Current()->DetachCurrentThread();
+    return nullptr;
+  }
+
+  static void* NativeThread(void* arg) {
+    ThreadListBenchmarkTest* test = reinterpret_cast<ThreadListBenchmarkTest*>(arg);
+    CHECK(Runtime::Current()->AttachCurrentThread("native benchmark thread", true, nullptr,
+                                                  false));
+    test->started_barrier_.Pass(Thread::Current());
+    while (test->stop_.Load() == 0) {
+      usleep(kNativeSleepUs);
+    }
+    Runtime::Current()->DetachCurrentThread();
+    return nullptr;
+  }
+
+  static constexpr size_t kWarmUpIterations = 100;
+  static constexpr size_t kIterations = 2000;
+  static constexpr size_t kInitialBucketSize = 1;  // 1 microsecond.
+  static constexpr size_t kBucketCount = 100;
+  static constexpr useconds_t kNativeSleepUs = 1000;
+
+  Barrier started_barrier_;
+  Barrier checkpoint_barrier_;
+  Atomic<int32_t> stop_;
+};
+
+// Declares the benchmarks of SuspendAll and RunCheckpoint with the given numbers of threads.
+#define THREAD_LIST_BENCHMARKS(runnable_threads, native_threads) \
+  TEST_F(ThreadListBenchmarkTest, \
+         DISABLED_SuspendAll_##runnable_threads##Runnable_##native_threads##Native) { \
+    Run("suspend_all", runnable_threads, native_threads, &ThreadListBenchmarkTest::SuspendAll); \
+  } \
+  TEST_F(ThreadListBenchmarkTest, \
+         DISABLED_Checkpoint_##runnable_threads##Runnable_##native_threads##Native) { \
+    Run("checkpoint", runnable_threads, native_threads, &ThreadListBenchmarkTest::Checkpoint); \
+  }
+
+THREAD_LIST_BENCHMARKS(0, 0)
+THREAD_LIST_BENCHMARKS(4, 0)
+THREAD_LIST_BENCHMARKS(0, 4)
+THREAD_LIST_BENCHMARKS(4, 4)
+THREAD_LIST_BENCHMARKS(16, 16)
+THREAD_LIST_BENCHMARKS(64, 64)
+
+}  // namespace art
@@ -16,19 +16,28 @@
 
 #include "thread_pool.h"
 
+#include <sched.h>
+
+#include <algorithm>
+#include <ostream>
+
 #include "base/casts.h"
 #include "base/stl_util.h"
 #include "runtime.h"
 #include "thread-inl.h"
+#include "utils.h"
 
 namespace art {
 
 static constexpr bool kMeasureWaitTime = false;
 
 ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name,
-                                   size_t stack_size)
+                                   size_t stack_size, int numa_node)
     : thread_pool_(thread_pool),
-      name_(name) {
+      name_(name),
+      numa_node_(numa_node),
+      busy_time_ns_(0),
+      idle_time_ns_(0) {
   std::string error_msg;
   stack_.reset(MemMap::MapAnonymous(name.c_str(), nullptr, stack_size, PROT_READ | PROT_WRITE,
                                     false, &error_msg));
@@ -49,16 +58,25 @@ void ThreadPoolWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   thread_pool_->creation_barier_.Wait(self);
+  uint64_t idle_start = NanoTime();
   while ((task = thread_pool_->GetTask(self)) != NULL) {
+    const uint64_t busy_start = NanoTime();
+    idle_time_ns_ += busy_start - idle_start;
     task->Run(self);
     task->Finalize();
+    idle_start = NanoTime();
+    busy_time_ns_ += idle_start - busy_start;
   }
 }
 
 void* ThreadPoolWorker::Callback(void* arg) {
   ThreadPoolWorker* worker = reinterpret_cast<ThreadPoolWorker*>(arg);
   Runtime* runtime = Runtime::Current();
-  CHECK(runtime->AttachCurrentThread(worker->name_.c_str(), true, NULL, false));
+  CHECK(runtime->AttachCurrentThread(worker->name_.c_str(), true, NULL,
+                                     worker->thread_pool_->create_peers_));
+  if (worker->numa_node_ != -1) {
+    worker->thread_pool_->PinCurrentThreadToNumaNode(worker->numa_node_);
+  }
   // Do work until its time to shut down.
   worker->Run();
   runtime->DetachCurrentThread();
@@ -67,14 +85,30 @@ void* ThreadPoolWorker::Callback(void* arg) {
 
 void ThreadPool::AddTask(Thread* self, Task* task) {
   MutexLock mu(self, task_queue_lock_);
-  tasks_.push_back(task);
+  tasks_[task->GetPriority()].push_back(task);
   // If we have any waiters, signal one.
   if (started_ && waiting_count_ != 0) {
     task_queue_condition_.Signal(self);
   }
 }
 
-ThreadPool::ThreadPool(const char* name, size_t num_threads)
+void ThreadPool::AddTasks(Thread* self, const std::vector<Task*>& tasks) {
+  MutexLock mu(self, task_queue_lock_);
+  for (Task* task : tasks) {
+    tasks_[task->GetPriority()].push_back(task);
+  }
+  if (started_ && waiting_count_ != 0) {
+    if (tasks.size() >= waiting_count_) {
+      task_queue_condition_.Broadcast(self);
+    } else {
+      for (size_t i = 0; i < tasks.size(); ++i) {
+        task_queue_condition_.Signal(self);
+      }
+    }
+  }
+}
+
+ThreadPool::ThreadPool(const char* name, size_t num_threads, bool numa_aware, bool create_peers)
   : name_(name),
     task_queue_lock_("task queue lock"),
     task_queue_condition_("task queue condition", task_queue_lock_),
@@ -86,16 +120,94 @@ ThreadPool::ThreadPool(const char* name, size_t num_threads)
     total_wait_time_(0),
     // Add one since the caller of constructor waits on the barrier too.
     creation_barier_(num_threads + 1),
-    max_active_workers_(num_threads) {
+    max_active_workers_(num_threads),
+    cross_node_tasks_(0),
+    create_peers_(create_peers) {
   Thread* self = Thread::Current();
+  if (numa_aware && GetNumaNodeCpus(&numa_node_cpus_)) {
+    size_t nodes_with_cpus = 0;
+    for (size_t node = 0; node < numa_node_cpus_.size(); ++node) {
+      for (int cpu : numa_node_cpus_[node]) {
+        if (static_cast<size_t>(cpu) >= cpu_numa_nodes_.size()) {
+          cpu_numa_nodes_.resize(cpu + 1, -1);
+        }
+        cpu_numa_nodes_[cpu] = node;
+      }
+      if (!numa_node_cpus_[node].empty()) {
+        ++nodes_with_cpus;
+      }
+    }
+    if (nodes_with_cpus < 2) {
+      // Nothing to gain from pinning on a single node.
+      numa_node_cpus_.clear();
+      cpu_numa_nodes_.clear();
+    }
+  }
   while (GetThreadCount() < num_threads) {
     const std::string name = StringPrintf("%s worker thread %zu", name_.c_str(), GetThreadCount());
-    threads_.push_back(new ThreadPoolWorker(this, name, ThreadPoolWorker::kDefaultStackSize));
+    threads_.push_back(new ThreadPoolWorker(this, name, ThreadPoolWorker::kDefaultStackSize,
+                                            NextWorkerNumaNode()));
   }
   // Wait for all of the threads to attach.
   creation_barier_.Wait(self);
 }
 
+int ThreadPool::NextWorkerNumaNode() const {
+  if (!IsNumaAware()) {
+    return -1;
+  }
+  // Spread the workers round robin over the nodes which have CPUs.
+  size_t index = GetThreadCount();
+  for (;;) {
+    for (size_t node = 0; node < numa_node_cpus_.size(); ++node) {
+      if (!numa_node_cpus_[node].empty() && index-- == 0) {
+        return node;
+      }
+    }
+  }
+}
+
+void ThreadPool::PinCurrentThreadToNumaNode(int numa_node) const {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : numa_node_cpus_[numa_node]) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    PLOG(WARNING) << "Failed to pin " << name_ << " worker to NUMA node " << numa_node;
+  }
+#else
+  UNUSED(numa_node);
+#endif
+}
+
+int ThreadPool::GetCurrentNumaNode() const {
+#if defined(__linux__)
+  const int cpu = sched_getcpu();
+  if (cpu >= 0 && static_cast<size_t>(cpu) < cpu_numa_nodes_.size()) {
+    return cpu_numa_nodes_[cpu];
+  }
+#endif
+  return -1;
+}
+
+int ThreadPool::GetNumaNodeOfAddress(const void* addr) const {
+  return IsNumaAware() ? ::art::GetNumaNodeOfAddress(addr) : -1;
+}
+
+uint64_t ThreadPool::GetCrossNodeTaskCount(Thread* self) {
+  MutexLock mu(self, task_queue_lock_);
+  return cross_node_tasks_;
+}
+
+void ThreadPool::DumpWorkerTimes(std::ostream& os) const {
+  for (const ThreadPoolWorker* worker : threads_) {
+    os << worker->name_ << ": busy " << PrettyDuration(worker->GetBusyTime())
+       << ", idle " << PrettyDuration(worker->GetIdleTime()) << "\n";
+  }
+}
+
 void ThreadPool::SetMaxActiveWorkers(size_t threads) {
   MutexLock mu(Thread::Current(), task_queue_lock_);
   CHECK_LE(threads, GetThreadCount());
@@ -144,7 +256,7 @@ Task* ThreadPool::GetTask(Thread* self) {
     }
 
     ++waiting_count_;
-    if (waiting_count_ == GetThreadCount() && tasks_.empty()) {
+    if (waiting_count_ == GetThreadCount() && !HasTasks()) {
       // We may be done, lets broadcast to the completion condition.
       completion_condition_.Broadcast(self);
     }
@@ -167,14 +279,42 @@ Task* ThreadPool::TryGetTask(Thread* self) {
 }
 
 Task* ThreadPool::TryGetTaskLocked(Thread* self) {
-  if (started_ && !tasks_.empty()) {
-    Task* task = tasks_.front();
-    tasks_.pop_front();
+  if (!started_) {
+    return NULL;
+  }
+  for (std::deque<Task*>& tasks : tasks_) {
+    if (tasks.empty()) {
+      continue;
+    }
+    auto it = tasks.begin();
+    if (IsNumaAware()) {
+      // Take the oldest task of our node, if there is none the oldest task of any node.
+      const int numa_node = GetCurrentNumaNode();
+      auto local = std::find_if(tasks.begin(), tasks.end(), [numa_node](Task* task) {
+        return task->GetNumaNode() == numa_node;
+      });
+      if (local != tasks.end()) {
+        it = local;
+      } else if ((*it)->GetNumaNode() != -1 && numa_node != -1) {
+        ++cross_node_tasks_;
+      }
+    }
+    Task* task = *it;
+    tasks.erase(it);
     return task;
   }
   return NULL;
 }
 
+bool ThreadPool::HasTasks() const {
+  for (const std::deque<Task*>& tasks : tasks_) {
+    if (!tasks.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
   if (do_work) {
     Task* task = NULL;
@@ -185,7 +325,7 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
   }
   // Wait until each thread is waiting and the task list is empty.
   MutexLock mu(self, task_queue_lock_);
-  while (!shutting_down_ && (waiting_count_ != GetThreadCount() || !tasks_.empty())) {
+  while (!shutting_down_ && (waiting_count_ != GetThreadCount() || HasTasks())) {
     if (!may_hold_locks) {
       completion_condition_.Wait(self);
     } else {
@@ -196,18 +336,25 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
 
 size_t ThreadPool::GetTaskCount(Thread* self) {
   MutexLock mu(self, task_queue_lock_);
-  return tasks_.size();
+  size_t count = 0;
+  for (const std::deque<Task*>& tasks : tasks_) {
+    count += tasks.size();
+  }
+  return count;
 }
 
 WorkStealingWorker::WorkStealingWorker(ThreadPool* thread_pool, const std::string& name,
-                                       size_t stack_size)
-    : ThreadPoolWorker(thread_pool, name, stack_size), task_(NULL) {}
+                                       size_t stack_size, int numa_node)
+    : ThreadPoolWorker(thread_pool, name, stack_size, numa_node), task_(NULL) {}
 
 void WorkStealingWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   WorkStealingThreadPool* thread_pool = down_cast<WorkStealingThreadPool*>(thread_pool_);
+  uint64_t idle_start = NanoTime();
   while ((task = thread_pool_->GetTask(self)) != NULL) {
+    const uint64_t busy_start = NanoTime();
+    idle_time_ns_ += busy_start - idle_start;
     WorkStealingTask* stealing_task = down_cast<WorkStealingTask*>(task);
 
     {
@@ -234,7 +381,7 @@ void WorkStealingWorker::Run() {
       {
         MutexLock mu(self, thread_pool->work_steal_lock_);
         // Try finding a task to steal from.
-        steal_from_task = thread_pool->FindTaskToStealFrom(self);
+        steal_from_task = thread_pool->FindTaskToStealFrom(self, this);
         if (steal_from_task != NULL) {
           CHECK_NE(stealing_task, steal_from_task)
               << "Attempting to steal from completed self task";
@@ -245,12 +392,19 @@ void WorkStealingWorker::Run() {
       }
 
       if (steal_from_task != NULL) {
+        {
+          // Register our task again while it processes the stolen work so that other workers can
+          // in turn steal from it.
+          MutexLock mu(self, thread_pool->work_steal_lock_);
+          task_ = stealing_task;
+        }
         // Task which completed earlier is going to steal some work.
         stealing_task->StealFrom(self, steal_from_task);
 
         {
           // We are done stealing from the task, lets decrement its reference count.
           MutexLock mu(self, thread_pool->work_steal_lock_);
+          task_ = NULL;
           finalize = !--steal_from_task->ref_count_;
         }
 
@@ -269,41 +423,62 @@ void WorkStealingWorker::Run() {
     if (finalize) {
       stealing_task->Finalize();
     }
+    idle_start = NanoTime();
+    busy_time_ns_ += idle_start - busy_start;
   }
 }
 
 WorkStealingWorker::~WorkStealingWorker() {}
 
-WorkStealingThreadPool::WorkStealingThreadPool(const char* name, size_t num_threads)
-    : ThreadPool(name, 0),
+WorkStealingThreadPool::WorkStealingThreadPool(const char* name, size_t num_threads,
+                                               bool numa_aware)
+    : ThreadPool(name, 0, numa_aware),
       work_steal_lock_("work stealing lock"),
-      steal_index_(0) {
+      steal_index_(0),
+      steals_(0),
+      cross_node_steals_(0) {
   while (GetThreadCount() < num_threads) {
     const std::string name = StringPrintf("Work stealing worker %zu", GetThreadCount());
-    threads_.push_back(new WorkStealingWorker(this, name, ThreadPoolWorker::kDefaultStackSize));
+    threads_.push_back(new WorkStealingWorker(this, name, ThreadPoolWorker::kDefaultStackSize,
+                                              NextWorkerNumaNode()));
   }
 }
 
-WorkStealingTask* WorkStealingThreadPool::FindTaskToStealFrom(Thread* self) {
+WorkStealingTask* WorkStealingThreadPool::FindTaskToStealFrom(Thread* self,
+                                                              WorkStealingWorker* thief) {
   const size_t thread_count = GetThreadCount();
-  for (size_t i = 0; i < thread_count; ++i) {
-    // TODO: Use CAS instead of lock.
-    ++steal_index_;
-    if (steal_index_ >= thread_count) {
-      steal_index_-= thread_count;
-    }
+  // Without NUMA awareness every worker is on node -1, so the first pass finds any victim.
+  for (bool same_node : {true, false}) {
+    for (size_t i = 0; i < thread_count; ++i) {
+      // TODO: Use CAS instead of lock.
+      ++steal_index_;
+      if (steal_index_ >= thread_count) {
+        steal_index_-= thread_count;
+      }
 
-    WorkStealingWorker* worker = down_cast<WorkStealingWorker*>(threads_[steal_index_]);
-    WorkStealingTask* task = worker->task_;
-    if (task) {
-      // Not null, we can probably steal from this worker.
-      return task;
+      WorkStealingWorker* worker = down_cast<WorkStealingWorker*>(threads_[steal_index_]);
+      WorkStealingTask* task = worker->task_;
+      if (task && (worker->GetNumaNode() == thief->GetNumaNode()) == same_node) {
+        // Not null, we can probably steal from this worker.
+        ++steals_;
+        if (!same_node) {
+          ++cross_node_steals_;
+        }
+        return task;
+      }
     }
   }
   // Couldn't find something to steal.
   return NULL;
 }
 
+void WorkStealingThreadPool::GetStealCounts(Thread* self, uint64_t* steals,
+                                            uint64_t* cross_node_steals) {
+  MutexLock mu(self, work_steal_lock_);
+  *steals = steals_;
+  *cross_node_steals = cross_node_steals_;
+}
+
 WorkStealingThreadPool::~WorkStealingThreadPool() {}
 
 }  // namespace art
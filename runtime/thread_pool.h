@@ -18,6 +18,7 @@
 #define ART_RUNTIME_THREAD_POOL_H_
 
 #include <deque>
+#include <iosfwd>
 #include <vector>
 
 #include "barrier.h"
@@ -31,8 +32,40 @@ class ThreadPool;
 
 class Task : public Closure {
  public:
+  // The workers run the queued tasks of the highest priority first, tasks of the same priority in
+  // the order they were added.
+  enum Priority {
+    kPriorityHigh,
+    kPriorityNormal,
+    kPriorityLow,
+  };
+  static constexpr size_t kNumPriorities = kPriorityLow + 1;
+
+  Task() : numa_node_(-1), priority_(kPriorityNormal) {}
+
   // Called when references reaches 0.
   virtual void Finalize() { }
+
+  // The NUMA node of the memory the task works on, or -1 if unknown. The workers of a NUMA aware
+  // thread pool prefer the tasks of their own node.
+  int GetNumaNode() const {
+    return numa_node_;
+  }
+  void SetNumaNode(int numa_node) {
+    numa_node_ = numa_node;
+  }
+
+  Priority GetPriority() const {
+    return priority_;
+  }
+  // Must be called before the task is added to a thread pool.
+  void SetPriority(Priority priority) {
+    priority_ = priority;
+  }
+
+ private:
+  int numa_node_;
+  Priority priority_;
 };
 
 class ThreadPoolWorker {
@@ -44,17 +77,35 @@ class ThreadPoolWorker {
     return stack_->Size();
   }
 
+  // The NUMA node the worker is pinned to, or -1 if it is not pinned.
+  int GetNumaNode() const {
+    return numa_node_;
+  }
+
+  // The time the worker spent running tasks, and getting or waiting for tasks. Only stable while
+  // the worker waits for tasks, e.g. after ThreadPool::Wait.
+  uint64_t GetBusyTime() const {
+    return busy_time_ns_;
+  }
+  uint64_t GetIdleTime() const {
+    return idle_time_ns_;
+  }
+
   virtual ~ThreadPoolWorker();
 
  protected:
-  ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name, size_t stack_size);
+  ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name, size_t stack_size,
+                   int numa_node);
   static void* Callback(void* arg) LOCKS_EXCLUDED(Locks::mutator_lock_);
   virtual void Run();
 
   ThreadPool* const thread_pool_;
   const std::string name_;
+  const int numa_node_;
   UniquePtr<MemMap> stack_;
   pthread_t pthread_;
+  uint64_t busy_time_ns_;
+  uint64_t idle_time_ns_;
 
  private:
   friend class ThreadPool;
@@ -78,7 +129,15 @@ class ThreadPool {
   // after running it, it is the caller's responsibility.
   void AddTask(Thread* self, Task* task);
 
-  explicit ThreadPool(const char* name, size_t num_threads);
+  // Add the tasks with a single acquisition of the task queue lock, waking up as many waiting
+  // workers as there are tasks.
+  void AddTasks(Thread* self, const std::vector<Task*>& tasks);
+
+  // If numa_aware, the workers are spread over the NUMA nodes and pinned to the CPUs of their node.
+  // If create_peers, the workers get java.lang.Thread peers so that their tasks can call managed
+  // code; this needs a started runtime.
+  explicit ThreadPool(const char* name, size_t num_threads, bool numa_aware = false,
+                      bool create_peers = false);
   virtual ~ThreadPool();
 
   // Wait for all tasks currently on queue to get completed.
@@ -95,7 +154,31 @@ class ThreadPool {
   // thread count of the thread pool.
   void SetMaxActiveWorkers(size_t threads);
 
+  // Whether the workers are pinned to NUMA nodes, false if there is only one node.
+  bool IsNumaAware() const {
+    return !numa_node_cpus_.empty();
+  }
+
+  // The NUMA node of the memory at addr, to pass to Task::SetNumaNode. Returns -1 without a system
+  // call if the thread pool is not NUMA aware.
+  int GetNumaNodeOfAddress(const void* addr) const;
+
+  // How many tasks were run by a thread on another NUMA node than the one of the task.
+  uint64_t GetCrossNodeTaskCount(Thread* self) LOCKS_EXCLUDED(task_queue_lock_);
+
+  // Dumps the busy and idle times of each worker, for seeing how well the work was balanced.
+  void DumpWorkerTimes(std::ostream& os) const;
+
  protected:
+  // The NUMA node the calling thread is running on, or -1 if unknown.
+  int GetCurrentNumaNode() const;
+
+  // The NUMA node the next worker to be created is pinned to.
+  int NextWorkerNumaNode() const;
+
+  // Restrict the calling thread to the CPUs of numa_node.
+  void PinCurrentThreadToNumaNode(int numa_node) const;
+
   // Get a task to run, blocks if there are no tasks left
   virtual Task* GetTask(Thread* self);
 
@@ -103,6 +186,8 @@ class ThreadPool {
   Task* TryGetTask(Thread* self);
   Task* TryGetTaskLocked(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
 
+  bool HasTasks() const EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
+
   // Are we shutting down?
   bool IsShuttingDown() const EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_) {
     return shutting_down_;
@@ -116,7 +201,8 @@ class ThreadPool {
   volatile bool shutting_down_ GUARDED_BY(task_queue_lock_);
   // How many worker threads are waiting on the condition.
   volatile size_t waiting_count_ GUARDED_BY(task_queue_lock_);
-  std::deque<Task*> tasks_ GUARDED_BY(task_queue_lock_);
+  // The queued tasks of each priority.
+  std::deque<Task*> tasks_[Task::kNumPriorities] GUARDED_BY(task_queue_lock_);
   // TODO: make this immutable/const?
   std::vector<ThreadPoolWorker*> threads_;
   // Work balance detection.
@@ -124,6 +210,13 @@ class ThreadPool {
   uint64_t total_wait_time_;
   Barrier creation_barier_;
   size_t max_active_workers_ GUARDED_BY(task_queue_lock_);
+  uint64_t cross_node_tasks_ GUARDED_BY(task_queue_lock_);
+  // The CPUs of each NUMA node when the thread pool is NUMA aware, empty otherwise.
+  std::vector<std::vector<int>> numa_node_cpus_;
+  // The NUMA node of each CPU, for GetCurrentNumaNode.
+  std::vector<int> cpu_numa_nodes_;
+  // Whether the workers attach with java.lang.Thread peers.
+  const bool create_peers_;
 
  private:
   friend class ThreadPoolWorker;
@@ -159,7 +252,8 @@ class WorkStealingWorker : public ThreadPoolWorker {
  protected:
   WorkStealingTask* task_;
 
-  WorkStealingWorker(ThreadPool* thread_pool, const std::string& name, size_t stack_size);
+  WorkStealingWorker(ThreadPool* thread_pool, const std::string& name, size_t stack_size,
+                     int numa_node);
   virtual void Run();
 
  private:
@@ -169,16 +263,23 @@ class WorkStealingWorker : public ThreadPoolWorker {
 
 class WorkStealingThreadPool : public ThreadPool {
  public:
-  explicit WorkStealingThreadPool(const char* name, size_t num_threads);
+  explicit WorkStealingThreadPool(const char* name, size_t num_threads, bool numa_aware = false);
   virtual ~WorkStealingThreadPool();
 
+  // Total number of steals, and how many of them were from a worker on another NUMA node.
+  void GetStealCounts(Thread* self, uint64_t* steals, uint64_t* cross_node_steals)
+      LOCKS_EXCLUDED(work_steal_lock_);
+
  private:
   Mutex work_steal_lock_;
   // Which thread we are stealing from (round robin).
   size_t steal_index_;
+  uint64_t steals_ GUARDED_BY(work_steal_lock_);
+  uint64_t cross_node_steals_ GUARDED_BY(work_steal_lock_);
 
-  // Find a task to steal from
-  WorkStealingTask* FindTaskToStealFrom(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(work_steal_lock_);
+  // Find a task to steal from, the tasks run by workers on the NUMA node of thief first.
+  WorkStealingTask* FindTaskToStealFrom(Thread* self, WorkStealingWorker* thief)
+      EXCLUSIVE_LOCKS_REQUIRED(work_steal_lock_);
 
   friend class WorkStealingWorker;
 };
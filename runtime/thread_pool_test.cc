@@ -17,6 +17,7 @@
 #include "thread_pool.h"
 
 #include <string>
+#include <vector>
 
 #include "atomic.h"
 #include "common_runtime_test.h"
@@ -72,6 +73,67 @@ TEST_F(ThreadPoolTest, CheckRun) {
   EXPECT_EQ(num_tasks, count);
 }
 
+// Check that a NUMA aware thread pool runs the tasks of every node, whatever the topology is.
+TEST_F(ThreadPoolTest, NumaAwareRun) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("NUMA aware thread pool test thread pool", num_threads, true);
+  AtomicInteger count(0);
+  static const int32_t num_tasks = num_threads * 4;
+  for (int32_t i = 0; i < num_tasks; ++i) {
+    CountTask* task = new CountTask(&count);
+    // Includes nodes which may not exist, their tasks are run by the workers of other nodes.
+    task->SetNumaNode(i % 4 - 1);
+    thread_pool.AddTask(self, task);
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  EXPECT_EQ(num_tasks, count);
+}
+
+class OrderTask : public Task {
+ public:
+  OrderTask(std::vector<int>* order, int id) : order_(order), id_(id) {}
+
+  void Run(Thread* self) {
+    order_->push_back(id_);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  std::vector<int>* const order_;
+  const int id_;
+};
+
+// Check that the tasks of a higher priority run first, and in order within a priority.
+TEST_F(ThreadPoolTest, Priorities) {
+  Thread* self = Thread::Current();
+  // Without workers, Wait runs the tasks on the calling thread in the order the pool hands them.
+  ThreadPool thread_pool("Thread pool test thread pool", 0);
+  std::vector<int> order;
+  std::vector<Task*> tasks;
+  const Task::Priority priorities[] = {
+    Task::kPriorityLow, Task::kPriorityNormal, Task::kPriorityHigh, Task::kPriorityNormal,
+    Task::kPriorityHigh,
+  };
+  for (size_t i = 0; i < arraysize(priorities); ++i) {
+    Task* task = new OrderTask(&order, i);
+    task->SetPriority(priorities[i]);
+    tasks.push_back(task);
+  }
+  thread_pool.AddTasks(self, tasks);
+  EXPECT_EQ(arraysize(priorities), thread_pool.GetTaskCount(self));
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  const int expected[] = { 2, 4, 1, 3, 0 };
+  ASSERT_EQ(arraysize(expected), order.size());
+  for (size_t i = 0; i < arraysize(expected); ++i) {
+    EXPECT_EQ(expected[i], order[i]);
+  }
+}
+
 TEST_F(ThreadPoolTest, StopStart) {
   Thread* self = Thread::Current();
   ThreadPool thread_pool("Thread pool test thread pool", num_threads);
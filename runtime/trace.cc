@@ -75,6 +75,13 @@ namespace art {
 // 32 bits of microseconds is 70 minutes.
 //
 // All values are stored in little-endian order.
+//
+// A streamed trace (kTraceStreaming) instead starts with the header, with 0xF0 or'ed into the
+// version, followed by the records. The text summary that normally precedes the header comes
+// last, introduced by a record with thread ID 0:
+//     u2  0
+//     u1  kOpTraceSummary
+//     u4  length of the summary
 
 enum TraceAction {
     kTraceMethodEnter = 0x00,       // method entry
@@ -114,8 +121,22 @@ static const uint16_t kTraceVersionSingleClock    = 2;
 static const uint16_t kTraceVersionDualClock      = 3;
 static const uint16_t kTraceRecordSizeSingleClock = 10;  // using v2
 static const uint16_t kTraceRecordSizeDualClock   = 14;  // using v3 with two timestamps
+static const uint16_t kTraceVersionStreamingMask  = 0xF0;
+static const uint8_t  kOpTraceSummary             = 3;
+
+// The records of one thread not yet written out when streaming.
+struct TraceBuffer {
+  static constexpr size_t kCapacity = 64 * KB;
+
+  size_t size;
+  uint8_t data[kCapacity];
+};
+
+// Threads recording faster than the trace file is written wait once this many buffers are queued.
+static constexpr size_t kMaxQueuedTraceBuffers = 64;
 
 ProfilerClockSource Trace::default_clock_source_ = kDefaultProfilerClockSource;
+std::vector<std::string> Trace::method_filters_;
 
 Trace* volatile Trace::the_trace_ = NULL;
 pthread_t Trace::sampling_pthread_ = 0U;
@@ -159,6 +180,11 @@ void Trace::SetDefaultClockSource(ProfilerClockSource clock_source) {
 #endif
 }
 
+void Trace::SetMethodFilters(const std::string& filters) {
+  method_filters_.clear();
+  Split(filters, ',', method_filters_);
+}
+
 static uint16_t GetTraceVersion(ProfilerClockSource clock_source) {
   return (clock_source == kProfilerClockSourceDual) ? kTraceVersionDualClock
                                                     : kTraceVersionSingleClock;
@@ -325,6 +351,91 @@ void* Trace::RunSamplingThread(void* arg) {
   return NULL;
 }
 
+void* Trace::RunStreamingThread(void* arg) {
+  Trace* the_trace = reinterpret_cast<Trace*>(arg);
+  if (!the_trace->trace_file_->WriteFully(the_trace->buf_.get(), kTraceHeaderLength)) {
+    PLOG(ERROR) << "Trace data write failed";
+    the_trace->streaming_failed_ = true;
+  }
+
+  MutexLock mu(nullptr, the_trace->streaming_lock_);
+  while (true) {
+    if (the_trace->full_buffers_.empty()) {
+      if (the_trace->stop_streaming_) {
+        break;
+      }
+      the_trace->streaming_cond_.Wait(nullptr);
+      continue;
+    }
+    TraceBuffer* buffer = the_trace->full_buffers_.front();
+    the_trace->full_buffers_.pop_front();
+    // Wake threads waiting for room in the queue.
+    the_trace->streaming_cond_.Broadcast(nullptr);
+
+    the_trace->streaming_lock_.ExclusiveUnlock(nullptr);
+    the_trace->GetVisitedMethods(buffer->data, buffer->data + buffer->size,
+                                 &the_trace->streamed_methods_);
+    the_trace->num_streamed_records_ += buffer->size / GetRecordSize(the_trace->clock_source_);
+    if (!the_trace->streaming_failed_ &&
+        !the_trace->trace_file_->WriteFully(buffer->data, buffer->size)) {
+      PLOG(ERROR) << "Trace data write failed";
+      the_trace->streaming_failed_ = true;
+    }
+    the_trace->streaming_lock_.ExclusiveLock(nullptr);
+
+    the_trace->free_buffers_.push_back(buffer);
+  }
+  return NULL;
+}
+
+TraceBuffer* Trace::QueueTraceBuffer(Thread* thread, bool replace) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, streaming_lock_);
+  TraceBuffer* buffer = thread->GetTraceBuffer();
+  if (buffer != nullptr) {
+    if (buffer->size == 0) {
+      free_buffers_.push_back(buffer);
+    } else {
+      // The caller may be runnable or even hold the thread list lock, neither of which the
+      // streaming thread needs to make room.
+      while (full_buffers_.size() >= kMaxQueuedTraceBuffers) {
+        streaming_cond_.WaitHoldingLocks(self);
+      }
+      full_buffers_.push_back(buffer);
+      streaming_cond_.Broadcast(self);
+    }
+    buffer = nullptr;
+  }
+  if (replace) {
+    if (free_buffers_.empty()) {
+      buffer = new TraceBuffer;
+    } else {
+      buffer = free_buffers_.back();
+      free_buffers_.pop_back();
+    }
+    buffer->size = 0;
+  }
+  thread->SetTraceBuffer(buffer);
+  return buffer;
+}
+
+void Trace::StopStreaming() {
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      QueueTraceBuffer(thread, false);
+    }
+  }
+  {
+    MutexLock mu(self, streaming_lock_);
+    stop_streaming_ = true;
+    streaming_cond_.Broadcast(self);
+  }
+  CHECK_PTHREAD_CALL(pthread_join, (streaming_pthread_, NULL), "trace streaming thread shutdown");
+  streaming_pthread_ = 0U;
+}
+
 void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
                   bool direct_to_ddms, bool sampling_enabled, int interval_us) {
   Thread* self = Thread::Current();
@@ -335,6 +446,15 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
       return;
     }
   }
+  if ((flags & kTraceStreaming) != 0) {
+    if (direct_to_ddms) {
+      LOG(WARNING) << "Streaming a trace to ddms is unsupported, buffering it instead";
+      flags &= ~kTraceStreaming;
+    } else {
+      // Only the header goes into the buffer.
+      buffer_size = kTraceHeaderLength;
+    }
+  }
   Runtime* runtime = Runtime::Current();
   runtime->GetThreadList()->SuspendAll();
 
@@ -365,11 +485,15 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
       the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled);
 
       // Enable count of allocs if specified in the flags.
-      if ((flags && kTraceCountAllocs) != 0) {
+      if ((flags & kTraceCountAllocs) != 0) {
         runtime->SetStatsEnabled(true);
       }
 
-
+      if (the_trace_->streaming_) {
+        CHECK_PTHREAD_CALL(pthread_create, (&the_trace_->streaming_pthread_, NULL,
+                                            &RunStreamingThread, the_trace_),
+                                            "Trace streaming thread");
+      }
 
       if (sampling_enabled) {
         CHECK_PTHREAD_CALL(pthread_create, (&sampling_pthread_, NULL, &RunSamplingThread,
@@ -380,7 +504,11 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
                                                    instrumentation::Instrumentation::kMethodEntered |
                                                    instrumentation::Instrumentation::kMethodExited |
                                                    instrumentation::Instrumentation::kMethodUnwind);
-        runtime->GetInstrumentation()->EnableMethodTracing();
+        if (method_filters_.empty()) {
+          runtime->GetInstrumentation()->EnableMethodTracing();
+        } else {
+          runtime->GetInstrumentation()->EnableFilteredMethodTracing(method_filters_);
+        }
       }
     }
   }
@@ -431,6 +559,20 @@ void Trace::Shutdown() {
   }
 }
 
+void Trace::StoreExitingThreadInfo(Thread* thread) {
+  MutexLock mu(thread, *Locks::trace_lock_);
+  if (the_trace_ != NULL) {
+    std::string name;
+    thread->GetThreadName(name);
+    the_trace_->exited_threads_.Overwrite(thread->GetTid(), name);
+    if (the_trace_->streaming_) {
+      // The sampling thread records events of other threads while holding the thread list lock.
+      MutexLock mu2(thread, *Locks::thread_list_lock_);
+      the_trace_->QueueTraceBuffer(thread, false);
+    }
+  }
+}
+
 TracingMode Trace::GetMethodTracingMode() {
   MutexLock mu(Thread::Current(), *Locks::trace_lock_);
   if (the_trace_ == NULL) {
@@ -445,12 +587,17 @@ TracingMode Trace::GetMethodTracingMode() {
 Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled)
     : trace_file_(trace_file), buf_(new uint8_t[buffer_size]()), flags_(flags),
       sampling_enabled_(sampling_enabled), clock_source_(default_clock_source_),
-      buffer_size_(buffer_size), start_time_(MicroTime()), cur_offset_(0),  overflow_(false) {
+      buffer_size_(buffer_size), start_time_(MicroTime()), cur_offset_(0),  overflow_(false),
+      streaming_((flags & kTraceStreaming) != 0), streaming_pthread_(0U),
+      streaming_lock_("trace streaming lock"),
+      streaming_cond_("trace streaming condition variable", streaming_lock_),
+      stop_streaming_(false), num_streamed_records_(0), streaming_failed_(false) {
   // Set up the beginning of the trace.
   uint16_t trace_version = GetTraceVersion(clock_source_);
   memset(buf_.get(), 0, kTraceHeaderLength);
   Append4LE(buf_.get(), kTraceMagicValue);
-  Append2LE(buf_.get() + 4, trace_version);
+  Append2LE(buf_.get() + 4,
+            streaming_ ? (trace_version | kTraceVersionStreamingMask) : trace_version);
   Append2LE(buf_.get() + 6, kTraceHeaderLength);
   Append8LE(buf_.get() + 8, start_time_);
   if (trace_version >= kTraceVersionDualClock) {
@@ -462,6 +609,10 @@ Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled
   cur_offset_ = kTraceHeaderLength;
 }
 
+Trace::~Trace() {
+  STLDeleteElements(&free_buffers_);
+}
+
 static void DumpBuf(uint8_t* buf, size_t buf_size, ProfilerClockSource clock_source)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   uint8_t* ptr = buf + kTraceHeaderLength;
@@ -488,7 +639,16 @@ void Trace::FinishTracing() {
   }
 
   std::set<mirror::ArtMethod*> visited_methods;
-  GetVisitedMethods(final_offset, &visited_methods);
+  size_t num_records;
+  if (streaming_) {
+    StopStreaming();
+    visited_methods.swap(streamed_methods_);
+    num_records = num_streamed_records_;
+  } else {
+    GetVisitedMethods(buf_.get() + kTraceHeaderLength, buf_.get() + final_offset,
+                      &visited_methods);
+    num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
+  }
 
   std::ostringstream os;
 
@@ -505,7 +665,6 @@ void Trace::FinishTracing() {
     os << StringPrintf("clock=wall\n");
   }
   os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
-  size_t num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
   os << StringPrintf("num-method-calls=%zd\n", num_records);
   os << StringPrintf("clock-call-overhead-nsec=%d\n", clock_overhead_ns);
   os << StringPrintf("vm=art\n");
@@ -521,7 +680,20 @@ void Trace::FinishTracing() {
   os << StringPrintf("%cend\n", kTraceTokenChar);
 
   std::string header(os.str());
-  if (trace_file_.get() == NULL) {
+  if (streaming_) {
+    uint8_t op[7];
+    Append2LE(op, 0);
+    op[2] = kOpTraceSummary;
+    Append4LE(op + 3, header.length());
+    if (streaming_failed_) {
+      ThrowRuntimeException("Trace data write failed");
+    } else if (!trace_file_->WriteFully(op, sizeof(op)) ||
+               !trace_file_->WriteFully(header.c_str(), header.length())) {
+      std::string detail(StringPrintf("Trace data write failed: %s", strerror(errno)));
+      PLOG(ERROR) << detail;
+      ThrowRuntimeException("%s", detail.c_str());
+    }
+  } else if (trace_file_.get() == NULL) {
     iovec iov[2];
     iov[0].iov_base = reinterpret_cast<void*>(const_cast<char*>(header.c_str()));
     iov[0].iov_len = header.length();
@@ -619,17 +791,30 @@ void Trace::ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wa
 void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
                                 instrumentation::Instrumentation::InstrumentationEvent event,
                                 uint32_t thread_clock_diff, uint32_t wall_clock_diff) {
-  // Advance cur_offset_ atomically.
-  int32_t new_offset;
-  int32_t old_offset;
-  do {
-    old_offset = cur_offset_;
-    new_offset = old_offset + GetRecordSize(clock_source_);
-    if (new_offset > buffer_size_) {
-      overflow_ = true;
-      return;
+  uint8_t* ptr;
+  if (streaming_) {
+    // Only this thread, or the sampling thread while it is suspended, appends to its buffer.
+    TraceBuffer* buffer = thread->GetTraceBuffer();
+    if (UNLIKELY(buffer == nullptr ||
+                 buffer->size + GetRecordSize(clock_source_) > TraceBuffer::kCapacity)) {
+      buffer = QueueTraceBuffer(thread, true);
     }
-  } while (android_atomic_release_cas(old_offset, new_offset, &cur_offset_) != 0);
+    ptr = buffer->data + buffer->size;
+    buffer->size += GetRecordSize(clock_source_);
+  } else {
+    // Advance cur_offset_ atomically.
+    int32_t new_offset;
+    int32_t old_offset;
+    do {
+      old_offset = cur_offset_;
+      new_offset = old_offset + GetRecordSize(clock_source_);
+      if (new_offset > buffer_size_) {
+        overflow_ = true;
+        return;
+      }
+    } while (android_atomic_release_cas(old_offset, new_offset, &cur_offset_) != 0);
+    ptr = buf_.get() + old_offset;
+  }
 
   TraceAction action = kTraceMethodEnter;
   switch (event) {
@@ -649,7 +834,6 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   uint32_t method_value = EncodeTraceMethodAndAction(method, action);
 
   // Write data
-  uint8_t* ptr = buf_.get() + old_offset;
   Append2LE(ptr, thread->GetTid());
   Append4LE(ptr + 2, method_value);
   ptr += 6;
@@ -663,11 +847,9 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   }
 }
 
-void Trace::GetVisitedMethods(size_t buf_size,
+void Trace::GetVisitedMethods(const uint8_t* begin, const uint8_t* end,
                               std::set<mirror::ArtMethod*>* visited_methods) {
-  uint8_t* ptr = buf_.get() + kTraceHeaderLength;
-  uint8_t* end = buf_.get() + buf_size;
-
+  const uint8_t* ptr = begin;
   while (ptr < end) {
     uint32_t tmid = ptr[2] | (ptr[3] << 8) | (ptr[4] << 16) | (ptr[5] << 24);
     mirror::ArtMethod* method = DecodeTraceMethodId(tmid);
@@ -695,6 +877,12 @@ static void DumpThread(Thread* t, void* arg) {
 
 void Trace::DumpThreadList(std::ostream& os) {
   Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, *Locks::trace_lock_);
+    for (const auto& exited_thread : exited_threads_) {
+      os << exited_thread.first << "\t" << exited_thread.second << "\n";
+    }
+  }
   Locks::thread_list_lock_->AssertNotHeld(self);
   MutexLock mu(self, *Locks::thread_list_lock_);
   Runtime::Current()->GetThreadList()->ForEach(DumpThread, &os);
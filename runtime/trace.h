@@ -17,12 +17,14 @@
 #ifndef ART_RUNTIME_TRACE_H_
 #define ART_RUNTIME_TRACE_H_
 
+#include <deque>
 #include <ostream>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "globals.h"
 #include "instrumentation.h"
 #include "os.h"
@@ -36,6 +38,7 @@ namespace mirror {
   class ArtMethod;
 }  // namespace mirror
 class Thread;
+struct TraceBuffer;
 
 enum ProfilerClockSource {
   kProfilerClockSourceThreadCpu,
@@ -59,10 +62,18 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
  public:
   enum TraceFlag {
     kTraceCountAllocs = 1,
+    // Write the records to the trace file while tracing rather than when tracing stops, see
+    // RunStreamingThread.
+    kTraceStreaming = 2,
   };
 
   static void SetDefaultClockSource(ProfilerClockSource clock_source);
 
+  // Restrict method tracing to the methods whose name starts with one of the comma separated
+  // prefixes of filters, see Instrumentation::EnableFilteredMethodTracing. Sampling isn't
+  // affected.
+  static void SetMethodFilters(const std::string& filters);
+
   static void Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
                     bool direct_to_ddms, bool sampling_enabled, int interval_us)
   LOCKS_EXCLUDED(Locks::mutator_lock_,
@@ -73,6 +84,11 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   static void Shutdown() LOCKS_EXCLUDED(Locks::trace_lock_);
   static TracingMode GetMethodTracingMode() LOCKS_EXCLUDED(Locks::trace_lock_);
 
+  // Remember the name of a thread that is going away for the thread list of the trace and, when
+  // streaming, hand its remaining records to the writer.
+  static void StoreExitingThreadInfo(Thread* thread)
+      LOCKS_EXCLUDED(Locks::trace_lock_, Locks::thread_list_lock_);
+
   bool UseWallClock();
   bool UseThreadCpuClock();
 
@@ -112,10 +128,23 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
 
  private:
   explicit Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled);
+  ~Trace();
 
   // The sampling interval in microseconds is passed as an argument.
   static void* RunSamplingThread(void* arg) LOCKS_EXCLUDED(Locks::trace_lock_);
 
+  // When streaming, each thread appends its records to its own TraceBuffer without any
+  // synchronization. Full buffers are queued for this thread, which writes them to the trace file
+  // so the trace isn't bounded by the buffer size. The Trace is passed as an argument.
+  static void* RunStreamingThread(void* arg) LOCKS_EXCLUDED(streaming_lock_);
+
+  // Queue the buffer of thread, if any, for writing and give the thread an empty one if
+  // replace is set. Waits while too many buffers are queued.
+  TraceBuffer* QueueTraceBuffer(Thread* thread, bool replace) LOCKS_EXCLUDED(streaming_lock_);
+
+  // Queue the buffers of all threads and wait for the streaming thread to write them.
+  void StopStreaming() LOCKS_EXCLUDED(Locks::thread_list_lock_, streaming_lock_);
+
   void FinishTracing() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wall_clock_diff);
@@ -125,10 +154,12 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
                            uint32_t thread_clock_diff, uint32_t wall_clock_diff);
 
   // Methods to output traced methods and threads.
-  void GetVisitedMethods(size_t end_offset, std::set<mirror::ArtMethod*>* visited_methods);
+  void GetVisitedMethods(const uint8_t* begin, const uint8_t* end,
+                         std::set<mirror::ArtMethod*>* visited_methods);
   void DumpMethodList(std::ostream& os, const std::set<mirror::ArtMethod*>& visited_methods)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void DumpThreadList(std::ostream& os) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+  void DumpThreadList(std::ostream& os)
+      LOCKS_EXCLUDED(Locks::trace_lock_, Locks::thread_list_lock_);
 
   // Singleton instance of the Trace or NULL when no method tracing is active.
   static Trace* volatile the_trace_ GUARDED_BY(Locks::trace_lock_);
@@ -136,6 +167,9 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // The default profiler clock source.
   static ProfilerClockSource default_clock_source_;
 
+  // The method name prefixes that method tracing is restricted to, empty to trace all methods.
+  static std::vector<std::string> method_filters_;
+
   // Sampling thread, non-zero when sampling.
   static pthread_t sampling_pthread_;
 
@@ -168,6 +202,36 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Did we overflow the buffer recording traces?
   bool overflow_;
 
+  // Whether the records are written by the streaming thread rather than kept in buf_.
+  const bool streaming_;
+
+  // Names of the threads that exited while tracing, by tid.
+  SafeMap<pid_t, std::string> exited_threads_ GUARDED_BY(Locks::trace_lock_);
+
+  // Streaming thread, non-zero when streaming.
+  pthread_t streaming_pthread_;
+
+  Mutex streaming_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Signaled when a buffer is queued and when the streaming thread takes one off the queue.
+  ConditionVariable streaming_cond_ GUARDED_BY(streaming_lock_);
+
+  // Buffers waiting for the streaming thread, in the order they filled up.
+  std::deque<TraceBuffer*> full_buffers_ GUARDED_BY(streaming_lock_);
+
+  // Written buffers available for reuse.
+  std::vector<TraceBuffer*> free_buffers_ GUARDED_BY(streaming_lock_);
+
+  // Set to make the streaming thread exit once the queue is empty.
+  bool stop_streaming_ GUARDED_BY(streaming_lock_);
+
+  // The following are only used by the streaming thread until it exits.
+  // Methods seen in the streamed records, for the method list.
+  std::set<mirror::ArtMethod*> streamed_methods_;
+  // Number of streamed records.
+  size_t num_streamed_records_;
+  // Set if writing to the trace file failed, the records are then dropped.
+  bool streaming_failed_;
+
   DISALLOW_COPY_AND_ASSIGN(Trace);
 };
 
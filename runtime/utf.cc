@@ -68,6 +68,18 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, const uint16_t* utf16_in, size_t
   }
 }
 
+void ConvertLatin1ToModifiedUtf8(char* utf8_out, const uint8_t* latin1_in, size_t char_count) {
+  while (char_count--) {
+    uint8_t ch = *latin1_in++;
+    if (ch > 0 && ch <= 0x7f) {
+      *utf8_out++ = ch;
+    } else {
+      *utf8_out++ = (ch >> 6) | 0xc0;
+      *utf8_out++ = (ch & 0x3f) | 0x80;
+    }
+  }
+}
+
 int32_t ComputeUtf16Hash(mirror::CharArray* chars, int32_t offset,
                          size_t char_count) {
   int32_t hash = 0;
@@ -85,6 +97,14 @@ int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count) {
   return hash;
 }
 
+int32_t ComputeLatin1Hash(const uint8_t* chars, size_t char_count) {
+  int32_t hash = 0;
+  while (char_count--) {
+    hash = hash * 31 + *chars++;
+  }
+  return hash;
+}
+
 int CompareModifiedUtf8ToUtf16AsCodePointValues(const char* utf8_1, const uint16_t* utf8_2) {
   for (;;) {
     if (*utf8_1 == '\0') {
@@ -119,4 +139,13 @@ size_t CountUtf8Bytes(const uint16_t* chars, size_t char_count) {
   return result;
 }
 
+size_t CountLatin1Utf8Bytes(const uint8_t* chars, size_t char_count) {
+  size_t result = 0;
+  while (char_count--) {
+    uint8_t ch = *chars++;
+    result += (ch > 0 && ch <= 0x7f) ? 1 : 2;
+  }
+  return result;
+}
+
 }  // namespace art
@@ -47,6 +47,12 @@ size_t CountModifiedUtf8Chars(const char* utf8);
  */
 size_t CountUtf8Bytes(const uint16_t* chars, size_t char_count);
 
+/*
+ * Returns the number of modified UTF-8 bytes needed to represent the given
+ * Latin-1 string, one byte per character.
+ */
+size_t CountLatin1Utf8Bytes(const uint8_t* chars, size_t char_count);
+
 /*
  * Convert from Modified UTF-8 to UTF-16.
  */
@@ -71,6 +77,12 @@ int CompareModifiedUtf8ToUtf16AsCodePointValues(const char* utf8_1, const uint16
  */
 void ConvertUtf16ToModifiedUtf8(char* utf8_out, const uint16_t* utf16_in, size_t char_count);
 
+/*
+ * Convert from Latin-1 to Modified UTF-8. As above, the output is _not_
+ * NUL-terminated.
+ */
+void ConvertLatin1ToModifiedUtf8(char* utf8_out, const uint8_t* latin1_in, size_t char_count);
+
 /*
  * The java.lang.String hashCode() algorithm.
  */
@@ -78,6 +90,12 @@ int32_t ComputeUtf16Hash(mirror::CharArray* chars, int32_t offset, size_t char_c
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count);
 
+/*
+ * The java.lang.String hashCode() of a Latin-1 string, the same as the hash of
+ * its characters widened to UTF-16.
+ */
+int32_t ComputeLatin1Hash(const uint8_t* chars, size_t char_count);
+
 /*
  * Retrieve the next UTF-16 character from a UTF-8 string.
  *
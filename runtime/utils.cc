@@ -16,6 +16,7 @@
 
 #include "utils.h"
 
+#include <dirent.h>
 #include <inttypes.h>
 #include <pthread.h>
 #include <sys/stat.h>
@@ -1041,6 +1042,107 @@ std::string GetSchedulerGroupName(pid_t tid) {
   return "";
 }
 
+bool GetNumaNodeCpus(std::vector<std::vector<int>>* node_cpus) {
+  node_cpus->clear();
+#if defined(__linux__)
+  DIR* dir = opendir("/sys/devices/system/node");
+  if (dir == nullptr) {
+    return false;
+  }
+  while (dirent* entry = readdir(dir)) {
+    int node;
+    if (sscanf(entry->d_name, "node%d", &node) != 1 || node < 0) {
+      continue;
+    }
+    // The cpulist looks like "0-7,16-23".
+    std::string cpu_list;
+    if (!ReadFileToString(StringPrintf("/sys/devices/system/node/node%d/cpulist", node),
+                          &cpu_list)) {
+      continue;
+    }
+    if (static_cast<size_t>(node) >= node_cpus->size()) {
+      node_cpus->resize(node + 1);
+    }
+    std::vector<std::string> ranges;
+    Split(Trim(cpu_list), ',', ranges);
+    for (const std::string& range : ranges) {
+      int first;
+      int last;
+      const int matched = sscanf(range.c_str(), "%d-%d", &first, &last);
+      if (matched < 1) {
+        continue;
+      }
+      if (matched == 1) {
+        last = first;
+      }
+      for (int cpu = first; cpu <= last; ++cpu) {
+        (*node_cpus)[node].push_back(cpu);
+      }
+    }
+  }
+  closedir(dir);
+  return !node_cpus->empty();
+#else
+  return false;
+#endif
+}
+
+int GetNumaNodeOfAddress(const void* addr) {
+#if defined(__linux__) && defined(__NR_get_mempolicy)
+  // MPOL_F_NODE | MPOL_F_ADDR, from linux/mempolicy.h.
+  static constexpr unsigned long kGetNodeOfAddress = 1 | 2;
+  int node = -1;
+  if (syscall(__NR_get_mempolicy, &node, nullptr, 0, addr, kGetNodeOfAddress) != 0) {
+    return -1;
+  }
+  return node;
+#else
+  UNUSED(addr);
+  return -1;
+#endif
+}
+
+bool CountPrivatePages(const void* begin, size_t size, size_t* private_pages) {
+  *private_pages = 0;
+  if (size == 0) {
+    return true;
+  }
+  const uintptr_t first_page = RoundDown(reinterpret_cast<uintptr_t>(begin), kPageSize) / kPageSize;
+  const uintptr_t end_page =
+      RoundUp(reinterpret_cast<uintptr_t>(begin) + size, kPageSize) / kPageSize;
+  UniquePtr<File> pagemap(OS::OpenFileForReading("/proc/self/pagemap"));
+  if (pagemap.get() == nullptr) {
+    return false;
+  }
+  // One 64-bit entry per virtual page: bit 63 is set for a resident page and bit 56 for a page
+  // mapped exclusively.
+  std::vector<uint64_t> entries(end_page - first_page);
+  const int64_t byte_count = entries.size() * sizeof(uint64_t);
+  if (pagemap->Read(reinterpret_cast<char*>(&entries[0]), byte_count,
+                    first_page * sizeof(uint64_t)) != byte_count) {
+    return false;
+  }
+  static constexpr uint64_t kPresent = UINT64_C(1) << 63;
+  static constexpr uint64_t kExclusive = UINT64_C(1) << 56;
+  for (uint64_t entry : entries) {
+    if ((entry & (kPresent | kExclusive)) == (kPresent | kExclusive)) {
+      ++*private_pages;
+    }
+  }
+  return true;
+}
+
+std::string DescribePrivatePages(const void* begin, size_t size) {
+  const size_t total_pages =
+      (RoundUp(reinterpret_cast<uintptr_t>(begin) + size, kPageSize) -
+       RoundDown(reinterpret_cast<uintptr_t>(begin), kPageSize)) / kPageSize;
+  size_t private_pages;
+  if (!CountPrivatePages(begin, size, &private_pages)) {
+    return StringPrintf("?/%zd pages private", total_pages);
+  }
+  return StringPrintf("%zd/%zd pages private", private_pages, total_pages);
+}
+
 void DumpNativeStack(std::ostream& os, pid_t tid, const char* prefix,
     mirror::ArtMethod* current_method) {
   // We may be called from contexts where current_method is not null, so we must assert this.
@@ -375,6 +375,22 @@ void GetTaskStats(pid_t tid, char* state, int* utime, int* stime, int* task_cpu)
 // Returns the name of the scheduler group for the given thread the current process, or the empty string.
 std::string GetSchedulerGroupName(pid_t tid);
 
+// Fills node_cpus with the CPUs of each NUMA node, indexed by node. Returns false if the topology
+// is not available, as on single node kernels without NUMA support.
+bool GetNumaNodeCpus(std::vector<std::vector<int>>* node_cpus);
+
+// Returns the NUMA node holding the page of addr, or -1 if unknown. Reads the page in if it was
+// never touched.
+int GetNumaNodeOfAddress(const void* addr);
+
+// Counts the pages of [begin, begin + size) that are resident and mapped by this process only.
+// In a zygote child, these are the pages shared with the zygote that the child wrote to. Returns
+// false if /proc/self/pagemap can't be read.
+bool CountPrivatePages(const void* begin, size_t size, size_t* private_pages);
+
+// Describes the private pages of [begin, begin + size) as "<private>/<total> pages private".
+std::string DescribePrivatePages(const void* begin, size_t size);
+
 // Sets the name of the current thread. The name may be truncated to an
 // implementation-defined limit.
 void SetThreadName(const char* thread_name);
@@ -66,6 +66,14 @@ inline bool MethodVerifier::HasFailures() const {
   return !failure_messages_.empty();
 }
 
+inline bool MethodVerifier::HasBadClassSoftFailure() const {
+  return have_bad_class_soft_failure_;
+}
+
+inline const DexFile::ClassDef* MethodVerifier::GetClassDef() const {
+  return class_def_;
+}
+
 inline const RegType& MethodVerifier::ResolveCheckedClass(uint32_t class_idx) {
   DCHECK(!HasFailures());
   const RegType& result = ResolveClassAndCheckAccess(class_idx);
@@ -16,8 +16,10 @@
 
 #include "method_verifier-inl.h"
 
+#include <algorithm>
 #include <iostream>
 
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/mutex-inl.h"
 #include "class_linker.h"
@@ -41,6 +43,7 @@
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "sirt_ref-inl.h"
+#include "thread_pool.h"
 #include "verifier/dex_gc_map.h"
 
 namespace art {
@@ -53,7 +56,9 @@ void PcToRegisterLineTable::Init(RegisterTrackingMode mode, InstructionFlags* fl
                                  uint32_t insns_size, uint16_t registers_size,
                                  MethodVerifier* verifier) {
   DCHECK_GT(insns_size, 0U);
-  register_lines_.reset(new RegisterLine*[insns_size]());
+  register_lines_ = reinterpret_cast<RegisterLine**>(
+      verifier->GetArena().Alloc(insns_size * sizeof(RegisterLine*), kArenaAllocVerifier));
+  std::fill_n(register_lines_, insns_size, static_cast<RegisterLine*>(nullptr));
   size_ = insns_size;
   for (uint32_t i = 0; i < insns_size; i++) {
     bool interesting = false;
@@ -78,7 +83,7 @@ void PcToRegisterLineTable::Init(RegisterTrackingMode mode, InstructionFlags* fl
 
 PcToRegisterLineTable::~PcToRegisterLineTable() {
   for (size_t i = 0; i < size_; i++) {
-    delete register_lines_[i];
+    RegisterLineArenaDelete()(register_lines_[i]);
     if (kIsDebugBuild) {
       register_lines_[i] = nullptr;
     }
@@ -121,6 +126,11 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(mirror::Class* klass,
   return VerifyClass(&dex_file, dex_cache, class_loader, class_def, allow_soft_failures, error);
 }
 
+// Classes with at least this many code units of methods have their methods verified in parallel
+// when the compiler provides a thread pool, so that a huge class doesn't leave a single thread
+// verifying at the end of the verification of a dex file.
+static constexpr size_t kParallelVerificationMinCodeUnits = 16 * KB;
+
 MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
                                                         SirtRef<mirror::DexCache>& dex_cache,
                                                         SirtRef<mirror::ClassLoader>& class_loader,
@@ -137,9 +147,8 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
   while (it.HasNextStaticField() || it.HasNextInstanceField()) {
     it.Next();
   }
-  size_t error_count = 0;
-  bool hard_fail = false;
-  ClassLinker* linker = Runtime::Current()->GetClassLinker();
+  std::vector<ClassMethod> methods;
+  size_t code_units = 0;
   int64_t previous_direct_method_idx = -1;
   while (it.HasNextDirectMethod()) {
     uint32_t method_idx = it.GetMemberIndex();
@@ -150,35 +159,11 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
       continue;
     }
     previous_direct_method_idx = method_idx;
-    InvokeType type = it.GetMethodInvokeType(*class_def);
-    mirror::ArtMethod* method =
-        linker->ResolveMethod(*dex_file, method_idx, dex_cache, class_loader, NULL, type);
-    if (method == NULL) {
-      DCHECK(Thread::Current()->IsExceptionPending());
-      // We couldn't resolve the method, but continue regardless.
-      Thread::Current()->ClearException();
-    }
-    MethodVerifier::FailureKind result = VerifyMethod(method_idx,
-                                                      dex_file,
-                                                      dex_cache,
-                                                      class_loader,
-                                                      class_def,
-                                                      it.GetMethodCodeItem(),
-                                                      method,
-                                                      it.GetMemberAccessFlags(),
-                                                      allow_soft_failures);
-    if (result != kNoFailure) {
-      if (result == kHardFailure) {
-        hard_fail = true;
-        if (error_count > 0) {
-          *error += "\n";
-        }
-        *error = "Verifier rejected class ";
-        *error += PrettyDescriptor(dex_file->GetClassDescriptor(*class_def));
-        *error += " due to bad method ";
-        *error += PrettyMethod(method_idx, *dex_file);
-      }
-      ++error_count;
+    ClassMethod method = { method_idx, it.GetMethodCodeItem(), it.GetMemberAccessFlags(),
+                           it.GetMethodInvokeType(*class_def) };
+    methods.push_back(method);
+    if (method.code_item != NULL) {
+      code_units += method.code_item->insns_size_in_code_units_;
     }
     it.Next();
   }
@@ -192,23 +177,36 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
       continue;
     }
     previous_virtual_method_idx = method_idx;
-    InvokeType type = it.GetMethodInvokeType(*class_def);
-    mirror::ArtMethod* method =
-        linker->ResolveMethod(*dex_file, method_idx, dex_cache, class_loader, NULL, type);
-    if (method == NULL) {
-      DCHECK(Thread::Current()->IsExceptionPending());
-      // We couldn't resolve the method, but continue regardless.
-      Thread::Current()->ClearException();
-    }
-    MethodVerifier::FailureKind result = VerifyMethod(method_idx,
-                                                      dex_file,
-                                                      dex_cache,
-                                                      class_loader,
-                                                      class_def,
-                                                      it.GetMethodCodeItem(),
-                                                      method,
-                                                      it.GetMemberAccessFlags(),
-                                                      allow_soft_failures);
+    ClassMethod method = { method_idx, it.GetMethodCodeItem(), it.GetMemberAccessFlags(),
+                           it.GetMethodInvokeType(*class_def) };
+    methods.push_back(method);
+    if (method.code_item != NULL) {
+      code_units += method.code_item->insns_size_in_code_units_;
+    }
+    it.Next();
+  }
+
+  std::vector<FailureKind> results(methods.size(), kNoFailure);
+  Runtime* runtime = Runtime::Current();
+  ThreadPool* thread_pool = NULL;
+  if (runtime->IsCompiler() && methods.size() > 1 &&
+      code_units >= kParallelVerificationMinCodeUnits) {
+    thread_pool = runtime->GetCompilerCallbacks()->GetVerificationThreadPool();
+  }
+  if (thread_pool != NULL) {
+    VerifyClassMethodsInParallel(thread_pool, dex_file, dex_cache, class_loader, class_def,
+                                 methods, allow_soft_failures, &results[0]);
+  } else {
+    for (size_t i = 0; i != methods.size(); ++i) {
+      results[i] = VerifyClassMethod(dex_file, dex_cache, class_loader, class_def, methods[i],
+                                     allow_soft_failures);
+    }
+  }
+
+  size_t error_count = 0;
+  bool hard_fail = false;
+  for (size_t i = 0; i != methods.size(); ++i) {
+    MethodVerifier::FailureKind result = results[i];
     if (result != kNoFailure) {
       if (result == kHardFailure) {
         hard_fail = true;
@@ -218,11 +216,10 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
         *error = "Verifier rejected class ";
         *error += PrettyDescriptor(dex_file->GetClassDescriptor(*class_def));
         *error += " due to bad method ";
-        *error += PrettyMethod(method_idx, *dex_file);
+        *error += PrettyMethod(methods[i].method_idx, *dex_file);
       }
       ++error_count;
     }
-    it.Next();
   }
   if (error_count == 0) {
     return kNoFailure;
@@ -231,6 +228,167 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
   }
 }
 
+MethodVerifier::FailureKind MethodVerifier::VerifyClassMethod(
+    const DexFile* dex_file, SirtRef<mirror::DexCache>& dex_cache,
+    SirtRef<mirror::ClassLoader>& class_loader, const DexFile::ClassDef* class_def,
+    const ClassMethod& method, bool allow_soft_failures) {
+  ClassLinker* linker = Runtime::Current()->GetClassLinker();
+  mirror::ArtMethod* resolved_method = linker->ResolveMethod(*dex_file, method.method_idx,
+                                                             dex_cache, class_loader, NULL,
+                                                             method.type);
+  if (resolved_method == NULL) {
+    DCHECK(Thread::Current()->IsExceptionPending());
+    // We couldn't resolve the method, but continue regardless.
+    Thread::Current()->ClearException();
+  }
+  return VerifyMethod(method.method_idx,
+                      dex_file,
+                      dex_cache,
+                      class_loader,
+                      class_def,
+                      method.code_item,
+                      resolved_method,
+                      method.access_flags,
+                      allow_soft_failures);
+}
+
+// The state shared by the threads verifying the methods of a class in parallel. The threads claim
+// the methods one at a time and the caller only waits for the methods which were claimed, so the
+// caller never waits for a task which no worker got to, e.g. because all the workers are verifying
+// classes of their own. A task which runs after all the methods were claimed finds nothing left to
+// do, it doesn't touch the methods or the results which belong to the caller. The last of the
+// caller and the tasks to release the state deletes it.
+class MethodVerifier::ParallelVerification {
+ public:
+  ParallelVerification(const DexFile* dex_file, SirtRef<mirror::DexCache>* dex_cache,
+                       SirtRef<mirror::ClassLoader>* class_loader,
+                       const DexFile::ClassDef* class_def, const std::vector<ClassMethod>* methods,
+                       bool allow_soft_failures, FailureKind* results, size_t references)
+      : dex_file_(dex_file),
+        dex_cache_(dex_cache),
+        class_loader_(class_loader),
+        class_def_(class_def),
+        methods_(methods),
+        num_methods_(methods->size()),
+        allow_soft_failures_(allow_soft_failures),
+        results_(results),
+        next_method_(0),
+        lock_("parallel verification lock"),
+        cond_("parallel verification condition variable", lock_),
+        num_verified_(0),
+        references_(references) {
+  }
+
+  void VerifyMethods(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    while (true) {
+      size_t index = static_cast<size_t>(next_method_.FetchAndAdd(1));
+      if (index >= num_methods_) {
+        break;
+      }
+      {
+        SirtRef<mirror::DexCache> dex_cache(self, dex_cache_->get());
+        SirtRef<mirror::ClassLoader> class_loader(self, class_loader_->get());
+        results_[index] = VerifyClassMethod(dex_file_, dex_cache, class_loader, class_def_,
+                                            (*methods_)[index], allow_soft_failures_);
+      }
+      MutexLock mu(self, lock_);
+      ++num_verified_;
+      if (num_verified_ == num_methods_) {
+        cond_.Broadcast(self);
+      }
+    }
+  }
+
+  // Waits for the methods claimed by the tasks, once the caller claimed the last method.
+  void WaitForMethods(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    ScopedThreadStateChange tsc(self, kWaiting);
+    MutexLock mu(self, lock_);
+    while (num_verified_ != num_methods_) {
+      cond_.Wait(self);
+    }
+  }
+
+  void Release(Thread* self) {
+    bool last;
+    {
+      MutexLock mu(self, lock_);
+      DCHECK_GT(references_, 0U);
+      --references_;
+      last = references_ == 0;
+    }
+    if (last) {
+      delete this;
+    }
+  }
+
+ private:
+  const DexFile* const dex_file_;
+  SirtRef<mirror::DexCache>* const dex_cache_;
+  SirtRef<mirror::ClassLoader>* const class_loader_;
+  const DexFile::ClassDef* const class_def_;
+  const std::vector<ClassMethod>* const methods_;
+  const size_t num_methods_;
+  const bool allow_soft_failures_;
+  FailureKind* const results_;
+  AtomicInteger next_method_;
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  ConditionVariable cond_ GUARDED_BY(lock_);
+  size_t num_verified_ GUARDED_BY(lock_);
+  size_t references_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelVerification);
+};
+
+class MethodVerifier::ParallelVerificationTask : public Task {
+ public:
+  explicit ParallelVerificationTask(ParallelVerification* verification)
+      : verification_(verification) {
+    // Run ahead of the remaining classes, the class being verified holds up its thread.
+    SetPriority(kPriorityHigh);
+  }
+
+  void Run(Thread* self) {
+    {
+      ScopedObjectAccess soa(self);
+      verification_->VerifyMethods(self);
+    }
+    verification_->Release(self);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ParallelVerification* const verification_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelVerificationTask);
+};
+
+void MethodVerifier::VerifyClassMethodsInParallel(ThreadPool* thread_pool,
+                                                  const DexFile* dex_file,
+                                                  SirtRef<mirror::DexCache>& dex_cache,
+                                                  SirtRef<mirror::ClassLoader>& class_loader,
+                                                  const DexFile::ClassDef* class_def,
+                                                  const std::vector<ClassMethod>& methods,
+                                                  bool allow_soft_failures,
+                                                  FailureKind* results) {
+  Thread* self = Thread::Current();
+  size_t num_tasks = std::min(thread_pool->GetThreadCount(), methods.size() - 1);
+  ParallelVerification* verification =
+      new ParallelVerification(dex_file, &dex_cache, &class_loader, class_def, &methods,
+                               allow_soft_failures, results, num_tasks + 1);
+  std::vector<Task*> tasks;
+  for (size_t i = 0; i != num_tasks; ++i) {
+    tasks.push_back(new ParallelVerificationTask(verification));
+  }
+  thread_pool->AddTasks(self, tasks);
+  verification->VerifyMethods(self);
+  verification->WaitForMethods(self);
+  verification->Release(self);
+}
+
 MethodVerifier::FailureKind MethodVerifier::VerifyMethod(uint32_t method_idx,
                                                          const DexFile* dex_file,
                                                          SirtRef<mirror::DexCache>& dex_cache,
@@ -298,7 +456,9 @@ MethodVerifier::MethodVerifier(const DexFile* dex_file, SirtRef<mirror::DexCache
                                const DexFile::CodeItem* code_item, uint32_t dex_method_idx,
                                mirror::ArtMethod* method, uint32_t method_access_flags,
                                bool can_load_classes, bool allow_soft_failures)
-    : reg_types_(can_load_classes),
+    : arena_stack_(Runtime::Current()->GetArenaPool()),
+      arena_(&arena_stack_),
+      reg_types_(can_load_classes, arena_),
       work_insn_idx_(-1),
       dex_method_idx_(dex_method_idx),
       mirror_method_(method),
@@ -314,6 +474,7 @@ MethodVerifier::MethodVerifier(const DexFile* dex_file, SirtRef<mirror::DexCache
       monitor_enter_dex_pcs_(nullptr),
       have_pending_hard_failure_(false),
       have_pending_runtime_throw_failure_(false),
+      have_bad_class_soft_failure_(false),
       new_instance_count_(0),
       monitor_enter_count_(0),
       can_load_classes_(can_load_classes),
@@ -413,7 +574,8 @@ mirror::ArtMethod* MethodVerifier::FindInvokedMethodAtDexPc(uint32_t dex_pc) {
     return NULL;
   }
   const Instruction* inst = Instruction::At(code_item_->insns_ + dex_pc);
-  const bool is_range = (inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK);
+  const bool is_range = (inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK ||
+                         inst->Opcode() == Instruction::INVOKE_SUPER_RANGE_QUICK);
   return GetQuickInvokedMethod(inst, register_line, is_range);
 }
 
@@ -480,6 +642,7 @@ std::ostream& MethodVerifier::Fail(VerifyError error) {
       if (!allow_soft_failures_) {
         have_pending_hard_failure_ = true;
       }
+      have_bad_class_soft_failure_ = true;
       break;
       // Hard verification failures at compile time will still fail at runtime, so the class is
       // marked as rejected to prevent it from being compiled.
@@ -1434,8 +1597,8 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
   // We need to ensure the work line is consistent while performing validation. When we spot a
   // peephole pattern we compute a new line for either the fallthrough instruction or the
   // branch target.
-  UniquePtr<RegisterLine> branch_line;
-  UniquePtr<RegisterLine> fallthrough_line;
+  RegisterLineArenaUniquePtr branch_line;
+  RegisterLineArenaUniquePtr fallthrough_line;
 
   // We need precise constant types only for deoptimization which happens at runtime.
   const bool need_precise_constant = !Runtime::Current()->IsCompiler();
@@ -1642,6 +1805,7 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
       break;
     }
     case Instruction::CONST_STRING:
+    case Instruction::CONST_STRING_QUICK:
       work_line_->SetRegisterType(inst->VRegA_21c(), reg_types_.JavaLangString());
       break;
     case Instruction::CONST_STRING_JUMBO:
@@ -2090,12 +2254,15 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
       VerifyISGet(inst, reg_types_.Short(), true, true);
       break;
     case Instruction::SGET:
+    case Instruction::SGET_QUICK:
       VerifyISGet(inst, reg_types_.Integer(), true, true);
       break;
     case Instruction::SGET_WIDE:
+    case Instruction::SGET_WIDE_QUICK:
       VerifyISGet(inst, reg_types_.LongLo(), true, true);
       break;
     case Instruction::SGET_OBJECT:
+    case Instruction::SGET_OBJECT_QUICK:
       VerifyISGet(inst, reg_types_.JavaLangObject(false), false, true);
       break;
 
@@ -2112,12 +2279,15 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
       VerifyISPut(inst, reg_types_.Short(), true, true);
       break;
     case Instruction::SPUT:
+    case Instruction::SPUT_QUICK:
       VerifyISPut(inst, reg_types_.Integer(), true, true);
       break;
     case Instruction::SPUT_WIDE:
+    case Instruction::SPUT_WIDE_QUICK:
       VerifyISPut(inst, reg_types_.LongLo(), true, true);
       break;
     case Instruction::SPUT_OBJECT:
+    case Instruction::SPUT_OBJECT_QUICK:
       VerifyISPut(inst, reg_types_.JavaLangObject(false), false, true);
       break;
 
@@ -2561,8 +2731,11 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
       VerifyIPutQuick(inst, reg_types_.JavaLangObject(false), false);
       break;
     case Instruction::INVOKE_VIRTUAL_QUICK:
-    case Instruction::INVOKE_VIRTUAL_RANGE_QUICK: {
-      bool is_range = (inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK);
+    case Instruction::INVOKE_VIRTUAL_RANGE_QUICK:
+    case Instruction::INVOKE_SUPER_QUICK:
+    case Instruction::INVOKE_SUPER_RANGE_QUICK: {
+      bool is_range = (inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK ||
+                       inst->Opcode() == Instruction::INVOKE_SUPER_RANGE_QUICK);
       mirror::ArtMethod* called_method = VerifyInvokeVirtualQuickArgs(inst, is_range);
       if (called_method != NULL) {
         const char* descriptor = MethodHelper(called_method).GetReturnTypeDescriptor();
@@ -2587,15 +2760,6 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
     case Instruction::UNUSED_43:
     case Instruction::UNUSED_79:
     case Instruction::UNUSED_7A:
-    case Instruction::UNUSED_EB:
-    case Instruction::UNUSED_EC:
-    case Instruction::UNUSED_ED:
-    case Instruction::UNUSED_EE:
-    case Instruction::UNUSED_EF:
-    case Instruction::UNUSED_F0:
-    case Instruction::UNUSED_F1:
-    case Instruction::UNUSED_F2:
-    case Instruction::UNUSED_F3:
     case Instruction::UNUSED_F4:
     case Instruction::UNUSED_F5:
     case Instruction::UNUSED_F6:
@@ -3119,14 +3283,21 @@ mirror::ArtMethod* MethodVerifier::VerifyInvocationArgs(const Instruction* inst,
 mirror::ArtMethod* MethodVerifier::GetQuickInvokedMethod(const Instruction* inst,
                                                          RegisterLine* reg_line, bool is_range) {
   DCHECK(inst->Opcode() == Instruction::INVOKE_VIRTUAL_QUICK ||
-         inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK);
-  const RegType& actual_arg_type = reg_line->GetInvocationThis(inst, is_range);
+         inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE_QUICK ||
+         inst->Opcode() == Instruction::INVOKE_SUPER_QUICK ||
+         inst->Opcode() == Instruction::INVOKE_SUPER_RANGE_QUICK);
+  const bool is_super = (inst->Opcode() == Instruction::INVOKE_SUPER_QUICK ||
+                         inst->Opcode() == Instruction::INVOKE_SUPER_RANGE_QUICK);
+  const RegType& actual_arg_type = is_super ? GetDeclaringClass()
+                                            : reg_line->GetInvocationThis(inst, is_range);
   if (!actual_arg_type.HasClass()) {
     VLOG(verifier) << "Failed to get mirror::Class* from '" << actual_arg_type << "'";
     return nullptr;
   }
   mirror::ObjectArray<mirror::ArtMethod>* vtable = nullptr;
-  mirror::Class* klass = actual_arg_type.GetClass();
+  // invoke-super-quick indexes the vtable of the super class of the declaring class.
+  mirror::Class* klass = is_super ? actual_arg_type.GetClass()->GetSuperClass()
+                                  : actual_arg_type.GetClass();
   if (klass->IsInterface()) {
     // Derive Object.class from Class.class.getSuperclass().
     mirror::Class* object_klass = klass->GetClass()->GetSuperClass();
@@ -3795,9 +3966,9 @@ bool MethodVerifier::UpdateRegisters(uint32_t next_insn, const RegisterLine* mer
       }
     }
   } else {
-    UniquePtr<RegisterLine> copy(gDebugVerify ?
-                                 RegisterLine::Create(target_line->NumRegs(), this) :
-                                 NULL);
+    RegisterLineArenaUniquePtr copy(gDebugVerify ?
+                                    RegisterLine::Create(target_line->NumRegs(), this) :
+                                    NULL);
     if (gDebugVerify) {
       copy->CopyFromLine(target_line);
     }
@@ -22,6 +22,7 @@
 
 #include "base/casts.h"
 #include "base/macros.h"
+#include "base/scoped_arena_allocator.h"
 #include "base/stl_util.h"
 #include "class_reference.h"
 #include "dex_file.h"
@@ -39,6 +40,7 @@ namespace art {
 
 struct ReferenceMap2Visitor;
 template<class T> class SirtRef;
+class ThreadPool;
 
 namespace verifier {
 
@@ -111,12 +113,13 @@ enum RegisterTrackingMode {
 // execution of that instruction.
 class PcToRegisterLineTable {
  public:
-  PcToRegisterLineTable() : size_(0) {}
+  PcToRegisterLineTable() : register_lines_(nullptr), size_(0) {}
   ~PcToRegisterLineTable();
 
   // Initialize the RegisterTable. Every instruction address can have a different set of information
   // about what's in which register, but for verification purposes we only need to store it at
-  // branch target addresses (because we merge into that).
+  // branch target addresses (because we merge into that). The table and the lines are allocated
+  // on the arena of the verifier.
   void Init(RegisterTrackingMode mode, InstructionFlags* flags, uint32_t insns_size,
             uint16_t registers_size, MethodVerifier* verifier);
 
@@ -126,7 +129,7 @@ class PcToRegisterLineTable {
   }
 
  private:
-  UniquePtr<RegisterLine*[]> register_lines_;
+  RegisterLine** register_lines_;
   size_t size_;
 };
 
@@ -166,6 +169,12 @@ class MethodVerifier {
     return &reg_types_;
   }
 
+  // The allocator for the state of the verification of the method, released all at once when the
+  // verifier is destroyed.
+  ScopedArenaAllocator& GetArena() {
+    return arena_;
+  }
+
   // Log a verification failure.
   std::ostream& Fail(VerifyError error);
 
@@ -233,6 +242,10 @@ class MethodVerifier {
   bool HasCheckCasts() const;
   bool HasVirtualOrInterfaceInvokes() const;
   bool HasFailures() const;
+  // Whether some failures are not about unavailable or inaccessible classes and members, which
+  // runtime verification turns into hard failures.
+  bool HasBadClassSoftFailure() const;
+  const DexFile::ClassDef* GetClassDef() const;
   const RegType& ResolveCheckedClass(uint32_t class_idx)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -243,6 +256,35 @@ class MethodVerifier {
   // Adds the given string to the end of the last failure message.
   void AppendToLastFailMessage(std::string);
 
+  // A method of the class being verified by VerifyClass.
+  struct ClassMethod {
+    uint32_t method_idx;
+    const DexFile::CodeItem* code_item;
+    uint32_t access_flags;
+    InvokeType type;
+  };
+
+  class ParallelVerification;
+  class ParallelVerificationTask;
+
+  // Resolves and verifies a method of the class being verified.
+  static FailureKind VerifyClassMethod(const DexFile* dex_file,
+                                       SirtRef<mirror::DexCache>& dex_cache,
+                                       SirtRef<mirror::ClassLoader>& class_loader,
+                                       const DexFile::ClassDef* class_def,
+                                       const ClassMethod& method, bool allow_soft_failures)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Verifies the methods of a class on the calling thread and the workers of thread_pool, storing
+  // the failure kind of each method in results.
+  static void VerifyClassMethodsInParallel(ThreadPool* thread_pool, const DexFile* dex_file,
+                                           SirtRef<mirror::DexCache>& dex_cache,
+                                           SirtRef<mirror::ClassLoader>& class_loader,
+                                           const DexFile::ClassDef* class_def,
+                                           const std::vector<ClassMethod>& methods,
+                                           bool allow_soft_failures, FailureKind* results)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   /*
    * Perform verification on a single method.
    *
@@ -612,19 +654,23 @@ class MethodVerifier {
   const RegType& DetermineCat1Constant(int32_t value, bool precise)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The arenas are taken from the runtime's pool and returned to it for the next verifier.
+  ArenaStack arena_stack_;
+  ScopedArenaAllocator arena_;
+
   RegTypeCache reg_types_;
 
   PcToRegisterLineTable reg_table_;
 
   // Storage for the register status we're currently working on.
-  UniquePtr<RegisterLine> work_line_;
+  RegisterLineArenaUniquePtr work_line_;
 
   // The address of the instruction we're currently working on, note that this is in 2 byte
   // quantities
   uint32_t work_insn_idx_;
 
   // Storage for the register status we're saving for later.
-  UniquePtr<RegisterLine> saved_line_;
+  RegisterLineArenaUniquePtr saved_line_;
 
   const uint32_t dex_method_idx_;  // The method we're working on.
   // Its object representation if known.
@@ -658,6 +704,9 @@ class MethodVerifier {
   // to be unreachable. This is set by Fail and used to ensure we don't process unreachable
   // instructions that would hard fail the verification.
   bool have_pending_runtime_throw_failure_;
+  // Has a VERIFY_ERROR_BAD_CLASS_SOFT failure been reported, as opposed to the failures which are
+  // turned into soft failures when compiling?
+  bool have_bad_class_soft_failure_;
 
   // Info message log use primarily for verifier diagnostics.
   std::ostringstream info_messages_;
@@ -21,7 +21,9 @@
 #include "UniquePtr.h"
 #include "class_linker.h"
 #include "common_runtime_test.h"
+#include "compiler_callbacks.h"
 #include "dex_file.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace verifier {
@@ -57,5 +59,19 @@ TEST_F(MethodVerifierTest, LibCore) {
   VerifyDexFile(java_lang_dex_file_);
 }
 
+TEST_F(MethodVerifierTest, LibCoreInParallel) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Verification thread pool", 3);
+  thread_pool.StartWorkers(self);
+  CompilerCallbacks* callbacks = Runtime::Current()->GetCompilerCallbacks();
+  callbacks->SetVerificationThreadPool(&thread_pool);
+  {
+    ScopedObjectAccess soa(self);
+    VerifyDexFile(java_lang_dex_file_);
+  }
+  callbacks->SetVerificationThreadPool(nullptr);
+  thread_pool.Wait(self, true, false);
+}
+
 }  // namespace verifier
 }  // namespace art
@@ -18,6 +18,7 @@
 #define ART_RUNTIME_VERIFIER_REG_TYPE_H_
 
 #include "base/macros.h"
+#include "base/scoped_arena_allocator.h"
 #include "globals.h"
 #include "object_callbacks.h"
 #include "primitive.h"
@@ -270,6 +271,22 @@ class RegType {
 
   virtual ~RegType() {}
 
+  // The shared primitive and small constant types are allocated on the heap, the types of a
+  // RegTypeCache on its arena. Arena allocated types are destroyed but not deleted.
+  static void* operator new(size_t size) {
+    return ::operator new(size);
+  }
+  static void operator delete(void* ptr) {
+    ::operator delete(ptr);
+  }
+  static void* operator new(size_t size, ScopedArenaAllocator* arena) {
+    return arena->Alloc(size, kArenaAllocVerifier);
+  }
+  static void operator delete(void* ptr, ScopedArenaAllocator* arena) {
+    UNUSED(ptr);
+    UNUSED(arena);
+  }
+
   void VisitRoots(RootCallback* callback, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  protected:
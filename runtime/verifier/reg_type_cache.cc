@@ -181,9 +181,9 @@ const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descr
     if (klass->CannotBeAssignedFromOtherTypes() || precise) {
       DCHECK(!(klass->IsAbstract()) || klass->IsArrayClass());
       DCHECK(!klass->IsInterface());
-      entry = new PreciseReferenceType(klass, descriptor, entries_.size());
+      entry = new (&arena_) PreciseReferenceType(klass, descriptor, entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor, entries_.size());
+      entry = new (&arena_) ReferenceType(klass, descriptor, entries_.size());
     }
     entries_.push_back(entry);
     return *entry;
@@ -197,7 +197,7 @@ const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descr
       DCHECK(!Thread::Current()->IsExceptionPending());
     }
     if (IsValidDescriptor(descriptor)) {
-      RegType* entry = new UnresolvedReferenceType(descriptor, entries_.size());
+      RegType* entry = new (&arena_) UnresolvedReferenceType(descriptor, entries_.size());
       entries_.push_back(entry);
       return *entry;
     } else {
@@ -225,16 +225,17 @@ const RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* kl
     // No reference to the class was found, create new reference.
     RegType* entry;
     if (precise) {
-      entry = new PreciseReferenceType(klass, descriptor, entries_.size());
+      entry = new (&arena_) PreciseReferenceType(klass, descriptor, entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor, entries_.size());
+      entry = new (&arena_) ReferenceType(klass, descriptor, entries_.size());
     }
     entries_.push_back(entry);
     return *entry;
   }
 }
 
-RegTypeCache::RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_classes) {
+RegTypeCache::RegTypeCache(bool can_load_classes, ScopedArenaAllocator& arena)
+    : entries_(arena.Adapter()), arena_(arena), can_load_classes_(can_load_classes) {
   if (kIsDebugBuild && can_load_classes) {
     Thread::Current()->AssertThreadSuspensionIsAllowable();
   }
@@ -244,14 +245,10 @@ RegTypeCache::RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_c
 
 RegTypeCache::~RegTypeCache() {
   CHECK_LE(primitive_count_, entries_.size());
-  // Delete only the non primitive types.
-  if (entries_.size() == kNumPrimitivesAndSmallConstants) {
-    // All entries are from the global pool, nothing to delete.
-    return;
-  }
-  std::vector<RegType*>::iterator non_primitive_begin = entries_.begin();
-  std::advance(non_primitive_begin, kNumPrimitivesAndSmallConstants);
-  STLDeleteContainerPointers(non_primitive_begin, entries_.end());
+  // Destroy only the non primitive types, their memory is released with the arena.
+  for (size_t i = kNumPrimitivesAndSmallConstants; i < entries_.size(); ++i) {
+    entries_[i]->~RegType();
+  }
 }
 
 void RegTypeCache::ShutDown() {
@@ -338,7 +335,8 @@ const RegType& RegTypeCache::FromUnresolvedMerge(const RegType& left, const RegT
     }
   }
   // Create entry.
-  RegType* entry = new UnresolvedMergedType(left.GetId(), right.GetId(), this, entries_.size());
+  RegType* entry = new (&arena_) UnresolvedMergedType(left.GetId(), right.GetId(), this,
+                                                      entries_.size());
   entries_.push_back(entry);
   if (kIsDebugBuild) {
     UnresolvedMergedType* tmp_entry = down_cast<UnresolvedMergedType*>(entry);
@@ -362,7 +360,7 @@ const RegType& RegTypeCache::FromUnresolvedSuperClass(const RegType& child) {
       }
     }
   }
-  RegType* entry = new UnresolvedSuperClass(child.GetId(), this, entries_.size());
+  RegType* entry = new (&arena_) UnresolvedSuperClass(child.GetId(), this, entries_.size());
   entries_.push_back(entry);
   return *entry;
 }
@@ -379,7 +377,8 @@ const UninitializedType& RegTypeCache::Uninitialized(const RegType& type, uint32
         return *down_cast<UnresolvedUninitializedRefType*>(cur_entry);
       }
     }
-    entry = new UnresolvedUninitializedRefType(descriptor, allocation_pc, entries_.size());
+    entry = new (&arena_) UnresolvedUninitializedRefType(descriptor, allocation_pc,
+                                                         entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -391,7 +390,8 @@ const UninitializedType& RegTypeCache::Uninitialized(const RegType& type, uint32
         return *down_cast<UninitializedReferenceType*>(cur_entry);
       }
     }
-    entry = new UninitializedReferenceType(klass, descriptor, allocation_pc, entries_.size());
+    entry = new (&arena_) UninitializedReferenceType(klass, descriptor, allocation_pc,
+                                                     entries_.size());
   }
   entries_.push_back(entry);
   return *entry;
@@ -409,7 +409,7 @@ const RegType& RegTypeCache::FromUninitialized(const RegType& uninit_type) {
         return *cur_entry;
       }
     }
-    entry = new UnresolvedReferenceType(descriptor.c_str(), entries_.size());
+    entry = new (&arena_) UnresolvedReferenceType(descriptor.c_str(), entries_.size());
   } else {
     mirror::Class* klass = uninit_type.GetClass();
     if (uninit_type.IsUninitializedThisReference() && !klass->IsFinal()) {
@@ -420,7 +420,7 @@ const RegType& RegTypeCache::FromUninitialized(const RegType& uninit_type) {
           return *cur_entry;
         }
       }
-      entry = new ReferenceType(klass, "", entries_.size());
+      entry = new (&arena_) ReferenceType(klass, "", entries_.size());
     } else if (klass->IsInstantiable()) {
       // We're uninitialized because of allocation, look or create a precise type as allocations
       // may only create objects of that type.
@@ -430,7 +430,8 @@ const RegType& RegTypeCache::FromUninitialized(const RegType& uninit_type) {
           return *cur_entry;
         }
       }
-      entry = new PreciseReferenceType(klass, uninit_type.GetDescriptor(), entries_.size());
+      entry = new (&arena_) PreciseReferenceType(klass, uninit_type.GetDescriptor(),
+                                                 entries_.size());
     } else {
       return Conflict();
     }
@@ -487,7 +488,7 @@ const UninitializedType& RegTypeCache::UninitializedThisArgument(const RegType&
         return *down_cast<UninitializedType*>(cur_entry);
       }
     }
-    entry = new UnresolvedUninitializedThisRefType(descriptor, entries_.size());
+    entry = new (&arena_) UnresolvedUninitializedThisRefType(descriptor, entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -496,7 +497,7 @@ const UninitializedType& RegTypeCache::UninitializedThisArgument(const RegType&
         return *down_cast<UninitializedType*>(cur_entry);
       }
     }
-    entry = new UninitializedThisReferenceType(klass, descriptor, entries_.size());
+    entry = new (&arena_) UninitializedThisReferenceType(klass, descriptor, entries_.size());
   }
   entries_.push_back(entry);
   return *entry;
@@ -513,9 +514,9 @@ const ConstantType& RegTypeCache::FromCat1NonSmallConstant(int32_t value, bool p
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstType(value, entries_.size());
+    entry = new (&arena_) PreciseConstType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstType(value, entries_.size());
+    entry = new (&arena_) ImpreciseConstType(value, entries_.size());
   }
   entries_.push_back(entry);
   return *entry;
@@ -531,9 +532,9 @@ const ConstantType& RegTypeCache::FromCat2ConstLo(int32_t value, bool precise) {
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstLoType(value, entries_.size());
+    entry = new (&arena_) PreciseConstLoType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstLoType(value, entries_.size());
+    entry = new (&arena_) ImpreciseConstLoType(value, entries_.size());
   }
   entries_.push_back(entry);
   return *entry;
@@ -549,9 +550,9 @@ const ConstantType& RegTypeCache::FromCat2ConstHi(int32_t value, bool precise) {
   }
   ConstantType* entry;
   if (precise) {
-    entry = new PreciseConstHiType(value, entries_.size());
+    entry = new (&arena_) PreciseConstHiType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstHiType(value, entries_.size());
+    entry = new (&arena_) ImpreciseConstHiType(value, entries_.size());
   }
   entries_.push_back(entry);
   return *entry;
@@ -580,6 +581,17 @@ void RegTypeCache::Dump(std::ostream& os) {
   }
 }
 
+void RegTypeCache::GetClassTypes(std::vector<const RegType*>* types) const {
+  for (size_t i = primitive_count_; i < entries_.size(); i++) {
+    const RegType* cur_entry = entries_[i];
+    if (cur_entry->HasClass() ||
+        (cur_entry->IsUnresolvedTypes() && !cur_entry->IsUnresolvedMergedReference() &&
+         !cur_entry->IsUnresolvedSuperClass())) {
+      types->push_back(cur_entry);
+    }
+  }
+}
+
 void RegTypeCache::VisitRoots(RootCallback* callback, void* arg) {
   for (RegType* entry : entries_) {
     entry->VisitRoots(callback, arg);
@@ -19,6 +19,7 @@
 
 #include "base/casts.h"
 #include "base/macros.h"
+#include "base/scoped_arena_allocator.h"
 #include "base/stl_util.h"
 #include "object_callbacks.h"
 #include "reg_type.h"
@@ -38,7 +39,8 @@ class RegType;
 
 class RegTypeCache {
  public:
-  explicit RegTypeCache(bool can_load_classes);
+  // The non primitive types are allocated on the arena, which must outlive the cache.
+  RegTypeCache(bool can_load_classes, ScopedArenaAllocator& arena);
   ~RegTypeCache();
   static void Init() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     if (!RegTypeCache::primitive_initialized_) {
@@ -143,6 +145,10 @@ class RegTypeCache {
   void Dump(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   const RegType& RegTypeFromPrimitiveType(Primitive::Type) const;
 
+  // Appends the types of the classes looked up so far, resolved or not, to types.
+  void GetClassTypes(std::vector<const RegType*>* types) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void VisitRoots(RootCallback* callback, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
@@ -160,7 +166,10 @@ class RegTypeCache {
   static void CreatePrimitiveAndSmallConstantTypes() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // The actual storage for the RegTypes.
-  std::vector<RegType*> entries_;
+  std::vector<RegType*, ScopedArenaAllocatorAdapter<RegType*> > entries_;
+
+  // Arena allocator for the RegTypes and entries_.
+  ScopedArenaAllocator& arena_;
 
   // A quick look up for popular small constants.
   static constexpr int32_t kMinSmallConstant = -1;
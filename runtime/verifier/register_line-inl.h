@@ -23,6 +23,12 @@
 namespace art {
 namespace verifier {
 
+inline RegisterLine* RegisterLine::Create(size_t num_regs, MethodVerifier* verifier) {
+  void* memory = verifier->GetArena().Alloc(sizeof(RegisterLine) + (num_regs * sizeof(uint16_t)),
+                                            kArenaAllocVerifier);
+  return new (memory) RegisterLine(num_regs, verifier);
+}
+
 inline const RegType& RegisterLine::GetRegisterType(uint32_t vsrc) const {
   // The register index was validated during the static pass, so we don't need to check it here.
   DCHECK_LT(vsrc, num_regs_);
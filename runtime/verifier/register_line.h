@@ -50,11 +50,9 @@ enum TypeCategory {
 // stack of entered monitors (identified by code unit offset).
 class RegisterLine {
  public:
-  static RegisterLine* Create(size_t num_regs, MethodVerifier* verifier) {
-    uint8_t* memory = new uint8_t[sizeof(RegisterLine) + (num_regs * sizeof(uint16_t))];
-    RegisterLine* rl = new (memory) RegisterLine(num_regs, verifier);
-    return rl;
-  }
+  // Allocates the line on the arena of the verifier. The line is destroyed, but not freed, by
+  // RegisterLineArenaDelete.
+  static RegisterLine* Create(size_t num_regs, MethodVerifier* verifier);
 
   // Implement category-1 "move" instructions. Copy a 32-bit value from "vsrc" to "vdst".
   void CopyRegister1(uint32_t vdst, uint32_t vsrc, TypeCategory cat)
@@ -363,6 +361,17 @@ class RegisterLine {
 };
 std::ostream& operator<<(std::ostream& os, const RegisterLine& rhs);
 
+class RegisterLineArenaDelete {
+ public:
+  void operator()(RegisterLine* ptr) const {
+    if (ptr != nullptr) {
+      ptr->~RegisterLine();
+    }
+  }
+};
+
+typedef UniquePtr<RegisterLine, RegisterLineArenaDelete> RegisterLineArenaUniquePtr;
+
 }  // namespace verifier
 }  // namespace art
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "verifier_deps.h"
+
+#include "class_linker.h"
+#include "dex_file-inl.h"
+#include "method_verifier-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "mirror/iftable-inl.h"
+#include "reg_type.h"
+#include "reg_type_cache.h"
+#include "runtime.h"
+#include "sirt_ref.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace verifier {
+
+void VerifierDeps::AddMethod(MethodVerifier* verifier) {
+  if (verifier->HasBadClassSoftFailure()) {
+    valid_ = false;
+  }
+  if (verifier->HasFailures()) {
+    flags_ |= kHasFailures;
+  }
+  if (!valid_) {
+    return;
+  }
+  const DexFile& dex_file = *verifier->GetMethodReference().dex_file;
+  // The class itself, for its superclass and interfaces.
+  const char* descriptor = dex_file.StringByTypeIdx(verifier->GetClassDef()->class_idx_);
+  AddClass(dex_file, descriptor,
+           Runtime::Current()->GetClassLinker()->LookupClass(descriptor,
+                                                             verifier->GetClassLoader()));
+  std::vector<const RegType*> types;
+  verifier->GetRegTypeCache()->GetClassTypes(&types);
+  for (const RegType* type : types) {
+    AddClass(dex_file, type->GetDescriptor().c_str(),
+             type->HasClass() ? type->GetClass() : nullptr);
+  }
+}
+
+void VerifierDeps::AddClass(const DexFile& dex_file, const char* descriptor,
+                            mirror::Class* klass) {
+  if (klass != nullptr && klass->GetClassLoader() == nullptr) {
+    return;
+  }
+  const DexFile::TypeId* type_id = dex_file.FindTypeId(descriptor);
+  if (type_id == nullptr) {
+    valid_ = false;
+    return;
+  }
+  uint32_t type_idx = dex_file.GetIndexForTypeId(*type_id);
+  uint32_t checksum = (klass != nullptr) ? ComputeClassChecksum(klass) : 0;
+  auto it = classes_.find(type_idx);
+  if (it == classes_.end()) {
+    classes_.Put(type_idx, checksum);
+  } else if (it->second != checksum) {
+    // The class was looked up by another class loader or changed while compiling.
+    valid_ = false;
+  }
+}
+
+void VerifierDeps::Encode(std::vector<uint32_t>* words) const {
+  DCHECK(valid_);
+  words->push_back(flags_);
+  for (const auto& entry : classes_) {
+    words->push_back(entry.first);
+    words->push_back(entry.second);
+  }
+}
+
+bool VerifierDeps::Check(const DexFile& dex_file, const uint32_t* words, uint32_t num_words,
+                         const SirtRef<mirror::ClassLoader>& class_loader, bool* has_failures) {
+  if (num_words % 2 != 1) {
+    // No dependencies were recorded.
+    return false;
+  }
+  Thread* self = Thread::Current();
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  for (uint32_t i = 1; i < num_words; i += 2) {
+    if (words[i] >= dex_file.NumTypeIds()) {
+      return false;
+    }
+    const char* descriptor = dex_file.StringByTypeIdx(words[i]);
+    mirror::Class* klass = class_linker->FindClass(self, descriptor, class_loader);
+    uint32_t checksum = 0;
+    if (klass == nullptr) {
+      DCHECK(self->IsExceptionPending());
+      self->ClearException();
+    } else {
+      checksum = ComputeClassChecksum(klass);
+    }
+    if (checksum != words[i + 1]) {
+      VLOG(verifier) << "Class " << PrettyDescriptor(descriptor)
+                     << " changed since compile time verification";
+      return false;
+    }
+  }
+  *has_failures = (words[0] & kHasFailures) != 0;
+  return true;
+}
+
+static uint32_t DexFileChecksum(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  // Primitive, proxy and array classes aren't defined by a dex file.
+  mirror::DexCache* dex_cache = klass->GetDexCache();
+  return (dex_cache != nullptr) ? dex_cache->GetDexFile()->GetLocationChecksum() : 0;
+}
+
+uint32_t VerifierDeps::ComputeClassChecksum(mirror::Class* klass) {
+  while (klass->IsArrayClass()) {
+    klass = klass->GetComponentType();
+  }
+  uint32_t checksum = 1;
+  for (mirror::Class* c = klass; c != nullptr; c = c->GetSuperClass()) {
+    checksum = checksum * 31 + DexFileChecksum(c);
+  }
+  mirror::IfTable* iftable = klass->GetIfTable();
+  for (int32_t i = 0, e = klass->GetIfTableCount(); i < e; ++i) {
+    checksum = checksum * 31 + DexFileChecksum(iftable->GetInterface(i));
+  }
+  return (checksum != 0) ? checksum : 1;
+}
+
+}  // namespace verifier
+}  // namespace art
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_VERIFIER_VERIFIER_DEPS_H_
+#define ART_RUNTIME_VERIFIER_VERIFIER_DEPS_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "safe_map.h"
+
+namespace art {
+
+class DexFile;
+template<class T> class SirtRef;
+
+namespace mirror {
+class Class;
+class ClassLoader;
+}  // namespace mirror
+
+namespace verifier {
+
+class MethodVerifier;
+
+// The classes the compile time verification of a class depended on. A class that can't be
+// verified when compiling, typically because it refers to classes missing from the compile time
+// class path, is verified again at runtime. When the classes it refers to resolve to the same
+// definitions as when compiling, the verifier answers every question the same way and verifying
+// again is skipped.
+//
+// A class is identified by the checksums of the dex files defining it, its superclasses and its
+// interfaces, which determine its members and its assignability. Classes of the boot class path
+// aren't recorded since the oat file is rejected when the boot class path changes.
+//
+// The dependencies are encoded as 32-bit words: the flags, then a type index of the dex file of
+// the class and the checksum of the class it resolved to for each class.
+class VerifierDeps {
+ public:
+  enum Flags {
+    // Some methods have failures that the runtime checks with slow paths, the methods of the
+    // class aren't preverified.
+    kHasFailures = 1,
+  };
+
+  VerifierDeps() : valid_(true), flags_(0) {}
+
+  // Records the classes looked up by the verifier of a method of the class.
+  void AddMethod(MethodVerifier* verifier) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether the verification result only depends on the recorded classes. It doesn't when a
+  // method has failures that runtime verification turns into hard failures, or when a class
+  // can't be named by a type index of the dex file.
+  bool IsValid() const {
+    return valid_;
+  }
+
+  void Encode(std::vector<uint32_t>* words) const;
+
+  // Checks encoded dependencies against the classes the class loader resolves. Returns true and
+  // sets has_failures if verification would give the same result as when compiling.
+  static bool Check(const DexFile& dex_file, const uint32_t* words, uint32_t num_words,
+                    const SirtRef<mirror::ClassLoader>& class_loader, bool* has_failures)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The checksum of the definitions of the class and its supertypes, never 0 which stands for a
+  // class that doesn't resolve.
+  static uint32_t ComputeClassChecksum(mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  void AddClass(const DexFile& dex_file, const char* descriptor, mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  bool valid_;
+  uint32_t flags_;
+  // The checksums of the classes by type index.
+  SafeMap<uint32_t, uint32_t> classes_;
+
+  DISALLOW_COPY_AND_ASSIGN(VerifierDeps);
+};
+
+}  // namespace verifier
+}  // namespace art
+
+#endif  // ART_RUNTIME_VERIFIER_VERIFIER_DEPS_H_
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "verifier_deps.h"
+
+#include <vector>
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "dex_file.h"
+#include "sirt_ref.h"
+
+namespace art {
+namespace verifier {
+
+class VerifierDepsTest : public CommonRuntimeTest {};
+
+TEST_F(VerifierDepsTest, ClassChecksum) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  mirror::Class* string = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/String;");
+  mirror::Class* string_array = class_linker_->FindSystemClass(soa.Self(), "[Ljava/lang/String;");
+  ASSERT_TRUE(object != nullptr);
+  ASSERT_TRUE(string != nullptr);
+  ASSERT_TRUE(string_array != nullptr);
+  uint32_t object_checksum = VerifierDeps::ComputeClassChecksum(object);
+  uint32_t string_checksum = VerifierDeps::ComputeClassChecksum(string);
+  EXPECT_NE(0U, object_checksum);
+  EXPECT_NE(object_checksum, string_checksum);
+  EXPECT_EQ(object_checksum, VerifierDeps::ComputeClassChecksum(object));
+  // Arrays depend on their element class.
+  EXPECT_EQ(string_checksum, VerifierDeps::ComputeClassChecksum(string_array));
+}
+
+TEST_F(VerifierDepsTest, Check) {
+  ScopedObjectAccess soa(Thread::Current());
+  SirtRef<mirror::ClassLoader> class_loader(soa.Self(), nullptr);
+  const DexFile& dex_file = *java_lang_dex_file_;
+  const DexFile::TypeId* type_id = dex_file.FindTypeId("Ljava/lang/Object;");
+  ASSERT_TRUE(type_id != nullptr);
+  mirror::Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object != nullptr);
+
+  bool has_failures = false;
+  // No dependencies were recorded.
+  EXPECT_FALSE(VerifierDeps::Check(dex_file, nullptr, 0, class_loader, &has_failures));
+
+  std::vector<uint32_t> words;
+  words.push_back(VerifierDeps::kHasFailures);
+  words.push_back(dex_file.GetIndexForTypeId(*type_id));
+  words.push_back(VerifierDeps::ComputeClassChecksum(object));
+  EXPECT_TRUE(VerifierDeps::Check(dex_file, &words[0], words.size(), class_loader,
+                                  &has_failures));
+  EXPECT_TRUE(has_failures);
+
+  // The class resolves to a different definition.
+  words[2] += 1;
+  EXPECT_FALSE(VerifierDeps::Check(dex_file, &words[0], words.size(), class_loader,
+                                   &has_failures));
+  // The class doesn't resolve any more.
+  words[2] = 0;
+  EXPECT_FALSE(VerifierDeps::Check(dex_file, &words[0], words.size(), class_loader,
+                                   &has_failures));
+}
+
+}  // namespace verifier
+}  // namespace art
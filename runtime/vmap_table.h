@@ -49,6 +49,16 @@ class VmapTable {
     return DecodeUnsignedLeb128(&table);
   }
 
+  // The size in bytes of the encoded table, size included.
+  size_t EncodedSize() const {
+    const uint8_t* table = table_;
+    size_t size = DecodeUnsignedLeb128(&table);
+    for (size_t i = 0; i < size; ++i) {
+      DecodeUnsignedLeb128(&table);
+    }
+    return table - table_;
+  }
+
   // Is the dex register 'vreg' in the context or on the stack? Should not be called when the
   // 'kind' is unknown or constant.
   bool IsInContext(size_t vreg, VRegKind kind, uint32_t* vmap_offset) const {
@@ -26,7 +26,9 @@
 namespace art {
 
 jclass WellKnownClasses::com_android_dex_Dex;
+jclass WellKnownClasses::dalvik_system_DexClassLoader;
 jclass WellKnownClasses::dalvik_system_PathClassLoader;
+jclass WellKnownClasses::java_lang_BootClassLoader;
 jclass WellKnownClasses::java_lang_ClassLoader;
 jclass WellKnownClasses::java_lang_ClassNotFoundException;
 jclass WellKnownClasses::java_lang_Daemons;
@@ -36,6 +38,7 @@ jclass WellKnownClasses::java_lang_reflect_AbstractMethod;
 jclass WellKnownClasses::java_lang_reflect_ArtMethod;
 jclass WellKnownClasses::java_lang_reflect_Constructor;
 jclass WellKnownClasses::java_lang_reflect_Field;
+jclass WellKnownClasses::java_lang_reflect_InvocationTargetException;
 jclass WellKnownClasses::java_lang_reflect_Method;
 jclass WellKnownClasses::java_lang_reflect_Proxy;
 jclass WellKnownClasses::java_lang_RuntimeException;
@@ -64,6 +67,7 @@ jmethodID WellKnownClasses::java_lang_Integer_valueOf;
 jmethodID WellKnownClasses::java_lang_Long_valueOf;
 jmethodID WellKnownClasses::java_lang_ref_FinalizerReference_add;
 jmethodID WellKnownClasses::java_lang_ref_ReferenceQueue_add;
+jmethodID WellKnownClasses::java_lang_reflect_InvocationTargetException_init;
 jmethodID WellKnownClasses::java_lang_reflect_Proxy_invoke;
 jmethodID WellKnownClasses::java_lang_Runtime_nativeLoad;
 jmethodID WellKnownClasses::java_lang_Short_valueOf;
@@ -76,6 +80,19 @@ jmethodID WellKnownClasses::java_nio_DirectByteBuffer_init;
 jmethodID WellKnownClasses::org_apache_harmony_dalvik_ddmc_DdmServer_broadcast;
 jmethodID WellKnownClasses::org_apache_harmony_dalvik_ddmc_DdmServer_dispatch;
 
+jfieldID WellKnownClasses::dalvik_system_BaseDexClassLoader_pathList;
+jfieldID WellKnownClasses::dalvik_system_DexFile_cookie;
+jfieldID WellKnownClasses::dalvik_system_DexPathList_dexElements;
+jfieldID WellKnownClasses::dalvik_system_DexPathList$Element_dexFile;
+jfieldID WellKnownClasses::java_lang_Boolean_value;
+jfieldID WellKnownClasses::java_lang_Byte_value;
+jfieldID WellKnownClasses::java_lang_Character_value;
+jfieldID WellKnownClasses::java_lang_ClassLoader_parent;
+jfieldID WellKnownClasses::java_lang_Double_value;
+jfieldID WellKnownClasses::java_lang_Float_value;
+jfieldID WellKnownClasses::java_lang_Integer_value;
+jfieldID WellKnownClasses::java_lang_Long_value;
+jfieldID WellKnownClasses::java_lang_Short_value;
 jfieldID WellKnownClasses::java_lang_Thread_daemon;
 jfieldID WellKnownClasses::java_lang_Thread_group;
 jfieldID WellKnownClasses::java_lang_Thread_lock;
@@ -126,9 +143,16 @@ static jmethodID CachePrimitiveBoxingMethod(JNIEnv* env, char prim_name, const c
                      StringPrintf("(%c)L%s;", prim_name, boxed_name).c_str());
 }
 
+static jfieldID CachePrimitiveBoxValueField(JNIEnv* env, char prim_name, const char* boxed_name) {
+  ScopedLocalRef<jclass> boxed_class(env, env->FindClass(boxed_name));
+  return CacheField(env, boxed_class.get(), false, "value", StringPrintf("%c", prim_name).c_str());
+}
+
 void WellKnownClasses::Init(JNIEnv* env) {
   com_android_dex_Dex = CacheClass(env, "com/android/dex/Dex");
+  dalvik_system_DexClassLoader = CacheClass(env, "dalvik/system/DexClassLoader");
   dalvik_system_PathClassLoader = CacheClass(env, "dalvik/system/PathClassLoader");
+  java_lang_BootClassLoader = CacheClass(env, "java/lang/BootClassLoader");
   java_lang_ClassLoader = CacheClass(env, "java/lang/ClassLoader");
   java_lang_ClassNotFoundException = CacheClass(env, "java/lang/ClassNotFoundException");
   java_lang_Daemons = CacheClass(env, "java/lang/Daemons");
@@ -138,6 +162,7 @@ void WellKnownClasses::Init(JNIEnv* env) {
   java_lang_reflect_ArtMethod = CacheClass(env, "java/lang/reflect/ArtMethod");
   java_lang_reflect_Constructor = CacheClass(env, "java/lang/reflect/Constructor");
   java_lang_reflect_Field = CacheClass(env, "java/lang/reflect/Field");
+  java_lang_reflect_InvocationTargetException = CacheClass(env, "java/lang/reflect/InvocationTargetException");
   java_lang_reflect_Method = CacheClass(env, "java/lang/reflect/Method");
   java_lang_reflect_Proxy = CacheClass(env, "java/lang/reflect/Proxy");
   java_lang_RuntimeException = CacheClass(env, "java/lang/RuntimeException");
@@ -164,6 +189,7 @@ void WellKnownClasses::Init(JNIEnv* env) {
   ScopedLocalRef<jclass> java_lang_ref_ReferenceQueue(env, env->FindClass("java/lang/ref/ReferenceQueue"));
   java_lang_ref_ReferenceQueue_add = CacheMethod(env, java_lang_ref_ReferenceQueue.get(), true, "add", "(Ljava/lang/ref/Reference;)V");
 
+  java_lang_reflect_InvocationTargetException_init = CacheMethod(env, java_lang_reflect_InvocationTargetException, false, "<init>", "(Ljava/lang/Throwable;)V");
   java_lang_reflect_Proxy_invoke = CacheMethod(env, java_lang_reflect_Proxy, true, "invoke", "(Ljava/lang/reflect/Proxy;Ljava/lang/reflect/ArtMethod;[Ljava/lang/Object;)Ljava/lang/Object;");
   java_lang_Thread_init = CacheMethod(env, java_lang_Thread, false, "<init>", "(Ljava/lang/ThreadGroup;Ljava/lang/String;IZ)V");
   java_lang_Thread_run = CacheMethod(env, java_lang_Thread, false, "run", "()V");
@@ -173,6 +199,15 @@ void WellKnownClasses::Init(JNIEnv* env) {
   org_apache_harmony_dalvik_ddmc_DdmServer_broadcast = CacheMethod(env, org_apache_harmony_dalvik_ddmc_DdmServer, true, "broadcast", "(I)V");
   org_apache_harmony_dalvik_ddmc_DdmServer_dispatch = CacheMethod(env, org_apache_harmony_dalvik_ddmc_DdmServer, true, "dispatch", "(I[BII)Lorg/apache/harmony/dalvik/ddmc/Chunk;");
 
+  ScopedLocalRef<jclass> dalvik_system_BaseDexClassLoader(env, env->FindClass("dalvik/system/BaseDexClassLoader"));
+  dalvik_system_BaseDexClassLoader_pathList = CacheField(env, dalvik_system_BaseDexClassLoader.get(), false, "pathList", "Ldalvik/system/DexPathList;");
+  ScopedLocalRef<jclass> dalvik_system_DexFile(env, env->FindClass("dalvik/system/DexFile"));
+  dalvik_system_DexFile_cookie = CacheField(env, dalvik_system_DexFile.get(), false, "mCookie", "J");
+  ScopedLocalRef<jclass> dalvik_system_DexPathList(env, env->FindClass("dalvik/system/DexPathList"));
+  dalvik_system_DexPathList_dexElements = CacheField(env, dalvik_system_DexPathList.get(), false, "dexElements", "[Ldalvik/system/DexPathList$Element;");
+  ScopedLocalRef<jclass> dalvik_system_DexPathList$Element(env, env->FindClass("dalvik/system/DexPathList$Element"));
+  dalvik_system_DexPathList$Element_dexFile = CacheField(env, dalvik_system_DexPathList$Element.get(), false, "dexFile", "Ldalvik/system/DexFile;");
+  java_lang_ClassLoader_parent = CacheField(env, java_lang_ClassLoader, false, "parent", "Ljava/lang/ClassLoader;");
   java_lang_Thread_daemon = CacheField(env, java_lang_Thread, false, "daemon", "Z");
   java_lang_Thread_group = CacheField(env, java_lang_Thread, false, "group", "Ljava/lang/ThreadGroup;");
   java_lang_Thread_lock = CacheField(env, java_lang_Thread, false, "lock", "Ljava/lang/Object;");
@@ -201,6 +236,15 @@ void WellKnownClasses::Init(JNIEnv* env) {
   java_lang_Integer_valueOf = CachePrimitiveBoxingMethod(env, 'I', "java/lang/Integer");
   java_lang_Long_valueOf = CachePrimitiveBoxingMethod(env, 'J', "java/lang/Long");
   java_lang_Short_valueOf = CachePrimitiveBoxingMethod(env, 'S', "java/lang/Short");
+
+  java_lang_Boolean_value = CachePrimitiveBoxValueField(env, 'Z', "java/lang/Boolean");
+  java_lang_Byte_value = CachePrimitiveBoxValueField(env, 'B', "java/lang/Byte");
+  java_lang_Character_value = CachePrimitiveBoxValueField(env, 'C', "java/lang/Character");
+  java_lang_Double_value = CachePrimitiveBoxValueField(env, 'D', "java/lang/Double");
+  java_lang_Float_value = CachePrimitiveBoxValueField(env, 'F', "java/lang/Float");
+  java_lang_Integer_value = CachePrimitiveBoxValueField(env, 'I', "java/lang/Integer");
+  java_lang_Long_value = CachePrimitiveBoxValueField(env, 'J', "java/lang/Long");
+  java_lang_Short_value = CachePrimitiveBoxValueField(env, 'S', "java/lang/Short");
 }
 
 void WellKnownClasses::LateInit(JNIEnv* env) {
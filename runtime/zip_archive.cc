@@ -38,6 +38,10 @@ uint32_t ZipEntry::GetCrc32() {
   return zip_entry_->crc32;
 }
 
+bool ZipEntry::IsUncompressed() {
+  return zip_entry_->method == kCompressStored;
+}
+
 ZipEntry::~ZipEntry() {
   delete zip_entry_;
 }
@@ -74,6 +78,24 @@ MemMap* ZipEntry::ExtractToMemMap(const char* entry_filename, std::string* error
   return map.release();
 }
 
+MemMap* ZipEntry::MapDirectlyFromFile(const char* entry_filename, size_t alignment,
+                                      std::string* error_msg) {
+  if (!IsUncompressed()) {
+    *error_msg = StringPrintf("Cannot map '%s' directly because it is compressed", entry_filename);
+    return nullptr;
+  }
+  if (zip_entry_->offset % alignment != 0) {
+    *error_msg = StringPrintf("Cannot map '%s' directly because its offset %lld is not aligned to "
+                              "%zd", entry_filename, static_cast<long long>(zip_entry_->offset),
+                              alignment);
+    return nullptr;
+  }
+  std::string name(entry_filename);
+  name += " mapped directly in memory";
+  return MemMap::MapFile(GetUncompressedLength(), PROT_READ, MAP_PRIVATE,
+                         GetFileDescriptor(handle_), zip_entry_->offset, name.c_str(), error_msg);
+}
+
 static void SetCloseOnExec(int fd) {
   // This dance is more portable than Linux's O_CLOEXEC open(2) flag.
   int flags = fcntl(fd, F_GETFD);
@@ -38,10 +38,16 @@ class ZipEntry {
  public:
   bool ExtractToFile(File& file, std::string* error_msg);
   MemMap* ExtractToMemMap(const char* entry_filename, std::string* error_msg);
+  // Maps a stored entry read only from the archive file, so that its pages are shared clean
+  // pages of the page cache rather than a private copy. Returns NULL if the entry is compressed
+  // or doesn't start at a multiple of alignment in the archive.
+  MemMap* MapDirectlyFromFile(const char* entry_filename, size_t alignment,
+                              std::string* error_msg);
   virtual ~ZipEntry();
 
   uint32_t GetUncompressedLength();
   uint32_t GetCrc32();
+  bool IsUncompressed();
 
  private:
   ZipEntry(ZipArchiveHandle handle,
@@ -62,4 +62,26 @@ TEST_F(ZipArchiveTest, FindAndExtract) {
   EXPECT_EQ(zip_entry->GetCrc32(), computed_crc);
 }
 
+TEST_F(ZipArchiveTest, MapDirectlyFromFile) {
+  std::string error_msg;
+  UniquePtr<ZipArchive> zip_archive(ZipArchive::Open(GetLibCoreDexFileName().c_str(), &error_msg));
+  ASSERT_TRUE(zip_archive.get() != nullptr) << error_msg;
+  UniquePtr<ZipEntry> zip_entry(zip_archive->Find("classes.dex", &error_msg));
+  ASSERT_TRUE(zip_entry.get() != nullptr) << error_msg;
+
+  UniquePtr<MemMap> extracted(zip_entry->ExtractToMemMap("classes.dex", &error_msg));
+  ASSERT_TRUE(extracted.get() != nullptr) << error_msg;
+  UniquePtr<MemMap> mapped(zip_entry->MapDirectlyFromFile("classes.dex", 4, &error_msg));
+  if (!zip_entry->IsUncompressed()) {
+    // Only stored entries can be mapped.
+    EXPECT_TRUE(mapped.get() == nullptr);
+    EXPECT_FALSE(error_msg.empty());
+    return;
+  }
+  if (mapped.get() != nullptr) {
+    ASSERT_EQ(extracted->Size(), mapped->Size());
+    EXPECT_EQ(0, memcmp(extracted->Begin(), mapped->Begin(), mapped->Size()));
+  }
+}
+
 }  // namespace art
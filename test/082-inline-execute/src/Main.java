@@ -22,10 +22,29 @@ public class Main {
     test_Double_longBitsToDouble();
     test_Float_floatToRawIntBits();
     test_Float_intBitsToFloat();
+    test_Integer_bitCount();
+    test_Integer_numberOfLeadingZeros();
+    test_Integer_numberOfTrailingZeros();
+    test_Integer_rotate();
+    test_Long_bitCount();
+    test_Long_numberOfLeadingZeros();
+    test_Long_numberOfTrailingZeros();
+    test_Long_rotate();
     test_Math_abs_I();
     test_Math_abs_J();
     test_Math_min();
     test_Math_max();
+    test_Math_min_J();
+    test_Math_max_J();
+    test_Math_min_F();
+    test_Math_max_F();
+    test_Math_min_D();
+    test_Math_max_D();
+    test_Math_ceil();
+    test_Math_floor();
+    test_Math_rint();
+    test_Math_round_F();
+    test_Math_round_D();
     test_StrictMath_abs_I();
     test_StrictMath_abs_J();
     test_StrictMath_min();
@@ -334,4 +353,235 @@ public class Main {
     Assert.assertEquals(Double.longBitsToDouble(0x7ff0000000000000L), Double.POSITIVE_INFINITY);
     Assert.assertEquals(Double.longBitsToDouble(0xfff0000000000000L), Double.NEGATIVE_INFINITY);
   }
+
+  public static void test_Math_min_J() {
+    Assert.assertEquals(Math.min(0L, 0L), 0L);
+    Assert.assertEquals(Math.min(1L, 0L), 0L);
+    Assert.assertEquals(Math.min(0L, 1L), 0L);
+    Assert.assertEquals(Math.min(0x100000000L, 0xffffffffL), 0xffffffffL);
+    Assert.assertEquals(Math.min(-1L, 0xffffffffL), -1L);
+    Assert.assertEquals(Math.min(Long.MIN_VALUE, Long.MAX_VALUE), Long.MIN_VALUE);
+    Assert.assertEquals(StrictMath.min(Long.MAX_VALUE, Long.MIN_VALUE), Long.MIN_VALUE);
+  }
+
+  public static void test_Math_max_J() {
+    Assert.assertEquals(Math.max(0L, 0L), 0L);
+    Assert.assertEquals(Math.max(1L, 0L), 1L);
+    Assert.assertEquals(Math.max(0L, 1L), 1L);
+    Assert.assertEquals(Math.max(0x100000000L, 0xffffffffL), 0x100000000L);
+    Assert.assertEquals(Math.max(-1L, 0xffffffffL), 0xffffffffL);
+    Assert.assertEquals(Math.max(Long.MIN_VALUE, Long.MAX_VALUE), Long.MAX_VALUE);
+    Assert.assertEquals(StrictMath.max(Long.MAX_VALUE, Long.MIN_VALUE), Long.MAX_VALUE);
+  }
+
+  // The float and double comparisons box their arguments, so that NaN equals NaN and -0.0 differs
+  // from 0.0.
+  public static void test_Math_min_F() {
+    Assert.assertEquals(Math.min(1.0f, 2.0f), 1.0f);
+    Assert.assertEquals(Math.min(2.0f, -1.0f), -1.0f);
+    Assert.assertEquals(Math.min(0.0f, -0.0f), -0.0f);
+    Assert.assertEquals(Math.min(-0.0f, 0.0f), -0.0f);
+    Assert.assertEquals(Math.min(Float.NaN, 1.0f), Float.NaN);
+    Assert.assertEquals(Math.min(1.0f, Float.NaN), Float.NaN);
+    Assert.assertEquals(Math.min(Float.NEGATIVE_INFINITY, Float.MAX_VALUE),
+                        Float.NEGATIVE_INFINITY);
+    Assert.assertEquals(StrictMath.min(Float.MIN_VALUE, 0.0f), 0.0f);
+  }
+
+  public static void test_Math_max_F() {
+    Assert.assertEquals(Math.max(1.0f, 2.0f), 2.0f);
+    Assert.assertEquals(Math.max(2.0f, -1.0f), 2.0f);
+    Assert.assertEquals(Math.max(0.0f, -0.0f), 0.0f);
+    Assert.assertEquals(Math.max(-0.0f, 0.0f), 0.0f);
+    Assert.assertEquals(Math.max(Float.NaN, 1.0f), Float.NaN);
+    Assert.assertEquals(Math.max(1.0f, Float.NaN), Float.NaN);
+    Assert.assertEquals(Math.max(Float.POSITIVE_INFINITY, Float.MAX_VALUE),
+                        Float.POSITIVE_INFINITY);
+    Assert.assertEquals(StrictMath.max(Float.MIN_VALUE, 0.0f), Float.MIN_VALUE);
+  }
+
+  public static void test_Math_min_D() {
+    Assert.assertEquals(Math.min(1.0, 2.0), 1.0);
+    Assert.assertEquals(Math.min(2.0, -1.0), -1.0);
+    Assert.assertEquals(Math.min(0.0, -0.0), -0.0);
+    Assert.assertEquals(Math.min(-0.0, 0.0), -0.0);
+    Assert.assertEquals(Math.min(Double.NaN, 1.0), Double.NaN);
+    Assert.assertEquals(Math.min(1.0, Double.NaN), Double.NaN);
+    Assert.assertEquals(Math.min(Double.NEGATIVE_INFINITY, Double.MAX_VALUE),
+                        Double.NEGATIVE_INFINITY);
+    Assert.assertEquals(StrictMath.min(Double.MIN_VALUE, 0.0), 0.0);
+  }
+
+  public static void test_Math_max_D() {
+    Assert.assertEquals(Math.max(1.0, 2.0), 2.0);
+    Assert.assertEquals(Math.max(2.0, -1.0), 2.0);
+    Assert.assertEquals(Math.max(0.0, -0.0), 0.0);
+    Assert.assertEquals(Math.max(-0.0, 0.0), 0.0);
+    Assert.assertEquals(Math.max(Double.NaN, 1.0), Double.NaN);
+    Assert.assertEquals(Math.max(1.0, Double.NaN), Double.NaN);
+    Assert.assertEquals(Math.max(Double.POSITIVE_INFINITY, Double.MAX_VALUE),
+                        Double.POSITIVE_INFINITY);
+    Assert.assertEquals(StrictMath.max(Double.MIN_VALUE, 0.0), Double.MIN_VALUE);
+  }
+
+  public static void test_Math_ceil() {
+    Assert.assertEquals(Math.ceil(+0.0), +0.0);
+    Assert.assertEquals(Math.ceil(-0.0), -0.0);
+    Assert.assertEquals(Math.ceil(-0.9), -0.0);
+    Assert.assertEquals(Math.ceil(-0.5), -0.0);
+    Assert.assertEquals(Math.ceil(0.1), 1.0);
+    Assert.assertEquals(Math.ceil(2.5), 3.0);
+    Assert.assertEquals(Math.ceil(-2.5), -2.0);
+    Assert.assertEquals(Math.ceil(1e20), 1e20);
+    Assert.assertEquals(Math.ceil(Double.NaN), Double.NaN);
+    Assert.assertEquals(Math.ceil(Double.POSITIVE_INFINITY), Double.POSITIVE_INFINITY);
+    Assert.assertEquals(Math.ceil(Double.NEGATIVE_INFINITY), Double.NEGATIVE_INFINITY);
+    Assert.assertEquals(StrictMath.ceil(-1.5), -1.0);
+  }
+
+  public static void test_Math_floor() {
+    Assert.assertEquals(Math.floor(+0.0), +0.0);
+    Assert.assertEquals(Math.floor(-0.0), -0.0);
+    Assert.assertEquals(Math.floor(0.9), 0.0);
+    Assert.assertEquals(Math.floor(-0.1), -1.0);
+    Assert.assertEquals(Math.floor(2.5), 2.0);
+    Assert.assertEquals(Math.floor(-2.5), -3.0);
+    Assert.assertEquals(Math.floor(1e20), 1e20);
+    Assert.assertEquals(Math.floor(Double.NaN), Double.NaN);
+    Assert.assertEquals(Math.floor(Double.POSITIVE_INFINITY), Double.POSITIVE_INFINITY);
+    Assert.assertEquals(Math.floor(Double.NEGATIVE_INFINITY), Double.NEGATIVE_INFINITY);
+    Assert.assertEquals(StrictMath.floor(1.5), 1.0);
+  }
+
+  public static void test_Math_rint() {
+    Assert.assertEquals(Math.rint(+0.0), +0.0);
+    Assert.assertEquals(Math.rint(-0.0), -0.0);
+    Assert.assertEquals(Math.rint(0.5), 0.0);
+    Assert.assertEquals(Math.rint(-0.5), -0.0);
+    Assert.assertEquals(Math.rint(1.5), 2.0);
+    Assert.assertEquals(Math.rint(2.5), 2.0);
+    Assert.assertEquals(Math.rint(-2.5), -2.0);
+    Assert.assertEquals(Math.rint(2.6), 3.0);
+    Assert.assertEquals(Math.rint(1e20), 1e20);
+    Assert.assertEquals(Math.rint(Double.NaN), Double.NaN);
+    Assert.assertEquals(Math.rint(Double.POSITIVE_INFINITY), Double.POSITIVE_INFINITY);
+    Assert.assertEquals(Math.rint(Double.NEGATIVE_INFINITY), Double.NEGATIVE_INFINITY);
+    Assert.assertEquals(StrictMath.rint(3.5), 4.0);
+  }
+
+  public static void test_Math_round_F() {
+    Assert.assertEquals(Math.round(0.0f), 0);
+    Assert.assertEquals(Math.round(-0.0f), 0);
+    Assert.assertEquals(Math.round(0.5f), 1);
+    Assert.assertEquals(Math.round(-0.5f), 0);
+    Assert.assertEquals(Math.round(2.5f), 3);
+    Assert.assertEquals(Math.round(-2.5f), -2);
+    Assert.assertEquals(Math.round(-2.6f), -3);
+    Assert.assertEquals(Math.round(1e20f), Integer.MAX_VALUE);
+    Assert.assertEquals(Math.round(-1e20f), Integer.MIN_VALUE);
+    Assert.assertEquals(Math.round(Float.NaN), 0);
+    Assert.assertEquals(Math.round(Float.POSITIVE_INFINITY), Integer.MAX_VALUE);
+    Assert.assertEquals(Math.round(Float.NEGATIVE_INFINITY), Integer.MIN_VALUE);
+  }
+
+  public static void test_Math_round_D() {
+    Assert.assertEquals(Math.round(0.0), 0L);
+    Assert.assertEquals(Math.round(-0.0), 0L);
+    Assert.assertEquals(Math.round(0.5), 1L);
+    Assert.assertEquals(Math.round(-0.5), 0L);
+    Assert.assertEquals(Math.round(2.5), 3L);
+    Assert.assertEquals(Math.round(-2.5), -2L);
+    Assert.assertEquals(Math.round(-2.6), -3L);
+    Assert.assertEquals(Math.round(1e20), Long.MAX_VALUE);
+    Assert.assertEquals(Math.round(-1e20), Long.MIN_VALUE);
+    Assert.assertEquals(Math.round(Double.NaN), 0L);
+    Assert.assertEquals(Math.round(Double.POSITIVE_INFINITY), Long.MAX_VALUE);
+    Assert.assertEquals(Math.round(Double.NEGATIVE_INFINITY), Long.MIN_VALUE);
+  }
+
+  public static void test_Integer_numberOfLeadingZeros() {
+    Assert.assertEquals(Integer.numberOfLeadingZeros(0), 32);
+    Assert.assertEquals(Integer.numberOfLeadingZeros(1), 31);
+    Assert.assertEquals(Integer.numberOfLeadingZeros(0x8000), 16);
+    Assert.assertEquals(Integer.numberOfLeadingZeros(Integer.MAX_VALUE), 1);
+    Assert.assertEquals(Integer.numberOfLeadingZeros(Integer.MIN_VALUE), 0);
+    Assert.assertEquals(Integer.numberOfLeadingZeros(-1), 0);
+  }
+
+  public static void test_Long_numberOfLeadingZeros() {
+    Assert.assertEquals(Long.numberOfLeadingZeros(0L), 64);
+    Assert.assertEquals(Long.numberOfLeadingZeros(1L), 63);
+    Assert.assertEquals(Long.numberOfLeadingZeros(0xffffffffL), 32);
+    Assert.assertEquals(Long.numberOfLeadingZeros(0x100000000L), 31);
+    Assert.assertEquals(Long.numberOfLeadingZeros(Long.MAX_VALUE), 1);
+    Assert.assertEquals(Long.numberOfLeadingZeros(Long.MIN_VALUE), 0);
+    Assert.assertEquals(Long.numberOfLeadingZeros(-1L), 0);
+  }
+
+  public static void test_Integer_numberOfTrailingZeros() {
+    Assert.assertEquals(Integer.numberOfTrailingZeros(0), 32);
+    Assert.assertEquals(Integer.numberOfTrailingZeros(1), 0);
+    Assert.assertEquals(Integer.numberOfTrailingZeros(0x8000), 15);
+    Assert.assertEquals(Integer.numberOfTrailingZeros(Integer.MIN_VALUE), 31);
+    Assert.assertEquals(Integer.numberOfTrailingZeros(-1), 0);
+  }
+
+  public static void test_Long_numberOfTrailingZeros() {
+    Assert.assertEquals(Long.numberOfTrailingZeros(0L), 64);
+    Assert.assertEquals(Long.numberOfTrailingZeros(1L), 0);
+    Assert.assertEquals(Long.numberOfTrailingZeros(0x80000000L), 31);
+    Assert.assertEquals(Long.numberOfTrailingZeros(0x100000000L), 32);
+    Assert.assertEquals(Long.numberOfTrailingZeros(Long.MIN_VALUE), 63);
+    Assert.assertEquals(Long.numberOfTrailingZeros(-1L), 0);
+  }
+
+  public static void test_Integer_bitCount() {
+    Assert.assertEquals(Integer.bitCount(0), 0);
+    Assert.assertEquals(Integer.bitCount(1), 1);
+    Assert.assertEquals(Integer.bitCount(0x0f0f0f0f), 16);
+    Assert.assertEquals(Integer.bitCount(Integer.MAX_VALUE), 31);
+    Assert.assertEquals(Integer.bitCount(Integer.MIN_VALUE), 1);
+    Assert.assertEquals(Integer.bitCount(-1), 32);
+  }
+
+  public static void test_Long_bitCount() {
+    Assert.assertEquals(Long.bitCount(0L), 0);
+    Assert.assertEquals(Long.bitCount(1L), 1);
+    Assert.assertEquals(Long.bitCount(0x100000001L), 2);
+    Assert.assertEquals(Long.bitCount(0x0f0f0f0f0f0f0f0fL), 32);
+    Assert.assertEquals(Long.bitCount(Long.MIN_VALUE), 1);
+    Assert.assertEquals(Long.bitCount(-1L), 64);
+  }
+
+  public static void test_Integer_rotate() {
+    Assert.assertEquals(Integer.rotateRight(0x12345678, 0), 0x12345678);
+    Assert.assertEquals(Integer.rotateRight(0x12345678, 4), 0x81234567);
+    Assert.assertEquals(Integer.rotateRight(0x12345678, 32), 0x12345678);
+    Assert.assertEquals(Integer.rotateRight(0x12345678, 36), 0x81234567);
+    Assert.assertEquals(Integer.rotateRight(0x12345678, -4), 0x23456781);
+    Assert.assertEquals(Integer.rotateLeft(0x12345678, 0), 0x12345678);
+    Assert.assertEquals(Integer.rotateLeft(0x12345678, 4), 0x23456781);
+    Assert.assertEquals(Integer.rotateLeft(0x12345678, 31), 0x091a2b3c);
+    Assert.assertEquals(Integer.rotateLeft(0x12345678, -4), 0x81234567);
+    // Distances which aren't constants.
+    for (int i = -64; i <= 64; ++i) {
+      int expected = (0x12345678 >>> i) | (0x12345678 << -i);
+      Assert.assertEquals(Integer.rotateRight(0x12345678, i), expected);
+      Assert.assertEquals(Integer.rotateLeft(0x12345678, -i), expected);
+    }
+  }
+
+  public static void test_Long_rotate() {
+    Assert.assertEquals(Long.rotateRight(0x123456789abcdef0L, 0), 0x123456789abcdef0L);
+    Assert.assertEquals(Long.rotateRight(0x123456789abcdef0L, 4), 0x0123456789abcdefL);
+    Assert.assertEquals(Long.rotateRight(0x123456789abcdef0L, 32), 0x9abcdef012345678L);
+    Assert.assertEquals(Long.rotateRight(0x123456789abcdef0L, 64), 0x123456789abcdef0L);
+    Assert.assertEquals(Long.rotateLeft(0x123456789abcdef0L, 4), 0x23456789abcdef01L);
+    Assert.assertEquals(Long.rotateLeft(0x123456789abcdef0L, -4), 0x0123456789abcdefL);
+    for (int i = -128; i <= 128; ++i) {
+      long expected = (0x123456789abcdef0L >>> i) | (0x123456789abcdef0L << -i);
+      Assert.assertEquals(Long.rotateRight(0x123456789abcdef0L, i), expected);
+      Assert.assertEquals(Long.rotateLeft(0x123456789abcdef0L, -i), expected);
+    }
+  }
 }
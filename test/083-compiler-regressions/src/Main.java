@@ -52,6 +52,7 @@ public class Main {
         LVNTests.testNPE2();
         ZeroTests.longDivTest();
         ZeroTests.longModTest();
+        longDivRemTest();
         MirOpSelectTests.testIfCcz();
         ManyFloatArgs();
         atomicLong();
@@ -767,6 +768,74 @@ public class Main {
         }
     }
 
+    static long longDiv(long lhs, long rhs) {
+        return lhs / rhs;
+    }
+
+    static long longRem(long lhs, long rhs) {
+        return lhs % rhs;
+    }
+
+    // The quotient is a fresh wide value next to an int, which lets dx give it a register pair
+    // straddling the one of the dividend.
+    static long longDivMinusOneOverlap(int pad, long x) {
+        long q = x / -1L;
+        return q + pad;
+    }
+
+    static long longDivMinusOneOverlap(long x, int pad) {
+        int i = pad + 1;
+        long q = x / -1L;
+        return q - i + 1;
+    }
+
+    static void longDivRemTest() {
+        long[] values = {
+            0L, 5L, -5L, 2147483647L, -2147483648L, 2147483648L,
+            0x123456789abcdefL, -0x123456789abcdefL, Long.MIN_VALUE, Long.MAX_VALUE
+        };
+        boolean passes = true;
+        // Division by constants against division by a variable.
+        for (long x : values) {
+            passes &= (x / 1L) == longDiv(x, 1L) && (x % 1L) == longRem(x, 1L);
+            passes &= (x / -1L) == longDiv(x, -1L) && (x % -1L) == longRem(x, -1L);
+            passes &= (x / 2L) == longDiv(x, 2L) && (x % 2L) == longRem(x, 2L);
+            passes &= (x / 16L) == longDiv(x, 16L) && (x % 16L) == longRem(x, 16L);
+            passes &= (x / -16L) == longDiv(x, -16L) && (x % -16L) == longRem(x, -16L);
+            passes &= (x / 0x100000000L) == longDiv(x, 0x100000000L);
+            passes &= (x % 0x100000000L) == longRem(x, 0x100000000L);
+            passes &= (x / 0x10000000000L) == longDiv(x, 0x10000000000L);
+            passes &= (x % 0x10000000000L) == longRem(x, 0x10000000000L);
+            passes &= (x / -0x10000000000L) == longDiv(x, -0x10000000000L);
+            passes &= (x % -0x10000000000L) == longRem(x, -0x10000000000L);
+            passes &= (x / 0x4000000000000000L) == longDiv(x, 0x4000000000000000L);
+            passes &= (x % 0x4000000000000000L) == longRem(x, 0x4000000000000000L);
+            passes &= (x / 7L) == longDiv(x, 7L) && (x % 7L) == longRem(x, 7L);
+            passes &= (x / -1000L) == longDiv(x, -1000L) && (x % -1000L) == longRem(x, -1000L);
+            passes &= (x / Long.MIN_VALUE) == longDiv(x, Long.MIN_VALUE);
+            passes &= (x % Long.MIN_VALUE) == longRem(x, Long.MIN_VALUE);
+        }
+        // Operands which fit in 32 bits, and the one quotient which doesn't.
+        passes &= longDiv(-7L, 2L) == -3L && longRem(-7L, 2L) == -1L;
+        passes &= longDiv(100L, -7L) == -14L && longRem(-100L, 7L) == -2L;
+        passes &= longDiv(-2147483648L, -1L) == 2147483648L;
+        passes &= longRem(-2147483648L, -1L) == 0L;
+        passes &= longDivMinusOneOverlap(0, -2147483648L) == 2147483648L;
+        passes &= longDivMinusOneOverlap(-2147483648L, 0) == 2147483648L;
+        passes &= longDivMinusOneOverlap(1, 0x123456789abcdefL) == -0x123456789abcdeeL;
+        passes &= longDivMinusOneOverlap(Long.MIN_VALUE, 0) == Long.MIN_VALUE;
+        passes &= longDiv(Long.MIN_VALUE, -1L) == Long.MIN_VALUE;
+        passes &= longDiv(0x123456789abcdefL, 16L) == 0x123456789abcdeL;
+        passes &= longRem(-0x123456789abcdefL, 16L) == -15L;
+        passes &= (Long.MIN_VALUE / 0x10000000000L) == -0x800000L;
+        passes &= (-0x123456789abcdefL % 0x100000000L) == -0x89abcdefL;
+        if (passes) {
+            System.out.println("longDivRemTest passes");
+        } else {
+            System.out.println("longDivRemTest fails");
+        }
+    }
+
     static void constantPropagationTest() {
         int i = 1;
         int t = 1;
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Loop and call heavy code whose cost is dominated by the suspend checks on the
+ * back edges and the stack overflow checks in the prologues.
+ */
+public class Main {
+    private static final int ITERATIONS = 10;
+
+    public static void main(String[] args) throws Exception {
+        boolean timing = (args.length >= 1) && args[0].equals("--timing");
+
+        // Warm up and check the results.
+        System.out.println("loop: " + loop(10000000));
+        System.out.println("nested loops: " + nestedLoops(1000));
+        System.out.println("calls: " + fib(33));
+
+        long time0 = System.nanoTime();
+        for (int i = 0; i < ITERATIONS; i++) {
+            loop(10000000);
+        }
+        long time1 = System.nanoTime();
+        for (int i = 0; i < ITERATIONS; i++) {
+            nestedLoops(1000);
+        }
+        long time2 = System.nanoTime();
+        for (int i = 0; i < ITERATIONS; i++) {
+            fib(33);
+        }
+        long time3 = System.nanoTime();
+
+        suspendSpinningThread();
+        stackOverflow();
+
+        if (timing) {
+            System.out.printf("loop: %.3g msec per iteration\n",
+                              (time1 - time0) / (double) ITERATIONS / 1000000);
+            System.out.printf("nested loops: %.3g msec per iteration\n",
+                              (time2 - time1) / (double) ITERATIONS / 1000000);
+            System.out.printf("calls: %.3g msec per iteration\n",
+                              (time3 - time2) / (double) ITERATIONS / 1000000);
+        }
+    }
+
+    static int loop(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum = sum * 31 + i;
+        }
+        return sum;
+    }
+
+    static int nestedLoops(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                sum += i * j ^ j;
+            }
+        }
+        return sum;
+    }
+
+    // Not a leaf, every call checks for a stack overflow.
+    static int fib(int n) {
+        return (n < 2) ? n : fib(n - 1) + fib(n - 2);
+    }
+
+    static class Spinner extends Thread {
+        volatile boolean stop = false;
+        int count = 0;
+
+        public void run() {
+            while (!stop) {
+                count++;
+            }
+        }
+    }
+
+    // A collection needs to suspend a thread that only runs a loop.
+    static void suspendSpinningThread() throws Exception {
+        Spinner spinner = new Spinner();
+        spinner.start();
+        for (int i = 0; i < ITERATIONS; i++) {
+            Runtime.getRuntime().gc();
+        }
+        spinner.stop = true;
+        spinner.join();
+        System.out.println("suspended spinning thread");
+    }
+
+    static int recurse(int depth) {
+        return recurse(depth + 1) + 1;
+    }
+
+    static void stackOverflow() {
+        try {
+            recurse(0);
+        } catch (StackOverflowError expected) {
+            System.out.println("caught StackOverflowError");
+        }
+    }
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Exercises the instructions of the assembly interpreter. The leaf methods only use instructions
+ * it has a handler for, the callers are left to the C++ interpreter at their first invoke.
+ */
+public class Main {
+    public static void main(String[] args) throws Exception {
+        int a = 0x12345678;
+        int b = -7;
+        System.out.println("add: " + add(a, b) + " " + add(Integer.MAX_VALUE, 1));
+        System.out.println("sub: " + sub(b, a));
+        System.out.println("mul: " + mul(a, 31));
+        System.out.println("and/or/xor: " + and(a, b) + " " + or(a, b) + " " + xor(a, b));
+        System.out.println("shifts: " + shl(a, 35) + " " + shr(b, 35) + " " + ushr(b, 35));
+        System.out.println("lit8: " + addLit8(a) + " " + rsubLit8(a) + " " + mulLit8(b) + " " +
+                           ushrLit8(b) + " " + shlLit8(a));
+        System.out.println("lit16: " + addLit16(a) + " " + rsubLit16(b) + " " + xorLit16(a));
+        System.out.println("accumulate: " + accumulate(a, b));
+        System.out.println("unary: " + neg(a) + " " + neg(Integer.MIN_VALUE) + " " + not(b));
+        System.out.println("conversions: " + toByte(0x1ff) + " " + (int) toChar(-1) + " " +
+                           toShort(0x18000) + " " + toLong(b) + " " + toInt(0x123456789L));
+        System.out.println("constants: " + const4() + " " + const16() + " " + constHigh16() + " " +
+                           const32());
+        System.out.println("wide constants: " + constWide16() + " " + constWide32() + " " +
+                           constWideHigh16() + " " + constWide());
+        long x = 0x00000000ffffffffL;
+        long y = 0x0123456789abcdefL;
+        System.out.println("long ops: " + addLong(x, 1) + " " + subLong(0, x) + " " +
+                           andLong(x, y) + " " + orLong(x, y) + " " + xorLong(x, y));
+        System.out.println("compare: " + compare(1, 2) + " " + compare(2, 2) + " " +
+                           compare(-1, -2));
+        System.out.println("compare zero: " + compareZero(-5) + " " + compareZero(0) + " " +
+                           compareZero(5));
+        System.out.println("loop: " + sumTo(100000));
+        System.out.println("nested loops: " + nestedLoops(300));
+        System.out.println("fibonacci: " + fibonacci(90));
+        Object o = new Object();
+        System.out.println("move object: " + (select(o, null, 1) == o) + " " +
+                           (select(null, o, 0) == o));
+        System.out.println("resumed: " + resume(1000));
+
+        // A thread spinning in a loop of the assembly interpreter must still get suspended.
+        Spinner spinner = new Spinner();
+        spinner.start();
+        for (int i = 0; i < 10; ++i) {
+            Runtime.getRuntime().gc();
+        }
+        spinner.join();
+        System.out.println("spin: " + spinner.result);
+    }
+
+    static class Spinner extends Thread {
+        int result;
+
+        public void run() {
+            result = spin(10000000);
+        }
+    }
+
+    static int add(int a, int b) {
+        return a + b;
+    }
+
+    static int sub(int a, int b) {
+        return a - b;
+    }
+
+    static int mul(int a, int b) {
+        return a * b;
+    }
+
+    static int and(int a, int b) {
+        return a & b;
+    }
+
+    static int or(int a, int b) {
+        return a | b;
+    }
+
+    static int xor(int a, int b) {
+        return a ^ b;
+    }
+
+    static int shl(int a, int b) {
+        return a << b;
+    }
+
+    static int shr(int a, int b) {
+        return a >> b;
+    }
+
+    static int ushr(int a, int b) {
+        return a >>> b;
+    }
+
+    static int addLit8(int a) {
+        return a + 127;
+    }
+
+    static int rsubLit8(int a) {
+        return 100 - a;
+    }
+
+    static int mulLit8(int a) {
+        return a * -128;
+    }
+
+    static int ushrLit8(int a) {
+        return a >>> 28;
+    }
+
+    static int shlLit8(int a) {
+        return a << 33;
+    }
+
+    static int addLit16(int a) {
+        return a + 32767;
+    }
+
+    static int rsubLit16(int a) {
+        return 1000 - a;
+    }
+
+    static int xorLit16(int a) {
+        return a ^ 0x7fff;
+    }
+
+    // Updates in place, which dx turns into the 2addr forms.
+    static int accumulate(int a, int b) {
+        a += b;
+        a *= b;
+        a -= b;
+        a <<= b;
+        a ^= b;
+        a >>= 3;
+        a |= b;
+        a >>>= 1;
+        a &= b;
+        return a;
+    }
+
+    static int neg(int a) {
+        return -a;
+    }
+
+    static int not(int a) {
+        return ~a;
+    }
+
+    static byte toByte(int a) {
+        return (byte) a;
+    }
+
+    static char toChar(int a) {
+        return (char) a;
+    }
+
+    static short toShort(int a) {
+        return (short) a;
+    }
+
+    static long toLong(int a) {
+        return a;
+    }
+
+    static int toInt(long a) {
+        return (int) a;
+    }
+
+    static int const4() {
+        return -3;
+    }
+
+    static int const16() {
+        return -1000;
+    }
+
+    static int constHigh16() {
+        return 0x7fff0000;
+    }
+
+    static int const32() {
+        return 0x12345678;
+    }
+
+    static long constWide16() {
+        return -5L;
+    }
+
+    static long constWide32() {
+        return -100000L;
+    }
+
+    static long constWideHigh16() {
+        return 0x1234000000000000L;
+    }
+
+    static long constWide() {
+        return 0x123456789abcdef0L;
+    }
+
+    static long addLong(long a, long b) {
+        return a + b;
+    }
+
+    static long subLong(long a, long b) {
+        return a - b;
+    }
+
+    static long andLong(long a, long b) {
+        return a & b;
+    }
+
+    static long orLong(long a, long b) {
+        return a | b;
+    }
+
+    static long xorLong(long a, long b) {
+        return a ^ b;
+    }
+
+    static int compare(int a, int b) {
+        int result = 0;
+        if (a == b) {
+            result |= 1;
+        }
+        if (a != b) {
+            result |= 2;
+        }
+        if (a < b) {
+            result |= 4;
+        }
+        if (a >= b) {
+            result |= 8;
+        }
+        if (a > b) {
+            result |= 16;
+        }
+        if (a <= b) {
+            result |= 32;
+        }
+        return result;
+    }
+
+    static int compareZero(int a) {
+        int result = 0;
+        if (a == 0) {
+            result |= 1;
+        }
+        if (a != 0) {
+            result |= 2;
+        }
+        if (a < 0) {
+            result |= 4;
+        }
+        if (a >= 0) {
+            result |= 8;
+        }
+        if (a > 0) {
+            result |= 16;
+        }
+        if (a <= 0) {
+            result |= 32;
+        }
+        return result;
+    }
+
+    static int sumTo(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; ++i) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static int nestedLoops(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                sum += i * j ^ (i - j);
+            }
+        }
+        return sum;
+    }
+
+    static long fibonacci(int n) {
+        long previous = 0;
+        long current = 1;
+        for (int i = 1; i < n; ++i) {
+            long next = previous + current;
+            previous = current;
+            current = next;
+        }
+        return current;
+    }
+
+    static Object select(Object a, Object b, int which) {
+        Object result = b;
+        if (which != 0) {
+            result = a;
+        }
+        return result;
+    }
+
+    // Falls back to the C++ interpreter in the middle of the method.
+    static int resume(int n) {
+        int sum = sumTo(n);
+        for (int i = 0; i < n; ++i) {
+            sum -= i;
+        }
+        return sum;
+    }
+
+    static int spin(int n) {
+        int result = 0;
+        for (int i = 0; i < n; ++i) {
+            result = result * 31 + i;
+        }
+        return result;
+    }
+}
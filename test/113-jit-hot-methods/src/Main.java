@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Runs the same rounds of hot methods several times. The first round is interpreted, the methods
+ * are compiled by the jit in the background while the later ones run, so all rounds must print
+ * the same results.
+ */
+public class Main {
+    static class Counter {
+        long count;
+
+        void add(int value) {
+            count += value;
+        }
+    }
+
+    public static void main(String[] args) throws Exception {
+        for (int round = 0; round < 3; round++) {
+            long sum = 0;
+            for (int i = 0; i < 2000; i++) {
+                sum += sumTo(i % 100);
+            }
+            System.out.println("sum: " + sum);
+
+            int caught = 0;
+            long quotients = 0;
+            for (int i = 0; i < 2000; i++) {
+                try {
+                    quotients += divide(i, i % 10);
+                } catch (ArithmeticException e) {
+                    caught++;
+                }
+            }
+            System.out.println("divide: " + quotients + " caught " + caught);
+
+            Counter counter = new Counter();
+            for (int i = 0; i < 2000; i++) {
+                counter.add(i);
+            }
+            System.out.println("counter: " + counter.count);
+
+            System.out.println("allocate: " + allocate(5000));
+
+            // Lets the compiler thread catch up before the next round.
+            Thread.sleep(200);
+        }
+    }
+
+    static int sumTo(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    static int divide(int a, int b) {
+        return a / b;
+    }
+
+    // Keeps references in the frame across the collections.
+    static int allocate(int n) {
+        Object[] objects = new Object[16];
+        for (int i = 0; i < n; i++) {
+            objects[i & 15] = new int[i & 63];
+            if ((i & 1023) == 0) {
+                Runtime.getRuntime().gc();
+            }
+        }
+        int live = 0;
+        for (Object o : objects) {
+            live += ((int[]) o).length;
+        }
+        return live;
+    }
+}
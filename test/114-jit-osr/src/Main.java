@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Each method is invoked once and loops long enough for the jit to compile it in the background,
+ * so the loop starts in the interpreter and finishes in the compiled code.
+ */
+public class Main {
+    static final int ITERATIONS = 2000000;
+
+    static class Node {
+        final int value;
+        final Node next;
+
+        Node(int value, Node next) {
+            this.value = value;
+            this.next = next;
+        }
+    }
+
+    public static void main(String[] args) {
+        System.out.println("ints: " + loopInts(ITERATIONS));
+        System.out.println("longs: " + loopLongs(ITERATIONS));
+        System.out.println("doubles: " + loopDoubles(ITERATIONS));
+        System.out.println("floats: " + loopFloats(ITERATIONS));
+        System.out.println("nodes: " + loopNodes(ITERATIONS));
+        System.out.println("nested: " + loopNested(2000));
+        try {
+            loopThrows(ITERATIONS);
+        } catch (ArithmeticException e) {
+            System.out.println("caught " + e.getClass().getName());
+        }
+        System.out.println("caught in loop: " + loopCatches(ITERATIONS));
+        System.out.println("this: " + new Main().loopFields(ITERATIONS));
+    }
+
+    int field = 7;
+
+    static int loopInts(int n) {
+        int a = 1;
+        int b = 2;
+        for (int i = 0; i < n; i++) {
+            int t = a ^ (b << 1);
+            a = b;
+            b = t + i;
+        }
+        return a + b;
+    }
+
+    static long loopLongs(int n) {
+        long sum = 0x100000000L;
+        for (int i = 0; i < n; i++) {
+            sum += (long) i * i;
+        }
+        return sum;
+    }
+
+    static double loopDoubles(int n) {
+        double sum = 0.5;
+        for (int i = 0; i < n; i++) {
+            sum += i * 0.25;
+        }
+        return sum;
+    }
+
+    static float loopFloats(int n) {
+        float sum = 0.0f;
+        for (int i = 0; i < n; i++) {
+            sum += (i & 7) * 0.5f;
+        }
+        return sum;
+    }
+
+    static int loopNodes(int n) {
+        Node head = null;
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            head = new Node(i & 1023, (i & 63) == 0 ? null : head);
+            sum += head.value;
+        }
+        for (Node node = head; node != null; node = node.next) {
+            sum -= node.value;
+        }
+        return sum;
+    }
+
+    static long loopNested(int n) {
+        long sum = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                sum += i ^ j;
+            }
+        }
+        return sum;
+    }
+
+    static int loopThrows(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += 1000 / (n - 1 - i);
+        }
+        return sum;
+    }
+
+    static int loopCatches(int n) {
+        int caught = 0;
+        for (int i = 0; i < n; i++) {
+            try {
+                caught += 1 / (i & 1023);
+            } catch (ArithmeticException e) {
+                caught += 1000;
+            }
+        }
+        return caught;
+    }
+
+    long loopFields(int n) {
+        long sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += field + i;
+        }
+        return sum;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Exercises the invoke-super, sget, sput and const-string instructions that DEX-to-DEX
+ * rewrites into their quick forms.
+ */
+public class Main {
+    static int counter = 1;
+    static long total = 0x100000000L;
+    static Object last = "none";
+
+    static class Base {
+        String name() {
+            return "base";
+        }
+
+        long sum(int a, int b, int c, int d, int e, int f) {
+            return a + b + c + d + e + f;
+        }
+    }
+
+    static class Derived extends Base {
+        String name() {
+            return "derived of " + super.name();
+        }
+
+        long sum(int a, int b, int c, int d, int e, int f) {
+            return 2 * super.sum(a, b, c, d, e, f);
+        }
+    }
+
+    static class Lazy {
+        static int value;
+
+        static {
+            System.out.println("Lazy initialized");
+            value = 42;
+        }
+    }
+
+    public static void main(String[] args) {
+        Derived derived = new Derived();
+        System.out.println(derived.name());
+        System.out.println("sum: " + derived.sum(1, 2, 3, 4, 5, 6));
+
+        for (int i = 0; i < 10; i++) {
+            counter += i;
+            total += counter;
+            last = Integer.valueOf(counter);
+        }
+        System.out.println("counter: " + counter);
+        System.out.println("total: " + total);
+        System.out.println("last: " + last);
+
+        // Another class's statics still go through the initialization check.
+        System.out.println("before Lazy");
+        System.out.println("Lazy.value: " + Lazy.value);
+        Lazy.value++;
+        System.out.println("Lazy.value: " + Lazy.value);
+
+        String a = constant();
+        String b = constant();
+        System.out.println("same string: " + (a == b) + " " + (a == "quickened".intern()));
+    }
+
+    static String constant() {
+        return "quickened";
+    }
+}
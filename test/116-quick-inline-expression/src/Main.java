@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+  public static void expectEquals(int expected, int value) {
+    if (expected != value) {
+      throw new Error("Expected: " + expected + ", found: " + value);
+    }
+  }
+
+  static int square(int a) {
+    return a * a;
+  }
+
+  static int average(int a, int b) {
+    return (a + b) >>> 1;
+  }
+
+  static int mix(int a, int b, int c) {
+    return ((a << 3) - b) ^ (c & 0xff);
+  }
+
+  static int toByte(int a) {
+    return (byte) -a;
+  }
+
+  static boolean isOdd(int a) {
+    return (a & 1) != 0;
+  }
+
+  static int divide(int a, int b) {
+    // Division may throw, so this one must stay a call.
+    return a / b + 1;
+  }
+
+  public static void main(String[] args) {
+    int a = 7;
+    int b = 12;
+    expectEquals(49, square(a));
+    expectEquals(9, average(a, b));
+    expectEquals(32, mix(a, b, b));
+    expectEquals(-7, toByte(a));
+    expectEquals(1, isOdd(a) ? 1 : 0);
+
+    // The result replaces an argument that the inlined code reads again.
+    a = mix(a, b, a);
+    expectEquals(43, a);
+    b = average(b, b);
+    expectEquals(12, b);
+    a = square(a);
+    expectEquals(1849, a);
+
+    // Unused results.
+    square(a);
+    mix(a, b, a);
+
+    // More inlining candidates than the inlining budget of main() allows.
+    int sum = 0;
+    for (int i = 0; i < 10; ++i) {
+      sum += mix(i, average(i, square(i)), toByte(i)) + average(square(i), mix(i, i, i));
+    }
+    expectEquals(2399, sum);
+
+    expectEquals(4, divide(b, 4));
+    try {
+      divide(a, 0);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException e) {
+      // Expected.
+    }
+    System.out.println("Done");
+  }
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Micro-kernels whose cost is dominated by one kind of operation. Each kernel
+ * runs a number of operations and returns a checksum, which is printed to check
+ * the results. With --timing, every kernel is timed over several samples and
+ * its nanoseconds per operation are printed as key=value pairs.
+ */
+public class Main {
+    private static final int OPERATIONS = 100000;
+    private static final int SAMPLES = 10;
+
+    abstract static class Kernel {
+        final String name;
+
+        Kernel(String name) {
+            this.name = name;
+        }
+
+        // Runs n operations and returns a checksum of their results.
+        abstract int run(int n);
+    }
+
+    public static void main(String[] args) {
+        boolean timing = (args.length >= 1) && args[0].equals("--timing");
+
+        Kernel[] kernels = {
+            new FieldAccess(),
+            new VirtualCalls(),
+            new InterfaceCalls(),
+            new ArrayLoop(),
+            new StringOps(),
+            new Allocation(),
+            new Exceptions(),
+        };
+
+        for (Kernel kernel : kernels) {
+            // Also warms the kernel up.
+            System.out.println(kernel.name + ": " + kernel.run(OPERATIONS));
+        }
+
+        if (timing) {
+            for (Kernel kernel : kernels) {
+                time(kernel);
+            }
+        }
+    }
+
+    private static void time(Kernel kernel) {
+        double[] nsPerOp = new double[SAMPLES];
+        double sum = 0;
+        for (int i = 0; i < SAMPLES; i++) {
+            long start = System.nanoTime();
+            kernel.run(OPERATIONS);
+            nsPerOp[i] = (System.nanoTime() - start) / (double) OPERATIONS;
+            sum += nsPerOp[i];
+        }
+        double mean = sum / SAMPLES;
+        double squares = 0;
+        for (int i = 0; i < SAMPLES; i++) {
+            squares += (nsPerOp[i] - mean) * (nsPerOp[i] - mean);
+        }
+        double stddev = Math.sqrt(squares / (SAMPLES - 1));
+        System.out.printf("kernel=%s ns_per_op=%.2f stddev=%.2f samples=%d\n",
+                          kernel.name, mean, stddev, SAMPLES);
+    }
+
+    static class FieldAccess extends Kernel {
+        int intField;
+        long longField;
+        Object objectField;
+        static int staticField;
+
+        FieldAccess() {
+            super("field_access");
+        }
+
+        int run(int n) {
+            intField = 0;
+            longField = 0;
+            staticField = 0;
+            for (int i = 0; i < n; i++) {
+                intField += i;
+                longField += intField;
+                staticField ^= intField;
+                objectField = (i & 1) == 0 ? this : null;
+            }
+            return intField + (int) longField + staticField + (objectField == null ? 1 : 0);
+        }
+    }
+
+    static class Base {
+        int value(int i) {
+            return i;
+        }
+    }
+
+    static class Doubler extends Base {
+        int value(int i) {
+            return i * 2;
+        }
+    }
+
+    static class Negater extends Base {
+        int value(int i) {
+            return -i;
+        }
+    }
+
+    static class VirtualCalls extends Kernel {
+        // Polymorphic call sites, so that the calls are not devirtualized.
+        private final Base[] receivers = { new Base(), new Doubler(), new Negater() };
+
+        VirtualCalls() {
+            super("virtual_calls");
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += receivers[i % 3].value(i);
+            }
+            return sum;
+        }
+    }
+
+    interface Hasher {
+        int hash(int i);
+    }
+
+    static class ShiftHasher implements Hasher {
+        public int hash(int i) {
+            return i ^ (i >>> 7);
+        }
+    }
+
+    static class MultiplyHasher implements Hasher {
+        public int hash(int i) {
+            return i * 31;
+        }
+    }
+
+    static class InterfaceCalls extends Kernel {
+        private final Hasher[] hashers = { new ShiftHasher(), new MultiplyHasher() };
+
+        InterfaceCalls() {
+            super("interface_calls");
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += hashers[i & 1].hash(i);
+            }
+            return sum;
+        }
+    }
+
+    static class ArrayLoop extends Kernel {
+        private final int[] array = new int[1024];
+
+        ArrayLoop() {
+            super("array_loop");
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                int index = i & (array.length - 1);
+                array[index] = array[index] + i;
+                sum += array[index];
+            }
+            return sum;
+        }
+    }
+
+    static class StringOps extends Kernel {
+        private final String[] words = { "alpha", "beta", "gamma", "delta" };
+
+        StringOps() {
+            super("string_ops");
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                String word = words[i & 3];
+                sum += word.length() + word.charAt(i % word.length());
+                if (word.equals(words[(i + 1) & 3])) {
+                    sum++;
+                }
+                sum += word.indexOf('a') + word.compareTo(words[0]);
+            }
+            return sum;
+        }
+    }
+
+    static class Point {
+        final int x;
+        final int y;
+
+        Point(int x, int y) {
+            this.x = x;
+            this.y = y;
+        }
+    }
+
+    static class Allocation extends Kernel {
+        Allocation() {
+            super("allocation");
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                Point point = new Point(i, -i);
+                int[] array = new int[i & 15];
+                sum += point.x + point.y + array.length;
+            }
+            return sum;
+        }
+    }
+
+    static class Exceptions extends Kernel {
+        private static final int THROW_INTERVAL = 16;
+
+        Exceptions() {
+            super("exceptions");
+        }
+
+        private static int mayThrow(int i) {
+            if (i % THROW_INTERVAL == 0) {
+                throw new IllegalArgumentException();
+            }
+            return i;
+        }
+
+        int run(int n) {
+            int sum = 0;
+            for (int i = 0; i < n; i++) {
+                try {
+                    sum += mayThrow(i);
+                } catch (IllegalArgumentException e) {
+                    sum--;
+                }
+            }
+            return sum;
+        }
+    }
+}
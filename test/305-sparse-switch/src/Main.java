@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Test the sparse-switch lowerings. Each switch returns the position of the
+ * matching key in its key array plus one, or zero if no key matches. The keys
+ * of dense() fill a quarter of their range, which javac and dx still compile
+ * to a sparse-switch.
+ */
+public class Main {
+    static final int[] CHAIN_KEYS = { -5, 7, 1000 };
+    static final int[] DENSE_KEYS = { 0, 4, 9, 13, 18, 22, 27, 31 };
+    static final int[] SEARCH_KEYS = {
+        Integer.MIN_VALUE, -100000, -77, -1, 0, 3, 42, 999, 4096, 65537,
+        0x12345678, Integer.MAX_VALUE - 1, Integer.MAX_VALUE
+    };
+
+    static int chain(int i) {
+        switch (i) {
+            case -5: return 1;
+            case 7: return 2;
+            case 1000: return 3;
+            default: return 0;
+        }
+    }
+
+    static int dense(int i) {
+        switch (i) {
+            case 0: return 1;
+            case 4: return 2;
+            case 9: return 3;
+            case 13: return 4;
+            case 18: return 5;
+            case 22: return 6;
+            case 27: return 7;
+            case 31: return 8;
+            default: return 0;
+        }
+    }
+
+    static int search(int i) {
+        switch (i) {
+            case Integer.MIN_VALUE: return 1;
+            case -100000: return 2;
+            case -77: return 3;
+            case -1: return 4;
+            case 0: return 5;
+            case 3: return 6;
+            case 42: return 7;
+            case 999: return 8;
+            case 4096: return 9;
+            case 65537: return 10;
+            case 0x12345678: return 11;
+            case Integer.MAX_VALUE - 1: return 12;
+            case Integer.MAX_VALUE: return 13;
+            default: return 0;
+        }
+    }
+
+    static int expected(int[] keys, int i) {
+        for (int k = 0; k < keys.length; k++) {
+            if (keys[k] == i) {
+                return k + 1;
+            }
+        }
+        return 0;
+    }
+
+    static int call(int which, int i) {
+        switch (which) {
+            case 0: return chain(i);
+            case 1: return dense(i);
+            default: return search(i);
+        }
+    }
+
+    static void check(String name, int which, int[] keys) {
+        int[] extremes = { Integer.MIN_VALUE, Integer.MIN_VALUE + 1, Integer.MAX_VALUE };
+        boolean ok = true;
+        for (int key : keys) {
+            for (int delta = -1; delta <= 1; delta++) {
+                int i = key + delta;
+                if (call(which, i) != expected(keys, i)) {
+                    System.out.println(name + ": wrong result for " + i);
+                    ok = false;
+                }
+            }
+        }
+        for (int i : extremes) {
+            if (call(which, i) != expected(keys, i)) {
+                System.out.println(name + ": wrong result for " + i);
+                ok = false;
+            }
+        }
+        if (ok) {
+            System.out.println(name + ": OK");
+        }
+    }
+
+    public static void main(String[] args) {
+        check("chain", 0, CHAIN_KEYS);
+        check("dense", 1, DENSE_KEYS);
+        check("search", 2, SEARCH_KEYS);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.ref.WeakReference;
+import java.lang.reflect.Constructor;
+import java.lang.reflect.Method;
+
+/**
+ * Class unloading tests: the classes of a class loader which is no longer reachable are unloaded
+ * with it, those of a class loader reachable through an instance of its classes are not.
+ */
+public class Main {
+    private static final String CLASS_PATH = System.getenv("DEX_LOCATION") +
+            "/306-class-unloading-ex.jar";
+    private static final String ODEX_DIR = System.getenv("DEX_LOCATION");
+
+    public static void main(String[] args) throws Exception {
+        testUnreachableLoader();
+        testLoaderReachableFromInstance();
+        testReload();
+        System.out.println("done");
+    }
+
+    private static void testUnreachableLoader() throws Exception {
+        WeakReference<Class> klass = loadAndRun("first");
+        collect();
+        System.out.println("class collected: " + (klass.get() == null));
+    }
+
+    private static void testLoaderReachableFromInstance() throws Exception {
+        Object instance = newInstance("second");
+        collect();
+        // The instance keeps its class, and the class its class loader.
+        System.out.println(describe(instance));
+        WeakReference<Class> klass = weakClassOf(instance);
+        instance = null;
+        collect();
+        System.out.println("class collected: " + (klass.get() == null));
+    }
+
+    private static void testReload() throws Exception {
+        // A new class loader defines the class again, from the dex file of the unloaded one.
+        for (int i = 0; i < 3; ++i) {
+            System.out.println(describe(newInstance("reloaded")));
+            collect();
+        }
+    }
+
+    /** Loads the class in a frame of its own, so no dead register holds on to it. */
+    private static WeakReference<Class> loadAndRun(String name) throws Exception {
+        Object instance = newInstance(name);
+        System.out.println(describe(instance));
+        return weakClassOf(instance);
+    }
+
+    private static WeakReference<Class> weakClassOf(Object instance) {
+        return new WeakReference<Class>(instance.getClass());
+    }
+
+    private static Object newInstance(String name) throws Exception {
+        Class klass = getDexClassLoader().loadClass("Unloadable");
+        return klass.getConstructor(String.class).newInstance(name);
+    }
+
+    private static String describe(Object instance) throws Exception {
+        Method describe = instance.getClass().getMethod("describe");
+        return (String) describe.invoke(instance);
+    }
+
+    private static void collect() {
+        for (int i = 0; i < 3; ++i) {
+            Runtime.getRuntime().gc();
+            System.runFinalization();
+        }
+    }
+
+    /*
+     * Create an instance of DexClassLoader.  The test harness doesn't
+     * have visibility into dalvik.system.*, so we do this through
+     * reflection.
+     */
+    private static ClassLoader getDexClassLoader() throws Exception {
+        ClassLoader myLoader = Main.class.getClassLoader();
+        Class dclClass = myLoader.loadClass("dalvik.system.DexClassLoader");
+        Constructor ctor = dclClass.getConstructor(String.class, String.class,
+                String.class, ClassLoader.class);
+        return (ClassLoader) ctor.newInstance(CLASS_PATH, ODEX_DIR, null, myLoader);
+    }
+}
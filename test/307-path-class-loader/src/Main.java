@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.reflect.Constructor;
+
+/**
+ * Class lookups through chains of PathClassLoaders and DexClassLoaders, which the runtime walks
+ * natively, and through class loaders which override findClass, which it leaves to Java.
+ */
+public class Main {
+    private static final String CLASS_PATH = System.getenv("DEX_LOCATION") +
+            "/307-path-class-loader-ex.jar";
+    private static final String ODEX_DIR = System.getenv("DEX_LOCATION");
+
+    public static void main(String[] args) throws Exception {
+        ClassLoader loader = newDexClassLoader(Main.class.getClassLoader());
+        // Child is found in the dex file of loader, Parent and String through its parents.
+        Class child = loader.loadClass("Child");
+        System.out.println(child.newInstance());
+        System.out.println(child.getClassLoader() == loader);
+        System.out.println(child.getSuperclass().getClassLoader() == Main.class.getClassLoader());
+        System.out.println(Class.forName("java.lang.String", false, loader) == String.class);
+        // Loaded once per class loader.
+        System.out.println(Class.forName("Child", false, loader) == child);
+
+        try {
+            Class.forName("DoesNotExist", false, loader);
+            System.out.println("found DoesNotExist");
+        } catch (ClassNotFoundException expected) {
+            System.out.println("ClassNotFoundException");
+        }
+
+        // The chain of a class loader which overrides findClass isn't walked natively.
+        ClassLoader counting = new CountingClassLoader(loader);
+        System.out.println(Class.forName("Child", false, counting) == child);
+        try {
+            Class.forName("DoesNotExist", false, counting);
+        } catch (ClassNotFoundException expected) {
+            System.out.println("ClassNotFoundException");
+        }
+        System.out.println(CountingClassLoader.finds);
+
+        // A DexClassLoader whose parent is not understood either.
+        ClassLoader below = newDexClassLoader(counting);
+        System.out.println(below.loadClass("Child") == child);
+        System.out.println(CountingClassLoader.finds);
+        System.out.println("done");
+    }
+
+    static class CountingClassLoader extends ClassLoader {
+        static int finds;
+
+        CountingClassLoader(ClassLoader parent) {
+            super(parent);
+        }
+
+        protected Class<?> findClass(String name) throws ClassNotFoundException {
+            finds++;
+            throw new ClassNotFoundException(name);
+        }
+    }
+
+    /*
+     * Create an instance of DexClassLoader.  The test harness doesn't
+     * have visibility into dalvik.system.*, so we do this through
+     * reflection.
+     */
+    private static ClassLoader newDexClassLoader(ClassLoader parent) throws Exception {
+        Class dclClass = Main.class.getClassLoader().loadClass("dalvik.system.DexClassLoader");
+        Constructor ctor = dclClass.getConstructor(String.class, String.class,
+                String.class, ClassLoader.class);
+        return (ClassLoader) ctor.newInstance(CLASS_PATH, ODEX_DIR, null, parent);
+    }
+}
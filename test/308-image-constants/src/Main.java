@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.io.File;
+
+/**
+ * Reads static final fields which the class initializers of the boot image
+ * compute, so that javac can't inline them, and string literals which the
+ * boot image interns.
+ */
+public class Main {
+    public static void main(String[] args) {
+        System.out.println("separator: " + File.separator);
+        System.out.println("separatorChar: " + File.separatorChar);
+        System.out.println("pathSeparator: " + File.pathSeparator);
+        System.out.println("Integer cache: " + (Integer.valueOf(127) == Integer.valueOf(127)));
+        System.out.println("Long.SIZE: " + Long.SIZE);
+        System.out.println("literal identity: " + (literal() == literal()));
+        String built = new StringBuilder("java.lang.").append("Object").toString();
+        System.out.println("intern identity: " + (built.intern() == literal()));
+    }
+
+    static String literal() {
+        return "java.lang.Object";
+    }
+}
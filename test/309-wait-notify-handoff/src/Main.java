@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.ArrayList;
+import java.util.LinkedList;
+
+public class Main {
+    static final int NUM_WAITERS = 8;
+
+    static final Object lock = new Object();
+    static int waiting;
+    static int woken;
+    static boolean go;
+
+    public static void main(String[] args) throws Exception {
+        testNotifyAll();
+        testNotify();
+        testQueue();
+        testTimedWait();
+        testInterrupt();
+    }
+
+    static class Waiter extends Thread {
+        public void run() {
+            synchronized (lock) {
+                ++waiting;
+                lock.notifyAll();  // Wakes the main thread waiting for the waiters.
+                while (!go) {
+                    try {
+                        lock.wait();
+                    } catch (InterruptedException e) {
+                        throw new AssertionError(e);
+                    }
+                }
+                ++woken;
+            }
+        }
+    }
+
+    static ArrayList<Thread> startWaiters(int count) throws Exception {
+        ArrayList<Thread> threads = new ArrayList<Thread>();
+        synchronized (lock) {
+            waiting = 0;
+            woken = 0;
+            go = false;
+        }
+        for (int i = 0; i < count; ++i) {
+            Thread thread = new Waiter();
+            thread.start();
+            threads.add(thread);
+        }
+        synchronized (lock) {
+            while (waiting != count) {
+                lock.wait();
+            }
+        }
+        return threads;
+    }
+
+    static void joinAll(ArrayList<Thread> threads) throws Exception {
+        for (Thread thread : threads) {
+            thread.join();
+        }
+    }
+
+    static void testNotifyAll() throws Exception {
+        ArrayList<Thread> threads = startWaiters(NUM_WAITERS);
+        synchronized (lock) {
+            go = true;
+            lock.notifyAll();
+        }
+        joinAll(threads);
+        System.out.println("notifyAll woke " + woken + " waiters");
+    }
+
+    static void testNotify() throws Exception {
+        ArrayList<Thread> threads = startWaiters(NUM_WAITERS);
+        synchronized (lock) {
+            go = true;
+            // One notification per waiter, all given while holding the monitor.
+            for (int i = 0; i < NUM_WAITERS; ++i) {
+                lock.notify();
+            }
+        }
+        joinAll(threads);
+        System.out.println("notify woke " + woken + " waiters");
+    }
+
+    static final int NUM_ITEMS = 20000;
+    static final LinkedList<Integer> queue = new LinkedList<Integer>();
+    static int consumed;
+
+    static class Consumer extends Thread {
+        public void run() {
+            while (true) {
+                synchronized (queue) {
+                    while (queue.isEmpty()) {
+                        try {
+                            queue.wait();
+                        } catch (InterruptedException e) {
+                            throw new AssertionError(e);
+                        }
+                    }
+                    int item = queue.removeFirst();
+                    if (item < 0) {
+                        return;
+                    }
+                    ++consumed;
+                    queue.notifyAll();  // Wakes the producer.
+                }
+            }
+        }
+    }
+
+    static void testQueue() throws Exception {
+        ArrayList<Thread> consumers = new ArrayList<Thread>();
+        for (int i = 0; i < NUM_WAITERS; ++i) {
+            Thread consumer = new Consumer();
+            consumer.start();
+            consumers.add(consumer);
+        }
+        for (int i = 0; i < NUM_ITEMS; ++i) {
+            synchronized (queue) {
+                while (queue.size() > 16) {
+                    queue.wait();
+                }
+                queue.addLast(i);
+                queue.notifyAll();
+            }
+        }
+        synchronized (queue) {
+            for (int i = 0; i < NUM_WAITERS; ++i) {
+                queue.addLast(-1);
+            }
+            queue.notifyAll();
+        }
+        joinAll(consumers);
+        System.out.println("queue consumed " + consumed + " items");
+    }
+
+    static void testTimedWait() throws Exception {
+        // Waiters which time out while notified must not keep the others from waking.
+        ArrayList<Thread> threads = new ArrayList<Thread>();
+        for (int i = 0; i < NUM_WAITERS; ++i) {
+            Thread thread = new Thread() {
+                public void run() {
+                    synchronized (lock) {
+                        try {
+                            lock.wait(1);
+                        } catch (InterruptedException e) {
+                            throw new AssertionError(e);
+                        }
+                    }
+                }
+            };
+            thread.start();
+            threads.add(thread);
+            synchronized (lock) {
+                lock.notifyAll();
+            }
+        }
+        joinAll(threads);
+        System.out.println("timed out waiters woke");
+    }
+
+    static void testInterrupt() throws Exception {
+        final boolean[] threw = new boolean[1];
+        Thread interrupted = new Thread() {
+            public void run() {
+                synchronized (lock) {
+                    ++waiting;
+                    lock.notifyAll();
+                    try {
+                        while (!go) {
+                            lock.wait();
+                        }
+                    } catch (InterruptedException e) {
+                        threw[0] = true;
+                    }
+                }
+            }
+        };
+        ArrayList<Thread> threads = startWaiters(NUM_WAITERS);
+        interrupted.start();
+        synchronized (lock) {
+            // Nothing notifies the lock once the last waiter is in, it is waiting now.
+            while (waiting != NUM_WAITERS + 1) {
+                lock.wait();
+            }
+            // Interrupt a notified waiter before the monitor is released.
+            lock.notifyAll();
+            interrupted.interrupt();
+            go = true;
+        }
+        interrupted.join();
+        joinAll(threads);
+        if (threw[0]) {
+            System.out.println("interrupted waiter threw");
+        }
+        if (woken == NUM_WAITERS) {
+            System.out.println("notified waiters after interrupt woke");
+        }
+    }
+}
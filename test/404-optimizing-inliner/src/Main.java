@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  int field;
+  Main next;
+  int[] array;
+
+  public static void expectEquals(int expected, int value) {
+    if (expected != value) {
+      throw new Error("Expected: " + expected + ", found: " + value);
+    }
+  }
+
+  public static void main(String[] args) {
+    Main m = new Main();
+    m.array = new int[2];
+
+    $opt$InlineSetter(m, 42);
+    expectEquals(42, m.field);
+    expectEquals(42, $opt$InlineGetter(m));
+    expectEquals(43, $opt$InlineStatic(42));
+    expectEquals(86, $opt$InlineNested(m));
+    expectEquals(44, $opt$InlinePrivate(m));
+
+    m.next = m;
+    expectEquals(42, $opt$InlineNextField(m));
+    m.next = null;
+    try {
+      $opt$InlineNextField(m);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$InlineGetter(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    $opt$InlineArraySet(m, 1, 5);
+    expectEquals(5, m.array[1]);
+    try {
+      $opt$InlineArraySet(m, 2, 5);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+  }
+
+  public static void $opt$InlineSetter(Main m, int value) {
+    m.setField(value);
+  }
+
+  public static int $opt$InlineGetter(Main m) {
+    return m.getField();
+  }
+
+  public static int $opt$InlineStatic(int value) {
+    return addOne(value);
+  }
+
+  public static int $opt$InlineNested(Main m) {
+    return m.getFieldTwice();
+  }
+
+  public static int $opt$InlinePrivate(Main m) {
+    return m.addTwo();
+  }
+
+  public static int $opt$InlineNextField(Main m) {
+    return m.getNextField();
+  }
+
+  public static void $opt$InlineArraySet(Main m, int index, int value) {
+    m.setArrayElement(index, value);
+  }
+
+  public final int getField() {
+    return field;
+  }
+
+  public final void setField(int value) {
+    field = value;
+  }
+
+  public static int addOne(int value) {
+    return value + 1;
+  }
+
+  public final int getFieldTwice() {
+    return getField() + getField() + 2;
+  }
+
+  private int addTwo() {
+    return field + 2;
+  }
+
+  public final int getNextField() {
+    return next.field;
+  }
+
+  public final void setArrayElement(int index, int value) {
+    array[index] = value;
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  public static void expectEquals(int expected, int value) {
+    if (expected != value) {
+      throw new Error("Expected: " + expected + ", found: " + value);
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] array = { 1, 2, 3, 4, 5 };
+    expectEquals(15, $opt$Sum(array));
+    expectEquals(14, $opt$SumFromOne(array));
+    expectEquals(9, $opt$SumEvenIndices(array));
+    expectEquals(0, $opt$Sum(new int[0]));
+    try {
+      $opt$Sum(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$SumOnePastTheEnd(array);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+
+    $opt$Fill(array, 7);
+    expectEquals(35, $opt$Sum(array));
+
+    char[] chars = { 'a', 'b', 'a', 'c', 'a' };
+    expectEquals(3, $opt$Count(chars, 'a'));
+    expectEquals(0, $opt$Count(chars, 'd'));
+    expectEquals(0, $opt$Count(new char[0], 'a'));
+  }
+
+  public static int $opt$Sum(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; i++) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  public static int $opt$SumFromOne(int[] array) {
+    int sum = 0;
+    for (int i = 1; i < array.length; i++) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  public static int $opt$SumEvenIndices(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; i += 2) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  public static int $opt$SumOnePastTheEnd(int[] array) {
+    int sum = 0;
+    for (int i = 0; i <= array.length; i++) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  public static void $opt$Fill(int[] array, int value) {
+    for (int i = 0; i < array.length; i++) {
+      array[i] = value;
+    }
+  }
+
+  public static int $opt$Count(char[] chars, char c) {
+    int count = 0;
+    for (int i = 0; i < chars.length; i++) {
+      if (chars[i] == c) {
+        count++;
+      }
+    }
+    return count;
+  }
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  public static void expectEquals(int expected, int value) {
+    if (expected != value) {
+      throw new Error("Expected: " + expected + ", found: " + value);
+    }
+  }
+
+  public static void main(String[] args) {
+    // Cover lengths with and without a remainder after the vector loop.
+    for (int length = 0; length < 19; length++) {
+      testLength(length);
+    }
+    testExceptions();
+  }
+
+  public static int[] newArray(int length, int seed) {
+    int[] array = new int[length];
+    for (int i = 0; i < length; i++) {
+      array[i] = seed * 1000003 + i * 7919;
+    }
+    return array;
+  }
+
+  public static void testLength(int length) {
+    int[] a = new int[length];
+    int[] b = newArray(length, 1);
+    int[] c = newArray(length, 2);
+
+    $opt$Fill(a, 42);
+    for (int i = 0; i < length; i++) {
+      expectEquals(42, a[i]);
+    }
+
+    $opt$Copy(a, b);
+    for (int i = 0; i < length; i++) {
+      expectEquals(b[i], a[i]);
+    }
+
+    $opt$Add(a, b, c);
+    for (int i = 0; i < length; i++) {
+      expectEquals(b[i] + c[i], a[i]);
+    }
+
+    $opt$Sub(a, b, c);
+    for (int i = 0; i < length; i++) {
+      expectEquals(b[i] - c[i], a[i]);
+    }
+
+    $opt$FillFromThree(a, -1);
+    for (int i = 0; i < length; i++) {
+      expectEquals(i < 3 ? b[i] - c[i] : -1, a[i]);
+    }
+
+    // The destination may also be an operand.
+    $opt$Add(b, b, b);
+    for (int i = 0; i < length; i++) {
+      expectEquals(2 * (1000003 + i * 7919), b[i]);
+    }
+
+    int sum = 0;
+    for (int i = 0; i < length; i++) {
+      sum += c[i];
+    }
+    expectEquals(sum, $opt$Sum(c));
+    expectEquals(sum + 5, $opt$SumFromFive(c));
+  }
+
+  public static void testExceptions() {
+    int[] a = new int[10];
+    int[] b = newArray(10, 1);
+    int[] shorter = newArray(5, 2);
+
+    try {
+      $opt$Sum(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$Add(a, b, null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+    expectEquals(0, a[0]);
+
+    // The elements before the missing one are stored.
+    try {
+      $opt$Add(a, b, shorter);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+    for (int i = 0; i < 10; i++) {
+      expectEquals(i < 5 ? b[i] + shorter[i] : 0, a[i]);
+    }
+
+    try {
+      $opt$Copy(shorter, b);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+    for (int i = 0; i < 5; i++) {
+      expectEquals(b[i], shorter[i]);
+    }
+  }
+
+  public static void $opt$Fill(int[] a, int value) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = value;
+    }
+  }
+
+  public static void $opt$FillFromThree(int[] a, int value) {
+    for (int i = 3; i < a.length; i++) {
+      a[i] = value;
+    }
+  }
+
+  public static void $opt$Copy(int[] a, int[] b) {
+    for (int i = 0; i < b.length; i++) {
+      a[i] = b[i];
+    }
+  }
+
+  public static void $opt$Add(int[] a, int[] b, int[] c) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = b[i] + c[i];
+    }
+  }
+
+  public static void $opt$Sub(int[] a, int[] b, int[] c) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = b[i] - c[i];
+    }
+  }
+
+  public static int $opt$Sum(int[] a) {
+    int sum = 0;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  public static int $opt$SumFromFive(int[] a) {
+    int sum = 5;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  int x;
+  int y;
+  long wide;
+  Main next;
+
+  public Main() {
+  }
+
+  public Main(int x, int y) {
+    this.x = x;
+    this.y = y;
+  }
+
+  public static void expectEquals(long expected, long value) {
+    if (expected != value) {
+      throw new Error("Expected: " + expected + ", found: " + value);
+    }
+  }
+
+  public static void main(String[] args) {
+    expectEquals(42, $opt$Sum(40, 2));
+    expectEquals(0, $opt$DefaultInt());
+    expectEquals(0, $opt$DefaultLong());
+    expectEquals(7, $opt$Overwrite(3, 7));
+
+    Main m = $opt$Escape(5);
+    expectEquals(5, m.x);
+    expectEquals(6, m.y);
+
+    Main other = new Main();
+    $opt$StoreInField(other, 8);
+    expectEquals(8, other.next.x);
+
+    if ($opt$DefaultReference() != null) {
+      throw new Error("Expected null");
+    }
+  }
+
+  public static int $opt$Sum(int a, int b) {
+    Main m = new Main(a, b);
+    return m.x + m.y;
+  }
+
+  public static int $opt$DefaultInt() {
+    Main m = new Main();
+    return m.x;
+  }
+
+  public static long $opt$DefaultLong() {
+    Main m = new Main();
+    return m.wide;
+  }
+
+  public static int $opt$Overwrite(int a, int b) {
+    Main m = new Main(a, a);
+    m.y = b;
+    return m.y;
+  }
+
+  public static Main $opt$Escape(int a) {
+    Main m = new Main(a, a);
+    m.y = m.x + 1;
+    return m;
+  }
+
+  public static void $opt$StoreInField(Main other, int a) {
+    Main m = new Main(a, a);
+    other.next = m;
+  }
+
+  public static Main $opt$DefaultReference() {
+    Main m = new Main();
+    return m.next;
+  }
+}
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+import dalvik.annotation.optimization.CriticalNative;
+import dalvik.annotation.optimization.FastNative;
+
 class MyClassNatives {
     native void throwException();
     native void foo();
@@ -92,4 +95,13 @@ class MyClassNatives {
     native static void stackArgsMixed(int i1, float f1, int i2, float f2, int i3, float f3, int i4,
         float f4, int i5, float f5, int i6, float f6, int i7, float f7, int i8, float f8, int i9,
         float f9, int i10, float f10);
+
+    @FastNative
+    static native int fastSbar(int count);
+
+    @CriticalNative
+    static native int criticalAdd(int x, int y);
+
+    @CriticalNative
+    static native double criticalMixed(int i, long l, float f, double d);
 }